@@ -0,0 +1,4 @@
+# the programs the Benchmark plugin measures edb against, built separately
+# from edb itself with: qmake benchmarks.pro && make
+TEMPLATE = subdirs
+SUBDIRS  = target
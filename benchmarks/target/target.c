@@ -0,0 +1,65 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+ * a process which behaves the same way every time, for the Benchmark plugin
+ * to be run against:
+ *
+ *     edb --run edb-benchmark-target [mappings]
+ *
+ * It makes <mappings> (default 1000) small mappings for the memory map to
+ * sync, touches a 16MiB buffer so that it can be read and written in large
+ * chunks, and then calls edb_benchmark_tick forever, which is where the
+ * breakpoint benchmark puts its breakpoint.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#define BUFFER_SIZE (16 << 20)
+
+volatile unsigned long edb_benchmark_counter;
+
+__attribute__((noinline)) void edb_benchmark_tick(void) {
+	++edb_benchmark_counter;
+}
+
+int main(int argc, char *argv[]) {
+
+	const int mappings = (argc > 1) ? atoi(argv[1]) : 1000;
+	const long page_size = sysconf(_SC_PAGESIZE);
+	char *buffer;
+	int i;
+
+	/* alternating the protection keeps the kernel from merging neighbours */
+	for(i = 0; i < mappings; ++i) {
+		mmap(0, page_size, (i & 1) ? PROT_READ : (PROT_READ | PROT_WRITE), MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	}
+
+	buffer = malloc(BUFFER_SIZE);
+	if(!buffer) {
+		return 1;
+	}
+	memset(buffer, 0x90, BUFFER_SIZE);
+
+	for(;;) {
+		edb_benchmark_tick();
+	}
+}
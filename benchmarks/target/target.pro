@@ -0,0 +1,11 @@
+
+TEMPLATE = app
+TARGET   = edb-benchmark-target
+CONFIG  -= qt app_bundle
+CONFIG  += console
+
+# keep the frame pointers and the symbols, the benchmarks unwind and look
+# up edb_benchmark_tick by name
+QMAKE_CFLAGS += -O1 -g -fno-omit-frame-pointer
+
+SOURCES += target.c
@@ -0,0 +1,88 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef ANNOTATIONS_20261014_H_
+#define ANNOTATIONS_20261014_H_
+
+#include "API.h"
+#include "Types.h"
+#include <QObject>
+#include <QString>
+#include <QVector>
+
+// what the user has attached to addresses: labels, comments and bookmarks.
+// Each kind is a flat vector kept sorted by address, so finding one is a
+// binary search and everything in a range, such as the lines a view shows,
+// is one search followed by a walk along contiguous memory. Changes are
+// announced so that the session can write them out as they are made.
+//
+// Typical usage:
+//
+//     edb::v1::annotations().set(Annotations::COMMENT, address, text);
+class EDB_EXPORT Annotations : public QObject {
+	Q_OBJECT
+
+public:
+	enum Kind {
+		LABEL,
+		COMMENT,
+		BOOKMARK,
+		KIND_COUNT
+	};
+
+	struct Entry {
+		edb::address_t address;
+		QString        text;
+	};
+
+	typedef QVector<Entry>::const_iterator const_iterator;
+
+public:
+	Annotations();
+
+public:
+	// <text> may be empty, a bookmark doesn't need any
+	void set(Kind kind, edb::address_t address, const QString &text);
+	bool remove(Kind kind, edb::address_t address);
+	void clear(Kind kind);
+	void clear();
+
+public:
+	bool contains(Kind kind, edb::address_t address) const;
+	QString find(Kind kind, edb::address_t address) const;
+
+	// the entries of <kind> from <first> up to, but not including, <last>
+	const_iterator lower_bound(Kind kind, edb::address_t address) const;
+	void range(Kind kind, edb::address_t first, edb::address_t last, const_iterator *begin, const_iterator *end) const;
+
+	// all of them, in address order
+	const QVector<Entry> &entries(Kind kind) const { return entries_[kind]; }
+
+Q_SIGNALS:
+	// an entry of <kind> at <address> was set or removed
+	void changed(Annotations::Kind kind, edb::address_t address);
+
+	// everything of <kind> went away at once, which isn't a change the user
+	// made and so isn't reported entry by entry
+	void cleared(Annotations::Kind kind);
+
+private:
+	QVector<Entry> entries_[KIND_COUNT];
+};
+
+#endif
@@ -19,7 +19,9 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #ifndef ARCHPROCESSOR_20070312_H_
 #define ARCHPROCESSOR_20070312_H_
 
+#include "API.h"
 #include "State.h"
+#include "SyscallRecord.h"
 #include "Types.h"
 #include <QCoreApplication>
 #include <QStringList>
@@ -31,7 +33,7 @@ class QTreeWidgetItem;
 class RegisterListWidget;
 class State;
 
-class ArchProcessor : public QObject {
+class EDB_EXPORT ArchProcessor : public QObject {
 	Q_OBJECT
 	Q_DISABLE_COPY(ArchProcessor)
 public:
@@ -39,14 +41,19 @@ public:
 	virtual ~ArchProcessor() {}
 
 public:
-	QStringList update_instruction_info(edb::address_t address);
+	QStringList update_instruction_info(const edb::Instruction &inst, const State &state);
 	Register value_from_item(const QTreeWidgetItem &item);
 	bool can_step_over(const edb::Instruction &inst) const;
+	edb::address_t effective_address(const edb::Operand &op, const State &state) const;
 	bool is_filling(const edb::Instruction &inst) const;
 	void reset();
 	void setup_register_view(RegisterListWidget *category_list);
 	void update_register_view(const QString &default_region_name, const State &state);
 
+public:
+	QString format_syscall(const SyscallRecord &record) const;
+	bool syscall_number(const QString &name, edb::reg_t *number) const;
+
 private:
 	void update_register(QTreeWidgetItem *item, const QString &name, const Register &reg) const;
 
@@ -55,6 +62,9 @@ private:
 	State             last_state_;
 	bool              has_mmx_;
 	bool              has_xmm_;
+	bool              has_ymm_;
+	bool              has_zmm_;
+	bool              register_view_valid_; // false until every item has been filled in once
 	QTreeWidgetItem * register_view_items_[128];
 };
 
@@ -24,66 +24,66 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <QVector>
 #include <QSharedPointer>
-#include <iterator>
 
 typedef QSharedPointer<edb::Instruction> instruction_pointer;
 
+// a block is kept as just where it starts, how long it is and where it goes,
+// its instructions are decoded again whenever they are asked for. The bytes
+// come out of the snapshot the block was found in, which every block of a
+// region shares, or out of the process for blocks with no snapshot
 class EDB_EXPORT BasicBlock {
 public:
 	typedef QSharedPointer<BasicBlock>                   pointer;
 
 public:
 	typedef size_t                                       size_type;
-	typedef instruction_pointer                          value_type;
-	typedef instruction_pointer                         &reference;
-	typedef const instruction_pointer                   &const_reference;
-	typedef QVector<instruction_pointer>::iterator       iterator;
-	typedef QVector<instruction_pointer>::const_iterator const_iterator;
-	typedef std::reverse_iterator<iterator>              reverse_iterator;
-	typedef std::reverse_iterator<const_iterator>        const_reverse_iterator;
-	
+
 public:
 	BasicBlock();
+	BasicBlock(const QVector<quint8> &memory, edb::address_t memory_base);
 	BasicBlock(const BasicBlock &other);
 	BasicBlock &operator=(const BasicBlock &rhs);
 	~BasicBlock();
-	
-public:
-	void push_back(const instruction_pointer &inst);
-	
+
 public:
-	reference operator[](size_type pos);
-	const_reference operator[](size_type pos) const;
-	
-	const_reference back() const;
-	const_reference front() const;
-	reference back();
-	reference front();
+	void push_back(const edb::Instruction &inst);
+	void add_successor(edb::address_t address);
 
 public:
-	const_iterator begin() const;
-	const_iterator end() const;
-	const_reverse_iterator rbegin() const;
-	const_reverse_iterator rend() const;
-	iterator begin();
-	iterator end();
-	reverse_iterator rbegin();
-	reverse_iterator rend();
-	
+	instruction_pointer front() const;
+	instruction_pointer back() const;
+	QVector<instruction_pointer> instructions() const;
+
 public:
 	size_type size() const;
 	bool empty() const;
 
+public:
+	size_type successor_count() const;
+	edb::address_t successor(size_type n) const;
+
 public:
 	void swap(BasicBlock &other);
-	
+	void rebase(edb::address_t start, edb::address_t end, edb::address_t new_start);
+
 public:
 	size_type byte_size() const;
 	edb::address_t first_address() const;
 	edb::address_t last_address() const;
+	edb::address_t last_instruction() const;
+
+private:
+	instruction_pointer decode(edb::address_t address) const;
 
 private:
-	QVector<instruction_pointer> instructions_;
+	QVector<quint8> memory_;
+	edb::address_t  memory_base_;
+	edb::address_t  address_;
+	quint32         byte_size_;
+	quint32         instruction_count_;
+	quint32         last_offset_;
+	quint32         successor_count_;
+	edb::address_t  successors_[2];
 };
 
 #endif
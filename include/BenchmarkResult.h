@@ -0,0 +1,85 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef BENCHMARKRESULT_20261014_H_
+#define BENCHMARKRESULT_20261014_H_
+
+#include "IRegion.h"
+#include <QList>
+#include <QString>
+#include <QTime>
+#include <QVariant>
+#include <QtGlobal>
+
+// one timing taken by IPlugin::run_benchmarks, <msecs> is for all of the
+// iterations together
+struct BenchmarkResult {
+	QString     name;
+	QVariantMap parameters;  // what was timed, e.g. the region's name
+	quint64     iterations;
+	int         msecs;
+	quint64     bytes;       // searched or analyzed, 0 if that doesn't apply
+	quint64     items;       // found, counted in <units>
+	QString     units;       // what <items> are, empty if they aren't counted
+};
+
+// collects the results of an IPlugin::run_benchmarks which makes one timed
+// scan for each of its parameters. start() before each scan and finish()
+// after it
+class BenchmarkRun {
+public:
+	BenchmarkRun(const QString &name, const QString &units) : name_(name), units_(units) {}
+
+public:
+	static quint64 bytes(const QList<IRegion::pointer> &regions) {
+		quint64 n = 0;
+		Q_FOREACH(const IRegion::pointer &region, regions) {
+			n += region->size();
+		}
+		return n;
+	}
+
+public:
+	void start() {
+		timer_.start();
+	}
+
+	void finish(const QVariantMap &parameters, quint64 bytes, quint64 items) {
+		BenchmarkResult result;
+		result.name       = name_;
+		result.parameters = parameters;
+		result.iterations = 1;
+		result.msecs      = timer_.elapsed();
+		result.bytes      = bytes;
+		result.items      = items;
+		result.units      = units_;
+		results_.push_back(result);
+	}
+
+	QList<BenchmarkResult> results() const {
+		return results_;
+	}
+
+private:
+	QString                name_;
+	QString                units_;
+	QTime                  timer_;
+	QList<BenchmarkResult> results_;
+};
+
+#endif
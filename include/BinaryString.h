@@ -25,6 +25,8 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 namespace Ui { class BinaryStringWidget; }
 
+class HexStringValidator;
+
 class QString;
 class QByteArray;
 
@@ -42,11 +44,14 @@ private Q_SLOTS:
 
 public:
 	void setMaxLength(int n);
+	void setAllowWildcards(bool allow);
 	QByteArray value() const;
+	QByteArray mask() const;
 	void setValue(const QByteArray &);
 
 private:
 	 Ui::BinaryStringWidget *const ui;
+	 HexStringValidator *const     hex_validator_;
 };
 
 #endif
@@ -0,0 +1,73 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef BYTESEARCHER_20261014_H_
+#define BYTESEARCHER_20261014_H_
+
+#include "API.h"
+#include "Types.h"
+#include <QByteArray>
+#include <QString>
+#include <QVector>
+#include <cstddef>
+
+// finds a byte pattern in a buffer. Patterns may have a mask, in which case
+// only the bits set in the mask have to match, so "48 8B ?? ?? E8" is the
+// pattern 48 8B 00 00 E8 with the mask FF FF 00 00 FF. Positions are first
+// checked against two of the pattern's bytes, 16 at a time where SSE2 is
+// available, and only compared in full when both match. Long patterns without
+// a mask use Boyer-Moore-Horspool instead. When an alignment is given only
+// aligned addresses are ever looked at, rather than finding everything and
+// filtering it after.
+//
+// Typical usage:
+//
+//     ByteSearcher searcher(pattern, alignment);
+//     const quint8 *p = first;
+//     while((p = searcher.find(p, last, address + (p - first))) != last) {
+//         // a match at address + (p - first)
+//         ++p;
+//     }
+class EDB_EXPORT ByteSearcher {
+public:
+	explicit ByteSearcher(const QByteArray &pattern, edb::address_t alignment = 1);
+	ByteSearcher(const QByteArray &pattern, const QByteArray &mask, edb::address_t alignment = 1);
+
+public:
+	static bool parse(const QString &text, QByteArray *pattern, QByteArray *mask);
+
+public:
+	const quint8 *find(const quint8 *first, const quint8 *last, edb::address_t address) const;
+	std::size_t size() const { return pattern_.size(); }
+
+private:
+	void init();
+	bool matches(const quint8 *p) const;
+	const quint8 *find_aligned(const quint8 *first, const quint8 *last, edb::address_t address) const;
+	const quint8 *find_horspool(const quint8 *first, const quint8 *last) const;
+	const quint8 *find_short(const quint8 *first, const quint8 *last) const;
+
+private:
+	QByteArray           pattern_;
+	QByteArray           mask_;   // empty when every bit has to match
+	edb::address_t       alignment_;
+	QVector<std::size_t> shift_;  // Horspool skips, empty when not used
+	int                  head_;   // the bytes positions are first checked
+	int                  tail_;   // against, -1 if the mask is all clear
+};
+
+#endif
@@ -24,10 +24,14 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <QList>
 #include <QtCore/qglobal.h>
 
+class IProcess;
+class State;
+
 class CallStack
 {
 public:
 	CallStack();
+	explicit CallStack(edb::tid_t tid);
 	~CallStack();
 
 //Struct that holds the caller and return addresses.
@@ -38,7 +42,9 @@ public:
 	} stack_frame;
 
 private:
-	void get_call_stack();
+	void get_call_stack(edb::tid_t tid);
+	void build_call_stack(IProcess *process, const State &state);
+	void scan_call_stack(const State &state);
 
 public:
 	stack_frame *operator [](qint32 index);
@@ -0,0 +1,77 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef COMPILED_EXPRESSION_20261014_H_
+#define COMPILED_EXPRESSION_20261014_H_
+
+#include "API.h"
+#include "Expression.h"
+#include "Types.h"
+#include <QString>
+#include <QVector>
+
+class State;
+
+// an expression parsed once and then evaluated over and over against whatever
+// the registers are at the time, as breakpoint conditions, watches and trace
+// filters are. Registers are looked up by their index and symbols are
+// resolved to their addresses when compiled, only names which were neither
+// are looked up by name every time
+class EDB_EXPORT CompiledExpression {
+public:
+	typedef Expression<edb::address_t>::memory_reader_t memory_reader_t;
+	typedef Expression<edb::address_t>::Program         Program;
+
+public:
+	CompiledExpression();
+
+public:
+	bool compile(const QString &source, const State &state);
+	bool evaluate(const State &state, edb::address_t *result, ExpressionError *error) const;
+	bool evaluate(const State &state, memory_reader_t mr, edb::address_t *result, ExpressionError *error) const;
+
+public:
+	// true if the symbols have changed since the expression was compiled, so
+	// the addresses it resolved them to may be out of date
+	bool stale() const;
+
+public:
+	const QString &source() const         { return source_; }
+	const Program &program() const        { return program_; }
+	const ExpressionError &error() const  { return error_; }
+	bool valid() const                    { return valid_; }
+
+public:
+	// the State::register_index of each variable, -1 for those which aren't
+	// registers, and whether any of those weren't symbols either and so can
+	// only be looked up by name. Without those the expression only depends on
+	// the registers and memory
+	const QVector<int> &registers() const { return registers_; }
+	bool has_named_variables() const      { return named_variables_; }
+
+private:
+	QString         source_;
+	Program         program_;
+	QVector<int>    registers_;          // State::register_index for each variable, -1 if it has none
+	ExpressionError error_;
+	quint64         symbols_generation_;
+	bool            named_variables_;
+	bool            valid_;
+};
+
+#endif
@@ -20,6 +20,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #define CONFIGURATION_20061031_H_
 
 #include "API.h"
+#include <QMap>
 #include <QString>
 
 class EDB_EXPORT Configuration {
@@ -43,6 +44,13 @@ public:
 		MainSymbol
 	};
 
+	// what happens when the debugged process receives a signal
+	enum SignalPolicy {
+		SignalStop, // report it, the UI decides
+		SignalPass, // give it straight to the process
+		SignalLog   // the same, but note it in the log
+	};
+
 public:
 	// general tab
 	CloseBehavior     close_behavior;
@@ -66,17 +74,33 @@ public:
 	bool              find_main;
 	bool              tty_enabled;
 	QString           tty_command;
+	int               page_cache_size;
+	int               memory_budget;     // MiB for edb's own caches, 0 for no limit
+	bool              track_memory_map;
+	bool              non_stop;
+	bool              follow_fork;
+
+	// signals which aren't in here stop the process
+	QMap<int, SignalPolicy> signal_policies;
 
 	// disassembly tab
 	Syntax            syntax;
 	bool              zeros_are_filling;
 	bool              uppercase_disassembly;
 
+	// searches for code (functions, gadgets, opcodes) skip the parts of a
+	// binary's mappings which its section headers say are data
+	bool              scan_code_sections_only;
+
 	// directories tab
 	QString           symbol_path;
 	QString           plugin_path;
 	QString           session_path;
 
+	// C declarations of the structures which can be overlaid on the data
+	// and stack views, see TypeLayout
+	QString           structures_file;
+
 	int               min_string_length;
 
 protected:
@@ -0,0 +1,75 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef CONTENTMAP_20261014_H_
+#define CONTENTMAP_20261014_H_
+
+#include "API.h"
+#include "RegionScanner.h"
+#include "Types.h"
+#include <QList>
+#include <QVector>
+
+// works out the Shannon entropy of every page of some regions, and roughly
+// what each one holds from that and its byte histogram. Windows are scanned
+// in parallel, and within a window a page which is all zeros is spotted 16
+// bytes at a time where SSE2 is available, before any histogram is made.
+// The rest are counted into four interleaved histograms, so that runs of one
+// byte value don't make every increment wait on the one before. Pages come
+// back in address order.
+//
+// Typical usage:
+//
+//     ContentMap map(edb::v1::debugger_core->page_size());
+//     map.run(regions);
+//     Q_FOREACH(const ContentMap::Page &page, map.pages()) { ... }
+class EDB_EXPORT ContentMap : public RegionScanner::Task {
+public:
+	enum Content {
+		CONTENT_ZERO,   // nothing but zeros
+		CONTENT_TEXT,   // almost all printable ASCII
+		CONTENT_CODE,   // looks like x86 instructions
+		CONTENT_RANDOM, // compressed, encrypted or key material
+		CONTENT_DATA    // anything else
+	};
+
+	struct Page {
+		edb::address_t address;
+		float          entropy; // in bits per byte, 0 to 8
+		Content        content;
+	};
+
+public:
+	explicit ContentMap(edb::address_t page_size);
+
+public:
+	static Page classify(edb::address_t address, const quint8 *p, std::size_t size);
+
+public:
+	void run(const QList<IRegion::pointer> &regions);
+	const QVector<Page> &pages() const { return pages_; }
+
+public:
+	virtual Result *scan(const RegionScanner::Chunk &chunk) const;
+	virtual void merge(Result *result);
+
+private:
+	const edb::address_t page_size_;
+	QVector<Page>        pages_;
+};
+
+#endif
@@ -0,0 +1,98 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef COREFILE_20261014_H_
+#define COREFILE_20261014_H_
+
+#include "API.h"
+#include "MappedFile.h"
+#include "Types.h"
+#include <QByteArray>
+#include <QCoreApplication>
+#include <QList>
+#include <QString>
+#include <QVector>
+#include <cstddef>
+
+class State;
+
+// an ELF core file, in the format the kernel and gdb write them. save()
+// writes one for the debuggee: a PT_LOAD segment for each region, and notes
+// for the threads (NT_PRSTATUS), the process (NT_PRPSINFO), the mapped files
+// (NT_FILE) and the names of all regions (an "EDB" note). open() maps one
+// back in without copying anything, everything handed out points into the
+// mapping and stays valid for as long as some copy of the CoreFile is around.
+//
+// Only cores of the architecture edb was built for are understood
+class EDB_EXPORT CoreFile {
+	Q_DECLARE_TR_FUNCTIONS(CoreFile)
+public:
+	struct Segment {
+		edb::address_t start;
+		edb::address_t end;
+		edb::address_t base;      // the file offset of the mapping, if it maps a file
+		QString        name;
+		const uchar   *data;      // NULL if the contents weren't saved
+		bool           read;
+		bool           write;
+		bool           execute;
+	};
+
+	struct Thread {
+		edb::tid_t   tid;
+		int          signal;
+		const uchar *registers;      // the kernel's elf_gregset_t
+		std::size_t  registers_size;
+	};
+
+public:
+	CoreFile();
+
+public:
+	static bool save(const QString &filename, QString *error);
+
+public:
+	bool open(const QString &filename, QString *error);
+	bool is_open() const { return file_.is_open(); }
+
+public:
+	QString                  filename() const   { return file_.filename(); }
+	edb::pid_t               pid() const        { return pid_; }
+	QString                  executable() const { return executable_; }
+	QList<QByteArray>        arguments() const  { return arguments_; }
+	const QVector<Segment> & segments() const   { return segments_; }
+	const QVector<Thread> &  threads() const    { return threads_; }
+
+public:
+	static void get_state(const Thread &thread, State *state);
+
+	// the general purpose registers of <state> in the layout of a thread's
+	// registers, and back
+	static QByteArray save_registers(const State &state);
+	static void load_registers(const uchar *data, std::size_t size, State *state);
+
+private:
+	MappedFile        file_;
+	edb::pid_t        pid_;
+	QString           executable_;
+	QList<QByteArray> arguments_;
+	QVector<Segment>  segments_;
+	QVector<Thread>   threads_;
+};
+
+#endif
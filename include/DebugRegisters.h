@@ -0,0 +1,31 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef DEBUG_REGISTERS_20261014_H_
+#define DEBUG_REGISTERS_20261014_H_
+
+#include "Types.h"
+
+// the hardware breakpoint configuration shared by every thread: the addresses
+// for DR0-DR3 and the DR7 control word enabling them
+struct DebugRegisters {
+	edb::address_t address[4];
+	edb::reg_t     control;
+};
+
+#endif
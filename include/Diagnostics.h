@@ -0,0 +1,89 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef DIAGNOSTICS_20261014_H_
+#define DIAGNOSTICS_20261014_H_
+
+#include "API.h"
+#include <QByteArray>
+#include <QList>
+#include <QString>
+#include <QtGlobal>
+
+class QObject;
+
+// always on counters of what edb's hot paths are doing, cheap enough to be
+// left in: counting is a couple of adds and timing two reads of a monotonic
+// clock. A counter is looked up by name once and the pointer kept, they live
+// until edb exits. Only the UI thread counts (it is the one which talks to
+// the process), so nothing here is locked
+//
+// Typical usage:
+//
+//     static edb::diagnostics::Counter *const reads = edb::diagnostics::counter("process: read_bytes");
+//     edb::diagnostics::add(reads, len);
+//
+//     static edb::diagnostics::Counter *const syncs = edb::diagnostics::timer("MemoryRegions::sync");
+//     edb::diagnostics::ScopedTimer timer(syncs);
+namespace edb {
+namespace diagnostics {
+
+struct Counter {
+	QString name;
+	bool    timing;
+	quint64 count;
+	quint64 total;  // of the amounts added, nanoseconds for a timer
+	quint64 max;    // the largest single amount
+};
+
+EDB_EXPORT Counter *counter(const QString &name);
+EDB_EXPORT Counter *timer(const QString &name);
+EDB_EXPORT QList<const Counter *> counters();
+EDB_EXPORT void reset();
+EDB_EXPORT QByteArray to_json();
+EDB_EXPORT quint64 nsecs();
+
+// like connecting <member> of <receiver> to the UI's gui_updated() signal,
+// but each call of it is timed under "gui_updated: Class::member"
+EDB_EXPORT void connect_gui_updated(QObject *receiver, const char *member);
+EDB_EXPORT void disconnect_gui_updated(QObject *receiver, const char *member);
+
+inline void add(Counter *counter, quint64 amount = 1) {
+	++counter->count;
+	counter->total += amount;
+	if(amount > counter->max) {
+		counter->max = amount;
+	}
+}
+
+// adds the time between its construction and destruction to a timer
+class ScopedTimer {
+	Q_DISABLE_COPY(ScopedTimer)
+public:
+	explicit ScopedTimer(Counter *counter) : counter_(counter), start_(nsecs()) {}
+	~ScopedTimer() { add(counter_, nsecs() - start_); }
+
+private:
+	Counter *const counter_;
+	const quint64  start_;
+};
+
+}
+}
+
+#endif
@@ -0,0 +1,88 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef EMULATOR_20261014_H_
+#define EMULATOR_20261014_H_
+
+#include "API.h"
+#include "Types.h"
+#include <QByteArray>
+#include <QVector>
+
+class State;
+
+// runs the simplest x86-64 instructions of the active thread without it
+// trapping into the kernel for each one. It works on a copy of the general
+// purpose registers which is written back with store(), memory is read and
+// written through the process (and so its page cache).
+//
+// Only a whitelist is emulated: nops, mov, lea, push and pop of registers and
+// immediates, add/or/and/sub/xor/cmp/test/inc/dec on 32 and 64 bit operands,
+// and jmp, jcc, call and ret. step() returns false, without changing
+// anything, for everything else (system calls, 8 and 16 bit operands, any
+// legacy prefix, segment overrides, the FPU and vector units, ...), for
+// any instruction with a breakpoint on it and for any access which would
+// fault (the page protections, or a page a memory breakpoint watches), which
+// then has to be really stepped. Nothing is emulated at all when a hardware breakpoint is enabled
+// or the process isn't running 64-bit code. On x86 builds step() always
+// returns false.
+//
+// Typical usage:
+//
+//     Emulator emulator(state);
+//     while(emulator.step()) {
+//         // emulator.instruction_pointer(), emulator.writes() ...
+//     }
+//     emulator.store(&state);
+//     edb::v1::debugger_core->set_state(state);
+class EDB_EXPORT Emulator {
+public:
+	struct Write {
+		edb::address_t address;
+		QByteArray     bytes;
+		QByteArray     previous;
+	};
+
+public:
+	explicit Emulator(const State &state);
+
+public:
+	bool step();
+	void store(State *state) const;
+
+public:
+	edb::address_t instruction_pointer() const { return machine_.rip; }
+	const QVector<Write> &writes() const       { return writes_; }
+	quint64 count() const                      { return count_; }
+
+private:
+	struct Machine {
+		edb::reg_t     gpr[16]; // in encoding order, rax, rcx, rdx, rbx, rsp ...
+		edb::address_t rip;
+		edb::reg_t     flags;
+	};
+
+private:
+	Machine        machine_;
+	QVector<Write> writes_;   // the ones made by the last step
+	quint32        dirty_;    // the registers which store() has to write back
+	quint64        count_;
+	bool           usable_;
+};
+
+#endif
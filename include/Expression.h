@@ -20,6 +20,8 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #define EXPRESSION_20070402_H_
 
 #include <QString>
+#include <QStringList>
+#include <QVector>
 #include <boost/function.hpp>
 
 struct ExpressionError {
@@ -81,11 +83,40 @@ class Expression {
 public:
 	typedef boost::function<T(const QString&, bool*, ExpressionError*)> variable_getter_t;
 	typedef boost::function<T(T, bool*, ExpressionError*)>              memory_reader_t;
+	typedef boost::function<T(int, bool*, ExpressionError*)>            slot_reader_t;
 
 public:
 	Expression(const QString &s, variable_getter_t vg, memory_reader_t mr);
 	~Expression() {}
 
+public:
+	// an expression compiled down to a little stack machine, so that it can
+	// be evaluated over and over (eg. a breakpoint condition) without being
+	// parsed again. Variables are referred to by their index in <variables>
+	// so that callers can work out how to look each one up ahead of time
+	struct Program {
+		struct Instruction {
+			enum Type {
+				CONSTANT,
+				VARIABLE,
+				DEREFERENCE,
+				UNARY,
+				BINARY
+			};
+
+			Type type;
+			int  op;
+			T    value;
+		};
+
+		QVector<Instruction> code;
+		QStringList          variables;
+	};
+
+public:
+	bool compile(Program *program, ExpressionError *error) throw();
+	static T execute(const Program &program, slot_reader_t sr, memory_reader_t mr, bool *ok, ExpressionError *error) throw();
+
 private:
 	struct Token {
 		Token()                   : operator_(NONE), type_(UNKNOWN) { }
@@ -173,6 +204,19 @@ private:
 	void eval_atom(T &result);
 	void get_token();
 
+private:
+	void compile_exp0();
+	void compile_exp1();
+	void compile_exp2();
+	void compile_exp3();
+	void compile_exp4();
+	void compile_exp5();
+	void compile_exp6();
+	void compile_exp7();
+	void compile_atom();
+	void emit_instruction(typename Program::Instruction::Type type, int op, T value);
+	static T apply(int op, T lhs, T rhs);
+
 	static bool is_delim(QChar ch) {
 		return QString("[]!()=+-*/%&|^~<>\t\n\r ").contains(ch);
 	}
@@ -183,6 +227,7 @@ private:
 	Token                   token_;
 	variable_getter_t       variable_reader_;
 	memory_reader_t         memory_reader_;
+	Program                 *program_;
 };
 
 #include "Expression.tcc"
@@ -26,7 +26,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 template <class T>
 Expression<T>::Expression(const QString &s, variable_getter_t vg, memory_reader_t mr) :
 		expression_(s), expression_ptr_(expression_.begin()),
-		variable_reader_(vg), memory_reader_(mr) {
+		variable_reader_(vg), memory_reader_(mr), program_(0) {
 }
 
 //------------------------------------------------------------------------------
@@ -546,4 +546,392 @@ void Expression<T>::get_token() {
 	}
 }
 
+//------------------------------------------------------------------------------
+// Name: compile
+// Desc: compiles the expression into <program>, this follows the same grammar
+//       as evaluate_expression, so running the program gives the same result
+//------------------------------------------------------------------------------
+template <class T>
+bool Expression<T>::compile(Program *program, ExpressionError *error) throw() {
+
+	Q_ASSERT(program);
+	Q_ASSERT(error);
+
+	*program = Program();
+	program_ = program;
+
+	try {
+		get_token();
+
+		if(token_.type_ == Token::UNKNOWN) {
+			throw ExpressionError(ExpressionError::SYNTAX);
+		}
+
+		compile_exp0();
+
+		switch(token_.type_) {
+		case Token::OPERATOR:
+			switch(token_.operator_) {
+			case Token::LPAREN:
+			case Token::RPAREN:
+				throw ExpressionError(ExpressionError::UNBALANCED_PARENS);
+			case Token::LBRACE:
+			case Token::RBRACE:
+				throw ExpressionError(ExpressionError::UNBALANCED_BRACES);
+			default:
+				throw ExpressionError(ExpressionError::UNEXPECTED_OPERATOR);
+			}
+			break;
+		case Token::NUMBER:
+			throw ExpressionError(ExpressionError::UNEXPECTED_NUMBER);
+		default:
+			break;
+		}
+
+		program_ = 0;
+		return true;
+	} catch(const ExpressionError &e) {
+		*error   = e;
+		*program = Program();
+		program_ = 0;
+		return false;
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: emit_instruction
+// Desc:
+//------------------------------------------------------------------------------
+template <class T>
+void Expression<T>::emit_instruction(typename Program::Instruction::Type type, int op, T value) {
+	const typename Program::Instruction insn = { type, op, value };
+	program_->code.push_back(insn);
+}
+
+//------------------------------------------------------------------------------
+// Name: compile_exp0
+// Desc: logic
+//------------------------------------------------------------------------------
+template <class T>
+void Expression<T>::compile_exp0() {
+	compile_exp1();
+
+	for(Token op = token_; op.operator_ == Token::LOGICAL_AND || op.operator_ == Token::LOGICAL_OR; op = token_) {
+		get_token();
+		compile_exp1();
+		emit_instruction(Program::Instruction::BINARY, op.operator_, T());
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: compile_exp1
+// Desc: binary logic
+//------------------------------------------------------------------------------
+template <class T>
+void Expression<T>::compile_exp1() {
+	compile_exp2();
+
+	for(Token op = token_; op.operator_ == Token::AND || op.operator_ == Token::OR || op.operator_ == Token::XOR; op = token_) {
+		get_token();
+		compile_exp2();
+		emit_instruction(Program::Instruction::BINARY, op.operator_, T());
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: compile_exp2
+// Desc: comparisons
+//------------------------------------------------------------------------------
+template <class T>
+void Expression<T>::compile_exp2() {
+	compile_exp3();
+
+	for(Token op = token_; op.operator_ == Token::LT || op.operator_ == Token::LE || op.operator_ == Token::GT || op.operator_ == Token::GE || op.operator_ == Token::EQ || op.operator_ == Token::NE; op = token_) {
+		get_token();
+		compile_exp3();
+		emit_instruction(Program::Instruction::BINARY, op.operator_, T());
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: compile_exp3
+// Desc: shifts
+//------------------------------------------------------------------------------
+template <class T>
+void Expression<T>::compile_exp3() {
+	compile_exp4();
+
+	for(Token op = token_; op.operator_ == Token::RSHFT || op.operator_ == Token::LSHFT; op = token_) {
+		get_token();
+		compile_exp4();
+		emit_instruction(Program::Instruction::BINARY, op.operator_, T());
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: compile_exp4
+// Desc: addition/subtraction
+//------------------------------------------------------------------------------
+template <class T>
+void Expression<T>::compile_exp4() {
+	compile_exp5();
+
+	for(Token op = token_; op.operator_ == Token::PLUS || op.operator_ == Token::MINUS; op = token_) {
+		get_token();
+		compile_exp5();
+		emit_instruction(Program::Instruction::BINARY, op.operator_, T());
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: compile_exp5
+// Desc: multiplication/division
+//------------------------------------------------------------------------------
+template <class T>
+void Expression<T>::compile_exp5() {
+	compile_exp6();
+
+	for(Token op = token_; op.operator_ == Token::MUL || op.operator_ == Token::DIV || op.operator_ == Token::MOD; op = token_) {
+		get_token();
+		compile_exp6();
+		emit_instruction(Program::Instruction::BINARY, op.operator_, T());
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: compile_exp6
+// Desc: unary expressions
+//------------------------------------------------------------------------------
+template <class T>
+void Expression<T>::compile_exp6() {
+
+	Token op = token_;
+	if(op.operator_ == Token::PLUS || op.operator_ == Token::MINUS || op.operator_ == Token::CMP || op.operator_ == Token::NOT) {
+		get_token();
+	}
+
+	compile_exp7();
+
+	switch(op.operator_) {
+	case Token::PLUS:
+	case Token::MINUS:
+	case Token::CMP:
+	case Token::NOT:
+		emit_instruction(Program::Instruction::UNARY, op.operator_, T());
+		break;
+	default:
+		break;
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: compile_exp7
+// Desc: sub-expressions
+//------------------------------------------------------------------------------
+template <class T>
+void Expression<T>::compile_exp7() {
+
+	switch(token_.operator_) {
+	case Token::LPAREN:
+		get_token();
+		compile_exp0();
+
+		if(token_.operator_ != Token::RPAREN) {
+			throw ExpressionError(ExpressionError::UNBALANCED_PARENS);
+		}
+
+		get_token();
+		break;
+	case Token::RPAREN:
+		throw ExpressionError(ExpressionError::UNBALANCED_PARENS);
+	case Token::LBRACE:
+		get_token();
+		compile_exp0();
+
+		if(token_.operator_ != Token::RBRACE) {
+			throw ExpressionError(ExpressionError::UNBALANCED_BRACES);
+		}
+
+		emit_instruction(Program::Instruction::DEREFERENCE, Token::NONE, T());
+		get_token();
+		break;
+	case Token::RBRACE:
+		throw ExpressionError(ExpressionError::UNBALANCED_BRACES);
+	default:
+		compile_atom();
+		break;
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: compile_atom
+// Desc: atoms (variables/constants)
+//------------------------------------------------------------------------------
+template <class T>
+void Expression<T>::compile_atom() {
+
+	switch(token_.type_) {
+	case Token::VARIABLE:
+		{
+			int slot = program_->variables.indexOf(token_.data_);
+			if(slot == -1) {
+				slot = program_->variables.size();
+				program_->variables.push_back(token_.data_);
+			}
+			emit_instruction(Program::Instruction::VARIABLE, slot, T());
+		}
+		get_token();
+		break;
+	case Token::NUMBER:
+		{
+			bool ok;
+			const T value = token_.data_.toULongLong(&ok, 0);
+			if(!ok) {
+				throw ExpressionError(ExpressionError::INVALID_NUMBER);
+			}
+			emit_instruction(Program::Instruction::CONSTANT, Token::NONE, value);
+		}
+		get_token();
+		break;
+	default:
+		throw ExpressionError(ExpressionError::SYNTAX);
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: apply
+// Desc: applies binary operator <op>
+//------------------------------------------------------------------------------
+template <class T>
+T Expression<T>::apply(int op, T lhs, T rhs) {
+	switch(op) {
+	case Token::LOGICAL_AND: return lhs && rhs;
+	case Token::LOGICAL_OR:  return lhs || rhs;
+	case Token::AND:         return lhs & rhs;
+	case Token::OR:          return lhs | rhs;
+	case Token::XOR:         return lhs ^ rhs;
+	case Token::LT:          return lhs < rhs;
+	case Token::LE:          return lhs <= rhs;
+	case Token::GT:          return lhs > rhs;
+	case Token::GE:          return lhs >= rhs;
+	case Token::EQ:          return lhs == rhs;
+	case Token::NE:          return lhs != rhs;
+	case Token::LSHFT:       return lhs << rhs;
+	case Token::RSHFT:       return lhs >> rhs;
+	case Token::PLUS:        return lhs + rhs;
+	case Token::MINUS:       return lhs - rhs;
+	case Token::MUL:         return lhs * rhs;
+	case Token::DIV:
+		if(rhs == 0) {
+			throw ExpressionError(ExpressionError::DIVIDE_BY_ZERO);
+		}
+		return lhs / rhs;
+	case Token::MOD:
+		if(rhs == 0) {
+			throw ExpressionError(ExpressionError::DIVIDE_BY_ZERO);
+		}
+		return lhs % rhs;
+	default:
+		throw ExpressionError(ExpressionError::SYNTAX);
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: execute
+// Desc: runs a compiled program, variables are fetched by slot number
+//------------------------------------------------------------------------------
+template <class T>
+T Expression<T>::execute(const Program &program, slot_reader_t sr, memory_reader_t mr, bool *ok, ExpressionError *error) throw() {
+
+	Q_ASSERT(ok);
+	Q_ASSERT(error);
+
+	// conditions are tiny, this is almost never going to allocate
+	QVector<T> stack;
+	stack.reserve(16);
+
+	try {
+		Q_FOREACH(const typename Program::Instruction &insn, program.code) {
+			switch(insn.type) {
+			case Program::Instruction::CONSTANT:
+				stack.push_back(insn.value);
+				break;
+			case Program::Instruction::VARIABLE:
+				{
+					if(!sr) {
+						throw ExpressionError(ExpressionError::UNKNOWN_VARIABLE);
+					}
+
+					bool read_ok;
+					ExpressionError read_error;
+					const T value = sr(insn.op, &read_ok, &read_error);
+					if(!read_ok) {
+						throw read_error;
+					}
+					stack.push_back(value);
+				}
+				break;
+			case Program::Instruction::DEREFERENCE:
+				{
+					if(!mr) {
+						throw ExpressionError(ExpressionError::CANNOT_READ_MEMORY);
+					}
+
+					bool read_ok;
+					ExpressionError read_error;
+					const T value = mr(stack.back(), &read_ok, &read_error);
+					if(!read_ok) {
+						throw read_error;
+					}
+					stack.back() = value;
+				}
+				break;
+			case Program::Instruction::UNARY:
+				switch(insn.op) {
+				case Token::PLUS:
+					stack.back() = +stack.back();
+					break;
+				case Token::MINUS:
+#ifdef _MSC_VER
+#pragma warning(push)
+#pragma warning(disable:4146)
+#endif
+					stack.back() = -stack.back();
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif
+					break;
+				case Token::CMP:
+					stack.back() = ~stack.back();
+					break;
+				case Token::NOT:
+					stack.back() = !stack.back();
+					break;
+				default:
+					break;
+				}
+				break;
+			case Program::Instruction::BINARY:
+				{
+					const T rhs = stack.back();
+					stack.pop_back();
+					stack.back() = apply(insn.op, stack.back(), rhs);
+				}
+				break;
+			}
+		}
+
+		if(stack.size() != 1) {
+			throw ExpressionError(ExpressionError::SYNTAX);
+		}
+
+		*ok = true;
+		return stack.back();
+	} catch(const ExpressionError &e) {
+		*ok    = false;
+		*error = e;
+		return T();
+	}
+}
+
 #endif
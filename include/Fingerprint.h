@@ -0,0 +1,36 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef FINGERPRINT_20261014_H_
+#define FINGERPRINT_20261014_H_
+
+#include "API.h"
+#include <QtGlobal>
+#include <cstddef>
+
+namespace edb {
+namespace internal {
+
+// XXH64, a fast non-cryptographic hash. Good for telling whether something
+// has changed, nothing which has to be secure should use it
+EDB_EXPORT quint64 xxh64(const void *data, std::size_t len, quint64 seed = 0);
+
+}
+}
+
+#endif
@@ -81,6 +81,7 @@ public:
 	
 public:
 	void swap(Function &other);
+	void rebase(edb::address_t start, edb::address_t end, edb::address_t new_start);
 	
 private:
 	edb::address_t                   address_;
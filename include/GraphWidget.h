@@ -23,10 +23,13 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #define GRAPHWIDGET_20090903_H_
 
 #include "API.h"
+#include <QByteArray>
 #include <QRectF>
 #include <QGraphicsView>
 
+class GraphNode;
 class QGraphicsScene;
+class QPainter;
 class QContextMenuEvent;
 class QMouseEvent;
 
@@ -39,7 +42,10 @@ private:
 	friend class GraphNode;
 	friend class GraphEdge;
 
+	class LayoutThread;
+
 public:
+	explicit GraphWidget(QWidget* parent = 0);
 	GraphWidget(const QString& filename, const QString& layout, QWidget* parent = 0);
 	GraphWidget(GVC_t *gvc, graph_t *graph, const QString& layout, QWidget* parent = 0);
 
@@ -48,13 +54,22 @@ public:
 public:
 	void render_graph(const QString& filename, const QString& layout);
 	void render_graph(GVC_t *gvc, graph_t *graph, const QString& layout);
+	void layout_graph(const QByteArray& dot, const QString& layout);
 	void clear_graph();
 
+public:
+	// false once the view is zoomed out so far that labels, arrow heads and
+	// the like can't be made out and only the shapes are worth drawing
+	static bool show_details(const QPainter *painter);
+
 Q_SIGNALS:
 	void backgroundContextMenuEvent(QContextMenuEvent* event);
 	void nodeContextMenuEvent(QContextMenuEvent* event, const QString& name);
 	void nodeDoubleClickEvent(QMouseEvent* event, const QString& name);
 
+private Q_SLOTS:
+	void layout_finished();
+
 protected:
 	void keyPressEvent(QKeyEvent* event);
 	void wheelEvent(QWheelEvent* event);
@@ -62,6 +77,10 @@ protected:
 	void mouseDoubleClickEvent(QMouseEvent* event);
 
 private:
+	void init_view();
+	void set_opengl(bool enable);
+	GraphNode *node_at(const QPoint &pos) const;
+	void render_layout(graph_t *graph);
 	void render_node(graph_t *graph, node_t *node);
 	void render_edge(edge_t *edge);
 	void render_sub_graph(graph_t *graph);
@@ -79,6 +98,8 @@ private:
 private:
 	QRectF          graph_rect_;
 	QGraphicsScene *scene_;
+	LayoutThread   *layout_thread_;
+	bool            opengl_; // the viewport is a QOpenGLWidget
 };
 
 #endif
@@ -19,19 +19,61 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #ifndef IANALYZER_20080630_H_
 #define IANALYZER_20080630_H_
 
+#include "BasicBlock.h"
 #include "Function.h"
 #include "IRegion.h"
 #include "Types.h"
 
+#include <QList>
+#include <QMap>
 #include <QSet>
 #include <QHash>
+#include <QVector>
 
 class IAnalyzer {
 public:
 	virtual ~IAnalyzer() {}
 
 public:
-	typedef QHash<edb::address_t, Function> FunctionMap;
+	typedef QHash<edb::address_t, Function>   FunctionMap;
+	typedef QHash<edb::address_t, BasicBlock> BasicBlockMap;
+
+public:
+	// something at <source> which refers to <target>
+	struct Reference {
+		enum Type {
+			REF_CALL,      // call <target>
+			REF_JUMP,      // jmp/jcc <target>
+			REF_IMMEDIATE, // an immediate operand of <target>
+			REF_MEMORY,    // a memory operand at <target>
+			REF_POINTER    // a pointer to <target> stored at <source>
+		};
+
+		edb::address_t target;
+		edb::address_t source;
+		Type           type;
+	};
+
+	typedef QVector<Reference> ReferenceList;
+
+	// a function without its blocks, which is all a table of them needs
+	struct FunctionSummary {
+		edb::address_t entry;
+		edb::address_t end;             // the entry, for a function with no blocks
+		int            reference_count;
+		Function::Type type;
+	};
+
+	typedef QVector<FunctionSummary> FunctionTable;
+
+	// which functions call which, in compressed sparse row form. <nodes> are
+	// sorted, and the callees of nodes[i] are nodes[edges[j]] for every j in
+	// [offsets[i], offsets[i + 1])
+	struct CallGraph {
+		QVector<edb::address_t> nodes;
+		QVector<int>            offsets;
+		QVector<int>            edges;
+	};
 
 public:
 	enum AddressCategory {
@@ -44,11 +86,66 @@ public:
 public:
 	virtual AddressCategory category(edb::address_t address) const = 0;
 	virtual FunctionMap functions(const IRegion::pointer &region) const = 0;
+	virtual BasicBlockMap basic_blocks(const IRegion::pointer &region) const = 0;
 	virtual QSet<edb::address_t> specified_functions() const { return QSet<edb::address_t>(); }
 	virtual edb::address_t find_containing_function(edb::address_t address, bool *ok) const = 0;
 	virtual void analyze(const IRegion::pointer &region) = 0;
 	virtual void invalidate_analysis() = 0;
 	virtual void invalidate_analysis(const IRegion::pointer &region) = 0;
+
+public:
+	// optional, tells the analyzer that [address, address + size) has been
+	// written to so that only the analysis touching it needs redoing
+	virtual void invalidate_range(edb::address_t address, edb::address_t size) { Q_UNUSED(address); Q_UNUSED(size); }
+
+	// optional, for when the process is restarted. The analysis of the modules
+	// is put aside instead of forgotten, and a region which is later analyzed
+	// as the same bytes of the same file takes it back, moved to wherever the
+	// region is loaded now
+	virtual void invalidate_for_restart() { invalidate_analysis(); }
+
+	// optional, asks a running analysis to stop early, keeping what it has
+	virtual void cancel_analysis() {}
+
+	// optional, analyzes all of <regions> in one go, which lets an analyzer
+	// share its threads between them and use what each found in the others
+	virtual void analyze_regions(const QList<IRegion::pointer> &regions) { Q_FOREACH(const IRegion::pointer &region, regions) { analyze(region); } }
+
+	// optional, the references to <target> from inside <region> which its last
+	// analysis found. Returns false if there is no analysis of <region> to go
+	// by, in which case the caller has to look for itself
+	virtual bool references(const IRegion::pointer &region, edb::address_t target, ReferenceList *results) const { Q_UNUSED(region); Q_UNUSED(target); Q_UNUSED(results); return false; }
+
+	// optional, the same functions as functions(), sorted by entry and without
+	// their blocks. This includes what a running analysis has found so far
+	virtual FunctionTable function_table(const IRegion::pointer &region) const {
+		const FunctionMap map = functions(region);
+		QMap<edb::address_t, FunctionSummary> sorted;
+		for(FunctionMap::const_iterator it = map.begin(); it != map.end(); ++it) {
+			sorted.insert(it.key(), summarize(it.value()));
+		}
+		return sorted.values().toVector();
+	}
+
+	// optional, the calls made by the functions of <region>'s last analysis
+	virtual CallGraph call_graph(const IRegion::pointer &region) const { Q_UNUSED(region); return CallGraph(); }
+
+	// optional, sets <result> to whether <address> is just past a call, that
+	// is, whether it can be a return address. Returns false if no analysis
+	// decoded the bytes in front of <address>, in which case the caller has to
+	// decode them for itself
+	virtual bool follows_call(edb::address_t address, bool *result) const { Q_UNUSED(address); Q_UNUSED(result); return false; }
+
+public:
+	static FunctionSummary summarize(const Function &function) {
+		const FunctionSummary summary = {
+			function.entry_address(),
+			function.empty() ? function.entry_address() : function.end_address(),
+			function.reference_count(),
+			function.type()
+		};
+		return summary;
+	}
 };
 
 #endif
@@ -23,7 +23,41 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "IRegion.h"
 #include "Types.h"
 
+#include <QList>
+#include <QString>
+
 class EDB_EXPORT IBinary {
+public:
+	// a part of the image which is mapped when it runs, [start, end) are
+	// where it is in the target process
+	struct Section {
+		QString        name;
+		edb::address_t start;
+		edb::address_t end;
+		bool           executable;
+	};
+
+	// [start, end) in the target process are loaded from <offset> in the file
+	struct ImageRange {
+		edb::address_t start;
+		edb::address_t end;
+		quint64        offset;
+	};
+
+	// bytes of an ImageRange which the loader changes as it loads the image
+	struct Fixup {
+		enum Kind {
+			FIXUP_ADD, // the little endian value in the file plus <value>
+			FIXUP_SET, // <value>
+			FIXUP_ANY  // something which can't be worked out from the file
+		};
+
+		edb::address_t address;
+		quint32        size;
+		Kind           kind;
+		quint64        value;
+	};
+
 public:
 	virtual ~IBinary() {}
 
@@ -41,6 +75,21 @@ public:
 	// this should return a pointer to it
 	virtual edb::address_t debug_pointer() { return 0; }
 
+	// where the binary's table of unwind info is mapped in the target process
+	// (for ELF, the PT_GNU_EH_FRAME segment), 0 if it has none
+	virtual edb::address_t eh_frame_header() { return 0; }
+
+	// the sections which are mapped when the binary runs, ordered as the
+	// binary lists them. Empty if they aren't known, section headers are
+	// often only in the file on disk and may have been stripped from it
+	virtual QList<Section> sections() { return QList<Section>(); }
+
+	// what the executable parts of the image hold right after it was loaded
+	// (optional), for finding code which was patched in memory since. <file>
+	// is the file on disk the ranges come from, the fixups are ordered by
+	// address. Returns false if the file can't be found or doesn't match
+	virtual bool file_image(QString *file, QList<ImageRange> *ranges, QList<Fixup> *fixups) { Q_UNUSED(file); Q_UNUSED(ranges); Q_UNUSED(fixups); return false; }
+
 public:
 	typedef IBinary *(*create_func_ptr_t)(const IRegion::pointer &);
 };
@@ -20,9 +20,12 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #define IBREAKPOINT_20060720_H_
 
 #include "Types.h"
+#include "CompiledExpression.h"
+#include "LogFormat.h"
 
 #include <QString>
 #include <QSharedPointer>
+#include <QVector>
 
 class QByteArray;
 
@@ -54,7 +57,19 @@ public:
 public:
 	QString condition;
 	quint64 tag;
-	
+
+public:
+	// <condition> compiled so that it doesn't have to be parsed on every hit,
+	// it is rebuilt whenever <condition> no longer matches its source, see
+	// edb::v1::breakpoint_condition_true
+	CompiledExpression compiled_condition;
+
+public:
+	// a breakpoint with a log format is a logpoint, when it is hit (and its
+	// condition holds) the message is added to the breakpoint log and the
+	// process carries on without stopping, see edb::v1::log_breakpoint_hit
+	QString   log_format;
+	LogFormat compiled_log_format;
 };
 
 #endif
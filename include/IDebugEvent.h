@@ -73,6 +73,11 @@ public:
 	virtual edb::pid_t process() const = 0;
 	virtual edb::tid_t thread() const = 0;
 	virtual int code() const = 0;
+
+public:
+	// true if this is a fault from accessing memory without permission, as
+	// opposed to unmapped memory, <address> is set to what was accessed
+	virtual bool access_violation(edb::address_t *address) const { Q_UNUSED(address); return false; }
 };
 
 #endif
@@ -19,21 +19,29 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #ifndef IDEBUGGER_20061101_H_
 #define IDEBUGGER_20061101_H_
 
+#include "BranchRecord.h"
+#include "DebugRegisters.h"
 #include "IBreakpoint.h"
 #include "IDebugEvent.h"
 #include "IRegion.h"
 #include "IProcess.h"
+#include "MemoryUsage.h"
+#include "PerformanceCounters.h"
 #include "ProcessInfo.h"
+#include "ProfileSample.h"
 #include "Module.h"
+#include "SyscallRecord.h"
 #include "ThreadInfo.h"
 
 #include <QByteArray>
 #include <QHash>
+#include <QList>
 #include <QMap>
 #include <QString>
 #include <QVector>
 #include <QtPlugin>
 
+class CompiledExpression;
 class IState;
 class QString;
 class State;
@@ -87,10 +95,120 @@ public:
 	virtual void              set_active_thread(edb::tid_t) {}
 	virtual ThreadInfo        get_thread_info(edb::tid_t)   { return ThreadInfo(); }
 
+	// the registers of a stopped thread other than the active one (optional),
+	// cores which can't do that only know about the active thread
+	virtual bool get_thread_state(edb::tid_t tid, State *state) { if(tid != active_thread()) { return false; } get_state(state); return true; }
+
+public:
+	// returns true if the memory map of the process may have changed since
+	// the last time this was asked (optional), cores which can't tell should
+	// always say yes
+	virtual bool memory_map_changed() { return true; }
+
+	// the modules which were loaded and unloaded since the last call
+	// (optional), for cores which hear about them from the OS itself rather
+	// than having edb follow the dynamic linker. Returns false if the core
+	// can't tell
+	virtual bool module_changes(QList<Module> *loaded, QList<Module> *unloaded) { Q_UNUSED(loaded); Q_UNUSED(unloaded); return false; }
+
+public:
+	// every process being traced, for cores which follow forks (optional).
+	// Only the selected one (pid()) is debugged, the rest run by themselves
+	// until they are selected, which requires that we are paused
+	virtual QList<edb::pid_t> traced_processes() const        { return QList<edb::pid_t>(); }
+	virtual bool              select_process(edb::pid_t pid)  { Q_UNUSED(pid); return false; }
+
+public:
+	// a descriptor which becomes readable whenever wait_debug_event may have
+	// something to report (optional), if there is one the UI can sleep on it
+	// instead of polling, -1 means the core doesn't have one
+	virtual int event_fd() const { return -1; }
+
+public:
+	// steps the active thread by itself, up to <count> times, without any of
+	// the steps being reported (optional). It stops early once <condition>
+	// (if given) is true of the registers after a step, when it gets to an
+	// enabled breakpoint, or when a step ends in anything but a trap. <event>
+	// is set to what the last step is reported as, which may be nothing if
+	// the core kept the process going. The address of each instruction
+	// stepped is appended to <trace> if it is given. Returns false, without
+	// stepping, if the core can't do this
+	virtual bool step_many(quint64 count, const CompiledExpression *condition, QVector<edb::address_t> *trace, IDebugEvent::const_pointer *event) { Q_UNUSED(count); Q_UNUSED(condition); Q_UNUSED(trace); Q_UNUSED(event); return false; }
+
+public:
+	// hardware branch tracing of the active thread (optional). While a trace
+	// is running the branches it takes are recorded at full speed,
+	// branch_trace returns (and forgets) what has been recorded so far and
+	// sets <lost> to the number of branches which didn't fit in the buffer
+	virtual bool                  start_branch_trace()        { return false; }
+	virtual void                  stop_branch_trace()         {}
+	virtual QVector<BranchRecord> branch_trace(quint64 *lost) { if(lost) { *lost = 0; } return QVector<BranchRecord>(); }
+
+public:
+	// recording the syscalls made by every thread (optional). Only the ones in
+	// <numbers> are recorded (all of them if it is empty), into a buffer which
+	// keeps the last <capacity>. The process doesn't stop for the UI while it
+	// is traced, syscall_trace returns what was recorded so far, oldest first,
+	// and sets <lost> to the number which were overwritten
+	virtual bool                   start_syscall_trace(const QList<edb::reg_t> &numbers, int capacity) { Q_UNUSED(numbers); Q_UNUSED(capacity); return false; }
+	virtual void                   stop_syscall_trace()         {}
+	virtual QVector<SyscallRecord> syscall_trace(quint64 *lost) { if(lost) { *lost = 0; } return QVector<SyscallRecord>(); }
+
+public:
+	// statistical profiling of every thread (optional). Threads are sampled
+	// about <frequency> times a second of the CPU time they use, without the
+	// process stopping for it. profile_samples returns (and forgets) what has
+	// been recorded so far, it may be called while the process is running
+	virtual bool                   start_profile(int frequency)   { Q_UNUSED(frequency); return false; }
+	virtual void                   stop_profile()                 {}
+	virtual QVector<ProfileSample> profile_samples(quint64 *lost) { if(lost) { *lost = 0; } return QVector<ProfileSample>(); }
+
+public:
+	// counting what every thread does in user space with the CPU's
+	// performance counters (optional), from start_counters until
+	// stop_counters. Threads created in between are counted too, and what
+	// threads which exited counted is kept. read_counters gives the totals so
+	// far, it may be called while the process is running
+	virtual bool start_counters()                             { return false; }
+	virtual void stop_counters()                              {}
+	virtual bool read_counters(PerformanceCounters *counters) { Q_UNUSED(counters); return false; }
+
+public:
+	// hardware breakpoints for the whole process (optional). The registers are
+	// given to every thread, including ones created later, the next time it
+	// runs, and only to threads which don't already have them. Returns false
+	// if this isn't supported, the active thread's State is all there is then
+	virtual bool set_debug_registers(const DebugRegisters &registers) { Q_UNUSED(registers); return false; }
+
+public:
+	// changes the protection of whole pages from inside the stopped active
+	// thread, without running any other thread (optional)
+	virtual bool set_page_permissions(edb::address_t address, edb::address_t size, bool read, bool write, bool execute) { Q_UNUSED(address); Q_UNUSED(size); Q_UNUSED(read); Q_UNUSED(write); Q_UNUSED(execute); return false; }
+
+	// maps <size> bytes of new readable, writable and executable memory into
+	// the process from inside the stopped active thread, at <hint> if it is
+	// free (optional). Returns where it went, or 0 if it couldn't be done
+	virtual edb::address_t allocate_memory(edb::address_t hint, edb::address_t size) { Q_UNUSED(hint); Q_UNUSED(size); return 0; }
+
+public:
+	// the enabled breakpoints which the process wrote over since the last call
+	// (optional), as self-modifying code and JITs do. The core has put them
+	// back, with what the process wrote as the byte they hide. Cores which
+	// can't tell return nothing
+	virtual QList<edb::address_t> overwritten_breakpoints() { return QList<edb::address_t>(); }
+
+public:
+	// how much of each region starting at one of <starts> is in RAM
+	// (optional), regions the core can't say anything about are left out.
+	// total_memory_usage is the same for the whole process
+	virtual QHash<edb::address_t, MemoryUsage> memory_usage(const QList<edb::address_t> &starts) { Q_UNUSED(starts); return QHash<edb::address_t, MemoryUsage>(); }
+	virtual bool                               total_memory_usage(MemoryUsage *usage) { Q_UNUSED(usage); return false; }
+
 public:
 	// basic breakpoint managment
 	virtual BreakpointList       backup_breakpoints() const = 0;
 	virtual IBreakpoint::pointer add_breakpoint(edb::address_t address) = 0;
+	virtual QList<IBreakpoint::pointer> add_breakpoints(const QList<edb::address_t> &addresses) = 0;
 	virtual IBreakpoint::pointer find_breakpoint(edb::address_t address) = 0;
 	virtual void                 clear_breakpoints() = 0;
 	virtual void                 remove_breakpoint(edb::address_t address) = 0;
@@ -104,6 +222,20 @@ public:
 
 public:
 	virtual QMap<edb::pid_t, ProcessInfo> enumerate_processes() const = 0;
+
+public:
+	// is handed the processes in batches as stream_processes finds them,
+	// returning false stops it
+	class ProcessSink {
+	public:
+		virtual ~ProcessSink() {}
+		virtual bool found(const QList<ProcessInfo> &processes) = 0;
+	};
+
+	// the same processes as enumerate_processes, given to <sink> as they are
+	// found and safe to call from a thread other than the UI's (optional),
+	// cores which can't do better hand them all over in one go
+	virtual void stream_processes(ProcessSink *sink) const { sink->found(enumerate_processes().values()); }
 };
 
 Q_DECLARE_INTERFACE(IDebugger, "EDB.IDebugger/1.0")
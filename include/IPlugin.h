@@ -19,6 +19,8 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #ifndef IPLUGIN_20061101_H_
 #define IPLUGIN_20061101_H_
 
+#include "BenchmarkResult.h"
+#include "IRegion.h"
 #include <QtPlugin>
 #include <QList>
 
@@ -52,6 +54,11 @@ public:
 	virtual QByteArray save_state() const          { return QByteArray(); }
 	virtual void restore_state(const QByteArray &) { }
 
+public:
+	// optional, overload this to time the plugin's engines over <regions>
+	// without any of its UI, for the Benchmark plugin
+	virtual QList<BenchmarkResult> run_benchmarks(const QList<IRegion::pointer> &) { return QList<BenchmarkResult>(); }
+
 public:
 	enum ArgumentStatus {
 		ARG_SUCCESS,
@@ -22,13 +22,38 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "IRegion.h"
 #include "IThread.h"
 #include "Types.h"
+#include <QByteArray>
 #include <QDateTime>
+#include <QFuture>
+#include <QFutureInterface>
 #include <QSharedPointer>
 #include <QString>
+#include <QVector>
 
 class IProcess {
 public:
 	typedef QSharedPointer<IProcess> pointer;
+
+public:
+	// a single (address, buffer, length) tuple for read_batch
+	struct ReadRequest {
+		ReadRequest() : address(0), buffer(0), length(0) {}
+		ReadRequest(edb::address_t address, void *buffer, size_t length) : address(address), buffer(buffer), length(length) {}
+
+		edb::address_t address;
+		void          *buffer;
+		size_t         length;
+	};
+
+	// what read_bytes_async gives back, <bytes> are what read_bytes would
+	// have read and <ok> is true if all of them could be
+	struct AsyncRead {
+		AsyncRead() : ok(false) {}
+
+		QByteArray bytes;
+		bool       ok;
+	};
+
 public:
 	virtual ~IProcess() {}
 
@@ -50,6 +75,59 @@ public:
 	virtual bool write_bytes(edb::address_t address, const void *buf, size_t len) = 0;
 	virtual bool read_bytes(edb::address_t address, void *buf, size_t len) = 0;
 	virtual bool read_pages(edb::address_t address, void *buf, size_t count) = 0;
+
+public:
+	// changes whenever the process's memory may have changed, that is when it
+	// runs and when it is written to. Anything worked out from its memory can
+	// be kept for as long as this stays the same. Values are never reused,
+	// not even by another process. Platforms which can't tell return 0, so
+	// that nothing is kept
+	virtual quint64 memory_generation() const { return 0; }
+
+public:
+	// services many small reads at unrelated addresses at once, the result
+	// has one entry per request which is true if that request was fully read.
+	// Like read_bytes, any bytes which could not be read are filled with 0xff.
+	// Platforms which can't do better than one read per request can rely on
+	// this default implementation.
+	virtual QVector<bool> read_batch(const QVector<ReadRequest> &requests) {
+		QVector<bool> results;
+		results.reserve(requests.size());
+		Q_FOREACH(const ReadRequest &request, requests) {
+			results.push_back(read_bytes(request.address, request.buffer, request.length));
+		}
+		return results;
+	}
+
+public:
+	// reads and writes which are done on a thread of the core's, so that the
+	// caller doesn't wait on them (optional). They are done one at a time in
+	// the order they were asked for. Reads may be asked for from any thread,
+	// writes only from the UI thread, as they have to keep the page cache in
+	// step, and they are seen by every read made after them. Both are only
+	// done while the process is stopped, resuming it waits for what is still
+	// queued. Platforms which can't do this do them right away, on the
+	// calling thread, and hand back a future which has already finished
+	virtual QFuture<AsyncRead> read_bytes_async(edb::address_t address, size_t len) {
+		AsyncRead result;
+		result.bytes.resize(len);
+		result.ok = read_bytes(address, result.bytes.data(), len);
+		return finished_future(result);
+	}
+
+	virtual QFuture<bool> write_bytes_async(edb::address_t address, const QByteArray &bytes) {
+		return finished_future(write_bytes(address, bytes.constData(), bytes.size()));
+	}
+
+protected:
+	template <class T>
+	static QFuture<T> finished_future(const T &value) {
+		QFutureInterface<T> future;
+		future.reportStarted();
+		future.reportResult(value);
+		future.reportFinished();
+		return future.future();
+	}
 };
 
 #endif
@@ -23,11 +23,18 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "API.h"
 #include "Register.h"
 
+#include <QAtomicInt>
+
 // TODO(eteran): This file is still too taylored to x86 and family
 // we should develop a better abstraction model at some point
 
 class EDB_EXPORT IState {
+	friend class State;
+
 public:
+	IState() : ref_(0) {}
+	IState(const IState &) : ref_(0) {}
+	IState &operator=(const IState &) { return *this; }
 	virtual ~IState() {}
 
 public:
@@ -64,6 +71,23 @@ public:
 public:
 	// SSE
 	virtual QByteArray xmm_register(int n) const = 0;
+
+public:
+	// AVX/AVX-512 (optional), these come back in the same byte order as
+	// xmm_register, an empty array means the register isn't available
+	virtual QByteArray ymm_register(int n) const { Q_UNUSED(n); return QByteArray(); }
+	virtual QByteArray zmm_register(int n) const { Q_UNUSED(n); return QByteArray(); }
+
+public:
+	// fast access to registers by a precomputed index (optional), this lets
+	// things like compiled breakpoint conditions skip the name lookup.
+	// register_index returns -1 for names which must go through value()
+	virtual int register_index(const QString &name) const { Q_UNUSED(name); return -1; }
+	virtual edb::reg_t register_value(int index) const   { Q_UNUSED(index); return 0; }
+
+private:
+	// how many States share this one, copying a state doesn't copy this
+	QAtomicInt ref_;
 };
 
 #endif
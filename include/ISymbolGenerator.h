@@ -21,6 +21,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #define SYMBOL_GENERATOR_20130808_H_
 
 #include "API.h"
+#include "Types.h"
 
 class QString;
 
@@ -29,7 +30,14 @@ public:
 	virtual ~ISymbolGenerator() {}
 
 public:
+	// writes a SymbolCache for <filename> to <symbol_file>, this is called on a
+	// worker thread so it must not touch the GUI
 	virtual bool generate_symbol_file(const QString &filename, const QString &symbol_file) = 0;
+
+public:
+	// finds the source line for <address> from <filename>'s debug info, the
+	// addresses are as the file was linked. Called on the GUI thread
+	virtual bool source_line(const QString &filename, edb::address_t address, QString *file, int *line, edb::address_t *start) { Q_UNUSED(filename); Q_UNUSED(address); Q_UNUSED(file); Q_UNUSED(line); Q_UNUSED(start); return false; }
 };
 
 #endif
@@ -20,10 +20,12 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #define ISYMBOL_MANAGER_20110307_H_
 
 #include "API.h"
+#include "Annotations.h"
 #include "Types.h"
 #include "Symbol.h"
 #include <QList>
 #include <QHash>
+#include <QVector>
 
 class QString;
 class ISymbolGenerator;
@@ -32,19 +34,55 @@ class EDB_EXPORT ISymbolManager {
 public:
 	virtual ~ISymbolManager() {}
 
+public:
+	enum SearchMode {
+		SEARCH_EXACT,
+		SEARCH_PREFIX,
+		SEARCH_SUBSTRING,
+		SEARCH_FUZZY
+	};
+
 public:
 	virtual const QList<Symbol::pointer> symbols() const = 0;
 	virtual const Symbol::pointer find(const QString &name) const = 0;
 	virtual const Symbol::pointer find(edb::address_t address) const = 0;
 	virtual const Symbol::pointer find_near_symbol(edb::address_t address) const = 0;
 	virtual void add_symbol(const Symbol::pointer &symbol) = 0;
+	virtual void add_symbols(const QList<Symbol::pointer> &symbols) = 0;
 	virtual void clear() = 0;
 	virtual void load_symbol_file(const QString &filename, edb::address_t base) = 0;
+	virtual void unload_symbol_file(const QString &filename) = 0;
+	virtual void wait_for_symbol_file(const QString &filename) = 0;
 	virtual void set_symbol_generator(ISymbolGenerator *generator) = 0;
 	virtual void set_symbol_path(const QString &symbol_directory) = 0;
 	virtual void set_label(edb::address_t address, const QString &label) = 0;
 	virtual QString find_address_name(edb::address_t address) = 0;
-	virtual QHash<edb::address_t, QString> labels() const = 0;
+
+	// the labels, in address order. They are kept with the rest of what the
+	// user has annotated, see edb::v1::annotations()
+	virtual const QVector<Annotations::Entry> &labels() const = 0;
+
+public:
+	// like clear, for when the process is restarted. The mapped symbol caches
+	// of the modules are put aside, and a module loaded again from the same
+	// unchanged file takes its cache back, at its new address, instead of
+	// having it checked and mapped all over again
+	virtual void clear_for_restart() = 0;
+
+public:
+	// searches the names of the symbols without their module prefix, a text of
+	// "module::name" only searches that module. Passing the results of a search
+	// for a text this one extends narrows those rather than starting over. The
+	// results are handles for from_handle, they stay valid as long as
+	// generation() doesn't change
+	virtual QVector<quint64> search(const QString &text, SearchMode mode, const QVector<quint64> *within = 0) const = 0;
+	virtual Symbol::pointer from_handle(quint64 handle) const = 0;
+	virtual quint64 generation() const = 0;
+
+public:
+	// the source file and line <address> belongs to, when its module has debug
+	// info. <start> is the first address of that line's code
+	virtual bool find_source_line(edb::address_t address, QString *file, int *line, edb::address_t *start) const = 0;
 };
 
 #endif
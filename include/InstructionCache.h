@@ -0,0 +1,76 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef INSTRUCTION_CACHE_20261014_H_
+#define INSTRUCTION_CACHE_20261014_H_
+
+#include "API.h"
+#include "Instruction.h"
+#include "MemoryBudget.h"
+#include "Types.h"
+#include <QHash>
+#include <QMutex>
+#include <QSharedPointer>
+#include <cstddef>
+
+// the instructions of the debugged process which have been decoded since its
+// memory last changed. The process's memory generation changes whenever it
+// runs or is written to (setting and removing breakpoints included), and the
+// entries are only kept while it stays the same, so each instruction gets
+// decoded once per stop however many views and plugins look at it.
+//
+// Typical usage:
+//
+//     const InstructionCache::pointer inst = edb::v1::instruction_cache().find(address);
+//     if(inst && *inst) {
+//         // inst->size(), inst->operands() ...
+//     }
+class EDB_EXPORT InstructionCache : public edb::memory::Consumer {
+	Q_DISABLE_COPY(InstructionCache)
+public:
+	typedef QSharedPointer<const edb::Instruction> pointer;
+
+public:
+	static const int DefaultMaxEntries = 16384;
+
+public:
+	explicit InstructionCache(int max_entries = DefaultMaxEntries);
+	virtual ~InstructionCache();
+
+public:
+	pointer find(edb::address_t address, int max_size = edb::Instruction::MAX_SIZE);
+	pointer decode(edb::address_t address, const quint8 *first, const quint8 *last);
+	void clear();
+
+public:
+	virtual quint64 memory_used() const;
+	virtual void trim(quint64 bytes);
+
+private:
+	bool sync();
+	pointer lookup(edb::address_t address, std::size_t available) const;
+	void insert(edb::address_t address, const pointer &inst, std::size_t available);
+
+private:
+	mutable QMutex                 lock_;
+	QHash<edb::address_t, pointer> entries_;
+	quint64                        generation_;
+	int                            max_entries_;
+};
+
+#endif
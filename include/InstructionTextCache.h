@@ -0,0 +1,77 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef INSTRUCTION_TEXT_CACHE_20261014_H_
+#define INSTRUCTION_TEXT_CACHE_20261014_H_
+
+#include "API.h"
+#include "Instruction.h"
+#include "MemoryBudget.h"
+#include "Types.h"
+#include <QHash>
+#include <QMutex>
+#include <QString>
+
+// the text of instructions which have been formatted before. Entries are keyed
+// by the bytes of the instruction and the letter case, plus its address when
+// it has an operand relative to it, so the same instruction anywhere in
+// memory (and in any process) is only formatted once until the cache fills
+// up. Nothing here depends on the process's memory, so unlike the
+// InstructionCache it is never invalidated by the process running.
+//
+// Typical usage:
+//
+//     QString text; // may be reused from one instruction to the next
+//     edb::v1::instruction_text_cache().format(inst, upper, &text);
+class EDB_EXPORT InstructionTextCache : public edb::memory::Consumer {
+	Q_DISABLE_COPY(InstructionTextCache)
+public:
+	static const int DefaultMaxEntries = 16384;
+
+public:
+	explicit InstructionTextCache(int max_entries = DefaultMaxEntries);
+	virtual ~InstructionTextCache();
+
+public:
+	void format(const edb::Instruction &inst, bool upper, QString *text);
+	QString format(const edb::Instruction &inst, bool upper = false);
+	void clear();
+
+public:
+	virtual quint64 memory_used() const;
+	virtual void trim(quint64 bytes);
+
+public:
+	struct Key {
+		edb::address_t address;
+		quint8         bytes[edb::Instruction::MAX_SIZE];
+		quint8         size;
+		bool           upper;
+	};
+
+private:
+	mutable QMutex       lock_;
+	QHash<Key, QString>  entries_;
+	quint64              text_bytes_;
+	int                  max_entries_;
+};
+
+bool operator==(const InstructionTextCache::Key &lhs, const InstructionTextCache::Key &rhs);
+uint qHash(const InstructionTextCache::Key &key);
+
+#endif
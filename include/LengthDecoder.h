@@ -0,0 +1,439 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef LENGTH_DECODER_20261014_H_
+#define LENGTH_DECODER_20261014_H_
+
+#include <QtGlobal>
+#include <cstddef>
+
+// works out how long an x86 instruction is, and whether it changes the flow
+// of control, without decoding its operands. This is for the places which
+// would otherwise decode a whole edb::Instruction only to ask for its size.
+// Nothing is allocated and nothing but the opcode tables is looked at.
+//
+// It only answers for encodings it is sure of, which is nearly all of the
+// ordinary integer, x87 and SSE instructions. For anything else (VEX, EVEX,
+// XOP and 3DNow! encodings, invalid or truncated instructions, odd prefix
+// combinations) the answer is 0 and the caller should use edb::Instruction
+//
+// the mode specific entry point is edb::instruction_length, which lives in
+// include/arch/<arch>/InstructionLength.h next to Instruction.h
+
+namespace edb {
+namespace length {
+
+enum Flow {
+	FLOW_NONE,
+	FLOW_JUMP,
+	FLOW_CONDITIONAL,   // jcc, loop and jcxz
+	FLOW_CALL,
+	FLOW_RETURN
+};
+
+// no encoding may be longer than this
+const std::size_t MaxSize = 15;
+
+// where the parts of an instruction are, for code which copies instructions
+// somewhere else and has to patch them
+struct Layout {
+	std::size_t opcode;        // the offset of the first opcode byte, after any prefixes
+	std::size_t rip_relative;  // the offset of a RIP relative disp32, 0 if there isn't one
+};
+
+namespace detail {
+
+enum {
+	M   = 0x001, // has a ModRM byte
+	Ib  = 0x002, // an 8 bit immediate
+	Iw  = 0x004, // a 16 bit immediate
+	Iz  = 0x008, // a 16 or 32 bit immediate, by operand size
+	Iv  = 0x010, // a 16, 32 or 64 bit immediate, by operand size
+	Mo  = 0x020, // a memory offset, by address size
+	Ap  = 0x040, // a far pointer
+	No  = 0x080, // left to the full decoder
+	I64 = 0x100, // not valid in 64-bit mode
+	X   = 0x200  // needs a closer look
+};
+
+//------------------------------------------------------------------------------
+// Name: one_byte
+// Desc: prefixes are No here, they are taken care of before the table is used
+//------------------------------------------------------------------------------
+inline const quint16 *one_byte() {
+	static const quint16 table[256] = {
+		M,        M,        M,        M,        Ib,       Iz,       I64,      I64,      M,        M,        M,        M,        Ib,       Iz,       I64,      X, // 00
+		M,        M,        M,        M,        Ib,       Iz,       I64,      I64,      M,        M,        M,        M,        Ib,       Iz,       I64,      I64, // 10
+		M,        M,        M,        M,        Ib,       Iz,       No,       I64,      M,        M,        M,        M,        Ib,       Iz,       No,       I64, // 20
+		M,        M,        M,        M,        Ib,       Iz,       No,       I64,      M,        M,        M,        M,        Ib,       Iz,       No,       I64, // 30
+		0,        0,        0,        0,        0,        0,        0,        0,        0,        0,        0,        0,        0,        0,        0,        0, // 40
+		0,        0,        0,        0,        0,        0,        0,        0,        0,        0,        0,        0,        0,        0,        0,        0, // 50
+		I64,      I64,      M|I64|X,  M,        No,       No,       No,       No,       Iz,       M|Iz,     Ib,       M|Ib,     0,        0,        0,        0, // 60
+		Ib,       Ib,       Ib,       Ib,       Ib,       Ib,       Ib,       Ib,       Ib,       Ib,       Ib,       Ib,       Ib,       Ib,       Ib,       Ib, // 70
+		M|Ib,     M|Iz,     M|Ib|I64, M|Ib,     M,        M,        M,        M,        M,        M,        M,        M,        M,        M,        M,        M|X, // 80
+		0,        0,        0,        0,        0,        0,        0,        0,        0,        0,        Ap|I64,   0,        0,        0,        0,        0, // 90
+		Mo,       Mo,       Mo,       Mo,       0,        0,        0,        0,        Ib,       Iz,       0,        0,        0,        0,        0,        0, // A0
+		Ib,       Ib,       Ib,       Ib,       Ib,       Ib,       Ib,       Ib,       Iv,       Iv,       Iv,       Iv,       Iv,       Iv,       Iv,       Iv, // B0
+		M|Ib,     M|Ib,     Iw,       0,        M|I64|X,  M|I64|X,  M|Ib|X,   M|Iz|X,   Ib|Iw,    0,        Iw,       0,        0,        Ib,       I64,      0, // C0
+		M,        M,        M,        M,        Ib|I64,   Ib|I64,   No,       0,        M,        M,        M,        M,        M,        M,        M,        M, // D0
+		Ib,       Ib,       Ib,       Ib,       Ib,       Ib,       Ib,       Ib,       Iz|X,     Iz|X,     Ap|I64,   Ib,       0,        0,        0,        0, // E0
+		No,       No,       No,       No,       0,        0,        M|X,      M|X,      0,        0,        0,        0,        0,        0,        M|X,      M|X, // F0
+	};
+	return table;
+}
+
+//------------------------------------------------------------------------------
+// Name: two_byte
+// Desc: everything after 0F
+//------------------------------------------------------------------------------
+inline const quint16 *two_byte() {
+	static const quint16 table[256] = {
+		M,        M,        M,        M,        No,       X,        0,        X,        0,        0,        No,       0,        No,       M,        No,       No, // 00
+		M,        M,        M,        M,        M,        M,        M,        M,        M,        M,        M,        M,        M,        M,        M,        M, // 10
+		M|X,      M|X,      M|X,      M|X,      No,       No,       No,       No,       M,        M,        M,        M,        M,        M,        M,        M, // 20
+		0,        0,        0,        0,        0,        0,        No,       No,       X,        No,       X,        No,       No,       No,       No,       No, // 30
+		M,        M,        M,        M,        M,        M,        M,        M,        M,        M,        M,        M,        M,        M,        M,        M, // 40
+		M,        M,        M,        M,        M,        M,        M,        M,        M,        M,        M,        M,        M,        M,        M,        M, // 50
+		M,        M,        M,        M,        M,        M,        M,        M,        M,        M,        M,        M,        M,        M,        M,        M, // 60
+		M|Ib,     M|Ib,     M|Ib,     M|Ib,     M,        M,        M,        0,        No,       No,       No,       No,       M,        M,        M,        M, // 70
+		Iz|X,     Iz|X,     Iz|X,     Iz|X,     Iz|X,     Iz|X,     Iz|X,     Iz|X,     Iz|X,     Iz|X,     Iz|X,     Iz|X,     Iz|X,     Iz|X,     Iz|X,     Iz|X, // 80
+		M,        M,        M,        M,        M,        M,        M,        M,        M,        M,        M,        M,        M,        M,        M,        M, // 90
+		0,        0,        0,        M,        M|Ib,     M,        No,       No,       0,        0,        0,        M,        M|Ib,     M,        M,        M, // A0
+		M,        M,        M,        M,        M,        M,        M,        M,        M|X,      No,       M|Ib,     M,        M,        M,        M,        M, // B0
+		M,        M,        M|Ib,     M,        M|Ib,     M|Ib,     M|Ib,     M,        0,        0,        0,        0,        0,        0,        0,        0, // C0
+		M,        M,        M,        M,        M,        M,        M,        M,        M,        M,        M,        M,        M,        M,        M,        M, // D0
+		M,        M,        M,        M,        M,        M,        M,        M,        M,        M,        M,        M,        M,        M,        M,        M, // E0
+		M,        M,        M,        M,        M,        M,        M,        M,        M,        M,        M,        M,        M,        M,        M,        No, // F0
+	};
+	return table;
+}
+
+//------------------------------------------------------------------------------
+// Name: three_byte
+// Desc: true if 0F <map> <opcode> is an instruction we know, everything in
+//       these maps has a ModRM byte and those in 0F 3A an 8 bit immediate too
+//------------------------------------------------------------------------------
+inline bool three_byte(quint8 map, quint8 opcode) {
+	static const quint32 three_byte_38[8] = { 0x70b10fff, 0xffbf0f3f, 0x00000003, 0x00000000, 0x00000007, 0x00000000, 0xf8003f00, 0x00430000 };
+	static const quint32 three_byte_3a[8] = { 0x00f0ff00, 0x00000007, 0x00000017, 0x0000000f, 0x00000000, 0x00000000, 0x80001000, 0x00000000 };
+
+	const quint32 *const known = (map == 0x38) ? three_byte_38 : three_byte_3a;
+	return (known[opcode >> 5] >> (opcode & 31)) & 1;
+}
+
+//------------------------------------------------------------------------------
+// Name: is_prefix
+// Desc:
+//------------------------------------------------------------------------------
+inline bool is_prefix(quint8 byte) {
+	switch(byte) {
+	case 0x26: case 0x2e: case 0x36: case 0x3e: case 0x64: case 0x65:
+	case 0x66: case 0x67: case 0xf0: case 0xf2: case 0xf3:
+		return true;
+	default:
+		return false;
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: modrm_size
+// Desc: the size of the ModRM byte at <p> and the SIB byte and displacement
+//       which it calls for, 0 if the SIB byte would be past <last>
+//------------------------------------------------------------------------------
+inline std::size_t modrm_size(const quint8 *p, const quint8 *last, bool address16) {
+
+	if(p == last) {
+		return 0;
+	}
+
+	const int mod = *p >> 6;
+	const int rm  = *p & 7;
+
+	if(address16) {
+		if(mod == 1) {
+			return 2;
+		} else if(mod == 2 || (mod == 0 && rm == 6)) {
+			return 3;
+		}
+		return 1;
+	}
+
+	if(mod == 3) {
+		return 1;
+	}
+
+	std::size_t size = 1;
+	int base = rm;
+	if(rm == 4) {
+		if(last - p < 2) {
+			return 0;
+		}
+		++size;
+		base = p[1] & 7;
+	}
+
+	if(mod == 1) {
+		size += 1;
+	} else if(mod == 2 || (mod == 0 && base == 5)) {
+		size += 4;
+	}
+
+	return size;
+}
+
+}
+
+//------------------------------------------------------------------------------
+// Name: decode
+// Desc: returns the length of the instruction at [first, first + n) in 32-bit
+//       or (if <Long>) 64-bit mode, or 0 if the full decoder needs to look at
+//       it. If <flow> isn't null, it is set to how it changes the flow of
+//       control, and if <layout> isn't null it is filled in
+//------------------------------------------------------------------------------
+template <bool Long>
+std::size_t decode(const quint8 *first, std::size_t n, Flow *flow, Layout *layout = 0) {
+
+	using namespace detail;
+
+	const quint8 *const last = first + qMin(n, MaxSize);
+	const quint8 *p          = first;
+
+	bool operand16 = false;
+	bool address   = false; // the address size is overridden
+	bool rep       = false;
+	bool rex_w     = false;
+
+	for(; p != last && is_prefix(*p); ++p) {
+		switch(*p) {
+		case 0x66: operand16 = true; break;
+		case 0x67: address   = true; break;
+		case 0xf3: rep       = true; break;
+		default:
+			break;
+		}
+	}
+
+	// only a REX prefix which comes right before the opcode counts, anything
+	// else isn't worth being clever about
+	if(Long && p != last && (*p & 0xf0) == 0x40) {
+		rex_w = (*p & 0x08) != 0;
+		++p;
+		if(p != last && (is_prefix(*p) || (*p & 0xf0) == 0x40)) {
+			return 0;
+		}
+	}
+
+	if(p == last) {
+		return 0;
+	}
+
+	// REX.W wins over 66, Iz stays 4 bytes (66 48 c7 c0 imm32 is 7 long)
+	const bool address16    = !Long && address;
+	const std::size_t z     = (operand16 && !(Long && rex_w)) ? 2 : 4;
+	const std::size_t start = p - first;
+	const quint8 opcode     = *p++;
+	Flow kind               = FLOW_NONE;
+	bool register_only      = false; // the ModRM byte always names a register
+
+	quint16 entry = one_byte()[opcode];
+
+	if((entry & No) || (Long && (entry & I64))) {
+		return 0;
+	}
+
+	if(opcode == 0x0f) {
+		if(p == last) {
+			return 0;
+		}
+
+		const quint8 opcode2 = *p++;
+		entry = two_byte()[opcode2];
+
+		if(entry & No) {
+			return 0;
+		}
+
+		if(entry & X) {
+			switch(opcode2) {
+			case 0x05: // syscall
+			case 0x07: // sysret
+				if(!Long) {
+					return 0;
+				}
+				break;
+			case 0x20: case 0x21: case 0x22: case 0x23: // mov to and from cr and dr
+				register_only = true;
+				break;
+			case 0x38:
+			case 0x3a:
+				if(p == last || !three_byte(opcode2, *p)) {
+					return 0;
+				}
+				++p;
+				entry = (opcode2 == 0x3a) ? (M | Ib) : M;
+				break;
+			case 0xb8: // popcnt, without F3 it is jmpe
+				if(!rep) {
+					return 0;
+				}
+				break;
+			default: // jcc rel16/32
+				if(Long && operand16) {
+					return 0;
+				}
+				kind = FLOW_CONDITIONAL;
+				break;
+			}
+		}
+	} else {
+		if((opcode >= 0x70 && opcode <= 0x7f) || (opcode >= 0xe0 && opcode <= 0xe3)) {
+			kind = FLOW_CONDITIONAL;
+		}
+
+		switch(opcode) {
+		case 0x9a: kind = FLOW_CALL;   break;
+		case 0xea:
+		case 0xeb: kind = FLOW_JUMP;   break;
+		case 0xc2:
+		case 0xc3:
+		case 0xca:
+		case 0xcb:
+		case 0xcf: kind = FLOW_RETURN; break;
+		default:
+			break;
+		}
+
+		if(entry & X) {
+			if(p == last) {
+				return 0;
+			}
+
+			const int mod = *p >> 6;
+			const int reg = (*p >> 3) & 7;
+
+			switch(opcode) {
+			case 0x62: // bound, or EVEX
+			case 0xc4: // les, or VEX
+			case 0xc5: // lds, or VEX
+				if(mod == 3) {
+					return 0;
+				}
+				break;
+			case 0x8f: // pop, or XOP
+			case 0xc6: // mov, or xabort
+			case 0xc7: // mov, or xbegin
+				if(reg != 0) {
+					return 0;
+				}
+				break;
+			case 0xe8:
+			case 0xe9:
+				// AMD and Intel don't agree on what 66 does to these
+				if(Long && operand16) {
+					return 0;
+				}
+				kind = (opcode == 0xe8) ? FLOW_CALL : FLOW_JUMP;
+				break;
+			case 0xf6:
+			case 0xf7:
+				if(reg == 1) {
+					return 0;
+				} else if(reg == 0) {
+					entry |= (opcode == 0xf6) ? Ib : Iz;
+				}
+				break;
+			case 0xfe:
+				if(reg > 1) {
+					return 0;
+				}
+				break;
+			case 0xff:
+				if(reg == 7 || (mod == 3 && (reg == 3 || reg == 5))) {
+					return 0;
+				}
+				if(reg == 2 || reg == 3) {
+					kind = FLOW_CALL;
+				} else if(reg == 4 || reg == 5) {
+					kind = FLOW_JUMP;
+				}
+				break;
+			default:
+				break;
+			}
+		}
+	}
+
+	std::size_t immediate = 0;
+	if(entry & Ib) {
+		immediate += 1;
+	}
+	if(entry & Iw) {
+		immediate += 2;
+	}
+	if(entry & Iz) {
+		immediate += z;
+	}
+	if(entry & Iv) {
+		immediate += (Long && rex_w) ? 8 : z;
+	}
+	if(entry & Ap) {
+		immediate += z + 2;
+	}
+	if(entry & Mo) {
+		immediate += Long ? (address ? 4 : 8) : (address ? 2 : 4);
+	}
+
+	std::size_t size = p - first;
+	std::size_t rip_relative = 0;
+
+	if(entry & M) {
+		const std::size_t modrm = register_only ? (p != last ? 1 : 0) : modrm_size(p, last, address16);
+		if(modrm == 0) {
+			return 0;
+		}
+
+		// mod 00 with rm 101 is [rip+disp32] in 64-bit mode, and with a 67
+		// prefix [eip+disp32]
+		if(Long && !register_only && (*p & 0xc7) == 0x05) {
+			rip_relative = size + 1;
+		}
+
+		size += modrm;
+	}
+
+	size += immediate;
+	if(size > static_cast<std::size_t>(last - first)) {
+		return 0;
+	}
+
+	if(flow) {
+		*flow = kind;
+	}
+
+	if(layout) {
+		layout->opcode       = start;
+		layout->rip_relative = rip_relative;
+	}
+
+	return size;
+}
+
+}
+}
+
+#endif
@@ -0,0 +1,88 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef LOG_FORMAT_20261014_H_
+#define LOG_FORMAT_20261014_H_
+
+#include "API.h"
+#include "CompiledExpression.h"
+#include "Types.h"
+#include <QString>
+#include <QVector>
+
+class State;
+
+// the message of a logpoint, text with expressions in it which are filled in
+// from the registers and memory every time the breakpoint is hit:
+//
+//     %{expr}   the value of expr as a pointer
+//     %x{expr}  the value of expr in hex, without leading zeroes
+//     %d{expr}  the value of expr as a signed decimal
+//     %u{expr}  the value of expr as an unsigned decimal
+//     %s{expr}  the string at the address expr
+//     %%        a single %
+//
+// for example "fd=%d{rdi} len=%u{rdx} buf=%s{rsi}"
+class EDB_EXPORT LogFormat {
+public:
+	LogFormat();
+
+public:
+	bool compile(const QString &source, const State &state);
+
+	// fills in the message, expressions which can't be evaluated are shown
+	// as their error. Returns false if any of them couldn't be
+	bool format(const State &state, QString *line) const;
+
+public:
+	// true if the symbols have changed since the message was compiled
+	bool stale() const;
+
+	// true if any of the expressions need names looked up to be evaluated,
+	// see CompiledExpression::has_named_variables
+	bool has_named_variables() const;
+
+public:
+	const QString &source() const        { return source_; }
+	const ExpressionError &error() const { return error_; }
+	bool valid() const                   { return valid_; }
+
+private:
+	struct Piece {
+		enum Type {
+			TEXT,
+			POINTER,
+			HEX,
+			SIGNED,
+			UNSIGNED,
+			STRING
+		};
+
+		Type               type;
+		QString            text;
+		CompiledExpression expression;
+	};
+
+private:
+	QString         source_;
+	QVector<Piece>  pieces_;
+	ExpressionError error_;
+	bool            valid_;
+};
+
+#endif
@@ -0,0 +1,50 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef MAPPEDFILE_20261014_H_
+#define MAPPEDFILE_20261014_H_
+
+#include "API.h"
+#include <QSharedPointer>
+#include <QString>
+
+// a read only view of a whole file on disk. Everyone who asks for the same
+// file gets the same mapping for as long as anyone still holds it and the
+// file hasn't changed, which is decided by its inode and modification time.
+// Copies are cheap, the mapping goes away with the last of them
+class EDB_EXPORT MappedFile {
+public:
+	MappedFile();
+
+public:
+	static MappedFile open(const QString &filename);
+
+public:
+	bool is_open() const { return !mapping_.isNull(); }
+	const uchar *data() const;
+	qint64 size() const;
+	QString filename() const;
+
+private:
+	struct Mapping;
+
+private:
+	QSharedPointer<Mapping> mapping_;
+};
+
+#endif
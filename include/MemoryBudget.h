@@ -0,0 +1,80 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef MEMORY_BUDGET_20261014_H_
+#define MEMORY_BUDGET_20261014_H_
+
+#include "API.h"
+#include <QList>
+#include <QString>
+#include <QtGlobal>
+
+// how much memory edb's own caches may use between them. Each cache which
+// grows with the size of the target registers itself as a consumer and says
+// roughly how many bytes it holds; whenever the UI catches up with a stop,
+// enforce() adds them up and, if the total is over the budget, asks the
+// biggest ones to let go of their least recently used entries until it
+// isn't. Everything here is done on the UI thread, consumers which are also
+// used from other threads lock for themselves
+//
+// Typical usage:
+//
+//     class PageCache : public edb::memory::Consumer { ... };
+//
+//     edb::memory::add_consumer("debugger core: pages", &cache);
+//     ...
+//     edb::memory::remove_consumer(&cache);
+namespace edb {
+namespace memory {
+
+class Consumer {
+public:
+	virtual ~Consumer() {}
+
+public:
+	// an estimate of the heap it holds, in bytes
+	virtual quint64 memory_used() const = 0;
+
+	// drops entries, least recently used first, until it holds at most
+	// <bytes>. Anything dropped must be safe to make again later, a consumer
+	// with nothing like that to drop (a recording, search results) does
+	// nothing and still counts towards the total
+	virtual void trim(quint64 bytes) = 0;
+};
+
+struct Usage {
+	QString name;
+	quint64 bytes;
+};
+
+EDB_EXPORT void add_consumer(const QString &name, Consumer *consumer);
+EDB_EXPORT void remove_consumer(Consumer *consumer);
+
+// in bytes, from the options (Configuration::memory_budget). 0 means no limit
+EDB_EXPORT quint64 budget();
+
+EDB_EXPORT void enforce();
+EDB_EXPORT QList<Usage> usage();
+
+// edb's resident set size, 0 where the OS doesn't say
+EDB_EXPORT quint64 resident_size();
+
+}
+}
+
+#endif
@@ -0,0 +1,50 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef MEMORYDUMP_20261014_H_
+#define MEMORYDUMP_20261014_H_
+
+#include "API.h"
+#include "IRegion.h"
+#include <QCoreApplication>
+#include <QFile>
+#include <QString>
+#include <cstddef>
+
+// saves the memory of the debuggee to disk. Regions are read through the
+// debugger core in large windows and every window goes out in one unbuffered
+// write, so even a region of a few GB is dumped about as fast as the disk will
+// take it. Whatever can't be read is written as 0xff bytes, like read_bytes
+// gives back for it.
+//
+// CoreFile uses this to save every region at once as an ELF core file
+class EDB_EXPORT MemoryDump {
+	Q_DECLARE_TR_FUNCTIONS(MemoryDump)
+public:
+	// how much is read and written at a time
+	static const std::size_t WindowPages = 1024;
+
+public:
+	static bool save_region(const IRegion::pointer &region, const QString &filename, QString *error);
+	static bool write_region(QFile *file, const IRegion::pointer &region);
+
+private:
+	MemoryDump();
+};
+
+#endif
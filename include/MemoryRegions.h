@@ -22,8 +22,14 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "API.h"
 #include "Types.h"
 #include "IRegion.h"
+#include "MemoryUsage.h"
 #include <QAbstractItemModel>
+#include <QHash>
 #include <QList>
+#include <QSet>
+#include <QVector>
+
+class QTimer;
 
 class EDB_EXPORT MemoryRegions : public QAbstractItemModel {
 	Q_OBJECT
@@ -46,8 +52,39 @@ public:
 	void clear();
 	void sync();
 
+private Q_SLOTS:
+	void fetch_usage();
+
+private:
+	QVariant usage(const IRegion::pointer &region, int column) const;
+	int row_of(edb::address_t start) const;
+	void load_symbols(const IRegion::pointer &region);
+	void rebuild_index();
+
+private:
+	struct Range {
+		edb::address_t start;
+		edb::address_t end;
+	};
+
+	struct Usage {
+		MemoryUsage usage;
+		quint64     generation; // the sync it was found after
+		bool        known;
+	};
+
 private:
 	QList<IRegion::pointer> regions_;
+	QVector<Range>          index_;    // regions_ bounds, in the same order
+	mutable int             last_hit_; // index of the last region found, or -1
+
+	// how much of each region is in RAM, only ever found for the rows a view
+	// asks about, all at once soon after. Entries from before the last sync
+	// are still shown until they have been found again
+	mutable QHash<edb::address_t, Usage> usage_;
+	mutable QSet<edb::address_t>         usage_wanted_;
+	QTimer *const                        usage_timer_;
+	quint64                              usage_generation_;
 };
 
 #endif
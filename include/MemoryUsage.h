@@ -0,0 +1,30 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef MEMORY_USAGE_20261014_H_
+#define MEMORY_USAGE_20261014_H_
+
+#include <QtGlobal>
+
+// how much of some memory is in RAM, in bytes. <proportional> counts each
+// shared page as its share between the processes which map it (the PSS)
+struct MemoryUsage {
+	quint64 resident;
+	quint64 proportional;
+};
+
+#endif
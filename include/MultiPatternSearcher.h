@@ -0,0 +1,76 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef MULTIPATTERNSEARCHER_20261014_H_
+#define MULTIPATTERNSEARCHER_20261014_H_
+
+#include "API.h"
+#include "Types.h"
+#include <QByteArray>
+#include <QVector>
+
+// finds any number of byte strings in a single pass using an Aho-Corasick
+// automaton. The automaton is expanded into a full table of transitions when
+// compiled, costing 1KB per state (one per distinct pattern prefix), so that
+// each byte scanned is one lookup no matter how many patterns there are.
+// Scanning can be split over several buffers by passing the state returned
+// from one call to the next, matches which straddle buffers are still found.
+//
+// Typical usage:
+//
+//     MultiPatternSearcher searcher;
+//     searcher.add_pattern(a);
+//     searcher.add_pattern(b);
+//     searcher.compile();
+//
+//     int state = searcher.start_state();
+//     while(reader.next()) {
+//         state = searcher.scan(state, reader.data(), reader.data() + reader.size(), reader.address(), &matches);
+//     }
+class EDB_EXPORT MultiPatternSearcher {
+public:
+	struct Match {
+		int            pattern; // as returned by add_pattern
+		edb::address_t address; // of the first byte
+	};
+
+public:
+	MultiPatternSearcher();
+
+public:
+	int add_pattern(const QByteArray &pattern);
+	void compile();
+
+public:
+	int pattern_count() const                  { return patterns_.size(); }
+	const QByteArray &pattern(int id) const    { return patterns_[id]; }
+	int start_state() const                    { return 0; }
+	int scan(int state, const quint8 *first, const quint8 *last, edb::address_t address, QVector<Match> *matches) const;
+
+private:
+	int add_state();
+
+private:
+	QVector<QByteArray> patterns_;
+	QVector<int>        next_;        // transitions, 256 per state
+	QVector<int>        output_;      // per state, a pattern ending there or -1
+	QVector<int>        output_link_; // per state, the next state down its failure links with an output, or -1
+	QVector<int>        same_;        // per pattern, another pattern just like it or -1
+	bool                compiled_;
+};
+
+#endif
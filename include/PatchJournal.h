@@ -0,0 +1,100 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef PATCH_JOURNAL_20261014_H_
+#define PATCH_JOURNAL_20261014_H_
+
+#include "API.h"
+#include "Types.h"
+#include <QByteArray>
+#include <QObject>
+#include <QString>
+#include <QVector>
+
+// every change edb makes to the process's code and data on the user's behalf
+// (fills, edits of the views, assembled instructions). Each edit is written
+// with as few writes as possible, ranges which share a page are written
+// together, and what was there before is kept so that it can be undone and
+// redone. The net effect of the edits can be exported as a diff or written
+// into the file the memory was mapped from.
+//
+// Typical usage:
+//
+//     edb::v1::patch_journal().write(tr("Fill"), address, bytes);
+class EDB_EXPORT PatchJournal : public QObject {
+	Q_OBJECT
+
+public:
+	// bytes to be written at an address
+	struct Range {
+		edb::address_t address;
+		QByteArray     bytes;
+	};
+
+	// one write, <original> is what was there before it
+	struct Patch {
+		edb::address_t address;
+		QByteArray     original;
+		QByteArray     bytes;
+	};
+
+	// the writes of one edit, which are undone and redone together
+	struct Entry {
+		QString        description;
+		QVector<Patch> patches;
+	};
+
+public:
+	PatchJournal();
+
+public:
+	bool write(const QString &description, const QVector<Range> &ranges);
+	bool write(const QString &description, edb::address_t address, const QByteArray &bytes);
+	bool undo();
+	bool redo();
+	void clear();
+
+public:
+	bool can_undo() const             { return applied_ > 0; }
+	bool can_redo() const             { return applied_ < entries_.size(); }
+	QString undo_description() const;
+	QString redo_description() const;
+
+public:
+	// the bytes which differ from what was there before the first edit, one
+	// patch per run of them
+	QVector<Patch> changes() const;
+	QString diff() const;
+
+	// writes the changes to memory mapped from <module> into a copy of it
+	// named <filename> (the module itself if they are the same), sets
+	// <count> to the number of bytes written
+	bool save_to_file(const QString &module, const QString &filename, int *count, QString *error) const;
+
+Q_SIGNALS:
+	void changed();
+
+private:
+	bool rewrite(const Patch &patch, bool undo);
+
+private:
+	QVector<Entry> entries_;
+	int            applied_;  // entries_ before this one have been done
+};
+
+#endif
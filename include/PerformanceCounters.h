@@ -0,0 +1,40 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef PERFORMANCE_COUNTERS_20261014_H_
+#define PERFORMANCE_COUNTERS_20261014_H_
+
+#include <QtGlobal>
+
+// what the CPU's performance counters have counted of a process in user
+// space, summed over its threads. Counters the CPU (or the kernel) doesn't
+// have are left out of <available>
+struct PerformanceCounters {
+	enum Counter {
+		INSTRUCTIONS,
+		CYCLES,
+		CACHE_MISSES,
+		BRANCH_MISSES,
+		COUNTER_COUNT
+	};
+
+	quint64 values[COUNTER_COUNT];
+	quint32 available; // a bit for each Counter which was counted
+};
+
+#endif
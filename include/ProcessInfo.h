@@ -20,6 +20,8 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #define PROCESS_20120728_H_
 
 #include "Types.h"
+#include <QList>
+#include <QMetaType>
 #include <QString>
 
 struct ProcessInfo {
@@ -29,4 +31,7 @@ struct ProcessInfo {
 	QString    name;
 };
 
+Q_DECLARE_METATYPE(ProcessInfo)
+Q_DECLARE_METATYPE(QList<ProcessInfo>)
+
 #endif
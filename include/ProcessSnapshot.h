@@ -0,0 +1,99 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef PROCESSSNAPSHOT_20261014_H_
+#define PROCESSSNAPSHOT_20261014_H_
+
+#include "API.h"
+#include "CoreFile.h"
+#include "IProcess.h"
+#include <QTemporaryFile>
+#include <QVector>
+
+// a read-only copy of some of the regions of a stopped process. The contents
+// live in a memory mapped temporary file rather than on the heap, and once
+// captured nothing here touches the debugger core, so it is safe to scan a
+// snapshot from worker threads while the live process keeps running.
+//
+// Typical usage:
+//
+//     ProcessSnapshot *snapshot = new ProcessSnapshot(edb::v1::debugger_core->process());
+//     Q_FOREACH(const IRegion::pointer &region, regions) {
+//         snapshot->add_region(region);
+//     }
+//     // hand snapshot off to a thread, it's just an IProcess
+//
+// A snapshot can also be made from a core file, its contents are then read
+// straight out of the mapped core rather than copied anywhere
+class EDB_EXPORT ProcessSnapshot : public IProcess {
+	Q_DISABLE_COPY(ProcessSnapshot)
+public:
+	explicit ProcessSnapshot(IProcess *process);
+	virtual ~ProcessSnapshot();
+
+public:
+	static ProcessSnapshot *open_core(const QString &filename, QString *error);
+
+public:
+	bool add_region(const IRegion::pointer &region);
+
+public:
+	virtual QDateTime               start_time() const                { return start_time_; }
+	virtual QList<QByteArray>       arguments() const                 { return arguments_; }
+	virtual QString                 current_working_directory() const { return current_working_directory_; }
+	virtual QString                 executable() const                { return executable_; }
+	virtual edb::pid_t              pid() const                       { return pid_; }
+	virtual pointer                 parent() const                    { return pointer(); }
+	virtual edb::address_t          code_address() const              { return code_address_; }
+	virtual edb::address_t          data_address() const              { return data_address_; }
+	virtual QList<IRegion::pointer> regions() const;
+
+public:
+	virtual bool write_bytes(edb::address_t address, const void *buf, size_t len);
+	virtual bool read_bytes(edb::address_t address, void *buf, size_t len);
+	virtual bool read_pages(edb::address_t address, void *buf, size_t count);
+
+public:
+	// direct access to the captured bytes of a region, or NULL if the address
+	// isn't part of the snapshot. This is valid for the life of the snapshot
+	const quint8 *data(edb::address_t address, size_t *available) const;
+
+private:
+	struct Chunk {
+		IRegion::pointer region;
+		const quint8    *data;
+	};
+
+	const Chunk *find_chunk(edb::address_t address) const;
+
+private:
+	QTemporaryFile    file_;
+	CoreFile          core_;
+	QVector<Chunk>    chunks_;
+	qint64            file_size_;
+	edb::address_t    page_size_;
+	QDateTime         start_time_;
+	QList<QByteArray> arguments_;
+	QString           current_working_directory_;
+	QString           executable_;
+	edb::pid_t        pid_;
+	edb::address_t    code_address_;
+	edb::address_t    data_address_;
+};
+
+#endif
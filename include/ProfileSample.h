@@ -0,0 +1,35 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef PROFILE_SAMPLE_20261014_H_
+#define PROFILE_SAMPLE_20261014_H_
+
+#include "Types.h"
+
+// where a thread was when a profiling backend sampled it, along with the
+// first few return addresses on its stack, innermost first
+struct ProfileSample {
+	enum { MAX_DEPTH = 16 };
+
+	edb::tid_t     tid;
+	edb::address_t ip;
+	int            depth; // how many of <callers> are filled in
+	edb::address_t callers[MAX_DEPTH];
+};
+
+#endif
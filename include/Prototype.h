@@ -20,20 +20,21 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #define PROTOTYPE_20070320_H_
 
 #include "API.h"
-#include <QVector>
-#include <QString>
 
 namespace edb {
 
+// these are compiled in from xml/functions.xml, see compile_prototypes.py.
+// Types are mangled the way functions.xml describes
 struct EDB_EXPORT Argument {
-	QString name;
-	QString type;
+	const char *name;
+	const char *type;
 };
 
 struct EDB_EXPORT Prototype {
-	QString           name;
-	QString           type;
-	QVector<Argument> arguments;
+	const char     *name;
+	const char     *type;
+	const Argument *arguments;
+	int             argument_count;
 };
 
 }
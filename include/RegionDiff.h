@@ -0,0 +1,78 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef REGIONDIFF_20261014_H_
+#define REGIONDIFF_20261014_H_
+
+#include "API.h"
+#include "IRegion.h"
+#include "Types.h"
+#include <QList>
+#include <QScopedPointer>
+#include <QVector>
+
+class ProcessSnapshot;
+
+// finds out what changed in a set of regions between two stops. A baseline
+// is captured as a ProcessSnapshot along with a hash of every page. compare()
+// then hashes the live pages and only byte compares the ones whose hashes
+// differ, so an unchanged multi-gigabyte heap costs one pass of hashing.
+class EDB_EXPORT RegionDiff {
+	Q_DISABLE_COPY(RegionDiff)
+public:
+	struct Change {
+		edb::address_t address;
+		edb::address_t size;
+	};
+
+public:
+	RegionDiff();
+	~RegionDiff();
+
+public:
+	void set_baseline(const QList<IRegion::pointer> &regions);
+	void clear();
+	bool has_baseline() const;
+
+public:
+	// returns the byte ranges which differ from the baseline, adjacent ranges
+	// are merged. If <changed_pages> is given, it receives the address of
+	// every page which had at least one changed byte
+	QVector<Change> compare(QVector<edb::address_t> *changed_pages = 0) const;
+
+public:
+	// appends the runs of bytes which differ between <live> and <old>, both
+	// <size> bytes long and standing for the memory at <address>, to <changes>
+	static void diff(const quint8 *live, const quint8 *old, std::size_t size, edb::address_t address, QVector<Change> *changes);
+
+	// true if any of [address, address + size) is in <changes>, which must
+	// be sorted and not overlap, as diff() and compare() leave them
+	static bool overlaps(const QVector<Change> &changes, edb::address_t address, edb::address_t size);
+
+private:
+	struct Baseline {
+		IRegion::pointer region;
+		QVector<quint64> hashes;
+	};
+
+	QScopedPointer<ProcessSnapshot> snapshot_;
+	QVector<Baseline>               baseline_;
+	edb::address_t                  page_size_;
+};
+
+#endif
@@ -0,0 +1,74 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef REGIONREADER_20261014_H_
+#define REGIONREADER_20261014_H_
+
+#include "API.h"
+#include "IRegion.h"
+#include "Types.h"
+#include <QVector>
+#include <cstddef>
+
+// walks a region a fixed number of pages at a time using a single reusable
+// buffer, so that scanning even a very large region runs in constant memory.
+// Each window may also carry up to <lookahead> bytes from the start of the
+// next window so that things which straddle a window boundary (search
+// patterns, instructions, pointers) can still be examined in one piece.
+//
+// Typical usage:
+//
+//     RegionReader reader(region, pattern_size - 1);
+//     while(reader.next()) {
+//         for(std::size_t i = 0; i < reader.size(); ++i) {
+//             // reader.data()[i] up to reader.data()[reader.available() - 1]
+//             // can be looked at, reader.address() + i is the address
+//         }
+//     }
+class EDB_EXPORT RegionReader {
+	Q_DISABLE_COPY(RegionReader)
+public:
+	static const std::size_t DefaultWindowPages = 64;
+
+public:
+	explicit RegionReader(std::size_t lookahead = 0, std::size_t window_pages = DefaultWindowPages);
+	RegionReader(const IRegion::pointer &region, std::size_t lookahead = 0, std::size_t window_pages = DefaultWindowPages);
+
+public:
+	void reset(const IRegion::pointer &region);
+	bool next();
+
+public:
+	edb::address_t address() const { return address_; }
+	const quint8 *data() const     { return buffer_.constData(); }
+	std::size_t size() const       { return size_; }
+	std::size_t available() const  { return available_; }
+	edb::address_t offset() const;
+
+private:
+	IRegion::pointer region_;
+	QVector<quint8>  buffer_;
+	edb::address_t   address_;
+	edb::address_t   next_address_;
+	std::size_t      size_;
+	std::size_t      available_;
+	std::size_t      lookahead_;
+	std::size_t      window_pages_;
+};
+
+#endif
@@ -0,0 +1,100 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef REGIONSCANNER_20261014_H_
+#define REGIONSCANNER_20261014_H_
+
+#include "API.h"
+#include "IRegion.h"
+#include "Types.h"
+#include <QList>
+#include <QVector>
+#include <cstddef>
+
+template <class T> class QQueue;
+class QThreadPool;
+
+// scans regions in parallel. The regions are read a window at a time on the
+// calling thread (reading the process isn't thread safe) and each window is
+// handed to a thread pool to be scanned. Every window gets a result of its
+// own, so the scanning threads never share anything, and the results are
+// given back on the calling thread in address order as they become ready.
+// Only a few windows are in flight at once, so memory use stays bounded.
+//
+// Typical usage:
+//
+//     class FindTask : public RegionScanner::Task {
+//         virtual Result *scan(const RegionScanner::Chunk &chunk) const { ... }
+//         virtual void merge(Result *result) { ... }
+//     };
+//
+//     FindTask task;
+//     RegionScanner().run(regions, &task);
+class EDB_EXPORT RegionScanner {
+	Q_DISABLE_COPY(RegionScanner)
+public:
+	struct Chunk {
+		IRegion::pointer region;
+		edb::address_t   address; // of data[0]
+		std::size_t      size;    // hits have to start in the first size bytes
+		QVector<quint8>  data;    // those, then up to lookahead bytes which follow
+	};
+
+	// what to look for. scan is called on pool threads, for several chunks at
+	// once, so should only look at the chunk and build its result. merge and
+	// progress are called on the thread which called run
+	class Task {
+	public:
+		class Result {
+		public:
+			virtual ~Result() {}
+		};
+
+		// for the common case of a list of things found per chunk
+		template <class T>
+		class List : public Result {
+		public:
+			QVector<T> items;
+		};
+
+	public:
+		virtual ~Task() {}
+
+	public:
+		virtual std::size_t lookahead() const { return 0; }
+		virtual Result *scan(const Chunk &chunk) const = 0;
+		virtual void merge(Result *result) = 0;
+		virtual void progress(int percent) { Q_UNUSED(percent); }
+	};
+
+public:
+	explicit RegionScanner(QThreadPool *pool = 0);
+
+public:
+	void run(const QList<IRegion::pointer> &regions, Task *task);
+
+private:
+	class Job;
+
+private:
+	static void merge_oldest(QQueue<Job *> *pending, Task *task, edb::address_t *merged, edb::address_t total);
+
+private:
+	QThreadPool *pool_;
+};
+
+#endif
@@ -0,0 +1,86 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef RESULTSMODEL_20261014_H_
+#define RESULTSMODEL_20261014_H_
+
+#include "API.h"
+#include "Types.h"
+#include <QAbstractListModel>
+#include <QScopedPointer>
+#include <QVector>
+
+// a list of search results for a QListView. Results are kept as small plain
+// structs and a row's text is only made when the view asks for it, so even
+// millions of results cost little more than their 16 bytes each. Sorting and
+// filtering work on the results themselves, never on the text.
+//
+// Qt::UserRole is the result's address and ResultsModel::TypeRole its type
+class EDB_EXPORT ResultsModel : public QAbstractListModel {
+	Q_OBJECT
+
+public:
+	enum {
+		TypeRole = Qt::UserRole + 1
+	};
+
+public:
+	struct Result {
+		edb::address_t address;
+		quint32        type;   // whatever the search wants, e.g. which pattern
+		quint32        size;   // as is this, e.g. how long a string is
+	};
+
+	// how a result appears, only called for the rows being shown
+	class Formatter {
+	public:
+		virtual ~Formatter() {}
+		virtual QString format(const Result &result) const = 0;
+	};
+
+	// which results to show
+	class Filter {
+	public:
+		virtual ~Filter() {}
+		virtual bool accept(const Result &result) const = 0;
+	};
+
+public:
+	explicit ResultsModel(QObject *parent = 0);
+	virtual ~ResultsModel();
+
+public:
+	virtual QVariant data(const QModelIndex &index, int role) const;
+	virtual int rowCount(const QModelIndex &parent = QModelIndex()) const;
+	virtual void sort(int column, Qt::SortOrder order = Qt::AscendingOrder);
+
+public:
+	void addResult(const Result &result);
+	void addResults(const QVector<Result> &results);
+	void clear();
+	const Result &result(const QModelIndex &index) const;
+	void setFilter(Filter *filter);
+	void setFormatter(Formatter *formatter);
+
+private:
+	QVector<Result>           results_;
+	QVector<int>              visible_;  // indexes into results_ when filtered
+	QScopedPointer<Formatter> formatter_;
+	QScopedPointer<Filter>    filter_;
+};
+
+#endif
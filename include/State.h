@@ -30,6 +30,8 @@ class QString;
 
 namespace DebuggerCore { class DebuggerCore; }
 
+// the registers of a thread. Copies are cheap, they share the registers
+// until one of them is changed (copy on write)
 class EDB_EXPORT State {
 	friend class DebuggerCore::DebuggerCore;
 
@@ -39,14 +41,24 @@ public:
 	State(const State &other);
 	~State();
 
+#ifdef Q_COMPILER_RVALUE_REFS
+public:
+	State(State &&other);
+	State &operator=(State &&other);
+#endif
+
 public:
 	void swap(State &other);
 
 public:
 	QByteArray xmm_register(int n) const;
+	QByteArray ymm_register(int n) const;
+	QByteArray zmm_register(int n) const;
 	QString flags_to_string() const;
 	QString flags_to_string(edb::reg_t flags) const;
 	Register value(const QString &reg) const;
+	int register_index(const QString &name) const;
+	edb::reg_t register_value(int index) const;
 	edb::address_t frame_pointer() const;
 	edb::address_t instruction_pointer() const;
 	edb::address_t stack_pointer() const;
@@ -67,6 +79,10 @@ public:
 public:
 	Register operator[](const QString &reg) const;
 
+private:
+	IState *detach();
+	static void release(IState *impl);
+
 private:
 	IState *impl_;
 };
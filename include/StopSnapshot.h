@@ -0,0 +1,46 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef STOP_SNAPSHOT_20261014_H_
+#define STOP_SNAPSHOT_20261014_H_
+
+#include "IRegion.h"
+#include "State.h"
+#include "Types.h"
+#include <QList>
+#include <QSharedPointer>
+
+// what the process looked like when the views were last brought up to date,
+// it is made once per refresh so that everything which is shown for a stop
+// agrees with everything else, and so that the same questions don't get
+// asked of the core over and over. It never changes once it is made, a new one
+// is made for the next refresh
+struct StopSnapshot {
+	typedef QSharedPointer<const StopSnapshot> pointer;
+
+	StopSnapshot() : active_thread(0), generation(0), number(0) {}
+
+	State             state;          // the active thread's registers
+	edb::tid_t        active_thread;
+	QList<edb::tid_t> threads;
+	IRegion::pointer  code_region;    // the region the instruction pointer is in, if any
+	quint64           generation;     // the process' memory_generation when this was made
+	quint64           number;         // counts the snapshots made, so a consumer can tell if it has seen this one
+};
+
+#endif
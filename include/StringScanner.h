@@ -0,0 +1,104 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef STRINGSCANNER_20261014_H_
+#define STRINGSCANNER_20261014_H_
+
+#include "API.h"
+#include "RegionScanner.h"
+#include "Types.h"
+#include <QList>
+#include <QVector>
+
+// finds runs of printable characters in regions, the same characters that
+// edb::v1::get_ascii_string_at_address and get_utf16_string_at_address
+// accept. Each window is classified 16 bytes at a time where SSE2 is
+// available, and only the start and length of each run is kept, so nothing is
+// read a byte at a time. Windows are scanned in parallel, a run which crosses
+// from one window into the next is joined back together when they are merged,
+// so every string is found once, however long it is.
+//
+// Typical usage:
+//
+//     class FindStrings : public StringScanner {
+//         virtual void found(const QVector<String> &strings) { ... }
+//     };
+//
+//     FindStrings scanner(min_length, true);
+//     scanner.run(regions);
+class EDB_EXPORT StringScanner : public RegionScanner::Task {
+public:
+	enum Encoding {
+		ENCODING_ASCII,
+		ENCODING_UTF16
+	};
+
+	struct String {
+		edb::address_t address;
+		quint32        length;   // in characters
+		Encoding       encoding;
+	};
+
+public:
+	StringScanner(int min_length, bool utf16);
+
+public:
+	// printable or whitespace, as get_ascii_string_at_address has it
+	static bool is_ascii_char(quint8 ch) {
+		return (ch >= 0x20 && ch < 0x7f) || (ch >= 0x09 && ch <= 0x0d);
+	}
+
+	static std::size_t ascii_length(const quint8 *p, std::size_t size);
+	static std::size_t utf16_length(const quint8 *p, std::size_t size);
+
+public:
+	void run(const QList<IRegion::pointer> &regions);
+
+public:
+	virtual std::size_t lookahead() const;
+	virtual Result *scan(const RegionScanner::Chunk &chunk) const;
+	virtual void merge(Result *result);
+
+protected:
+	// called on the thread which called run, a window's worth at a time.
+	// Strings come roughly in address order, sort them if it matters
+	virtual void found(const QVector<String> &strings) = 0;
+
+private:
+	struct Run {
+		String string;
+		bool   head; // starts at the beginning of its window, may continue one
+		bool   tail; // reaches the end of its window, may be continued
+	};
+
+	class Runs;
+
+private:
+	void add_run(QVector<Run> *runs, edb::address_t address, quint32 length, Encoding encoding, bool head, bool tail) const;
+	void find_ascii(const RegionScanner::Chunk &chunk, QVector<Run> *runs) const;
+	void find_utf16(const RegionScanner::Chunk &chunk, std::size_t parity, QVector<Run> *runs) const;
+	void flush(QVector<String> *strings);
+
+private:
+	const quint32  min_length_;
+	const bool     utf16_;
+	QVector<Run>   open_;     // tails of the last window merged
+	const IRegion *open_region_;
+	edb::address_t open_end_;
+};
+
+#endif
@@ -0,0 +1,105 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SYMBOL_CACHE_20261014_H_
+#define SYMBOL_CACHE_20261014_H_
+
+#include "API.h"
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+#include <QVector>
+
+// a binary symbol file which is used in place of parsing text symbol files.
+// it is mapped into memory and every lookup is served directly from the
+// mapping, so loading a module's symbols costs nothing per symbol. The layout
+// is a header, a table of entries sorted by address, a hash table of entry
+// indexes by name and finally a pool of nul terminated names. C++ names are
+// demangled as the cache is written, which happens on the generator's thread,
+// so the views never pay for it. Both forms of a name are in the pool and the
+// hash table. It is written in native byte order, it is a cache and not meant
+// to be copied between machines
+class EDB_EXPORT SymbolCache {
+	Q_DISABLE_COPY(SymbolCache)
+
+public:
+	static const quint32 Version = 2;
+
+public:
+	struct Record {
+		quint64    address;
+		quint64    size;
+		QByteArray name;
+		char       type;
+	};
+
+public:
+	SymbolCache();
+	~SymbolCache();
+
+public:
+	static bool write(const QString &filename, const QString &source, QVector<Record> records);
+
+public:
+	bool open(const QString &filename);
+	void close();
+	bool is_open() const;
+	bool matches(const QString &source) const;
+
+public:
+	QByteArray md5() const;
+	QString source() const;
+	quint32 count() const;
+	quint64 address(quint32 index) const;
+	quint64 size(quint32 index) const;
+	char type(quint32 index) const;
+	const char *name(quint32 index) const;
+	const char *demangled(quint32 index) const;
+
+public:
+	qint64 find(quint64 address) const;
+	qint64 find_near(quint64 address) const;
+	qint64 find(const QByteArray &symbol) const;
+	QVector<quint32> find_prefix(const QByteArray &prefix) const;
+
+public:
+	// the mapping is the file's, only the name index is on the heap, and it
+	// is built again by the next prefix search after being dropped
+	quint64 memory_used() const { return by_name_.capacity() * sizeof(quint32); }
+	void drop_name_index()      { by_name_ = QVector<quint32>(); }
+
+private:
+	struct Header;
+	struct Entry;
+
+private:
+	static void insert_name(QVector<quint32> *hash, const QByteArray &strings, const QVector<Entry> &entries, quint32 offset, int index);
+
+private:
+	QFile         file_;
+	const Header *header_;
+	const Entry  *entries_;
+	const quint32 *hash_;
+	const char   *strings_;
+
+	// entry indexes sorted by demangled name, only built once a prefix search
+	// needs it
+	mutable QVector<quint32> by_name_;
+};
+
+#endif
@@ -0,0 +1,35 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SYSCALL_RECORD_20261014_H_
+#define SYSCALL_RECORD_20261014_H_
+
+#include "Types.h"
+
+// a syscall as recorded by a syscall tracing backend, the arguments are in the
+// order the syscall takes them. <returned> is false if the syscall hadn't
+// finished yet when the trace was read, <result> is meaningless then
+struct SyscallRecord {
+	edb::tid_t tid;
+	edb::reg_t number;
+	edb::reg_t arguments[6];
+	edb::reg_t result;
+	bool       returned;
+};
+
+#endif
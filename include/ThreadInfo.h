@@ -10,7 +10,7 @@ struct ThreadInfo {
 	edb::address_t ip;
 	int            priority;
 	QString        state;
-	
+	bool           running; // still executing while the debugger is paused (non-stop mode)
 };
 
 #endif
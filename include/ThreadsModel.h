@@ -20,17 +20,23 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #define THREADS_MODEL_H_
 
 #include <QAbstractItemModel>
+#include <QList>
 #include <QVector>
 #include "Types.h"
 #include "ThreadInfo.h"
 
+// the threads of the process. Rows are added and removed as threads come and
+// go rather than the whole model being reset, and a thread's details (which
+// may mean reading /proc) are only fetched once its row is actually shown
 class ThreadsModel : public QAbstractItemModel {
 	Q_OBJECT
 
 public:
 	struct Item {
-		ThreadInfo info;
-		bool       current;
+		edb::tid_t         tid;
+		bool               current;
+		mutable bool       loaded;  // false until info has been fetched
+		mutable ThreadInfo info;
 	};
 
 public:
@@ -48,6 +54,10 @@ public:
 public:
 	void addThread(const ThreadInfo &info, bool current);
 	void clear();
+	void sync(const QList<edb::tid_t> &threads, edb::tid_t current);
+
+private:
+	const ThreadInfo &info(const Item &item) const;
 
 private:
 	QVector<Item> items_;
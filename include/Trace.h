@@ -0,0 +1,74 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef TRACE_20261014_H_
+#define TRACE_20261014_H_
+
+#include "API.h"
+#include <QByteArray>
+#include <QtGlobal>
+
+// spans of time spent in edb's hot paths, for seeing where the milliseconds
+// go between a debug event and the next frame. They are only recorded when
+// edb is built with CONFIG+=tracing (which defines EDB_TRACING), otherwise
+// EDB_TRACE_SCOPE is nothing at all.
+//
+// Each thread records into a buffer only it writes, which keeps the last
+// BufferSize spans, so recording takes no locks. to_chrome_json gives them
+// in the Trace Event format chrome://tracing and Perfetto read
+//
+// Typical usage:
+//
+//     void Debugger::update_gui() {
+//         EDB_TRACE_SCOPE("Debugger::update_gui");
+//         ...
+//     }
+namespace edb {
+namespace trace {
+
+// <name> must outlive the trace, string literals are what it's meant for
+EDB_EXPORT void record(const char *name, quint64 start, quint64 end);
+EDB_EXPORT bool enabled();
+EDB_EXPORT void clear();
+EDB_EXPORT QByteArray to_chrome_json();
+
+#ifdef EDB_TRACING
+class EDB_EXPORT Span {
+	Q_DISABLE_COPY(Span)
+public:
+	explicit Span(const char *name);
+	~Span();
+
+private:
+	const char *const name_;
+	const quint64     start_;
+};
+#endif
+
+}
+}
+
+#ifdef EDB_TRACING
+#define EDB_TRACE_JOIN2(a, b) a##b
+#define EDB_TRACE_JOIN(a, b)  EDB_TRACE_JOIN2(a, b)
+#define EDB_TRACE_SCOPE(name) const edb::trace::Span EDB_TRACE_JOIN(edb_trace_span_, __LINE__)(name)
+#else
+#define EDB_TRACE_SCOPE(name) static_cast<void>(0)
+#endif
+
+#endif
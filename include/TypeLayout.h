@@ -0,0 +1,113 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef TYPE_LAYOUT_20261014_H_
+#define TYPE_LAYOUT_20261014_H_
+
+#include "API.h"
+#include "Types.h"
+#include <QHash>
+#include <QSharedPointer>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+// structures defined by C declarations, such as
+//
+//     struct point { int x; int y; };
+//     typedef struct { unsigned int kind; struct point points[16]; char *name; } shape;
+//
+// laid out the way the C compiler of the platform would, so that they can be
+// overlaid on memory. Finding out what is at an offset walks down the
+// definition without expanding any of its arrays, so it costs the same
+// whether an array has one element or a million
+class EDB_EXPORT TypeLayout {
+public:
+	struct Type;
+	typedef QSharedPointer<Type> type_pointer;
+
+	struct Field {
+		QString      name;      // empty for the members of an anonymous struct or union
+		quint64      offset;
+		type_pointer type;
+	};
+
+	struct Type {
+		enum Kind {
+			SIGNED,
+			UNSIGNED,
+			CHAR,
+			FLOAT,
+			POINTER,
+			ARRAY,
+			STRUCT,
+			UNION
+		};
+
+		Type() : kind(SIGNED), size(0), alignment(1), count(0), complete(true) {}
+
+		Kind           kind;
+		QString        name;      // "int", "struct point", "char *", "struct point[16]"
+		quint64        size;
+		quint64        alignment;
+		type_pointer   element;   // what a pointer points to, or what an array holds
+		quint64        count;     // the number of elements of an array
+		QVector<Field> fields;    // of a struct or union, by offset
+		bool           complete;  // false for structs which were only declared
+	};
+
+	// the innermost value at an offset, <path> names it from the outside, like
+	// "points[3].x", and <offset> is where it starts
+	struct Location {
+		QString      path;
+		type_pointer type;
+		quint64      offset;
+	};
+
+public:
+	// adds the definitions in <source>, declarations which can't be
+	// understood are skipped and described in <errors>
+	bool parse(const QString &source, QStringList *errors);
+	void clear();
+
+public:
+	// a defined type, or one made from it, like "struct point", "point",
+	// "shape *" or "struct point[1000000]"
+	type_pointer find(const QString &name) const;
+	QStringList names() const;
+
+public:
+	// the scalar (or string) at <offset> into a value of <type>, false if the
+	// offset is padding or past the end of it
+	static bool locate(const type_pointer &type, quint64 offset, Location *location);
+
+	// a scalar or string of <type>, made out of the first <size> of <bytes>
+	// (which should be all of it)
+	static QString format_value(const type_pointer &type, const void *bytes, quint64 size);
+
+	// a string is an array of char, which is shown whole
+	static bool is_leaf(const type_pointer &type);
+
+	static type_pointer pointer_to(const type_pointer &type);
+	static type_pointer array_of(const type_pointer &type, quint64 count);
+
+private:
+	QHash<QString, type_pointer> types_;
+};
+
+#endif
@@ -19,8 +19,39 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #ifndef UTIL_20061126_H_
 #define UTIL_20061126_H_
 
+#include <QString>
+#include <QtGlobal>
+
 namespace util {
 
+//------------------------------------------------------------------------------
+// Name: format_hex
+// Desc: writes the low <digits> nibbles of <value> to <buffer> as lower case
+//       hex, most significant first and without a terminator. Returns the end
+//       of what was written
+//------------------------------------------------------------------------------
+inline char *format_hex(quint64 value, int digits, char *buffer) {
+	static const char hex_digits[] = "0123456789abcdef";
+	for(int i = digits - 1; i >= 0; --i) {
+		buffer[i] = hex_digits[value & 0xf];
+		value >>= 4;
+	}
+	return buffer + digits;
+}
+
+//------------------------------------------------------------------------------
+// Name: assign_latin1
+// Desc: sets <s> to the <size> characters at <text>, reusing the buffer it
+//       already has if it isn't shared with anyone and is big enough
+//------------------------------------------------------------------------------
+inline void assign_latin1(QString *s, const char *text, int size) {
+	s->resize(size);
+	QChar *const out = s->data();
+	for(int i = 0; i < size; ++i) {
+		out[i] = QLatin1Char(text[i]);
+	}
+}
+
 //------------------------------------------------------------------------------
 // Name: percentage
 // Desc: calculates how much of a multi-region byte search we have completed
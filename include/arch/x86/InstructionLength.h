@@ -0,0 +1,37 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef INSTRUCTION_LENGTH_20261014_H_
+#define INSTRUCTION_LENGTH_20261014_H_
+
+#include "../../LengthDecoder.h"
+
+namespace edb {
+
+//------------------------------------------------------------------------------
+// Name: instruction_length
+// Desc: the length of the instruction at [p, p + n), 0 if edb::Instruction
+//       has to be asked, see LengthDecoder.h
+//------------------------------------------------------------------------------
+inline std::size_t instruction_length(const quint8 *p, std::size_t n, length::Flow *flow = 0, length::Layout *layout = 0) {
+	return length::decode<false>(p, n, flow, layout);
+}
+
+}
+
+#endif
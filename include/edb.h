@@ -23,6 +23,9 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "IBinary.h"
 #include "IRegion.h"
 #include "IBreakpoint.h"
+#include "Module.h"
+#include "StopSnapshot.h"
+#include "TypeLayout.h"
 #include "Types.h"
 
 #include <QHash>
@@ -32,6 +35,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <QVector>
 
 
+class Annotations;
 class ArchProcessor;
 class Configuration;
 class IAnalyzer;
@@ -40,7 +44,10 @@ class IDebugEventHandler;
 class IDebugger;
 class IPlugin;
 class ISymbolManager;
+class InstructionCache;
+class InstructionTextCache;
 class MemoryRegions;
+class PatchJournal;
 class State;
 
 class QAbstractScrollArea;
@@ -71,6 +78,18 @@ EDB_EXPORT MemoryRegions &memory_regions();
 // the current arch processor
 EDB_EXPORT ArchProcessor &arch_processor();
 
+// the changes the user has made to the process's memory
+EDB_EXPORT PatchJournal &patch_journal();
+
+// the labels, comments and bookmarks the user has added
+EDB_EXPORT Annotations &annotations();
+
+// the instructions decoded since the process last stopped
+EDB_EXPORT InstructionCache &instruction_cache();
+
+// the text of the instructions formatted so far
+EDB_EXPORT InstructionTextCache &instruction_text_cache();
+
 // widgets
 EDB_EXPORT QAbstractScrollArea *disassembly_widget();
 
@@ -82,8 +101,15 @@ EDB_EXPORT address_t enable_breakpoint(address_t address);
 EDB_EXPORT void create_breakpoint(address_t address);
 EDB_EXPORT void remove_breakpoint(address_t address);
 EDB_EXPORT void set_breakpoint_condition(address_t address, const QString &condition);
+EDB_EXPORT QString get_breakpoint_log_format(address_t address);
+EDB_EXPORT void set_breakpoint_log_format(address_t address, const QString &format);
 EDB_EXPORT void toggle_breakpoint(address_t address);
 
+// breakpoints given as "module!symbol+offset", set whenever the module is loaded
+EDB_EXPORT bool create_pending_breakpoint(const QString &location);
+EDB_EXPORT void remove_pending_breakpoint(const QString &location);
+EDB_EXPORT QStringList pending_breakpoints();
+
 EDB_EXPORT address_t current_data_view_address();
 
 // change what the various views show
@@ -112,7 +138,20 @@ EDB_EXPORT bool get_binary_string_from_user(QByteArray &value, const QString &ti
 EDB_EXPORT bool get_ascii_string_at_address(address_t address, QString &s, int min_length, int max_length, int &found_length);
 EDB_EXPORT bool get_utf16_string_at_address(address_t address, QString &s, int min_length, int max_length, int &found_length);
 
+// same as above, but examine bytes which have already been read from the process
+EDB_EXPORT bool get_ascii_string_from_buffer(const void *buffer, size_t size, QString &s, int min_length, int max_length, int &found_length);
+EDB_EXPORT bool get_utf16_string_from_buffer(const void *buffer, size_t size, QString &s, int min_length, int max_length, int &found_length);
+
 EDB_EXPORT IRegion::pointer current_cpu_view_region();
+
+// what the views are currently showing, null while the process is running or
+// if there isn't one. Views and plugins which refresh when the GUI does should
+// use this rather than asking the core again
+EDB_EXPORT StopSnapshot::pointer stop_snapshot();
+
+// true if touching <size> bytes at <address> (writing them if <write>) would
+// fault on a page which a memory breakpoint has protected
+EDB_EXPORT bool memory_breakpoint_page(address_t address, address_t size, bool write);
 EDB_EXPORT IRegion::pointer primary_code_region();
 EDB_EXPORT IRegion::pointer primary_data_region();
 
@@ -124,6 +163,10 @@ EDB_EXPORT Configuration &config();
 EDB_EXPORT quint32 edb_version();
 EDB_EXPORT quint32 int_version(const QString &s);
 
+// the structures defined in the structures file of the configuration, read
+// again whenever the file changes
+EDB_EXPORT const TypeLayout &structures();
+
 // symbol resolution
 EDB_EXPORT QString find_function_symbol(address_t address);
 EDB_EXPORT QString find_function_symbol(address_t address, const QString &default_value);
@@ -133,6 +176,17 @@ EDB_EXPORT QString find_function_symbol(address_t address, const QString &defaul
 EDB_EXPORT address_t get_value(address_t address, bool *ok, ExpressionError *err);
 EDB_EXPORT address_t get_variable(const QString &s, bool *ok, ExpressionError *err);
 
+// evaluates the condition of <bp> against <state>, compiling it first if it
+// has changed since the last time. returns false if it can't be evaluated
+EDB_EXPORT bool breakpoint_condition_true(const IBreakpoint::pointer &bp, const State &state, bool *result, ExpressionError *err);
+
+// adds the message of the logpoint <bp>, filled in from <state>, to the
+// breakpoint log. take_breakpoint_log returns (and forgets) the lines logged
+// so far, oldest first, and sets <lost> to the number which didn't fit. Both
+// may be called from any thread
+EDB_EXPORT void log_breakpoint_hit(const IBreakpoint::pointer &bp, const State &state);
+EDB_EXPORT QStringList take_breakpoint_log(quint64 *lost);
+
 // hook the debug event system
 EDB_EXPORT IDebugEventHandler *set_debug_event_handler(IDebugEventHandler *p);
 EDB_EXPORT IDebugEventHandler *debug_event_handler();
@@ -156,15 +210,23 @@ EDB_EXPORT int get_instruction_bytes(address_t address, quint8 (&buffer)[N]) {
 EDB_EXPORT QString disassemble_address(address_t address);
 
 EDB_EXPORT IBinary *get_binary_info(const IRegion::pointer &region);
+
+// the parts of <region> which hold code according to the section headers of
+// the binary it was mapped from, as regions of their own for the searches to
+// scan. Just <region> if the sections aren't known or the searches were told
+// to scan whole mappings
+EDB_EXPORT QList<IRegion::pointer> code_regions(const IRegion::pointer &region);
 EDB_EXPORT const Prototype *get_function_info(const QString &function);
 
 EDB_EXPORT address_t locate_main_function();
 
 EDB_EXPORT const QHash<QString, QObject *> &plugin_list();
 EDB_EXPORT IPlugin *find_plugin_by_name(const QString &name);
+EDB_EXPORT void load_lazy_plugins();
 
 EDB_EXPORT void reload_symbols();
 EDB_EXPORT void repaint_cpu_view();
+EDB_EXPORT void update_ui();
 
 // these are here and not members of state because
 // they may require using the debugger core plugin and
@@ -180,6 +242,17 @@ EDB_EXPORT void modify_bytes(address_t address, unsigned int size, QByteArray &b
 EDB_EXPORT QByteArray get_file_md5(const QString &s);
 EDB_EXPORT QByteArray get_md5(const void *p, size_t n);
 EDB_EXPORT QByteArray get_md5(const QVector<quint8> &bytes);
+EDB_EXPORT QByteArray get_fingerprint(const void *p, size_t n);
+
+// a name to write <filename> under before it is renamed into place, which no
+// other edb process sharing the caches will be writing to at the same time
+EDB_EXPORT QString temp_filename(const QString &filename);
+
+// the directory edb keeps its <name> files in, next to its own settings
+EDB_EXPORT QString cache_directory(const QString &name);
+
+// <s> quoted and escaped as a JSON string
+EDB_EXPORT QString json_string(const QString &s);
 
 EDB_EXPORT QString symlink_target(const QString &s);
 EDB_EXPORT QStringList parse_command_line(const QString &cmdline);
@@ -187,6 +260,7 @@ EDB_EXPORT address_t string_to_address(const QString &s, bool *ok);
 EDB_EXPORT QString format_bytes(const QByteArray &x);
 EDB_EXPORT QString format_bytes(quint8 byte);
 EDB_EXPORT QString format_pointer(address_t p);
+EDB_EXPORT void format_pointer(address_t p, QString *text);
 
 EDB_EXPORT address_t cpu_selected_address();
 
@@ -196,6 +270,8 @@ EDB_EXPORT int pointer_size();
 
 EDB_EXPORT QVector<quint8> read_pages(address_t address, size_t page_count);
 
+EDB_EXPORT QList<Module> loaded_modules();
+
 }
 }
 
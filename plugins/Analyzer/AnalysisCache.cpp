@@ -0,0 +1,346 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "AnalysisCache.h"
+#include "Instruction.h"
+#include "edb.h"
+
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QtDebug>
+
+#include <algorithm>
+#include <cstddef>
+
+namespace Analyzer {
+
+namespace {
+
+const quint32 CACHE_MAGIC   = 0x41424445; // "EDBA"
+const quint32 CACHE_VERSION = 3;
+
+//------------------------------------------------------------------------------
+// Name: write_offsets
+// Desc:
+//------------------------------------------------------------------------------
+void write_offsets(QDataStream &stream, const QSet<edb::address_t> &addresses, edb::address_t base) {
+	stream << static_cast<quint32>(addresses.size());
+	Q_FOREACH(const edb::address_t address, addresses) {
+		stream << static_cast<quint64>(address - base);
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: read_offsets
+// Desc:
+//------------------------------------------------------------------------------
+bool read_offsets(QDataStream &stream, QSet<edb::address_t> *addresses, edb::address_t base, quint64 size) {
+
+	quint32 count;
+	stream >> count;
+
+	for(quint32 i = 0; i < count && stream.status() == QDataStream::Ok; ++i) {
+		quint64 offset;
+		stream >> offset;
+		if(offset >= size) {
+			return false;
+		}
+		addresses->insert(base + offset);
+	}
+
+	return stream.status() == QDataStream::Ok;
+}
+
+//------------------------------------------------------------------------------
+// Name: decode_block
+// Desc: decodes <count> instructions from the snapshot starting at <offset>,
+//       only to size the block, the instructions themselves aren't kept
+//------------------------------------------------------------------------------
+bool decode_block(const QVector<quint8> &memory, edb::address_t base, quint64 offset, quint32 count, BasicBlock *block) {
+
+	const quint8 *const last = memory.constData() + memory.size();
+
+	for(quint32 i = 0; i < count; ++i) {
+		if(offset >= static_cast<quint64>(memory.size())) {
+			return false;
+		}
+
+		const quint8 *const p = memory.constData() + offset;
+		const edb::Instruction inst(p, p + std::min<std::ptrdiff_t>(edb::Instruction::MAX_SIZE, last - p), base + offset, std::nothrow);
+		if(!inst) {
+			return false;
+		}
+
+		block->push_back(inst);
+		offset += inst.size();
+	}
+
+	return !block->empty();
+}
+
+}
+
+//------------------------------------------------------------------------------
+// Name: AnalysisCache
+// Desc: only regions backed by a file get a cache, anything else has nothing
+//       stable to be known by
+//------------------------------------------------------------------------------
+AnalysisCache::AnalysisCache(const IRegion::pointer &region, const QByteArray &md5, bool fuzzy, const QVector<QPair<edb::address_t, edb::address_t> > &code, const QSet<edb::address_t> &marked_functions)
+	: region_(region), md5_(md5), fuzzy_(fuzzy) {
+
+	for(int i = 0; i < code.size(); ++i) {
+		code_.push_back(qMakePair<quint64, quint64>(code[i].first - region_->start(), code[i].second - region_->start()));
+	}
+
+	Q_FOREACH(const edb::address_t address, marked_functions) {
+		if(region_->contains(address)) {
+			marked_.push_back(address - region_->start());
+		}
+	}
+	std::sort(marked_.begin(), marked_.end());
+
+	const QString path = region_->name();
+	if(!md5_.isEmpty() && path.startsWith(QLatin1Char('/'))) {
+		filename_ = QString(QLatin1String("%1/%2-%3.cache")).arg(edb::v1::cache_directory(QLatin1String("analysis")), QFileInfo(path).fileName(), QString::fromLatin1(md5_.toHex()));
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: write_header
+// Desc:
+//------------------------------------------------------------------------------
+void AnalysisCache::write_header(QDataStream &stream) const {
+	stream << CACHE_MAGIC << CACHE_VERSION;
+	stream << region_->name() << md5_ << static_cast<quint64>(region_->size()) << fuzzy_ << code_ << marked_;
+
+	// not part of the key, it is only there to say where the results came from
+	stream << static_cast<quint64>(region_->start());
+}
+
+//------------------------------------------------------------------------------
+// Name: read_header
+// Desc: returns true if the cache was made from the same module, content and
+//       options as we have now
+//------------------------------------------------------------------------------
+bool AnalysisCache::read_header(QDataStream &stream) const {
+
+	quint32                         magic;
+	quint32                         version;
+	QString                         path;
+	QByteArray                      md5;
+	quint64                         size;
+	bool                            fuzzy;
+	QList<QPair<quint64, quint64> > code;
+	QList<quint64>                  marked;
+	quint64                         load_bias;
+
+	stream >> magic >> version;
+	if(stream.status() != QDataStream::Ok || magic != CACHE_MAGIC || version != CACHE_VERSION) {
+		return false;
+	}
+
+	stream >> path >> md5 >> size >> fuzzy >> code >> marked >> load_bias;
+
+	return stream.status() == QDataStream::Ok &&
+		path == region_->name() &&
+		md5 == md5_ &&
+		size == static_cast<quint64>(region_->size()) &&
+		fuzzy == fuzzy_ &&
+		code == code_ &&
+		marked == marked_;
+}
+
+//------------------------------------------------------------------------------
+// Name: load
+// Desc: fills in the results if there is a matching cache, the blocks are
+//       decoded again out of <memory>, the snapshot the MD5 was taken of
+//------------------------------------------------------------------------------
+bool AnalysisCache::load(const QVector<quint8> &memory, QSet<edb::address_t> *known_functions, QSet<edb::address_t> *fuzzy_functions, QHash<edb::address_t, BasicBlock> *basic_blocks, QHash<edb::address_t, Function> *functions) const {
+
+	Q_ASSERT(known_functions);
+	Q_ASSERT(fuzzy_functions);
+	Q_ASSERT(basic_blocks);
+	Q_ASSERT(functions);
+
+	if(filename_.isEmpty()) {
+		return false;
+	}
+
+	QFile file(filename_);
+	if(!file.open(QIODevice::ReadOnly)) {
+		return false;
+	}
+
+	QDataStream stream(&file);
+	stream.setByteOrder(QDataStream::LittleEndian);
+	stream.setVersion(QDataStream::Qt_4_6);
+
+	if(!read_header(stream)) {
+		return false;
+	}
+
+	const edb::address_t base = region_->start();
+	const quint64        size = memory.size();
+
+	QSet<edb::address_t>              known;
+	QSet<edb::address_t>              fuzzy;
+	QHash<edb::address_t, BasicBlock> blocks;
+	QHash<edb::address_t, Function>   funcs;
+
+	if(!read_offsets(stream, &known, base, size) || !read_offsets(stream, &fuzzy, base, size)) {
+		return false;
+	}
+
+	quint32 block_count;
+	stream >> block_count;
+	for(quint32 i = 0; i < block_count; ++i) {
+		quint64        offset;
+		quint32        instruction_count;
+		QList<quint64> successors;
+		stream >> offset >> instruction_count >> successors;
+
+		BasicBlock block(memory, base);
+		if(stream.status() != QDataStream::Ok || !decode_block(memory, base, offset, instruction_count, &block)) {
+			return false;
+		}
+
+		Q_FOREACH(const quint64 successor, successors) {
+			block.add_successor(base + successor);
+		}
+
+		blocks.insert(base + offset, block);
+	}
+
+	quint32 function_count;
+	stream >> function_count;
+	for(quint32 i = 0; i < function_count; ++i) {
+		quint64 entry;
+		qint32  references;
+		quint8  type;
+		quint32 function_blocks;
+		stream >> entry >> references >> type >> function_blocks;
+
+		if(stream.status() != QDataStream::Ok) {
+			return false;
+		}
+
+		Function func(base + entry);
+		for(qint32 j = 1; j < references; ++j) {
+			func.add_reference();
+		}
+		func.set_type(type == Function::FUNCTION_THUNK ? Function::FUNCTION_THUNK : Function::FUNCTION_STANDARD);
+
+		for(quint32 j = 0; j < function_blocks; ++j) {
+			quint64 offset;
+			stream >> offset;
+
+			const QHash<edb::address_t, BasicBlock>::const_iterator it = blocks.find(base + offset);
+			if(stream.status() != QDataStream::Ok || it == blocks.end()) {
+				return false;
+			}
+
+			func.insert(it.value());
+		}
+
+		funcs.insert(base + entry, func);
+	}
+
+	if(stream.status() != QDataStream::Ok) {
+		return false;
+	}
+
+	qSwap(*known_functions, known);
+	qSwap(*fuzzy_functions, fuzzy);
+	qSwap(*basic_blocks, blocks);
+	qSwap(*functions, funcs);
+	return true;
+}
+
+//------------------------------------------------------------------------------
+// Name: save
+// Desc: writes to a temporary file first, so a reader never sees half of one
+//------------------------------------------------------------------------------
+bool AnalysisCache::save(const QSet<edb::address_t> &known_functions, const QSet<edb::address_t> &fuzzy_functions, const QHash<edb::address_t, BasicBlock> &basic_blocks, const QHash<edb::address_t, Function> &functions) const {
+
+	if(filename_.isEmpty()) {
+		return false;
+	}
+
+	if(!QDir().mkpath(QFileInfo(filename_).absolutePath())) {
+		return false;
+	}
+
+	const QString temp_filename = edb::v1::temp_filename(filename_);
+
+	QFile file(temp_filename);
+	if(!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+		return false;
+	}
+
+	const edb::address_t base = region_->start();
+
+	QDataStream stream(&file);
+	stream.setByteOrder(QDataStream::LittleEndian);
+	stream.setVersion(QDataStream::Qt_4_6);
+
+	write_header(stream);
+	write_offsets(stream, known_functions, base);
+	write_offsets(stream, fuzzy_functions, base);
+
+	stream << static_cast<quint32>(basic_blocks.size());
+	for(QHash<edb::address_t, BasicBlock>::const_iterator it = basic_blocks.begin(); it != basic_blocks.end(); ++it) {
+		const BasicBlock &block = it.value();
+
+		QList<quint64> successors;
+		for(BasicBlock::size_type i = 0; i < block.successor_count(); ++i) {
+			successors.push_back(block.successor(i) - base);
+		}
+
+		stream << static_cast<quint64>(it.key() - base) << static_cast<quint32>(block.size()) << successors;
+	}
+
+	stream << static_cast<quint32>(functions.size());
+	for(QHash<edb::address_t, Function>::const_iterator it = functions.begin(); it != functions.end(); ++it) {
+		const Function &func = it.value();
+
+		stream << static_cast<quint64>(it.key() - base) << static_cast<qint32>(func.reference_count()) << static_cast<quint8>(func.type());
+		stream << static_cast<quint32>(func.size());
+		for(Function::const_iterator block = func.begin(); block != func.end(); ++block) {
+			stream << static_cast<quint64>(block->first_address() - base);
+		}
+	}
+
+	file.close();
+
+	if(stream.status() != QDataStream::Ok || file.error() != QFile::NoError) {
+		QFile::remove(temp_filename);
+		return false;
+	}
+
+	QFile::remove(filename_);
+	if(!QFile::rename(temp_filename, filename_)) {
+		QFile::remove(temp_filename);
+		return false;
+	}
+
+	return true;
+}
+
+}
@@ -0,0 +1,66 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef ANALYSIS_CACHE_20261014_H_
+#define ANALYSIS_CACHE_20261014_H_
+
+#include "BasicBlock.h"
+#include "Function.h"
+#include "IRegion.h"
+#include "Types.h"
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QPair>
+#include <QSet>
+#include <QString>
+#include <QVector>
+
+class QDataStream;
+
+namespace Analyzer {
+
+// keeps the analysis of a module's region on disk, so that seeing the same
+// build again costs a read instead of an analysis. Everything is stored as
+// offsets from the start of the region and instructions are decoded again on
+// load, so the results hold wherever the module ends up being loaded
+class AnalysisCache {
+public:
+	AnalysisCache(const IRegion::pointer &region, const QByteArray &md5, bool fuzzy, const QVector<QPair<edb::address_t, edb::address_t> > &code, const QSet<edb::address_t> &marked_functions);
+
+public:
+	bool load(const QVector<quint8> &memory, QSet<edb::address_t> *known_functions, QSet<edb::address_t> *fuzzy_functions, QHash<edb::address_t, BasicBlock> *basic_blocks, QHash<edb::address_t, Function> *functions) const;
+	bool save(const QSet<edb::address_t> &known_functions, const QSet<edb::address_t> &fuzzy_functions, const QHash<edb::address_t, BasicBlock> &basic_blocks, const QHash<edb::address_t, Function> &functions) const;
+	QString filename() const { return filename_; }
+
+private:
+	bool read_header(QDataStream &stream) const;
+	void write_header(QDataStream &stream) const;
+
+private:
+	IRegion::pointer                region_;
+	QByteArray                      md5_;
+	bool                            fuzzy_;
+	QList<QPair<quint64, quint64> > code_; // offsets of the ranges fuzzy analysis looks at
+	QList<quint64>                  marked_;
+	QString                         filename_;
+};
+
+}
+
+#endif
@@ -17,34 +17,54 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
 #include "Analyzer.h"
+#include "AnalysisCache.h"
 #include "OptionsPage.h"
 #include "AnalyzerWidget.h"
+#include "CallGraph.h"
+#include "CallScanner.h"
+#include "FunctionDiscovery.h"
+#include "Signatures.h"
 #include "SpecifiedFunctions.h"
 #include "IBinary.h"
 #include "IDebugger.h"
+#include "IProcess.h"
 #include "ISymbolManager.h"
 #include "Instruction.h"
+#include "InstructionLength.h"
 #include "MemoryRegions.h"
 #include "State.h"
+#include "Trace.h"
 #include "Util.h"
 #include "edb.h"
 
 #include <QCoreApplication>
+#include <QEventLoop>
+#include <QDir>
+#include <QFile>
+#include <QFileDialog>
+#include <QFileInfo>
 #include <QHash>
 #include <QMainWindow>
 #include <QMenu>
 #include <QMessageBox>
 #include <QProgressDialog>
 #include <QSettings>
-#include <QStack>
+#include <QTemporaryFile>
+#include <QThread>
 #include <QTime>
 #include <QToolBar>
 #include <QtDebug>
 
 #include <boost/bind.hpp>
 #include <boost/function.hpp>
+#include <algorithm>
+#include <cstddef>
 #include <cstring>
 
+#ifdef ENABLE_GRAPH
+#include "GraphWidget.h"
+#endif
+
 #if QT_VERSION >= 0x050000
 #ifdef QT_CONCURRENT_LIB
 #include <QtConcurrent>
@@ -79,13 +99,118 @@ edb::address_t module_entry_point(const IRegion::pointer &region) {
 	return entry;
 }
 
+//------------------------------------------------------------------------------
+// Name: add_references
+// Desc: appends what <inst> refers to. Immediates are only taken for references
+//       when they land in mapped memory, most of them are plain numbers
+//------------------------------------------------------------------------------
+void add_references(const edb::Instruction &inst, const MemoryRegions &regions, QVector<IAnalyzer::Reference> *references) {
+
+	IAnalyzer::Reference ref;
+	ref.source = inst.rva();
+
+	for(std::size_t i = 0; i < inst.operand_count(); ++i) {
+		const edb::Operand &op = inst.operands()[i];
+
+		switch(op.general_type()) {
+		case edb::Operand::TYPE_REL:
+			ref.target = op.relative_target();
+			ref.type   = is_call(inst) ? IAnalyzer::Reference::REF_CALL : IAnalyzer::Reference::REF_JUMP;
+			references->push_back(ref);
+			break;
+		case edb::Operand::TYPE_IMMEDIATE:
+			ref.target = static_cast<edb::address_t>(op.immediate());
+			ref.type   = IAnalyzer::Reference::REF_IMMEDIATE;
+			if(regions.find_region(ref.target)) {
+				references->push_back(ref);
+			}
+			break;
+		case edb::Operand::TYPE_EXPRESSION:
+			ref.type = IAnalyzer::Reference::REF_MEMORY;
+			if(fixed_address(inst, op, &ref.target)) {
+				references->push_back(ref);
+			}
+			break;
+		default:
+			break;
+		}
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: same_reference
+// Desc:
+//------------------------------------------------------------------------------
+bool same_reference(const IAnalyzer::Reference &lhs, const IAnalyzer::Reference &rhs) {
+	return lhs.target == rhs.target && lhs.source == rhs.source && lhs.type == rhs.type;
+}
+
+//------------------------------------------------------------------------------
+// Name: branch_slot
+// Desc: returns true if <inst> calls or jumps through the pointer at a fixed
+//       address, such as an import table entry, whose address goes in <slot>
+//------------------------------------------------------------------------------
+bool branch_slot(const edb::Instruction &inst, edb::address_t *slot) {
+
+	if((is_call(inst) || is_unconditional_jump(inst)) && inst.operand_count() == 1) {
+		const edb::Operand &op = inst.operands()[0];
+		return op.general_type() == edb::Operand::TYPE_EXPRESSION && fixed_address(inst, op, slot);
+	}
+
+	return false;
+}
+
+//------------------------------------------------------------------------------
+// Name: in_ranges
+// Desc: returns true if <address> is inside one of <ranges>
+//------------------------------------------------------------------------------
+bool in_ranges(edb::address_t address, const QVector<QPair<edb::address_t, edb::address_t> > &ranges) {
+
+	for(int i = 0; i < ranges.size(); ++i) {
+		if(address >= ranges[i].first && address < ranges[i].second) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+//------------------------------------------------------------------------------
+// Name: overlaps
+// Desc: returns true if any byte of <block> is inside one of <ranges>
+//------------------------------------------------------------------------------
+bool overlaps(const BasicBlock &block, const QVector<QPair<edb::address_t, edb::address_t> > &ranges) {
+
+	const edb::address_t first = block.first_address();
+	const edb::address_t last  = first + block.byte_size();
+
+	for(int i = 0; i < ranges.size(); ++i) {
+		if(first < ranges[i].second && ranges[i].first < last) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
 }
 
 //------------------------------------------------------------------------------
 // Name: Analyzer
 // Desc:
 //------------------------------------------------------------------------------
-Analyzer::Analyzer() : menu_(0), analyzer_widget_(0) {
+Analyzer::Analyzer() : menu_(0), analysis_sequence_(0), analyzer_widget_(0), analysis_step_(0), analysis_steps_(1), analysis_cancelled_(false), trim_pending_(false), trim_bytes_(0), use_cache_(true), signatures_loaded_(false) {
+	analysis_pool_.setMaxThreadCount(qMax(1, QThread::idealThreadCount()));
+}
+
+//------------------------------------------------------------------------------
+// Name: ~Analyzer
+// Desc:
+//------------------------------------------------------------------------------
+Analyzer::~Analyzer() {
+	edb::memory::remove_consumer(this);
+	analysis_pool_.waitForDone();
+	qDeleteAll(signatures_);
 }
 
 //------------------------------------------------------------------------------
@@ -113,6 +238,15 @@ QMenu *Analyzer::menu(QWidget *parent) {
 		}
 		
 		menu_->addAction(tr("&Analyze Viewed Region"), this, SLOT(do_view_analysis()), QKeySequence(tr("Ctrl+Shift+A")));
+		menu_->addAction(tr("Analyze A&ll Modules"), this, SLOT(do_module_analysis()));
+		menu_->addSeparator();
+#ifdef ENABLE_GRAPH
+		menu_->addAction(tr("Show &Call Graph"), this, SLOT(show_call_graph()));
+		menu_->addAction(tr("Show &Function Graph"), this, SLOT(show_function_graph()));
+#endif
+		menu_->addAction(tr("&Export Call Graph..."), this, SLOT(export_call_graph()));
+		menu_->addSeparator();
+		menu_->addAction(tr("&Import Signatures..."), this, SLOT(compile_signatures()));
 
 		// if we are dealing with a main window (and we are...)
 		// add the dock object
@@ -143,6 +277,7 @@ QMenu *Analyzer::menu(QWidget *parent) {
 //------------------------------------------------------------------------------
 void Analyzer::private_init() {
 	edb::v1::set_analyzer(this);
+	edb::memory::add_consumer("analyzer", this);
 }
 
 //------------------------------------------------------------------------------
@@ -176,6 +311,122 @@ void Analyzer::do_view_analysis() {
 	do_analysis(edb::v1::current_cpu_view_region());
 }
 
+//------------------------------------------------------------------------------
+// Name: compile_signatures
+// Desc: turns a FLIRT .pat file into a signature library in the signature
+//       directory, to be used from the next analysis on
+//------------------------------------------------------------------------------
+void Analyzer::compile_signatures() {
+
+	const QString filename = QFileDialog::getOpenFileName(edb::v1::debugger_ui, tr("Import Signatures"), QString(), tr("Pattern Files (*.pat);;All Files (*)"));
+	if(filename.isEmpty()) {
+		return;
+	}
+
+	const QString library = QString("%1/%2.sig").arg(edb::v1::cache_directory(QLatin1String("signatures")), QFileInfo(filename).completeBaseName());
+
+	// a library of the same name may be mapped, it has to go before the file
+	// is rewritten under it
+	qDeleteAll(signatures_);
+	signatures_.clear();
+	signatures_loaded_ = false;
+
+	QString error;
+	if(!SignatureLibrary::compile(filename, library, &error)) {
+		QMessageBox::information(edb::v1::debugger_ui, tr("Import Signatures"), tr("Unable to import the signatures: %1").arg(error));
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: show_call_graph
+// Desc: draws the call graph of the viewed region
+//------------------------------------------------------------------------------
+void Analyzer::show_call_graph() {
+#ifdef ENABLE_GRAPH
+	const IRegion::pointer region = edb::v1::current_cpu_view_region();
+	const CallGraph graph = region ? call_graph(region) : CallGraph();
+
+	if(graph.nodes.isEmpty()) {
+		QMessageBox::information(edb::v1::debugger_ui, tr("Call Graph"), tr("No calls are known for this region. Have you run an analysis of it?"));
+		return;
+	}
+
+	// laying out much more than this takes graphviz a very long time
+	if(graph.nodes.size() > 3000) {
+		QMessageBox::information(edb::v1::debugger_ui, tr("Call Graph"), tr("The call graph has too many functions to draw (%1), try exporting it instead.").arg(graph.nodes.size()));
+		return;
+	}
+
+	QTemporaryFile file;
+	if(file.open()) {
+		file.write(call_graph_dot(graph));
+		file.flush();
+
+		GraphWidget *const widget = new GraphWidget(file.fileName(), "dot");
+		widget->setAttribute(Qt::WA_DeleteOnClose);
+		widget->setWindowTitle(tr("Call Graph: %1").arg(region->name()));
+		widget->show();
+	}
+#endif
+}
+
+//------------------------------------------------------------------------------
+// Name: show_function_graph
+// Desc: draws the blocks of the function the selected instruction is in, the
+//       layout happens in the background so big functions don't hang the GUI
+//------------------------------------------------------------------------------
+void Analyzer::show_function_graph() {
+#ifdef ENABLE_GRAPH
+	Function function;
+	if(!find_containing_function(edb::v1::cpu_selected_address(), &function)) {
+		QMessageBox::information(
+			0,
+			tr("Function Graph"),
+			tr("The selected instruction is not inside of a known function. Have you run an analysis of this region?"));
+		return;
+	}
+
+	GraphWidget *const widget = new GraphWidget;
+	widget->setAttribute(Qt::WA_DeleteOnClose);
+	widget->setWindowTitle(tr("Function Graph: %1").arg(edb::v1::find_function_symbol(function.entry_address(), edb::v1::format_pointer(function.entry_address()))));
+	widget->layout_graph(function_graph_dot(function), "dot");
+	widget->show();
+#endif
+}
+
+//------------------------------------------------------------------------------
+// Name: export_call_graph
+// Desc: saves the call graph of the viewed region as DOT, or as JSON for a
+//       filename ending in .json
+//------------------------------------------------------------------------------
+void Analyzer::export_call_graph() {
+
+	const IRegion::pointer region = edb::v1::current_cpu_view_region();
+	const CallGraph graph = region ? call_graph(region) : CallGraph();
+
+	if(graph.nodes.isEmpty()) {
+		QMessageBox::information(edb::v1::debugger_ui, tr("Call Graph"), tr("No calls are known for this region. Have you run an analysis of it?"));
+		return;
+	}
+
+	const QString filename = QFileDialog::getSaveFileName(edb::v1::debugger_ui, tr("Export Call Graph"), QString(), tr("DOT Files (*.dot);;JSON Files (*.json);;All Files (*)"));
+	if(filename.isEmpty()) {
+		return;
+	}
+
+	QFile file(filename);
+	if(!file.open(QIODevice::WriteOnly)) {
+		QMessageBox::information(edb::v1::debugger_ui, tr("Call Graph"), tr("Unable to open call graph file: %1").arg(filename));
+		return;
+	}
+
+	if(filename.endsWith(".json", Qt::CaseInsensitive)) {
+		file.write(call_graph_json(graph));
+	} else {
+		file.write(call_graph_dot(graph));
+	}
+}
+
 //------------------------------------------------------------------------------
 // Name: mark_function_start
 // Desc:
@@ -249,6 +500,12 @@ QList<QAction *> Analyzer::cpu_context_menu() {
 	connect(action_mark_function_start, SIGNAL(triggered()), this, SLOT(mark_function_start()));
 	ret << action_find << action_goto_function_start << action_goto_function_end << action_mark_function_start;
 
+#ifdef ENABLE_GRAPH
+	QAction *const action_function_graph = new QAction(tr("Show Function Graph"), this);
+	connect(action_function_graph, SIGNAL(triggered()), this, SLOT(show_function_graph()));
+	ret << action_function_graph;
+#endif
+
 	return ret;
 }
 
@@ -258,15 +515,44 @@ QList<QAction *> Analyzer::cpu_context_menu() {
 //------------------------------------------------------------------------------
 void Analyzer::do_analysis(const IRegion::pointer &region) {
 	if(region->size() != 0) {
-		QProgressDialog progress(tr("Performing Analysis"), 0, 0, 100, edb::v1::debugger_ui);
+		do_analysis(QList<IRegion::pointer>() << region);
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: do_analysis
+// Desc:
+//------------------------------------------------------------------------------
+void Analyzer::do_analysis(const QList<IRegion::pointer> &regions) {
+	if(!regions.isEmpty()) {
+		QProgressDialog progress(tr("Performing Analysis"), tr("Cancel"), 0, 100, edb::v1::debugger_ui);
 		connect(this, SIGNAL(update_progress(int)), &progress, SLOT(setValue(int)));
+		connect(&progress, SIGNAL(canceled()), this, SLOT(cancel_analysis()));
 		progress.show();
 		progress.setValue(0);
-		analyze(region);
+		analyze_regions(regions);
 		edb::v1::repaint_cpu_view();
 	}
 }
 
+//------------------------------------------------------------------------------
+// Name: do_module_analysis
+// Desc: analyzes every executable region, the main binary's and the libraries'
+//------------------------------------------------------------------------------
+void Analyzer::do_module_analysis() {
+
+	edb::v1::memory_regions().sync();
+
+	QList<IRegion::pointer> regions;
+	Q_FOREACH(const IRegion::pointer &region, edb::v1::memory_regions().regions()) {
+		if(region->executable() && region->size() != 0) {
+			regions.push_back(region);
+		}
+	}
+
+	do_analysis(regions);
+}
+
 //------------------------------------------------------------------------------
 // Name: bonus_main
 // Desc:
@@ -307,365 +593,1051 @@ void Analyzer::bonus_symbols(RegionData *data) {
 }
 
 //------------------------------------------------------------------------------
-// Name: bonus_marked_functions
-// Desc:
+// Name: bonus_external_calls
+// Desc: whatever the other analyzed regions call or jump to in this one is a
+//       function, even if nothing in here calls it
 //------------------------------------------------------------------------------
-void Analyzer::bonus_marked_functions(RegionData *data) {
+void Analyzer::bonus_external_calls(RegionData *data) const {
 
 	Q_ASSERT(data);
 
-	Q_FOREACH(const edb::address_t addr, specified_functions_) {
-		if(data->region->contains(addr)) {
-			qDebug("[Analyzer] adding user marked function: <%p>", reinterpret_cast<void *>(addr));
-			data->known_functions.insert(addr);
+	if(!data->region->executable()) {
+		return;
+	}
+
+	for(QHash<edb::address_t, RegionData>::const_iterator it = analysis_info_.begin(); it != analysis_info_.end(); ++it) {
+		if(it.key() != data->region->start()) {
+			Q_FOREACH(const edb::address_t target, it->external_calls) {
+				if(data->region->contains(target)) {
+					data->known_functions.insert(target);
+				}
+			}
 		}
 	}
 }
 
 //------------------------------------------------------------------------------
-// Name: is_thunk
-// Desc: basically returns true if the first instruction of the function is a
-//       jmp
+// Name: entry_less
+// Desc:
 //------------------------------------------------------------------------------
-bool Analyzer::is_thunk(edb::address_t address) const {
-
-	quint8 buf[edb::Instruction::MAX_SIZE];
-	if(const int buf_size = edb::v1::get_instruction_bytes(address, buf)) {
-		const edb::Instruction inst(buf, buf + buf_size, address, std::nothrow);
-		return is_unconditional_jump(inst);
-	}
-
-	return false;
+bool Analyzer::entry_less(edb::address_t address, const FunctionRange &range) {
+	return address < range.entry;
 }
 
 //------------------------------------------------------------------------------
-// Name: set_function_types_helper
+// Name: range_less
 // Desc:
 //------------------------------------------------------------------------------
-void Analyzer::set_function_types_helper(Function &function) const {
-
-	if(is_thunk(function.entry_address())) {
-		function.set_type(Function::FUNCTION_THUNK);
-	} else {
-		function.set_type(Function::FUNCTION_STANDARD);
-	}
+bool Analyzer::range_less(const FunctionRange &lhs, const FunctionRange &rhs) {
+	return lhs.entry < rhs.entry;
 }
 
 //------------------------------------------------------------------------------
-// Name: set_function_types
+// Name: build_function_index
 // Desc:
 //------------------------------------------------------------------------------
-void Analyzer::set_function_types(FunctionMap *results) {
+void Analyzer::build_function_index(RegionData *data) {
 
-	Q_ASSERT(results);
+	Q_ASSERT(data);
 
-	// give bonus if we have a symbol for the address
-#if QT_VERSION >= 0x040800 && defined(QT_CONCURRENT_LIB)
-	QtConcurrent::blockingMap(
-		*results,
-		boost::bind(&Analyzer::set_function_types_helper, this, _1));
-#else
-	std::for_each(
-		results->begin(),
-		results->end(),
-		boost::bind(&Analyzer::set_function_types_helper, this, _1));
-#endif
-}
+	QVector<FunctionRange> index;
+	index.reserve(data->functions.size());
+
+	for(QHash<edb::address_t, Function>::const_iterator it = data->functions.begin(); it != data->functions.end(); ++it) {
+		const Function &func = it.value();
+		if(!func.empty()) {
+			FunctionRange range;
+			range.entry = it.key();
+			range.end   = func.end_address();
+			range.reach = range.end;
+			index.push_back(range);
+		}
+	}
 
-//------------------------------------------------------------------------------
-// Name: ident_header
-// Desc:
-//------------------------------------------------------------------------------
-void Analyzer::ident_header(Analyzer::RegionData *data) {
-	Q_UNUSED(data);
+	std::sort(index.begin(), index.end(), range_less);
+
+	for(int i = 1; i < index.size(); ++i) {
+		index[i].reach = qMax(index[i].end, index[i - 1].reach);
+	}
+
+	qSwap(data->function_index, index);
 }
 
 //------------------------------------------------------------------------------
-// Name: analyze
+// Name: reference_less
 // Desc:
 //------------------------------------------------------------------------------
-void Analyzer::collect_functions(Analyzer::RegionData *data) {
-	Q_ASSERT(data);
-
-	// results
-	QHash<edb::address_t, BasicBlock> basic_blocks;
-	QHash<edb::address_t, Function>   functions;
-
-	// push all known functions onto a stack
-	QStack<edb::address_t> known_functions;
-	Q_FOREACH(const edb::address_t function, data->known_functions) {
-		known_functions.push(function);
+bool Analyzer::reference_less(const Reference &lhs, const Reference &rhs) {
+	if(lhs.target != rhs.target) {
+		return lhs.target < rhs.target;
 	}
 
-	// push all fuzzy function too...
-	Q_FOREACH(const edb::address_t function, data->fuzzy_functions) {
-		known_functions.push(function);
+	if(lhs.source != rhs.source) {
+		return lhs.source < rhs.source;
 	}
 
-	// process all functions that are known
-	while(!known_functions.empty()) {
-		const edb::address_t function_address = known_functions.pop();
-
-		if(!functions.contains(function_address)) {
-
-			QStack<edb::address_t> blocks;
-			blocks.push(function_address);
+	return lhs.type < rhs.type;
+}
 
-			Function func(function_address);
+//------------------------------------------------------------------------------
+// Name: build_references
+// Desc: collects what every decoded instruction refers to, along with the
+//       aligned pointer sized values in the region which point into mapped
+//       memory. Needs the snapshot the blocks were decoded from
+//------------------------------------------------------------------------------
+void Analyzer::build_references(RegionData *data) {
 
-			// process are basic blocks that are known
-			while(!blocks.empty()) {
+	Q_ASSERT(data);
 
-				const edb::address_t block_address = blocks.pop();
-				edb::address_t address             = block_address;
-				BasicBlock     block;
+	const MemoryRegions   &regions = edb::v1::memory_regions();
+	const QVector<quint8> &memory  = data->memory;
+	const edb::address_t   base    = data->region->start();
+	const edb::address_t   length  = memory.size();
 
-				if(!basic_blocks.contains(block_address)) {
-					while(data->region->contains(address)) {
+	QVector<Reference>   references;
+	QSet<edb::address_t> slots;
+	QBitArray            decoded(length);
+	QBitArray            call_ends(length);
 
-						quint8 buffer[edb::Instruction::MAX_SIZE];
-						const int buf_size = edb::v1::get_instruction_bytes(address, buffer);
-						if(buf_size == 0) {
-							break;
-						}
+	for(QHash<edb::address_t, BasicBlock>::const_iterator it = data->basic_blocks.begin(); it != data->basic_blocks.end(); ++it) {
+		const BasicBlock &block = it.value();
 
-						const edb::Instruction inst(buffer, buffer + buf_size, address, std::nothrow);
-						if(!inst) {
-							break;
-						}
+		edb::address_t       address = block.first_address();
+		const edb::address_t end     = address + block.byte_size();
 
-						block.push_back(instruction_pointer(new edb::Instruction(inst)));
-
-						if(is_call(inst)) {
-
-							// note the destination and move on
-							// we special case some simple things.
-							// also this is an opportunity to find call tables.
-							const edb::Operand &op = inst.operands()[0];
-							if(op.general_type() == edb::Operand::TYPE_REL) {
-								const edb::address_t ea = op.relative_target();
-
-								// skip over ones which are: "call <label>; label:"
-								if(ea != address + inst.size()) {
-									known_functions.push(ea);
-									
-									if(!will_return(ea)) {
-										break;
-									}
-								}
-							} else if(op.general_type() == edb::Operand::TYPE_EXPRESSION) {
-								// looks like: "call [...]", if it is of the form, call [C + REG]
-								// then it may be a jump table using REG as an offset
-							} else if(op.general_type() == edb::Operand::TYPE_REGISTER) {
-								// looks like: "call <reg>", this is this may be a callback
-								// if we can use analysis to determine that it's a constant
-								// we can figure it out...
-								// eventually, we should figure out the parameters of the function
-								// to see if we can know what the target is
-							}
-
-							
-						} else if(is_unconditional_jump(inst)) {
-
-							Q_ASSERT(inst.operand_count() == 1);
-							const edb::Operand &op = inst.operands()[0];
-
-							// TODO: we need some heuristic for detecting when this is
-							//       a call/ret -> jmp optimization
-							if(op.general_type() == edb::Operand::TYPE_REL) {
-								const edb::address_t ea = op.relative_target();
-
-								
-								if(functions.contains(ea)) {
-									functions[ea].add_reference();
-								} else if((ea - function_address) > 0x2000) {
-									known_functions.push(ea);
-								} else {
-									blocks.push(ea);
-								}
-							}
-							break;
-						} else if(is_conditional_jump(inst)) {
-
-							Q_ASSERT(inst.operand_count() == 1);
-							const edb::Operand &op = inst.operands()[0];
-
-							if(op.general_type() == edb::Operand::TYPE_REL) {
-								blocks.push(op.relative_target());
-								blocks.push(address + inst.size());
-							}
-							break;
-						} else if(is_ret(inst) || inst.type() == edb::Instruction::OP_HLT) {
-							break;
-						}
+		while(address < end && address >= base && address - base < length) {
+			const quint8 *const first = memory.constData() + (address - base);
+			const quint8 *const last  = memory.constData() + length;
 
-						address += inst.size();
-					}
+			const edb::Instruction inst(first, last, address, std::nothrow);
+			if(!inst) {
+				break;
+			}
 
-					if(!block.empty()) {
-						basic_blocks.insert(block_address, block);
+			add_references(inst, regions, &references);
 
-						if(block_address >= function_address) {
-							func.insert(block);
-						}
-					}
-				}
+			const edb::address_t offset = address - base;
+			decoded.fill(true, offset, offset + inst.size());
+			if(is_call(inst)) {
+				call_ends.setBit(offset + inst.size() - 1);
 			}
 
-			if(!func.empty()) {
-				functions.insert(function_address, func);
+			edb::address_t slot;
+			if(branch_slot(inst, &slot)) {
+				slots.insert(slot);
 			}
-		} else {
-			functions[function_address].add_reference();
+
+			address += inst.size();
+		}
+	}
+
+	for(edb::address_t offset = 0; offset + sizeof(edb::address_t) <= length; offset += sizeof(edb::address_t)) {
+		edb::address_t value;
+		std::memcpy(&value, memory.constData() + offset, sizeof(value));
+
+		if(value != 0 && regions.find_region(value)) {
+			Reference ref;
+			ref.target = value;
+			ref.source = base + offset;
+			ref.type   = Reference::REF_POINTER;
+			references.push_back(ref);
+		}
+	}
+
+	// blocks can overlap, so the same instruction may have been seen twice
+	std::sort(references.begin(), references.end(), reference_less);
+	references.erase(std::unique(references.begin(), references.end(), same_reference), references.end());
+
+	// where the code leaves the region, which the analyses of the other
+	// regions can start from. A PLT entry jumps through a GOT slot which
+	// usually isn't part of the snapshot, so it is read from the process
+	QSet<edb::address_t> external_calls;
+	Q_FOREACH(const Reference &ref, references) {
+		if((ref.type == Reference::REF_CALL || ref.type == Reference::REF_JUMP) && !data->region->contains(ref.target)) {
+			external_calls.insert(ref.target);
 		}
 	}
 
-	qDebug() << "----------Basic Blocks----------";
-	for(QHash<edb::address_t, BasicBlock>::iterator it = basic_blocks.begin(); it != basic_blocks.end(); ++it) {
-		qDebug("%p:", reinterpret_cast<void *>(it.key()));
+	IProcess *const process = edb::v1::debugger_core ? edb::v1::debugger_core->process() : 0;
+
+	Q_FOREACH(const edb::address_t slot, slots) {
+		edb::address_t target;
+		if(slot >= base && slot - base + sizeof(target) <= length) {
+			std::memcpy(&target, memory.constData() + (slot - base), sizeof(target));
+		} else if(!process || !process->read_bytes(slot, &target, sizeof(target))) {
+			continue;
+		}
 
-		for(BasicBlock::const_iterator j = it.value().begin(); j != it.value().end(); ++j) {
-			const instruction_pointer &inst = *j;
-			qDebug("\t%p: %s", reinterpret_cast<void *>(inst->rva()), to_string(*inst).c_str());
+		if(!data->region->contains(target) && regions.find_region(target)) {
+			external_calls.insert(target);
 		}
 	}
-	qDebug() << "----------Basic Blocks----------";
 
-	qSwap(data->basic_blocks, basic_blocks);
-	qSwap(data->functions, functions);
+	qSwap(data->references, references);
+	qSwap(data->external_calls, external_calls);
+	qSwap(data->decoded, decoded);
+	qSwap(data->call_ends, call_ends);
 }
 
 //------------------------------------------------------------------------------
-// Name: collect_fuzzy_functions
-// Desc:
+// Name: containing_entry
+// Desc: the entry of the function of <data> which <address> is inside of
 //------------------------------------------------------------------------------
-void Analyzer::collect_fuzzy_functions(RegionData *data) {
-	Q_ASSERT(data);
-
-	data->fuzzy_functions.clear();
-
-	if(data->fuzzy) {
+bool Analyzer::containing_entry(const RegionData &data, edb::address_t address, edb::address_t *entry) {
 
-		QHash<edb::address_t, int> fuzzy_functions;
+	Q_ASSERT(entry);
 
-		// fuzzy_functions, known_functions
-		for(edb::address_t addr = data->region->start(); addr != data->region->end(); ++addr) {
-
-			quint8 buf[edb::Instruction::MAX_SIZE];
-			if(const int buf_size = edb::v1::get_instruction_bytes(addr, buf)) {
-				const edb::Instruction inst(buf, buf + buf_size, addr, std::nothrow);
-				if(inst) {
-					if(is_call(inst)) {
-
-						// note the destination and move on
-						// we special case some simple things.
-						// also this is an opportunity to find call tables.
-						const edb::Operand &op = inst.operands()[0];
-						if(op.general_type() == edb::Operand::TYPE_REL) {
-							const edb::address_t ea = op.relative_target();
-
-							// skip over ones which are: "call <label>; label:"
-							if(ea != addr + inst.size()) {
-
-								if(!data->known_functions.contains(ea)) {
-									fuzzy_functions[ea]++;
-								}
-							}
-						}
-					}
-				}
-			}
-		}
+	const QVector<FunctionRange> &index = data.function_index;
 
-		// transfer results to data->fuzzy_functions
-		for(QHash<edb::address_t, int>::const_iterator it = fuzzy_functions.begin(); it != fuzzy_functions.end(); ++it) {
-			if(it.value() > MIN_REFCOUNT) {
-				data->fuzzy_functions.insert(it.key());
-			}
+	// the candidates are the functions starting at or before the address,
+	// nearest first, and none before the reach drops below the address
+	// can get to it
+	int i = std::upper_bound(index.begin(), index.end(), address, entry_less) - index.begin();
+	while(i-- > 0 && index[i].reach >= address) {
+		if(address <= index[i].end) {
+			*entry = index[i].entry;
+			return true;
 		}
 	}
+
+	return false;
 }
 
 //------------------------------------------------------------------------------
-// Name: analyze
-// Desc:
+// Name: build_call_graph
+// Desc: turns the calls into caller -> callee edges, a callee outside of the
+//       region's functions still gets a node of its own
 //------------------------------------------------------------------------------
-void Analyzer::analyze(const IRegion::pointer &region) {
-
-	QTime t;
-	t.start();
+void Analyzer::build_call_graph(RegionData *data) {
 
-	RegionData &region_data = analysis_info_[region->start()];
+	Q_ASSERT(data);
 
-	QSettings settings;
-	const bool fuzzy          = settings.value("Analyzer/fuzzy_logic_functions.enabled", true).toBool();
-	const QByteArray md5      = md5_region(region);
-	const QByteArray prev_md5 = region_data.md5;
-
-	if(md5 != prev_md5 || fuzzy != region_data.fuzzy) {
-
-		region_data.basic_blocks.clear();
-		region_data.functions.clear();
-		region_data.fuzzy_functions.clear();
-		region_data.known_functions.clear();
-
-		region_data.region = region;
-		region_data.md5    = md5;
-		region_data.fuzzy  = fuzzy;
-
-		const struct {
-			const char             *message;
-			boost::function<void()> function;
-		} analysis_steps[] = {
-			{ "identifying executable headers...",                       boost::bind(&Analyzer::ident_header,            this, &region_data) },
-			{ "adding entry points to the list...",                      boost::bind(&Analyzer::bonus_entry_point,       this, &region_data) },
-			{ "attempting to add 'main' to the list...",                 boost::bind(&Analyzer::bonus_main,              this, &region_data) },
-			{ "attempting to add functions with symbols to the list...", boost::bind(&Analyzer::bonus_symbols,           this, &region_data) },
-			{ "attempting to add marked functions to the list...",       boost::bind(&Analyzer::bonus_marked_functions,  this, &region_data) },
-			{ "attempting to collect functions with fuzzy analysis...",  boost::bind(&Analyzer::collect_fuzzy_functions, this, &region_data) },
-			{ "collecting basic blocks...",                              boost::bind(&Analyzer::collect_functions,       this, &region_data) },
-		};
-
-		const int total_steps = sizeof(analysis_steps) / sizeof(analysis_steps[0]);
-
-		emit update_progress(util::percentage(0, total_steps));
-		for(int i = 0; i < total_steps; ++i) {
-			qDebug("[Analyzer] %s", analysis_steps[i].message);
-			analysis_steps[i].function();
-			emit update_progress(util::percentage(i + 1, total_steps));
+	QVector<QPair<edb::address_t, edb::address_t> > calls;
+	Q_FOREACH(const Reference &ref, data->references) {
+		edb::address_t caller;
+		if(ref.type == Reference::REF_CALL && containing_entry(*data, ref.source, &caller)) {
+			calls.push_back(qMakePair(caller, ref.target));
 		}
+	}
 
-		qDebug("[Analyzer] determining function types...");
+	std::sort(calls.begin(), calls.end());
+	calls.erase(std::unique(calls.begin(), calls.end()), calls.end());
 
-		set_function_types(&region_data.functions);
+	CallGraph graph;
+	graph.nodes.reserve(data->functions.size());
 
-		qDebug("[Analyzer] complete");
-		emit update_progress(100);
+	for(QHash<edb::address_t, Function>::const_iterator it = data->functions.begin(); it != data->functions.end(); ++it) {
+		graph.nodes.push_back(it.key());
+	}
 
-		if(analyzer_widget_) {
-			analyzer_widget_->repaint();
-		}
+	for(int i = 0; i < calls.size(); ++i) {
+		graph.nodes.push_back(calls[i].second);
+	}
 
+	std::sort(graph.nodes.begin(), graph.nodes.end());
+	graph.nodes.erase(std::unique(graph.nodes.begin(), graph.nodes.end()), graph.nodes.end());
 
-	} else {
-		qDebug("[Analyzer] region unchanged, using previous analysis");
+	// the calls are sorted by caller, so each node's edges follow on from the
+	// previous node's
+	graph.offsets.fill(0, graph.nodes.size() + 1);
+	graph.edges.reserve(calls.size());
+
+	for(int i = 0; i < calls.size(); ++i) {
+		const int from = std::lower_bound(graph.nodes.begin(), graph.nodes.end(), calls[i].first)  - graph.nodes.begin();
+		const int to   = std::lower_bound(graph.nodes.begin(), graph.nodes.end(), calls[i].second) - graph.nodes.begin();
+		++graph.offsets[from + 1];
+		graph.edges.push_back(to);
 	}
 
-	qDebug("[Analyzer] elapsed: %d ms", t.elapsed());
+	for(int i = 1; i < graph.offsets.size(); ++i) {
+		graph.offsets[i] += graph.offsets[i - 1];
+	}
+
+	qSwap(data->call_graph, graph);
 }
 
 //------------------------------------------------------------------------------
-// Name: category
-// Desc:
+// Name: load_signatures
+// Desc: maps every signature library in the signature directory
 //------------------------------------------------------------------------------
-IAnalyzer::AddressCategory Analyzer::category(edb::address_t address) const {
+void Analyzer::load_signatures() {
 
-	Function func;
-	if(find_containing_function(address, &func)) {
-		if(address == func.entry_address()) {
-			return ADDRESS_FUNC_START;
-		} else if(address == func.end_address()) {
-			return ADDRESS_FUNC_END;
+	qDeleteAll(signatures_);
+	signatures_.clear();
+
+	const QDir dir(edb::v1::cache_directory(QLatin1String("signatures")));
+	Q_FOREACH(const QFileInfo &info, dir.entryInfoList(QStringList() << "*.sig", QDir::Files, QDir::Name)) {
+		SignatureLibrary *const library = new SignatureLibrary(info.absoluteFilePath());
+		if(library->valid()) {
+			qDebug("[Analyzer] loaded %d signatures from %s", library->size(), qPrintable(info.fileName()));
+			signatures_.push_back(library);
+		} else {
+			delete library;
+		}
+	}
+
+	signatures_loaded_ = true;
+}
+
+//------------------------------------------------------------------------------
+// Name: name_library_functions
+// Desc: gives the functions which have no symbol the name of the signature
+//       they match, so library code in a stripped static binary is known
+//------------------------------------------------------------------------------
+void Analyzer::name_library_functions(RegionData *data) {
+
+	Q_ASSERT(data);
+
+	if(!signatures_loaded_) {
+		load_signatures();
+	}
+
+	if(signatures_.isEmpty() || data->memory.isEmpty()) {
+		return;
+	}
+
+	ISymbolManager &symbols = edb::v1::symbol_manager();
+
+	QList<edb::address_t> unnamed;
+	for(QHash<edb::address_t, Function>::const_iterator it = data->functions.begin(); it != data->functions.end(); ++it) {
+		if(!symbols.find(it.key())) {
+			unnamed.push_back(it.key());
+		}
+	}
+
+	const QHash<edb::address_t, QString> names = match_signatures(signatures_, data->memory, data->region->start(), unnamed);
+
+	const QString file   = data->region->name();
+	const QString prefix = QFileInfo(file).fileName();
+
+	QList<Symbol::pointer> matched;
+	for(QHash<edb::address_t, QString>::const_iterator it = names.begin(); it != names.end(); ++it) {
+		const Function &function = data->functions[it.key()];
+
+		Symbol::pointer sym(new Symbol);
+		sym->file           = file;
+		sym->name_no_prefix = it.value();
+		sym->name           = QString("%1::%2").arg(prefix, it.value());
+		sym->address        = it.key();
+		sym->size           = function.end_address() - function.entry_address() + 1;
+		sym->type           = 'T';
+		matched.push_back(sym);
+	}
+
+	qDebug("[Analyzer] named %d of %d functions from signatures", matched.size(), unnamed.size());
+	symbols.add_symbols(matched);
+}
+
+//------------------------------------------------------------------------------
+// Name: bonus_marked_functions
+// Desc:
+//------------------------------------------------------------------------------
+void Analyzer::bonus_marked_functions(RegionData *data) {
+
+	Q_ASSERT(data);
+
+	Q_FOREACH(const edb::address_t addr, specified_functions_) {
+		if(data->region->contains(addr)) {
+			qDebug("[Analyzer] adding user marked function: <%p>", reinterpret_cast<void *>(addr));
+			data->known_functions.insert(addr);
+		}
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: is_thunk
+// Desc: a thunk is a function which does nothing but jump elsewhere, its first
+//       block is the one at its entry so the answer is already decoded
+//------------------------------------------------------------------------------
+bool Analyzer::is_thunk(const Function &function) const {
+
+	if(!function.empty()) {
+		const BasicBlock &block = function.front();
+		if(!block.empty() && block.first_address() == function.entry_address()) {
+			const instruction_pointer inst = block.front();
+			return inst && is_unconditional_jump(*inst);
+		}
+	}
+
+	return false;
+}
+
+//------------------------------------------------------------------------------
+// Name: set_function_types_helper
+// Desc:
+//------------------------------------------------------------------------------
+void Analyzer::set_function_types_helper(Function &function) const {
+
+	if(is_thunk(function)) {
+		function.set_type(Function::FUNCTION_THUNK);
+	} else {
+		function.set_type(Function::FUNCTION_STANDARD);
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: set_function_types
+// Desc:
+//------------------------------------------------------------------------------
+void Analyzer::set_function_types(FunctionMap *results) {
+
+	Q_ASSERT(results);
+
+	// give bonus if we have a symbol for the address
+#if QT_VERSION >= 0x040800 && defined(QT_CONCURRENT_LIB)
+	QtConcurrent::blockingMap(
+		*results,
+		boost::bind(&Analyzer::set_function_types_helper, this, _1));
+#else
+	std::for_each(
+		results->begin(),
+		results->end(),
+		boost::bind(&Analyzer::set_function_types_helper, this, _1));
+#endif
+}
+
+//------------------------------------------------------------------------------
+// Name: ident_header
+// Desc:
+//------------------------------------------------------------------------------
+void Analyzer::ident_header(Analyzer::RegionData *data) {
+	Q_UNUSED(data);
+}
+
+//------------------------------------------------------------------------------
+// Name: publish_partial
+// Desc: adds the functions finished so far to the results of the region being
+//       analyzed, so the views can show them before the analysis is done
+//------------------------------------------------------------------------------
+void Analyzer::publish_partial(RegionData *data, const QHash<edb::address_t, Function> &finished) {
+
+	Q_ASSERT(data);
+
+	if(finished.isEmpty() || analysis_discarded_.contains(data->region->start())) {
+		return;
+	}
+
+	for(QHash<edb::address_t, Function>::const_iterator it = finished.begin(); it != finished.end(); ++it) {
+		data->functions.insert(it.key(), it.value());
+
+		for(Function::const_iterator block = it->begin(); block != it->end(); ++block) {
+			if(!data->basic_blocks.contains(block->first_address())) {
+				data->basic_blocks.insert(block->first_address(), *block);
+			}
+		}
+	}
+
+	build_function_index(data);
+
+	FunctionTable found;
+	found.reserve(finished.size());
+	for(QHash<edb::address_t, Function>::const_iterator it = finished.begin(); it != finished.end(); ++it) {
+		found.push_back(summarize(it.value()));
+	}
+
+	emit functions_found(data->region->start(), found);
+
+	// without an MD5 nobody takes these for a finished analysis
+	RegionData partial = *data;
+	partial.md5.clear();
+	partial.memory.clear();
+	analysis_info_[data->region->start()] = partial;
+	remember_analysis(data->region->start());
+
+	if(analyzer_widget_) {
+		analyzer_widget_->update();
+	}
+
+	edb::v1::repaint_cpu_view();
+}
+
+//------------------------------------------------------------------------------
+// Name: run_discovery
+// Desc: starts <discovery> walking from <entries> and keeps the progress moving
+//       until it is done. It never goes back even though the number of
+//       functions to walk grows as they are found. The GUI keeps running
+//       meanwhile, showing the functions found so far
+//------------------------------------------------------------------------------
+void Analyzer::run_discovery(RegionData *data, FunctionDiscovery *discovery, const QList<edb::address_t> &entries) {
+
+	Q_ASSERT(data);
+	Q_ASSERT(discovery);
+
+	discovery->start(entries);
+
+	QTime since_publish;
+	since_publish.start();
+
+	int progress = 0;
+	while(!discovery->wait(100)) {
+		if(analysis_stopped(*data)) {
+			discovery->cancel();
+		}
+
+		progress = qMax(progress, discovery->progress());
+		emit update_progress(util::percentage(analysis_step_, analysis_steps_, progress, 100));
+
+		if(since_publish.elapsed() >= 500) {
+			publish_partial(data, discovery->take_finished());
+			since_publish.restart();
+		}
+
+		QCoreApplication::processEvents();
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: run_discoveries
+// Desc: keeps the progress moving until every walk of <batch> is done, the
+//       walks of the regions share the pool so their threads never outnumber
+//       the cores. The GUI keeps running meanwhile, showing what was found
+//------------------------------------------------------------------------------
+void Analyzer::run_discoveries(const QList<PendingAnalysis *> &batch) {
+
+	if(batch.isEmpty()) {
+		return;
+	}
+
+	QTime since_publish;
+	since_publish.start();
+
+	Q_FOREVER {
+		bool done     = true;
+		int  progress = 0;
+
+		Q_FOREACH(PendingAnalysis *pending, batch) {
+			if(FunctionDiscovery *const discovery = pending->discovery.data()) {
+				if(analysis_stopped(pending->data)) {
+					discovery->cancel();
+				}
+
+				// only the first walk still going is waited on, the rest are
+				// just looked at
+				if(!discovery->wait(done ? 100 : 0)) {
+					done = false;
+				}
+
+				pending->progress = qMax(pending->progress, discovery->progress());
+				progress += pending->progress;
+			} else {
+				progress += 100;
+			}
+		}
+
+		if(done) {
+			break;
+		}
+
+		emit update_progress(util::percentage(analysis_step_, analysis_steps_, progress / batch.size(), 100));
+
+		if(since_publish.elapsed() >= 500) {
+			Q_FOREACH(PendingAnalysis *pending, batch) {
+				if(pending->discovery) {
+					publish_partial(&pending->data, pending->discovery->take_finished());
+				}
+			}
+			since_publish.restart();
+		}
+
+		QCoreApplication::processEvents();
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: start_discovery
+// Desc: sets the walk out from every known and fuzzy function going on the
+//       shared pool, over a snapshot of the region
+//------------------------------------------------------------------------------
+void Analyzer::start_discovery(PendingAnalysis *pending) {
+	Q_ASSERT(pending);
+
+	const RegionData &data = pending->data;
+
+	if(!data.memory.isEmpty()) {
+
+		QList<edb::address_t> entries;
+		Q_FOREACH(const edb::address_t function, data.known_functions) {
+			entries.push_back(function);
+		}
+
+		Q_FOREACH(const edb::address_t function, data.fuzzy_functions) {
+			entries.push_back(function);
+		}
+
+		pending->discovery = QSharedPointer<FunctionDiscovery>(new FunctionDiscovery(data.region, data.memory, no_return_functions(), &analysis_pool_));
+		pending->discovery->start(entries);
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: reanalyze_dirty
+// Desc: throws away just the blocks which were written to, and the functions
+//       which own them, then walks those functions again. Everything else is
+//       kept as it is, reference counts included
+//------------------------------------------------------------------------------
+void Analyzer::reanalyze_dirty(RegionData *data) {
+	Q_ASSERT(data);
+
+	QSet<edb::address_t>       roots;
+	QHash<edb::address_t, int> reference_counts;
+	QSet<edb::address_t>       stale_blocks;
+
+	for(QHash<edb::address_t, Function>::iterator it = data->functions.begin(); it != data->functions.end();) {
+		bool dirty = false;
+		for(Function::const_iterator block = it->begin(); block != it->end(); ++block) {
+			if(overlaps(*block, data->dirty)) {
+				dirty = true;
+				break;
+			}
+		}
+
+		if(dirty) {
+			for(Function::const_iterator block = it->begin(); block != it->end(); ++block) {
+				stale_blocks.insert(block->first_address());
+			}
+
+			roots.insert(it.key());
+			reference_counts.insert(it.key(), it->reference_count());
+			it = data->functions.erase(it);
+		} else {
+			++it;
+		}
+	}
+
+	for(QHash<edb::address_t, BasicBlock>::iterator it = data->basic_blocks.begin(); it != data->basic_blocks.end();) {
+		if(stale_blocks.contains(it.key()) || overlaps(*it, data->dirty)) {
+			it = data->basic_blocks.erase(it);
+		} else {
+			++it;
+		}
+	}
+
+	qDebug("[Analyzer] %d functions touched by writes", roots.size());
+
+	if(roots.isEmpty() || data->memory.isEmpty()) {
+		return;
+	}
+
+	QHash<edb::address_t, BasicBlock> basic_blocks;
+	FunctionMap                       functions;
+
+	QSet<edb::address_t> known;
+	for(QHash<edb::address_t, Function>::const_iterator it = data->functions.begin(); it != data->functions.end(); ++it) {
+		known.insert(it.key());
+	}
+
+	FunctionDiscovery discovery(data->region, data->memory, no_return_functions());
+	discovery.set_known_functions(known);
+	run_discovery(data, &discovery, roots.toList());
+	discovery.results(&basic_blocks, &functions);
+
+	// the callers of a function walked again haven't changed, so it keeps the
+	// count it had before
+	for(FunctionMap::iterator it = functions.begin(); it != functions.end(); ++it) {
+		for(int i = it->reference_count(); i < reference_counts.value(it.key(), 0); ++i) {
+			it->add_reference();
+		}
+	}
+
+	set_function_types(&functions);
+
+	for(FunctionMap::const_iterator it = functions.begin(); it != functions.end(); ++it) {
+		data->functions.insert(it.key(), it.value());
+	}
+
+	for(QHash<edb::address_t, BasicBlock>::const_iterator it = basic_blocks.begin(); it != basic_blocks.end(); ++it) {
+		if(!data->basic_blocks.contains(it.key())) {
+			data->basic_blocks.insert(it.key(), it.value());
+		}
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: collect_fuzzy_functions
+// Desc:
+//------------------------------------------------------------------------------
+void Analyzer::collect_fuzzy_functions(RegionData *data) {
+	Q_ASSERT(data);
+
+	data->fuzzy_functions.clear();
+
+	if(data->fuzzy) {
+
+		QHash<edb::address_t, int> fuzzy_functions;
+
+		const edb::address_t start   = data->region->start();
+		const QVector<quint8> memory = data->memory;
+		const quint8 *const first    = memory.constData();
+		const quint8 *const last     = first + memory.size();
+
+		// only a "call rel32" from code into code can count, so the decoder
+		// needs to look at just the offsets which could be one
+		QVector<std::size_t> candidates;
+		for(int i = 0; i < data->code.size(); ++i) {
+
+			const edb::address_t code_start = data->code[i].first;
+			if(code_start - start >= static_cast<edb::address_t>(memory.size())) {
+				continue;
+			}
+
+			const quint8 *const  code_first = first + (code_start - start);
+			const quint8 *const  code_last  = qMin(first + (data->code[i].second - start), last);
+
+			find_call_candidates(code_first, code_last, code_start, start, start + memory.size(), &candidates);
+
+			// fuzzy_functions, known_functions
+			Q_FOREACH(const std::size_t offset, candidates) {
+
+				const quint8 *const p     = code_first + offset;
+				const edb::address_t addr = code_start + offset;
+
+				// the target is right there in the bytes, so the length is all
+				// that needs decoding
+				edb::length::Flow flow;
+				if(p[0] == 0xe8 && edb::instruction_length(p, code_last - p, &flow) == 5 && flow == edb::length::FLOW_CALL) {
+
+					qint32 rel;
+					std::memcpy(&rel, p + 1, sizeof(rel));
+					const edb::address_t ea = addr + 5 + rel;
+
+					// skip over ones which are: "call <label>; label:"
+					if(ea != addr + 5 && in_ranges(ea, data->code)) {
+
+						if(!data->known_functions.contains(ea)) {
+							fuzzy_functions[ea]++;
+						}
+					}
+				}
+			}
+		}
+
+		// transfer results to data->fuzzy_functions
+		for(QHash<edb::address_t, int>::const_iterator it = fuzzy_functions.begin(); it != fuzzy_functions.end(); ++it) {
+			if(it.value() > MIN_REFCOUNT) {
+				data->fuzzy_functions.insert(it.key());
+			}
+		}
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: analysis_stopped
+// Desc: returns true if the analysis of <data>'s region should stop early
+//------------------------------------------------------------------------------
+bool Analyzer::analysis_stopped(const RegionData &data) const {
+	return analysis_cancelled_ || analysis_discarded_.contains(data.region->start());
+}
+
+//------------------------------------------------------------------------------
+// Name: begin_analysis
+// Desc: takes the analysis of <region> as far as walking its functions, which
+//       is left running on the shared pool for finish_analysis to collect.
+//       Returns false if the previous analysis of <region> still holds
+//------------------------------------------------------------------------------
+bool Analyzer::begin_analysis(const IRegion::pointer &region, bool report_steps, PendingAnalysis *pending) {
+
+	Q_ASSERT(pending);
+
+	// worked on as a copy, the GUI keeps running during the analysis and
+	// anything may happen to analysis_info_ meanwhile
+	RegionData &region_data = pending->data;
+	region_data = analysis_info_.value(region->start());
+
+	QSettings settings;
+	const bool fuzzy          = settings.value("Analyzer/fuzzy_logic_functions.enabled", true).toBool();
+	const QVector<quint8> memory = read_region(region);
+	const QByteArray md5         = memory.isEmpty() ? QByteArray() : edb::v1::get_fingerprint(memory.constData(), memory.size());
+	const QByteArray prev_md5    = region_data.md5;
+
+	QVector<QPair<edb::address_t, edb::address_t> > code;
+	Q_FOREACH(const IRegion::pointer &part, edb::v1::code_regions(region)) {
+		code.push_back(qMakePair(part->start(), part->end()));
+	}
+
+	if(prev_md5.isEmpty() && adopt_retired(region, md5, fuzzy, code)) {
+		qDebug("[Analyzer] region unchanged since the restart, using previous analysis");
+		return false;
+	}
+
+	if(md5 == prev_md5 && fuzzy == region_data.fuzzy && code == region_data.code) {
+		qDebug("[Analyzer] region unchanged, using previous analysis");
+		analysis_info_[region->start()].dirty.clear();
+		return false;
+	}
+
+	// if all that has changed is what edb itself wrote, only the code
+	// around the writes needs looking at again
+	const bool incremental =
+		!region_data.dirty.isEmpty() &&
+		region_data.region &&
+		region_data.region->size() == region->size() &&
+		fuzzy == region_data.fuzzy &&
+		code == region_data.code &&
+		!region_data.functions.isEmpty();
+
+	region_data.region = region;
+	region_data.md5    = md5;
+	region_data.fuzzy  = fuzzy;
+	region_data.code   = code;
+	region_data.memory = memory;
+
+	analysis_regions_.insert(region->start());
+	analysis_discarded_.remove(region->start());
+
+	pending->cache    = QSharedPointer<AnalysisCache>(new AnalysisCache(region, md5, fuzzy, code, specified_functions_));
+	pending->save     = use_cache_;
+	pending->progress = 0;
+
+	if(incremental) {
+		qDebug("[Analyzer] re-analyzing patched code...");
+		if(report_steps) {
+			analysis_step_  = 0;
+			analysis_steps_ = 1;
+		}
+
+		reanalyze_dirty(&region_data);
+		return true;
+	}
+
+	region_data.basic_blocks.clear();
+	region_data.functions.clear();
+	region_data.fuzzy_functions.clear();
+	region_data.known_functions.clear();
+
+	if(use_cache_ && pending->cache->load(memory, &region_data.known_functions, &region_data.fuzzy_functions, &region_data.basic_blocks, &region_data.functions)) {
+		qDebug("[Analyzer] loaded previous analysis from %s", qPrintable(pending->cache->filename()));
+		pending->save = false;
+		return true;
+	}
+
+	const struct {
+		const char             *message;
+		boost::function<void()> function;
+	} analysis_steps[] = {
+		{ "identifying executable headers...",                       boost::bind(&Analyzer::ident_header,            this, &region_data) },
+		{ "adding entry points to the list...",                      boost::bind(&Analyzer::bonus_entry_point,       this, &region_data) },
+		{ "attempting to add 'main' to the list...",                 boost::bind(&Analyzer::bonus_main,              this, &region_data) },
+		{ "attempting to add functions with symbols to the list...", boost::bind(&Analyzer::bonus_symbols,           this, &region_data) },
+		{ "attempting to add marked functions to the list...",       boost::bind(&Analyzer::bonus_marked_functions,  this, &region_data) },
+		{ "adding what other regions call to the list...",           boost::bind(&Analyzer::bonus_external_calls,    this, &region_data) },
+		{ "attempting to collect functions with fuzzy analysis...",  boost::bind(&Analyzer::collect_fuzzy_functions, this, &region_data) },
+	};
+
+	const int total_steps = sizeof(analysis_steps) / sizeof(analysis_steps[0]);
+
+	// collecting the basic blocks is the last step, it is finished along
+	// with the walks of the rest of the batch
+	if(report_steps) {
+		analysis_steps_ = total_steps + 1;
+		emit update_progress(util::percentage(0, analysis_steps_));
+	}
+
+	for(int i = 0; i < total_steps && !analysis_stopped(region_data); ++i) {
+		qDebug("[Analyzer] %s", analysis_steps[i].message);
+		if(report_steps) {
+			analysis_step_ = i;
+		}
+
+		analysis_steps[i].function();
+
+		if(report_steps) {
+			emit update_progress(util::percentage(i + 1, analysis_steps_));
+		}
+	}
+
+	if(report_steps) {
+		analysis_step_ = total_steps;
+	}
+
+	if(!analysis_stopped(region_data)) {
+		qDebug("[Analyzer] collecting basic blocks...");
+		start_discovery(pending);
+	}
+
+	return true;
+}
+
+//------------------------------------------------------------------------------
+// Name: finish_analysis
+// Desc: collects the walk begin_analysis left running and builds the rest of
+//       the analysis from it, which is kept unless the region was invalidated
+//       in the meantime
+//------------------------------------------------------------------------------
+void Analyzer::finish_analysis(PendingAnalysis *pending) {
+
+	Q_ASSERT(pending);
+
+	RegionData &region_data       = pending->data;
+	const IRegion::pointer region = region_data.region;
+
+	if(pending->discovery) {
+		QHash<edb::address_t, BasicBlock> basic_blocks;
+		QHash<edb::address_t, Function>   functions;
+
+		pending->discovery->results(&basic_blocks, &functions);
+		pending->discovery.clear();
+
+		qSwap(region_data.basic_blocks, basic_blocks);
+		qSwap(region_data.functions, functions);
+
+		qDebug("[Analyzer] determining function types...");
+
+		set_function_types(&region_data.functions);
+	}
+
+	const AnalysisCache &cache = *pending->cache;
+	if(pending->save && !analysis_stopped(region_data) && !cache.filename().isEmpty() && !cache.save(region_data.known_functions, region_data.fuzzy_functions, region_data.basic_blocks, region_data.functions)) {
+		qDebug("[Analyzer] could not save the analysis to %s", qPrintable(cache.filename()));
+	}
+
+	build_function_index(&region_data);
+	build_references(&region_data);
+	build_call_graph(&region_data);
+
+	if(!analysis_stopped(region_data)) {
+		name_library_functions(&region_data);
+	}
+
+	// the blocks hold their own share of the snapshot to decode from
+	region_data.memory.clear();
+	region_data.dirty.clear();
+
+	// what was found before a cancel is kept, but it isn't a whole
+	// analysis so the next one has to start over
+	if(analysis_stopped(region_data)) {
+		region_data.md5.clear();
+		qDebug("[Analyzer] cancelled");
+	} else {
+		qDebug("[Analyzer] complete");
+	}
+
+	if(!analysis_discarded_.contains(region->start())) {
+		analysis_info_[region->start()] = region_data;
+		remember_analysis(region->start());
+	}
+
+	analysis_regions_.remove(region->start());
+	analysis_discarded_.remove(region->start());
+}
+
+//------------------------------------------------------------------------------
+// Name: analyze_batch
+// Desc: begins the analysis of each of <regions> and then waits on all of
+//       their walks together. A region analyzed on its own reports every
+//       step, a batch only its walking, as <phase> of <phases>
+//------------------------------------------------------------------------------
+void Analyzer::analyze_batch(const QList<IRegion::pointer> &regions, int phase, int phases) {
+
+	EDB_TRACE_SCOPE("Analyzer::analyze_batch");
+
+	const bool report_steps = regions.size() == 1 && phases == 1;
+
+	if(!report_steps) {
+		analysis_step_  = phase;
+		analysis_steps_ = phases;
+		emit update_progress(util::percentage(phase, phases));
+	}
+
+	QList<QSharedPointer<PendingAnalysis> > started;
+	QList<PendingAnalysis *>                batch;
+
+	Q_FOREACH(const IRegion::pointer &region, regions) {
+		if(analysis_cancelled_) {
+			break;
+		}
+
+		const QSharedPointer<PendingAnalysis> pending(new PendingAnalysis);
+		if(begin_analysis(region, report_steps, pending.data())) {
+			started.push_back(pending);
+			batch.push_back(pending.data());
+		}
+	}
+
+	run_discoveries(batch);
+
+	Q_FOREACH(PendingAnalysis *pending, batch) {
+		finish_analysis(pending);
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: analyze
+// Desc:
+//------------------------------------------------------------------------------
+void Analyzer::analyze(const IRegion::pointer &region) {
+	analyze_regions(QList<IRegion::pointer>() << region);
+}
+
+//------------------------------------------------------------------------------
+// Name: analyze_regions
+// Desc: analyzes all of <regions>, their walks sharing one pool of threads.
+//       The main binary's region goes first and on its own, so that what it
+//       calls in the libraries gives their analyses more to start from
+//------------------------------------------------------------------------------
+void Analyzer::analyze_regions(const QList<IRegion::pointer> &regions) {
+
+	EDB_TRACE_SCOPE("Analyzer::analyze");
+
+	if(!analysis_regions_.isEmpty()) {
+		qDebug("[Analyzer] an analysis is already running");
+		return;
+	}
+
+	QTime t;
+	t.start();
+
+	analysis_cancelled_ = false;
+
+	QList<IRegion::pointer> main_region;
+	QList<IRegion::pointer> other_regions = regions;
+
+	if(other_regions.size() > 1) {
+		if(const IRegion::pointer primary = edb::v1::primary_code_region()) {
+			for(int i = 0; i < other_regions.size(); ++i) {
+				if(other_regions[i]->start() == primary->start()) {
+					main_region.push_back(other_regions.takeAt(i));
+					break;
+				}
+			}
+		}
+	}
+
+	const int phases = main_region.isEmpty() ? 1 : 2;
+
+	if(!main_region.isEmpty()) {
+		analyze_batch(main_region, 0, phases);
+	}
+
+	if(!analysis_cancelled_) {
+		analyze_batch(other_regions, phases - 1, phases);
+	}
+
+	emit update_progress(100);
+
+	if(trim_pending_) {
+		trim_pending_ = false;
+		trim(trim_bytes_);
+	}
+
+	if(analyzer_widget_) {
+		analyzer_widget_->repaint();
+	}
+
+	qDebug("[Analyzer] elapsed: %d ms", t.elapsed());
+}
+
+//------------------------------------------------------------------------------
+// Name: category
+// Desc:
+//------------------------------------------------------------------------------
+IAnalyzer::AddressCategory Analyzer::category(edb::address_t address) const {
+
+	Function func;
+	if(find_containing_function(address, &func)) {
+		if(address == func.entry_address()) {
+			return ADDRESS_FUNC_START;
+		} else if(address == func.end_address()) {
+			return ADDRESS_FUNC_END;
 		} else {
 			return ADDRESS_FUNC_BODY;
 		}
@@ -681,6 +1653,105 @@ IAnalyzer::FunctionMap Analyzer::functions(const IRegion::pointer &region) const
 	return analysis_info_[region->start()].functions;
 }
 
+//------------------------------------------------------------------------------
+// Name: summary_less
+// Desc:
+//------------------------------------------------------------------------------
+bool Analyzer::summary_less(const FunctionSummary &lhs, const FunctionSummary &rhs) {
+	return lhs.entry < rhs.entry;
+}
+
+//------------------------------------------------------------------------------
+// Name: function_table
+// Desc:
+//------------------------------------------------------------------------------
+IAnalyzer::FunctionTable Analyzer::function_table(const IRegion::pointer &region) const {
+
+	const QHash<edb::address_t, Function> functions = analysis_info_.value(region->start()).functions;
+
+	FunctionTable table;
+	table.reserve(functions.size());
+	for(QHash<edb::address_t, Function>::const_iterator it = functions.begin(); it != functions.end(); ++it) {
+		table.push_back(summarize(it.value()));
+	}
+
+	std::sort(table.begin(), table.end(), summary_less);
+	return table;
+}
+
+//------------------------------------------------------------------------------
+// Name: basic_blocks
+// Desc:
+//------------------------------------------------------------------------------
+IAnalyzer::BasicBlockMap Analyzer::basic_blocks(const IRegion::pointer &region) const {
+	return analysis_info_[region->start()].basic_blocks;
+}
+
+//------------------------------------------------------------------------------
+// Name: call_graph
+// Desc:
+//------------------------------------------------------------------------------
+IAnalyzer::CallGraph Analyzer::call_graph(const IRegion::pointer &region) const {
+	return analysis_info_.value(region->start()).call_graph;
+}
+
+//------------------------------------------------------------------------------
+// Name: references
+// Desc: looks <target> up in the references of <region>'s analysis, as long as
+//       nothing has been written to the region since
+//------------------------------------------------------------------------------
+bool Analyzer::references(const IRegion::pointer &region, edb::address_t target, ReferenceList *results) const {
+
+	Q_ASSERT(results);
+
+	const QHash<edb::address_t, RegionData>::const_iterator it = analysis_info_.find(region->start());
+	if(it == analysis_info_.end() || it->md5.isEmpty() || !it->dirty.isEmpty() || !it->region || it->region->size() != region->size()) {
+		return false;
+	}
+
+	Reference key;
+	key.target = target;
+	key.source = 0;
+	key.type   = Reference::REF_CALL;
+
+	results->clear();
+
+	QVector<Reference>::const_iterator ref = std::lower_bound(it->references.begin(), it->references.end(), key, reference_less);
+	for(; ref != it->references.end() && ref->target == target; ++ref) {
+		results->push_back(*ref);
+	}
+
+	return true;
+}
+
+//------------------------------------------------------------------------------
+// Name: follows_call
+// Desc: looks the byte in front of <address> up in the analysis of its region,
+//       as long as nothing has been written to the region since
+//------------------------------------------------------------------------------
+bool Analyzer::follows_call(edb::address_t address, bool *result) const {
+
+	Q_ASSERT(result);
+
+	const IRegion::pointer region = edb::v1::memory_regions().find_region(address - 1);
+	if(!region) {
+		return false;
+	}
+
+	const QHash<edb::address_t, RegionData>::const_iterator it = analysis_info_.find(region->start());
+	if(it == analysis_info_.end() || it->md5.isEmpty() || !it->dirty.isEmpty() || !it->region || it->region->size() != region->size()) {
+		return false;
+	}
+
+	const edb::address_t offset = address - 1 - region->start();
+	if(offset >= static_cast<edb::address_t>(it->decoded.size()) || !it->decoded.testBit(offset)) {
+		return false;
+	}
+
+	*result = it->call_ends.testBit(offset);
+	return true;
+}
+
 //------------------------------------------------------------------------------
 // Name: find_containing_function
 // Desc:
@@ -690,36 +1761,33 @@ bool Analyzer::find_containing_function(edb::address_t address, Function *functi
 	Q_ASSERT(function);
 
 	if(IRegion::pointer region = edb::v1::memory_regions().find_region(address)) {
-		const FunctionMap &funcs = functions(region);
-		Q_FOREACH(const Function &f, funcs) {
-			if(address >= f.entry_address() && address <= f.end_address()) {
-				*function = f;
-				return true;
-			}
+		const QHash<edb::address_t, RegionData>::const_iterator it = analysis_info_.find(region->start());
+		if(it == analysis_info_.end()) {
+			return false;
+		}
+
+		edb::address_t entry;
+		if(containing_entry(*it, address, &entry)) {
+			*function = it->functions.value(entry);
+			return true;
 		}
 	}
 	return false;
 }
 
 //------------------------------------------------------------------------------
-// Name: md5_region
-// Desc: returns a byte array representing the MD5 of a region
+// Name: read_region
+// Desc: returns a snapshot of the whole region with breakpoints patched out,
+//       every analysis step decodes from it rather than reading the process
 //------------------------------------------------------------------------------
-QByteArray Analyzer::md5_region(const IRegion::pointer &region) const{
+QVector<quint8> Analyzer::read_region(const IRegion::pointer &region) const {
 
 	const edb::address_t page_size = edb::v1::debugger_core->page_size();
 	const size_t page_count        = region->size() / page_size;
 
-	const QVector<quint8> pages = edb::v1::read_pages(region->start(), page_count);
-	if(!pages.isEmpty()) {
-		return edb::v1::get_md5(pages);
-	}
-
-
-	return QByteArray();
+	return edb::v1::read_pages(region->start(), page_count);
 }
 
-
 //------------------------------------------------------------------------------
 // Name: bonus_entry_point
 // Desc:
@@ -744,6 +1812,37 @@ void Analyzer::bonus_entry_point(RegionData *data) const {
 	}
 }
 
+//------------------------------------------------------------------------------
+// Name: run_benchmarks
+// Desc: analyzes each executable one of <regions> from scratch, without the
+//       analysis cache, and counts the functions which were found. The
+//       functions marked by the user are kept
+//------------------------------------------------------------------------------
+QList<BenchmarkResult> Analyzer::run_benchmarks(const QList<IRegion::pointer> &regions) {
+
+	BenchmarkRun run("Analyzer::analyze", "functions");
+
+	use_cache_ = false;
+
+	Q_FOREACH(const IRegion::pointer &region, regions) {
+		if(!region->executable() || region->size() == 0) {
+			continue;
+		}
+
+		invalidate_dynamic_analysis(region);
+
+		run.start();
+		analyze(region);
+
+		QVariantMap parameters;
+		parameters["region"] = region->name();
+		run.finish(parameters, region->size(), functions(region).size());
+	}
+
+	use_cache_ = true;
+	return run.results();
+}
+
 //------------------------------------------------------------------------------
 // Name: invalidate_analysis
 // Desc:
@@ -757,16 +1856,48 @@ void Analyzer::invalidate_analysis(const IRegion::pointer &region) {
 	}
 }
 
+//------------------------------------------------------------------------------
+// Name: cancel_analysis
+// Desc: the running analysis stops soon after, keeping what it found so far
+//------------------------------------------------------------------------------
+void Analyzer::cancel_analysis() {
+	if(!analysis_regions_.isEmpty()) {
+		analysis_cancelled_ = true;
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: invalidate_range
+// Desc: remembers the write so the next analysis of its region can redo just
+//       the part of it which was touched
+//------------------------------------------------------------------------------
+void Analyzer::invalidate_range(edb::address_t address, edb::address_t size) {
+
+	const edb::address_t end = address + size;
+
+	for(QHash<edb::address_t, RegionData>::iterator it = analysis_info_.begin(); it != analysis_info_.end(); ++it) {
+		RegionData &data = it.value();
+		if(data.region && address < data.region->end() && data.region->start() < end) {
+			data.dirty.push_back(qMakePair(qMax(address, data.region->start()), qMin(end, data.region->end())));
+		}
+	}
+}
+
 //------------------------------------------------------------------------------
 // Name: invalidate_dynamic_analysis
 // Desc:
 //------------------------------------------------------------------------------
 void Analyzer::invalidate_dynamic_analysis(const IRegion::pointer &region) {
 
+	if(analysis_regions_.contains(region->start())) {
+		analysis_discarded_.insert(region->start());
+	}
+
 	RegionData info;
 	info.region = region;
 
 	analysis_info_[region->start()] = info;
+	remember_analysis(region->start());
 }
 
 //------------------------------------------------------------------------------
@@ -774,8 +1905,284 @@ void Analyzer::invalidate_dynamic_analysis(const IRegion::pointer &region) {
 // Desc:
 //------------------------------------------------------------------------------
 void Analyzer::invalidate_analysis() {
+
+	if(!analysis_regions_.isEmpty()) {
+		analysis_cancelled_ = true;
+		analysis_discarded_ = analysis_regions_;
+	}
+
 	analysis_info_.clear();
+	analysis_order_.clear();
 	specified_functions_.clear();
+	retired_.clear();
+	restart_moves_.clear();
+}
+
+//------------------------------------------------------------------------------
+// Name: invalidate_for_restart
+// Desc: like invalidate_analysis, but the analysis of every module's region is
+//       kept in <retired_> for adopt_retired to find once the restarted
+//       process maps the module again
+//------------------------------------------------------------------------------
+void Analyzer::invalidate_for_restart() {
+
+	QHash<QString, RetiredAnalysis> retired;
+
+	for(QHash<edb::address_t, RegionData>::const_iterator it = analysis_info_.begin(); it != analysis_info_.end(); ++it) {
+		const RegionData &data = it.value();
+		if(!data.region || data.md5.isEmpty() || analysis_regions_.contains(it.key())) {
+			continue;
+		}
+
+		const QString key = module_key(data.region);
+		if(!key.isEmpty()) {
+			RetiredAnalysis &entry = retired[key];
+			entry.data = data;
+			Q_FOREACH(const edb::address_t address, specified_functions_) {
+				if(data.region->contains(address)) {
+					entry.specified_functions.insert(address);
+				}
+			}
+		}
+	}
+
+	invalidate_analysis();
+	qSwap(retired_, retired);
+}
+
+//------------------------------------------------------------------------------
+// Name: module_key
+// Desc: names a region by the file it maps and where in the file it starts,
+//       which stays the same however the module is loaded. Regions which
+//       aren't file mappings have no key
+//------------------------------------------------------------------------------
+QString Analyzer::module_key(const IRegion::pointer &region) {
+	if(!region || region->name().isEmpty() || !QFileInfo(region->name()).isAbsolute()) {
+		return QString();
+	}
+
+	return QString("%1@%2").arg(region->name()).arg(static_cast<quint64>(region->base()), 0, 16);
+}
+
+//------------------------------------------------------------------------------
+// Name: rebased_address
+// Desc: where <address> of the process before the restart is now. Addresses
+//       in a module which hasn't been mapped again yet have nowhere to go,
+//       anything outside of the modules stays where it was
+//------------------------------------------------------------------------------
+bool Analyzer::rebased_address(edb::address_t address, edb::address_t *result) const {
+
+	Q_ASSERT(result);
+
+	Q_FOREACH(const RegionMove &move, restart_moves_) {
+		if(address >= move.start && address < move.end) {
+			*result = address - move.start + move.new_start;
+			return true;
+		}
+	}
+
+	for(QHash<QString, RetiredAnalysis>::const_iterator it = retired_.begin(); it != retired_.end(); ++it) {
+		if(it->data.region->contains(address)) {
+			return false;
+		}
+	}
+
+	*result = address;
+	return true;
+}
+
+//------------------------------------------------------------------------------
+// Name: adopt_retired
+// Desc: if the analysis of <region> from before the restart was of the same
+//       bytes, it becomes the region's analysis, moved to where the region is
+//       now. Nothing is decoded again, only the addresses change. References
+//       into modules which haven't been mapped again yet are dropped
+//------------------------------------------------------------------------------
+bool Analyzer::adopt_retired(const IRegion::pointer &region, const QByteArray &md5, bool fuzzy, const QVector<QPair<edb::address_t, edb::address_t> > &code) {
+
+	if(!use_cache_ || md5.isEmpty()) {
+		return false;
+	}
+
+	const QHash<QString, RetiredAnalysis>::iterator it = retired_.find(module_key(region));
+	if(it == retired_.end()) {
+		return false;
+	}
+
+	const RetiredAnalysis retired = it.value();
+	retired_.erase(it);
+
+	const RegionData &old = retired.data;
+	if(old.md5 != md5 || old.fuzzy != fuzzy || old.region->size() != region->size()) {
+		return false;
+	}
+
+	const edb::address_t start     = old.region->start();
+	const edb::address_t end       = old.region->end();
+	const edb::address_t new_start = region->start();
+
+	const RegionMove move = { start, end, new_start };
+	restart_moves_.push_back(move);
+
+	RegionData data;
+	data.md5       = md5;
+	data.fuzzy     = fuzzy;
+	data.region    = region;
+	data.code      = code;
+	data.decoded   = old.decoded;
+	data.call_ends = old.call_ends;
+
+	edb::address_t address;
+	Q_FOREACH(const edb::address_t function, old.known_functions) {
+		if(rebased_address(function, &address)) {
+			data.known_functions.insert(address);
+		}
+	}
+
+	Q_FOREACH(const edb::address_t function, old.fuzzy_functions) {
+		if(rebased_address(function, &address)) {
+			data.fuzzy_functions.insert(address);
+		}
+	}
+
+	Q_FOREACH(const edb::address_t target, old.external_calls) {
+		if(rebased_address(target, &address)) {
+			data.external_calls.insert(address);
+		}
+	}
+
+	for(QHash<edb::address_t, Function>::const_iterator f = old.functions.begin(); f != old.functions.end(); ++f) {
+		Function function = f.value();
+		function.rebase(start, end, new_start);
+		data.functions.insert(f.key() - start + new_start, function);
+	}
+
+	for(QHash<edb::address_t, BasicBlock>::const_iterator b = old.basic_blocks.begin(); b != old.basic_blocks.end(); ++b) {
+		BasicBlock block = b.value();
+		block.rebase(start, end, new_start);
+		data.basic_blocks.insert(b.key() - start + new_start, block);
+	}
+
+	data.references.reserve(old.references.size());
+	Q_FOREACH(Reference ref, old.references) {
+		if(rebased_address(ref.source, &ref.source) && rebased_address(ref.target, &ref.target)) {
+			data.references.push_back(ref);
+		}
+	}
+
+	// the targets in other modules moved by other amounts
+	std::sort(data.references.begin(), data.references.end(), reference_less);
+
+	build_function_index(&data);
+	build_call_graph(&data);
+
+	Q_FOREACH(const edb::address_t function, retired.specified_functions) {
+		specified_functions_.insert(function - start + new_start);
+	}
+
+	analysis_info_[new_start] = data;
+	remember_analysis(new_start);
+	return true;
+}
+
+//------------------------------------------------------------------------------
+// Name: remember_analysis
+// Desc: marks the analysis of the region starting at <region> as the most
+//       recent one
+//------------------------------------------------------------------------------
+void Analyzer::remember_analysis(edb::address_t region) {
+	analysis_order_[region] = ++analysis_sequence_;
+}
+
+//------------------------------------------------------------------------------
+// Name: region_memory
+// Desc: an estimate of what the analysis of one region holds. The blocks of
+//       the functions share their bytes with <basic_blocks>
+//------------------------------------------------------------------------------
+quint64 Analyzer::region_memory(const RegionData &data) {
+
+	// a rough allowance for the nodes of the hashes, sets and maps
+	const quint64 node = 4 * sizeof(void *);
+
+	quint64 bytes = sizeof(RegionData);
+	bytes += static_cast<quint64>(data.known_functions.size() + data.fuzzy_functions.size() + data.external_calls.size()) * (sizeof(edb::address_t) + node);
+	bytes += static_cast<quint64>(data.functions.size()) * (sizeof(Function) + node);
+	bytes += data.memory.size();
+	bytes += data.code.size() * sizeof(data.code[0]);
+	bytes += data.dirty.size() * sizeof(data.dirty[0]);
+	bytes += data.function_index.size() * sizeof(FunctionRange);
+	bytes += data.references.size() * sizeof(Reference);
+	bytes += (data.decoded.size() + data.call_ends.size()) / 8;
+
+	for(QHash<edb::address_t, BasicBlock>::const_iterator it = data.basic_blocks.begin(); it != data.basic_blocks.end(); ++it) {
+		// each block is in its function's map too
+		bytes += 2 * (sizeof(BasicBlock) + node) + it->byte_size();
+	}
+
+	return bytes;
+}
+
+//------------------------------------------------------------------------------
+// Name: memory_used
+// Desc:
+//------------------------------------------------------------------------------
+quint64 Analyzer::memory_used() const {
+	quint64 bytes = 0;
+	for(QHash<edb::address_t, RegionData>::const_iterator it = analysis_info_.begin(); it != analysis_info_.end(); ++it) {
+		bytes += region_memory(it.value());
+	}
+	for(QHash<QString, RetiredAnalysis>::const_iterator it = retired_.begin(); it != retired_.end(); ++it) {
+		bytes += region_memory(it->data);
+	}
+	return bytes;
+}
+
+//------------------------------------------------------------------------------
+// Name: trim
+// Desc: forgets the least recently analyzed regions until what is left fits.
+//       The rest can be analyzed again (or loaded from the analysis cache)
+//       when they are next asked about. An analysis runs on the UI thread and
+//       lets events through while it waits on its walks, so a budget enforced
+//       from one of those events would pull regions out from under it. That
+//       trim is put off until the analysis is done instead
+//------------------------------------------------------------------------------
+void Analyzer::trim(quint64 bytes) {
+
+	if(!analysis_regions_.isEmpty()) {
+		trim_bytes_   = trim_pending_ ? qMin(trim_bytes_, bytes) : bytes;
+		trim_pending_ = true;
+		return;
+	}
+
+	QList<QPair<quint64, edb::address_t> > order;
+	quint64 used = 0;
+	for(QHash<edb::address_t, RegionData>::const_iterator it = analysis_info_.begin(); it != analysis_info_.end(); ++it) {
+		used += region_memory(it.value());
+		order.push_back(qMakePair(analysis_order_.value(it.key()), it.key()));
+	}
+
+	std::sort(order.begin(), order.end());
+
+	for(QHash<QString, RetiredAnalysis>::const_iterator it = retired_.begin(); it != retired_.end(); ++it) {
+		used += region_memory(it->data);
+	}
+
+	// what was put aside for a restart is the least recent of all
+	for(QHash<QString, RetiredAnalysis>::iterator it = retired_.begin(); it != retired_.end() && used > bytes; ) {
+		used -= qMin(used, region_memory(it->data));
+		it = retired_.erase(it);
+	}
+
+	for(QList<QPair<quint64, edb::address_t> >::const_iterator it = order.begin(); it != order.end() && used > bytes; ++it) {
+		const QHash<edb::address_t, RegionData>::iterator entry = analysis_info_.find(it->second);
+		used -= qMin(used, region_memory(entry.value()));
+		analysis_info_.erase(entry);
+		analysis_order_.remove(it->second);
+	}
+
+	if(analyzer_widget_) {
+		analyzer_widget_->update();
+	}
 }
 
 //------------------------------------------------------------------------------
@@ -795,26 +2202,25 @@ edb::address_t Analyzer::find_containing_function(edb::address_t address, bool *
 }
 
 //------------------------------------------------------------------------------
-// Name: will_return
-// Desc:
+// Name: no_return_functions
+// Desc: the addresses of the functions known never to return to their caller,
+//       gathered once up front so walking the region needs no symbol lookups
 //------------------------------------------------------------------------------
-bool Analyzer::will_return(edb::address_t address) const {
+QSet<edb::address_t> Analyzer::no_return_functions() const {
 
+	QSet<edb::address_t> results;
 
 	const QList<Symbol::pointer> symbols = edb::v1::symbol_manager().symbols();
 	Q_FOREACH(const Symbol::pointer &symbol, symbols) {
-		if(symbol->address == address) {
-			const QString symname = symbol->name_no_prefix;
-			const QString func_name = symname.mid(0, symname.indexOf("@"));
+		const QString symname = symbol->name_no_prefix;
+		const QString func_name = symname.mid(0, symname.indexOf("@"));
 
-			if(func_name == "__assert_fail" || func_name == "abort" || func_name == "_exit" || func_name == "_Exit") {
-				return false;
-			}
+		if(func_name == "__assert_fail" || func_name == "abort" || func_name == "_exit" || func_name == "_Exit") {
+			results.insert(symbol->address);
 		}
 	}
 
-
-	return true;
+	return results;
 }
 
 #if QT_VERSION < 0x050000
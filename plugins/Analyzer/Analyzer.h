@@ -22,22 +22,30 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "IAnalyzer.h"
 #include "IPlugin.h"
 #include "IRegion.h"
+#include "MemoryBudget.h"
 #include "Symbol.h"
 #include "Types.h"
 #include "BasicBlock.h"
+#include <QBitArray>
 #include <QSet>
 #include <QMap>
 #include <QHash>
 #include <QVector>
 #include <QList>
+#include <QPair>
+#include <QSharedPointer>
+#include <QThreadPool>
 
 class QMenu;
 
 namespace Analyzer {
 
+class AnalysisCache;
 class AnalyzerWidget;
+class FunctionDiscovery;
+class SignatureLibrary;
 
-class Analyzer : public QObject, public IAnalyzer, public IPlugin {
+class Analyzer : public QObject, public IAnalyzer, public IPlugin, public edb::memory::Consumer {
 	Q_OBJECT
 	
 #if QT_VERSION >= 0x050000
@@ -48,10 +56,13 @@ class Analyzer : public QObject, public IAnalyzer, public IPlugin {
 	Q_CLASSINFO("url", "http://www.codef00.com")
 
 private:
+	struct FunctionRange;
 	struct RegionData;
+	struct PendingAnalysis;
 	
 public:
 	Analyzer();
+	virtual ~Analyzer();
 
 public:
 	virtual QMenu *menu(QWidget *parent = 0);
@@ -61,44 +72,104 @@ private:
 	virtual void private_init();
 	virtual QWidget *options_page();
 
+public:
+	virtual QList<BenchmarkResult> run_benchmarks(const QList<IRegion::pointer> &regions);
+
 public:
 	virtual AddressCategory category(edb::address_t address) const;
 	virtual FunctionMap functions(const IRegion::pointer &region) const;
+	virtual BasicBlockMap basic_blocks(const IRegion::pointer &region) const;
 	virtual QSet<edb::address_t> specified_functions() const { return specified_functions_; }
 	virtual edb::address_t find_containing_function(edb::address_t address, bool *ok) const;
 	virtual void analyze(const IRegion::pointer &region);
+	virtual void analyze_regions(const QList<IRegion::pointer> &regions);
 	virtual void invalidate_analysis();
 	virtual void invalidate_analysis(const IRegion::pointer &region);
+	virtual void invalidate_range(edb::address_t address, edb::address_t size);
+	virtual void invalidate_for_restart();
+	virtual bool references(const IRegion::pointer &region, edb::address_t target, ReferenceList *results) const;
+	virtual CallGraph call_graph(const IRegion::pointer &region) const;
+	virtual FunctionTable function_table(const IRegion::pointer &region) const;
+	virtual bool follows_call(edb::address_t address, bool *result) const;
+
+public:
+	virtual quint64 memory_used() const;
+	virtual void trim(quint64 bytes);
 
 private:
-	QByteArray md5_region(const IRegion::pointer &region) const;
+	static quint64 region_memory(const RegionData &data);
+	static bool entry_less(edb::address_t address, const FunctionRange &range);
+	static bool summary_less(const FunctionSummary &lhs, const FunctionSummary &rhs);
+	static bool range_less(const FunctionRange &lhs, const FunctionRange &rhs);
+	static bool reference_less(const Reference &lhs, const Reference &rhs);
+	static bool containing_entry(const RegionData &data, edb::address_t address, edb::address_t *entry);
+	static QString module_key(const IRegion::pointer &region);
+
+private:
+	bool adopt_retired(const IRegion::pointer &region, const QByteArray &md5, bool fuzzy, const QVector<QPair<edb::address_t, edb::address_t> > &code);
+	bool analysis_stopped(const RegionData &data) const;
+	bool rebased_address(edb::address_t address, edb::address_t *result) const;
+	bool begin_analysis(const IRegion::pointer &region, bool report_steps, PendingAnalysis *pending);
 	bool find_containing_function(edb::address_t address, Function *function) const;
-	bool is_thunk(edb::address_t address) const;
-	bool will_return(edb::address_t address) const;
+	bool is_thunk(const Function &function) const;
+	void analyze_batch(const QList<IRegion::pointer> &regions, int phase, int phases);
 	void bonus_entry_point(RegionData *data) const;
+	void bonus_external_calls(RegionData *data) const;
 	void bonus_main(RegionData *data) const;
 	void bonus_marked_functions(RegionData *data);
 	void bonus_symbols(RegionData *data);
-	void collect_functions(RegionData *data);
+	void build_function_index(RegionData *data);
+	void build_call_graph(RegionData *data);
+	void build_references(RegionData *data);
 	void collect_fuzzy_functions(RegionData *data);
 	void do_analysis(const IRegion::pointer &region);
+	void do_analysis(const QList<IRegion::pointer> &regions);
+	void finish_analysis(PendingAnalysis *pending);
 	void ident_header(Analyzer::RegionData *data);
+	void load_signatures();
+	void name_library_functions(RegionData *data);
 	void invalidate_dynamic_analysis(const IRegion::pointer &region);
+	QSet<edb::address_t> no_return_functions() const;
+	QVector<quint8> read_region(const IRegion::pointer &region) const;
+	void reanalyze_dirty(RegionData *data);
+	void remember_analysis(edb::address_t region);
+	void publish_partial(RegionData *data, const QHash<edb::address_t, Function> &finished);
+	void run_discovery(RegionData *data, FunctionDiscovery *discovery, const QList<edb::address_t> &entries);
+	void run_discoveries(const QList<PendingAnalysis *> &batch);
+	void start_discovery(PendingAnalysis *pending);
 	void set_function_types(FunctionMap *results);
 	void set_function_types_helper(Function &function) const;
 
 Q_SIGNALS:
 	void update_progress(int);
 
+	// some of the functions of the region starting at <region>, as soon as a
+	// running analysis has finished walking them
+	void functions_found(edb::address_t region, const IAnalyzer::FunctionTable &functions);
+
 public Q_SLOTS:
+	virtual void cancel_analysis();
+	void compile_signatures();
 	void do_ip_analysis();
+	void do_module_analysis();
 	void do_view_analysis();
+	void export_call_graph();
+	void show_call_graph();
+	void show_function_graph();
 	void goto_function_start();
 	void goto_function_end();
 	void mark_function_start();
 	void show_specified();
 
 private:
+	struct FunctionRange {
+		edb::address_t entry;
+		edb::address_t end;
+
+		// the furthest end of this or any earlier function in the index
+		edb::address_t reach;
+	};
+
 	struct RegionData {
 		QSet<edb::address_t>              known_functions;
 		QSet<edb::address_t>              fuzzy_functions;
@@ -106,15 +177,105 @@ private:
 		QHash<edb::address_t, Function>   functions;
 		QHash<edb::address_t, BasicBlock> basic_blocks;
 			
-		QByteArray                        md5;
+		QByteArray                        md5;   // get_fingerprint of the region when it was analyzed
 		bool                              fuzzy;
 		IRegion::pointer                  region;
+
+		// the region's content while it is being analyzed
+		QVector<quint8>                   memory;
+
+		// [start, end) ranges of the region which hold code, where fuzzy
+		// analysis looks for calls
+		QVector<QPair<edb::address_t, edb::address_t> > code;
+
+		// [start, end) ranges edb has written to since the last analysis
+		QVector<QPair<edb::address_t, edb::address_t> > dirty;
+
+		// the functions sorted by entry, rebuilt after every analysis
+		QVector<FunctionRange>            function_index;
+
+		// what refers to what, sorted by target and then source. Taken from
+		// the decoded blocks and the pointers stored in the region
+		QVector<Reference>                references;
+
+		// built from the calls in <references>
+		CallGraph                         call_graph;
+
+		// bit n is set in <decoded> if the byte at start + n is part of a
+		// decoded instruction, and in <call_ends> if it is the last byte of a
+		// call, so telling a return address apart is a bit test
+		QBitArray                         decoded;
+		QBitArray                         call_ends;
+
+		// where the region's code calls or jumps to in other regions, with
+		// the jumps through pointers (import tables) followed
+		QSet<edb::address_t>              external_calls;
+	};
+
+	// the analysis of a module's region from before the process was restarted,
+	// along with the functions which were marked in it
+	struct RetiredAnalysis {
+		RegionData           data;
+		QSet<edb::address_t> specified_functions;
+	};
+
+	// [start, end) of the process before it was restarted is now at new_start
+	struct RegionMove {
+		edb::address_t start;
+		edb::address_t end;
+		edb::address_t new_start;
+	};
+
+	// an analysis whose functions are still being walked
+	struct PendingAnalysis {
+		RegionData                        data;
+		QSharedPointer<FunctionDiscovery> discovery;
+		QSharedPointer<AnalysisCache>     cache;
+		bool                              save;
+		int                               progress;
 	};
 
 	QMenu                             *menu_;
 	QHash<edb::address_t, RegionData>  analysis_info_;
+
+	// when each entry of analysis_info_ was last stored, so that the memory
+	// budget throws away the least recently analyzed regions first
+	QHash<edb::address_t, quint64>     analysis_order_;
+	quint64                            analysis_sequence_;
 	QSet<edb::address_t>               specified_functions_;
 	AnalyzerWidget                    *analyzer_widget_;
+
+	// what invalidate_for_restart put aside, by module_key, until the region
+	// is analyzed again. Addresses in the regions which have been taken back
+	// are moved by <restart_moves_>
+	QHash<QString, RetiredAnalysis>    retired_;
+	QVector<RegionMove>                restart_moves_;
+
+	// which of the analysis steps is running, so long steps can report how
+	// far through themselves they are
+	int                                analysis_step_;
+	int                                analysis_steps_;
+
+	// the starts of the regions being analyzed, if any. A cancel keeps what
+	// was found so far, a discard (the region was invalidated meanwhile)
+	// throws it away
+	QSet<edb::address_t>               analysis_regions_;
+	QSet<edb::address_t>               analysis_discarded_;
+	bool                               analysis_cancelled_;
+
+	// a trim asked for while an analysis was running, done once it is over
+	bool                               trim_pending_;
+	quint64                            trim_bytes_;
+
+	// off while benchmarking, so that every analysis is done from scratch
+	bool                               use_cache_;
+
+	// the walks of all regions analyzed together share these threads
+	QThreadPool                        analysis_pool_;
+
+	// the signature libraries, mapped the first time an analysis needs them
+	QList<SignatureLibrary *>          signatures_;
+	bool                               signatures_loaded_;
 };
 
 }
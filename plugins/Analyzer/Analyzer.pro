@@ -6,18 +6,31 @@ greaterThan(QT_MAJOR_VERSION, 4) {
 }
 
 HEADERS += \
+	AnalysisCache.h      \
 	Analyzer.h           \
 	AnalyzerWidget.h     \
+	CallGraph.h          \
+	CallScanner.h        \
+	FunctionDiscovery.h  \
 	OptionsPage.h        \
+	Signatures.h         \
 	SpecifiedFunctions.h
 	
 SOURCES += \
+	AnalysisCache.cpp      \
 	Analyzer.cpp           \
 	AnalyzerWidget.cpp     \
+	CallGraph.cpp          \
+	CallScanner.cpp        \
+	FunctionDiscovery.cpp  \
 	OptionsPage.cpp        \
+	Signatures.cpp         \
 	SpecifiedFunctions.cpp
 	
 FORMS += \
 	OptionsPage.ui        \
 	SpecifiedFunctions.ui
 
+graph {
+	DEFINES += ENABLE_GRAPH
+}
@@ -96,7 +96,9 @@ void AnalyzerWidget::paintEvent(QPaintEvent *event) {
 			} else {
 				if(QAbstractScrollArea *scroll_area = qobject_cast<QAbstractScrollArea*>(edb::v1::disassembly_widget())) {
 					if(QScrollBar *scrollbar = scroll_area->verticalScrollBar()) {
-						const int offset = (scrollbar->value()) * byte_width;
+						// the view may scale its scrollbar down for big regions, so
+						// only how far along it is means anything here
+						const int offset = static_cast<int>(static_cast<double>(scrollbar->value()) / (static_cast<double>(scrollbar->maximum()) + 1) * width());
 
 						const QString triangle(QChar(0x25b4));
 
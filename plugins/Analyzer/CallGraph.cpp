@@ -0,0 +1,182 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "CallGraph.h"
+#include "Instruction.h"
+#include "InstructionTextCache.h"
+#include "edb.h"
+
+#include <QSet>
+#include <QString>
+
+namespace Analyzer {
+
+namespace {
+
+//------------------------------------------------------------------------------
+// Name: node_name
+// Desc:
+//------------------------------------------------------------------------------
+QString node_name(edb::address_t address) {
+	return edb::v1::find_function_symbol(address, edb::v1::format_pointer(address));
+}
+
+//------------------------------------------------------------------------------
+// Name: quoted
+// Desc: <s> as a DOT double quoted string
+//------------------------------------------------------------------------------
+QByteArray quoted(const QString &s) {
+
+	QByteArray ret("\"");
+
+	Q_FOREACH(char ch, s.toUtf8()) {
+		switch(ch) {
+		case '"':
+		case '\\':
+			ret += '\\';
+			ret += ch;
+			break;
+		case '\n':
+			ret += "\\n";
+			break;
+		default:
+			ret += ch;
+			break;
+		}
+	}
+
+	ret += '"';
+	return ret;
+}
+
+//------------------------------------------------------------------------------
+// Name: block_label
+// Desc: the instructions of <block>, one left justified line each
+//------------------------------------------------------------------------------
+QByteArray block_label(const BasicBlock &block) {
+
+	QString text;
+	Q_FOREACH(const instruction_pointer &inst, block.instructions()) {
+		text += QString("%1: %2\n").arg(edb::v1::format_pointer(inst->rva())).arg(edb::v1::instruction_text_cache().format(*inst));
+	}
+
+	// graphviz ends left justified lines with "\l" rather than "\n"
+	QByteArray label = quoted(text);
+	label.replace("\\n", "\\l");
+	return label;
+}
+
+}
+
+//------------------------------------------------------------------------------
+// Name: call_graph_dot
+// Desc:
+//------------------------------------------------------------------------------
+QByteArray call_graph_dot(const IAnalyzer::CallGraph &graph) {
+
+	QByteArray ret("digraph calls {\n");
+	ret += "\tnode [shape=box];\n";
+
+	for(int i = 0; i < graph.nodes.size(); ++i) {
+		ret += QString("\tn%1 [label=%2];\n").arg(i).arg(QString::fromUtf8(quoted(node_name(graph.nodes[i])))).toUtf8();
+	}
+
+	for(int i = 0; i < graph.nodes.size(); ++i) {
+		for(int j = graph.offsets[i]; j < graph.offsets[i + 1]; ++j) {
+			ret += QString("\tn%1 -> n%2;\n").arg(i).arg(graph.edges[j]).toUtf8();
+		}
+	}
+
+	ret += "}\n";
+	return ret;
+}
+
+//------------------------------------------------------------------------------
+// Name: call_graph_json
+// Desc:
+//------------------------------------------------------------------------------
+QByteArray call_graph_json(const IAnalyzer::CallGraph &graph) {
+
+	QByteArray ret("{\n\t\"nodes\": [");
+
+	for(int i = 0; i < graph.nodes.size(); ++i) {
+		ret += (i == 0) ? "\n" : ",\n";
+		ret += QString("\t\t{ \"address\": \"%1\", \"name\": %2 }")
+			.arg(edb::v1::format_pointer(graph.nodes[i]))
+			.arg(edb::v1::json_string(node_name(graph.nodes[i]))).toUtf8();
+	}
+
+	ret += "\n\t],\n\t\"edges\": [";
+
+	bool first = true;
+	for(int i = 0; i < graph.nodes.size(); ++i) {
+		for(int j = graph.offsets[i]; j < graph.offsets[i + 1]; ++j) {
+			ret += first ? "\n" : ",\n";
+			ret += QString("\t\t[%1, %2]").arg(i).arg(graph.edges[j]).toUtf8();
+			first = false;
+		}
+	}
+
+	ret += "\n\t]\n}\n";
+	return ret;
+}
+
+//------------------------------------------------------------------------------
+// Name: function_graph_dot
+// Desc: taken branches are green, fall throughs red and unconditional edges blue
+//------------------------------------------------------------------------------
+QByteArray function_graph_dot(const Function &function) {
+
+	QByteArray ret("digraph flow {\n");
+	ret += "\tnode [shape=box fontname=\"monospace\"];\n";
+
+	QSet<edb::address_t> blocks;
+
+	for(Function::const_iterator it = function.begin(); it != function.end(); ++it) {
+		const BasicBlock &block = *it;
+		blocks.insert(block.first_address());
+		ret += QString("\tb%1 [label=").arg(block.first_address(), 0, 16).toUtf8();
+		ret += block_label(block);
+		ret += "];\n";
+	}
+
+	for(Function::const_iterator it = function.begin(); it != function.end(); ++it) {
+		const BasicBlock &block = *it;
+
+		for(BasicBlock::size_type i = 0; i < block.successor_count(); ++i) {
+			const edb::address_t to = block.successor(i);
+
+			// edges leaving the function (tail calls) aren't drawn
+			if(!blocks.contains(to)) {
+				continue;
+			}
+
+			const char *color = "blue";
+			if(block.successor_count() == 2) {
+				color = (i == 0) ? "green" : "red";
+			}
+
+			ret += QString("\tb%1 -> b%2 [color=%3];\n").arg(block.first_address(), 0, 16).arg(to, 0, 16).arg(color).toUtf8();
+		}
+	}
+
+	ret += "}\n";
+	return ret;
+}
+
+}
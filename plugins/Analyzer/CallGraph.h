@@ -0,0 +1,42 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef CALL_GRAPH_20261014_H_
+#define CALL_GRAPH_20261014_H_
+
+#include "IAnalyzer.h"
+#include "Function.h"
+#include <QByteArray>
+
+namespace Analyzer {
+
+// <graph> as a graphviz digraph, nodes are named after their function symbol
+// where there is one
+QByteArray call_graph_dot(const IAnalyzer::CallGraph &graph);
+
+// <graph> as { "nodes": [{ "address", "name" }...], "edges": [[from, to]...] }
+// where an edge refers to its nodes by index
+QByteArray call_graph_json(const IAnalyzer::CallGraph &graph);
+
+// the basic blocks of <function> as a graphviz digraph, each node listing its
+// block's instructions
+QByteArray function_graph_dot(const Function &function);
+
+}
+
+#endif
@@ -0,0 +1,163 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "CallScanner.h"
+#include <cstring>
+
+#if (defined(__i386__) || defined(__x86_64__)) && (defined(__clang__) || __GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))
+#define CALL_SCANNER_SIMD
+#include <immintrin.h>
+#endif
+
+namespace Analyzer {
+
+namespace {
+
+const quint8      CALL_REL32      = 0xe8;
+const std::size_t CALL_REL32_SIZE = 5;
+
+struct Range {
+	edb::address_t base;
+	edb::address_t low;
+	edb::address_t high;
+};
+
+//------------------------------------------------------------------------------
+// Name: check_candidate
+// Desc: the caller has made sure there is a whole rel32 after <offset>
+//------------------------------------------------------------------------------
+inline void check_candidate(const quint8 *first, std::size_t offset, const Range &range, QVector<std::size_t> *offsets) {
+
+	// x86 is little endian, so the bytes can be taken as they are
+	qint32 rel;
+	std::memcpy(&rel, first + offset + 1, sizeof(rel));
+
+	// the conversion sign extends, and wraps the same way the CPU would for
+	// 32-bit targets
+	const edb::address_t target = range.base + offset + CALL_REL32_SIZE + static_cast<edb::address_t>(rel);
+	if(target - range.low < range.high - range.low) {
+		offsets->push_back(offset);
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: scan_scalar
+// Desc:
+//------------------------------------------------------------------------------
+void scan_scalar(const quint8 *first, std::size_t from, std::size_t to, const Range &range, QVector<std::size_t> *offsets) {
+	for(std::size_t i = from; i < to; ++i) {
+		if(first[i] == CALL_REL32) {
+			check_candidate(first, i, range, offsets);
+		}
+	}
+}
+
+#ifdef CALL_SCANNER_SIMD
+
+//------------------------------------------------------------------------------
+// Name: check_mask
+// Desc: checks each chunk byte found to be 0xe8, lowest first
+//------------------------------------------------------------------------------
+inline void check_mask(const quint8 *first, std::size_t chunk, quint32 mask, const Range &range, QVector<std::size_t> *offsets) {
+	while(mask) {
+		check_candidate(first, chunk + __builtin_ctz(mask), range, offsets);
+		mask &= mask - 1;
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: scan_sse2
+// Desc: returns the offset it stopped at, the rest is left for scan_scalar
+//------------------------------------------------------------------------------
+__attribute__((target("sse2")))
+std::size_t scan_sse2(const quint8 *first, std::size_t to, const Range &range, QVector<std::size_t> *offsets) {
+
+	const __m128i needle = _mm_set1_epi8(static_cast<char>(CALL_REL32));
+
+	std::size_t i = 0;
+	for(; i + 16 <= to; i += 16) {
+		const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(first + i));
+		const quint32 mask  = static_cast<quint32>(_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, needle)));
+		check_mask(first, i, mask, range, offsets);
+	}
+
+	return i;
+}
+
+//------------------------------------------------------------------------------
+// Name: scan_avx2
+// Desc: returns the offset it stopped at, the rest is left for scan_scalar
+//------------------------------------------------------------------------------
+__attribute__((target("avx2")))
+std::size_t scan_avx2(const quint8 *first, std::size_t to, const Range &range, QVector<std::size_t> *offsets) {
+
+	const __m256i needle = _mm256_set1_epi8(static_cast<char>(CALL_REL32));
+
+	std::size_t i = 0;
+	for(; i + 32 <= to; i += 32) {
+		const __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(first + i));
+		const quint32 mask  = static_cast<quint32>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(bytes, needle)));
+		check_mask(first, i, mask, range, offsets);
+	}
+
+	return i;
+}
+
+#endif
+
+}
+
+//------------------------------------------------------------------------------
+// Name: find_call_candidates
+// Desc: <base> is the address of <first>, the offsets come out in order
+//------------------------------------------------------------------------------
+void find_call_candidates(const quint8 *first, const quint8 *last, edb::address_t base, edb::address_t low, edb::address_t high, QVector<std::size_t> *offsets) {
+
+	Q_ASSERT(offsets);
+
+	offsets->clear();
+
+	const std::size_t size = last - first;
+	if(size < CALL_REL32_SIZE || low >= high) {
+		return;
+	}
+
+	Range range;
+	range.base = base;
+	range.low  = low;
+	range.high = high;
+
+	// the last few bytes can't start a whole call, and leaving them out means
+	// every candidate has its rel32 in the buffer
+	const std::size_t to = size - CALL_REL32_SIZE + 1;
+
+	std::size_t i = 0;
+
+#ifdef CALL_SCANNER_SIMD
+	__builtin_cpu_init();
+	if(__builtin_cpu_supports("avx2")) {
+		i = scan_avx2(first, to, range, offsets);
+	} else if(__builtin_cpu_supports("sse2")) {
+		i = scan_sse2(first, to, range, offsets);
+	}
+#endif
+
+	scan_scalar(first, i, to, range, offsets);
+}
+
+}
@@ -0,0 +1,36 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef CALL_SCANNER_20261014_H_
+#define CALL_SCANNER_20261014_H_
+
+#include "Types.h"
+#include <QVector>
+#include <cstddef>
+
+namespace Analyzer {
+
+// finds the offsets into [first, last) of every 0xe8 byte which would make a
+// "call rel32" landing inside [low, high) if it were decoded there. This is
+// only a prefilter, every candidate still needs decoding to be sure. When the
+// CPU has it the search for 0xe8 bytes is done 16 or 32 bytes at a time
+void find_call_candidates(const quint8 *first, const quint8 *last, edb::address_t base, edb::address_t low, edb::address_t high, QVector<std::size_t> *offsets);
+
+}
+
+#endif
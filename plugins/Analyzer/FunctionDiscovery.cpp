@@ -0,0 +1,713 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "FunctionDiscovery.h"
+#include "Instruction.h"
+
+#include <QMutexLocker>
+#include <QRunnable>
+#include <QStack>
+#include <QThread>
+
+#include <algorithm>
+#include <climits>
+#include <cstring>
+
+namespace Analyzer {
+
+namespace {
+
+// a jump further than this from the start of the function it is in is taken
+// to be a tail call to another function rather than a branch within this one
+const edb::address_t FUNCTION_JUMP_DISTANCE = 0x2000;
+
+// the most entries a jump table is followed for, a bound bigger than this is
+// more likely a comparison which has nothing to do with a table
+const edb::address_t MAX_TABLE_ENTRIES = 1024;
+
+//------------------------------------------------------------------------------
+// Name: atomic_value
+// Desc: reads an atomic counter the same way on Qt4 and Qt5
+//------------------------------------------------------------------------------
+int atomic_value(QAtomicInt &value) {
+	return value.fetchAndAddOrdered(0);
+}
+
+//------------------------------------------------------------------------------
+// Name: jcc_condition
+// Desc: the condition code of a "jcc rel8" or "jcc rel32", -1 for the other
+//       conditional jumps (jcxz and the loops)
+//------------------------------------------------------------------------------
+int jcc_condition(const edb::Instruction &inst) {
+
+	const quint8 *const buf  = inst.bytes() + inst.prefix_size();
+	const std::size_t   size = inst.size() - inst.prefix_size();
+
+	if(size == 2 && (buf[0] & 0xf0) == 0x70) {
+		return buf[0] & 0x0f;
+	}
+
+	if(size > 2 && buf[0] == 0x0f && (buf[1] & 0xf0) == 0x80) {
+		return buf[1] & 0x0f;
+	}
+
+	return -1;
+}
+
+//------------------------------------------------------------------------------
+// Name: read_snapshot
+// Desc: copies <size> bytes at <address> out of <memory>, which holds the region
+//       starting at <base>. Returns false if they aren't all in it
+//------------------------------------------------------------------------------
+bool read_snapshot(const QVector<quint8> &memory, edb::address_t base, edb::address_t address, void *buffer, std::size_t size) {
+
+	const edb::address_t offset = address - base;
+	const edb::address_t length = memory.size();
+	if(address < base || offset >= length || size > length - offset) {
+		return false;
+	}
+
+	std::memcpy(buffer, memory.constData() + offset, size);
+	return true;
+}
+
+}
+
+// walks the function entries in its queue, decoding blocks into its own maps.
+// The owner of a queue pops from the back of it, thieves take from the front
+class FunctionDiscovery::Worker : public QRunnable {
+public:
+	explicit Worker(FunctionDiscovery *owner) : owner_(owner) {
+		setAutoDelete(false);
+	}
+
+public:
+	virtual void run() {
+		edb::address_t address;
+		while(owner_->next_function(this, &address)) {
+			walk(address);
+			owner_->function_done();
+		}
+		owner_->worker_finished();
+	}
+
+public:
+	void push(edb::address_t address) {
+		owner_->function_queued();
+		{
+			QMutexLocker locker(&lock_);
+			queue_.push_back(address);
+		}
+
+		if(atomic_value(owner_->idle_) != 0) {
+			QMutexLocker locker(&owner_->idle_lock_);
+			owner_->work_available_.wakeOne();
+		}
+	}
+
+	bool pop(edb::address_t *address) {
+		QMutexLocker locker(&lock_);
+		if(queue_.isEmpty()) {
+			return false;
+		}
+		*address = queue_.takeLast();
+		return true;
+	}
+
+	bool steal(edb::address_t *address) {
+		QMutexLocker locker(&lock_);
+		if(queue_.isEmpty()) {
+			return false;
+		}
+		*address = queue_.takeFirst();
+		return true;
+	}
+
+private:
+	void walk(edb::address_t function_address);
+	BasicBlock decode_block(edb::address_t function_address, edb::address_t block_address, QStack<edb::address_t> *blocks);
+	void bound_branch(int condition, edb::address_t limit, edb::address_t taken, edb::address_t fallthrough);
+	void follow_table(edb::address_t table, edb::address_t count, bool relative, QStack<edb::address_t> *blocks);
+	void follow_pointer(edb::address_t slot);
+
+public:
+	QHash<edb::address_t, BasicBlock> blocks_;
+	QHash<edb::address_t, Function>   functions_;
+	QHash<edb::address_t, int>        references_;
+
+private:
+	FunctionDiscovery     *owner_;
+	QMutex                 lock_;
+	QList<edb::address_t>  queue_;
+
+	// blocks which are only reached when a "cmp reg, imm" is in range, with
+	// how many entries a jump table indexed by reg can have there
+	QHash<edb::address_t, edb::address_t> bounds_;
+};
+
+//------------------------------------------------------------------------------
+// Name: walk
+// Desc: follows every block reachable from the function at <function_address>
+//       unless another visit to it already did
+//------------------------------------------------------------------------------
+void FunctionDiscovery::Worker::walk(edb::address_t function_address) {
+
+	if(!owner_->claim(function_address)) {
+		++references_[function_address];
+		return;
+	}
+
+	QStack<edb::address_t> blocks;
+	blocks.push(function_address);
+
+	Function func(function_address);
+
+	while(!blocks.empty()) {
+		const edb::address_t block_address = blocks.pop();
+
+		if(!blocks_.contains(block_address)) {
+			const BasicBlock block = decode_block(function_address, block_address, &blocks);
+			if(!block.empty()) {
+				blocks_.insert(block_address, block);
+
+				if(block_address >= function_address) {
+					func.insert(block);
+				}
+			}
+		}
+	}
+
+	if(!func.empty()) {
+		functions_.insert(function_address, func);
+		owner_->function_finished(function_address, func);
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: decode_block
+// Desc: decodes the block at <block_address> out of the snapshot, queueing the
+//       blocks and functions it leads to
+//------------------------------------------------------------------------------
+BasicBlock FunctionDiscovery::Worker::decode_block(edb::address_t function_address, edb::address_t block_address, QStack<edb::address_t> *blocks) {
+
+	const IRegion::pointer &region = owner_->region_;
+	const QVector<quint8>  &memory = owner_->memory_;
+
+	BasicBlock     block(memory, region->start());
+	edb::address_t address = block_address;
+
+	// what the block has done so far that a jump table or indirect call could
+	// be built on: a "cmp reg, imm" just before here, the last "lea reg, [addr]"
+	// and a "movsxd reg, [lea_reg + index * 4]" loading an entry of a PIC table
+	const edb::address_t   bound       = bounds_.value(block_address, 0);
+	bool                   compared    = false;
+	edb::address_t         limit       = 0;
+	edb::Operand::Register lea_reg     = edb::Operand::REG_NULL;
+	edb::address_t         lea_address = 0;
+	edb::Operand::Register entry_reg   = edb::Operand::REG_NULL;
+
+	while(region->contains(address)) {
+
+		const edb::address_t offset = address - region->start();
+		if(offset >= static_cast<edb::address_t>(memory.size())) {
+			break;
+		}
+
+		const quint8 *const first = memory.constData() + offset;
+		const quint8 *const last  = first + std::min<edb::address_t>(edb::Instruction::MAX_SIZE, memory.size() - offset);
+
+		const edb::Instruction inst(first, last, address, std::nothrow);
+		if(!inst) {
+			break;
+		}
+
+		block.push_back(inst);
+
+		const bool was_compared = compared;
+		compared = false;
+
+		if(is_call(inst)) {
+
+			// note the destination and move on
+			const edb::Operand &op = inst.operands()[0];
+			if(op.general_type() == edb::Operand::TYPE_REL) {
+				const edb::address_t ea = op.relative_target();
+
+				// skip over ones which are: "call <label>; label:"
+				if(ea != address + inst.size()) {
+					push(ea);
+
+					if(owner_->no_return_.contains(ea)) {
+						break;
+					}
+				}
+			} else if(op.general_type() == edb::Operand::TYPE_REGISTER) {
+				if(op.reg() == lea_reg && region->contains(lea_address)) {
+					push(lea_address);
+				}
+			} else {
+				edb::address_t slot;
+				if(fixed_address(inst, op, &slot)) {
+					follow_pointer(slot);
+				}
+			}
+		} else if(is_unconditional_jump(inst)) {
+
+			Q_ASSERT(inst.operand_count() == 1);
+			const edb::Operand &op = inst.operands()[0];
+
+			if(op.general_type() == edb::Operand::TYPE_REL) {
+				const edb::address_t ea = op.relative_target();
+				block.add_successor(ea);
+
+				if(owner_->is_claimed(ea)) {
+					++references_[ea];
+				} else if((ea - function_address) > FUNCTION_JUMP_DISTANCE) {
+					push(ea);
+				} else {
+					blocks->push(ea);
+				}
+			} else if(op.general_type() == edb::Operand::TYPE_EXPRESSION) {
+				edb::address_t slot;
+				if(fixed_address(inst, op, &slot)) {
+					// a thunk through a pointer ("jmp [got_entry]")
+					follow_pointer(slot);
+				} else if(bound != 0 && op.expression().base == edb::Operand::REG_NULL && op.expression().scale == sizeof(edb::address_t)) {
+					// "jmp [table + index * sizeof(void*)]"
+					follow_table(static_cast<edb::address_t>(op.displacement()), bound, false, blocks);
+				}
+			} else if(op.general_type() == edb::Operand::TYPE_REGISTER) {
+				if(bound != 0 && entry_reg != edb::Operand::REG_NULL && op.reg() == entry_reg) {
+					// "movsxd reg, [table + index * 4]; add reg, table; jmp reg"
+					follow_table(lea_address, bound, true, blocks);
+				}
+			}
+			break;
+		} else if(is_conditional_jump(inst)) {
+
+			Q_ASSERT(inst.operand_count() == 1);
+			const edb::Operand &op = inst.operands()[0];
+
+			if(op.general_type() == edb::Operand::TYPE_REL) {
+				block.add_successor(op.relative_target());
+				block.add_successor(address + inst.size());
+
+				if(was_compared) {
+					bound_branch(jcc_condition(inst), limit, op.relative_target(), address + inst.size());
+				}
+
+				blocks->push(op.relative_target());
+				blocks->push(address + inst.size());
+			}
+			break;
+		} else if(is_ret(inst) || inst.type() == edb::Instruction::OP_HLT) {
+			break;
+		} else if(inst.type() == edb::Instruction::OP_CMP) {
+			const edb::Operand &lhs = inst.operands()[0];
+			const edb::Operand &rhs = inst.operands()[1];
+			if(lhs.general_type() == edb::Operand::TYPE_REGISTER && rhs.general_type() == edb::Operand::TYPE_IMMEDIATE) {
+				limit    = static_cast<edb::address_t>(rhs.immediate());
+				compared = true;
+			}
+		} else if(inst.type() == edb::Instruction::OP_LEA) {
+			const edb::Operand &dst = inst.operands()[0];
+			edb::address_t ea;
+			if(dst.general_type() == edb::Operand::TYPE_REGISTER && fixed_address(inst, inst.operands()[1], &ea)) {
+				lea_reg     = dst.reg();
+				lea_address = ea;
+				entry_reg   = edb::Operand::REG_NULL;
+			}
+		} else if(inst.type() == edb::Instruction::OP_MOVSXD) {
+			const edb::Operand &dst = inst.operands()[0];
+			const edb::Operand &src = inst.operands()[1];
+			if(lea_reg != edb::Operand::REG_NULL && dst.general_type() == edb::Operand::TYPE_REGISTER && src.general_type() == edb::Operand::TYPE_EXPRESSION) {
+				if(src.expression().base == lea_reg && src.expression().index != edb::Operand::REG_NULL && src.expression().scale == 4) {
+					entry_reg = dst.reg();
+				}
+			}
+		}
+
+		address += inst.size();
+	}
+
+	return block;
+}
+
+//------------------------------------------------------------------------------
+// Name: bound_branch
+// Desc: after "cmp reg, <limit>" a jcc splits the values reg can have between
+//       its two successors, for the unsigned comparisons the one which sees
+//       only small values can index a table with that many entries
+//------------------------------------------------------------------------------
+void FunctionDiscovery::Worker::bound_branch(int condition, edb::address_t limit, edb::address_t taken, edb::address_t fallthrough) {
+
+	if(limit >= MAX_TABLE_ENTRIES) {
+		return;
+	}
+
+	switch(condition) {
+	case 0x02: // jb
+		bounds_.insert(taken, limit);
+		break;
+	case 0x03: // jae
+		bounds_.insert(fallthrough, limit);
+		break;
+	case 0x06: // jbe
+		bounds_.insert(taken, limit + 1);
+		break;
+	case 0x07: // ja
+		bounds_.insert(fallthrough, limit + 1);
+		break;
+	default:
+		break;
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: follow_table
+// Desc: queues the <count> targets of the jump table at <table> as blocks of the
+//       current function. Entries of a relative table are 32-bit offsets from
+//       the table itself, the others are plain pointers. Stops at the first
+//       entry which can't be read or doesn't point into the region
+//------------------------------------------------------------------------------
+void FunctionDiscovery::Worker::follow_table(edb::address_t table, edb::address_t count, bool relative, QStack<edb::address_t> *blocks) {
+
+	const IRegion::pointer &region = owner_->region_;
+	const QVector<quint8>  &memory = owner_->memory_;
+
+	for(edb::address_t i = 0; i < count; ++i) {
+		edb::address_t target;
+
+		if(relative) {
+			qint32 entry;
+			if(!read_snapshot(memory, region->start(), table + i * sizeof(entry), &entry, sizeof(entry))) {
+				break;
+			}
+			target = table + static_cast<edb::address_t>(entry);
+		} else {
+			if(!read_snapshot(memory, region->start(), table + i * sizeof(target), &target, sizeof(target))) {
+				break;
+			}
+		}
+
+		if(!region->contains(target)) {
+			break;
+		}
+
+		blocks->push(target);
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: follow_pointer
+// Desc: a call or jump through the pointer at <slot>, if the pointer is in the
+//       snapshot and leads back into the region its target is a function
+//------------------------------------------------------------------------------
+void FunctionDiscovery::Worker::follow_pointer(edb::address_t slot) {
+
+	const IRegion::pointer &region = owner_->region_;
+
+	edb::address_t target;
+	if(read_snapshot(owner_->memory_, region->start(), slot, &target, sizeof(target)) && region->contains(target)) {
+		push(target);
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: FunctionDiscovery
+// Desc: <memory> is the content of <region>, starting at its first byte
+//------------------------------------------------------------------------------
+FunctionDiscovery::FunctionDiscovery(const IRegion::pointer &region, const QVector<quint8> &memory, const QSet<edb::address_t> &no_return, QThreadPool *pool)
+	: region_(region), memory_(memory), no_return_(no_return), pool_(pool ? pool : &own_pool_), running_(0), pending_(0), idle_(0), queued_(0), done_(0), cancelled_(0) {
+
+	const int thread_count = qMax(1, QThread::idealThreadCount());
+	own_pool_.setMaxThreadCount(thread_count);
+
+	for(int i = 0; i < thread_count; ++i) {
+		workers_.push_back(new Worker(this));
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: ~FunctionDiscovery
+// Desc:
+//------------------------------------------------------------------------------
+FunctionDiscovery::~FunctionDiscovery() {
+	wait(-1);
+	qDeleteAll(workers_);
+}
+
+//------------------------------------------------------------------------------
+// Name: set_known_functions
+// Desc: functions which have been walked before and shouldn't be again, jumps
+//       to them still count as references. Only meaningful before start
+//------------------------------------------------------------------------------
+void FunctionDiscovery::set_known_functions(const QSet<edb::address_t> &functions) {
+	QMutexLocker locker(&claim_lock_);
+	claimed_ = functions;
+}
+
+//------------------------------------------------------------------------------
+// Name: start
+// Desc: deals <entries> out to the workers and sets them going
+//------------------------------------------------------------------------------
+void FunctionDiscovery::start(const QList<edb::address_t> &entries) {
+
+	for(int i = 0; i < entries.size(); ++i) {
+		workers_[i % workers_.size()]->push(entries[i]);
+	}
+
+	{
+		QMutexLocker locker(&running_lock_);
+		running_ = workers_.size();
+	}
+
+	Q_FOREACH(Worker *worker, workers_) {
+		pool_->start(worker);
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: cancel
+// Desc: workers stop once they finish the function they are on, whatever they
+//       have finished by then is still in the results
+//------------------------------------------------------------------------------
+void FunctionDiscovery::cancel() {
+	cancelled_.fetchAndStoreOrdered(1);
+
+	QMutexLocker locker(&idle_lock_);
+	work_available_.wakeAll();
+}
+
+//------------------------------------------------------------------------------
+// Name: take_finished
+// Desc: returns the functions finished since the last call
+//------------------------------------------------------------------------------
+QHash<edb::address_t, Function> FunctionDiscovery::take_finished() {
+	QHash<edb::address_t, Function> results;
+
+	QMutexLocker locker(&finished_lock_);
+	qSwap(results, finished_);
+	return results;
+}
+
+//------------------------------------------------------------------------------
+// Name: wait
+// Desc: returns true once every worker has finished, a negative <msecs> waits
+//       for as long as that takes
+//------------------------------------------------------------------------------
+bool FunctionDiscovery::wait(int msecs) {
+	QMutexLocker locker(&running_lock_);
+	while(running_ != 0) {
+		if(!all_finished_.wait(&running_lock_, msecs < 0 ? ULONG_MAX : static_cast<unsigned long>(msecs))) {
+			break;
+		}
+	}
+	return running_ == 0;
+}
+
+//------------------------------------------------------------------------------
+// Name: worker_finished
+// Desc:
+//------------------------------------------------------------------------------
+void FunctionDiscovery::worker_finished() {
+	QMutexLocker locker(&running_lock_);
+	if(--running_ == 0) {
+		all_finished_.wakeAll();
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: progress
+// Desc: how many percent of the entries found so far have been walked
+//------------------------------------------------------------------------------
+int FunctionDiscovery::progress() const {
+
+	const int queued = atomic_value(queued_);
+	const int done   = atomic_value(done_);
+
+	if(queued == 0) {
+		return 100;
+	}
+
+	return (done * 100) / queued;
+}
+
+//------------------------------------------------------------------------------
+// Name: results
+// Desc: merges what the workers found, only meaningful once wait has returned
+//       true
+//------------------------------------------------------------------------------
+void FunctionDiscovery::results(QHash<edb::address_t, BasicBlock> *basic_blocks, QHash<edb::address_t, Function> *functions) {
+
+	Q_ASSERT(basic_blocks);
+	Q_ASSERT(functions);
+
+	basic_blocks->clear();
+	functions->clear();
+
+	// every function is claimed by exactly one worker, blocks reached from
+	// functions on different workers decode the same so any copy will do
+	Q_FOREACH(Worker *worker, workers_) {
+		for(QHash<edb::address_t, Function>::const_iterator it = worker->functions_.begin(); it != worker->functions_.end(); ++it) {
+			functions->insert(it.key(), it.value());
+		}
+
+		for(QHash<edb::address_t, BasicBlock>::const_iterator it = worker->blocks_.begin(); it != worker->blocks_.end(); ++it) {
+			if(!basic_blocks->contains(it.key())) {
+				basic_blocks->insert(it.key(), it.value());
+			}
+		}
+	}
+
+	Q_FOREACH(Worker *worker, workers_) {
+		for(QHash<edb::address_t, int>::const_iterator it = worker->references_.begin(); it != worker->references_.end(); ++it) {
+			QHash<edb::address_t, Function>::iterator func = functions->find(it.key());
+			if(func != functions->end()) {
+				for(int i = 0; i < it.value(); ++i) {
+					func->add_reference();
+				}
+			}
+		}
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: claim
+// Desc: returns true if the caller is the first to take on <address>
+//------------------------------------------------------------------------------
+bool FunctionDiscovery::claim(edb::address_t address) {
+	QMutexLocker locker(&claim_lock_);
+	if(claimed_.contains(address)) {
+		return false;
+	}
+	claimed_.insert(address);
+	return true;
+}
+
+//------------------------------------------------------------------------------
+// Name: is_claimed
+// Desc:
+//------------------------------------------------------------------------------
+bool FunctionDiscovery::is_claimed(edb::address_t address) {
+	QMutexLocker locker(&claim_lock_);
+	return claimed_.contains(address);
+}
+
+//------------------------------------------------------------------------------
+// Name: next_function
+// Desc: finds <worker> another entry to walk, from its own queue if it can and
+//       by stealing otherwise. Returns false once there is no work left anywhere
+//------------------------------------------------------------------------------
+bool FunctionDiscovery::next_function(Worker *worker, edb::address_t *address) {
+
+	Q_ASSERT(address);
+
+	if(atomic_value(cancelled_) != 0) {
+		return false;
+	}
+
+	if(worker->pop(address)) {
+		return true;
+	}
+
+	idle_.ref();
+
+	Q_FOREVER {
+		if(atomic_value(cancelled_) != 0) {
+			idle_.deref();
+			return false;
+		}
+
+		Q_FOREACH(Worker *victim, workers_) {
+			if(victim != worker && victim->steal(address)) {
+				idle_.deref();
+				return true;
+			}
+		}
+
+		QMutexLocker locker(&idle_lock_);
+
+		// pending entries are only ever added by a worker which is busy, so
+		// once there are none and we are idle nothing can add more
+		if(atomic_value(pending_) == 0) {
+			work_available_.wakeAll();
+			idle_.deref();
+			return false;
+		}
+
+		// a timed wait, a push which misses the idle count still gets seen
+		work_available_.wait(&idle_lock_, 10);
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: function_queued
+// Desc:
+//------------------------------------------------------------------------------
+void FunctionDiscovery::function_queued() {
+	pending_.ref();
+	queued_.ref();
+}
+
+//------------------------------------------------------------------------------
+// Name: function_finished
+// Desc:
+//------------------------------------------------------------------------------
+void FunctionDiscovery::function_finished(edb::address_t address, const Function &function) {
+	QMutexLocker locker(&finished_lock_);
+	finished_.insert(address, function);
+}
+
+//------------------------------------------------------------------------------
+// Name: function_done
+// Desc:
+//------------------------------------------------------------------------------
+void FunctionDiscovery::function_done() {
+	done_.ref();
+	pending_.deref();
+}
+
+//------------------------------------------------------------------------------
+// Name: fixed_address
+// Desc:
+//------------------------------------------------------------------------------
+bool fixed_address(const edb::Instruction &inst, const edb::Operand &op, edb::address_t *address) {
+
+	if(op.general_type() != edb::Operand::TYPE_EXPRESSION || op.expression().index != edb::Operand::REG_NULL) {
+		return false;
+	}
+
+	if(op.expression().base == edb::Operand::REG_NULL) {
+		*address = static_cast<edb::address_t>(op.displacement());
+		return true;
+	}
+
+#if defined(EDB_X86_64)
+	if(op.expression().base == edb::Operand::REG_RIP) {
+		*address = inst.rva() + inst.size() + op.displacement();
+		return true;
+	}
+#else
+	Q_UNUSED(inst);
+#endif
+
+	return false;
+}
+
+}
@@ -0,0 +1,113 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef FUNCTION_DISCOVERY_20261014_H_
+#define FUNCTION_DISCOVERY_20261014_H_
+
+#include "BasicBlock.h"
+#include "Function.h"
+#include "IRegion.h"
+#include "Types.h"
+#include <QAtomicInt>
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QSet>
+#include <QThreadPool>
+#include <QVector>
+#include <QWaitCondition>
+
+namespace Analyzer {
+
+// true if <op> of <inst> is a memory operand whose address is known without
+// running anything ("[disp]" or "[rip + disp]"), which is stored in <address>
+bool fixed_address(const edb::Instruction &inst, const edb::Operand &op, edb::address_t *address);
+
+// follows calls and jumps out from a set of entry points to find the functions
+// and basic blocks of a region. The region is decoded out of a snapshot of its
+// memory by a pool of workers, each with its own queue of function entries to
+// walk. Idle workers steal from the others, and every worker keeps its own
+// blocks and functions until they are merged once all of them are done
+class FunctionDiscovery {
+public:
+	// the workers run on <pool> if there is one, so that several regions can
+	// be walked at once without each bringing a thread per core of its own
+	FunctionDiscovery(const IRegion::pointer &region, const QVector<quint8> &memory, const QSet<edb::address_t> &no_return, QThreadPool *pool = 0);
+	~FunctionDiscovery();
+
+public:
+	void set_known_functions(const QSet<edb::address_t> &functions);
+	void start(const QList<edb::address_t> &entries);
+	void cancel();
+	bool wait(int msecs);
+	int progress() const;
+	QHash<edb::address_t, Function> take_finished();
+	void results(QHash<edb::address_t, BasicBlock> *basic_blocks, QHash<edb::address_t, Function> *functions);
+
+private:
+	class Worker;
+	friend class Worker;
+
+private:
+	bool claim(edb::address_t address);
+	bool is_claimed(edb::address_t address);
+	bool next_function(Worker *worker, edb::address_t *address);
+	void function_queued();
+	void function_done();
+	void function_finished(edb::address_t address, const Function &function);
+	void worker_finished();
+
+private:
+	Q_DISABLE_COPY(FunctionDiscovery)
+
+private:
+	IRegion::pointer     region_;
+	QVector<quint8>      memory_;
+	QSet<edb::address_t> no_return_;
+	QList<Worker *>      workers_;
+	QThreadPool          own_pool_;
+	QThreadPool         *pool_;
+
+	// workers which have been started and haven't returned yet
+	QMutex               running_lock_;
+	QWaitCondition       all_finished_;
+	int                  running_;
+
+	// functions which some worker has taken on
+	QMutex               claim_lock_;
+	QSet<edb::address_t> claimed_;
+
+	// entries queued or being walked, when this reaches zero with every worker
+	// idle there is nothing left to find
+	QMutex               idle_lock_;
+	QWaitCondition       work_available_;
+	QAtomicInt           pending_;
+	QAtomicInt           idle_;
+	mutable QAtomicInt   queued_;
+	mutable QAtomicInt   done_;
+	QAtomicInt           cancelled_;
+
+	// functions walked since the last take_finished, so results can be shown
+	// before everything is done
+	QMutex                          finished_lock_;
+	QHash<edb::address_t, Function> finished_;
+};
+
+}
+
+#endif
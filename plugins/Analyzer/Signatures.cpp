@@ -0,0 +1,468 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Signatures.h"
+
+#include <QByteArray>
+#include <QDir>
+#include <QFileInfo>
+#include <QRunnable>
+#include <QStringList>
+#include <QTextStream>
+#include <QThread>
+#include <QThreadPool>
+
+#include <algorithm>
+#include <cstring>
+
+namespace Analyzer {
+
+namespace {
+
+const char          SIGNATURE_MAGIC[4]  = { 'E', 'D', 'B', 'S' };
+const quint32       SIGNATURE_VERSION   = 1;
+const int           PATTERN_SIZE        = 32;
+
+//------------------------------------------------------------------------------
+// Name: hex_value
+// Desc: the value of the hex digits in <text>, or -1 if it isn't all hex digits
+//------------------------------------------------------------------------------
+int hex_value(const QString &text) {
+	bool ok;
+	const int value = text.toInt(&ok, 16);
+	return ok ? value : -1;
+}
+
+}
+
+// the file starts with a Header, then come the sorted records, the records
+// starting with a wildcard and finally the names as NUL terminated strings.
+// Everything is little endian and laid out so that it can be used in place
+struct SignatureLibrary::Header {
+	char    magic[4];
+	quint32 version;
+	quint32 count;
+	quint32 loose_count;
+	quint32 names_size;
+};
+
+struct SignatureLibrary::Record {
+	quint32 key;              // the first four bytes of the pattern
+	quint32 wildcards;        // bit n set means byte n of the pattern is one
+	quint8  bytes[PATTERN_SIZE];
+	quint8  length;           // how many bytes of the pattern there are
+	quint8  reserved0;
+	quint16 tail_crc;         // CRC16 of the bytes after the pattern
+	quint16 tail_length;
+	quint16 reserved1;
+	quint32 function_length;
+	quint32 name;             // offset into the names
+};
+
+//------------------------------------------------------------------------------
+// Name: SignatureLibrary
+// Desc: maps <filename>, valid() is false if it isn't a signature library
+//------------------------------------------------------------------------------
+SignatureLibrary::SignatureLibrary(const QString &filename) : file_(filename), records_(0), names_(0), names_size_(0), count_(0), loose_count_(0) {
+
+	if(!file_.open(QIODevice::ReadOnly)) {
+		return;
+	}
+
+	const qint64 size = file_.size();
+	if(size < static_cast<qint64>(sizeof(Header))) {
+		return;
+	}
+
+	const uchar *const data = file_.map(0, size);
+	if(!data) {
+		return;
+	}
+
+	Header header;
+	std::memcpy(&header, data, sizeof(header));
+
+	if(std::memcmp(header.magic, SIGNATURE_MAGIC, sizeof(header.magic)) != 0 || header.version != SIGNATURE_VERSION) {
+		qDebug("[Analyzer] %s is not a signature library", qPrintable(filename));
+		return;
+	}
+
+	const quint64 records_size = (static_cast<quint64>(header.count) + header.loose_count) * sizeof(Record);
+	if(sizeof(Header) + records_size + header.names_size != static_cast<quint64>(size)) {
+		qDebug("[Analyzer] %s is truncated", qPrintable(filename));
+		return;
+	}
+
+	records_     = reinterpret_cast<const Record *>(data + sizeof(Header));
+	names_       = reinterpret_cast<const char *>(data + sizeof(Header) + records_size);
+	names_size_  = header.names_size;
+	count_       = header.count;
+	loose_count_ = header.loose_count;
+}
+
+//------------------------------------------------------------------------------
+// Name: ~SignatureLibrary
+// Desc:
+//------------------------------------------------------------------------------
+SignatureLibrary::~SignatureLibrary() {
+}
+
+//------------------------------------------------------------------------------
+// Name: crc16
+// Desc: the CRC16 FLIRT uses for the bytes following a pattern, so that .pat
+//       files made by the usual tools carry over as they are
+//------------------------------------------------------------------------------
+quint16 SignatureLibrary::crc16(const quint8 *p, std::size_t size) {
+
+	quint32 crc = 0xffff;
+
+	for(std::size_t i = 0; i < size; ++i) {
+		quint32 data = p[i];
+		for(int bit = 0; bit < 8; ++bit, data >>= 1) {
+			if((crc ^ data) & 1) {
+				crc = (crc >> 1) ^ 0x8408;
+			} else {
+				crc >>= 1;
+			}
+		}
+	}
+
+	crc = ~crc & 0xffff;
+	return static_cast<quint16>(((crc << 8) | (crc >> 8)) & 0xffff);
+}
+
+//------------------------------------------------------------------------------
+// Name: record_less
+// Desc:
+//------------------------------------------------------------------------------
+bool SignatureLibrary::record_less(const Record &lhs, const Record &rhs) {
+	return lhs.key < rhs.key;
+}
+
+//------------------------------------------------------------------------------
+// Name: key_less
+// Desc:
+//------------------------------------------------------------------------------
+bool SignatureLibrary::key_less(const Record &record, quint32 key) {
+	return record.key < key;
+}
+
+//------------------------------------------------------------------------------
+// Name: less_key
+// Desc:
+//------------------------------------------------------------------------------
+bool SignatureLibrary::less_key(quint32 key, const Record &record) {
+	return key < record.key;
+}
+
+//------------------------------------------------------------------------------
+// Name: matches
+// Desc: true if the function in [first, last) fits <record>
+//------------------------------------------------------------------------------
+bool SignatureLibrary::matches(const Record &record, const quint8 *first, const quint8 *last) const {
+
+	const std::size_t available = last - first;
+	if(record.length > available || record.length > PATTERN_SIZE) {
+		return false;
+	}
+
+	for(int i = 0; i < record.length; ++i) {
+		if(!(record.wildcards & (1u << i)) && first[i] != record.bytes[i]) {
+			return false;
+		}
+	}
+
+	if(record.tail_length != 0) {
+		if(record.length + static_cast<std::size_t>(record.tail_length) > available) {
+			return false;
+		}
+
+		if(crc16(first + record.length, record.tail_length) != record.tail_crc) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+//------------------------------------------------------------------------------
+// Name: match
+// Desc: the name of the signature the function in [first, last) matches, null
+//       if it matches none, or signatures of more than one name
+//------------------------------------------------------------------------------
+const char *SignatureLibrary::match(const quint8 *first, const quint8 *last) const {
+
+	if(!valid()) {
+		return 0;
+	}
+
+	const char *name = 0;
+	bool ambiguous   = false;
+
+	const Record *candidates_first = records_;
+	const Record *candidates_last  = records_;
+
+	if(last - first >= 4) {
+		quint32 key;
+		std::memcpy(&key, first, sizeof(key));
+		candidates_first = std::lower_bound(records_, records_ + count_, key, key_less);
+		candidates_last  = std::upper_bound(candidates_first, records_ + count_, key, less_key);
+	}
+
+	// the keyed candidates, then the ones which start with a wildcard
+	const Record *const ranges[2][2] = {
+		{ candidates_first, candidates_last },
+		{ records_ + count_, records_ + count_ + loose_count_ }
+	};
+
+	for(int r = 0; r < 2 && !ambiguous; ++r) {
+		for(const Record *record = ranges[r][0]; record != ranges[r][1]; ++record) {
+			if(record->name < names_size_ && matches(*record, first, last)) {
+				const char *const record_name = names_ + record->name;
+				if(name && std::strcmp(name, record_name) != 0) {
+					ambiguous = true;
+					break;
+				}
+				name = record_name;
+			}
+		}
+	}
+
+	return ambiguous ? 0 : name;
+}
+
+//------------------------------------------------------------------------------
+// Name: compile
+// Desc: turns a FLIRT .pat file into a signature library. Each line of one is
+//       "<pattern> <crc length> <crc> <function length> :<offset> <name> ..."
+//       where the pattern is hex with ".." for wildcard bytes, and the file
+//       ends with "---"
+//------------------------------------------------------------------------------
+bool SignatureLibrary::compile(const QString &pat_filename, const QString &sig_filename, QString *error) {
+
+	Q_ASSERT(error);
+
+	QFile pat(pat_filename);
+	if(!pat.open(QIODevice::ReadOnly | QIODevice::Text)) {
+		*error = pat.errorString();
+		return false;
+	}
+
+	QVector<Record> keyed;
+	QVector<Record> loose;
+	QByteArray      names;
+
+	QTextStream in(&pat);
+	int line_number = 0;
+
+	while(!in.atEnd()) {
+		const QString line = in.readLine().trimmed();
+		++line_number;
+
+		if(line == "---") {
+			break;
+		}
+
+		if(line.isEmpty()) {
+			continue;
+		}
+
+		const QStringList fields = line.split(' ', QString::SkipEmptyParts);
+		if(fields.size() < 6 || fields[0].size() % 2 != 0 || fields[0].size() > PATTERN_SIZE * 2) {
+			*error = QString("%1:%2: malformed signature").arg(pat_filename).arg(line_number);
+			return false;
+		}
+
+		Record record;
+		std::memset(&record, 0, sizeof(record));
+
+		const QString &pattern = fields[0];
+		record.length = pattern.size() / 2;
+
+		for(int i = 0; i < record.length; ++i) {
+			const QString byte = pattern.mid(i * 2, 2);
+			if(byte == "..") {
+				record.wildcards |= (1u << i);
+			} else {
+				const int value = hex_value(byte);
+				if(value < 0) {
+					*error = QString("%1:%2: malformed pattern").arg(pat_filename).arg(line_number);
+					return false;
+				}
+				record.bytes[i] = value;
+			}
+		}
+
+		const int tail_length     = hex_value(fields[1]);
+		const int tail_crc        = hex_value(fields[2]);
+		const int function_length = hex_value(fields[3]);
+		if(tail_length < 0 || tail_crc < 0 || function_length < 0) {
+			*error = QString("%1:%2: malformed signature").arg(pat_filename).arg(line_number);
+			return false;
+		}
+
+		record.tail_length     = tail_length;
+		record.tail_crc        = tail_crc;
+		record.function_length = function_length;
+
+		// the public names are ":<offset> <name>" pairs, the one at offset 0 is
+		// the function itself. Local ones are marked "@" and not wanted
+		QString name;
+		for(int i = 4; i + 1 < fields.size(); ++i) {
+			if(fields[i].startsWith(':') && !fields[i].endsWith('@') && hex_value(fields[i].mid(1)) == 0) {
+				name = fields[i + 1];
+				break;
+			}
+		}
+
+		if(name.isEmpty()) {
+			continue;
+		}
+
+		record.name = names.size();
+		names.append(name.toUtf8());
+		names.append('\0');
+
+		if(record.length >= 4 && (record.wildcards & 0x0f) == 0) {
+			std::memcpy(&record.key, record.bytes, sizeof(record.key));
+			keyed.push_back(record);
+		} else {
+			loose.push_back(record);
+		}
+	}
+
+	std::stable_sort(keyed.begin(), keyed.end(), record_less);
+
+	if(!QDir().mkpath(QFileInfo(sig_filename).absolutePath())) {
+		*error = QString("could not create %1").arg(QFileInfo(sig_filename).absolutePath());
+		return false;
+	}
+
+	QFile sig(sig_filename);
+	if(!sig.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+		*error = sig.errorString();
+		return false;
+	}
+
+	Header header;
+	std::memcpy(header.magic, SIGNATURE_MAGIC, sizeof(header.magic));
+	header.version     = SIGNATURE_VERSION;
+	header.count       = keyed.size();
+	header.loose_count = loose.size();
+	header.names_size  = names.size();
+
+	bool ok = sig.write(reinterpret_cast<const char *>(&header), sizeof(header)) == sizeof(header);
+	ok = ok && sig.write(reinterpret_cast<const char *>(keyed.constData()), keyed.size() * sizeof(Record)) == static_cast<qint64>(keyed.size() * sizeof(Record));
+	ok = ok && sig.write(reinterpret_cast<const char *>(loose.constData()), loose.size() * sizeof(Record)) == static_cast<qint64>(loose.size() * sizeof(Record));
+	ok = ok && sig.write(names) == names.size();
+
+	if(!ok) {
+		*error = sig.errorString();
+		sig.remove();
+		return false;
+	}
+
+	return true;
+}
+
+namespace {
+
+// matches one slice of the functions against every library
+class MatchTask : public QRunnable {
+public:
+	MatchTask(const QList<SignatureLibrary *> &libraries, const QVector<quint8> &memory, edb::address_t base, const QList<edb::address_t> &functions, int first, int last)
+		: libraries_(libraries), memory_(memory), base_(base), functions_(functions), first_(first), last_(last) {
+		setAutoDelete(false);
+	}
+
+public:
+	virtual void run() {
+		const quint8 *const memory_first = memory_.constData();
+		const quint8 *const memory_last  = memory_first + memory_.size();
+
+		for(int i = first_; i < last_; ++i) {
+			const edb::address_t address = functions_[i];
+			if(address < base_ || address - base_ >= static_cast<edb::address_t>(memory_.size())) {
+				continue;
+			}
+
+			const char *name = 0;
+			Q_FOREACH(const SignatureLibrary *library, libraries_) {
+				if((name = library->match(memory_first + (address - base_), memory_last))) {
+					break;
+				}
+			}
+
+			if(name) {
+				results.insert(address, QString::fromUtf8(name));
+			}
+		}
+	}
+
+public:
+	QHash<edb::address_t, QString> results;
+
+private:
+	const QList<SignatureLibrary *> &libraries_;
+	const QVector<quint8>           &memory_;
+	const edb::address_t             base_;
+	const QList<edb::address_t>     &functions_;
+	const int                        first_;
+	const int                        last_;
+};
+
+}
+
+//------------------------------------------------------------------------------
+// Name: match_signatures
+// Desc:
+//------------------------------------------------------------------------------
+QHash<edb::address_t, QString> match_signatures(const QList<SignatureLibrary *> &libraries, const QVector<quint8> &memory, edb::address_t base, const QList<edb::address_t> &functions) {
+
+	QHash<edb::address_t, QString> results;
+
+	if(libraries.isEmpty() || functions.isEmpty()) {
+		return results;
+	}
+
+	const int thread_count = qMax(1, QThread::idealThreadCount());
+	const int slice        = (functions.size() + thread_count - 1) / thread_count;
+
+	QThreadPool pool;
+	pool.setMaxThreadCount(thread_count);
+
+	QList<MatchTask *> tasks;
+	for(int first = 0; first < functions.size(); first += slice) {
+		MatchTask *const task = new MatchTask(libraries, memory, base, functions, first, qMin(first + slice, functions.size()));
+		tasks.push_back(task);
+		pool.start(task);
+	}
+
+	pool.waitForDone();
+
+	Q_FOREACH(MatchTask *task, tasks) {
+		for(QHash<edb::address_t, QString>::const_iterator it = task->results.begin(); it != task->results.end(); ++it) {
+			results.insert(it.key(), it.value());
+		}
+	}
+
+	qDeleteAll(tasks);
+	return results;
+}
+
+}
@@ -0,0 +1,82 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SIGNATURES_20261014_H_
+#define SIGNATURES_20261014_H_
+
+#include "Types.h"
+#include <QFile>
+#include <QHash>
+#include <QList>
+#include <QString>
+#include <QVector>
+
+namespace Analyzer {
+
+// a library of function signatures in the style of FLIRT: the first bytes of
+// a function, with the ones relocations touch left as wildcards, and a CRC16
+// of the bytes after them. The file is mapped and searched where it lies,
+// signatures are kept sorted by their first four bytes so finding the
+// candidates for a function is a binary search. Signatures which start with
+// a wildcard can't be sorted that way and are tried one by one
+class SignatureLibrary {
+public:
+	explicit SignatureLibrary(const QString &filename);
+	~SignatureLibrary();
+
+public:
+	static bool compile(const QString &pat_filename, const QString &sig_filename, QString *error);
+
+public:
+	bool valid() const         { return records_ != 0; }
+	QString filename() const   { return file_.fileName(); }
+	int size() const           { return count_ + loose_count_; }
+	const char *match(const quint8 *first, const quint8 *last) const;
+
+private:
+	struct Header;
+	struct Record;
+
+private:
+	static quint16 crc16(const quint8 *p, std::size_t size);
+	static bool record_less(const Record &lhs, const Record &rhs);
+	static bool key_less(const Record &record, quint32 key);
+	static bool less_key(quint32 key, const Record &record);
+	bool matches(const Record &record, const quint8 *first, const quint8 *last) const;
+
+private:
+	Q_DISABLE_COPY(SignatureLibrary)
+
+private:
+	QFile         file_;
+	const Record *records_;
+	const char   *names_;
+	quint32       names_size_;
+	quint32       count_;
+	quint32       loose_count_;
+};
+
+// names the <functions> of the region starting at <base>, whose content is
+// <memory>, which match a signature in one of <libraries>. The functions are
+// split up between a pool of threads. A function matching more than one name
+// gets none
+QHash<edb::address_t, QString> match_signatures(const QList<SignatureLibrary *> &libraries, const QVector<quint8> &memory, edb::address_t base, const QList<edb::address_t> &functions);
+
+}
+
+#endif
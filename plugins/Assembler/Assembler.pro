@@ -2,6 +2,6 @@
 include(../plugins.pri)
 
 # Input
-HEADERS += Assembler.h DialogAssembler.h OptionsPage.h
+HEADERS += Assembler.h DialogAssembler.h Encoder.h OptionsPage.h
 FORMS += DialogAssembler.ui OptionsPage.ui
-SOURCES += Assembler.cpp DialogAssembler.cpp OptionsPage.cpp
+SOURCES += Assembler.cpp DialogAssembler.cpp Encoder.cpp OptionsPage.cpp
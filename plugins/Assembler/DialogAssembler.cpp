@@ -17,6 +17,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
 #include "DialogAssembler.h"
+#include "Encoder.h"
 #include "IDebugger.h"
 #include "edb.h"
 #include "string_hash.h"
@@ -74,11 +75,30 @@ void DialogAssembler::set_address(edb::address_t address) {
 	}
 }
 
+namespace {
+
 //------------------------------------------------------------------------------
-// Name: on_buttonBox_accepted
-// Desc:
+// Name: cpu_bits
+// Desc: 32 or 64, for the kind of process being debugged
 //------------------------------------------------------------------------------
-void DialogAssembler::on_buttonBox_accepted() {
+int cpu_bits() {
+	switch(edb::v1::debugger_core->cpu_type()) {
+	case edb::string_hash<'x', '8', '6'>::value:
+		return 32;
+	case edb::string_hash<'x', '8', '6', '-', '6', '4'>::value:
+		return 64;
+	default:
+		Q_ASSERT(0);
+		return 0;
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: to_nasm_syntax
+// Desc: rewrites an instruction the way the disassembler shows it into
+//       something nasm and yasm accept, returns an empty string if it can't
+//------------------------------------------------------------------------------
+QString to_nasm_syntax(const QString &assembly) {
 
 	static const QString mnemonic_regex   = "([a-z][a-z0-9]*)";
 	static const QString register_regex   = "((?:(?:e|r)?(?:ax|bx|cx|dx|bp|sp|si|di|ip))|(?:[abcd](?:l|h))|(?:sp|bp|si|di)l|(?:[cdefgs]s)|(?:x?mm[0-7])|r(?:8|9|(?:1[0-5]))[dwb]?)";
@@ -106,12 +126,14 @@ void DialogAssembler::on_buttonBox_accepted() {
 // -------------------------
 // [((BASE(\+INDEX(\*SCALE)?)?(\+OFFSET)?)|((INDEX(\*SCALE)?)(\+OFFSET)?)|(OFFSET))]
 
+	// compiled once, this is only ever used from the UI thread
+	static QRegExp regex(assembly_regex, Qt::CaseInsensitive, QRegExp::RegExp2);
 
-	const QString assembly = ui->assembly->currentText().trimmed();
-	QRegExp regex(assembly_regex, Qt::CaseInsensitive, QRegExp::RegExp2);
+	if(!regex.exactMatch(assembly)) {
+		return QString();
+	}
 
-	if(regex.exactMatch(assembly)) {
-		const QStringList list = regex.capturedTexts();
+	const QStringList list = regex.capturedTexts();
 
 
 /*
@@ -167,142 +189,169 @@ void DialogAssembler::on_buttonBox_accepted() {
 [46] -> operand 3 displacement (EXPRESSION) (version 3)
 */
 
-		int operand_count = 0;
-		if(!list[2].isEmpty()) {
-			++operand_count;
-		}
+	int operand_count = 0;
+	if(!list[2].isEmpty()) {
+		++operand_count;
+	}
 
-		if(!list[17].isEmpty()) {
-			++operand_count;
-		}
+	if(!list[17].isEmpty()) {
+		++operand_count;
+	}
 
-		if(!list[32].isEmpty()) {
-			++operand_count;
-		}
+	if(!list[32].isEmpty()) {
+		++operand_count;
+	}
 
-		QStringList operands;
+	QStringList operands;
 
-		for(int i = 0; i < operand_count; ++i) {
+	for(int i = 0; i < operand_count; ++i) {
 
-			int offset = 15 * i;
+		int offset = 15 * i;
 
-			if(!list[3 + offset].isEmpty()) {
-				operands << list[3 + offset];
-			} else if(!list[4 + offset].isEmpty()) {
-				operands << list[4 + offset];
-			} else if(!list[5 + offset].isEmpty()) {
-				if(!list[7 + offset].isEmpty()) {
-					operands << QString("%1 [%2:%3]").arg(list[6 + offset], list[7 + offset], list[8 + offset]);
-				} else {
-					operands << QString("%1 [%2]").arg(list[6 + offset], list[8 + offset]);
-				}
+		if(!list[3 + offset].isEmpty()) {
+			operands << list[3 + offset];
+		} else if(!list[4 + offset].isEmpty()) {
+			operands << list[4 + offset];
+		} else if(!list[5 + offset].isEmpty()) {
+			if(!list[7 + offset].isEmpty()) {
+				operands << QString("%1 [%2:%3]").arg(list[6 + offset], list[7 + offset], list[8 + offset]);
+			} else {
+				operands << QString("%1 [%2]").arg(list[6 + offset], list[8 + offset]);
 			}
 		}
+	}
 
-		const QString nasm_syntax = list[1] + ' ' + operands.join(",");
+	return list[1] + ' ' + operands.join(",");
+}
 
-		QTemporaryFile source_file(QString("%1/edb_asm_temp_%2_XXXXXX.asm").arg(QDir::tempPath()).arg(getpid()));
-		if(!source_file.open()) {
-			QMessageBox::critical(this, tr("Error Creating File"), tr("Failed to create temporary source file."));
-			return;
-		}
+}
 
-		QTemporaryFile output_file(QString("%1/edb_asm_temp_%2_XXXXXX.bin").arg(QDir::tempPath()).arg(getpid()));
-		if(!output_file.open()) {
-			QMessageBox::critical(this, tr("Error Creating File"), tr("Failed to create temporary object file."));
-			return;
+//------------------------------------------------------------------------------
+// Name: assemble_external
+// Desc: assembles all of <lines> with the assembler from the options, in a
+//       single run of it
+//------------------------------------------------------------------------------
+bool DialogAssembler::assemble_external(const QStringList &lines, QByteArray *bytes) {
+
+	QStringList source;
+	Q_FOREACH(const QString &line, lines) {
+		const QString nasm_syntax = to_nasm_syntax(line);
+		if(nasm_syntax.isEmpty()) {
+			QMessageBox::warning(this, tr("Error In Code"), tr("Failed to assemble \"%1\".").arg(line));
+			return false;
 		}
+		source << nasm_syntax;
+	}
 
-		QSettings settings;
-		const QString assembler = settings.value("Assembler/helper_application", "/usr/bin/yasm").toString();
-		const QFile file(assembler);
-		if(assembler.isEmpty() || !file.exists()) {
-			QMessageBox::warning(this, tr("Couldn't Find Assembler"), tr("Failed to locate your assembler, please specify one in the options."));
-			return;
-		}
+	QTemporaryFile source_file(QString("%1/edb_asm_temp_%2_XXXXXX.asm").arg(QDir::tempPath()).arg(getpid()));
+	if(!source_file.open()) {
+		QMessageBox::critical(this, tr("Error Creating File"), tr("Failed to create temporary source file."));
+		return false;
+	}
 
-		const QFileInfo info(assembler);
+	QTemporaryFile output_file(QString("%1/edb_asm_temp_%2_XXXXXX.bin").arg(QDir::tempPath()).arg(getpid()));
+	if(!output_file.open()) {
+		QMessageBox::critical(this, tr("Error Creating File"), tr("Failed to create temporary object file."));
+		return false;
+	}
 
-		QProcess process;
-		QStringList arguments;
-		QString program(assembler);
+	QSettings settings;
+	const QString assembler = settings.value("Assembler/helper_application", "/usr/bin/yasm").toString();
+	const QFile file(assembler);
+	if(assembler.isEmpty() || !file.exists()) {
+		QMessageBox::warning(this, tr("Couldn't Find Assembler"), tr("Failed to locate your assembler, please specify one in the options."));
+		return false;
+	}
 
-		if(info.fileName() == "yasm") {
+	const QFileInfo info(assembler);
 
-			switch(edb::v1::debugger_core->cpu_type()) {
-			case edb::string_hash<'x', '8', '6'>::value:
-				source_file.write("[BITS 32]\n");
-				break;
-			case edb::string_hash<'x', '8', '6', '-', '6', '4'>::value:
-				source_file.write("[BITS 64]\n");
-				break;
-			default:
-				Q_ASSERT(0);
-			}
+	QProcess process;
+	QStringList arguments;
+	QString program(assembler);
 
-			source_file.write(QString("[SECTION .text vstart=0x%1 valign=1]\n\n").arg(edb::v1::format_pointer(address_)).toLatin1());
-			source_file.write(nasm_syntax.toLatin1());
-			source_file.write("\n");
-			source_file.close();
-
-			arguments << "-o" << output_file.fileName();
-			arguments << "-f" << "bin";
-			arguments << source_file.fileName();
-		} else if(info.fileName() == "nasm") {
-
-			switch(edb::v1::debugger_core->cpu_type()) {
-			case edb::string_hash<'x', '8', '6'>::value:
-				source_file.write("[BITS 32]\n");
-				break;
-			case edb::string_hash<'x', '8', '6', '-', '6', '4'>::value:
-				source_file.write("[BITS 64]\n");
-				break;
-			default:
-				Q_ASSERT(0);
-			}
+	source_file.write(QString("[BITS %1]\n").arg(cpu_bits()).toLatin1());
+
+	if(info.fileName() == "yasm") {
+		source_file.write(QString("[SECTION .text vstart=0x%1 valign=1]\n\n").arg(edb::v1::format_pointer(address_)).toLatin1());
+	} else if(info.fileName() == "nasm") {
+		source_file.write(QString("ORG 0x%1\n\n").arg(edb::v1::format_pointer(address_)).toLatin1());
+	}
+
+	source_file.write(source.join("\n").toLatin1());
+	source_file.write("\n");
+	source_file.close();
+
+	arguments << "-o" << output_file.fileName();
+	arguments << "-f" << "bin";
+	arguments << source_file.fileName();
+
+	process.start(program, arguments);
 
-			source_file.write(QString("ORG 0x%1\n\n").arg(edb::v1::format_pointer(address_)).toLatin1());
-			source_file.write(nasm_syntax.toLatin1());
-			source_file.write("\n");
-			source_file.close();
+	if(!process.waitForFinished()) {
+		return false;
+	}
+
+	if(process.exitCode() != 0) {
+		QMessageBox::warning(this, tr("Error In Code"), process.readAllStandardError());
+		return false;
+	}
 
+	*bytes = output_file.readAll();
+	return true;
+}
 
-			arguments << "-o" << output_file.fileName();
-			arguments << "-f" << "bin";
-			arguments << source_file.fileName();
+//------------------------------------------------------------------------------
+// Name: on_buttonBox_accepted
+// Desc: several instructions may be given at once, separated by ';'. They are
+//       encoded in process if they can be, otherwise all of them go to the
+//       external assembler together
+//------------------------------------------------------------------------------
+void DialogAssembler::on_buttonBox_accepted() {
+
+	QStringList lines;
+	Q_FOREACH(const QString &line, ui->assembly->currentText().split(';')) {
+		const QString trimmed = line.trimmed();
+		if(!trimmed.isEmpty()) {
+			lines << trimmed;
 		}
+	}
 
-		process.start(program, arguments);
+	if(lines.isEmpty()) {
+		return;
+	}
 
-		if(process.waitForFinished()) {
+	QByteArray bytes;
+	QString error;
 
-			const int exit_code = process.exitCode();
+	const Encoder encoder(cpu_bits());
+	if(!encoder.assemble(lines, address_, &bytes, &error)) {
+		QSettings settings;
+		const QString assembler = settings.value("Assembler/helper_application", "/usr/bin/yasm").toString();
+		if(assembler.isEmpty() || !QFile::exists(assembler)) {
+			QMessageBox::warning(this, tr("Error In Code"), error);
+			return;
+		}
 
-			if(exit_code != 0) {
-				QMessageBox::warning(this, tr("Error In Code"), process.readAllStandardError());
-			} else {
-				QByteArray bytes = output_file.readAll();
-
-				if(bytes.size() <= instruction_size_) {
-					if(ui->fillWithNOPs->isChecked()) {
-						// TODO: get system independent nop-code
-						edb::v1::modify_bytes(address_, instruction_size_, bytes, 0x90);
-					} else {
-						edb::v1::modify_bytes(address_, instruction_size_, bytes, 0x00);
-					}
-				} else {
-					if(ui->keepSize->isChecked()) {
-						QMessageBox::warning(this, tr("Error In Code"), tr("New instruction is too big to fit."));
-					} else {
-						edb::v1::modify_bytes(address_, bytes.size(), bytes, 0x00);
-					}
-				}
-			}
+		if(!assemble_external(lines, &bytes)) {
+			return;
 		}
-	} else {
-		QMessageBox::warning(this, tr("Error In Code"), tr("Failed to assembly the given assemble code."));
 	}
 
+	// all of it goes out in one write
+	if(bytes.size() <= instruction_size_) {
+		if(ui->fillWithNOPs->isChecked()) {
+			// TODO: get system independent nop-code
+			edb::v1::modify_bytes(address_, instruction_size_, bytes, 0x90);
+		} else {
+			edb::v1::modify_bytes(address_, instruction_size_, bytes, 0x00);
+		}
+	} else {
+		if(ui->keepSize->isChecked()) {
+			QMessageBox::warning(this, tr("Error In Code"), tr("New instruction is too big to fit."));
+		} else {
+			edb::v1::modify_bytes(address_, bytes.size(), bytes, 0x00);
+		}
+	}
 }
 
 }
@@ -20,6 +20,8 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #define DIALOG_ASSEMBLER_20130611_H_
 
 #include <QDialog>
+#include <QByteArray>
+#include <QStringList>
 #include "Types.h"
 #include "IRegion.h"
 
@@ -39,6 +41,9 @@ public Q_SLOTS:
 	
 public:
 	void set_address(edb::address_t address);
+
+private:
+	bool assemble_external(const QStringList &lines, QByteArray *bytes);
 	
 private:
 	 Ui::DialogAssembler *const ui;
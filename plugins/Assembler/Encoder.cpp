@@ -0,0 +1,1371 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Encoder.h"
+
+#include <cstring>
+
+namespace Assembler {
+
+namespace {
+
+enum {
+	HIGH_BYTE   = 1, // ah, ch, dh and bh, which can't be used with a REX prefix
+	NEEDS_REX   = 2, // spl, bpl, sil and dil, which can only be used with one
+	LONG_ONLY   = 4, // only exists in 64-bit mode
+	LEGACY_ONLY = 8  // only exists outside of 64-bit mode
+};
+
+struct RegisterName {
+	const char *name;
+	int         number;
+	int         size;
+	int         flags;
+};
+
+const RegisterName registers[] = {
+	{ "rax",  0, 8, LONG_ONLY }, { "rcx",  1, 8, LONG_ONLY }, { "rdx",  2, 8, LONG_ONLY }, { "rbx",  3, 8, LONG_ONLY },
+	{ "rsp",  4, 8, LONG_ONLY }, { "rbp",  5, 8, LONG_ONLY }, { "rsi",  6, 8, LONG_ONLY }, { "rdi",  7, 8, LONG_ONLY },
+	{ "r8",   8, 8, LONG_ONLY }, { "r9",   9, 8, LONG_ONLY }, { "r10", 10, 8, LONG_ONLY }, { "r11", 11, 8, LONG_ONLY },
+	{ "r12", 12, 8, LONG_ONLY }, { "r13", 13, 8, LONG_ONLY }, { "r14", 14, 8, LONG_ONLY }, { "r15", 15, 8, LONG_ONLY },
+
+	{ "eax",  0, 4, 0 },         { "ecx",  1, 4, 0 },         { "edx",  2, 4, 0 },         { "ebx",  3, 4, 0 },
+	{ "esp",  4, 4, 0 },         { "ebp",  5, 4, 0 },         { "esi",  6, 4, 0 },         { "edi",  7, 4, 0 },
+	{ "r8d",  8, 4, LONG_ONLY }, { "r9d",  9, 4, LONG_ONLY }, { "r10d", 10, 4, LONG_ONLY }, { "r11d", 11, 4, LONG_ONLY },
+	{ "r12d", 12, 4, LONG_ONLY }, { "r13d", 13, 4, LONG_ONLY }, { "r14d", 14, 4, LONG_ONLY }, { "r15d", 15, 4, LONG_ONLY },
+
+	{ "ax",   0, 2, 0 },         { "cx",   1, 2, 0 },         { "dx",   2, 2, 0 },         { "bx",   3, 2, 0 },
+	{ "sp",   4, 2, 0 },         { "bp",   5, 2, 0 },         { "si",   6, 2, 0 },         { "di",   7, 2, 0 },
+	{ "r8w",  8, 2, LONG_ONLY }, { "r9w",  9, 2, LONG_ONLY }, { "r10w", 10, 2, LONG_ONLY }, { "r11w", 11, 2, LONG_ONLY },
+	{ "r12w", 12, 2, LONG_ONLY }, { "r13w", 13, 2, LONG_ONLY }, { "r14w", 14, 2, LONG_ONLY }, { "r15w", 15, 2, LONG_ONLY },
+
+	{ "al",   0, 1, 0 },         { "cl",   1, 1, 0 },         { "dl",   2, 1, 0 },         { "bl",   3, 1, 0 },
+	{ "ah",   4, 1, HIGH_BYTE }, { "ch",   5, 1, HIGH_BYTE }, { "dh",   6, 1, HIGH_BYTE }, { "bh",   7, 1, HIGH_BYTE },
+	{ "spl",  4, 1, NEEDS_REX | LONG_ONLY }, { "bpl",  5, 1, NEEDS_REX | LONG_ONLY },
+	{ "sil",  6, 1, NEEDS_REX | LONG_ONLY }, { "dil",  7, 1, NEEDS_REX | LONG_ONLY },
+	{ "r8b",  8, 1, LONG_ONLY }, { "r9b",  9, 1, LONG_ONLY }, { "r10b", 10, 1, LONG_ONLY }, { "r11b", 11, 1, LONG_ONLY },
+	{ "r12b", 12, 1, LONG_ONLY }, { "r13b", 13, 1, LONG_ONLY }, { "r14b", 14, 1, LONG_ONLY }, { "r15b", 15, 1, LONG_ONLY }
+};
+
+struct SegmentName {
+	const char *name;
+	quint8      prefix;
+};
+
+const SegmentName segments[] = {
+	{ "es", 0x26 }, { "cs", 0x2e }, { "ss", 0x36 }, { "ds", 0x3e }, { "fs", 0x64 }, { "gs", 0x65 }
+};
+
+struct SizeName {
+	const char *name;
+	int         size;
+};
+
+const SizeName sizes[] = {
+	{ "byte", 1 }, { "word", 2 }, { "dword", 4 }, { "qword", 8 }
+};
+
+// instructions without operands
+struct Simple {
+	const char *name;
+	const char *bytes;
+	int         flags;
+};
+
+const Simple simple_instructions[] = {
+	{ "nop",      "\x90",         0 },
+	{ "ret",      "\xc3",         0 },
+	{ "retn",     "\xc3",         0 },
+	{ "int3",     "\xcc",         0 },
+	{ "hlt",      "\xf4",         0 },
+	{ "leave",    "\xc9",         0 },
+	{ "cbw",      "\x66\x98",     0 },
+	{ "cwde",     "\x98",         0 },
+	{ "cdqe",     "\x48\x98",     LONG_ONLY },
+	{ "cwd",      "\x66\x99",     0 },
+	{ "cdq",      "\x99",         0 },
+	{ "cqo",      "\x48\x99",     LONG_ONLY },
+	{ "pushf",    "\x9c",         0 },
+	{ "pushfd",   "\x9c",         LEGACY_ONLY },
+	{ "pushfq",   "\x9c",         LONG_ONLY },
+	{ "popf",     "\x9d",         0 },
+	{ "popfd",    "\x9d",         LEGACY_ONLY },
+	{ "popfq",    "\x9d",         LONG_ONLY },
+	{ "pusha",    "\x60",         LEGACY_ONLY },
+	{ "pushad",   "\x60",         LEGACY_ONLY },
+	{ "popa",     "\x61",         LEGACY_ONLY },
+	{ "popad",    "\x61",         LEGACY_ONLY },
+	{ "sahf",     "\x9e",         0 },
+	{ "lahf",     "\x9f",         0 },
+	{ "clc",      "\xf8",         0 },
+	{ "stc",      "\xf9",         0 },
+	{ "cmc",      "\xf5",         0 },
+	{ "cld",      "\xfc",         0 },
+	{ "std",      "\xfd",         0 },
+	{ "pause",    "\xf3\x90",     0 },
+	{ "syscall",  "\x0f\x05",     0 },
+	{ "sysenter", "\x0f\x34",     0 },
+	{ "cpuid",    "\x0f\xa2",     0 },
+	{ "rdtsc",    "\x0f\x31",     0 },
+	{ "ud2",      "\x0f\x0b",     0 },
+	{ "movsb",    "\xa4",         0 },
+	{ "movsw",    "\x66\xa5",     0 },
+	{ "movsd",    "\xa5",         0 },
+	{ "movsq",    "\x48\xa5",     LONG_ONLY },
+	{ "cmpsb",    "\xa6",         0 },
+	{ "cmpsw",    "\x66\xa7",     0 },
+	{ "cmpsd",    "\xa7",         0 },
+	{ "cmpsq",    "\x48\xa7",     LONG_ONLY },
+	{ "stosb",    "\xaa",         0 },
+	{ "stosw",    "\x66\xab",     0 },
+	{ "stosd",    "\xab",         0 },
+	{ "stosq",    "\x48\xab",     LONG_ONLY },
+	{ "lodsb",    "\xac",         0 },
+	{ "lodsw",    "\x66\xad",     0 },
+	{ "lodsd",    "\xad",         0 },
+	{ "lodsq",    "\x48\xad",     LONG_ONLY },
+	{ "scasb",    "\xae",         0 },
+	{ "scasw",    "\x66\xaf",     0 },
+	{ "scasd",    "\xaf",         0 },
+	{ "scasq",    "\x48\xaf",     LONG_ONLY }
+};
+
+struct Prefix {
+	const char *name;
+	quint8      byte;
+};
+
+const Prefix prefixes[] = {
+	{ "lock", 0xf0 }, { "rep", 0xf3 }, { "repe", 0xf3 }, { "repz", 0xf3 }, { "repne", 0xf2 }, { "repnz", 0xf2 }
+};
+
+struct Condition {
+	const char *name;
+	int         code;
+};
+
+const Condition conditions[] = {
+	{ "o",  0x0 }, { "no", 0x1 }, { "b",  0x2 }, { "c",   0x2 }, { "nae", 0x2 }, { "nb", 0x3 }, { "ae",  0x3 }, { "nc", 0x3 },
+	{ "e",  0x4 }, { "z",  0x4 }, { "ne", 0x5 }, { "nz",  0x5 }, { "be",  0x6 }, { "na", 0x6 }, { "nbe", 0x7 }, { "a",  0x7 },
+	{ "s",  0x8 }, { "ns", 0x9 }, { "p",  0xa }, { "pe",  0xa }, { "np",  0xb }, { "po", 0xb }, { "l",   0xc }, { "nge", 0xc },
+	{ "nl", 0xd }, { "ge", 0xd }, { "le", 0xe }, { "ng",  0xe }, { "nle", 0xf }, { "g",  0xf }
+};
+
+// the ALU group, numbered as the reg field of 80 to 83
+const char *const alu_names[8]   = { "add", "or", "adc", "sbb", "and", "sub", "xor", "cmp" };
+
+// the shift group, numbered as the reg field of C0, C1 and D0 to D3
+const char *const shift_names[8] = { "rol", "ror", "rcl", "rcr", "shl", "shr", "sal", "sar" };
+
+// the groups of F6/F7 and FE/FF with a single operand
+struct Unary {
+	const char *name;
+	quint8      opcode8;
+	quint8      opcode;
+	int         digit;
+};
+
+const Unary unary_instructions[] = {
+	{ "inc",  0xfe, 0xff, 0 },
+	{ "dec",  0xfe, 0xff, 1 },
+	{ "not",  0xf6, 0xf7, 2 },
+	{ "neg",  0xf6, 0xf7, 3 },
+	{ "mul",  0xf6, 0xf7, 4 },
+	{ "imul", 0xf6, 0xf7, 5 },
+	{ "div",  0xf6, 0xf7, 6 },
+	{ "idiv", 0xf6, 0xf7, 7 }
+};
+
+template <class T, std::size_t N>
+std::size_t array_size(const T (&)[N]) {
+	return N;
+}
+
+//------------------------------------------------------------------------------
+// Name: find_condition
+// Desc: the condition code of the suffix of a jcc, setcc or cmovcc
+//------------------------------------------------------------------------------
+int find_condition(const QString &suffix) {
+	for(std::size_t i = 0; i < array_size(conditions); ++i) {
+		if(suffix == QLatin1String(conditions[i].name)) {
+			return conditions[i].code;
+		}
+	}
+	return -1;
+}
+
+//------------------------------------------------------------------------------
+// Name: find_name
+// Desc: the index of <name> in <names>, or -1
+//------------------------------------------------------------------------------
+int find_name(const QString &name, const char *const (&names)[8]) {
+	for(int i = 0; i < 8; ++i) {
+		if(name == QLatin1String(names[i])) {
+			return i;
+		}
+	}
+	return -1;
+}
+
+//------------------------------------------------------------------------------
+// Name: parse_number
+// Desc: decimal, 0x prefixed or h suffixed hex, optionally negated
+//------------------------------------------------------------------------------
+bool parse_number(QString text, qint64 *value) {
+
+	text = text.trimmed();
+
+	bool negative = false;
+	if(text.startsWith(QLatin1Char('-'))) {
+		negative = true;
+		text = text.mid(1).trimmed();
+	} else if(text.startsWith(QLatin1Char('+'))) {
+		text = text.mid(1).trimmed();
+	}
+
+	if(text.isEmpty() || !text[0].isDigit()) {
+		return false;
+	}
+
+	bool ok;
+	quint64 n;
+	if(text.startsWith(QLatin1String("0x"))) {
+		n = text.mid(2).toULongLong(&ok, 16);
+	} else if(text.endsWith(QLatin1Char('h'))) {
+		n = text.left(text.size() - 1).toULongLong(&ok, 16);
+	} else {
+		n = text.toULongLong(&ok, 10);
+	}
+
+	if(!ok) {
+		return false;
+	}
+
+	*value = negative ? -static_cast<qint64>(n) : static_cast<qint64>(n);
+	return true;
+}
+
+//------------------------------------------------------------------------------
+// Name: fits
+// Desc: whether <value> can be written as a <size> byte operand, either
+//       signed or unsigned
+//------------------------------------------------------------------------------
+bool fits(qint64 value, int size) {
+	if(size >= 8) {
+		return true;
+	}
+
+	const int bits = size * 8;
+	return value >= -(Q_INT64_C(1) << (bits - 1)) && value < (Q_INT64_C(1) << bits);
+}
+
+//------------------------------------------------------------------------------
+// Name: fits_signed
+// Desc: whether <value> survives being truncated to <size> bytes and sign
+//       extended again
+//------------------------------------------------------------------------------
+bool fits_signed(qint64 value, int size) {
+	const int bits = size * 8;
+	return value >= -(Q_INT64_C(1) << (bits - 1)) && value < (Q_INT64_C(1) << (bits - 1));
+}
+
+//------------------------------------------------------------------------------
+// Name: normalize
+// Desc: <value> as the processor sees a <size> byte operand, sign extended
+//------------------------------------------------------------------------------
+qint64 normalize(qint64 value, int size) {
+	if(size >= 8) {
+		return value;
+	}
+
+	const int bits = size * 8;
+	const quint64 mask = (Q_UINT64_C(1) << bits) - 1;
+
+	quint64 v = static_cast<quint64>(value) & mask;
+	if(v & (Q_UINT64_C(1) << (bits - 1))) {
+		v |= ~mask;
+	}
+	return static_cast<qint64>(v);
+}
+
+//------------------------------------------------------------------------------
+// Name: append
+// Desc: <size> bytes of <value>, little endian
+//------------------------------------------------------------------------------
+void append(QByteArray *out, qint64 value, int size) {
+	for(int i = 0; i < size; ++i) {
+		out->append(static_cast<char>((static_cast<quint64>(value) >> (i * 8)) & 0xff));
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: branch_displacement
+// Desc: the displacement from the end of a <length> byte branch at <from> to
+//       <to>, wrapping around the address space as the processor does
+//------------------------------------------------------------------------------
+qint64 branch_displacement(quint64 to, quint64 from, int length, int bits) {
+	const quint64 diff = to - (from + length);
+	return (bits == 64) ? static_cast<qint64>(diff) : static_cast<qint64>(static_cast<qint32>(diff));
+}
+
+//------------------------------------------------------------------------------
+// Name: operand_size
+// Desc: the size of an instruction's operands, which are known from the
+//       registers and memory sizes and have to agree. 0 if they don't
+//------------------------------------------------------------------------------
+int operand_size(const Encoder::Operand &a, const Encoder::Operand &b, QString *error) {
+
+	const int size_a = (a.type == Encoder::Operand::IMMEDIATE) ? 0 : a.size;
+	const int size_b = (b.type == Encoder::Operand::IMMEDIATE) ? 0 : b.size;
+
+	if(size_a != 0 && size_b != 0 && size_a != size_b) {
+		*error = QString::fromLatin1("the operands aren't the same size");
+		return 0;
+	}
+
+	if(size_a == 0 && size_b == 0) {
+		*error = QString::fromLatin1("the operand size isn't known, say byte, word, dword or qword");
+		return 0;
+	}
+
+	return size_a ? size_a : size_b;
+}
+
+//------------------------------------------------------------------------------
+// Name: split_operands
+// Desc:
+//------------------------------------------------------------------------------
+QStringList split_operands(const QString &text) {
+
+	QStringList operands;
+
+	int depth = 0;
+	int start = 0;
+	for(int i = 0; i < text.size(); ++i) {
+		if(text[i] == QLatin1Char('[')) {
+			++depth;
+		} else if(text[i] == QLatin1Char(']')) {
+			--depth;
+		} else if(text[i] == QLatin1Char(',') && depth == 0) {
+			operands << text.mid(start, i - start).trimmed();
+			start = i + 1;
+		}
+	}
+
+	const QString last = text.mid(start).trimmed();
+	if(!last.isEmpty() || !operands.isEmpty()) {
+		operands << last;
+	}
+
+	return operands;
+}
+
+}
+
+//------------------------------------------------------------------------------
+// Name: Encoder
+// Desc: <bits> is 32 or 64
+//------------------------------------------------------------------------------
+Encoder::Encoder(int bits) : bits_(bits) {
+}
+
+//------------------------------------------------------------------------------
+// Name: assemble
+// Desc:
+//------------------------------------------------------------------------------
+bool Encoder::assemble(const QStringList &lines, edb::address_t address, QByteArray *bytes, QString *error) const {
+
+	Q_ASSERT(bytes);
+	Q_ASSERT(error);
+
+	QByteArray result;
+	Q_FOREACH(const QString &line, lines) {
+		if(line.trimmed().isEmpty()) {
+			continue;
+		}
+
+		QByteArray encoded;
+		if(!encode(line, address + result.size(), &encoded, error)) {
+			*error = QString::fromLatin1("%1: %2").arg(line.trimmed(), *error);
+			return false;
+		}
+		result += encoded;
+	}
+
+	*bytes = result;
+	return true;
+}
+
+//------------------------------------------------------------------------------
+// Name: parse_operand
+// Desc:
+//------------------------------------------------------------------------------
+bool Encoder::parse_operand(const QString &source, Operand *operand, QString *error) const {
+
+	std::memset(operand, 0, sizeof(*operand));
+	operand->base  = -1;
+	operand->index = -1;
+
+	QString text = source.trimmed();
+
+	// a size, as in "dword ptr [eax]"
+	for(std::size_t i = 0; i < array_size(sizes); ++i) {
+		const QString name = QLatin1String(sizes[i].name);
+		if(text.startsWith(name) && (text.size() == name.size() || !text[name.size()].isLetterOrNumber())) {
+			operand->size = sizes[i].size;
+			text = text.mid(name.size()).trimmed();
+			if(text.startsWith(QLatin1String("ptr")) && (text.size() == 3 || !text[3].isLetterOrNumber())) {
+				text = text.mid(3).trimmed();
+			}
+			break;
+		}
+	}
+
+	const int open = text.indexOf(QLatin1Char('['));
+	if(open == -1) {
+		if(operand->size != 0) {
+			*error = QString::fromLatin1("a size only goes with a memory operand");
+			return false;
+		}
+
+		for(std::size_t i = 0; i < array_size(registers); ++i) {
+			if(text == QLatin1String(registers[i].name)) {
+				if((registers[i].flags & LONG_ONLY) && bits_ != 64) {
+					*error = QString::fromLatin1("%1 only exists in 64-bit mode").arg(text);
+					return false;
+				}
+
+				operand->type      = Operand::REGISTER;
+				operand->reg       = registers[i].number;
+				operand->size      = registers[i].size;
+				operand->needs_rex = registers[i].flags & NEEDS_REX;
+				operand->high_byte = registers[i].flags & HIGH_BYTE;
+				return true;
+			}
+		}
+
+		if(parse_number(text, &operand->imm)) {
+			operand->type = Operand::IMMEDIATE;
+			return true;
+		}
+
+		*error = QString::fromLatin1("unknown operand \"%1\"").arg(text);
+		return false;
+	}
+
+	if(!text.endsWith(QLatin1Char(']'))) {
+		*error = QString::fromLatin1("missing ]");
+		return false;
+	}
+
+	operand->type = Operand::MEMORY;
+
+	// segment overrides go before the brackets or just inside them
+	QString segment = text.left(open).trimmed();
+	QString inside  = text.mid(open + 1, text.size() - open - 2).trimmed();
+
+	if(segment.isEmpty() && inside.size() > 3 && inside[2] == QLatin1Char(':')) {
+		segment = inside.left(3);
+		inside  = inside.mid(3).trimmed();
+	}
+
+	if(!segment.isEmpty()) {
+		if(segment.endsWith(QLatin1Char(':'))) {
+			segment.chop(1);
+		}
+
+		for(std::size_t i = 0; i < array_size(segments); ++i) {
+			if(segment.trimmed() == QLatin1String(segments[i].name)) {
+				operand->segment = segments[i].prefix;
+			}
+		}
+
+		if(!operand->segment) {
+			*error = QString::fromLatin1("unknown segment \"%1\"").arg(segment);
+			return false;
+		}
+	}
+
+	// terms separated by + and -, each a register, register*scale or number
+	int sign  = 1;
+	int start = 0;
+	for(int i = 0; i <= inside.size(); ++i) {
+		if(i != inside.size() && inside[i] != QLatin1Char('+') && inside[i] != QLatin1Char('-')) {
+			continue;
+		}
+
+		const QString term = inside.mid(start, i - start).trimmed();
+		const int next_sign = (i != inside.size() && inside[i] == QLatin1Char('-')) ? -1 : 1;
+		start = i + 1;
+
+		if(term.isEmpty()) {
+			if(i == 0) {
+				sign = next_sign;
+				continue;
+			}
+			*error = QString::fromLatin1("malformed address");
+			return false;
+		}
+
+		QString reg_text = term;
+		int scale = 1;
+
+		const int star = term.indexOf(QLatin1Char('*'));
+		if(star != -1) {
+			QString left  = term.left(star).trimmed();
+			QString right = term.mid(star + 1).trimmed();
+
+			qint64 n;
+			if(parse_number(right, &n)) {
+				reg_text = left;
+			} else if(parse_number(left, &n)) {
+				reg_text = right;
+			} else {
+				*error = QString::fromLatin1("malformed scale");
+				return false;
+			}
+
+			if(n != 1 && n != 2 && n != 4 && n != 8) {
+				*error = QString::fromLatin1("the scale must be 1, 2, 4 or 8");
+				return false;
+			}
+			scale = static_cast<int>(n);
+		}
+
+		qint64 n;
+		if(star == -1 && parse_number(term, &n)) {
+			operand->disp += sign * n;
+			sign = next_sign;
+			continue;
+		}
+
+		if(sign < 0) {
+			*error = QString::fromLatin1("registers can't be subtracted");
+			return false;
+		}
+
+		if(reg_text == QLatin1String("rip") || reg_text == QLatin1String("eip")) {
+			if(bits_ != 64 || star != -1 || operand->base != -1 || operand->index != -1 || operand->rip_relative) {
+				*error = QString::fromLatin1("rip can't be used like that");
+				return false;
+			}
+			operand->rip_relative = true;
+			operand->address_size = (reg_text == QLatin1String("rip")) ? 8 : 4;
+			sign = next_sign;
+			continue;
+		}
+
+		Operand reg;
+		if(!parse_operand(reg_text, &reg, error) || reg.type != Operand::REGISTER) {
+			*error = QString::fromLatin1("unknown register \"%1\"").arg(reg_text);
+			return false;
+		}
+
+		if(reg.size != 4 && reg.size != 8) {
+			*error = QString::fromLatin1("only 32 and 64-bit registers can be used in addresses");
+			return false;
+		}
+
+		if(operand->rip_relative || (operand->address_size != 0 && operand->address_size != reg.size)) {
+			*error = QString::fromLatin1("the registers of an address must all be the same size");
+			return false;
+		}
+		operand->address_size = reg.size;
+
+		if(star == -1 && operand->base == -1) {
+			operand->base = reg.reg;
+		} else if(operand->index == -1) {
+			operand->index = reg.reg;
+			operand->scale = scale;
+		} else {
+			*error = QString::fromLatin1("too many registers in address");
+			return false;
+		}
+
+		sign = next_sign;
+	}
+
+	// [esp] can't be an index, but [esp+eax] can be written the other way
+	if(operand->index == 4) {
+		if(operand->scale == 1 && operand->base != 4) {
+			qSwap(operand->index, operand->base);
+		} else {
+			*error = QString::fromLatin1("the stack pointer can't be an index");
+			return false;
+		}
+	}
+
+	return true;
+}
+
+//------------------------------------------------------------------------------
+// Name: emit_rm
+// Desc: the prefixes, <opcode> and ModRM (and whatever follows it) of an
+//       instruction with a <size> byte operand. <reg_field> is either the
+//       number of the register operand <reg>, or the opcode extension if
+//       <reg> is null. <default64> is for the instructions whose operand is
+//       64-bit in 64-bit mode without REX.W
+//------------------------------------------------------------------------------
+bool Encoder::emit_rm(QByteArray *out, int size, const QByteArray &opcode, int reg_field, const Operand *reg, const Operand &rm, bool default64, QString *error) const {
+
+	QByteArray prefix;
+	QByteArray tail;
+	quint8 rex       = 0;
+	bool force_rex   = false;
+	bool forbid_rex  = false;
+
+	if(rm.type == Operand::MEMORY) {
+		if(rm.segment) {
+			prefix += static_cast<char>(rm.segment);
+		}
+
+		if(bits_ == 64 && rm.address_size == 4) {
+			prefix += '\x67';
+		} else if(bits_ == 32 && rm.address_size == 8) {
+			*error = QString::fromLatin1("64-bit registers only exist in 64-bit mode");
+			return false;
+		}
+	}
+
+	if(size == 2) {
+		prefix += '\x66';
+	} else if(size == 8 && !default64) {
+		if(bits_ != 64) {
+			*error = QString::fromLatin1("64-bit operands only exist in 64-bit mode");
+			return false;
+		}
+		rex |= 0x48;
+	}
+
+	if(reg_field & 8) {
+		rex |= 0x44;
+	}
+
+	if(reg) {
+		force_rex  |= reg->needs_rex;
+		forbid_rex |= reg->high_byte;
+	}
+
+	if(rm.type == Operand::REGISTER) {
+		force_rex  |= rm.needs_rex;
+		forbid_rex |= rm.high_byte;
+
+		if(rm.reg & 8) {
+			rex |= 0x41;
+		}
+
+		tail += static_cast<char>(0xc0 | ((reg_field & 7) << 3) | (rm.reg & 7));
+	} else if(rm.type == Operand::MEMORY) {
+
+		const bool disp32_fits = (bits_ == 64) ? fits_signed(rm.disp, 4) : fits(rm.disp, 4);
+		if(!disp32_fits) {
+			*error = QString::fromLatin1("the displacement doesn't fit in 32 bits");
+			return false;
+		}
+
+		const quint8 reg_bits = (reg_field & 7) << 3;
+
+		if(rm.rip_relative) {
+			tail += static_cast<char>(0x05 | reg_bits);
+			append(&tail, rm.disp, 4);
+		} else if(rm.base == -1 && rm.index == -1) {
+			// in 64-bit mode the short form would be rip relative
+			if(bits_ == 64) {
+				tail += static_cast<char>(0x04 | reg_bits);
+				tail += '\x25';
+			} else {
+				tail += static_cast<char>(0x05 | reg_bits);
+			}
+			append(&tail, rm.disp, 4);
+		} else {
+			static const quint8 scales[9] = { 0, 0, 1, 0, 2, 0, 0, 0, 3 };
+
+			if(rm.index != -1 && (rm.index & 8)) {
+				rex |= 0x42;
+			}
+
+			if(rm.base != -1 && (rm.base & 8)) {
+				rex |= 0x41;
+			}
+
+			if(rm.base == -1) {
+				// just an index, which always has a 32-bit displacement
+				tail += static_cast<char>(0x04 | reg_bits);
+				tail += static_cast<char>((scales[rm.scale] << 6) | ((rm.index & 7) << 3) | 0x05);
+				append(&tail, rm.disp, 4);
+			} else {
+				int mod;
+				if(rm.disp == 0 && (rm.base & 7) != 5) {
+					mod = 0;
+				} else if(fits_signed(rm.disp, 1)) {
+					mod = 1;
+				} else {
+					mod = 2;
+				}
+
+				if(rm.index != -1 || (rm.base & 7) == 4) {
+					const int index = (rm.index != -1) ? rm.index : 4;
+					const int scale = (rm.index != -1) ? scales[rm.scale] : 0;
+					tail += static_cast<char>((mod << 6) | reg_bits | 0x04);
+					tail += static_cast<char>((scale << 6) | ((index & 7) << 3) | (rm.base & 7));
+				} else {
+					tail += static_cast<char>((mod << 6) | reg_bits | (rm.base & 7));
+				}
+
+				if(mod == 1) {
+					append(&tail, rm.disp, 1);
+				} else if(mod == 2) {
+					append(&tail, rm.disp, 4);
+				}
+			}
+		}
+	} else {
+		*error = QString::fromLatin1("expected a register or memory operand");
+		return false;
+	}
+
+	if(rex || force_rex) {
+		if(bits_ != 64) {
+			*error = QString::fromLatin1("that needs a REX prefix, which only exists in 64-bit mode");
+			return false;
+		}
+
+		if(forbid_rex) {
+			*error = QString::fromLatin1("ah, ch, dh and bh can't be used with a REX prefix");
+			return false;
+		}
+
+		rex |= 0x40;
+	}
+
+	*out += prefix;
+	if(rex) {
+		*out += static_cast<char>(rex);
+	}
+	*out += opcode;
+	*out += tail;
+	return true;
+}
+
+//------------------------------------------------------------------------------
+// Name: emit_plus_r
+// Desc: an instruction with the register in the low bits of the opcode
+//------------------------------------------------------------------------------
+bool Encoder::emit_plus_r(QByteArray *out, int size, quint8 opcode, const Operand &reg, bool default64, QString *error) const {
+
+	quint8 rex = 0;
+
+	if(size == 2) {
+		*out += '\x66';
+	} else if(size == 8 && !default64) {
+		rex |= 0x48;
+	}
+
+	if(reg.reg & 8) {
+		rex |= 0x41;
+	}
+
+	if(rex || reg.needs_rex) {
+		if(reg.high_byte) {
+			*error = QString::fromLatin1("ah, ch, dh and bh can't be used with a REX prefix");
+			return false;
+		}
+		*out += static_cast<char>(rex | 0x40);
+	}
+
+	*out += static_cast<char>(opcode + (reg.reg & 7));
+	return true;
+}
+
+//------------------------------------------------------------------------------
+// Name: emit_immediate
+// Desc:
+//------------------------------------------------------------------------------
+bool Encoder::emit_immediate(QByteArray *out, qint64 value, int size, QString *error) const {
+
+	if(!fits(value, size)) {
+		*error = QString::fromLatin1("the immediate doesn't fit in %1 bits").arg(size * 8);
+		return false;
+	}
+
+	append(out, value, size);
+	return true;
+}
+
+//------------------------------------------------------------------------------
+// Name: emit_branch
+// Desc: a relative jmp, call, jcc or loop to the absolute <target>, the
+//       short form is used where it reaches
+//------------------------------------------------------------------------------
+bool Encoder::emit_branch(QByteArray *out, const QString &mnemonic, const Operand &target, edb::address_t address, QString *error) const {
+
+	const quint64 mask = (bits_ == 64) ? ~Q_UINT64_C(0) : Q_UINT64_C(0xffffffff);
+
+	const quint64 to   = static_cast<quint64>(target.imm) & mask;
+	const quint64 from = static_cast<quint64>(address) & mask;
+
+	int short_opcode = -1;
+	QByteArray near_opcode;
+
+	if(mnemonic == QLatin1String("jmp")) {
+		short_opcode = 0xeb;
+		near_opcode  = "\xe9";
+	} else if(mnemonic == QLatin1String("call")) {
+		near_opcode  = "\xe8";
+	} else if(mnemonic == QLatin1String("loop")) {
+		short_opcode = 0xe2;
+	} else if(mnemonic == QLatin1String("loope") || mnemonic == QLatin1String("loopz")) {
+		short_opcode = 0xe1;
+	} else if(mnemonic == QLatin1String("loopne") || mnemonic == QLatin1String("loopnz")) {
+		short_opcode = 0xe0;
+	} else if(mnemonic == QLatin1String((bits_ == 64) ? "jrcxz" : "jecxz")) {
+		short_opcode = 0xe3;
+	} else {
+		const int cc = find_condition(mnemonic.mid(1));
+		if(!mnemonic.startsWith(QLatin1Char('j')) || cc == -1) {
+			*error = QString::fromLatin1("unknown branch \"%1\"").arg(mnemonic);
+			return false;
+		}
+		short_opcode = 0x70 + cc;
+		near_opcode  = QByteArray("\x0f", 1) + static_cast<char>(0x80 + cc);
+	}
+
+	if(short_opcode != -1) {
+		const qint64 disp = branch_displacement(to, from, 2, bits_);
+		if(fits_signed(disp, 1) || near_opcode.isEmpty()) {
+			if(!fits_signed(disp, 1)) {
+				*error = QString::fromLatin1("the target is out of reach of a short branch");
+				return false;
+			}
+			*out += static_cast<char>(short_opcode);
+			append(out, disp, 1);
+			return true;
+		}
+	}
+
+	const qint64 disp = branch_displacement(to, from, near_opcode.size() + 4, bits_);
+	if(!fits_signed(disp, 4)) {
+		*error = QString::fromLatin1("the target is out of reach of a relative branch");
+		return false;
+	}
+
+	*out += near_opcode;
+	append(out, disp, 4);
+	return true;
+}
+
+//------------------------------------------------------------------------------
+// Name: encode
+// Desc: a single instruction at <address>
+//------------------------------------------------------------------------------
+bool Encoder::encode(const QString &line, edb::address_t address, QByteArray *bytes, QString *error) const {
+
+	Q_ASSERT(bytes);
+	Q_ASSERT(error);
+
+	QString text = line.trimmed().toLower();
+	QByteArray out;
+	QString mnemonic;
+
+	// the mnemonic, after any prefixes
+	Q_FOREVER {
+		int end = 0;
+		while(end < text.size() && !text[end].isSpace()) {
+			++end;
+		}
+
+		mnemonic = text.left(end);
+		text     = text.mid(end).trimmed();
+
+		bool prefix = false;
+		for(std::size_t i = 0; i < array_size(prefixes); ++i) {
+			if(mnemonic == QLatin1String(prefixes[i].name)) {
+				out += static_cast<char>(prefixes[i].byte);
+				prefix = true;
+			}
+		}
+
+		if(!prefix || text.isEmpty()) {
+			break;
+		}
+	}
+
+	if(mnemonic.isEmpty()) {
+		*error = QString::fromLatin1("nothing to assemble");
+		return false;
+	}
+
+	const QStringList texts = split_operands(text);
+	if(texts.size() > 3) {
+		*error = QString::fromLatin1("too many operands");
+		return false;
+	}
+
+	Operand ops[3];
+	for(int i = 0; i < 3; ++i) {
+		if(i < texts.size()) {
+			if(!parse_operand(texts[i], &ops[i], error)) {
+				return false;
+			}
+		} else {
+			std::memset(&ops[i], 0, sizeof(ops[i]));
+			ops[i].type = Operand::NONE;
+		}
+	}
+
+	const int n             = texts.size();
+	const int native        = bits_ / 8;
+	const Operand &dst      = ops[0];
+	const Operand &src      = ops[1];
+	const bool dst_is_rm    = dst.type == Operand::REGISTER || dst.type == Operand::MEMORY;
+	const bool src_is_reg   = src.type == Operand::REGISTER;
+
+	// instructions without operands
+	if(n == 0) {
+		for(std::size_t i = 0; i < array_size(simple_instructions); ++i) {
+			const Simple &simple = simple_instructions[i];
+			if(mnemonic == QLatin1String(simple.name)) {
+				if(((simple.flags & LONG_ONLY) && bits_ != 64) || ((simple.flags & LEGACY_ONLY) && bits_ == 64)) {
+					*error = QString::fromLatin1("%1 doesn't exist in %2-bit mode").arg(mnemonic).arg(bits_);
+					return false;
+				}
+				out += QByteArray(simple.bytes);
+				*bytes = out;
+				return true;
+			}
+		}
+	}
+
+	if(n == 1 && dst.type == Operand::IMMEDIATE) {
+		if(mnemonic == QLatin1String("ret") || mnemonic == QLatin1String("retn")) {
+			out += '\xc2';
+			if(!emit_immediate(&out, dst.imm, 2, error)) {
+				return false;
+			}
+			*bytes = out;
+			return true;
+		}
+
+		if(mnemonic == QLatin1String("int")) {
+			if(dst.imm == 3) {
+				out += '\xcc';
+			} else {
+				out += '\xcd';
+				if(!emit_immediate(&out, dst.imm, 1, error)) {
+					return false;
+				}
+			}
+			*bytes = out;
+			return true;
+		}
+
+		if(mnemonic.startsWith(QLatin1Char('j')) || mnemonic == QLatin1String("call") || mnemonic.startsWith(QLatin1String("loop"))) {
+			if(!emit_branch(&out, mnemonic, dst, address + out.size(), error)) {
+				return false;
+			}
+			*bytes = out;
+			return true;
+		}
+	}
+
+	// indirect jumps and calls
+	if(n == 1 && dst_is_rm && (mnemonic == QLatin1String("jmp") || mnemonic == QLatin1String("call"))) {
+		if(dst.size != 0 && dst.size != native) {
+			*error = QString::fromLatin1("the target must be %1-bit").arg(bits_);
+			return false;
+		}
+		if(!emit_rm(&out, native, QByteArray("\xff"), (mnemonic == QLatin1String("jmp")) ? 4 : 2, 0, dst, true, error)) {
+			return false;
+		}
+		*bytes = out;
+		return true;
+	}
+
+	if(n == 1 && (mnemonic == QLatin1String("push") || mnemonic == QLatin1String("pop"))) {
+		const bool push = mnemonic == QLatin1String("push");
+
+		if(dst.type == Operand::IMMEDIATE) {
+			if(!push) {
+				*error = QString::fromLatin1("an immediate can't be popped");
+				return false;
+			}
+
+			if(!fits(dst.imm, 4)) {
+				*error = QString::fromLatin1("the immediate doesn't fit in 32 bits");
+				return false;
+			}
+
+			if(fits_signed(normalize(dst.imm, 4), 1)) {
+				out += '\x6a';
+				append(&out, dst.imm, 1);
+			} else {
+				out += '\x68';
+				append(&out, dst.imm, 4);
+			}
+			*bytes = out;
+			return true;
+		}
+
+		const int size = dst.size ? dst.size : native;
+		if(size != 2 && size != native) {
+			*error = QString::fromLatin1("only 16 and %1-bit operands can be pushed and popped").arg(bits_);
+			return false;
+		}
+
+		if(dst.type == Operand::REGISTER) {
+			if(!emit_plus_r(&out, size, push ? 0x50 : 0x58, dst, true, error)) {
+				return false;
+			}
+		} else if(!emit_rm(&out, size, QByteArray(push ? "\xff" : "\x8f"), push ? 6 : 0, 0, dst, true, error)) {
+			return false;
+		}
+
+		*bytes = out;
+		return true;
+	}
+
+	if(n == 2 && mnemonic == QLatin1String("mov") && dst_is_rm) {
+		const int size = operand_size(dst, src, error);
+		if(!size) {
+			return false;
+		}
+
+		if(src.type == Operand::IMMEDIATE) {
+			if(!fits(src.imm, size)) {
+				*error = QString::fromLatin1("the immediate doesn't fit in %1 bits").arg(size * 8);
+				return false;
+			}
+
+			if(dst.type == Operand::REGISTER && !(size == 8 && fits_signed(src.imm, 4))) {
+				if(!emit_plus_r(&out, size, (size == 1) ? 0xb0 : 0xb8, dst, false, error)) {
+					return false;
+				}
+				append(&out, src.imm, size);
+			} else {
+				if(size == 8 && !fits_signed(src.imm, 4)) {
+					*error = QString::fromLatin1("a 64-bit immediate can only be moved into a register");
+					return false;
+				}
+				if(!emit_rm(&out, size, QByteArray((size == 1) ? "\xc6" : "\xc7"), 0, 0, dst, false, error)) {
+					return false;
+				}
+				append(&out, src.imm, qMin(size, 4));
+			}
+		} else if(src_is_reg) {
+			if(!emit_rm(&out, size, QByteArray((size == 1) ? "\x88" : "\x89"), src.reg, &src, dst, false, error)) {
+				return false;
+			}
+		} else if(dst.type == Operand::REGISTER) {
+			if(!emit_rm(&out, size, QByteArray((size == 1) ? "\x8a" : "\x8b"), dst.reg, &dst, src, false, error)) {
+				return false;
+			}
+		} else {
+			*error = QString::fromLatin1("memory can't be moved to memory");
+			return false;
+		}
+
+		*bytes = out;
+		return true;
+	}
+
+	if(n == 2 && mnemonic == QLatin1String("lea")) {
+		if(dst.type != Operand::REGISTER || src.type != Operand::MEMORY || dst.size == 1) {
+			*error = QString::fromLatin1("lea needs a register and an address");
+			return false;
+		}
+
+		if(!emit_rm(&out, dst.size, QByteArray("\x8d"), dst.reg, &dst, src, false, error)) {
+			return false;
+		}
+		*bytes = out;
+		return true;
+	}
+
+	const int alu = find_name(mnemonic, alu_names);
+	const bool is_test = mnemonic == QLatin1String("test");
+	if(n == 2 && (alu != -1 || is_test) && dst_is_rm) {
+		const int size = operand_size(dst, src, error);
+		if(!size) {
+			return false;
+		}
+
+		// al, ax, eax and rax have shorter forms for a full sized immediate
+		const bool accumulator = dst.type == Operand::REGISTER && dst.reg == 0 && !dst.high_byte;
+
+		if(src.type == Operand::IMMEDIATE) {
+			if(!fits(src.imm, size) || (size == 8 && !fits_signed(src.imm, 4))) {
+				*error = QString::fromLatin1("the immediate doesn't fit in %1 bits").arg((size == 8) ? 32 : size * 8);
+				return false;
+			}
+
+			if(accumulator && (is_test || size == 1 || !fits_signed(normalize(src.imm, size), 1))) {
+				const quint8 opcode = is_test ? 0xa8 : static_cast<quint8>(alu * 8 + 4);
+				if(!emit_plus_r(&out, size, opcode + ((size == 1) ? 0 : 1), dst, false, error)) {
+					return false;
+				}
+				append(&out, src.imm, qMin(size, 4));
+			} else if(is_test) {
+				if(!emit_rm(&out, size, QByteArray((size == 1) ? "\xf6" : "\xf7"), 0, 0, dst, false, error)) {
+					return false;
+				}
+				append(&out, src.imm, qMin(size, 4));
+			} else if(size == 1) {
+				if(!emit_rm(&out, size, QByteArray("\x80"), alu, 0, dst, false, error)) {
+					return false;
+				}
+				append(&out, src.imm, 1);
+			} else if(fits_signed(normalize(src.imm, size), 1)) {
+				if(!emit_rm(&out, size, QByteArray("\x83"), alu, 0, dst, false, error)) {
+					return false;
+				}
+				append(&out, src.imm, 1);
+			} else {
+				if(!emit_rm(&out, size, QByteArray("\x81"), alu, 0, dst, false, error)) {
+					return false;
+				}
+				append(&out, src.imm, qMin(size, 4));
+			}
+		} else if(src_is_reg) {
+			const quint8 opcode = is_test ? 0x84 : static_cast<quint8>(alu * 8);
+			if(!emit_rm(&out, size, QByteArray(1, static_cast<char>(opcode + ((size == 1) ? 0 : 1))), src.reg, &src, dst, false, error)) {
+				return false;
+			}
+		} else if(dst.type == Operand::REGISTER && !is_test) {
+			if(!emit_rm(&out, size, QByteArray(1, static_cast<char>(alu * 8 + ((size == 1) ? 2 : 3))), dst.reg, &dst, src, false, error)) {
+				return false;
+			}
+		} else if(dst.type == Operand::REGISTER && is_test) {
+			if(!emit_rm(&out, size, QByteArray((size == 1) ? "\x84" : "\x85"), dst.reg, &dst, src, false, error)) {
+				return false;
+			}
+		} else {
+			*error = QString::fromLatin1("memory can't be combined with memory");
+			return false;
+		}
+
+		*bytes = out;
+		return true;
+	}
+
+	if(n == 2 && mnemonic == QLatin1String("xchg") && dst_is_rm && src.type != Operand::IMMEDIATE) {
+		const int size = operand_size(dst, src, error);
+		if(!size) {
+			return false;
+		}
+
+		const Operand &reg = src_is_reg ? src : dst;
+		const Operand &rm  = src_is_reg ? dst : src;
+		if(reg.type != Operand::REGISTER) {
+			*error = QString::fromLatin1("memory can't be exchanged with memory");
+			return false;
+		}
+
+		// with the accumulator the other register goes in the opcode, except
+		// that 90 is a nop rather than zero extending eax in 64-bit mode
+		const bool accumulator = rm.type == Operand::REGISTER && size != 1 && (reg.reg == 0 || rm.reg == 0);
+		if(accumulator && !(bits_ == 64 && size == 4 && reg.reg == 0 && rm.reg == 0)) {
+			if(!emit_plus_r(&out, size, 0x90, (reg.reg == 0) ? rm : reg, false, error)) {
+				return false;
+			}
+		} else if(!emit_rm(&out, size, QByteArray((size == 1) ? "\x86" : "\x87"), reg.reg, &reg, rm, false, error)) {
+			return false;
+		}
+		*bytes = out;
+		return true;
+	}
+
+	const int shift = find_name(mnemonic, shift_names);
+	if((n == 1 || n == 2) && shift != -1 && dst_is_rm) {
+		// sal is another name for shl
+		const int digit = (shift == 6) ? 4 : shift;
+		const int size  = dst.size;
+		if(!size) {
+			*error = QString::fromLatin1("the operand size isn't known, say byte, word, dword or qword");
+			return false;
+		}
+
+		if(n == 1 || (src.type == Operand::IMMEDIATE && src.imm == 1)) {
+			if(!emit_rm(&out, size, QByteArray((size == 1) ? "\xd0" : "\xd1"), digit, 0, dst, false, error)) {
+				return false;
+			}
+		} else if(src.type == Operand::REGISTER && src.size == 1 && src.reg == 1 && !src.high_byte) {
+			if(!emit_rm(&out, size, QByteArray((size == 1) ? "\xd2" : "\xd3"), digit, 0, dst, false, error)) {
+				return false;
+			}
+		} else if(src.type == Operand::IMMEDIATE) {
+			if(!emit_rm(&out, size, QByteArray((size == 1) ? "\xc0" : "\xc1"), digit, 0, dst, false, error)) {
+				return false;
+			}
+			if(!emit_immediate(&out, src.imm, 1, error)) {
+				return false;
+			}
+		} else {
+			*error = QString::fromLatin1("the shift count must be an immediate or cl");
+			return false;
+		}
+
+		*bytes = out;
+		return true;
+	}
+
+	// the long nops
+	if(n == 1 && mnemonic == QLatin1String("nop") && dst_is_rm) {
+		if(dst.size != 2 && dst.size != 4) {
+			*error = QString::fromLatin1("nop takes a word or dword operand");
+			return false;
+		}
+
+		if(!emit_rm(&out, dst.size, QByteArray("\x0f\x1f"), 0, 0, dst, false, error)) {
+			return false;
+		}
+		*bytes = out;
+		return true;
+	}
+
+	if(n == 1 && dst_is_rm) {
+		for(std::size_t i = 0; i < array_size(unary_instructions); ++i) {
+			const Unary &unary = unary_instructions[i];
+			if(mnemonic == QLatin1String(unary.name)) {
+				if(!dst.size) {
+					*error = QString::fromLatin1("the operand size isn't known, say byte, word, dword or qword");
+					return false;
+				}
+
+				// 32-bit mode has one byte forms of inc and dec, which are REX
+				// prefixes in 64-bit mode
+				if(bits_ == 32 && unary.opcode == 0xff && dst.type == Operand::REGISTER && dst.size != 1) {
+					if(!emit_plus_r(&out, dst.size, (unary.digit == 0) ? 0x40 : 0x48, dst, false, error)) {
+						return false;
+					}
+					*bytes = out;
+					return true;
+				}
+
+				if(!emit_rm(&out, dst.size, QByteArray(1, static_cast<char>((dst.size == 1) ? unary.opcode8 : unary.opcode)), unary.digit, 0, dst, false, error)) {
+					return false;
+				}
+				*bytes = out;
+				return true;
+			}
+		}
+	}
+
+	if(mnemonic == QLatin1String("imul") && (n == 2 || n == 3) && dst.type == Operand::REGISTER && dst.size != 1) {
+		// imul r, imm is imul r, r, imm
+		const Operand &rm = (n == 2 && src.type == Operand::IMMEDIATE) ? dst : src;
+		const Operand &imm = (n == 3) ? ops[2] : src;
+
+		if(rm.type == Operand::IMMEDIATE || (rm.size != 0 && rm.size != dst.size)) {
+			*error = QString::fromLatin1("the operands aren't the same size");
+			return false;
+		}
+
+		if(imm.type == Operand::IMMEDIATE) {
+			if(!fits(imm.imm, dst.size) || (dst.size == 8 && !fits_signed(imm.imm, 4))) {
+				*error = QString::fromLatin1("the immediate doesn't fit");
+				return false;
+			}
+
+			const bool short_form = fits_signed(normalize(imm.imm, dst.size), 1);
+			if(!emit_rm(&out, dst.size, QByteArray(short_form ? "\x6b" : "\x69"), dst.reg, &dst, rm, false, error)) {
+				return false;
+			}
+			append(&out, imm.imm, short_form ? 1 : qMin(dst.size, 4));
+		} else if(n == 2) {
+			if(!emit_rm(&out, dst.size, QByteArray("\x0f\xaf"), dst.reg, &dst, src, false, error)) {
+				return false;
+			}
+		} else {
+			*error = QString::fromLatin1("the last operand of imul must be an immediate");
+			return false;
+		}
+
+		*bytes = out;
+		return true;
+	}
+
+	const bool movzx = mnemonic == QLatin1String("movzx");
+	const bool movsx = mnemonic == QLatin1String("movsx");
+	if(n == 2 && (movzx || movsx) && dst.type == Operand::REGISTER && (src.type == Operand::REGISTER || src.type == Operand::MEMORY)) {
+		if((src.size != 1 && src.size != 2) || dst.size <= src.size) {
+			*error = QString::fromLatin1("%1 widens a byte or word into a bigger register").arg(mnemonic);
+			return false;
+		}
+
+		QByteArray opcode("\x0f", 1);
+		opcode += static_cast<char>((movzx ? 0xb6 : 0xbe) + ((src.size == 2) ? 1 : 0));
+		if(!emit_rm(&out, dst.size, opcode, dst.reg, &dst, src, false, error)) {
+			return false;
+		}
+		*bytes = out;
+		return true;
+	}
+
+	if(n == 2 && mnemonic == QLatin1String("movsxd") && dst.type == Operand::REGISTER && dst.size == 8 && (src.type == Operand::REGISTER || src.type == Operand::MEMORY)) {
+		if(src.size != 0 && src.size != 4) {
+			*error = QString::fromLatin1("movsxd widens a dword");
+			return false;
+		}
+		if(!emit_rm(&out, 8, QByteArray("\x63"), dst.reg, &dst, src, false, error)) {
+			return false;
+		}
+		*bytes = out;
+		return true;
+	}
+
+	if(n == 1 && mnemonic.startsWith(QLatin1String("set")) && dst_is_rm) {
+		const int cc = find_condition(mnemonic.mid(3));
+		if(cc != -1) {
+			if(dst.size != 0 && dst.size != 1) {
+				*error = QString::fromLatin1("set%1 writes a byte").arg(mnemonic.mid(3));
+				return false;
+			}
+
+			QByteArray opcode("\x0f", 1);
+			opcode += static_cast<char>(0x90 + cc);
+			if(!emit_rm(&out, 1, opcode, 0, 0, dst, false, error)) {
+				return false;
+			}
+			*bytes = out;
+			return true;
+		}
+	}
+
+	if(n == 2 && mnemonic.startsWith(QLatin1String("cmov")) && dst.type == Operand::REGISTER && dst.size != 1) {
+		const int cc = find_condition(mnemonic.mid(4));
+		if(cc != -1 && (src.type == Operand::REGISTER || src.type == Operand::MEMORY)) {
+			if(src.size != 0 && src.size != dst.size) {
+				*error = QString::fromLatin1("the operands aren't the same size");
+				return false;
+			}
+
+			QByteArray opcode("\x0f", 1);
+			opcode += static_cast<char>(0x40 + cc);
+			if(!emit_rm(&out, dst.size, opcode, dst.reg, &dst, src, false, error)) {
+				return false;
+			}
+			*bytes = out;
+			return true;
+		}
+	}
+
+	*error = QString::fromLatin1("\"%1\" with those operands isn't known to the built-in assembler").arg(mnemonic);
+	return false;
+}
+
+}
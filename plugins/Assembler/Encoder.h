@@ -0,0 +1,83 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef ENCODER_20261014_H_
+#define ENCODER_20261014_H_
+
+#include "Types.h"
+#include <QByteArray>
+#include <QString>
+#include <QStringList>
+
+namespace Assembler {
+
+// a small x86 and x86-64 encoder for the instructions which are typically
+// patched in: moves, lea, push/pop, the ALU and shift groups, test, xchg,
+// inc/dec/not/neg/mul/div, movzx/movsx, setcc/cmovcc, and jumps and calls to
+// an absolute target, along with a handful of instructions without operands.
+// Operands are written the way the disassembler shows them (Intel syntax,
+// "dword ptr [eax+ecx*4+8]"). Anything else is reported as an error, it is
+// then up to an external assembler
+class Encoder {
+public:
+	explicit Encoder(int bits);
+
+public:
+	// encodes <lines> one after the other starting at <address>, stopping at
+	// the first which can't be encoded and saying why in <error>
+	bool assemble(const QStringList &lines, edb::address_t address, QByteArray *bytes, QString *error) const;
+	bool encode(const QString &line, edb::address_t address, QByteArray *bytes, QString *error) const;
+
+public:
+	struct Operand {
+		enum Type {
+			NONE,
+			REGISTER,
+			IMMEDIATE,
+			MEMORY
+		};
+
+		Type    type;
+		int     size;         // in bytes, 0 if it isn't known
+		int     reg;          // REGISTER
+		bool    needs_rex;    // REGISTER, spl, bpl, sil and dil
+		bool    high_byte;    // REGISTER, ah, ch, dh and bh
+		qint64  imm;          // IMMEDIATE
+		int     base;         // MEMORY, -1 if there is none
+		int     index;        // MEMORY, -1 if there is none
+		int     scale;        // MEMORY
+		qint64  disp;         // MEMORY
+		bool    rip_relative; // MEMORY
+		int     address_size; // MEMORY, 0 if there are no registers
+		quint8  segment;      // MEMORY, the override prefix, 0 if there is none
+	};
+
+private:
+	bool parse_operand(const QString &text, Operand *operand, QString *error) const;
+	bool emit_rm(QByteArray *out, int size, const QByteArray &opcode, int reg_field, const Operand *reg, const Operand &rm, bool default64, QString *error) const;
+	bool emit_plus_r(QByteArray *out, int size, quint8 opcode, const Operand &reg, bool default64, QString *error) const;
+	bool emit_immediate(QByteArray *out, qint64 value, int size, QString *error) const;
+	bool emit_branch(QByteArray *out, const QString &mnemonic, const Operand &target, edb::address_t address, QString *error) const;
+
+private:
+	int bits_;
+};
+
+}
+
+#endif
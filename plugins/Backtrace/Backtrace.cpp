@@ -18,6 +18,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "Backtrace.h"
 #include "DialogBacktrace.h"
+#include "DialogThreadBacktraces.h"
 #include "edb.h"
 
 #include <QMenu>
@@ -25,13 +26,14 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 namespace Backtrace {
 
-Backtrace::Backtrace() : menu_(0), dialog_(0)
+Backtrace::Backtrace() : menu_(0), dialog_(0), threads_dialog_(0)
 {
 
 }
 
 Backtrace::~Backtrace() {
 	delete dialog_;
+	delete threads_dialog_;
 }
 
 //------------------------------------------------------------------------------
@@ -48,6 +50,7 @@ QMenu *Backtrace::menu(QWidget *parent) {
 
 		//Ctrl + K shortcut, reminiscent of OllyDbg
 		menu_->addAction(tr("Backtrace"), this, SLOT(show_menu()), QKeySequence(tr("Ctrl+K")));
+		menu_->addAction(tr("Backtrace All Threads"), this, SLOT(show_threads()));
 	}
 
 	return menu_;
@@ -64,6 +67,17 @@ void Backtrace::show_menu() {
 	dialog_->show();
 }
 
+//------------------------------------------------------------------------------
+// Name: show_threads
+// Desc: Shows the merged backtraces of every thread
+//------------------------------------------------------------------------------
+void Backtrace::show_threads() {
+	if (!threads_dialog_) {
+		threads_dialog_ = new DialogThreadBacktraces(edb::v1::debugger_ui);
+	}
+	threads_dialog_->show();
+}
+
 //Do we need this?  Wasn't included by default; I saw it in other plugins and added it.
 #if QT_VERSION < 0x050000
 Q_EXPORT_PLUGIN2(Backtrace, Backtrace)
@@ -47,10 +47,12 @@ public:
 
 public Q_SLOTS:
 	void show_menu();
+	void show_threads();
 
 private:
 	QMenu	*menu_;
 	QDialog	*dialog_;
+	QDialog	*threads_dialog_;
 };
 
 }
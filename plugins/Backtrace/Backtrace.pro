@@ -1,9 +1,12 @@
 include(../plugins.pri)
 
 SOURCES += Backtrace.cpp\
-	DialogBacktrace.cpp
+	DialogBacktrace.cpp\
+	DialogThreadBacktraces.cpp
 
 HEADERS += Backtrace.h\
 	DialogBacktrace.h\
+	DialogThreadBacktraces.h
 
-FORMS	+= DialogBacktrace.ui
+FORMS	+= DialogBacktrace.ui\
+	DialogThreadBacktraces.ui
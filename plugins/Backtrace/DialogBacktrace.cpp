@@ -19,6 +19,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "DialogBacktrace.h"
 #include "ui_DialogBacktrace.h"
 #include "CallStack.h"
+#include "Diagnostics.h"
 #include "Expression.h"
 #include "IBreakpoint.h"
 #include "IDebugger.h"
@@ -59,8 +60,7 @@ void DialogBacktrace::showEvent(QShowEvent *) {
 	resizeEvent(NULL);
 
 	//Sync with the Debugger UI.
-	connect(edb::v1::debugger_ui, SIGNAL(gui_updated()),
-			this, SLOT(populate_table()));
+	edb::diagnostics::connect_gui_updated(this, SLOT(populate_table()));
 
 	//Populate the tabel with our call stack info.
 	populate_table();
@@ -147,8 +147,7 @@ void DialogBacktrace::populate_table() {
 //			populate_table() is not called unnecessarily.
 //------------------------------------------------------------------------------
 void DialogBacktrace::hideEvent(QHideEvent *) {
-	disconnect(edb::v1::debugger_ui, SIGNAL(gui_updated()),
-			   this, SLOT(populate_table()));
+	edb::diagnostics::disconnect_gui_updated(this, SLOT(populate_table()));
 }
 
 //------------------------------------------------------------------------------
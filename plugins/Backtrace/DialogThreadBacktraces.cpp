@@ -0,0 +1,183 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "DialogThreadBacktraces.h"
+#include "CallStack.h"
+#include "Diagnostics.h"
+#include "IDebugger.h"
+#include "State.h"
+#include "edb.h"
+
+#include <QHash>
+#include <QHeaderView>
+#include <QStringList>
+#include <QTreeWidgetItem>
+
+#include "ui_DialogThreadBacktraces.h"
+
+namespace {
+
+enum {
+	COLUMN_FRAME,
+	COLUMN_COUNT,
+	COLUMN_THREADS
+};
+
+//------------------------------------------------------------------------------
+// Name: frame_name
+// Desc:
+//------------------------------------------------------------------------------
+QString frame_name(edb::address_t address) {
+	const QString default_region_name;
+	const QString symname = edb::v1::find_function_symbol(address, default_region_name);
+
+	if(!symname.isEmpty()) {
+		return QString("%1 <%2>").arg(edb::v1::format_pointer(address)).arg(symname);
+	} else {
+		return edb::v1::format_pointer(address);
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: child_for
+// Desc: the child of <parent> for a frame at <address>, made if need be
+//------------------------------------------------------------------------------
+QTreeWidgetItem *child_for(QTreeWidgetItem *parent, QHash<QTreeWidgetItem *, QHash<edb::address_t, QTreeWidgetItem *> > *children, edb::address_t address) {
+
+	QHash<edb::address_t, QTreeWidgetItem *> &known = (*children)[parent];
+
+	QTreeWidgetItem *&item = known[address];
+	if(!item) {
+		item = new QTreeWidgetItem(parent);
+		item->setText(COLUMN_FRAME, frame_name(address));
+		item->setData(COLUMN_FRAME, Qt::UserRole, static_cast<qulonglong>(address));
+		item->setData(COLUMN_COUNT, Qt::DisplayRole, 0);
+	}
+
+	return item;
+}
+
+}
+
+//------------------------------------------------------------------------------
+// Name: DialogThreadBacktraces
+// Desc:
+//------------------------------------------------------------------------------
+DialogThreadBacktraces::DialogThreadBacktraces(QWidget *parent) : QDialog(parent), ui(new Ui::DialogThreadBacktraces) {
+	ui->setupUi(this);
+#if QT_VERSION >= 0x050000
+	ui->treeWidget->header()->setSectionResizeMode(COLUMN_FRAME, QHeaderView::Stretch);
+#else
+	ui->treeWidget->header()->setResizeMode(COLUMN_FRAME, QHeaderView::Stretch);
+#endif
+	ui->treeWidget->header()->setStretchLastSection(false);
+}
+
+//------------------------------------------------------------------------------
+// Name: ~DialogThreadBacktraces
+// Desc:
+//------------------------------------------------------------------------------
+DialogThreadBacktraces::~DialogThreadBacktraces() {
+	delete ui;
+}
+
+//------------------------------------------------------------------------------
+// Name: showEvent
+// Desc: follows the process for as long as the dialog is up
+//------------------------------------------------------------------------------
+void DialogThreadBacktraces::showEvent(QShowEvent *) {
+	edb::diagnostics::connect_gui_updated(this, SLOT(populate_tree()));
+	populate_tree();
+}
+
+//------------------------------------------------------------------------------
+// Name: hideEvent
+// Desc:
+//------------------------------------------------------------------------------
+void DialogThreadBacktraces::hideEvent(QHideEvent *) {
+	edb::diagnostics::disconnect_gui_updated(this, SLOT(populate_tree()));
+}
+
+//------------------------------------------------------------------------------
+// Name: populate_tree
+// Desc: unwinds every stopped thread and merges the stacks. The registers of
+//       each thread are read once per stop and its call stack is only worked
+//       out again when it may have changed, so refreshing this is cheap
+//------------------------------------------------------------------------------
+void DialogThreadBacktraces::populate_tree() {
+
+	ui->treeWidget->clear();
+
+	if(!edb::v1::debugger_core) {
+		return;
+	}
+
+	QHash<QTreeWidgetItem *, QHash<edb::address_t, QTreeWidgetItem *> > children;
+	QHash<QTreeWidgetItem *, QStringList> threads;
+
+	QTreeWidgetItem *const root = ui->treeWidget->invisibleRootItem();
+
+	const StopSnapshot::pointer snapshot = edb::v1::stop_snapshot();
+	Q_FOREACH(edb::tid_t tid, snapshot ? snapshot->threads : edb::v1::debugger_core->thread_ids()) {
+
+		State state;
+		if(!edb::v1::debugger_core->get_thread_state(tid, &state)) {
+			continue;
+		}
+
+		// from the outermost caller in to where the thread is now
+		QList<edb::address_t> path;
+		CallStack call_stack(tid);
+		for(int i = call_stack.size() - 1; i >= 0; --i) {
+			path.push_back(call_stack[i]->caller);
+		}
+		path.push_back(state.instruction_pointer());
+
+		QTreeWidgetItem *item = root;
+		Q_FOREACH(edb::address_t address, path) {
+			item = child_for(item, &children, address);
+			item->setData(COLUMN_COUNT, Qt::DisplayRole, item->data(COLUMN_COUNT, Qt::DisplayRole).toInt() + 1);
+		}
+
+		threads[item].push_back(QString::number(tid));
+	}
+
+	for(QHash<QTreeWidgetItem *, QStringList>::const_iterator it = threads.begin(); it != threads.end(); ++it) {
+		it.key()->setText(COLUMN_THREADS, it.value().join(", "));
+	}
+
+	ui->treeWidget->sortItems(COLUMN_COUNT, Qt::DescendingOrder);
+	ui->treeWidget->expandAll();
+}
+
+//------------------------------------------------------------------------------
+// Name: on_treeWidget_itemDoubleClicked
+// Desc:
+//------------------------------------------------------------------------------
+void DialogThreadBacktraces::on_treeWidget_itemDoubleClicked(QTreeWidgetItem *item, int column) {
+	Q_UNUSED(column);
+	edb::v1::jump_to_address(item->data(COLUMN_FRAME, Qt::UserRole).toULongLong());
+}
+
+//------------------------------------------------------------------------------
+// Name: on_pushButtonClose_clicked
+// Desc:
+//------------------------------------------------------------------------------
+void DialogThreadBacktraces::on_pushButtonClose_clicked() {
+	hide();
+}
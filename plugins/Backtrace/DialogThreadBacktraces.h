@@ -0,0 +1,59 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef DIALOGTHREADBACKTRACES_20261014_H_
+#define DIALOGTHREADBACKTRACES_20261014_H_
+
+#if QT_VERSION >= 0x050000
+#include <QtWidgets/QDialog>
+#else
+#include <QtGui/QDialog>
+#endif
+
+class QTreeWidgetItem;
+
+namespace Ui {
+class DialogThreadBacktraces;
+}
+
+// the backtraces of every thread, merged into a tree from the outermost frame
+// in. Threads which are doing the same thing share a branch, and the number
+// of threads under each frame says where the process is spending its time
+class DialogThreadBacktraces : public QDialog {
+	Q_OBJECT
+
+public:
+	explicit DialogThreadBacktraces(QWidget *parent = 0);
+	virtual ~DialogThreadBacktraces();
+
+public Q_SLOTS:
+	void populate_tree();
+
+private Q_SLOTS:
+	void on_treeWidget_itemDoubleClicked(QTreeWidgetItem *item, int column);
+	void on_pushButtonClose_clicked();
+
+private:
+	virtual void showEvent(QShowEvent *);
+	virtual void hideEvent(QHideEvent *);
+
+private:
+	Ui::DialogThreadBacktraces *const ui;
+};
+
+#endif
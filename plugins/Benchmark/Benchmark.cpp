@@ -0,0 +1,643 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Benchmark.h"
+#include "IBreakpoint.h"
+#include "IDebugEvent.h"
+#include "IDebugger.h"
+#include "IProcess.h"
+#include "ISymbolManager.h"
+#include "MemoryRegions.h"
+#include "State.h"
+#include "StringScanner.h"
+#include "Symbol.h"
+#include "edb.h"
+#include "version.h"
+
+#include <QFile>
+#include <QFileInfo>
+#include <QFileDialog>
+#include <QMenu>
+#include <QMessageBox>
+#include <QPair>
+#include <QTime>
+#include <QVector>
+
+namespace Benchmark {
+
+namespace {
+
+// each benchmark repeats its operation for at least this long, which keeps
+// QTime's millisecond resolution from mattering
+const int MinimumTime = 250;
+
+// how long to wait for the process to stop again, after which the stepping
+// and breakpoint benchmarks give up
+const int EventTimeout = 5000;
+
+//------------------------------------------------------------------------------
+// Name: wait_for_stop
+// Desc: the next event, null if the process didn't stop in time or is gone
+//------------------------------------------------------------------------------
+IDebugEvent::const_pointer wait_for_stop() {
+	const IDebugEvent::const_pointer e = edb::v1::debugger_core->wait_debug_event(EventTimeout);
+	if(e && e->stopped()) {
+		return e;
+	}
+	return IDebugEvent::const_pointer();
+}
+
+//------------------------------------------------------------------------------
+// Name: json_value
+// Desc: numbers and booleans as they are, anything else as a string
+//------------------------------------------------------------------------------
+QString json_value(const QVariant &value) {
+	switch(value.type()) {
+	case QVariant::Bool:
+		return value.toBool() ? "true" : "false";
+	case QVariant::Int:
+	case QVariant::UInt:
+	case QVariant::LongLong:
+	case QVariant::ULongLong:
+	case QVariant::Double:
+		return value.toString();
+	default:
+		return edb::v1::json_string(value.toString());
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: is_libc
+// Desc: true if <region> is mapped from libc, whichever way it is named
+//------------------------------------------------------------------------------
+bool is_libc(const IRegion::pointer &region) {
+	const QString name = QFileInfo(region->name()).fileName();
+	return name.startsWith("libc.so") || (name.startsWith("libc-") && name.endsWith(".so"));
+}
+
+// only counts what it finds
+class CountStrings : public StringScanner {
+public:
+	CountStrings(int min_length, bool utf16) : StringScanner(min_length, utf16), count(0) {
+	}
+
+protected:
+	virtual void found(const QVector<String> &strings) {
+		count += strings.size();
+	}
+
+public:
+	quint64 count;
+};
+
+}
+
+//------------------------------------------------------------------------------
+// Name: Benchmark
+// Desc:
+//------------------------------------------------------------------------------
+Benchmark::Benchmark() : menu_(0) {
+}
+
+//------------------------------------------------------------------------------
+// Name: ~Benchmark
+// Desc:
+//------------------------------------------------------------------------------
+Benchmark::~Benchmark() {
+}
+
+//------------------------------------------------------------------------------
+// Name: menu
+// Desc:
+//------------------------------------------------------------------------------
+QMenu *Benchmark::menu(QWidget *parent) {
+
+	Q_ASSERT(parent);
+
+	if(!menu_) {
+		menu_ = new QMenu(tr("Benchmark"), parent);
+		menu_->addAction(tr("&Run Core Benchmarks..."), this, SLOT(run_benchmarks()));
+		menu_->addAction(tr("Run &Analysis Benchmarks..."), this, SLOT(run_analysis_benchmarks()));
+	}
+
+	return menu_;
+}
+
+//------------------------------------------------------------------------------
+// Name: report
+// Desc: records a result, <parameters> are extra JSON members for it
+//------------------------------------------------------------------------------
+void Benchmark::report(const QString &name, const QString &parameters, quint64 iterations, const QTime &timer, quint64 bytes) {
+
+	const int msecs = qMax(timer.elapsed(), 1);
+
+	QString result = QString("{ \"name\": %1, ").arg(edb::v1::json_string(name));
+	if(!parameters.isEmpty()) {
+		result += parameters + ", ";
+	}
+
+	result += QString("\"iterations\": %1, \"ns_per_op\": %2").arg(iterations).arg(msecs * 1e6 / iterations, 0, 'f', 1);
+	if(bytes != 0) {
+		result += QString(", \"mb_per_s\": %1").arg(bytes / (msecs * 1e-3) / (1 << 20), 0, 'f', 1);
+	}
+
+	result += " }";
+	results_.push_back(result.toUtf8());
+}
+
+//------------------------------------------------------------------------------
+// Name: report
+// Desc: records a result taken by a plugin, the rates are per second of all
+//       of its iterations
+//------------------------------------------------------------------------------
+void Benchmark::report(const BenchmarkResult &r) {
+
+	const double  seconds    = qMax(r.msecs, 1) * 1e-3;
+	const quint64 iterations = qMax<quint64>(r.iterations, 1);
+
+	QString result = QString("{ \"name\": %1, ").arg(edb::v1::json_string(r.name));
+	for(QVariantMap::const_iterator it = r.parameters.begin(); it != r.parameters.end(); ++it) {
+		result += QString("%1: %2, ").arg(edb::v1::json_string(it.key()), json_value(it.value()));
+	}
+
+	result += QString("\"iterations\": %1, \"ns_per_op\": %2").arg(iterations).arg(seconds * 1e9 / iterations, 0, 'f', 1);
+	if(r.bytes != 0) {
+		result += QString(", \"bytes\": %1, \"mb_per_s\": %2").arg(r.bytes).arg(r.bytes * iterations / seconds / (1 << 20), 0, 'f', 1);
+	}
+
+	if(!r.units.isEmpty()) {
+		result += QString(", %1: %2, %3: %4").arg(edb::v1::json_string(r.units)).arg(r.items).arg(edb::v1::json_string(r.units + "_per_s")).arg(r.items * iterations / seconds, 0, 'f', 1);
+	}
+
+	result += " }";
+	results_.push_back(result.toUtf8());
+}
+
+//------------------------------------------------------------------------------
+// Name: skipped
+// Desc: a benchmark which couldn't be run, so that it doesn't just disappear
+//       from the results
+//------------------------------------------------------------------------------
+void Benchmark::skipped(const QString &name, const QString &reason) {
+	results_.push_back(QString("{ \"name\": %1, \"skipped\": %2 }").arg(edb::v1::json_string(name)).arg(edb::v1::json_string(reason)).toUtf8());
+}
+
+//------------------------------------------------------------------------------
+// Name: run_benchmarks
+// Desc:
+//------------------------------------------------------------------------------
+void Benchmark::run_benchmarks() {
+
+	IProcess *const process = edb::v1::debugger_core ? edb::v1::debugger_core->process() : 0;
+	if(!process) {
+		QMessageBox::information(edb::v1::debugger_ui, tr("Benchmark"), tr("The benchmarks need a stopped process, ideally benchmarks/target."));
+		return;
+	}
+
+	const QString filename = QFileDialog::getSaveFileName(edb::v1::debugger_ui, tr("Save Benchmark Results"), QString(), tr("JSON Files (*.json);;All Files (*)"));
+	if(filename.isEmpty()) {
+		return;
+	}
+
+	results_.clear();
+
+	// reads and writes go to the biggest writable region, which for the
+	// target is its 16MiB buffer
+	edb::v1::memory_regions().sync();
+
+	IRegion::pointer region;
+	Q_FOREACH(const IRegion::pointer &r, edb::v1::memory_regions().regions()) {
+		if(r->readable() && r->writable() && (!region || r->size() > region->size())) {
+			region = r;
+		}
+	}
+
+	bench_memory(region);
+	bench_state();
+	bench_regions();
+	bench_symbols();
+	bench_step();
+	bench_breakpoint();
+
+	// the process has moved on, so everything needs to be shown again
+	edb::v1::update_ui();
+
+	save_results(filename, process->pid());
+}
+
+//------------------------------------------------------------------------------
+// Name: run_analysis_benchmarks
+// Desc: times the search and analysis engines over libc and the main binary,
+//       the plugins which are only loaded when used are loaded for this
+//------------------------------------------------------------------------------
+void Benchmark::run_analysis_benchmarks() {
+
+	IProcess *const process = edb::v1::debugger_core ? edb::v1::debugger_core->process() : 0;
+	if(!process) {
+		QMessageBox::information(edb::v1::debugger_ui, tr("Benchmark"), tr("The benchmarks need a stopped process, ideally one linked against libc or a large static binary."));
+		return;
+	}
+
+	const QString filename = QFileDialog::getSaveFileName(edb::v1::debugger_ui, tr("Save Benchmark Results"), QString(), tr("JSON Files (*.json);;All Files (*)"));
+	if(filename.isEmpty()) {
+		return;
+	}
+
+	results_.clear();
+
+	edb::v1::memory_regions().sync();
+	edb::v1::load_lazy_plugins();
+
+	// every readable region of each module, the analyzer only looks at the
+	// executable ones
+	const IRegion::pointer primary = edb::v1::primary_code_region();
+
+	QList<IRegion::pointer> libc;
+	QList<IRegion::pointer> binary;
+	Q_FOREACH(const IRegion::pointer &region, edb::v1::memory_regions().regions()) {
+		if(!region->readable() || region->size() == 0) {
+			continue;
+		}
+
+		if(is_libc(region)) {
+			libc.push_back(region);
+		} else if(primary && region->name() == primary->name()) {
+			binary.push_back(region);
+		}
+	}
+
+	QList<QPair<QString, QList<IRegion::pointer> > > corpora;
+	if(!libc.isEmpty()) {
+		corpora.push_back(qMakePair(QString("libc"), libc));
+	} else {
+		skipped("libc", "libc isn't mapped, is the process static?");
+	}
+
+	if(!binary.isEmpty()) {
+		corpora.push_back(qMakePair(QFileInfo(primary->name()).fileName(), binary));
+	} else {
+		skipped("main", "no primary code region");
+	}
+
+	for(int i = 0; i < corpora.size(); ++i) {
+		bench_strings(corpora[i].first, corpora[i].second);
+
+		Q_FOREACH(QObject *plugin, edb::v1::plugin_list()) {
+			if(IPlugin *const p = qobject_cast<IPlugin *>(plugin)) {
+				if(p != this) {
+					bench_plugin(p, corpora[i].first, corpora[i].second);
+				}
+			}
+		}
+	}
+
+	// the analyzer's results will have changed
+	edb::v1::update_ui();
+
+	save_results(filename, process->pid());
+}
+
+//------------------------------------------------------------------------------
+// Name: save_results
+// Desc:
+//------------------------------------------------------------------------------
+void Benchmark::save_results(const QString &filename, edb::pid_t pid) {
+
+	QFile file(filename);
+	if(!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+		QMessageBox::information(edb::v1::debugger_ui, tr("Benchmark"), tr("Unable to open file: %1").arg(filename));
+		return;
+	}
+
+	file.write(QString("{\n\t\"edb_version\": %1,\n\t\"pid\": %2,\n\t\"results\": [").arg(edb::v1::json_string(edb::version)).arg(pid).toUtf8());
+	for(int i = 0; i < results_.size(); ++i) {
+		file.write(i == 0 ? "\n\t\t" : ",\n\t\t");
+		file.write(results_[i]);
+	}
+	file.write("\n\t]\n}\n");
+}
+
+//------------------------------------------------------------------------------
+// Name: bench_memory
+// Desc: read_bytes, read_pages and write_bytes at a few sizes. What is written
+//       is what was just read, so the process doesn't notice
+//------------------------------------------------------------------------------
+void Benchmark::bench_memory(const IRegion::pointer &region) {
+
+	static const int sizes[] = { 8, 4096, 65536, 1 << 20 };
+
+	if(!region) {
+		skipped("read_bytes", "no writable region");
+		skipped("read_pages", "no writable region");
+		skipped("write_bytes", "no writable region");
+		return;
+	}
+
+	IProcess *const process        = edb::v1::debugger_core->process();
+	const edb::address_t page_size = edb::v1::debugger_core->page_size();
+
+	for(std::size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); ++i) {
+
+		const std::size_t size = sizes[i];
+		if(size > region->size()) {
+			skipped("read_bytes", QString("region is smaller than %1 bytes").arg(size));
+			continue;
+		}
+
+		QVector<quint8> buffer(static_cast<int>(size));
+		const QString parameters = QString("\"size\": %1").arg(size);
+
+		// spread the reads over the region so that caches don't flatter them
+		const edb::address_t span      = region->size() - size + 1;
+		const edb::address_t page_span = qMax(span - span % page_size, page_size);
+
+		quint64 iterations = 0;
+		QTime timer;
+		timer.start();
+		do {
+			process->read_bytes(region->start() + (iterations * page_size) % span, buffer.data(), size);
+			++iterations;
+		} while(timer.elapsed() < MinimumTime);
+		report("read_bytes", parameters, iterations, timer, iterations * size);
+
+		if(size >= page_size) {
+			iterations = 0;
+			timer.start();
+			do {
+				process->read_pages(region->start() + (iterations * page_size) % page_span, buffer.data(), size / page_size);
+				++iterations;
+			} while(timer.elapsed() < MinimumTime);
+			report("read_pages", parameters, iterations, timer, iterations * size);
+		}
+
+		process->read_bytes(region->start(), buffer.data(), size);
+		iterations = 0;
+		timer.start();
+		do {
+			process->write_bytes(region->start(), buffer.data(), size);
+			++iterations;
+		} while(timer.elapsed() < MinimumTime);
+		report("write_bytes", parameters, iterations, timer, iterations * size);
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: bench_state
+// Desc: get_state, and set_state of a state which was changed, so that the
+//       registers really are written each time
+//------------------------------------------------------------------------------
+void Benchmark::bench_state() {
+
+	State state;
+
+	quint64 iterations = 0;
+	QTime timer;
+	timer.start();
+	do {
+		edb::v1::debugger_core->get_state(&state);
+		++iterations;
+	} while(timer.elapsed() < MinimumTime);
+	report("get_state", QString(), iterations, timer);
+
+	edb::v1::debugger_core->get_state(&state);
+	const edb::address_t ip = state.instruction_pointer();
+
+	iterations = 0;
+	timer.start();
+	do {
+		state.set_instruction_pointer(ip);
+		edb::v1::debugger_core->set_state(state);
+		++iterations;
+	} while(timer.elapsed() < MinimumTime);
+	report("set_state", QString(), iterations, timer);
+}
+
+//------------------------------------------------------------------------------
+// Name: bench_regions
+// Desc: MemoryRegions::sync, with however many mappings the process has
+//------------------------------------------------------------------------------
+void Benchmark::bench_regions() {
+
+	quint64 iterations = 0;
+	QTime timer;
+	timer.start();
+	do {
+		edb::v1::memory_regions().sync();
+		++iterations;
+	} while(timer.elapsed() < MinimumTime);
+	report("memory_regions_sync", QString("\"mappings\": %1").arg(edb::v1::memory_regions().regions().size()), iterations, timer);
+}
+
+//------------------------------------------------------------------------------
+// Name: bench_symbols
+// Desc: loading the symbols of the main module again, from the symbol cache
+//------------------------------------------------------------------------------
+void Benchmark::bench_symbols() {
+
+	const IRegion::pointer region = edb::v1::primary_code_region();
+	if(!region) {
+		skipped("symbol_load", "no primary code region");
+		return;
+	}
+
+	quint64 iterations = 0;
+	QTime timer;
+	timer.start();
+	do {
+		edb::v1::symbol_manager().unload_symbol_file(region->name());
+		edb::v1::symbol_manager().load_symbol_file(region->name(), region->start());
+		edb::v1::symbol_manager().wait_for_symbol_file(region->name());
+		++iterations;
+	} while(timer.elapsed() < MinimumTime);
+	report("symbol_load", QString("\"module\": %1").arg(edb::v1::json_string(region->name())), iterations, timer);
+}
+
+//------------------------------------------------------------------------------
+// Name: bench_step
+// Desc: single steps of the active thread, each waited for
+//------------------------------------------------------------------------------
+void Benchmark::bench_step() {
+
+	quint64 iterations = 0;
+	QTime timer;
+	timer.start();
+	do {
+		edb::v1::debugger_core->step(edb::DEBUG_CONTINUE);
+		if(!wait_for_stop()) {
+			skipped("single_step", "the process didn't stop after a step");
+			return;
+		}
+		++iterations;
+	} while(timer.elapsed() < MinimumTime);
+	report("single_step", QString(), iterations, timer);
+}
+
+//------------------------------------------------------------------------------
+// Name: bench_breakpoint
+// Desc: a breakpoint being hit and stepped over again, the way the debugger
+//       does it: rewind past the int3, step the real instruction and put the
+//       breakpoint back
+//------------------------------------------------------------------------------
+void Benchmark::bench_breakpoint() {
+
+	const QVector<quint64> matches = edb::v1::symbol_manager().search("edb_benchmark_tick", ISymbolManager::SEARCH_EXACT);
+	const Symbol::pointer symbol = matches.isEmpty() ? Symbol::pointer() : edb::v1::symbol_manager().from_handle(matches.front());
+	if(!symbol) {
+		skipped("breakpoint_round_trip", "edb_benchmark_tick not found, is this benchmarks/target?");
+		return;
+	}
+
+	const edb::address_t address = symbol->address;
+	const IBreakpoint::pointer bp = edb::v1::debugger_core->add_breakpoint(address);
+	if(!bp) {
+		skipped("breakpoint_round_trip", "the breakpoint couldn't be set");
+		return;
+	}
+
+	// the first hit only gets us into the loop
+	bool ok = true;
+	quint64 iterations = 0;
+	QTime timer;
+	for(int i = -1; ok && (i < 0 || timer.elapsed() < MinimumTime); ++i) {
+
+		if(i == 0) {
+			timer.start();
+		}
+
+		edb::v1::debugger_core->resume(edb::DEBUG_CONTINUE);
+		ok = !wait_for_stop().isNull();
+
+		State state;
+		edb::v1::debugger_core->get_state(&state);
+		ok = ok && state.instruction_pointer() == address + 1;
+
+		if(ok) {
+			state.set_instruction_pointer(address);
+			edb::v1::debugger_core->set_state(state);
+
+			bp->disable();
+			edb::v1::debugger_core->step(edb::DEBUG_CONTINUE);
+			ok = !wait_for_stop().isNull();
+			bp->enable();
+		}
+
+		if(i >= 0) {
+			++iterations;
+		}
+	}
+
+	edb::v1::debugger_core->remove_breakpoint(address);
+
+	if(ok) {
+		report("breakpoint_round_trip", QString(), iterations, timer);
+	} else {
+		skipped("breakpoint_round_trip", "the process didn't stop at the breakpoint");
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: bench_strings
+// Desc: the string search, ASCII only and with UTF-16 as well
+//------------------------------------------------------------------------------
+void Benchmark::bench_strings(const QString &corpus, const QList<IRegion::pointer> &regions) {
+
+	quint64 bytes = 0;
+	Q_FOREACH(const IRegion::pointer &region, regions) {
+		bytes += region->size();
+	}
+
+	for(int utf16 = 0; utf16 < 2; ++utf16) {
+
+		quint64 iterations = 0;
+		quint64 count      = 0;
+
+		QTime timer;
+		timer.start();
+		do {
+			CountStrings scanner(4, utf16 != 0);
+			scanner.run(regions);
+			count = scanner.count;
+			++iterations;
+		} while(timer.elapsed() < MinimumTime);
+
+		BenchmarkResult result;
+		result.name                 = "StringScanner::run";
+		result.parameters["corpus"] = corpus;
+		result.parameters["utf16"]  = utf16 != 0;
+		result.iterations           = iterations;
+		result.msecs                = timer.elapsed();
+		result.bytes                = bytes;
+		result.items                = count;
+		result.units                = "strings";
+		report(result);
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: bench_plugin
+// Desc: runs <plugin>'s benchmarks over and over until they have taken long
+//       enough to be worth timing, adding up the passes. A pass's own times
+//       are whole milliseconds and a fast one reports none, so the passes are
+//       timed as a whole and that time is shared out by what each reported
+//------------------------------------------------------------------------------
+void Benchmark::bench_plugin(IPlugin *plugin, const QString &corpus, const QList<IRegion::pointer> &regions) {
+
+	QList<BenchmarkResult> totals;
+
+	QTime timer;
+	timer.start();
+	do {
+		const QList<BenchmarkResult> results = plugin->run_benchmarks(regions);
+		if(results.isEmpty()) {
+			return;
+		}
+
+		if(totals.isEmpty()) {
+			totals = results;
+		} else {
+			for(int i = 0; i < totals.size() && i < results.size(); ++i) {
+				totals[i].iterations += results[i].iterations;
+				totals[i].msecs      += results[i].msecs;
+			}
+		}
+	} while(timer.elapsed() < MinimumTime);
+
+	const int elapsed = timer.elapsed();
+
+	qint64 reported = 0;
+	Q_FOREACH(const BenchmarkResult &r, totals) {
+		reported += r.msecs;
+	}
+
+	Q_FOREACH(BenchmarkResult r, totals) {
+		if(reported != 0) {
+			r.msecs = static_cast<int>(elapsed * r.msecs / reported);
+		} else {
+			r.msecs = elapsed / totals.size();
+		}
+
+		r.parameters["corpus"] = corpus;
+		report(r);
+	}
+}
+
+#if QT_VERSION < 0x050000
+Q_EXPORT_PLUGIN2(Benchmark, Benchmark)
+#endif
+
+}
@@ -0,0 +1,85 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef BENCHMARK_20261014_H_
+#define BENCHMARK_20261014_H_
+
+#include "BenchmarkResult.h"
+#include "IPlugin.h"
+#include "IRegion.h"
+#include "Types.h"
+
+#include <QByteArray>
+#include <QList>
+
+class QMenu;
+class QTime;
+
+namespace Benchmark {
+
+// times the operations the rest of edb is built on against the stopped
+// process (benchmarks/target is made for this) and saves the results as JSON,
+// so that two builds can be compared. Everything is run directly against the
+// debugger core, the UI only catches up once it is all done. The analysis
+// benchmarks time the engines of the other plugins (see
+// IPlugin::run_benchmarks) and the string search over libc and the main
+// binary
+class Benchmark : public QObject, public IPlugin {
+	Q_OBJECT
+	Q_INTERFACES(IPlugin)
+#if QT_VERSION >= 0x050000
+	Q_PLUGIN_METADATA(IID "edb.IPlugin/1.0")
+#endif
+	Q_CLASSINFO("author", "Evan Teran")
+	Q_CLASSINFO("url", "http://www.codef00.com")
+
+public:
+	Benchmark();
+	virtual ~Benchmark();
+
+public:
+	virtual QMenu *menu(QWidget *parent = 0);
+
+public Q_SLOTS:
+	void run_benchmarks();
+	void run_analysis_benchmarks();
+
+private:
+	void bench_memory(const IRegion::pointer &region);
+	void bench_state();
+	void bench_step();
+	void bench_breakpoint();
+	void bench_regions();
+	void bench_symbols();
+	void bench_strings(const QString &corpus, const QList<IRegion::pointer> &regions);
+	void bench_plugin(IPlugin *plugin, const QString &corpus, const QList<IRegion::pointer> &regions);
+
+private:
+	void report(const QString &name, const QString &parameters, quint64 iterations, const QTime &timer, quint64 bytes = 0);
+	void report(const BenchmarkResult &result);
+	void skipped(const QString &name, const QString &reason);
+	void save_results(const QString &filename, edb::pid_t pid);
+
+private:
+	QMenu            *menu_;
+	QList<QByteArray> results_;
+};
+
+}
+
+#endif
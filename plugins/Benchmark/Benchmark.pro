@@ -0,0 +1,6 @@
+
+include(../plugins.pri)
+
+# Input
+HEADERS += Benchmark.h
+SOURCES += Benchmark.cpp
@@ -18,6 +18,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "BinaryInfo.h"
 #include "DialogHeader.h"
+#include "DialogIntegrity.h"
 #include "ELF32.h"
 #include "ELF64.h"
 #include "IBinary.h"
@@ -29,8 +30,6 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <QDebug>
 #include <QMenu>
 
-#include <fstream>
-
 namespace BinaryInfo {
 namespace {
 
@@ -89,6 +88,7 @@ QMenu *BinaryInfo::menu(QWidget *parent) {
 	if(!menu_) {
 		menu_ = new QMenu(tr("Binary Info"), parent);
 		menu_->addAction(tr("&Explore Binary Header"), this, SLOT(explore_header()));
+		menu_->addAction(tr("Find &Hooks and Patches"), this, SLOT(find_hooks()));
 	}
 
 	return menu_;
@@ -103,6 +103,15 @@ void BinaryInfo::explore_header() {
 	dialog->show();
 }
 
+//------------------------------------------------------------------------------
+// Name: find_hooks
+// Desc:
+//------------------------------------------------------------------------------
+void BinaryInfo::find_hooks() {
+	static QDialog *dialog = new DialogIntegrity(edb::v1::debugger_ui);
+	dialog->show();
+}
+
 //------------------------------------------------------------------------------
 // Name: extra_arguments
 // Desc:
@@ -130,12 +139,24 @@ IPlugin::ArgumentStatus BinaryInfo::parse_argments(QStringList &args) {
 // Desc:
 //------------------------------------------------------------------------------
 bool BinaryInfo::generate_symbol_file(const QString &filename, const QString &symbol_file) {
+	return generate_symbol_cache(filename, symbol_file);
+}
+
+//------------------------------------------------------------------------------
+// Name: source_line
+// Desc: a file's debug info is found and mapped the first time it is asked for
+//------------------------------------------------------------------------------
+bool BinaryInfo::source_line(const QString &filename, edb::address_t address, QString *file, int *line, edb::address_t *start) {
+
+	QSharedPointer<DebugInfo> &debug_info = debug_info_[filename];
+	if(!debug_info) {
+		debug_info = QSharedPointer<DebugInfo>(new DebugInfo(filename));
+	}
 
-	std::ofstream file(qPrintable(symbol_file));
-	if(file) {
-		if(generate_symbols(filename, file)) {
-			return true;
-		}
+	quint64 line_start;
+	if(debug_info->find_line(address, file, line, &line_start)) {
+		*start = line_start;
+		return true;
 	}
 
 	return false;
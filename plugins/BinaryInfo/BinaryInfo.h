@@ -22,11 +22,15 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "IPlugin.h"
 #include "ISymbolGenerator.h"
 #include "Types.h"
+#include <QHash>
+#include <QSharedPointer>
 
 class QMenu;
 
 namespace BinaryInfo {
 
+class DebugInfo;
+
 class BinaryInfo : public QObject, public IPlugin, public ISymbolGenerator {
 	Q_OBJECT
 	Q_INTERFACES(IPlugin)
@@ -49,12 +53,15 @@ public:
 	
 public:
 	virtual bool generate_symbol_file(const QString &filename, const QString &symbol_file);
+	virtual bool source_line(const QString &filename, edb::address_t address, QString *file, int *line, edb::address_t *start);
 
 public Q_SLOTS:
 	void explore_header();
+	void find_hooks();
 	
 private:
-	QMenu *menu_;
+	QMenu                                    *menu_;
+	QHash<QString, QSharedPointer<DebugInfo> > debug_info_;
 };
 
 }
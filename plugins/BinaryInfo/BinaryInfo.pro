@@ -2,7 +2,7 @@
 include(../plugins.pri)
 
 # Input
-HEADERS += symbols.h BinaryInfo.h ELF32.h ELF64.h PE32.h elf_binary.h pe_binary.h DialogHeader.h
-FORMS += DialogHeader.ui
-SOURCES += symbols.cpp BinaryInfo.cpp ELF32.cpp ELF64.cpp PE32.cpp DialogHeader.cpp
+HEADERS += symbols.h dwarf.h BinaryInfo.h ELF32.h ELF64.h PE32.h ElfImage.h elf_binary.h pe_binary.h DialogHeader.h DialogIntegrity.h IntegrityCheck.h
+FORMS += DialogHeader.ui DialogIntegrity.ui
+SOURCES += symbols.cpp dwarf.cpp BinaryInfo.cpp ELF32.cpp ELF64.cpp PE32.cpp DialogHeader.cpp DialogIntegrity.cpp IntegrityCheck.cpp
 
@@ -0,0 +1,119 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "DialogIntegrity.h"
+#include "IntegrityCheck.h"
+#include "edb.h"
+
+#include <QApplication>
+#include <QHeaderView>
+#include <QTreeWidgetItem>
+
+#include "ui_DialogIntegrity.h"
+
+namespace BinaryInfo {
+namespace {
+
+enum {
+	COLUMN_ADDRESS,
+	COLUMN_SYMBOL,
+	COLUMN_SIZE,
+	COLUMN_EXPECTED,
+	COLUMN_ACTUAL,
+	COLUMN_MODULE
+};
+
+// longer runs are shown cut short, the whole of them is in the CPU view
+const int max_shown_bytes = 32;
+
+//------------------------------------------------------------------------------
+// Name: shown_bytes
+// Desc:
+//------------------------------------------------------------------------------
+QString shown_bytes(const QByteArray &bytes) {
+	if(bytes.size() > max_shown_bytes) {
+		return edb::v1::format_bytes(bytes.left(max_shown_bytes)) + "...";
+	}
+	return edb::v1::format_bytes(bytes);
+}
+
+}
+
+//------------------------------------------------------------------------------
+// Name: DialogIntegrity
+// Desc:
+//------------------------------------------------------------------------------
+DialogIntegrity::DialogIntegrity(QWidget *parent) : QDialog(parent), ui(new Ui::DialogIntegrity) {
+	ui->setupUi(this);
+	ui->treeWidget->header()->setStretchLastSection(true);
+}
+
+//------------------------------------------------------------------------------
+// Name: ~DialogIntegrity
+// Desc:
+//------------------------------------------------------------------------------
+DialogIntegrity::~DialogIntegrity() {
+	delete ui;
+}
+
+//------------------------------------------------------------------------------
+// Name: on_btnScan_clicked
+// Desc:
+//------------------------------------------------------------------------------
+void DialogIntegrity::on_btnScan_clicked() {
+
+	ui->treeWidget->setSortingEnabled(false);
+	ui->treeWidget->clear();
+
+	QApplication::setOverrideCursor(Qt::WaitCursor);
+
+	IntegrityStats stats;
+	const QList<Modification> modifications = find_modifications(&stats);
+
+	Q_FOREACH(const Modification &modification, modifications) {
+		QTreeWidgetItem *const item = new QTreeWidgetItem(ui->treeWidget);
+		item->setText(COLUMN_ADDRESS, edb::v1::format_pointer(modification.address));
+		item->setText(COLUMN_SYMBOL, edb::v1::find_function_symbol(modification.address));
+		item->setData(COLUMN_SIZE, Qt::DisplayRole, modification.actual.size());
+		item->setText(COLUMN_EXPECTED, shown_bytes(modification.expected));
+		item->setText(COLUMN_ACTUAL, shown_bytes(modification.actual));
+		item->setText(COLUMN_MODULE, modification.module);
+		item->setData(COLUMN_ADDRESS, Qt::UserRole, static_cast<qulonglong>(modification.address));
+	}
+
+	QApplication::restoreOverrideCursor();
+
+	ui->treeWidget->setSortingEnabled(true);
+	ui->treeWidget->sortByColumn(COLUMN_ADDRESS, Qt::AscendingOrder);
+
+	ui->lblStatus->setText(tr("%n modification(s) in %1 modules, %2 of %3 pages of code differ", 0, modifications.size())
+		.arg(stats.modules)
+		.arg(stats.changed_pages)
+		.arg(stats.pages));
+}
+
+//------------------------------------------------------------------------------
+// Name: on_treeWidget_itemDoubleClicked
+// Desc:
+//------------------------------------------------------------------------------
+void DialogIntegrity::on_treeWidget_itemDoubleClicked(QTreeWidgetItem *item, int column) {
+	Q_UNUSED(column);
+	edb::v1::jump_to_address(item->data(COLUMN_ADDRESS, Qt::UserRole).toULongLong());
+}
+
+}
@@ -0,0 +1,49 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef DIALOG_INTEGRITY_20261014_H_
+#define DIALOG_INTEGRITY_20261014_H_
+
+#include <QDialog>
+
+class QTreeWidgetItem;
+
+namespace BinaryInfo {
+
+namespace Ui { class DialogIntegrity; }
+
+// lists where the code of the loaded modules differs from their files,
+// double clicking one shows it in the CPU view
+class DialogIntegrity : public QDialog {
+	Q_OBJECT
+
+public:
+	DialogIntegrity(QWidget *parent = 0);
+	virtual ~DialogIntegrity();
+
+public Q_SLOTS:
+	void on_btnScan_clicked();
+	void on_treeWidget_itemDoubleClicked(QTreeWidgetItem *item, int column);
+
+private:
+	Ui::DialogIntegrity *const ui;
+};
+
+}
+
+#endif
@@ -18,6 +18,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "ELF32.h"
 #include "ByteShiftArray.h"
+#include "ElfImage.h"
 #include "IDebugger.h"
 #include "Util.h"
 #include "edb.h"
@@ -96,11 +97,69 @@ void ELF32::read_header() {
 				if(!process->read_bytes(region_->start(), header_, sizeof(elf32_header))) {
 					std::memset(header_, 0, sizeof(elf32_header));
 				}
+
+				// if the region is the start of a file which still looks the
+				// way it was mapped, the rest is read out of the shared view of
+				// the file instead of through the process a piece at a time
+				if(region_->base() == 0 && region_->name().startsWith('/')) {
+					const MappedFile file = MappedFile::open(region_->name());
+					if(file.size() >= static_cast<qint64>(sizeof(elf32_header)) && std::memcmp(file.data(), header_, sizeof(elf32_header)) == 0) {
+						file_ = file;
+					}
+				}
 			}
 		}
 	}
 }
 
+//------------------------------------------------------------------------------
+// Name: read_program_header
+// Desc: reads the <index>th program header, read_header must have been called
+//------------------------------------------------------------------------------
+bool ELF32::read_program_header(std::size_t index, elf32_phdr *program_header) {
+
+	Q_ASSERT(header_);
+	Q_ASSERT(program_header);
+
+	const quint64 offset = header_->e_phoff + index * sizeof(elf32_phdr);
+
+	if(file_.is_open()) {
+		if(offset + sizeof(elf32_phdr) <= static_cast<quint64>(file_.size())) {
+			std::memcpy(program_header, file_.data() + offset, sizeof(elf32_phdr));
+			return true;
+		}
+	}
+
+	if(IProcess *process = edb::v1::debugger_core->process()) {
+		return process->read_bytes(region_->start() + offset, program_header, sizeof(elf32_phdr));
+	}
+
+	return false;
+}
+
+//------------------------------------------------------------------------------
+// Name: read_section_header
+// Desc: reads the <index>th section header, read_header must have been called.
+//       The section headers aren't in any loaded segment, so this only works
+//       when the file could be mapped
+//------------------------------------------------------------------------------
+bool ELF32::read_section_header(std::size_t index, elf32_shdr *section_header) {
+
+	Q_ASSERT(header_);
+	Q_ASSERT(section_header);
+
+	const quint64 offset = header_->e_shoff + index * sizeof(elf32_shdr);
+
+	if(file_.is_open() && header_->e_shentsize == sizeof(elf32_shdr)) {
+		if(offset + sizeof(elf32_shdr) <= static_cast<quint64>(file_.size())) {
+			std::memcpy(section_header, file_.data() + offset, sizeof(elf32_shdr));
+			return true;
+		}
+	}
+
+	return false;
+}
+
 //------------------------------------------------------------------------------
 // Name: header_size
 // Desc: returns the number of bytes in this executable's header
@@ -109,25 +168,51 @@ size_t ELF32::header_size() const {
 	return sizeof(elf32_header);
 }
 
+//------------------------------------------------------------------------------
+// Name: load_bias
+// Desc: how far the image was moved from the addresses it was linked at, found
+//       from where the first loadable segment ended up. Position independent
+//       executables are linked at 0 and need this to find anything by p_vaddr
+//------------------------------------------------------------------------------
+bool ELF32::load_bias(edb::address_t *bias) {
+
+	Q_ASSERT(bias);
+
+	read_header();
+	if(region_ && header_) {
+		const std::size_t count = header_->e_phnum;
+
+		elf32_phdr section_header;
+		for(std::size_t i = 0; i < count; ++i) {
+			if(read_program_header(i, &section_header)) {
+				if(section_header.p_type == PT_LOAD) {
+					*bias = region_->start() - (section_header.p_vaddr & ~(edb::v1::debugger_core->page_size() - 1));
+					return true;
+				}
+			}
+		}
+	}
+	return false;
+}
+
 //------------------------------------------------------------------------------
 // Name: debug_pointer
 // Desc: attempts to locate the ELF debug pointer in the target process and
 //       returns it, 0 of not found
 //------------------------------------------------------------------------------
 edb::address_t ELF32::debug_pointer() {
-	read_header();
-	if(region_) {
+	edb::address_t bias;
+	if(load_bias(&bias)) {
 		if(IProcess *process = edb::v1::debugger_core->process()) {
-			const edb::address_t section_offset = header_->e_phoff;
-			const std::size_t count             = header_->e_phnum;
+			const std::size_t count = header_->e_phnum;
 
 			elf32_phdr section_header;
 			for(std::size_t i = 0; i < count; ++i) {
-				if(process->read_bytes(region_->start() + (section_offset + i * sizeof(elf32_phdr)), &section_header, sizeof(elf32_phdr))) {
+				if(read_program_header(i, &section_header)) {
 					if(section_header.p_type == PT_DYNAMIC) {
 						try {
 							QVector<quint8> buf(section_header.p_memsz);
-							if(process->read_bytes(section_header.p_vaddr, &buf[0], section_header.p_memsz)) {
+							if(process->read_bytes(section_header.p_vaddr + bias, &buf[0], section_header.p_memsz)) {
 								const elf32_dyn *dynamic = reinterpret_cast<elf32_dyn *>(&buf[0]);
 								while(dynamic->d_tag != DT_NULL) {
 									if(dynamic->d_tag == DT_DEBUG) {
@@ -141,7 +226,6 @@ edb::address_t ELF32::debug_pointer() {
 							return 0;
 						}
 					}
-			
 				}
 			}
 		}
@@ -149,6 +233,89 @@ edb::address_t ELF32::debug_pointer() {
 	return 0;
 }
 
+//------------------------------------------------------------------------------
+// Name: eh_frame_header
+// Desc: finds the mapped .eh_frame_hdr through the program headers. Its
+//       p_vaddr is as linked, so it is moved by the load bias
+//------------------------------------------------------------------------------
+edb::address_t ELF32::eh_frame_header() {
+	edb::address_t bias;
+	if(load_bias(&bias)) {
+		const std::size_t count = header_->e_phnum;
+
+		elf32_phdr section_header;
+		for(std::size_t i = 0; i < count; ++i) {
+			if(read_program_header(i, &section_header)) {
+				if(section_header.p_type == PT_GNU_EH_FRAME) {
+					return section_header.p_vaddr + bias;
+				}
+			}
+		}
+	}
+	return 0;
+}
+
+//------------------------------------------------------------------------------
+// Name: sections
+// Desc: the SHF_ALLOC sections, named from the section header string table.
+//       Their sh_addr is as linked, so they are moved by the load bias
+//------------------------------------------------------------------------------
+QList<IBinary::Section> ELF32::sections() {
+
+	QList<Section> sections;
+
+	edb::address_t bias;
+	if(load_bias(&bias)) {
+		const std::size_t count = header_->e_shnum;
+
+		elf32_shdr names;
+		if(header_->e_shstrndx >= count || !read_section_header(header_->e_shstrndx, &names) || names.sh_offset > static_cast<quint64>(file_.size())) {
+			return sections;
+		}
+
+		const char *const strings      = reinterpret_cast<const char *>(file_.data() + names.sh_offset);
+		const quint64     strings_size = qMin<quint64>(names.sh_size, file_.size() - names.sh_offset);
+
+		elf32_shdr section_header;
+		for(std::size_t i = 0; i < count; ++i) {
+			if(read_section_header(i, &section_header)) {
+				if((section_header.sh_flags & SHF_ALLOC) && section_header.sh_size != 0) {
+					Section section;
+					section.start      = section_header.sh_addr + bias;
+					section.end        = section.start + section_header.sh_size;
+					section.executable = (section_header.sh_flags & SHF_EXECINSTR) != 0;
+					if(section_header.sh_name < strings_size) {
+						const char *const name = strings + section_header.sh_name;
+						section.name = QString::fromLatin1(name, static_cast<int>(qstrnlen(name, static_cast<uint>(strings_size - section_header.sh_name))));
+					}
+					sections.push_back(section);
+				}
+			}
+		}
+	}
+
+	return sections;
+}
+
+//------------------------------------------------------------------------------
+// Name: file_image
+// Desc: only when the file on disk is the one which was mapped
+//------------------------------------------------------------------------------
+bool ELF32::file_image(QString *file, QList<ImageRange> *ranges, QList<Fixup> *fixups) {
+
+	Q_ASSERT(file);
+	Q_ASSERT(ranges);
+	Q_ASSERT(fixups);
+
+	edb::address_t bias;
+	if(!load_bias(&bias) || !file_.is_open()) {
+		return false;
+	}
+
+	*file = file_.filename();
+	return ElfImage<elf32_traits>(file_, bias).read(ranges, fixups);
+}
+
 //------------------------------------------------------------------------------
 // Name: calculate_main
 // Desc: uses a heuristic to locate "main"
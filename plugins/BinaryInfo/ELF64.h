@@ -20,6 +20,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #define ELF64_20070718_H_
 
 #include "IBinary.h"
+#include "MappedFile.h"
 #include "elf_binary.h"
 
 namespace BinaryInfo {
@@ -34,15 +35,22 @@ public:
 	virtual bool validate_header();
 	virtual edb::address_t calculate_main();
 	virtual edb::address_t debug_pointer();
+	virtual edb::address_t eh_frame_header();
+	virtual QList<Section> sections();
+	virtual bool file_image(QString *file, QList<ImageRange> *ranges, QList<Fixup> *fixups);
 	virtual edb::address_t entry_point();
 	virtual size_t header_size() const;
 	virtual const void *header() const;
 
 private:
+	bool load_bias(edb::address_t *bias);
+	bool read_program_header(std::size_t index, elf64_phdr *program_header);
+	bool read_section_header(std::size_t index, elf64_shdr *section_header);
 	void read_header();
 
 private:
 	IRegion::pointer region_;
+	MappedFile       file_;
 	elf64_header *   header_;
 };
 
@@ -0,0 +1,252 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef ELF_IMAGE_20261014_H_
+#define ELF_IMAGE_20261014_H_
+
+#include "IBinary.h"
+#include "MappedFile.h"
+#include "elf_binary.h"
+
+#include <QList>
+#include <QVector>
+#include <algorithm>
+#include <cstring>
+
+namespace BinaryInfo {
+
+struct elf32_traits {
+	typedef elf32_header header;
+	typedef elf32_phdr   phdr;
+	typedef elf32_dyn    dyn;
+	typedef elf32_rel    rel;
+	typedef elf32_rela   rela;
+	typedef elf32_addr   addr;
+
+	static quint32 type(elf32_word info) { return ELF32_R_TYPE(info); }
+	static const quint32 relative = R_386_RELATIVE;
+	static const quint32 none     = R_386_NONE;
+};
+
+struct elf64_traits {
+	typedef elf64_header header;
+	typedef elf64_phdr   phdr;
+	typedef elf64_dyn    dyn;
+	typedef elf64_rel    rel;
+	typedef elf64_rela   rela;
+	typedef elf64_addr   addr;
+
+	static quint32 type(elf64_xword info) { return ELF64_R_TYPE(info); }
+	static const quint32 relative = R_X86_64_RELATIVE;
+	static const quint32 none     = R_X86_64_NONE;
+};
+
+// the executable PT_LOAD segments of an ELF file and the dynamic relocations
+// which land in them, for IBinary::file_image. Only objects linked with text
+// relocations have any of the latter, everything else is loaded as is
+template <class Traits>
+class ElfImage {
+public:
+	ElfImage(const MappedFile &file, edb::address_t bias) : file_(file), bias_(bias) {
+	}
+
+public:
+	//------------------------------------------------------------------------------
+	// Name: read
+	// Desc:
+	//------------------------------------------------------------------------------
+	bool read(QList<IBinary::ImageRange> *ranges, QList<IBinary::Fixup> *fixups) {
+
+		Q_ASSERT(ranges);
+		Q_ASSERT(fixups);
+
+		const quint64 size = file_.size();
+		if(!file_.is_open() || size < sizeof(typename Traits::header)) {
+			return false;
+		}
+
+		typename Traits::header header;
+		std::memcpy(&header, file_.data(), sizeof(header));
+
+		if(header.e_phentsize != sizeof(typename Traits::phdr) || header.e_phoff + static_cast<quint64>(header.e_phnum) * sizeof(typename Traits::phdr) > size) {
+			return false;
+		}
+
+		segments_.resize(header.e_phnum);
+		std::memcpy(segments_.data(), file_.data() + header.e_phoff, segments_.size() * sizeof(typename Traits::phdr));
+
+		Q_FOREACH(const typename Traits::phdr &segment, segments_) {
+			if(segment.p_type == PT_LOAD && (segment.p_flags & PF_X) && segment.p_filesz != 0 && segment.p_offset + segment.p_filesz <= size) {
+				IBinary::ImageRange range;
+				range.start  = segment.p_vaddr + bias_;
+				range.end    = range.start + segment.p_filesz;
+				range.offset = segment.p_offset;
+				ranges->push_back(range);
+			}
+		}
+
+		ranges_ = *ranges;
+
+		Q_FOREACH(const typename Traits::phdr &segment, segments_) {
+			if(segment.p_type == PT_DYNAMIC && segment.p_offset + segment.p_filesz <= size) {
+				read_dynamic(segment, fixups);
+			}
+		}
+
+		std::sort(fixups->begin(), fixups->end(), fixup_less);
+		return true;
+	}
+
+private:
+	//------------------------------------------------------------------------------
+	// Name: fixup_less
+	// Desc:
+	//------------------------------------------------------------------------------
+	static bool fixup_less(const IBinary::Fixup &lhs, const IBinary::Fixup &rhs) {
+		return lhs.address < rhs.address;
+	}
+
+	//------------------------------------------------------------------------------
+	// Name: file_offset
+	// Desc: where the linked address <address> is in the file, 0 if it isn't
+	//------------------------------------------------------------------------------
+	quint64 file_offset(quint64 address) const {
+		Q_FOREACH(const typename Traits::phdr &segment, segments_) {
+			if(segment.p_type == PT_LOAD && address >= segment.p_vaddr && address - segment.p_vaddr < segment.p_filesz) {
+				return segment.p_offset + (address - segment.p_vaddr);
+			}
+		}
+		return 0;
+	}
+
+	//------------------------------------------------------------------------------
+	// Name: in_ranges
+	// Desc:
+	//------------------------------------------------------------------------------
+	bool in_ranges(edb::address_t address) const {
+		Q_FOREACH(const IBinary::ImageRange &range, ranges_) {
+			if(address >= range.start && address < range.end) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+	//------------------------------------------------------------------------------
+	// Name: read_dynamic
+	// Desc: finds the relocation tables through the dynamic section
+	//------------------------------------------------------------------------------
+	void read_dynamic(const typename Traits::phdr &segment, QList<IBinary::Fixup> *fixups) const {
+
+		quint64 rel       = 0;
+		quint64 rel_size  = 0;
+		quint64 rela      = 0;
+		quint64 rela_size = 0;
+		quint64 plt       = 0;
+		quint64 plt_size  = 0;
+		quint64 plt_type  = DT_REL;
+
+		const std::size_t count = segment.p_filesz / sizeof(typename Traits::dyn);
+		for(std::size_t i = 0; i < count; ++i) {
+			typename Traits::dyn dynamic;
+			std::memcpy(&dynamic, file_.data() + segment.p_offset + i * sizeof(dynamic), sizeof(dynamic));
+
+			switch(dynamic.d_tag) {
+			case DT_REL:      rel       = dynamic.d_un.d_ptr; break;
+			case DT_RELSZ:    rel_size  = dynamic.d_un.d_val; break;
+			case DT_RELA:     rela      = dynamic.d_un.d_ptr; break;
+			case DT_RELASZ:   rela_size = dynamic.d_un.d_val; break;
+			case DT_JMPREL:   plt       = dynamic.d_un.d_ptr; break;
+			case DT_PLTRELSZ: plt_size  = dynamic.d_un.d_val; break;
+			case DT_PLTREL:   plt_type  = dynamic.d_un.d_val; break;
+			default:
+				break;
+			}
+
+			if(dynamic.d_tag == DT_NULL) {
+				break;
+			}
+		}
+
+		read_relocations<typename Traits::rel>(rel, rel_size, false, fixups);
+		read_relocations<typename Traits::rela>(rela, rela_size, true, fixups);
+
+		if(plt_type == DT_RELA) {
+			read_relocations<typename Traits::rela>(plt, plt_size, true, fixups);
+		} else {
+			read_relocations<typename Traits::rel>(plt, plt_size, false, fixups);
+		}
+	}
+
+	//------------------------------------------------------------------------------
+	// Name: addend
+	// Desc:
+	//------------------------------------------------------------------------------
+	static quint64 addend(const typename Traits::rel &)    { return 0; }
+	static quint64 addend(const typename Traits::rela &r)  { return r.r_addend; }
+
+	//------------------------------------------------------------------------------
+	// Name: read_relocations
+	// Desc: the relocations at linked address <address> which land in one of
+	//       the executable ranges. Relative ones can be worked out, anything
+	//       else depends on symbols from other objects
+	//------------------------------------------------------------------------------
+	template <class Rel>
+	void read_relocations(quint64 address, quint64 table_size, bool has_addend, QList<IBinary::Fixup> *fixups) const {
+
+		const quint64 offset = address ? file_offset(address) : 0;
+		if(offset == 0 || offset + table_size > static_cast<quint64>(file_.size())) {
+			return;
+		}
+
+		const std::size_t count = table_size / sizeof(Rel);
+		for(std::size_t i = 0; i < count; ++i) {
+			Rel relocation;
+			std::memcpy(&relocation, file_.data() + offset + i * sizeof(relocation), sizeof(relocation));
+
+			const quint32 type = Traits::type(relocation.r_info);
+			const edb::address_t target = relocation.r_offset + bias_;
+			if(type == Traits::none || !in_ranges(target)) {
+				continue;
+			}
+
+			IBinary::Fixup fixup;
+			fixup.address = target;
+			fixup.size    = sizeof(typename Traits::addr);
+			fixup.kind    = IBinary::Fixup::FIXUP_ANY;
+			fixup.value   = 0;
+
+			if(type == Traits::relative) {
+				fixup.kind  = has_addend ? IBinary::Fixup::FIXUP_SET : IBinary::Fixup::FIXUP_ADD;
+				fixup.value = has_addend ? bias_ + addend(relocation) : bias_;
+			}
+
+			fixups->push_back(fixup);
+		}
+	}
+
+private:
+	MappedFile                         file_;
+	edb::address_t                     bias_;
+	QVector<typename Traits::phdr>     segments_;
+	QList<IBinary::ImageRange>         ranges_;
+};
+
+}
+
+#endif
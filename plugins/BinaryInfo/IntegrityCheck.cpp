@@ -0,0 +1,251 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "IntegrityCheck.h"
+#include "IBinary.h"
+#include "IDebugger.h"
+#include "IProcess.h"
+#include "IRegion.h"
+#include "MappedFile.h"
+#include "MemoryRegions.h"
+#include "edb.h"
+
+#include <QScopedPointer>
+#include <QSet>
+#include <cstring>
+
+namespace BinaryInfo {
+namespace {
+
+// differences closer together than this are one modification, a hook is
+// one instruction (or a few) but rarely changes every byte of them
+const edb::address_t merge_distance = 8;
+
+// how much of a range is read from the process at a time
+const edb::address_t chunk_size = 1 << 20;
+
+//------------------------------------------------------------------------------
+// Name: apply_fixups
+// Desc: makes <expected>, which holds the file's bytes for [start, start +
+//       size) of <range>, what the loader would have made of them. Bytes
+//       nobody can predict are taken from <actual>. <next> is the first of
+//       the (sorted) fixups which may still reach this far
+//------------------------------------------------------------------------------
+void apply_fixups(const IBinary::ImageRange &range, const uchar *file, edb::address_t start, const QByteArray &actual, QByteArray *expected, const QList<IBinary::Fixup> &fixups, int *next) {
+
+	const edb::address_t end = start + expected->size();
+
+	while(*next < fixups.size() && fixups[*next].address + fixups[*next].size <= start) {
+		++*next;
+	}
+
+	for(int i = *next; i < fixups.size() && fixups[i].address < end; ++i) {
+		const IBinary::Fixup &fixup = fixups[i];
+		const quint32 size = qMin<quint32>(fixup.size, sizeof(quint64));
+
+		// a fixup may straddle two chunks, its value comes from the whole of it
+		quint64 value = 0;
+		for(quint32 j = 0; j < size; ++j) {
+			const edb::address_t address = fixup.address + j;
+			if(address >= range.start && address < range.end) {
+				value |= static_cast<quint64>(file[range.offset + (address - range.start)]) << (j * 8);
+			}
+		}
+
+		switch(fixup.kind) {
+		case IBinary::Fixup::FIXUP_ADD:
+			value += fixup.value;
+			break;
+		case IBinary::Fixup::FIXUP_SET:
+			value = fixup.value;
+			break;
+		case IBinary::Fixup::FIXUP_ANY:
+			break;
+		}
+
+		for(quint32 j = 0; j < size; ++j) {
+			const edb::address_t address = fixup.address + j;
+			if(address >= start && address < end) {
+				const int n = address - start;
+				(*expected)[n] = (fixup.kind == IBinary::Fixup::FIXUP_ANY) ? actual[n] : static_cast<char>(value >> (j * 8));
+			}
+		}
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: read_chunk
+// Desc: reads [start, start + size) all at once if it can, a page at a time
+//       if it can't. Pages which can't be read at all are given the expected
+//       bytes, so that they compare equal
+//------------------------------------------------------------------------------
+void read_chunk(IProcess *process, edb::address_t start, const QByteArray &expected, QByteArray *actual) {
+
+	if(process->read_bytes(start, actual->data(), actual->size())) {
+		return;
+	}
+
+	const edb::address_t page_size = edb::v1::debugger_core->page_size();
+	const edb::address_t end       = start + actual->size();
+
+	for(edb::address_t address = start; address < end; ) {
+		const edb::address_t next = qMin((address & ~(page_size - 1)) + page_size, end);
+		const int n = address - start;
+		if(!process->read_bytes(address, actual->data() + n, next - address)) {
+			std::memcpy(actual->data() + n, expected.constData() + n, next - address);
+		}
+		address = next;
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: add_modification
+// Desc: the bytes [first, last] of a chunk starting at <chunk>
+//------------------------------------------------------------------------------
+void add_modification(const QString &module, edb::address_t chunk, const QByteArray &expected, const QByteArray &actual, int first, int last, QList<Modification> *results) {
+	Modification modification;
+	modification.module   = module;
+	modification.address  = chunk + first;
+	modification.expected = expected.mid(first, last - first + 1);
+	modification.actual   = actual.mid(first, last - first + 1);
+	results->push_back(modification);
+}
+
+//------------------------------------------------------------------------------
+// Name: compare_range
+// Desc:
+//------------------------------------------------------------------------------
+void compare_range(IProcess *process, const QString &module, const MappedFile &file, const IBinary::ImageRange &range, const QList<IBinary::Fixup> &fixups, QList<Modification> *results, IntegrityStats *stats) {
+
+	if(range.offset + (range.end - range.start) > static_cast<quint64>(file.size())) {
+		return;
+	}
+
+	const edb::address_t page_size = edb::v1::debugger_core->page_size();
+
+	int next = 0;
+	for(edb::address_t chunk = range.start; chunk < range.end; chunk += chunk_size) {
+
+		const int size = static_cast<int>(qMin(chunk_size, range.end - chunk));
+
+		QByteArray expected(reinterpret_cast<const char *>(file.data() + range.offset + (chunk - range.start)), size);
+		QByteArray actual(size, '\0');
+
+		read_chunk(process, chunk, expected, &actual);
+		apply_fixups(range, file.data(), chunk, actual, &expected, fixups, &next);
+
+		// the run of differences being built, which may go on into the next
+		// page if that one changed too
+		int run_first = -1;
+		int run_last  = -1;
+
+		for(int page = 0; page < size; ) {
+			const int page_end = static_cast<int>(qMin<edb::address_t>(((chunk + page) & ~(page_size - 1)) + page_size - chunk, size));
+
+			++stats->pages;
+
+			if(std::memcmp(expected.constData() + page, actual.constData() + page, page_end - page) != 0) {
+				++stats->changed_pages;
+
+				for(int i = page; i < page_end; ++i) {
+					if(expected[i] == actual[i]) {
+						continue;
+					}
+
+					if(run_first != -1 && static_cast<edb::address_t>(i - run_last) > merge_distance) {
+						add_modification(module, chunk, expected, actual, run_first, run_last, results);
+						run_first = -1;
+					}
+
+					if(run_first == -1) {
+						run_first = i;
+					}
+					run_last = i;
+				}
+			} else if(run_first != -1) {
+				add_modification(module, chunk, expected, actual, run_first, run_last, results);
+				run_first = -1;
+			}
+
+			page = page_end;
+		}
+
+		if(run_first != -1) {
+			add_modification(module, chunk, expected, actual, run_first, run_last, results);
+		}
+	}
+}
+
+}
+
+//------------------------------------------------------------------------------
+// Name: find_modifications
+// Desc: a module is found by the region which maps the start of its file,
+//       modules whose file can't be found or doesn't match are left out
+//------------------------------------------------------------------------------
+QList<Modification> find_modifications(IntegrityStats *stats) {
+
+	Q_ASSERT(stats);
+
+	stats->modules       = 0;
+	stats->pages         = 0;
+	stats->changed_pages = 0;
+
+	QList<Modification> results;
+
+	IProcess *const process = edb::v1::debugger_core ? edb::v1::debugger_core->process() : 0;
+	if(!process) {
+		return results;
+	}
+
+	QSet<QString> seen;
+	Q_FOREACH(const IRegion::pointer &region, edb::v1::memory_regions().regions()) {
+
+		if(region->base() != 0 || !region->name().startsWith('/') || seen.contains(region->name())) {
+			continue;
+		}
+
+		QScopedPointer<IBinary> binary(edb::v1::get_binary_info(region));
+		if(!binary) {
+			continue;
+		}
+
+		QString filename;
+		QList<IBinary::ImageRange> ranges;
+		QList<IBinary::Fixup> fixups;
+		if(!binary->file_image(&filename, &ranges, &fixups)) {
+			continue;
+		}
+
+		const MappedFile file = MappedFile::open(filename);
+		if(!file.is_open()) {
+			continue;
+		}
+
+		seen.insert(region->name());
+		++stats->modules;
+
+		Q_FOREACH(const IBinary::ImageRange &range, ranges) {
+			compare_range(process, region->name(), file, range, fixups, &results, stats);
+		}
+	}
+
+	return results;
+}
+
+}
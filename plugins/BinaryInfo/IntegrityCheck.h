@@ -0,0 +1,52 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef INTEGRITY_CHECK_20261014_H_
+#define INTEGRITY_CHECK_20261014_H_
+
+#include "Types.h"
+#include <QByteArray>
+#include <QList>
+#include <QString>
+
+namespace BinaryInfo {
+
+// a run of a module's code which isn't what its file on disk says it should
+// be: an inline hook, a breakpoint someone else set, or a patch
+struct Modification {
+	QString        module;
+	edb::address_t address;
+	QByteArray     expected;
+	QByteArray     actual;
+};
+
+struct IntegrityStats {
+	int     modules;       // how many could be compared with their files
+	quint64 pages;         // how many pages of code were compared
+	quint64 changed_pages; // how many of them had any differences
+};
+
+// compares the executable parts of every loaded module with the file they
+// were loaded from, after applying what the loader is expected to have
+// relocated. Memory is read a range at a time, identical pages cost a single
+// compare and only the others are looked at byte by byte
+QList<Modification> find_modifications(IntegrityStats *stats);
+
+}
+
+#endif
@@ -17,71 +17,356 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
 #include "PE32.h"
+#include "IDebugger.h"
+#include "edb.h"
 #include "string_hash.h"
 #include "pe_binary.h"
 
+#include <QVector>
+#include <algorithm>
+#include <cstring>
+
 namespace BinaryInfo {
+namespace {
 
 //------------------------------------------------------------------------------
-// Name:
+// Name: fixup_less
 // Desc:
 //------------------------------------------------------------------------------
-PE32::PE32(const IRegion::pointer &region) : region_(region) {
+bool fixup_less(const IBinary::Fixup &lhs, const IBinary::Fixup &rhs) {
+	return lhs.address < rhs.address;
+}
+
 }
 
 //------------------------------------------------------------------------------
-// Name:
-// Desc:
+// Name: PE32
+// Desc: constructor
+//------------------------------------------------------------------------------
+PE32::PE32(const IRegion::pointer &region) : region_(region), header_read_(false) {
+	std::memset(&dos_header_, 0, sizeof(dos_header_));
+}
+
+//------------------------------------------------------------------------------
+// Name: ~PE32
+// Desc: deconstructor
 //------------------------------------------------------------------------------
 PE32::~PE32() {
 }
 
 //------------------------------------------------------------------------------
-// Name:
-// Desc:
+// Name: read_header
+// Desc: reads the DOS header and the NT headers it points to, nt_headers_ is
+//       left empty unless both have the right signatures
+//------------------------------------------------------------------------------
+void PE32::read_header() {
+	if(!header_read_) {
+		header_read_ = true;
+
+		IProcess *const process = edb::v1::debugger_core->process();
+		if(!process || !region_) {
+			return;
+		}
+
+		if(!process->read_bytes(region_->start(), &dos_header_, sizeof(dos_header_)) || dos_header_.e_magic != IMAGE_DOS_SIGNATURE || dos_header_.e_lfanew <= 0) {
+			return;
+		}
+
+		const edb::address_t address = region_->start() + dos_header_.e_lfanew;
+
+		QByteArray headers(sizeof(IMAGE_NT_HEADERS32), '\0');
+		if(!process->read_bytes(address, headers.data(), headers.size())) {
+			return;
+		}
+
+		const IMAGE_NT_HEADERS32 *const nt_headers = reinterpret_cast<const IMAGE_NT_HEADERS32 *>(headers.constData());
+		if(nt_headers->Signature != IMAGE_NT_SIGNATURE) {
+			return;
+		}
+
+		switch(nt_headers->OptionalHeader.Magic) {
+		case IMAGE_NT_OPTIONAL_HDR32_MAGIC:
+			nt_headers_ = headers;
+			break;
+		case IMAGE_NT_OPTIONAL_HDR64_MAGIC:
+			headers.resize(sizeof(IMAGE_NT_HEADERS64));
+			if(process->read_bytes(address, headers.data(), headers.size())) {
+				nt_headers_ = headers;
+			}
+			break;
+		default:
+			break;
+		}
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: pe32_plus
+// Desc: true if the image is 64-bit, read_header must have found it valid
+//------------------------------------------------------------------------------
+bool PE32::pe32_plus() const {
+	Q_ASSERT(!nt_headers_.isEmpty());
+	return nt_headers_.size() == sizeof(IMAGE_NT_HEADERS64);
+}
+
+//------------------------------------------------------------------------------
+// Name: file_header
+// Desc: the same in both kinds of NT headers
+//------------------------------------------------------------------------------
+const IMAGE_FILE_HEADER &PE32::file_header() const {
+	Q_ASSERT(!nt_headers_.isEmpty());
+	return reinterpret_cast<const IMAGE_NT_HEADERS32 *>(nt_headers_.constData())->FileHeader;
+}
+
+//------------------------------------------------------------------------------
+// Name: validate_header
+// Desc: returns true if this file matches this particular info class
 //------------------------------------------------------------------------------
 bool PE32::validate_header() {
-	return false;
+	read_header();
+	return !nt_headers_.isEmpty();
 }
 
 //------------------------------------------------------------------------------
-// Name:
-// Desc:
+// Name: entry_point
+// Desc: returns the entry point if any of the binary, DLLs usually have one
+//       too, which the loader calls as it attaches and detaches them
 //------------------------------------------------------------------------------
 edb::address_t PE32::entry_point() {
+	read_header();
+	if(!nt_headers_.isEmpty()) {
+
+		const DWORD entry = pe32_plus()
+			? reinterpret_cast<const IMAGE_NT_HEADERS64 *>(nt_headers_.constData())->OptionalHeader.AddressOfEntryPoint
+			: reinterpret_cast<const IMAGE_NT_HEADERS32 *>(nt_headers_.constData())->OptionalHeader.AddressOfEntryPoint;
+
+		if(entry != 0) {
+			return region_->start() + entry;
+		}
+	}
 	return 0;
 }
 
 //------------------------------------------------------------------------------
-// Name:
+// Name: read_section_headers
 // Desc:
 //------------------------------------------------------------------------------
+bool PE32::read_section_headers(QVector<IMAGE_SECTION_HEADER> *section_headers) {
+
+	Q_ASSERT(section_headers);
+
+	read_header();
+	if(nt_headers_.isEmpty()) {
+		return false;
+	}
+
+	IProcess *const process = edb::v1::debugger_core->process();
+	if(!process) {
+		return false;
+	}
+
+	const IMAGE_FILE_HEADER &header = file_header();
+	const edb::address_t     table  = region_->start() + dos_header_.e_lfanew + sizeof(DWORD) + sizeof(IMAGE_FILE_HEADER) + header.SizeOfOptionalHeader;
+
+	section_headers->resize(header.NumberOfSections);
+	return !section_headers->isEmpty() && process->read_bytes(table, section_headers->data(), section_headers->size() * sizeof(IMAGE_SECTION_HEADER));
+}
+
+//------------------------------------------------------------------------------
+// Name: sections
+// Desc: the section table, moved to where the image was loaded
+//------------------------------------------------------------------------------
+QList<IBinary::Section> PE32::sections() {
+
+	QList<Section> sections;
+
+	QVector<IMAGE_SECTION_HEADER> section_headers;
+	if(!read_section_headers(&section_headers)) {
+		return sections;
+	}
+
+	Q_FOREACH(const IMAGE_SECTION_HEADER &section_header, section_headers) {
+
+		// the virtual size isn't always filled in, the raw size is then all
+		// there is of it
+		const DWORD size = section_header.VirtualSize ? section_header.VirtualSize : section_header.SizeOfRawData;
+		if(size == 0) {
+			continue;
+		}
+
+		Section section;
+		section.name       = QString::fromLatin1(reinterpret_cast<const char *>(section_header.Name), static_cast<int>(qstrnlen(reinterpret_cast<const char *>(section_header.Name), IMAGE_SIZEOF_SHORT_NAME)));
+		section.start      = region_->start() + section_header.VirtualAddress;
+		section.end        = section.start + size;
+		section.executable = (section_header.Characteristics & (IMAGE_SCN_MEM_EXECUTE | IMAGE_SCN_CNT_CODE)) != 0;
+		sections.push_back(section);
+	}
+
+	return sections;
+}
+
+//------------------------------------------------------------------------------
+// Name: file_image
+// Desc: the raw data of the executable sections, with the base relocations
+//       which land in them moved by how far the image is from its ImageBase
+//------------------------------------------------------------------------------
+bool PE32::file_image(QString *file, QList<ImageRange> *ranges, QList<Fixup> *fixups) {
+
+	Q_ASSERT(file);
+	Q_ASSERT(ranges);
+	Q_ASSERT(fixups);
+
+	QVector<IMAGE_SECTION_HEADER> section_headers;
+	if(!read_section_headers(&section_headers)) {
+		return false;
+	}
+
+	const MappedFile mapped = MappedFile::open(region_->name());
+	if(!mapped.is_open()) {
+		return false;
+	}
+
+	const quint64 file_size = mapped.size();
+
+	Q_FOREACH(const IMAGE_SECTION_HEADER &section_header, section_headers) {
+		if(section_header.Characteristics & (IMAGE_SCN_MEM_EXECUTE | IMAGE_SCN_CNT_CODE)) {
+			const DWORD size = section_header.VirtualSize ? qMin(section_header.VirtualSize, section_header.SizeOfRawData) : section_header.SizeOfRawData;
+			if(size != 0 && static_cast<quint64>(section_header.PointerToRawData) + size <= file_size) {
+				ImageRange range;
+				range.start  = region_->start() + section_header.VirtualAddress;
+				range.end    = range.start + size;
+				range.offset = section_header.PointerToRawData;
+				ranges->push_back(range);
+			}
+		}
+	}
+
+	quint64 image_base;
+	IMAGE_DATA_DIRECTORY relocations;
+	if(pe32_plus()) {
+		const IMAGE_OPTIONAL_HEADER64 &optional = reinterpret_cast<const IMAGE_NT_HEADERS64 *>(nt_headers_.constData())->OptionalHeader;
+		image_base  = optional.ImageBase;
+		relocations = optional.DataDirectory[IMAGE_DIRECTORY_ENTRY_BASERELOC];
+	} else {
+		const IMAGE_OPTIONAL_HEADER32 &optional = reinterpret_cast<const IMAGE_NT_HEADERS32 *>(nt_headers_.constData())->OptionalHeader;
+		image_base  = optional.ImageBase;
+		relocations = optional.DataDirectory[IMAGE_DIRECTORY_ENTRY_BASERELOC];
+	}
+
+	*file = mapped.filename();
+
+	// loaded where it was linked for, nothing was moved
+	const quint64 delta = region_->start() - image_base;
+	if(delta == 0 || relocations.Size == 0) {
+		return true;
+	}
+
+	// the relocations are read from the file, where the section they are in
+	// is found by its RVA
+	quint64 offset = 0;
+	Q_FOREACH(const IMAGE_SECTION_HEADER &section_header, section_headers) {
+		if(relocations.VirtualAddress >= section_header.VirtualAddress && relocations.VirtualAddress - section_header.VirtualAddress < section_header.SizeOfRawData) {
+			offset = section_header.PointerToRawData + (relocations.VirtualAddress - section_header.VirtualAddress);
+			break;
+		}
+	}
+
+	if(offset == 0 || offset + relocations.Size > file_size) {
+		return true;
+	}
+
+	const uchar *const data = mapped.data() + offset;
+	quint64 position = 0;
+	while(position + sizeof(IMAGE_BASE_RELOCATION) <= relocations.Size) {
+		IMAGE_BASE_RELOCATION block;
+		std::memcpy(&block, data + position, sizeof(block));
+		if(block.SizeOfBlock < sizeof(block) || position + block.SizeOfBlock > relocations.Size) {
+			break;
+		}
+
+		const std::size_t count = (block.SizeOfBlock - sizeof(block)) / sizeof(WORD);
+		for(std::size_t i = 0; i < count; ++i) {
+			WORD entry;
+			std::memcpy(&entry, data + position + sizeof(block) + i * sizeof(WORD), sizeof(entry));
+
+			Fixup fixup;
+			fixup.address = region_->start() + block.VirtualAddress + (entry & 0x0fff);
+			fixup.kind    = Fixup::FIXUP_ADD;
+			fixup.value   = delta;
+
+			switch(entry >> 12) {
+			case IMAGE_REL_BASED_ABSOLUTE:
+				continue;
+			case IMAGE_REL_BASED_HIGHLOW:
+				fixup.size = sizeof(DWORD);
+				break;
+			case IMAGE_REL_BASED_DIR64:
+				fixup.size = sizeof(ULONGLONG);
+				break;
+			default:
+				fixup.size = sizeof(DWORD);
+				fixup.kind = Fixup::FIXUP_ANY;
+				break;
+			}
+
+			Q_FOREACH(const ImageRange &range, *ranges) {
+				if(fixup.address >= range.start && fixup.address < range.end) {
+					fixups->push_back(fixup);
+					break;
+				}
+			}
+		}
+
+		position += block.SizeOfBlock;
+	}
+
+	std::sort(fixups->begin(), fixups->end(), fixup_less);
+	return true;
+}
+
+//------------------------------------------------------------------------------
+// Name: calculate_main
+// Desc: every compiler's C runtime gets to main in its own way, so there is
+//       nothing here to go on
+//------------------------------------------------------------------------------
 edb::address_t PE32::calculate_main() {
 	return 0;
 }
 
 //------------------------------------------------------------------------------
-// Name:
-// Desc:
+// Name: native
+// Desc: returns true if this binary is native to the arch edb was built for
 //------------------------------------------------------------------------------
 bool PE32::native() const {
-	return true;
+	if(nt_headers_.isEmpty()) {
+		return false;
+	}
+
+	switch(file_header().Machine) {
+	case IMAGE_FILE_MACHINE_I386:
+		return edb::v1::debugger_core->cpu_type() == edb::string_hash<'x', '8', '6'>::value;
+	case IMAGE_FILE_MACHINE_AMD64:
+		return edb::v1::debugger_core->cpu_type() == edb::string_hash<'x', '8', '6', '-', '6', '4'>::value;
+	default:
+		return false;
+	}
 }
 
 //------------------------------------------------------------------------------
-// Name:
-// Desc:
+// Name: debug_pointer
+// Desc: the Windows loader has no r_debug for debuggers to follow, the core
+//       hears about DLLs from the OS instead
 //------------------------------------------------------------------------------
 edb::address_t PE32::debug_pointer() {
 	return 0;
 }
 
 //------------------------------------------------------------------------------
-// Name:
-// Desc:
+// Name: header_size
+// Desc: returns the number of bytes in this executable's header
 //------------------------------------------------------------------------------
 size_t PE32::header_size() const {
-	return 0;
+	return nt_headers_.size();
 }
 
 //------------------------------------------------------------------------------
@@ -90,7 +375,7 @@ size_t PE32::header_size() const {
 //       known binary type
 //------------------------------------------------------------------------------
 const void *PE32::header() const {
-	return 0;
+	return nt_headers_.isEmpty() ? 0 : nt_headers_.constData();
 }
 
 }
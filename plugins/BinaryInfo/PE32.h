@@ -20,10 +20,16 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #define PE32_20070718_H_
 
 #include "IBinary.h"
+#include "MappedFile.h"
 #include "pe_binary.h"
+#include <QByteArray>
+#include <QVector>
 
 namespace BinaryInfo {
 
+// PE32 and PE32+ images, read through the process. The image is mapped the
+// way the loader laid it out, so everything is found by its RVA from the start
+// of the region
 class PE32 : public IBinary {
 public:
 	PE32(const IRegion::pointer &region);
@@ -35,11 +41,22 @@ public:
 	virtual edb::address_t calculate_main();
 	virtual edb::address_t debug_pointer();
 	virtual edb::address_t entry_point();
+	virtual QList<Section> sections();
+	virtual bool file_image(QString *file, QList<ImageRange> *ranges, QList<Fixup> *fixups);
 	virtual size_t header_size() const;
 	virtual const void *header() const;
-	
+
+private:
+	bool pe32_plus() const;
+	const IMAGE_FILE_HEADER &file_header() const;
+	bool read_section_headers(QVector<IMAGE_SECTION_HEADER> *section_headers);
+	void read_header();
+
 private:
 	IRegion::pointer region_;
+	IMAGE_DOS_HEADER dos_header_;
+	QByteArray       nt_headers_; // an IMAGE_NT_HEADERS32 or IMAGE_NT_HEADERS64, empty if it isn't valid
+	bool             header_read_;
 };
 
 }
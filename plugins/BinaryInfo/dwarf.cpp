@@ -0,0 +1,1230 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "dwarf.h"
+
+#include <QSet>
+
+#include <algorithm>
+#include <cstring>
+
+namespace BinaryInfo {
+namespace {
+
+enum {
+	DW_TAG_compile_unit = 0x11,
+	DW_TAG_subprogram   = 0x2e,
+	DW_TAG_partial_unit = 0x3c,
+	DW_TAG_skeleton_unit = 0x4a
+};
+
+enum {
+	DW_AT_name               = 0x03,
+	DW_AT_stmt_list          = 0x10,
+	DW_AT_low_pc             = 0x11,
+	DW_AT_high_pc            = 0x12,
+	DW_AT_comp_dir           = 0x1b,
+	DW_AT_abstract_origin    = 0x31,
+	DW_AT_declaration        = 0x3c,
+	DW_AT_specification      = 0x47,
+	DW_AT_ranges             = 0x55,
+	DW_AT_linkage_name       = 0x6e,
+	DW_AT_str_offsets_base   = 0x72,
+	DW_AT_addr_base          = 0x73,
+	DW_AT_rnglists_base      = 0x74,
+	DW_AT_MIPS_linkage_name  = 0x2007,
+	DW_AT_GNU_addr_base      = 0x2133,
+	DW_AT_GNU_ranges_base    = 0x2132
+};
+
+enum {
+	DW_FORM_addr           = 0x01,
+	DW_FORM_block2         = 0x03,
+	DW_FORM_block4         = 0x04,
+	DW_FORM_data2          = 0x05,
+	DW_FORM_data4          = 0x06,
+	DW_FORM_data8          = 0x07,
+	DW_FORM_string         = 0x08,
+	DW_FORM_block          = 0x09,
+	DW_FORM_block1         = 0x0a,
+	DW_FORM_data1          = 0x0b,
+	DW_FORM_flag           = 0x0c,
+	DW_FORM_sdata          = 0x0d,
+	DW_FORM_strp           = 0x0e,
+	DW_FORM_udata          = 0x0f,
+	DW_FORM_ref_addr       = 0x10,
+	DW_FORM_ref1           = 0x11,
+	DW_FORM_ref2           = 0x12,
+	DW_FORM_ref4           = 0x13,
+	DW_FORM_ref8           = 0x14,
+	DW_FORM_ref_udata      = 0x15,
+	DW_FORM_indirect       = 0x16,
+	DW_FORM_sec_offset     = 0x17,
+	DW_FORM_exprloc        = 0x18,
+	DW_FORM_flag_present   = 0x19,
+	DW_FORM_strx           = 0x1a,
+	DW_FORM_addrx          = 0x1b,
+	DW_FORM_ref_sup4       = 0x1c,
+	DW_FORM_strp_sup       = 0x1d,
+	DW_FORM_data16         = 0x1e,
+	DW_FORM_line_strp      = 0x1f,
+	DW_FORM_ref_sig8       = 0x20,
+	DW_FORM_implicit_const = 0x21,
+	DW_FORM_loclistx       = 0x22,
+	DW_FORM_rnglistx       = 0x23,
+	DW_FORM_ref_sup8       = 0x24,
+	DW_FORM_strx1          = 0x25,
+	DW_FORM_strx2          = 0x26,
+	DW_FORM_strx3          = 0x27,
+	DW_FORM_strx4          = 0x28,
+	DW_FORM_addrx1         = 0x29,
+	DW_FORM_addrx2         = 0x2a,
+	DW_FORM_addrx3         = 0x2b,
+	DW_FORM_addrx4         = 0x2c,
+	DW_FORM_GNU_addr_index = 0x1f01,
+	DW_FORM_GNU_str_index  = 0x1f02,
+	DW_FORM_GNU_ref_alt    = 0x1f20,
+	DW_FORM_GNU_strp_alt   = 0x1f21
+};
+
+enum {
+	DW_UT_compile       = 0x01,
+	DW_UT_type          = 0x02,
+	DW_UT_partial       = 0x03,
+	DW_UT_skeleton      = 0x04,
+	DW_UT_split_compile = 0x05,
+	DW_UT_split_type    = 0x06
+};
+
+enum {
+	DW_LNS_copy               = 0x01,
+	DW_LNS_advance_pc         = 0x02,
+	DW_LNS_advance_line       = 0x03,
+	DW_LNS_set_file           = 0x04,
+	DW_LNS_set_column         = 0x05,
+	DW_LNS_negate_stmt        = 0x06,
+	DW_LNS_set_basic_block    = 0x07,
+	DW_LNS_const_add_pc       = 0x08,
+	DW_LNS_fixed_advance_pc   = 0x09,
+	DW_LNS_set_prologue_end   = 0x0a,
+	DW_LNS_set_epilogue_begin = 0x0b,
+	DW_LNS_set_isa            = 0x0c
+};
+
+enum {
+	DW_LNE_end_sequence = 0x01,
+	DW_LNE_set_address  = 0x02
+};
+
+enum {
+	DW_LNCT_path            = 0x1,
+	DW_LNCT_directory_index = 0x2
+};
+
+enum {
+	DW_RLE_end_of_list   = 0x00,
+	DW_RLE_base_addressx = 0x01,
+	DW_RLE_startx_endx   = 0x02,
+	DW_RLE_startx_length = 0x03,
+	DW_RLE_offset_pair   = 0x04,
+	DW_RLE_base_address  = 0x05,
+	DW_RLE_start_end     = 0x06,
+	DW_RLE_start_length  = 0x07
+};
+
+//------------------------------------------------------------------------------
+// Name: string_at
+// Desc: a nul terminated string inside <section>, or NULL
+//------------------------------------------------------------------------------
+const char *string_at(const QByteArray &section, quint64 offset) {
+	if(offset < static_cast<quint64>(section.size())) {
+		const char *const s = section.constData() + offset;
+		if(std::memchr(s, 0, section.size() - offset)) {
+			return s;
+		}
+	}
+	return 0;
+}
+
+//------------------------------------------------------------------------------
+// Name: join_path
+// Desc:
+//------------------------------------------------------------------------------
+QString join_path(const QString &directory, const QString &name) {
+	if(name.startsWith('/') || directory.isEmpty()) {
+		return name;
+	}
+	return directory + '/' + name;
+}
+
+}
+
+// reads the little endian encodings DWARF uses, running off the end of the
+// data makes every later read return 0 and ok() false
+class DwarfReader::Cursor {
+public:
+	Cursor(const QByteArray &data, quint64 offset) : data_(reinterpret_cast<const uchar *>(data.constData())), size_(data.size()), offset_(offset), ok_(offset <= size_) {
+	}
+
+public:
+	bool ok() const         { return ok_; }
+	quint64 offset() const  { return offset_; }
+	void seek(quint64 offset) {
+		offset_ = offset;
+		ok_     = ok_ && offset <= size_;
+	}
+
+	void skip(quint64 n) {
+		if(!ok_ || n > size_ - offset_) {
+			ok_ = false;
+			return;
+		}
+		offset_ += n;
+	}
+
+	quint64 uint(int n) {
+		if(!ok_ || static_cast<quint64>(n) > size_ - offset_ || n > 8) {
+			ok_ = false;
+			return 0;
+		}
+
+		quint64 value = 0;
+		for(int i = 0; i < n; ++i) {
+			value |= static_cast<quint64>(data_[offset_ + i]) << (i * 8);
+		}
+		offset_ += n;
+		return value;
+	}
+
+	quint8 u8()   { return uint(1); }
+	quint16 u16() { return uint(2); }
+	quint32 u32() { return uint(4); }
+	quint64 u64() { return uint(8); }
+	quint64 offset_value(bool dwarf64) { return uint(dwarf64 ? 8 : 4); }
+
+	quint64 uleb() {
+		quint64 value = 0;
+		int shift     = 0;
+		while(ok_) {
+			const quint8 byte = u8();
+			if(shift < 64) {
+				value |= static_cast<quint64>(byte & 0x7f) << shift;
+			}
+			shift += 7;
+			if(!(byte & 0x80)) {
+				break;
+			}
+		}
+		return value;
+	}
+
+	qint64 sleb() {
+		quint64 value = 0;
+		int shift     = 0;
+		quint8 byte   = 0;
+		while(ok_) {
+			byte = u8();
+			if(shift < 64) {
+				value |= static_cast<quint64>(byte & 0x7f) << shift;
+			}
+			shift += 7;
+			if(!(byte & 0x80)) {
+				break;
+			}
+		}
+		if(shift < 64 && (byte & 0x40)) {
+			value |= ~static_cast<quint64>(0) << shift;
+		}
+		return static_cast<qint64>(value);
+	}
+
+	const char *cstr() {
+		if(!ok_) {
+			return "";
+		}
+		const char *const s = reinterpret_cast<const char *>(data_ + offset_);
+		const void *const nul = std::memchr(s, 0, size_ - offset_);
+		if(!nul) {
+			ok_ = false;
+			return "";
+		}
+		offset_ += (static_cast<const char *>(nul) - s) + 1;
+		return s;
+	}
+
+private:
+	const uchar *data_;
+	quint64      size_;
+	quint64      offset_;
+	bool         ok_;
+};
+
+// one attribute value, form 0 means the attribute wasn't there
+struct DwarfReader::Value {
+	Value() : form(0), u(0), str(0) {
+	}
+
+	quint64     form;
+	quint64     u;
+	const char *str;
+};
+
+// the attributes of a DIE that we care about
+struct DwarfReader::Die {
+	quint64 tag;
+	bool    declaration;
+	Value   name;
+	Value   linkage_name;
+	Value   low_pc;
+	Value   high_pc;
+	Value   ranges;
+	Value   stmt_list;
+	Value   comp_dir;
+	Value   specification;
+	Value   abstract_origin;
+	Value   addr_base;
+	Value   str_offsets_base;
+	Value   rnglists_base;
+};
+
+//------------------------------------------------------------------------------
+// Name: DwarfReader
+// Desc:
+//------------------------------------------------------------------------------
+DwarfReader::DwarfReader(const DwarfSections &sections) : sections_(sections), units_found_(false), ranges_found_(false) {
+}
+
+//------------------------------------------------------------------------------
+// Name: find_units
+// Desc: reads just the unit headers of .debug_info
+//------------------------------------------------------------------------------
+void DwarfReader::find_units() {
+
+	if(units_found_) {
+		return;
+	}
+	units_found_ = true;
+
+	quint64 offset = 0;
+	while(offset < static_cast<quint64>(sections_.info.size())) {
+		Cursor cursor(sections_.info, offset);
+
+		Unit unit;
+		unit.offset  = offset;
+		unit.dwarf64 = false;
+
+		quint64 length = cursor.u32();
+		if(length == 0xffffffff) {
+			unit.dwarf64 = true;
+			length       = cursor.u64();
+		}
+
+		unit.end     = cursor.offset() + length;
+		unit.version = cursor.u16();
+
+		int unit_type = DW_UT_compile;
+		if(unit.version >= 5) {
+			unit_type          = cursor.u8();
+			unit.address_size  = cursor.u8();
+			unit.abbrev_offset = cursor.offset_value(unit.dwarf64);
+			if(unit_type == DW_UT_skeleton || unit_type == DW_UT_split_compile) {
+				cursor.skip(8);
+			} else if(unit_type == DW_UT_type || unit_type == DW_UT_split_type) {
+				cursor.skip(8);
+				cursor.offset_value(unit.dwarf64);
+			}
+		} else {
+			unit.abbrev_offset = cursor.offset_value(unit.dwarf64);
+			unit.address_size  = cursor.u8();
+		}
+
+		if(!cursor.ok() || length == 0 || unit.end > static_cast<quint64>(sections_.info.size()) || unit.version < 2 || unit.version > 5) {
+			break;
+		}
+
+		unit.die              = cursor.offset();
+		unit.loaded           = false;
+		unit.has_stmt_list    = false;
+		unit.stmt_list        = 0;
+		unit.addr_base        = 0;
+		unit.str_offsets_base = 0;
+		unit.rnglists_base    = 0;
+
+		// type units have no code in them
+		if(unit_type == DW_UT_compile || unit_type == DW_UT_partial || unit_type == DW_UT_skeleton) {
+			units_.push_back(unit);
+		}
+
+		offset = unit.end;
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: abbrevs
+// Desc: the abbreviation table at <offset>, parsed the first time it is used
+//------------------------------------------------------------------------------
+const DwarfReader::AbbrevTable &DwarfReader::abbrevs(quint64 offset) {
+
+	QHash<quint64, AbbrevTable>::const_iterator it = abbrevs_.constFind(offset);
+	if(it != abbrevs_.constEnd()) {
+		return it.value();
+	}
+
+	AbbrevTable &table = abbrevs_[offset];
+
+	Cursor cursor(sections_.abbrev, offset);
+	while(cursor.ok()) {
+		const quint64 code = cursor.uleb();
+		if(code == 0) {
+			break;
+		}
+
+		Abbrev abbrev;
+		abbrev.tag      = cursor.uleb();
+		abbrev.children = cursor.u8() != 0;
+
+		while(cursor.ok()) {
+			AttributeSpec spec;
+			spec.name           = cursor.uleb();
+			spec.form           = cursor.uleb();
+			spec.implicit_const = (spec.form == DW_FORM_implicit_const) ? cursor.sleb() : 0;
+			if(spec.name == 0 && spec.form == 0) {
+				break;
+			}
+			abbrev.attributes.push_back(spec);
+		}
+
+		table.insert(code, abbrev);
+	}
+
+	return table;
+}
+
+//------------------------------------------------------------------------------
+// Name: read_value
+// Desc: reads (or skips) one attribute value of the given form
+//------------------------------------------------------------------------------
+bool DwarfReader::read_value(const Unit &unit, quint64 form, qint64 implicit_const, Cursor *cursor, Value *value) {
+
+	value->form = form;
+	value->u    = 0;
+	value->str  = 0;
+
+	switch(form) {
+	case DW_FORM_addr:           value->u = cursor->uint(unit.address_size); break;
+	case DW_FORM_data1:
+	case DW_FORM_ref1:
+	case DW_FORM_flag:
+	case DW_FORM_strx1:
+	case DW_FORM_addrx1:         value->u = cursor->u8(); break;
+	case DW_FORM_data2:
+	case DW_FORM_ref2:
+	case DW_FORM_strx2:
+	case DW_FORM_addrx2:         value->u = cursor->u16(); break;
+	case DW_FORM_strx3:
+	case DW_FORM_addrx3:         value->u = cursor->uint(3); break;
+	case DW_FORM_data4:
+	case DW_FORM_ref4:
+	case DW_FORM_ref_sup4:
+	case DW_FORM_strx4:
+	case DW_FORM_addrx4:         value->u = cursor->u32(); break;
+	case DW_FORM_data8:
+	case DW_FORM_ref8:
+	case DW_FORM_ref_sig8:
+	case DW_FORM_ref_sup8:       value->u = cursor->u64(); break;
+	case DW_FORM_data16:         cursor->skip(16); break;
+	case DW_FORM_sdata:          value->u = cursor->sleb(); break;
+	case DW_FORM_udata:
+	case DW_FORM_ref_udata:
+	case DW_FORM_strx:
+	case DW_FORM_addrx:
+	case DW_FORM_loclistx:
+	case DW_FORM_rnglistx:
+	case DW_FORM_GNU_addr_index:
+	case DW_FORM_GNU_str_index:  value->u = cursor->uleb(); break;
+	case DW_FORM_string:         value->str = cursor->cstr(); break;
+	case DW_FORM_strp:
+	case DW_FORM_line_strp:
+	case DW_FORM_sec_offset:
+	case DW_FORM_strp_sup:
+	case DW_FORM_GNU_ref_alt:
+	case DW_FORM_GNU_strp_alt:   value->u = cursor->offset_value(unit.dwarf64); break;
+	case DW_FORM_ref_addr:       value->u = (unit.version <= 2) ? cursor->uint(unit.address_size) : cursor->offset_value(unit.dwarf64); break;
+	case DW_FORM_flag_present:   value->u = 1; break;
+	case DW_FORM_implicit_const: value->u = implicit_const; break;
+	case DW_FORM_block1:         cursor->skip(cursor->u8()); break;
+	case DW_FORM_block2:         cursor->skip(cursor->u16()); break;
+	case DW_FORM_block4:         cursor->skip(cursor->u32()); break;
+	case DW_FORM_block:
+	case DW_FORM_exprloc:        cursor->skip(cursor->uleb()); break;
+	case DW_FORM_indirect:       return read_value(unit, cursor->uleb(), 0, cursor, value);
+	default:
+		// we can't know how big it is, so nothing after it can be read
+		return false;
+	}
+
+	// unit relative references are made absolute here
+	switch(form) {
+	case DW_FORM_ref1:
+	case DW_FORM_ref2:
+	case DW_FORM_ref4:
+	case DW_FORM_ref8:
+	case DW_FORM_ref_udata:
+		value->u += unit.offset;
+		break;
+	}
+
+	return cursor->ok();
+}
+
+//------------------------------------------------------------------------------
+// Name: read_die
+// Desc: reads the DIE at the cursor, a tag of 0 is a null entry
+//------------------------------------------------------------------------------
+bool DwarfReader::read_die(Unit *unit, Cursor *cursor, Die *die) {
+
+	*die = Die();
+	die->tag         = 0;
+	die->declaration = false;
+
+	const quint64 code = cursor->uleb();
+	if(!cursor->ok()) {
+		return false;
+	}
+
+	if(code == 0) {
+		return true;
+	}
+
+	const AbbrevTable &table = abbrevs(unit->abbrev_offset);
+	AbbrevTable::const_iterator it = table.constFind(code);
+	if(it == table.constEnd()) {
+		return false;
+	}
+
+	die->tag = it->tag;
+
+	Q_FOREACH(const AttributeSpec &spec, it->attributes) {
+		Value value;
+		if(!read_value(*unit, spec.form, spec.implicit_const, cursor, &value)) {
+			return false;
+		}
+
+		switch(spec.name) {
+		case DW_AT_name:              die->name             = value; break;
+		case DW_AT_linkage_name:
+		case DW_AT_MIPS_linkage_name: die->linkage_name     = value; break;
+		case DW_AT_low_pc:            die->low_pc           = value; break;
+		case DW_AT_high_pc:           die->high_pc          = value; break;
+		case DW_AT_ranges:            die->ranges           = value; break;
+		case DW_AT_stmt_list:         die->stmt_list        = value; break;
+		case DW_AT_comp_dir:          die->comp_dir         = value; break;
+		case DW_AT_specification:     die->specification    = value; break;
+		case DW_AT_abstract_origin:   die->abstract_origin  = value; break;
+		case DW_AT_addr_base:
+		case DW_AT_GNU_addr_base:     die->addr_base        = value; break;
+		case DW_AT_str_offsets_base:  die->str_offsets_base = value; break;
+		case DW_AT_rnglists_base:
+		case DW_AT_GNU_ranges_base:   die->rnglists_base    = value; break;
+		case DW_AT_declaration:       die->declaration      = value.u != 0; break;
+		}
+	}
+
+	return true;
+}
+
+//------------------------------------------------------------------------------
+// Name: load_unit
+// Desc: reads the unit's own DIE, which says where its line table is and how
+//       to resolve indexed strings and addresses
+//------------------------------------------------------------------------------
+bool DwarfReader::load_unit(Unit *unit) {
+
+	if(unit->loaded) {
+		return true;
+	}
+
+	Cursor cursor(sections_.info, unit->die);
+	Die die;
+	if(!read_die(unit, &cursor, &die)) {
+		return false;
+	}
+
+	unit->loaded           = true;
+	unit->has_stmt_list    = die.stmt_list.form != 0;
+	unit->stmt_list        = die.stmt_list.u;
+	unit->addr_base        = die.addr_base.u;
+	unit->str_offsets_base = die.str_offsets_base.u;
+	unit->rnglists_base    = die.rnglists_base.u;
+
+	// DWARF 5 says the string offsets table starts after its 8 (or 16) byte
+	// header when the unit doesn't say where
+	if(die.str_offsets_base.form == 0 && unit->version >= 5) {
+		unit->str_offsets_base = unit->dwarf64 ? 16 : 8;
+	}
+
+	unit->name     = QString::fromUtf8(value_string(*unit, die.name));
+	unit->comp_dir = QString::fromUtf8(value_string(*unit, die.comp_dir));
+	return true;
+}
+
+//------------------------------------------------------------------------------
+// Name: value_string
+// Desc:
+//------------------------------------------------------------------------------
+QByteArray DwarfReader::value_string(const Unit &unit, const Value &value) const {
+
+	const char *s = 0;
+
+	switch(value.form) {
+	case DW_FORM_string:
+		s = value.str;
+		break;
+	case DW_FORM_strp:
+		s = string_at(sections_.str, value.u);
+		break;
+	case DW_FORM_line_strp:
+		s = string_at(sections_.line_str, value.u);
+		break;
+	case DW_FORM_strx:
+	case DW_FORM_strx1:
+	case DW_FORM_strx2:
+	case DW_FORM_strx3:
+	case DW_FORM_strx4:
+	case DW_FORM_GNU_str_index:
+		{
+			const int size = unit.dwarf64 ? 8 : 4;
+			Cursor cursor(sections_.str_offsets, unit.str_offsets_base + value.u * size);
+			const quint64 offset = cursor.uint(size);
+			if(cursor.ok()) {
+				s = string_at(sections_.str, offset);
+			}
+		}
+		break;
+	}
+
+	return s ? QByteArray(s) : QByteArray();
+}
+
+//------------------------------------------------------------------------------
+// Name: value_address
+// Desc:
+//------------------------------------------------------------------------------
+quint64 DwarfReader::value_address(const Unit &unit, const Value &value) const {
+	switch(value.form) {
+	case DW_FORM_addrx:
+	case DW_FORM_addrx1:
+	case DW_FORM_addrx2:
+	case DW_FORM_addrx3:
+	case DW_FORM_addrx4:
+	case DW_FORM_GNU_addr_index:
+		{
+			Cursor cursor(sections_.addr, unit.addr_base + value.u * unit.address_size);
+			return cursor.uint(unit.address_size);
+		}
+	default:
+		return value.u;
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: functions
+// Desc: every function with code in it that the debug info describes. This
+//       has to look at every DIE, it is meant for symbol generation
+//------------------------------------------------------------------------------
+QList<DwarfReader::Function> DwarfReader::functions() {
+
+	find_units();
+
+	QList<Function> result;
+
+	for(int i = 0; i < units_.size(); ++i) {
+		if(!load_unit(&units_[i])) {
+			continue;
+		}
+
+		Cursor cursor(sections_.info, units_[i].die);
+		while(cursor.ok() && cursor.offset() < units_[i].end) {
+
+			Die die;
+			if(!read_die(&units_[i], &cursor, &die)) {
+				break;
+			}
+
+			if(die.tag != DW_TAG_subprogram || die.declaration || die.low_pc.form == 0 || die.high_pc.form == 0) {
+				continue;
+			}
+
+			Function function;
+			function.low = value_address(units_[i], die.low_pc);
+
+			switch(die.high_pc.form) {
+			case DW_FORM_addr:
+			case DW_FORM_addrx:
+			case DW_FORM_addrx1:
+			case DW_FORM_addrx2:
+			case DW_FORM_addrx3:
+			case DW_FORM_addrx4:
+			case DW_FORM_GNU_addr_index:
+				function.high = value_address(units_[i], die.high_pc);
+				break;
+			default:
+				function.high = function.low + die.high_pc.u;
+				break;
+			}
+
+			// prefer the mangled name, it is what the symbol tables use. Out of
+			// line definitions only have their names on the declaration
+			Die named       = die;
+			const Unit *owner = &units_[i];
+			for(int hops = 0; hops < 2; ++hops) {
+				function.name = value_string(*owner, named.linkage_name.form ? named.linkage_name : named.name);
+				if(!function.name.isEmpty()) {
+					break;
+				}
+
+				const Value &ref = named.specification.form ? named.specification : named.abstract_origin;
+				if(ref.form == 0 || ref.form == DW_FORM_GNU_ref_alt || ref.form == DW_FORM_ref_sig8 || ref.form == DW_FORM_ref_sup4 || ref.form == DW_FORM_ref_sup8) {
+					break;
+				}
+
+				// the reference may be into another unit
+				int target = -1;
+				for(int j = 0; j < units_.size(); ++j) {
+					if(ref.u >= units_[j].die && ref.u < units_[j].end) {
+						target = j;
+						break;
+					}
+				}
+
+				if(target == -1 || !load_unit(&units_[target])) {
+					break;
+				}
+
+				Cursor ref_cursor(sections_.info, ref.u);
+				if(!read_die(&units_[target], &ref_cursor, &named)) {
+					break;
+				}
+				owner = &units_[target];
+			}
+
+			if(!function.name.isEmpty() && function.high > function.low) {
+				result.push_back(function);
+			}
+		}
+	}
+
+	return result;
+}
+
+//------------------------------------------------------------------------------
+// Name: unit_ranges
+// Desc: adds the address ranges a unit's DIE covers to ranges_
+//------------------------------------------------------------------------------
+void DwarfReader::unit_ranges(const Unit &unit, const Die &die, int index) {
+
+	quint64 base = 0;
+
+	if(die.low_pc.form != 0) {
+		base = value_address(unit, die.low_pc);
+
+		if(die.high_pc.form != 0) {
+			Range range;
+			range.low  = base;
+			range.high = (die.high_pc.form == DW_FORM_addr) ? value_address(unit, die.high_pc) : base + die.high_pc.u;
+			range.unit = index;
+			ranges_.push_back(range);
+			return;
+		}
+	}
+
+	if(die.ranges.form == 0) {
+		return;
+	}
+
+	if(unit.version < 5) {
+		const quint64 all_ones = (unit.address_size == 8) ? ~static_cast<quint64>(0) : 0xffffffff;
+
+		Cursor cursor(sections_.ranges, die.ranges.u);
+		while(cursor.ok()) {
+			const quint64 start = cursor.uint(unit.address_size);
+			const quint64 end   = cursor.uint(unit.address_size);
+			if(!cursor.ok() || (start == 0 && end == 0)) {
+				break;
+			}
+
+			if(start == all_ones) {
+				base = end;
+			} else {
+				Range range;
+				range.low  = base + start;
+				range.high = base + end;
+				range.unit = index;
+				ranges_.push_back(range);
+			}
+		}
+		return;
+	}
+
+	quint64 offset = die.ranges.u;
+	if(die.ranges.form == DW_FORM_rnglistx) {
+		const int size = unit.dwarf64 ? 8 : 4;
+		Cursor cursor(sections_.rnglists, unit.rnglists_base + die.ranges.u * size);
+		offset = unit.rnglists_base + cursor.uint(size);
+	}
+
+	Cursor cursor(sections_.rnglists, offset);
+	while(cursor.ok()) {
+
+		Value index_value;
+		index_value.form = DW_FORM_addrx;
+
+		Range range;
+		range.unit = index;
+
+		bool add = true;
+		switch(cursor.u8()) {
+		case DW_RLE_end_of_list:
+			return;
+		case DW_RLE_base_addressx:
+			index_value.u = cursor.uleb();
+			base = value_address(unit, index_value);
+			add = false;
+			break;
+		case DW_RLE_startx_endx:
+			index_value.u = cursor.uleb();
+			range.low     = value_address(unit, index_value);
+			index_value.u = cursor.uleb();
+			range.high    = value_address(unit, index_value);
+			break;
+		case DW_RLE_startx_length:
+			index_value.u = cursor.uleb();
+			range.low     = value_address(unit, index_value);
+			range.high    = range.low + cursor.uleb();
+			break;
+		case DW_RLE_offset_pair:
+			range.low  = base + cursor.uleb();
+			range.high = base + cursor.uleb();
+			break;
+		case DW_RLE_base_address:
+			base = cursor.uint(unit.address_size);
+			add  = false;
+			break;
+		case DW_RLE_start_end:
+			range.low  = cursor.uint(unit.address_size);
+			range.high = cursor.uint(unit.address_size);
+			break;
+		case DW_RLE_start_length:
+			range.low  = cursor.uint(unit.address_size);
+			range.high = range.low + cursor.uleb();
+			break;
+		default:
+			return;
+		}
+
+		if(add && cursor.ok()) {
+			ranges_.push_back(range);
+		}
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: range_less
+// Desc:
+//------------------------------------------------------------------------------
+bool DwarfReader::range_less(const Range &lhs, const Range &rhs) {
+	return lhs.low < rhs.low;
+}
+
+//------------------------------------------------------------------------------
+// Name: row_less
+// Desc: an end of sequence sorts before a row which starts at the same address
+//------------------------------------------------------------------------------
+bool DwarfReader::row_less(const Row &lhs, const Row &rhs) {
+	return lhs.address < rhs.address || (lhs.address == rhs.address && lhs.end_sequence && !rhs.end_sequence);
+}
+
+//------------------------------------------------------------------------------
+// Name: find_ranges
+// Desc: works out which unit covers which addresses, from .debug_aranges when
+//       there is one. Units it doesn't list only have their top DIE read
+//------------------------------------------------------------------------------
+void DwarfReader::find_ranges() {
+
+	if(ranges_found_) {
+		return;
+	}
+	ranges_found_ = true;
+
+	find_units();
+
+	QHash<quint64, int> unit_index;
+	for(int i = 0; i < units_.size(); ++i) {
+		unit_index.insert(units_[i].offset, i);
+	}
+
+	QSet<int> covered;
+
+	quint64 offset = 0;
+	while(offset < static_cast<quint64>(sections_.aranges.size())) {
+		Cursor cursor(sections_.aranges, offset);
+
+		bool dwarf64   = false;
+		quint64 length = cursor.u32();
+		if(length == 0xffffffff) {
+			dwarf64 = true;
+			length  = cursor.u64();
+		}
+
+		const quint64 end = cursor.offset() + length;
+		cursor.u16();
+		const quint64 info_offset = cursor.offset_value(dwarf64);
+		const int address_size    = cursor.u8();
+		cursor.u8();
+
+		if(!cursor.ok() || length == 0 || address_size == 0) {
+			break;
+		}
+
+		// the tuples are aligned to twice the address size
+		const quint64 tuple_size = address_size * 2;
+		const quint64 header     = cursor.offset() - offset;
+		cursor.skip((tuple_size - header % tuple_size) % tuple_size);
+
+		QHash<quint64, int>::const_iterator it = unit_index.constFind(info_offset);
+		if(it != unit_index.constEnd()) {
+			covered.insert(it.value());
+
+			while(cursor.ok() && cursor.offset() < end) {
+				const quint64 address = cursor.uint(address_size);
+				const quint64 size    = cursor.uint(address_size);
+				if(address == 0 && size == 0) {
+					break;
+				}
+
+				Range range;
+				range.low  = address;
+				range.high = address + size;
+				range.unit = it.value();
+				ranges_.push_back(range);
+			}
+		}
+
+		offset = end;
+	}
+
+	for(int i = 0; i < units_.size(); ++i) {
+		if(!covered.contains(i)) {
+			Cursor cursor(sections_.info, units_[i].die);
+			Die die;
+			if(load_unit(&units_[i]) && read_die(&units_[i], &cursor, &die)) {
+				unit_ranges(units_[i], die, i);
+			}
+		}
+	}
+
+	std::sort(ranges_.begin(), ranges_.end(), range_less);
+}
+
+//------------------------------------------------------------------------------
+// Name: read_line_table
+// Desc: decodes a unit's whole line number program
+//------------------------------------------------------------------------------
+bool DwarfReader::read_line_table(const Unit &unit, LineTable *table) {
+
+	Cursor cursor(sections_.line, unit.stmt_list);
+
+	// the forms in a DWARF 5 header are read like attributes of a unit with
+	// the line table's own offset size
+	Unit header_unit = unit;
+
+	quint64 length = cursor.u32();
+	header_unit.dwarf64 = false;
+	if(length == 0xffffffff) {
+		header_unit.dwarf64 = true;
+		length              = cursor.u64();
+	}
+
+	const quint64 end = cursor.offset() + length;
+	const int version = cursor.u16();
+	if(version >= 5) {
+		header_unit.address_size = cursor.u8();
+		cursor.u8();
+	}
+
+	const quint64 header_length = cursor.offset_value(header_unit.dwarf64);
+	const quint64 program       = cursor.offset() + header_length;
+
+	const int minimum_instruction_length = cursor.u8();
+	if(version >= 4) {
+		cursor.u8();
+	}
+	const bool default_is_stmt = cursor.u8() != 0;
+	const int line_base        = static_cast<qint8>(cursor.u8());
+	const int line_range       = cursor.u8();
+	const int opcode_base      = cursor.u8();
+
+	Q_UNUSED(default_is_stmt);
+
+	if(!cursor.ok() || version < 2 || version > 5 || line_range == 0 || opcode_base == 0 || end > static_cast<quint64>(sections_.line.size())) {
+		return false;
+	}
+
+	QVector<int> standard_lengths(opcode_base, 0);
+	for(int i = 1; i < opcode_base; ++i) {
+		standard_lengths[i] = cursor.u8();
+	}
+
+	QStringList directories;
+
+	if(version < 5) {
+		directories.push_back(unit.comp_dir);
+		while(cursor.ok()) {
+			const char *const directory = cursor.cstr();
+			if(*directory == '\0') {
+				break;
+			}
+			directories.push_back(join_path(unit.comp_dir, QString::fromUtf8(directory)));
+		}
+
+		// files are numbered from 1, 0 is the unit itself
+		table->files.push_back(join_path(unit.comp_dir, unit.name));
+		while(cursor.ok()) {
+			const char *const name = cursor.cstr();
+			if(*name == '\0') {
+				break;
+			}
+			const quint64 directory = cursor.uleb();
+			cursor.uleb();
+			cursor.uleb();
+			table->files.push_back(join_path(directory < static_cast<quint64>(directories.size()) ? directories[directory] : QString(), QString::fromUtf8(name)));
+		}
+	} else {
+		for(int pass = 0; pass < 2; ++pass) {
+			QVector<QPair<quint64, quint64> > formats;
+			const int format_count = cursor.u8();
+			for(int i = 0; i < format_count; ++i) {
+				const quint64 type = cursor.uleb();
+				const quint64 form = cursor.uleb();
+				formats.push_back(qMakePair(type, form));
+			}
+
+			const quint64 count = cursor.uleb();
+			for(quint64 n = 0; n < count && cursor.ok(); ++n) {
+				QString path;
+				quint64 directory = 0;
+
+				for(int i = 0; i < formats.size(); ++i) {
+					Value value;
+					if(!read_value(header_unit, formats[i].second, 0, &cursor, &value)) {
+						return false;
+					}
+
+					if(formats[i].first == DW_LNCT_path) {
+						path = QString::fromUtf8(value_string(header_unit, value));
+					} else if(formats[i].first == DW_LNCT_directory_index) {
+						directory = value.u;
+					}
+				}
+
+				if(pass == 0) {
+					directories.push_back(join_path(unit.comp_dir, path));
+				} else {
+					table->files.push_back(join_path(directory < static_cast<quint64>(directories.size()) ? directories[directory] : QString(), path));
+				}
+			}
+		}
+	}
+
+	if(!cursor.ok()) {
+		return false;
+	}
+
+	cursor.seek(program);
+
+	quint64 address = 0;
+	quint32 file    = 1;
+	qint64  line    = 1;
+
+	while(cursor.ok() && cursor.offset() < end) {
+
+		bool emit         = false;
+		bool end_sequence = false;
+
+		const int opcode = cursor.u8();
+		if(opcode >= opcode_base) {
+			const int adjusted = opcode - opcode_base;
+			address += (adjusted / line_range) * minimum_instruction_length;
+			line    += line_base + (adjusted % line_range);
+			emit     = true;
+		} else if(opcode == 0) {
+			const quint64 size  = cursor.uleb();
+			const quint64 start = cursor.offset();
+			if(size == 0) {
+				continue;
+			}
+
+			switch(cursor.u8()) {
+			case DW_LNE_end_sequence:
+				emit         = true;
+				end_sequence = true;
+				break;
+			case DW_LNE_set_address:
+				address = cursor.uint(size - 1);
+				break;
+			default:
+				break;
+			}
+
+			cursor.seek(start + size);
+		} else {
+			switch(opcode) {
+			case DW_LNS_copy:
+				emit = true;
+				break;
+			case DW_LNS_advance_pc:
+				address += cursor.uleb() * minimum_instruction_length;
+				break;
+			case DW_LNS_advance_line:
+				line += cursor.sleb();
+				break;
+			case DW_LNS_set_file:
+				file = cursor.uleb();
+				break;
+			case DW_LNS_const_add_pc:
+				address += ((255 - opcode_base) / line_range) * minimum_instruction_length;
+				break;
+			case DW_LNS_fixed_advance_pc:
+				address += cursor.u16();
+				break;
+			case DW_LNS_negate_stmt:
+			case DW_LNS_set_basic_block:
+			case DW_LNS_set_prologue_end:
+			case DW_LNS_set_epilogue_begin:
+				break;
+			default:
+				// includes set_column and set_isa, which take one operand
+				for(int i = 0; i < standard_lengths[opcode]; ++i) {
+					cursor.uleb();
+				}
+				break;
+			}
+		}
+
+		if(emit) {
+			Row row;
+			row.address      = address;
+			row.file         = file;
+			row.line         = line;
+			row.end_sequence = end_sequence;
+			table->rows.push_back(row);
+		}
+
+		if(end_sequence) {
+			address = 0;
+			file    = 1;
+			line    = 1;
+		}
+	}
+
+	// sequences can be in any order
+	std::stable_sort(table->rows.begin(), table->rows.end(), row_less);
+	return true;
+}
+
+//------------------------------------------------------------------------------
+// Name: line_table
+// Desc: a unit's line table, decoded the first time it is asked for
+//------------------------------------------------------------------------------
+const DwarfReader::LineTable *DwarfReader::line_table(int unit) {
+
+	QHash<int, LineTable>::const_iterator it = line_tables_.constFind(unit);
+	if(it != line_tables_.constEnd()) {
+		return &it.value();
+	}
+
+	LineTable &table = line_tables_[unit];
+	if(load_unit(&units_[unit]) && units_[unit].has_stmt_list) {
+		if(!read_line_table(units_[unit], &table)) {
+			table = LineTable();
+		}
+	}
+	return &table;
+}
+
+//------------------------------------------------------------------------------
+// Name: find_line
+// Desc: finds the source line <address> belongs to, <start> is where the code
+//       for that line begins
+//------------------------------------------------------------------------------
+bool DwarfReader::find_line(quint64 address, QString *file, int *line, quint64 *start) {
+
+	Q_ASSERT(file);
+	Q_ASSERT(line);
+	Q_ASSERT(start);
+
+	find_ranges();
+
+	// the last range starting at or before the address, ranges rarely overlap
+	// so walking back from there is short
+	int first = 0;
+	int last  = ranges_.size();
+	while(first < last) {
+		const int middle = first + (last - first) / 2;
+		if(ranges_[middle].low <= address) {
+			first = middle + 1;
+		} else {
+			last = middle;
+		}
+	}
+
+	for(int i = first - 1; i >= 0; --i) {
+		if(address >= ranges_[i].high) {
+			continue;
+		}
+
+		const LineTable *const table = line_table(ranges_[i].unit);
+
+		int row_first = 0;
+		int row_last  = table->rows.size();
+		while(row_first < row_last) {
+			const int middle = row_first + (row_last - row_first) / 2;
+			if(table->rows[middle].address <= address) {
+				row_first = middle + 1;
+			} else {
+				row_last = middle;
+			}
+		}
+
+		if(row_first != 0) {
+			const Row &row = table->rows[row_first - 1];
+			if(!row.end_sequence && row.file < static_cast<quint32>(table->files.size())) {
+				*file  = table->files[row.file];
+				*line  = row.line;
+				*start = row.address;
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	return false;
+}
+
+}
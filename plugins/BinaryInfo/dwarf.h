@@ -0,0 +1,149 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef DWARF_20261014_H_
+#define DWARF_20261014_H_
+
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+namespace BinaryInfo {
+
+// the DWARF sections of one ELF file. Uncompressed sections refer to the
+// file's mapping, compressed ones are inflated copies
+struct DwarfSections {
+	QByteArray info;
+	QByteArray abbrev;
+	QByteArray line;
+	QByteArray line_str;
+	QByteArray aranges;
+	QByteArray str;
+	QByteArray str_offsets;
+	QByteArray addr;
+	QByteArray ranges;
+	QByteArray rnglists;
+};
+
+// reads function ranges and line tables out of DWARF 2 through 5. Nothing is
+// parsed up front, a unit's line table is only decoded the first time an
+// address inside it is looked up, so huge debug files cost little until used
+class DwarfReader {
+public:
+	struct Function {
+		quint64    low;
+		quint64    high;
+		QByteArray name;
+	};
+
+public:
+	explicit DwarfReader(const DwarfSections &sections);
+
+public:
+	bool empty() const { return sections_.info.isEmpty(); }
+	QList<Function> functions();
+	bool find_line(quint64 address, QString *file, int *line, quint64 *start);
+
+private:
+	struct AttributeSpec {
+		quint64 name;
+		quint64 form;
+		qint64  implicit_const;
+	};
+
+	struct Abbrev {
+		quint64                tag;
+		bool                   children;
+		QVector<AttributeSpec> attributes;
+	};
+
+	typedef QHash<quint64, Abbrev> AbbrevTable;
+
+	struct Unit {
+		quint64 offset;
+		quint64 end;
+		quint64 die;
+		quint64 abbrev_offset;
+		int     version;
+		int     address_size;
+		bool    dwarf64;
+
+		// from the unit's own DIE, filled in by load_unit
+		bool    loaded;
+		bool    has_stmt_list;
+		quint64 stmt_list;
+		quint64 addr_base;
+		quint64 str_offsets_base;
+		quint64 rnglists_base;
+		QString name;
+		QString comp_dir;
+	};
+
+	struct Row {
+		quint64 address;
+		quint32 file;
+		quint32 line;
+		bool    end_sequence;
+	};
+
+	struct LineTable {
+		QVector<Row> rows;
+		QStringList  files;
+	};
+
+	struct Range {
+		quint64 low;
+		quint64 high;
+		int     unit;
+	};
+
+	class Cursor;
+	struct Value;
+	struct Die;
+
+private:
+	static bool range_less(const Range &lhs, const Range &rhs);
+	static bool row_less(const Row &lhs, const Row &rhs);
+	void find_units();
+	void find_ranges();
+	bool load_unit(Unit *unit);
+	const AbbrevTable &abbrevs(quint64 offset);
+	bool read_die(Unit *unit, Cursor *cursor, Die *die);
+	bool read_value(const Unit &unit, quint64 form, qint64 implicit_const, Cursor *cursor, Value *value);
+	QByteArray value_string(const Unit &unit, const Value &value) const;
+	quint64 value_address(const Unit &unit, const Value &value) const;
+	void unit_ranges(const Unit &unit, const Die &die, int index);
+	bool read_line_table(const Unit &unit, LineTable *table);
+	const LineTable *line_table(int unit);
+
+private:
+	DwarfSections              sections_;
+	QVector<Unit>              units_;
+	QVector<Range>             ranges_;
+	QHash<quint64, AbbrevTable> abbrevs_;
+	QHash<int, LineTable>      line_tables_;
+	bool                       units_found_;
+	bool                       ranges_found_;
+};
+
+}
+
+#endif
@@ -36,6 +36,29 @@ typedef uint32_t UINT;
 typedef uint64_t ULONGLONG;
 typedef int64_t  LONGLONG;
 #define IMAGE_NUMBEROF_DIRECTORY_ENTRIES 16
+#define IMAGE_SIZEOF_SHORT_NAME          8
+
+#define IMAGE_DOS_SIGNATURE              0x5a4d     // "MZ"
+#define IMAGE_NT_SIGNATURE               0x00004550 // "PE\0\0"
+#define IMAGE_NT_OPTIONAL_HDR32_MAGIC    0x10b
+#define IMAGE_NT_OPTIONAL_HDR64_MAGIC    0x20b
+
+#define IMAGE_FILE_MACHINE_I386          0x014c
+#define IMAGE_FILE_MACHINE_AMD64         0x8664
+
+#define IMAGE_DIRECTORY_ENTRY_EXPORT     0
+#define IMAGE_DIRECTORY_ENTRY_IMPORT     1
+#define IMAGE_DIRECTORY_ENTRY_BASERELOC  5
+
+#define IMAGE_REL_BASED_ABSOLUTE         0
+#define IMAGE_REL_BASED_HIGHLOW          3
+#define IMAGE_REL_BASED_DIR64            10
+
+#define IMAGE_SCN_CNT_CODE               0x00000020
+#define IMAGE_SCN_MEM_EXECUTE            0x20000000
+
+#define IMAGE_ORDINAL_FLAG32             0x80000000U
+#define IMAGE_ORDINAL_FLAG64             0x8000000000000000ULL
 #endif
 
 namespace BinaryInfo {
@@ -156,6 +179,51 @@ struct IMAGE_NT_HEADERS64 {
 	IMAGE_OPTIONAL_HEADER64 OptionalHeader;
 };
 
+// the section table follows the optional header, which is
+// FileHeader.SizeOfOptionalHeader bytes long
+struct IMAGE_SECTION_HEADER {
+	BYTE  Name[IMAGE_SIZEOF_SHORT_NAME];
+	DWORD VirtualSize;
+	DWORD VirtualAddress;
+	DWORD SizeOfRawData;
+	DWORD PointerToRawData;
+	DWORD PointerToRelocations;
+	DWORD PointerToLinenumbers;
+	WORD  NumberOfRelocations;
+	WORD  NumberOfLinenumbers;
+	DWORD Characteristics;
+};
+
+struct IMAGE_EXPORT_DIRECTORY {
+	DWORD Characteristics;
+	DWORD TimeDateStamp;
+	WORD  MajorVersion;
+	WORD  MinorVersion;
+	DWORD Name;
+	DWORD Base;
+	DWORD NumberOfFunctions;
+	DWORD NumberOfNames;
+	DWORD AddressOfFunctions;
+	DWORD AddressOfNames;
+	DWORD AddressOfNameOrdinals;
+};
+
+// the import directory is an array of these ending in one which is all zero
+struct IMAGE_IMPORT_DESCRIPTOR {
+	DWORD OriginalFirstThunk;
+	DWORD TimeDateStamp;
+	DWORD ForwarderChain;
+	DWORD Name;
+	DWORD FirstThunk;
+};
+
+// followed by (SizeOfBlock - 8) / 2 WORDs, the type in the top 4 bits of
+// each and the offset from VirtualAddress in the rest
+struct IMAGE_BASE_RELOCATION {
+	DWORD VirtualAddress;
+	DWORD SizeOfBlock;
+};
+
 }
 
 #endif
@@ -17,6 +17,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
 #include "symbols.h"
+#include "SymbolCache.h"
 #include "edb.h"
 
 #include <QDateTime>
@@ -26,18 +27,28 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <QList>
 #include <QSet>
 #include <QString>
+#include <QVector>
+#include <QtEndian>
+#include <cstring>
 #include <iostream>
 
 #include "elf/elf_types.h"
 #include "elf/elf_header.h"
+#include "elf/elf_nhdr.h"
 #include "elf/elf_rela.h"
 #include "elf/elf_rel.h"
 #include "elf/elf_sym.h"
 #include "elf/elf_shdr.h"
 #include "elf/elf_syminfo.h"
+#include "pe_binary.h"
 
 namespace BinaryInfo {
 namespace {
+
+// not in our copy of the ELF headers yet
+const quint64 SHF_COMPRESSED  = 0x800;
+const quint32 ELFCOMPRESS_ZLIB = 1;
+
 struct elf32_model {
 	typedef quint32    address_t;
 
@@ -46,6 +57,13 @@ struct elf32_model {
 	typedef elf32_sym    elf_symbol_t;
 	typedef elf32_rela   elf_relocation_a_t;
 	typedef elf32_rel    elf_relocation_t;
+	typedef elf32_nhdr   elf_note_t;
+
+	struct elf_compression_header_t {
+		quint32 ch_type;
+		quint32 ch_size;
+		quint32 ch_addralign;
+	};
 
 	static const int plt_entry_size = 0x10;
 
@@ -89,6 +107,14 @@ struct elf64_model {
 	typedef elf64_sym    elf_symbol_t;
 	typedef elf64_rela   elf_relocation_a_t;
 	typedef elf64_rel    elf_relocation_t;
+	typedef elf64_nhdr   elf_note_t;
+
+	struct elf_compression_header_t {
+		quint32 ch_type;
+		quint32 ch_reserved;
+		quint64 ch_size;
+		quint64 ch_addralign;
+	};
 
 	static const int plt_entry_size = 0x10;
 
@@ -140,6 +166,219 @@ bool is_elf64(const void *ptr) {
 	return false;
 }
 
+//--------------------------------------------------------------------------
+// Name: inflate
+// Desc: zlib data of a known uncompressed size
+//--------------------------------------------------------------------------
+QByteArray inflate(const char *data, quint64 size, quint64 uncompressed_size) {
+
+	if(uncompressed_size > 0x7fffffff || size > 0x7fffffff) {
+		return QByteArray();
+	}
+
+	// qUncompress wants the size up front, big endian
+	uchar prefix[4];
+	qToBigEndian(static_cast<quint32>(uncompressed_size), prefix);
+
+	QByteArray input;
+	input.reserve(static_cast<int>(size) + 4);
+	input.append(reinterpret_cast<const char *>(prefix), 4);
+	input.append(data, static_cast<int>(size));
+	return qUncompress(input);
+}
+
+//--------------------------------------------------------------------------
+// Name: section_data
+// Desc: the contents of the named section. Compressed sections, either
+//       SHF_COMPRESSED or the older .zdebug kind, are inflated, anything else
+//       refers directly to the mapping at <p>
+//--------------------------------------------------------------------------
+template <class M>
+QByteArray section_data(const void *p, size_t size, const char *name) {
+
+	typedef typename M::elf_header_t             elf_header_t;
+	typedef typename M::elf_section_header_t     elf_section_header_t;
+	typedef typename M::elf_compression_header_t elf_compression_header_t;
+
+	const uintptr_t base = reinterpret_cast<uintptr_t>(p);
+
+	const elf_header_t *const header = static_cast<const elf_header_t*>(p);
+	if(header->e_shoff == 0 || header->e_shoff + header->e_shnum * sizeof(elf_section_header_t) > size || header->e_shstrndx >= header->e_shnum) {
+		return QByteArray();
+	}
+
+	const elf_section_header_t *const sections_begin = reinterpret_cast<const elf_section_header_t*>(base + header->e_shoff);
+	const elf_section_header_t *const sections_end   = sections_begin + header->e_shnum;
+	const elf_section_header_t *const strings        = &sections_begin[header->e_shstrndx];
+	if(strings->sh_offset + strings->sh_size > size) {
+		return QByteArray();
+	}
+
+	const char *const section_strings = reinterpret_cast<const char*>(base + strings->sh_offset);
+
+	// ".debug_info" is ".zdebug_info" when compressed the old way
+	const QByteArray zname = QByteArray(".z") + (name + 1);
+
+	for(const elf_section_header_t *section = sections_begin; section != sections_end; ++section) {
+
+		if(section->sh_name >= strings->sh_size || section->sh_type == SHT_NOBITS || section->sh_offset + section->sh_size > size) {
+			continue;
+		}
+
+		const char *const section_name = &section_strings[section->sh_name];
+		const char *const data         = reinterpret_cast<const char*>(base + section->sh_offset);
+
+		if(std::strcmp(section_name, name) == 0) {
+			if(section->sh_flags & SHF_COMPRESSED) {
+				if(section->sh_size < sizeof(elf_compression_header_t)) {
+					return QByteArray();
+				}
+
+				const elf_compression_header_t *const compression = reinterpret_cast<const elf_compression_header_t*>(data);
+				if(compression->ch_type != ELFCOMPRESS_ZLIB) {
+					return QByteArray();
+				}
+
+				return inflate(data + sizeof(elf_compression_header_t), section->sh_size - sizeof(elf_compression_header_t), compression->ch_size);
+			}
+
+			return QByteArray::fromRawData(data, section->sh_size);
+		}
+
+		if(zname == section_name) {
+			if(section->sh_size < 12 || std::memcmp(data, "ZLIB", 4) != 0) {
+				return QByteArray();
+			}
+
+			const quint64 uncompressed_size = qFromBigEndian<quint64>(reinterpret_cast<const uchar*>(data + 4));
+			return inflate(data + 12, section->sh_size - 12, uncompressed_size);
+		}
+	}
+
+	return QByteArray();
+}
+
+//--------------------------------------------------------------------------
+// Name: build_id
+// Desc: the NT_GNU_BUILD_ID note, if the file has one
+//--------------------------------------------------------------------------
+template <class M>
+QByteArray build_id(const void *p, size_t size) {
+
+	typedef typename M::elf_note_t elf_note_t;
+
+	const QByteArray notes = section_data<M>(p, size, ".note.gnu.build-id");
+
+	int offset = 0;
+	while(offset + static_cast<int>(sizeof(elf_note_t)) <= notes.size()) {
+		const elf_note_t *const note = reinterpret_cast<const elf_note_t*>(notes.constData() + offset);
+
+		// the name and descriptor are each padded to 4 bytes
+		const int name_offset = offset + sizeof(elf_note_t);
+		const int desc_offset = name_offset + ((note->n_namesz + 3) & ~3);
+		const int next        = desc_offset + ((note->n_descsz + 3) & ~3);
+		if(next > notes.size() || next <= offset) {
+			break;
+		}
+
+		if(note->n_type == NT_GNU_BUILD_ID && note->n_namesz == sizeof(ELF_NOTE_GNU) && std::memcmp(notes.constData() + name_offset, ELF_NOTE_GNU, sizeof(ELF_NOTE_GNU)) == 0) {
+			return QByteArray(notes.constData() + desc_offset, note->n_descsz);
+		}
+
+		offset = next;
+	}
+
+	return QByteArray();
+}
+
+//--------------------------------------------------------------------------
+// Name: read_debug_sections
+// Desc:
+//--------------------------------------------------------------------------
+template <class M>
+void read_debug_sections(const void *p, size_t size, DwarfSections *sections, QByteArray *id, QByteArray *debug_link) {
+
+	sections->info        = section_data<M>(p, size, ".debug_info");
+	sections->abbrev      = section_data<M>(p, size, ".debug_abbrev");
+	sections->line        = section_data<M>(p, size, ".debug_line");
+	sections->line_str    = section_data<M>(p, size, ".debug_line_str");
+	sections->aranges     = section_data<M>(p, size, ".debug_aranges");
+	sections->str         = section_data<M>(p, size, ".debug_str");
+	sections->str_offsets = section_data<M>(p, size, ".debug_str_offsets");
+	sections->addr        = section_data<M>(p, size, ".debug_addr");
+	sections->ranges      = section_data<M>(p, size, ".debug_ranges");
+	sections->rnglists    = section_data<M>(p, size, ".debug_rnglists");
+
+	if(id) {
+		*id = build_id<M>(p, size);
+	}
+
+	if(debug_link) {
+		// the name is followed by padding and a CRC, which we don't check
+		const QByteArray link = section_data<M>(p, size, ".gnu_debuglink");
+		*debug_link = QByteArray(link.constData(), qstrnlen(link.constData(), link.size()));
+	}
+}
+
+//--------------------------------------------------------------------------
+// Name: map_debug_sections
+// Desc: reads the debug sections of a mapped file
+//--------------------------------------------------------------------------
+bool map_debug_sections(const MappedFile &file, DwarfSections *sections, QByteArray *id, QByteArray *debug_link) {
+
+	if(const void *const file_ptr = file.data()) {
+		if(is_elf64(file_ptr)) {
+			read_debug_sections<elf64_model>(file_ptr, file.size(), sections, id, debug_link);
+			return true;
+		} else if(is_elf32(file_ptr)) {
+			read_debug_sections<elf32_model>(file_ptr, file.size(), sections, id, debug_link);
+			return true;
+		}
+	}
+	return false;
+}
+
+//--------------------------------------------------------------------------
+// Name: find_debug_file
+// Desc: finds the separate debug file the way gdb does, first by build-id
+//       then by the .gnu_debuglink name
+//--------------------------------------------------------------------------
+QString find_debug_file(const QString &filename, const QByteArray &id, const QByteArray &debug_link) {
+
+	static const QString debug_directory = "/usr/lib/debug";
+
+	if(id.size() >= 2) {
+		const QString hex = id.toHex();
+		const QString path = QString("%1/.build-id/%2/%3.debug").arg(debug_directory, hex.left(2), hex.mid(2));
+		if(QFile::exists(path)) {
+			return path;
+		}
+	}
+
+	if(!debug_link.isEmpty()) {
+		// libraries are usually reached through symlinks, the link is relative
+		// to the real file
+		const QFileInfo info(filename);
+		const QString real_path = info.canonicalFilePath().isEmpty() ? info.absoluteFilePath() : info.canonicalFilePath();
+		const QString directory = QFileInfo(real_path).absolutePath();
+		const QString name      = QString::fromLocal8Bit(debug_link);
+
+		const QString candidates[] = {
+			directory + '/' + name,
+			directory + "/.debug/" + name,
+			debug_directory + directory + '/' + name
+		};
+
+		for(size_t i = 0; i < sizeof(candidates) / sizeof(candidates[0]); ++i) {
+			if(candidates[i] != real_path && QFile::exists(candidates[i])) {
+				return candidates[i];
+			}
+		}
+	}
+
+	return QString();
+}
+
 /*
 The  symbol  type.   At least the following types are used; others are, as well, depending on the object file format.  If lowercase,
 the symbol is local; if uppercase, the symbol is global (external).
@@ -405,6 +644,295 @@ void process_symbols(const void *p, size_t size, std::ostream &os) {
 		os << qPrintable(it->to_string()) << '\n';
 	}
 }
+
+template <class M>
+QVector<SymbolCache::Record> cache_records(const void *p, size_t size) {
+
+	typedef typename M::symbol symbol;
+
+	const QList<symbol> symbols = collect_symbols<M>(p, size);
+
+	QVector<SymbolCache::Record> records;
+	records.reserve(symbols.size());
+
+	Q_FOREACH(const symbol &sym, symbols) {
+		SymbolCache::Record record;
+		record.address = sym.address;
+		record.size    = sym.size;
+		record.name    = sym.name.toUtf8();
+		record.type    = sym.type;
+		records.push_back(record);
+	}
+
+	return records;
+}
+
+struct pe32_model {
+	typedef IMAGE_NT_HEADERS32 nt_headers_t;
+	typedef quint32            thunk_t;
+
+	static const quint64 ordinal_flag = IMAGE_ORDINAL_FLAG32;
+};
+
+struct pe64_model {
+	typedef IMAGE_NT_HEADERS64 nt_headers_t;
+	typedef quint64            thunk_t;
+
+	static const quint64 ordinal_flag = IMAGE_ORDINAL_FLAG64;
+};
+
+//--------------------------------------------------------------------------
+// Name: pe_optional_magic
+// Desc: the optional header's magic if <p> is a PE file, 0 otherwise
+//--------------------------------------------------------------------------
+WORD pe_optional_magic(const void *p, size_t size) {
+
+	if(size < sizeof(IMAGE_DOS_HEADER)) {
+		return 0;
+	}
+
+	const IMAGE_DOS_HEADER *const dos_header = static_cast<const IMAGE_DOS_HEADER *>(p);
+	if(dos_header->e_magic != IMAGE_DOS_SIGNATURE || dos_header->e_lfanew <= 0 || static_cast<size_t>(dos_header->e_lfanew) + sizeof(IMAGE_NT_HEADERS32) > size) {
+		return 0;
+	}
+
+	const IMAGE_NT_HEADERS32 *const nt_headers = reinterpret_cast<const IMAGE_NT_HEADERS32 *>(static_cast<const char *>(p) + dos_header->e_lfanew);
+	if(nt_headers->Signature != IMAGE_NT_SIGNATURE) {
+		return 0;
+	}
+
+	return nt_headers->OptionalHeader.Magic;
+}
+
+// finds what an RVA refers to in the file, through the section table
+template <class M>
+class PEImage {
+public:
+	typedef typename M::nt_headers_t nt_headers_t;
+
+public:
+	PEImage(const void *p, size_t size) : base_(static_cast<const char *>(p)), size_(size), sections_(0), section_count_(0) {
+
+		const IMAGE_DOS_HEADER *const dos_header = static_cast<const IMAGE_DOS_HEADER *>(p);
+
+		nt_headers_ = reinterpret_cast<const nt_headers_t *>(base_ + dos_header->e_lfanew);
+
+		const size_t table = dos_header->e_lfanew + sizeof(DWORD) + sizeof(IMAGE_FILE_HEADER) + nt_headers_->FileHeader.SizeOfOptionalHeader;
+		if(table <= size_) {
+			sections_      = reinterpret_cast<const IMAGE_SECTION_HEADER *>(base_ + table);
+			section_count_ = qMin<size_t>(nt_headers_->FileHeader.NumberOfSections, (size_ - table) / sizeof(IMAGE_SECTION_HEADER));
+		}
+	}
+
+public:
+	// <size> bytes at <rva>, null unless they are all in the file
+	const char *at(quint64 rva, quint64 size) const {
+		if(rva + size <= nt_headers_->OptionalHeader.SizeOfHeaders) {
+			return rva + size <= size_ ? base_ + rva : 0;
+		}
+
+		for(size_t i = 0; i < section_count_; ++i) {
+			const IMAGE_SECTION_HEADER &section = sections_[i];
+			if(rva >= section.VirtualAddress && rva + size <= static_cast<quint64>(section.VirtualAddress) + section.SizeOfRawData) {
+				const quint64 offset = section.PointerToRawData + (rva - section.VirtualAddress);
+				return offset + size <= size_ ? base_ + offset : 0;
+			}
+		}
+
+		return 0;
+	}
+
+	// the NUL terminated string at <rva>, empty if it runs off the file
+	QByteArray string(quint64 rva) const {
+		if(const char *const s = at(rva, 1)) {
+			const size_t available = static_cast<size_t>(base_ + size_ - s);
+			const size_t length    = qstrnlen(s, static_cast<uint>(qMin<size_t>(available, 0xffff)));
+			if(length < available) {
+				return QByteArray(s, static_cast<int>(length));
+			}
+		}
+		return QByteArray();
+	}
+
+	// where the section holding <rva> is mapped executable
+	bool executable(quint64 rva) const {
+		for(size_t i = 0; i < section_count_; ++i) {
+			const IMAGE_SECTION_HEADER &section = sections_[i];
+			const DWORD size = section.VirtualSize ? section.VirtualSize : section.SizeOfRawData;
+			if(rva >= section.VirtualAddress && rva < static_cast<quint64>(section.VirtualAddress) + size) {
+				return (section.Characteristics & (IMAGE_SCN_MEM_EXECUTE | IMAGE_SCN_CNT_CODE)) != 0;
+			}
+		}
+		return false;
+	}
+
+	const IMAGE_DATA_DIRECTORY *directory(unsigned int index) const {
+		if(index < nt_headers_->OptionalHeader.NumberOfRvaAndSizes && index < IMAGE_NUMBEROF_DIRECTORY_ENTRIES) {
+			const IMAGE_DATA_DIRECTORY *const entry = &nt_headers_->OptionalHeader.DataDirectory[index];
+			if(entry->VirtualAddress != 0 && entry->Size != 0) {
+				return entry;
+			}
+		}
+		return 0;
+	}
+
+private:
+	const char                 *base_;
+	size_t                      size_;
+	const nt_headers_t         *nt_headers_;
+	const IMAGE_SECTION_HEADER *sections_;
+	size_t                      section_count_;
+};
+
+//--------------------------------------------------------------------------
+// Name: pe_export_records
+// Desc: the exported functions and data, by RVA so that the symbol manager
+//       adds the base the module was loaded at. Exports forwarded to another
+//       DLL have no address in this one and are left out
+//--------------------------------------------------------------------------
+template <class M>
+void pe_export_records(const PEImage<M> &image, QVector<SymbolCache::Record> *records) {
+
+	const IMAGE_DATA_DIRECTORY *const entry = image.directory(IMAGE_DIRECTORY_ENTRY_EXPORT);
+	if(!entry) {
+		return;
+	}
+
+	const IMAGE_EXPORT_DIRECTORY *const exports = reinterpret_cast<const IMAGE_EXPORT_DIRECTORY *>(image.at(entry->VirtualAddress, sizeof(IMAGE_EXPORT_DIRECTORY)));
+	if(!exports) {
+		return;
+	}
+
+	const DWORD *const functions = reinterpret_cast<const DWORD *>(image.at(exports->AddressOfFunctions, static_cast<quint64>(exports->NumberOfFunctions) * sizeof(DWORD)));
+	const DWORD *const names     = reinterpret_cast<const DWORD *>(image.at(exports->AddressOfNames, static_cast<quint64>(exports->NumberOfNames) * sizeof(DWORD)));
+	const WORD *const  ordinals  = reinterpret_cast<const WORD *>(image.at(exports->AddressOfNameOrdinals, static_cast<quint64>(exports->NumberOfNames) * sizeof(WORD)));
+	if(!functions) {
+		return;
+	}
+
+	QVector<QByteArray> function_names(exports->NumberOfFunctions);
+	if(names && ordinals) {
+		for(DWORD i = 0; i < exports->NumberOfNames; ++i) {
+			if(ordinals[i] < exports->NumberOfFunctions) {
+				function_names[ordinals[i]] = image.string(names[i]);
+			}
+		}
+	}
+
+	for(DWORD i = 0; i < exports->NumberOfFunctions; ++i) {
+		const DWORD rva = functions[i];
+		if(rva == 0 || (rva >= entry->VirtualAddress && rva < entry->VirtualAddress + entry->Size)) {
+			continue;
+		}
+
+		SymbolCache::Record record;
+		record.address = rva;
+		record.size    = 0;
+		record.name    = function_names[i].isEmpty() ? QByteArray("$ordinal_") + QByteArray::number(exports->Base + i) : function_names[i];
+		record.type    = image.executable(rva) ? 'T' : 'D';
+		records->push_back(record);
+	}
+}
+
+//--------------------------------------------------------------------------
+// Name: pe_import_records
+// Desc: the import address table slots, named "function@dll" like the PLT
+//       entries of ELF files. The loader writes the function's address over
+//       each one, so they are pointers rather than code
+//--------------------------------------------------------------------------
+template <class M>
+void pe_import_records(const PEImage<M> &image, QVector<SymbolCache::Record> *records) {
+
+	typedef typename M::thunk_t thunk_t;
+
+	const IMAGE_DATA_DIRECTORY *const entry = image.directory(IMAGE_DIRECTORY_ENTRY_IMPORT);
+	if(!entry) {
+		return;
+	}
+
+	for(quint64 rva = entry->VirtualAddress;; rva += sizeof(IMAGE_IMPORT_DESCRIPTOR)) {
+
+		const IMAGE_IMPORT_DESCRIPTOR *const import = reinterpret_cast<const IMAGE_IMPORT_DESCRIPTOR *>(image.at(rva, sizeof(IMAGE_IMPORT_DESCRIPTOR)));
+		if(!import || (import->Name == 0 && import->FirstThunk == 0)) {
+			break;
+		}
+
+		const QByteArray dll = image.string(import->Name);
+
+		// the names are in the lookup table, the IAT may already have been
+		// bound to addresses on disk
+		const quint64 lookup = import->OriginalFirstThunk ? import->OriginalFirstThunk : import->FirstThunk;
+
+		for(quint64 i = 0;; ++i) {
+			const thunk_t *const thunk = reinterpret_cast<const thunk_t *>(image.at(lookup + i * sizeof(thunk_t), sizeof(thunk_t)));
+			if(!thunk || *thunk == 0) {
+				break;
+			}
+
+			QByteArray name;
+			if(*thunk & M::ordinal_flag) {
+				name = QByteArray("$ordinal_") + QByteArray::number(static_cast<quint32>(*thunk & 0xffff));
+			} else {
+				// skipping the hint in front of the name
+				name = image.string((*thunk & 0x7fffffff) + sizeof(WORD));
+			}
+
+			SymbolCache::Record record;
+			record.address = import->FirstThunk + i * sizeof(thunk_t);
+			record.size    = sizeof(thunk_t);
+			record.name    = name + '@' + dll;
+			record.type    = 'D';
+			records->push_back(record);
+		}
+	}
+}
+
+//--------------------------------------------------------------------------
+// Name: pe_records
+// Desc:
+//--------------------------------------------------------------------------
+template <class M>
+QVector<SymbolCache::Record> pe_records(const void *p, size_t size) {
+
+	const PEImage<M> image(p, size);
+
+	QVector<SymbolCache::Record> records;
+	pe_export_records(image, &records);
+	pe_import_records(image, &records);
+	return records;
+}
+
+//--------------------------------------------------------------------------
+// Name: file_records
+// Desc: the symbols of an ELF file, or the exports and imports of a PE file,
+//       as cache records
+//--------------------------------------------------------------------------
+bool file_records(const QString &filename, QVector<SymbolCache::Record> *records) {
+
+	const MappedFile file = MappedFile::open(filename);
+	if(const void *const file_ptr = file.data()) {
+		if(is_elf64(file_ptr)) {
+			*records = cache_records<elf64_model>(file_ptr, file.size());
+			return true;
+		} else if(is_elf32(file_ptr)) {
+			*records = cache_records<elf32_model>(file_ptr, file.size());
+			return true;
+		}
+
+		switch(pe_optional_magic(file_ptr, file.size())) {
+		case IMAGE_NT_OPTIONAL_HDR32_MAGIC:
+			*records = pe_records<pe32_model>(file_ptr, file.size());
+			return true;
+		case IMAGE_NT_OPTIONAL_HDR64_MAGIC:
+			*records = pe_records<pe64_model>(file_ptr, file.size());
+			return true;
+		default:
+			qDebug() << "unknown file type";
+			break;
+		}
+	}
+	return false;
+}
 }
 
 //--------------------------------------------------------------------------
@@ -413,8 +941,8 @@ void process_symbols(const void *p, size_t size, std::ostream &os) {
 //--------------------------------------------------------------------------
 bool generate_symbols(const QString &filename, std::ostream &os) {
 
-	QFile file(filename);
-	if(file.open(QIODevice::ReadOnly)) {
+	const MappedFile file = MappedFile::open(filename);
+	if(file.is_open()) {
 #if QT_VERSION >= 0x040700
 		os << qPrintable(QDateTime::currentDateTimeUtc().toString(Qt::ISODate)) << " +0000" << '\n';
 #else
@@ -423,18 +951,113 @@ bool generate_symbols(const QString &filename, std::ostream &os) {
 		const QByteArray md5 = edb::v1::get_file_md5(filename);
 		os << md5.toHex().data() << ' ' << qPrintable(QFileInfo(filename).absoluteFilePath()) << '\n';
 
-		if(const void *const file_ptr = reinterpret_cast<void *>(file.map(0, file.size(), QFile::NoOptions))) {
-			if(is_elf64(file_ptr)) {
-				process_symbols<elf64_model>(file_ptr, file.size(), os);
-				return true;
-			} else if(is_elf32(file_ptr)) {
-				process_symbols<elf32_model>(file_ptr, file.size(), os);
-				return true;
-			} else {
-				qDebug() << "unknown file type";
-			}
+		const void *const file_ptr = file.data();
+		if(is_elf64(file_ptr)) {
+			process_symbols<elf64_model>(file_ptr, file.size(), os);
+			return true;
+		} else if(is_elf32(file_ptr)) {
+			process_symbols<elf32_model>(file_ptr, file.size(), os);
+			return true;
+		} else {
+			qDebug() << "unknown file type";
 		}
 	}
 	return false;
 }
+
+//--------------------------------------------------------------------------
+// Name: generate_symbol_cache
+// Desc: writes the binary symbol cache that the symbol manager maps. A
+//       separate debug file adds its full symbol table and the functions
+//       its DWARF describes, where the file itself had nothing
+//--------------------------------------------------------------------------
+bool generate_symbol_cache(const QString &filename, const QString &cache_file) {
+
+	QVector<SymbolCache::Record> records;
+	if(!file_records(filename, &records)) {
+		return false;
+	}
+
+	QSet<quint64> known;
+	Q_FOREACH(const SymbolCache::Record &record, records) {
+		known.insert(record.address);
+	}
+
+	DebugInfo debug_info(filename);
+
+	QVector<SymbolCache::Record> debug_records;
+	if(!debug_info.debug_filename().isEmpty() && debug_info.debug_filename() != filename && file_records(debug_info.debug_filename(), &debug_records)) {
+		Q_FOREACH(const SymbolCache::Record &record, debug_records) {
+			if(!known.contains(record.address)) {
+				known.insert(record.address);
+				records.push_back(record);
+			}
+		}
+	}
+
+	Q_FOREACH(const DwarfReader::Function &function, debug_info.functions()) {
+		if(!known.contains(function.low)) {
+			known.insert(function.low);
+
+			SymbolCache::Record record;
+			record.address = function.low;
+			record.size    = function.high - function.low;
+			record.name    = function.name;
+			record.type    = 'T';
+			records.push_back(record);
+		}
+	}
+
+	return SymbolCache::write(cache_file, filename, records);
+}
+
+//--------------------------------------------------------------------------
+// Name: DebugInfo
+// Desc: nothing is parsed until it is asked for
+//--------------------------------------------------------------------------
+DebugInfo::DebugInfo(const QString &filename) : file_(MappedFile::open(filename)) {
+
+	DwarfSections sections;
+	QByteArray id;
+	QByteArray debug_link;
+
+	if(!map_debug_sections(file_, &sections, &id, &debug_link)) {
+		return;
+	}
+
+	if(!sections.info.isEmpty()) {
+		debug_filename_ = filename;
+	} else {
+		const QString path = find_debug_file(filename, id, debug_link);
+		if(path.isEmpty()) {
+			return;
+		}
+
+		sections = DwarfSections();
+		debug_file_ = MappedFile::open(path);
+		if(!map_debug_sections(debug_file_, &sections, 0, 0)) {
+			return;
+		}
+
+		debug_filename_ = path;
+	}
+
+	reader_.reset(new DwarfReader(sections));
+}
+
+//--------------------------------------------------------------------------
+// Name: functions
+// Desc:
+//--------------------------------------------------------------------------
+QList<DwarfReader::Function> DebugInfo::functions() {
+	return reader_ ? reader_->functions() : QList<DwarfReader::Function>();
+}
+
+//--------------------------------------------------------------------------
+// Name: find_line
+// Desc: <address> is relative to how the file was linked
+//--------------------------------------------------------------------------
+bool DebugInfo::find_line(quint64 address, QString *file, int *line, quint64 *start) {
+	return reader_ && reader_->find_line(address, file, line, start);
+}
 }
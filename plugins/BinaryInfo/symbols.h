@@ -19,11 +19,36 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #ifndef SYMBOLS_20110312_H_
 #define SYMBOLS_20110312_H_
 
-class QString;
+#include "MappedFile.h"
+#include "dwarf.h"
+#include <QScopedPointer>
+#include <QString>
 #include <iostream>
 
 namespace BinaryInfo {
 bool generate_symbols(const QString &filename, std::ostream &os = std::cout);
+bool generate_symbol_cache(const QString &filename, const QString &cache_file);
+
+// the DWARF of an ELF file, or of the separate debug file it names through its
+// build-id or .gnu_debuglink. The files stay mapped for as long as this lives
+class DebugInfo {
+public:
+	explicit DebugInfo(const QString &filename);
+
+public:
+	QString debug_filename() const { return debug_filename_; }
+	QList<DwarfReader::Function> functions();
+	bool find_line(quint64 address, QString *file, int *line, quint64 *start);
+
+private:
+	Q_DISABLE_COPY(DebugInfo)
+
+private:
+	MappedFile                  file_;
+	MappedFile                  debug_file_;
+	QString                     debug_filename_;
+	QScopedPointer<DwarfReader> reader_;
+};
 }
 
 #endif
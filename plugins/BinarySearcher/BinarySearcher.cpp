@@ -20,6 +20,10 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "edb.h"
 #include "DialogASCIIString.h"
 #include "DialogBinaryString.h"
+#include "DialogMultiPattern.h"
+#include "ByteSearcher.h"
+#include "PatternScan.h"
+#include "RegionScanner.h"
 #include <QMenu>
 
 namespace BinarySearcher {
@@ -49,6 +53,7 @@ QMenu *BinarySearcher::menu(QWidget *parent) {
 	if(!menu_) {
 		menu_ = new QMenu(tr("BinarySearcher"), parent);
 		menu_->addAction(tr("&Binary String Search"), this, SLOT(show_menu()), QKeySequence(tr("Ctrl+F")));
+		menu_->addAction(tr("&Multiple Pattern Search"), this, SLOT(show_multi_pattern()));
 	}
 
 	return menu_;
@@ -78,6 +83,15 @@ void BinarySearcher::show_menu() {
 	dialog->show();
 }
 
+//------------------------------------------------------------------------------
+// Name: show_multi_pattern
+// Desc:
+//------------------------------------------------------------------------------
+void BinarySearcher::show_multi_pattern() {
+	static QDialog *const dialog = new DialogMultiPattern(edb::v1::debugger_ui);
+	dialog->show();
+}
+
 //------------------------------------------------------------------------------
 // Name: mnuStackFindASCII
 // Desc:
@@ -87,6 +101,48 @@ void BinarySearcher::mnuStackFindASCII() {
 	dialog->show();
 }
 
+//------------------------------------------------------------------------------
+// Name: run_benchmarks
+// Desc: the binary string search over all of <regions>, with a short, a long
+//       and a masked pattern, as they take different paths through the
+//       searcher
+//------------------------------------------------------------------------------
+QList<BenchmarkResult> BinarySearcher::run_benchmarks(const QList<IRegion::pointer> &regions) {
+
+	static const char *const patterns[] = {
+		"c3",
+		"55 48 89 e5",
+		"48 8b ?? 24 ?? e8",
+		"48 89 5c 24 08 48 89 6c 24 10 48 89 74 24 18 57"
+	};
+
+	const quint64 bytes = BenchmarkRun::bytes(regions);
+
+	BenchmarkRun run("DialogBinaryString::do_find", "matches");
+
+	for(std::size_t i = 0; i < sizeof(patterns) / sizeof(patterns[0]); ++i) {
+
+		QByteArray pattern;
+		QByteArray mask;
+		if(!ByteSearcher::parse(patterns[i], &pattern, &mask)) {
+			continue;
+		}
+
+		const ByteSearcher searcher(pattern, mask);
+
+		run.start();
+
+		PatternScan scan(searcher, 0, 0);
+		RegionScanner().run(regions, &scan);
+
+		QVariantMap parameters;
+		parameters["pattern"] = patterns[i];
+		run.finish(parameters, bytes, scan.matches());
+	}
+
+	return run.results();
+}
+
 #if QT_VERSION < 0x050000
 Q_EXPORT_PLUGIN2(BinarySearcher, BinarySearcher)
 #endif
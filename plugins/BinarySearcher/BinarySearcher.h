@@ -42,9 +42,11 @@ public:
 public:
 	virtual QMenu *menu(QWidget *parent = 0);
 	virtual QList<QAction *> stack_context_menu();
+	virtual QList<BenchmarkResult> run_benchmarks(const QList<IRegion::pointer> &regions);
 
 public Q_SLOTS:
 	void show_menu();
+	void show_multi_pattern();
 	void mnuStackFindASCII();
 
 private:
@@ -2,6 +2,6 @@
 include(../plugins.pri)
 
 # Input
-HEADERS += BinarySearcher.h DialogBinaryString.h DialogASCIIString.h
-FORMS += DialogBinaryString.ui DialogASCIIString.ui
-SOURCES += BinarySearcher.cpp DialogBinaryString.cpp DialogASCIIString.cpp
+HEADERS += BinarySearcher.h DialogBinaryString.h DialogASCIIString.h DialogMultiPattern.h PatternScan.h
+FORMS += DialogBinaryString.ui DialogASCIIString.ui DialogMultiPattern.ui
+SOURCES += BinarySearcher.cpp DialogBinaryString.cpp DialogASCIIString.cpp DialogMultiPattern.cpp PatternScan.cpp
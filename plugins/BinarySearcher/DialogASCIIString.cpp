@@ -19,9 +19,12 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "DialogASCIIString.h"
 #include "edb.h"
 #include "IDebugger.h"
+#include "IProcess.h"
 #include "MemoryRegions.h"
+#include "RegionReader.h"
 #include "State.h"
 #include "Util.h"
+#include <QHash>
 #include <QMessageBox>
 #include <QVector>
 #include <cstring>
@@ -32,6 +35,19 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 namespace BinarySearcher {
 
+namespace {
+
+// how many pointers have their targets read in one batch
+const int batch_size = 4096;
+
+// a stack slot and where it points
+struct Candidate {
+	edb::address_t slot;
+	edb::address_t value;
+};
+
+}
+
 //------------------------------------------------------------------------------
 // Name: DialogASCIIString
 // Desc: constructor
@@ -68,29 +84,62 @@ void DialogASCIIString::do_find() {
 		edb::v1::debugger_core->get_state(&state);
 		edb::address_t stack_ptr = state.stack_pointer();
 
-		if(IRegion::pointer region = edb::v1::memory_regions().find_region(stack_ptr)) {
+		const MemoryRegions &regions = edb::v1::memory_regions();
+
+		if(IRegion::pointer region = regions.find_region(stack_ptr)) {
 			if(IProcess *process = edb::v1::debugger_core->process()) {
-				std::size_t count = (region->end() - stack_ptr) / sizeof(edb::address_t);
-				stack_ptr = region->start();
+
+				// read the whole stack once, keeping the slots which point
+				// into memory that is mapped at all
+				QVector<Candidate> candidates;
+
+				RegionReader reader(region);
+				while(reader.next()) {
+					for(std::size_t i = 0; i + sizeof(edb::address_t) <= reader.size(); i += sizeof(edb::address_t)) {
+						Candidate candidate;
+						candidate.slot = reader.address() + i;
+						std::memcpy(&candidate.value, reader.data() + i, sizeof(edb::address_t));
+
+						if(regions.find_region(candidate.value)) {
+							candidates.push_back(candidate);
+						}
+					}
+
+					ui->progressBar->setValue(util::percentage(reader.offset(), region->size()) / 2);
+				}
 
 				try {
-					QVector<quint8> chars(sz);
-
-					int i = 0;
-					while(stack_ptr < region->end()) {
-						// get the value from the stack
-						edb::address_t value;
-						if(process->read_bytes(stack_ptr, &value, sizeof(edb::address_t))) {
-							if(process->read_bytes(value, &chars[0], sz)) {
-								if(std::memcmp(&chars[0], b.constData(), sz) == 0) {
-									QListWidgetItem *const item = new QListWidgetItem(edb::v1::format_pointer(stack_ptr));
-									item->setData(Qt::UserRole, stack_ptr);
-									ui->listWidget->addItem(item);
-								}
+					// then read what they point to a batch at a time, a target
+					// which several slots point to is only read once
+					QVector<quint8> chars(batch_size * sz);
+
+					for(int first = 0; first < candidates.size(); first += batch_size) {
+						const int last = qMin(first + batch_size, candidates.size());
+
+						QVector<IProcess::ReadRequest> requests;
+						QHash<edb::address_t, int>     request_index;
+
+						for(int i = first; i < last; ++i) {
+							const edb::address_t value = candidates[i].value;
+							if(!request_index.contains(value)) {
+								request_index.insert(value, requests.size());
+								requests.push_back(IProcess::ReadRequest(value, &chars[requests.size() * sz], sz));
 							}
 						}
-						ui->progressBar->setValue(util::percentage(i++, count));
-						stack_ptr += sizeof(edb::address_t);
+
+						const QVector<bool> results = process->read_batch(requests);
+
+						for(int i = first; i < last; ++i) {
+							const int n = request_index.value(candidates[i].value);
+							if(results[n] && std::memcmp(&chars[n * sz], b.constData(), sz) == 0) {
+								const edb::address_t slot = candidates[i].slot;
+								QListWidgetItem *const item = new QListWidgetItem(edb::v1::format_pointer(slot));
+								item->setData(Qt::UserRole, slot);
+								ui->listWidget->addItem(item);
+							}
+						}
+
+						ui->progressBar->setValue(50 + util::percentage(last, candidates.size()) / 2);
 					}
 				} catch(const std::bad_alloc &) {
 					QMessageBox::information(0, tr("Memroy Allocation Error"),
@@ -17,14 +17,15 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
 #include "DialogBinaryString.h"
-#include "ByteShiftArray.h"
+#include "ByteSearcher.h"
+#include "PatternScan.h"
 #include "edb.h"
 #include "IDebugger.h"
 #include "MemoryRegions.h"
-#include "Util.h"
+#include "RegionScanner.h"
+#include "ResultsModel.h"
 #include <QMessageBox>
 #include <QVector>
-#include <cstring>
 
 #include "ui_DialogBinaryString.h"
 
@@ -34,10 +35,11 @@ namespace BinarySearcher {
 // Name: DialogBinaryString
 // Desc: constructor
 //------------------------------------------------------------------------------
-DialogBinaryString::DialogBinaryString(QWidget *parent) : QDialog(parent), ui(new Ui::DialogBinaryString) {
+DialogBinaryString::DialogBinaryString(QWidget *parent) : QDialog(parent), ui(new Ui::DialogBinaryString), model_(new ResultsModel(this)) {
 	ui->setupUi(this);
 	ui->progressBar->setValue(0);
-	ui->listWidget->clear();
+	ui->listView->setModel(model_);
+	ui->binaryString->setAllowWildcards(true);
 }
 
 //------------------------------------------------------------------------------
@@ -55,59 +57,25 @@ DialogBinaryString::~DialogBinaryString() {
 void DialogBinaryString::do_find() {
 
 	const QByteArray b = ui->binaryString->value();
-	ui->listWidget->clear();
+	model_->clear();
 
 	const int sz = b.size();
 	if(sz != 0) {
-		ByteShiftArray bsa(sz);
-
 		edb::v1::memory_regions().sync();
 		const QList<IRegion::pointer> regions = edb::v1::memory_regions().regions();
-		const edb::address_t page_size = edb::v1::debugger_core->page_size();
+		const edb::address_t align            = 1 << (ui->cmbAlignment->currentIndex() + 1);
+		const ByteSearcher searcher(b, ui->binaryString->mask(), ui->chkAlignment->isChecked() ? align : 1);
 
-		int i = 0;
+		// a short circut for speading things up
+		QList<IRegion::pointer> searched;
 		Q_FOREACH(const IRegion::pointer &region, regions) {
-
-			bsa.clear();
-
-			// a short circut for speading things up
-			if(ui->chkSkipNoAccess->isChecked() && !region->accessible()) {
-				ui->progressBar->setValue(util::percentage(++i, regions.size()));
-				continue;
+			if(!ui->chkSkipNoAccess->isChecked() || region->accessible()) {
+				searched.push_back(region);
 			}
-
-			const size_t page_count     = region->size() / page_size;
-			const QVector<quint8> pages = edb::v1::read_pages(region->start(), page_count);
-			
-			if(!pages.isEmpty()) {
-
-				const quint8 *p = &pages[0];
-				const quint8 *const pages_end = &pages[0] + region->size();
-				
-				QString temp;
-				while(p != pages_end) {
-					// shift in the next byte
-					bsa << *p;
-
-					// compare values..
-					if(std::memcmp(bsa.data(), b.constData(), sz) == 0) {
-						const edb::address_t addr = (p - &pages[0] + region->start()) - sz + 1;
-						const edb::address_t align = 1 << (ui->cmbAlignment->currentIndex() + 1);
-
-						if(!ui->chkAlignment->isChecked() || (addr % align) == 0) {
-							QListWidgetItem *item = new QListWidgetItem(edb::v1::format_pointer(addr));
-							item->setData(Qt::UserRole, addr);
-							ui->listWidget->addItem(item);
-						}
-					}
-
-					ui->progressBar->setValue(util::percentage(i, regions.size(), p - &pages[0], region->size()));
-
-					++p;
-				}
-			}
-			++i;
 		}
+
+		PatternScan scan(searcher, model_, ui->progressBar);
+		RegionScanner().run(searched, &scan);
 	}
 }
 
@@ -125,12 +93,11 @@ void DialogBinaryString::on_btnFind_clicked() {
 }
 
 //------------------------------------------------------------------------------
-// Name: on_listWidget_itemDoubleClicked
+// Name: on_listView_doubleClicked
 // Desc: follows the found item in the data view
 //------------------------------------------------------------------------------
-void DialogBinaryString::on_listWidget_itemDoubleClicked(QListWidgetItem *item) {
-	const edb::address_t addr = item->data(Qt::UserRole).toULongLong();
-	edb::v1::dump_data(addr, false);
+void DialogBinaryString::on_listView_doubleClicked(const QModelIndex &index) {
+	edb::v1::dump_data(model_->result(index).address, false);
 }
 
 }
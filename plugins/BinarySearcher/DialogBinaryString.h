@@ -21,7 +21,8 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <QDialog>
 
-class QListWidgetItem;
+class QModelIndex;
+class ResultsModel;
 
 namespace BinarySearcher {
 
@@ -36,13 +37,14 @@ public:
 
 public Q_SLOTS:
 	void on_btnFind_clicked();
-	void on_listWidget_itemDoubleClicked(QListWidgetItem *);
+	void on_listView_doubleClicked(const QModelIndex &index);
 
 private:
 	void do_find();
 
 private:
 	 Ui::DialogBinaryString *const ui;
+	 ResultsModel           *const model_;
 };
 
 }
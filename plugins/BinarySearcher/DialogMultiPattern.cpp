@@ -0,0 +1,202 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "DialogMultiPattern.h"
+#include "ByteSearcher.h"
+#include "edb.h"
+#include "IDebugger.h"
+#include "MemoryRegions.h"
+#include "MultiPatternSearcher.h"
+#include "RegionScanner.h"
+#include "ResultsModel.h"
+#include <QMessageBox>
+#include <QStringList>
+
+#include "ui_DialogMultiPattern.h"
+
+namespace BinarySearcher {
+
+namespace {
+
+// a result's type is the id of the pattern which matched
+class PatternFormatter : public ResultsModel::Formatter {
+public:
+	PatternFormatter(const MultiPatternSearcher &searcher, const QVector<int> &lines) : lines_(lines) {
+		for(int i = 0; i < searcher.pattern_count(); ++i) {
+			hex_.push_back(searcher.pattern(i).toHex());
+		}
+	}
+
+public:
+	virtual QString format(const ResultsModel::Result &result) const {
+		return DialogMultiPattern::tr("%1: line %2 [%3]").arg(edb::v1::format_pointer(result.address)).arg(lines_[result.type]).arg(hex_[result.type].constData());
+	}
+
+private:
+	QVector<int>        lines_;
+	QVector<QByteArray> hex_;
+};
+
+// every chunk is scanned from a fresh automaton, the chunk's lookahead is
+// enough for the longest pattern to be found if it starts in the chunk
+class MultiPatternScan : public RegionScanner::Task {
+public:
+	MultiPatternScan(const MultiPatternSearcher &searcher, ResultsModel *model, QProgressBar *progress) : searcher_(searcher), model_(model), progress_(progress), longest_(0) {
+		for(int i = 0; i < searcher_.pattern_count(); ++i) {
+			longest_ = qMax<std::size_t>(longest_, searcher_.pattern(i).size());
+		}
+	}
+
+public:
+	virtual std::size_t lookahead() const {
+		return longest_ - 1;
+	}
+
+	virtual Result *scan(const RegionScanner::Chunk &chunk) const {
+
+		List<ResultsModel::Result> *const result = new List<ResultsModel::Result>;
+		QVector<MultiPatternSearcher::Match> matches;
+
+		searcher_.scan(searcher_.start_state(), chunk.data.constData(), chunk.data.constData() + chunk.data.size(), chunk.address, &matches);
+
+		// the ones which start in the lookahead belong to the next chunk
+		Q_FOREACH(const MultiPatternSearcher::Match &match, matches) {
+			if(match.address - chunk.address < chunk.size) {
+				const ResultsModel::Result r = { match.address, static_cast<quint32>(match.pattern), static_cast<quint32>(searcher_.pattern(match.pattern).size()) };
+				result->items.push_back(r);
+			}
+		}
+
+		return result;
+	}
+
+	virtual void merge(Result *result) {
+		model_->addResults(static_cast<List<ResultsModel::Result> *>(result)->items);
+	}
+
+	virtual void progress(int percent) {
+		progress_->setValue(percent);
+	}
+
+private:
+	const MultiPatternSearcher &searcher_;
+	ResultsModel *const         model_;
+	QProgressBar *const         progress_;
+	std::size_t                 longest_;
+};
+
+}
+
+//------------------------------------------------------------------------------
+// Name: DialogMultiPattern
+// Desc: constructor
+//------------------------------------------------------------------------------
+DialogMultiPattern::DialogMultiPattern(QWidget *parent) : QDialog(parent), ui(new Ui::DialogMultiPattern), model_(new ResultsModel(this)) {
+	ui->setupUi(this);
+	ui->progressBar->setValue(0);
+	ui->listView->setModel(model_);
+}
+
+//------------------------------------------------------------------------------
+// Name: ~DialogMultiPattern
+// Desc:
+//------------------------------------------------------------------------------
+DialogMultiPattern::~DialogMultiPattern() {
+	delete ui;
+}
+
+//------------------------------------------------------------------------------
+// Name: build_searcher
+// Desc: adds every line of hex to <searcher>, <lines> gets the line number of
+//       each pattern id. Complains and returns false about the first line
+//       which isn't a pattern
+//------------------------------------------------------------------------------
+bool DialogMultiPattern::build_searcher(MultiPatternSearcher *searcher, QVector<int> *lines) {
+
+	const QStringList text = ui->txtPatterns->toPlainText().split('\n');
+
+	for(int i = 0; i < text.size(); ++i) {
+		QByteArray pattern;
+		QByteArray mask;
+
+		if(!ByteSearcher::parse(text[i], &pattern, &mask) || mask.count(static_cast<char>(0xff)) != mask.size()) {
+			QMessageBox::information(this, tr("Multiple Pattern Search"), tr("Line %1 is not a pattern, patterns are bytes of hex without wildcards: %2").arg(i + 1).arg(text[i]));
+			return false;
+		}
+
+		if(searcher->add_pattern(pattern) != -1) {
+			lines->push_back(i + 1);
+		}
+	}
+
+	searcher->compile();
+	return true;
+}
+
+//------------------------------------------------------------------------------
+// Name: do_find
+// Desc: reads every region once, looking for all of the patterns at the same
+//       time
+//------------------------------------------------------------------------------
+void DialogMultiPattern::do_find() {
+
+	model_->clear();
+
+	MultiPatternSearcher searcher;
+	QVector<int>         lines;
+	if(!build_searcher(&searcher, &lines) || searcher.pattern_count() == 0) {
+		return;
+	}
+
+	edb::v1::memory_regions().sync();
+	const QList<IRegion::pointer> regions = edb::v1::memory_regions().regions();
+
+	QList<IRegion::pointer> searched;
+	Q_FOREACH(const IRegion::pointer &region, regions) {
+		if(!ui->chkSkipNoAccess->isChecked() || region->accessible()) {
+			searched.push_back(region);
+		}
+	}
+
+	model_->setFormatter(new PatternFormatter(searcher, lines));
+
+	MultiPatternScan scan(searcher, model_, ui->progressBar);
+	RegionScanner().run(searched, &scan);
+}
+
+//------------------------------------------------------------------------------
+// Name: on_btnFind_clicked
+// Desc: find button event handler
+//------------------------------------------------------------------------------
+void DialogMultiPattern::on_btnFind_clicked() {
+
+	ui->btnFind->setEnabled(false);
+	ui->progressBar->setValue(0);
+	do_find();
+	ui->progressBar->setValue(100);
+	ui->btnFind->setEnabled(true);
+}
+
+//------------------------------------------------------------------------------
+// Name: on_listView_doubleClicked
+// Desc: follows the found item in the data view
+//------------------------------------------------------------------------------
+void DialogMultiPattern::on_listView_doubleClicked(const QModelIndex &index) {
+	edb::v1::dump_data(model_->result(index).address, false);
+}
+
+}
@@ -0,0 +1,54 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef DIALOGMULTIPATTERN_20261014_H_
+#define DIALOGMULTIPATTERN_20261014_H_
+
+#include <QDialog>
+#include <QVector>
+
+class MultiPatternSearcher;
+class QModelIndex;
+class ResultsModel;
+
+namespace BinarySearcher {
+
+namespace Ui { class DialogMultiPattern; }
+
+class DialogMultiPattern : public QDialog {
+	Q_OBJECT
+
+public:
+	DialogMultiPattern(QWidget *parent = 0);
+	virtual ~DialogMultiPattern();
+
+public Q_SLOTS:
+	void on_btnFind_clicked();
+	void on_listView_doubleClicked(const QModelIndex &index);
+
+private:
+	bool build_searcher(MultiPatternSearcher *searcher, QVector<int> *lines);
+	void do_find();
+
+private:
+	 Ui::DialogMultiPattern *const ui;
+	 ResultsModel           *const model_;
+};
+
+}
+
+#endif
@@ -0,0 +1,86 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "PatternScan.h"
+#include "ByteSearcher.h"
+#include "ResultsModel.h"
+#include <QProgressBar>
+
+namespace BinarySearcher {
+
+//------------------------------------------------------------------------------
+// Name: PatternScan
+// Desc:
+//------------------------------------------------------------------------------
+PatternScan::PatternScan(const ByteSearcher &searcher, ResultsModel *model, QProgressBar *progress) : searcher_(searcher), model_(model), progress_(progress), matches_(0) {
+}
+
+//------------------------------------------------------------------------------
+// Name: lookahead
+// Desc:
+//------------------------------------------------------------------------------
+std::size_t PatternScan::lookahead() const {
+	return searcher_.size() - 1;
+}
+
+//------------------------------------------------------------------------------
+// Name: scan
+// Desc: runs on a pool thread
+//------------------------------------------------------------------------------
+RegionScanner::Task::Result *PatternScan::scan(const RegionScanner::Chunk &chunk) const {
+
+	List<ResultsModel::Result> *const result = new List<ResultsModel::Result>;
+
+	// matches have to start inside of the window, but may run on into the
+	// bytes carried over from the next one
+	const quint8 *const first = chunk.data.constData();
+	const quint8 *const last  = first + qMin<std::size_t>(chunk.data.size(), chunk.size + searcher_.size() - 1);
+
+	const quint8 *p = first;
+	while((p = searcher_.find(p, last, chunk.address + (p - first))) != last) {
+		const ResultsModel::Result r = { chunk.address + (p - first), 0, static_cast<quint32>(searcher_.size()) };
+		result->items.push_back(r);
+		++p;
+	}
+
+	return result;
+}
+
+//------------------------------------------------------------------------------
+// Name: merge
+// Desc:
+//------------------------------------------------------------------------------
+void PatternScan::merge(Result *result) {
+	const QVector<ResultsModel::Result> &items = static_cast<List<ResultsModel::Result> *>(result)->items;
+	matches_ += items.size();
+	if(model_) {
+		model_->addResults(items);
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: progress
+// Desc:
+//------------------------------------------------------------------------------
+void PatternScan::progress(int percent) {
+	if(progress_) {
+		progress_->setValue(percent);
+	}
+}
+
+}
@@ -0,0 +1,56 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef PATTERNSCAN_20261014_H_
+#define PATTERNSCAN_20261014_H_
+
+#include "RegionScanner.h"
+
+class ByteSearcher;
+class QProgressBar;
+class ResultsModel;
+
+namespace BinarySearcher {
+
+// finds every match of one pattern, each window carries the start of the
+// next one, so that matches which straddle a window boundary are still found.
+// The matches go into <model> and <progress> is kept up to date, either may
+// be null when nobody is looking
+class PatternScan : public RegionScanner::Task {
+public:
+	PatternScan(const ByteSearcher &searcher, ResultsModel *model, QProgressBar *progress);
+
+public:
+	virtual std::size_t lookahead() const;
+	virtual Result *scan(const RegionScanner::Chunk &chunk) const;
+	virtual void merge(Result *result);
+	virtual void progress(int percent);
+
+public:
+	quint64 matches() const { return matches_; }
+
+private:
+	const ByteSearcher &searcher_;
+	ResultsModel *const model_;
+	QProgressBar *const progress_;
+	quint64             matches_;
+};
+
+}
+
+#endif
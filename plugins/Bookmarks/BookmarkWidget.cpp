@@ -22,7 +22,6 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <QInputDialog>
 #include <QMenu>
 #include <QMessageBox>
-#include <QScopedPointer>
 #include <QTableWidgetItem>
 
 #include "ui_Bookmarks.h"
@@ -35,6 +34,16 @@ namespace Bookmarks {
 //------------------------------------------------------------------------------
 BookmarkWidget::BookmarkWidget(QWidget *parent, Qt::WindowFlags f) : QWidget(parent, f), ui(new Ui::Bookmarks) {
 	ui->setupUi(this);
+
+	// the bookmarks are kept with the rest of the annotations, the table
+	// shows them in the same order as they are kept there
+	Annotations *const annotations = &edb::v1::annotations();
+	connect(annotations, SIGNAL(changed(Annotations::Kind, edb::address_t)), this, SLOT(annotation_changed(Annotations::Kind, edb::address_t)));
+	connect(annotations, SIGNAL(cleared(Annotations::Kind)), this, SLOT(annotations_cleared(Annotations::Kind)));
+
+	Q_FOREACH(const Annotations::Entry &entry, annotations->entries(Annotations::BOOKMARK)) {
+		annotation_changed(Annotations::BOOKMARK, entry.address);
+	}
 }
 
 //------------------------------------------------------------------------------
@@ -66,7 +75,8 @@ void BookmarkWidget::on_tableWidget_cellDoubleClicked(int row, int col) {
 			bool ok;
 			const QString new_comment = QInputDialog::getText(ui->tableWidget, tr("Comment"), tr("Set Comment:"), QLineEdit::Normal, old_comment, &ok);
 			if(ok) {
-				ui->tableWidget->setItem(row, 1, new QTableWidgetItem(new_comment));
+				ui->tableWidget->setCurrentCell(row, col);
+				set_current_comment(new_comment);
 			}
 		}
 		break;
@@ -90,11 +100,10 @@ void BookmarkWidget::on_btnAdd_clicked() {
 // Desc:
 //------------------------------------------------------------------------------
 void BookmarkWidget::on_btnDel_clicked() {
-	QScopedPointer<QTableWidgetItem> item(ui->tableWidget->takeItem(ui->tableWidget->currentRow(), 0));
-	ui->tableWidget->removeRow(ui->tableWidget->currentRow());
-	if(item) {
-		const edb::address_t address = item->data(Qt::UserRole).toULongLong();
-		entries_.remove(address);
+	bool ok;
+	const edb::address_t address = current_address(&ok);
+	if(ok) {
+		edb::v1::annotations().remove(Annotations::BOOKMARK, address);
 	}
 }
 
@@ -103,9 +112,10 @@ void BookmarkWidget::on_btnDel_clicked() {
 // Desc:
 //------------------------------------------------------------------------------
 void BookmarkWidget::on_btnClear_clicked() {
-	ui->tableWidget->clearContents();
-	ui->tableWidget->setRowCount(0);
-	entries_.clear();
+	// one at a time, so that the session forgets them too
+	Q_FOREACH(edb::address_t address, entries()) {
+		edb::v1::annotations().remove(Annotations::BOOKMARK, address);
+	}
 }
 
 //------------------------------------------------------------------------------
@@ -113,14 +123,93 @@ void BookmarkWidget::on_btnClear_clicked() {
 // Desc:
 //------------------------------------------------------------------------------
 void BookmarkWidget::add_address(edb::address_t address) {
-	if(!entries_.contains(address)) {
-		QTableWidgetItem *const new_item = new QTableWidgetItem(edb::v1::format_pointer(address));
-		new_item->setData(Qt::UserRole, address);
-		const int row = ui->tableWidget->rowCount();
-		ui->tableWidget->setRowCount(row + 1);
-		ui->tableWidget->setItem(row, 0, new_item);
-		ui->tableWidget->resizeColumnToContents(0);
-		entries_.insert(address);
+	if(!edb::v1::annotations().contains(Annotations::BOOKMARK, address)) {
+		edb::v1::annotations().set(Annotations::BOOKMARK, address, QString());
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: entries
+// Desc:
+//------------------------------------------------------------------------------
+QList<edb::address_t> BookmarkWidget::entries() const {
+	QList<edb::address_t> ret;
+	Q_FOREACH(const Annotations::Entry &entry, edb::v1::annotations().entries(Annotations::BOOKMARK)) {
+		ret.push_back(entry.address);
+	}
+	return ret;
+}
+
+//------------------------------------------------------------------------------
+// Name: annotation_changed
+// Desc: the rows are in the same order as the bookmarks, so the one for
+//       <address> is where the store says it goes
+//------------------------------------------------------------------------------
+void BookmarkWidget::annotation_changed(Annotations::Kind kind, edb::address_t address) {
+
+	if(kind != Annotations::BOOKMARK) {
+		return;
+	}
+
+	const Annotations &annotations               = edb::v1::annotations();
+	const QVector<Annotations::Entry> &bookmarks = annotations.entries(Annotations::BOOKMARK);
+	const Annotations::const_iterator it         = annotations.lower_bound(Annotations::BOOKMARK, address);
+	const int row                                = it - bookmarks.begin();
+
+	QTableWidgetItem *const address_item = ui->tableWidget->item(row, 0);
+	const bool shown = address_item && address_item->data(Qt::UserRole).toULongLong() == address;
+
+	if(it != bookmarks.end() && it->address == address) {
+		if(!shown) {
+			QTableWidgetItem *const new_item = new QTableWidgetItem(edb::v1::format_pointer(address));
+			new_item->setData(Qt::UserRole, address);
+			ui->tableWidget->insertRow(row);
+			ui->tableWidget->setItem(row, 0, new_item);
+			ui->tableWidget->resizeColumnToContents(0);
+		}
+		ui->tableWidget->setItem(row, 1, new QTableWidgetItem(it->text));
+	} else if(shown) {
+		ui->tableWidget->removeRow(row);
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: annotations_cleared
+// Desc:
+//------------------------------------------------------------------------------
+void BookmarkWidget::annotations_cleared(Annotations::Kind kind) {
+	if(kind == Annotations::BOOKMARK) {
+		ui->tableWidget->clearContents();
+		ui->tableWidget->setRowCount(0);
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: current_address
+// Desc: the bookmark in the selected row
+//------------------------------------------------------------------------------
+edb::address_t BookmarkWidget::current_address(bool *ok) const {
+
+	Q_ASSERT(ok);
+
+	if(QTableWidgetItem *const item = ui->tableWidget->item(ui->tableWidget->currentRow(), 0)) {
+		*ok = true;
+		return item->data(Qt::UserRole).toULongLong();
+	}
+
+	*ok = false;
+	return 0;
+}
+
+//------------------------------------------------------------------------------
+// Name: set_current_comment
+// Desc:
+//------------------------------------------------------------------------------
+void BookmarkWidget::set_current_comment(const QString &comment) {
+	bool ok;
+	const edb::address_t address = current_address(&ok);
+	if(ok) {
+		edb::v1::annotations().set(Annotations::BOOKMARK, address, comment);
 	}
 }
 
@@ -164,7 +253,7 @@ void BookmarkWidget::on_tableWidget_customContextMenuRequested(const QPoint &pos
 
 	    const QString text = QInputDialog::getText(ui->tableWidget, tr("Comment"), tr("Set Comment:"), QLineEdit::Normal, current_comment, &ok);
 		if(ok) {
-			ui->tableWidget->setItem(ui->tableWidget->currentRow(), 1, new QTableWidgetItem(text));
+			set_current_comment(text);
 		}
 	}
 }
@@ -20,7 +20,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #define BOOKMARKWIDGET_20101207_H_
 
 #include <QWidget>
-#include <QSet>
+#include "Annotations.h"
 #include "Types.h"
 
 namespace Bookmarks {
@@ -42,13 +42,20 @@ public Q_SLOTS:
 	void on_tableWidget_customContextMenuRequested(const QPoint &pos);
 	void shortcut(int index);
 
+private Q_SLOTS:
+	void annotation_changed(Annotations::Kind kind, edb::address_t address);
+	void annotations_cleared(Annotations::Kind kind);
+
 public:
 	void add_address(edb::address_t address);
-	QList<edb::address_t> entries() const { return entries_.toList(); }
+	QList<edb::address_t> entries() const;
+
+private:
+	edb::address_t current_address(bool *ok) const;
+	void set_current_comment(const QString &comment);
 
 private:
-	Ui::Bookmarks *      ui;
-	QSet<edb::address_t> entries_;
+	Ui::Bookmarks *ui;
 };
 
 }
@@ -17,6 +17,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
 #include "BreakpointManager.h"
+#include "DialogBreakpointLog.h"
 #include "DialogBreakpoints.h"
 #include "edb.h"
 #include <QMenu>
@@ -28,7 +29,7 @@ namespace BreakpointManager {
 // Name: BreakpointManager
 // Desc:
 //------------------------------------------------------------------------------
-BreakpointManager::BreakpointManager() : menu_(0), dialog_(0) {
+BreakpointManager::BreakpointManager() : menu_(0), dialog_(0), log_dialog_(0) {
 }
 
 //------------------------------------------------------------------------------
@@ -37,6 +38,7 @@ BreakpointManager::BreakpointManager() : menu_(0), dialog_(0) {
 //------------------------------------------------------------------------------
 BreakpointManager::~BreakpointManager() {
 	delete dialog_;
+	delete log_dialog_;
 }
 
 //------------------------------------------------------------------------------
@@ -50,6 +52,7 @@ QMenu *BreakpointManager::menu(QWidget *parent) {
 	if(!menu_) {
 		menu_ = new QMenu(tr("BreakpointManager"), parent);
 		menu_->addAction(tr("&Breakpoints"), this, SLOT(show_menu()), QKeySequence(tr("Ctrl+B")));
+		menu_->addAction(tr("Breakpoint &Log"), this, SLOT(show_log()));
 	}
 
 	return menu_;
@@ -68,6 +71,19 @@ void BreakpointManager::show_menu() {
 	dialog_->show();
 }
 
+//------------------------------------------------------------------------------
+// Name: show_log
+// Desc:
+//------------------------------------------------------------------------------
+void BreakpointManager::show_log() {
+
+	if(!log_dialog_) {
+		log_dialog_ = new DialogBreakpointLog(edb::v1::debugger_ui);
+	}
+
+	log_dialog_->show();
+}
+
 #if QT_VERSION < 0x050000
 Q_EXPORT_PLUGIN2(BreakpointManager, BreakpointManager)
 #endif
@@ -44,10 +44,12 @@ public:
 
 public Q_SLOTS:
 	void show_menu();
+	void show_log();
 
 private:
 	QMenu *   menu_;
 	QDialog * dialog_;
+	QDialog * log_dialog_;
 };
 
 }
@@ -2,6 +2,6 @@
 include(../plugins.pri)
 
 # Input
-HEADERS += BreakpointManager.h DialogBreakpoints.h
-FORMS += DialogBreakpoints.ui
-SOURCES += BreakpointManager.cpp DialogBreakpoints.cpp
+HEADERS += BreakpointManager.h BreakpointModel.h DialogBreakpointLog.h DialogBreakpoints.h
+FORMS += DialogBreakpointLog.ui DialogBreakpoints.ui
+SOURCES += BreakpointManager.cpp BreakpointModel.cpp DialogBreakpointLog.cpp DialogBreakpoints.cpp
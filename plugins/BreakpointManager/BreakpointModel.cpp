@@ -0,0 +1,381 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "BreakpointModel.h"
+#include "edb.h"
+
+#include <algorithm>
+
+namespace BreakpointManager {
+
+namespace {
+
+//------------------------------------------------------------------------------
+// Name: item_symbol
+// Desc: symbol lookups are slow enough to matter with many breakpoints, so
+//       they are only done for rows which are shown or sorted on
+//------------------------------------------------------------------------------
+const QString &item_symbol(const BreakpointModel::Item &item) {
+	if(!item.symbol_known) {
+		item.symbol       = edb::v1::find_function_symbol(item.breakpoint->address(), QString(), 0);
+		item.symbol_known = true;
+	}
+	return item.symbol;
+}
+
+// orders rows by one column, pending breakpoints go after the set ones
+class ItemLess {
+public:
+	explicit ItemLess(int column) : column_(column) {
+	}
+
+public:
+	bool operator()(const BreakpointModel::Item &lhs, const BreakpointModel::Item &rhs) const {
+
+		if(!lhs.breakpoint || !rhs.breakpoint) {
+			if(lhs.breakpoint || rhs.breakpoint) {
+				return lhs.breakpoint;
+			}
+			return lhs.location < rhs.location;
+		}
+
+		switch(column_) {
+		case BreakpointModel::CONDITION_COLUMN:
+			return lhs.breakpoint->condition < rhs.breakpoint->condition;
+		case BreakpointModel::LOG_COLUMN:
+			return lhs.breakpoint->log_format < rhs.breakpoint->log_format;
+		case BreakpointModel::BYTE_COLUMN:
+			return lhs.breakpoint->original_byte() < rhs.breakpoint->original_byte();
+		case BreakpointModel::TYPE_COLUMN:
+			return lhs.breakpoint->one_time() < rhs.breakpoint->one_time();
+		case BreakpointModel::FUNCTION_COLUMN:
+			return item_symbol(lhs) < item_symbol(rhs);
+		case BreakpointModel::HITS_COLUMN:
+			return lhs.hits < rhs.hits;
+		default:
+			return lhs.breakpoint->address() < rhs.breakpoint->address();
+		}
+	}
+
+private:
+	int column_;
+};
+
+// the same, the other way around
+class ItemGreater {
+public:
+	explicit ItemGreater(int column) : less_(column) {
+	}
+
+public:
+	bool operator()(const BreakpointModel::Item &lhs, const BreakpointModel::Item &rhs) const {
+		return less_(rhs, lhs);
+	}
+
+private:
+	ItemLess less_;
+};
+
+}
+
+//------------------------------------------------------------------------------
+// Name: BreakpointModel
+// Desc:
+//------------------------------------------------------------------------------
+BreakpointModel::BreakpointModel(QObject *parent) : QAbstractItemModel(parent), sort_column_(ADDRESS_COLUMN), sort_order_(Qt::AscendingOrder) {
+}
+
+//------------------------------------------------------------------------------
+// Name: ~BreakpointModel
+// Desc:
+//------------------------------------------------------------------------------
+BreakpointModel::~BreakpointModel() {
+}
+
+//------------------------------------------------------------------------------
+// Name: index
+// Desc:
+//------------------------------------------------------------------------------
+QModelIndex BreakpointModel::index(int row, int column, const QModelIndex &parent) const {
+	Q_UNUSED(parent);
+
+	if(row < 0 || row >= rowCount(parent) || column < 0 || column >= columnCount(parent)) {
+		return QModelIndex();
+	}
+
+	return createIndex(row, column, const_cast<Item *>(&items_[row]));
+}
+
+//------------------------------------------------------------------------------
+// Name: parent
+// Desc:
+//------------------------------------------------------------------------------
+QModelIndex BreakpointModel::parent(const QModelIndex &index) const {
+	Q_UNUSED(index);
+	return QModelIndex();
+}
+
+//------------------------------------------------------------------------------
+// Name: data
+// Desc: Qt::UserRole is the address, Qt::UserRole + 1 the pending location
+//------------------------------------------------------------------------------
+QVariant BreakpointModel::data(const QModelIndex &index, int role) const {
+
+	if(!index.isValid()) {
+		return QVariant();
+	}
+
+	const Item &item = items_[index.row()];
+
+	if(role == Qt::UserRole) {
+		if(item.breakpoint) {
+			return static_cast<qulonglong>(item.breakpoint->address());
+		}
+	} else if(role == Qt::UserRole + 1) {
+		if(!item.breakpoint) {
+			return item.location;
+		}
+	} else if(role == Qt::DisplayRole) {
+
+		if(!item.breakpoint) {
+			switch(index.column()) {
+			case ADDRESS_COLUMN:
+			case TYPE_COLUMN:
+				return tr("Pending");
+			case FUNCTION_COLUMN:
+				return item.location;
+			default:
+				return QVariant();
+			}
+		}
+
+		switch(index.column()) {
+		case ADDRESS_COLUMN:
+			return edb::v1::format_pointer(item.breakpoint->address());
+		case CONDITION_COLUMN:
+			return item.breakpoint->condition;
+		case LOG_COLUMN:
+			return item.breakpoint->log_format;
+		case BYTE_COLUMN:
+			return edb::v1::format_bytes(item.breakpoint->original_byte());
+		case TYPE_COLUMN:
+			if(!item.breakpoint->log_format.isEmpty()) {
+				return tr("Logpoint");
+			}
+			return item.breakpoint->one_time() ? tr("One Time") : tr("Standard");
+		case FUNCTION_COLUMN:
+			return item_symbol(item);
+		case HITS_COLUMN:
+			return item.hits;
+		}
+	}
+
+	return QVariant();
+}
+
+//------------------------------------------------------------------------------
+// Name: headerData
+// Desc:
+//------------------------------------------------------------------------------
+QVariant BreakpointModel::headerData(int section, Qt::Orientation orientation, int role) const {
+	if(role == Qt::DisplayRole && orientation == Qt::Horizontal) {
+		switch(section) {
+		case ADDRESS_COLUMN:
+			return tr("Address");
+		case CONDITION_COLUMN:
+			return tr("Condition");
+		case LOG_COLUMN:
+			return tr("Log Message");
+		case BYTE_COLUMN:
+			return tr("Original Byte");
+		case TYPE_COLUMN:
+			return tr("Type");
+		case FUNCTION_COLUMN:
+			return tr("Function");
+		case HITS_COLUMN:
+			return tr("Hits");
+		}
+	}
+
+	return QVariant();
+}
+
+//------------------------------------------------------------------------------
+// Name: columnCount
+// Desc:
+//------------------------------------------------------------------------------
+int BreakpointModel::columnCount(const QModelIndex &parent) const {
+	Q_UNUSED(parent);
+	return COLUMN_COUNT;
+}
+
+//------------------------------------------------------------------------------
+// Name: rowCount
+// Desc:
+//------------------------------------------------------------------------------
+int BreakpointModel::rowCount(const QModelIndex &parent) const {
+	Q_UNUSED(parent);
+	return items_.size();
+}
+
+//------------------------------------------------------------------------------
+// Name: sort
+// Desc: sorts the rows themselves, a proxy model in front of 100k rows is
+//       much slower
+//------------------------------------------------------------------------------
+void BreakpointModel::sort(int column, Qt::SortOrder order) {
+
+	sort_column_ = column;
+	sort_order_  = order;
+
+	Q_EMIT layoutAboutToBeChanged();
+
+	const QModelIndexList from = persistentIndexList();
+	QVector<IBreakpoint::pointer> from_breakpoints;
+	QStringList                   from_locations;
+	Q_FOREACH(const QModelIndex &index, from) {
+		from_breakpoints.push_back(items_[index.row()].breakpoint);
+		from_locations.push_back(items_[index.row()].location);
+	}
+
+	if(order == Qt::AscendingOrder) {
+		std::stable_sort(items_.begin(), items_.end(), ItemLess(column));
+	} else {
+		std::stable_sort(items_.begin(), items_.end(), ItemGreater(column));
+	}
+
+	// the selection is usually one row, so finding it again is cheap
+	if(!from.isEmpty()) {
+		QModelIndexList to;
+		Q_FOREACH(const QModelIndex &index, from) {
+			const int n = to.size();
+			for(int row = 0; row < items_.size(); ++row) {
+				if(items_[row].breakpoint == from_breakpoints[n] && items_[row].location == from_locations[n]) {
+					to.push_back(createIndex(row, index.column(), &items_[row]));
+					break;
+				}
+			}
+
+			if(to.size() == n) {
+				to.push_back(QModelIndex());
+			}
+		}
+		changePersistentIndexList(from, to);
+	}
+
+	Q_EMIT layoutChanged();
+}
+
+//------------------------------------------------------------------------------
+// Name: refresh
+// Desc: rebuilds the rows if the breakpoints are not the ones shown. The core
+//       hands out its own list, which is implicitly shared, so while nothing
+//       is added or removed this costs nothing
+//------------------------------------------------------------------------------
+void BreakpointModel::refresh(bool force) {
+
+	const IDebugger::BreakpointList breakpoints = edb::v1::debugger_core->backup_breakpoints();
+	const QStringList               pending     = edb::v1::pending_breakpoints();
+
+	if(!force && breakpoints.isSharedWith(breakpoints_) && pending == pending_) {
+		return;
+	}
+
+	beginResetModel();
+
+	breakpoints_ = breakpoints;
+	pending_     = pending;
+
+	items_.clear();
+	items_.reserve(breakpoints.size() + pending.size());
+
+	for(IDebugger::BreakpointList::const_iterator it = breakpoints.begin(); it != breakpoints.end(); ++it) {
+
+		//Skip if it's an internal bp; we don't want to insert a row for it.
+		if(it.value()->internal()) {
+			continue;
+		}
+
+		Item item;
+		item.breakpoint   = it.value();
+		item.hits         = it.value()->hit_count();
+		item.symbol_known = false;
+		items_.push_back(item);
+	}
+
+	// pending breakpoints which are waiting for their module to be loaded
+	Q_FOREACH(const QString &location, pending) {
+		Item item;
+		item.location     = location;
+		item.hits         = 0;
+		item.symbol_known = true;
+		items_.push_back(item);
+	}
+
+	if(sort_order_ == Qt::AscendingOrder) {
+		std::stable_sort(items_.begin(), items_.end(), ItemLess(sort_column_));
+	} else {
+		std::stable_sort(items_.begin(), items_.end(), ItemGreater(sort_column_));
+	}
+
+	endResetModel();
+}
+
+//------------------------------------------------------------------------------
+// Name: update_hits
+// Desc: one dataChanged covering every row whose count moved, so the view
+//       repaints once however many breakpoints were hit. Rows keep their
+//       place until the next sort
+//------------------------------------------------------------------------------
+void BreakpointModel::update_hits() {
+
+	int first = -1;
+	int last  = -1;
+
+	for(int row = 0; row < items_.size(); ++row) {
+		Item &item = items_[row];
+		if(item.breakpoint) {
+			const quint64 hits = item.breakpoint->hit_count();
+			if(hits != item.hits) {
+				item.hits = hits;
+				if(first == -1) {
+					first = row;
+				}
+				last = row;
+			}
+		}
+	}
+
+	if(first != -1) {
+		Q_EMIT dataChanged(index(first, HITS_COLUMN), index(last, HITS_COLUMN));
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: clear
+// Desc: lets go of the breakpoints, so that removed ones can be freed
+//------------------------------------------------------------------------------
+void BreakpointModel::clear() {
+	beginResetModel();
+	breakpoints_.clear();
+	pending_.clear();
+	items_.clear();
+	endResetModel();
+}
+
+}
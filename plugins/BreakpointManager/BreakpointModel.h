@@ -0,0 +1,85 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef BREAKPOINT_MODEL_20261014_H_
+#define BREAKPOINT_MODEL_20261014_H_
+
+#include "IBreakpoint.h"
+#include "IDebugger.h"
+#include <QAbstractItemModel>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+namespace BreakpointManager {
+
+// the core's breakpoints, and the pending ones waiting for their module. The
+// rows are only rebuilt when the set of breakpoints changes, hit counts are
+// updated in place by update_hits
+class BreakpointModel : public QAbstractItemModel {
+	Q_OBJECT
+
+public:
+	enum Column {
+		ADDRESS_COLUMN,
+		CONDITION_COLUMN,
+		LOG_COLUMN,
+		BYTE_COLUMN,
+		TYPE_COLUMN,
+		FUNCTION_COLUMN,
+		HITS_COLUMN,
+		COLUMN_COUNT
+	};
+
+	struct Item {
+		IBreakpoint::pointer breakpoint;  // null for pending ones
+		QString              location;    // the pending location
+		quint64              hits;
+		mutable QString      symbol;      // looked up when first shown
+		mutable bool         symbol_known;
+	};
+
+public:
+	BreakpointModel(QObject *parent = 0);
+	virtual ~BreakpointModel();
+
+public:
+	virtual QModelIndex index(int row, int column, const QModelIndex &parent = QModelIndex()) const;
+	virtual QModelIndex parent(const QModelIndex &index) const;
+	virtual QVariant data(const QModelIndex &index, int role) const;
+	virtual QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const;
+	virtual int columnCount(const QModelIndex &parent = QModelIndex()) const;
+	virtual int rowCount(const QModelIndex &parent = QModelIndex()) const;
+	virtual void sort(int column, Qt::SortOrder order = Qt::AscendingOrder);
+
+public:
+	void refresh(bool force = false);
+	void update_hits();
+	void clear();
+
+private:
+	IDebugger::BreakpointList breakpoints_;
+	QStringList               pending_;
+	QVector<Item>             items_;
+	int                       sort_column_;
+	Qt::SortOrder             sort_order_;
+};
+
+}
+
+#endif
@@ -0,0 +1,103 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "DialogBreakpointLog.h"
+#include "edb.h"
+
+#include <QPlainTextEdit>
+#include <QStringList>
+#include <QTimer>
+
+#include "ui_DialogBreakpointLog.h"
+
+namespace BreakpointManager {
+
+namespace {
+
+const int LogUpdatesPerSecond = 4;
+
+// the view forgets the oldest lines past this many
+const int MaxLogLines = 50000;
+
+}
+
+//------------------------------------------------------------------------------
+// Name: DialogBreakpointLog
+// Desc:
+//------------------------------------------------------------------------------
+DialogBreakpointLog::DialogBreakpointLog(QWidget *parent) : QDialog(parent), ui(new Ui::DialogBreakpointLog), timer_(new QTimer(this)) {
+	ui->setupUi(this);
+	ui->textLog->setMaximumBlockCount(MaxLogLines);
+
+	timer_->setInterval(1000 / LogUpdatesPerSecond);
+	connect(timer_, SIGNAL(timeout()), this, SLOT(updateLog()));
+}
+
+//------------------------------------------------------------------------------
+// Name: ~DialogBreakpointLog
+// Desc:
+//------------------------------------------------------------------------------
+DialogBreakpointLog::~DialogBreakpointLog() {
+	delete ui;
+}
+
+//------------------------------------------------------------------------------
+// Name: showEvent
+// Desc: what was logged while it was hidden shows up right away
+//------------------------------------------------------------------------------
+void DialogBreakpointLog::showEvent(QShowEvent *) {
+	updateLog();
+	timer_->start();
+}
+
+//------------------------------------------------------------------------------
+// Name: hideEvent
+// Desc:
+//------------------------------------------------------------------------------
+void DialogBreakpointLog::hideEvent(QHideEvent *) {
+	timer_->stop();
+}
+
+//------------------------------------------------------------------------------
+// Name: updateLog
+// Desc: everything logged since the last update goes in with one append
+//------------------------------------------------------------------------------
+void DialogBreakpointLog::updateLog() {
+
+	quint64 lost;
+	QStringList lines = edb::v1::take_breakpoint_log(&lost);
+
+	if(lost) {
+		lines.prepend(tr("[%1 lines were lost]").arg(lost));
+	}
+
+	if(!lines.isEmpty()) {
+		ui->textLog->appendPlainText(lines.join("\n"));
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: on_btnClear_clicked
+// Desc:
+//------------------------------------------------------------------------------
+void DialogBreakpointLog::on_btnClear_clicked() {
+	edb::v1::take_breakpoint_log(0);
+	ui->textLog->clear();
+}
+
+}
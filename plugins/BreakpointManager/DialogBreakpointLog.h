@@ -0,0 +1,54 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef DIALOG_BREAKPOINT_LOG_20261014_H_
+#define DIALOG_BREAKPOINT_LOG_20261014_H_
+
+#include <QDialog>
+
+class QTimer;
+
+namespace BreakpointManager {
+
+namespace Ui { class DialogBreakpointLog; }
+
+// what logpoints have logged, picked up a few times a second while it is
+// shown rather than on every hit
+class DialogBreakpointLog : public QDialog {
+	Q_OBJECT
+
+public:
+	DialogBreakpointLog(QWidget *parent = 0);
+	virtual ~DialogBreakpointLog();
+
+public Q_SLOTS:
+	void updateLog();
+	void on_btnClear_clicked();
+
+private:
+	virtual void showEvent(QShowEvent *event);
+	virtual void hideEvent(QHideEvent *event);
+
+private:
+	Ui::DialogBreakpointLog *const ui;
+	QTimer                  *const timer_;
+};
+
+}
+
+#endif
@@ -17,37 +17,233 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
 #include "DialogBreakpoints.h"
+#include "BreakpointModel.h"
 #include "Expression.h"
 #include "IDebugger.h"
+#include "LogFormat.h"
+#include "State.h"
 #include "edb.h"
 #include "MemoryRegions.h"
 
-#include <QHeaderView>
 #include <QInputDialog>
 #include <QMessageBox>
 
+#include <QDataStream>
 #include <QDir>
 #include <QFileDialog>
 #include <QFile>
 #include <QTextStream>
+#include <QHash>
+#include <QSet>
 #include <QMessageBox>
 #include <QStringList>
+#include <QTimer>
 
 #include "ui_DialogBreakpoints.h"
 
 namespace BreakpointManager {
 
+namespace {
+
+// the binary format is a header followed by one record per breakpoint:
+//
+//     quint32 magic, quint32 version, quint32 count
+//     QString module, quint64 offset, QString condition
+//
+// the offset is from the lowest mapping of the module, an empty module
+// means the offset is the address itself
+const quint32 BinaryMagic   = 0x45444242; // "EDBB"
+const quint32 BinaryVersion = 1;
+const int     MaxErrorsShown = 20;
+
+const int     HitUpdatesPerSecond = 4;
+
+//------------------------------------------------------------------------------
+// Name: set_stream_version
+// Desc:
+//------------------------------------------------------------------------------
+void set_stream_version(QDataStream &stream) {
+	stream.setVersion(QDataStream::Qt_4_6);
+}
+
+//------------------------------------------------------------------------------
+// Name: module_bases
+// Desc: where each mapped file starts, its lowest mapping. One pass over the
+//       regions, rather than one per breakpoint
+//------------------------------------------------------------------------------
+QHash<QString, edb::address_t> module_bases() {
+
+	QHash<QString, edb::address_t> bases;
+	Q_FOREACH(const IRegion::pointer &region, edb::v1::memory_regions().regions()) {
+		if(region->name().startsWith("/")) {
+			QHash<QString, edb::address_t>::iterator it = bases.find(region->name());
+			if(it == bases.end()) {
+				bases.insert(region->name(), region->start());
+			} else if(region->start() < *it) {
+				*it = region->start();
+			}
+		}
+	}
+
+	return bases;
+}
+
+//------------------------------------------------------------------------------
+// Name: is_binary_file
+// Desc: peeks at the magic, leaving the file where it was
+//------------------------------------------------------------------------------
+bool is_binary_file(QIODevice *file) {
+
+	const QByteArray header = file->peek(sizeof(quint32));
+	if(header.size() != sizeof(quint32)) {
+		return false;
+	}
+
+	QDataStream stream(header);
+	set_stream_version(stream);
+
+	quint32 magic;
+	stream >> magic;
+	return magic == BinaryMagic;
+}
+
+}
+
+//------------------------------------------------------------------------------
+// Name: read_text
+// Desc: one hex address per line
+//------------------------------------------------------------------------------
+void DialogBreakpoints::read_text(QIODevice *file, QList<Entry> *entries, QStringList *errors) {
+
+	Q_ASSERT(entries);
+	Q_ASSERT(errors);
+
+	//Addreses should be prefixed with 0x, i.e. a hex number.
+	while (!file->atEnd()) {
+
+		//Get the address
+		const QString line = QString(file->readLine()).trimmed();
+		bool ok;
+		int base = 16;
+		const edb::address_t address = line.toULongLong(&ok, base);
+
+		//Skip if there's an issue.
+		if (!ok) {
+			errors->append(line);
+			continue;
+		}
+
+		Entry entry;
+		entry.address = address;
+		entry.text    = line;
+		entries->append(entry);
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: read_binary
+// Desc: false if the file isn't one this version can read, entries in modules
+//       which aren't loaded are errors
+//------------------------------------------------------------------------------
+bool DialogBreakpoints::read_binary(QIODevice *file, const QHash<QString, edb::address_t> &bases, QList<Entry> *entries, QStringList *errors) {
+
+	Q_ASSERT(entries);
+	Q_ASSERT(errors);
+
+	QDataStream stream(file);
+	set_stream_version(stream);
+
+	quint32 magic;
+	quint32 version;
+	quint32 count;
+	stream >> magic >> version >> count;
+
+	if(stream.status() != QDataStream::Ok || magic != BinaryMagic || version > BinaryVersion) {
+		return false;
+	}
+
+	entries->reserve(count);
+
+	for(quint32 i = 0; i < count; ++i) {
+		QString module;
+		quint64 offset;
+		QString condition;
+		stream >> module >> offset >> condition;
+
+		if(stream.status() != QDataStream::Ok) {
+			return false;
+		}
+
+		Entry entry;
+		entry.condition = condition;
+
+		if(module.isEmpty()) {
+			entry.address = offset;
+			entry.text    = edb::v1::format_pointer(entry.address);
+		} else {
+			entry.text = QString("%1+0x%2").arg(module).arg(offset, 0, 16);
+
+			QHash<QString, edb::address_t>::const_iterator it = bases.find(module);
+			if(it == bases.end()) {
+				errors->append(entry.text);
+				continue;
+			}
+
+			entry.address = *it + offset;
+		}
+
+		entries->append(entry);
+	}
+
+	return true;
+}
+
+//------------------------------------------------------------------------------
+// Name: write_binary
+// Desc: addresses in mapped files are written relative to them, so that they
+//       still work when the file is mapped somewhere else
+//------------------------------------------------------------------------------
+void DialogBreakpoints::write_binary(QIODevice *file, const QHash<QString, edb::address_t> &bases, const QList<IBreakpoint::pointer> &breakpoints) {
+
+	QDataStream stream(file);
+	set_stream_version(stream);
+
+	stream << BinaryMagic << BinaryVersion << static_cast<quint32>(breakpoints.size());
+
+	Q_FOREACH(const IBreakpoint::pointer &bp, breakpoints) {
+		QString        module;
+		edb::address_t offset = bp->address();
+
+		if(const IRegion::pointer region = edb::v1::memory_regions().find_region(bp->address())) {
+			QHash<QString, edb::address_t>::const_iterator it = bases.find(region->name());
+			if(it != bases.end()) {
+				module = region->name();
+				offset = bp->address() - *it;
+			}
+		}
+
+		stream << module << static_cast<quint64>(offset) << bp->condition;
+	}
+}
+
 //------------------------------------------------------------------------------
 // Name: DialogBreakpoints
 // Desc:
 //------------------------------------------------------------------------------
-DialogBreakpoints::DialogBreakpoints(QWidget *parent) : QDialog(parent), ui(new Ui::DialogBreakpoints) {
+DialogBreakpoints::DialogBreakpoints(QWidget *parent) : QDialog(parent), ui(new Ui::DialogBreakpoints), model_(new BreakpointModel(this)), hits_timer_(new QTimer(this)) {
 	ui->setupUi(this);
-#if QT_VERSION >= 0x050000
-	ui->tableWidget->horizontalHeader()->setSectionResizeMode(QHeaderView::ResizeToContents);
-#else
-	ui->tableWidget->horizontalHeader()->setResizeMode(QHeaderView::ResizeToContents);
-#endif
+
+	// sizing the columns to their contents would measure every row
+	ui->tableView->setModel(model_);
+	ui->tableView->sortByColumn(BreakpointModel::ADDRESS_COLUMN, Qt::AscendingOrder);
+	ui->tableView->setColumnWidth(BreakpointModel::ADDRESS_COLUMN, 150);
+	ui->tableView->setColumnWidth(BreakpointModel::CONDITION_COLUMN, 150);
+	ui->tableView->setColumnWidth(BreakpointModel::LOG_COLUMN, 150);
+
+	// hit counts are picked up at most this often while the process runs, not
+	// on every hit
+	hits_timer_->setInterval(1000 / HitUpdatesPerSecond);
+	connect(hits_timer_, SIGNAL(timeout()), this, SLOT(updateHits()));
 }
 
 //------------------------------------------------------------------------------
@@ -64,11 +260,18 @@ DialogBreakpoints::~DialogBreakpoints() {
 //------------------------------------------------------------------------------
 void DialogBreakpoints::showEvent(QShowEvent *) {
 	connect(edb::v1::disassembly_widget(), SIGNAL(signal_updated()), this, SLOT(updateList()));
-	updateList();
+	model_->refresh(true);
+	hits_timer_->start();
 }
 
+//------------------------------------------------------------------------------
+// Name: hideEvent
+// Desc:
+//------------------------------------------------------------------------------
 void DialogBreakpoints::hideEvent(QHideEvent *) {
 	disconnect(edb::v1::disassembly_widget(), SIGNAL(signal_updated()), this, SLOT(updateList()));
+	hits_timer_->stop();
+	model_->clear();
 }
 
 //------------------------------------------------------------------------------
@@ -76,40 +279,29 @@ void DialogBreakpoints::hideEvent(QHideEvent *) {
 // Desc:
 //------------------------------------------------------------------------------
 void DialogBreakpoints::updateList() {
+	model_->refresh();
+}
 
+//------------------------------------------------------------------------------
+// Name: updateHits
+// Desc: also picks up breakpoints which were added or removed some other way
+//------------------------------------------------------------------------------
+void DialogBreakpoints::updateHits() {
+	model_->refresh();
+	model_->update_hits();
+}
 
-	ui->tableWidget->setSortingEnabled(false);
-	ui->tableWidget->setRowCount(0);
-
-	const IDebugger::BreakpointList breakpoint_state = edb::v1::debugger_core->backup_breakpoints();
-
-	Q_FOREACH(const IBreakpoint::pointer &bp, breakpoint_state) {
-
-		//Skip if it's an internal bp; we don't want to insert a row for it.
-		if (bp->internal()) {
-			continue; }
-
-		const int row = ui->tableWidget->rowCount();
-		ui->tableWidget->insertRow(row);
-
-		const edb::address_t address = bp->address();
-		const QString condition      = bp->condition;
-		const quint8 orig_byte       = bp->original_byte();
-		const bool onetime           = bp->one_time();
-		const QString symname        = edb::v1::find_function_symbol(address, QString(), 0);
-		const QString bytes          = edb::v1::format_bytes(orig_byte);
-
-		QTableWidgetItem *item = new QTableWidgetItem(edb::v1::format_pointer(address));
-		item->setData(Qt::UserRole, address);
-
-		ui->tableWidget->setItem(row, 0, item);
-		ui->tableWidget->setItem(row, 1, new QTableWidgetItem(condition));
-		ui->tableWidget->setItem(row, 2, new QTableWidgetItem(bytes));
-		ui->tableWidget->setItem(row, 3, new QTableWidgetItem(onetime ? tr("One Time") : tr("Standard")));
-		ui->tableWidget->setItem(row, 4, new QTableWidgetItem(symname));
+//------------------------------------------------------------------------------
+// Name: selected_index
+// Desc:
+//------------------------------------------------------------------------------
+QModelIndex DialogBreakpoints::selected_index() const {
+	const QModelIndexList sel = ui->tableView->selectionModel()->selectedRows();
+	if(sel.isEmpty()) {
+		return QModelIndex();
 	}
 
-	ui->tableWidget->setSortingEnabled(true);
+	return sel[0];
 }
 
 //------------------------------------------------------------------------------
@@ -121,6 +313,16 @@ void DialogBreakpoints::on_btnAdd_clicked() {
 	bool ok;
     QString text = QInputDialog::getText(this, tr("Add Breakpoint"), tr("Address:"), QLineEdit::Normal, QString(), &ok);
 
+	// module!symbol+offset waits for the module to be loaded
+	if(ok && text.contains('!')) {
+		if(edb::v1::create_pending_breakpoint(text)) {
+			updateList();
+		} else {
+			QMessageBox::information(this, tr("Error In Pending Breakpoint!"), tr("Pending breakpoints are written as module!symbol+offset."));
+		}
+		return;
+	}
+
 	if(ok && !text.isEmpty()) {
 		Expression<edb::address_t> expr(text, edb::v1::get_variable, edb::v1::get_value);
 		ExpressionError err;
@@ -140,16 +342,45 @@ void DialogBreakpoints::on_btnAdd_clicked() {
 // Desc:
 //------------------------------------------------------------------------------
 void DialogBreakpoints::on_btnCondition_clicked() {
-	QList<QTableWidgetItem *> sel = ui->tableWidget->selectedItems();
-	if(!sel.empty()) {
-		QTableWidgetItem *const item = sel[0];
+	const QModelIndex item = selected_index();
+	if(item.isValid() && item.data(Qt::UserRole).isValid()) {
 		bool ok;
-		const edb::address_t address = item->data(Qt::UserRole).toULongLong();
+		const edb::address_t address = item.data(Qt::UserRole).toULongLong();
 		const QString condition      = edb::v1::get_breakpoint_condition(address);
 		const QString text           = QInputDialog::getText(this, tr("Set Breakpoint Condition"), tr("Expression:"), QLineEdit::Normal, condition, &ok);
 		if(ok) {
 			edb::v1::set_breakpoint_condition(address, text);
-			updateList();
+			model_->refresh(true);
+		}
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: on_btnLog_clicked
+// Desc: the message is checked here, so that mistakes in it are found before
+//       the breakpoint is hit
+//------------------------------------------------------------------------------
+void DialogBreakpoints::on_btnLog_clicked() {
+	const QModelIndex item = selected_index();
+	if(item.isValid() && item.data(Qt::UserRole).isValid()) {
+		bool ok;
+		const edb::address_t address = item.data(Qt::UserRole).toULongLong();
+		const QString format         = edb::v1::get_breakpoint_log_format(address);
+		const QString text           = QInputDialog::getText(this, tr("Set Breakpoint Log Message"), tr("Message, with %{expr}, %d{expr}, %u{expr}, %x{expr} or %s{expr} for values (empty to stop as usual):"), QLineEdit::Normal, format, &ok);
+		if(ok) {
+			if(!text.isEmpty()) {
+				State state;
+				edb::v1::debugger_core->get_state(&state);
+
+				LogFormat compiled;
+				if(!compiled.compile(text, state)) {
+					QMessageBox::information(this, tr("Error In Log Message!"), compiled.error().what());
+					return;
+				}
+			}
+
+			edb::v1::set_breakpoint_log_format(address, text);
+			model_->refresh(true);
 		}
 	}
 }
@@ -179,46 +410,58 @@ void DialogBreakpoints::on_btnAddFunction_clicked() {
 // Desc:
 //------------------------------------------------------------------------------
 void DialogBreakpoints::on_btnRemove_clicked() {
-	QList<QTableWidgetItem *> sel = ui->tableWidget->selectedItems();
-	if(!sel.empty()) {
-		QTableWidgetItem *const item = sel[0];
-		const edb::address_t address = item->data(Qt::UserRole).toULongLong();
-		edb::v1::remove_breakpoint(address);
+	const QModelIndex item = selected_index();
+	if(item.isValid()) {
+		const QVariant location = item.data(Qt::UserRole + 1);
+		if(location.isValid()) {
+			edb::v1::remove_pending_breakpoint(location.toString());
+		} else {
+			const edb::address_t address = item.data(Qt::UserRole).toULongLong();
+			edb::v1::remove_breakpoint(address);
+		}
 	}
 	updateList();
 }
 
 //------------------------------------------------------------------------------
-// Name: on_tableWidget_cellDoubleClicked
+// Name: on_tableView_doubleClicked
 // Desc:
 //------------------------------------------------------------------------------
-void DialogBreakpoints::on_tableWidget_cellDoubleClicked(int row, int col) {
-	switch(col) {
-	case 0: // address
-		if(QTableWidgetItem *const address_item = ui->tableWidget->item(row, 0)) {
-			const edb::address_t address = address_item->data(Qt::UserRole).toULongLong();
-			edb::v1::jump_to_address(address);
-		}
+void DialogBreakpoints::on_tableView_doubleClicked(const QModelIndex &index) {
+
+	const QVariant data = index.data(Qt::UserRole);
+	if(!data.isValid()) {
+		return;
+	}
+
+	const edb::address_t address = data.toULongLong();
+
+	switch(index.column()) {
+	case BreakpointModel::ADDRESS_COLUMN:
+		edb::v1::jump_to_address(address);
 		break;
-	case 1: // condition
-		if(QTableWidgetItem *const address_item = ui->tableWidget->item(row, 0)) {
+	case BreakpointModel::CONDITION_COLUMN:
+		{
 			bool ok;
-			const edb::address_t address = address_item->data(Qt::UserRole).toULongLong();
-			const QString condition      = edb::v1::get_breakpoint_condition(address);
-			const QString text           = QInputDialog::getText(this, tr("Set Breakpoint Condition"), tr("Expression:"), QLineEdit::Normal, condition, &ok);
+			const QString condition = edb::v1::get_breakpoint_condition(address);
+			const QString text      = QInputDialog::getText(this, tr("Set Breakpoint Condition"), tr("Expression:"), QLineEdit::Normal, condition, &ok);
 			if(ok) {
 				edb::v1::set_breakpoint_condition(address, text);
-				updateList();
+				model_->refresh(true);
 			}
 		}
 		break;
+	case BreakpointModel::LOG_COLUMN:
+		on_btnLog_clicked();
+		break;
 	}
 }
 
 //------------------------------------------------------------------------------
 // Name: on_btnImport_clicked()
-// Desc: Opens a file selection window to choose a file with newline-separated,
-//          hex address breakpoints.
+// Desc: Opens a file selection window to choose a file of breakpoints. That is
+//          either newline-separated hex addresses, or the binary format which
+//          the export writes, with module relative addresses and conditions.
 //------------------------------------------------------------------------------
 void DialogBreakpoints::on_btnImport_clicked() {
 
@@ -238,53 +481,72 @@ void DialogBreakpoints::on_btnImport_clicked() {
 		return;
 	}
 
-	//Keep a list of any lines in the file that don't make valid breakpoints.
+	//Keep a list of any entries in the file that don't make valid breakpoints.
 	QStringList errors;
 
-	//Iterate through each line; attempt to make a breakpoint for each line.
-	//Addreses should be prefixed with 0x, i.e. a hex number.
-	//Count each breakpoint successfully made.
-	int count = 0;
-	while (!file.atEnd()) {
+	//The module bases are only worked out once, not for every entry.
+	edb::v1::memory_regions().sync();
+	const QHash<QString, edb::address_t> bases = module_bases();
 
-		//Get the address
-		QString line = file.readLine();
-		bool ok;
-		int base = 16;
-		edb::address_t address = line.toULong(&ok, base);
-
-		//Skip if there's an issue.
-		if (!ok) {
-			errors.append(line);
-			continue;
+	QList<Entry> entries;
+	if (is_binary_file(&file)) {
+		if (!read_binary(&file, bases, &entries, &errors)) {
+			QMessageBox::information(this, "Error Reading File", "The breakpoint file is damaged or is from a newer version of edb:" + file_name);
+			return;
 		}
+	} else {
+		read_text(&file, &entries, &errors);
+	}
 
-		//If there's an issue with the line or address isn't in any region,
-		//add to error list and skip.
-		edb::v1::memory_regions().sync();
-		IRegion::pointer p = edb::v1::memory_regions().find_region(address);
-		if (!p) {;
-			errors.append(line);
+	file.close();
+
+	//Collect an address for each entry, skipping ones that can't be set.
+	QList<edb::address_t> addresses;
+	QList<Entry> placed;
+	QSet<edb::address_t> seen;
+	Q_FOREACH (const Entry &entry, entries) {
+
+		//If the address isn't in any region, add to error list and skip.
+		if (!edb::v1::memory_regions().find_region(entry.address)) {
+			errors.append(entry.text);
 			continue;
 		}
 
 		//If the bp already exists, skip.  No error.
-		if (edb::v1::debugger_core->find_breakpoint(address)) {
+		if (edb::v1::debugger_core->find_breakpoint(entry.address)) {
+			continue; }
+
+		//Same for an address that's already in the file.
+		if (seen.contains(entry.address)) {
 			continue; }
 
-		//If the line was converted to an address, try to create the breakpoint.
-		//Access debugger_core directly to avoid many possible error windows by edb::v1::create_breakpoint()
-		const IBreakpoint::pointer bp = edb::v1::debugger_core->add_breakpoint(address);
-		if (bp) {
+		seen.insert(entry.address);
+		addresses.append(entry.address);
+		placed.append(entry);
+	}
+
+	//Create all of the breakpoints in one go, they get written a page at a time.
+	//Access debugger_core directly to avoid many possible error windows by edb::v1::create_breakpoint()
+	//Count each breakpoint successfully made.
+	const QList<IBreakpoint::pointer> breakpoints = edb::v1::debugger_core->add_breakpoints(addresses);
+	int count = 0;
+	for (int i = 0; i < breakpoints.size(); ++i) {
+		if (breakpoints[i]) {
+			breakpoints[i]->condition = placed[i].condition;
 			count++;
-		} else{
-			errors.append(line);
+		} else {
+			errors.append(placed[i].text);
 		}
 	}
 
-	//Report any errors to the user
+	//Report any errors to the user, there may be a great many of them
 	if (errors.size() > 0) {
-		QString msg = "The following breakpoints were not made:\n" + errors.join("");
+		QStringList shown = errors.mid(0, MaxErrorsShown);
+		if (errors.size() > MaxErrorsShown) {
+			shown.append(QString("...and %1 more").arg(errors.size() - MaxErrorsShown));
+		}
+
+		QString msg = "The following breakpoints were not made:\n" + shown.join("\n");
 		QMessageBox::information(this, "Invalid Breakpoints", msg);
 	}
 
@@ -295,27 +557,26 @@ void DialogBreakpoints::on_btnImport_clicked() {
 
 	QMessageBox::information(this, "Breakpoint Import", msg);
 
-	file.close();
 	updateList();
 }
 
 //------------------------------------------------------------------------------
 // Name: on_btnExport_clicked()
-// Desc: Opens a file selection window to choose a file to save newline-separated,
-//          hex address breakpoints.
+// Desc: Opens a file selection window to choose a file to save the breakpoints
+//          to, as newline-separated hex addresses or in the binary format.
 //------------------------------------------------------------------------------
 void DialogBreakpoints::on_btnExport_clicked() {
 
 	//Get the current list of breakpoints
 	const IDebugger::BreakpointList breakpoint_state = edb::v1::debugger_core->backup_breakpoints();
 
-	//Create a list for addresses to be exported at the end
-	QList<edb::address_t> export_list;
+	//Create a list for breakpoints to be exported at the end
+	QList<IBreakpoint::pointer> export_list;
 
 	//Go through our breakpoints and add for export if not one-time and not internal.
 	Q_FOREACH (const IBreakpoint::pointer bp, breakpoint_state) {
 		if (!bp->one_time() && !bp->internal()) {
-			export_list.append(bp->address()); }
+			export_list.append(bp); }
 	}
 
 	//If there are no breakpoints, fail
@@ -324,8 +585,10 @@ void DialogBreakpoints::on_btnExport_clicked() {
 		return;
 	}
 
-	//Now ask the user for a file, open it, and write each address to it.
-	QString filename = QFileDialog::getSaveFileName(this, "Breakpoint Export File", QDir::homePath());
+	//Now ask the user for a file, open it, and write the breakpoints to it.
+	const QString binary_filter = "edb breakpoints (*.edbbp)";
+	QString selected_filter;
+	QString filename = QFileDialog::getSaveFileName(this, "Breakpoint Export File", QDir::homePath(), binary_filter + ";;Text files (*)", &selected_filter);
 
 	if (filename.isEmpty()) {
 		return; }
@@ -335,10 +598,15 @@ void DialogBreakpoints::on_btnExport_clicked() {
 	if (!file.open(QIODevice::WriteOnly)) {
 		return; }
 
-	Q_FOREACH (edb::address_t address, export_list) {
-		int base = 16;
-		QString string_address = "0x" + QString().number(address, base) + "\n";
-		file.write(string_address.toAscii());
+	if (selected_filter == binary_filter || filename.endsWith(".edbbp")) {
+		edb::v1::memory_regions().sync();
+		write_binary(&file, module_bases(), export_list);
+	} else {
+		Q_FOREACH (const IBreakpoint::pointer &bp, export_list) {
+			int base = 16;
+			QString string_address = "0x" + QString().number(bp->address(), base) + "\n";
+			file.write(string_address.toAscii());
+		}
 	}
 
 	file.close();
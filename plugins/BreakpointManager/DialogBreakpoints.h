@@ -19,12 +19,24 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #ifndef DIALOGBREAKPOINTS_20061101_H_
 #define DIALOGBREAKPOINTS_20061101_H_
 
+#include "IBreakpoint.h"
+#include "Types.h"
 #include <QDialog>
+#include <QHash>
+#include <QList>
+#include <QString>
+
+class QIODevice;
+class QModelIndex;
+class QStringList;
+class QTimer;
 
 namespace BreakpointManager {
 
 namespace Ui { class DialogBreakpoints; }
 
+class BreakpointModel;
+
 class DialogBreakpoints : public QDialog {
 	Q_OBJECT
 
@@ -34,19 +46,39 @@ public:
 
 public Q_SLOTS:
 	void updateList();
+	void updateHits();
 	void on_btnAdd_clicked();
 	void on_btnRemove_clicked();
 	void on_btnCondition_clicked();
-	void on_tableWidget_cellDoubleClicked(int row, int col);
+	void on_btnLog_clicked();
+	void on_tableView_doubleClicked(const QModelIndex &index);
     void on_btnImport_clicked();
     void on_btnExport_clicked();
 
+private:
+	// a breakpoint read from a file, <text> is how errors name it
+	struct Entry {
+		edb::address_t address;
+		QString        condition;
+		QString        text;
+	};
+
+private:
+	static void read_text(QIODevice *file, QList<Entry> *entries, QStringList *errors);
+	static bool read_binary(QIODevice *file, const QHash<QString, edb::address_t> &bases, QList<Entry> *entries, QStringList *errors);
+	static void write_binary(QIODevice *file, const QHash<QString, edb::address_t> &bases, const QList<IBreakpoint::pointer> &breakpoints);
+
+private:
+	QModelIndex selected_index() const;
+
 private:
 	virtual void showEvent(QShowEvent *event);
 	virtual void hideEvent(QHideEvent *event);
 
 private:
 	 Ui::DialogBreakpoints *const ui;
+	 BreakpointModel       *const model_;
+	 QTimer                *const hits_timer_;
 };
 
 }
@@ -20,6 +20,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "OptionsPage.h"
 #include "edb.h"
 
+#include <QDateTime>
 #include <QDebug>
 #include <QMenu>
 #include <QMessageBox>
@@ -29,6 +30,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <QNetworkReply>
 #include <QNetworkRequest>
 #include <QSettings>
+#include <QTimer>
 #include <QUrl>
 
 namespace CheckVersion {
@@ -37,7 +39,7 @@ namespace CheckVersion {
 // Name: CheckVersion
 // Desc:
 //------------------------------------------------------------------------------
-CheckVersion::CheckVersion() : menu_(0), network_(0), initial_check_(true) {
+CheckVersion::CheckVersion() : menu_(0), network_(0), timeout_(0), initial_check_(true), timed_out_(false) {
 }
 
 //------------------------------------------------------------------------------
@@ -49,15 +51,39 @@ CheckVersion::~CheckVersion() {
 
 //------------------------------------------------------------------------------
 // Name: private_init
-// Desc:
+// Desc: the check waits for the main window, a zero timer doesn't fire until
+//       the events which show and paint it have been handled
 //------------------------------------------------------------------------------
 void CheckVersion::private_init() {
 	QSettings settings;
 	if(settings.value("CheckVersion/check_on_start.enabled", true).toBool()) {
-		do_check();
+		QTimer::singleShot(0, this, SLOT(startup_check()));
 	}
 }
 
+//------------------------------------------------------------------------------
+// Name: startup_check
+// Desc: only asks the server if the last answer is older than the interval,
+//       otherwise the answer is taken from the settings
+//------------------------------------------------------------------------------
+void CheckVersion::startup_check() {
+
+	QSettings settings;
+	const QDateTime last_check = settings.value("CheckVersion/last_check").toDateTime();
+	const int       hours      = settings.value("CheckVersion/check_interval.hours", 24).toInt();
+
+	if(hours > 0 && last_check.isValid() && qAbs(last_check.secsTo(QDateTime::currentDateTime())) < hours * 3600) {
+		const QString latest = settings.value("CheckVersion/latest_version").toString();
+		if(!latest.isEmpty()) {
+			show_result(latest);
+			initial_check_ = false;
+			return;
+		}
+	}
+
+	do_check();
+}
+
 //------------------------------------------------------------------------------
 // Name: options_page
 // Desc:
@@ -88,19 +114,43 @@ QMenu *CheckVersion::menu(QWidget *parent) {
 //------------------------------------------------------------------------------
 void CheckVersion::do_check() {
 
+	// one is already on the way, its answer will do
+	if(reply_) {
+		return;
+	}
+
 	if(!network_) {
 		network_ = new QNetworkAccessManager(this);
 		connect(network_, SIGNAL(finished(QNetworkReply*)), this, SLOT(requestFinished(QNetworkReply*)));
-	}
 
-	//network_->abort(); //?
+		// QNetworkAccessManager doesn't give up by itself, DNS alone can take
+		// minutes on hosts with no network
+		timeout_ = new QTimer(this);
+		timeout_->setSingleShot(true);
+		connect(timeout_, SIGNAL(timeout()), this, SLOT(request_timed_out()));
+	}
 
 	const QUrl update_url("http://codef00.com/projects/debugger-latest");
 	const QNetworkRequest request(update_url);
 
 	set_proxy(update_url);
 
-	network_->get(request);
+	QSettings settings;
+	timed_out_ = false;
+	timeout_->start(qMax(1, settings.value("CheckVersion/timeout.seconds", 10).toInt()) * 1000);
+
+	reply_ = network_->get(request);
+}
+
+//------------------------------------------------------------------------------
+// Name: request_timed_out
+// Desc: aborting finishes the request, with an error
+//------------------------------------------------------------------------------
+void CheckVersion::request_timed_out() {
+	if(reply_) {
+		timed_out_ = true;
+		reply_->abort();
+	}
 }
 
 //------------------------------------------------------------------------------
@@ -151,35 +201,52 @@ void CheckVersion::show_menu() {
 // Desc:
 //------------------------------------------------------------------------------
 void CheckVersion::requestFinished(QNetworkReply *reply) {
-	
+
+	timeout_->stop();
+	reply->deleteLater();
+	reply_ = 0;
+
 	if(QNetworkReply::NoError != reply->error()) {
 		if(!initial_check_) {
 			QMessageBox::information(
 				0,
 				tr("An Error Occured"),
-				reply->errorString());
+				timed_out_ ? tr("The server didn't answer in time.") : reply->errorString());
 		}
 	} else {
 		const QByteArray result = reply->readAll();
 		const QString s = result;
 
-		qDebug("comparing versions: [%d] [%d]", edb::v1::int_version(s), edb::v1::edb_version());
+		QSettings settings;
+		settings.setValue("CheckVersion/last_check", QDateTime::currentDateTime());
+		settings.setValue("CheckVersion/latest_version", s);
+
+		show_result(s);
+	}
+	initial_check_ = false;
+}
+
+//------------------------------------------------------------------------------
+// Name: show_result
+// Desc: the check at startup only says something if there is a newer version
+//------------------------------------------------------------------------------
+void CheckVersion::show_result(const QString &latest) {
 
-		if(edb::v1::int_version(s) > edb::v1::edb_version()) {
+	qDebug("comparing versions: [%d] [%d]", edb::v1::int_version(latest), edb::v1::edb_version());
+
+	if(edb::v1::int_version(latest) > edb::v1::edb_version()) {
+		QMessageBox::information(
+			0,
+			tr("New Version Available"),
+			tr("There is a newer version of edb available: <strong>%1</strong>").arg(latest));
+	} else {
+		if(!initial_check_) {
 			QMessageBox::information(
 				0,
-				tr("New Version Available"),
-				tr("There is a newer version of edb available: <strong>%1</strong>").arg(s));
-		} else {
-			if(!initial_check_) {
-				QMessageBox::information(
-					0,
-					tr("You are up to date"),
-					tr("You are running the latest version of edb"));
-			}
+				tr("You are up to date"),
+				tr("You are running the latest version of edb"));
 		}
 	}
-	initial_check_ = false;
 }
 
 #if QT_VERSION < 0x050000
@@ -20,8 +20,10 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #define CHECKVERSION_20061122_H_
 
 #include "IPlugin.h"
+#include <QPointer>
 
 class QMenu;
+class QTimer;
 class QNetworkReply;
 class QNetworkAccessManager;
 class QUrl;
@@ -49,17 +51,25 @@ public Q_SLOTS:
 	void show_menu();
 	void requestFinished(QNetworkReply *reply);
 
+private Q_SLOTS:
+	void startup_check();
+	void request_timed_out();
+
 protected:
 	virtual void private_init();
 
 private:
 	void do_check();
 	void set_proxy(const QUrl &url);
+	void show_result(const QString &latest);
 
 private:
-	QMenu                 *menu_;
-	QNetworkAccessManager *network_;
-	bool                   initial_check_;
+	QMenu                  *menu_;
+	QNetworkAccessManager  *network_;
+	QTimer                 *timeout_;
+	QPointer<QNetworkReply> reply_;
+	bool                    initial_check_;
+	bool                    timed_out_;
 };
 
 }
@@ -48,6 +48,8 @@ void OptionsPage::showEvent(QShowEvent *event) {
 
 	QSettings settings;
 	ui->checkBox->setChecked(settings.value("CheckVersion/check_on_start.enabled", true).toBool());
+	ui->spnInterval->setValue(settings.value("CheckVersion/check_interval.hours", 24).toInt());
+	ui->spnTimeout->setValue(settings.value("CheckVersion/timeout.seconds", 10).toInt());
 }
 
 //------------------------------------------------------------------------------
@@ -61,4 +63,22 @@ void OptionsPage::on_checkBox_toggled(bool checked) {
 	settings.setValue("CheckVersion/check_on_start.enabled", ui->checkBox->isChecked());
 }
 
+//------------------------------------------------------------------------------
+// Name: on_spnInterval_valueChanged
+// Desc:
+//------------------------------------------------------------------------------
+void OptionsPage::on_spnInterval_valueChanged(int value) {
+	QSettings settings;
+	settings.setValue("CheckVersion/check_interval.hours", value);
+}
+
+//------------------------------------------------------------------------------
+// Name: on_spnTimeout_valueChanged
+// Desc:
+//------------------------------------------------------------------------------
+void OptionsPage::on_spnTimeout_valueChanged(int value) {
+	QSettings settings;
+	settings.setValue("CheckVersion/timeout.seconds", value);
+}
+
 }
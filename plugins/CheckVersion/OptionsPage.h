@@ -37,6 +37,8 @@ public:
 
 public Q_SLOTS:
 	void on_checkBox_toggled(bool checked);
+	void on_spnInterval_valueChanged(int value);
+	void on_spnTimeout_valueChanged(int value);
 
 private:
 	Ui::OptionsPage *const ui;
@@ -0,0 +1,207 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "CounterWidget.h"
+#include "IDebugger.h"
+#include "edb.h"
+#include <QMessageBox>
+#include <QTableWidgetItem>
+#include <cstring>
+
+#include "ui_CounterWidget.h"
+
+namespace Counters {
+
+namespace {
+
+const char *const counter_names[PerformanceCounters::COUNTER_COUNT] = {
+	QT_TRANSLATE_NOOP("Counters::CounterWidget", "Instructions"),
+	QT_TRANSLATE_NOOP("Counters::CounterWidget", "Cycles"),
+	QT_TRANSLATE_NOOP("Counters::CounterWidget", "Cache Misses"),
+	QT_TRANSLATE_NOOP("Counters::CounterWidget", "Branch Misses")
+};
+
+enum {
+	COLUMN_NAME,
+	COLUMN_LAST,
+	COLUMN_TOTAL,
+	COLUMN_AVERAGE,
+	COLUMN_COUNT
+};
+
+}
+
+//------------------------------------------------------------------------------
+// Name: CounterWidget
+// Desc:
+//------------------------------------------------------------------------------
+CounterWidget::CounterWidget(QWidget *parent, Qt::WindowFlags f) : QWidget(parent, f), ui(new Ui::CounterWidget), stops_(0), running_(false) {
+	ui->setupUi(this);
+
+	std::memset(&previous_, 0, sizeof(previous_));
+	std::memset(last_, 0, sizeof(last_));
+	std::memset(total_, 0, sizeof(total_));
+
+	ui->tableWidget->setRowCount(PerformanceCounters::COUNTER_COUNT);
+	for(int i = 0; i < PerformanceCounters::COUNTER_COUNT; ++i) {
+		ui->tableWidget->setItem(i, COLUMN_NAME, new QTableWidgetItem(tr(counter_names[i])));
+		for(int column = COLUMN_LAST; column < COLUMN_COUNT; ++column) {
+			QTableWidgetItem *const item = new QTableWidgetItem;
+			item->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
+			ui->tableWidget->setItem(i, column, item);
+		}
+	}
+
+	show_counters();
+}
+
+//------------------------------------------------------------------------------
+// Name: ~CounterWidget
+// Desc:
+//------------------------------------------------------------------------------
+CounterWidget::~CounterWidget() {
+	delete ui;
+}
+
+//------------------------------------------------------------------------------
+// Name: on_btnStart_clicked
+// Desc:
+//------------------------------------------------------------------------------
+void CounterWidget::on_btnStart_clicked() {
+	if(running_) {
+		stop();
+	} else {
+		start();
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: on_btnReset_clicked
+// Desc:
+//------------------------------------------------------------------------------
+void CounterWidget::on_btnReset_clicked() {
+	reset();
+}
+
+//------------------------------------------------------------------------------
+// Name: start
+// Desc: the counters start from wherever the process is now, typically the
+//       breakpoint at the start of the code to be measured
+//------------------------------------------------------------------------------
+void CounterWidget::start() {
+
+	if(!edb::v1::debugger_core || !edb::v1::debugger_core->start_counters()) {
+		QMessageBox::information(this, tr("Performance Counters"), tr("The debugger core is unable to count this process. On Linux, kernel.perf_event_paranoid may need lowering."));
+		return;
+	}
+
+	running_ = true;
+	ui->btnStart->setText(tr("Stop"));
+	reset();
+}
+
+//------------------------------------------------------------------------------
+// Name: stop
+// Desc: what was counted stays on display
+//------------------------------------------------------------------------------
+void CounterWidget::stop() {
+
+	if(edb::v1::debugger_core) {
+		edb::v1::debugger_core->stop_counters();
+	}
+
+	running_ = false;
+	ui->btnStart->setText(tr("Start"));
+	show_counters();
+}
+
+//------------------------------------------------------------------------------
+// Name: reset
+// Desc:
+//------------------------------------------------------------------------------
+void CounterWidget::reset() {
+
+	std::memset(last_, 0, sizeof(last_));
+	std::memset(total_, 0, sizeof(total_));
+	stops_ = 0;
+
+	if(!running_ || !edb::v1::debugger_core->read_counters(&previous_)) {
+		std::memset(&previous_, 0, sizeof(previous_));
+	}
+
+	show_counters();
+}
+
+//------------------------------------------------------------------------------
+// Name: refresh
+// Desc: called whenever the views are brought up to date, which also happens
+//       without the process having run. The counters only count the process,
+//       so if no instruction was counted it didn't run
+//------------------------------------------------------------------------------
+void CounterWidget::refresh() {
+
+	if(!running_) {
+		return;
+	}
+
+	PerformanceCounters now;
+	if(!edb::v1::debugger_core->read_counters(&now)) {
+		// the process went away, and the counters with it
+		stop();
+		return;
+	}
+
+	if(now.values[PerformanceCounters::INSTRUCTIONS] == previous_.values[PerformanceCounters::INSTRUCTIONS]) {
+		return;
+	}
+
+	for(int i = 0; i < PerformanceCounters::COUNTER_COUNT; ++i) {
+		last_[i]   = now.values[i] - previous_.values[i];
+		total_[i] += last_[i];
+	}
+
+	previous_ = now;
+	++stops_;
+	show_counters();
+}
+
+//------------------------------------------------------------------------------
+// Name: show_counters
+// Desc:
+//------------------------------------------------------------------------------
+void CounterWidget::show_counters() {
+
+	for(int i = 0; i < PerformanceCounters::COUNTER_COUNT; ++i) {
+		const bool available = previous_.available & (1u << i);
+
+		if(available && stops_ != 0) {
+			ui->tableWidget->item(i, COLUMN_LAST)->setText(QString::number(last_[i]));
+			ui->tableWidget->item(i, COLUMN_TOTAL)->setText(QString::number(total_[i]));
+			ui->tableWidget->item(i, COLUMN_AVERAGE)->setText(QString::number(total_[i] / stops_));
+		} else {
+			const QString text = (running_ && !available) ? tr("n/a") : QString();
+			ui->tableWidget->item(i, COLUMN_LAST)->setText(text);
+			ui->tableWidget->item(i, COLUMN_TOTAL)->setText(text);
+			ui->tableWidget->item(i, COLUMN_AVERAGE)->setText(text);
+		}
+	}
+
+	ui->lblStops->setText(tr("Stops: %1").arg(stops_));
+}
+
+}
@@ -0,0 +1,58 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef COUNTERWIDGET_20261014_H_
+#define COUNTERWIDGET_20261014_H_
+
+#include "PerformanceCounters.h"
+#include <QWidget>
+
+namespace Counters {
+
+namespace Ui { class CounterWidget; }
+
+class CounterWidget : public QWidget {
+	Q_OBJECT
+
+public:
+	CounterWidget(QWidget *parent = 0, Qt::WindowFlags f = 0);
+	virtual ~CounterWidget();
+
+public Q_SLOTS:
+	void on_btnStart_clicked();
+	void on_btnReset_clicked();
+	void refresh();
+
+private:
+	void start();
+	void stop();
+	void reset();
+	void show_counters();
+
+private:
+	Ui::CounterWidget * ui;
+	PerformanceCounters previous_; // what had been counted at the last stop
+	quint64             last_[PerformanceCounters::COUNTER_COUNT];
+	quint64             total_[PerformanceCounters::COUNTER_COUNT];
+	quint64             stops_;
+	bool                running_;
+};
+
+}
+
+#endif
@@ -0,0 +1,70 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Counters.h"
+#include "CounterWidget.h"
+#include "Diagnostics.h"
+#include "edb.h"
+#include <QDockWidget>
+#include <QMainWindow>
+#include <QMenu>
+
+namespace Counters {
+
+//------------------------------------------------------------------------------
+// Name: Counters
+// Desc:
+//------------------------------------------------------------------------------
+Counters::Counters() : QObject(0), menu_(0), counter_widget_(0) {
+}
+
+//------------------------------------------------------------------------------
+// Name: menu
+// Desc:
+//------------------------------------------------------------------------------
+QMenu *Counters::menu(QWidget *parent) {
+
+	Q_ASSERT(parent);
+
+	if(!menu_) {
+
+		if(QMainWindow *const main_window = qobject_cast<QMainWindow *>(edb::v1::debugger_ui)) {
+			counter_widget_ = new CounterWidget;
+
+			// it is named so that its state is saved in the GUI info
+			QDockWidget *const dock_widget = new QDockWidget(tr("Performance Counters"), main_window);
+			dock_widget->setObjectName(QString::fromUtf8("Performance Counters"));
+			dock_widget->setWidget(counter_widget_);
+
+			main_window->addDockWidget(Qt::RightDockWidgetArea, dock_widget);
+
+			menu_ = new QMenu(tr("Performance Counters"), parent);
+			menu_->addAction(dock_widget->toggleViewAction());
+
+			edb::diagnostics::connect_gui_updated(counter_widget_, SLOT(refresh()));
+		}
+	}
+
+	return menu_;
+}
+
+#if QT_VERSION < 0x050000
+Q_EXPORT_PLUGIN2(Counters, Counters)
+#endif
+
+}
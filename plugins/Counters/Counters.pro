@@ -0,0 +1,7 @@
+
+include(../plugins.pri)
+
+# Input
+HEADERS += Counters.h CounterWidget.h
+FORMS += CounterWidget.ui
+SOURCES += Counters.cpp CounterWidget.cpp
@@ -0,0 +1,256 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Coverage.h"
+#include "IAnalyzer.h"
+#include "IDebugger.h"
+#include "State.h"
+#include "edb.h"
+
+#include <QDataStream>
+#include <QFile>
+#include <QFileDialog>
+#include <QMenu>
+#include <QMessageBox>
+#include <QTextStream>
+
+#include <algorithm>
+
+namespace Coverage {
+
+namespace {
+
+const quint64 coverage_bp_tag = Q_UINT64_C(0x434f564552414745); // "COVERAGE" in hex
+
+}
+
+//------------------------------------------------------------------------------
+// Name: Coverage
+// Desc:
+//------------------------------------------------------------------------------
+Coverage::Coverage() : menu_(0), old_event_handler_(0) {
+}
+
+//------------------------------------------------------------------------------
+// Name: ~Coverage
+// Desc:
+//------------------------------------------------------------------------------
+Coverage::~Coverage() {
+	if(old_event_handler_) {
+		edb::v1::set_debug_event_handler(old_event_handler_);
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: menu
+// Desc:
+//------------------------------------------------------------------------------
+QMenu *Coverage::menu(QWidget *parent) {
+
+	Q_ASSERT(parent);
+
+	if(!menu_) {
+		menu_ = new QMenu(tr("Coverage"), parent);
+		menu_->addAction(tr("&Start Coverage"), this, SLOT(start_coverage()));
+		menu_->addAction(tr("S&top Coverage"), this, SLOT(stop_coverage()));
+		menu_->addSeparator();
+		menu_->addAction(tr("&Export drcov File..."), this, SLOT(export_drcov()));
+	}
+
+	return menu_;
+}
+
+//------------------------------------------------------------------------------
+// Name: start_coverage
+// Desc: puts a one time breakpoint on every basic block of the main code
+//       region, each one records a hit and then removes itself
+//------------------------------------------------------------------------------
+void Coverage::start_coverage() {
+
+	IAnalyzer *const analyzer = edb::v1::analyzer();
+	if(!analyzer || !edb::v1::debugger_core->process()) {
+		return;
+	}
+
+	const IRegion::pointer region = edb::v1::primary_code_region();
+	if(!region) {
+		QMessageBox::information(edb::v1::debugger_ui, tr("Coverage"), tr("Could not find the main code region."));
+		return;
+	}
+
+	remove_breakpoints();
+
+	analyzer->analyze(region);
+	const IAnalyzer::BasicBlockMap basic_blocks = analyzer->basic_blocks(region);
+
+	region_ = region;
+	blocks_.clear();
+	block_sizes_.clear();
+
+	for(IAnalyzer::BasicBlockMap::const_iterator it = basic_blocks.begin(); it != basic_blocks.end(); ++it) {
+		if(!it.value().empty()) {
+			blocks_.push_back(it.key());
+		}
+	}
+
+	std::sort(blocks_.begin(), blocks_.end());
+
+	Q_FOREACH(edb::address_t address, blocks_) {
+		block_sizes_.push_back(qMin<BasicBlock::size_type>(basic_blocks[address].byte_size(), 0xffff));
+	}
+
+	hits_.fill(false, blocks_.size());
+
+	// placing them all at once is a lot cheaper than one at a time
+	const QList<IBreakpoint::pointer> breakpoints = edb::v1::debugger_core->add_breakpoints(blocks_.toList());
+	Q_FOREACH(const IBreakpoint::pointer &bp, breakpoints) {
+		if(bp) {
+			bp->set_one_time(true);
+			bp->set_internal(true);
+			bp->tag = coverage_bp_tag;
+		}
+	}
+
+	if(!old_event_handler_) {
+		old_event_handler_ = edb::v1::set_debug_event_handler(this);
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: stop_coverage
+// Desc: removes any blocks which haven't been hit yet, the results are kept
+//       so that they can still be exported
+//------------------------------------------------------------------------------
+void Coverage::stop_coverage() {
+
+	remove_breakpoints();
+
+	if(old_event_handler_) {
+		edb::v1::set_debug_event_handler(old_event_handler_);
+		old_event_handler_ = 0;
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: remove_breakpoints
+// Desc:
+//------------------------------------------------------------------------------
+void Coverage::remove_breakpoints() {
+
+	if(!edb::v1::debugger_core->process()) {
+		return;
+	}
+
+	for(int i = 0; i < blocks_.size(); ++i) {
+		if(!hits_.testBit(i)) {
+			const IBreakpoint::pointer bp = edb::v1::debugger_core->find_breakpoint(blocks_[i]);
+			if(bp && bp->tag == coverage_bp_tag) {
+				edb::v1::debugger_core->remove_breakpoint(blocks_[i]);
+			}
+		}
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: export_drcov
+// Desc: writes the blocks which have been hit so far in the format that
+//       DynamoRIO's drcov tool produces, so existing tools can read it
+//------------------------------------------------------------------------------
+void Coverage::export_drcov() {
+
+	if(!region_) {
+		QMessageBox::information(edb::v1::debugger_ui, tr("Coverage"), tr("No coverage has been collected."));
+		return;
+	}
+
+	const QString filename = QFileDialog::getSaveFileName(edb::v1::debugger_ui, tr("Export Coverage"), QString(), tr("drcov Files (*.log);;All Files (*)"));
+	if(filename.isEmpty()) {
+		return;
+	}
+
+	QFile file(filename);
+	if(!file.open(QIODevice::WriteOnly)) {
+		QMessageBox::information(edb::v1::debugger_ui, tr("Coverage"), tr("Unable to open coverage file: %1").arg(filename));
+		return;
+	}
+
+	const int hit_count = hits_.count(true);
+
+	{
+		QTextStream header(&file);
+		header << "DRCOV VERSION: 2\n";
+		header << "DRCOV FLAVOR: drcov\n";
+		header << "Module Table: version 2, count 1\n";
+		header << "Columns: id, base, end, entry, checksum, timestamp, path\n";
+		header << QString(" 0, 0x%1, 0x%2, 0x%3, 0x00000000, 0x00000000, %4\n")
+			.arg(region_->start(), 16, 16, QChar('0'))
+			.arg(region_->end(), 16, 16, QChar('0'))
+			.arg(0, 16, 16, QChar('0'))
+			.arg(region_->name());
+		header << "BB Table: " << hit_count << " bbs\n";
+	}
+
+	// each entry is { uint32 start; uint16 size; uint16 mod_id; } where start
+	// is an offset from the base of the module
+	QDataStream table(&file);
+	table.setByteOrder(QDataStream::LittleEndian);
+	for(int i = 0; i < blocks_.size(); ++i) {
+		if(hits_.testBit(i)) {
+			table << static_cast<quint32>(blocks_[i] - region_->start()) << block_sizes_[i] << static_cast<quint16>(0);
+		}
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: handle_event
+// Desc: records a hit on one of our blocks, and gets it out of the way
+//       without disturbing the GUI, anything else is passed along
+//------------------------------------------------------------------------------
+edb::EVENT_STATUS Coverage::handle_event(const IDebugEvent::const_pointer &event) {
+
+	if(event->stopped() && event->is_trap()) {
+
+		State state;
+		edb::v1::debugger_core->get_state(&state);
+
+		const edb::address_t address = state.instruction_pointer() - 1;
+		const IBreakpoint::pointer bp = edb::v1::debugger_core->find_breakpoint(address);
+		if(bp && bp->tag == coverage_bp_tag) {
+
+			const QVector<edb::address_t>::const_iterator it = std::lower_bound(blocks_.begin(), blocks_.end(), address);
+			if(it != blocks_.end() && *it == address) {
+				hits_.setBit(it - blocks_.begin());
+			}
+
+			// run the real instruction this time, and every time after
+			state.set_instruction_pointer(address);
+			edb::v1::debugger_core->set_state(state);
+			edb::v1::debugger_core->remove_breakpoint(address);
+			return edb::DEBUG_CONTINUE;
+		}
+	}
+
+	// pass the event down the stack
+	return old_event_handler_->handle_event(event);
+}
+
+#if QT_VERSION < 0x050000
+Q_EXPORT_PLUGIN2(Coverage, Coverage)
+#endif
+
+}
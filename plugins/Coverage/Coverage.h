@@ -0,0 +1,73 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef COVERAGE_20261014_H_
+#define COVERAGE_20261014_H_
+
+#include "IPlugin.h"
+#include "IDebugEventHandler.h"
+#include "IRegion.h"
+#include "Types.h"
+
+#include <QBitArray>
+#include <QVector>
+
+class QMenu;
+
+namespace Coverage {
+
+class Coverage : public QObject, public IPlugin, public IDebugEventHandler {
+	Q_OBJECT
+	Q_INTERFACES(IPlugin)
+#if QT_VERSION >= 0x050000
+	Q_PLUGIN_METADATA(IID "edb.IPlugin/1.0")
+#endif
+	Q_CLASSINFO("author", "Evan Teran")
+	Q_CLASSINFO("url", "http://www.codef00.com")
+
+public:
+	Coverage();
+	virtual ~Coverage();
+
+public:
+	virtual QMenu *menu(QWidget *parent = 0);
+	virtual edb::EVENT_STATUS handle_event(const IDebugEvent::const_pointer &event);
+
+public Q_SLOTS:
+	void start_coverage();
+	void stop_coverage();
+	void export_drcov();
+
+private:
+	void remove_breakpoints();
+
+private:
+	QMenu                   *menu_;
+	IDebugEventHandler      *old_event_handler_;
+
+	// the blocks being covered, sorted by address so that a hit can be turned
+	// into a bit in hits_ with a binary search
+	IRegion::pointer         region_;
+	QVector<edb::address_t>  blocks_;
+	QVector<quint16>         block_sizes_;
+	QBitArray                hits_;
+};
+
+}
+
+#endif
@@ -0,0 +1,6 @@
+
+include(../plugins.pri)
+
+# Input
+HEADERS += Coverage.h
+SOURCES += Coverage.cpp
@@ -22,9 +22,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 namespace DebuggerCore {
 
-namespace {
-const quint8 BreakpointInstruction = 0xcc;
-}
+const quint8 Breakpoint::BreakpointInstruction;
 
 //------------------------------------------------------------------------------
 // Name: Breakpoint
@@ -34,6 +32,14 @@ Breakpoint::Breakpoint(edb::address_t address) : address_(address), hit_count_(0
 	enable();
 }
 
+//------------------------------------------------------------------------------
+// Name: Breakpoint
+// Desc: constructor for a breakpoint whose instruction the caller has already
+//       written to the process, <original_byte> is what it replaced
+//------------------------------------------------------------------------------
+Breakpoint::Breakpoint(edb::address_t address, quint8 original_byte) : original_byte_(original_byte), address_(address), hit_count_(0), enabled_(true), one_time_(false), internal_(false) {
+}
+
 //------------------------------------------------------------------------------
 // Name: ~Breakpoint
 // Desc:
@@ -78,6 +84,23 @@ bool Breakpoint::disable() {
 	return false;
 }
 
+//------------------------------------------------------------------------------
+// Name: reinsert
+// Desc: the process wrote <byte> over the breakpoint, that is now the byte it
+//       hides and the breakpoint instruction goes back in front of it
+//------------------------------------------------------------------------------
+bool Breakpoint::reinsert(quint8 byte) {
+	if(enabled()) {
+		if(IProcess *process = edb::v1::debugger_core->process()) {
+			if(process->write_bytes(address(), &BreakpointInstruction, 1)) {
+				original_byte_ = byte;
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
 //------------------------------------------------------------------------------
 // Name: hit
 // Desc:
@@ -26,8 +26,12 @@ namespace DebuggerCore {
 class Breakpoint : public IBreakpoint {
 public:
 	Breakpoint(edb::address_t address);
+	Breakpoint(edb::address_t address, quint8 original_byte);
 	virtual ~Breakpoint();
 
+public:
+	static const quint8 BreakpointInstruction = 0xcc;
+
 public:
 	virtual edb::address_t address() const { return address_; }
 	virtual quint64 hit_count() const      { return hit_count_; }
@@ -43,6 +47,9 @@ public:
 	virtual void set_one_time(bool value);
 	virtual void set_internal(bool value);
 
+public:
+	bool reinsert(quint8 byte);
+
 private:
 	quint8         original_byte_;
 	edb::address_t address_;
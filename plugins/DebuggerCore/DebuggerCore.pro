@@ -1,38 +1,41 @@
-
-include(../plugins.pri)
-
-unix {
-	VPATH       += unix
-	INCLUDEPATH += unix
-	
-	SOURCES += DebuggerCoreUNIX.cpp
-	HEADERS += DebuggerCoreUNIX.h
-
-	linux-* {
-		VPATH       += unix/linux
-		INCLUDEPATH += unix/linux
-	}
-
-	openbsd-* {
-		VPATH       += unix/openbsd
-		INCLUDEPATH += unix/openbsd
-	}
-
-	freebsd-*{
-		VPATH       += unix/freebsd
-		INCLUDEPATH += unix/freebsd
-	}
-
-	macx {
-		VPATH       += unix/osx
-		INCLUDEPATH += unix/osx
-	}
-}
-
-win32 {
-	VPATH       += win32 .
-	INCLUDEPATH += win32 .
-}
-
-HEADERS += PlatformProcess.h   PlatformEvent.h   PlatformState.h   PlatformRegion.h   DebuggerCoreBase.h   DebuggerCore.h   Breakpoint.h
-SOURCES += PlatformProcess.cpp PlatformEvent.cpp PlatformState.cpp PlatformRegion.cpp DebuggerCoreBase.cpp DebuggerCore.cpp Breakpoint.cpp
+
+include(../plugins.pri)
+
+unix {
+	VPATH       += unix
+	INCLUDEPATH += unix
+	
+	SOURCES += DebuggerCoreUNIX.cpp
+	HEADERS += DebuggerCoreUNIX.h
+
+	linux-* {
+		VPATH       += unix/linux
+		INCLUDEPATH += unix/linux
+
+		HEADERS += BranchTracer.h BreakpointGuard.h CounterSet.h PerfEvent.h ProfileSampler.h SyscallTracer.h
+		SOURCES += BranchTracer.cpp BreakpointGuard.cpp CounterSet.cpp ProfileSampler.cpp SyscallTracer.cpp
+	}
+
+	openbsd-* {
+		VPATH       += unix/openbsd
+		INCLUDEPATH += unix/openbsd
+	}
+
+	freebsd-*{
+		VPATH       += unix/freebsd
+		INCLUDEPATH += unix/freebsd
+	}
+
+	macx {
+		VPATH       += unix/osx
+		INCLUDEPATH += unix/osx
+	}
+}
+
+win32 {
+	VPATH       += win32 .
+	INCLUDEPATH += win32 .
+}
+
+HEADERS += PlatformProcess.h   PlatformEvent.h   PlatformState.h   PlatformRegion.h   DebuggerCoreBase.h   DebuggerCore.h   Breakpoint.h   PageCache.h   ObjectPool.h
+SOURCES += PlatformProcess.cpp PlatformEvent.cpp PlatformState.cpp PlatformRegion.cpp DebuggerCoreBase.cpp DebuggerCore.cpp Breakpoint.cpp PageCache.cpp
@@ -19,8 +19,42 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "DebuggerCoreBase.h"
 #include "Breakpoint.h"
 
+#include <QMap>
+#include <QMutexLocker>
+#include <algorithm>
+
 namespace DebuggerCore {
 
+namespace {
+
+// the granularity of the breakpoint index, this doesn't have to match the
+// real page size, it just has to be a power of two
+const edb::address_t bucket_size = 0x1000;
+
+//------------------------------------------------------------------------------
+// Name: bucket_address
+// Desc: returns the key of the index bucket which holds <address>
+//------------------------------------------------------------------------------
+edb::address_t bucket_address(edb::address_t address) {
+	return address & ~(bucket_size - 1);
+}
+
+//------------------------------------------------------------------------------
+// Name: breakpoint_less
+// Desc: orders breakpoints (and addresses) within a bucket
+//------------------------------------------------------------------------------
+struct breakpoint_less {
+	bool operator()(const IBreakpoint::pointer &bp, edb::address_t address) const {
+		return bp->address() < address;
+	}
+
+	bool operator()(edb::address_t address, const IBreakpoint::pointer &bp) const {
+		return address < bp->address();
+	}
+};
+
+}
+
 //------------------------------------------------------------------------------
 // Name: DebuggerCoreBase
 // Desc: constructor
@@ -41,7 +75,9 @@ DebuggerCoreBase::~DebuggerCoreBase() {
 //------------------------------------------------------------------------------
 void DebuggerCoreBase::clear_breakpoints() {
 	if(attached()) {
+		QMutexLocker locker(&breakpoint_lock_);
 		breakpoints_.clear();
+		breakpoint_index_.clear();
 	}
 }
 
@@ -55,7 +91,12 @@ IBreakpoint::pointer DebuggerCoreBase::add_breakpoint(edb::address_t address) {
 	if(attached()) {
 		if(!find_breakpoint(address)) {
 			IBreakpoint::pointer bp(new Breakpoint(address));
+
+			QMutexLocker locker(&breakpoint_lock_);
 			breakpoints_[address] = bp;
+
+			BreakpointBucket &bucket = breakpoint_index_[bucket_address(address)];
+			bucket.insert(std::lower_bound(bucket.begin(), bucket.end(), address, breakpoint_less()), bp);
 			return bp;
 		}
 	}
@@ -63,15 +104,127 @@ IBreakpoint::pointer DebuggerCoreBase::add_breakpoint(edb::address_t address) {
 	return IBreakpoint::pointer();
 }
 
+//------------------------------------------------------------------------------
+// Name: add_breakpoints
+// Desc: creates a breakpoint at each of <addresses>, the result has an entry
+//       for each address which is null if a breakpoint couldn't be made there
+//       (or there already was one). Rather than a read and a write for each
+//       breakpoint, each page's breakpoints are placed with one of each. When
+//       the process may be running, only the breakpoints' own bytes are
+//       written
+//------------------------------------------------------------------------------
+QList<IBreakpoint::pointer> DebuggerCoreBase::add_breakpoints(const QList<edb::address_t> &addresses) {
+
+	QHash<edb::address_t, IBreakpoint::pointer> created;
+
+	IProcess *const process = this->process();
+	const bool rewrite_spans = can_rewrite_memory();
+
+	if(attached() && process) {
+
+		// group the new addresses by page, sorted so each page is one span
+		QMap<edb::address_t, QVector<edb::address_t> > pages;
+		Q_FOREACH(edb::address_t address, addresses) {
+			if(!find_breakpoint(address)) {
+				pages[address & ~(page_size() - 1)].push_back(address);
+			}
+		}
+
+		QVector<quint8> buffer;
+		for(QMap<edb::address_t, QVector<edb::address_t> >::iterator it = pages.begin(); it != pages.end(); ++it) {
+
+			QVector<edb::address_t> &page_addresses = it.value();
+			std::sort(page_addresses.begin(), page_addresses.end());
+			page_addresses.erase(std::unique(page_addresses.begin(), page_addresses.end()), page_addresses.end());
+
+			const edb::address_t first = page_addresses.front();
+			const std::size_t len      = page_addresses.back() - first + 1;
+
+			// reads have our breakpoints masked out, so the buffer holds the
+			// original bytes
+			buffer.resize(len);
+			if(!process->read_bytes(first, buffer.data(), len)) {
+				continue;
+			}
+
+			QVector<quint8> original(page_addresses.size());
+			for(int i = 0; i < page_addresses.size(); ++i) {
+				original[i] = buffer[page_addresses[i] - first];
+				buffer[page_addresses[i] - first] = Breakpoint::BreakpointInstruction;
+			}
+
+			if(!rewrite_spans) {
+				QVector<bool> written(page_addresses.size());
+				for(int i = 0; i < page_addresses.size(); ++i) {
+					written[i] = process->write_bytes(page_addresses[i], &Breakpoint::BreakpointInstruction, 1);
+				}
+
+				QMutexLocker locker(&breakpoint_lock_);
+				for(int i = 0; i < page_addresses.size(); ++i) {
+					if(written[i]) {
+						const edb::address_t address = page_addresses[i];
+						IBreakpoint::pointer bp(new Breakpoint(address, original[i]));
+						breakpoints_[address] = bp;
+
+						BreakpointBucket &bucket = breakpoint_index_[bucket_address(address)];
+						bucket.insert(std::lower_bound(bucket.begin(), bucket.end(), address, breakpoint_less()), bp);
+						created[address] = bp;
+					}
+				}
+				continue;
+			}
+
+			// put back any existing breakpoints in the span, so writing it
+			// doesn't take them out
+			for(edb::address_t bucket = bucket_address(first); bucket <= bucket_address(first + len - 1); bucket += bucket_size) {
+				const BreakpointIndex::const_iterator bucket_it = breakpoint_index_.find(bucket);
+				if(bucket_it != breakpoint_index_.end()) {
+					Q_FOREACH(const IBreakpoint::pointer &bp, bucket_it.value()) {
+						if(bp->enabled() && bp->address() >= first && bp->address() < first + len) {
+							buffer[bp->address() - first] = Breakpoint::BreakpointInstruction;
+						}
+					}
+				}
+			}
+
+			if(!process->write_bytes(first, buffer.data(), len)) {
+				continue;
+			}
+
+			QMutexLocker locker(&breakpoint_lock_);
+			for(int i = 0; i < page_addresses.size(); ++i) {
+				const edb::address_t address = page_addresses[i];
+				IBreakpoint::pointer bp(new Breakpoint(address, original[i]));
+				breakpoints_[address] = bp;
+
+				BreakpointBucket &bucket = breakpoint_index_[bucket_address(address)];
+				bucket.insert(std::lower_bound(bucket.begin(), bucket.end(), address, breakpoint_less()), bp);
+				created[address] = bp;
+			}
+		}
+	}
+
+	QList<IBreakpoint::pointer> ret;
+	Q_FOREACH(edb::address_t address, addresses) {
+		// only the first of any duplicates gets the breakpoint
+		ret.push_back(created.take(address));
+	}
+	return ret;
+}
+
 //------------------------------------------------------------------------------
 // Name: find_breakpoint
 // Desc: returns the breakpoint at the given address or IBreakpoint::pointer()
 //------------------------------------------------------------------------------
 IBreakpoint::pointer DebuggerCoreBase::find_breakpoint(edb::address_t address) {
 	if(attached()) {
-		const BreakpointList::const_iterator it = breakpoints_.find(address);
-		if(it != breakpoints_.end()) {
-			return it.value();
+		const BreakpointIndex::const_iterator it = breakpoint_index_.find(bucket_address(address));
+		if(it != breakpoint_index_.end()) {
+			const BreakpointBucket &bucket = it.value();
+			const BreakpointBucket::const_iterator bp = std::lower_bound(bucket.begin(), bucket.end(), address, breakpoint_less());
+			if(bp != bucket.end() && (*bp)->address() == address) {
+				return *bp;
+			}
 		}
 	}
 	return IBreakpoint::pointer();
@@ -89,9 +242,69 @@ void DebuggerCoreBase::remove_breakpoint(edb::address_t address) {
 
 	// TODO(eteran): assert paused
 	if(attached()) {
+		QMutexLocker locker(&breakpoint_lock_);
 		const BreakpointList::iterator it = breakpoints_.find(address);
 		if(it != breakpoints_.end()) {
 			breakpoints_.erase(it);
+
+			const BreakpointIndex::iterator bucket_it = breakpoint_index_.find(bucket_address(address));
+			if(bucket_it != breakpoint_index_.end()) {
+				BreakpointBucket &bucket = bucket_it.value();
+				const BreakpointBucket::iterator bp = std::lower_bound(bucket.begin(), bucket.end(), address, breakpoint_less());
+				if(bp != bucket.end() && (*bp)->address() == address) {
+					bucket.erase(bp);
+				}
+
+				if(bucket.isEmpty()) {
+					breakpoint_index_.erase(bucket_it);
+				}
+			}
+		}
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: mask_breakpoints
+// Desc: replaces any breakpoint bytes in <buf> (which holds <len> bytes read
+//       from <address>) with the original bytes they replaced
+//------------------------------------------------------------------------------
+void DebuggerCoreBase::mask_breakpoints(edb::address_t address, void *buf, std::size_t len) const {
+
+	QMutexLocker locker(&breakpoint_lock_);
+
+	if(len == 0 || breakpoint_index_.isEmpty()) {
+		return;
+	}
+
+	quint8 *const ptr                 = reinterpret_cast<quint8 *>(buf);
+	const edb::address_t last_address = address + len - 1;
+
+	// if the read covers more pages than we have buckets, it's cheaper to go
+	// through the buckets instead of through the pages
+	if((last_address - address) / bucket_size >= static_cast<edb::address_t>(breakpoint_index_.size())) {
+		for(BreakpointIndex::const_iterator it = breakpoint_index_.begin(); it != breakpoint_index_.end(); ++it) {
+			Q_FOREACH(const IBreakpoint::pointer &bp, it.value()) {
+				if(bp->address() >= address && bp->address() <= last_address) {
+					ptr[bp->address() - address] = bp->original_byte();
+				}
+			}
+		}
+		return;
+	}
+
+	const edb::address_t last_bucket = bucket_address(last_address);
+	for(edb::address_t page = bucket_address(address);; page += bucket_size) {
+		const BreakpointIndex::const_iterator it = breakpoint_index_.find(page);
+		if(it != breakpoint_index_.end()) {
+			const BreakpointBucket &bucket = it.value();
+			for(BreakpointBucket::const_iterator bp = std::lower_bound(bucket.begin(), bucket.end(), address, breakpoint_less()); bp != bucket.end() && (*bp)->address() <= last_address; ++bp) {
+				// show the original bytes in the buffer..
+				ptr[(*bp)->address() - address] = (*bp)->original_byte();
+			}
+		}
+
+		if(page == last_bucket) {
+			break;
 		}
 	}
 }
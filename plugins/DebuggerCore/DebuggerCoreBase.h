@@ -20,6 +20,9 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #define DEBUGGERCOREBASE_20090529_H_
 
 #include "IDebugger.h"
+#include <QHash>
+#include <QMutex>
+#include <QVector>
 
 namespace DebuggerCore {
 
@@ -41,6 +44,7 @@ public:
 public:
 	virtual BreakpointList backup_breakpoints() const;
 	virtual IBreakpoint::pointer add_breakpoint(edb::address_t address);
+	virtual QList<IBreakpoint::pointer> add_breakpoints(const QList<edb::address_t> &addresses);
 	virtual IBreakpoint::pointer find_breakpoint(edb::address_t address);
 	virtual void clear_breakpoints();
 	virtual void remove_breakpoint(edb::address_t address);
@@ -50,11 +54,29 @@ public:
 
 protected:
 	bool attached() const;
+	void mask_breakpoints(edb::address_t address, void *buf, std::size_t len) const;
+
+	// false while some of the process may be running, writing back a span of
+	// memory read a moment ago could then undo what the process wrote since
+	virtual bool can_rewrite_memory() const { return true; }
+
+private:
+	// breakpoints bucketed by the page that they are on, each bucket is kept
+	// sorted by address, so a read (or lookup) only needs to look at the
+	// breakpoints on the pages it actually touches
+	typedef QVector<IBreakpoint::pointer>          BreakpointBucket;
+	typedef QHash<edb::address_t, BreakpointBucket> BreakpointIndex;
 
 protected:
 	edb::tid_t      active_thread_;
 	edb::pid_t      pid_;
 	BreakpointList  breakpoints_;
+
+private:
+	// only the UI thread changes the index, the lock is so that it can be
+	// read by reads done on the core's own thread
+	BreakpointIndex breakpoint_index_;
+	mutable QMutex  breakpoint_lock_;
 };
 
 }
@@ -0,0 +1,84 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef OBJECTPOOL_20261014_H_
+#define OBJECTPOOL_20261014_H_
+
+#include <QMutex>
+#include <QMutexLocker>
+#include <cstddef>
+#include <new>
+
+namespace DebuggerCore {
+
+// a free list of blocks the size of a T, for the objects the core makes and
+// throws away at every stop (the state and the event). T gives its class
+// operator new and delete to allocate and release, blocks of any other size
+// (a class derived from T) go to the heap as usual. At most MaxFree blocks
+// are kept, and they are never given back until the process exits
+template <class T, int MaxFree = 32>
+class ObjectPool {
+public:
+	ObjectPool() : free_(0), count_(0) {}
+
+public:
+	void *allocate(std::size_t size) {
+		if(size == sizeof(T)) {
+			QMutexLocker locker(&lock_);
+			if(Node *const node = free_) {
+				free_ = node->next;
+				--count_;
+				return node;
+			}
+		}
+		return ::operator new(size);
+	}
+
+	void release(void *p, std::size_t size) {
+		if(p) {
+			if(size == sizeof(T)) {
+				QMutexLocker locker(&lock_);
+				if(count_ < MaxFree) {
+					Node *const node = static_cast<Node *>(p);
+					node->next = free_;
+					free_      = node;
+					++count_;
+					return;
+				}
+			}
+			::operator delete(p);
+		}
+	}
+
+private:
+	Q_DISABLE_COPY(ObjectPool)
+
+private:
+	struct Node {
+		Node *next;
+	};
+
+private:
+	QMutex lock_;
+	Node * free_;
+	int    count_;
+};
+
+}
+
+#endif
@@ -0,0 +1,145 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "PageCache.h"
+#include <cstring>
+
+namespace DebuggerCore {
+
+//------------------------------------------------------------------------------
+// Name: PageCache
+// Desc: constructor
+//------------------------------------------------------------------------------
+PageCache::PageCache(edb::address_t page_size, int max_pages) : pages_(max_pages), page_size_(page_size) {
+	edb::memory::add_consumer("debugger core: page cache", this);
+}
+
+//------------------------------------------------------------------------------
+// Name: ~PageCache
+// Desc: destructor
+//------------------------------------------------------------------------------
+PageCache::~PageCache() {
+	edb::memory::remove_consumer(this);
+}
+
+//------------------------------------------------------------------------------
+// Name: find
+// Desc: returns the cached contents of the page starting at <page> or NULL if
+//       it isn't cached
+//------------------------------------------------------------------------------
+const quint8 *PageCache::find(edb::address_t page) const {
+	Q_ASSERT((page & (page_size_ - 1)) == 0);
+
+	// QCache::object marks the entry as recently used, which is what we want
+	// even through a const interface
+	if(QByteArray *const bytes = const_cast<QCache<edb::address_t, QByteArray> &>(pages_).object(page)) {
+		return reinterpret_cast<const quint8 *>(bytes->constData());
+	}
+
+	return 0;
+}
+
+//------------------------------------------------------------------------------
+// Name: insert
+// Desc: stores a copy of a whole page, evicting the least recently used page
+//       if the cache is full
+//------------------------------------------------------------------------------
+void PageCache::insert(edb::address_t page, const void *data) {
+	Q_ASSERT((page & (page_size_ - 1)) == 0);
+	Q_ASSERT(data);
+
+	if(max_pages() != 0) {
+		pages_.insert(page, new QByteArray(reinterpret_cast<const char *>(data), page_size_));
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: write
+// Desc: updates any cached pages which overlap with a write of <len> bytes
+//       to <address>
+//------------------------------------------------------------------------------
+void PageCache::write(edb::address_t address, const void *buf, std::size_t len) {
+
+	const quint8 *src = reinterpret_cast<const quint8 *>(buf);
+
+	while(len != 0) {
+		const edb::address_t page   = address & ~(page_size_ - 1);
+		const std::size_t offset    = address - page;
+		const std::size_t n         = qMin(static_cast<std::size_t>(page_size_ - offset), len);
+
+		if(QByteArray *const bytes = pages_.object(page)) {
+			std::memcpy(bytes->data() + offset, src, n);
+		}
+
+		address += n;
+		src     += n;
+		len     -= n;
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: invalidate
+// Desc: drops any cached pages which overlap [address, address + len)
+//------------------------------------------------------------------------------
+void PageCache::invalidate(edb::address_t address, std::size_t len) {
+
+	if(len != 0) {
+		const edb::address_t first = address & ~(page_size_ - 1);
+		const edb::address_t last  = (address + len - 1) & ~(page_size_ - 1);
+
+		for(edb::address_t page = first; page <= last; page += page_size_) {
+			pages_.remove(page);
+
+			// guard against wrapping around at the top of the address space
+			if(page == last) {
+				break;
+			}
+		}
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: clear
+// Desc: forgets everything, this must be done any time the process may have
+//       run
+//------------------------------------------------------------------------------
+void PageCache::clear() {
+	pages_.clear();
+}
+
+//------------------------------------------------------------------------------
+// Name: memory_used
+// Desc: every page costs 1
+//------------------------------------------------------------------------------
+quint64 PageCache::memory_used() const {
+	return static_cast<quint64>(pages_.totalCost()) * page_size_;
+}
+
+//------------------------------------------------------------------------------
+// Name: trim
+// Desc: lowering the maximum makes QCache evict the least recently used pages,
+//       after which it can go back to what it was
+//------------------------------------------------------------------------------
+void PageCache::trim(quint64 bytes) {
+	const int max_cost = pages_.maxCost();
+	const int keep     = static_cast<int>(qMin<quint64>(bytes / page_size_, max_cost));
+	pages_.setMaxCost(keep);
+	pages_.setMaxCost(max_cost);
+}
+
+}
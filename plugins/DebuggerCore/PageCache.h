@@ -0,0 +1,63 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef PAGECACHE_20261014_H_
+#define PAGECACHE_20261014_H_
+
+#include "MemoryBudget.h"
+#include "Types.h"
+#include <QByteArray>
+#include <QCache>
+
+namespace DebuggerCore {
+
+// a small LRU cache of whole pages of the inferior's memory. It is only valid
+// while the process is stopped, so the core must clear it whenever the process
+// is allowed to run again. Writes must go through write() so that the cache
+// never disagrees with the process.
+class PageCache : public edb::memory::Consumer {
+public:
+	PageCache(edb::address_t page_size, int max_pages);
+	virtual ~PageCache();
+
+public:
+	const quint8 *find(edb::address_t page) const;
+	void insert(edb::address_t page, const void *data);
+	void write(edb::address_t address, const void *buf, std::size_t len);
+	void invalidate(edb::address_t address, std::size_t len);
+	void clear();
+
+public:
+	edb::address_t page_size() const { return page_size_; }
+	int max_pages() const            { return pages_.maxCost(); }
+
+public:
+	virtual quint64 memory_used() const;
+	virtual void trim(quint64 bytes);
+
+private:
+	Q_DISABLE_COPY(PageCache)
+
+private:
+	QCache<edb::address_t, QByteArray> pages_;
+	edb::address_t                     page_size_;
+};
+
+}
+
+#endif
@@ -167,6 +167,25 @@ pid_t native::waitpid_timeout(pid_t pid, int *status, int options, int msecs, bo
 	return -1;
 }
 
+//------------------------------------------------------------------------------
+// Name: event_fd
+// Desc: the read end of the SIGCHLD self-pipe, it is readable whenever a child
+//       has changed state and we haven't looked at it yet
+//------------------------------------------------------------------------------
+int DebuggerCoreUNIX::event_fd() const {
+	return selfpipe[0];
+}
+
+//------------------------------------------------------------------------------
+// Name: requeue_sigchld
+// Desc: makes the next wait_for_sigchld return immediately
+// Note: SIGCHLDs which arrive together are merged into one, so after handling
+//       an event, cores should call this to make sure they look for another
+//------------------------------------------------------------------------------
+void DebuggerCoreUNIX::requeue_sigchld() {
+	native::write(selfpipe[1], " ", sizeof(char));
+}
+
 //------------------------------------------------------------------------------
 // Name: DebuggerCoreUNIX
 // Desc:
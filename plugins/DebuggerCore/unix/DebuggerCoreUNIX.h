@@ -42,6 +42,10 @@ public:
 
 protected:
 	void execute_process(const QString &path, const QString &cwd, const QList<QByteArray> &args);
+	void requeue_sigchld();
+
+public:
+	virtual int event_fd() const;
 
 public:
 	virtual int pointer_size() const;
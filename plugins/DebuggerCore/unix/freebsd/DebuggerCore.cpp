@@ -167,6 +167,86 @@ bool DebuggerCore::write_data(edb::address_t address, long value) {
 	return ptrace(PT_WRITE_D, pid(), reinterpret_cast<char*>(address), value) != -1;
 }
 
+//------------------------------------------------------------------------------
+// Name: transfer
+// Desc: moves up to <len> bytes between <buf> and <address> in the process,
+//       <op> is PIOD_READ_D or PIOD_WRITE_D. Returns how many bytes were
+//       moved, which stops short at the first page that can't be accessed
+//------------------------------------------------------------------------------
+std::size_t DebuggerCore::transfer(int op, edb::address_t address, void *buf, std::size_t len) {
+
+	std::size_t total = 0;
+	while(total < len) {
+		struct ptrace_io_desc io;
+		io.piod_op   = op;
+		io.piod_offs = reinterpret_cast<void *>(address + total);
+		io.piod_addr = reinterpret_cast<char *>(buf) + total;
+		io.piod_len  = len - total;
+
+		if(ptrace(PT_IO, pid(), reinterpret_cast<caddr_t>(&io), 0) == -1 || io.piod_len == 0) {
+			break;
+		}
+
+		total += io.piod_len;
+	}
+
+	return total;
+}
+
+//------------------------------------------------------------------------------
+// Name: read_bytes
+// Desc: reads <len> bytes into <buf> starting at <address>
+// Note: if the read failed, the part of the buffer that could not be read will
+//       be filled with 0xff bytes
+//------------------------------------------------------------------------------
+bool DebuggerCore::read_bytes(edb::address_t address, void *buf, std::size_t len) {
+
+	Q_ASSERT(buf);
+
+	if(len != 0) {
+		const std::size_t n = transfer(PIOD_READ_D, address, buf, len);
+		if(n != len) {
+			std::memset(reinterpret_cast<quint8 *>(buf) + n, 0xff, len - n);
+		}
+
+		mask_breakpoints(address, buf, n);
+	}
+
+	return true;
+}
+
+//------------------------------------------------------------------------------
+// Name: read_pages
+// Desc: reads <count> pages from the process starting at <address>
+// Note: buf's size must be >= count * page_size()
+// Note: address should be page aligned.
+//------------------------------------------------------------------------------
+bool DebuggerCore::read_pages(edb::address_t address, void *buf, std::size_t count) {
+
+	Q_ASSERT(buf);
+
+	if((address & (page_size() - 1)) == 0) {
+		const std::size_t len = count * page_size();
+		const std::size_t n   = transfer(PIOD_READ_D, address, buf, len);
+
+		mask_breakpoints(address, buf, n);
+		return n == len;
+	}
+
+	return false;
+}
+
+//------------------------------------------------------------------------------
+// Name: write_bytes
+// Desc: writes <len> bytes from <buf> starting at <address>
+//------------------------------------------------------------------------------
+bool DebuggerCore::write_bytes(edb::address_t address, const void *buf, std::size_t len) {
+
+	Q_ASSERT(buf);
+
+	return transfer(PIOD_WRITE_D, address, const_cast<void *>(buf), len) == len;
+}
+
 //------------------------------------------------------------------------------
 // Name: attach
 // Desc:
@@ -274,7 +354,7 @@ void DebuggerCore::get_state(State *state) {
 
 	// TODO: assert that we are paused
 
-	PlatformState *const state_impl = static_cast<PlatformState *>(state->impl_);
+	PlatformState *const state_impl = static_cast<PlatformState *>(state->detach());
 
 	if(attached()) {
 	#if defined(EDB_X86)
@@ -83,6 +83,15 @@ public:
 public:
 	virtual QString format_pointer(edb::address_t address) const;
 
+public:
+	// memory, a whole range at a time with PT_IO rather than a word per call
+	bool read_bytes(edb::address_t address, void *buf, std::size_t len);
+	bool read_pages(edb::address_t address, void *buf, std::size_t count);
+	bool write_bytes(edb::address_t address, const void *buf, std::size_t len);
+
+private:
+	std::size_t transfer(int op, edb::address_t address, void *buf, std::size_t len);
+
 private:
 	virtual long read_data(edb::address_t address, bool *ok);
 	virtual bool write_data(edb::address_t address, long value);
@@ -0,0 +1,201 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "BranchTracer.h"
+#include "PerfEvent.h"
+
+#include <cstring>
+
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace DebuggerCore {
+
+namespace {
+
+// the number of pages in the ring buffer, this must be a power of two. At
+// 24 bytes a branch, this holds about 87,000 branches between stops
+const std::size_t RingPages = 512;
+
+// more than this many branches are counted as lost instead of kept
+const int MaxRecords = 1 << 22;
+
+}
+
+//------------------------------------------------------------------------------
+// Name: BranchTracer
+// Desc: constructor
+//------------------------------------------------------------------------------
+BranchTracer::BranchTracer() : fd_(-1), buffer_(MAP_FAILED), buffer_size_(0), page_size_(0), lost_(0) {
+}
+
+//------------------------------------------------------------------------------
+// Name: ~BranchTracer
+// Desc: destructor
+//------------------------------------------------------------------------------
+BranchTracer::~BranchTracer() {
+	stop();
+}
+
+//------------------------------------------------------------------------------
+// Name: start
+// Desc: starts recording the branches that thread <tid> takes in user space,
+//       returns false if the kernel or CPU can't do it for us
+//------------------------------------------------------------------------------
+bool BranchTracer::start(edb::tid_t tid, edb::address_t page_size) {
+
+	stop();
+
+	struct perf_event_attr attr;
+	std::memset(&attr, 0, sizeof(attr));
+	attr.size           = sizeof(attr);
+	attr.type           = PERF_TYPE_HARDWARE;
+	attr.config         = PERF_COUNT_HW_BRANCH_INSTRUCTIONS;
+	attr.sample_period  = 1;
+	attr.sample_type    = PERF_SAMPLE_IP | PERF_SAMPLE_ADDR;
+	attr.disabled       = 1;
+	attr.exclude_kernel = 1;
+	attr.exclude_hv     = 1;
+
+	fd_ = perf_event_open(&attr, tid, -1, -1, 0);
+	if(fd_ == -1) {
+		return false;
+	}
+
+	// the first page is the control page, the rest is the ring itself
+	page_size_   = page_size;
+	buffer_size_ = (RingPages + 1) * page_size;
+	buffer_      = mmap(0, buffer_size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+	if(buffer_ == MAP_FAILED) {
+		stop();
+		return false;
+	}
+
+	records_.clear();
+	lost_ = 0;
+
+	if(ioctl(fd_, PERF_EVENT_IOC_ENABLE, 0) == -1) {
+		stop();
+		return false;
+	}
+
+	return true;
+}
+
+//------------------------------------------------------------------------------
+// Name: stop
+// Desc: stops recording, anything already collected can still be taken
+//------------------------------------------------------------------------------
+void BranchTracer::stop() {
+
+	if(fd_ != -1) {
+		ioctl(fd_, PERF_EVENT_IOC_DISABLE, 0);
+		collect();
+	}
+
+	if(buffer_ != MAP_FAILED) {
+		munmap(buffer_, buffer_size_);
+		buffer_ = MAP_FAILED;
+	}
+
+	if(fd_ != -1) {
+		close(fd_);
+		fd_ = -1;
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: collect
+// Desc: moves whatever the kernel has recorded out of the ring buffer, this
+//       should be done every time the thread stops
+//------------------------------------------------------------------------------
+void BranchTracer::collect() {
+
+	if(buffer_ == MAP_FAILED) {
+		return;
+	}
+
+	struct perf_event_mmap_page *const control = static_cast<struct perf_event_mmap_page *>(buffer_);
+
+	const quint8 *const data     = static_cast<const quint8 *>(buffer_) + page_size_;
+	const std::size_t   data_len = buffer_size_ - page_size_;
+
+	const quint64 head = control->data_head;
+	__sync_synchronize();
+
+	quint64 tail = control->data_tail;
+	while(tail < head) {
+		struct perf_event_header header;
+		read_ring(data, data_len, tail, &header, sizeof(header));
+		if(header.size == 0) {
+			break;
+		}
+
+		switch(header.type) {
+		case PERF_RECORD_SAMPLE:
+			{
+				// the layout follows sample_type: { u64 ip; u64 addr; }
+				quint64 sample[2];
+				read_ring(data, data_len, tail + sizeof(header), sample, sizeof(sample));
+				if(records_.size() < MaxRecords) {
+					const BranchRecord record = { static_cast<edb::address_t>(sample[0]), static_cast<edb::address_t>(sample[1]) };
+					records_.push_back(record);
+				} else {
+					++lost_;
+				}
+			}
+			break;
+		case PERF_RECORD_LOST:
+			{
+				// { u64 id; u64 lost; }
+				quint64 lost[2];
+				read_ring(data, data_len, tail + sizeof(header), lost, sizeof(lost));
+				lost_ += lost[1];
+			}
+			break;
+		default:
+			break;
+		}
+
+		tail += header.size;
+	}
+
+	// let the kernel know that it can reuse the space
+	__sync_synchronize();
+	control->data_tail = head;
+}
+
+//------------------------------------------------------------------------------
+// Name: take
+// Desc: returns the branches collected so far and forgets them
+//------------------------------------------------------------------------------
+QVector<BranchRecord> BranchTracer::take(quint64 *lost) {
+
+	QVector<BranchRecord> ret;
+	qSwap(ret, records_);
+
+	if(lost) {
+		*lost = lost_;
+	}
+
+	lost_ = 0;
+	return ret;
+}
+
+}
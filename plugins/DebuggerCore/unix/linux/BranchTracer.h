@@ -0,0 +1,61 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef BRANCHTRACER_20261014_H_
+#define BRANCHTRACER_20261014_H_
+
+#include "BranchRecord.h"
+#include "Types.h"
+#include <QVector>
+
+namespace DebuggerCore {
+
+// records the branches taken by a single thread using perf's branch sampling
+// with a period of 1, which the kernel implements with the CPU's branch trace
+// store (BTS) where there is one. The kernel writes the records into a ring
+// buffer which has to be drained (with collect) before it fills up, anything
+// which doesn't fit is counted as lost.
+class BranchTracer {
+public:
+	BranchTracer();
+	~BranchTracer();
+
+public:
+	bool start(edb::tid_t tid, edb::address_t page_size);
+	void stop();
+	bool running() const { return fd_ != -1; }
+
+public:
+	void collect();
+	QVector<BranchRecord> take(quint64 *lost);
+
+private:
+	Q_DISABLE_COPY(BranchTracer)
+
+private:
+	int                   fd_;
+	void                 *buffer_;
+	std::size_t           buffer_size_;
+	edb::address_t        page_size_;
+	QVector<BranchRecord> records_;
+	quint64               lost_;
+};
+
+}
+
+#endif
@@ -0,0 +1,280 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "BreakpointGuard.h"
+#include "Fingerprint.h"
+
+#include <QVector>
+#include <cstdio>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace DebuggerCore {
+
+namespace {
+
+const quint8  BreakpointInstruction = 0xcc;
+const quint64 SoftDirtyBit          = Q_UINT64_C(1) << 55;
+
+}
+
+//------------------------------------------------------------------------------
+// Name: BreakpointGuard
+// Desc: constructor
+//------------------------------------------------------------------------------
+BreakpointGuard::BreakpointGuard() : page_size_(0), memory_fd_(-1), pagemap_fd_(-1), clear_refs_fd_(-1), running_(false), checked_(true), clear_pending_(false) {
+}
+
+//------------------------------------------------------------------------------
+// Name: ~BreakpointGuard
+// Desc: destructor
+//------------------------------------------------------------------------------
+BreakpointGuard::~BreakpointGuard() {
+	close();
+}
+
+//------------------------------------------------------------------------------
+// Name: open
+// Desc: pages are read through <memory_fd>, which stays the caller's. If the
+//       kernel has soft-dirty bits they are used to skip the pages the process
+//       hasn't written to
+//------------------------------------------------------------------------------
+void BreakpointGuard::open(edb::pid_t pid, int memory_fd, edb::address_t page_size) {
+
+	close();
+
+	memory_fd_ = memory_fd;
+	page_size_ = page_size;
+
+	char path[64];
+	snprintf(path, sizeof(path), "/proc/%d/pagemap", static_cast<int>(pid));
+	pagemap_fd_ = ::open(path, O_RDONLY | O_CLOEXEC);
+
+	snprintf(path, sizeof(path), "/proc/%d/clear_refs", static_cast<int>(pid));
+	clear_refs_fd_ = ::open(path, O_WRONLY | O_CLOEXEC);
+
+	// kernels without soft-dirty bits refuse to clear them
+	if(pagemap_fd_ == -1 || clear_refs_fd_ == -1 || ::write(clear_refs_fd_, "4", 1) != 1) {
+		if(pagemap_fd_ != -1) {
+			::close(pagemap_fd_);
+			pagemap_fd_ = -1;
+		}
+
+		if(clear_refs_fd_ != -1) {
+			::close(clear_refs_fd_);
+			clear_refs_fd_ = -1;
+		}
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: close
+// Desc:
+//------------------------------------------------------------------------------
+void BreakpointGuard::close() {
+
+	if(pagemap_fd_ != -1) {
+		::close(pagemap_fd_);
+		pagemap_fd_ = -1;
+	}
+
+	if(clear_refs_fd_ != -1) {
+		::close(clear_refs_fd_);
+		clear_refs_fd_ = -1;
+	}
+
+	hashes_.clear();
+	stale_.clear();
+	memory_fd_     = -1;
+	running_       = false;
+	checked_       = true;
+	clear_pending_ = false;
+}
+
+//------------------------------------------------------------------------------
+// Name: written
+// Desc:
+//------------------------------------------------------------------------------
+void BreakpointGuard::written(edb::address_t address, std::size_t len) {
+
+	if(hashes_.isEmpty() || len == 0) {
+		return;
+	}
+
+	const edb::address_t last = (address + len - 1) & ~(page_size_ - 1);
+	for(edb::address_t page = address & ~(page_size_ - 1); page <= last; page += page_size_) {
+		if(hashes_.contains(page)) {
+			stale_.insert(page);
+		}
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: arm
+// Desc: called just before the process runs, after check. Pages which have
+//       gained breakpoints, or which edb changed while it was stopped, are
+//       hashed again, the rest already are as they are now
+//------------------------------------------------------------------------------
+void BreakpointGuard::arm(const IDebugger::BreakpointList &breakpoints) {
+
+	if(running_ || memory_fd_ == -1) {
+		return;
+	}
+
+	QSet<edb::address_t> pages;
+	for(IDebugger::BreakpointList::const_iterator it = breakpoints.begin(); it != breakpoints.end(); ++it) {
+		if(it.value()->enabled()) {
+			pages.insert(it.key() & ~(page_size_ - 1));
+		}
+	}
+
+	QHash<edb::address_t, quint64>::iterator it = hashes_.begin();
+	while(it != hashes_.end()) {
+		if(pages.contains(it.key())) {
+			++it;
+		} else {
+			it = hashes_.erase(it);
+		}
+	}
+
+	// what edb wrote set the soft-dirty bits of those pages too
+	if(!stale_.isEmpty()) {
+		clear_pending_ = true;
+	}
+
+	QVector<quint8> buffer(page_size_);
+	Q_FOREACH(edb::address_t page, pages) {
+		if(!hashes_.contains(page) || stale_.contains(page)) {
+			clear_pending_ = true;
+			if(read_page(page, buffer.data())) {
+				hashes_[page] = edb::internal::xxh64(buffer.data(), page_size_);
+			} else {
+				hashes_.remove(page);
+			}
+		}
+	}
+
+	stale_.clear();
+
+	if(clear_pending_) {
+		clear_soft_dirty();
+		clear_pending_ = false;
+	}
+
+	running_ = true;
+	checked_ = false;
+}
+
+//------------------------------------------------------------------------------
+// Name: stopped
+// Desc: the process has stopped, and may have written anything since it was
+//       armed
+//------------------------------------------------------------------------------
+void BreakpointGuard::stopped() {
+	running_ = false;
+}
+
+//------------------------------------------------------------------------------
+// Name: check
+// Desc: after a stop, the pages the process may have written to are hashed
+//       again, only the breakpoints on the ones which changed are looked at.
+//       Once this has been done for a stop it costs nothing until the next
+//------------------------------------------------------------------------------
+QHash<edb::address_t, quint8> BreakpointGuard::check(const IDebugger::BreakpointList &breakpoints) {
+
+	QHash<edb::address_t, quint8> overwritten;
+
+	if(running_ || checked_) {
+		return overwritten;
+	}
+
+	checked_ = true;
+
+	QVector<quint8> buffer(page_size_);
+	for(QHash<edb::address_t, quint64>::iterator it = hashes_.begin(); it != hashes_.end(); ++it) {
+		const edb::address_t page = it.key();
+
+		if(pagemap_fd_ != -1) {
+			if(!soft_dirty(page)) {
+				continue;
+			}
+			clear_pending_ = true;
+		}
+
+		if(!read_page(page, buffer.data())) {
+			continue;
+		}
+
+		const quint64 hash = edb::internal::xxh64(buffer.data(), page_size_);
+		if(hash == it.value()) {
+			continue;
+		}
+
+		it.value() = hash;
+
+		for(IDebugger::BreakpointList::const_iterator bp = breakpoints.begin(); bp != breakpoints.end(); ++bp) {
+			const edb::address_t address = bp.key();
+			if(bp.value()->enabled() && (address & ~(page_size_ - 1)) == page) {
+				const quint8 byte = buffer[address - page];
+				if(byte != BreakpointInstruction) {
+					overwritten.insert(address, byte);
+				}
+			}
+		}
+	}
+
+	return overwritten;
+}
+
+//------------------------------------------------------------------------------
+// Name: read_page
+// Desc: what is really in memory, breakpoints and all
+//------------------------------------------------------------------------------
+bool BreakpointGuard::read_page(edb::address_t page, quint8 *buffer) const {
+	return pread64(memory_fd_, buffer, page_size_, page) == static_cast<ssize_t>(page_size_);
+}
+
+//------------------------------------------------------------------------------
+// Name: soft_dirty
+// Desc: true if the process may have written to <page> since the bits were
+//       last cleared
+//------------------------------------------------------------------------------
+bool BreakpointGuard::soft_dirty(edb::address_t page) const {
+	quint64 entry;
+	if(pread64(pagemap_fd_, &entry, sizeof(entry), (page / page_size_) * sizeof(entry)) != sizeof(entry)) {
+		return true;
+	}
+	return (entry & SoftDirtyBit) != 0;
+}
+
+//------------------------------------------------------------------------------
+// Name: clear_soft_dirty
+// Desc:
+//------------------------------------------------------------------------------
+void BreakpointGuard::clear_soft_dirty() {
+	if(clear_refs_fd_ != -1 && ::write(clear_refs_fd_, "4", 1) != 1) {
+		// it worked when it was opened, don't trust the bits from now on
+		::close(pagemap_fd_);
+		::close(clear_refs_fd_);
+		pagemap_fd_    = -1;
+		clear_refs_fd_ = -1;
+	}
+}
+
+}
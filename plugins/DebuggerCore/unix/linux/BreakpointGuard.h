@@ -0,0 +1,80 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef BREAKPOINTGUARD_20261014_H_
+#define BREAKPOINTGUARD_20261014_H_
+
+#include "IDebugger.h"
+#include "Types.h"
+#include <QHash>
+#include <QList>
+#include <QSet>
+
+namespace DebuggerCore {
+
+// notices when the process writes over the int3 of one of our breakpoints,
+// as self-modifying code and JITs do. Each page holding enabled breakpoints
+// is hashed just before the process runs, and once it has stopped the pages
+// are hashed again and only the breakpoints on the ones which changed are
+// looked at. When the kernel keeps soft-dirty bits, only the pages it says
+// were written are read at all. The pages are checked lazily, when asked or
+// at the latest before the process runs again
+class BreakpointGuard {
+public:
+	BreakpointGuard();
+	~BreakpointGuard();
+
+public:
+	void open(edb::pid_t pid, int memory_fd, edb::address_t page_size);
+	void close();
+
+public:
+	// edb changed these bytes itself, the pages are hashed again before the
+	// process next runs
+	void written(edb::address_t address, std::size_t len);
+
+	void arm(const IDebugger::BreakpointList &breakpoints);
+	void stopped();
+
+	// the enabled breakpoints whose int3 isn't in memory any more, along with
+	// the byte found there instead
+	QHash<edb::address_t, quint8> check(const IDebugger::BreakpointList &breakpoints);
+
+private:
+	Q_DISABLE_COPY(BreakpointGuard)
+
+private:
+	bool read_page(edb::address_t page, quint8 *buffer) const;
+	bool soft_dirty(edb::address_t page) const;
+	void clear_soft_dirty();
+
+private:
+	QHash<edb::address_t, quint64> hashes_;  // page -> hash of it when the process last ran
+	QSet<edb::address_t>           stale_;   // pages edb wrote to since
+	edb::address_t                 page_size_;
+	int                            memory_fd_;
+	int                            pagemap_fd_;    // -1 without soft-dirty bits
+	int                            clear_refs_fd_;
+	bool                           running_;
+	bool                           checked_;       // since the process stopped
+	bool                           clear_pending_; // some soft-dirty bits were seen set
+};
+
+}
+
+#endif
@@ -0,0 +1,217 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "CounterSet.h"
+#include "PerfEvent.h"
+
+#include <cstring>
+
+#include <unistd.h>
+
+namespace DebuggerCore {
+
+namespace {
+
+// what each of PerformanceCounters::Counter is to perf
+const quint64 hardware_events[PerformanceCounters::COUNTER_COUNT] = {
+	PERF_COUNT_HW_INSTRUCTIONS,
+	PERF_COUNT_HW_CPU_CYCLES,
+	PERF_COUNT_HW_CACHE_MISSES,
+	PERF_COUNT_HW_BRANCH_MISSES
+};
+
+}
+
+//------------------------------------------------------------------------------
+// Name: CounterSet
+// Desc: constructor
+//------------------------------------------------------------------------------
+CounterSet::CounterSet() : available_(0), running_(false) {
+	std::memset(exited_, 0, sizeof(exited_));
+}
+
+//------------------------------------------------------------------------------
+// Name: ~CounterSet
+// Desc: destructor
+//------------------------------------------------------------------------------
+CounterSet::~CounterSet() {
+	stop();
+}
+
+//------------------------------------------------------------------------------
+// Name: start
+// Desc: starts counting from zero for <threads>, returns false if the kernel
+//       can't count instructions for us. The other counters are optional
+//------------------------------------------------------------------------------
+bool CounterSet::start(const QList<edb::tid_t> &threads) {
+
+	stop();
+
+	std::memset(exited_, 0, sizeof(exited_));
+	available_ = ~0u;
+
+	Q_FOREACH(edb::tid_t tid, threads) {
+		Counters counters;
+		if(!open_counters(tid, &counters)) {
+			stop();
+			return false;
+		}
+		threads_.insert(tid, counters);
+	}
+
+	running_ = true;
+	return true;
+}
+
+//------------------------------------------------------------------------------
+// Name: stop
+// Desc:
+//------------------------------------------------------------------------------
+void CounterSet::stop() {
+
+	for(QHash<edb::tid_t, Counters>::iterator it = threads_.begin(); it != threads_.end(); ++it) {
+		close_counters(&it.value());
+	}
+
+	threads_.clear();
+	running_ = false;
+}
+
+//------------------------------------------------------------------------------
+// Name: add_thread
+// Desc: a thread which was created while counting
+//------------------------------------------------------------------------------
+void CounterSet::add_thread(edb::tid_t tid) {
+
+	if(running_ && !threads_.contains(tid)) {
+		Counters counters;
+		if(open_counters(tid, &counters)) {
+			threads_.insert(tid, counters);
+		}
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: remove_thread
+// Desc: a thread which has exited, what it counted is kept
+//------------------------------------------------------------------------------
+void CounterSet::remove_thread(edb::tid_t tid) {
+
+	QHash<edb::tid_t, Counters>::iterator it = threads_.find(tid);
+	if(it != threads_.end()) {
+		quint64 values[PerformanceCounters::COUNTER_COUNT];
+		read_counters(it.value(), values);
+		for(int i = 0; i < PerformanceCounters::COUNTER_COUNT; ++i) {
+			exited_[i] += values[i];
+		}
+
+		close_counters(&it.value());
+		threads_.erase(it);
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: read
+// Desc: the totals since counting started, of every thread
+//------------------------------------------------------------------------------
+PerformanceCounters CounterSet::read() const {
+
+	PerformanceCounters counters;
+	std::memcpy(counters.values, exited_, sizeof(counters.values));
+	counters.available = running_ ? available_ : 0;
+
+	Q_FOREACH(const Counters &thread, threads_) {
+		quint64 values[PerformanceCounters::COUNTER_COUNT];
+		read_counters(thread, values);
+		for(int i = 0; i < PerformanceCounters::COUNTER_COUNT; ++i) {
+			counters.values[i] += values[i];
+		}
+	}
+
+	return counters;
+}
+
+//------------------------------------------------------------------------------
+// Name: open_counters
+// Desc: a counter which can't be opened for one thread is dropped for all of
+//       them, instructions are needed though
+//------------------------------------------------------------------------------
+bool CounterSet::open_counters(edb::tid_t tid, Counters *counters) {
+
+	for(int i = 0; i < PerformanceCounters::COUNTER_COUNT; ++i) {
+		counters->fds[i] = -1;
+	}
+
+	for(int i = 0; i < PerformanceCounters::COUNTER_COUNT; ++i) {
+		if(!(available_ & (1u << i))) {
+			continue;
+		}
+
+		struct perf_event_attr attr;
+		std::memset(&attr, 0, sizeof(attr));
+		attr.size           = sizeof(attr);
+		attr.type           = PERF_TYPE_HARDWARE;
+		attr.config         = hardware_events[i];
+		attr.exclude_kernel = 1;
+		attr.exclude_hv     = 1;
+
+		counters->fds[i] = perf_event_open(&attr, tid, -1, -1, 0);
+		if(counters->fds[i] == -1) {
+			if(i == PerformanceCounters::INSTRUCTIONS) {
+				return false;
+			}
+
+			available_ &= ~(1u << i);
+		}
+	}
+
+	return true;
+}
+
+//------------------------------------------------------------------------------
+// Name: read_counters
+// Desc:
+//------------------------------------------------------------------------------
+void CounterSet::read_counters(const Counters &counters, quint64 *values) const {
+
+	for(int i = 0; i < PerformanceCounters::COUNTER_COUNT; ++i) {
+		values[i] = 0;
+		if(counters.fds[i] != -1) {
+			quint64 value;
+			if(::read(counters.fds[i], &value, sizeof(value)) == sizeof(value)) {
+				values[i] = value;
+			}
+		}
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: close_counters
+// Desc:
+//------------------------------------------------------------------------------
+void CounterSet::close_counters(Counters *counters) {
+
+	for(int i = 0; i < PerformanceCounters::COUNTER_COUNT; ++i) {
+		if(counters->fds[i] != -1) {
+			close(counters->fds[i]);
+			counters->fds[i] = -1;
+		}
+	}
+}
+
+}
@@ -0,0 +1,73 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef COUNTERSET_20261014_H_
+#define COUNTERSET_20261014_H_
+
+#include "PerformanceCounters.h"
+#include "Types.h"
+#include <QHash>
+#include <QList>
+
+namespace DebuggerCore {
+
+// counts what every thread does in user space with perf's hardware counters.
+// Each thread gets one counter of each kind and inherits nothing, so threads
+// are added as they are created and what a thread counted is kept once it
+// exits. The counters run whenever the thread does, reading them is fine at
+// any time
+class CounterSet {
+public:
+	CounterSet();
+	~CounterSet();
+
+public:
+	bool start(const QList<edb::tid_t> &threads);
+	void stop();
+	bool running() const { return running_; }
+
+public:
+	void add_thread(edb::tid_t tid);
+	void remove_thread(edb::tid_t tid);
+
+public:
+	PerformanceCounters read() const;
+
+private:
+	Q_DISABLE_COPY(CounterSet)
+
+private:
+	struct Counters {
+		int fds[PerformanceCounters::COUNTER_COUNT]; // -1 for those which couldn't be opened
+	};
+
+private:
+	bool open_counters(edb::tid_t tid, Counters *counters);
+	void read_counters(const Counters &counters, quint64 *values) const;
+	void close_counters(Counters *counters);
+
+private:
+	QHash<edb::tid_t, Counters> threads_;
+	quint64                     exited_[PerformanceCounters::COUNTER_COUNT]; // what threads which are gone counted
+	quint32                     available_;
+	bool                        running_;
+};
+
+}
+
+#endif
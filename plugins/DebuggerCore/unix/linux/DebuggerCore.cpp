@@ -16,10 +16,11 @@ You should have received a copy of the GNU General Public License
 along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
-
-// TODO(eteran): research usage of process_vm_readv, process_vm_writev
-
 #include "DebuggerCore.h"
+#include "Breakpoint.h"
+#include "CompiledExpression.h"
+#include "Configuration.h"
+#include "Diagnostics.h"
 #include "edb.h"
 #include "MemoryRegions.h"
 #include "PlatformEvent.h"
@@ -31,8 +32,13 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <QDebug>
 #include <QDir>
+#include <QFile>
+#include <QMutexLocker>
 
+#include <algorithm>
 #include <cerrno>
+#include <cstdio>
+#include <cstdlib>
 #include <cstring>
 
 #ifndef _GNU_SOURCE
@@ -40,11 +46,16 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #endif
 
 #include <asm/ldt.h>
+#include <elf.h>
 #include <pwd.h>
 #include <link.h>
 #include <cpuid.h>
+#include <dirent.h>
+#include <fcntl.h>
 #include <sys/mman.h>
 #include <sys/ptrace.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
 #include <sys/user.h>
 #include <sys/wait.h>
 
@@ -61,6 +72,22 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #define PTRACE_GETSIGINFO static_cast<__ptrace_request>(0x4202)
 #endif
 
+#ifndef PTRACE_EVENT_FORK
+#define PTRACE_EVENT_FORK 1
+#endif
+
+#ifndef PTRACE_O_TRACEFORK
+#define PTRACE_O_TRACEFORK (1 << PTRACE_EVENT_FORK)
+#endif
+
+#ifndef PTRACE_EVENT_VFORK
+#define PTRACE_EVENT_VFORK 2
+#endif
+
+#ifndef PTRACE_O_TRACEVFORK
+#define PTRACE_O_TRACEVFORK (1 << PTRACE_EVENT_VFORK)
+#endif
+
 #ifndef PTRACE_EVENT_CLONE
 #define PTRACE_EVENT_CLONE 3
 #endif
@@ -69,22 +96,134 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #define PTRACE_O_TRACECLONE (1 << PTRACE_EVENT_CLONE)
 #endif
 
+#ifndef PTRACE_EVENT_EXEC
+#define PTRACE_EVENT_EXEC 4
+#endif
+
+#ifndef PTRACE_O_TRACEEXEC
+#define PTRACE_O_TRACEEXEC (1 << PTRACE_EVENT_EXEC)
+#endif
+
+#ifndef PTRACE_O_TRACESYSGOOD
+#define PTRACE_O_TRACESYSGOOD 1
+#endif
+
 namespace DebuggerCore {
 
 namespace {
 
 //------------------------------------------------------------------------------
-// Name: is_numeric
-// Desc: returns true if the string only contains decimal digits
+// Name: ptrace_name
+// Desc:
 //------------------------------------------------------------------------------
-bool is_numeric(const QString &s) {
-	Q_FOREACH(QChar ch, s) {
-		if(!ch.isDigit()) {
-			return false;
-		}
+QString ptrace_name(__ptrace_request request) {
+	switch(request) {
+	case PTRACE_TRACEME: return "PTRACE_TRACEME";
+	case PTRACE_PEEKTEXT: return "PTRACE_PEEKTEXT";
+	case PTRACE_PEEKDATA: return "PTRACE_PEEKDATA";
+	case PTRACE_PEEKUSER: return "PTRACE_PEEKUSER";
+	case PTRACE_POKETEXT: return "PTRACE_POKETEXT";
+	case PTRACE_POKEDATA: return "PTRACE_POKEDATA";
+	case PTRACE_POKEUSER: return "PTRACE_POKEUSER";
+	case PTRACE_CONT: return "PTRACE_CONT";
+	case PTRACE_KILL: return "PTRACE_KILL";
+	case PTRACE_SINGLESTEP: return "PTRACE_SINGLESTEP";
+	case PTRACE_GETREGS: return "PTRACE_GETREGS";
+	case PTRACE_SETREGS: return "PTRACE_SETREGS";
+	case PTRACE_GETFPREGS: return "PTRACE_GETFPREGS";
+	case PTRACE_SETFPREGS: return "PTRACE_SETFPREGS";
+	case PTRACE_ATTACH: return "PTRACE_ATTACH";
+	case PTRACE_DETACH: return "PTRACE_DETACH";
+	case PTRACE_GET_THREAD_AREA: return "PTRACE_GET_THREAD_AREA";
+	case PTRACE_SYSCALL: return "PTRACE_SYSCALL";
+	case PTRACE_SETOPTIONS: return "PTRACE_SETOPTIONS";
+	case PTRACE_GETEVENTMSG: return "PTRACE_GETEVENTMSG";
+	case PTRACE_GETSIGINFO: return "PTRACE_GETSIGINFO";
+	case PTRACE_GETREGSET: return "PTRACE_GETREGSET";
+	case PTRACE_SEIZE: return "PTRACE_SEIZE";
+	case PTRACE_INTERRUPT: return "PTRACE_INTERRUPT";
+	case PTRACE_LISTEN: return "PTRACE_LISTEN";
+	default:
+		return QString("request %1").arg(static_cast<int>(request));
 	}
+}
 
-	return true;
+//------------------------------------------------------------------------------
+// Name: counted_ptrace
+// Desc: every ptrace edb makes goes through here, so that the diagnostics can
+//       say how many of each kind were made
+//------------------------------------------------------------------------------
+template <class Address, class Data>
+long counted_ptrace(__ptrace_request request, pid_t pid, Address address, Data data) {
+
+	static QHash<int, edb::diagnostics::Counter *> counters;
+
+	edb::diagnostics::Counter *&counter = counters[request];
+	if(!counter) {
+		counter = edb::diagnostics::counter(QString("ptrace: %1").arg(ptrace_name(request)));
+	}
+
+	edb::diagnostics::add(counter);
+	return ptrace(request, pid, address, data);
+}
+
+//------------------------------------------------------------------------------
+// Name: os_supports
+// Desc: returns true if CPUID reports OSXSAVE and the OS has enabled all of
+//       the XSAVE components in <mask> (as reported by XCR0)
+//------------------------------------------------------------------------------
+bool os_supports(quint32 mask) {
+	quint32 eax;
+	quint32 ebx;
+	quint32 ecx;
+	quint32 edx;
+	__cpuid(1, eax, ebx, ecx, edx);
+
+	if(!(ecx & bit_OSXSAVE)) {
+		return false;
+	}
+
+	quint32 xcr0_lo;
+	quint32 xcr0_hi;
+	asm volatile("xgetbv" : "=a"(xcr0_lo), "=d"(xcr0_hi) : "c"(0));
+	Q_UNUSED(xcr0_hi);
+
+	return (xcr0_lo & mask) == mask;
+}
+
+//------------------------------------------------------------------------------
+// Name: has_avx
+// Desc:
+//------------------------------------------------------------------------------
+bool has_avx() {
+	quint32 eax;
+	quint32 ebx;
+	quint32 ecx;
+	quint32 edx;
+	__cpuid(1, eax, ebx, ecx, edx);
+
+	// SSE and AVX state
+	return (ecx & bit_AVX) && os_supports(0x06);
+}
+
+//------------------------------------------------------------------------------
+// Name: has_avx512
+// Desc:
+//------------------------------------------------------------------------------
+bool has_avx512() {
+	if(!has_avx() || __get_cpuid_max(0, 0) < 7) {
+		return false;
+	}
+
+	quint32 eax;
+	quint32 ebx;
+	quint32 ecx;
+	quint32 edx;
+	__cpuid_count(7, 0, eax, ebx, ecx, edx);
+
+	// AVX512F is EBX bit 16, the opmask, ZMM_Hi256 and Hi16_ZMM state must be
+	// enabled as well
+	return (ebx & (1u << 16)) && os_supports(0xe6);
 }
 
 //------------------------------------------------------------------------------
@@ -97,6 +236,16 @@ int resume_code(int status) {
 		return 0;
 	}
 
+	// a syscall stop (see PTRACE_O_TRACESYSGOOD) is not a signal to pass on
+	if(WIFSTOPPED(status) && WSTOPSIG(status) == (SIGTRAP | 0x80)) {
+		return 0;
+	}
+
+	// neither is anything reported as PTRACE_EVENT_STOP
+	if(is_event_stop(status)) {
+		return 0;
+	}
+
 	if(WIFSIGNALED(status)) {
 		return WTERMSIG(status);
 	}
@@ -120,6 +269,135 @@ bool is_clone_event(int status) {
 	return false;
 }
 
+//------------------------------------------------------------------------------
+// Name: is_fork_event
+// Desc: a fork or a vfork, <vfork> is set to which one it was
+//------------------------------------------------------------------------------
+bool is_fork_event(int status, bool *vfork) {
+	Q_ASSERT(vfork);
+
+	if(WIFSTOPPED(status) && WSTOPSIG(status) == SIGTRAP) {
+		const int event = (status >> 16) & 0xffff;
+		if(event == PTRACE_EVENT_FORK || event == PTRACE_EVENT_VFORK) {
+			*vfork = (event == PTRACE_EVENT_VFORK);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+//------------------------------------------------------------------------------
+// Name: is_exec_event
+// Desc:
+//------------------------------------------------------------------------------
+bool is_exec_event(int status) {
+	if(WIFSTOPPED(status) && WSTOPSIG(status) == SIGTRAP) {
+		return (((status >> 16) & 0xffff) == PTRACE_EVENT_EXEC);
+	}
+
+	return false;
+}
+
+//------------------------------------------------------------------------------
+// Name: is_event_stop
+// Desc: PTRACE_EVENT_STOP is how seized threads report PTRACE_INTERRUPT,
+//       their initial stop and group-stops
+//------------------------------------------------------------------------------
+bool is_event_stop(int status) {
+	return WIFSTOPPED(status) && (((status >> 16) & 0xffff) == PTRACE_EVENT_STOP);
+}
+
+//------------------------------------------------------------------------------
+// Name: is_group_stop
+// Desc: a PTRACE_EVENT_STOP caused by a stopping signal rather than by us
+//------------------------------------------------------------------------------
+bool is_group_stop(int status) {
+	if(is_event_stop(status)) {
+		switch(WSTOPSIG(status)) {
+		case SIGSTOP:
+		case SIGTSTP:
+		case SIGTTIN:
+		case SIGTTOU:
+			return true;
+		default:
+			break;
+		}
+	}
+
+	return false;
+}
+
+//------------------------------------------------------------------------------
+// Name: is_syscall_stop
+// Desc: with PTRACE_O_TRACESYSGOOD, syscall stops are SIGTRAP | 0x80
+//------------------------------------------------------------------------------
+bool is_syscall_stop(int status) {
+	return WIFSTOPPED(status) && WSTOPSIG(status) == (SIGTRAP | 0x80);
+}
+
+//------------------------------------------------------------------------------
+// Name: poke_byte
+// Desc: writes a single byte to <pid> with ptrace, for processes which we have
+//       no PlatformProcess (or /proc/<pid>/mem) for
+//------------------------------------------------------------------------------
+bool poke_byte(edb::pid_t pid, edb::address_t address, quint8 byte) {
+	errno = 0;
+	long word = counted_ptrace(PTRACE_PEEKDATA, pid, address, 0);
+	if(errno != 0) {
+		return false;
+	}
+
+	// the lowest address is the lowest byte
+	std::memcpy(&word, &byte, sizeof(byte));
+	return counted_ptrace(PTRACE_POKEDATA, pid, address, word) != -1;
+}
+
+//------------------------------------------------------------------------------
+// Name: instruction_pointer_offset
+// Desc: where the instruction pointer is for PTRACE_PEEKUSER/PTRACE_POKEUSER
+//------------------------------------------------------------------------------
+std::size_t instruction_pointer_offset() {
+#if defined(EDB_X86_64)
+	return offsetof(struct user, regs.rip);
+#elif defined(EDB_X86)
+	return offsetof(struct user, regs.eip);
+#endif
+}
+
+//------------------------------------------------------------------------------
+// Name: changes_memory_map
+// Desc: returns true if <syscall_number> is one which can add, remove or
+//       change the protection of a mapping
+//------------------------------------------------------------------------------
+bool changes_memory_map(long syscall_number) {
+	switch(syscall_number) {
+#ifdef SYS_mmap
+	case SYS_mmap:
+#endif
+#ifdef SYS_mmap2
+	case SYS_mmap2:
+#endif
+#ifdef SYS_remap_file_pages
+	case SYS_remap_file_pages:
+#endif
+#ifdef SYS_shmat
+	case SYS_shmat:
+	case SYS_shmdt:
+#endif
+#ifdef SYS_ipc
+	case SYS_ipc:
+#endif
+	case SYS_munmap:
+	case SYS_mprotect:
+	case SYS_mremap:
+	case SYS_brk:
+		return true;
+	default:
+		return false;
+	}
+}
+
 struct user_stat {
 /* 01 */ int pid;
 /* 02 */ char comm[256];
@@ -262,6 +540,168 @@ int get_user_stat(edb::pid_t pid, struct user_stat *user_stat) {
 	return get_user_stat(QString("/proc/%1/stat").arg(pid), user_stat);
 }
 
+// what getdents64 fills its buffer with, glibc doesn't declare it
+struct linux_dirent64 {
+	quint64        d_ino;
+	qint64         d_off;
+	unsigned short d_reclen;
+	unsigned char  d_type;
+	char           d_name[1];
+};
+
+//------------------------------------------------------------------------------
+// Name: read_pids
+// Desc: the numeric entries of the directory <fd> is open on, read with
+//       getdents64 directly so that nothing is allocated or stat'ed per entry
+//------------------------------------------------------------------------------
+QVector<edb::pid_t> read_pids(int fd) {
+
+	QVector<edb::pid_t> pids;
+
+	char buffer[32768];
+	long n;
+	while((n = syscall(SYS_getdents64, fd, buffer, sizeof(buffer))) > 0) {
+		for(long offset = 0; offset < n;) {
+			const linux_dirent64 *const entry = reinterpret_cast<const linux_dirent64 *>(buffer + offset);
+			offset += entry->d_reclen;
+
+			if(entry->d_type != DT_DIR && entry->d_type != DT_UNKNOWN) {
+				continue;
+			}
+
+			edb::pid_t pid = 0;
+			const char *p = entry->d_name;
+			for(; *p >= '0' && *p <= '9'; ++p) {
+				pid = pid * 10 + (*p - '0');
+			}
+
+			if(p != entry->d_name && *p == '\0') {
+				pids.push_back(pid);
+			}
+		}
+	}
+
+	std::sort(pids.begin(), pids.end());
+	return pids;
+}
+
+//------------------------------------------------------------------------------
+// Name: read_process
+// Desc: the owner and name of the process which /proc/<pid> is for, <fd> being
+//       open on /proc. Returns false if it has gone away
+//------------------------------------------------------------------------------
+bool read_process(int fd, edb::pid_t pid, ProcessInfo *info) {
+
+	char path[32];
+	std::snprintf(path, sizeof(path), "%d", static_cast<int>(pid));
+
+	struct stat st;
+	if(::fstatat(fd, path, &st, 0) == -1) {
+		return false;
+	}
+
+	info->pid = pid;
+	info->uid = st.st_uid;
+
+	std::snprintf(path, sizeof(path), "%d/stat", static_cast<int>(pid));
+
+	const int stat_fd = ::openat(fd, path, O_RDONLY | O_CLOEXEC);
+	if(stat_fd == -1) {
+		return false;
+	}
+
+	// "pid (comm) state ...", comm may itself have parentheses in it but is
+	// never longer than 16 characters, so the last ')' is near the start
+	char line[256];
+	const ssize_t n = ::read(stat_fd, line, sizeof(line) - 1);
+	::close(stat_fd);
+
+	if(n > 0) {
+		line[n] = '\0';
+		const char *const first = std::strchr(line, '(');
+		const char *const last  = std::strrchr(line, ')');
+		if(first && last && last > first) {
+			info->name = QString::fromLocal8Bit(first + 1, last - first - 1);
+		}
+	}
+
+	return true;
+}
+
+//------------------------------------------------------------------------------
+// Name: user_name
+// Desc: getpwuid can mean reading /etc/passwd or asking NSS, so every uid is
+//       only looked up once, unknown ones included
+//------------------------------------------------------------------------------
+QString user_name(edb::uid_t uid, QHash<edb::uid_t, QString> *names) {
+
+	QHash<edb::uid_t, QString>::const_iterator it = names->find(uid);
+	if(it != names->end()) {
+		return it.value();
+	}
+
+	QString name;
+
+	long size = ::sysconf(_SC_GETPW_R_SIZE_MAX);
+	if(size <= 0) {
+		size = 16384;
+	}
+
+	QByteArray buffer(size, 0);
+	struct passwd pwd;
+	struct passwd *result = 0;
+	if(::getpwuid_r(uid, &pwd, buffer.data(), buffer.size(), &result) == 0 && result) {
+		name = QString::fromLocal8Bit(result->pw_name);
+	}
+
+	names->insert(uid, name);
+	return name;
+}
+
+//------------------------------------------------------------------------------
+// Name: CollectProcesses
+// Desc: what enumerate_processes uses to get all of them at once
+//------------------------------------------------------------------------------
+struct CollectProcesses : IDebugger::ProcessSink {
+	virtual bool found(const QList<ProcessInfo> &processes) {
+		Q_FOREACH(const ProcessInfo &info, processes) {
+			result.insert(info.pid, info);
+		}
+		return true;
+	}
+
+	QMap<edb::pid_t, ProcessInfo> result;
+};
+
+//------------------------------------------------------------------------------
+// Name: smaps_field
+// Desc: if <line> is the "<name>: <n> kB" line of an smaps file, sets <bytes>
+//       to n kB in bytes and returns true
+//------------------------------------------------------------------------------
+bool smaps_field(const char *line, const char *name, quint64 *bytes) {
+
+	const std::size_t length = std::strlen(name);
+	if(std::strncmp(line, name, length) != 0 || line[length] != ':') {
+		return false;
+	}
+
+	*bytes = std::strtoull(line + length + 1, 0, 10) * 1024;
+	return true;
+}
+
+//------------------------------------------------------------------------------
+// Name: smaps_usage
+// Desc: adds the Rss and Pss of <line> to <usage>, if it has either
+//------------------------------------------------------------------------------
+void smaps_usage(const char *line, MemoryUsage *usage) {
+
+	quint64 bytes;
+	if(smaps_field(line, "Rss", &bytes)) {
+		usage->resident += bytes;
+	} else if(smaps_field(line, "Pss", &bytes)) {
+		usage->proportional += bytes;
+	}
+}
 
 }
 
@@ -269,7 +709,8 @@ int get_user_stat(edb::pid_t pid, struct user_stat *user_stat) {
 // Name: DebuggerCore
 // Desc: constructor
 //------------------------------------------------------------------------------
-DebuggerCore::DebuggerCore() : binary_info_(0), process_(0) {
+DebuggerCore::DebuggerCore() : binary_info_(0), process_(0), memory_fd_(-1), trace_syscalls_(false), memory_map_changed_(true), seized_(false), pause_requested_(false), non_stop_(false), follow_fork_(false), stop_generation_(0), debug_generation_(0) {
+	std::memset(&debug_registers_, 0, sizeof(debug_registers_));
 #if defined(_SC_PAGESIZE)
 	page_size_ = sysconf(_SC_PAGESIZE);
 #elif defined(_SC_PAGE_SIZE)
@@ -277,6 +718,7 @@ DebuggerCore::DebuggerCore() : binary_info_(0), process_(0) {
 #else
 	page_size_ = PAGE_SIZE;
 #endif
+	memory_service_.setMaxThreadCount(1);
 }
 
 //------------------------------------------------------------------------------
@@ -300,6 +742,11 @@ bool DebuggerCore::has_extension(quint64 ext) const {
 		return (edx & bit_MMX);
 	case edb::string_hash<'X', 'M', 'M'>::value:
 		//return (edx & bit_SSE);
+		return false;
+	case edb::string_hash<'A', 'V', 'X'>::value:
+		return has_avx();
+	case edb::string_hash<'A', 'V', 'X', '5', '1', '2'>::value:
+		return has_avx512();
 	default:
 		return false;
 	}
@@ -310,6 +757,10 @@ bool DebuggerCore::has_extension(quint64 ext) const {
 	case edb::string_hash<'M', 'M', 'X'>::value:
 	case edb::string_hash<'X', 'M', 'M'>::value:
 		return true;
+	case edb::string_hash<'A', 'V', 'X'>::value:
+		return has_avx();
+	case edb::string_hash<'A', 'V', 'X', '5', '1', '2'>::value:
+		return has_avx512();
 	default:
 		return false;
 	}
@@ -338,7 +789,7 @@ DebuggerCore::~DebuggerCore() {
 //------------------------------------------------------------------------------
 long DebuggerCore::ptrace_getsiginfo(edb::tid_t tid, siginfo_t *siginfo) {
 	Q_ASSERT(siginfo != 0);
-	return ptrace(PTRACE_GETSIGINFO, tid, 0, siginfo);
+	return counted_ptrace(PTRACE_GETSIGINFO, tid, 0, siginfo);
 }
 
 //------------------------------------------------------------------------------
@@ -346,7 +797,7 @@ long DebuggerCore::ptrace_getsiginfo(edb::tid_t tid, siginfo_t *siginfo) {
 // Desc:
 //------------------------------------------------------------------------------
 long DebuggerCore::ptrace_traceme() {
-	return ptrace(PTRACE_TRACEME, 0, 0, 0);
+	return counted_ptrace(PTRACE_TRACEME, 0, 0, 0);
 }
 
 //------------------------------------------------------------------------------
@@ -357,7 +808,22 @@ long DebuggerCore::ptrace_continue(edb::tid_t tid, long status) {
 	Q_ASSERT(waited_threads_.contains(tid));
 	Q_ASSERT(tid != 0);
 	waited_threads_.remove(tid);
-	return ptrace(PTRACE_CONT, tid, 0, status);
+	apply_debug_registers(tid);
+
+	// once anything runs, nothing we have cached can be trusted
+	if(process_) {
+		process_->flush_cache();
+	}
+	thread_ran(tid);
+	guard_breakpoints();
+
+	// unless we're watching the syscalls, who knows what it mapped
+	if(trace_syscalls_ || syscall_tracer_.running()) {
+		return counted_ptrace(PTRACE_SYSCALL, tid, 0, status);
+	}
+
+	memory_map_changed_ = true;
+	return counted_ptrace(PTRACE_CONT, tid, 0, status);
 }
 
 //------------------------------------------------------------------------------
@@ -368,7 +834,71 @@ long DebuggerCore::ptrace_step(edb::tid_t tid, long status) {
 	Q_ASSERT(waited_threads_.contains(tid));
 	Q_ASSERT(tid != 0);
 	waited_threads_.remove(tid);
-	return ptrace(PTRACE_SINGLESTEP, tid, 0, status);
+	apply_debug_registers(tid);
+
+	// a single instruction can only change the memory map if it is a syscall
+	if(at_syscall_instruction(tid)) {
+		memory_map_changed_ = true;
+	}
+
+	// once anything runs, nothing we have cached can be trusted
+	if(process_) {
+		process_->flush_cache();
+	}
+	thread_ran(tid);
+	guard_breakpoints();
+
+	return counted_ptrace(PTRACE_SINGLESTEP, tid, 0, status);
+}
+
+//------------------------------------------------------------------------------
+// Name: ptrace_listen
+// Desc: lets a seized thread which is in a group-stop sit there until it
+//       gets a SIGCONT, while still reporting events to us
+//------------------------------------------------------------------------------
+long DebuggerCore::ptrace_listen(edb::tid_t tid) {
+	Q_ASSERT(waited_threads_.contains(tid));
+	Q_ASSERT(tid != 0);
+	waited_threads_.remove(tid);
+	apply_debug_registers(tid);
+
+	threads_[tid].state = thread_info::THREAD_STOPPED;
+
+	// once anything runs, nothing we have cached can be trusted
+	if(process_) {
+		process_->flush_cache();
+	}
+	thread_ran(tid);
+	guard_breakpoints();
+
+	memory_map_changed_ = true;
+	return counted_ptrace(PTRACE_LISTEN, tid, 0, 0);
+}
+
+//------------------------------------------------------------------------------
+// Name: ptrace_resume
+// Desc: continues <tid>, unless it is in a group-stop, in which case it is
+//       left listening for a SIGCONT
+//------------------------------------------------------------------------------
+long DebuggerCore::ptrace_resume(edb::tid_t tid, long status) {
+	if(threads_[tid].state == thread_info::THREAD_GROUP_STOPPED) {
+		return ptrace_listen(tid);
+	}
+
+	return ptrace_continue(tid, status);
+}
+
+//------------------------------------------------------------------------------
+// Name: is_attach_stop
+// Desc: returns true if <status> is the stop we expect from a thread which we
+//       just attached to or asked to stop
+//------------------------------------------------------------------------------
+bool DebuggerCore::is_attach_stop(int status) const {
+	if(seized_) {
+		return is_event_stop(status);
+	}
+
+	return WIFSTOPPED(status) && WSTOPSIG(status) == SIGSTOP;
 }
 
 //------------------------------------------------------------------------------
@@ -378,7 +908,19 @@ long DebuggerCore::ptrace_step(edb::tid_t tid, long status) {
 long DebuggerCore::ptrace_set_options(edb::tid_t tid, long options) {
 	Q_ASSERT(waited_threads_.contains(tid));
 	Q_ASSERT(tid != 0);
-	return ptrace(PTRACE_SETOPTIONS, tid, 0, options);
+	return counted_ptrace(PTRACE_SETOPTIONS, tid, 0, options);
+}
+
+//------------------------------------------------------------------------------
+// Name: trace_options
+// Desc: the PTRACE_O_* options every thread we trace gets
+//------------------------------------------------------------------------------
+long DebuggerCore::trace_options() const {
+	long options = PTRACE_O_TRACECLONE | PTRACE_O_TRACEEXEC | PTRACE_O_TRACESYSGOOD;
+	if(follow_fork_) {
+		options |= PTRACE_O_TRACEFORK | PTRACE_O_TRACEVFORK;
+	}
+	return options;
 }
 
 //------------------------------------------------------------------------------
@@ -389,7 +931,7 @@ long DebuggerCore::ptrace_get_event_message(edb::tid_t tid, unsigned long *messa
 	Q_ASSERT(waited_threads_.contains(tid));
 	Q_ASSERT(tid != 0);
 	Q_ASSERT(message != 0);
-	return ptrace(PTRACE_GETEVENTMSG, tid, 0, message);
+	return counted_ptrace(PTRACE_GETEVENTMSG, tid, 0, message);
 }
 
 //------------------------------------------------------------------------------
@@ -400,11 +942,17 @@ IDebugEvent::const_pointer DebuggerCore::handle_event(edb::tid_t tid, int status
 
 	// note that we have waited on this thread
 	waited_threads_.insert(tid);
+	breakpoint_guard_.stopped();
+
+	// drain the branch trace while there's room to spare
+	branch_tracer_.collect();
 
 	// was it a thread exit event?
 	if(WIFEXITED(status)) {
 		threads_.remove(tid);
 		waited_threads_.remove(tid);
+		profile_sampler_.remove_thread(tid);
+		counter_set_.remove_thread(tid);
 
 		// if this was the last thread, return true
 		// so we report it to the user.
@@ -415,13 +963,26 @@ IDebugEvent::const_pointer DebuggerCore::handle_event(edb::tid_t tid, int status
 		}
 	}
 
+	// was it a new process? with follow_fork_ we track it in the background
+	bool vfork;
+	if(is_fork_event(status, &vfork)) {
+
+		unsigned long child;
+		if(ptrace_get_event_message(tid, &child) != -1) {
+			adopt_child(child, vfork);
+		}
+
+		ptrace_continue(tid, 0);
+		return IDebugEvent::const_pointer();
+	}
+
 	// was it a thread create event?
 	if(is_clone_event(status)) {
 
 		unsigned long new_tid;
 		if(ptrace_get_event_message(tid, &new_tid) != -1) {
 
-			const thread_info info = { 0, thread_info::THREAD_STOPPED };
+			const thread_info info = { 0, thread_info::THREAD_STOPPED, 0, ++stop_generation_ };
 			threads_.insert(new_tid, info);
 
 			int thread_status = 0;
@@ -431,10 +992,13 @@ IDebugEvent::const_pointer DebuggerCore::handle_event(edb::tid_t tid, int status
 				}
 			}
 
-			if(!WIFSTOPPED(thread_status) || WSTOPSIG(thread_status) != SIGSTOP) {
+			if(!is_attach_stop(thread_status)) {
 				qDebug("[warning] new thread [%d] received an event besides SIGSTOP", static_cast<int>(new_tid));
 			}
 
+			profile_sampler_.add_thread(new_tid);
+			counter_set_.add_thread(new_tid);
+
 			// TODO: what the heck do we do if this isn't a SIGSTOP?
 			ptrace_continue(new_tid, resume_code(thread_status));
 		}
@@ -443,8 +1007,54 @@ IDebugEvent::const_pointer DebuggerCore::handle_event(edb::tid_t tid, int status
 		return IDebugEvent::const_pointer();
 	}
 
-	// normal event
-
+	// we only get these when tracking the memory map or tracing syscalls,
+	// note the interesting ones and quietly carry on
+	if(is_syscall_stop(status)) {
+		syscall_stop(tid);
+		ptrace_continue(tid, 0);
+		return IDebugEvent::const_pointer();
+	}
+
+	// the old /proc/<pid>/mem refers to the address space which was just
+	// thrown away, so we need a new one
+	if(is_exec_event(status)) {
+		open_memory_file();
+		memory_map_changed_ = true;
+	}
+
+	// neither do signals which the policy says go straight to the process,
+	// the other threads haven't been stopped so only this one is resumed
+	if(WIFSTOPPED(status) && (status >> 16) == 0 && pass_signal(tid, WSTOPSIG(status))) {
+		ptrace_continue(tid, WSTOPSIG(status));
+		return IDebugEvent::const_pointer();
+	}
+
+	// conditional breakpoints whose condition doesn't hold, and logpoints,
+	// never need to be seen by the UI
+	bool skipped = false;
+	IDebugEvent::const_pointer step_event = skip_conditional_breakpoint(tid, status, &skipped);
+	if(skipped) {
+		return step_event;
+	}
+
+	if(seized_ && is_event_stop(status)) {
+		if(is_group_stop(status)) {
+			// something sent the process a SIGSTOP (or similar), when we
+			// resume, we'll leave it in the group-stop with PTRACE_LISTEN
+			threads_[tid].state = thread_info::THREAD_GROUP_STOPPED;
+		} else if(!pause_requested_) {
+			// a PTRACE_INTERRUPT from stop_threads which arrived after the
+			// thread had already stopped for some other reason
+			ptrace_continue(tid, 0);
+			return IDebugEvent::const_pointer();
+		}
+
+		// report it the same way as the SIGSTOP pause() would otherwise send
+		status = (WSTOPSIG(status) == SIGTRAP ? SIGSTOP : WSTOPSIG(status)) << 8 | 0x7f;
+	}
+
+	// normal event
+	pause_requested_ = false;
 
 	PlatformEvent *const e = new PlatformEvent;
 
@@ -459,32 +1069,442 @@ IDebugEvent::const_pointer DebuggerCore::handle_event(edb::tid_t tid, int status
 	event_thread_        = tid;
 	threads_[tid].status = status;
 
-	stop_threads();
+	// in non-stop mode, only the thread which had the event is paused
+	if(!non_stop_) {
+		stop_threads();
+	}
+
 	return IDebugEvent::const_pointer(e);
 }
 
+//------------------------------------------------------------------------------
+// Name: syscall_stop
+// Desc: <tid> is entering or leaving a syscall. The ones which can change the
+//       memory map are noted, and the syscall is recorded if it is traced
+// Note: the kernel sets the return value to -ENOSYS before the syscall runs,
+//       which is how an entry is told apart from an exit
+//------------------------------------------------------------------------------
+void DebuggerCore::syscall_stop(edb::tid_t tid) {
+
+	struct user_regs_struct regs;
+	if(counted_ptrace(PTRACE_GETREGS, tid, 0, &regs) == -1) {
+		memory_map_changed_ = true;
+		return;
+	}
+
+#if defined(EDB_X86_64)
+	const long       syscall_number = regs.orig_rax;
+	const long       result         = regs.rax;
+	const edb::reg_t arguments[6]   = { regs.rdi, regs.rsi, regs.rdx, regs.r10, regs.r8, regs.r9 };
+#elif defined(EDB_X86)
+	const long       syscall_number = regs.orig_eax;
+	const long       result         = regs.eax;
+	const edb::reg_t arguments[6]   = { regs.ebx, regs.ecx, regs.edx, regs.esi, regs.edi, regs.ebp };
+#endif
+
+	if(changes_memory_map(syscall_number)) {
+		memory_map_changed_ = true;
+	}
+
+	if(syscall_tracer_.running()) {
+		if(result == -ENOSYS) {
+			syscall_tracer_.enter(tid, syscall_number, arguments);
+		} else {
+			syscall_tracer_.leave(tid, result);
+		}
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: pass_signal
+// Desc: returns true if <signal> is one which the signal policy says to give
+//       to the process without telling the UI, it is logged if asked to be
+//------------------------------------------------------------------------------
+bool DebuggerCore::pass_signal(edb::tid_t tid, int signal) const {
+
+	// these are how we debug, they are never just the process' business
+	if(signal == SIGTRAP || signal == SIGSTOP || signal == SIGKILL) {
+		return false;
+	}
+
+	switch(signal_policies_.value(signal, Configuration::SignalStop)) {
+	case Configuration::SignalLog:
+		qDebug("[DebuggerCore] thread [%d] received signal %d, passed on", static_cast<int>(tid), signal);
+		return true;
+	case Configuration::SignalPass:
+		return true;
+	default:
+		return false;
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: skip_conditional_breakpoint
+// Desc: if <tid> stopped on one of our breakpoints and its condition is false,
+//       or it is a logpoint, this does what the UI would: logs the message of
+//       a logpoint, steps over the breakpoint and resumes.
+//       <skipped> is set to true if the event was dealt with, in which case
+//       the result is whatever event came out of the step (usually none)
+// Note: if the condition can't be evaluated here (eg. it uses symbols), we
+//       leave it to the UI which will report any error
+//------------------------------------------------------------------------------
+IDebugEvent::const_pointer DebuggerCore::skip_conditional_breakpoint(edb::tid_t tid, int status, bool *skipped) {
+
+	Q_ASSERT(skipped);
+	*skipped = false;
+
+	// an int3 is a SIGTRAP with si_code == SI_KERNEL, anything else is a step,
+	// a hardware breakpoint or a ptrace event
+	if(!WIFSTOPPED(status) || WSTOPSIG(status) != SIGTRAP || (status >> 16) != 0 || breakpoints_.isEmpty()) {
+		return IDebugEvent::const_pointer();
+	}
+
+	siginfo_t siginfo;
+	if(ptrace_getsiginfo(tid, &siginfo) == -1 || siginfo.si_code != SI_KERNEL) {
+		return IDebugEvent::const_pointer();
+	}
+
+	const PlatformState &cached = fetch_state(tid, PlatformState::GROUP_GPR);
+
+	const edb::address_t address = cached.instruction_pointer() - 1;
+	const IBreakpoint::pointer bp = find_breakpoint(address);
+	if(!bp || !bp->enabled() || (bp->condition.isEmpty() && bp->log_format.isEmpty())) {
+		return IDebugEvent::const_pointer();
+	}
+
+	// the condition sees the registers as they are at the breakpoint
+	PlatformState regs = cached;
+	regs.set_instruction_pointer(address);
+
+	State state;
+	*static_cast<PlatformState *>(state.detach()) = regs;
+
+	if(!bp->condition.isEmpty()) {
+		bool result;
+		ExpressionError err;
+		if(!edb::v1::breakpoint_condition_true(bp, state, &result, &err)) {
+			return IDebugEvent::const_pointer();
+		}
+
+		// a regular breakpoint whose condition holds stops as usual
+		if(result && bp->log_format.isEmpty()) {
+			return IDebugEvent::const_pointer();
+		}
+
+		// a logpoint only logs when its condition holds
+		if(result) {
+			edb::v1::log_breakpoint_hit(bp, state);
+		}
+	} else {
+		edb::v1::log_breakpoint_hit(bp, state);
+	}
+
+	*skipped = true;
+	bp->hit();
+
+	// run the real instruction, with the other threads stopped so none of them
+	// can get past the breakpoint while it's out of the way
+	if(!non_stop_) {
+		stop_threads();
+	}
+
+	counted_ptrace(PTRACE_SETREGS, tid, 0, &regs.regs_);
+
+	bp->disable();
+	ptrace_step(tid, 0);
+
+	int step_status;
+	const bool stepped = native::waitpid(tid, &step_status, __WALL) > 0;
+	bp->enable();
+
+	if(!stepped) {
+		return IDebugEvent::const_pointer();
+	}
+
+	// the step might have hit something interesting (even another breakpoint)
+	if(!WIFSTOPPED(step_status) || WSTOPSIG(step_status) != SIGTRAP || (step_status >> 16) != 0) {
+		return handle_event(tid, step_status);
+	}
+
+	waited_threads_.insert(tid);
+	threads_[tid].status = step_status;
+
+	Q_FOREACH(edb::tid_t thread, thread_ids()) {
+		if(waited_threads_.contains(thread)) {
+			ptrace_resume(thread, (thread == tid) ? 0 : resume_code(threads_[thread].status));
+		}
+	}
+
+	return IDebugEvent::const_pointer();
+}
+
+//------------------------------------------------------------------------------
+// Name: thread_ran
+// Desc: forgets the registers cached for <tid>, which is about to run
+//------------------------------------------------------------------------------
+void DebuggerCore::thread_ran(edb::tid_t tid) {
+	const threadmap_t::iterator it = threads_.find(tid);
+	if(it != threads_.end()) {
+		it->run_generation = ++stop_generation_;
+	}
+	stop_states_.remove(tid);
+}
+
+//------------------------------------------------------------------------------
+// Name: thread_generation
+// Desc: the run_generation of <tid>, states captured under any other are out
+//       of date
+//------------------------------------------------------------------------------
+quint64 DebuggerCore::thread_generation(edb::tid_t tid) const {
+	const threadmap_t::const_iterator it = threads_.find(tid);
+	return it != threads_.end() ? it->run_generation : 0;
+}
+
+//------------------------------------------------------------------------------
+// Name: threads_running
+// Desc: true if some of the threads are running while we look at the others,
+//       which only happens in non-stop mode. Memory can change under us then
+//------------------------------------------------------------------------------
+bool DebuggerCore::threads_running() const {
+	return non_stop_ && waited_threads_.size() != threads_.size();
+}
+
+//------------------------------------------------------------------------------
+// Name: can_rewrite_memory
+// Desc:
+//------------------------------------------------------------------------------
+bool DebuggerCore::can_rewrite_memory() const {
+	return !threads_running();
+}
+
 //------------------------------------------------------------------------------
 // Name: stop_threads
 // Desc:
 //------------------------------------------------------------------------------
 void DebuggerCore::stop_threads() {
-	for(threadmap_t::iterator it = threads_.begin(); it != threads_.end(); ++it) {
+
+	// ask all of the threads to stop before waiting on any of them, that way
+	// they stop in parallel instead of one at a time
+	QList<edb::tid_t> stopping;
+	for(threadmap_t::const_iterator it = threads_.begin(); it != threads_.end(); ++it) {
 		if(!waited_threads_.contains(it.key())) {
 			const edb::tid_t tid = it.key();
 
-			syscall(SYS_tgkill, pid(), tid, SIGSTOP);
+			// a seized thread can be stopped without sending it a signal
+			if(seized_) {
+				counted_ptrace(PTRACE_INTERRUPT, tid, 0, 0);
+			} else {
+				syscall(SYS_tgkill, pid(), tid, SIGSTOP);
+			}
+
+			stopping.push_back(tid);
+		}
+	}
+
+	Q_FOREACH(edb::tid_t tid, stopping) {
+		int thread_status;
+		if(native::waitpid(tid, &thread_status, __WALL) > 0) {
+			waited_threads_.insert(tid);
+			threads_[tid].status = thread_status;
+
+			if(!is_attach_stop(thread_status)) {
+				qDebug("[warning] paused thread [%d] received an event besides SIGSTOP", tid);
+			}
+		}
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: adopt_child
+// Desc: starts following <child> in the background. Unless it shares our
+//       memory (vfork), it got a copy of our breakpoints which are taken out
+//       so it doesn't trip over them while nobody is looking
+//------------------------------------------------------------------------------
+void DebuggerCore::adopt_child(edb::pid_t child, bool shares_memory) {
+
+	// a traced child starts out stopped, and it may have told us about it
+	// before the parent told us about the fork
+	int status = 0;
+	if(native::waitpid(child, &status, __WALL) > 0 && !is_attach_stop(status)) {
+		qDebug("[warning] new process [%d] received an event besides SIGSTOP", static_cast<int>(child));
+	}
+
+	background_process &process = background_[child];
+	process.threads.insert(child);
+	process.shares_memory = shares_memory;
+
+	if(!shares_memory) {
+		strip_breakpoints(child);
+	}
+
+	counted_ptrace(PTRACE_CONT, child, 0, 0);
+}
+
+//------------------------------------------------------------------------------
+// Name: strip_breakpoints
+// Desc: puts back the original bytes of our breakpoints in <pid>, whose
+//       memory is a copy of ours
+//------------------------------------------------------------------------------
+void DebuggerCore::strip_breakpoints(edb::pid_t pid) {
+	Q_FOREACH(const IBreakpoint::pointer &bp, breakpoints_) {
+		if(bp->enabled()) {
+			poke_byte(pid, bp->address(), bp->original_byte());
+		}
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: step_over_breakpoint
+// Desc: <tid> of <pid> is in a process which shares our memory and ran into one of our
+//       breakpoints at <address>, it runs the real instruction and carries on
+//------------------------------------------------------------------------------
+void DebuggerCore::step_over_breakpoint(edb::pid_t pid, edb::tid_t tid, edb::address_t address) {
+
+	const IBreakpoint::pointer bp = find_breakpoint(address);
+	Q_ASSERT(bp);
+
+	// the vfork parent is suspended until the child execs or exits, so nothing
+	// else of ours runs past the breakpoint while it is out
+	const quint8 int3 = 0xcc;
+	poke_byte(tid, address, bp->original_byte());
+	counted_ptrace(PTRACE_POKEUSER, tid, instruction_pointer_offset(), address);
+	counted_ptrace(PTRACE_SINGLESTEP, tid, 0, 0);
+
+	int status;
+	const bool stepped = native::waitpid(tid, &status, __WALL) > 0;
+	poke_byte(tid, address, int3);
+
+	if(stepped) {
+		if(WIFSTOPPED(status) && WSTOPSIG(status) == SIGTRAP && (status >> 16) == 0) {
+			counted_ptrace(PTRACE_CONT, tid, 0, 0);
+		} else {
+			// the step ended in something else, like a signal or an exit
+			handle_background_event(pid, tid, status);
+		}
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: handle_background_event
+// Desc: deals with an event from <tid> of <pid>, one of the processes that we
+//       follow without debugging them, and lets it carry on
+//------------------------------------------------------------------------------
+void DebuggerCore::handle_background_event(edb::pid_t pid, edb::tid_t tid, int status) {
+
+	processmap_t::iterator it = background_.find(pid);
+	if(it == background_.end()) {
+		return;
+	}
+
+	if(WIFEXITED(status) || WIFSIGNALED(status)) {
+		it->threads.remove(tid);
+		if(it->threads.isEmpty()) {
+			background_.erase(it);
+		}
+		return;
+	}
+
+	if(!WIFSTOPPED(status)) {
+		return;
+	}
+
+	bool vfork;
+	if(is_fork_event(status, &vfork)) {
+		const bool shares_memory = vfork && it->shares_memory;
+
+		unsigned long child;
+		if(counted_ptrace(PTRACE_GETEVENTMSG, tid, 0, &child) != -1) {
+			adopt_child(child, shares_memory);
+		}
+
+		counted_ptrace(PTRACE_CONT, tid, 0, 0);
+		return;
+	}
+
+	if(is_clone_event(status)) {
+		unsigned long new_tid;
+		if(counted_ptrace(PTRACE_GETEVENTMSG, tid, 0, &new_tid) != -1) {
+			it->threads.insert(new_tid);
 
 			int thread_status;
-			if(native::waitpid(tid, &thread_status, __WALL) > 0) {
-				waited_threads_.insert(tid);
-				it->status = thread_status;
+			if(native::waitpid(new_tid, &thread_status, __WALL) > 0) {
+				counted_ptrace(PTRACE_CONT, new_tid, 0, 0);
+			}
+		}
+
+		counted_ptrace(PTRACE_CONT, tid, 0, 0);
+		return;
+	}
+
+	// an exec leaves only the main thread, in an address space of its own
+	if(is_exec_event(status)) {
+		it->threads.clear();
+		it->threads.insert(pid);
+		it->shares_memory = false;
+		counted_ptrace(PTRACE_CONT, tid, 0, 0);
+		return;
+	}
 
-				if(!WIFSTOPPED(thread_status) || WSTOPSIG(thread_status) != SIGSTOP) {
-					qDebug("[warning] paused thread [%d] received an event besides SIGSTOP", tid);
+	if(is_event_stop(status)) {
+		if(is_group_stop(status)) {
+			counted_ptrace(PTRACE_LISTEN, tid, 0, 0);
+		} else {
+			counted_ptrace(PTRACE_CONT, tid, 0, 0);
+		}
+		return;
+	}
+
+	// one of our breakpoints, in memory that we share with it
+	if(WSTOPSIG(status) == SIGTRAP && (status >> 16) == 0 && it->shares_memory) {
+		siginfo_t siginfo;
+		if(counted_ptrace(PTRACE_GETSIGINFO, tid, 0, &siginfo) != -1 && siginfo.si_code == SI_KERNEL) {
+			errno = 0;
+			const edb::address_t address = counted_ptrace(PTRACE_PEEKUSER, tid, instruction_pointer_offset(), 0) - 1;
+			if(errno == 0) {
+				const IBreakpoint::pointer bp = find_breakpoint(address);
+				if(bp && bp->enabled()) {
+					step_over_breakpoint(pid, tid, address);
+					return;
 				}
 			}
 		}
 	}
+
+	// anything else is the process' own business
+	counted_ptrace(PTRACE_CONT, tid, 0, resume_code(status));
+}
+
+//------------------------------------------------------------------------------
+// Name: release_background
+// Desc: detaches from (or kills) all of the processes we follow in the
+//       background
+//------------------------------------------------------------------------------
+void DebuggerCore::release_background(bool kill) {
+
+	for(processmap_t::const_iterator it = background_.begin(); it != background_.end(); ++it) {
+		if(kill) {
+			::kill(it.key(), SIGKILL);
+			native::waitpid(it.key(), 0, __WALL);
+			continue;
+		}
+
+		// a thread has to be stopped to be detached from
+		Q_FOREACH(edb::tid_t tid, it->threads) {
+			if(seized_) {
+				counted_ptrace(PTRACE_INTERRUPT, tid, 0, 0);
+			} else {
+				syscall(SYS_tgkill, it.key(), tid, SIGSTOP);
+			}
+		}
+
+		Q_FOREACH(edb::tid_t tid, it->threads) {
+			if(native::waitpid(tid, 0, __WALL) > 0) {
+				counted_ptrace(PTRACE_DETACH, tid, 0, 0);
+			}
+		}
+	}
+
+	background_.clear();
 }
 
 //------------------------------------------------------------------------------
@@ -496,10 +1516,24 @@ IDebugEvent::const_pointer DebuggerCore::wait_debug_event(int msecs) {
 
 	if(attached()) {
 		if(!native::wait_for_sigchld(msecs)) {
+
+			// the processes we aren't debugging are kept going right here,
+			// nothing they do is reported
+			Q_FOREACH(edb::pid_t process, background_.keys()) {
+				Q_FOREACH(edb::tid_t thread, background_.value(process).threads) {
+					int status;
+					if(native::waitpid(thread, &status, __WALL | WNOHANG) > 0) {
+						handle_background_event(process, thread, status);
+					}
+				}
+			}
+
 			Q_FOREACH(edb::tid_t thread, thread_ids()) {
 				int status;
 				const edb::tid_t tid = native::waitpid(thread, &status, __WALL | WNOHANG);
 				if(tid > 0) {
+					// another thread may have stopped under the same SIGCHLD
+					requeue_sigchld();
 					return handle_event(tid, status);
 				}
 			}
@@ -518,8 +1552,9 @@ long DebuggerCore::read_data(edb::address_t address, bool *ok) {
 
 	Q_ASSERT(ok);
 
+	// any stopped thread will do, in non-stop mode the main thread may not be
 	errno = 0;
-	const long v = ptrace(PTRACE_PEEKTEXT, pid(), address, 0);
+	const long v = counted_ptrace(PTRACE_PEEKTEXT, active_thread(), address, 0);
 	SET_OK(*ok, v);
 	return v;
 }
@@ -532,32 +1567,108 @@ bool DebuggerCore::read_pages(edb::address_t address, void *buf, std::size_t cou
 
 	const std::size_t len = count * page_size();
 
-	QFile memory_file(QString("/proc/%1/mem").arg(pid_));
-	if(memory_file.open(QIODevice::ReadOnly)) {
+	if(memory_fd_ != -1) {
 
-		memory_file.seek(address);
-		const qint64 n = memory_file.read(reinterpret_cast<char *>(buf), len);
-
-		Q_FOREACH(const IBreakpoint::pointer &bp, breakpoints_) {
-			if(bp->address() >= address && bp->address() < (address + n)) {
-				// show the original bytes in the buffer..
-				reinterpret_cast<quint8 *>(buf)[bp->address() - address] = bp->original_byte();
-			}
+		const ssize_t n = pread64(memory_fd_, buf, len, address);
+		if(n > 0) {
+			mask_breakpoints(address, buf, n);
 		}
-
-		memory_file.close();
 	}
 
 	return true;
 }
 
+//------------------------------------------------------------------------------
+// Name: at_syscall_instruction
+// Desc: returns true if thread <tid> is about to execute a syscall, int 0x80
+//       or sysenter instruction. If we can't tell, we assume that it is
+//------------------------------------------------------------------------------
+bool DebuggerCore::at_syscall_instruction(edb::tid_t tid) {
+
+	if(!process_) {
+		return true;
+	}
+
+	errno = 0;
+#if defined(EDB_X86_64)
+	const edb::address_t ip = counted_ptrace(PTRACE_PEEKUSER, tid, offsetof(struct user, regs.rip), 0);
+#elif defined(EDB_X86)
+	const edb::address_t ip = counted_ptrace(PTRACE_PEEKUSER, tid, offsetof(struct user, regs.eip), 0);
+#endif
+	if(errno != 0) {
+		return true;
+	}
+
+	quint8 insn[2];
+	if(!process_->read_bytes(ip, insn, sizeof(insn))) {
+		return true;
+	}
+
+	return (insn[0] == 0x0f && insn[1] == 0x05) || // syscall
+	       (insn[0] == 0x0f && insn[1] == 0x34) || // sysenter
+	       (insn[0] == 0xcd && insn[1] == 0x80);   // int 0x80
+}
+
+//------------------------------------------------------------------------------
+// Name: memory_map_changed
+// Desc: returns true if the memory map may have changed since the last call
+//------------------------------------------------------------------------------
+bool DebuggerCore::memory_map_changed() {
+	const bool changed = memory_map_changed_;
+	memory_map_changed_ = false;
+	return changed;
+}
+
+//------------------------------------------------------------------------------
+// Name: open_memory_file
+// Desc: (re)opens /proc/<pid>/mem for the current process, it is kept open
+//       for as long as we are attached so reads don't pay for an open/close
+// Note: the file is bound to the address space it was opened for, so this
+//       has to be done again after an exec
+//------------------------------------------------------------------------------
+void DebuggerCore::open_memory_file() {
+
+	close_memory_file();
+
+	char path[64];
+	snprintf(path, sizeof(path), "/proc/%d/mem", static_cast<int>(pid_));
+
+	memory_fd_ = ::open(path, O_RDWR | O_CLOEXEC);
+	if(memory_fd_ == -1) {
+		// we can still read even if we can't write through it
+		memory_fd_ = ::open(path, O_RDONLY | O_CLOEXEC);
+	}
+
+	if(memory_fd_ == -1) {
+		qDebug("[DebuggerCore] failed to open %s: %s", path, strerror(errno));
+	} else {
+		breakpoint_guard_.open(pid_, memory_fd_, page_size());
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: close_memory_file
+// Desc:
+//------------------------------------------------------------------------------
+void DebuggerCore::close_memory_file() {
+
+	// anything still queued would be using it
+	memory_service_.waitForDone();
+	breakpoint_guard_.close();
+
+	if(memory_fd_ != -1) {
+		::close(memory_fd_);
+		memory_fd_ = -1;
+	}
+}
+
 
 //------------------------------------------------------------------------------
 // Name: write_data
 // Desc:
 //------------------------------------------------------------------------------
 bool DebuggerCore::write_data(edb::address_t address, long value) {
-	return ptrace(PTRACE_POKETEXT, pid(), address, value) != -1;
+	return counted_ptrace(PTRACE_POKETEXT, active_thread(), address, value) != -1;
 }
 
 //------------------------------------------------------------------------------
@@ -565,18 +1676,43 @@ bool DebuggerCore::write_data(edb::address_t address, long value) {
 // Desc:
 //------------------------------------------------------------------------------
 bool DebuggerCore::attach_thread(edb::tid_t tid) {
-	if(ptrace(PTRACE_ATTACH, tid, 0, 0) == 0) {
+
+	// PTRACE_SEIZE doesn't send the thread a SIGSTOP which we'd then have to
+	// suppress, and lets us stop threads with PTRACE_INTERRUPT later, so we
+	// use it if the kernel supports it (3.4+). Either all threads of the
+	// process are seized or none are
+	if(seized_) {
+		if(counted_ptrace(PTRACE_SEIZE, tid, 0, trace_options()) == 0) {
+			counted_ptrace(PTRACE_INTERRUPT, tid, 0, 0);
+
+			int status;
+			if(native::waitpid(tid, &status, __WALL) > 0) {
+				const thread_info info = { status, thread_info::THREAD_STOPPED, 0, ++stop_generation_ };
+				threads_[tid] = info;
+				waited_threads_.insert(tid);
+			}
+			return true;
+		}
+
+		if(errno != EIO || !threads_.empty()) {
+			return false;
+		}
+
+		seized_ = false;
+	}
+
+	if(counted_ptrace(PTRACE_ATTACH, tid, 0, 0) == 0) {
 		// I *think* that the PTRACE_O_TRACECLONE is only valid on
 		// on stopped threads
 		int status;
 		if(native::waitpid(tid, &status, __WALL) > 0) {
 
-			const thread_info info = { status, thread_info::THREAD_STOPPED };
+			const thread_info info = { status, thread_info::THREAD_STOPPED, 0, ++stop_generation_ };
 			threads_[tid] = info;
 
 			waited_threads_.insert(tid);
-			if(ptrace_set_options(tid, PTRACE_O_TRACECLONE) == -1) {
-				qDebug("[DebuggerCore] failed to set PTRACE_O_TRACECLONE: [%d] %s", tid, strerror(errno));
+			if(ptrace_set_options(tid, trace_options()) == -1) {
+				qDebug("[DebuggerCore] failed to set PTRACE_SETOPTIONS: [%d] %s", tid, strerror(errno));
 			}
 		}
 		return true;
@@ -591,6 +1727,10 @@ bool DebuggerCore::attach_thread(edb::tid_t tid) {
 bool DebuggerCore::attach(edb::pid_t pid) {
 	detach();
 
+	// attach_thread falls back to PTRACE_ATTACH if seizing isn't supported
+	seized_      = true;
+	follow_fork_ = edb::v1::config().follow_fork;
+
 	bool attached;
 	do {
 		attached = false;
@@ -613,6 +1753,11 @@ bool DebuggerCore::attach(edb::pid_t pid) {
 		event_thread_   = pid;
 		binary_info_    = edb::v1::get_binary_info(edb::v1::primary_code_region());
 		process_        = new PlatformProcess(this, pid);
+		open_memory_file();
+		trace_syscalls_     = edb::v1::config().track_memory_map;
+		non_stop_           = edb::v1::config().non_stop;
+		signal_policies_    = edb::v1::config().signal_policies;
+		memory_map_changed_ = true;
 		return true;
 	}
 
@@ -629,9 +1774,10 @@ void DebuggerCore::detach() {
 		stop_threads();
 
 		clear_breakpoints();
+		release_background(false);
 
 		Q_FOREACH(edb::tid_t thread, thread_ids()) {
-			if(ptrace(PTRACE_DETACH, thread, 0, 0) == 0) {
+			if(counted_ptrace(PTRACE_DETACH, thread, 0, 0) == 0) {
 				native::waitpid(thread, 0, __WALL);
 			}
 		}
@@ -650,8 +1796,9 @@ void DebuggerCore::detach() {
 void DebuggerCore::kill() {
 	if(attached()) {
 		clear_breakpoints();
+		release_background(true);
 
-		ptrace(PTRACE_KILL, pid(), 0, 0);
+		counted_ptrace(PTRACE_KILL, pid(), 0, 0);
 
 		// TODO: do i need to actually do this wait?
 		native::waitpid(pid(), 0, __WALL);
@@ -669,6 +1816,20 @@ void DebuggerCore::kill() {
 //------------------------------------------------------------------------------
 void DebuggerCore::pause() {
 	if(attached()) {
+		// seized threads can simply be interrupted, handle_event stops the rest
+		if(seized_) {
+			pause_requested_ = true;
+			if(counted_ptrace(PTRACE_INTERRUPT, pid(), 0, 0) == -1) {
+				// the main thread may have already exited
+				Q_FOREACH(edb::tid_t tid, thread_ids()) {
+					if(counted_ptrace(PTRACE_INTERRUPT, tid, 0, 0) == 0) {
+						break;
+					}
+				}
+			}
+			return;
+		}
+
 		// belive it or not, I belive that this is sufficient for all threads
 		// this is because in the debug event handler above, a SIGSTOP is sent
 		// to all threads when any event arrives, so no need to explicitly do
@@ -689,12 +1850,12 @@ void DebuggerCore::resume(edb::EVENT_STATUS status) {
 		if(status != edb::DEBUG_STOP) {
 			const edb::tid_t tid = active_thread();
 			const int code = (status == edb::DEBUG_EXCEPTION_NOT_HANDLED) ? resume_code(threads_[tid].status) : 0;
-			ptrace_continue(tid, code);
+			ptrace_resume(tid, code);
 
 			// resume the other threads passing the signal they originally reported had
-			for(threadmap_t::const_iterator it = threads_.begin(); it != threads_.end(); ++it) {
-				if(waited_threads_.contains(it.key())) {
-					ptrace_continue(it.key(), resume_code(it->status));
+			Q_FOREACH(edb::tid_t other, thread_ids()) {
+				if(waited_threads_.contains(other)) {
+					ptrace_resume(other, resume_code(threads_[other].status));
 				}
 			}
 		}
@@ -717,6 +1878,84 @@ void DebuggerCore::step(edb::EVENT_STATUS status) {
 	}
 }
 
+//------------------------------------------------------------------------------
+// Name: step_many
+// Desc: steps the active thread in a loop of our own, the other threads stay
+//       stopped throughout. Only the step which ends it goes through
+//       handle_event, the rest only cost the step and reading the registers
+//------------------------------------------------------------------------------
+bool DebuggerCore::step_many(quint64 count, const CompiledExpression *condition, QVector<edb::address_t> *trace, IDebugEvent::const_pointer *event) {
+
+	Q_ASSERT(event);
+
+	const edb::tid_t tid = active_thread();
+	if(count == 0 || !attached() || !waited_threads_.contains(tid)) {
+		return false;
+	}
+
+	*event = IDebugEvent::const_pointer();
+
+	// a breakpoint we are sitting on is stepped past just like the UI would
+	IBreakpoint::pointer bp = find_breakpoint(fetch_state(tid, PlatformState::GROUP_GPR).instruction_pointer());
+	if(bp && bp->enabled()) {
+		bp->disable();
+	} else {
+		bp = IBreakpoint::pointer();
+	}
+
+	for(quint64 i = 0; i < count; ++i) {
+
+		if(trace) {
+			trace->push_back(fetch_state(tid, PlatformState::GROUP_GPR).instruction_pointer());
+		}
+
+		ptrace_step(tid, 0);
+
+		int status;
+		const bool stepped = native::waitpid(tid, &status, __WALL) > 0;
+
+		if(bp) {
+			bp->enable();
+			bp = IBreakpoint::pointer();
+		}
+
+		if(!stepped) {
+			return true;
+		}
+
+		bool last = (i + 1 == count) || !WIFSTOPPED(status) || WSTOPSIG(status) != SIGTRAP || (status >> 16) != 0;
+
+		if(!last) {
+			waited_threads_.insert(tid);
+			threads_[tid].status = status;
+
+			const PlatformState &regs = fetch_state(tid, PlatformState::GROUP_GPR);
+
+			// stop on a breakpoint before it is executed, the same place
+			// running into it leaves us
+			if(IBreakpoint::pointer next = find_breakpoint(regs.instruction_pointer())) {
+				last = next->enabled();
+			}
+
+			if(!last && condition) {
+				State state;
+				*static_cast<PlatformState *>(state.detach()) = regs;
+
+				edb::address_t value;
+				ExpressionError err;
+				last = !condition->evaluate(state, &value, &err) || value != 0;
+			}
+		}
+
+		if(last) {
+			*event = handle_event(tid, status);
+			return true;
+		}
+	}
+
+	return true;
+}
+
 //------------------------------------------------------------------------------
 // Name: get_state
 // Desc:
@@ -724,46 +1963,184 @@ void DebuggerCore::step(edb::EVENT_STATUS status) {
 void DebuggerCore::get_state(State *state) {
 	// TODO: assert that we are paused
 
-	if(PlatformState *const state_impl = static_cast<PlatformState *>(state->impl_)) {
+	if(PlatformState *const state_impl = static_cast<PlatformState *>(state->detach())) {
 		if(attached()) {
-			if(ptrace(PTRACE_GETREGS, active_thread(), 0, &state_impl->regs_) != -1) {
-			#if defined(EDB_X86)
-				struct user_desc desc;
-				std::memset(&desc, 0, sizeof(desc));
-
-				if(ptrace(PTRACE_GET_THREAD_AREA, active_thread(), (state_impl->regs_.xgs / LDT_ENTRY_SIZE), &desc) != -1) {
-					state_impl->gs_base = desc.base_addr;
-				} else {
-					state_impl->gs_base = 0;
-				}
+			// only the general purpose registers are needed up front, and
+			// if we've already read them during this stop, that's free too
+			*state_impl = fetch_state(active_thread(), PlatformState::GROUP_GPR);
+		} else {
+			state_impl->clear();
+		}
+	}
+}
 
-				if(ptrace(PTRACE_GET_THREAD_AREA, active_thread(), (state_impl->regs_.xfs / LDT_ENTRY_SIZE), &desc) != -1) {
-					state_impl->fs_base = desc.base_addr;
-				} else {
-					state_impl->fs_base = 0;
-				}
-			#elif defined(EDB_X86_64)
-			#endif
-			}
+//------------------------------------------------------------------------------
+// Name: get_thread_state
+// Desc: the registers of any stopped thread, without making it the active one.
+//       They come from the same per-stop cache as get_state
+//------------------------------------------------------------------------------
+bool DebuggerCore::get_thread_state(edb::tid_t tid, State *state) {
 
-			// floating point registers
-			if(ptrace(PTRACE_GETFPREGS, active_thread(), 0, &state_impl->fpregs_) != -1) {
-			}
+	if(!attached() || !waited_threads_.contains(tid)) {
+		return false;
+	}
+
+	if(PlatformState *const state_impl = static_cast<PlatformState *>(state->detach())) {
+		*state_impl = fetch_state(tid, PlatformState::GROUP_GPR);
+	}
+
+	return true;
+}
+
+//------------------------------------------------------------------------------
+// Name: fetch_state
+// Desc: makes sure that the per-stop cache holds <groups> for thread <tid>
+//       and returns its entry, which stays where it is until the cache is
+//       next added to
+//------------------------------------------------------------------------------
+PlatformState &DebuggerCore::fetch_state(edb::tid_t tid, quint32 groups) {
 
-			// debug registers
-			state_impl->dr_[0] = ptrace(PTRACE_PEEKUSER, active_thread(), offsetof(struct user, u_debugreg[0]), 0);
-			state_impl->dr_[1] = ptrace(PTRACE_PEEKUSER, active_thread(), offsetof(struct user, u_debugreg[1]), 0);
-			state_impl->dr_[2] = ptrace(PTRACE_PEEKUSER, active_thread(), offsetof(struct user, u_debugreg[2]), 0);
-			state_impl->dr_[3] = ptrace(PTRACE_PEEKUSER, active_thread(), offsetof(struct user, u_debugreg[3]), 0);
-			state_impl->dr_[4] = 0;
-			state_impl->dr_[5] = 0;
-			state_impl->dr_[6] = ptrace(PTRACE_PEEKUSER, active_thread(), offsetof(struct user, u_debugreg[6]), 0);
-			state_impl->dr_[7] = ptrace(PTRACE_PEEKUSER, active_thread(), offsetof(struct user, u_debugreg[7]), 0);
+	const quint64 generation = thread_generation(tid);
 
+	// nothing survives the thread running
+	statemap_t::iterator it = stop_states_.find(tid);
+	if(it != stop_states_.end() && it->generation_ != generation) {
+		stop_states_.erase(it);
+		it = stop_states_.end();
+	}
+
+	if(it == stop_states_.end()) {
+		PlatformState state;
+		state.clear();
+		state.core_       = this;
+		state.tid_        = tid;
+		state.generation_ = generation;
+		state.loaded_     = 0;
+		it = stop_states_.insert(tid, state);
+	}
+
+	PlatformState &state = it.value();
+
+#if defined(EDB_X86)
+	// the segment bases are looked up using the selectors
+	if(groups & PlatformState::GROUP_SEGMENT_BASE) {
+		groups |= PlatformState::GROUP_GPR;
+	}
+#elif defined(EDB_X86_64)
+	// these are part of user_regs_struct
+	if(groups & PlatformState::GROUP_SEGMENT_BASE) {
+		groups = (groups & ~PlatformState::GROUP_SEGMENT_BASE) | PlatformState::GROUP_GPR;
+		state.loaded_ |= PlatformState::GROUP_SEGMENT_BASE;
+	}
+#endif
+
+	const quint32 missing = groups & ~state.loaded_;
+
+	if(missing & PlatformState::GROUP_GPR) {
+		if(counted_ptrace(PTRACE_GETREGS, tid, 0, &state.regs_) == -1) {
+			std::memset(&state.regs_, 0, sizeof(state.regs_));
+		}
+	}
+
+#if defined(EDB_X86)
+	if(missing & PlatformState::GROUP_SEGMENT_BASE) {
+		struct user_desc desc;
+		std::memset(&desc, 0, sizeof(desc));
+
+		if(counted_ptrace(PTRACE_GET_THREAD_AREA, tid, (state.regs_.xgs / LDT_ENTRY_SIZE), &desc) != -1) {
+			state.gs_base = desc.base_addr;
 		} else {
-			state_impl->clear();
+			state.gs_base = 0;
+		}
+
+		if(counted_ptrace(PTRACE_GET_THREAD_AREA, tid, (state.regs_.xfs / LDT_ENTRY_SIZE), &desc) != -1) {
+			state.fs_base = desc.base_addr;
+		} else {
+			state.fs_base = 0;
+		}
+	}
+#endif
+
+	// floating point registers
+	if(missing & PlatformState::GROUP_FPU) {
+		if(counted_ptrace(PTRACE_GETFPREGS, tid, 0, &state.fpregs_) == -1) {
+			std::memset(&state.fpregs_, 0, sizeof(state.fpregs_));
+		}
+	}
+
+	// debug registers
+	if(missing & PlatformState::GROUP_DEBUG) {
+		state.dr_[0] = counted_ptrace(PTRACE_PEEKUSER, tid, offsetof(struct user, u_debugreg[0]), 0);
+		state.dr_[1] = counted_ptrace(PTRACE_PEEKUSER, tid, offsetof(struct user, u_debugreg[1]), 0);
+		state.dr_[2] = counted_ptrace(PTRACE_PEEKUSER, tid, offsetof(struct user, u_debugreg[2]), 0);
+		state.dr_[3] = counted_ptrace(PTRACE_PEEKUSER, tid, offsetof(struct user, u_debugreg[3]), 0);
+		state.dr_[4] = 0;
+		state.dr_[5] = 0;
+		state.dr_[6] = counted_ptrace(PTRACE_PEEKUSER, tid, offsetof(struct user, u_debugreg[6]), 0);
+		state.dr_[7] = counted_ptrace(PTRACE_PEEKUSER, tid, offsetof(struct user, u_debugreg[7]), 0);
+	}
+
+	// AVX and friends, one GETREGSET gets all of the XSAVE components
+	if(missing & PlatformState::GROUP_XSTATE) {
+		state.xstate_.clear();
+
+		if(const std::size_t size = PlatformState::xstate_size()) {
+			QByteArray buffer(static_cast<int>(size), 0);
+
+			struct iovec iov;
+			iov.iov_base = buffer.data();
+			iov.iov_len  = size;
+
+			if(counted_ptrace(PTRACE_GETREGSET, tid, NT_X86_XSTATE, &iov) != -1) {
+				buffer.resize(static_cast<int>(iov.iov_len));
+				state.xstate_ = buffer;
+			}
 		}
 	}
+
+	state.loaded_ |= missing;
+	return state;
+}
+
+//------------------------------------------------------------------------------
+// Name: load_state
+// Desc: fills in the lazily loaded <groups> of <state>, this is a no-op if
+//       the thread has run since the state was captured
+//------------------------------------------------------------------------------
+void DebuggerCore::load_state(PlatformState *state, quint32 groups) {
+
+	if(!attached() || !threads_.contains(state->tid_) || state->generation_ != thread_generation(state->tid_)) {
+		return;
+	}
+
+	const PlatformState &cached = fetch_state(state->tid_, groups);
+
+	if(state == &cached) {
+		return;
+	}
+
+	if(groups & PlatformState::GROUP_GPR) {
+		state->regs_ = cached.regs_;
+	}
+
+#if defined(EDB_X86)
+	if(groups & PlatformState::GROUP_SEGMENT_BASE) {
+		state->fs_base = cached.fs_base;
+		state->gs_base = cached.gs_base;
+	}
+#endif
+
+	if(groups & PlatformState::GROUP_FPU) {
+		state->fpregs_ = cached.fpregs_;
+	}
+
+	if(groups & PlatformState::GROUP_DEBUG) {
+		std::memcpy(state->dr_, cached.dr_, sizeof(state->dr_));
+	}
+
+	if(groups & PlatformState::GROUP_XSTATE) {
+		state->xstate_ = cached.xstate_;
+	}
 }
 
 //------------------------------------------------------------------------------
@@ -778,17 +2155,60 @@ void DebuggerCore::set_state(const State &state) {
 	if(attached()) {
 
 		if(PlatformState *const state_impl = static_cast<PlatformState *>(state.impl_)) {
-			ptrace(PTRACE_SETREGS, active_thread(), 0, &state_impl->regs_);
+			const edb::tid_t tid = active_thread();
+
+			const quint64 generation = thread_generation(tid);
+			const statemap_t::iterator cached = stop_states_.find(tid);
+			const bool cache_valid = cached != stop_states_.end() && cached->generation_ == generation;
+
+			// a state captured at another stop (or for another thread) may
+			// differ from the thread in any group we have for it
+			quint32 dirty = state_impl->dirty_;
+			if(state_impl->tid_ != tid || state_impl->generation_ != generation) {
+				dirty = state_impl->loaded_ & (PlatformState::GROUP_GPR | PlatformState::GROUP_FPU | PlatformState::GROUP_DEBUG);
+			}
+
+			if(dirty & PlatformState::GROUP_GPR) {
+				counted_ptrace(PTRACE_SETREGS, tid, 0, &state_impl->regs_);
+			}
+
+			if(dirty & PlatformState::GROUP_FPU) {
+				counted_ptrace(PTRACE_SETFPREGS, tid, 0, &state_impl->fpregs_);
+			}
+
+			if(dirty & PlatformState::GROUP_DEBUG) {
+				// DR4 and DR5 are aliases of DR6 and DR7, so skip them, and
+				// don't rewrite the ones we know haven't changed
+				static const int writable[] = { 0, 1, 2, 3, 6, 7 };
+				const bool known = cache_valid && (cached->loaded_ & PlatformState::GROUP_DEBUG);
+
+				for(std::size_t i = 0; i < sizeof(writable) / sizeof(writable[0]); ++i) {
+					const int n = writable[i];
+					if(!known || cached->dr_[n] != state_impl->dr_[n]) {
+						counted_ptrace(PTRACE_POKEUSER, tid, offsetof(struct user, u_debugreg) + n * sizeof(static_cast<struct user *>(0)->u_debugreg[0]), state_impl->dr_[n]);
+					}
+				}
+			}
 
-			// debug registers
-			ptrace(PTRACE_POKEUSER, active_thread(), offsetof(struct user, u_debugreg[0]), state_impl->dr_[0]);
-			ptrace(PTRACE_POKEUSER, active_thread(), offsetof(struct user, u_debugreg[1]), state_impl->dr_[1]);
-			ptrace(PTRACE_POKEUSER, active_thread(), offsetof(struct user, u_debugreg[2]), state_impl->dr_[2]);
-			ptrace(PTRACE_POKEUSER, active_thread(), offsetof(struct user, u_debugreg[3]), state_impl->dr_[3]);
-			//ptrace(PTRACE_POKEUSER, active_thread(), offsetof(struct user, u_debugreg[4]), state_impl->dr_[4]);
-			//ptrace(PTRACE_POKEUSER, active_thread(), offsetof(struct user, u_debugreg[5]), state_impl->dr_[5]);
-			ptrace(PTRACE_POKEUSER, active_thread(), offsetof(struct user, u_debugreg[6]), state_impl->dr_[6]);
-			ptrace(PTRACE_POKEUSER, active_thread(), offsetof(struct user, u_debugreg[7]), state_impl->dr_[7]);
+			// keep the per-stop cache in sync with what we just wrote
+			if(cache_valid) {
+				if(dirty & PlatformState::GROUP_GPR) {
+					cached->regs_ = state_impl->regs_;
+				}
+
+				if(dirty & PlatformState::GROUP_FPU) {
+					cached->fpregs_  = state_impl->fpregs_;
+					cached->loaded_ |= PlatformState::GROUP_FPU;
+				}
+
+				if(dirty & PlatformState::GROUP_DEBUG) {
+					std::memcpy(cached->dr_, state_impl->dr_, sizeof(cached->dr_));
+					cached->loaded_ |= PlatformState::GROUP_DEBUG;
+				}
+			}
+
+			// the thread now matches the state
+			state_impl->dirty_ = 0;
 		}
 	}
 }
@@ -846,8 +2266,10 @@ bool DebuggerCore::open(const QString &path, const QString &cwd, const QList<QBy
 
 			waited_threads_.insert(pid);
 
-			// enable following clones (threads)
-			if(ptrace_set_options(pid, PTRACE_O_TRACECLONE) == -1) {
+			// enable following clones (threads), forks if asked to, and tell
+			// us about exec
+			follow_fork_ = edb::v1::config().follow_fork;
+			if(ptrace_set_options(pid, trace_options()) == -1) {
 				qDebug("[DebuggerCore] failed to set PTRACE_SETOPTIONS: %s", strerror(errno));
 				detach();
 				return false;
@@ -856,7 +2278,7 @@ bool DebuggerCore::open(const QString &path, const QString &cwd, const QList<QBy
 			// setup the first event data for the primary thread
 			waited_threads_.insert(pid);
 
-			const thread_info info = { status, thread_info::THREAD_STOPPED };
+			const thread_info info = { status, thread_info::THREAD_STOPPED, 0, ++stop_generation_ };
 			threads_[pid]   = info;
 
 			pid_            = pid;
@@ -865,6 +2287,11 @@ bool DebuggerCore::open(const QString &path, const QString &cwd, const QList<QBy
 			binary_info_    = edb::v1::get_binary_info(edb::v1::primary_code_region());
 
 			process_ = new PlatformProcess(this, pid);
+			open_memory_file();
+			trace_syscalls_     = edb::v1::config().track_memory_map;
+			non_stop_           = edb::v1::config().non_stop;
+			signal_policies_    = edb::v1::config().signal_policies;
+			memory_map_changed_ = true;
 
 			return true;
 		} while(0);
@@ -878,11 +2305,9 @@ bool DebuggerCore::open(const QString &path, const QString &cwd, const QList<QBy
 //------------------------------------------------------------------------------
 void DebuggerCore::set_active_thread(edb::tid_t tid) {
 	if(threads_.contains(tid)) {
-#if 0
+		// the registers of whichever threads were looked at are kept until
+		// something runs, so this costs nothing
 		active_thread_ = tid;
-#else
-		qDebug("[DebuggerCore::set_active_thread] not implemented yet");
-#endif
 	} else {
 		qDebug("[DebuggerCore] warning, attempted to set invalid thread as active: %d", tid);
 	}
@@ -900,6 +2325,445 @@ void DebuggerCore::reset() {
 	event_thread_  = 0;
 	delete binary_info_;
 	binary_info_   = 0;
+	close_memory_file();
+	stop_states_.clear();
+	++stop_generation_;
+	seized_          = false;
+	pause_requested_ = false;
+	non_stop_        = false;
+	follow_fork_     = false;
+	signal_policies_.clear();
+	background_.clear();
+	branch_tracer_.stop();
+	syscall_tracer_.stop();
+	profile_sampler_.stop();
+	counter_set_.stop();
+	overwritten_breakpoints_.clear();
+	std::memset(&debug_registers_, 0, sizeof(debug_registers_));
+	debug_generation_ = 0;
+}
+
+//------------------------------------------------------------------------------
+// Name: set_debug_registers
+// Desc: nothing is written here, each thread picks the new registers up when
+//       it is next resumed, and setting the same ones again costs nothing
+//------------------------------------------------------------------------------
+bool DebuggerCore::set_debug_registers(const DebugRegisters &registers) {
+	if(std::memcmp(&registers, &debug_registers_, sizeof(registers)) != 0) {
+		debug_registers_ = registers;
+		++debug_generation_;
+	}
+	return true;
+}
+
+//------------------------------------------------------------------------------
+// Name: inject_syscall
+// Desc: makes the stopped active thread perform a system call by putting a
+//       syscall instruction where it is and stepping it, then puts the code
+//       and the registers back. Nothing else runs, and it is all done before
+//       this returns, no debug events are involved
+//------------------------------------------------------------------------------
+bool DebuggerCore::inject_syscall(long number, const edb::reg_t (&args)[6], edb::reg_t *result) {
+
+	if(!attached()) {
+		return false;
+	}
+
+	const edb::tid_t tid = active_thread();
+
+	struct user_regs_struct saved;
+	if(counted_ptrace(PTRACE_GETREGS, tid, 0, &saved) == -1) {
+		return false;
+	}
+
+#if defined(EDB_X86)
+	static const quint8 syscall_instruction[] = { 0xcd, 0x80 }; // int $0x80
+	const edb::address_t ip = saved.eip;
+#elif defined(EDB_X86_64)
+	static const quint8 syscall_instruction[] = { 0x0f, 0x05 }; // syscall
+	const edb::address_t ip = saved.rip;
+#endif
+
+	errno = 0;
+	const long code = counted_ptrace(PTRACE_PEEKTEXT, tid, ip, 0);
+	if(errno != 0) {
+		return false;
+	}
+
+	long patched = code;
+	std::memcpy(&patched, syscall_instruction, sizeof(syscall_instruction));
+
+	// orig_eax/orig_rax of -1 keeps the kernel from treating the thread as
+	// being in the middle of a syscall it should restart
+	struct user_regs_struct regs = saved;
+#if defined(EDB_X86)
+	regs.orig_eax = -1;
+	regs.eax = number;
+	regs.ebx = args[0];
+	regs.ecx = args[1];
+	regs.edx = args[2];
+	regs.esi = args[3];
+	regs.edi = args[4];
+	regs.ebp = args[5];
+#elif defined(EDB_X86_64)
+	regs.orig_rax = -1;
+	regs.rax = number;
+	regs.rdi = args[0];
+	regs.rsi = args[1];
+	regs.rdx = args[2];
+	regs.r10 = args[3];
+	regs.r8  = args[4];
+	regs.r9  = args[5];
+#endif
+
+	bool ok = false;
+	int pending_signal = 0;
+
+	if(counted_ptrace(PTRACE_POKETEXT, tid, ip, patched) != -1 && counted_ptrace(PTRACE_SETREGS, tid, 0, &regs) != -1) {
+
+		// a signal can arrive before the step completes, it is held back and
+		// sent again once the thread is back the way it was
+		while(counted_ptrace(PTRACE_SINGLESTEP, tid, 0, 0) != -1) {
+			int status;
+			if(native::waitpid(tid, &status, __WALL) == -1 || !WIFSTOPPED(status)) {
+				break;
+			}
+
+			if(counted_ptrace(PTRACE_GETREGS, tid, 0, &regs) == -1) {
+				break;
+			}
+
+#if defined(EDB_X86)
+			const bool done = regs.eip != ip;
+#elif defined(EDB_X86_64)
+			const bool done = regs.rip != ip;
+#endif
+			if(WSTOPSIG(status) != SIGTRAP) {
+				pending_signal = WSTOPSIG(status);
+			}
+
+			if(done) {
+#if defined(EDB_X86)
+				*result = regs.eax;
+#elif defined(EDB_X86_64)
+				*result = regs.rax;
+#endif
+				ok = true;
+				break;
+			}
+		}
+	}
+
+	counted_ptrace(PTRACE_POKETEXT, tid, ip, code);
+	counted_ptrace(PTRACE_SETREGS, tid, 0, &saved);
+
+	if(pending_signal != 0) {
+		syscall(SYS_tgkill, pid(), tid, pending_signal);
+	}
+
+	return ok;
+}
+
+//------------------------------------------------------------------------------
+// Name: set_page_permissions
+// Desc: mprotect, run by the active thread
+//------------------------------------------------------------------------------
+bool DebuggerCore::set_page_permissions(edb::address_t address, edb::address_t size, bool read, bool write, bool execute) {
+
+	const edb::reg_t prot = (read ? PROT_READ : 0) | (write ? PROT_WRITE : 0) | (execute ? PROT_EXEC : 0);
+
+	const edb::reg_t args[6] = { address, size, prot, 0, 0, 0 };
+
+	edb::reg_t result;
+	if(!inject_syscall(__NR_mprotect, args, &result) || result != 0) {
+		return false;
+	}
+
+	memory_map_changed_ = true;
+	return true;
+}
+
+//------------------------------------------------------------------------------
+// Name: allocate_memory
+// Desc: an anonymous mmap, run by the active thread. Without MAP_FIXED the
+//       kernel only takes the hint if nothing is there
+//------------------------------------------------------------------------------
+edb::address_t DebuggerCore::allocate_memory(edb::address_t hint, edb::address_t size) {
+
+	const edb::reg_t prot = PROT_READ | PROT_WRITE | PROT_EXEC;
+	const edb::reg_t args[6] = { hint & ~(page_size() - 1), size, prot, MAP_PRIVATE | MAP_ANONYMOUS, static_cast<edb::reg_t>(-1), 0 };
+
+#if defined(EDB_X86)
+	const long number = __NR_mmap2;
+#elif defined(EDB_X86_64)
+	const long number = __NR_mmap;
+#endif
+
+	// the kernel returns errors as -errno, which no mapping can start at
+	edb::reg_t result;
+	if(!inject_syscall(number, args, &result) || result > static_cast<edb::reg_t>(-4096)) {
+		return 0;
+	}
+
+	memory_map_changed_ = true;
+	return result;
+}
+
+//------------------------------------------------------------------------------
+// Name: apply_debug_registers
+// Desc: writes debug_registers_ to <tid> if it has an older generation
+// Note: DR7 is cleared first, every enabled breakpoint must have a valid
+//       address at all times or the kernel rejects the write
+//------------------------------------------------------------------------------
+void DebuggerCore::apply_debug_registers(edb::tid_t tid) {
+
+	threadmap_t::iterator it = threads_.find(tid);
+	if(it == threads_.end() || it->debug_generation == debug_generation_) {
+		return;
+	}
+
+	const std::size_t dr0 = offsetof(struct user, u_debugreg);
+	const std::size_t dr7 = dr0 + 7 * sizeof(static_cast<struct user *>(0)->u_debugreg[0]);
+
+	counted_ptrace(PTRACE_POKEUSER, tid, dr7, 0);
+
+	if(debug_registers_.control != 0) {
+		for(int n = 0; n < 4; ++n) {
+			counted_ptrace(PTRACE_POKEUSER, tid, dr0 + n * sizeof(static_cast<struct user *>(0)->u_debugreg[0]), debug_registers_.address[n]);
+		}
+		counted_ptrace(PTRACE_POKEUSER, tid, dr7, debug_registers_.control);
+	}
+
+	it->debug_generation = debug_generation_;
+}
+
+//------------------------------------------------------------------------------
+// Name: start_branch_trace
+// Desc: starts recording the branches that the active thread takes
+//------------------------------------------------------------------------------
+bool DebuggerCore::start_branch_trace() {
+	return attached() && branch_tracer_.start(active_thread(), page_size());
+}
+
+//------------------------------------------------------------------------------
+// Name: stop_branch_trace
+// Desc:
+//------------------------------------------------------------------------------
+void DebuggerCore::stop_branch_trace() {
+	branch_tracer_.stop();
+}
+
+//------------------------------------------------------------------------------
+// Name: branch_trace
+// Desc: returns the branches recorded since the last call
+//------------------------------------------------------------------------------
+QVector<BranchRecord> DebuggerCore::branch_trace(quint64 *lost) {
+	branch_tracer_.collect();
+	return branch_tracer_.take(lost);
+}
+
+//------------------------------------------------------------------------------
+// Name: start_syscall_trace
+// Desc: threads stop at each syscall from when they are next resumed, the
+//       stops are dealt with in handle_event and never reach the UI
+//------------------------------------------------------------------------------
+bool DebuggerCore::start_syscall_trace(const QList<edb::reg_t> &numbers, int capacity) {
+	if(!attached()) {
+		return false;
+	}
+
+	syscall_tracer_.start(numbers, capacity);
+	return true;
+}
+
+//------------------------------------------------------------------------------
+// Name: stop_syscall_trace
+// Desc:
+//------------------------------------------------------------------------------
+void DebuggerCore::stop_syscall_trace() {
+	syscall_tracer_.stop();
+}
+
+//------------------------------------------------------------------------------
+// Name: syscall_trace
+// Desc:
+//------------------------------------------------------------------------------
+QVector<SyscallRecord> DebuggerCore::syscall_trace(quint64 *lost) {
+	return syscall_tracer_.records(lost);
+}
+
+//------------------------------------------------------------------------------
+// Name: start_profile
+// Desc: samples every thread, including ones created from now on
+//------------------------------------------------------------------------------
+bool DebuggerCore::start_profile(int frequency) {
+	return attached() && profile_sampler_.start(threads_.keys(), frequency, page_size());
+}
+
+//------------------------------------------------------------------------------
+// Name: stop_profile
+// Desc:
+//------------------------------------------------------------------------------
+void DebuggerCore::stop_profile() {
+	profile_sampler_.stop();
+}
+
+//------------------------------------------------------------------------------
+// Name: profile_samples
+// Desc: returns the samples recorded since the last call
+//------------------------------------------------------------------------------
+QVector<ProfileSample> DebuggerCore::profile_samples(quint64 *lost) {
+	profile_sampler_.collect();
+	return profile_sampler_.take(lost);
+}
+
+//------------------------------------------------------------------------------
+// Name: start_counters
+// Desc: counts every thread, including ones created from now on
+//------------------------------------------------------------------------------
+bool DebuggerCore::start_counters() {
+	return attached() && counter_set_.start(threads_.keys());
+}
+
+//------------------------------------------------------------------------------
+// Name: stop_counters
+// Desc:
+//------------------------------------------------------------------------------
+void DebuggerCore::stop_counters() {
+	counter_set_.stop();
+}
+
+//------------------------------------------------------------------------------
+// Name: read_counters
+// Desc:
+//------------------------------------------------------------------------------
+bool DebuggerCore::read_counters(PerformanceCounters *counters) {
+
+	Q_ASSERT(counters);
+
+	if(!counter_set_.running()) {
+		return false;
+	}
+
+	*counters = counter_set_.read();
+	return true;
+}
+
+//------------------------------------------------------------------------------
+// Name: check_breakpoints
+// Desc: puts back the int3 of each breakpoint the process wrote over, what it
+//       wrote becomes the byte the breakpoint hides
+//------------------------------------------------------------------------------
+void DebuggerCore::check_breakpoints() {
+
+	const QHash<edb::address_t, quint8> overwritten = breakpoint_guard_.check(breakpoints_);
+
+	for(QHash<edb::address_t, quint8>::const_iterator it = overwritten.begin(); it != overwritten.end(); ++it) {
+		if(const IBreakpoint::pointer bp = breakpoints_.value(it.key())) {
+			// every breakpoint in the list is one of ours
+			if(static_cast<Breakpoint *>(bp.data())->reinsert(it.value())) {
+				overwritten_breakpoints_.push_back(it.key());
+			}
+		}
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: guard_breakpoints
+// Desc: called whenever a thread is about to run, the stop which is ending
+//       is checked if nobody asked yet, and the guard is armed for the next
+//------------------------------------------------------------------------------
+void DebuggerCore::guard_breakpoints() {
+	check_breakpoints();
+	breakpoint_guard_.arm(breakpoints_);
+}
+
+//------------------------------------------------------------------------------
+// Name: overwritten_breakpoints
+// Desc:
+//------------------------------------------------------------------------------
+QList<edb::address_t> DebuggerCore::overwritten_breakpoints() {
+
+	check_breakpoints();
+
+	QList<edb::address_t> addresses;
+	addresses.swap(overwritten_breakpoints_);
+	return addresses;
+}
+
+//------------------------------------------------------------------------------
+// Name: memory_usage
+// Desc: smaps lists the mappings in address order and the kernel only works
+//       out each one as it is read, so reading stops at the last one wanted
+//------------------------------------------------------------------------------
+QHash<edb::address_t, MemoryUsage> DebuggerCore::memory_usage(const QList<edb::address_t> &starts) {
+
+	QHash<edb::address_t, MemoryUsage> usage;
+
+	if(!attached() || starts.isEmpty()) {
+		return usage;
+	}
+
+	QFile file(QString("/proc/%1/smaps").arg(pid_));
+	if(!file.open(QIODevice::ReadOnly)) {
+		return usage;
+	}
+
+	const QSet<edb::address_t> wanted = starts.toSet();
+	const edb::address_t       last   = *std::max_element(starts.begin(), starts.end());
+
+	MemoryUsage *current = 0;
+	char line[4096];
+	while(file.readLine(line, sizeof(line)) > 0) {
+
+		// each mapping starts with its address range, the fields follow
+		char *end;
+		const edb::address_t start = std::strtoull(line, &end, 16);
+		if(end != line && *end == '-') {
+			if(start > last) {
+				break;
+			}
+
+			current = 0;
+			if(wanted.contains(start)) {
+				current = &usage[start];
+				current->resident     = 0;
+				current->proportional = 0;
+			}
+		} else if(current) {
+			smaps_usage(line, current);
+		}
+	}
+
+	return usage;
+}
+
+//------------------------------------------------------------------------------
+// Name: total_memory_usage
+// Desc: smaps_rollup has every mapping added up already
+//------------------------------------------------------------------------------
+bool DebuggerCore::total_memory_usage(MemoryUsage *usage) {
+
+	Q_ASSERT(usage);
+
+	if(!attached()) {
+		return false;
+	}
+
+	QFile file(QString("/proc/%1/smaps_rollup").arg(pid_));
+	if(!file.open(QIODevice::ReadOnly)) {
+		return false;
+	}
+
+	usage->resident     = 0;
+	usage->proportional = 0;
+
+	char line[4096];
+	while(file.readLine(line, sizeof(line)) > 0) {
+		smaps_usage(line, usage);
+	}
+
+	return true;
 }
 
 //------------------------------------------------------------------------------
@@ -915,38 +2779,78 @@ IState *DebuggerCore::create_state() const {
 // Desc:
 //------------------------------------------------------------------------------
 QMap<edb::pid_t, ProcessInfo> DebuggerCore::enumerate_processes() const {
-	QMap<edb::pid_t, ProcessInfo> ret;
+	CollectProcesses collect;
+	stream_processes(&collect);
+	return collect.result;
+}
 
-	QDir proc_directory("/proc/");
-	QFileInfoList entries = proc_directory.entryInfoList(QDir::Dirs | QDir::NoDotAndDotDot);
+//------------------------------------------------------------------------------
+// Name: stream_processes
+// Desc: walks /proc with getdents64 and hands the processes to <sink> a batch
+//       at a time. Only pids which weren't there last time are looked at, the
+//       rest come from the list kept from then, so a refresh costs a stat and
+//       a read of /proc/<pid>/stat per new process and nothing per old one
+//------------------------------------------------------------------------------
+void DebuggerCore::stream_processes(ProcessSink *sink) const {
 
-	Q_FOREACH(const QFileInfo &info, entries) {
-		const QString filename = info.fileName();
-		if(is_numeric(filename)) {
+	Q_ASSERT(sink);
 
-			const edb::pid_t pid = filename.toULong();
-			ProcessInfo process_info;
+	static const int BATCH_SIZE = 512;
 
-			struct user_stat user_stat;
-			const int n = get_user_stat(pid, &user_stat);
-			if(n >= 2) {
-				process_info.name = user_stat.comm;
-			}
+	const int fd = ::open("/proc", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+	if(fd == -1) {
+		return;
+	}
 
-			process_info.pid = pid;
-			process_info.uid = info.ownerId();
+	const QVector<edb::pid_t> pids = read_pids(fd);
 
-			if(const struct passwd *const pwd = ::getpwuid(process_info.uid)) {
-				process_info.user = pwd->pw_name;
-			}
+	// this may be running on a thread of its own
+	QMutexLocker locker(&process_list_lock_);
+
+	QMap<edb::pid_t, ProcessInfo> processes;
+	QList<ProcessInfo>            batch;
+	bool                          stopped = false;
+
+	Q_FOREACH(edb::pid_t pid, pids) {
+
+		QMap<edb::pid_t, ProcessInfo>::const_iterator it = process_list_.find(pid);
+
+		ProcessInfo info;
+		if(it != process_list_.end()) {
+			info = it.value();
+		} else if(read_process(fd, pid, &info)) {
+			info.user = user_name(info.uid, &user_names_);
+		} else {
+			continue;
+		}
+
+		processes.insert(pid, info);
+		batch.push_back(info);
 
-			ret.insert(process_info.pid, process_info);
+		if(batch.size() == BATCH_SIZE) {
+			if(!sink->found(batch)) {
+				stopped = true;
+				break;
+			}
+			batch.clear();
 		}
 	}
 
-	return ret;
-}
+	::close(fd);
 
+	if(!stopped) {
+		if(!batch.isEmpty()) {
+			sink->found(batch);
+		}
+
+		// the pids which are gone are forgotten along with the old list
+		process_list_ = processes;
+	} else {
+		// what was read is still worth keeping for next time, but whatever
+		// wasn't walked can't be told to be gone yet
+		process_list_.unite(processes);
+	}
+}
 
 //------------------------------------------------------------------------------
 // Name:
@@ -963,6 +2867,142 @@ edb::pid_t DebuggerCore::parent_pid(edb::pid_t pid) const {
 	return 0;
 }
 
+//------------------------------------------------------------------------------
+// Name: traced_processes
+// Desc:
+//------------------------------------------------------------------------------
+QList<edb::pid_t> DebuggerCore::traced_processes() const {
+	QList<edb::pid_t> processes;
+	if(attached()) {
+		processes.push_back(pid());
+		processes.append(background_.keys());
+	}
+	return processes;
+}
+
+//------------------------------------------------------------------------------
+// Name: select_process
+// Desc: makes <target> the process we debug, the current one is left to run
+//       in the background. Our breakpoints move along with the selection
+//------------------------------------------------------------------------------
+bool DebuggerCore::select_process(edb::pid_t target) {
+
+	if(!attached() || !background_.contains(target)) {
+		return false;
+	}
+
+	// stop all of it in parallel, the way stop_threads does
+	background_process next = background_.take(target);
+
+	Q_FOREACH(edb::tid_t tid, next.threads) {
+		if(seized_) {
+			counted_ptrace(PTRACE_INTERRUPT, tid, 0, 0);
+		} else {
+			syscall(SYS_tgkill, target, tid, SIGSTOP);
+		}
+	}
+
+	QList<edb::tid_t> stopping = next.threads.toList();
+	QHash<edb::tid_t, int> stopped;
+	while(!stopping.isEmpty()) {
+		const edb::tid_t tid = stopping.takeFirst();
+
+		int status;
+		if(native::waitpid(tid, &status, __WALL) <= 0 || !WIFSTOPPED(status)) {
+			continue;
+		}
+
+		// it may have had something else to report before it saw our stop,
+		// there is nothing there to pass on when it later resumes
+		bool vfork;
+		if(is_fork_event(status, &vfork)) {
+			unsigned long child;
+			if(counted_ptrace(PTRACE_GETEVENTMSG, tid, 0, &child) != -1) {
+				adopt_child(child, vfork && next.shares_memory);
+			}
+			status = SIGSTOP << 8 | 0x7f;
+		} else if(is_clone_event(status)) {
+			unsigned long new_tid;
+			if(counted_ptrace(PTRACE_GETEVENTMSG, tid, 0, &new_tid) != -1) {
+				stopping.push_back(new_tid);
+			}
+			status = SIGSTOP << 8 | 0x7f;
+		} else if(is_exec_event(status)) {
+			next.shares_memory = false;
+			status = SIGSTOP << 8 | 0x7f;
+		}
+
+		stopped.insert(tid, status);
+	}
+
+	if(stopped.isEmpty()) {
+		return false;
+	}
+
+	// in non-stop mode, some of ours may still be running
+	stop_threads();
+
+	// take our breakpoints out of the process we are leaving...
+	QList<IBreakpoint::pointer> enabled;
+	Q_FOREACH(const IBreakpoint::pointer &bp, breakpoints_) {
+		if(bp->enabled() && bp->disable()) {
+			enabled.push_back(bp);
+		}
+	}
+
+	// ...and let it run free, without any hardware breakpoints either
+	const std::size_t dr7 = offsetof(struct user, u_debugreg) + 7 * sizeof(static_cast<struct user *>(0)->u_debugreg[0]);
+
+	background_process previous;
+	previous.shares_memory = next.shares_memory;
+
+	for(threadmap_t::const_iterator it = threads_.begin(); it != threads_.end(); ++it) {
+		const edb::tid_t tid = it.key();
+		previous.threads.insert(tid);
+
+		counted_ptrace(PTRACE_POKEUSER, tid, dr7, 0);
+		if(it->state == thread_info::THREAD_GROUP_STOPPED) {
+			counted_ptrace(PTRACE_LISTEN, tid, 0, 0);
+		} else {
+			// the event which the UI has already dealt with isn't passed on
+			counted_ptrace(PTRACE_CONT, tid, 0, (tid == event_thread_) ? 0 : resume_code(it->status));
+		}
+	}
+
+	background_.insert(pid(), previous);
+
+	// the target is now the one we debug, with all of its threads stopped
+	threads_.clear();
+	waited_threads_.clear();
+	for(QHash<edb::tid_t, int>::const_iterator it = stopped.begin(); it != stopped.end(); ++it) {
+		const thread_info info = { it.value(), is_group_stop(it.value()) ? thread_info::THREAD_GROUP_STOPPED : thread_info::THREAD_STOPPED, 0, ++stop_generation_ };
+		threads_.insert(it.key(), info);
+		waited_threads_.insert(it.key());
+	}
+
+	branch_tracer_.stop();
+	profile_sampler_.stop();
+	counter_set_.stop();
+	stop_states_.clear();
+	++stop_generation_;
+
+	pid_           = target;
+	active_thread_ = threads_.contains(target) ? target : threads_.begin().key();
+	event_thread_  = active_thread_;
+
+	// a new page cache and memory file, for the new address space
+	delete process_;
+	process_ = new PlatformProcess(this, target);
+	open_memory_file();
+	memory_map_changed_ = true;
+
+	Q_FOREACH(const IBreakpoint::pointer &bp, enabled) {
+		bp->enable();
+	}
+
+	return true;
+}
+
 //------------------------------------------------------------------------------
 // Name:
 // Desc:
@@ -1118,6 +3158,7 @@ ThreadInfo DebuggerCore::get_thread_info(edb::tid_t tid) {
 		info.tid      = tid;
 		info.ip       = thread_stat.kstkeip;  // 18
 		info.priority = thread_stat.priority; // 30
+		info.running  = !waited_threads_.contains(tid);
 		
 		switch(thread_stat.state) {           // 03
 		case 'R':
@@ -1161,6 +3202,7 @@ ThreadInfo DebuggerCore::get_thread_info(edb::tid_t tid) {
 		info.ip       = 0;
 		info.priority = 0;
 		info.state    = '?';
+		info.running  = false;
 	}
 	return info;
 }
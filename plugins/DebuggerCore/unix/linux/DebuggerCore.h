@@ -19,9 +19,19 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #ifndef DEBUGGERCORE_20090529_H_
 #define DEBUGGERCORE_20090529_H_
 
+#include "BranchTracer.h"
+#include "BreakpointGuard.h"
+#include "Configuration.h"
+#include "CounterSet.h"
 #include "DebuggerCoreUNIX.h"
+#include "PlatformState.h"
+#include "ProfileSampler.h"
+#include "SyscallTracer.h"
 #include <QHash>
+#include <QMap>
+#include <QMutex>
 #include <QSet>
+#include <QThreadPool>
 #include <csignal>
 #include <sys/syscall.h>   /* For SYS_xxx definitions */
 #include <unistd.h>
@@ -32,6 +42,8 @@ class IBinary;
 
 namespace DebuggerCore {
 
+class PlatformProcess;
+
 class DebuggerCore : public DebuggerCoreUNIX {
 	Q_OBJECT
 #if QT_VERSION >= 0x050000
@@ -41,6 +53,7 @@ class DebuggerCore : public DebuggerCoreUNIX {
 	Q_CLASSINFO("author", "Evan Teran")
 	Q_CLASSINFO("url", "http://www.codef00.com")
 	friend class PlatformProcess;
+	friend class PlatformState;
 	
 public:
 	DebuggerCore();
@@ -56,6 +69,7 @@ public:
 	virtual void pause();
 	virtual void resume(edb::EVENT_STATUS status);
 	virtual void step(edb::EVENT_STATUS status);
+	virtual bool step_many(quint64 count, const CompiledExpression *condition, QVector<edb::address_t> *trace, IDebugEvent::const_pointer *event);
 	virtual void get_state(State *state);
 	virtual void set_state(const State &state);
 	virtual bool open(const QString &path, const QString &cwd, const QList<QByteArray> &args, const QString &tty);
@@ -67,10 +81,18 @@ public:
 	virtual edb::tid_t active_thread() const     { return active_thread_; }
 	virtual void set_active_thread(edb::tid_t);
 	virtual ThreadInfo get_thread_info(edb::tid_t);
+	virtual bool get_thread_state(edb::tid_t tid, State *state);
+
+public:
+	virtual bool memory_map_changed();
 
 public:
 	virtual edb::pid_t parent_pid(edb::pid_t pid) const;
 
+public:
+	virtual QList<edb::pid_t> traced_processes() const;
+	virtual bool select_process(edb::pid_t pid);
+
 public:
 	virtual IState *create_state() const;
 
@@ -78,8 +100,12 @@ public:
 	virtual quint64 cpu_type() const;
 
 
+protected:
+	virtual bool can_rewrite_memory() const;
+
 private:
 	virtual QMap<edb::pid_t, ProcessInfo> enumerate_processes() const;
+	virtual void stream_processes(ProcessSink *sink) const;
 	virtual QList<Module> loaded_modules() const;
 
 public:
@@ -94,6 +120,38 @@ public:
 public:
 	virtual IProcess *process() const;
 
+public:
+	virtual bool start_branch_trace();
+	virtual void stop_branch_trace();
+	virtual QVector<BranchRecord> branch_trace(quint64 *lost);
+
+public:
+	virtual bool start_syscall_trace(const QList<edb::reg_t> &numbers, int capacity);
+	virtual void stop_syscall_trace();
+	virtual QVector<SyscallRecord> syscall_trace(quint64 *lost);
+
+public:
+	virtual bool start_profile(int frequency);
+	virtual void stop_profile();
+	virtual QVector<ProfileSample> profile_samples(quint64 *lost);
+
+public:
+	virtual bool start_counters();
+	virtual void stop_counters();
+	virtual bool read_counters(PerformanceCounters *counters);
+
+public:
+	virtual QList<edb::address_t> overwritten_breakpoints();
+
+public:
+	virtual QHash<edb::address_t, MemoryUsage> memory_usage(const QList<edb::address_t> &starts);
+	virtual bool total_memory_usage(MemoryUsage *usage);
+
+public:
+	virtual bool set_debug_registers(const DebugRegisters &registers);
+	virtual bool set_page_permissions(edb::address_t address, edb::address_t size, bool read, bool write, bool execute);
+	virtual edb::address_t allocate_memory(edb::address_t hint, edb::address_t size);
+
 private:
 	virtual long read_data(edb::address_t address, bool *ok);
 	virtual bool write_data(edb::address_t address, long value);
@@ -102,6 +160,8 @@ private:
 	long ptrace_getsiginfo(edb::tid_t tid, siginfo_t *siginfo);
 	long ptrace_continue(edb::tid_t tid, long status);
 	long ptrace_step(edb::tid_t tid, long status);
+	long ptrace_listen(edb::tid_t tid);
+	long ptrace_resume(edb::tid_t tid, long status);
 	long ptrace_set_options(edb::tid_t tid, long options);
 	long ptrace_get_event_message(edb::tid_t tid, unsigned long *message);
 	long ptrace_traceme();
@@ -109,26 +169,113 @@ private:
 private:
 	void reset();
 	void stop_threads();
+	void thread_ran(edb::tid_t tid);
+	quint64 thread_generation(edb::tid_t tid) const;
+	bool threads_running() const;
 	IDebugEvent::const_pointer handle_event(edb::tid_t tid, int status);
+	IDebugEvent::const_pointer skip_conditional_breakpoint(edb::tid_t tid, int status, bool *skipped);
 	bool attach_thread(edb::tid_t tid);
+	void open_memory_file();
+	void close_memory_file();
+	bool at_syscall_instruction(edb::tid_t tid);
+	bool is_attach_stop(int status) const;
+	PlatformState &fetch_state(edb::tid_t tid, quint32 groups);
+	void load_state(PlatformState *state, quint32 groups);
+	void apply_debug_registers(edb::tid_t tid);
+	bool inject_syscall(long number, const edb::reg_t (&args)[6], edb::reg_t *result);
+	long trace_options() const;
+	void syscall_stop(edb::tid_t tid);
+	bool pass_signal(edb::tid_t tid, int signal) const;
+	void check_breakpoints();
+	void guard_breakpoints();
+
+private:
+	// following forks
+	void adopt_child(edb::pid_t child, bool shares_memory);
+	void handle_background_event(edb::pid_t pid, edb::tid_t tid, int status);
+	void strip_breakpoints(edb::pid_t pid);
+	void step_over_breakpoint(edb::pid_t pid, edb::tid_t tid, edb::address_t address);
+	void release_background(bool kill);
 	
 private:
 	struct thread_info {
 		int status;
 		enum {
 			THREAD_STOPPED,
-			THREAD_SIGNALED
+			THREAD_SIGNALED,
+			THREAD_GROUP_STOPPED
 		} state;
+
+		// which debug_registers_ the thread has, new threads start with none
+		// set, which is generation 0
+		quint64 debug_generation;
+
+		// changes every time the thread runs, its registers are only cached
+		// for as long as it stays the same
+		quint64 run_generation;
 	};
 
 	typedef QHash<edb::tid_t, thread_info> threadmap_t;
 
+	// a process we follow but aren't debugging right now, it runs on its own
+	// with no breakpoints (unless it shares memory with the one we debug) and
+	// we only look at its events to keep it going
+	struct background_process {
+		QSet<edb::tid_t> threads;
+		bool             shares_memory; // a vfork child before it execs
+	};
+
+	typedef QMap<edb::pid_t, background_process> processmap_t;
+	typedef QHash<edb::tid_t, PlatformState>     statemap_t;
+
 	edb::address_t   page_size_;
 	threadmap_t      threads_;
 	QSet<edb::tid_t> waited_threads_;
 	edb::tid_t       event_thread_;
 	IBinary          *binary_info_;
-	IProcess         *process_;
+	PlatformProcess  *process_;
+	int              memory_fd_;
+
+	// the thread the process's asynchronous reads and writes are done on,
+	// one at a time and in order
+	QThreadPool      memory_service_;
+	bool             trace_syscalls_;
+	bool             memory_map_changed_;
+	bool             seized_;
+	bool             pause_requested_;
+	bool             non_stop_;
+	bool             follow_fork_;
+	QMap<int, Configuration::SignalPolicy> signal_policies_;
+	processmap_t     background_;
+
+	// the registers of each thread which has been looked at while it is
+	// stopped, filled in as needed and thrown away once that thread runs (its
+	// run_generation changes), so switching between threads is free. In
+	// non-stop mode the other threads running doesn't disturb them.
+	// stop_generation_ hands out the generations
+	statemap_t       stop_states_;
+	quint64          stop_generation_;
+
+	BranchTracer     branch_tracer_;
+	SyscallTracer    syscall_tracer_;
+	ProfileSampler   profile_sampler_;
+	CounterSet       counter_set_;
+
+	// breakpoints the process wrote over, which have been put back since, for
+	// overwritten_breakpoints to report
+	BreakpointGuard        breakpoint_guard_;
+	QList<edb::address_t>  overwritten_breakpoints_;
+
+	// the hardware breakpoints every thread should have, each change is a new
+	// generation and threads are brought up to date as they are resumed
+	DebugRegisters   debug_registers_;
+	quint64          debug_generation_;
+
+	// what the last walk of /proc found, so that the next one only needs to
+	// look at the processes which are new since
+	mutable QMutex                        process_list_lock_;
+	mutable QMap<edb::pid_t, ProcessInfo> process_list_;
+	mutable QHash<edb::uid_t, QString>    user_names_;
 };
 
 }
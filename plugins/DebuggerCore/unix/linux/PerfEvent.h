@@ -0,0 +1,48 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef PERFEVENT_20261014_H_
+#define PERFEVENT_20261014_H_
+
+#include <QtGlobal>
+#include <cstddef>
+#include <cstring>
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace DebuggerCore {
+
+// glibc doesn't provide a wrapper for this one
+inline int perf_event_open(struct perf_event_attr *attr, pid_t pid, int cpu, int group_fd, unsigned long flags) {
+	return syscall(__NR_perf_event_open, attr, pid, cpu, group_fd, flags);
+}
+
+// copies <len> bytes at <offset> out of the data part of a perf ring buffer,
+// <data_len> bytes long, wrapping as needed
+inline void read_ring(const quint8 *data, std::size_t data_len, quint64 offset, void *buf, std::size_t len) {
+	const std::size_t start = offset & (data_len - 1);
+	const std::size_t first = qMin(len, data_len - start);
+
+	std::memcpy(buf, data + start, first);
+	std::memcpy(static_cast<quint8 *>(buf) + first, data, len - first);
+}
+
+}
+
+#endif
@@ -17,10 +17,17 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
 #include "PlatformEvent.h"
+#include "ObjectPool.h"
 #include "edb.h"
 
 namespace DebuggerCore {
 
+namespace {
+
+ObjectPool<PlatformEvent> event_pool;
+
+}
+
 //------------------------------------------------------------------------------
 // Name:
 //------------------------------------------------------------------------------
@@ -28,6 +35,20 @@ PlatformEvent::PlatformEvent() : pid_(0), tid_(0), status_(0) {
 	std::memset(&siginfo_, 0, sizeof(siginfo_t));
 }
 
+//------------------------------------------------------------------------------
+// Name: operator new
+//------------------------------------------------------------------------------
+void *PlatformEvent::operator new(std::size_t size) {
+	return event_pool.allocate(size);
+}
+
+//------------------------------------------------------------------------------
+// Name: operator delete
+//------------------------------------------------------------------------------
+void PlatformEvent::operator delete(void *p, std::size_t size) {
+	event_pool.release(p, size);
+}
+
 //------------------------------------------------------------------------------
 // Name:
 //------------------------------------------------------------------------------
@@ -240,4 +261,17 @@ int PlatformEvent::code() const {
 	return 0;
 }
 
+//------------------------------------------------------------------------------
+// Name: access_violation
+// Desc: SEGV_ACCERR is a mapped page which doesn't allow the access,
+//       SEGV_MAPERR would be an unmapped one
+//------------------------------------------------------------------------------
+bool PlatformEvent::access_violation(edb::address_t *address) const {
+	if(stopped() && code() == SIGSEGV && siginfo_.si_code == SEGV_ACCERR) {
+		*address = reinterpret_cast<edb::address_t>(siginfo_.si_addr);
+		return true;
+	}
+	return false;
+}
+
 }
@@ -22,6 +22,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "IDebugEvent.h"
 
 #include <QCoreApplication>
+#include <cstddef>
 #include <signal.h> // for the SIG* definitions
 
 namespace DebuggerCore {
@@ -33,6 +34,11 @@ class PlatformEvent : IDebugEvent {
 public:
 	PlatformEvent();
 
+public:
+	// there is one of these for every stop, so they come from a pool
+	static void *operator new(std::size_t size);
+	static void operator delete(void *p, std::size_t size);
+
 public:
 	virtual PlatformEvent *clone() const;
 	
@@ -51,6 +57,9 @@ public:
 	virtual edb::tid_t thread() const;
 	virtual int code() const;
 
+public:
+	virtual bool access_violation(edb::address_t *address) const;
+
 private:
 	siginfo_t  siginfo_;
 	edb::pid_t pid_;
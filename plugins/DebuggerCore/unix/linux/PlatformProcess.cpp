@@ -1,13 +1,23 @@
 
 #include "PlatformProcess.h"
+#include "Configuration.h"
 #include "DebuggerCore.h"
+#include "Diagnostics.h"
 #include "PlatformRegion.h"
 #include "edb.h"
 #include <QByteArray>
 #include <QFile>
 #include <QFileInfo>
+#include <QHash>
+#include <QRunnable>
 #include <QTextStream>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
 #include <sys/mman.h>
+#include <sys/uio.h>
+#include <unistd.h>
 
 using namespace DebuggerCore;
 
@@ -19,6 +29,34 @@ namespace {
 #define EDB_WORDSIZE sizeof(quint32)
 #endif
 
+//------------------------------------------------------------------------------
+// Name: next_memory_generation
+// Desc: shared by every process, so that no two memory states are ever given
+//       the same generation
+//------------------------------------------------------------------------------
+quint64 next_memory_generation() {
+	static quint64 generation = 0;
+	return ++generation;
+}
+
+// what the syscalls which move memory are counted under, by bytes moved
+edb::diagnostics::Counter *const readv_counter  = edb::diagnostics::counter("syscall: process_vm_readv");
+edb::diagnostics::Counter *const writev_counter = edb::diagnostics::counter("syscall: process_vm_writev");
+edb::diagnostics::Counter *const pread_counter  = edb::diagnostics::counter("syscall: pread64");
+edb::diagnostics::Counter *const pwrite_counter = edb::diagnostics::counter("syscall: pwrite64");
+
+// the most pages we will ask process_vm_readv for in a single call,
+// this is well under the usual IOV_MAX of 1024
+const int ReadChunkPages = 256;
+
+// writes shorter than this aren't worth a process_vm_writev call, a couple of
+// ptrace words will do
+const std::size_t WriteBulkThreshold = 64;
+
+// process_vm_readv was added in Linux 3.2, if it turns out to not be available
+// we just use /proc/<pid>/mem for everything
+bool process_vm_readv_works  = true;
+bool process_vm_writev_works = true;
 
 struct user_stat {
 /* 01 */ int pid;
@@ -162,55 +200,188 @@ int get_user_stat(edb::pid_t pid, struct user_stat *user_stat) {
 	return get_user_stat(QString("/proc/%1/stat").arg(pid), user_stat);
 }
 
+//------------------------------------------------------------------------------
+// Name: parse_hex
+// Desc: parses a hex number at <p>, leaving <p> just past it. Returns false if
+//       there were no hex digits at all
+//------------------------------------------------------------------------------
+bool parse_hex(const char *&p, const char *end, edb::address_t *value) {
+
+	const char *const first = p;
+	edb::address_t v        = 0;
+
+	for(; p != end; ++p) {
+		const char ch = *p;
+		if(ch >= '0' && ch <= '9') {
+			v = (v << 4) | (ch - '0');
+		} else if(ch >= 'a' && ch <= 'f') {
+			v = (v << 4) | (ch - 'a' + 10);
+		} else if(ch >= 'A' && ch <= 'F') {
+			v = (v << 4) | (ch - 'A' + 10);
+		} else {
+			break;
+		}
+	}
+
+	*value = v;
+	return p != first;
+}
+
+//------------------------------------------------------------------------------
+// Name: skip_spaces
+// Desc:
+//------------------------------------------------------------------------------
+void skip_spaces(const char *&p, const char *end) {
+	while(p != end && (*p == ' ' || *p == '\t')) {
+		++p;
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: skip_field
+// Desc: skips to the next whitespace
+//------------------------------------------------------------------------------
+void skip_field(const char *&p, const char *end) {
+	while(p != end && *p != ' ' && *p != '\t') {
+		++p;
+	}
+}
+
 //------------------------------------------------------------------------------
 // Name: process_map_line
-// Desc: parses the data from a line of a memory map file
+// Desc: parses the data from a line of a memory map file, in place. The name
+//       is looked up in <names> so that every region from the same file
+//       shares one QString
 //------------------------------------------------------------------------------
-IRegion::pointer process_map_line(const QString &line) {
+IRegion::pointer process_map_line(const char *p, const char *end, QHash<QByteArray, QString> &names) {
 
+	// 00400000-0040b000 r-xp 00000000 08:01 1234    /bin/cat
 	edb::address_t start;
-	edb::address_t end;
+	edb::address_t end_address;
 	edb::address_t base;
-	IRegion::permissions_t permissions;
-	QString name;
 
-	const QStringList items = line.split(" ", QString::SkipEmptyParts);
-	if(items.size() >= 3) {
-		bool ok;
-		const QStringList bounds = items[0].split("-");
-		if(bounds.size() == 2) {
-			start = bounds[0].toULongLong(&ok, 16);
-			if(ok) {
-				end = bounds[1].toULongLong(&ok, 16);
-				if(ok) {
-					base = items[2].toULongLong(&ok, 16);
-					if(ok) {
-						const QString perms = items[1];
-						permissions = 0;
-						if(perms[0] == 'r') permissions |= PROT_READ;
-						if(perms[1] == 'w') permissions |= PROT_WRITE;
-						if(perms[2] == 'x') permissions |= PROT_EXEC;
-
-						if(items.size() >= 6) {
-							name = items[5];
-						}
-
-						return IRegion::pointer(new PlatformRegion(start, end, base, name, permissions));
-					}
-				}
-			}
+	if(!parse_hex(p, end, &start) || p == end || *p++ != '-') {
+		return IRegion::pointer();
+	}
+
+	if(!parse_hex(p, end, &end_address)) {
+		return IRegion::pointer();
+	}
+
+	skip_spaces(p, end);
+	if(end - p < 3) {
+		return IRegion::pointer();
+	}
+
+	IRegion::permissions_t permissions = 0;
+	if(p[0] == 'r') permissions |= PROT_READ;
+	if(p[1] == 'w') permissions |= PROT_WRITE;
+	if(p[2] == 'x') permissions |= PROT_EXEC;
+
+	skip_field(p, end);
+	skip_spaces(p, end);
+	if(!parse_hex(p, end, &base)) {
+		return IRegion::pointer();
+	}
+
+	// device and inode
+	skip_spaces(p, end);
+	skip_field(p, end);
+	skip_spaces(p, end);
+	skip_field(p, end);
+	skip_spaces(p, end);
+
+	// whatever is left is the name, which may well have spaces in it
+	while(end != p && (end[-1] == ' ' || end[-1] == '\t' || end[-1] == '\r')) {
+		--end;
+	}
+
+	QString name;
+	if(p != end) {
+		const QByteArray key = QByteArray::fromRawData(p, end - p);
+		QHash<QByteArray, QString>::const_iterator it = names.constFind(key);
+		if(it != names.constEnd()) {
+			name = *it;
+		} else {
+			name = QString::fromLocal8Bit(p, end - p);
+			names.insert(QByteArray(p, end - p), name);
 		}
 	}
-	return IRegion::pointer();
+
+	return IRegion::pointer(new PlatformRegion(start, end_address, base, name, permissions));
 }
 
 }
 
+// the jobs run on the core's memory service. Their futures are started as
+// soon as they are made, so that they can be handed back before the job runs
+class PlatformProcess::ReadJob : public QRunnable {
+public:
+	ReadJob(PlatformProcess *process, edb::address_t address, std::size_t len) : process_(process), address_(address), len_(len) {
+		future_.reportStarted();
+	}
+
+public:
+	QFuture<AsyncRead> future() { return future_.future(); }
+
+public:
+	virtual void run() {
+		AsyncRead result;
+		result.bytes.resize(len_);
+
+		// the page cache belongs to the UI thread, so this always goes to
+		// the process, and the counters are the UI thread's too
+		const std::size_t n = process_->read_uncached(address_, result.bytes.data(), len_, false);
+		if(n != len_) {
+			std::memset(result.bytes.data() + n, 0xff, len_ - n);
+		}
+
+		process_->patch_breakpoints(address_, result.bytes.data(), n);
+		result.ok = (n == len_);
+
+		future_.reportResult(result);
+		future_.reportFinished();
+	}
+
+private:
+	PlatformProcess             *process_;
+	edb::address_t              address_;
+	std::size_t                 len_;
+	QFutureInterface<AsyncRead> future_;
+};
+
+class PlatformProcess::WriteJob : public QRunnable {
+public:
+	WriteJob(PlatformProcess *process, edb::address_t address, const QByteArray &bytes) : process_(process), address_(address), bytes_(bytes) {
+		future_.reportStarted();
+	}
+
+public:
+	QFuture<bool> future() { return future_.future(); }
+
+public:
+	virtual void run() {
+		// ptrace would have to be done from the tracing thread, these
+		// don't need it
+		const std::size_t n = process_->write_memory(address_, bytes_.constData(), bytes_.size(), false);
+		process_->pending_writes_.fetchAndAddOrdered(-1);
+
+		future_.reportResult(n == static_cast<std::size_t>(bytes_.size()));
+		future_.reportFinished();
+	}
+
+private:
+	PlatformProcess        *process_;
+	edb::address_t         address_;
+	QByteArray             bytes_;
+	QFutureInterface<bool> future_;
+};
+
 //------------------------------------------------------------------------------
 // Name: PlatformProcess
 // Desc: 
 //------------------------------------------------------------------------------
-PlatformProcess::PlatformProcess(DebuggerCore *core, edb::pid_t pid) : core_(core), pid_(pid) {
+PlatformProcess::PlatformProcess(DebuggerCore *core, edb::pid_t pid) : core_(core), pid_(pid), cache_(core->page_size(), edb::v1::config().page_cache_size), memory_generation_(next_memory_generation()), pending_writes_(0) {
 
 }
 
@@ -219,49 +390,274 @@ PlatformProcess::PlatformProcess(DebuggerCore *core, edb::pid_t pid) : core_(cor
 // Desc: 
 //------------------------------------------------------------------------------
 PlatformProcess::~PlatformProcess() {
+	core_->memory_service_.waitForDone();
 }
 
 //------------------------------------------------------------------------------
-// Name: read_pages
-// Desc: reads <count> pages from the process starting at <address>
-// Note: buf's size must be >= count * core_->page_size()
-// Note: address should be page aligned.
+// Name: read_uncached
+// Desc: reads up to <len> bytes into <buf> starting at <address>, moving whole
+//       pages per syscall. Returns the number of bytes which were successfully
+//       read, reading stops at the first page which cannot be read at all
+// Note: this does not hide breakpoints, see patch_breakpoints. Reads which
+//       aren't <counted> can be made from any thread
 //------------------------------------------------------------------------------
-bool PlatformProcess::read_pages(edb::address_t address, void *buf, std::size_t count) {
+std::size_t PlatformProcess::read_uncached(edb::address_t address, void *buf, std::size_t len, bool counted) {
 
 	Q_ASSERT(buf);
 
-	if((address & (core_->page_size() - 1)) == 0) {
-		const edb::address_t orig_address = address;
-		long *ptr                         = reinterpret_cast<long *>(buf);
-		quint8 *const orig_ptr            = reinterpret_cast<quint8 *>(buf);
-
-		const edb::address_t end_address  = orig_address + core_->page_size() * count;
-
-		for(std::size_t c = 0; c < count; ++c) {
-			for(edb::address_t i = 0; i < core_->page_size(); i += EDB_WORDSIZE) {
-				bool ok;
-				const long v = core_->read_data(address, &ok);
-				if(!ok) {
-					return false;
-				}
+	quint8 *const ptr              = reinterpret_cast<quint8 *>(buf);
+	const edb::address_t page_size = core_->page_size();
+	std::size_t total              = 0;
+
+	while(total < len) {
+		ssize_t n = -1;
+
+		if(process_vm_readv_works) {
+			// split the remote side on page boundaries, process_vm_readv never
+			// splits a single iovec, so a partial read tells us exactly which
+			// page could not be read
+			struct iovec local_iov;
+			struct iovec remote_iov[ReadChunkPages];
 
-				*ptr++ = v;
-				address += EDB_WORDSIZE;
+			edb::address_t remote_address = address + total;
+			std::size_t remaining         = len - total;
+			int iov_count                 = 0;
+			std::size_t chunk_len         = 0;
+
+			while(remaining != 0 && iov_count < ReadChunkPages) {
+				const std::size_t to_boundary = page_size - (remote_address & (page_size - 1));
+				const std::size_t n_bytes     = qMin(to_boundary, remaining);
+
+				remote_iov[iov_count].iov_base = reinterpret_cast<void *>(remote_address);
+				remote_iov[iov_count].iov_len  = n_bytes;
+
+				remote_address += n_bytes;
+				remaining      -= n_bytes;
+				chunk_len      += n_bytes;
+				++iov_count;
+			}
+
+			local_iov.iov_base = ptr + total;
+			local_iov.iov_len  = chunk_len;
+
+			n = process_vm_readv(pid_, &local_iov, 1, remote_iov, iov_count, 0);
+			if(counted) {
+				edb::diagnostics::add(readv_counter, qMax<ssize_t>(n, 0));
+			}
+			if(n == -1 && (errno == ENOSYS || errno == EPERM)) {
+				// the kernel doesn't support it (or won't let us use it), don't
+				// bother trying again
+				process_vm_readv_works = false;
 			}
 		}
 
-		Q_FOREACH(const IBreakpoint::pointer &bp, core_->breakpoints_) {
-			if(bp->address() >= orig_address && bp->address() < end_address) {
-				// show the original bytes in the buffer..
-				orig_ptr[bp->address() - orig_address] = bp->original_byte();
+		if(n <= 0) {
+			// process_vm_readv refuses pages which aren't readable by the
+			// inferior itself, /proc/<pid>/mem doesn't, so give it a shot
+			// for just the page that failed
+			const edb::address_t remote_address = address + total;
+			const std::size_t to_boundary       = page_size - (remote_address & (page_size - 1));
+			const std::size_t n_bytes           = qMin(to_boundary, len - total);
+
+			if(core_->memory_fd_ == -1) {
+				break;
+			}
+
+			n = pread64(core_->memory_fd_, ptr + total, n_bytes, remote_address);
+			if(counted) {
+				edb::diagnostics::add(pread_counter, qMax<ssize_t>(n, 0));
+			}
+			if(n <= 0) {
+				break;
 			}
 		}
+
+		total += n;
+	}
+
+	return total;
+}
+
+//------------------------------------------------------------------------------
+// Name: read_cached
+// Desc: copies <len> bytes starting at <address> into <buf>, but only if every
+//       page involved is already in the cache. Returns true on success
+//------------------------------------------------------------------------------
+bool PlatformProcess::read_cached(edb::address_t address, void *buf, std::size_t len) const {
+
+	const edb::address_t page_size = cache_.page_size();
+	quint8 *const ptr              = reinterpret_cast<quint8 *>(buf);
+
+	// make sure that we have all of it before copying anything
+	std::size_t offset = 0;
+	while(offset < len) {
+		const edb::address_t page = (address + offset) & ~(page_size - 1);
+		if(!cache_.find(page)) {
+			return false;
+		}
+		offset += page_size - ((address + offset) & (page_size - 1));
+	}
+
+	offset = 0;
+	while(offset < len) {
+		const edb::address_t a        = address + offset;
+		const edb::address_t page     = a & ~(page_size - 1);
+		const std::size_t page_offset = a - page;
+		const std::size_t n           = qMin(static_cast<std::size_t>(page_size - page_offset), len - offset);
+
+		std::memcpy(ptr + offset, cache_.find(page) + page_offset, n);
+		offset += n;
 	}
 
 	return true;
 }
 
+//------------------------------------------------------------------------------
+// Name: cache_usable
+// Desc: in non-stop mode the other threads may be running while we read, and
+//       then nothing read can be kept for the next read. The cache is emptied
+//       and the views are told that memory may have changed
+//------------------------------------------------------------------------------
+bool PlatformProcess::cache_usable() {
+	if(!core_->threads_running()) {
+		return true;
+	}
+
+	cache_.clear();
+	memory_generation_ = next_memory_generation();
+	return false;
+}
+
+//------------------------------------------------------------------------------
+// Name: read_memory
+// Desc: like read_uncached, but pages which have been read since the process
+//       last ran are served from the page cache, and pages which have to be
+//       fetched are added to it
+// Note: large reads bypass the cache so that a single region dump doesn't
+//       throw away everything that is actually being looked at
+//------------------------------------------------------------------------------
+std::size_t PlatformProcess::read_memory(edb::address_t address, void *buf, std::size_t len) {
+
+	static edb::diagnostics::Counter *const hits     = edb::diagnostics::counter("page cache: hits");
+	static edb::diagnostics::Counter *const misses   = edb::diagnostics::counter("page cache: misses");
+	static edb::diagnostics::Counter *const bypassed = edb::diagnostics::counter("page cache: bypassed");
+
+	const edb::address_t page_size = cache_.page_size();
+
+	if(len == 0) {
+		return 0;
+	}
+
+	wait_for_service();
+
+	const edb::address_t first_page = address & ~(page_size - 1);
+	const edb::address_t last_page  = (address + len - 1) & ~(page_size - 1);
+	const std::size_t page_count    = (last_page - first_page) / page_size + 1;
+
+	if(!cache_usable() || cache_.max_pages() == 0 || page_count > static_cast<std::size_t>(qMax(1, cache_.max_pages() / 4))) {
+		edb::diagnostics::add(bypassed, len);
+		return read_uncached(address, buf, len);
+	}
+
+	quint8 *const ptr = reinterpret_cast<quint8 *>(buf);
+	QVector<quint8> pages;
+	std::size_t total = 0;
+
+	edb::address_t page = first_page;
+	while(total < len) {
+		const std::size_t page_offset = (address + total) - page;
+		const std::size_t n           = qMin(static_cast<std::size_t>(page_size - page_offset), len - total);
+
+		if(const quint8 *const cached = cache_.find(page)) {
+			edb::diagnostics::add(hits);
+			std::memcpy(ptr + total, cached + page_offset, n);
+			total += n;
+			page  += page_size;
+			continue;
+		}
+
+		// fetch the whole run of missing pages in one go
+		std::size_t run = 1;
+		while(page + run * page_size <= last_page && !cache_.find(page + run * page_size)) {
+			++run;
+		}
+
+		edb::diagnostics::add(misses, run);
+
+		pages.resize(run * page_size);
+		const std::size_t got = read_uncached(page, pages.data(), run * page_size) / page_size;
+
+		for(std::size_t i = 0; i < got; ++i) {
+			cache_.insert(page + i * page_size, &pages[i * page_size]);
+		}
+
+		// copy out what we got, the first page may be partial
+		std::size_t available = got * page_size;
+		if(available <= page_offset) {
+			break;
+		}
+
+		available -= page_offset;
+		const std::size_t copy = qMin(available, len - total);
+		std::memcpy(ptr + total, &pages[page_offset], copy);
+		total += copy;
+
+		if(got != run) {
+			break;
+		}
+
+		page += run * page_size;
+	}
+
+	return total;
+}
+
+//------------------------------------------------------------------------------
+// Name: flush_cache
+// Desc: forgets all cached pages, this must be called whenever the process
+//       is allowed to run
+//------------------------------------------------------------------------------
+void PlatformProcess::flush_cache() {
+	core_->memory_service_.waitForDone();
+	cache_.clear();
+	memory_generation_ = next_memory_generation();
+}
+
+//------------------------------------------------------------------------------
+// Name: patch_breakpoints
+// Desc: replaces any breakpoint bytes in <buf> (which holds <len> bytes read
+//       from <address>) with the original bytes they replaced
+//------------------------------------------------------------------------------
+void PlatformProcess::patch_breakpoints(edb::address_t address, void *buf, std::size_t len) const {
+
+	core_->mask_breakpoints(address, buf, len);
+}
+
+//------------------------------------------------------------------------------
+// Name: read_pages
+// Desc: reads <count> pages from the process starting at <address>
+// Note: buf's size must be >= count * core_->page_size()
+// Note: address should be page aligned.
+//------------------------------------------------------------------------------
+bool PlatformProcess::read_pages(edb::address_t address, void *buf, std::size_t count) {
+
+	static edb::diagnostics::Counter *const pages_read = edb::diagnostics::counter("process: read_pages");
+
+	Q_ASSERT(buf);
+
+	edb::diagnostics::add(pages_read, count * core_->page_size());
+
+	if((address & (core_->page_size() - 1)) == 0) {
+		const std::size_t len = count * core_->page_size();
+		const std::size_t n   = read_memory(address, buf, len);
+
+		patch_breakpoints(address, buf, n);
+		return n == len;
+	}
+
+	return false;
+}
+
 //------------------------------------------------------------------------------
 // Name: read_bytes
 // Desc: reads <len> bytes into <buf> starting at <address>
@@ -270,161 +666,347 @@ bool PlatformProcess::read_pages(edb::address_t address, void *buf, std::size_t
 //------------------------------------------------------------------------------
 bool PlatformProcess::read_bytes(edb::address_t address, void *buf, std::size_t len) {
 
+	static edb::diagnostics::Counter *const bytes_read = edb::diagnostics::counter("process: read_bytes");
+
 	Q_ASSERT(buf);
 
+	edb::diagnostics::add(bytes_read, len);
+
 	if(len != 0) {
-		bool ok;
-		quint8 *p = reinterpret_cast<quint8 *>(buf);
-		quint8 ch = read_byte(address, &ok);
-
-		while(ok && len) {
-			*p++ = ch;
-			if(--len) {
-				++address;
-				ch = read_byte(address, &ok);
-			}
+		const std::size_t n = read_memory(address, buf, len);
+		if(n != len) {
+			std::memset(reinterpret_cast<quint8 *>(buf) + n, 0xff, len - n);
 		}
 
-		if(!ok) {
-			while(len--) {
-				*p++ = 0xff;
-			}
-		}
+		patch_breakpoints(address, buf, n);
 	}
 
 	return true;
 }
 
 //------------------------------------------------------------------------------
-// Name: write_bytes
-// Desc: writes <len> bytes from <buf> starting at <address>
+// Name: read_batch
+// Desc: reads every request in as few process_vm_readv calls as possible, each
+//       request gets its own local iovec, so a stack walk or heap walk costs a
+//       single syscall instead of one per read
 //------------------------------------------------------------------------------
-bool PlatformProcess::write_bytes(edb::address_t address, const void *buf, std::size_t len) {
+QVector<bool> PlatformProcess::read_batch(const QVector<ReadRequest> &requests) {
 
-	Q_ASSERT(buf);
+	const edb::address_t page_size = core_->page_size();
+	QVector<bool> results(requests.size(), false);
 
-	bool ok = false;
+	wait_for_service();
 
-	const quint8 *p = reinterpret_cast<const quint8 *>(buf);
+	const bool use_cache = cache_usable();
 
-	while(len--) {
-		write_byte(address++, *p++, &ok);
-		if(!ok) {
-			break;
+	int i = 0;
+	while(i < requests.size()) {
+
+		struct iovec local_iov[ReadChunkPages];
+		struct iovec remote_iov[ReadChunkPages];
+		int          indexes[ReadChunkPages];
+
+		int local_count  = 0;
+		int remote_count = 0;
+
+		// gather as many whole requests as will fit in one call, anything
+		// which is entirely in the page cache doesn't need to be read at all
+		while(i < requests.size() && local_count < ReadChunkPages) {
+			const ReadRequest &request = requests[i];
+
+			if(use_cache && read_cached(request.address, request.buffer, request.length)) {
+				patch_breakpoints(request.address, request.buffer, request.length);
+				results[i] = true;
+				++i;
+				continue;
+			}
+
+			if(!process_vm_readv_works) {
+				break;
+			}
+
+			// how many remote iovecs would this one need?
+			const int pages_spanned = (((request.address & (page_size - 1)) + request.length + page_size - 1) / page_size);
+			if(request.length != 0 && remote_count + pages_spanned > ReadChunkPages) {
+				break;
+			}
+
+			local_iov[local_count].iov_base = request.buffer;
+			local_iov[local_count].iov_len  = request.length;
+			indexes[local_count]            = i;
+			++local_count;
+
+			edb::address_t remote_address = request.address;
+			std::size_t remaining         = request.length;
+			while(remaining != 0) {
+				const std::size_t to_boundary = page_size - (remote_address & (page_size - 1));
+				const std::size_t n_bytes     = qMin(to_boundary, remaining);
+
+				remote_iov[remote_count].iov_base = reinterpret_cast<void *>(remote_address);
+				remote_iov[remote_count].iov_len  = n_bytes;
+				++remote_count;
+
+				remote_address += n_bytes;
+				remaining      -= n_bytes;
+			}
+
+			++i;
+		}
+
+		std::size_t done = 0;
+		if(remote_count != 0) {
+			const ssize_t n = process_vm_readv(pid_, local_iov, local_count, remote_iov, remote_count, 0);
+			edb::diagnostics::add(readv_counter, qMax<ssize_t>(n, 0));
+			if(n > 0) {
+				done = n;
+			} else if(n == -1 && (errno == ENOSYS || errno == EPERM)) {
+				process_vm_readv_works = false;
+			}
+		}
+
+		// mark everything which was completely read
+		int k = 0;
+		for(; k < local_count; ++k) {
+			const ReadRequest &request = requests[indexes[k]];
+			if(request.length > done) {
+				break;
+			}
+
+			patch_breakpoints(request.address, request.buffer, request.length);
+			results[indexes[k]] = true;
+			done -= request.length;
+		}
+
+		// the next request either failed or was too big to batch, so do it the
+		// slow way and pick up with the one after it
+		int j = -1;
+		if(k < local_count) {
+			j = indexes[k];
+		} else if(local_count == 0 && i < requests.size()) {
+			j = i;
+		}
+
+		if(j != -1) {
+			const ReadRequest &request = requests[j];
+			const std::size_t n = read_memory(request.address, request.buffer, request.length);
+			if(n != request.length) {
+				std::memset(reinterpret_cast<quint8 *>(request.buffer) + n, 0xff, request.length - n);
+			}
+
+			patch_breakpoints(request.address, request.buffer, n);
+			results[j] = (n == request.length);
+			i = j + 1;
 		}
 	}
 
-	return ok;
+	return results;
 }
 
 //------------------------------------------------------------------------------
-// Name: write_byte
-// Desc: writes a single byte at a given address
-// Note: assumes the this will not trample any breakpoints, must be handled
-//       in calling code!
+// Name: write_memory
+// Desc: writes up to <len> bytes from <buf> starting at <address> a page at a
+//       time using process_vm_writev, or /proc/<pid>/mem for pages the
+//       inferior can't write to itself. Returns the number of bytes written,
+//       writing stops at the first page that neither will accept
 //------------------------------------------------------------------------------
-void PlatformProcess::write_byte(edb::address_t address, quint8 value, bool *ok) {
-	// TODO(eteran): assert that we are paused
+std::size_t PlatformProcess::write_memory(edb::address_t address, const void *buf, std::size_t len, bool counted) {
 
-	Q_ASSERT(ok);
+	Q_ASSERT(buf);
 
-	*ok = false;
+	const quint8 *const ptr        = reinterpret_cast<const quint8 *>(buf);
+	const edb::address_t page_size = core_->page_size();
+	std::size_t total              = 0;
 
-	long v;
-	long mask;
-	// core_->page_size() - 1 will always be 0xf* because pagesizes
-	// are always 0x10*, so the masking works
-	// range of a is [1..n] where n=pagesize, and we have to adjust
-	// if a < wordsize
-	const edb::address_t a = core_->page_size() - (address & (core_->page_size() - 1));
+	while(total < len) {
+		ssize_t n = -1;
 
-	v = value;
-#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
-	if(a < EDB_WORDSIZE) {
-		address -= (EDB_WORDSIZE - a);                       // LE + BE
-		mask = ~(0xffUL << (CHAR_BIT * (EDB_WORDSIZE - a))); // LE
-		v <<= CHAR_BIT * (EDB_WORDSIZE - a);                 // LE
-	} else {
-		mask = ~0xffUL; // LE
-	}
-#else /* BIG ENDIAN */
-	if(a < EDB_WORDSIZE) {
-		address -= (EDB_WORDSIZE - a);            // LE + BE
-		mask = ~(0xffUL << (CHAR_BIT * (a - 1))); // BE
-		v <<= CHAR_BIT * (a - 1);                 // BE
-	} else {
-		mask = ~(0xffUL << (CHAR_BIT * (EDB_WORDSIZE - 1))); // BE
-		v <<= CHAR_BIT * (EDB_WORDSIZE - 1);                 // BE
-	}
-#endif
+		if(process_vm_writev_works) {
+			struct iovec local_iov;
+			struct iovec remote_iov[ReadChunkPages];
+
+			edb::address_t remote_address = address + total;
+			std::size_t remaining         = len - total;
+			int iov_count                 = 0;
+			std::size_t chunk_len         = 0;
+
+			while(remaining != 0 && iov_count < ReadChunkPages) {
+				const std::size_t to_boundary = page_size - (remote_address & (page_size - 1));
+				const std::size_t n_bytes     = qMin(to_boundary, remaining);
+
+				remote_iov[iov_count].iov_base = reinterpret_cast<void *>(remote_address);
+				remote_iov[iov_count].iov_len  = n_bytes;
 
-	v |= (core_->read_data(address, ok) & mask);
-	if(*ok) {
-		*ok = core_->write_data(address, v);
+				remote_address += n_bytes;
+				remaining      -= n_bytes;
+				chunk_len      += n_bytes;
+				++iov_count;
+			}
+
+			local_iov.iov_base = const_cast<quint8 *>(ptr + total);
+			local_iov.iov_len  = chunk_len;
+
+			n = process_vm_writev(pid_, &local_iov, 1, remote_iov, iov_count, 0);
+			if(counted) {
+				edb::diagnostics::add(writev_counter, qMax<ssize_t>(n, 0));
+			}
+			if(n == -1 && (errno == ENOSYS || errno == EPERM)) {
+				process_vm_writev_works = false;
+			}
+		}
+
+		if(n <= 0) {
+			// most likely a read-only page such as .text, /proc/<pid>/mem
+			// will write through the protection for us
+			const edb::address_t remote_address = address + total;
+			const std::size_t to_boundary       = page_size - (remote_address & (page_size - 1));
+			const std::size_t n_bytes           = qMin(to_boundary, len - total);
+
+			if(core_->memory_fd_ == -1) {
+				break;
+			}
+
+			n = pwrite64(core_->memory_fd_, ptr + total, n_bytes, remote_address);
+			if(counted) {
+				edb::diagnostics::add(pwrite_counter, qMax<ssize_t>(n, 0));
+			}
+			if(n <= 0) {
+				break;
+			}
+		}
+
+		total += n;
 	}
 
+	return total;
 }
 
 //------------------------------------------------------------------------------
-// Name: read_byte
-// Desc: reads a single bytes at a given address
+// Name: write_words
+// Desc: writes <len> bytes from <buf> starting at <address> using ptrace. Only
+//       the partial words at either end need to be read first, everything in
+//       between is stored a whole word at a time
+// Note: words are always aligned, so they never straddle a page boundary
 //------------------------------------------------------------------------------
-quint8 PlatformProcess::read_byte(edb::address_t address, bool *ok) {
+bool PlatformProcess::write_words(edb::address_t address, const void *buf, std::size_t len) {
 
-	const quint8 ret = read_byte_base(address, ok);
+	const quint8 *p = reinterpret_cast<const quint8 *>(buf);
 
-	if(ok) {
-		if(const IBreakpoint::pointer bp = core_->find_breakpoint(address)) {
-			return bp->original_byte();
+	while(len != 0) {
+		const edb::address_t word_address = address & ~static_cast<edb::address_t>(EDB_WORDSIZE - 1);
+		const std::size_t offset          = address - word_address;
+		const std::size_t n               = qMin(EDB_WORDSIZE - offset, len);
+
+		long v;
+		if(n == EDB_WORDSIZE) {
+			std::memcpy(&v, p, sizeof(v));
+		} else {
+			bool ok;
+			v = core_->read_data(word_address, &ok);
+			if(!ok) {
+				return false;
+			}
+
+			std::memcpy(reinterpret_cast<quint8 *>(&v) + offset, p, n);
+		}
+
+		if(!core_->write_data(word_address, v)) {
+			return false;
 		}
+
+		address += n;
+		p       += n;
+		len     -= n;
 	}
 
-	return ret;
+	return true;
 }
 
 //------------------------------------------------------------------------------
-// Name: read_byte_base
-// Desc: the base implementation of reading a byte
+// Name: write_bytes
+// Desc: writes <len> bytes from <buf> starting at <address>
+// Note: assumes the this will not trample any breakpoints, must be handled
+//       in calling code!
 //------------------------------------------------------------------------------
-quint8 PlatformProcess::read_byte_base(edb::address_t address, bool *ok) {
+bool PlatformProcess::write_bytes(edb::address_t address, const void *buf, std::size_t len) {
 	// TODO(eteran): assert that we are paused
 
-	Q_ASSERT(ok);
+	static edb::diagnostics::Counter *const bytes_written = edb::diagnostics::counter("process: write_bytes");
 
-	*ok = false;
-	errno = -1;
+	Q_ASSERT(buf);
 
-	// if this spot is unreadable, then just return 0xff, otherwise
-	// continue as normal.
+	edb::diagnostics::add(bytes_written, len);
 
-	// core_->page_size() - 1 will always be 0xf* because pagesizes
-	// are always 0x10*, so the masking works
-	// range of a is [1..n] where n=pagesize, and we have to adjust
-	// if a < wordsize
-	const edb::address_t a = core_->page_size() - (address & (core_->page_size() - 1));
+	// a queued write must not land on top of this one
+	wait_for_service();
 
-	if(a < EDB_WORDSIZE) {
-		address -= (EDB_WORDSIZE - a); // LE + BE
+	std::size_t n = 0;
+
+	// small writes (breakpoints mostly) are cheapest done with ptrace, bigger
+	// ones go a page at a time with whatever is left over done with ptrace
+	if(len >= WriteBulkThreshold) {
+		n = write_memory(address, buf, len);
 	}
 
-	long value = core_->read_data(address, ok);
+	const bool ok = (n == len) || write_words(address + n, reinterpret_cast<const quint8 *>(buf) + n, len - n);
 
-	if(*ok) {
-#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
-		if(a < EDB_WORDSIZE) {
-			value >>= CHAR_BIT * (EDB_WORDSIZE - a); // LE
-		}
-#else
-		if(a < EDB_WORDSIZE) {
-			value >>= CHAR_BIT * (a - 1);            // BE
-		} else {
-			value >>= CHAR_BIT * (EDB_WORDSIZE - 1); // BE
-		}
-#endif
-		return value & 0xff;
+	memory_generation_ = next_memory_generation();
+
+	// keep the page cache in sync with what is really there
+	if(ok) {
+		cache_.write(address, buf, len);
+	} else {
+		cache_.invalidate(address, len);
 	}
 
-	return 0xff;
+	core_->breakpoint_guard_.written(address, len);
+
+	return ok;
+}
+
+//------------------------------------------------------------------------------
+// Name: wait_for_service
+// Desc: if there are writes still queued on the memory service, waits for
+//       them (and everything queued before them) to be done, so that what we
+//       are about to read or write comes after them
+//------------------------------------------------------------------------------
+void PlatformProcess::wait_for_service() {
+	if(pending_writes_.fetchAndAddOrdered(0) != 0) {
+		core_->memory_service_.waitForDone();
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: read_bytes_async
+// Desc: queues a read of <len> bytes starting at <address> on the memory
+//       service, it sees every write which was asked for before it
+//------------------------------------------------------------------------------
+QFuture<IProcess::AsyncRead> PlatformProcess::read_bytes_async(edb::address_t address, size_t len) {
+
+	ReadJob *const job = new ReadJob(this, address, len);
+	const QFuture<AsyncRead> future = job->future();
+	core_->memory_service_.start(job);
+	return future;
+}
+
+//------------------------------------------------------------------------------
+// Name: write_bytes_async
+// Desc: queues a write of <bytes> at <address> on the memory service. Like
+//       write_bytes it doesn't look after breakpoints
+// Note: only for the UI thread, the range is dropped from the page cache
+//       right away and reads made through it wait for the write
+//------------------------------------------------------------------------------
+QFuture<bool> PlatformProcess::write_bytes_async(edb::address_t address, const QByteArray &bytes) {
+
+	cache_.invalidate(address, bytes.size());
+	memory_generation_ = next_memory_generation();
+	core_->breakpoint_guard_.written(address, bytes.size());
+
+	pending_writes_.fetchAndAddOrdered(1);
+
+	WriteJob *const job = new WriteJob(this, address, bytes);
+	const QFuture<bool> future = job->future();
+	core_->memory_service_.start(job);
+	return future;
 }
 
 //------------------------------------------------------------------------------
@@ -543,23 +1125,70 @@ edb::address_t PlatformProcess::data_address() const {
 // Desc:
 //------------------------------------------------------------------------------
 QList<IRegion::pointer> PlatformProcess::regions() const {
-	QList<IRegion::pointer> regions;
 
-	const QString map_file(QString("/proc/%1/maps").arg(pid_));
+	char path[64];
+	snprintf(path, sizeof(path), "/proc/%d/maps", static_cast<int>(pid_));
 
-	QFile file(map_file);
-    if(file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+	const int fd = ::open(path, O_RDONLY | O_CLOEXEC);
+	if(fd == -1) {
+		return QList<IRegion::pointer>();
+	}
 
-		QTextStream in(&file);
-		QString line = in.readLine();
+	// files in /proc don't have a size, so read until there is no more. The
+	// buffer is kept between calls so this normally doesn't allocate
+	if(maps_buffer_.size() < 16384) {
+		maps_buffer_.resize(16384);
+	}
 
-		while(!line.isNull()) {
-			if(IRegion::pointer region = process_map_line(line)) {
-				regions.push_back(region);
-			}
-			line = in.readLine();
+	int size = 0;
+	for(;;) {
+		if(size == maps_buffer_.size()) {
+			maps_buffer_.resize(size * 2);
+		}
+
+		const ssize_t n = ::read(fd, maps_buffer_.data() + size, maps_buffer_.size() - size);
+		if(n == -1 && errno == EINTR) {
+			continue;
+		}
+
+		if(n <= 0) {
+			break;
+		}
+
+		size += n;
+	}
+
+	::close(fd);
+
+	// when nothing was mapped, unmapped or protected since last time
+	// the file is byte for byte the same, so don't bother parsing it
+	if(size == maps_data_.size() && std::memcmp(maps_buffer_.constData(), maps_data_.constData(), size) == 0) {
+		return regions_;
+	}
+
+	QList<IRegion::pointer> regions;
+
+	const char *p         = maps_buffer_.constData();
+	const char *const end = p + size;
+
+	while(p != end) {
+		const char *eol = static_cast<const char *>(std::memchr(p, '\n', end - p));
+		if(!eol) {
+			eol = end;
 		}
+
+		if(IRegion::pointer region = process_map_line(p, eol, names_)) {
+			regions.push_back(region);
+		}
+
+		p = (eol == end) ? end : eol + 1;
 	}
 
+	// keep what we just read for next time, the old copy becomes the buffer
+	maps_buffer_.resize(size);
+	qSwap(maps_data_, maps_buffer_);
+	maps_buffer_.resize(maps_buffer_.capacity());
+
+	regions_ = regions;
 	return regions;
 }
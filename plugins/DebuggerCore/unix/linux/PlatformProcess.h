@@ -3,6 +3,10 @@
 #define PLATOFORM_PROCESS_20150517_H_
 
 #include "IProcess.h"
+#include "PageCache.h"
+#include <QAtomicInt>
+#include <QByteArray>
+#include <QHash>
 
 namespace DebuggerCore {
 
@@ -28,15 +32,43 @@ public:
 	virtual bool write_bytes(edb::address_t address, const void *buf, size_t len);
 	virtual bool read_bytes(edb::address_t address, void *buf, size_t len);
 	virtual bool read_pages(edb::address_t address, void *buf, size_t count);
+	virtual QVector<bool> read_batch(const QVector<ReadRequest> &requests);
+	virtual quint64 memory_generation() const { return memory_generation_; }
+
+public:
+	virtual QFuture<AsyncRead> read_bytes_async(edb::address_t address, size_t len);
+	virtual QFuture<bool> write_bytes_async(edb::address_t address, const QByteArray &bytes);
+
+public:
+	void flush_cache();
 
 private:
-	quint8 read_byte(edb::address_t address, bool *ok);
-	void write_byte(edb::address_t address, quint8 value, bool *ok);
-	quint8 read_byte_base(edb::address_t address, bool *ok);
+	std::size_t read_memory(edb::address_t address, void *buf, std::size_t len);
+	std::size_t read_uncached(edb::address_t address, void *buf, std::size_t len, bool counted = true);
+	bool read_cached(edb::address_t address, void *buf, std::size_t len) const;
+	bool cache_usable();
+	void patch_breakpoints(edb::address_t address, void *buf, std::size_t len) const;
+	std::size_t write_memory(edb::address_t address, const void *buf, std::size_t len, bool counted = true);
+	void wait_for_service();
+	bool write_words(edb::address_t address, const void *buf, std::size_t len);
+
+private:
+	class ReadJob;
+	class WriteJob;
 
 private:
 	DebuggerCore* core_;
 	edb::pid_t    pid_;
+	PageCache     cache_;
+	quint64       memory_generation_;
+	QAtomicInt    pending_writes_;
+
+private:
+	// the last maps file we parsed and what we got from it
+	mutable QByteArray                 maps_data_;
+	mutable QByteArray                 maps_buffer_;
+	mutable QList<IRegion::pointer>    regions_;
+	mutable QHash<QByteArray, QString> names_;
 };
 
 }
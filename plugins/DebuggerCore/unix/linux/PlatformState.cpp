@@ -17,14 +17,85 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
 #include "PlatformState.h"
+#include "DebuggerCore.h"
+#include "ObjectPool.h"
+
+#include <algorithm>
+#include <cpuid.h>
+#include <cstring>
 
 namespace DebuggerCore {
 
+namespace {
+
+#if defined(EDB_X86)
+const int vector_register_count = 8;
+const int zmm_register_count    = 8;
+#elif defined(EDB_X86_64)
+const int vector_register_count = 16;
+const int zmm_register_count    = 32;
+#endif
+
+// offset of XSTATE_BV in the XSAVE header
+const std::size_t xstate_bv_offset = 512;
+
+//------------------------------------------------------------------------------
+// Name: xstate_layout
+// Desc: where each XSAVE component lives, the ptrace regset always uses the
+//       standard (non-compacted) format, so CPUID tells us everything
+//------------------------------------------------------------------------------
+struct xstate_layout {
+	xstate_layout() : size(0) {
+		std::memset(offset, 0, sizeof(offset));
+		std::memset(length, 0, sizeof(length));
+
+		unsigned int eax;
+		unsigned int ebx;
+		unsigned int ecx;
+		unsigned int edx;
+
+		if(__get_cpuid_max(0, 0) >= 0xd) {
+			__cpuid(1, eax, ebx, ecx, edx);
+			if(ecx & bit_OSXSAVE) {
+				__cpuid_count(0xd, 0, eax, ebx, ecx, edx);
+				size = ebx;
+
+				for(int i = PlatformState::XSTATE_AVX; i <= PlatformState::XSTATE_HI16_ZMM; ++i) {
+					__cpuid_count(0xd, i, eax, ebx, ecx, edx);
+					length[i] = eax;
+					offset[i] = ebx;
+				}
+
+				// the XMM registers are in the legacy FXSAVE region
+				offset[PlatformState::XSTATE_SSE] = 160;
+				length[PlatformState::XSTATE_SSE] = 256;
+			}
+		}
+	}
+
+	std::size_t size;
+	std::size_t offset[8];
+	std::size_t length[8];
+};
+
+//------------------------------------------------------------------------------
+// Name: layout
+// Desc:
+//------------------------------------------------------------------------------
+const xstate_layout &layout() {
+	static const xstate_layout instance;
+	return instance;
+}
+
+ObjectPool<PlatformState> state_pool;
+
+}
+
 //------------------------------------------------------------------------------
 // Name: PlatformState
 // Desc:
 //------------------------------------------------------------------------------
-PlatformState::PlatformState() {
+PlatformState::PlatformState() : core_(0), tid_(0), generation_(0), loaded_(GROUP_ALL), dirty_(0) {
 	memset(&regs_, 0, sizeof(regs_));
 	memset(&fpregs_, 0, sizeof(fpregs_));
 	memset(&dr_, 0, sizeof(dr_));
@@ -34,6 +105,22 @@ PlatformState::PlatformState() {
 #endif
 }
 
+//------------------------------------------------------------------------------
+// Name: operator new
+// Desc:
+//------------------------------------------------------------------------------
+void *PlatformState::operator new(std::size_t size) {
+	return state_pool.allocate(size);
+}
+
+//------------------------------------------------------------------------------
+// Name: operator delete
+// Desc:
+//------------------------------------------------------------------------------
+void PlatformState::operator delete(void *p, std::size_t size) {
+	state_pool.release(p, size);
+}
+
 //------------------------------------------------------------------------------
 // Name: PlatformState::clone
 // Desc: makes a copy of the state object
@@ -42,6 +129,31 @@ IState *PlatformState::clone() const {
 	return new PlatformState(*this);
 }
 
+//------------------------------------------------------------------------------
+// Name: xstate_size
+// Desc: returns the size of the XSAVE area for the enabled features, or 0 if
+//       the CPU or kernel doesn't support XSAVE
+//------------------------------------------------------------------------------
+std::size_t PlatformState::xstate_size() {
+	return layout().size;
+}
+
+//------------------------------------------------------------------------------
+// Name: load
+// Desc: makes sure that <groups> have been read from the thread
+//------------------------------------------------------------------------------
+void PlatformState::load(quint32 groups) const {
+	const quint32 missing = groups & ~loaded_;
+	if(missing) {
+		if(core_) {
+			core_->load_state(const_cast<PlatformState *>(this), missing);
+		}
+
+		// even if we couldn't get them, don't keep trying
+		loaded_ |= missing;
+	}
+}
+
 //------------------------------------------------------------------------------
 // Name: flags_to_string
 // Desc: returns the flags in a string form appropriate for this platform
@@ -111,8 +223,8 @@ Register PlatformState::value(const QString &reg) const {
 	else if(lreg == "fs")      return Register("fs", regs_.xfs, Register::TYPE_SEG);
 	else if(lreg == "gs")      return Register("gs", regs_.xgs, Register::TYPE_SEG);
 	else if(lreg == "ss")      return Register("ss", regs_.xss, Register::TYPE_SEG);
-	else if(lreg == "fs_base") return Register("fs_base", fs_base, Register::TYPE_SEG);
-	else if(lreg == "gs_base") return Register("gs_base", gs_base, Register::TYPE_SEG);
+	else if(lreg == "fs_base") { load(GROUP_SEGMENT_BASE); return Register("fs_base", fs_base, Register::TYPE_SEG); }
+	else if(lreg == "gs_base") { load(GROUP_SEGMENT_BASE); return Register("gs_base", gs_base, Register::TYPE_SEG); }
 	else if(lreg == "eflags")  return Register("eflags", regs_.eflags, Register::TYPE_COND);
 #if 0
 	else if(lreg == "mxcsr")   return Register("mxcsr", fpregs_.mxcsr, Register::TYPE_COND);
@@ -196,7 +308,7 @@ Register PlatformState::value(const QString &reg) const {
 	else if(lreg == "fs_base") return Register("fs_base", regs_.fs_base, Register::TYPE_SEG);
 	else if(lreg == "gs_base") return Register("gs_base", regs_.gs_base, Register::TYPE_SEG);
 	else if(lreg == "rflags")  return Register("rflags", regs_.eflags, Register::TYPE_COND);
-	else if(lreg == "mxcsr")   return Register("mxcsr", fpregs_.mxcsr, Register::TYPE_COND);
+	else if(lreg == "mxcsr")   { load(GROUP_FPU); return Register("mxcsr", fpregs_.mxcsr, Register::TYPE_COND); }
 #endif
 
 	return Register();
@@ -243,6 +355,7 @@ edb::address_t PlatformState::stack_pointer() const {
 // Desc:
 //------------------------------------------------------------------------------
 edb::reg_t PlatformState::debug_register(int n) const {
+	load(GROUP_DEBUG);
 	return dr_[n];
 }
 
@@ -264,6 +377,8 @@ edb::reg_t PlatformState::flags() const {
 //------------------------------------------------------------------------------
 long double PlatformState::fpu_register(int n) const {
 
+	load(GROUP_FPU);
+
 	if(sizeof(long double) == 16) {
 		// st_space is an array of 128 bytes, 16 bytes for each of 8 FPU registers
 		const long double *const p = reinterpret_cast<const long double *>(fpregs_.st_space);
@@ -282,6 +397,7 @@ void PlatformState::adjust_stack(int bytes) {
 #elif defined(EDB_X86_64)
 	regs_.rsp += bytes;
 #endif
+	dirty_ |= GROUP_GPR;
 }
 
 //------------------------------------------------------------------------------
@@ -289,9 +405,13 @@ void PlatformState::adjust_stack(int bytes) {
 // Desc:
 //------------------------------------------------------------------------------
 void PlatformState::clear() {
+	core_   = 0;
+	loaded_ = GROUP_ALL;
+	dirty_  = 0;
 	memset(&regs_, 0, sizeof(regs_));
 	memset(&fpregs_, 0, sizeof(fpregs_));
 	memset(&dr_, 0, sizeof(dr_));
+	xstate_.clear();
 #if defined(EDB_X86)
 	fs_base = 0;
 	gs_base = 0;
@@ -303,7 +423,9 @@ void PlatformState::clear() {
 // Desc:
 //------------------------------------------------------------------------------
 void PlatformState::set_debug_register(int n, edb::reg_t value) {
+	load(GROUP_DEBUG);
 	dr_[n] = value;
+	dirty_ |= GROUP_DEBUG;
 }
 
 //------------------------------------------------------------------------------
@@ -316,6 +438,7 @@ void PlatformState::set_flags(edb::reg_t flags) {
 #elif defined(EDB_X86_64)
 	regs_.eflags = flags;
 #endif
+	dirty_ |= GROUP_GPR;
 }
 
 //------------------------------------------------------------------------------
@@ -330,6 +453,7 @@ void PlatformState::set_instruction_pointer(edb::address_t value) {
 	regs_.rip = value;
 	regs_.orig_rax = -1;
 #endif
+	dirty_ |= GROUP_GPR;
 }
 
 //------------------------------------------------------------------------------
@@ -428,8 +552,9 @@ void PlatformState::set_register(const QString &name, edb::reg_t value) {
 	else if(lreg == "gs") { regs_.gs = value; }
 	else if(lreg == "ss") { regs_.ss = value; }
 	else if(lreg == "rflags") { regs_.eflags = value; }
-	else if(lreg == "mxcsr") { fpregs_.mxcsr = value; }
+	else if(lreg == "mxcsr") { load(GROUP_FPU); fpregs_.mxcsr = value; dirty_ |= GROUP_FPU; return; }
 #endif
+	dirty_ |= GROUP_GPR;
 }
 
 //------------------------------------------------------------------------------
@@ -439,6 +564,8 @@ void PlatformState::set_register(const QString &name, edb::reg_t value) {
 quint64 PlatformState::mmx_register(int n) const {
 
 	if(n >= 0 && n <= 7) {
+		load(GROUP_FPU);
+
 		// MMX registers are an alias to the lower 64-bits of the FPU regs
 		const uint64_t *const p = reinterpret_cast<const uint64_t *>(fpregs_.st_space);
 		return p[n * 2];
@@ -456,6 +583,7 @@ QByteArray PlatformState::xmm_register(int n) const {
 #if defined(EDB_X86)
 #elif defined(EDB_X86_64)
 	if(n >= 0 && n <= 16) {
+		load(GROUP_FPU);
 		const uint8_t *const p = reinterpret_cast<const uint8_t *>(fpregs_.xmm_space);
 		const uint8_t *r = &p[n * 16];
 		QByteArray ret(reinterpret_cast<const char *>(r), 16);
@@ -467,4 +595,185 @@ QByteArray PlatformState::xmm_register(int n) const {
 	return 0;
 }
 
+//------------------------------------------------------------------------------
+// Name: xstate_component
+// Desc: returns a pointer to <component> in the XSAVE area, or NULL if we
+//       don't have it. <in_use> is false if the component is in its initial
+//       (all zero) state, in which case the kernel needn't have filled it in
+//------------------------------------------------------------------------------
+const char *PlatformState::xstate_component(int component, bool *in_use) const {
+
+	load(GROUP_XSTATE);
+
+	const xstate_layout &l    = layout();
+	const std::size_t   size = static_cast<std::size_t>(xstate_.size());
+
+	if(size < xstate_bv_offset + sizeof(quint64) || l.length[component] == 0 || l.offset[component] + l.length[component] > size) {
+		return 0;
+	}
+
+	quint64 xstate_bv;
+	std::memcpy(&xstate_bv, xstate_.constData() + xstate_bv_offset, sizeof(xstate_bv));
+
+	*in_use = (xstate_bv & (Q_UINT64_C(1) << component)) != 0;
+	return xstate_.constData() + l.offset[component];
+}
+
+//------------------------------------------------------------------------------
+// Name: xstate_register
+// Desc: assembles vector register <n> which is <width> bytes wide from the
+//       XSAVE components which hold its pieces
+//------------------------------------------------------------------------------
+QByteArray PlatformState::xstate_register(int n, int width) const {
+
+	QByteArray ret(width, 0);
+	bool in_use = false;
+
+	if(n < vector_register_count) {
+		const char *const sse = xstate_component(XSTATE_SSE, &in_use);
+		if(!sse) {
+			return QByteArray();
+		}
+
+		if(in_use) {
+			std::memcpy(ret.data(), sse + n * 16, 16);
+		}
+
+		const char *const avx = xstate_component(XSTATE_AVX, &in_use);
+		if(!avx) {
+			return QByteArray();
+		}
+
+		if(in_use) {
+			std::memcpy(ret.data() + 16, avx + n * 16, 16);
+		}
+
+		if(width == 64) {
+			const char *const zmm_hi = xstate_component(XSTATE_ZMM_HI256, &in_use);
+			if(!zmm_hi) {
+				return QByteArray();
+			}
+
+			if(in_use) {
+				std::memcpy(ret.data() + 32, zmm_hi + n * 32, 32);
+			}
+		}
+	} else {
+		// ZMM16-31 are stored whole
+		const char *const zmm = xstate_component(XSTATE_HI16_ZMM, &in_use);
+		if(!zmm) {
+			return QByteArray();
+		}
+
+		if(in_use) {
+			std::memcpy(ret.data(), zmm + (n - vector_register_count) * 64, 64);
+		}
+	}
+
+	// little endian!
+	std::reverse(ret.begin(), ret.end());
+	return ret;
+}
+
+//------------------------------------------------------------------------------
+// Name: ymm_register
+// Desc:
+//------------------------------------------------------------------------------
+QByteArray PlatformState::ymm_register(int n) const {
+	if(n >= 0 && n < vector_register_count) {
+		return xstate_register(n, 32);
+	}
+	return QByteArray();
+}
+
+//------------------------------------------------------------------------------
+// Name: zmm_register
+// Desc:
+//------------------------------------------------------------------------------
+QByteArray PlatformState::zmm_register(int n) const {
+	if(n >= 0 && n < zmm_register_count) {
+		return xstate_register(n, 64);
+	}
+	return QByteArray();
+}
+
+//------------------------------------------------------------------------------
+// Name: register_index
+// Desc: for the full width general purpose registers, the index is their
+//       offset in user_regs_struct
+// Note: fs and gs are deliberately left out, expressions treat them as their
+//       base addresses rather than the selectors
+//------------------------------------------------------------------------------
+int PlatformState::register_index(const QString &name) const {
+
+	struct register_offset {
+		const char *name;
+		int         offset;
+	};
+
+	static const register_offset offsets[] = {
+#if defined(EDB_X86)
+		{ "eax",    offsetof(struct user_regs_struct, eax)    },
+		{ "ebx",    offsetof(struct user_regs_struct, ebx)    },
+		{ "ecx",    offsetof(struct user_regs_struct, ecx)    },
+		{ "edx",    offsetof(struct user_regs_struct, edx)    },
+		{ "ebp",    offsetof(struct user_regs_struct, ebp)    },
+		{ "esp",    offsetof(struct user_regs_struct, esp)    },
+		{ "esi",    offsetof(struct user_regs_struct, esi)    },
+		{ "edi",    offsetof(struct user_regs_struct, edi)    },
+		{ "eip",    offsetof(struct user_regs_struct, eip)    },
+		{ "eflags", offsetof(struct user_regs_struct, eflags) },
+		{ "cs",     offsetof(struct user_regs_struct, xcs)    },
+		{ "ds",     offsetof(struct user_regs_struct, xds)    },
+		{ "es",     offsetof(struct user_regs_struct, xes)    },
+		{ "ss",     offsetof(struct user_regs_struct, xss)    },
+#elif defined(EDB_X86_64)
+		{ "rax",    offsetof(struct user_regs_struct, rax)    },
+		{ "rbx",    offsetof(struct user_regs_struct, rbx)    },
+		{ "rcx",    offsetof(struct user_regs_struct, rcx)    },
+		{ "rdx",    offsetof(struct user_regs_struct, rdx)    },
+		{ "rbp",    offsetof(struct user_regs_struct, rbp)    },
+		{ "rsp",    offsetof(struct user_regs_struct, rsp)    },
+		{ "rsi",    offsetof(struct user_regs_struct, rsi)    },
+		{ "rdi",    offsetof(struct user_regs_struct, rdi)    },
+		{ "r8",     offsetof(struct user_regs_struct, r8)     },
+		{ "r9",     offsetof(struct user_regs_struct, r9)     },
+		{ "r10",    offsetof(struct user_regs_struct, r10)    },
+		{ "r11",    offsetof(struct user_regs_struct, r11)    },
+		{ "r12",    offsetof(struct user_regs_struct, r12)    },
+		{ "r13",    offsetof(struct user_regs_struct, r13)    },
+		{ "r14",    offsetof(struct user_regs_struct, r14)    },
+		{ "r15",    offsetof(struct user_regs_struct, r15)    },
+		{ "rip",    offsetof(struct user_regs_struct, rip)    },
+		{ "rflags", offsetof(struct user_regs_struct, eflags) },
+		{ "cs",     offsetof(struct user_regs_struct, cs)     },
+		{ "ds",     offsetof(struct user_regs_struct, ds)     },
+		{ "es",     offsetof(struct user_regs_struct, es)     },
+		{ "ss",     offsetof(struct user_regs_struct, ss)     },
+#endif
+	};
+
+	const QString lreg = name.toLower();
+	for(std::size_t i = 0; i < sizeof(offsets) / sizeof(offsets[0]); ++i) {
+		if(lreg == QLatin1String(offsets[i].name)) {
+			return offsets[i].offset;
+		}
+	}
+
+	return -1;
+}
+
+//------------------------------------------------------------------------------
+// Name: register_value
+// Desc:
+//------------------------------------------------------------------------------
+edb::reg_t PlatformState::register_value(int index) const {
+	if(index >= 0 && static_cast<std::size_t>(index) + sizeof(edb::reg_t) <= sizeof(regs_)) {
+		edb::reg_t value;
+		std::memcpy(&value, reinterpret_cast<const char *>(&regs_) + index, sizeof(value));
+		return value;
+	}
+	return 0;
+}
+
 }
@@ -21,16 +21,52 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "IState.h"
 #include "Types.h"
+#include <QByteArray>
+#include <cstddef>
 #include <sys/user.h>
 
 namespace DebuggerCore {
 
+class DebuggerCore;
+
 class PlatformState : public IState {
 	friend class DebuggerCore;
 
+public:
+	// the register sets we get from the kernel, only the general purpose
+	// registers are read when the state is fetched, the rest are read the
+	// first time somebody actually looks at them
+	enum Group {
+		GROUP_GPR          = 0x01,
+		GROUP_FPU          = 0x02,
+		GROUP_DEBUG        = 0x04,
+		GROUP_SEGMENT_BASE = 0x08,
+		GROUP_XSTATE       = 0x10,
+		GROUP_ALL          = 0x1f
+	};
+
+public:
+	// the XSAVE state components we know how to display
+	enum XStateComponent {
+		XSTATE_SSE       = 1,
+		XSTATE_AVX       = 2,
+		XSTATE_OPMASK    = 5,
+		XSTATE_ZMM_HI256 = 6,
+		XSTATE_HI16_ZMM  = 7
+	};
+
+public:
+	static std::size_t xstate_size();
+
+
 public:
 	PlatformState();
 
+public:
+	// every stop makes a few of these, so they come from a pool
+	static void *operator new(std::size_t size);
+	static void operator delete(void *p, std::size_t size);
+
 public:
 	virtual IState *clone() const;
 
@@ -52,15 +88,37 @@ public:
 	virtual void set_register(const QString &name, edb::reg_t value);
 	virtual quint64 mmx_register(int n) const;
 	virtual QByteArray xmm_register(int n) const;
+	virtual QByteArray ymm_register(int n) const;
+	virtual QByteArray zmm_register(int n) const;
 	virtual Register gp_register(int n) const;
-	
+	virtual int register_index(const QString &name) const;
+	virtual edb::reg_t register_value(int index) const;
+
+private:
+	void load(quint32 groups) const;
+	const char *xstate_component(int component, bool *in_use) const;
+	QByteArray xstate_register(int n, int width) const;
+
+private:
+	// where lazily loaded groups come from, they are only fetched if the
+	// thread hasn't run since the state was captured
+	DebuggerCore             *core_;
+	edb::tid_t                tid_;
+	quint64                   generation_;
+	mutable quint32           loaded_;
+
+	// the groups which have been modified since they were read, these are
+	// the only ones set_state needs to write back
+	quint32                   dirty_;
+
 private:
-	struct user_regs_struct   regs_;
-	struct user_fpregs_struct fpregs_;
-	edb::reg_t                dr_[8];
+	mutable struct user_regs_struct   regs_;
+	mutable struct user_fpregs_struct fpregs_;
+	mutable edb::reg_t                dr_[8];
+	mutable QByteArray                xstate_;
 #if defined(EDB_X86)
-	edb::address_t            fs_base;
-	edb::address_t            gs_base;
+	mutable edb::address_t            fs_base;
+	mutable edb::address_t            gs_base;
 #endif
 };
 
@@ -0,0 +1,275 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "ProfileSampler.h"
+#include "PerfEvent.h"
+
+#include <cstring>
+
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace DebuggerCore {
+
+namespace {
+
+// the number of pages in each thread's ring buffer, this must be a power of
+// two. The rings count against perf's locked memory limit, which is shared by
+// every thread, so they are kept small and need draining a few times a second
+const std::size_t RingPages = 32;
+
+// more than this many samples are counted as lost instead of kept
+const int MaxSamples = 1 << 20;
+
+}
+
+//------------------------------------------------------------------------------
+// Name: ProfileSampler
+// Desc: constructor
+//------------------------------------------------------------------------------
+ProfileSampler::ProfileSampler() : running_(false), frequency_(0), page_size_(0), lost_(0) {
+}
+
+//------------------------------------------------------------------------------
+// Name: ~ProfileSampler
+// Desc: destructor
+//------------------------------------------------------------------------------
+ProfileSampler::~ProfileSampler() {
+	stop();
+}
+
+//------------------------------------------------------------------------------
+// Name: start
+// Desc: starts sampling <threads> about <frequency> times a second each,
+//       returns false if the kernel can't do it for us
+//------------------------------------------------------------------------------
+bool ProfileSampler::start(const QList<edb::tid_t> &threads, int frequency, edb::address_t page_size) {
+
+	stop();
+
+	frequency_ = frequency;
+	page_size_ = page_size;
+	samples_.clear();
+	lost_ = 0;
+
+	Q_FOREACH(edb::tid_t tid, threads) {
+		Ring ring;
+		if(!open_ring(tid, &ring)) {
+			stop();
+			return false;
+		}
+		rings_.insert(tid, ring);
+	}
+
+	running_ = true;
+	return true;
+}
+
+//------------------------------------------------------------------------------
+// Name: stop
+// Desc: stops sampling, anything already collected can still be taken
+//------------------------------------------------------------------------------
+void ProfileSampler::stop() {
+
+	for(QHash<edb::tid_t, Ring>::iterator it = rings_.begin(); it != rings_.end(); ++it) {
+		close_ring(&it.value());
+	}
+
+	rings_.clear();
+	running_ = false;
+}
+
+//------------------------------------------------------------------------------
+// Name: add_thread
+// Desc: a thread which was created while sampling
+//------------------------------------------------------------------------------
+void ProfileSampler::add_thread(edb::tid_t tid) {
+
+	if(running_ && !rings_.contains(tid)) {
+		Ring ring;
+		if(open_ring(tid, &ring)) {
+			rings_.insert(tid, ring);
+		}
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: remove_thread
+// Desc: a thread which has exited, whatever it had recorded is kept
+//------------------------------------------------------------------------------
+void ProfileSampler::remove_thread(edb::tid_t tid) {
+
+	QHash<edb::tid_t, Ring>::iterator it = rings_.find(tid);
+	if(it != rings_.end()) {
+		close_ring(&it.value());
+		rings_.erase(it);
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: open_ring
+// Desc:
+//------------------------------------------------------------------------------
+bool ProfileSampler::open_ring(edb::tid_t tid, Ring *ring) const {
+
+	struct perf_event_attr attr;
+	std::memset(&attr, 0, sizeof(attr));
+	attr.size                     = sizeof(attr);
+	attr.type                     = PERF_TYPE_SOFTWARE;
+	attr.config                   = PERF_COUNT_SW_TASK_CLOCK;
+	attr.freq                     = 1;
+	attr.sample_freq              = frequency_;
+	attr.sample_type              = PERF_SAMPLE_IP | PERF_SAMPLE_TID | PERF_SAMPLE_CALLCHAIN;
+	attr.exclude_kernel           = 1;
+	attr.exclude_hv               = 1;
+	attr.exclude_callchain_kernel = 1;
+
+	ring->fd = perf_event_open(&attr, tid, -1, -1, 0);
+	if(ring->fd == -1) {
+		return false;
+	}
+
+	// the first page is the control page, the rest is the ring itself
+	ring->buffer = mmap(0, (RingPages + 1) * page_size_, PROT_READ | PROT_WRITE, MAP_SHARED, ring->fd, 0);
+	if(ring->buffer == MAP_FAILED) {
+		close(ring->fd);
+		return false;
+	}
+
+	return true;
+}
+
+//------------------------------------------------------------------------------
+// Name: close_ring
+// Desc:
+//------------------------------------------------------------------------------
+void ProfileSampler::close_ring(Ring *ring) {
+	ioctl(ring->fd, PERF_EVENT_IOC_DISABLE, 0);
+	collect(*ring);
+	munmap(ring->buffer, (RingPages + 1) * page_size_);
+	close(ring->fd);
+}
+
+//------------------------------------------------------------------------------
+// Name: collect
+// Desc: moves whatever the kernel has recorded out of the ring buffers
+//------------------------------------------------------------------------------
+void ProfileSampler::collect() {
+	Q_FOREACH(const Ring &ring, rings_) {
+		collect(ring);
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: collect
+// Desc:
+//------------------------------------------------------------------------------
+void ProfileSampler::collect(const Ring &ring) {
+
+	struct perf_event_mmap_page *const control = static_cast<struct perf_event_mmap_page *>(ring.buffer);
+
+	const quint8 *const data     = static_cast<const quint8 *>(ring.buffer) + page_size_;
+	const std::size_t   data_len = RingPages * page_size_;
+
+	const quint64 head = control->data_head;
+	__sync_synchronize();
+
+	quint64 tail = control->data_tail;
+	while(tail < head) {
+		struct perf_event_header header;
+		read_ring(data, data_len, tail, &header, sizeof(header));
+		if(header.size == 0) {
+			break;
+		}
+
+		switch(header.type) {
+		case PERF_RECORD_SAMPLE:
+			if(samples_.size() < MaxSamples) {
+				// the layout follows sample_type:
+				// { u64 ip; u32 pid, tid; u64 nr; u64 ips[nr]; }
+				quint64 fixed[3];
+				read_ring(data, data_len, tail + sizeof(header), fixed, sizeof(fixed));
+
+				ProfileSample sample;
+				sample.tid   = static_cast<edb::tid_t>(fixed[1] >> 32);
+				sample.ip    = static_cast<edb::address_t>(fixed[0]);
+				sample.depth = 0;
+
+				// the chain starts with the IP itself and has markers for
+				// the context the addresses which follow are in
+				const quint64 count = qMin<quint64>(fixed[2], (header.size - sizeof(header) - sizeof(fixed)) / sizeof(quint64));
+				bool skipped_ip = false;
+				for(quint64 i = 0; i < count && sample.depth < ProfileSample::MAX_DEPTH; ++i) {
+					quint64 address;
+					read_ring(data, data_len, tail + sizeof(header) + sizeof(fixed) + i * sizeof(address), &address, sizeof(address));
+					if(address >= static_cast<quint64>(PERF_CONTEXT_MAX)) {
+						continue;
+					}
+
+					if(!skipped_ip) {
+						skipped_ip = true;
+						continue;
+					}
+
+					sample.callers[sample.depth++] = static_cast<edb::address_t>(address);
+				}
+
+				samples_.push_back(sample);
+			} else {
+				++lost_;
+			}
+			break;
+		case PERF_RECORD_LOST:
+			{
+				// { u64 id; u64 lost; }
+				quint64 lost[2];
+				read_ring(data, data_len, tail + sizeof(header), lost, sizeof(lost));
+				lost_ += lost[1];
+			}
+			break;
+		default:
+			break;
+		}
+
+		tail += header.size;
+	}
+
+	// let the kernel know that it can reuse the space
+	__sync_synchronize();
+	control->data_tail = head;
+}
+
+//------------------------------------------------------------------------------
+// Name: take
+// Desc: returns the samples collected so far and forgets them
+//------------------------------------------------------------------------------
+QVector<ProfileSample> ProfileSampler::take(quint64 *lost) {
+
+	QVector<ProfileSample> ret;
+	qSwap(ret, samples_);
+
+	if(lost) {
+		*lost = lost_;
+	}
+
+	lost_ = 0;
+	return ret;
+}
+
+}
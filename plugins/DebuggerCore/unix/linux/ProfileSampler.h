@@ -0,0 +1,78 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef PROFILESAMPLER_20261014_H_
+#define PROFILESAMPLER_20261014_H_
+
+#include "ProfileSample.h"
+#include "Types.h"
+#include <QHash>
+#include <QList>
+#include <QVector>
+
+namespace DebuggerCore {
+
+// samples where every thread is using perf's task clock, so a thread is only
+// sampled while it actually runs. Each thread has a ring buffer of its own
+// which the kernel fills with the IP and a user space call chain (found by
+// following frame pointers) for each sample. The rings are drained with collect
+// which, unlike with BranchTracer, is fine to do while the threads are running
+class ProfileSampler {
+public:
+	ProfileSampler();
+	~ProfileSampler();
+
+public:
+	bool start(const QList<edb::tid_t> &threads, int frequency, edb::address_t page_size);
+	void stop();
+	bool running() const { return running_; }
+
+public:
+	void add_thread(edb::tid_t tid);
+	void remove_thread(edb::tid_t tid);
+
+public:
+	void collect();
+	QVector<ProfileSample> take(quint64 *lost);
+
+private:
+	Q_DISABLE_COPY(ProfileSampler)
+
+private:
+	struct Ring {
+		int   fd;
+		void *buffer;
+	};
+
+private:
+	bool open_ring(edb::tid_t tid, Ring *ring) const;
+	void close_ring(Ring *ring);
+	void collect(const Ring &ring);
+
+private:
+	QHash<edb::tid_t, Ring> rings_;
+	bool                    running_;
+	int                     frequency_;
+	edb::address_t          page_size_;
+	QVector<ProfileSample>  samples_;
+	quint64                 lost_;
+};
+
+}
+
+#endif
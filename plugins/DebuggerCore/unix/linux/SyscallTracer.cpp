@@ -0,0 +1,141 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "SyscallTracer.h"
+
+#include <cstring>
+
+namespace DebuggerCore {
+
+//------------------------------------------------------------------------------
+// Name: SyscallTracer
+// Desc: constructor
+//------------------------------------------------------------------------------
+SyscallTracer::SyscallTracer() : written_(0) {
+}
+
+//------------------------------------------------------------------------------
+// Name: start
+// Desc: starts a new trace of the syscalls in <numbers>, or all of them if it
+//       is empty, keeping the last <capacity> of them
+//------------------------------------------------------------------------------
+void SyscallTracer::start(const QList<edb::reg_t> &numbers, int capacity) {
+
+	stop();
+
+	numbers_.clear();
+	Q_FOREACH(edb::reg_t number, numbers) {
+		if(number >= static_cast<edb::reg_t>(numbers_.size())) {
+			numbers_.resize(number + 1);
+		}
+		numbers_.setBit(number);
+	}
+
+	buffer_.resize(qMax(capacity, 1));
+}
+
+//------------------------------------------------------------------------------
+// Name: stop
+// Desc:
+//------------------------------------------------------------------------------
+void SyscallTracer::stop() {
+	buffer_.clear();
+	pending_.clear();
+	written_ = 0;
+}
+
+//------------------------------------------------------------------------------
+// Name: wanted
+// Desc: true if syscall <number> is one which is being traced
+//------------------------------------------------------------------------------
+bool SyscallTracer::wanted(edb::reg_t number) const {
+	if(numbers_.isEmpty()) {
+		return true;
+	}
+
+	return number < static_cast<edb::reg_t>(numbers_.size()) && numbers_.testBit(number);
+}
+
+//------------------------------------------------------------------------------
+// Name: enter
+// Desc: <tid> is about to make syscall <number>, with the six argument
+//       registers in <arguments>
+//------------------------------------------------------------------------------
+void SyscallTracer::enter(edb::tid_t tid, edb::reg_t number, const edb::reg_t *arguments) {
+
+	if(!running() || !wanted(number)) {
+		return;
+	}
+
+	SyscallRecord &record = buffer_[written_ % buffer_.size()];
+	record.tid      = tid;
+	record.number   = number;
+	record.result   = 0;
+	record.returned = false;
+	std::memcpy(record.arguments, arguments, sizeof(record.arguments));
+
+	pending_.insert(tid, written_++);
+}
+
+//------------------------------------------------------------------------------
+// Name: leave
+// Desc: the syscall <tid> was in has returned <result>
+//------------------------------------------------------------------------------
+void SyscallTracer::leave(edb::tid_t tid, edb::reg_t result) {
+
+	QHash<edb::tid_t, quint64>::iterator it = pending_.find(tid);
+	if(it == pending_.end()) {
+		return;
+	}
+
+	// a thread which blocks for long enough can find its record overwritten
+	// by the time it returns
+	const quint64 sequence = it.value();
+	pending_.erase(it);
+
+	if(written_ - sequence <= static_cast<quint64>(buffer_.size())) {
+		SyscallRecord &record = buffer_[sequence % buffer_.size()];
+		record.result   = result;
+		record.returned = true;
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: records
+// Desc: what is in the buffer, oldest first. <lost> is set to the number of
+//       records which have been overwritten
+//------------------------------------------------------------------------------
+QVector<SyscallRecord> SyscallTracer::records(quint64 *lost) const {
+
+	const quint64 size  = buffer_.size();
+	const quint64 count = qMin(written_, size);
+
+	if(lost) {
+		*lost = written_ - count;
+	}
+
+	QVector<SyscallRecord> result;
+	result.reserve(count);
+	for(quint64 sequence = written_ - count; sequence != written_; ++sequence) {
+		result.push_back(buffer_[sequence % size]);
+	}
+
+	return result;
+}
+
+}
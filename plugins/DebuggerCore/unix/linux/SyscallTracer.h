@@ -0,0 +1,59 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SYSCALLTRACER_20261014_H_
+#define SYSCALLTRACER_20261014_H_
+
+#include "SyscallRecord.h"
+#include "Types.h"
+#include <QBitArray>
+#include <QHash>
+#include <QList>
+#include <QVector>
+
+namespace DebuggerCore {
+
+// keeps a ring buffer of the last few syscalls made by the threads of the
+// process, as the core sees them at their syscall stops. Calls which aren't
+// wanted are thrown away right there, so tracing only a few of them costs a
+// pair of stops per syscall and nothing more
+class SyscallTracer {
+public:
+	SyscallTracer();
+
+public:
+	void start(const QList<edb::reg_t> &numbers, int capacity);
+	void stop();
+	bool running() const { return !buffer_.isEmpty(); }
+	bool wanted(edb::reg_t number) const;
+
+public:
+	void enter(edb::tid_t tid, edb::reg_t number, const edb::reg_t *arguments);
+	void leave(edb::tid_t tid, edb::reg_t result);
+	QVector<SyscallRecord> records(quint64 *lost) const;
+
+private:
+	QVector<SyscallRecord>      buffer_;
+	quint64                     written_;  // every record ever entered
+	QBitArray                   numbers_;  // empty if all of them are wanted
+	QHash<edb::tid_t, quint64>  pending_;  // the record each thread is still in
+};
+
+}
+
+#endif
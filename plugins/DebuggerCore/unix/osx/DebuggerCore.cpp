@@ -25,6 +25,8 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <QDebug>
 
+#include <cstring>
+
 #include <fcntl.h>
 #include <mach/mach.h>
 #include <mach/mach_vm.h>
@@ -59,7 +61,7 @@ int resume_code(int status) {
 // Name: DebuggerCore
 // Desc: constructor
 //------------------------------------------------------------------------------
-DebuggerCore::DebuggerCore() {
+DebuggerCore::DebuggerCore() : task_(MACH_PORT_NULL) {
 	page_size_ = 0x1000;
 }
 
@@ -115,6 +117,131 @@ IDebugEvent::const_pointer DebuggerCore::wait_debug_event(int msecs) {
 	return IDebugEvent::const_pointer();
 }
 
+//------------------------------------------------------------------------------
+// Name: task
+// Desc: the mach task of the process, task_for_pid is not cheap so the port
+//       is kept until the process is detached from
+//------------------------------------------------------------------------------
+task_t DebuggerCore::task() const {
+
+	if(task_ == MACH_PORT_NULL && pid() != 0) {
+		const kern_return_t err = task_for_pid(mach_task_self(), pid(), &task_);
+		if(err != KERN_SUCCESS) {
+			qDebug("task_for_pid() failed with %x [%d]", err, pid());
+			task_ = MACH_PORT_NULL;
+		}
+	}
+
+	return task_;
+}
+
+//------------------------------------------------------------------------------
+// Name: release_task
+// Desc:
+//------------------------------------------------------------------------------
+void DebuggerCore::release_task() {
+	if(task_ != MACH_PORT_NULL) {
+		mach_port_deallocate(mach_task_self(), task_);
+		task_ = MACH_PORT_NULL;
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: read_memory
+// Desc: reads up to <len> bytes at <address> into <buf>, a whole run of
+//       readable pages with a single mach_vm_read_overwrite. Returns how many
+//       bytes were read, reading stops at the first page which can't be
+//       read at all
+// Note: this does not hide breakpoints
+//------------------------------------------------------------------------------
+std::size_t DebuggerCore::read_memory(edb::address_t address, void *buf, std::size_t len) const {
+
+	const task_t t = task();
+	if(t == MACH_PORT_NULL) {
+		return 0;
+	}
+
+	quint8 *const ptr = reinterpret_cast<quint8 *>(buf);
+
+	// one call for everything, the usual case
+	mach_vm_size_t size = 0;
+	if(mach_vm_read_overwrite(t, address, len, reinterpret_cast<mach_vm_address_t>(ptr), &size) == KERN_SUCCESS && size == len) {
+		return len;
+	}
+
+	// something in the range isn't readable, find out where it starts by
+	// going a page at a time
+	std::size_t total = 0;
+	while(total < len) {
+		const std::size_t n = qMin<std::size_t>(page_size_ - ((address + total) & (page_size_ - 1)), len - total);
+		if(mach_vm_read_overwrite(t, address + total, n, reinterpret_cast<mach_vm_address_t>(ptr + total), &size) != KERN_SUCCESS || size != n) {
+			break;
+		}
+		total += n;
+	}
+
+	return total;
+}
+
+//------------------------------------------------------------------------------
+// Name: read_bytes
+// Desc: reads <len> bytes into <buf> starting at <address>
+// Note: if the read failed, the part of the buffer that could not be read will
+//       be filled with 0xff bytes
+//------------------------------------------------------------------------------
+bool DebuggerCore::read_bytes(edb::address_t address, void *buf, std::size_t len) {
+
+	Q_ASSERT(buf);
+
+	if(len != 0) {
+		const std::size_t n = read_memory(address, buf, len);
+		if(n != len) {
+			std::memset(reinterpret_cast<quint8 *>(buf) + n, 0xff, len - n);
+		}
+
+		mask_breakpoints(address, buf, n);
+	}
+
+	return true;
+}
+
+//------------------------------------------------------------------------------
+// Name: read_pages
+// Desc: reads <count> pages from the process starting at <address>
+// Note: buf's size must be >= count * page_size()
+// Note: address should be page aligned.
+//------------------------------------------------------------------------------
+bool DebuggerCore::read_pages(edb::address_t address, void *buf, std::size_t count) {
+
+	Q_ASSERT(buf);
+
+	if((address & (page_size() - 1)) == 0) {
+		const std::size_t len = count * page_size();
+		const std::size_t n   = read_memory(address, buf, len);
+
+		mask_breakpoints(address, buf, n);
+		return n == len;
+	}
+
+	return false;
+}
+
+//------------------------------------------------------------------------------
+// Name: write_bytes
+// Desc: writes <len> bytes from <buf> starting at <address>
+//------------------------------------------------------------------------------
+bool DebuggerCore::write_bytes(edb::address_t address, const void *buf, std::size_t len) {
+
+	Q_ASSERT(buf);
+
+	const task_t t = task();
+	if(t == MACH_PORT_NULL) {
+		return false;
+	}
+
+	return mach_vm_write(t, address, reinterpret_cast<vm_offset_t>(buf), len) == KERN_SUCCESS;
+}
+
 //------------------------------------------------------------------------------
 // Name: read_data
 // Desc:
@@ -123,17 +250,8 @@ long DebuggerCore::read_data(edb::address_t address, bool *ok) {
 
 	Q_ASSERT(ok);
 
-	mach_port_t task;
-	kern_return_t err = task_for_pid(mach_task_self(), pid(), &task);
-	if(err != KERN_SUCCESS) {
-		qDebug("task_for_pid() failed with %x [%d]", err, pid());
-		*ok = false;
-		return -1;
-	}
-
-	long x;
-	vm_size_t size;
-	*ok =  vm_read_overwrite(task, address, sizeof(long), (vm_address_t)&x, &size) == 0;
+	long x = -1;
+	*ok = read_memory(address, &x, sizeof(x)) == sizeof(x);
 	return x;
 }
 
@@ -179,6 +297,7 @@ void DebuggerCore::detach() {
 			ptrace(PT_DETACH, it.key(), 0, 0);
 		}
 
+		release_task();
 		pid_ = 0;
 		threads_.clear();
 	}
@@ -193,6 +312,7 @@ void DebuggerCore::kill() {
 		clear_breakpoints();
 		ptrace(PT_KILL, pid(), 0, 0);
 		native::waitpid(pid(), 0, WAIT_ANY);
+		release_task();
 		pid_ = 0;
 		threads_.clear();
 	}
@@ -251,7 +371,7 @@ void DebuggerCore::get_state(State *state) {
 	Q_ASSERT(state);
 
 	// TODO: assert that we are paused
-	PlatformState *const state_impl = static_cast<PlatformState *>(state->impl_);
+	PlatformState *const state_impl = static_cast<PlatformState *>(state->detach());
 
 	if(attached()) {
 
@@ -591,80 +711,45 @@ edb::pid_t DebuggerCore::parent_pid(edb::pid_t pid) const {
 //------------------------------------------------------------------------------
 QList<IRegion::pointer> DebuggerCore::memory_regions() const {
 
-#if 0
-    static const char * inheritance_strings[] = {
-		"SHARE", "COPY", "NONE", "DONATE_COPY",
-	};
+	QList<IRegion::pointer> regions;
 
-	static const char * behavior_strings[] = {
-		"DEFAULT", "RANDOM", "SEQUENTIAL", "RESQNTL", "WILLNEED", "DONTNEED",
-	};
-#endif
+	const task_t t = task();
+	if(t == MACH_PORT_NULL) {
+		return regions;
+	}
 
-	QList<IRegion::pointer> regions;
-	if(pid_ != 0) {
-		task_t the_task;
-		kern_return_t kr = task_for_pid(mach_task_self(), pid_, &the_task);
+	// the recursing walk goes into submaps (the shared cache mostly), so each
+	// region is what is actually mapped rather than one huge submap entry
+	mach_vm_address_t address = 0;
+	natural_t         depth   = 0;
+
+	Q_FOREVER {
+		mach_vm_size_t                  size = 0;
+		vm_region_submap_info_data_64_t info;
+		mach_msg_type_number_t          info_count = VM_REGION_SUBMAP_INFO_COUNT_64;
+
+		const kern_return_t kr = mach_vm_region_recurse(t, &address, &size, &depth, reinterpret_cast<vm_region_recurse_info_t>(&info), &info_count);
 		if(kr != KERN_SUCCESS) {
-			qDebug("task_for_pid failed");
-            return QList<IRegion::pointer>();
+			break;
 		}
 
-		vm_size_t vmsize;
-		vm_address_t address;
-		vm_region_basic_info_data_64_t info;
-		mach_msg_type_number_t info_count;
-		vm_region_flavor_t flavor;
-		memory_object_name_t object;
+		if(info.is_submap) {
+			++depth;
+			continue;
+		}
 
-		kr = KERN_SUCCESS;
-		address = 0;
+		const edb::address_t start               = address;
+		const edb::address_t end                 = address + size;
+		const edb::address_t base                = address;
+		const QString name                       = QString();
+		const IRegion::permissions_t permissions =
+			((info.protection & VM_PROT_READ)    ? PROT_READ  : 0) |
+			((info.protection & VM_PROT_WRITE)   ? PROT_WRITE : 0) |
+			((info.protection & VM_PROT_EXECUTE) ? PROT_EXEC  : 0);
 
-		do {
-			flavor     = VM_REGION_BASIC_INFO_64;
-			info_count = VM_REGION_BASIC_INFO_COUNT_64;
-			kr = vm_region_64(the_task, &address, &vmsize, flavor, (vm_region_info_64_t)&info, &info_count, &object);
-			if(kr == KERN_SUCCESS) {
-
-				const edb::address_t start               = address;
-				const edb::address_t end                 = address + vmsize;
-				const edb::address_t base                = address;
-				const QString name                       = QString();
-				const IRegion::permissions_t permissions =
-					((info.protection & VM_PROT_READ)    ? PROT_READ  : 0) |
-					((info.protection & VM_PROT_WRITE)   ? PROT_WRITE : 0) |
-					((info.protection & VM_PROT_EXECUTE) ? PROT_EXEC  : 0);
-
-				regions.push_back(IRegion::pointer(new PlatformRegion(start, end, base, name, permissions)));
-
-				/*
-				printf("%016llx-%016llx %8uK %c%c%c/%c%c%c %11s %6s %10s uwir=%hu sub=%u\n",
-				address, (address + vmsize), (vmsize >> 10),
-				(info.protection & VM_PROT_READ)        ? 'r' : '-',
-				(info.protection & VM_PROT_WRITE)       ? 'w' : '-',
-				(info.protection & VM_PROT_EXECUTE)     ? 'x' : '-',
-				(info.max_protection & VM_PROT_READ)    ? 'r' : '-',
-				(info.max_protection & VM_PROT_WRITE)   ? 'w' : '-',
-				(info.max_protection & VM_PROT_EXECUTE) ? 'x' : '-',
-				inheritance_strings[info.inheritance],
-				(info.shared) ? "shared" : "-",
-				behavior_strings[info.behavior],
-				info.user_wired_count,
-				info.reserved);
-				*/
-
-				address += vmsize;
-			} else if(kr != KERN_INVALID_ADDRESS) {
-				if(the_task != MACH_PORT_NULL) {
-					mach_port_deallocate(mach_task_self(), the_task);
-				}
-                return QList<IRegion::pointer>();
-			}
-		} while(kr != KERN_INVALID_ADDRESS);
+		regions.push_back(IRegion::pointer(new PlatformRegion(start, end, base, name, permissions)));
 
-		if(the_task != MACH_PORT_NULL) {
-			mach_port_deallocate(mach_task_self(), the_task);
-		}
+		address += size;
 	}
 
 	return regions;
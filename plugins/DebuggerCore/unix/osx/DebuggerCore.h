@@ -21,6 +21,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "DebuggerCoreUNIX.h"
 #include <QHash>
+#include <mach/mach_types.h>
 
 namespace DebuggerCore {
 
@@ -83,6 +84,17 @@ public:
 public:
 	virtual QString format_pointer(edb::address_t address) const;
 
+public:
+	// memory, a whole range per mach_vm call rather than a word at a time
+	bool read_bytes(edb::address_t address, void *buf, std::size_t len);
+	bool read_pages(edb::address_t address, void *buf, std::size_t count);
+	bool write_bytes(edb::address_t address, const void *buf, std::size_t len);
+
+private:
+	task_t task() const;
+	void release_task();
+	std::size_t read_memory(edb::address_t address, void *buf, std::size_t len) const;
+
 private:
 	virtual long read_data(edb::address_t address, bool *ok);
 	virtual bool write_data(edb::address_t address, long value);
@@ -103,6 +115,7 @@ private:
 
 	edb::address_t page_size_;
 	threadmap_t    threads_;
+	mutable task_t task_;   // the port of the process, looked up once per attach
 };
 
 }
@@ -212,6 +212,30 @@ namespace {
 
         return ok;
     }
+
+	//------------------------------------------------------------------------------
+	// Name: module_path
+	// Desc: the full path of the module <file> was opened from, without the \\?\
+	//       prefix
+	//------------------------------------------------------------------------------
+	QString module_path(HANDLE file) {
+
+		if(!file) {
+			return QString();
+		}
+
+		WCHAR buffer[MAX_PATH + 1];
+		const DWORD n = GetFinalPathNameByHandleW(file, buffer, MAX_PATH, FILE_NAME_NORMALIZED);
+		if(n == 0 || n > MAX_PATH) {
+			return QString();
+		}
+
+		QString path = QString::fromWCharArray(buffer, n);
+		if(path.startsWith("\\\\?\\")) {
+			path.remove(0, 4);
+		}
+		return path;
+	}
 }
 
 
@@ -219,7 +243,7 @@ namespace {
 // Name: DebuggerCore
 // Desc: constructor
 //------------------------------------------------------------------------------
-DebuggerCore::DebuggerCore() : start_address(0), image_base(0), page_size_(0), process_handle_(0) {
+DebuggerCore::DebuggerCore() : start_address(0), image_base(0), page_size_(0), process_handle_(0), memory_map_changed_(true) {
 	DebugSetProcessKillOnExit(false);
 
 	SYSTEM_INFO sys_info;
@@ -294,14 +318,20 @@ IDebugEvent::const_pointer DebuggerCore::wait_debug_event(int msecs) {
 				threads_.remove(active_thread_);
 				break;
 			case CREATE_PROCESS_DEBUG_EVENT:
+				module_loaded(de.u.CreateProcessInfo.hFile, de.u.CreateProcessInfo.lpBaseOfImage);
 				CloseHandle(de.u.CreateProcessInfo.hFile);
 				start_address = reinterpret_cast<edb::address_t>(de.u.CreateProcessInfo.lpStartAddress);
 				image_base    = reinterpret_cast<edb::address_t>(de.u.CreateProcessInfo.lpBaseOfImage);
 				break;
 			case LOAD_DLL_DEBUG_EVENT:
+				module_loaded(de.u.LoadDll.hFile, de.u.LoadDll.lpBaseOfDll);
 				CloseHandle(de.u.LoadDll.hFile);
 				break;
+			case UNLOAD_DLL_DEBUG_EVENT:
+				module_unloaded(de.u.UnloadDll.lpBaseOfDll);
+				break;
 			case EXIT_PROCESS_DEBUG_EVENT:
+				forget_modules();
 				CloseHandle(process_handle_);
 				process_handle_ = 0;
 				pid_            = 0;
@@ -332,6 +362,109 @@ IDebugEvent::const_pointer DebuggerCore::wait_debug_event(int msecs) {
 	return IDebugEvent::const_pointer();
 }
 
+//------------------------------------------------------------------------------
+// Name: module_loaded
+// Desc: the process mapped the module <file> at <base>
+//------------------------------------------------------------------------------
+void DebuggerCore::module_loaded(HANDLE file, LPVOID base) {
+
+	Module module;
+	module.base_address = reinterpret_cast<quintptr>(base);
+	module.name         = module_path(file);
+
+	modules_.insert(module.base_address, module);
+	loaded_modules_.push_back(module);
+	memory_map_changed_ = true;
+	queried_ranges_.clear();
+}
+
+//------------------------------------------------------------------------------
+// Name: module_unloaded
+// Desc: the module at <base> is gone
+//------------------------------------------------------------------------------
+void DebuggerCore::module_unloaded(LPVOID base) {
+
+	const edb::address_t address = reinterpret_cast<quintptr>(base);
+	if(modules_.contains(address)) {
+		unloaded_modules_.push_back(modules_.take(address));
+	}
+
+	memory_map_changed_ = true;
+	queried_ranges_.clear();
+}
+
+//------------------------------------------------------------------------------
+// Name: forget_modules
+// Desc: the process is gone, and with it everything it had loaded
+//------------------------------------------------------------------------------
+void DebuggerCore::forget_modules() {
+	modules_.clear();
+	loaded_modules_.clear();
+	unloaded_modules_.clear();
+	memory_map_changed_ = true;
+}
+
+//------------------------------------------------------------------------------
+// Name: memory_map_changed
+// Desc: the debug events tell us about every module which comes and goes, the
+//       map is only re-read when one has
+//------------------------------------------------------------------------------
+bool DebuggerCore::memory_map_changed() {
+	const bool changed = memory_map_changed_;
+	memory_map_changed_ = false;
+	return changed;
+}
+
+//------------------------------------------------------------------------------
+// Name: module_changes
+// Desc:
+//------------------------------------------------------------------------------
+bool DebuggerCore::module_changes(QList<Module> *loaded, QList<Module> *unloaded) {
+
+	Q_ASSERT(loaded);
+	Q_ASSERT(unloaded);
+
+	*loaded   = loaded_modules_;
+	*unloaded = unloaded_modules_;
+	loaded_modules_.clear();
+	unloaded_modules_.clear();
+	return true;
+}
+
+//------------------------------------------------------------------------------
+// Name: query_range
+// Desc: the range around <address> which is all alike as far as reading it is
+//       concerned, from VirtualQueryEx the first time it is asked about in a
+//       stop. Only committed memory without PAGE_NOACCESS or PAGE_GUARD is
+//       readable, touching a guard page would disturb the stack it guards
+//------------------------------------------------------------------------------
+DebuggerCore::QueriedRange DebuggerCore::query_range(edb::address_t address) {
+
+	QMap<edb::address_t, QueriedRange>::const_iterator it = queried_ranges_.upperBound(address);
+	if(it != queried_ranges_.constBegin()) {
+		--it;
+		if(address < it->end) {
+			return *it;
+		}
+	}
+
+	MEMORY_BASIC_INFORMATION info;
+	if(VirtualQueryEx(process_handle_, reinterpret_cast<LPCVOID>(address), &info, sizeof(info)) != sizeof(info)) {
+		// past the end of what the process can have, nothing more to read
+		const QueriedRange range = { address, static_cast<edb::address_t>(-1), false };
+		return range;
+	}
+
+	const QueriedRange range = {
+		reinterpret_cast<quintptr>(info.BaseAddress),
+		reinterpret_cast<quintptr>(info.BaseAddress) + info.RegionSize,
+		info.State == MEM_COMMIT && !(info.Protect & (PAGE_NOACCESS | PAGE_GUARD))
+	};
+
+	queried_ranges_.insert(range.start, range);
+	return range;
+}
+
 //------------------------------------------------------------------------------
 // Name: read_pages
 // Desc: reads <count> pages from the process starting at <address>
@@ -347,7 +480,9 @@ bool DebuggerCore::read_pages(edb::address_t address, void *buf, std::size_t cou
 
 //------------------------------------------------------------------------------
 // Name: read_bytes
-// Desc: reads <len> bytes into <buf> starting at <address>
+// Desc: reads <len> bytes into <buf> starting at <address>. The request is
+//       split where the memory map changes, each readable range is read with
+//       one ReadProcessMemory and everything else is skipped
 // Note: if the read failed, the part of the buffer that could not be read will
 //       be filled with 0xff bytes
 //------------------------------------------------------------------------------
@@ -355,24 +490,34 @@ bool DebuggerCore::read_bytes(edb::address_t address, void *buf, std::size_t len
 
 	Q_ASSERT(buf);
 
-	if(attached()) {
-		if(len == 0) {
-			return true;
-		}
+	if(!attached()) {
+		return false;
+	}
+
+	quint8 *const ptr = reinterpret_cast<quint8 *>(buf);
+	bool ok = true;
+
+	std::size_t offset = 0;
+	while(offset < len) {
+		const edb::address_t a     = address + offset;
+		const QueriedRange   range = query_range(a);
+		const std::size_t    n     = static_cast<std::size_t>(qMin<edb::address_t>(range.end - a, len - offset));
 
-		memset(buf, 0xff, len);
 		SIZE_T bytes_read = 0;
-        if(ReadProcessMemory(process_handle_, reinterpret_cast<void*>(address), buf, len, &bytes_read)) {
-			Q_FOREACH(const IBreakpoint::pointer &bp, breakpoints_) {
+		if(range.readable) {
+			ReadProcessMemory(process_handle_, reinterpret_cast<void*>(a), ptr + offset, n, &bytes_read);
+		}
 
-				if(bp->address() >= address && bp->address() < address + bytes_read) {
-					reinterpret_cast<quint8 *>(buf)[bp->address() - address] = bp->original_byte();
-				}
-			}
-            return true;
+		if(bytes_read != n) {
+			memset(ptr + offset + bytes_read, 0xff, n - bytes_read);
+			ok = false;
 		}
+
+		offset += n;
 	}
-    return false;
+
+	mask_breakpoints(address, buf, len);
+	return ok;
 }
 
 //------------------------------------------------------------------------------
@@ -431,6 +576,8 @@ void DebuggerCore::detach() {
 		DebugActiveProcessStop(pid());
 		CloseHandle(process_handle_);
 		process_handle_ = 0;
+		queried_ranges_.clear();
+		forget_modules();
 		pid_            = 0;
 		start_address   = 0;
 		image_base      = 0;
@@ -467,6 +614,9 @@ void DebuggerCore::resume(edb::EVENT_STATUS status) {
 	// TODO: assert that we are paused
 
 	if(attached()) {
+		// the map may be different when it stops again
+		queried_ranges_.clear();
+
 		if(status != edb::DEBUG_STOP) {
 			// TODO: does this resume *all* threads?
 			// it does! (unless you manually paused one using SuspendThread)
@@ -516,7 +666,7 @@ void DebuggerCore::get_state(State *state) {
 	// TODO: assert that we are paused
 	Q_ASSERT(state);
 
-	PlatformState *state_impl = static_cast<PlatformState *>(state->impl_);
+	PlatformState *state_impl = static_cast<PlatformState *>(state->detach());
 
 	if(attached() && state_impl) {
 
@@ -20,6 +20,8 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #define DEBUGGERCORE_20090529_H_
 
 #include "DebuggerCoreBase.h"
+#include <QHash>
+#include <QMap>
 #include <QSet>
 
 namespace DebuggerCore {
@@ -61,6 +63,8 @@ public:
 
 public:
 	virtual QList<IRegion::pointer> memory_regions() const;
+	virtual bool memory_map_changed();
+	virtual bool module_changes(QList<Module> *loaded, QList<Module> *unloaded);
 	virtual edb::address_t process_code_address() const;
 	virtual edb::address_t process_data_address() const;
 
@@ -97,9 +101,27 @@ private:
 	bool attached() { return DebuggerCoreBase::attached() && process_handle_ != 0; }
 
 private:
-	edb::address_t   page_size_;
-	HANDLE           process_handle_;
-	QSet<edb::tid_t> threads_;
+	// what VirtualQueryEx said about [start, end), kept until the process runs
+	struct QueriedRange {
+		edb::address_t start;
+		edb::address_t end;
+		bool           readable;
+	};
+
+	QueriedRange query_range(edb::address_t address);
+	void module_loaded(HANDLE file, LPVOID base);
+	void module_unloaded(LPVOID base);
+	void forget_modules();
+
+private:
+	edb::address_t                      page_size_;
+	HANDLE                              process_handle_;
+	QSet<edb::tid_t>                    threads_;
+	QMap<edb::address_t, QueriedRange>  queried_ranges_;  // by start
+	bool                                memory_map_changed_;
+	QHash<edb::address_t, Module>       modules_;          // by base, to name the ones which are unloaded
+	QList<Module>                       loaded_modules_;   // since the last module_changes
+	QList<Module>                       unloaded_modules_;
 };
 
 }
@@ -0,0 +1,7 @@
+
+include(../plugins.pri)
+
+# Input
+HEADERS += DiagnosticsPanel.h DialogDiagnostics.h
+FORMS   += DialogDiagnostics.ui
+SOURCES += DiagnosticsPanel.cpp DialogDiagnostics.cpp
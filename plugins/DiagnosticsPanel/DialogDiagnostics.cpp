@@ -0,0 +1,242 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "DialogDiagnostics.h"
+#include "Diagnostics.h"
+#include "MemoryBudget.h"
+#include "Trace.h"
+#include "edb.h"
+
+#include <QFile>
+#include <QFileDialog>
+#include <QHeaderView>
+#include <QMessageBox>
+#include <QTimer>
+#include <QTreeWidget>
+#include <QTreeWidgetItem>
+
+#include "ui_DialogDiagnostics.h"
+
+namespace DiagnosticsPanel {
+
+namespace {
+
+enum {
+	COLUMN_NAME,
+	COLUMN_COUNT,
+	COLUMN_RATE,
+	COLUMN_TOTAL,
+	COLUMN_AVERAGE,
+	COLUMN_MAX
+};
+
+// how often the counters are shown again, in milliseconds
+const int RefreshInterval = 1000;
+
+//------------------------------------------------------------------------------
+// Name: format_amount
+// Desc: timings (in nanoseconds) are shown in whichever unit reads best
+//------------------------------------------------------------------------------
+QString format_amount(double amount, bool timing) {
+
+	if(!timing) {
+		return QString::number(amount, 'f', 0);
+	}
+
+	if(amount >= 1000000.0) {
+		return QString("%1 ms").arg(amount / 1000000.0, 0, 'f', 2);
+	}
+
+	return QString::fromUtf8("%1 \xc2\xb5s").arg(amount / 1000.0, 0, 'f', 2);
+}
+
+//------------------------------------------------------------------------------
+// Name: format_bytes
+// Desc:
+//------------------------------------------------------------------------------
+QString format_bytes(quint64 bytes) {
+
+	if(bytes >= (Q_UINT64_C(1) << 20)) {
+		return QString("%1 MiB").arg(bytes / 1048576.0, 0, 'f', 1);
+	}
+
+	return QString("%1 KiB").arg(bytes / 1024.0, 0, 'f', 1);
+}
+
+//------------------------------------------------------------------------------
+// Name: add_memory_item
+// Desc: memory is shown as a count of bytes, and the total in a unit which
+//       reads better
+//------------------------------------------------------------------------------
+void add_memory_item(QTreeWidget *tree, const QString &name, quint64 bytes) {
+	QTreeWidgetItem *const item = new QTreeWidgetItem(tree);
+	item->setText(COLUMN_NAME, QString("memory: %1").arg(name));
+	item->setData(COLUMN_COUNT, Qt::DisplayRole, bytes);
+	item->setText(COLUMN_TOTAL, format_bytes(bytes));
+}
+
+}
+
+//------------------------------------------------------------------------------
+// Name: DialogDiagnostics
+// Desc:
+//------------------------------------------------------------------------------
+DialogDiagnostics::DialogDiagnostics(QWidget *parent) : QDialog(parent), ui(new Ui::DialogDiagnostics), timer_(new QTimer(this)) {
+	ui->setupUi(this);
+#if QT_VERSION >= 0x050000
+	ui->treeWidget->header()->setSectionResizeMode(COLUMN_NAME, QHeaderView::Stretch);
+#else
+	ui->treeWidget->header()->setResizeMode(COLUMN_NAME, QHeaderView::Stretch);
+#endif
+	ui->treeWidget->header()->setStretchLastSection(false);
+
+	// the spans are only recorded by a build with CONFIG+=tracing
+	ui->btnExportTrace->setEnabled(edb::trace::enabled());
+
+	connect(timer_, SIGNAL(timeout()), this, SLOT(refresh()));
+}
+
+//------------------------------------------------------------------------------
+// Name: ~DialogDiagnostics
+// Desc:
+//------------------------------------------------------------------------------
+DialogDiagnostics::~DialogDiagnostics() {
+	delete ui;
+}
+
+//------------------------------------------------------------------------------
+// Name: showEvent
+// Desc:
+//------------------------------------------------------------------------------
+void DialogDiagnostics::showEvent(QShowEvent *event) {
+	QDialog::showEvent(event);
+	refresh();
+	timer_->start(RefreshInterval);
+}
+
+//------------------------------------------------------------------------------
+// Name: hideEvent
+// Desc:
+//------------------------------------------------------------------------------
+void DialogDiagnostics::hideEvent(QHideEvent *event) {
+	timer_->stop();
+	QDialog::hideEvent(event);
+}
+
+//------------------------------------------------------------------------------
+// Name: refresh
+// Desc: replaces what is shown, keeping the order the user picked
+//------------------------------------------------------------------------------
+void DialogDiagnostics::refresh() {
+
+	const int elapsed = last_refresh_.isNull() ? 0 : last_refresh_.elapsed();
+	last_refresh_.start();
+
+	ui->treeWidget->setSortingEnabled(false);
+	ui->treeWidget->clear();
+
+	QHash<QString, quint64> counts;
+	Q_FOREACH(const edb::diagnostics::Counter *counter, edb::diagnostics::counters()) {
+
+		counts.insert(counter->name, counter->count);
+		if(counter->count == 0) {
+			continue;
+		}
+
+		QTreeWidgetItem *const item = new QTreeWidgetItem(ui->treeWidget);
+		item->setText(COLUMN_NAME, counter->name);
+		item->setData(COLUMN_COUNT, Qt::DisplayRole, counter->count);
+
+		if(elapsed > 0) {
+			const quint64 delta = counter->count - qMin(counter->count, last_counts_.value(counter->name));
+			item->setText(COLUMN_RATE, QString::number(delta * 1000.0 / elapsed, 'f', 1));
+		}
+
+		item->setText(COLUMN_TOTAL, format_amount(counter->total, counter->timing));
+		item->setText(COLUMN_AVERAGE, format_amount(static_cast<double>(counter->total) / counter->count, counter->timing));
+		item->setText(COLUMN_MAX, format_amount(counter->max, counter->timing));
+	}
+
+	Q_FOREACH(const edb::memory::Usage &usage, edb::memory::usage()) {
+		add_memory_item(ui->treeWidget, usage.name, usage.bytes);
+	}
+
+	if(const quint64 resident = edb::memory::resident_size()) {
+		add_memory_item(ui->treeWidget, tr("edb resident"), resident);
+	}
+
+	if(const quint64 budget = edb::memory::budget()) {
+		add_memory_item(ui->treeWidget, tr("budget"), budget);
+	}
+
+	ui->treeWidget->setSortingEnabled(true);
+
+	last_counts_ = counts;
+}
+
+//------------------------------------------------------------------------------
+// Name: on_btnReset_clicked
+// Desc:
+//------------------------------------------------------------------------------
+void DialogDiagnostics::on_btnReset_clicked() {
+	edb::diagnostics::reset();
+	last_counts_.clear();
+	refresh();
+}
+
+//------------------------------------------------------------------------------
+// Name: on_btnExport_clicked
+// Desc:
+//------------------------------------------------------------------------------
+void DialogDiagnostics::on_btnExport_clicked() {
+
+	const QString filename = QFileDialog::getSaveFileName(this, tr("Export Diagnostics"), QString(), tr("JSON Files (*.json);;All Files (*)"));
+	if(filename.isEmpty()) {
+		return;
+	}
+
+	QFile file(filename);
+	if(!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+		QMessageBox::information(this, tr("Diagnostics"), tr("Unable to open file: %1").arg(filename));
+		return;
+	}
+
+	file.write(edb::diagnostics::to_json());
+}
+
+//------------------------------------------------------------------------------
+// Name: on_btnExportTrace_clicked
+// Desc: for loading into chrome://tracing or Perfetto
+//------------------------------------------------------------------------------
+void DialogDiagnostics::on_btnExportTrace_clicked() {
+
+	const QString filename = QFileDialog::getSaveFileName(this, tr("Export Trace"), QString(), tr("JSON Files (*.json);;All Files (*)"));
+	if(filename.isEmpty()) {
+		return;
+	}
+
+	QFile file(filename);
+	if(!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+		QMessageBox::information(this, tr("Diagnostics"), tr("Unable to open file: %1").arg(filename));
+		return;
+	}
+
+	file.write(edb::trace::to_chrome_json());
+}
+
+}
@@ -0,0 +1,63 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef DIALOGDIAGNOSTICS_20261014_H_
+#define DIALOGDIAGNOSTICS_20261014_H_
+
+#include <QDialog>
+#include <QHash>
+#include <QString>
+#include <QTime>
+
+class QTimer;
+
+namespace DiagnosticsPanel {
+
+namespace Ui { class DialogDiagnostics; }
+
+// every counter, refreshed once a second while the dialog is shown. The rate
+// is of the count since the last refresh
+class DialogDiagnostics : public QDialog {
+	Q_OBJECT
+
+public:
+	DialogDiagnostics(QWidget *parent = 0);
+	virtual ~DialogDiagnostics();
+
+public Q_SLOTS:
+	void on_btnReset_clicked();
+	void on_btnExport_clicked();
+	void on_btnExportTrace_clicked();
+
+private Q_SLOTS:
+	void refresh();
+
+private:
+	virtual void showEvent(QShowEvent *event);
+	virtual void hideEvent(QHideEvent *event);
+
+private:
+	Ui::DialogDiagnostics *const ui;
+	QTimer                *timer_;
+	QTime                  last_refresh_;
+	QHash<QString, quint64> last_counts_;
+};
+
+}
+
+#endif
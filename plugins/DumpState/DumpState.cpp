@@ -17,15 +17,21 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
 #include "DumpState.h"
+#include "IDebugEvent.h"
 #include "IDebugger.h"
+#include "IProcess.h"
 #include "Instruction.h"
+#include "InstructionTextCache.h"
 #include "OptionsPage.h"
 #include "State.h"
 #include "Util.h"
 #include "edb.h"
 
+#include <QFile>
 #include <QMenu>
 #include <QSettings>
+#include <QVector>
+#include <cctype>
 #include <iomanip>
 #include <iostream>
 #include <sstream>
@@ -34,6 +40,23 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 namespace DumpState {
 namespace {
 
+const int StackLines = 4;
+const int DataLines  = 2;
+
+// the registers the JSON dumps have, in order
+#if defined(EDB_X86)
+const char *const json_registers[] = {
+	"eax", "ebx", "ecx", "edx", "esi", "edi", "esp", "ebp", "eflags",
+	"cs", "ds", "es", "fs", "gs", "ss"
+};
+#elif defined(EDB_X86_64)
+const char *const json_registers[] = {
+	"rax", "rbx", "rcx", "rdx", "rsi", "rdi", "rsp", "rbp",
+	"r8", "r9", "r10", "r11", "r12", "r13", "r14", "r15", "rflags",
+	"cs", "ds", "es", "fs", "gs", "ss"
+};
+#endif
+
 //------------------------------------------------------------------------------
 // Name: hex_string
 // Desc:
@@ -45,13 +68,21 @@ std::string hex_string(T value) {
 	return ss.str();
 }
 
+//------------------------------------------------------------------------------
+// Name: json_bytes
+// Desc: the bytes as one hex string
+//------------------------------------------------------------------------------
+std::string json_bytes(const QByteArray &bytes) {
+	return "\"" + std::string(bytes.toHex().constData()) + "\"";
+}
+
 }
 
 //------------------------------------------------------------------------------
 // Name: DumpState
 // Desc:
 //------------------------------------------------------------------------------
-DumpState::DumpState() : menu_(0) {
+DumpState::DumpState() : menu_(0), breakpoint_action_(0), old_event_handler_(0), instructions_(7), json_(false) {
 }
 
 //------------------------------------------------------------------------------
@@ -59,6 +90,18 @@ DumpState::DumpState() : menu_(0) {
 // Desc:
 //------------------------------------------------------------------------------
 DumpState::~DumpState() {
+	if(old_event_handler_) {
+		edb::v1::set_debug_event_handler(old_event_handler_);
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: private_init
+// Desc:
+//------------------------------------------------------------------------------
+void DumpState::private_init() {
+	QSettings settings;
+	set_dump_on_breakpoint(settings.value("DumpState/dump_on_breakpoint.enabled", false).toBool());
 }
 
 //------------------------------------------------------------------------------
@@ -72,166 +115,366 @@ QMenu *DumpState::menu(QWidget *parent) {
 	if(!menu_) {
 		menu_ = new QMenu(tr("DumpState"), parent);
 		menu_->addAction (tr("&Dump Current State"), this, SLOT(show_menu()), QKeySequence(tr("Ctrl+D")));
+
+		breakpoint_action_ = menu_->addAction(tr("Dump On Every &Breakpoint"));
+		breakpoint_action_->setCheckable(true);
+		breakpoint_action_->setChecked(old_event_handler_ != 0);
+		connect(breakpoint_action_, SIGNAL(toggled(bool)), this, SLOT(set_dump_on_breakpoint(bool)));
 	}
 
 	return menu_;
 }
 
 //------------------------------------------------------------------------------
-// Name: dump_code
-// Desc:
+// Name: set_dump_on_breakpoint
+// Desc: puts us in front of the event handlers, or takes us back out
 //------------------------------------------------------------------------------
-void DumpState::dump_code(const State &state) {
+void DumpState::set_dump_on_breakpoint(bool enabled) {
+
+	if(enabled && !old_event_handler_) {
+		load_options();
+		old_event_handler_ = edb::v1::set_debug_event_handler(this);
+	} else if(!enabled && old_event_handler_) {
+		edb::v1::set_debug_event_handler(old_event_handler_);
+		old_event_handler_ = 0;
+		file_.reset();
+	}
 
 	QSettings settings;
-	const int instructions_to_print = settings.value("DumpState/instructions_after_ip", 6).toInt();
+	settings.setValue("DumpState/dump_on_breakpoint.enabled", enabled);
+}
 
-	const edb::address_t ip = state.instruction_pointer();
-	edb::address_t address = ip;
+//------------------------------------------------------------------------------
+// Name: load_options
+// Desc: the dumps at breakpoints go by these, rather than reading the
+//       settings on every hit. They are read again for each manual dump
+//------------------------------------------------------------------------------
+void DumpState::load_options() {
+	QSettings settings;
+	instructions_ = settings.value("DumpState/instructions_after_ip", 6).toInt() + 1;
+	json_         = settings.value("DumpState/format", "text").toString() == "json";
+	filename_     = settings.value("DumpState/output_file").toString();
+}
 
-	for(int i = 0; i < instructions_to_print + 1; ++i) {
-		quint8 buf[edb::Instruction::MAX_SIZE];
-		if(const int size = edb::v1::get_instruction_bytes(address, buf)) {
-			edb::Instruction inst(buf, buf + size, address, std::nothrow);
-			if(inst) {
-				std::cout << ((address == ip) ? "> " : "  ") << hex_string(address) << ": " << to_string(inst) << "\n";
-			} else {
-				break;
-			}
-			address += inst.size();
-		} else {
-			break;
+//------------------------------------------------------------------------------
+// Name: handle_event
+// Desc: dumps the state at every breakpoint which isn't one of edb's own,
+//       then lets the event go on as it would have
+//------------------------------------------------------------------------------
+edb::EVENT_STATUS DumpState::handle_event(const IDebugEvent::const_pointer &event) {
+
+	if(event->stopped() && event->is_trap()) {
+
+		State state;
+		edb::v1::debugger_core->get_state(&state);
+
+		// the instruction pointer is past the int3 still
+		const edb::address_t address = state.instruction_pointer() - 1;
+		const IBreakpoint::pointer bp = edb::v1::debugger_core->find_breakpoint(address);
+		if(bp && !bp->internal()) {
+			state.set_instruction_pointer(address);
+
+			Snapshot snapshot;
+			capture(state, &snapshot);
+			write(snapshot, false);
 		}
 	}
+
+	return old_event_handler_->handle_event(event);
 }
 
 //------------------------------------------------------------------------------
-// Name: dump_registers
-// Desc:
+// Name: capture
+// Desc: everything a dump shows, read in one batch
 //------------------------------------------------------------------------------
-void DumpState::dump_registers(const State &state) {
-#if defined(EDB_X86)
-	std::cout << "     eax:" << hex_string(state["eax"].value<edb::reg_t>());
-	std::cout << " ebx:" << hex_string(state["ebx"].value<edb::reg_t>());
-	std::cout << "  ecx:" << hex_string(state["ecx"].value<edb::reg_t>());
-	std::cout << "  edx:" << hex_string(state["edx"].value<edb::reg_t>());
-	std::cout << "     eflags:" << hex_string(state["eflags"].value<edb::reg_t>());
-	std::cout << "\n";
-	std::cout << "     esi:" << hex_string(state["esi"].value<edb::reg_t>());
-	std::cout << " edi:" << hex_string(state["edi"].value<edb::reg_t>());
-	std::cout << "  esp:" << hex_string(state["esp"].value<edb::reg_t>());
-	std::cout << "  ebp:" << hex_string(state["ebp"].value<edb::reg_t>());
-	std::cout << "     eip:" << hex_string(state.instruction_pointer());
-	std::cout << "\n";
-	std::cout << "     cs:" << hex_string<quint16>(state["cs"].value<edb::reg_t>());
-	std::cout << "  ds:" << hex_string<quint16>(state["ds"].value<edb::reg_t>());
-	std::cout << "  es:" << hex_string<quint16>(state["es"].value<edb::reg_t>());
-	std::cout << "  fs:" << hex_string<quint16>(state["fs"].value<edb::reg_t>());
-	std::cout << "  gs:" << hex_string<quint16>(state["gs"].value<edb::reg_t>());
-	std::cout << "  ss:" << hex_string<quint16>(state["ss"].value<edb::reg_t>());
-	std::cout << "    ";
-	std::cout << ((state["eflags"].value<edb::reg_t>() & (1 << 11)) != 0 ? 'O' : 'o') << ' ';
-	std::cout << ((state["eflags"].value<edb::reg_t>() & (1 << 10)) != 0 ? 'D' : 'd') << ' ';
-	std::cout << ((state["eflags"].value<edb::reg_t>() & (1 <<  9)) != 0 ? 'I' : 'i') << ' ';
-	std::cout << ((state["eflags"].value<edb::reg_t>() & (1 <<  8)) != 0 ? 'T' : 't') << ' ';
-	std::cout << ((state["eflags"].value<edb::reg_t>() & (1 <<  7)) != 0 ? 'S' : 's') << ' ';
-	std::cout << ((state["eflags"].value<edb::reg_t>() & (1 <<  6)) != 0 ? 'Z' : 'z') << ' ';
-	std::cout << ((state["eflags"].value<edb::reg_t>() & (1 <<  4)) != 0 ? 'A' : 'a') << ' ';
-	std::cout << ((state["eflags"].value<edb::reg_t>() & (1 <<  2)) != 0 ? 'P' : 'p') << ' ';
-	std::cout << ((state["eflags"].value<edb::reg_t>() & (1 <<  0)) != 0 ? 'C' : 'c');
-	std::cout << "\n";
-#elif defined(EDB_X86_64)
-	std::cout << "     rax:" << hex_string(state["rax"].value<edb::reg_t>());
-	std::cout << " rbx:" << hex_string(state["rbx"].value<edb::reg_t>());
-	std::cout << "  rcx:" << hex_string(state["rcx"].value<edb::reg_t>());
-	std::cout << "  rdx:" << hex_string(state["rdx"].value<edb::reg_t>());
-	std::cout << "     rflags:" << hex_string(state["rflags"].value<edb::reg_t>());
-	std::cout << "\n";
-	std::cout << "     rsi:" << hex_string(state["rsi"].value<edb::reg_t>());
-	std::cout << " rdi:" << hex_string(state["rdi"].value<edb::reg_t>());
-	std::cout << "  rsp:" << hex_string(state["rsp"].value<edb::reg_t>());
-	std::cout << "  rbp:" << hex_string(state["rbp"].value<edb::reg_t>());
-	std::cout << "        rip:" << hex_string(state.instruction_pointer());
-	std::cout << "\n";
-	std::cout << "      r8:" << hex_string(state["r8"].value<edb::reg_t>());
-	std::cout << "  r9:" << hex_string(state["r9"].value<edb::reg_t>());
-	std::cout << "  r10:" << hex_string(state["r10"].value<edb::reg_t>());
-	std::cout << "  r11:" << hex_string(state["r11"].value<edb::reg_t>());
-	std::cout << "           ";
-	std::cout << ((state["rflags"].value<edb::reg_t>() & (1 << 11)) != 0 ? 'O' : 'o') << ' ';
-	std::cout << ((state["rflags"].value<edb::reg_t>() & (1 << 10)) != 0 ? 'D' : 'd') << ' ';
-	std::cout << ((state["rflags"].value<edb::reg_t>() & (1 <<  9)) != 0 ? 'I' : 'i') << ' ';
-	std::cout << ((state["rflags"].value<edb::reg_t>() & (1 <<  8)) != 0 ? 'T' : 't') << ' ';
-	std::cout << ((state["rflags"].value<edb::reg_t>() & (1 <<  7)) != 0 ? 'S' : 's') << ' ';
-	std::cout << ((state["rflags"].value<edb::reg_t>() & (1 <<  6)) != 0 ? 'Z' : 'z') << ' ';
-	std::cout << ((state["rflags"].value<edb::reg_t>() & (1 <<  4)) != 0 ? 'A' : 'a') << ' ';
-	std::cout << ((state["rflags"].value<edb::reg_t>() & (1 <<  2)) != 0 ? 'P' : 'p') << ' ';
-	std::cout << ((state["rflags"].value<edb::reg_t>() & (1 <<  0)) != 0 ? 'C' : 'c');
-	std::cout << "\n";
-	std::cout << "     r12:" << hex_string(state["r12"].value<edb::reg_t>());
-	std::cout << " r13:" << hex_string(state["r13"].value<edb::reg_t>());
-	std::cout << "  r14:" << hex_string(state["r14"].value<edb::reg_t>());
-	std::cout << "  r15:" << hex_string(state["r15"].value<edb::reg_t>());
-	std::cout << "\n";
-	std::cout << "      cs:" << hex_string<quint16>(state["cs"].value<edb::reg_t>());
-	std::cout << "  ds:" << hex_string<quint16>(state["ds"].value<edb::reg_t>());
-	std::cout << "   es:" << hex_string<quint16>(state["es"].value<edb::reg_t>());
-	std::cout << "   fs:" << hex_string<quint16>(state["fs"].value<edb::reg_t>());
-	std::cout << "\n";
-	std::cout << "      gs:" << hex_string<quint16>(state["gs"].value<edb::reg_t>());
-	std::cout << "  ss:" << hex_string<quint16>(state["ss"].value<edb::reg_t>());
-	std::cout << "\n";
-#endif
+void DumpState::capture(const State &state, Snapshot *snapshot) {
+
+	Q_ASSERT(snapshot);
+
+	snapshot->state        = state;
+	snapshot->data_address = edb::v1::current_data_view_address();
+	snapshot->code.resize(instructions_ * edb::Instruction::MAX_SIZE);
+	snapshot->stack.resize(StackLines * 16);
+	snapshot->data.resize(DataLines * 16);
+	snapshot->instructions = instructions_;
+	snapshot->code_ok      = false;
+	snapshot->stack_ok     = false;
+	snapshot->data_ok      = false;
+
+	if(IProcess *const process = edb::v1::debugger_core->process()) {
+		QVector<IProcess::ReadRequest> requests;
+		requests.push_back(IProcess::ReadRequest(state.instruction_pointer(), snapshot->code.data(), snapshot->code.size()));
+		requests.push_back(IProcess::ReadRequest(state.stack_pointer(), snapshot->stack.data(), snapshot->stack.size()));
+		requests.push_back(IProcess::ReadRequest(snapshot->data_address, snapshot->data.data(), snapshot->data.size()));
+
+		const QVector<bool> results = process->read_batch(requests);
+		snapshot->code_ok  = results[0];
+		snapshot->stack_ok = results[1];
+		snapshot->data_ok  = results[2];
+	}
 }
 
 //------------------------------------------------------------------------------
-// Name: dump_lines
+// Name: write
+// Desc: formats the snapshot and writes it out in one go, to the file if one
+//       is set and otherwise to standard output
+//------------------------------------------------------------------------------
+void DumpState::write(const Snapshot &snapshot, bool flush) {
+
+	std::ostringstream os;
+	if(json_) {
+		write_json(os, snapshot);
+	} else {
+		write_text(os, snapshot);
+	}
+
+	const std::string text = os.str();
+
+	if(filename_.isEmpty()) {
+		file_.reset();
+		std::cout << text;
+		if(flush) {
+			std::cout.flush();
+		}
+		return;
+	}
+
+	// the file stays open, its buffer saves a write per dump at breakpoints
+	if(!file_ || file_->fileName() != filename_) {
+		file_.reset(new QFile(filename_));
+		if(!file_->open(QIODevice::WriteOnly | QIODevice::Append)) {
+			qDebug("[DumpState] can't open %s", qPrintable(filename_));
+			file_.reset();
+			return;
+		}
+	}
+
+	file_->write(text.data(), text.size());
+	if(flush) {
+		file_->flush();
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: write_text
 // Desc:
 //------------------------------------------------------------------------------
-void DumpState::dump_lines(edb::address_t address, int lines) {
-	
-	if(IProcess *process = edb::v1::debugger_core->process()) {
-		for(int i = 0; i < lines; ++i) {
-			quint8 buf[16];
-			if(process->read_bytes(address, buf, sizeof(buf))) {
-				std::cout << hex_string(address) << " : ";
-
-				for(int j = 0x00; j < 0x04; ++j) std::cout << hex_string(buf[j]) << " ";
-				std::cout << " ";
-				for(int j = 0x04; j < 0x08; ++j) std::cout << hex_string(buf[j]) << " ";
-				std::cout << "- ";
-				for(int j = 0x08; j < 0x0c; ++j) std::cout << hex_string(buf[j]) << " ";
-				std::cout << " ";
-				for(int j = 0x0c; j < 0x10; ++j) std::cout << hex_string(buf[j]) << " ";
-
-				for(int j = 0; j < 16; ++j) {
-					const quint8 ch = buf[j];
-					std::cout << ((std::isprint(ch) || (std::isspace(ch) && (ch != '\f' && ch != '\t' && ch != '\r' && ch != '\n') && ch < 0x80)) ? static_cast<char>(ch) : '.');
-				}
+void DumpState::write_text(std::ostream &os, const Snapshot &snapshot) {
+
+	const State &state = snapshot.state;
+
+	os << "------------------------------------------------------------------------------\n";
+	dump_registers(os, state);
+	os << "[" << hex_string<quint16>(state["ss"].value<edb::reg_t>()) << ":" << hex_string(state.stack_pointer()) << "]---------------------------------------------------------[stack]\n";
+	if(snapshot.stack_ok) {
+		dump_lines(os, state.stack_pointer(), snapshot.stack);
+	}
+
+	os << "[" << hex_string<quint16>(state["ds"].value<edb::reg_t>()) << ":" << hex_string(snapshot.data_address) << "]---------------------------------------------------------[ data]\n";
+	if(snapshot.data_ok) {
+		dump_lines(os, snapshot.data_address, snapshot.data);
+	}
+
+	os << "[" << hex_string<quint16>(state["cs"].value<edb::reg_t>()) << ":" << hex_string(state.instruction_pointer()) << "]---------------------------------------------------------[ code]\n";
+	dump_code(os, snapshot);
+	os << "------------------------------------------------------------------------------\n";
+}
+
+//------------------------------------------------------------------------------
+// Name: write_json
+// Desc: one object per line
+//------------------------------------------------------------------------------
+void DumpState::write_json(std::ostream &os, const Snapshot &snapshot) {
+
+	const State &state = snapshot.state;
+
+	os << "{\"ip\":\"" << hex_string(state.instruction_pointer()) << "\",\"registers\":{";
+	for(std::size_t i = 0; i < sizeof(json_registers) / sizeof(json_registers[0]); ++i) {
+		if(i != 0) {
+			os << ',';
+		}
+		os << '"' << json_registers[i] << "\":\"" << hex_string(state[json_registers[i]].value<edb::reg_t>()) << '"';
+	}
+	os << '}';
+
+	os << ",\"stack\":{\"address\":\"" << hex_string(state.stack_pointer()) << "\",\"bytes\":" << (snapshot.stack_ok ? json_bytes(snapshot.stack) : "null") << '}';
+	os << ",\"data\":{\"address\":\"" << hex_string(snapshot.data_address) << "\",\"bytes\":" << (snapshot.data_ok ? json_bytes(snapshot.data) : "null") << '}';
+
+	os << ",\"code\":[";
+	const QList<std::pair<edb::address_t, std::string> > instructions = decode(snapshot);
+	for(int i = 0; i < instructions.size(); ++i) {
+		if(i != 0) {
+			os << ',';
+		}
+		os << "{\"address\":\"" << hex_string(instructions[i].first) << "\",\"text\":" << edb::v1::json_string(QString::fromStdString(instructions[i].second)).toStdString() << '}';
+	}
+	os << "]}\n";
+}
+
+//------------------------------------------------------------------------------
+// Name: decode
+// Desc: the instructions from the instruction pointer on. The bytes were read
+//       along with everything else, only if that failed (the code runs up to
+//       the end of a region) are they read again instruction by instruction
+//------------------------------------------------------------------------------
+QList<std::pair<edb::address_t, std::string> > DumpState::decode(const Snapshot &snapshot) {
+
+	QList<std::pair<edb::address_t, std::string> > ret;
+
+	edb::address_t address = snapshot.state.instruction_pointer();
+
+	if(snapshot.code_ok) {
+		const quint8 *p          = reinterpret_cast<const quint8 *>(snapshot.code.constData());
+		const quint8 *const last = p + snapshot.code.size();
 
-				std::cout << "\n";
+		for(int i = 0; i < snapshot.instructions && p != last; ++i) {
+			edb::Instruction inst(p, last, address, std::nothrow);
+			if(!inst) {
+				break;
+			}
+			ret.push_back(std::make_pair(address, edb::v1::instruction_text_cache().format(inst).toStdString()));
+			address += inst.size();
+			p       += inst.size();
+		}
+	} else {
+		for(int i = 0; i < snapshot.instructions; ++i) {
+			quint8 buf[edb::Instruction::MAX_SIZE];
+			if(const int size = edb::v1::get_instruction_bytes(address, buf)) {
+				edb::Instruction inst(buf, buf + size, address, std::nothrow);
+				if(!inst) {
+					break;
+				}
+				ret.push_back(std::make_pair(address, edb::v1::instruction_text_cache().format(inst).toStdString()));
+				address += inst.size();
 			} else {
 				break;
 			}
-			address += 16;
 		}
 	}
+
+	return ret;
 }
 
 //------------------------------------------------------------------------------
-// Name: dump_stack
+// Name: dump_code
 // Desc:
 //------------------------------------------------------------------------------
-void DumpState::dump_stack(const State &state) {
-	dump_lines(state.stack_pointer(), 4);
+void DumpState::dump_code(std::ostream &os, const Snapshot &snapshot) {
+
+	const edb::address_t ip = snapshot.state.instruction_pointer();
+
+	typedef std::pair<edb::address_t, std::string> Line;
+	Q_FOREACH(const Line &line, decode(snapshot)) {
+		os << ((line.first == ip) ? "> " : "  ") << hex_string(line.first) << ": " << line.second << "\n";
+	}
 }
 
 //------------------------------------------------------------------------------
-// Name: dump_data
+// Name: dump_registers
 // Desc:
 //------------------------------------------------------------------------------
-void DumpState::dump_data(edb::address_t address) {
-	dump_lines(address, 2);
+void DumpState::dump_registers(std::ostream &os, const State &state) {
+#if defined(EDB_X86)
+	os << "     eax:" << hex_string(state["eax"].value<edb::reg_t>());
+	os << " ebx:" << hex_string(state["ebx"].value<edb::reg_t>());
+	os << "  ecx:" << hex_string(state["ecx"].value<edb::reg_t>());
+	os << "  edx:" << hex_string(state["edx"].value<edb::reg_t>());
+	os << "     eflags:" << hex_string(state["eflags"].value<edb::reg_t>());
+	os << "\n";
+	os << "     esi:" << hex_string(state["esi"].value<edb::reg_t>());
+	os << " edi:" << hex_string(state["edi"].value<edb::reg_t>());
+	os << "  esp:" << hex_string(state["esp"].value<edb::reg_t>());
+	os << "  ebp:" << hex_string(state["ebp"].value<edb::reg_t>());
+	os << "     eip:" << hex_string(state.instruction_pointer());
+	os << "\n";
+	os << "     cs:" << hex_string<quint16>(state["cs"].value<edb::reg_t>());
+	os << "  ds:" << hex_string<quint16>(state["ds"].value<edb::reg_t>());
+	os << "  es:" << hex_string<quint16>(state["es"].value<edb::reg_t>());
+	os << "  fs:" << hex_string<quint16>(state["fs"].value<edb::reg_t>());
+	os << "  gs:" << hex_string<quint16>(state["gs"].value<edb::reg_t>());
+	os << "  ss:" << hex_string<quint16>(state["ss"].value<edb::reg_t>());
+	os << "    ";
+	os << ((state["eflags"].value<edb::reg_t>() & (1 << 11)) != 0 ? 'O' : 'o') << ' ';
+	os << ((state["eflags"].value<edb::reg_t>() & (1 << 10)) != 0 ? 'D' : 'd') << ' ';
+	os << ((state["eflags"].value<edb::reg_t>() & (1 <<  9)) != 0 ? 'I' : 'i') << ' ';
+	os << ((state["eflags"].value<edb::reg_t>() & (1 <<  8)) != 0 ? 'T' : 't') << ' ';
+	os << ((state["eflags"].value<edb::reg_t>() & (1 <<  7)) != 0 ? 'S' : 's') << ' ';
+	os << ((state["eflags"].value<edb::reg_t>() & (1 <<  6)) != 0 ? 'Z' : 'z') << ' ';
+	os << ((state["eflags"].value<edb::reg_t>() & (1 <<  4)) != 0 ? 'A' : 'a') << ' ';
+	os << ((state["eflags"].value<edb::reg_t>() & (1 <<  2)) != 0 ? 'P' : 'p') << ' ';
+	os << ((state["eflags"].value<edb::reg_t>() & (1 <<  0)) != 0 ? 'C' : 'c');
+	os << "\n";
+#elif defined(EDB_X86_64)
+	os << "     rax:" << hex_string(state["rax"].value<edb::reg_t>());
+	os << " rbx:" << hex_string(state["rbx"].value<edb::reg_t>());
+	os << "  rcx:" << hex_string(state["rcx"].value<edb::reg_t>());
+	os << "  rdx:" << hex_string(state["rdx"].value<edb::reg_t>());
+	os << "     rflags:" << hex_string(state["rflags"].value<edb::reg_t>());
+	os << "\n";
+	os << "     rsi:" << hex_string(state["rsi"].value<edb::reg_t>());
+	os << " rdi:" << hex_string(state["rdi"].value<edb::reg_t>());
+	os << "  rsp:" << hex_string(state["rsp"].value<edb::reg_t>());
+	os << "  rbp:" << hex_string(state["rbp"].value<edb::reg_t>());
+	os << "        rip:" << hex_string(state.instruction_pointer());
+	os << "\n";
+	os << "      r8:" << hex_string(state["r8"].value<edb::reg_t>());
+	os << "  r9:" << hex_string(state["r9"].value<edb::reg_t>());
+	os << "  r10:" << hex_string(state["r10"].value<edb::reg_t>());
+	os << "  r11:" << hex_string(state["r11"].value<edb::reg_t>());
+	os << "           ";
+	os << ((state["rflags"].value<edb::reg_t>() & (1 << 11)) != 0 ? 'O' : 'o') << ' ';
+	os << ((state["rflags"].value<edb::reg_t>() & (1 << 10)) != 0 ? 'D' : 'd') << ' ';
+	os << ((state["rflags"].value<edb::reg_t>() & (1 <<  9)) != 0 ? 'I' : 'i') << ' ';
+	os << ((state["rflags"].value<edb::reg_t>() & (1 <<  8)) != 0 ? 'T' : 't') << ' ';
+	os << ((state["rflags"].value<edb::reg_t>() & (1 <<  7)) != 0 ? 'S' : 's') << ' ';
+	os << ((state["rflags"].value<edb::reg_t>() & (1 <<  6)) != 0 ? 'Z' : 'z') << ' ';
+	os << ((state["rflags"].value<edb::reg_t>() & (1 <<  4)) != 0 ? 'A' : 'a') << ' ';
+	os << ((state["rflags"].value<edb::reg_t>() & (1 <<  2)) != 0 ? 'P' : 'p') << ' ';
+	os << ((state["rflags"].value<edb::reg_t>() & (1 <<  0)) != 0 ? 'C' : 'c');
+	os << "\n";
+	os << "     r12:" << hex_string(state["r12"].value<edb::reg_t>());
+	os << " r13:" << hex_string(state["r13"].value<edb::reg_t>());
+	os << "  r14:" << hex_string(state["r14"].value<edb::reg_t>());
+	os << "  r15:" << hex_string(state["r15"].value<edb::reg_t>());
+	os << "\n";
+	os << "      cs:" << hex_string<quint16>(state["cs"].value<edb::reg_t>());
+	os << "  ds:" << hex_string<quint16>(state["ds"].value<edb::reg_t>());
+	os << "   es:" << hex_string<quint16>(state["es"].value<edb::reg_t>());
+	os << "   fs:" << hex_string<quint16>(state["fs"].value<edb::reg_t>());
+	os << "\n";
+	os << "      gs:" << hex_string<quint16>(state["gs"].value<edb::reg_t>());
+	os << "  ss:" << hex_string<quint16>(state["ss"].value<edb::reg_t>());
+	os << "\n";
+#endif
+}
+
+//------------------------------------------------------------------------------
+// Name: dump_lines
+// Desc: 16 bytes a line, from bytes which were already read
+//------------------------------------------------------------------------------
+void DumpState::dump_lines(std::ostream &os, edb::address_t address, const QByteArray &bytes) {
+
+	for(int i = 0; i + 16 <= bytes.size(); i += 16) {
+		const quint8 *const buf = reinterpret_cast<const quint8 *>(bytes.constData()) + i;
+
+		os << hex_string(address) << " : ";
+
+		for(int j = 0x00; j < 0x04; ++j) os << hex_string(buf[j]) << " ";
+		os << " ";
+		for(int j = 0x04; j < 0x08; ++j) os << hex_string(buf[j]) << " ";
+		os << "- ";
+		for(int j = 0x08; j < 0x0c; ++j) os << hex_string(buf[j]) << " ";
+		os << " ";
+		for(int j = 0x0c; j < 0x10; ++j) os << hex_string(buf[j]) << " ";
+
+		for(int j = 0; j < 16; ++j) {
+			const quint8 ch = buf[j];
+			os << ((std::isprint(ch) || (std::isspace(ch) && (ch != '\f' && ch != '\t' && ch != '\r' && ch != '\n') && ch < 0x80)) ? static_cast<char>(ch) : '.');
+		}
+
+		os << "\n";
+		address += 16;
+	}
 }
 
 //------------------------------------------------------------------------------
@@ -240,20 +483,14 @@ void DumpState::dump_data(edb::address_t address) {
 //------------------------------------------------------------------------------
 void DumpState::show_menu() {
 
+	load_options();
+
 	State state;
 	edb::v1::debugger_core->get_state(&state);
 
-	std::cout << "------------------------------------------------------------------------------\n";
-	dump_registers(state);
-	std::cout << "[" << hex_string<quint16>(state["ss"].value<edb::reg_t>()) << ":" << hex_string(state.stack_pointer()) << "]---------------------------------------------------------[stack]\n";
-	dump_stack(state);
-
-	const edb::address_t data_address = edb::v1::current_data_view_address();
-	std::cout << "[" << hex_string<quint16>(state["ds"].value<edb::reg_t>()) << ":" << hex_string(data_address) << "]---------------------------------------------------------[ data]\n";
-	dump_data(data_address);
-	std::cout << "[" << hex_string<quint16>(state["cs"].value<edb::reg_t>()) << ":" << hex_string(state.instruction_pointer()) << "]---------------------------------------------------------[ code]\n";
-	dump_code(state);
-	std::cout << "------------------------------------------------------------------------------\n";
+	Snapshot snapshot;
+	capture(state, &snapshot);
+	write(snapshot, true);
 }
 
 //------------------------------------------------------------------------------
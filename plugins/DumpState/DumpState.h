@@ -19,15 +19,26 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #ifndef CHECKVERSION_20061122_H_
 #define CHECKVERSION_20061122_H_
 
+#include "IDebugEventHandler.h"
 #include "IPlugin.h"
+#include "State.h"
 #include "Types.h"
 
+#include <QByteArray>
+#include <QList>
+#include <QString>
+#include <QScopedPointer>
+#include <iosfwd>
+#include <string>
+#include <utility>
+
+class QAction;
+class QFile;
 class QMenu;
-class State;
 
 namespace DumpState {
 
-class DumpState : public QObject, public IPlugin {
+class DumpState : public QObject, public IPlugin, public IDebugEventHandler {
 	Q_OBJECT
 	Q_INTERFACES(IPlugin)
 #if QT_VERSION >= 0x050000
@@ -43,21 +54,50 @@ public:
 public:
 	virtual QMenu *menu(QWidget *parent = 0);
 
+public:
+	virtual edb::EVENT_STATUS handle_event(const IDebugEvent::const_pointer &event);
+
 public Q_SLOTS:
 	void show_menu();
+	void set_dump_on_breakpoint(bool enabled);
 
 private:
 	virtual QWidget *options_page();
+	virtual void private_init();
+
+private:
+	// what a dump shows, all of it read at once
+	struct Snapshot {
+		State          state;
+		edb::address_t data_address;
+		QByteArray     code;
+		QByteArray     stack;
+		QByteArray     data;
+		int            instructions;
+		bool           code_ok;
+		bool           stack_ok;
+		bool           data_ok;
+	};
 
 private:
-	void dump_code(const State &state);
-	void dump_registers(const State &state);
-	void dump_stack(const State &state);
-	void dump_data(edb::address_t address);
-	void dump_lines(edb::address_t address, int lines);
+	void load_options();
+	void capture(const State &state, Snapshot *snapshot);
+	void write(const Snapshot &snapshot, bool flush);
+	void write_text(std::ostream &os, const Snapshot &snapshot);
+	void write_json(std::ostream &os, const Snapshot &snapshot);
+	QList<std::pair<edb::address_t, std::string> > decode(const Snapshot &snapshot);
+	void dump_code(std::ostream &os, const Snapshot &snapshot);
+	void dump_registers(std::ostream &os, const State &state);
+	void dump_lines(std::ostream &os, edb::address_t address, const QByteArray &bytes);
 
 private:
-	QMenu * menu_;
+	QMenu                 *menu_;
+	QAction               *breakpoint_action_;
+	IDebugEventHandler    *old_event_handler_;
+	QScopedPointer<QFile>  file_;
+	int                    instructions_;
+	bool                   json_;
+	QString                filename_;
 };
 
 }
@@ -49,6 +49,8 @@ void OptionsPage::showEvent(QShowEvent *event) {
 	QSettings settings;
 	ui->instructionsBeforeIP->setValue(settings.value("DumpState/instructions_before_ip", 0).toInt());
 	ui->instructionsAfterIP->setValue(settings.value("DumpState/instructions_after_ip", 5).toInt());
+	ui->format->setCurrentIndex(settings.value("DumpState/format", "text").toString() == "json" ? 1 : 0);
+	ui->outputFile->setText(settings.value("DumpState/output_file").toString());
 }
 
 //------------------------------------------------------------------------------
@@ -69,4 +71,22 @@ void OptionsPage::on_instructionsAfterIP_valueChanged(int i) {
 	settings.setValue("DumpState/instructions_after_ip", i);
 }
 
+//------------------------------------------------------------------------------
+// Name: on_format_currentIndexChanged
+// Desc:
+//------------------------------------------------------------------------------
+void OptionsPage::on_format_currentIndexChanged(int index) {
+	QSettings settings;
+	settings.setValue("DumpState/format", index == 1 ? "json" : "text");
+}
+
+//------------------------------------------------------------------------------
+// Name: on_outputFile_textChanged
+// Desc:
+//------------------------------------------------------------------------------
+void OptionsPage::on_outputFile_textChanged(const QString &text) {
+	QSettings settings;
+	settings.setValue("DumpState/output_file", text);
+}
+
 }
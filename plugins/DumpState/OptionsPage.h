@@ -38,6 +38,8 @@ public:
 public Q_SLOTS:
 	void on_instructionsBeforeIP_valueChanged(int i);
 	void on_instructionsAfterIP_valueChanged(int i);
+	void on_format_currentIndexChanged(int index);
+	void on_outputFile_textChanged(const QString &text);
 
 private:
 	Ui::OptionsPage *const ui;
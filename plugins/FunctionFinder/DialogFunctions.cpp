@@ -17,6 +17,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
 #include "DialogFunctions.h"
+#include "FunctionsModel.h"
 #include "edb.h"
 #include "IAnalyzer.h"
 #include "MemoryRegions.h"
@@ -27,25 +28,26 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "ui_DialogFunctions.h"
 
-#define MIN_REFCOUNT 2
-
 namespace FunctionFinder {
 
 //------------------------------------------------------------------------------
 // Name: DialogFunctions
 // Desc:
 //------------------------------------------------------------------------------
-DialogFunctions::DialogFunctions(QWidget *parent) : QDialog(parent), ui(new Ui::DialogFunctions) {
+DialogFunctions::DialogFunctions(QWidget *parent) : QDialog(parent), ui(new Ui::DialogFunctions), functions_model_(new FunctionsModel(this)), searching_(false), cancelled_(false) {
 	ui->setupUi(this);
 	
 #if QT_VERSION >= 0x050000
 	ui->tableView->horizontalHeader()->setSectionResizeMode(QHeaderView::ResizeToContents);
-	ui->tableWidget->horizontalHeader()->setSectionResizeMode(QHeaderView::ResizeToContents);
 #else
 	ui->tableView->horizontalHeader()->setResizeMode(QHeaderView::ResizeToContents);
-	ui->tableWidget->horizontalHeader()->setResizeMode(QHeaderView::ResizeToContents);
 #endif
 
+	// the results can run to hundreds of thousands of rows, far too many to
+	// keep the columns fitted to
+	ui->tableFunctions->setModel(functions_model_);
+	ui->tableFunctions->sortByColumn(0, Qt::AscendingOrder);
+
 	filter_model_ = new QSortFilterProxyModel(this);
 	connect(ui->txtSearch, SIGNAL(textChanged(const QString &)), filter_model_, SLOT(setFilterFixedString(const QString &)));
 }
@@ -59,15 +61,24 @@ DialogFunctions::~DialogFunctions() {
 }
 
 //------------------------------------------------------------------------------
-// Name: on_tableWidget_cellDoubleClicked
+// Name: on_tableFunctions_doubleClicked
 // Desc: follows the found item in the data view
 //------------------------------------------------------------------------------
-void DialogFunctions::on_tableWidget_cellDoubleClicked(int row, int column) {
-	Q_UNUSED(column);
+void DialogFunctions::on_tableFunctions_doubleClicked(const QModelIndex &index) {
+	if(index.isValid()) {
+		edb::v1::jump_to_address(functions_model_->address(index));
+	}
+}
 
-	QTableWidgetItem *const item = ui->tableWidget->item(row, 0);
-	const edb::address_t addr = item->data(Qt::UserRole).toULongLong();
-	edb::v1::jump_to_address(addr);
+//------------------------------------------------------------------------------
+// Name: functions_found
+// Desc: shows what a running analysis of one of the searched regions has
+//       found so far
+//------------------------------------------------------------------------------
+void DialogFunctions::functions_found(edb::address_t region, const IAnalyzer::FunctionTable &functions) {
+	if(!cancelled_ && searched_regions_.contains(region)) {
+		functions_model_->add_functions(region, functions);
+	}
 }
 
 //------------------------------------------------------------------------------
@@ -80,7 +91,7 @@ void DialogFunctions::showEvent(QShowEvent *) {
 	ui->tableView->setModel(filter_model_);
 
 	ui->progressBar->setValue(0);
-	ui->tableWidget->setRowCount(0);
+	functions_model_->clear();
 }
 
 //------------------------------------------------------------------------------
@@ -100,66 +111,47 @@ void DialogFunctions::do_find() {
 
 		QObject *const analyzer_object = dynamic_cast<QObject *>(analyzer);
 
-		if(analyzer_object) {
-			connect(analyzer_object, SIGNAL(update_progress(int)), ui->progressBar, SLOT(setValue(int)));
-		}
-
-		ui->tableWidget->setRowCount(0);
-		ui->tableWidget->setSortingEnabled(false);
-
+		QList<IRegion::pointer> regions;
 		Q_FOREACH(const QModelIndex &selected_item, sel) {
-
 			const QModelIndex index = filter_model_->mapToSource(selected_item);
-
-			// do the search for this region!
 			if(const IRegion::pointer region = *reinterpret_cast<const IRegion::pointer *>(index.internalPointer())) {
+				regions.push_back(region);
+			}
+		}
 
-				analyzer->analyze(region);
-
-				const IAnalyzer::FunctionMap &results = analyzer->functions(region);
-
-				Q_FOREACH(const Function &info, results) {
-
-					const int row = ui->tableWidget->rowCount();
-					ui->tableWidget->insertRow(row);
-
-					// entry point
-					QTableWidgetItem *const p = new QTableWidgetItem(edb::v1::format_pointer(info.entry_address()));
-					p->setData(Qt::UserRole, info.entry_address());
-					ui->tableWidget->setItem(row, 0, p);
+		functions_model_->clear();
+		searched_regions_.clear();
+		Q_FOREACH(const IRegion::pointer &region, regions) {
+			searched_regions_.insert(region->start());
+		}
 
-					// upper bound of the function
-					if(info.reference_count() >= MIN_REFCOUNT) {
-						ui->tableWidget->setItem(row, 1, new QTableWidgetItem(edb::v1::format_pointer(info.end_address())));
+		// analyzers which tell as they go fill the table in while they run
+		if(analyzer_object) {
+			connect(analyzer_object, SIGNAL(update_progress(int)), ui->progressBar, SLOT(setValue(int)));
+			connect(analyzer_object, SIGNAL(functions_found(edb::address_t, const IAnalyzer::FunctionTable &)), this, SLOT(functions_found(edb::address_t, const IAnalyzer::FunctionTable &)));
+		}
 
-						QTableWidgetItem *const size_item = new QTableWidgetItem;
-						size_item->setData(Qt::DisplayRole, info.end_address() - info.entry_address() + 1);
+		// the regions are analyzed together, so that they can share threads
+		// and learn from each other what is called
+		analyzer->analyze_regions(regions);
 
-						ui->tableWidget->setItem(row, 2, size_item);
-					}
+		if(analyzer_object) {
+			disconnect(analyzer_object, SIGNAL(functions_found(edb::address_t, const IAnalyzer::FunctionTable &)), this, SLOT(functions_found(edb::address_t, const IAnalyzer::FunctionTable &)));
+			disconnect(analyzer_object, SIGNAL(update_progress(int)), ui->progressBar, SLOT(setValue(int)));
+		}
 
-					// reference count
-					QTableWidgetItem *const itemCount = new QTableWidgetItem;
-					itemCount->setData(Qt::DisplayRole, info.reference_count());
-					ui->tableWidget->setItem(row, 3, itemCount);
+		// a finished analysis may have dropped or retyped what it found early
+		// on, so each region is brought up to date with all of it
+		Q_FOREACH(const IRegion::pointer &region, regions) {
 
-					// type
-					switch(info.type()) {
-					case Function::FUNCTION_THUNK:
-						ui->tableWidget->setItem(row, 4, new QTableWidgetItem(tr("Thunk")));
-						break;
-					case Function::FUNCTION_STANDARD:
-						ui->tableWidget->setItem(row, 4, new QTableWidgetItem(tr("Standard Function")));
-						break;
-					}
-				}
+			if(cancelled_) {
+				break;
 			}
-		}
-		ui->tableWidget->setSortingEnabled(true);
 
-		if(analyzer_object) {
-			disconnect(analyzer_object, SIGNAL(update_progress(int)), ui->progressBar, SLOT(setValue(int)));
+			functions_model_->set_functions(region->start(), analyzer->function_table(region));
 		}
+
+		ui->tableFunctions->resizeColumnsToContents();
 	}
 }
 
@@ -168,11 +160,24 @@ void DialogFunctions::do_find() {
 // Desc:
 //------------------------------------------------------------------------------
 void DialogFunctions::on_btnFind_clicked() {
-	ui->btnFind->setEnabled(false);
+
+	// while a search runs the button cancels it instead
+	if(searching_) {
+		cancelled_ = true;
+		if(IAnalyzer *const analyzer = edb::v1::analyzer()) {
+			analyzer->cancel_analysis();
+		}
+		return;
+	}
+
+	searching_ = true;
+	cancelled_ = false;
+	ui->btnFind->setText(tr("&Cancel"));
 	ui->progressBar->setValue(0);
 	do_find();
 	ui->progressBar->setValue(100);
-	ui->btnFind->setEnabled(true);
+	ui->btnFind->setText(tr("&Find"));
+	searching_ = false;
 }
 
 }
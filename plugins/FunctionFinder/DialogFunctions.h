@@ -19,14 +19,18 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #ifndef DIALOGFUNCTIONS_20061101_H_
 #define DIALOGFUNCTIONS_20061101_H_
 
+#include "IAnalyzer.h"
 #include "Types.h"
 #include <QDialog>
+#include <QSet>
 
+class QModelIndex;
 class QSortFilterProxyModel;
-class IAnalyzer;
 
 namespace FunctionFinder {
 
+class FunctionsModel;
+
 namespace Ui { class DialogFunctions; }
 
 class DialogFunctions : public QDialog {
@@ -38,7 +42,10 @@ public:
 
 public Q_SLOTS:
 	void on_btnFind_clicked();
-	void on_tableWidget_cellDoubleClicked (int row, int column);
+	void on_tableFunctions_doubleClicked(const QModelIndex &index);
+
+private Q_SLOTS:
+	void functions_found(edb::address_t region, const IAnalyzer::FunctionTable &functions);
 
 private:
 	virtual void showEvent(QShowEvent *event);
@@ -49,6 +56,10 @@ private:
 private:
 	Ui::DialogFunctions *const ui;
 	QSortFilterProxyModel *    filter_model_;
+	FunctionsModel *           functions_model_;
+	QSet<edb::address_t>       searched_regions_;
+	bool                       searching_;
+	bool                       cancelled_;
 };
 
 }
@@ -2,6 +2,7 @@
 include(../plugins.pri)
 
 # Input
-HEADERS += FunctionFinder.h DialogFunctions.h
+HEADERS += FunctionFinder.h DialogFunctions.h FunctionsModel.h
 FORMS += DialogFunctions.ui
-SOURCES += FunctionFinder.cpp DialogFunctions.cpp
+SOURCES += FunctionFinder.cpp DialogFunctions.cpp FunctionsModel.cpp
+OTHER_FILES += FunctionFinder.json
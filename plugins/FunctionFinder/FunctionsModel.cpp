@@ -0,0 +1,329 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "FunctionsModel.h"
+#include "edb.h"
+#include <QSet>
+#include <algorithm>
+
+namespace FunctionFinder {
+
+namespace {
+
+// the end of a function is only a guess until enough calls were seen to it
+const int min_refcount = 2;
+
+//------------------------------------------------------------------------------
+// Name: same_function
+// Desc:
+//------------------------------------------------------------------------------
+bool same_function(const IAnalyzer::FunctionSummary &a, const IAnalyzer::FunctionSummary &b) {
+	return a.entry == b.entry && a.end == b.end && a.reference_count == b.reference_count && a.type == b.type;
+}
+
+}
+
+// orders rows by one column's raw value, then by entry so that equal ones
+// always come out the same way
+class FunctionsModel::RowLess {
+public:
+	RowLess(const QVector<Row> &rows, int column, Qt::SortOrder order) : rows_(rows), column_(column), order_(order) {
+	}
+
+public:
+	bool operator()(int lhs, int rhs) const {
+		const IAnalyzer::FunctionSummary &a = rows_[lhs].function;
+		const IAnalyzer::FunctionSummary &b = rows_[rhs].function;
+
+		const int c = compare(a, b);
+		if(c != 0) {
+			return (order_ == Qt::AscendingOrder) ? c < 0 : c > 0;
+		}
+
+		return a.entry < b.entry;
+	}
+
+private:
+	template <class T>
+	static int compare_values(const T &a, const T &b) {
+		return (a < b) ? -1 : (b < a) ? 1 : 0;
+	}
+
+	int compare(const IAnalyzer::FunctionSummary &a, const IAnalyzer::FunctionSummary &b) const {
+		switch(column_) {
+		case 0: return compare_values(a.entry, b.entry);
+		case 1: return compare_values(a.end, b.end);
+		case 2: return compare_values(a.end - a.entry, b.end - b.entry);
+		case 3: return compare_values(a.reference_count, b.reference_count);
+		case 4: return compare_values(static_cast<int>(a.type), static_cast<int>(b.type));
+		default:
+			return 0;
+		}
+	}
+
+private:
+	const QVector<Row> &rows_;
+	const int           column_;
+	const Qt::SortOrder order_;
+};
+
+//------------------------------------------------------------------------------
+// Name: FunctionsModel
+// Desc: constructor
+//------------------------------------------------------------------------------
+FunctionsModel::FunctionsModel(QObject *parent) : QAbstractTableModel(parent), sort_column_(-1), sort_order_(Qt::AscendingOrder) {
+}
+
+//------------------------------------------------------------------------------
+// Name: ~FunctionsModel
+// Desc: destructor
+//------------------------------------------------------------------------------
+FunctionsModel::~FunctionsModel() {
+}
+
+//------------------------------------------------------------------------------
+// Name: data
+// Desc:
+//------------------------------------------------------------------------------
+QVariant FunctionsModel::data(const QModelIndex &index, int role) const {
+
+	if(!index.isValid() || index.row() >= rows_.size() || role != Qt::DisplayRole) {
+		return QVariant();
+	}
+
+	const IAnalyzer::FunctionSummary &function = rows_[index.row()].function;
+
+	switch(index.column()) {
+	case 0:
+		return edb::v1::format_pointer(function.entry);
+	case 1:
+		if(function.reference_count >= min_refcount) {
+			return edb::v1::format_pointer(function.end);
+		}
+		break;
+	case 2:
+		if(function.reference_count >= min_refcount) {
+			return static_cast<qulonglong>(function.end - function.entry + 1);
+		}
+		break;
+	case 3:
+		return function.reference_count;
+	case 4:
+		switch(function.type) {
+		case Function::FUNCTION_THUNK:    return tr("Thunk");
+		case Function::FUNCTION_STANDARD: return tr("Standard Function");
+		}
+		break;
+	}
+
+	return QVariant();
+}
+
+//------------------------------------------------------------------------------
+// Name: headerData
+// Desc:
+//------------------------------------------------------------------------------
+QVariant FunctionsModel::headerData(int section, Qt::Orientation orientation, int role) const {
+	if(role == Qt::DisplayRole && orientation == Qt::Horizontal) {
+		switch(section) {
+		case 0: return tr("Start Address");
+		case 1: return tr("End Address");
+		case 2: return tr("Size");
+		case 3: return tr("Score");
+		case 4: return tr("Type");
+		}
+	}
+
+	return QVariant();
+}
+
+//------------------------------------------------------------------------------
+// Name: columnCount
+// Desc:
+//------------------------------------------------------------------------------
+int FunctionsModel::columnCount(const QModelIndex &parent) const {
+	Q_UNUSED(parent);
+	return 5;
+}
+
+//------------------------------------------------------------------------------
+// Name: rowCount
+// Desc:
+//------------------------------------------------------------------------------
+int FunctionsModel::rowCount(const QModelIndex &parent) const {
+	Q_UNUSED(parent);
+	return rows_.size();
+}
+
+//------------------------------------------------------------------------------
+// Name: rebuild_rows
+// Desc: refreshes row_of_ after rows_ was reordered
+//------------------------------------------------------------------------------
+void FunctionsModel::rebuild_rows() {
+	row_of_.clear();
+	row_of_.reserve(rows_.size());
+	for(int i = 0; i < rows_.size(); ++i) {
+		row_of_.insert(rows_[i].function.entry, i);
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: sort
+// Desc: reorders the rows where they are, so that the view keeps the selection
+//       and anything else it holds on to. The order is kept up as rows are
+//       added
+//------------------------------------------------------------------------------
+void FunctionsModel::sort(int column, Qt::SortOrder order) {
+
+	sort_column_ = column;
+	sort_order_  = order;
+
+	if(column < 0 || rows_.size() < 2) {
+		return;
+	}
+
+	Q_EMIT layoutAboutToBeChanged();
+
+	QVector<int> order_of(rows_.size());
+	for(int i = 0; i < order_of.size(); ++i) {
+		order_of[i] = i;
+	}
+
+	std::sort(order_of.begin(), order_of.end(), RowLess(rows_, column, order));
+
+	QVector<Row> sorted(rows_.size());
+	QVector<int> new_row(rows_.size());
+	for(int i = 0; i < order_of.size(); ++i) {
+		sorted[i]            = rows_[order_of[i]];
+		new_row[order_of[i]] = i;
+	}
+
+	rows_.swap(sorted);
+	rebuild_rows();
+
+	const QModelIndexList from = persistentIndexList();
+	QModelIndexList to;
+	Q_FOREACH(const QModelIndex &index, from) {
+		to.push_back(index.isValid() ? this->index(new_row[index.row()], index.column()) : QModelIndex());
+	}
+	changePersistentIndexList(from, to);
+
+	Q_EMIT layoutChanged();
+}
+
+//------------------------------------------------------------------------------
+// Name: add_functions
+// Desc: <functions> of the region starting at <region> which are already
+//       listed are updated, the rest are added
+//------------------------------------------------------------------------------
+void FunctionsModel::add_functions(edb::address_t region, const IAnalyzer::FunctionTable &functions) {
+
+	QVector<Row> added;
+
+	Q_FOREACH(const IAnalyzer::FunctionSummary &function, functions) {
+		const QHash<edb::address_t, int>::const_iterator it = row_of_.find(function.entry);
+		if(it != row_of_.end()) {
+			Row &row = rows_[it.value()];
+			if(!same_function(row.function, function)) {
+				row.function = function;
+				Q_EMIT dataChanged(index(it.value(), 0), index(it.value(), columnCount() - 1));
+			}
+		} else {
+			Row row;
+			row.function = function;
+			row.region   = region;
+			added.push_back(row);
+		}
+	}
+
+	if(added.isEmpty()) {
+		return;
+	}
+
+	beginInsertRows(QModelIndex(), rows_.size(), rows_.size() + added.size() - 1);
+	Q_FOREACH(const Row &row, added) {
+		row_of_.insert(row.function.entry, rows_.size());
+		rows_.push_back(row);
+	}
+	endInsertRows();
+
+	sort(sort_column_, sort_order_);
+}
+
+//------------------------------------------------------------------------------
+// Name: set_functions
+// Desc: like add_functions, but <functions> are all of the region's, so any
+//       others listed for it are removed
+//------------------------------------------------------------------------------
+void FunctionsModel::set_functions(edb::address_t region, const IAnalyzer::FunctionTable &functions) {
+
+	QSet<edb::address_t> entries;
+	entries.reserve(functions.size());
+	Q_FOREACH(const IAnalyzer::FunctionSummary &function, functions) {
+		entries.insert(function.entry);
+	}
+
+	bool removed = false;
+
+	// removed from the end back, so the rows still to go keep their number
+	for(int i = rows_.size() - 1; i >= 0; --i) {
+		if(rows_[i].region == region && !entries.contains(rows_[i].function.entry)) {
+			int first = i;
+			while(first > 0 && rows_[first - 1].region == region && !entries.contains(rows_[first - 1].function.entry)) {
+				--first;
+			}
+
+			beginRemoveRows(QModelIndex(), first, i);
+			rows_.erase(rows_.begin() + first, rows_.begin() + i + 1);
+			endRemoveRows();
+
+			removed = true;
+			i       = first;
+		}
+	}
+
+	if(removed) {
+		rebuild_rows();
+	}
+
+	add_functions(region, functions);
+}
+
+//------------------------------------------------------------------------------
+// Name: clear
+// Desc:
+//------------------------------------------------------------------------------
+void FunctionsModel::clear() {
+	beginResetModel();
+	rows_.clear();
+	row_of_.clear();
+	endResetModel();
+}
+
+//------------------------------------------------------------------------------
+// Name: address
+// Desc: the entry point of the function in <index>'s row
+//------------------------------------------------------------------------------
+edb::address_t FunctionsModel::address(const QModelIndex &index) const {
+	if(index.isValid() && index.row() < rows_.size()) {
+		return rows_[index.row()].function.entry;
+	}
+
+	return 0;
+}
+
+}
@@ -0,0 +1,73 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef FUNCTIONSMODEL_20261014_H_
+#define FUNCTIONSMODEL_20261014_H_
+
+#include "IAnalyzer.h"
+#include "Types.h"
+#include <QAbstractTableModel>
+#include <QHash>
+#include <QVector>
+
+namespace FunctionFinder {
+
+// the functions found so far, as the analyzer's summaries of them. Rows are
+// only formatted when they are shown, they can be added to while the view is
+// open without it losing its place, and sorting compares the numbers rather
+// than the text
+class FunctionsModel : public QAbstractTableModel {
+	Q_OBJECT
+
+public:
+	FunctionsModel(QObject *parent = 0);
+	virtual ~FunctionsModel();
+
+public:
+	virtual QVariant data(const QModelIndex &index, int role) const;
+	virtual QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const;
+	virtual int columnCount(const QModelIndex &parent = QModelIndex()) const;
+	virtual int rowCount(const QModelIndex &parent = QModelIndex()) const;
+	virtual void sort(int column, Qt::SortOrder order = Qt::AscendingOrder);
+
+public:
+	void add_functions(edb::address_t region, const IAnalyzer::FunctionTable &functions);
+	void set_functions(edb::address_t region, const IAnalyzer::FunctionTable &functions);
+	void clear();
+	edb::address_t address(const QModelIndex &index) const;
+
+private:
+	struct Row {
+		IAnalyzer::FunctionSummary function;
+		edb::address_t             region;
+	};
+
+	class RowLess;
+
+private:
+	void rebuild_rows();
+
+private:
+	QVector<Row>               rows_;
+	QHash<edb::address_t, int> row_of_; // entry to row
+	int                        sort_column_;
+	Qt::SortOrder              sort_order_;
+};
+
+}
+
+#endif
@@ -25,6 +25,8 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <QMenu>
 #include <QDialog>
 
+#include <cstring>
+
 #include "ui_DialogHWBreakpoints.h"
 
 // TODO: at the moment, nearly this entire file is x86/x86-64 specific
@@ -64,34 +66,34 @@ QMenu *HardwareBreakpoints::menu(QWidget *parent) {
 // Name: setup_bp
 // Desc:
 //------------------------------------------------------------------------------
-void HardwareBreakpoints::setup_bp(State *state, int num, bool enabled, edb::address_t addr, int type, int size) {
+void HardwareBreakpoints::setup_bp(DebugRegisters *registers, int num, bool enabled, edb::address_t addr, int type, int size) {
 
 	const int N1 = 16 + (num * 4);
 	const int N2 = 18 + (num * 4);
 
 	// default to disabled
-	state->set_debug_register(7, (state->debug_register(7) & ~(0x01 << (num * 2))));
+	registers->control &= ~(0x01 << (num * 2));
 
 	if(enabled) {
 		// set the address
-		state->set_debug_register(num, addr);
+		registers->address[num] = addr;
 
 		// enable this breakpoint
-		state->set_debug_register(7, state->debug_register(7) | (0x01 << (num * 2)));
+		registers->control |= (0x01 << (num * 2));
 
 		// setup the type
 		switch(type) {
 		case 2:
 			// read/write
-			state->set_debug_register(7, (state->debug_register(7) & ~(0x03 << N1)) | (0x03 << N1));
+			registers->control = (registers->control & ~(0x03 << N1)) | (0x03 << N1);
 			break;
 		case 1:
 			// write
-			state->set_debug_register(7, (state->debug_register(7) & ~(0x03 << N1)) | (0x01 << N1));
+			registers->control = (registers->control & ~(0x03 << N1)) | (0x01 << N1);
 			break;
 		case 0:
 			// execute
-			state->set_debug_register(7, (state->debug_register(7) & ~(0x03 << N1)));
+			registers->control = (registers->control & ~(0x03 << N1));
 			break;
 		}
 
@@ -100,23 +102,43 @@ void HardwareBreakpoints::setup_bp(State *state, int num, bool enabled, edb::add
 			switch(size) {
 			case 2:
 				// 4 bytes
-				state->set_debug_register(7, (state->debug_register(7) & ~(0x03 << N2)) | (0x03 << N2));
+				registers->control = (registers->control & ~(0x03 << N2)) | (0x03 << N2);
 				break;
 			case 1:
 				// 2 bytes
-				state->set_debug_register(7, (state->debug_register(7) & ~(0x03 << N2)) | (0x01 << N2));
+				registers->control = (registers->control & ~(0x03 << N2)) | (0x01 << N2);
 				break;
 			case 0:
 				// 1 byte
-				state->set_debug_register(7, (state->debug_register(7) & ~(0x03 << N2)));
+				registers->control = (registers->control & ~(0x03 << N2));
 				break;
 			}
 		} else {
-			state->set_debug_register(7, (state->debug_register(7) & ~(0x03 << N2)));
+			registers->control = (registers->control & ~(0x03 << N2));
 		}
 	}
 }
 
+//------------------------------------------------------------------------------
+// Name: apply_breakpoints
+// Desc: the core gives the registers to every thread as it resumes them, if
+//       it can't, the active thread is all we can set them for
+//------------------------------------------------------------------------------
+void HardwareBreakpoints::apply_breakpoints(const DebugRegisters &registers) {
+
+	if(edb::v1::debugger_core->set_debug_registers(registers)) {
+		return;
+	}
+
+	State state;
+	edb::v1::debugger_core->get_state(&state);
+	for(int n = 0; n < 4; ++n) {
+		state.set_debug_register(n, registers.address[n]);
+	}
+	state.set_debug_register(7, registers.control);
+	edb::v1::debugger_core->set_state(state);
+}
+
 //------------------------------------------------------------------------------
 // Name: setup_breakpoints
 // Desc:
@@ -134,6 +156,9 @@ void HardwareBreakpoints::setup_breakpoints() {
 			p->ui->chkBP3->isChecked() ||
 			p->ui->chkBP4->isChecked();
 
+		DebugRegisters registers;
+		std::memset(&registers, 0, sizeof(registers));
+
 		if(enabled) {
 			// we want to be enabled, if we aren't already hooked,
 			// hook it
@@ -141,40 +166,34 @@ void HardwareBreakpoints::setup_breakpoints() {
 				old_event_handler_ = edb::v1::set_debug_event_handler(this);
 			}
 
-			State state;
 			bool ok;
-			edb::v1::debugger_core->get_state(&state);
-
 			edb::address_t addr;
 
 			addr = edb::v1::string_to_address(p->ui->txtBP1->text(), &ok);
 			if(ok) {
-				setup_bp(&state, 0, p->ui->chkBP1->isChecked(), addr, p->ui->cmbType1->currentIndex(), p->ui->cmbSize1->currentIndex());
+				setup_bp(&registers, 0, p->ui->chkBP1->isChecked(), addr, p->ui->cmbType1->currentIndex(), p->ui->cmbSize1->currentIndex());
 			}
 
 			addr = edb::v1::string_to_address(p->ui->txtBP2->text(), &ok);
 			if(ok) {
-				setup_bp(&state, 1, p->ui->chkBP2->isChecked(), addr, p->ui->cmbType2->currentIndex(), p->ui->cmbSize2->currentIndex());
+				setup_bp(&registers, 1, p->ui->chkBP2->isChecked(), addr, p->ui->cmbType2->currentIndex(), p->ui->cmbSize2->currentIndex());
 			}
 
 			addr = edb::v1::string_to_address(p->ui->txtBP3->text(), &ok);
 			if(ok) {
-				setup_bp(&state, 2, p->ui->chkBP3->isChecked(), addr, p->ui->cmbType3->currentIndex(), p->ui->cmbSize3->currentIndex());
+				setup_bp(&registers, 2, p->ui->chkBP3->isChecked(), addr, p->ui->cmbType3->currentIndex(), p->ui->cmbSize3->currentIndex());
 			}
 
 			addr = edb::v1::string_to_address(p->ui->txtBP4->text(), &ok);
 			if(ok) {
-				setup_bp(&state, 3, p->ui->chkBP4->isChecked(), addr, p->ui->cmbType4->currentIndex(), p->ui->cmbSize4->currentIndex());
+				setup_bp(&registers, 3, p->ui->chkBP4->isChecked(), addr, p->ui->cmbType4->currentIndex(), p->ui->cmbSize4->currentIndex());
 			}
 
-			edb::v1::debugger_core->set_state(state);
+			apply_breakpoints(registers);
 
 		} else {
 
-			State state;
-			edb::v1::debugger_core->get_state(&state);
-			state.set_debug_register(7, 0);
-			edb::v1::debugger_core->set_state(state);
+			apply_breakpoints(registers);
 
 			// we want to be disabled and we have hooked, so unhook
 			if(old_event_handler_) {
@@ -213,6 +232,9 @@ edb::EVENT_STATUS HardwareBreakpoints::handle_event(const IDebugEvent::const_poi
 		State state;
 		edb::v1::debugger_core->get_state(&state);
 		if((state.debug_register(6) & 0x0f) != 0x00) {
+			// the status bits are sticky, clear them so that the next trap
+			// isn't mistaken for another hit
+			state.set_debug_register(6, 0);
 			state.set_flags(state.flags() | (1 << 16));
 			edb::v1::debugger_core->set_state(state);
 		}
@@ -19,12 +19,12 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #ifndef HARDWAREBREAKPOINTS_20080228_H_
 #define HARDWAREBREAKPOINTS_20080228_H_
 
+#include "DebugRegisters.h"
 #include "IPlugin.h"
 #include "IDebugEventHandler.h"
 
 class QDialog;
 class QMenu;
-class State;
 
 namespace HardwareBreakpoints {
 
@@ -49,7 +49,8 @@ public Q_SLOTS:
 
 private:
 	void setup_breakpoints();
-	void setup_bp(State *state, int num, bool enabled, edb::address_t addr, int type, int size);
+	void setup_bp(DebugRegisters *registers, int num, bool enabled, edb::address_t addr, int type, int size);
+	void apply_breakpoints(const DebugRegisters &registers);
 
 private:
 	QMenu *              menu_;
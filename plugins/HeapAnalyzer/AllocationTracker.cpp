@@ -0,0 +1,360 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "AllocationTracker.h"
+#include "IDebugger.h"
+#include "IProcess.h"
+#include "ISymbolManager.h"
+#include "State.h"
+#include "Symbol.h"
+#include "edb.h"
+
+namespace HeapAnalyzer {
+
+namespace {
+
+const quint64 tracker_bp_tag = Q_UINT64_C(0x4845415054524143); // "HEAPTRAC" in hex
+
+// how many of the most recent calls are kept
+const int ring_size = 256 * 1024;
+
+//------------------------------------------------------------------------------
+// Name: read_pointer
+// Desc:
+//------------------------------------------------------------------------------
+edb::address_t read_pointer(edb::address_t address) {
+	edb::address_t value = 0;
+	if(IProcess *process = edb::v1::debugger_core->process()) {
+		process->read_bytes(address, &value, sizeof(value));
+	}
+	return value;
+}
+
+}
+
+//------------------------------------------------------------------------------
+// Name: AllocationTracker
+// Desc:
+//------------------------------------------------------------------------------
+AllocationTracker::AllocationTracker() : old_event_handler_(0), event_count_(0), result_register_(-1) {
+	argument_registers_[0] = -1;
+	argument_registers_[1] = -1;
+}
+
+//------------------------------------------------------------------------------
+// Name: ~AllocationTracker
+// Desc:
+//------------------------------------------------------------------------------
+AllocationTracker::~AllocationTracker() {
+	if(old_event_handler_) {
+		edb::v1::set_debug_event_handler(old_event_handler_);
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: start
+// Desc: puts breakpoints on the allocation functions of <libcName>, false if
+//       none of them could be found. What was logged before is thrown away
+//------------------------------------------------------------------------------
+bool AllocationTracker::start(const QString &libcName) {
+
+	if(running() || !edb::v1::debugger_core->process()) {
+		return running();
+	}
+
+	static const struct {
+		const char *name;
+		Kind        kind;
+	} functions[] = {
+		{ "malloc",  MALLOC  },
+		{ "calloc",  CALLOC  },
+		{ "realloc", REALLOC },
+		{ "free",    FREE    }
+	};
+
+	functions_.clear();
+	for(std::size_t i = 0; i < sizeof(functions) / sizeof(functions[0]); ++i) {
+		if(const Symbol::pointer symbol = edb::v1::symbol_manager().find(libcName + "::" + functions[i].name)) {
+			functions_.insert(symbol->address, functions[i].kind);
+		}
+	}
+
+	if(functions_.isEmpty()) {
+		return false;
+	}
+
+	// looked up once, a register name is too slow to go through on every call
+	State state;
+	edb::v1::debugger_core->get_state(&state);
+#if defined(EDB_X86_64)
+	argument_registers_[0] = state.register_index("rdi");
+	argument_registers_[1] = state.register_index("rsi");
+	result_register_       = state.register_index("rax");
+#else
+	result_register_       = state.register_index("eax");
+#endif
+
+	returns_.clear();
+	calls_.clear();
+	live_.clear();
+	events_ = QVector<Event>(ring_size);
+	event_count_ = 0;
+	step_bp_.clear();
+
+	const QList<IBreakpoint::pointer> breakpoints = edb::v1::debugger_core->add_breakpoints(functions_.keys());
+	Q_FOREACH(const IBreakpoint::pointer &bp, breakpoints) {
+		if(bp) {
+			bp->set_internal(true);
+			bp->tag = tracker_bp_tag;
+		}
+	}
+
+	old_event_handler_ = edb::v1::set_debug_event_handler(this);
+	return true;
+}
+
+//------------------------------------------------------------------------------
+// Name: stop
+// Desc: removes all of our breakpoints, what was logged is kept
+//------------------------------------------------------------------------------
+void AllocationTracker::stop() {
+
+	if(!running()) {
+		return;
+	}
+
+	if(edb::v1::debugger_core->process()) {
+		Q_FOREACH(edb::address_t address, functions_.keys()) {
+			remove_breakpoint(address);
+		}
+
+		Q_FOREACH(edb::address_t address, returns_.keys()) {
+			remove_breakpoint(address);
+		}
+	}
+
+	returns_.clear();
+	calls_.clear();
+	step_bp_.clear();
+
+	edb::v1::set_debug_event_handler(old_event_handler_);
+	old_event_handler_ = 0;
+}
+
+//------------------------------------------------------------------------------
+// Name: remove_breakpoint
+// Desc: removes the breakpoint at <address> if it is one of ours
+//------------------------------------------------------------------------------
+void AllocationTracker::remove_breakpoint(edb::address_t address) {
+	const IBreakpoint::pointer bp = edb::v1::debugger_core->find_breakpoint(address);
+	if(bp && bp->tag == tracker_bp_tag) {
+		edb::v1::debugger_core->remove_breakpoint(address);
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: events
+// Desc: the logged calls which are still in the ring, oldest first
+//------------------------------------------------------------------------------
+QVector<AllocationTracker::Event> AllocationTracker::events() const {
+
+	QVector<Event> ret;
+	if(events_.isEmpty()) {
+		return ret;
+	}
+
+	const quint64 first = (event_count_ > static_cast<quint64>(ring_size)) ? event_count_ - ring_size : 0;
+	ret.reserve(event_count_ - first);
+
+	for(quint64 i = first; i != event_count_; ++i) {
+		ret.push_back(events_[i % ring_size]);
+	}
+
+	return ret;
+}
+
+//------------------------------------------------------------------------------
+// Name: log
+// Desc: adds a call to the ring and brings the live allocations up to date
+//------------------------------------------------------------------------------
+void AllocationTracker::log(Kind kind, edb::address_t pointer, edb::address_t old_pointer, edb::address_t size, edb::address_t caller) {
+
+	Event &event      = events_[event_count_ % ring_size];
+	event.kind        = kind;
+	event.pointer     = pointer;
+	event.old_pointer = old_pointer;
+	event.size        = size;
+	event.caller      = caller;
+	++event_count_;
+
+	// realloc only frees the old block if it succeeds, or if the size is 0
+	if(kind == FREE || (kind == REALLOC && (pointer != 0 || size == 0))) {
+		live_.remove(old_pointer);
+	}
+
+	if(pointer != 0) {
+		const Allocation allocation = { size, caller };
+		live_.insert(pointer, allocation);
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: argument
+// Desc: the <n>th argument of a function which has just been called
+//------------------------------------------------------------------------------
+edb::address_t AllocationTracker::argument(const State &state, int n) const {
+#if defined(EDB_X86_64)
+	return state.register_value(argument_registers_[n]);
+#else
+	return read_pointer(state.stack_pointer() + (n + 1) * sizeof(edb::address_t));
+#endif
+}
+
+//------------------------------------------------------------------------------
+// Name: enter
+// Desc: a call to one of the functions. free is logged there and then, the
+//       others once they return to the caller
+//------------------------------------------------------------------------------
+void AllocationTracker::enter(edb::tid_t tid, Kind kind, const State &state) {
+
+	Call call;
+	call.kind         = kind;
+	call.arguments[0] = argument(state, 0);
+	call.arguments[1] = (kind == CALLOC || kind == REALLOC) ? argument(state, 1) : 0;
+	call.caller       = read_pointer(state.stack_pointer());
+	call.stack        = state.stack_pointer() + sizeof(edb::address_t);
+
+	if(kind == FREE) {
+		if(call.arguments[0] != 0) {
+			log(FREE, 0, call.arguments[0], 0, call.caller);
+		}
+		return;
+	}
+
+	// somebody else's breakpoint is already where it returns to, so we
+	// wouldn't get to see it
+	const IBreakpoint::pointer bp = edb::v1::debugger_core->find_breakpoint(call.caller);
+	if(bp && bp->tag != tracker_bp_tag) {
+		return;
+	}
+
+	if(!bp) {
+		if(const IBreakpoint::pointer ret = edb::v1::debugger_core->add_breakpoint(call.caller)) {
+			ret->set_internal(true);
+			ret->tag = tracker_bp_tag;
+		} else {
+			return;
+		}
+	}
+
+	++returns_[call.caller];
+	calls_[tid].push_back(call);
+}
+
+//------------------------------------------------------------------------------
+// Name: leave
+// Desc: a return to where one of the calls of <tid> came from. The stack
+//       pointer says which call it is when they nest or recurse
+//------------------------------------------------------------------------------
+void AllocationTracker::leave(edb::tid_t tid, edb::address_t address, const State &state) {
+
+	QVector<Call> &calls = calls_[tid];
+
+	for(int i = calls.size() - 1; i >= 0; --i) {
+		const Call &call = calls[i];
+		if(call.caller != address || call.stack != state.stack_pointer()) {
+			continue;
+		}
+
+		const edb::address_t result = state.register_value(result_register_);
+
+		switch(call.kind) {
+		case MALLOC:
+			log(MALLOC, result, 0, call.arguments[0], call.caller);
+			break;
+		case CALLOC:
+			log(CALLOC, result, 0, call.arguments[0] * call.arguments[1], call.caller);
+			break;
+		case REALLOC:
+			log(REALLOC, result, call.arguments[0], call.arguments[1], call.caller);
+			break;
+		case FREE:
+			break;
+		}
+
+		calls.remove(i);
+
+		if(--returns_[address] == 0) {
+			returns_.remove(address);
+			remove_breakpoint(address);
+		}
+		break;
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: handle_event
+// Desc: logs a hit on one of our breakpoints and steps past it if it is still
+//       needed, anything else is passed along
+//------------------------------------------------------------------------------
+edb::EVENT_STATUS AllocationTracker::handle_event(const IDebugEvent::const_pointer &event) {
+
+	if(!event->stopped() || !event->is_trap()) {
+		return old_event_handler_->handle_event(event);
+	}
+
+	// we just stepped past one of ours, put it back
+	if(step_bp_) {
+		step_bp_->enable();
+		step_bp_.clear();
+		return edb::DEBUG_CONTINUE;
+	}
+
+	State state;
+	edb::v1::debugger_core->get_state(&state);
+
+	const edb::address_t address = state.instruction_pointer() - 1;
+	const IBreakpoint::pointer bp = edb::v1::debugger_core->find_breakpoint(address);
+	if(!bp || bp->tag != tracker_bp_tag || !bp->enabled()) {
+		return old_event_handler_->handle_event(event);
+	}
+
+	state.set_instruction_pointer(address);
+	edb::v1::debugger_core->set_state(state);
+
+	if(returns_.contains(address)) {
+		leave(event->thread(), address, state);
+	}
+
+	const QHash<edb::address_t, Kind>::const_iterator it = functions_.find(address);
+	if(it != functions_.end()) {
+		enter(event->thread(), it.value(), state);
+	}
+
+	// a return breakpoint which nobody is waiting on any more is gone, the
+	// rest have to be stepped past
+	if(edb::v1::debugger_core->find_breakpoint(address) == bp) {
+		bp->disable();
+		step_bp_ = bp;
+		return edb::DEBUG_CONTINUE_STEP;
+	}
+
+	return edb::DEBUG_CONTINUE;
+}
+
+}
@@ -0,0 +1,111 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef ALLOCATIONTRACKER_20261014_H_
+#define ALLOCATIONTRACKER_20261014_H_
+
+#include "IDebugEventHandler.h"
+#include "IBreakpoint.h"
+#include "Types.h"
+
+#include <QHash>
+#include <QString>
+#include <QVector>
+
+class State;
+
+namespace HeapAnalyzer {
+
+// follows malloc, calloc, realloc and free as the process runs. A call is
+// caught by a breakpoint on the function and, unless it is free, one on where
+// it returns to. Each is logged to a fixed size ring buffer and the process is
+// resumed straight away, the GUI isn't involved
+class AllocationTracker : public IDebugEventHandler {
+public:
+	enum Kind {
+		MALLOC,
+		CALLOC,
+		REALLOC,
+		FREE
+	};
+
+	// one logged call. For free only old_pointer is set, for malloc and calloc
+	// it isn't
+	struct Event {
+		quint8         kind;
+		edb::address_t pointer;
+		edb::address_t old_pointer;
+		edb::address_t size;
+		edb::address_t caller;
+	};
+
+	struct Allocation {
+		edb::address_t size;
+		edb::address_t caller;
+	};
+
+public:
+	AllocationTracker();
+	virtual ~AllocationTracker();
+
+public:
+	bool start(const QString &libcName);
+	void stop();
+	bool running() const { return old_event_handler_ != 0; }
+
+public:
+	QVector<Event> events() const;
+	quint64 event_count() const { return event_count_; }
+	const QHash<edb::address_t, Allocation> &live() const { return live_; }
+
+public:
+	virtual edb::EVENT_STATUS handle_event(const IDebugEvent::const_pointer &event);
+
+private:
+	// a call which hasn't returned yet, <stack> is what the stack pointer will
+	// be once it has
+	struct Call {
+		Kind           kind;
+		edb::address_t arguments[2];
+		edb::address_t caller;
+		edb::address_t stack;
+	};
+
+private:
+	edb::address_t argument(const State &state, int n) const;
+	void enter(edb::tid_t tid, Kind kind, const State &state);
+	void leave(edb::tid_t tid, edb::address_t address, const State &state);
+	void log(Kind kind, edb::address_t pointer, edb::address_t old_pointer, edb::address_t size, edb::address_t caller);
+	void remove_breakpoint(edb::address_t address);
+
+private:
+	IDebugEventHandler                  *old_event_handler_;
+	IBreakpoint::pointer                 step_bp_;
+	QHash<edb::address_t, Kind>          functions_;
+	QHash<edb::address_t, int>           returns_;   // how many calls will return to each
+	QHash<edb::tid_t, QVector<Call> >    calls_;
+	QHash<edb::address_t, Allocation>    live_;
+	QVector<Event>                       events_;
+	quint64                              event_count_;
+	int                                  argument_registers_[2];
+	int                                  result_register_;
+};
+
+}
+
+#endif
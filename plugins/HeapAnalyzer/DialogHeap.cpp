@@ -22,27 +22,20 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "IDebugger.h"
 #include "ISymbolManager.h"
 #include "MemoryRegions.h"
+#include "RegionScanner.h"
 #include "Util.h"
 #include <QFileInfo>
 #include <QHeaderView>
 #include <QMessageBox>
 #include <QSortFilterProxyModel>
-#include <QStack>
 #include <QString>
 #include <QVector>
 #include <QtDebug>
 #include <algorithm>
-#include <boost/bind.hpp>
+#include <cstring>
 
 #ifdef ENABLE_GRAPH
 #include "GraphWidget.h"
-#include <graphviz/gvc.h>
-#endif
-
-#if QT_VERSION >= 0x050000
-#include <QtConcurrent>
-#elif QT_VERSION >= 0x040800
-#include <QtConcurrentMap>
 #endif
 
 #include "ui_DialogHeap.h"
@@ -80,14 +73,190 @@ edb::address_t block_start(edb::address_t pointer) {
 	return pointer + sizeof(struct malloc_chunk *) * 2;
 }
 
+// how much of the heap is read at a time
+const std::size_t window_size = 1024 * 1024;
+
+// how much of a block is looked at to guess what it holds
+const std::size_t max_probe_size = 64 * 1024;
+
+// laying out much more than this takes graphviz a very long time
+const int max_graph_nodes = 3000;
+
+// reads the heap a window at a time. A chunk walk only ever moves forwards,
+// so each window is read once however many chunks are in it
+class HeapReader {
+public:
+	HeapReader(IProcess *process, edb::address_t end_address) : process_(process), end_address_(end_address), start_(0) {
+	}
+
+public:
+	// the <size> bytes at <address>, moving the window up to them if they
+	// aren't in it already. The pointer is good until the next read
+	const quint8 *read(edb::address_t address, std::size_t size) {
+
+		if(buffer_.isEmpty() || address < start_ || address + size > start_ + buffer_.size()) {
+
+			const std::size_t remaining = (address < end_address_) ? end_address_ - address : 0;
+			const std::size_t length    = qMax(size, qMin(window_size, remaining));
+
+			buffer_.fill(0, length);
+			process_->read_bytes(address, buffer_.data(), length);
+			start_ = address;
+		}
+
+		return buffer_.constData() + (address - start_);
+	}
+
+private:
+	IProcess *const      process_;
+	const edb::address_t end_address_;
+	edb::address_t       start_;
+	QVector<quint8>      buffer_;
+};
+
 //------------------------------------------------------------------------------
-// Name: block_start
-// Desc:
+// Name: heap_regions
+// Desc: the parts of the memory regions which are in the heaps, for scanning
+//       just them
 //------------------------------------------------------------------------------
-edb::address_t block_start(const Result &result) {
-	return block_start(result.block);
+QList<IRegion::pointer> heap_regions(const QVector<Heap> &heaps) {
+
+	QList<IRegion::pointer> regions;
+
+	Q_FOREACH(const Heap &heap, heaps) {
+		Q_FOREACH(const IRegion::pointer &region, edb::v1::memory_regions().regions()) {
+			if(region->end() > heap.start && region->start() < heap.end) {
+				const IRegion::pointer part(region->clone());
+				part->set_start(qMax(region->start(), heap.start));
+				part->set_end(qMin(region->end(), heap.end));
+				regions.push_back(part);
+			}
+		}
+	}
+
+	return regions;
 }
 
+//------------------------------------------------------------------------------
+// Name: chunk_type
+// Desc: chunks on one of malloc's free lists say which, any other is busy if
+//       the next chunk says so. That isn't enough on its own, tcache and
+//       fastbin chunks look busy to the chunk after them
+//------------------------------------------------------------------------------
+ResultViewModel::ChunkType chunk_type(const GlibcHeap &glibc, edb::address_t chunk, bool in_use) {
+
+	GlibcHeap::FreeList list;
+	if(glibc.find_free(chunk, &list)) {
+		switch(list) {
+		case GlibcHeap::FREE_TCACHE:   return ResultViewModel::CHUNK_TCACHE;
+		case GlibcHeap::FREE_FASTBIN:  return ResultViewModel::CHUNK_FASTBIN;
+		case GlibcHeap::FREE_UNSORTED: return ResultViewModel::CHUNK_UNSORTED;
+		case GlibcHeap::FREE_SMALLBIN: return ResultViewModel::CHUNK_SMALLBIN;
+		case GlibcHeap::FREE_LARGEBIN: return ResultViewModel::CHUNK_LARGEBIN;
+		}
+	}
+
+	return in_use ? ResultViewModel::CHUNK_BUSY : ResultViewModel::CHUNK_FREE;
+}
+
+// the data of every block, sorted by address. Blocks don't overlap, so the
+// one an address is in is found with a binary search, and once built it is
+// only ever read, so every scanning thread can share it
+class BlockIndex {
+public:
+	struct Block {
+		edb::address_t start;
+		edb::address_t end;
+		int            chunk;
+	};
+
+public:
+	explicit BlockIndex(const ResultViewModel &model) {
+		for(int i = 0; i < model.chunkCount(); ++i) {
+			const Block block = { block_start(model.block(i)), block_start(model.block(i)) + model.size(i), i };
+			blocks_.push_back(block);
+		}
+
+		std::sort(blocks_.begin(), blocks_.end(), start_less);
+	}
+
+public:
+	// the block whose data <address> is in, or 0
+	const Block *find(edb::address_t address) const {
+		if(blocks_.isEmpty() || address < blocks_.first().start || address >= blocks_.last().end) {
+			return 0;
+		}
+
+		QVector<Block>::const_iterator it = std::upper_bound(blocks_.begin(), blocks_.end(), address, address_less);
+		if(it != blocks_.begin() && address < (it - 1)->end) {
+			return &*(it - 1);
+		}
+
+		return 0;
+	}
+
+private:
+	static bool start_less(const Block &lhs, const Block &rhs) {
+		return lhs.start < rhs.start;
+	}
+
+	static bool address_less(edb::address_t address, const Block &block) {
+		return address < block.start;
+	}
+
+private:
+	QVector<Block> blocks_;
+};
+
+// finds the references in the heap. The heap is read a window at a time and
+// the windows are scanned in parallel, each aligned slot whose value is a slot
+// in some block is a reference if the slot itself is in one too
+class PointerScan : public RegionScanner::Task {
+public:
+	PointerScan(const BlockIndex &index, QVector<Reference> *references, QProgressBar *progress) : index_(index), references_(references), progress_(progress) {
+	}
+
+public:
+	virtual Result *scan(const RegionScanner::Chunk &chunk) const {
+
+		List<Reference> *const result = new List<Reference>;
+
+		const quint8 *const first = chunk.data.constData();
+		const std::size_t   skip  = (sizeof(edb::address_t) - chunk.address % sizeof(edb::address_t)) % sizeof(edb::address_t);
+
+		for(std::size_t i = skip; i + sizeof(edb::address_t) <= chunk.size; i += sizeof(edb::address_t)) {
+
+			edb::address_t value;
+			std::memcpy(&value, first + i, sizeof(value));
+
+			const BlockIndex::Block *const to = index_.find(value);
+			if(!to || (value - to->start) % sizeof(edb::address_t) != 0) {
+				continue;
+			}
+
+			if(const BlockIndex::Block *const from = index_.find(chunk.address + i)) {
+				const Reference reference = { value, from->chunk, to->chunk };
+				result->items.push_back(reference);
+			}
+		}
+
+		return result;
+	}
+
+	virtual void merge(Result *result) {
+		*references_ += static_cast<List<Reference> *>(result)->items;
+	}
+
+	virtual void progress(int percent) {
+		progress_->setValue(percent);
+	}
+
+private:
+	const BlockIndex         &index_;
+	QVector<Reference> *const references_;
+	QProgressBar       *const progress_;
+};
+
 }
 
 //------------------------------------------------------------------------------
@@ -138,8 +307,9 @@ void DialogHeap::on_tableView_doubleClicked(const QModelIndex &index) {
 	// NOTE: remember that if we use a sort filter, we need to map the indexes
 	// to get at the data we need
 
-	if(const Result *const item = static_cast<Result *>(index.internalPointer())) {
-		edb::v1::dump_data_range(item->block, item->block + item->size, false);
+	const int chunk = model_->chunkAt(index);
+	if(chunk != -1) {
+		edb::v1::dump_data_range(model_->block(chunk), model_->block(chunk) + model_->size(chunk), false);
 	}
 }
 
@@ -147,12 +317,12 @@ void DialogHeap::on_tableView_doubleClicked(const QModelIndex &index) {
 // Name: get_library_names
 // Desc:
 //------------------------------------------------------------------------------
-void DialogHeap::get_library_names(QString *libcName, QString *ldName) const {
+void DialogHeap::get_library_names(QString *libcName, QString *ldName) {
 	
 	Q_ASSERT(libcName);
 	Q_ASSERT(ldName);
 	
-	const QList<Module> libs = edb::v1::debugger_core->loaded_modules();
+	const QList<Module> libs = edb::v1::loaded_modules();
 
 	Q_FOREACH(const Module &module, libs) {
 		if(!ldName->isEmpty() && !libcName->isEmpty()) {
@@ -185,186 +355,177 @@ void DialogHeap::get_library_names(QString *libcName, QString *ldName) const {
 	}
 }
 
-//------------------------------------------------------------------------------
-// Name: process_potential_pointer
-// Desc:
-//------------------------------------------------------------------------------
-void DialogHeap::process_potential_pointer(const QHash<edb::address_t, edb::address_t> &targets, Result &result) {
-	
-	if(IProcess *process = edb::v1::debugger_core->process()) {
-		if(result.data.isEmpty()) {
-			edb::address_t pointer;
-			edb::address_t block_ptr = block_start(result);
-			edb::address_t block_end = block_ptr + result.size;
-
-			while(block_ptr < block_end) {
-
-				if(process->read_bytes(block_ptr, &pointer, sizeof(pointer))) {
-					QHash<edb::address_t, edb::address_t>::const_iterator it = targets.find(pointer);
-					if(it != targets.end()) {
-					#if QT_POINTER_SIZE == 4
-						result.data += QString("dword ptr [%1] |").arg(edb::v1::format_pointer(it.key()));
-					#elif QT_POINTER_SIZE == 8
-						result.data += QString("qword ptr [%1] |").arg(edb::v1::format_pointer(it.key()));
-					#endif
-					result.points_to.push_back(it.value());
-					}
-				}
-
-				block_ptr += sizeof(edb::address_t);
-			}
-
-			result.data.truncate(result.data.size() - 2);
-		}
-	}
-}
-
 //------------------------------------------------------------------------------
 // Name: detect_pointers
-// Desc:
+// Desc: finds the pointers from each block to the others, blocks which were
+//       recognized as holding something else are left alone
 //------------------------------------------------------------------------------
-void DialogHeap::detect_pointers() {
+void DialogHeap::detect_pointers(const QVector<Heap> &heaps) {
 
 	qDebug() << "[Heap Analyzer] detecting pointers in heap blocks";
 
-	QHash<edb::address_t, edb::address_t> targets;
-	QVector<Result> &results = model_->results();
-
-	// the potential targets
-	qDebug() << "[Heap Analyzer] collecting possible targets addresses";
-	Q_FOREACH(const Result &result, results) {
-		edb::address_t block_ptr = block_start(result);
-		edb::address_t block_end = block_ptr + result.size;
-		while(block_ptr < block_end) {
-			targets.insert(block_ptr, result.block);
-			block_ptr += sizeof(edb::address_t);
-		}
-	}
+	const BlockIndex   index(*model_);
+	QVector<Reference> references;
 
-#if QT_VERSION >= 0x040800
-	QtConcurrent::blockingMap(
-		results,
-		boost::bind(&DialogHeap::process_potential_pointer, this, targets, _1));
-#else
-	std::for_each(
-		results.begin(),
-		results.end(),
-		boost::bind(&DialogHeap::process_potential_pointer, this, targets, _1));
-#endif
+	PointerScan scan(index, &references, ui->progressBar);
+	RegionScanner().run(heap_regions(heaps), &scan);
 
-	model_->update();
+	// the references come in address order, so each block's are in order too
+	model_->setReferences(references);
 }
 
 //------------------------------------------------------------------------------
 // Name: collect_blocks
-// Desc:
+// Desc: walks the chunks of each heap in turn, reading the process can only be
+//       done from one thread at a time
 //------------------------------------------------------------------------------
-void DialogHeap::collect_blocks(edb::address_t start_address, edb::address_t end_address) {
+void DialogHeap::collect_blocks(const QVector<Heap> &heaps, const GlibcHeap &glibc) {
 	model_->clearResults();
 
 	if(IProcess *process = edb::v1::debugger_core->process()) {
 		const int min_string_length = edb::v1::config().min_string_length;
 
-		if(start_address != 0 && end_address != 0) {
+		edb::address_t how_many = 0;
+		Q_FOREACH(const Heap &heap, heaps) {
+			how_many += heap.end - heap.start;
+		}
+
+		if(how_many != 0) {
 	#if defined(Q_OS_LINUX) || defined(Q_OS_FREEBSD) || defined(Q_OS_OPENBSD)
 			malloc_chunk currentChunk;
 			malloc_chunk nextChunk;
-			edb::address_t currentChunkAddress = start_address;
 
 			model_->setUpdatesEnabled(false);
 
-			const edb::address_t how_many = end_address - start_address;
-			while(currentChunkAddress != end_address) {
-				// read in the current chunk..
-				process->read_bytes(currentChunkAddress, &currentChunk, sizeof(currentChunk));
-
-				// figure out the address of the next chunk
-				const edb::address_t nextChunkAddress = next_chunk(currentChunkAddress, currentChunk);
+			edb::address_t done = 0;
 
-				// is this the last chunk (if so, it's the 'top')
-				if(nextChunkAddress == end_address) {
+			Q_FOREACH(const Heap &heap, heaps) {
+				const edb::address_t start_address = heap.start;
+				const edb::address_t end_address   = heap.end;
 
-					const Result r(
-						currentChunkAddress,
-						currentChunk.chunk_size(),
-						tr("Top"));
+				edb::address_t currentChunkAddress = start_address;
+				HeapReader     reader(process, end_address);
 
-					model_->addResult(r);
+				while(currentChunkAddress != end_address) {
+					// read in the current chunk..
+					std::memcpy(&currentChunk, reader.read(currentChunkAddress, sizeof(currentChunk)), sizeof(currentChunk));
 
-				} else {
+					// figure out the address of the next chunk
+					const edb::address_t nextChunkAddress = next_chunk(currentChunkAddress, currentChunk);
 
-					// make sure we aren't following a broken heap...
-					if(nextChunkAddress > end_address || nextChunkAddress < start_address) {
-						break;
-					}
+					// is this the last chunk (if so, it's the 'top')
+					if(nextChunkAddress == end_address) {
 
-					QString data;
-
-					// read in the next chunk
-					process->read_bytes(nextChunkAddress, &nextChunk, sizeof(nextChunk));
-
-					// if this block is a container for an ascii string, display it...
-					// there is a lot of room for improvement here, but it's a start
-					QString asciiData;
-					QString utf16Data;
-					int asciisz;
-					int utf16sz;
-					if(edb::v1::get_ascii_string_at_address(
-							block_start(currentChunkAddress),
-							asciiData,
-							min_string_length,
+						model_->addChunk(
+							currentChunkAddress,
 							currentChunk.chunk_size(),
-							asciisz)) {
+							ResultViewModel::CHUNK_TOP);
 
-						data = QString("ASCII \"%1\"").arg(asciiData);
-					} else if(edb::v1::get_utf16_string_at_address(
-							block_start(currentChunkAddress),
-							utf16Data,
-							min_string_length,
-							currentChunk.chunk_size(),
-							utf16sz)) {
-						data = QString("UTF-16 \"%1\"").arg(utf16Data);
 					} else {
 
-						using std::memcmp;
-
-						quint8 bytes[16];
-						process->read_bytes(block_start(currentChunkAddress), bytes, sizeof(bytes));
-
-						if(memcmp(bytes, "\x89\x50\x4e\x47", 4) == 0) {
-							data = "PNG IMAGE";
-						} else if(memcmp(bytes, "\x2f\x2a\x20\x58\x50\x4d\x20\x2a\x2f", 9) == 0) {
-							data = "XPM IMAGE";
-						} else if(memcmp(bytes, "\x42\x5a", 2) == 0) {
-							data = "BZIP FILE";
-						} else if(memcmp(bytes, "\x1f\x9d", 2) == 0) {
-							data = "COMPRESS FILE";
-						} else if(memcmp(bytes, "\x1f\x8b", 2) == 0) {
-							data = "GZIP FILE";
+						// make sure we aren't following a broken heap...
+						if(nextChunkAddress > end_address || nextChunkAddress < start_address) {
+							break;
+						}
+
+						ResultViewModel::DataType data = ResultViewModel::DATA_NONE;
+						QString                   text;
+
+						// the start of this block's data is what we use to guess
+						// what the block contains, the magic numbers need at least
+						// a few bytes of it whatever the block's size
+						const size_t probe_size   = qMin(static_cast<size_t>(currentChunk.chunk_size()), max_probe_size);
+						const quint8 *const bytes = reader.read(block_start(currentChunkAddress), qMax<size_t>(probe_size, 16));
+
+						// if this block is a container for an ascii string, display it...
+						// there is a lot of room for improvement here, but it's a start
+						QString asciiData;
+						QString utf16Data;
+						int asciisz;
+						int utf16sz;
+						if(edb::v1::get_ascii_string_from_buffer(
+								bytes,
+								probe_size,
+								asciiData,
+								min_string_length,
+								currentChunk.chunk_size(),
+								asciisz)) {
+
+							// only a string in a huge block may go on past the probe
+							if(static_cast<size_t>(asciisz) == probe_size && probe_size < currentChunk.chunk_size()) {
+								edb::v1::get_ascii_string_at_address(
+									block_start(currentChunkAddress),
+									asciiData,
+									min_string_length,
+									currentChunk.chunk_size(),
+									asciisz);
+							}
+
+							data = ResultViewModel::DATA_ASCII;
+							text = asciiData;
+						} else if(edb::v1::get_utf16_string_from_buffer(
+								bytes,
+								probe_size,
+								utf16Data,
+								min_string_length,
+								currentChunk.chunk_size(),
+								utf16sz)) {
+
+							if(static_cast<size_t>(utf16sz) * sizeof(quint16) == (probe_size & ~1) && probe_size < currentChunk.chunk_size()) {
+								edb::v1::get_utf16_string_at_address(
+									block_start(currentChunkAddress),
+									utf16Data,
+									min_string_length,
+									currentChunk.chunk_size(),
+									utf16sz);
+							}
+
+							data = ResultViewModel::DATA_UTF16;
+							text = utf16Data;
+						} else {
+
+							using std::memcmp;
+
+							if(memcmp(bytes, "\x89\x50\x4e\x47", 4) == 0) {
+								data = ResultViewModel::DATA_PNG;
+							} else if(memcmp(bytes, "\x2f\x2a\x20\x58\x50\x4d\x20\x2a\x2f", 9) == 0) {
+								data = ResultViewModel::DATA_XPM;
+							} else if(memcmp(bytes, "\x42\x5a", 2) == 0) {
+								data = ResultViewModel::DATA_BZIP;
+							} else if(memcmp(bytes, "\x1f\x9d", 2) == 0) {
+								data = ResultViewModel::DATA_COMPRESS;
+							} else if(memcmp(bytes, "\x1f\x8b", 2) == 0) {
+								data = ResultViewModel::DATA_GZIP;
+							}
+
 						}
 
+						// the next chunk says whether this one is in use, it is
+						// read last as it moves the window on
+						std::memcpy(&nextChunk, reader.read(nextChunkAddress, sizeof(nextChunk)), sizeof(nextChunk));
+
+						model_->addChunk(
+							currentChunkAddress,
+							currentChunk.chunk_size() + sizeof(unsigned int),
+							chunk_type(glibc, currentChunkAddress, nextChunk.prev_inuse()),
+							data,
+							text);
 					}
 
-					const Result r(
-						currentChunkAddress,
-						currentChunk.chunk_size() + sizeof(unsigned int),
-						nextChunk.prev_inuse() ? tr("Busy") : tr("Free"),
-						data);
+					// avoif self referencing blocks
+					if(currentChunkAddress == nextChunkAddress) {
+						break;
+					}
 
-					model_->addResult(r);
-				}
+					currentChunkAddress = nextChunkAddress;
 
-				// avoif self referencing blocks
-				if(currentChunkAddress == nextChunkAddress) {
-					break;
+					ui->progressBar->setValue(util::percentage(done + (currentChunkAddress - start_address), how_many));
 				}
 
-				currentChunkAddress = nextChunkAddress;
-
-				ui->progressBar->setValue(util::percentage(currentChunkAddress - start_address, how_many));
+				done += end_address - start_address;
 			}
 
-			detect_pointers();
+			detect_pointers(heaps);
 			model_->setUpdatesEnabled(true);
 
 
@@ -486,7 +647,26 @@ void DialogHeap::do_find() {
 		qDebug() << "[Heap Analyzer] heap start : " << edb::v1::format_pointer(start_address);
 		qDebug() << "[Heap Analyzer] heap end   : " << edb::v1::format_pointer(end_address);
 
-		collect_blocks(start_address, end_address);
+		// with main_arena, malloc can say where the other arenas' heaps are and
+		// which chunks it has free
+		const Heap main_heap = { start_address, end_address };
+
+		GlibcHeap     glibc;
+		QVector<Heap> heaps;
+
+		if(const Symbol::pointer arena = edb::v1::symbol_manager().find(libcName + "::main_arena")) {
+			if(glibc.load(process, arena->address, main_heap)) {
+				heaps = glibc.heaps();
+			} else {
+				qDebug() << "[Heap Analyzer] main_arena doesn't look like a malloc_state, only the main heap will be shown";
+			}
+		}
+
+		if(heaps.isEmpty()) {
+			heaps.push_back(main_heap);
+		}
+
+		collect_blocks(heaps, glibc);
 	}
 }
 
@@ -504,85 +684,92 @@ void DialogHeap::on_btnFind_clicked() {
 
 //------------------------------------------------------------------------------
 // Name: on_btnGraph_clicked
-// Desc:
+// Desc: draws the blocks within the chosen number of pointers of the selected
+//       ones, following pointers either way, or the whole of their connected
+//       component if there is no limit. The layout is done in the background
 //------------------------------------------------------------------------------
 void DialogHeap::on_btnGraph_clicked() {
 #ifdef ENABLE_GRAPH
-	GVC_t *const gvc = gvContext();
-	graph_t *const g = agopen(const_cast<char*>("g"), AGDIGRAPH);
+	const int count = model_->chunkCount();
 
-	const QVector<Result> &results = model_->results();
+	// the blocks which point to each block, to follow pointers backwards
+	QVector<QVector<int> > referrers(count);
+	for(int i = 0; i < count; ++i) {
+		for(int r = model_->referencesBegin(i); r != model_->referencesEnd(i); ++r) {
+			referrers[model_->referenceTarget(r)].push_back(i);
+		}
+	}
 
-	do {
-		QMap<edb::address_t, node_t *>        nodes;
-		QHash<edb::address_t, const Result *> result_map;
-		QStack<const Result *>                result_stack;
-		QSet<const Result *>                  seen_results;
+	// how far each block in the graph is from the selection, -1 for the rest
+	QVector<int> depth(count, -1);
+	QVector<int> nodes;
 
-		// first we make a nice index for our results, this is likely redundant,
-		// but won't take long
-		Q_FOREACH(const Result &result, results) {
-			result_map.insert(result.block, &result);
+	const QModelIndexList sel = ui->tableView->selectionModel()->selectedRows();
+	Q_FOREACH(const QModelIndex &selected, sel) {
+		const int n = model_->chunkAt(selected);
+		if(n != -1 && depth[n] == -1) {
+			depth[n] = 0;
+			nodes.push_back(n);
 		}
+	}
 
-		// seed our search with the selected blocks
-		const QItemSelectionModel *const selModel = ui->tableView->selectionModel();
-		const QModelIndexList sel = selModel->selectedRows();
-		if(sel.size() != 0) {
-			Q_FOREACH(QModelIndex index, sel) {
-				const Result *const item = static_cast<Result *>(index.internalPointer());
-					result_stack.push(item);
-					seen_results.insert(item);
-			}
-		}
+	if(nodes.isEmpty()) {
+		QMessageBox::information(this, tr("Heap Graph"), tr("Select the blocks to graph first."));
+		return;
+	}
 
-		while(!result_stack.isEmpty()) {
-			const Result *const result = result_stack.pop();
-			node_t *n = agnode(g, const_cast<char*>(qPrintable(edb::v1::format_pointer(result->block))));
-			if(result->type == tr("Busy")) {
-				agsafeset(n, const_cast<char*>("fillcolor"), const_cast<char*>("green"), const_cast<char*>(""));
-			} else {
-				agsafeset(n, const_cast<char*>("fillcolor"), const_cast<char*>("red"), const_cast<char*>(""));
-			}
-			agsafeset(n, const_cast<char*>("style"), const_cast<char*>("filled"), const_cast<char*>(""));
-			//agsafeset(n, const_cast<char*>("shape"), const_cast<char*>("box"), const_cast<char*>(""));
+	const int max_depth = ui->spnGraphDepth->value();
 
-			nodes.insert(result->block, n);
+	// breadth first, so giving up part way still leaves the nearest blocks
+	for(int i = 0; i < nodes.size() && nodes.size() <= max_graph_nodes; ++i) {
+		const int n = nodes[i];
+		if(max_depth != 0 && depth[n] == max_depth) {
+			continue;
+		}
 
-			Q_FOREACH(edb::address_t pointer, result->points_to) {
-				const Result *next_result = result_map[pointer];
-				if(!seen_results.contains(next_result)) {
-					seen_results.insert(next_result);
-					result_stack.push(next_result);
-				}
+		QVector<int> neighbours = referrers[n];
+		for(int r = model_->referencesBegin(n); r != model_->referencesEnd(n); ++r) {
+			neighbours.push_back(model_->referenceTarget(r));
+		}
+
+		Q_FOREACH(int m, neighbours) {
+			if(depth[m] == -1) {
+				depth[m] = depth[n] + 1;
+				nodes.push_back(m);
 			}
 		}
+	}
 
-		qDebug("[Heap Analyzer] Done Processing %d Nodes", nodes.size());
+	qDebug("[Heap Analyzer] Done Processing %d Nodes", nodes.size());
 
-		if(nodes.size() > 3000) {
-			qDebug("[Heap Analyzer] Too Many Nodes! (%d)", nodes.size());
-			return;
-		}
+	if(nodes.size() > max_graph_nodes) {
+		QMessageBox::information(this, tr("Heap Graph"), tr("More than %1 blocks are that close to the selected ones, try a smaller depth.").arg(max_graph_nodes));
+		return;
+	}
 
-		Q_FOREACH(const Result *result, result_map) {
-			const edb::address_t addr = result->block;
-			if(nodes.contains(addr)) {
-				Q_FOREACH(edb::address_t pointer, result->points_to) {
-					agedge(g, nodes[addr], nodes[pointer]);
-				}
+	QByteArray dot("strict digraph heap {\n");
+	dot += "\tnode [style=filled];\n";
+
+	Q_FOREACH(int n, nodes) {
+		dot += QString("\tb%1 [label=\"%2\" fillcolor=%3];\n").arg(n).arg(edb::v1::format_pointer(model_->block(n))).arg(model_->type(n) == ResultViewModel::CHUNK_BUSY ? "green" : "red").toUtf8();
+	}
+
+	Q_FOREACH(int n, nodes) {
+		for(int r = model_->referencesBegin(n); r != model_->referencesEnd(n); ++r) {
+			const int to = model_->referenceTarget(r);
+			if(depth[to] != -1) {
+				dot += QString("\tb%1 -> b%2;\n").arg(n).arg(to).toUtf8();
 			}
 		}
+	}
 
-		qDebug("[Heap Analyzer] Done Processing Edges");
-	} while(0);
+	dot += "}\n";
 
-	GraphWidget *graph = new GraphWidget(gvc, g, "dot");
+	GraphWidget *const graph = new GraphWidget;
+	graph->setAttribute(Qt::WA_DeleteOnClose);
+	graph->setWindowTitle(tr("Heap Graph"));
+	graph->layout_graph(dot, "dot");
 	graph->show();
-
-	gvFreeLayout(gvc, g);
-	agclose(g);
-	gvFreeContext(gvc);
 #endif
 }
 
@@ -20,6 +20,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #define DIALOGHEAP_20061101_H_
 
 #include "Types.h"
+#include "GlibcHeap.h"
 #include "ResultViewModel.h"
 
 #include <QDialog>
@@ -38,6 +39,9 @@ public:
 	DialogHeap(QWidget *parent = 0);
 	virtual ~DialogHeap();
 
+public:
+	static void get_library_names(QString *libcName, QString *ldName);
+
 public Q_SLOTS:
 	void on_btnFind_clicked();
 	void on_btnGraph_clicked();
@@ -47,11 +51,9 @@ private:
 	virtual void showEvent(QShowEvent *event);
 
 private:
-	void get_library_names(QString *libcName, QString *ldName) const;
-	void collect_blocks(edb::address_t start_address, edb::address_t end_address);
-	void detect_pointers();
+	void collect_blocks(const QVector<Heap> &heaps, const GlibcHeap &glibc);
+	void detect_pointers(const QVector<Heap> &heaps);
 	void do_find();
-	void process_potential_pointer(const QHash<edb::address_t, edb::address_t> &targets, Result &result);
 
 	edb::address_t find_heap_start_heuristic(edb::address_t end_address, size_t offset) const;
 
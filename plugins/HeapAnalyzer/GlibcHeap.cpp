@@ -0,0 +1,378 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "GlibcHeap.h"
+#include "IProcess.h"
+#include <QSet>
+#include <algorithm>
+
+namespace HeapAnalyzer {
+
+namespace {
+
+const std::size_t pointer_size     = sizeof(edb::address_t);
+const std::size_t nfastbins        = 10;
+const std::size_t nbins            = 128;
+const std::size_t nsmallbins       = 64;
+const std::size_t binmap_size      = 4;
+const std::size_t tcache_max_bins  = 64;
+const edb::address_t malloc_alignment = 16;
+
+// the mmapped heaps of an arena other than main_arena are aligned to this, so
+// the heap_info of any address in one is found by rounding it down
+#if defined(EDB_X86_64)
+const edb::address_t heap_max_size = 64 * 1024 * 1024;
+#else
+const edb::address_t heap_max_size = 1024 * 1024;
+#endif
+
+// limits for following lists in a heap which may well be corrupt
+const int max_arenas      = 1024;
+const int max_heaps       = 4096;
+const int max_list_length = 1000000;
+
+//------------------------------------------------------------------------------
+// Name: heap_less
+// Desc:
+//------------------------------------------------------------------------------
+bool heap_less(const Heap &lhs, const Heap &rhs) {
+	return lhs.start < rhs.start;
+}
+
+//------------------------------------------------------------------------------
+// Name: request2size
+// Desc: the size of the chunk malloc hands out for a <request> byte allocation
+//------------------------------------------------------------------------------
+std::size_t request2size(std::size_t request) {
+	return (request + pointer_size + malloc_alignment - 1) & ~(malloc_alignment - 1);
+}
+
+//------------------------------------------------------------------------------
+// Name: align_chunk
+// Desc: moves a chunk at <address> up as far as it needs to go for its data
+//       to be aligned, as malloc does with the first chunk of a heap
+//------------------------------------------------------------------------------
+edb::address_t align_chunk(edb::address_t address) {
+	const edb::address_t misalign = (address + 2 * pointer_size) % malloc_alignment;
+	return misalign ? address + malloc_alignment - misalign : address;
+}
+
+}
+
+//------------------------------------------------------------------------------
+// Name: GlibcHeap
+// Desc:
+//------------------------------------------------------------------------------
+GlibcHeap::GlibcHeap() : process_(0) {
+}
+
+//------------------------------------------------------------------------------
+// Name: layout
+// Desc: where the fields of malloc_state are, glibc 2.27 added have_fastchunks
+//       after flags which moves everything after it along
+//------------------------------------------------------------------------------
+GlibcHeap::Layout GlibcHeap::layout(bool have_fastchunks) {
+	Layout layout;
+	layout.fastbins = have_fastchunks ? (3 * sizeof(int) + pointer_size - 1) / pointer_size * pointer_size : 2 * sizeof(int);
+	layout.top      = layout.fastbins + nfastbins * pointer_size;
+	layout.bins     = layout.top + 2 * pointer_size;
+	layout.next     = layout.bins + (nbins * 2 - 2) * pointer_size + binmap_size * sizeof(int);
+	layout.size     = layout.next + 5 * pointer_size;
+	return layout;
+}
+
+//------------------------------------------------------------------------------
+// Name: find_layout
+// Desc: an empty bin's fd and bk both point at the bin itself, so the right
+//       layout is the one which finds the most of those. Every arena has some
+//------------------------------------------------------------------------------
+bool GlibcHeap::find_layout(IProcess *process, edb::address_t arena, Layout *layout) {
+
+	const Layout layouts[] = { GlibcHeap::layout(true), GlibcHeap::layout(false) };
+
+	QVector<edb::address_t> state(layouts[0].size / pointer_size);
+	process->read_bytes(arena, state.data(), state.size() * pointer_size);
+
+	int best_score = 0;
+	for(std::size_t i = 0; i < sizeof(layouts) / sizeof(layouts[0]); ++i) {
+
+		int score = 0;
+		for(std::size_t bin = 1; bin < nbins; ++bin) {
+			const std::size_t    fd   = layouts[i].bins + (bin - 1) * 2 * pointer_size;
+			const edb::address_t self = arena + fd - 2 * pointer_size;
+			if(state[fd / pointer_size] == self && state[fd / pointer_size + 1] == self) {
+				++score;
+			}
+		}
+
+		if(score > best_score) {
+			best_score = score;
+			*layout    = layouts[i];
+		}
+	}
+
+	return best_score != 0;
+}
+
+//------------------------------------------------------------------------------
+// Name: read_pointer
+// Desc:
+//------------------------------------------------------------------------------
+edb::address_t GlibcHeap::read_pointer(edb::address_t address) const {
+	edb::address_t value = 0;
+	process_->read_bytes(address, &value, sizeof(value));
+	return value;
+}
+
+//------------------------------------------------------------------------------
+// Name: in_heaps
+// Desc: there are only ever a few heaps, so they are just looked through
+//------------------------------------------------------------------------------
+bool GlibcHeap::in_heaps(edb::address_t address) const {
+	Q_FOREACH(const Heap &heap, heaps_) {
+		if(address >= heap.start && address < heap.end) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+//------------------------------------------------------------------------------
+// Name: add_arena_heaps
+// Desc: the heaps of an arena other than main_arena, from the one its top is
+//       in back to the first, which has the arena itself just past its
+//       heap_info. heap_info has grown over time, so its size is taken from
+//       where the arena is rather than assumed
+//------------------------------------------------------------------------------
+void GlibcHeap::add_arena_heaps(edb::address_t arena, const Layout &layout) {
+
+	const edb::address_t first       = arena & ~(heap_max_size - 1);
+	const std::size_t    header_size = arena - first;
+
+	if(header_size == 0 || header_size > 0x100) {
+		return;
+	}
+
+	edb::address_t heap = read_pointer(arena + layout.top) & ~(heap_max_size - 1);
+
+	for(int n = 0; heap != 0 && n < max_heaps; ++n) {
+
+		// ar_ptr, prev and size
+		edb::address_t info[3];
+		process_->read_bytes(heap, info, sizeof(info));
+
+		if(info[0] != arena) {
+			break;
+		}
+
+		Heap h;
+		h.start = (heap == first) ? align_chunk(arena + layout.size) : heap + header_size;
+		h.end   = heap + info[2];
+
+		if(h.end > h.start) {
+			heaps_.push_back(h);
+		}
+
+		if(heap == first) {
+			first_chunks_.push_back(h.start);
+			break;
+		}
+
+		heap = info[1];
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: follow_list
+// Desc: follows a singly linked free list. <node> is what the links point at
+//       and <link> where the next one is in it, <header> how far in front of
+//       it its chunk starts. True if the list ends properly, every chunk on it
+//       being an aligned one in a heap
+//------------------------------------------------------------------------------
+bool GlibcHeap::follow_list(edb::address_t node, std::size_t link, std::size_t header, bool mangled, QVector<edb::address_t> *chunks) const {
+
+	QSet<edb::address_t> seen;
+
+	for(int n = 0; n < max_list_length; ++n) {
+
+		if(node == 0) {
+			return true;
+		}
+
+		const edb::address_t chunk = node - header;
+		if(!in_heaps(chunk) || align_chunk(chunk) != chunk || free_.contains(chunk) || seen.contains(chunk)) {
+			return false;
+		}
+
+		seen.insert(chunk);
+		chunks->push_back(chunk);
+
+		const edb::address_t slot  = node + link;
+		const edb::address_t value = read_pointer(slot);
+		node = mangled ? (slot >> 12) ^ value : value;
+	}
+
+	return false;
+}
+
+//------------------------------------------------------------------------------
+// Name: add_list
+// Desc: since glibc 2.32 the links of the singly linked lists are mangled with
+//       the address they are stored at. Whichever way of reading a list gets
+//       properly to its end is believed, or failing that the furthest
+//------------------------------------------------------------------------------
+void GlibcHeap::add_list(edb::address_t node, std::size_t link, std::size_t header, FreeList list) {
+
+	QVector<edb::address_t> chunks;
+	if(!follow_list(node, link, header, false, &chunks)) {
+
+		QVector<edb::address_t> mangled;
+		if(follow_list(node, link, header, true, &mangled) || mangled.size() > chunks.size()) {
+			chunks = mangled;
+		}
+	}
+
+	Q_FOREACH(edb::address_t chunk, chunks) {
+		free_.insert(chunk, list);
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: add_bins
+// Desc: the fastbins, and the unsorted, small and large bins of an arena. The
+//       bins are doubly linked lists which end back at the bin itself
+//------------------------------------------------------------------------------
+void GlibcHeap::add_bins(edb::address_t arena, const Layout &layout) {
+
+	edb::address_t fastbins[nfastbins];
+	process_->read_bytes(arena + layout.fastbins, fastbins, sizeof(fastbins));
+
+	for(std::size_t i = 0; i < nfastbins; ++i) {
+		add_list(fastbins[i], 2 * pointer_size, 0, FREE_FASTBIN);
+	}
+
+	QVector<edb::address_t> bins(nbins * 2 - 2);
+	process_->read_bytes(arena + layout.bins, bins.data(), bins.size() * pointer_size);
+
+	for(std::size_t bin = 1; bin < nbins; ++bin) {
+
+		const edb::address_t self = arena + layout.bins + (bin - 1) * 2 * pointer_size - 2 * pointer_size;
+		const FreeList       list = (bin == 1) ? FREE_UNSORTED : (bin < nsmallbins) ? FREE_SMALLBIN : FREE_LARGEBIN;
+
+		edb::address_t chunk = bins[(bin - 1) * 2];
+		for(int n = 0; chunk != self && n < max_list_length; ++n) {
+			if(!in_heaps(chunk) || free_.contains(chunk)) {
+				break;
+			}
+
+			free_.insert(chunk, list);
+			chunk = read_pointer(chunk + 2 * pointer_size);
+		}
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: add_tcache
+// Desc: a thread's tcache is the first thing it allocates from its arena, so
+//       it is the first chunk of the arena's heap. It is recognized by its size,
+//       its counts were chars before glibc 2.30 and are 16 bits since
+//------------------------------------------------------------------------------
+void GlibcHeap::add_tcache(edb::address_t chunk) {
+
+	const std::size_t size         = read_pointer(chunk + pointer_size) & ~static_cast<edb::address_t>(7);
+	const std::size_t entries_size = tcache_max_bins * pointer_size;
+
+	std::size_t counts_size;
+	if(size == request2size(tcache_max_bins * sizeof(quint16) + entries_size)) {
+		counts_size = tcache_max_bins * sizeof(quint16);
+	} else if(size == request2size(tcache_max_bins + entries_size)) {
+		counts_size = tcache_max_bins;
+	} else {
+		return;
+	}
+
+	edb::address_t entries[tcache_max_bins];
+	process_->read_bytes(chunk + 2 * pointer_size + counts_size, entries, sizeof(entries));
+
+	// the entries point at the data of the chunks, which is where their next is
+	for(std::size_t i = 0; i < tcache_max_bins; ++i) {
+		add_list(entries[i], 0, 2 * pointer_size, FREE_TCACHE);
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: load
+// Desc: finds the heaps of every arena and the chunks on their free lists.
+//       <main_heap> is the brk heap, which main_arena doesn't record. False if
+//       <main_arena> doesn't look like a malloc_state
+//------------------------------------------------------------------------------
+bool GlibcHeap::load(IProcess *process, edb::address_t main_arena, const Heap &main_heap) {
+
+	process_ = process;
+	heaps_.clear();
+	first_chunks_.clear();
+	free_.clear();
+
+	Layout layout;
+	if(!find_layout(process, main_arena, &layout)) {
+		return false;
+	}
+
+	heaps_.push_back(main_heap);
+	first_chunks_.push_back(main_heap.start);
+
+	QVector<edb::address_t> arenas;
+	arenas.push_back(main_arena);
+
+	for(edb::address_t arena = read_pointer(main_arena + layout.next); arena != 0 && !arenas.contains(arena) && arenas.size() < max_arenas; arena = read_pointer(arena + layout.next)) {
+		arenas.push_back(arena);
+		add_arena_heaps(arena, layout);
+	}
+
+	std::sort(heaps_.begin(), heaps_.end(), heap_less);
+
+	// a free list is only followed while it stays in the heaps, so they all
+	// have to be known first
+	Q_FOREACH(edb::address_t arena, arenas) {
+		add_bins(arena, layout);
+	}
+
+	Q_FOREACH(edb::address_t chunk, first_chunks_) {
+		add_tcache(chunk);
+	}
+
+	return true;
+}
+
+//------------------------------------------------------------------------------
+// Name: find_free
+// Desc: if <chunk> is on a free list, which one
+//------------------------------------------------------------------------------
+bool GlibcHeap::find_free(edb::address_t chunk, FreeList *list) const {
+
+	const QHash<edb::address_t, FreeList>::const_iterator it = free_.find(chunk);
+	if(it == free_.end()) {
+		return false;
+	}
+
+	*list = it.value();
+	return true;
+}
+
+}
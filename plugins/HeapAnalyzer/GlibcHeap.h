@@ -0,0 +1,88 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef GLIBCHEAP_20261014_H_
+#define GLIBCHEAP_20261014_H_
+
+#include "Types.h"
+#include <QHash>
+#include <QVector>
+
+class IProcess;
+
+namespace HeapAnalyzer {
+
+// the chunks of one heap run from start up to end, where its top chunk ends
+struct Heap {
+	edb::address_t start;
+	edb::address_t end;
+};
+
+// what glibc's malloc itself knows about the heap: the arenas on the
+// main_arena.next list, the mmapped heaps of the ones other than main_arena,
+// and which chunks are on a tcache, fastbin or bin list. malloc_state has
+// changed shape between glibc versions, so both layouts are tried and the one
+// whose empty bins point back at themselves is believed
+class GlibcHeap {
+public:
+	enum FreeList {
+		FREE_TCACHE,
+		FREE_FASTBIN,
+		FREE_UNSORTED,
+		FREE_SMALLBIN,
+		FREE_LARGEBIN
+	};
+
+public:
+	GlibcHeap();
+
+public:
+	bool load(IProcess *process, edb::address_t main_arena, const Heap &main_heap);
+	const QVector<Heap> &heaps() const { return heaps_; }
+	bool find_free(edb::address_t chunk, FreeList *list) const;
+
+private:
+	struct Layout {
+		std::size_t fastbins;
+		std::size_t top;
+		std::size_t bins;
+		std::size_t next;
+		std::size_t size;
+	};
+
+private:
+	static Layout layout(bool have_fastchunks);
+	static bool find_layout(IProcess *process, edb::address_t arena, Layout *layout);
+	edb::address_t read_pointer(edb::address_t address) const;
+	bool in_heaps(edb::address_t address) const;
+	void add_arena_heaps(edb::address_t arena, const Layout &layout);
+	void add_bins(edb::address_t arena, const Layout &layout);
+	void add_tcache(edb::address_t chunk);
+	bool follow_list(edb::address_t node, std::size_t link, std::size_t header, bool mangled, QVector<edb::address_t> *chunks) const;
+	void add_list(edb::address_t node, std::size_t link, std::size_t header, FreeList list);
+
+private:
+	IProcess                        *process_;
+	QVector<Heap>                    heaps_;
+	QVector<edb::address_t>          first_chunks_;
+	QHash<edb::address_t, FreeList>  free_;
+};
+
+}
+
+#endif
@@ -19,10 +19,36 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "HeapAnalyzer.h"
 #include "edb.h"
 #include "DialogHeap.h"
+#include "IDebugger.h"
+#include <QDataStream>
+#include <QFile>
+#include <QFileDialog>
 #include <QMenu>
+#include <QMessageBox>
+#include <QTextStream>
+#include <algorithm>
 
 namespace HeapAnalyzer {
 
+namespace {
+
+// what is still allocated from one place
+struct CallerTotal {
+	edb::address_t caller;
+	int            count;
+	edb::address_t bytes;
+};
+
+//------------------------------------------------------------------------------
+// Name: bytes_greater
+// Desc:
+//------------------------------------------------------------------------------
+bool bytes_greater(const CallerTotal &lhs, const CallerTotal &rhs) {
+	return lhs.bytes > rhs.bytes;
+}
+
+}
+
 //------------------------------------------------------------------------------
 // Name: HeapAnalyzer
 // Desc:
@@ -49,6 +75,11 @@ QMenu *HeapAnalyzer::menu(QWidget *parent) {
 	if(!menu_) {
 		menu_ = new QMenu(tr("HeapAnalyzer"), parent);
 		menu_->addAction (tr("&Heap Analyzer"), this, SLOT(show_menu()), QKeySequence(tr("Ctrl+H")));
+		menu_->addSeparator();
+		menu_->addAction(tr("&Start Allocation Tracking"), this, SLOT(start_tracking()));
+		menu_->addAction(tr("S&top Allocation Tracking"), this, SLOT(stop_tracking()));
+		menu_->addAction(tr("Export Allocation &Log..."), this, SLOT(export_log()));
+		menu_->addAction(tr("Export Li&ve Allocations..."), this, SLOT(export_live()));
 	}
 
 	return menu_;
@@ -67,6 +98,128 @@ void HeapAnalyzer::show_menu() {
 	dialog_->show();
 }
 
+//------------------------------------------------------------------------------
+// Name: start_tracking
+// Desc:
+//------------------------------------------------------------------------------
+void HeapAnalyzer::start_tracking() {
+
+	if(!edb::v1::debugger_core->process()) {
+		return;
+	}
+
+	QString libcName;
+	QString ldName;
+	DialogHeap::get_library_names(&libcName, &ldName);
+
+	if(!tracker_.start(libcName)) {
+		QMessageBox::information(edb::v1::debugger_ui, tr("Allocation Tracking"), tr("Could not find malloc or free in libc, are its symbols loaded?"));
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: stop_tracking
+// Desc:
+//------------------------------------------------------------------------------
+void HeapAnalyzer::stop_tracking() {
+	tracker_.stop();
+}
+
+//------------------------------------------------------------------------------
+// Name: export_log
+// Desc: writes the calls in the log as they are. It starts with "EDBALLOC",
+//       a quint32 version (1), a quint32 pointer size and a quint64 count, then
+//       each call is { quint8 kind; quint64 pointer, old_pointer, size,
+//       caller; }. Everything is little endian
+//------------------------------------------------------------------------------
+void HeapAnalyzer::export_log() {
+
+	const QVector<AllocationTracker::Event> events = tracker_.events();
+	if(events.isEmpty()) {
+		QMessageBox::information(edb::v1::debugger_ui, tr("Allocation Tracking"), tr("No allocations have been tracked."));
+		return;
+	}
+
+	const QString filename = QFileDialog::getSaveFileName(edb::v1::debugger_ui, tr("Export Allocation Log"), QString(), tr("Allocation Logs (*.bin);;All Files (*)"));
+	if(filename.isEmpty()) {
+		return;
+	}
+
+	QFile file(filename);
+	if(!file.open(QIODevice::WriteOnly)) {
+		QMessageBox::information(edb::v1::debugger_ui, tr("Allocation Tracking"), tr("Unable to open allocation log file: %1").arg(filename));
+		return;
+	}
+
+	QDataStream out(&file);
+	out.setByteOrder(QDataStream::LittleEndian);
+	out.writeRawData("EDBALLOC", 8);
+	out << static_cast<quint32>(1) << static_cast<quint32>(sizeof(edb::address_t)) << static_cast<quint64>(events.size());
+
+	Q_FOREACH(const AllocationTracker::Event &event, events) {
+		out << event.kind
+		    << static_cast<quint64>(event.pointer)
+		    << static_cast<quint64>(event.old_pointer)
+		    << static_cast<quint64>(event.size)
+		    << static_cast<quint64>(event.caller);
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: export_live
+// Desc: what is allocated and not yet freed, totalled by where it was
+//       allocated to show the likely leaks first, then every block
+//------------------------------------------------------------------------------
+void HeapAnalyzer::export_live() {
+
+	const QHash<edb::address_t, AllocationTracker::Allocation> &live = tracker_.live();
+	if(tracker_.event_count() == 0) {
+		QMessageBox::information(edb::v1::debugger_ui, tr("Allocation Tracking"), tr("No allocations have been tracked."));
+		return;
+	}
+
+	const QString filename = QFileDialog::getSaveFileName(edb::v1::debugger_ui, tr("Export Live Allocations"), QString(), tr("Text Files (*.txt);;All Files (*)"));
+	if(filename.isEmpty()) {
+		return;
+	}
+
+	QFile file(filename);
+	if(!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+		QMessageBox::information(edb::v1::debugger_ui, tr("Allocation Tracking"), tr("Unable to open allocation report file: %1").arg(filename));
+		return;
+	}
+
+	QHash<edb::address_t, CallerTotal> totals;
+	edb::address_t bytes = 0;
+
+	for(QHash<edb::address_t, AllocationTracker::Allocation>::const_iterator it = live.begin(); it != live.end(); ++it) {
+		CallerTotal &total = totals[it.value().caller];
+		total.caller = it.value().caller;
+		total.count += 1;
+		total.bytes += it.value().size;
+		bytes       += it.value().size;
+	}
+
+	QVector<CallerTotal> callers;
+	Q_FOREACH(const CallerTotal &total, totals) {
+		callers.push_back(total);
+	}
+	std::sort(callers.begin(), callers.end(), bytes_greater);
+
+	QTextStream out(&file);
+	out << tr("%1 blocks of %2 bytes still allocated after %3 calls").arg(live.size()).arg(bytes).arg(tracker_.event_count()) << "\n\n";
+
+	Q_FOREACH(const CallerTotal &total, callers) {
+		out << QString("%1 bytes in %2 blocks from %3\n").arg(total.bytes).arg(total.count).arg(edb::v1::find_function_symbol(total.caller, edb::v1::format_pointer(total.caller)));
+	}
+
+	out << "\n";
+
+	for(QHash<edb::address_t, AllocationTracker::Allocation>::const_iterator it = live.begin(); it != live.end(); ++it) {
+		out << QString("%1 %2 bytes from %3\n").arg(edb::v1::format_pointer(it.key())).arg(it.value().size).arg(edb::v1::format_pointer(it.value().caller));
+	}
+}
+
 #if QT_VERSION < 0x050000
 Q_EXPORT_PLUGIN2(HeapAnalyzer, HeapAnalyzer)
 #endif
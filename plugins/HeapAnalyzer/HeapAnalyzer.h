@@ -20,6 +20,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #define HEAPANALYZER_20060430_H_
 
 #include "IPlugin.h"
+#include "AllocationTracker.h"
 
 class QMenu;
 class QDialog;
@@ -30,7 +31,7 @@ class HeapAnalyzer : public QObject, public IPlugin {
 	Q_OBJECT
 	Q_INTERFACES(IPlugin)
 #if QT_VERSION >= 0x050000
-	Q_PLUGIN_METADATA(IID "edb.IPlugin/1.0")
+	Q_PLUGIN_METADATA(IID "edb.IPlugin/1.0" FILE "HeapAnalyzer.json")
 #endif
 	Q_CLASSINFO("author", "Evan Teran")
 	Q_CLASSINFO("url", "http://www.codef00.com")
@@ -44,10 +45,15 @@ public:
 
 public Q_SLOTS:
 	void show_menu();
+	void start_tracking();
+	void stop_tracking();
+	void export_log();
+	void export_live();
 
 private:
-	QMenu *   menu_;
-	QDialog * dialog_;
+	QMenu *           menu_;
+	QDialog *         dialog_;
+	AllocationTracker tracker_;
 };
 
 }
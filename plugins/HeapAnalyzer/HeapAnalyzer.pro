@@ -1,14 +1,11 @@
 
 include(../plugins.pri)
 
-greaterThan(QT_MAJOR_VERSION, 4) {
-    QT += concurrent
-}
-
 # Input
-HEADERS += HeapAnalyzer.h DialogHeap.h ResultViewModel.h
+HEADERS += HeapAnalyzer.h AllocationTracker.h DialogHeap.h GlibcHeap.h ResultViewModel.h
 FORMS += DialogHeap.ui
-SOURCES += HeapAnalyzer.cpp DialogHeap.cpp ResultViewModel.cpp
+SOURCES += HeapAnalyzer.cpp AllocationTracker.cpp DialogHeap.cpp GlibcHeap.cpp ResultViewModel.cpp
+OTHER_FILES += HeapAnalyzer.json
 
 graph {
 	DEFINES += ENABLE_GRAPH
@@ -15,29 +15,85 @@ GNU General Public License for more details.
 You should have received a copy of the GNU General Public License
 along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
-
 #include "ResultViewModel.h"
 #include "edb.h"
-#include <QtAlgorithms>
+#include <QStringList>
+#include <algorithm>
 
 namespace HeapAnalyzer {
 
-namespace {
-	bool BlockGreater(const Result &s1, const Result &s2) { return s1.block > s2.block; }
-	bool BlockLess(const Result &s1, const Result &s2)    { return s1.block < s2.block; }
-	bool DataGreater(const Result &s1, const Result &s2)  { return s1.data > s2.data; }
-	bool DataLess(const Result &s1, const Result &s2)     { return s1.data < s2.data; }
-	bool SizeGreater(const Result &s1, const Result &s2)  { return s1.size > s2.size; }
-	bool SizeLess(const Result &s1, const Result &s2)     { return s1.size < s2.size; }
-	bool TypeGreater(const Result &s1, const Result &s2)  { return s1.type > s2.type; }
-	bool TypeLess(const Result &s1, const Result &s2)     { return s1.type < s2.type; }
-}
+// orders chunk indexes by one column, ties go by chunk index so that a sort
+// always comes out the same
+class ResultViewModel::Less {
+public:
+	Less(const ResultViewModel *model, int column) : model_(model), column_(column) {
+	}
+
+public:
+	bool operator()(int lhs, int rhs) const {
+		switch(column_) {
+		case 0:
+			return model_->blocks_[lhs] < model_->blocks_[rhs];
+		case 1:
+			if(model_->sizes_[lhs] != model_->sizes_[rhs]) {
+				return model_->sizes_[lhs] < model_->sizes_[rhs];
+			}
+			break;
+		case 2:
+			if(model_->types_[lhs] != model_->types_[rhs]) {
+				return model_->types_[lhs] < model_->types_[rhs];
+			}
+			break;
+		case 3:
+			if(const int n = compare_data(lhs, rhs)) {
+				return n < 0;
+			}
+			break;
+		}
+
+		return lhs < rhs;
+	}
+
+private:
+	// strings by their text and pointers by the first one, without making
+	// any of them into the text which is shown
+	int compare_data(int lhs, int rhs) const {
+
+		if(model_->data_types_[lhs] != model_->data_types_[rhs]) {
+			return model_->data_types_[lhs] - model_->data_types_[rhs];
+		}
+
+		switch(model_->data_types_[lhs]) {
+		case DATA_ASCII:
+		case DATA_UTF16:
+			return QStringRef::compare(text(lhs), text(rhs));
+		case DATA_POINTERS:
+			{
+				const edb::address_t l = model_->reference_values_[model_->referencesBegin(lhs)];
+				const edb::address_t r = model_->reference_values_[model_->referencesBegin(rhs)];
+				return (l < r) ? -1 : (l > r) ? 1 : 0;
+			}
+		default:
+			return 0;
+		}
+	}
+
+	QStringRef text(int chunk) const {
+		const int offset = model_->text_offsets_[chunk];
+		return QStringRef(&model_->text_pool_, offset, model_->text_offsets_[chunk + 1] - offset);
+	}
+
+private:
+	const ResultViewModel *const model_;
+	const int                    column_;
+};
 
 //------------------------------------------------------------------------------
 // Name: ResultViewModel
 // Desc:
 //------------------------------------------------------------------------------
 ResultViewModel::ResultViewModel(QObject *parent) : QAbstractItemModel(parent), updates_enabled_(false) {
+	text_offsets_.push_back(0);
 }
 
 //------------------------------------------------------------------------------
@@ -58,6 +114,59 @@ QVariant ResultViewModel::headerData(int section, Qt::Orientation orientation, i
 	return QVariant();
 }
 
+//------------------------------------------------------------------------------
+// Name: typeName
+// Desc:
+//------------------------------------------------------------------------------
+QString ResultViewModel::typeName(ChunkType type) {
+	switch(type) {
+	case CHUNK_BUSY:     return tr("Busy");
+	case CHUNK_FREE:     return tr("Free");
+	case CHUNK_TOP:      return tr("Top");
+	case CHUNK_TCACHE:   return tr("Free (tcache)");
+	case CHUNK_FASTBIN:  return tr("Free (fastbin)");
+	case CHUNK_UNSORTED: return tr("Free (unsorted)");
+	case CHUNK_SMALLBIN: return tr("Free (small bin)");
+	case CHUNK_LARGEBIN: return tr("Free (large bin)");
+	}
+
+	return QString();
+}
+
+//------------------------------------------------------------------------------
+// Name: dataText
+// Desc: what the data column shows for a chunk, made when it is shown
+//------------------------------------------------------------------------------
+QString ResultViewModel::dataText(int chunk) const {
+
+	const int offset = text_offsets_[chunk];
+	const int length = text_offsets_[chunk + 1] - offset;
+
+	switch(data_types_[chunk]) {
+	case DATA_ASCII:    return QString("ASCII \"%1\"").arg(text_pool_.mid(offset, length));
+	case DATA_UTF16:    return QString("UTF-16 \"%1\"").arg(text_pool_.mid(offset, length));
+	case DATA_PNG:      return "PNG IMAGE";
+	case DATA_XPM:      return "XPM IMAGE";
+	case DATA_BZIP:     return "BZIP FILE";
+	case DATA_COMPRESS: return "COMPRESS FILE";
+	case DATA_GZIP:     return "GZIP FILE";
+	case DATA_POINTERS:
+		{
+			QStringList pointers;
+			for(int i = referencesBegin(chunk); i != referencesEnd(chunk); ++i) {
+			#if QT_POINTER_SIZE == 4
+				pointers.push_back(QString("dword ptr [%1]").arg(edb::v1::format_pointer(reference_values_[i])));
+			#elif QT_POINTER_SIZE == 8
+				pointers.push_back(QString("qword ptr [%1]").arg(edb::v1::format_pointer(reference_values_[i])));
+			#endif
+			}
+			return pointers.join(" |");
+		}
+	default:
+		return QString();
+	}
+}
+
 //------------------------------------------------------------------------------
 // Name: data
 // Desc:
@@ -70,23 +179,73 @@ QVariant ResultViewModel::data(const QModelIndex &index, int role) const {
 	if(role != Qt::DisplayRole)
 		return QVariant();
 
-	const Result &result = results_[index.row()];
+	const int chunk = order_[index.row()];
 
 	switch(index.column()) {
-	case 0:  return edb::v1::format_pointer(result.block);
-	case 1:  return edb::v1::format_pointer(result.size);
-	case 2:  return result.type;
-	case 3:  return result.data;
+	case 0:  return edb::v1::format_pointer(blocks_[chunk]);
+	case 1:  return edb::v1::format_pointer(sizes_[chunk]);
+	case 2:  return typeName(type(chunk));
+	case 3:  return dataText(chunk);
 	default: return QVariant();
 	}
 }
 
 //------------------------------------------------------------------------------
-// Name: addResult
-// Desc:
+// Name: addChunk
+// Desc: <text> is the string for DATA_ASCII and DATA_UTF16. Nothing is
+//       updated until update is called
+//------------------------------------------------------------------------------
+void ResultViewModel::addChunk(edb::address_t block, edb::address_t size, ChunkType type, DataType data, const QString &text) {
+
+	order_.push_back(blocks_.size());
+	blocks_.push_back(block);
+	sizes_.push_back(size);
+	types_.push_back(type);
+	data_types_.push_back(data);
+
+	text_pool_ += text;
+	text_offsets_.push_back(text_pool_.size());
+}
+
 //------------------------------------------------------------------------------
-void ResultViewModel::addResult(const Result &r) {
-	results_.push_back(r);
+// Name: setReferences
+// Desc: gives the chunks with nothing else in their data column the pointers
+//       in them, <references> is in address order
+//------------------------------------------------------------------------------
+void ResultViewModel::setReferences(const QVector<Reference> &references) {
+
+	const int count = blocks_.size();
+
+	// a count of each chunk's references, then where each one's start
+	reference_offsets_.fill(0, count + 1);
+	Q_FOREACH(const Reference &reference, references) {
+		if(data_types_[reference.from] == DATA_NONE) {
+			++reference_offsets_[reference.from + 1];
+		}
+	}
+
+	for(int i = 0; i < count; ++i) {
+		reference_offsets_[i + 1] += reference_offsets_[i];
+	}
+
+	reference_values_.resize(reference_offsets_[count]);
+	reference_targets_.resize(reference_offsets_[count]);
+
+	QVector<int> next = reference_offsets_;
+	Q_FOREACH(const Reference &reference, references) {
+		if(data_types_[reference.from] == DATA_NONE) {
+			const int n = next[reference.from]++;
+			reference_values_[n]  = reference.value;
+			reference_targets_[n] = reference.to;
+		}
+	}
+
+	for(int i = 0; i < count; ++i) {
+		if(reference_offsets_[i + 1] != reference_offsets_[i]) {
+			data_types_[i] = DATA_POINTERS;
+		}
+	}
+
 	update();
 }
 
@@ -95,7 +254,17 @@ void ResultViewModel::addResult(const Result &r) {
 // Desc:
 //------------------------------------------------------------------------------
 void ResultViewModel::clearResults() {
-	results_.clear();
+	blocks_.clear();
+	sizes_.clear();
+	types_.clear();
+	data_types_.clear();
+	text_offsets_.clear();
+	text_offsets_.push_back(0);
+	text_pool_.clear();
+	reference_offsets_.clear();
+	reference_values_.clear();
+	reference_targets_.clear();
+	order_.clear();
 	update();
 }
 
@@ -118,7 +287,7 @@ QModelIndex ResultViewModel::index(int row, int column, const QModelIndex &paren
 
 	Q_UNUSED(parent);
 
-	if(row >= results_.size()) {
+	if(row >= order_.size()) {
 		return QModelIndex();
 	}
 
@@ -126,11 +295,35 @@ QModelIndex ResultViewModel::index(int row, int column, const QModelIndex &paren
 		return QModelIndex();
 	}
 
-	if(row >= 0) {
-		return createIndex(row, column, const_cast<Result *>(&results_[row]));
-	} else {
-		return createIndex(row, column);
+	return createIndex(row, column);
+}
+
+//------------------------------------------------------------------------------
+// Name: chunkAt
+// Desc: the chunk shown at <index>, or -1
+//------------------------------------------------------------------------------
+int ResultViewModel::chunkAt(const QModelIndex &index) const {
+	if(!index.isValid() || index.row() < 0 || index.row() >= order_.size()) {
+		return -1;
 	}
+
+	return order_[index.row()];
+}
+
+//------------------------------------------------------------------------------
+// Name: referencesBegin
+// Desc: the references from <chunk> are [referencesBegin, referencesEnd)
+//------------------------------------------------------------------------------
+int ResultViewModel::referencesBegin(int chunk) const {
+	return reference_offsets_.isEmpty() ? 0 : reference_offsets_[chunk];
+}
+
+//------------------------------------------------------------------------------
+// Name: referencesEnd
+// Desc:
+//------------------------------------------------------------------------------
+int ResultViewModel::referencesEnd(int chunk) const {
+	return reference_offsets_.isEmpty() ? 0 : reference_offsets_[chunk + 1];
 }
 
 //------------------------------------------------------------------------------
@@ -148,7 +341,7 @@ QModelIndex ResultViewModel::parent(const QModelIndex &index) const {
 //------------------------------------------------------------------------------
 int ResultViewModel::rowCount(const QModelIndex &parent) const {
 	Q_UNUSED(parent);
-	return results_.size();
+	return order_.size();
 }
 
 //------------------------------------------------------------------------------
@@ -162,27 +355,22 @@ int ResultViewModel::columnCount(const QModelIndex &parent) const {
 
 //------------------------------------------------------------------------------
 // Name: sort
-// Desc:
+// Desc: only the permutation of the rows is sorted
 //------------------------------------------------------------------------------
 void ResultViewModel::sort(int column, Qt::SortOrder order) {
 
-	if(order == Qt::AscendingOrder) {
-		switch(column) {
-		case 0: qSort(results_.begin(), results_.end(), BlockLess); break;
-		case 1: qSort(results_.begin(), results_.end(), SizeLess);  break;
-		case 2: qSort(results_.begin(), results_.end(), TypeLess);  break;
-		case 3: qSort(results_.begin(), results_.end(), DataLess);  break;
-		}
-	} else {
-		switch(column) {
-		case 0: qSort(results_.begin(), results_.end(), BlockGreater); break;
-		case 1: qSort(results_.begin(), results_.end(), SizeGreater);  break;
-		case 2: qSort(results_.begin(), results_.end(), TypeGreater);  break;
-		case 3: qSort(results_.begin(), results_.end(), DataGreater);  break;
-		}
+	if(column < 0 || column >= 4) {
+		return;
+	}
+
+	emit layoutAboutToBeChanged();
+
+	std::sort(order_.begin(), order_.end(), Less(this, column));
+	if(order == Qt::DescendingOrder) {
+		std::reverse(order_.begin(), order_.end());
 	}
 
-	emit dataChanged(createIndex(0, 0, static_cast<void *>(0)), createIndex(-1, -1, static_cast<void *>(0)));
+	emit layoutChanged();
 }
 
 //------------------------------------------------------------------------------
@@ -15,32 +15,54 @@ GNU General Public License for more details.
 You should have received a copy of the GNU General Public License
 along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
-
 #ifndef RESULTVIEWMODEL_20070419_H_
 #define RESULTVIEWMODEL_20070419_H_
 
 #include <QAbstractItemModel>
+#include <QString>
 #include <QVector>
 #include "Types.h"
 
 namespace HeapAnalyzer {
 
-struct Result {
-	Result() : block(0), size(0) {
-	}
-
-	Result(edb::address_t block, edb::address_t size, const QString &type, const QString &data = QString()) : block(block), size(size), type(type), data(data) {
-	}
-
-	edb::address_t        block;
-	edb::address_t        size;
-	QString               type;
-	QString               data;
-	QList<edb::address_t> points_to;
+// a slot in one chunk's data which points to a slot in another's
+struct Reference {
+	edb::address_t value; // the slot pointed to
+	int            from;  // chunk indexes
+	int            to;
 };
 
+// the chunks are kept a column at a time rather than as an object each, and
+// the data column is only made into text when it is shown, so a heap of
+// millions of chunks costs little more than its addresses. Sorting reorders a
+// permutation of the rows, the chunks themselves stay in the order they were
+// added in and are what the chunk indexes refer to
 class ResultViewModel : public QAbstractItemModel {
 	Q_OBJECT
+public:
+	enum ChunkType {
+		CHUNK_BUSY,
+		CHUNK_FREE,
+		CHUNK_TOP,
+		CHUNK_TCACHE,
+		CHUNK_FASTBIN,
+		CHUNK_UNSORTED,
+		CHUNK_SMALLBIN,
+		CHUNK_LARGEBIN
+	};
+
+	enum DataType {
+		DATA_NONE,
+		DATA_ASCII,
+		DATA_UTF16,
+		DATA_PNG,
+		DATA_XPM,
+		DATA_BZIP,
+		DATA_COMPRESS,
+		DATA_GZIP,
+		DATA_POINTERS
+	};
+
 public:
 	ResultViewModel(QObject *parent = 0);
 
@@ -54,18 +76,50 @@ public:
 	virtual void sort (int column, Qt::SortOrder order = Qt::AscendingOrder);
 
 public:
-	void addResult(const Result &r);
+	void addChunk(edb::address_t block, edb::address_t size, ChunkType type, DataType data = DATA_NONE, const QString &text = QString());
+	void setReferences(const QVector<Reference> &references);
 	void clearResults();
 	void update();
 	void setUpdatesEnabled(bool value);
 	bool updatesEnabled() const;
 
 public:
-	QVector<Result> &results() { return results_; }
+	int chunkCount() const                  { return blocks_.size(); }
+	int chunkAt(const QModelIndex &index) const;
+	edb::address_t block(int chunk) const   { return blocks_[chunk]; }
+	edb::address_t size(int chunk) const    { return sizes_[chunk]; }
+	ChunkType type(int chunk) const         { return static_cast<ChunkType>(types_[chunk]); }
+	DataType dataType(int chunk) const      { return static_cast<DataType>(data_types_[chunk]); }
+	int referencesBegin(int chunk) const;
+	int referencesEnd(int chunk) const;
+	int referenceTarget(int reference) const { return reference_targets_[reference]; }
+
+public:
+	static QString typeName(ChunkType type);
+
+private:
+	class Less;
+	QString dataText(int chunk) const;
 
 private:
-	QVector<Result> results_;
-	bool            updates_enabled_;
+	QVector<edb::address_t> blocks_;
+	QVector<edb::address_t> sizes_;
+	QVector<quint8>         types_;
+	QVector<quint8>         data_types_;
+
+	// the text of each chunk is [text_offsets_[i], text_offsets_[i + 1]) in
+	// the pool
+	QVector<int>            text_offsets_;
+	QString                 text_pool_;
+
+	// the same for the references from each chunk, empty until there are some
+	QVector<int>            reference_offsets_;
+	QVector<edb::address_t> reference_values_;
+	QVector<int>            reference_targets_;
+
+	// the chunk shown in each row
+	QVector<int>            order_;
+	bool                    updates_enabled_;
 };
 
 }
@@ -17,13 +17,17 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
 #include "DialogOpcodes.h"
-#include "ByteShiftArray.h"
+#include "Configuration.h"
 #include "IDebugger.h"
+#include "InstructionTemplate.h"
 #include "MemoryRegions.h"
-#include "ShiftBuffer.h"
-#include "Util.h"
+#include "OpcodeIndex.h"
+#include "OpcodeScan.h"
+#include "RegionScanner.h"
+#include "TemplateScan.h"
 #include "edb.h"
 
+#include <QHash>
 #include <QHeaderView>
 #include <QMessageBox>
 #include <QSortFilterProxyModel>
@@ -34,14 +38,6 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 namespace OpcodeSearcher {
 
-namespace {
-#if defined(EDB_X86)
-const edb::Operand::Register STACK_REG = edb::Operand::REG_ESP;
-#elif defined(EDB_X86_64)
-const edb::Operand::Register STACK_REG = edb::Operand::REG_RSP;
-#endif
-}
-
 //------------------------------------------------------------------------------
 // Name: DialogOpcodes
 // Desc:
@@ -153,640 +149,111 @@ void DialogOpcodes::showEvent(QShowEvent *) {
 	ui->listWidget->clear();
 }
 
-//------------------------------------------------------------------------------
-// Name: add_result
-// Desc:
-//------------------------------------------------------------------------------
-void DialogOpcodes::add_result(QList<edb::Instruction> instructions, edb::address_t rva) {
-	if(!instructions.isEmpty()) {
-		const edb::Instruction inst1 = instructions.takeFirst();
-
-		QString instruction_string = QString("%1: %2").arg(
-			edb::v1::format_pointer(rva),
-			QString::fromStdString(to_string(inst1)));
-
-
-		Q_FOREACH(const edb::Instruction &instruction, instructions) {
-			instruction_string.append(QString("; %1").arg(QString::fromStdString(to_string(instruction))));
-		}
-
-		QListWidgetItem *const item = new QListWidgetItem(instruction_string);
-
-		item->setData(Qt::UserRole, rva);
-		ui->listWidget->addItem(item);
-	}
-}
 
 //------------------------------------------------------------------------------
-// Name: test_deref_reg_to_ip
+// Name: do_find
 // Desc:
 //------------------------------------------------------------------------------
-template <edb::Operand::Register REG>
-void DialogOpcodes::test_deref_reg_to_ip(const OpcodeData &data, edb::address_t start_address) {
-	const quint8 *p = data.data;
-	const quint8 *last = p + sizeof(data);
-
-	edb::Instruction inst(p, last, 0, std::nothrow);
-
-	if(inst) {
-		const edb::Operand &op1 = inst.operands()[0];
-		switch(inst.type()) {
-		case edb::Instruction::OP_JMP:
-		case edb::Instruction::OP_CALL:
-			if(op1.general_type() == edb::Operand::TYPE_EXPRESSION) {
-
-				if(op1.expression().displacement_type == edb::Operand::DISP_NONE) {
-
-					if(op1.expression().base == REG && op1.expression().index == edb::Operand::REG_NULL && op1.expression().scale == 1) {
-						add_result((QList<edb::Instruction>() << inst), start_address);
-						return;
-					}
-
-					if(op1.expression().index == REG && op1.expression().base == edb::Operand::REG_NULL && op1.expression().scale == 1) {
-						add_result((QList<edb::Instruction>() << inst), start_address);
-						return;
-					}
-				}
-			}
-			break;
-		default:
-			break;
-		}
-	}
-}
+void DialogOpcodes::do_find() {
 
-//------------------------------------------------------------------------------
-// Name: test_reg_to_ip
-// Desc:
-//------------------------------------------------------------------------------
-template <edb::Operand::Register REG>
-void DialogOpcodes::test_reg_to_ip(const DialogOpcodes::OpcodeData &data, edb::address_t start_address) {
-
-	const quint8 *p = data.data;
-	const quint8 *last = p + sizeof(data);
-
-	edb::Instruction inst(p, last, 0, std::nothrow);
-
-	if(inst) {
-		const edb::Operand &op1 = inst.operands()[0];
-		switch(inst.type()) {
-		case edb::Instruction::OP_JMP:
-		case edb::Instruction::OP_CALL:
-			if(op1.general_type() == edb::Operand::TYPE_REGISTER) {
-				if(op1.reg() == REG) {
-					add_result((QList<edb::Instruction>() << inst), start_address);
-					return;
-				}
-			}
-			break;
-
-		case edb::Instruction::OP_PUSH:
-			if(op1.general_type() == edb::Operand::TYPE_REGISTER) {
-				if(op1.reg() == REG) {
-
-					p += inst.size();
-					edb::Instruction inst2(p, last, 0, std::nothrow);
-					if(inst2) {
-						const edb::Operand &op2 = inst2.operands()[0];
-						switch(inst2.type()) {
-						case edb::Instruction::OP_RET:
-							add_result((QList<edb::Instruction>() << inst << inst2), start_address);
-							break;
-						case edb::Instruction::OP_JMP:
-						case edb::Instruction::OP_CALL:
-
-							if(op2.general_type() == edb::Operand::TYPE_EXPRESSION) {
-
-								if(op2.expression().displacement_type == edb::Operand::DISP_NONE) {
-
-									if(op2.expression().base == STACK_REG && op2.expression().index == edb::Operand::REG_NULL) {
-										add_result((QList<edb::Instruction>() << inst << inst2), start_address);
-										return;
-									}
-
-									if(op2.expression().index == STACK_REG && op2.expression().base == edb::Operand::REG_NULL) {
-										add_result((QList<edb::Instruction>() << inst << inst2), start_address);
-										return;
-									}
-								}
-							}
-							break;
-						default:
-							break;
-						}
-					}
-				}
-			}
-			break;
-		default:
-			break;
-		}
-	}
-}
+	const int classtype = ui->comboBox->itemData(ui->comboBox->currentIndex()).toInt();
 
-//------------------------------------------------------------------------------
-// Name: test_esp_add_0
-// Desc:
-//------------------------------------------------------------------------------
-void DialogOpcodes::test_esp_add_0(const OpcodeData &data, edb::address_t start_address) {
+	const QItemSelectionModel *const selModel = ui->tableView->selectionModel();
+	const QModelIndexList sel = selModel->selectedRows();
 
-	const quint8 *p = data.data;
-	const quint8 *last = p + sizeof(data);
+	if(sel.size() == 0) {
+		QMessageBox::information(
+			this,
+			tr("No Region Selected"),
+			tr("You must select a region which is to be scanned for the desired opcode."));
+	} else if(ui->radioTemplate->isChecked()) {
+		find_template(sel);
+	} else {
 
-	edb::Instruction inst(p, last, 0, std::nothrow);
+		const bool code_only = edb::v1::config().scan_code_sections_only;
 
-	if(inst) {
-		const edb::Operand &op1 = inst.operands()[0];
-		switch(inst.type()) {
-		case edb::Instruction::OP_RET:
-			add_result((QList<edb::Instruction>() << inst), start_address);
-			break;
+		QHash<QString, QByteArray>  md5s;
+		QList<IRegion::pointer>     regions;
+		QVector<OpcodeScan::Result> results;
 
-		case edb::Instruction::OP_CALL:
-		case edb::Instruction::OP_JMP:
-			if(op1.general_type() == edb::Operand::TYPE_EXPRESSION) {
+		Q_FOREACH(const QModelIndex &selected_item, sel) {
 
-				if(op1.expression().displacement_type == edb::Operand::DISP_NONE) {
+			const QModelIndex index = filter_model_->mapToSource(selected_item);
 
-					if(op1.expression().base == STACK_REG && op1.expression().index == edb::Operand::REG_NULL) {
-						add_result((QList<edb::Instruction>() << inst), start_address);
-						return;
-					}
+			if(const IRegion::pointer region = *reinterpret_cast<const IRegion::pointer *>(index.internalPointer())) {
 
-					if(op1.expression().index == STACK_REG && op1.expression().base == edb::Operand::REG_NULL) {
-						add_result((QList<edb::Instruction>() << inst), start_address);
-						return;
-					}
+				const QString path = region->name();
+				if(!md5s.contains(path)) {
+					md5s.insert(path, path.startsWith('/') ? edb::v1::get_file_md5(path) : QByteArray());
 				}
-			}
-			break;
-		case edb::Instruction::OP_POP:
-			if(op1.general_type() == edb::Operand::TYPE_REGISTER) {
-
-				p += inst.size();
-				edb::Instruction inst2(p, last, 0, std::nothrow);
-				if(inst2) {
-					const edb::Operand &op2 = inst2.operands()[0];
-					switch(inst2.type()) {
-					case edb::Instruction::OP_JMP:
-					case edb::Instruction::OP_CALL:
-
-						if(op2.general_type() == edb::Operand::TYPE_REGISTER) {
-
-							if(op1.reg() == op2.reg()) {
-								add_result((QList<edb::Instruction>() << inst << inst2), start_address);
-							}
-						}
-						break;
-					default:
-						break;
-					}
-				}
-			}
-			break;
-
-		default:
-			break;
-		}
-	}
-}
 
-//------------------------------------------------------------------------------
-// Name: test_esp_add_regx1
-// Desc:
-//------------------------------------------------------------------------------
-void DialogOpcodes::test_esp_add_regx1(const OpcodeData &data, edb::address_t start_address) {
-
-	const quint8 *p = data.data;
-	const quint8 *last = p + sizeof(data);
-
-	edb::Instruction inst(p, last, 0, std::nothrow);
-
-	if(inst) {
-		const edb::Operand &op1 = inst.operands()[0];
-		switch(inst.type()) {
-		case edb::Instruction::OP_POP:
-
-			if(op1.general_type() != edb::Operand::TYPE_REGISTER || op1.reg() != STACK_REG) {
-				p += inst.size();
-				edb::Instruction inst2(p, last, 0, std::nothrow);
-				if(inst2) {
-					if(is_ret(inst2)) {
-						add_result((QList<edb::Instruction>() << inst << inst2), start_address);
-					}
+				// a region of a file is searched for every class the first
+				// time, after that the results are looked up
+				OpcodeIndex opcode_index(region, md5s[path], code_only);
+				if(!opcode_index.valid()) {
+					regions += edb::v1::code_regions(region);
+					continue;
 				}
-			}
-			break;
-		case edb::Instruction::OP_JMP:
-		case edb::Instruction::OP_CALL:
-
-			if(op1.general_type() == edb::Operand::TYPE_EXPRESSION) {
 
-				if(op1.displacement() == 4) {
-					if(op1.expression().base == STACK_REG && op1.expression().index == edb::Operand::REG_NULL) {
-						add_result((QList<edb::Instruction>() << inst), start_address);
-					} else if(op1.expression().base == edb::Operand::REG_NULL && op1.expression().index == STACK_REG && op1.expression().scale == 1) {
-						add_result((QList<edb::Instruction>() << inst), start_address);
-					}
-
-				}
-			}
-			break;
-		case edb::Instruction::OP_SUB:
-			if(op1.general_type() == edb::Operand::TYPE_REGISTER && op1.reg() == STACK_REG) {
-
-				const edb::Operand &op2 = inst.operands()[1];
-				if(op2.general_type() == edb::Operand::TYPE_IMMEDIATE) {
-
-					if(op2.immediate() == -static_cast<int>(sizeof(edb::reg_t))) {
-						p += inst.size();
-						edb::Instruction inst2(p, last, 0, std::nothrow);
-						if(inst2) {
-							if(is_ret(inst2)) {
-								add_result((QList<edb::Instruction>() << inst << inst2), start_address);
-							}
-						}
-					}
-				}
-			}
-			break;
-
-		case edb::Instruction::OP_ADD:
-			if(op1.general_type() == edb::Operand::TYPE_REGISTER && op1.reg() == STACK_REG) {
-
-				const edb::Operand &op2 = inst.operands()[1];
-				if(op2.general_type() == edb::Operand::TYPE_IMMEDIATE) {
-
-					if(op2.immediate() == sizeof(edb::reg_t)) {
-						p += inst.size();
-						edb::Instruction inst2(p, last, 0, std::nothrow);
-						if(inst2) {
-							if(is_ret(inst2)) {
-								add_result((QList<edb::Instruction>() << inst << inst2), start_address);
-							}
-						}
-					}
+				if(!opcode_index.load()) {
+					OpcodeScan scan(OpcodeScan::ALL_CLASSES, ui->progressBar);
+					scan.run(edb::v1::code_regions(region));
+					opcode_index.set_results(scan.results);
+					opcode_index.save();
 				}
-			}
-			break;
-
-		default:
-			break;
-		}
-	}
-}
 
-//------------------------------------------------------------------------------
-// Name: test_esp_add_regx2
-// Desc:
-//------------------------------------------------------------------------------
-void DialogOpcodes::test_esp_add_regx2(const OpcodeData &data, edb::address_t start_address) {
-
-	const quint8 *p = data.data;
-	const quint8 *last = p + sizeof(data);
-
-	edb::Instruction inst(p, last, 0, std::nothrow);
-
-	if(inst) {
-		const edb::Operand &op1 = inst.operands()[0];
-		switch(inst.type()) {
-		case edb::Instruction::OP_POP:
-
-			if(op1.general_type() != edb::Operand::TYPE_REGISTER || op1.reg() != STACK_REG) {
-				p += inst.size();
-				edb::Instruction inst2(p, last, 0, std::nothrow);
-				if(inst2) {
-					const edb::Operand &op2 = inst2.operands()[0];
-					switch(inst2.type()) {
-					case edb::Instruction::OP_POP:
-
-						if(op2.general_type() != edb::Operand::TYPE_REGISTER || op2.reg() != STACK_REG) {
-							p += inst2.size();
-							edb::Instruction inst3(p, last, 0, std::nothrow);
-							if(inst3) {
-								if(is_ret(inst3)) {
-									add_result((QList<edb::Instruction>() << inst << inst2 << inst3), start_address);
-								}
-							}
-						}
-						break;
-					default:
-						break;
-					}
-				}
+				results += opcode_index.results(classtype);
 			}
-			break;
-
-		case edb::Instruction::OP_JMP:
-		case edb::Instruction::OP_CALL:
-			if(op1.general_type() == edb::Operand::TYPE_EXPRESSION) {
-
-				if(op1.displacement() == (sizeof(edb::reg_t) * 2)) {
-					if(op1.expression().base == STACK_REG && op1.expression().index == edb::Operand::REG_NULL) {
-						add_result((QList<edb::Instruction>() << inst), start_address);
-					} else if(op1.expression().base == edb::Operand::REG_NULL && op1.expression().index == STACK_REG && op1.expression().scale == 1) {
-						add_result((QList<edb::Instruction>() << inst), start_address);
-					}
+		}
 
-				}
-			}
-			break;
-
-		case edb::Instruction::OP_SUB:
-			if(op1.general_type() == edb::Operand::TYPE_REGISTER && op1.reg() == STACK_REG) {
-
-				const edb::Operand &op2 = inst.operands()[1];
-				if(op2.general_type() == edb::Operand::TYPE_IMMEDIATE) {
-
-					if(op2.immediate() == -static_cast<int>(sizeof(edb::reg_t) * 2)) {
-						p += inst.size();
-						edb::Instruction inst2(p, last, 0, std::nothrow);
-						if(inst2) {
-							if(is_ret(inst2)) {
-								add_result((QList<edb::Instruction>() << inst << inst2), start_address);
-							}
-						}
-					}
-				}
-			}
-			break;
-
-		case edb::Instruction::OP_ADD:
-			if(op1.general_type() == edb::Operand::TYPE_REGISTER && op1.reg() == STACK_REG) {
-
-				const edb::Operand &op2 = inst.operands()[1];
-				if(op2.general_type() == edb::Operand::TYPE_IMMEDIATE) {
-
-					if(op2.immediate() == (sizeof(edb::reg_t) * 2)) {
-						p += inst.size();
-						edb::Instruction inst2(p, last, 0, std::nothrow);
-						if(inst2) {
-							if(is_ret(inst2)) {
-								add_result((QList<edb::Instruction>() << inst << inst2), start_address);
-							}
-						}
-					}
-				}
-			}
-			break;
+		OpcodeScan scan(classtype, ui->progressBar);
+		scan.run(regions);
+		results += scan.results;
 
-		default:
-			break;
-		}
+		add_results(results);
 	}
 }
 
 //------------------------------------------------------------------------------
-// Name: test_esp_sub_regx1
-// Desc:
+// Name: find_template
+// Desc: searches the selected regions for the instruction template, by their
+//       basic blocks where the analyzer knows them
 //------------------------------------------------------------------------------
-void DialogOpcodes::test_esp_sub_regx1(const OpcodeData &data, edb::address_t start_address) {
-
-	const quint8 *p = data.data;
-	const quint8 *last = p + sizeof(data);
+void DialogOpcodes::find_template(const QModelIndexList &sel) {
 
-	edb::Instruction inst(p, last, 0, std::nothrow);
+	InstructionTemplate pattern;
+	QString error;
+	if(!pattern.parse(ui->txtTemplate->text(), &error)) {
+		QMessageBox::information(this, tr("Invalid Template"), error);
+		return;
+	}
 
-	if(inst) {
-		const edb::Operand &op1 = inst.operands()[0];
-		switch(inst.type()) {
-		case edb::Instruction::OP_JMP:
-		case edb::Instruction::OP_CALL:
-			if(op1.general_type() == edb::Operand::TYPE_EXPRESSION) {
+	TemplateScan scan(pattern, ui->progressBar);
+	QList<IRegion::pointer> regions;
 
-				if(op1.displacement() == -static_cast<int>(sizeof(edb::reg_t))) {
-					if(op1.expression().base == STACK_REG && op1.expression().index == edb::Operand::REG_NULL) {
-						add_result((QList<edb::Instruction>() << inst), start_address);
-					} else if(op1.expression().base == edb::Operand::REG_NULL && op1.expression().index == STACK_REG && op1.expression().scale == 1) {
-						add_result((QList<edb::Instruction>() << inst), start_address);
-					}
+	Q_FOREACH(const QModelIndex &selected_item, sel) {
 
-				}
-			}
-			break;
-
-		case edb::Instruction::OP_SUB:
-			if(op1.general_type() == edb::Operand::TYPE_REGISTER && op1.reg() == STACK_REG) {
-
-				const edb::Operand &op2 = inst.operands()[1];
-				if(op2.general_type() == edb::Operand::TYPE_IMMEDIATE) {
-
-					if(op2.immediate() == static_cast<int>(sizeof(edb::reg_t))) {
-						p += inst.size();
-						edb::Instruction inst2(p, last, 0, std::nothrow);
-						if(inst2) {
-							if(is_ret(inst2)) {
-								add_result((QList<edb::Instruction>() << inst << inst2), start_address);
-							}
-						}
-					}
-				}
-			}
-			break;
-
-		case edb::Instruction::OP_ADD:
-			if(op1.general_type() == edb::Operand::TYPE_REGISTER && op1.reg() == STACK_REG) {
-
-				const edb::Operand &op2 = inst.operands()[1];
-				if(op2.general_type() == edb::Operand::TYPE_IMMEDIATE) {
-
-					if(op2.immediate() == -static_cast<int>(sizeof(edb::reg_t))) {
-						p += inst.size();
-						edb::Instruction inst2(p, last, 0, std::nothrow);
-						if(inst2) {
-							if(is_ret(inst2)) {
-								add_result((QList<edb::Instruction>() << inst << inst2), start_address);
-							}
-						}
-					}
-				}
-			}
-			break;
+		const QModelIndex index = filter_model_->mapToSource(selected_item);
 
-		default:
-			break;
+		if(const IRegion::pointer region = *reinterpret_cast<const IRegion::pointer *>(index.internalPointer())) {
+			scan.add_code(region);
+			regions += edb::v1::code_regions(region);
 		}
 	}
-}
 
-//------------------------------------------------------------------------------
-// Name:
-// Desc:
-//------------------------------------------------------------------------------
-void DialogOpcodes::run_tests(int classtype, const OpcodeData &opcode, edb::address_t address) {
-
-	switch(classtype) {
-#if defined(EDB_X86)
-	case 1: test_reg_to_ip<edb::Operand::REG_EAX>(opcode, address); break;
-	case 2: test_reg_to_ip<edb::Operand::REG_EBX>(opcode, address); break;
-	case 3: test_reg_to_ip<edb::Operand::REG_ECX>(opcode, address); break;
-	case 4: test_reg_to_ip<edb::Operand::REG_EDX>(opcode, address); break;
-	case 5: test_reg_to_ip<edb::Operand::REG_EBP>(opcode, address); break;
-	case 6: test_reg_to_ip<edb::Operand::REG_ESP>(opcode, address); break;
-	case 7: test_reg_to_ip<edb::Operand::REG_ESI>(opcode, address); break;
-	case 8: test_reg_to_ip<edb::Operand::REG_EDI>(opcode, address); break;
-#elif defined(EDB_X86_64)
-	case 1: test_reg_to_ip<edb::Operand::REG_RAX>(opcode, address); break;
-	case 2: test_reg_to_ip<edb::Operand::REG_RBX>(opcode, address); break;
-	case 3: test_reg_to_ip<edb::Operand::REG_RCX>(opcode, address); break;
-	case 4: test_reg_to_ip<edb::Operand::REG_RDX>(opcode, address); break;
-	case 5: test_reg_to_ip<edb::Operand::REG_RBP>(opcode, address); break;
-	case 6: test_reg_to_ip<edb::Operand::REG_RSP>(opcode, address); break;
-	case 7: test_reg_to_ip<edb::Operand::REG_RSI>(opcode, address); break;
-	case 8: test_reg_to_ip<edb::Operand::REG_RDI>(opcode, address); break;
-	case 9: test_reg_to_ip<edb::Operand::REG_R8>(opcode, address); break;
-	case 10: test_reg_to_ip<edb::Operand::REG_R9>(opcode, address); break;
-	case 11: test_reg_to_ip<edb::Operand::REG_R10>(opcode, address); break;
-	case 12: test_reg_to_ip<edb::Operand::REG_R11>(opcode, address); break;
-	case 13: test_reg_to_ip<edb::Operand::REG_R12>(opcode, address); break;
-	case 14: test_reg_to_ip<edb::Operand::REG_R13>(opcode, address); break;
-	case 15: test_reg_to_ip<edb::Operand::REG_R14>(opcode, address); break;
-	case 16: test_reg_to_ip<edb::Operand::REG_R15>(opcode, address); break;
-#endif
-
-	case 17:
-	#if defined(EDB_X86)
-		test_reg_to_ip<edb::Operand::REG_EAX>(opcode, address);
-		test_reg_to_ip<edb::Operand::REG_EBX>(opcode, address);
-		test_reg_to_ip<edb::Operand::REG_ECX>(opcode, address);
-		test_reg_to_ip<edb::Operand::REG_EDX>(opcode, address);
-		test_reg_to_ip<edb::Operand::REG_EBP>(opcode, address);
-		test_reg_to_ip<edb::Operand::REG_ESP>(opcode, address);
-		test_reg_to_ip<edb::Operand::REG_ESI>(opcode, address);
-		test_reg_to_ip<edb::Operand::REG_EDI>(opcode, address);
-	#elif defined(EDB_X86_64)
-		test_reg_to_ip<edb::Operand::REG_RAX>(opcode, address);
-		test_reg_to_ip<edb::Operand::REG_RBX>(opcode, address);
-		test_reg_to_ip<edb::Operand::REG_RCX>(opcode, address);
-		test_reg_to_ip<edb::Operand::REG_RDX>(opcode, address);
-		test_reg_to_ip<edb::Operand::REG_RBP>(opcode, address);
-		test_reg_to_ip<edb::Operand::REG_RSP>(opcode, address);
-		test_reg_to_ip<edb::Operand::REG_RSI>(opcode, address);
-		test_reg_to_ip<edb::Operand::REG_RDI>(opcode, address);
-		test_reg_to_ip<edb::Operand::REG_R8>(opcode, address);
-		test_reg_to_ip<edb::Operand::REG_R9>(opcode, address);
-		test_reg_to_ip<edb::Operand::REG_R10>(opcode, address);
-		test_reg_to_ip<edb::Operand::REG_R11>(opcode, address);
-		test_reg_to_ip<edb::Operand::REG_R12>(opcode, address);
-		test_reg_to_ip<edb::Operand::REG_R13>(opcode, address);
-		test_reg_to_ip<edb::Operand::REG_R14>(opcode, address);
-		test_reg_to_ip<edb::Operand::REG_R15>(opcode, address);
-	#endif
-		break;
-	case 18:
-		// [ESP] -> EIP
-		test_esp_add_0(opcode, address);
-		break;
-	case 19:
-		// [ESP + 4] -> EIP
-		test_esp_add_regx1(opcode, address);
-		break;
-	case 20:
-		// [ESP + 8] -> EIP
-		test_esp_add_regx2(opcode, address);
-		break;
-	case 21:
-		// [ESP - 4] -> EIP
-		test_esp_sub_regx1(opcode, address);
-		break;
-
-
-	case 22: test_deref_reg_to_ip<edb::Operand::REG_RAX>(opcode, address); break;
-	case 23: test_deref_reg_to_ip<edb::Operand::REG_RBX>(opcode, address); break;
-	case 24: test_deref_reg_to_ip<edb::Operand::REG_RCX>(opcode, address); break;
-	case 25: test_deref_reg_to_ip<edb::Operand::REG_RDX>(opcode, address); break;
-	case 26: test_deref_reg_to_ip<edb::Operand::REG_RBP>(opcode, address); break;
-	case 28: test_deref_reg_to_ip<edb::Operand::REG_RSI>(opcode, address); break;
-	case 29: test_deref_reg_to_ip<edb::Operand::REG_RDI>(opcode, address); break;
-	case 30: test_deref_reg_to_ip<edb::Operand::REG_R8>(opcode, address); break;
-	case 31: test_deref_reg_to_ip<edb::Operand::REG_R9>(opcode, address); break;
-	case 32: test_deref_reg_to_ip<edb::Operand::REG_R10>(opcode, address); break;
-	case 33: test_deref_reg_to_ip<edb::Operand::REG_R11>(opcode, address); break;
-	case 34: test_deref_reg_to_ip<edb::Operand::REG_R12>(opcode, address); break;
-	case 35: test_deref_reg_to_ip<edb::Operand::REG_R13>(opcode, address); break;
-	case 36: test_deref_reg_to_ip<edb::Operand::REG_R14>(opcode, address); break;
-	case 37: test_deref_reg_to_ip<edb::Operand::REG_R15>(opcode, address); break;
-	}
+	RegionScanner().run(regions, &scan);
+	add_results(scan.results);
 }
 
 //------------------------------------------------------------------------------
-// Name: do_find
+// Name: add_results
 // Desc:
 //------------------------------------------------------------------------------
-void DialogOpcodes::do_find() {
-
-	const int classtype = ui->comboBox->itemData(ui->comboBox->currentIndex()).toInt();
-
-	const QItemSelectionModel *const selModel = ui->tableView->selectionModel();
-	const QModelIndexList sel = selModel->selectedRows();
-
-	if(sel.size() == 0) {
-		QMessageBox::information(
-			this,
-			tr("No Region Selected"),
-			tr("You must select a region which is to be scanned for the desired opcode."));
-	} else {
-
-		if(IProcess *process = edb::v1::debugger_core->process()) {
-			Q_FOREACH(const QModelIndex &selected_item, sel) {
-
-				const QModelIndex index = filter_model_->mapToSource(selected_item);
-
-				if(const IRegion::pointer region = *reinterpret_cast<const IRegion::pointer *>(index.internalPointer())) {
-
-					edb::address_t start_address     = region->start();
-					edb::address_t address           = region->start();
-					const edb::address_t end_address = region->end();
-					const edb::address_t orig_start  = region->start();
-
-					ShiftBuffer<sizeof(OpcodeData)> shift_buffer;
-
-					// prime the buffer by filling it up with the minimum block size
-					for(size_t i = 0; i < shift_buffer.size(); ++i) {
-
-						quint8 byte;
-						process->read_bytes(start_address, &byte, 1);
-						shift_buffer.shl();
-						shift_buffer[shift_buffer.size() - 1] = byte;
-
-						++start_address;
-					}
-
-					// this will read the rest of the region
-					while(start_address < end_address) {
-
-						// create a reference to the bsa's data so we can pass it to the testXXXX functions
-						const OpcodeData &opcode = *reinterpret_cast<const OpcodeData *>(&shift_buffer[0]);
-						run_tests(classtype, opcode, address);
-
-						quint8 byte;
-						process->read_bytes(start_address, &byte, 1);
-						shift_buffer.shl();
-						shift_buffer[shift_buffer.size() - 1] = byte;
-
-						++start_address;
-
-						ui->progressBar->setValue(util::percentage(address - orig_start, region->size()));
-						++address;
-					}
-
-					// test the stuff at the regions edge
-					for(size_t i = 0; i < shift_buffer.size(); ++i) {
-
-						// create a reference to the bsa's data so we can pass it to the testXXXX functions
-						const OpcodeData &opcode = *reinterpret_cast<const OpcodeData *>(&shift_buffer[0]);
-						run_tests(classtype, opcode, address);
-
-						// we just shift in 0's and hope it doesn't give false positives
-						shift_buffer.shl();
-						shift_buffer[shift_buffer.size() - 1] = 0x00;
-
-						ui->progressBar->setValue(util::percentage(address - orig_start, region->size()));
-						++address;
-					}
-				}
-			}
-		}
+void DialogOpcodes::add_results(const QVector<OpcodeScan::Result> &results) {
+	Q_FOREACH(const OpcodeScan::Result &result, results) {
+		QListWidgetItem *const item = new QListWidgetItem(result.text);
+		item->setData(Qt::UserRole, result.address);
+		ui->listWidget->addItem(item);
 	}
 }
 
@@ -0,0 +1,541 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "InstructionTemplate.h"
+
+#include <QCoreApplication>
+#include <QRegExp>
+#include <QStringList>
+
+namespace OpcodeSearcher {
+
+namespace {
+
+#if defined(EDB_X86)
+typedef edisassm::x86 model_t;
+#elif defined(EDB_X86_64)
+typedef edisassm::x86_64 model_t;
+#endif
+
+// the furthest "...N" may let the next instruction be
+const int MaxGap = 64;
+
+//------------------------------------------------------------------------------
+// Name: tr
+// Desc:
+//------------------------------------------------------------------------------
+QString tr(const char *text) {
+	return QCoreApplication::translate("OpcodeSearcher::InstructionTemplate", text);
+}
+
+//------------------------------------------------------------------------------
+// Name: parse_number
+// Desc: a number as C would write it, with an optional '-' in front
+//------------------------------------------------------------------------------
+bool parse_number(const QString &text, qint64 *value) {
+	bool ok;
+	if(text.startsWith('-')) {
+		*value = -text.mid(1).toLongLong(&ok, 0);
+	} else {
+		*value = text.toLongLong(&ok, 0);
+	}
+	return ok;
+}
+
+//------------------------------------------------------------------------------
+// Name: register_size
+// Desc: the size in bits of a general purpose register, 0 for any other
+//------------------------------------------------------------------------------
+int register_size(const std::string &name) {
+	static const char *const names[][4] = {
+		{ "rax", "eax", "ax", "al" },
+		{ "rbx", "ebx", "bx", "bl" },
+		{ "rcx", "ecx", "cx", "cl" },
+		{ "rdx", "edx", "dx", "dl" },
+		{ "rsi", "esi", "si", "sil" },
+		{ "rdi", "edi", "di", "dil" },
+		{ "rbp", "ebp", "bp", "bpl" },
+		{ "rsp", "esp", "sp", "spl" },
+		{ "",    "",    "",   "ah" },
+		{ "",    "",    "",   "bh" },
+		{ "",    "",    "",   "ch" },
+		{ "",    "",    "",   "dh" }
+	};
+
+	static const int sizes[] = { 64, 32, 16, 8 };
+
+	for(std::size_t i = 0; i < sizeof(names) / sizeof(names[0]); ++i) {
+		for(int j = 0; j < 4; ++j) {
+			if(name == names[i][j]) {
+				return sizes[j];
+			}
+		}
+	}
+
+	// r8 to r15 and their parts, r8d, r8w and r8b (or r8l)
+	std::size_t n = 1;
+	if(name.size() < 2 || name[0] != 'r') {
+		return 0;
+	}
+
+	while(n < name.size() && name[n] >= '0' && name[n] <= '9') {
+		++n;
+	}
+
+	if(n == 1) {
+		return 0;
+	}
+
+	if(n == name.size()) {
+		return 64;
+	}
+
+	if(n + 1 == name.size()) {
+		switch(name[n]) {
+		case 'd': return 32;
+		case 'w': return 16;
+		case 'b':
+		case 'l': return 8;
+		}
+	}
+
+	return 0;
+}
+
+//------------------------------------------------------------------------------
+// Name: mnemonic_flow
+// Desc: the flow every instruction a step's mnemonic matches has, -1 if they
+//       could have more than one
+//------------------------------------------------------------------------------
+int mnemonic_flow(const QString &mnemonic, bool prefix) {
+	if(mnemonic == "call" || mnemonic == "lcall") {
+		return edb::length::FLOW_CALL;
+	}
+
+	if(mnemonic.startsWith("ret") || mnemonic.startsWith("iret") || mnemonic.startsWith("lret")) {
+		return edb::length::FLOW_RETURN;
+	}
+
+	if(mnemonic == "jmp" || mnemonic == "ljmp") {
+		return edb::length::FLOW_JUMP;
+	}
+
+	if(prefix) {
+		return -1;
+	}
+
+	if(mnemonic.startsWith("jmp")) {
+		// jmpe and whatever else may be named like that
+		return -1;
+	}
+
+	if(mnemonic.startsWith('j') || mnemonic.startsWith("loop")) {
+		return edb::length::FLOW_CONDITIONAL;
+	}
+
+	return edb::length::FLOW_NONE;
+}
+
+}
+
+//------------------------------------------------------------------------------
+// Name: parse
+// Desc: compiles <text>, on failure <error> says why
+//------------------------------------------------------------------------------
+bool InstructionTemplate::parse(const QString &text, QString *error) {
+
+	steps_.clear();
+	span_ = 0;
+
+	QRegExp separator("(;|\\.\\.\\.(\\d*))");
+
+	int gap = 0;
+	int pos = 0;
+
+	Q_FOREVER {
+		const int next = separator.indexIn(text, pos);
+
+		Step step;
+		if(!parse_step(text.mid(pos, next == -1 ? -1 : next - pos).trimmed(), &step, error)) {
+			steps_.clear();
+			return false;
+		}
+
+		step.gap = gap;
+		steps_.push_back(step);
+		span_ += gap + 1;
+
+		if(next == -1) {
+			break;
+		}
+
+		if(separator.cap(1) == ";") {
+			gap = 0;
+		} else {
+			bool ok;
+			const int n = separator.cap(2).toInt(&ok);
+			if(!ok || n < 1 || n > MaxGap) {
+				*error = tr("\"...\" needs the number of instructions the next one has to be within, from 1 to %1").arg(MaxGap);
+				steps_.clear();
+				return false;
+			}
+			gap = n - 1;
+		}
+
+		pos = next + separator.matchedLength();
+	}
+
+	return true;
+}
+
+//------------------------------------------------------------------------------
+// Name: parse_step
+// Desc:
+//------------------------------------------------------------------------------
+bool InstructionTemplate::parse_step(const QString &text, Step *step, QString *error) {
+
+	if(text.isEmpty()) {
+		*error = tr("An instruction is missing");
+		return false;
+	}
+
+	const int space = text.indexOf(QRegExp("\\s"));
+
+	QString       mnemonic = (space == -1 ? text : text.left(space)).toLower();
+	const QString rest     = (space == -1 ? QString() : text.mid(space).trimmed());
+
+	if(!QRegExp("[a-z0-9]*\\*?").exactMatch(mnemonic)) {
+		*error = tr("\"%1\" is not a mnemonic").arg(mnemonic);
+		return false;
+	}
+
+	step->prefix = mnemonic.endsWith('*');
+	if(step->prefix) {
+		mnemonic.chop(1);
+	}
+
+	step->mnemonic     = mnemonic.toStdString();
+	step->flow         = mnemonic.isEmpty() ? -1 : mnemonic_flow(mnemonic, step->prefix);
+	step->any_operands = rest.isEmpty();
+
+	if(!rest.isEmpty()) {
+		Q_FOREACH(const QString &operand, rest.split(',')) {
+			Operand op;
+			if(!parse_operand(operand.trimmed().toLower(), &op, error)) {
+				return false;
+			}
+			step->operands.push_back(op);
+		}
+	}
+
+	return true;
+}
+
+//------------------------------------------------------------------------------
+// Name: parse_operand
+// Desc:
+//------------------------------------------------------------------------------
+bool InstructionTemplate::parse_operand(const QString &text, Operand *operand, QString *error) {
+
+	operand->type         = Operand::OPERAND_ANY;
+	operand->reg.kind     = Register::REG_NONE;
+	operand->index.kind   = Register::REG_NONE;
+	operand->scale        = 1;
+	operand->any_value    = false;
+	operand->value        = 0;
+	operand->displacement = Operand::DISP_NONE;
+	operand->any_memory   = false;
+
+	if(text.isEmpty()) {
+		*error = tr("An operand is missing");
+		return false;
+	}
+
+	if(text == "*") {
+		return true;
+	}
+
+	if(text.startsWith('[')) {
+		if(!text.endsWith(']')) {
+			*error = tr("\"%1\" is missing a ']'").arg(text);
+			return false;
+		}
+		operand->type = Operand::OPERAND_MEMORY;
+		return parse_memory(text.mid(1, text.size() - 2), operand, error);
+	}
+
+	if(text == "imm") {
+		operand->type      = Operand::OPERAND_IMMEDIATE;
+		operand->any_value = true;
+		return true;
+	}
+
+	if(text == "rel") {
+		operand->type = Operand::OPERAND_RELATIVE;
+		return true;
+	}
+
+	if(parse_number(text, &operand->value)) {
+		operand->type = Operand::OPERAND_IMMEDIATE;
+		return true;
+	}
+
+	if(parse_register(text, &operand->reg)) {
+		operand->type = Operand::OPERAND_REGISTER;
+		return true;
+	}
+
+	*error = tr("\"%1\" is not an operand").arg(text);
+	return false;
+}
+
+//------------------------------------------------------------------------------
+// Name: parse_memory
+// Desc: what is between the brackets of a memory operand
+//------------------------------------------------------------------------------
+bool InstructionTemplate::parse_memory(const QString &text, Operand *operand, QString *error) {
+
+	QString expression = text;
+	expression.remove(QRegExp("\\s"));
+
+	if(expression == "*") {
+		operand->any_memory = true;
+		return true;
+	}
+
+	const QString invalid = tr("\"[%1]\" is not a memory operand").arg(text);
+
+	if(expression.isEmpty()) {
+		*error = invalid;
+		return false;
+	}
+
+	QRegExp term("([+-]?)([^+-]+)");
+
+	int pos = 0;
+	while(pos < expression.size()) {
+		if(term.indexIn(expression, pos) != pos) {
+			*error = invalid;
+			return false;
+		}
+
+		const bool    negative = (term.cap(1) == "-");
+		const QString part     = term.cap(2);
+		const int     star     = part.indexOf('*');
+
+		qint64 value;
+
+		if(star != -1) {
+			bool ok;
+			operand->scale = part.mid(star + 1).toInt(&ok);
+			if(negative || operand->index.kind != Register::REG_NONE || !parse_register(part.left(star), &operand->index)) {
+				*error = invalid;
+				return false;
+			}
+
+			if(!ok || (operand->scale != 1 && operand->scale != 2 && operand->scale != 4 && operand->scale != 8)) {
+				*error = tr("The scale of \"[%1]\" has to be 1, 2, 4 or 8").arg(text);
+				return false;
+			}
+		} else if(part == "imm") {
+			if(operand->displacement != Operand::DISP_NONE) {
+				*error = invalid;
+				return false;
+			}
+			operand->displacement = Operand::DISP_ANY;
+		} else if(parse_number(part, &value)) {
+			if(operand->displacement != Operand::DISP_NONE) {
+				*error = invalid;
+				return false;
+			}
+			operand->displacement = Operand::DISP_VALUE;
+			operand->value        = negative ? -value : value;
+		} else {
+			Register reg;
+			if(negative || !parse_register(part, &reg)) {
+				*error = invalid;
+				return false;
+			}
+
+			if(operand->reg.kind == Register::REG_NONE) {
+				operand->reg = reg;
+			} else if(operand->index.kind == Register::REG_NONE) {
+				operand->index = reg;
+				operand->scale = 1;
+			} else {
+				*error = invalid;
+				return false;
+			}
+		}
+
+		pos += term.matchedLength();
+	}
+
+	return true;
+}
+
+//------------------------------------------------------------------------------
+// Name: parse_register
+// Desc:
+//------------------------------------------------------------------------------
+bool InstructionTemplate::parse_register(const QString &text, Register *reg) {
+
+	if(text == "reg") {
+		reg->kind = Register::REG_ANY;
+	} else if(text == "r8") {
+		reg->kind = Register::REG_8;
+	} else if(text == "r16") {
+		reg->kind = Register::REG_16;
+	} else if(text == "r32") {
+		reg->kind = Register::REG_32;
+	} else if(text == "r64") {
+		reg->kind = Register::REG_64;
+	} else if(text == "xmm") {
+		reg->kind = Register::REG_XMM;
+	} else {
+		const QString name = text.startsWith('%') ? text.mid(1) : text;
+		if(!QRegExp("[a-z][a-z0-9]*").exactMatch(name)) {
+			return false;
+		}
+		reg->kind = Register::REG_NAMED;
+		reg->name = name.toStdString();
+	}
+
+	return true;
+}
+
+//------------------------------------------------------------------------------
+// Name: may_match
+// Desc:
+//------------------------------------------------------------------------------
+bool InstructionTemplate::may_match(int step, edb::length::Flow flow) const {
+	return steps_[step].flow == -1 || steps_[step].flow == flow;
+}
+
+//------------------------------------------------------------------------------
+// Name: matches
+// Desc:
+//------------------------------------------------------------------------------
+bool InstructionTemplate::matches(int step, const edb::Instruction &inst) const {
+
+	const Step &s = steps_[step];
+
+	if(!s.mnemonic.empty()) {
+		const std::string mnemonic = inst.mnemonic();
+		if(s.prefix ? mnemonic.compare(0, s.mnemonic.size(), s.mnemonic) != 0 : mnemonic != s.mnemonic) {
+			return false;
+		}
+	}
+
+	if(s.any_operands) {
+		return true;
+	}
+
+	if(static_cast<int>(inst.operand_count()) != s.operands.size()) {
+		return false;
+	}
+
+	for(int i = 0; i < s.operands.size(); ++i) {
+		if(!matches(s.operands[i], inst.operands()[i])) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+//------------------------------------------------------------------------------
+// Name: matches
+// Desc:
+//------------------------------------------------------------------------------
+bool InstructionTemplate::matches(const Register &reg, edb::Operand::Register value) {
+
+	switch(reg.kind) {
+	case Register::REG_NONE:
+		return value == edb::Operand::REG_NULL;
+	case Register::REG_ANY:
+		return value != edb::Operand::REG_NULL;
+	default:
+		break;
+	}
+
+	if(value == edb::Operand::REG_NULL) {
+		return false;
+	}
+
+	const std::string name = edisassm::register_name<model_t>(value);
+
+	switch(reg.kind) {
+	case Register::REG_8:     return register_size(name) == 8;
+	case Register::REG_16:    return register_size(name) == 16;
+	case Register::REG_32:    return register_size(name) == 32;
+	case Register::REG_64:    return register_size(name) == 64;
+	case Register::REG_XMM:   return name.compare(0, 3, "xmm") == 0;
+	case Register::REG_NAMED: return name == reg.name;
+	default:
+		return false;
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: matches
+// Desc:
+//------------------------------------------------------------------------------
+bool InstructionTemplate::matches(const Operand &operand, const edb::Operand &value) {
+
+	switch(operand.type) {
+	case Operand::OPERAND_ANY:
+		return true;
+	case Operand::OPERAND_REGISTER:
+		return value.general_type() == edb::Operand::TYPE_REGISTER && matches(operand.reg, value.reg());
+	case Operand::OPERAND_IMMEDIATE:
+		return value.general_type() == edb::Operand::TYPE_IMMEDIATE && (operand.any_value || static_cast<qint64>(value.immediate()) == operand.value);
+	case Operand::OPERAND_RELATIVE:
+		return value.general_type() == edb::Operand::TYPE_REL;
+	case Operand::OPERAND_MEMORY:
+		break;
+	}
+
+	if(value.general_type() != edb::Operand::TYPE_EXPRESSION) {
+		return false;
+	}
+
+	if(operand.any_memory) {
+		return true;
+	}
+
+	if(!matches(operand.reg, value.expression().base) || !matches(operand.index, value.expression().index)) {
+		return false;
+	}
+
+	if(operand.index.kind != Register::REG_NONE && value.expression().scale != operand.scale) {
+		return false;
+	}
+
+	switch(operand.displacement) {
+	case Operand::DISP_ANY:
+		return value.expression().displacement_type != edb::Operand::DISP_NONE;
+	case Operand::DISP_VALUE:
+		return static_cast<qint64>(value.displacement()) == operand.value;
+	default:
+		// [rbp] is encoded as [rbp + 0], which is the same thing
+		return value.displacement() == 0;
+	}
+}
+
+}
@@ -0,0 +1,138 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef INSTRUCTION_TEMPLATE_20261014_H_
+#define INSTRUCTION_TEMPLATE_20261014_H_
+
+#include "Instruction.h"
+#include "LengthDecoder.h"
+
+#include <QString>
+#include <QVector>
+#include <string>
+
+namespace OpcodeSearcher {
+
+// a sequence of instructions to look for by what they are rather than by
+// their bytes, such as:
+//
+//     mov r64, [r64 + imm] ...3 call r64
+//
+// the instructions are separated by ';' if the next one has to follow right
+// away, or by "...N" if it can be anywhere in the next N instructions. Each
+// one is a mnemonic, which matches any that start with it if it ends in a
+// '*' ("j*", "cmov*") or any instruction at all if it is just "*". If
+// operands are given the instruction has to have just those:
+//
+//     *              anything
+//     reg            any register, r8, r16, r32, r64 and xmm any of that
+//                    kind, or a register by name such as rsp. A '%' in front
+//                    of a name keeps it from being taken for a kind (%r8)
+//     imm            any immediate, or a number for just that one
+//     rel            the target of a relative jump or call
+//     [...]          memory, made of up to a base and an index register (the
+//                    latter scaled by "*N") and "imm" or a number for the
+//                    displacement, joined by '+' or '-'. "[*]" is any memory
+//
+// A match is judged one instruction at a time, so a template can be matched
+// against a stream of instructions in a single pass, see TemplateScan
+class InstructionTemplate {
+public:
+	bool parse(const QString &text, QString *error);
+	bool empty() const { return steps_.isEmpty(); }
+
+public:
+	int size() const     { return steps_.size(); }
+	int max_span() const { return span_; }
+
+	// how many instructions may come before <step>, after the one before it
+	int gap(int step) const { return steps_[step].gap; }
+
+	bool matches(int step, const edb::Instruction &inst) const;
+
+	// false if no instruction which flows like <flow> can be <step>, which
+	// is known without decoding it in full
+	bool may_match(int step, edb::length::Flow flow) const;
+
+private:
+	struct Register {
+		enum Kind {
+			REG_NONE,
+			REG_ANY,
+			REG_8,
+			REG_16,
+			REG_32,
+			REG_64,
+			REG_XMM,
+			REG_NAMED
+		};
+
+		Kind        kind;
+		std::string name;
+	};
+
+	struct Operand {
+		enum Type {
+			OPERAND_ANY,
+			OPERAND_REGISTER,
+			OPERAND_IMMEDIATE,
+			OPERAND_RELATIVE,
+			OPERAND_MEMORY
+		};
+
+		enum Displacement {
+			DISP_NONE,
+			DISP_ANY,
+			DISP_VALUE
+		};
+
+		Type         type;
+		Register     reg;          // the register, or the base of memory
+		Register     index;
+		int          scale;
+		bool         any_value;    // of an immediate
+		qint64       value;        // of an immediate, or the displacement
+		Displacement displacement;
+		bool         any_memory;
+	};
+
+	struct Step {
+		std::string      mnemonic;
+		bool             prefix;       // the mnemonic only has to start with it
+		bool             any_operands;
+		QVector<Operand> operands;
+		int              gap;
+		int              flow;         // an edb::length::Flow, -1 for any
+	};
+
+private:
+	static bool parse_step(const QString &text, Step *step, QString *error);
+	static bool parse_operand(const QString &text, Operand *operand, QString *error);
+	static bool parse_memory(const QString &text, Operand *operand, QString *error);
+	static bool parse_register(const QString &text, Register *reg);
+	static bool matches(const Register &reg, edb::Operand::Register value);
+	static bool matches(const Operand &operand, const edb::Operand &value);
+
+private:
+	QVector<Step> steps_;
+	int           span_;
+};
+
+}
+
+#endif
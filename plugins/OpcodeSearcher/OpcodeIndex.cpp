@@ -0,0 +1,261 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "OpcodeIndex.h"
+#include "edb.h"
+
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+
+namespace OpcodeSearcher {
+
+namespace {
+
+const quint32 INDEX_MAGIC   = 0x58494445; // "EDIX"
+const quint32 INDEX_VERSION = 1;
+
+}
+
+//------------------------------------------------------------------------------
+// Name: OpcodeIndex
+// Desc: only regions of a file which can't be written to get an index,
+//       nothing else can be trusted to still be what the file says it is
+//------------------------------------------------------------------------------
+OpcodeIndex::OpcodeIndex(const IRegion::pointer &region, const QByteArray &md5, bool code_only) : region_(region), md5_(md5), code_only_(code_only) {
+
+	const QString path = region_->name();
+	if(!md5_.isEmpty() && !region_->writable() && path.startsWith(QLatin1Char('/'))) {
+		filename_ = QString(QLatin1String("%1/%2-%3-%4%5.opcodes")).arg(edb::v1::cache_directory(QLatin1String("opcodes")), QFileInfo(path).fileName(), QString::fromLatin1(md5_.toHex())).arg(static_cast<quint64>(region_->base()), 0, 16).arg(code_only_ ? QString() : QLatin1String("-raw"));
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: write_header
+// Desc:
+//------------------------------------------------------------------------------
+void OpcodeIndex::write_header(QDataStream &stream) const {
+	stream << INDEX_MAGIC << INDEX_VERSION;
+	stream << region_->name() << md5_ << static_cast<quint64>(region_->base()) << static_cast<quint64>(region_->size()) << code_only_;
+}
+
+//------------------------------------------------------------------------------
+// Name: read_header
+// Desc: returns true if the index was made from the same part of the same
+//       file, searched in the same way
+//------------------------------------------------------------------------------
+bool OpcodeIndex::read_header(QDataStream &stream) const {
+
+	quint32    magic;
+	quint32    version;
+	QString    path;
+	QByteArray md5;
+	quint64    base;
+	quint64    size;
+	bool       code_only;
+
+	stream >> magic >> version;
+	if(stream.status() != QDataStream::Ok || magic != INDEX_MAGIC || version != INDEX_VERSION) {
+		return false;
+	}
+
+	stream >> path >> md5 >> base >> size >> code_only;
+
+	return stream.status() == QDataStream::Ok &&
+		path == region_->name() &&
+		md5 == md5_ &&
+		base == static_cast<quint64>(region_->base()) &&
+		size == static_cast<quint64>(region_->size()) &&
+		code_only == code_only_;
+}
+
+//------------------------------------------------------------------------------
+// Name: load
+// Desc: returns true if there was a matching index
+//------------------------------------------------------------------------------
+bool OpcodeIndex::load() {
+
+	if(filename_.isEmpty()) {
+		return false;
+	}
+
+	QFile file(filename_);
+	if(!file.open(QIODevice::ReadOnly)) {
+		return false;
+	}
+
+	QDataStream stream(&file);
+	stream.setByteOrder(QDataStream::LittleEndian);
+	stream.setVersion(QDataStream::Qt_4_6);
+
+	if(!read_header(stream)) {
+		return false;
+	}
+
+	const quint64 size = region_->size();
+
+	quint32 classes;
+	stream >> classes;
+
+	QMap<int, QVector<Entry> > entries;
+
+	for(quint32 i = 0; i < classes && stream.status() == QDataStream::Ok; ++i) {
+		qint32  classtype;
+		quint32 count;
+		stream >> classtype >> count;
+
+		QVector<Entry> &found = entries[classtype];
+		found.reserve(count);
+
+		for(quint32 n = 0; n < count; ++n) {
+			Entry entry;
+			stream >> entry.offset >> entry.bytes;
+
+			if(stream.status() != QDataStream::Ok || entry.offset >= size || entry.bytes.isEmpty()) {
+				return false;
+			}
+
+			found.push_back(entry);
+		}
+	}
+
+	if(stream.status() != QDataStream::Ok) {
+		return false;
+	}
+
+	entries_ = entries;
+	return true;
+}
+
+//------------------------------------------------------------------------------
+// Name: save
+// Desc: writes to a temporary file first, so a reader never sees half of one
+//------------------------------------------------------------------------------
+bool OpcodeIndex::save() const {
+
+	if(filename_.isEmpty()) {
+		return false;
+	}
+
+	if(!QDir().mkpath(QFileInfo(filename_).absolutePath())) {
+		return false;
+	}
+
+	const QString temp_filename = edb::v1::temp_filename(filename_);
+
+	QFile file(temp_filename);
+	if(!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+		return false;
+	}
+
+	QDataStream stream(&file);
+	stream.setByteOrder(QDataStream::LittleEndian);
+	stream.setVersion(QDataStream::Qt_4_6);
+
+	write_header(stream);
+
+	stream << static_cast<quint32>(entries_.size());
+	for(QMap<int, QVector<Entry> >::const_iterator it = entries_.begin(); it != entries_.end(); ++it) {
+		stream << static_cast<qint32>(it.key()) << static_cast<quint32>(it.value().size());
+		Q_FOREACH(const Entry &entry, it.value()) {
+			stream << entry.offset << entry.bytes;
+		}
+	}
+
+	file.close();
+
+	if(stream.status() != QDataStream::Ok || file.error() != QFile::NoError) {
+		QFile::remove(temp_filename);
+		return false;
+	}
+
+	QFile::remove(filename_);
+	if(!QFile::rename(temp_filename, filename_)) {
+		QFile::remove(temp_filename);
+		return false;
+	}
+
+	return true;
+}
+
+//------------------------------------------------------------------------------
+// Name: set_results
+// Desc: takes what an OpcodeScan of every class found, only the results
+//       inside of our region are kept. Every class gets an entry, even an
+//       empty one, so that not finding anything is remembered too
+//------------------------------------------------------------------------------
+void OpcodeIndex::set_results(const QVector<OpcodeScan::Result> &results) {
+
+	entries_.clear();
+	Q_FOREACH(int classtype, OpcodeScan::indexed_classtypes()) {
+		entries_[classtype];
+	}
+
+	Q_FOREACH(const OpcodeScan::Result &result, results) {
+		if(region_->contains(result.address) && entries_.contains(result.classtype)) {
+			const Entry entry = { result.address - region_->start(), result.bytes };
+			entries_[result.classtype].push_back(entry);
+		}
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: results
+// Desc: what a search for <classtype> finds, in address order, relocated to
+//       where the region is now
+//------------------------------------------------------------------------------
+QVector<OpcodeScan::Result> OpcodeIndex::results(int classtype) const {
+
+	QList<int> classtypes;
+	if(classtype == OpcodeScan::ANY_REGISTER) {
+		Q_FOREACH(int indexed, OpcodeScan::indexed_classtypes()) {
+			if(indexed < OpcodeScan::ANY_REGISTER) {
+				classtypes.push_back(indexed);
+			}
+		}
+	} else {
+		classtypes.push_back(classtype);
+	}
+
+	// only one register class can match at any address, so putting them
+	// together in order is all it takes to make ANY_REGISTER
+	QMap<quint64, const Entry *> found;
+	Q_FOREACH(int c, classtypes) {
+		QMap<int, QVector<Entry> >::const_iterator it = entries_.find(c);
+		if(it != entries_.end()) {
+			for(int i = 0; i < it.value().size(); ++i) {
+				found.insert(it.value()[i].offset, &it.value()[i]);
+			}
+		}
+	}
+
+	const edb::address_t base = region_->start();
+
+	QVector<OpcodeScan::Result> ret;
+	ret.reserve(found.size());
+	for(QMap<quint64, const Entry *>::const_iterator it = found.begin(); it != found.end(); ++it) {
+		const edb::address_t address = base + it.key();
+		const OpcodeScan::Result result = { address, OpcodeScan::result_text(it.value()->bytes, address), it.value()->bytes, classtype };
+		ret.push_back(result);
+	}
+
+	return ret;
+}
+
+}
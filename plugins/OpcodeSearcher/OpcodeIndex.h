@@ -0,0 +1,72 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef OPCODE_INDEX_20261014_H_
+#define OPCODE_INDEX_20261014_H_
+
+#include "IRegion.h"
+#include "OpcodeScan.h"
+#include <QByteArray>
+#include <QMap>
+#include <QString>
+#include <QVector>
+
+class QDataStream;
+
+namespace OpcodeSearcher {
+
+// where each kind of sequence the dialog searches for is in a module's
+// region, kept on disk next to the symbol files and keyed by the MD5 of the
+// module's file. A region is searched for all of them in one pass the first
+// time any of them is asked for, after that a search is a lookup. Results
+// are stored as offsets from the start of the region along with their bytes,
+// so they hold wherever the module ends up being loaded. Searches of just
+// the code sections and of the whole region are indexed apart
+class OpcodeIndex {
+public:
+	OpcodeIndex(const IRegion::pointer &region, const QByteArray &md5, bool code_only);
+
+public:
+	// false for regions which can't be indexed, they have to be searched
+	bool valid() const { return !filename_.isEmpty(); }
+	bool load();
+	bool save() const;
+	void set_results(const QVector<OpcodeScan::Result> &results);
+	QVector<OpcodeScan::Result> results(int classtype) const;
+
+private:
+	struct Entry {
+		quint64    offset;
+		QByteArray bytes;
+	};
+
+private:
+	bool read_header(QDataStream &stream) const;
+	void write_header(QDataStream &stream) const;
+
+private:
+	IRegion::pointer           region_;
+	QByteArray                 md5_;
+	bool                       code_only_;
+	QString                    filename_;
+	QMap<int, QVector<Entry> > entries_;  // by classtype, each in address order
+};
+
+}
+
+#endif
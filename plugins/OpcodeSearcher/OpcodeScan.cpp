@@ -0,0 +1,846 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "OpcodeScan.h"
+#include "Instruction.h"
+#include "InstructionTextCache.h"
+#include "RegionReader.h"
+#include "Util.h"
+#include "edb.h"
+
+#include <QProgressBar>
+
+#include <algorithm>
+#include <cstring>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace OpcodeSearcher {
+
+namespace {
+#if defined(EDB_X86)
+const edb::Operand::Register STACK_REG = edb::Operand::REG_ESP;
+#elif defined(EDB_X86_64)
+const edb::Operand::Register STACK_REG = edb::Operand::REG_RSP;
+#endif
+
+//------------------------------------------------------------------------------
+// Name: set_bytes
+// Desc:
+//------------------------------------------------------------------------------
+void set_bytes(bool *table, quint8 first, quint8 last) {
+	for(int i = first; i <= last; ++i) {
+		table[i] = true;
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: make_first_byte_table
+// Desc: marks the bytes that a sequence <classtype> looks for can start with,
+//       positions starting with anything else are never decoded. Prefixes
+//       are always let through, they can come before any of the opcodes
+//------------------------------------------------------------------------------
+void make_first_byte_table(int classtype, bool *table) {
+
+	std::fill(table, table + 256, false);
+
+	// segment overrides, operand and address size, lock and rep
+	table[0x26] = true;
+	table[0x2e] = true;
+	table[0x36] = true;
+	table[0x3e] = true;
+	set_bytes(table, 0x64, 0x67);
+	table[0xf0] = true;
+	table[0xf2] = true;
+	table[0xf3] = true;
+
+	// REX
+	set_bytes(table, 0x40, 0x4f);
+
+	// jmp/call through a register or memory
+	table[0xff] = true;
+
+	if(classtype == OpcodeScan::ALL_CLASSES || classtype <= OpcodeScan::ANY_REGISTER) {
+		// push reg; ret
+		set_bytes(table, 0x50, 0x57);
+	}
+
+	if(classtype == OpcodeScan::ALL_CLASSES || (classtype > OpcodeScan::ANY_REGISTER && classtype <= 21)) {
+		// pop reg; ...
+		set_bytes(table, 0x58, 0x5f);
+		table[0x8f] = true;
+		table[0x07] = true;
+		table[0x17] = true;
+		table[0x1f] = true;
+		table[0x0f] = true;
+
+		// ret and ret imm16
+		set_bytes(table, 0xc2, 0xc3);
+		set_bytes(table, 0xca, 0xcb);
+
+		// add/sub esp, imm
+		table[0x81] = true;
+		table[0x83] = true;
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: next_candidate
+// Desc: skips to the first byte which make_first_byte_table(ALL_CLASSES)
+//       lets through, or to a little before it. Most bytes of code get
+//       through anyway, this pays off over the stretches which are made of
+//       other things
+//------------------------------------------------------------------------------
+const quint8 *next_candidate(const quint8 *p, const quint8 *last) {
+
+#ifdef __SSE2__
+	// each pair is a mask and what a byte looks like under it, together they
+	// cover a few bytes more than the table, which it then turns away
+	const __m128i segment_mask = _mm_set1_epi8(static_cast<char>(0xe7)); // 26 2e 36 3e and 07 0f 17 1f
+	const __m128i segment      = _mm_set1_epi8(static_cast<char>(0x26));
+	const __m128i pop_segment  = _mm_set1_epi8(static_cast<char>(0x07));
+	const __m128i quad_mask    = _mm_set1_epi8(static_cast<char>(0xfc)); // 64-67 and f0-f3
+	const __m128i size         = _mm_set1_epi8(static_cast<char>(0x64));
+	const __m128i lock_rep     = _mm_set1_epi8(static_cast<char>(0xf0));
+	const __m128i ret_mask     = _mm_set1_epi8(static_cast<char>(0xf6)); // c2 c3 ca cb
+	const __m128i ret          = _mm_set1_epi8(static_cast<char>(0xc2));
+	const __m128i arith_mask   = _mm_set1_epi8(static_cast<char>(0xfd)); // 81 83
+	const __m128i arith        = _mm_set1_epi8(static_cast<char>(0x81));
+	const __m128i group_mask   = _mm_set1_epi8(static_cast<char>(0x8f)); // 8f and ff
+	const __m128i low          = _mm_set1_epi8(static_cast<char>(0x40)); // REX, push and pop are 40-5f
+	const __m128i span         = _mm_set1_epi8(static_cast<char>(0x1f));
+	const __m128i zero         = _mm_setzero_si128();
+
+	while(last - p >= 16) {
+		const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+
+		const __m128i masked = _mm_and_si128(v, segment_mask);
+		__m128i hits = _mm_or_si128(_mm_cmpeq_epi8(masked, segment), _mm_cmpeq_epi8(masked, pop_segment));
+
+		const __m128i quad = _mm_and_si128(v, quad_mask);
+		hits = _mm_or_si128(hits, _mm_cmpeq_epi8(quad, size));
+		hits = _mm_or_si128(hits, _mm_cmpeq_epi8(quad, lock_rep));
+		hits = _mm_or_si128(hits, _mm_cmpeq_epi8(_mm_and_si128(v, ret_mask), ret));
+		hits = _mm_or_si128(hits, _mm_cmpeq_epi8(_mm_and_si128(v, arith_mask), arith));
+		hits = _mm_or_si128(hits, _mm_cmpeq_epi8(_mm_and_si128(v, group_mask), group_mask));
+		hits = _mm_or_si128(hits, _mm_cmpeq_epi8(_mm_subs_epu8(_mm_sub_epi8(v, low), span), zero));
+
+		if(const unsigned int mask = _mm_movemask_epi8(hits)) {
+			return p + __builtin_ctz(mask);
+		}
+
+		p += 16;
+	}
+#endif
+
+	return p;
+}
+
+#if defined(EDB_X86)
+const int indexed_classes[] = {
+	1, 2, 3, 4, 5, 6, 7, 8,
+	18, 19, 20, 21,
+	22, 23, 24, 25, 26, 28, 29
+};
+#elif defined(EDB_X86_64)
+const int indexed_classes[] = {
+	1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16,
+	18, 19, 20, 21,
+	22, 23, 24, 25, 26, 28, 29, 30, 31, 32, 33, 34, 35, 36, 37
+};
+#endif
+
+}
+
+//------------------------------------------------------------------------------
+// Name: indexed_classtypes
+// Desc:
+//------------------------------------------------------------------------------
+QList<int> OpcodeScan::indexed_classtypes() {
+	QList<int> ret;
+	for(std::size_t i = 0; i < sizeof(indexed_classes) / sizeof(indexed_classes[0]); ++i) {
+		ret.push_back(indexed_classes[i]);
+	}
+	return ret;
+}
+
+//------------------------------------------------------------------------------
+// Name: OpcodeScan
+// Desc:
+//------------------------------------------------------------------------------
+OpcodeScan::OpcodeScan(int classtype, QProgressBar *progress) : classtype_(classtype), progress_(progress) {
+	make_first_byte_table(classtype_, first_byte_);
+}
+
+//------------------------------------------------------------------------------
+// Name: run
+// Desc: searches each of <regions> in turn, the progress is that of the one
+//       being searched
+//------------------------------------------------------------------------------
+void OpcodeScan::run(const QList<IRegion::pointer> &regions) {
+
+	RegionReader reader(sizeof(OpcodeData) - 1);
+
+	Q_FOREACH(const IRegion::pointer &region, regions) {
+
+		reader.reset(region);
+		while(reader.next()) {
+
+			const quint8 *const data = reader.data();
+
+			for(std::size_t i = 0; i < reader.size(); ++i) {
+
+				if(classtype_ == ALL_CLASSES) {
+					i = next_candidate(data + i, data + reader.size()) - data;
+					if(i == reader.size()) {
+						break;
+					}
+				}
+
+				if(!first_byte_[data[i]]) {
+					continue;
+				}
+
+				// past the end of the region we just shift in 0's and
+				// hope it doesn't give false positives
+				OpcodeData opcode;
+				opcode.qword = 0;
+				std::memcpy(opcode.data, data + i, qMin(sizeof(opcode), reader.available() - i));
+
+				if(classtype_ == ALL_CLASSES) {
+					for(std::size_t n = 0; n < sizeof(indexed_classes) / sizeof(indexed_classes[0]); ++n) {
+						const int first = results.size();
+						run_tests(indexed_classes[n], opcode, reader.address() + i);
+						for(int r = first; r < results.size(); ++r) {
+							results[r].classtype = indexed_classes[n];
+						}
+					}
+				} else {
+					run_tests(classtype_, opcode, reader.address() + i);
+				}
+			}
+
+			if(progress_) {
+				progress_->setValue(util::percentage(reader.offset(), region->size()));
+			}
+		}
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: add_result
+// Desc:
+//------------------------------------------------------------------------------
+void OpcodeScan::add_result(const OpcodeData &data, QList<edb::Instruction> instructions, edb::address_t rva) {
+	if(!instructions.isEmpty()) {
+
+		int size = 0;
+		Q_FOREACH(const edb::Instruction &instruction, instructions) {
+			size += instruction.size();
+		}
+
+		const QByteArray bytes(reinterpret_cast<const char *>(data.data), qMin<int>(size, sizeof(data)));
+
+		// an index only needs to know where they are
+		if(classtype_ == ALL_CLASSES) {
+			const Result result = { rva, QString(), bytes, classtype_ };
+			results.push_back(result);
+			return;
+		}
+
+		const edb::Instruction inst1 = instructions.takeFirst();
+
+		QString instruction_string = QString("%1: %2").arg(
+			edb::v1::format_pointer(rva),
+			edb::v1::instruction_text_cache().format(inst1));
+
+
+		Q_FOREACH(const edb::Instruction &instruction, instructions) {
+			instruction_string.append(QString("; %1").arg(edb::v1::instruction_text_cache().format(instruction)));
+		}
+
+		const Result result = { rva, instruction_string, bytes, classtype_ };
+		results.push_back(result);
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: result_text
+// Desc: the same text add_result gives the instructions
+//------------------------------------------------------------------------------
+QString OpcodeScan::result_text(const QByteArray &bytes, edb::address_t address) {
+
+	const quint8 *p          = reinterpret_cast<const quint8 *>(bytes.constData());
+	const quint8 *const last = p + bytes.size();
+
+	QString ret = QString("%1: ").arg(edb::v1::format_pointer(address));
+
+	bool first = true;
+	while(p < last) {
+		const edb::Instruction inst(p, last, address + (p - reinterpret_cast<const quint8 *>(bytes.constData())), std::nothrow);
+		if(!inst) {
+			break;
+		}
+
+		if(!first) {
+			ret.append(QLatin1String("; "));
+		}
+
+		ret.append(edb::v1::instruction_text_cache().format(inst));
+		first = false;
+		p += inst.size();
+	}
+
+	return ret;
+}
+
+//------------------------------------------------------------------------------
+// Name: test_deref_reg_to_ip
+// Desc:
+//------------------------------------------------------------------------------
+template <edb::Operand::Register REG>
+void OpcodeScan::test_deref_reg_to_ip(const OpcodeData &data, edb::address_t start_address) {
+	const quint8 *p = data.data;
+	const quint8 *last = p + sizeof(data);
+
+	edb::Instruction inst(p, last, 0, std::nothrow);
+
+	if(inst) {
+		const edb::Operand &op1 = inst.operands()[0];
+		switch(inst.type()) {
+		case edb::Instruction::OP_JMP:
+		case edb::Instruction::OP_CALL:
+			if(op1.general_type() == edb::Operand::TYPE_EXPRESSION) {
+
+				if(op1.expression().displacement_type == edb::Operand::DISP_NONE) {
+
+					if(op1.expression().base == REG && op1.expression().index == edb::Operand::REG_NULL && op1.expression().scale == 1) {
+						add_result(data, (QList<edb::Instruction>() << inst), start_address);
+						return;
+					}
+
+					if(op1.expression().index == REG && op1.expression().base == edb::Operand::REG_NULL && op1.expression().scale == 1) {
+						add_result(data, (QList<edb::Instruction>() << inst), start_address);
+						return;
+					}
+				}
+			}
+			break;
+		default:
+			break;
+		}
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: test_reg_to_ip
+// Desc:
+//------------------------------------------------------------------------------
+template <edb::Operand::Register REG>
+void OpcodeScan::test_reg_to_ip(const OpcodeScan::OpcodeData &data, edb::address_t start_address) {
+
+	const quint8 *p = data.data;
+	const quint8 *last = p + sizeof(data);
+
+	edb::Instruction inst(p, last, 0, std::nothrow);
+
+	if(inst) {
+		const edb::Operand &op1 = inst.operands()[0];
+		switch(inst.type()) {
+		case edb::Instruction::OP_JMP:
+		case edb::Instruction::OP_CALL:
+			if(op1.general_type() == edb::Operand::TYPE_REGISTER) {
+				if(op1.reg() == REG) {
+					add_result(data, (QList<edb::Instruction>() << inst), start_address);
+					return;
+				}
+			}
+			break;
+
+		case edb::Instruction::OP_PUSH:
+			if(op1.general_type() == edb::Operand::TYPE_REGISTER) {
+				if(op1.reg() == REG) {
+
+					p += inst.size();
+					edb::Instruction inst2(p, last, 0, std::nothrow);
+					if(inst2) {
+						const edb::Operand &op2 = inst2.operands()[0];
+						switch(inst2.type()) {
+						case edb::Instruction::OP_RET:
+							add_result(data, (QList<edb::Instruction>() << inst << inst2), start_address);
+							break;
+						case edb::Instruction::OP_JMP:
+						case edb::Instruction::OP_CALL:
+
+							if(op2.general_type() == edb::Operand::TYPE_EXPRESSION) {
+
+								if(op2.expression().displacement_type == edb::Operand::DISP_NONE) {
+
+									if(op2.expression().base == STACK_REG && op2.expression().index == edb::Operand::REG_NULL) {
+										add_result(data, (QList<edb::Instruction>() << inst << inst2), start_address);
+										return;
+									}
+
+									if(op2.expression().index == STACK_REG && op2.expression().base == edb::Operand::REG_NULL) {
+										add_result(data, (QList<edb::Instruction>() << inst << inst2), start_address);
+										return;
+									}
+								}
+							}
+							break;
+						default:
+							break;
+						}
+					}
+				}
+			}
+			break;
+		default:
+			break;
+		}
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: test_esp_add_0
+// Desc:
+//------------------------------------------------------------------------------
+void OpcodeScan::test_esp_add_0(const OpcodeData &data, edb::address_t start_address) {
+
+	const quint8 *p = data.data;
+	const quint8 *last = p + sizeof(data);
+
+	edb::Instruction inst(p, last, 0, std::nothrow);
+
+	if(inst) {
+		const edb::Operand &op1 = inst.operands()[0];
+		switch(inst.type()) {
+		case edb::Instruction::OP_RET:
+			add_result(data, (QList<edb::Instruction>() << inst), start_address);
+			break;
+
+		case edb::Instruction::OP_CALL:
+		case edb::Instruction::OP_JMP:
+			if(op1.general_type() == edb::Operand::TYPE_EXPRESSION) {
+
+				if(op1.expression().displacement_type == edb::Operand::DISP_NONE) {
+
+					if(op1.expression().base == STACK_REG && op1.expression().index == edb::Operand::REG_NULL) {
+						add_result(data, (QList<edb::Instruction>() << inst), start_address);
+						return;
+					}
+
+					if(op1.expression().index == STACK_REG && op1.expression().base == edb::Operand::REG_NULL) {
+						add_result(data, (QList<edb::Instruction>() << inst), start_address);
+						return;
+					}
+				}
+			}
+			break;
+		case edb::Instruction::OP_POP:
+			if(op1.general_type() == edb::Operand::TYPE_REGISTER) {
+
+				p += inst.size();
+				edb::Instruction inst2(p, last, 0, std::nothrow);
+				if(inst2) {
+					const edb::Operand &op2 = inst2.operands()[0];
+					switch(inst2.type()) {
+					case edb::Instruction::OP_JMP:
+					case edb::Instruction::OP_CALL:
+
+						if(op2.general_type() == edb::Operand::TYPE_REGISTER) {
+
+							if(op1.reg() == op2.reg()) {
+								add_result(data, (QList<edb::Instruction>() << inst << inst2), start_address);
+							}
+						}
+						break;
+					default:
+						break;
+					}
+				}
+			}
+			break;
+
+		default:
+			break;
+		}
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: test_esp_add_regx1
+// Desc:
+//------------------------------------------------------------------------------
+void OpcodeScan::test_esp_add_regx1(const OpcodeData &data, edb::address_t start_address) {
+
+	const quint8 *p = data.data;
+	const quint8 *last = p + sizeof(data);
+
+	edb::Instruction inst(p, last, 0, std::nothrow);
+
+	if(inst) {
+		const edb::Operand &op1 = inst.operands()[0];
+		switch(inst.type()) {
+		case edb::Instruction::OP_POP:
+
+			if(op1.general_type() != edb::Operand::TYPE_REGISTER || op1.reg() != STACK_REG) {
+				p += inst.size();
+				edb::Instruction inst2(p, last, 0, std::nothrow);
+				if(inst2) {
+					if(is_ret(inst2)) {
+						add_result(data, (QList<edb::Instruction>() << inst << inst2), start_address);
+					}
+				}
+			}
+			break;
+		case edb::Instruction::OP_JMP:
+		case edb::Instruction::OP_CALL:
+
+			if(op1.general_type() == edb::Operand::TYPE_EXPRESSION) {
+
+				if(op1.displacement() == 4) {
+					if(op1.expression().base == STACK_REG && op1.expression().index == edb::Operand::REG_NULL) {
+						add_result(data, (QList<edb::Instruction>() << inst), start_address);
+					} else if(op1.expression().base == edb::Operand::REG_NULL && op1.expression().index == STACK_REG && op1.expression().scale == 1) {
+						add_result(data, (QList<edb::Instruction>() << inst), start_address);
+					}
+
+				}
+			}
+			break;
+		case edb::Instruction::OP_SUB:
+			if(op1.general_type() == edb::Operand::TYPE_REGISTER && op1.reg() == STACK_REG) {
+
+				const edb::Operand &op2 = inst.operands()[1];
+				if(op2.general_type() == edb::Operand::TYPE_IMMEDIATE) {
+
+					if(op2.immediate() == -static_cast<int>(sizeof(edb::reg_t))) {
+						p += inst.size();
+						edb::Instruction inst2(p, last, 0, std::nothrow);
+						if(inst2) {
+							if(is_ret(inst2)) {
+								add_result(data, (QList<edb::Instruction>() << inst << inst2), start_address);
+							}
+						}
+					}
+				}
+			}
+			break;
+
+		case edb::Instruction::OP_ADD:
+			if(op1.general_type() == edb::Operand::TYPE_REGISTER && op1.reg() == STACK_REG) {
+
+				const edb::Operand &op2 = inst.operands()[1];
+				if(op2.general_type() == edb::Operand::TYPE_IMMEDIATE) {
+
+					if(op2.immediate() == sizeof(edb::reg_t)) {
+						p += inst.size();
+						edb::Instruction inst2(p, last, 0, std::nothrow);
+						if(inst2) {
+							if(is_ret(inst2)) {
+								add_result(data, (QList<edb::Instruction>() << inst << inst2), start_address);
+							}
+						}
+					}
+				}
+			}
+			break;
+
+		default:
+			break;
+		}
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: test_esp_add_regx2
+// Desc:
+//------------------------------------------------------------------------------
+void OpcodeScan::test_esp_add_regx2(const OpcodeData &data, edb::address_t start_address) {
+
+	const quint8 *p = data.data;
+	const quint8 *last = p + sizeof(data);
+
+	edb::Instruction inst(p, last, 0, std::nothrow);
+
+	if(inst) {
+		const edb::Operand &op1 = inst.operands()[0];
+		switch(inst.type()) {
+		case edb::Instruction::OP_POP:
+
+			if(op1.general_type() != edb::Operand::TYPE_REGISTER || op1.reg() != STACK_REG) {
+				p += inst.size();
+				edb::Instruction inst2(p, last, 0, std::nothrow);
+				if(inst2) {
+					const edb::Operand &op2 = inst2.operands()[0];
+					switch(inst2.type()) {
+					case edb::Instruction::OP_POP:
+
+						if(op2.general_type() != edb::Operand::TYPE_REGISTER || op2.reg() != STACK_REG) {
+							p += inst2.size();
+							edb::Instruction inst3(p, last, 0, std::nothrow);
+							if(inst3) {
+								if(is_ret(inst3)) {
+									add_result(data, (QList<edb::Instruction>() << inst << inst2 << inst3), start_address);
+								}
+							}
+						}
+						break;
+					default:
+						break;
+					}
+				}
+			}
+			break;
+
+		case edb::Instruction::OP_JMP:
+		case edb::Instruction::OP_CALL:
+			if(op1.general_type() == edb::Operand::TYPE_EXPRESSION) {
+
+				if(op1.displacement() == (sizeof(edb::reg_t) * 2)) {
+					if(op1.expression().base == STACK_REG && op1.expression().index == edb::Operand::REG_NULL) {
+						add_result(data, (QList<edb::Instruction>() << inst), start_address);
+					} else if(op1.expression().base == edb::Operand::REG_NULL && op1.expression().index == STACK_REG && op1.expression().scale == 1) {
+						add_result(data, (QList<edb::Instruction>() << inst), start_address);
+					}
+
+				}
+			}
+			break;
+
+		case edb::Instruction::OP_SUB:
+			if(op1.general_type() == edb::Operand::TYPE_REGISTER && op1.reg() == STACK_REG) {
+
+				const edb::Operand &op2 = inst.operands()[1];
+				if(op2.general_type() == edb::Operand::TYPE_IMMEDIATE) {
+
+					if(op2.immediate() == -static_cast<int>(sizeof(edb::reg_t) * 2)) {
+						p += inst.size();
+						edb::Instruction inst2(p, last, 0, std::nothrow);
+						if(inst2) {
+							if(is_ret(inst2)) {
+								add_result(data, (QList<edb::Instruction>() << inst << inst2), start_address);
+							}
+						}
+					}
+				}
+			}
+			break;
+
+		case edb::Instruction::OP_ADD:
+			if(op1.general_type() == edb::Operand::TYPE_REGISTER && op1.reg() == STACK_REG) {
+
+				const edb::Operand &op2 = inst.operands()[1];
+				if(op2.general_type() == edb::Operand::TYPE_IMMEDIATE) {
+
+					if(op2.immediate() == (sizeof(edb::reg_t) * 2)) {
+						p += inst.size();
+						edb::Instruction inst2(p, last, 0, std::nothrow);
+						if(inst2) {
+							if(is_ret(inst2)) {
+								add_result(data, (QList<edb::Instruction>() << inst << inst2), start_address);
+							}
+						}
+					}
+				}
+			}
+			break;
+
+		default:
+			break;
+		}
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: test_esp_sub_regx1
+// Desc:
+//------------------------------------------------------------------------------
+void OpcodeScan::test_esp_sub_regx1(const OpcodeData &data, edb::address_t start_address) {
+
+	const quint8 *p = data.data;
+	const quint8 *last = p + sizeof(data);
+
+	edb::Instruction inst(p, last, 0, std::nothrow);
+
+	if(inst) {
+		const edb::Operand &op1 = inst.operands()[0];
+		switch(inst.type()) {
+		case edb::Instruction::OP_JMP:
+		case edb::Instruction::OP_CALL:
+			if(op1.general_type() == edb::Operand::TYPE_EXPRESSION) {
+
+				if(op1.displacement() == -static_cast<int>(sizeof(edb::reg_t))) {
+					if(op1.expression().base == STACK_REG && op1.expression().index == edb::Operand::REG_NULL) {
+						add_result(data, (QList<edb::Instruction>() << inst), start_address);
+					} else if(op1.expression().base == edb::Operand::REG_NULL && op1.expression().index == STACK_REG && op1.expression().scale == 1) {
+						add_result(data, (QList<edb::Instruction>() << inst), start_address);
+					}
+
+				}
+			}
+			break;
+
+		case edb::Instruction::OP_SUB:
+			if(op1.general_type() == edb::Operand::TYPE_REGISTER && op1.reg() == STACK_REG) {
+
+				const edb::Operand &op2 = inst.operands()[1];
+				if(op2.general_type() == edb::Operand::TYPE_IMMEDIATE) {
+
+					if(op2.immediate() == static_cast<int>(sizeof(edb::reg_t))) {
+						p += inst.size();
+						edb::Instruction inst2(p, last, 0, std::nothrow);
+						if(inst2) {
+							if(is_ret(inst2)) {
+								add_result(data, (QList<edb::Instruction>() << inst << inst2), start_address);
+							}
+						}
+					}
+				}
+			}
+			break;
+
+		case edb::Instruction::OP_ADD:
+			if(op1.general_type() == edb::Operand::TYPE_REGISTER && op1.reg() == STACK_REG) {
+
+				const edb::Operand &op2 = inst.operands()[1];
+				if(op2.general_type() == edb::Operand::TYPE_IMMEDIATE) {
+
+					if(op2.immediate() == -static_cast<int>(sizeof(edb::reg_t))) {
+						p += inst.size();
+						edb::Instruction inst2(p, last, 0, std::nothrow);
+						if(inst2) {
+							if(is_ret(inst2)) {
+								add_result(data, (QList<edb::Instruction>() << inst << inst2), start_address);
+							}
+						}
+					}
+				}
+			}
+			break;
+
+		default:
+			break;
+		}
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: run_tests
+// Desc:
+//------------------------------------------------------------------------------
+void OpcodeScan::run_tests(int classtype, const OpcodeData &opcode, edb::address_t address) {
+
+	switch(classtype) {
+#if defined(EDB_X86)
+	case 1: test_reg_to_ip<edb::Operand::REG_EAX>(opcode, address); break;
+	case 2: test_reg_to_ip<edb::Operand::REG_EBX>(opcode, address); break;
+	case 3: test_reg_to_ip<edb::Operand::REG_ECX>(opcode, address); break;
+	case 4: test_reg_to_ip<edb::Operand::REG_EDX>(opcode, address); break;
+	case 5: test_reg_to_ip<edb::Operand::REG_EBP>(opcode, address); break;
+	case 6: test_reg_to_ip<edb::Operand::REG_ESP>(opcode, address); break;
+	case 7: test_reg_to_ip<edb::Operand::REG_ESI>(opcode, address); break;
+	case 8: test_reg_to_ip<edb::Operand::REG_EDI>(opcode, address); break;
+#elif defined(EDB_X86_64)
+	case 1: test_reg_to_ip<edb::Operand::REG_RAX>(opcode, address); break;
+	case 2: test_reg_to_ip<edb::Operand::REG_RBX>(opcode, address); break;
+	case 3: test_reg_to_ip<edb::Operand::REG_RCX>(opcode, address); break;
+	case 4: test_reg_to_ip<edb::Operand::REG_RDX>(opcode, address); break;
+	case 5: test_reg_to_ip<edb::Operand::REG_RBP>(opcode, address); break;
+	case 6: test_reg_to_ip<edb::Operand::REG_RSP>(opcode, address); break;
+	case 7: test_reg_to_ip<edb::Operand::REG_RSI>(opcode, address); break;
+	case 8: test_reg_to_ip<edb::Operand::REG_RDI>(opcode, address); break;
+	case 9: test_reg_to_ip<edb::Operand::REG_R8>(opcode, address); break;
+	case 10: test_reg_to_ip<edb::Operand::REG_R9>(opcode, address); break;
+	case 11: test_reg_to_ip<edb::Operand::REG_R10>(opcode, address); break;
+	case 12: test_reg_to_ip<edb::Operand::REG_R11>(opcode, address); break;
+	case 13: test_reg_to_ip<edb::Operand::REG_R12>(opcode, address); break;
+	case 14: test_reg_to_ip<edb::Operand::REG_R13>(opcode, address); break;
+	case 15: test_reg_to_ip<edb::Operand::REG_R14>(opcode, address); break;
+	case 16: test_reg_to_ip<edb::Operand::REG_R15>(opcode, address); break;
+#endif
+
+	case 17:
+	#if defined(EDB_X86)
+		test_reg_to_ip<edb::Operand::REG_EAX>(opcode, address);
+		test_reg_to_ip<edb::Operand::REG_EBX>(opcode, address);
+		test_reg_to_ip<edb::Operand::REG_ECX>(opcode, address);
+		test_reg_to_ip<edb::Operand::REG_EDX>(opcode, address);
+		test_reg_to_ip<edb::Operand::REG_EBP>(opcode, address);
+		test_reg_to_ip<edb::Operand::REG_ESP>(opcode, address);
+		test_reg_to_ip<edb::Operand::REG_ESI>(opcode, address);
+		test_reg_to_ip<edb::Operand::REG_EDI>(opcode, address);
+	#elif defined(EDB_X86_64)
+		test_reg_to_ip<edb::Operand::REG_RAX>(opcode, address);
+		test_reg_to_ip<edb::Operand::REG_RBX>(opcode, address);
+		test_reg_to_ip<edb::Operand::REG_RCX>(opcode, address);
+		test_reg_to_ip<edb::Operand::REG_RDX>(opcode, address);
+		test_reg_to_ip<edb::Operand::REG_RBP>(opcode, address);
+		test_reg_to_ip<edb::Operand::REG_RSP>(opcode, address);
+		test_reg_to_ip<edb::Operand::REG_RSI>(opcode, address);
+		test_reg_to_ip<edb::Operand::REG_RDI>(opcode, address);
+		test_reg_to_ip<edb::Operand::REG_R8>(opcode, address);
+		test_reg_to_ip<edb::Operand::REG_R9>(opcode, address);
+		test_reg_to_ip<edb::Operand::REG_R10>(opcode, address);
+		test_reg_to_ip<edb::Operand::REG_R11>(opcode, address);
+		test_reg_to_ip<edb::Operand::REG_R12>(opcode, address);
+		test_reg_to_ip<edb::Operand::REG_R13>(opcode, address);
+		test_reg_to_ip<edb::Operand::REG_R14>(opcode, address);
+		test_reg_to_ip<edb::Operand::REG_R15>(opcode, address);
+	#endif
+		break;
+	case 18:
+		// [ESP] -> EIP
+		test_esp_add_0(opcode, address);
+		break;
+	case 19:
+		// [ESP + 4] -> EIP
+		test_esp_add_regx1(opcode, address);
+		break;
+	case 20:
+		// [ESP + 8] -> EIP
+		test_esp_add_regx2(opcode, address);
+		break;
+	case 21:
+		// [ESP - 4] -> EIP
+		test_esp_sub_regx1(opcode, address);
+		break;
+
+
+	case 22: test_deref_reg_to_ip<edb::Operand::REG_RAX>(opcode, address); break;
+	case 23: test_deref_reg_to_ip<edb::Operand::REG_RBX>(opcode, address); break;
+	case 24: test_deref_reg_to_ip<edb::Operand::REG_RCX>(opcode, address); break;
+	case 25: test_deref_reg_to_ip<edb::Operand::REG_RDX>(opcode, address); break;
+	case 26: test_deref_reg_to_ip<edb::Operand::REG_RBP>(opcode, address); break;
+	case 28: test_deref_reg_to_ip<edb::Operand::REG_RSI>(opcode, address); break;
+	case 29: test_deref_reg_to_ip<edb::Operand::REG_RDI>(opcode, address); break;
+	case 30: test_deref_reg_to_ip<edb::Operand::REG_R8>(opcode, address); break;
+	case 31: test_deref_reg_to_ip<edb::Operand::REG_R9>(opcode, address); break;
+	case 32: test_deref_reg_to_ip<edb::Operand::REG_R10>(opcode, address); break;
+	case 33: test_deref_reg_to_ip<edb::Operand::REG_R11>(opcode, address); break;
+	case 34: test_deref_reg_to_ip<edb::Operand::REG_R12>(opcode, address); break;
+	case 35: test_deref_reg_to_ip<edb::Operand::REG_R13>(opcode, address); break;
+	case 36: test_deref_reg_to_ip<edb::Operand::REG_R14>(opcode, address); break;
+	case 37: test_deref_reg_to_ip<edb::Operand::REG_R15>(opcode, address); break;
+	}
+}
+
+}
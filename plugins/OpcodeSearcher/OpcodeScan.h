@@ -0,0 +1,100 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef OPCODESCAN_20261014_H_
+#define OPCODESCAN_20261014_H_
+
+#include "IRegion.h"
+#include "Instruction.h"
+#include "Types.h"
+
+#include <QByteArray>
+#include <QList>
+#include <QString>
+#include <QVector>
+
+class QProgressBar;
+
+namespace OpcodeSearcher {
+
+// looks for the instructions which send execution to wherever a register or
+// stack slot points, <classtype> is one of the entries of the dialog's combo
+// box. <progress> may be null, for searches which nobody is watching.
+// ALL_CLASSES looks for every one of them at once, for OpcodeIndex, the
+// results then say which they were found for and have no text
+class OpcodeScan {
+public:
+	enum {
+		ALL_CLASSES  = 0,
+		ANY_REGISTER = 17  // every one of the register classes before it
+	};
+
+	struct Result {
+		edb::address_t address;
+		QString        text;
+		QByteArray     bytes;
+		int            classtype;
+	};
+
+public:
+	OpcodeScan(int classtype, QProgressBar *progress);
+
+public:
+	void run(const QList<IRegion::pointer> &regions);
+
+public:
+	// the classes ALL_CLASSES looks for, ANY_REGISTER is left out since it
+	// is just the register classes put together
+	static QList<int> indexed_classtypes();
+
+	// the text of a result for the instructions <bytes> at <address>
+	static QString result_text(const QByteArray &bytes, edb::address_t address);
+
+public:
+	QVector<Result> results;
+
+private:
+	// we currently only support opcodes sequences up to 8 bytes big
+	union OpcodeData {
+		quint32 dword;
+		quint64 qword;
+		quint8  data[sizeof(quint64)];
+	};
+
+	void test_esp_add_0(const OpcodeData &data, edb::address_t start_address);
+	void test_esp_add_regx1(const OpcodeData &data, edb::address_t start_address);
+	void test_esp_add_regx2(const OpcodeData &data, edb::address_t start_address);
+	void test_esp_sub_regx1(const OpcodeData &data, edb::address_t start_address);
+	void add_result(const OpcodeData &data, QList<edb::Instruction> instructions, edb::address_t rva);
+	void run_tests(int classtype, const OpcodeData &opcode, edb::address_t address);
+
+	template <edb::Operand::Register REG>
+	void test_reg_to_ip(const OpcodeData &data, edb::address_t start_address);
+
+	template <edb::Operand::Register REG>
+	void test_deref_reg_to_ip(const OpcodeData &data, edb::address_t start_address);
+
+private:
+	const int           classtype_;
+	QProgressBar *const progress_;
+	bool                first_byte_[256];
+};
+
+}
+
+#endif
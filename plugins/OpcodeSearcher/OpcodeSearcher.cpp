@@ -18,6 +18,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "OpcodeSearcher.h"
 #include "DialogOpcodes.h"
+#include "OpcodeScan.h"
 #include "edb.h"
 #include <QMenu>
 
@@ -67,6 +68,37 @@ void OpcodeSearcher::show_menu() {
 	dialog_->show();
 }
 
+//------------------------------------------------------------------------------
+// Name: run_benchmarks
+// Desc: the opcode search over all of <regions> for a register jump, for any
+//       register and for a return through the stack, which between them use
+//       every kind of test
+//------------------------------------------------------------------------------
+QList<BenchmarkResult> OpcodeSearcher::run_benchmarks(const QList<IRegion::pointer> &regions) {
+
+	// the combo box's "EAX -> EIP", "ANY REGISTER -> EIP" and "[ESP] -> EIP"
+	// (or RAX, RIP and so on)
+	static const int classtypes[] = { 1, 17, 18 };
+
+	const quint64 bytes = BenchmarkRun::bytes(regions);
+
+	BenchmarkRun run("DialogOpcodes::do_find", "matches");
+
+	for(std::size_t i = 0; i < sizeof(classtypes) / sizeof(classtypes[0]); ++i) {
+
+		run.start();
+
+		OpcodeScan scan(classtypes[i], 0);
+		scan.run(regions);
+
+		QVariantMap parameters;
+		parameters["classtype"] = classtypes[i];
+		run.finish(parameters, bytes, scan.results.size());
+	}
+
+	return run.results();
+}
+
 #if QT_VERSION < 0x050000
 Q_EXPORT_PLUGIN2(OpcodeSearcher, OpcodeSearcher)
 #endif
@@ -2,7 +2,8 @@
 include(../plugins.pri)
 
 # Input
-HEADERS += OpcodeSearcher.h DialogOpcodes.h
+HEADERS += OpcodeSearcher.h DialogOpcodes.h InstructionTemplate.h OpcodeIndex.h OpcodeScan.h TemplateScan.h
 FORMS += DialogOpcodes.ui
-SOURCES += OpcodeSearcher.cpp DialogOpcodes.cpp
+SOURCES += OpcodeSearcher.cpp DialogOpcodes.cpp InstructionTemplate.cpp OpcodeIndex.cpp OpcodeScan.cpp TemplateScan.cpp
+OTHER_FILES += OpcodeSearcher.json
 
@@ -0,0 +1,346 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "TemplateScan.h"
+#include "BasicBlock.h"
+#include "IAnalyzer.h"
+#include "InstructionLength.h"
+#include "edb.h"
+
+#include <QProgressBar>
+#include <algorithm>
+
+namespace OpcodeSearcher {
+
+namespace {
+
+// a match which has got as far as <step>, <budget> more instructions may go
+// by before one is it
+struct Partial {
+	const quint8 *start;
+	int           step;
+	int           budget;
+};
+
+//------------------------------------------------------------------------------
+// Name: starts_before
+// Desc:
+//------------------------------------------------------------------------------
+bool starts_before(const TemplateScan::Range &range, edb::address_t address) {
+	return range.start < address;
+}
+
+//------------------------------------------------------------------------------
+// Name: range_less
+// Desc:
+//------------------------------------------------------------------------------
+bool range_less(const TemplateScan::Range &lhs, const TemplateScan::Range &rhs) {
+	return lhs.start < rhs.start;
+}
+
+//------------------------------------------------------------------------------
+// Name: match_less
+// Desc:
+//------------------------------------------------------------------------------
+bool match_less(const TemplateScan::Match &lhs, const TemplateScan::Match &rhs) {
+	return lhs.address < rhs.address;
+}
+
+//------------------------------------------------------------------------------
+// Name: same_start
+// Desc:
+//------------------------------------------------------------------------------
+bool same_start(const TemplateScan::Match &lhs, const TemplateScan::Match &rhs) {
+	return lhs.address == rhs.address;
+}
+
+// is fed one instruction after another and keeps every match in progress,
+// at most one for each instruction a match could have started at. Each step
+// is taken by the first instruction which fits it
+class Matcher {
+public:
+	Matcher(const InstructionTemplate &pattern, const RegionScanner::Chunk &chunk, QVector<TemplateScan::Match> *matches) : pattern_(pattern), chunk_(chunk), matches_(matches) {
+	}
+
+public:
+	bool pending() const { return !partials_.isEmpty(); }
+	void reset()         { partials_.clear(); }
+
+public:
+	std::size_t feed(const quint8 *p, const quint8 *last, bool owned);
+
+private:
+	void advance(const edb::Instruction *inst, const quint8 *end);
+	void found(const quint8 *start, const quint8 *end);
+
+private:
+	const InstructionTemplate &        pattern_;
+	const RegionScanner::Chunk &       chunk_;
+	QVector<TemplateScan::Match> *const matches_;
+	QVector<Partial>                   partials_;
+};
+
+//------------------------------------------------------------------------------
+// Name: feed
+// Desc: the instruction at <p>, which may start a match if it is <owned>.
+//       Returns its size, 0 if it isn't a valid instruction
+//------------------------------------------------------------------------------
+std::size_t Matcher::feed(const quint8 *p, const quint8 *last, bool owned) {
+
+	edb::length::Flow flow = edb::length::FLOW_NONE;
+	std::size_t size       = edb::instruction_length(p, last - p, &flow);
+
+	bool wanted = (size == 0) || (owned && pattern_.may_match(0, flow));
+	for(int i = 0; !wanted && i < partials_.size(); ++i) {
+		wanted = pattern_.may_match(partials_[i].step, flow);
+	}
+
+	if(!wanted) {
+		// no step can be this one, so it only counts against the matches
+		advance(0, p + size);
+		return size;
+	}
+
+	const edb::Instruction inst(p, last, chunk_.address + (p - chunk_.data.constData()), std::nothrow);
+	if(!inst) {
+		reset();
+		return 0;
+	}
+
+	size = inst.size();
+	advance(&inst, p + size);
+
+	if(owned && pattern_.matches(0, inst)) {
+		if(pattern_.size() == 1) {
+			found(p, p + size);
+		} else {
+			const Partial partial = { p, 1, pattern_.gap(1) };
+			partials_.push_back(partial);
+		}
+	}
+
+	return size;
+}
+
+//------------------------------------------------------------------------------
+// Name: advance
+// Desc: moves every match in progress past an instruction ending at <end>,
+//       <inst> is null if it is known not to fit any of their steps
+//------------------------------------------------------------------------------
+void Matcher::advance(const edb::Instruction *inst, const quint8 *end) {
+
+	int kept = 0;
+	for(int i = 0; i < partials_.size(); ++i) {
+		Partial partial = partials_[i];
+
+		if(inst && pattern_.matches(partial.step, *inst)) {
+			if(++partial.step == pattern_.size()) {
+				found(partial.start, end);
+				continue;
+			}
+			partial.budget = pattern_.gap(partial.step);
+		} else if(partial.budget-- == 0) {
+			continue;
+		}
+
+		partials_[kept++] = partial;
+	}
+
+	partials_.resize(kept);
+}
+
+//------------------------------------------------------------------------------
+// Name: found
+// Desc:
+//------------------------------------------------------------------------------
+void Matcher::found(const quint8 *start, const quint8 *end) {
+	TemplateScan::Match match;
+	match.address = chunk_.address + (start - chunk_.data.constData());
+	match.bytes   = QByteArray(reinterpret_cast<const char *>(start), end - start);
+	matches_->push_back(match);
+}
+
+}
+
+//------------------------------------------------------------------------------
+// Name: TemplateScan
+// Desc:
+//------------------------------------------------------------------------------
+TemplateScan::TemplateScan(const InstructionTemplate &pattern, QProgressBar *progress) : pattern_(pattern), progress_(progress) {
+}
+
+//------------------------------------------------------------------------------
+// Name: add_code
+// Desc: searches <region> by the basic blocks the analyzer found in it, if
+//       it has been analyzed. Has to be called before run
+//------------------------------------------------------------------------------
+void TemplateScan::add_code(const IRegion::pointer &region) {
+
+	IAnalyzer *const analyzer = edb::v1::analyzer();
+	if(!analyzer) {
+		return;
+	}
+
+	const IAnalyzer::BasicBlockMap basic_blocks = analyzer->basic_blocks(region);
+	if(basic_blocks.isEmpty()) {
+		return;
+	}
+
+	for(IAnalyzer::BasicBlockMap::const_iterator it = basic_blocks.begin(); it != basic_blocks.end(); ++it) {
+		if(!it.value().empty()) {
+			const Range block = { it.value().first_address(), it.value().last_address() };
+			blocks_.push_back(block);
+		}
+	}
+
+	std::sort(blocks_.begin(), blocks_.end(), range_less);
+
+	const Range range = { region->start(), region->end() };
+	known_.push_back(range);
+}
+
+//------------------------------------------------------------------------------
+// Name: lookahead
+// Desc: enough for a match which starts at the end of a window, and for most
+//       blocks which do
+//------------------------------------------------------------------------------
+std::size_t TemplateScan::lookahead() const {
+	return qMax<std::size_t>(pattern_.max_span() * edb::length::MaxSize, 4096);
+}
+
+//------------------------------------------------------------------------------
+// Name: merge
+// Desc:
+//------------------------------------------------------------------------------
+void TemplateScan::merge(Result *result) {
+	Q_FOREACH(const Match &match, static_cast<List<Match> *>(result)->items) {
+		const OpcodeScan::Result r = { match.address, OpcodeScan::result_text(match.bytes, match.address), match.bytes, 0 };
+		results.push_back(r);
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: progress
+// Desc:
+//------------------------------------------------------------------------------
+void TemplateScan::progress(int percent) {
+	if(progress_) {
+		progress_->setValue(percent);
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: find_known
+// Desc: the region given to add_code which holds <address>, if any
+//------------------------------------------------------------------------------
+const TemplateScan::Range *TemplateScan::find_known(edb::address_t address) const {
+	Q_FOREACH(const Range &range, known_) {
+		if(address >= range.start && address < range.end) {
+			return &range;
+		}
+	}
+	return 0;
+}
+
+//------------------------------------------------------------------------------
+// Name: scan_blocks
+// Desc: the blocks which start in the window, followed into the blocks right
+//       after them while a match is in progress. A block longer than the
+//       lookahead allows is only searched as far as the lookahead goes
+//------------------------------------------------------------------------------
+void TemplateScan::scan_blocks(const RegionScanner::Chunk &chunk, QVector<Match> *matches) const {
+
+	const quint8 *const  first      = chunk.data.constData();
+	const edb::address_t window_end = chunk.address + chunk.size;
+	const edb::address_t data_end   = chunk.address + chunk.data.size();
+
+	Matcher matcher(pattern_, chunk, matches);
+
+	edb::address_t previous_end = 0;
+
+	for(QVector<Range>::const_iterator block = std::lower_bound(blocks_.begin(), blocks_.end(), chunk.address, starts_before); block != blocks_.end() && block->start < data_end; ++block) {
+
+		const bool owned = block->start < window_end;
+
+		// a match can't reach across a gap between blocks
+		if(block->start != previous_end) {
+			matcher.reset();
+		}
+
+		if(!owned && !matcher.pending()) {
+			break;
+		}
+
+		const quint8 *p         = first + (block->start - chunk.address);
+		const quint8 *const end = first + (qMin(block->end, data_end) - chunk.address);
+
+		while(p < end && (owned || matcher.pending())) {
+			const std::size_t size = matcher.feed(p, end, owned);
+			if(size == 0) {
+				break;
+			}
+			p += size;
+		}
+
+		previous_end = (p == first + (block->end - chunk.address)) ? block->end : 0;
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: scan_linear
+// Desc: decodes from the start of the window, and on past its end while a
+//       match is in progress. Bytes which don't decode are stepped over one
+//       at a time
+//------------------------------------------------------------------------------
+void TemplateScan::scan_linear(const RegionScanner::Chunk &chunk, QVector<Match> *matches) const {
+
+	const quint8 *const first      = chunk.data.constData();
+	const quint8 *const window_end = first + chunk.size;
+	const quint8 *const last       = first + chunk.data.size();
+
+	Matcher matcher(pattern_, chunk, matches);
+
+	const quint8 *p = first;
+	while(p < last && (p < window_end || matcher.pending())) {
+		const std::size_t size = matcher.feed(p, last, p < window_end);
+		p += size ? size : 1;
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: scan
+// Desc: runs on a pool thread
+//------------------------------------------------------------------------------
+RegionScanner::Task::Result *TemplateScan::scan(const RegionScanner::Chunk &chunk) const {
+
+	List<Match> *const result = new List<Match>;
+
+	if(find_known(chunk.address)) {
+		scan_blocks(chunk, &result->items);
+	} else {
+		scan_linear(chunk, &result->items);
+	}
+
+	// overlapping blocks can find the same match twice
+	std::sort(result->items.begin(), result->items.end(), match_less);
+	result->items.erase(std::unique(result->items.begin(), result->items.end(), same_start), result->items.end());
+
+	return result;
+}
+
+}
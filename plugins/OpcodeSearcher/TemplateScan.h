@@ -0,0 +1,84 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef TEMPLATE_SCAN_20261014_H_
+#define TEMPLATE_SCAN_20261014_H_
+
+#include "InstructionTemplate.h"
+#include "OpcodeScan.h"
+#include "RegionScanner.h"
+#include <QVector>
+
+class QProgressBar;
+
+namespace OpcodeSearcher {
+
+// finds the runs of instructions an InstructionTemplate describes. Each
+// window is decoded one instruction after another and the instructions are
+// fed to all of the partial matches at once, so the template costs the same
+// however many places it could start. The length decoder says where
+// instructions are, and whether they can jump, call or return, so most of
+// them are not decoded in full unless a step could be them.
+//
+// Regions which were given to add_code and which the analyzer knows the
+// basic blocks of are searched only in those blocks, anywhere else is swept
+// from the start of each window. Matches belong to the window they start in
+// and may end in the lookahead past it
+class TemplateScan : public RegionScanner::Task {
+public:
+	// <progress> may be null, for searches which nobody is watching
+	TemplateScan(const InstructionTemplate &pattern, QProgressBar *progress);
+
+public:
+	void add_code(const IRegion::pointer &region);
+
+public:
+	virtual std::size_t lookahead() const;
+	virtual Result *scan(const RegionScanner::Chunk &chunk) const;
+	virtual void merge(Result *result);
+	virtual void progress(int percent);
+
+public:
+	QVector<OpcodeScan::Result> results;
+
+public:
+	struct Match {
+		edb::address_t address;
+		QByteArray     bytes;
+	};
+
+	struct Range {
+		edb::address_t start;
+		edb::address_t end;
+	};
+
+private:
+	const Range *find_known(edb::address_t address) const;
+	void scan_blocks(const RegionScanner::Chunk &chunk, QVector<Match> *matches) const;
+	void scan_linear(const RegionScanner::Chunk &chunk, QVector<Match> *matches) const;
+
+private:
+	const InstructionTemplate pattern_;
+	QProgressBar *const       progress_;
+	QVector<Range>            known_;  // regions searched by their blocks
+	QVector<Range>            blocks_; // sorted
+};
+
+}
+
+#endif
@@ -0,0 +1,186 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "PatchWidget.h"
+#include "IDebugger.h"
+#include "IRegion.h"
+#include "MemoryRegions.h"
+#include "PatchJournal.h"
+#include "edb.h"
+#include <QFile>
+#include <QFileDialog>
+#include <QFileInfo>
+#include <QMessageBox>
+#include <QTableWidgetItem>
+
+#include "ui_PatchWidget.h"
+
+namespace Patches {
+
+namespace {
+
+enum {
+	COLUMN_ADDRESS,
+	COLUMN_MODULE,
+	COLUMN_ORIGINAL,
+	COLUMN_PATCHED,
+	COLUMN_COUNT
+};
+
+}
+
+//------------------------------------------------------------------------------
+// Name: PatchWidget
+// Desc:
+//------------------------------------------------------------------------------
+PatchWidget::PatchWidget(QWidget *parent, Qt::WindowFlags f) : QWidget(parent, f), ui(new Ui::PatchWidget) {
+	ui->setupUi(this);
+	refresh();
+}
+
+//------------------------------------------------------------------------------
+// Name: ~PatchWidget
+// Desc:
+//------------------------------------------------------------------------------
+PatchWidget::~PatchWidget() {
+	delete ui;
+}
+
+//------------------------------------------------------------------------------
+// Name: on_btnUndo_clicked
+// Desc:
+//------------------------------------------------------------------------------
+void PatchWidget::on_btnUndo_clicked() {
+	if(!edb::v1::patch_journal().undo()) {
+		QMessageBox::warning(this, tr("Patches"), tr("Some of the bytes couldn't be put back."));
+	}
+	edb::v1::update_ui();
+}
+
+//------------------------------------------------------------------------------
+// Name: on_btnRedo_clicked
+// Desc:
+//------------------------------------------------------------------------------
+void PatchWidget::on_btnRedo_clicked() {
+	if(!edb::v1::patch_journal().redo()) {
+		QMessageBox::warning(this, tr("Patches"), tr("Some of the bytes couldn't be written."));
+	}
+	edb::v1::update_ui();
+}
+
+//------------------------------------------------------------------------------
+// Name: on_btnExport_clicked
+// Desc:
+//------------------------------------------------------------------------------
+void PatchWidget::on_btnExport_clicked() {
+
+	const QString filename = QFileDialog::getSaveFileName(this, tr("Export Patches"), QString(), tr("Diff Files (*.diff);;All Files (*)"));
+	if(filename.isEmpty()) {
+		return;
+	}
+
+	QFile file(filename);
+	if(!file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text) || file.write(edb::v1::patch_journal().diff().toUtf8()) == -1) {
+		QMessageBox::warning(this, tr("Export Patches"), file.errorString());
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: on_btnSave_clicked
+// Desc: the changes are written into a copy of the file the selected one came
+//       from, or the main executable if none is selected
+//------------------------------------------------------------------------------
+void PatchWidget::on_btnSave_clicked() {
+
+	IRegion::pointer region;
+
+	const QList<QTableWidgetItem *> selected = ui->tableWidget->selectedItems();
+	if(!selected.isEmpty()) {
+		const QTableWidgetItem *const item = ui->tableWidget->item(selected.first()->row(), COLUMN_ADDRESS);
+		region = edb::v1::memory_regions().find_region(item->data(Qt::UserRole).toULongLong());
+	} else {
+		region = edb::v1::primary_code_region();
+	}
+
+	if(!region || region->name().isEmpty() || !QFile::exists(region->name())) {
+		QMessageBox::information(this, tr("Apply Patches To File"), tr("The patched memory wasn't mapped from a file."));
+		return;
+	}
+
+	const QString module   = region->name();
+	const QString filename = QFileDialog::getSaveFileName(this, tr("Apply Patches To File"), module + QLatin1String(".patched"));
+	if(filename.isEmpty()) {
+		return;
+	}
+
+	int count;
+	QString error;
+	if(!edb::v1::patch_journal().save_to_file(module, filename, &count, &error)) {
+		QMessageBox::warning(this, tr("Apply Patches To File"), error);
+		return;
+	}
+
+	edb::v1::set_status(tr("%1 bytes of %2 patched").arg(count).arg(QFileInfo(filename).fileName()));
+}
+
+//------------------------------------------------------------------------------
+// Name: on_tableWidget_cellDoubleClicked
+// Desc:
+//------------------------------------------------------------------------------
+void PatchWidget::on_tableWidget_cellDoubleClicked(int row, int column) {
+	Q_UNUSED(column);
+	edb::v1::jump_to_address(ui->tableWidget->item(row, COLUMN_ADDRESS)->data(Qt::UserRole).toULongLong());
+}
+
+//------------------------------------------------------------------------------
+// Name: refresh
+// Desc: called whenever the journal changes
+//------------------------------------------------------------------------------
+void PatchWidget::refresh() {
+
+	const PatchJournal &journal                = edb::v1::patch_journal();
+	const QVector<PatchJournal::Patch> changes = journal.changes();
+
+	ui->tableWidget->setRowCount(changes.size());
+
+	for(int i = 0; i < changes.size(); ++i) {
+		const PatchJournal::Patch &patch = changes[i];
+
+		QTableWidgetItem *const address = new QTableWidgetItem(edb::v1::format_pointer(patch.address));
+		address->setData(Qt::UserRole, static_cast<qulonglong>(patch.address));
+
+		QString module;
+		if(const IRegion::pointer region = edb::v1::memory_regions().find_region(patch.address)) {
+			module = QFileInfo(region->name()).fileName();
+		}
+
+		ui->tableWidget->setItem(i, COLUMN_ADDRESS, address);
+		ui->tableWidget->setItem(i, COLUMN_MODULE, new QTableWidgetItem(module));
+		ui->tableWidget->setItem(i, COLUMN_ORIGINAL, new QTableWidgetItem(edb::v1::format_bytes(patch.original)));
+		ui->tableWidget->setItem(i, COLUMN_PATCHED, new QTableWidgetItem(edb::v1::format_bytes(patch.bytes)));
+	}
+
+	ui->btnUndo->setEnabled(journal.can_undo());
+	ui->btnRedo->setEnabled(journal.can_redo());
+	ui->btnUndo->setToolTip(journal.undo_description());
+	ui->btnRedo->setToolTip(journal.redo_description());
+	ui->btnExport->setEnabled(!changes.isEmpty());
+	ui->btnSave->setEnabled(!changes.isEmpty());
+}
+
+}
@@ -0,0 +1,49 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef PATCHWIDGET_20261014_H_
+#define PATCHWIDGET_20261014_H_
+
+#include <QWidget>
+
+namespace Patches {
+
+namespace Ui { class PatchWidget; }
+
+class PatchWidget : public QWidget {
+	Q_OBJECT
+
+public:
+	PatchWidget(QWidget *parent = 0, Qt::WindowFlags f = 0);
+	virtual ~PatchWidget();
+
+public Q_SLOTS:
+	void on_btnUndo_clicked();
+	void on_btnRedo_clicked();
+	void on_btnExport_clicked();
+	void on_btnSave_clicked();
+	void on_tableWidget_cellDoubleClicked(int row, int column);
+	void refresh();
+
+private:
+	Ui::PatchWidget *const ui;
+};
+
+}
+
+#endif
@@ -0,0 +1,70 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Patches.h"
+#include "PatchJournal.h"
+#include "PatchWidget.h"
+#include "edb.h"
+#include <QDockWidget>
+#include <QMainWindow>
+#include <QMenu>
+
+namespace Patches {
+
+//------------------------------------------------------------------------------
+// Name: Patches
+// Desc:
+//------------------------------------------------------------------------------
+Patches::Patches() : QObject(0), menu_(0), patch_widget_(0) {
+}
+
+//------------------------------------------------------------------------------
+// Name: menu
+// Desc:
+//------------------------------------------------------------------------------
+QMenu *Patches::menu(QWidget *parent) {
+
+	Q_ASSERT(parent);
+
+	if(!menu_) {
+
+		if(QMainWindow *const main_window = qobject_cast<QMainWindow *>(edb::v1::debugger_ui)) {
+			patch_widget_ = new PatchWidget;
+
+			// it is named so that its state is saved in the GUI info
+			QDockWidget *const dock_widget = new QDockWidget(tr("Patches"), main_window);
+			dock_widget->setObjectName(QString::fromUtf8("Patches"));
+			dock_widget->setWidget(patch_widget_);
+
+			main_window->addDockWidget(Qt::RightDockWidgetArea, dock_widget);
+
+			menu_ = new QMenu(tr("Patches"), parent);
+			menu_->addAction(dock_widget->toggleViewAction());
+
+			connect(&edb::v1::patch_journal(), SIGNAL(changed()), patch_widget_, SLOT(refresh()));
+		}
+	}
+
+	return menu_;
+}
+
+#if QT_VERSION < 0x050000
+Q_EXPORT_PLUGIN2(Patches, Patches)
+#endif
+
+}
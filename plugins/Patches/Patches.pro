@@ -0,0 +1,7 @@
+
+include(../plugins.pri)
+
+# Input
+HEADERS += Patches.h PatchWidget.h
+FORMS += PatchWidget.ui
+SOURCES += Patches.cpp PatchWidget.cpp
@@ -0,0 +1,241 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "DialogPointerScanner.h"
+#include "edb.h"
+#include "MemoryRegions.h"
+#include <QFileInfo>
+#include <QHash>
+#include <QMessageBox>
+#include <QSet>
+#include <QVector>
+#include <algorithm>
+
+#include "ui_DialogPointerScanner.h"
+
+namespace PointerScanner {
+
+namespace {
+
+// bounds on the search, each level can multiply the paths many times over
+const int max_nodes  = 1000000;
+const int max_chains = 10000;
+
+// a slot on the way to the target, it holds a pointer which plus offset is
+// the address of its parent. The target itself has no parent
+struct Node {
+	edb::address_t address;
+	edb::address_t offset;
+	int            parent;
+};
+
+// a region of a module, chains have to start in one
+struct Module {
+	edb::address_t start;
+	edb::address_t end;
+	edb::address_t base; // the start of the module's first region
+	QString        name;
+};
+
+//------------------------------------------------------------------------------
+// Name: module_start_less
+// Desc:
+//------------------------------------------------------------------------------
+bool module_start_less(edb::address_t address, const Module &module) {
+	return address < module.start;
+}
+
+//------------------------------------------------------------------------------
+// Name: find_modules
+// Desc: the regions which are mappings of a file, in address order
+//------------------------------------------------------------------------------
+QVector<Module> find_modules(const QList<IRegion::pointer> &regions) {
+
+	QHash<QString, edb::address_t> bases;
+	Q_FOREACH(const IRegion::pointer &region, regions) {
+		const QString name = region->name();
+		if(!name.isEmpty() && !name.startsWith('[') && !bases.contains(name)) {
+			bases.insert(name, region->start());
+		}
+	}
+
+	QVector<Module> modules;
+	Q_FOREACH(const IRegion::pointer &region, regions) {
+		const QHash<QString, edb::address_t>::const_iterator it = bases.find(region->name());
+		if(it != bases.end()) {
+			const Module module = { region->start(), region->end(), it.value(), QFileInfo(region->name()).fileName() };
+			modules.push_back(module);
+		}
+	}
+
+	return modules;
+}
+
+//------------------------------------------------------------------------------
+// Name: find_module
+// Desc: the module <address> is in, or 0
+//------------------------------------------------------------------------------
+const Module *find_module(const QVector<Module> &modules, edb::address_t address) {
+
+	QVector<Module>::const_iterator it = std::upper_bound(modules.begin(), modules.end(), address, module_start_less);
+	if(it != modules.begin() && address < (it - 1)->end) {
+		return &*(it - 1);
+	}
+
+	return 0;
+}
+
+//------------------------------------------------------------------------------
+// Name: format_offset
+// Desc:
+//------------------------------------------------------------------------------
+QString format_offset(edb::address_t offset) {
+	return QString("0x%1").arg(offset, 0, 16);
+}
+
+}
+
+//------------------------------------------------------------------------------
+// Name: DialogPointerScanner
+// Desc:
+//------------------------------------------------------------------------------
+DialogPointerScanner::DialogPointerScanner(QWidget *parent) : QDialog(parent), ui(new Ui::DialogPointerScanner) {
+	ui->setupUi(this);
+	ui->progressBar->setValue(0);
+}
+
+//------------------------------------------------------------------------------
+// Name: ~DialogPointerScanner
+// Desc:
+//------------------------------------------------------------------------------
+DialogPointerScanner::~DialogPointerScanner() {
+	delete ui;
+}
+
+//------------------------------------------------------------------------------
+// Name: do_find
+// Desc: walks back from the target a level at a time, each level is the slots
+//       pointing no more than the offset limit below the last level. The map is
+//       built once and kept until the process's memory changes
+//------------------------------------------------------------------------------
+void DialogPointerScanner::do_find() {
+
+	edb::address_t target;
+	if(!edb::v1::eval_expression(ui->txtTarget->text(), &target)) {
+		return;
+	}
+
+	ui->listWidget->clear();
+
+	edb::v1::memory_regions().sync();
+	const QList<IRegion::pointer> regions = edb::v1::memory_regions().regions();
+
+	if(!map_.current()) {
+		map_.build(regions, ui->progressBar);
+	}
+
+	const QVector<Module> modules  = find_modules(regions);
+	const int             depth    = ui->spnDepth->value();
+	const edb::address_t  offset   = ui->spnOffset->value();
+
+	QVector<Node>        nodes;
+	QSet<edb::address_t> seen;
+	QVector<int>         chains;
+
+	const Node root = { target, 0, -1 };
+	nodes.push_back(root);
+	seen.insert(target);
+
+	int level_begin = 0;
+	int level_end   = 1;
+
+	for(int level = 1; level <= depth && level_begin != level_end && nodes.size() < max_nodes; ++level) {
+		for(int i = level_begin; i < level_end && nodes.size() < max_nodes; ++i) {
+
+			// chains end at the first module they reach
+			if(i != 0 && find_module(modules, nodes[i].address)) {
+				continue;
+			}
+
+			const edb::address_t address = nodes[i].address;
+
+			const PointerMap::Entry *first;
+			const PointerMap::Entry *last;
+			map_.find(address > offset ? address - offset : 0, address, &first, &last);
+
+			for(const PointerMap::Entry *entry = first; entry != last && nodes.size() < max_nodes; ++entry) {
+				if(seen.contains(entry->slot)) {
+					continue;
+				}
+
+				seen.insert(entry->slot);
+
+				const Node node = { entry->slot, address - entry->value, i };
+				nodes.push_back(node);
+
+				if(chains.size() < max_chains && find_module(modules, entry->slot)) {
+					chains.push_back(nodes.size() - 1);
+				}
+			}
+		}
+
+		level_begin = level_end;
+		level_end   = nodes.size();
+	}
+
+	// base first, then the offset to add after each dereference
+	Q_FOREACH(int n, chains) {
+		const Node   &base   = nodes[n];
+		const Module *module = find_module(modules, base.address);
+		Q_ASSERT(module);
+
+		QString text = QString("%1+%2").arg(module->name, format_offset(base.address - module->base));
+		for(int i = n; nodes[i].parent != -1; i = nodes[i].parent) {
+			text += QString(" -> +%1").arg(format_offset(nodes[i].offset));
+		}
+
+		QListWidgetItem *const item = new QListWidgetItem(text);
+		item->setData(Qt::UserRole, static_cast<qulonglong>(base.address));
+		ui->listWidget->addItem(item);
+	}
+
+	if(nodes.size() >= max_nodes || chains.size() >= max_chains) {
+		QMessageBox::information(this, tr("Search Limit Reached"), tr("Not every path to the target was followed, lowering the depth or maximum offset will narrow the search."));
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: on_btnFind_clicked
+// Desc:
+//------------------------------------------------------------------------------
+void DialogPointerScanner::on_btnFind_clicked() {
+	ui->btnFind->setEnabled(false);
+	ui->progressBar->setValue(0);
+	do_find();
+	ui->progressBar->setValue(100);
+	ui->btnFind->setEnabled(true);
+}
+
+//------------------------------------------------------------------------------
+// Name: on_listWidget_itemDoubleClicked
+// Desc: follows the base of the chain in the data view
+//------------------------------------------------------------------------------
+void DialogPointerScanner::on_listWidget_itemDoubleClicked(QListWidgetItem *item) {
+	edb::v1::dump_data(item->data(Qt::UserRole).toULongLong(), false);
+}
+
+}
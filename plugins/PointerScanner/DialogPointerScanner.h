@@ -0,0 +1,51 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef DIALOGPOINTERSCANNER_20261014_H_
+#define DIALOGPOINTERSCANNER_20261014_H_
+
+#include "PointerMap.h"
+#include <QDialog>
+
+class QListWidgetItem;
+
+namespace PointerScanner {
+
+namespace Ui { class DialogPointerScanner; }
+
+class DialogPointerScanner : public QDialog {
+	Q_OBJECT
+
+public:
+	DialogPointerScanner(QWidget *parent = 0);
+	virtual ~DialogPointerScanner();
+
+public Q_SLOTS:
+	void on_btnFind_clicked();
+	void on_listWidget_itemDoubleClicked(QListWidgetItem *item);
+
+private:
+	void do_find();
+
+private:
+	Ui::DialogPointerScanner *const ui;
+	PointerMap                      map_;
+};
+
+}
+
+#endif
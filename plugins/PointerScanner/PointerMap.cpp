@@ -0,0 +1,207 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "PointerMap.h"
+#include "edb.h"
+#include "IDebugger.h"
+#include "IProcess.h"
+#include "RegionScanner.h"
+#include <QProgressBar>
+#include <algorithm>
+#include <cstring>
+
+namespace PointerScanner {
+
+namespace {
+
+struct Range {
+	edb::address_t start;
+	edb::address_t end;
+};
+
+//------------------------------------------------------------------------------
+// Name: range_start_less
+// Desc:
+//------------------------------------------------------------------------------
+bool range_start_less(edb::address_t address, const Range &range) {
+	return address < range.start;
+}
+
+//------------------------------------------------------------------------------
+// Name: entry_less
+// Desc: by value, then by slot
+//------------------------------------------------------------------------------
+bool entry_less(const PointerMap::Entry &lhs, const PointerMap::Entry &rhs) {
+	return lhs.value < rhs.value || (lhs.value == rhs.value && lhs.slot < rhs.slot);
+}
+
+//------------------------------------------------------------------------------
+// Name: value_less
+// Desc:
+//------------------------------------------------------------------------------
+bool value_less(const PointerMap::Entry &entry, edb::address_t value) {
+	return entry.value < value;
+}
+
+//------------------------------------------------------------------------------
+// Name: less_value
+// Desc:
+//------------------------------------------------------------------------------
+bool less_value(edb::address_t value, const PointerMap::Entry &entry) {
+	return value < entry.value;
+}
+
+// collects the aligned slots of each window whose value is in one of the
+// regions. The scanning threads get their own copy of the region bounds, the
+// shared MemoryRegions lookup remembers its last hit and so isn't thread safe
+class PointerScan : public RegionScanner::Task {
+public:
+	PointerScan(const QVector<Range> &ranges, QVector<PointerMap::Entry> *entries, QProgressBar *progress) : ranges_(ranges), entries_(entries), progress_(progress) {
+	}
+
+public:
+	virtual Result *scan(const RegionScanner::Chunk &chunk) const {
+
+		List<PointerMap::Entry> *const result = new List<PointerMap::Entry>;
+
+		const edb::address_t lowest  = ranges_.first().start;
+		const edb::address_t highest = ranges_.last().end;
+
+		const quint8 *const first = chunk.data.constData();
+		const std::size_t   skip  = (sizeof(edb::address_t) - chunk.address % sizeof(edb::address_t)) % sizeof(edb::address_t);
+
+		for(std::size_t i = skip; i + sizeof(edb::address_t) <= chunk.size; i += sizeof(edb::address_t)) {
+
+			edb::address_t value;
+			std::memcpy(&value, first + i, sizeof(value));
+
+			// most values aren't anywhere near mapped memory
+			if(value < lowest || value >= highest) {
+				continue;
+			}
+
+			QVector<Range>::const_iterator it = std::upper_bound(ranges_.begin(), ranges_.end(), value, range_start_less);
+			if(it != ranges_.begin() && value < (it - 1)->end) {
+				const PointerMap::Entry entry = { value, chunk.address + i };
+				result->items.push_back(entry);
+			}
+		}
+
+		return result;
+	}
+
+	virtual void merge(Result *result) {
+		*entries_ += static_cast<List<PointerMap::Entry> *>(result)->items;
+	}
+
+	virtual void progress(int percent) {
+		progress_->setValue(percent);
+	}
+
+private:
+	const QVector<Range>              ranges_;
+	QVector<PointerMap::Entry> *const entries_;
+	QProgressBar               *const progress_;
+};
+
+}
+
+//------------------------------------------------------------------------------
+// Name: PointerMap
+// Desc:
+//------------------------------------------------------------------------------
+PointerMap::PointerMap() : generation_(0), built_(false) {
+}
+
+//------------------------------------------------------------------------------
+// Name: build
+// Desc: finds the pointers in the readable <regions> which point into any of
+//       them, <regions> has to be sorted by address
+//------------------------------------------------------------------------------
+void PointerMap::build(const QList<IRegion::pointer> &regions, QProgressBar *progress) {
+
+	clear();
+
+	IProcess *const process = edb::v1::debugger_core->process();
+	if(!process) {
+		return;
+	}
+
+	QVector<Range>          ranges;
+	QList<IRegion::pointer> scanned;
+
+	Q_FOREACH(const IRegion::pointer &region, regions) {
+		const Range range = { region->start(), region->end() };
+		ranges.push_back(range);
+
+		if(region->readable()) {
+			scanned.push_back(region);
+		}
+	}
+
+	if(ranges.isEmpty()) {
+		return;
+	}
+
+	PointerScan scan(ranges, &entries_, progress);
+	RegionScanner().run(scanned, &scan);
+
+	std::sort(entries_.begin(), entries_.end(), entry_less);
+
+	generation_ = process->memory_generation();
+	built_      = true;
+}
+
+//------------------------------------------------------------------------------
+// Name: clear
+// Desc:
+//------------------------------------------------------------------------------
+void PointerMap::clear() {
+	entries_.clear();
+	generation_ = 0;
+	built_      = false;
+}
+
+//------------------------------------------------------------------------------
+// Name: current
+// Desc: true if the map was built since the process's memory last changed.
+//       Where that can't be told it never is, so it is built every time
+//------------------------------------------------------------------------------
+bool PointerMap::current() const {
+
+	if(IProcess *const process = edb::v1::debugger_core->process()) {
+		return built_ && generation_ != 0 && generation_ == process->memory_generation();
+	}
+
+	return false;
+}
+
+//------------------------------------------------------------------------------
+// Name: find
+// Desc: the slots holding values from <low> up to and including <high> are in
+//       [*first, *last)
+//------------------------------------------------------------------------------
+void PointerMap::find(edb::address_t low, edb::address_t high, const Entry **first, const Entry **last) const {
+
+	Q_ASSERT(first);
+	Q_ASSERT(last);
+
+	*first = std::lower_bound(entries_.constBegin(), entries_.constEnd(), low, value_less);
+	*last  = std::upper_bound(*first, entries_.constEnd(), high, less_value);
+}
+
+}
@@ -0,0 +1,68 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef POINTERMAP_20261014_H_
+#define POINTERMAP_20261014_H_
+
+#include "IRegion.h"
+#include "Types.h"
+#include <QList>
+#include <QVector>
+
+class QProgressBar;
+
+namespace PointerScanner {
+
+// every pointer in the process, that is every aligned slot holding a value
+// which lands in a mapped region. The regions are scanned in parallel and the
+// pointers kept in one flat array sorted by value, so the slots which point
+// into any range are found with a binary search.
+//
+// Typical usage:
+//
+//     PointerMap map;
+//     map.build(regions, progress);
+//
+//     const PointerMap::Entry *first;
+//     const PointerMap::Entry *last;
+//     map.find(address - max_offset, address, &first, &last);
+class PointerMap {
+public:
+	struct Entry {
+		edb::address_t value;
+		edb::address_t slot;
+	};
+
+public:
+	PointerMap();
+
+public:
+	void build(const QList<IRegion::pointer> &regions, QProgressBar *progress);
+	void clear();
+	bool current() const;
+	void find(edb::address_t low, edb::address_t high, const Entry **first, const Entry **last) const;
+	int size() const { return entries_.size(); }
+
+private:
+	QVector<Entry> entries_;
+	quint64        generation_; // of the process's memory when built, 0 if it can't be told
+	bool           built_;
+};
+
+}
+
+#endif
@@ -0,0 +1,7 @@
+include(../plugins.pri)
+
+# Input
+HEADERS += PointerScanner.h DialogPointerScanner.h PointerMap.h
+FORMS += DialogPointerScanner.ui
+SOURCES += PointerScanner.cpp DialogPointerScanner.cpp PointerMap.cpp
+OTHER_FILES += PointerScanner.json
@@ -29,9 +29,13 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <QDesktopServices>
 #include <QDir>
 #include <QFileInfo>
+#include <QHash>
 #include <QHostAddress>
+#include <QMutexLocker>
+#include <QRunnable>
 #include <QStringList>
 #include <QStringListModel>
+#include <QTextStream>
 #include <QUrl>
 
 #if defined(Q_OS_LINUX) || defined(Q_OS_FREEBSD) || defined(Q_OS_OPENBSD)
@@ -39,6 +43,13 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <arpa/inet.h>
 #endif
 
+#if defined(Q_OS_LINUX)
+#include <climits>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
 #include "ui_DialogProcessProperties.h"
 
 namespace ProcessProperties {
@@ -60,14 +71,15 @@ QString size_to_string(size_t n) {
 
 #if defined(Q_OS_LINUX)
 //------------------------------------------------------------------------------
-// Name: tcp_socket_prcoessor
-// Desc:
+// Name: inet_socket_entry
+// Desc: an entry of /proc/net/tcp or /proc/net/udp
 //------------------------------------------------------------------------------
-bool tcp_socket_prcoessor(QString *symlink, int sock, const QStringList &lst) {
+bool inet_socket_entry(const char *protocol, const QStringList &lst, int *inode, QString *description) {
 
-	Q_ASSERT(symlink);
+	Q_ASSERT(inode);
+	Q_ASSERT(description);
 
-	if(lst.size() >= 13) {
+	if(lst.size() >= 14) {
 
 		bool ok;
 		const quint32 local_address = ntohl(lst[1].toUInt(&ok, 16));
@@ -78,20 +90,15 @@ bool tcp_socket_prcoessor(QString *symlink, int sock, const QStringList &lst) {
 				if(ok) {
 					const quint16 remote_port = lst[4].toUInt(&ok, 16);
 					if(ok) {
-						const quint8 state = lst[5].toUInt(&ok, 16);
-						Q_UNUSED(state);
+						*inode = lst[13].toUInt(&ok, 10);
 						if(ok) {
-							const int inode = lst[13].toUInt(&ok, 10);
-							if(ok) {
-								if(inode == sock) {
-									*symlink = QString("TCP: %1:%2 -> %3:%4")
-										.arg(QHostAddress(local_address).toString())
-										.arg(local_port)
-										.arg(QHostAddress(remote_address).toString())
-										.arg(remote_port);
-										return true;
-								}
-							}
+							*description = QString("%1: %2:%3 -> %4:%5")
+								.arg(protocol)
+								.arg(QHostAddress(local_address).toString())
+								.arg(local_port)
+								.arg(QHostAddress(remote_address).toString())
+								.arg(remote_port);
+							return true;
 						}
 					}
 				}
@@ -102,76 +109,50 @@ bool tcp_socket_prcoessor(QString *symlink, int sock, const QStringList &lst) {
 }
 
 //------------------------------------------------------------------------------
-// Name: udp_socket_processor
+// Name: tcp_socket_entry
 // Desc:
 //------------------------------------------------------------------------------
-bool udp_socket_processor(QString *symlink, int sock, const QStringList &lst) {
-
-	Q_ASSERT(symlink);
-
-	if(lst.size() >= 13) {
-
-		bool ok;
-		const quint32 local_address = ntohl(lst[1].toUInt(&ok, 16));
-		if(ok) {
-			const quint16 local_port = lst[2].toUInt(&ok, 16);
-			if(ok) {
-				const quint32 remote_address = ntohl(lst[3].toUInt(&ok, 16));
-				if(ok) {
-					const quint16 remote_port = lst[4].toUInt(&ok, 16);
-					if(ok) {
-						const quint8 state = lst[5].toUInt(&ok, 16);
-						Q_UNUSED(state);
-						if(ok) {
-							const int inode = lst[13].toUInt(&ok, 10);
-							if(ok) {
-								if(inode == sock) {
-									*symlink = QString("UDP: %1:%2 -> %3:%4")
-										.arg(QHostAddress(local_address).toString())
-										.arg(local_port)
-										.arg(QHostAddress(remote_address).toString())
-										.arg(remote_port);
-										return true;
-								}
-							}
-						}
-					}
-				}
-			}
-		}
-	}
-	return false;
+bool tcp_socket_entry(const QStringList &lst, int *inode, QString *description) {
+	return inet_socket_entry("TCP", lst, inode, description);
 }
 
 //------------------------------------------------------------------------------
-// Name: unix_socket_processor
+// Name: udp_socket_entry
 // Desc:
 //------------------------------------------------------------------------------
-bool unix_socket_processor(QString *symlink, int sock, const QStringList &lst) {
+bool udp_socket_entry(const QStringList &lst, int *inode, QString *description) {
+	return inet_socket_entry("UDP", lst, inode, description);
+}
 
-	Q_ASSERT(symlink);
+//------------------------------------------------------------------------------
+// Name: unix_socket_entry
+// Desc: an entry of /proc/net/unix
+//------------------------------------------------------------------------------
+bool unix_socket_entry(const QStringList &lst, int *inode, QString *description) {
 
-	if(lst.size() >= 6) {
+	Q_ASSERT(inode);
+	Q_ASSERT(description);
+
+	if(lst.size() >= 7) {
 		bool ok;
-		const int inode = lst[6].toUInt(&ok, 10);
+		*inode = lst[6].toUInt(&ok, 10);
 		if(ok) {
-			if(inode == sock) {
-				*symlink = QString("UNIX [%1]").arg(lst[0]);
-				return true;
-			}
+			*description = QString("UNIX [%1]").arg(lst[0]);
+			return true;
 		}
 	}
 	return false;
 }
 
 //------------------------------------------------------------------------------
-// Name: process_socket_file
-// Desc:
+// Name: read_socket_file
+// Desc: adds what each socket in one of the /proc/net tables is to <sockets>,
+//       by inode. The ones already there are left alone
 //------------------------------------------------------------------------------
 template <class F>
-QString process_socket_file(const QString &filename, QString *symlink, int sock, F fp) {
+void read_socket_file(const QString &filename, QHash<int, QString> *sockets, F fp) {
 
-	Q_ASSERT(symlink);
+	Q_ASSERT(sockets);
 
 	QFile net(filename);
 	net.open(QIODevice::ReadOnly | QIODevice::Text);
@@ -188,79 +169,146 @@ QString process_socket_file(const QString &filename, QString *symlink, int sock,
 		// a null string means end of file (but not an empty string!)
 		while(!line.isNull()) {
 
-			QString lline(line);
-			const QStringList lst = lline.replace(":", " ").split(" ", QString::SkipEmptyParts);
+			const QStringList lst = line.replace(":", " ").split(" ", QString::SkipEmptyParts);
 
-			if(fp(symlink, sock, lst)) {
-				break;
+			int inode;
+			QString description;
+			if(fp(lst, &inode, &description) && !sockets->contains(inode)) {
+				sockets->insert(inode, description);
 			}
 
 			line = in.readLine();
 		}
 	}
-	return *symlink;
 }
 
 //------------------------------------------------------------------------------
-// Name: process_socket_tcp
-// Desc:
+// Name: read_sockets
+// Desc: every socket the system knows of, read once up front rather than
+//       once per socket handle
 //------------------------------------------------------------------------------
-QString process_socket_tcp(QString *symlink) {
-
-	Q_ASSERT(symlink);
-
-	const QString socket_info(symlink->mid(symlink->indexOf("socket:[")));
-	const int socket_number = socket_info.mid(8).remove("]").toUInt();
-
-	return process_socket_file("/proc/net/tcp", symlink, socket_number, tcp_socket_prcoessor);
+QHash<int, QString> read_sockets() {
+	QHash<int, QString> sockets;
+	read_socket_file("/proc/net/tcp", &sockets, tcp_socket_entry);
+	read_socket_file("/proc/net/udp", &sockets, udp_socket_entry);
+	read_socket_file("/proc/net/unix", &sockets, unix_socket_entry);
+	return sockets;
 }
 
 //------------------------------------------------------------------------------
-// Name: process_socket_unix
+// Name: file_type
 // Desc:
 //------------------------------------------------------------------------------
-QString process_socket_unix(QString *symlink) {
+QString file_type(const QString &filename) {
 
-	Q_ASSERT(symlink);
+	if(filename.startsWith("socket:")) {
+		return QT_TRANSLATE_NOOP("DialogProcessProperties", "Socket");
+	}
 
-	const QString socket_info(symlink->mid(symlink->indexOf("socket:[")));
-	const int socket_number = socket_info.mid(8).remove("]").toUInt();
+	if(filename.startsWith("pipe:")) {
+		return QT_TRANSLATE_NOOP("DialogProcessProperties", "Pipe");
+	}
 
-	return process_socket_file("/proc/net/unix", symlink, socket_number, unix_socket_processor);
+	return QT_TRANSLATE_NOOP("DialogProcessProperties", "File");
 }
 
-//------------------------------------------------------------------------------
-// Name: process_socket_udp
-// Desc:
-//------------------------------------------------------------------------------
-QString process_socket_udp(QString *symlink) {
-
-	Q_ASSERT(symlink);
+// walks /proc/<pid>/fd on the dialog's pool, with a readlink per handle and
+// nothing else, and hands the handles to the dialog a batch at a time
+class ListHandles : public QRunnable {
+public:
+	ListHandles(DialogProcessProperties *dialog, edb::pid_t pid, int request) : dialog_(dialog), pid_(pid), request_(request) {
+	}
 
-	const QString socket_info(symlink->mid(symlink->indexOf("socket:[")));
-	const int socket_number = socket_info.mid(8).remove("]").toUInt();
+public:
+	virtual void run();
 
-	return process_socket_file("/proc/net/udp", symlink, socket_number, udp_socket_processor);
-}
+private:
+	DialogProcessProperties *const dialog_;
+	const edb::pid_t               pid_;
+	const int                      request_;
+};
 
 //------------------------------------------------------------------------------
-// Name: file_type
+// Name: run
 // Desc:
 //------------------------------------------------------------------------------
-QString file_type(const QString &filename) {
-	const QFileInfo info(filename);
-	const QString basename(info.completeBaseName());
+void ListHandles::run() {
 
-	if(basename.startsWith("socket:")) {
-		return QT_TRANSLATE_NOOP("DialogProcessProperties", "Socket");
+	static const int BATCH_SIZE = 1024;
+
+	DIR *const dir = ::opendir(QString("/proc/%1/fd").arg(pid_).toLocal8Bit().constData());
+	if(!dir) {
+		return;
 	}
 
-	if(basename.startsWith("pipe:")) {
-		return QT_TRANSLATE_NOOP("DialogProcessProperties", "Pipe");
+	const QHash<int, QString> sockets = read_sockets();
+
+	QVector<HandlesModel::Item> batch;
+	batch.reserve(BATCH_SIZE);
+
+	while(const struct dirent *const entry = ::readdir(dir)) {
+
+		bool ok;
+		const int fd = QString::fromLatin1(entry->d_name).toInt(&ok);
+		if(!ok) {
+			continue;
+		}
+
+		char target[PATH_MAX];
+		const ssize_t n = ::readlinkat(::dirfd(dir), entry->d_name, target, sizeof(target));
+		if(n < 0) {
+			continue;
+		}
+
+		HandlesModel::Item item;
+		item.fd   = fd;
+		item.name = QString::fromLocal8Bit(target, n);
+		item.type = file_type(item.name);
+
+		if(item.name.startsWith("socket:[")) {
+			const int inode = item.name.mid(8, item.name.size() - 9).toInt();
+			QHash<int, QString>::const_iterator it = sockets.find(inode);
+			if(it != sockets.end()) {
+				item.name = it.value();
+			}
+		} else if(item.name.startsWith("pipe:")) {
+			item.name = QT_TRANSLATE_NOOP("DialogProcessProperties", "FIFO");
+		}
+
+		batch.push_back(item);
+
+		if(batch.size() == BATCH_SIZE) {
+			if(!dialog_->add_handles(batch, request_)) {
+				break;
+			}
+			batch.clear();
+		}
 	}
 
-	return QT_TRANSLATE_NOOP("DialogProcessProperties", "File");
+	::closedir(dir);
+
+	dialog_->add_handles(batch, request_);
 }
+
+// reads /proc/<pid>/environ on the dialog's pool
+class ReadEnvironment : public QRunnable {
+public:
+	ReadEnvironment(DialogProcessProperties *dialog, edb::pid_t pid, int request) : dialog_(dialog), pid_(pid), request_(request) {
+	}
+
+public:
+	virtual void run() {
+		QFile proc_environ(QString("/proc/%1/environ").arg(pid_));
+		if(proc_environ.open(QIODevice::ReadOnly)) {
+			QMetaObject::invokeMethod(dialog_, "environment_loaded", Qt::QueuedConnection, Q_ARG(QByteArray, proc_environ.readAll()), Q_ARG(int, request_));
+		}
+	}
+
+private:
+	DialogProcessProperties *const dialog_;
+	const edb::pid_t               pid_;
+	const int                      request_;
+};
 #endif
 
 }
@@ -272,7 +320,7 @@ QString file_type(const QString &filename) {
 // Name: DialogProcessProperties
 // Desc:
 //------------------------------------------------------------------------------
-DialogProcessProperties::DialogProcessProperties(QWidget *parent) : QDialog(parent), ui(new Ui::DialogProcessProperties) {
+DialogProcessProperties::DialogProcessProperties(QWidget *parent) : QDialog(parent), ui(new Ui::DialogProcessProperties), environment_request_(0), handles_request_(0) {
 	ui->setupUi(this);
 #if QT_VERSION >= 0x050000
 	ui->tableModules->horizontalHeader()->setSectionResizeMode(QHeaderView::ResizeToContents);
@@ -291,6 +339,14 @@ DialogProcessProperties::DialogProcessProperties(QWidget *parent) : QDialog(pare
 	threads_filter_->setFilterCaseSensitivity(Qt::CaseInsensitive);
 	
 	ui->threadTable->setModel(threads_filter_);
+
+	handles_model_  = new HandlesModel(this);
+	handles_filter_ = new QSortFilterProxyModel(this);
+
+	handles_filter_->setSourceModel(handles_model_);
+	ui->tableHandles->setModel(handles_filter_);
+
+	pool_.setMaxThreadCount(2);
 }
 
 //------------------------------------------------------------------------------
@@ -298,6 +354,16 @@ DialogProcessProperties::DialogProcessProperties(QWidget *parent) : QDialog(pare
 // Desc:
 //------------------------------------------------------------------------------
 DialogProcessProperties::~DialogProcessProperties() {
+
+	// stop what is still being read, whatever it already posted is dropped
+	// along with the dialog
+	{
+		QMutexLocker locker(&lock_);
+		++environment_request_;
+		++handles_request_;
+	}
+	pool_.waitForDone();
+
 	delete ui;
 }
 
@@ -345,7 +411,7 @@ void DialogProcessProperties::updateModulePage() {
 	ui->tableModules->clearContents();
 	ui->tableModules->setRowCount(0);
 	if(edb::v1::debugger_core) {
-		const QList<Module> modules = edb::v1::debugger_core->loaded_modules();
+		const QList<Module> modules = edb::v1::loaded_modules();
 		ui->tableModules->setSortingEnabled(false);
 		Q_FOREACH(const Module &m, modules) {
 			const int row = ui->tableModules->rowCount();
@@ -397,9 +463,48 @@ void DialogProcessProperties::on_txtSearchEnvironment_textChanged(const QString
 }
 
 //------------------------------------------------------------------------------
-// Name: updateEnvironmentPage
+// Name: updateEnvironment
+// Desc: starts reading the environment, the page is filled in once it's read
+//------------------------------------------------------------------------------
+void DialogProcessProperties::updateEnvironment() {
+
+	environment_.clear();
+	updateEnvironmentPage(ui->txtSearchEnvironment->text());
+
+#ifdef Q_OS_LINUX
+	if(IProcess *process = edb::v1::debugger_core->process()) {
+		int request;
+		{
+			QMutexLocker locker(&lock_);
+			request = ++environment_request_;
+		}
+
+		pool_.start(new ReadEnvironment(this, process->pid(), request));
+	}
+#endif
+}
+
+//------------------------------------------------------------------------------
+// Name: environment_loaded
 // Desc:
 //------------------------------------------------------------------------------
+void DialogProcessProperties::environment_loaded(const QByteArray &environment, int request) {
+
+	{
+		QMutexLocker locker(&lock_);
+		if(request != environment_request_) {
+			return;
+		}
+	}
+
+	environment_ = environment;
+	updateEnvironmentPage(ui->txtSearchEnvironment->text());
+}
+
+//------------------------------------------------------------------------------
+// Name: updateEnvironmentPage
+// Desc: shows the environment last read, filtering doesn't read it again
+//------------------------------------------------------------------------------
 void DialogProcessProperties::updateEnvironmentPage(const QString &filter) {
 	// tableEnvironment
 
@@ -409,93 +514,132 @@ void DialogProcessProperties::updateEnvironmentPage(const QString &filter) {
 
 	const QString lower_filter = filter.toLower();
 
-#ifdef Q_OS_LINUX
-	if(IProcess *process = edb::v1::debugger_core->process()) {
-		QFile proc_environ(QString("/proc/%1/environ").arg(process->pid()));
-		if(proc_environ.open(QIODevice::ReadOnly)) {
-			QByteArray env = proc_environ.readAll();
-			char *p = env.data();
-			char *ptr = p;
-			while(ptr != p + env.size()) {
-				const QString env = QString::fromUtf8(ptr);
-				const QString env_name  = env.mid(0, env.indexOf("="));
-				const QString env_value = env.mid(env.indexOf("=") + 1);
-
-				if(lower_filter.isEmpty() || env_name.toLower().contains(lower_filter)) {
-					const int row = ui->tableEnvironment->rowCount();
-					ui->tableEnvironment->insertRow(row);
-					ui->tableEnvironment->setItem(row, 0, new QTableWidgetItem(env_name));
-			    	ui->tableEnvironment->setItem(row, 1, new QTableWidgetItem(env_value));
-				}
-
-				ptr += qstrlen(ptr) + 1;
-			}
-
+	const char *const p = environment_.constData();
+	const char *ptr     = p;
+	while(ptr != p + environment_.size()) {
+		const QString env = QString::fromUtf8(ptr);
+		const QString env_name  = env.mid(0, env.indexOf("="));
+		const QString env_value = env.mid(env.indexOf("=") + 1);
+
+		if(lower_filter.isEmpty() || env_name.toLower().contains(lower_filter)) {
+			const int row = ui->tableEnvironment->rowCount();
+			ui->tableEnvironment->insertRow(row);
+			ui->tableEnvironment->setItem(row, 0, new QTableWidgetItem(env_name));
+			ui->tableEnvironment->setItem(row, 1, new QTableWidgetItem(env_value));
 		}
+
+		ptr += qstrlen(ptr) + 1;
 	}
-#endif
 
 	ui->tableEnvironment->setSortingEnabled(true);
 }
 
 //------------------------------------------------------------------------------
 // Name: updateHandles
-// Desc:
+// Desc: starts listing the handles, they show up as they are found
 //------------------------------------------------------------------------------
 void DialogProcessProperties::updateHandles() {
 
-	ui->tableHandles->setSortingEnabled(false);
-	ui->tableHandles->setRowCount(0);
+	int request;
+	{
+		QMutexLocker locker(&lock_);
+		request = ++handles_request_;
+		pending_handles_.clear();
+	}
+
+	handles_model_->clear();
 
 #ifdef Q_OS_LINUX
 	if(IProcess *process = edb::v1::debugger_core->process()) {
-		QDir dir(QString("/proc/%1/fd/").arg(process->pid()));
-		const QFileInfoList entries = dir.entryInfoList(QStringList() << "[0-9]*");
-		Q_FOREACH(const QFileInfo &info, entries) {
-			if(info.isSymLink()) {
-				QString symlink(info.symLinkTarget());
-				const QString type(file_type(symlink));
-
-				if(type == tr("Socket")) {
-					symlink = process_socket_tcp(&symlink);
-					symlink = process_socket_udp(&symlink);
-					symlink = process_socket_unix(&symlink);
-				}
-
-				if(type == tr("Pipe")) {
-					symlink = tr("FIFO");
-				}
-
-				const int row = ui->tableHandles->rowCount();
-				ui->tableHandles->insertRow(row);
+		pool_.start(new ListHandles(this, process->pid(), request));
+	}
+#else
+	Q_UNUSED(request);
+#endif
+}
 
+//------------------------------------------------------------------------------
+// Name: add_handles
+// Desc: the batches pile up until the UI thread gets to them, so it is only
+//       woken once for however many came in meanwhile
+//------------------------------------------------------------------------------
+bool DialogProcessProperties::add_handles(const QVector<HandlesModel::Item> &handles, int request) {
 
-				QTableWidgetItem *const itemFD = new QTableWidgetItem;
-				itemFD->setData(Qt::DisplayRole, info.fileName().toUInt());
+	QMutexLocker locker(&lock_);
+	if(request != handles_request_) {
+		return false;
+	}
 
-				ui->tableHandles->setItem(row, 0, new QTableWidgetItem(type));
-				ui->tableHandles->setItem(row, 1, itemFD);
-				ui->tableHandles->setItem(row, 2, new QTableWidgetItem(symlink));
-			}
+	if(!handles.isEmpty()) {
+		if(pending_handles_.isEmpty()) {
+			QMetaObject::invokeMethod(this, "flush_handles", Qt::QueuedConnection);
 		}
+		pending_handles_ += handles;
 	}
-#endif
 
-	ui->tableHandles->setSortingEnabled(true);
+	return true;
+}
 
+//------------------------------------------------------------------------------
+// Name: flush_handles
+// Desc:
+//------------------------------------------------------------------------------
+void DialogProcessProperties::flush_handles() {
+
+	QVector<HandlesModel::Item> handles;
+	{
+		QMutexLocker locker(&lock_);
+		handles.swap(pending_handles_);
+	}
+
+	handles_model_->addHandles(handles);
 }
 
 //------------------------------------------------------------------------------
 // Name: showEvent
-// Desc:
+// Desc: only the page being looked at is filled in, the others are when
+//       their tabs are opened
 //------------------------------------------------------------------------------
 void DialogProcessProperties::showEvent(QShowEvent *) {
-	updateGeneralPage();
-	updateMemoryPage();
-	updateModulePage();
-	updateHandles();
-	updateThreads();
-	updateEnvironmentPage(ui->txtSearchEnvironment->text());
+	loaded_pages_.clear();
+	loadPage(ui->tabWidget->currentWidget());
+}
+
+//------------------------------------------------------------------------------
+// Name: on_tabWidget_currentChanged
+// Desc:
+//------------------------------------------------------------------------------
+void DialogProcessProperties::on_tabWidget_currentChanged(int index) {
+	if(isVisible()) {
+		loadPage(ui->tabWidget->widget(index));
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: loadPage
+// Desc: fills in <page> if it hasn't been since the dialog was shown
+//------------------------------------------------------------------------------
+void DialogProcessProperties::loadPage(QWidget *page) {
+
+	if(!page || loaded_pages_.contains(page)) {
+		return;
+	}
+
+	loaded_pages_.insert(page);
+
+	if(page == ui->tab) {
+		updateGeneralPage();
+	} else if(page == ui->tab_4) {
+		updateThreads();
+	} else if(page == ui->tab_6) {
+		updateModulePage();
+	} else if(page == ui->tab_7) {
+		updateMemoryPage();
+	} else if(page == ui->tab_8) {
+		updateEnvironment();
+	} else if(page == ui->tab_9) {
+		updateHandles();
+	}
 }
 
 //------------------------------------------------------------------------------
@@ -534,7 +678,7 @@ void DialogProcessProperties::on_btnImage_clicked() {
 // Desc:
 //------------------------------------------------------------------------------
 void DialogProcessProperties::on_btnRefreshEnvironment_clicked() {
-	updateEnvironmentPage(ui->txtSearchEnvironment->text());
+	updateEnvironment();
 }
 
 //------------------------------------------------------------------------------
@@ -568,21 +712,7 @@ void DialogProcessProperties::on_btnRefreshThreads_clicked() {
 // Desc:
 //------------------------------------------------------------------------------
 void DialogProcessProperties::updateThreads() {
-	threads_model_->clear();
-
-	QList<edb::tid_t> threads       = edb::v1::debugger_core->thread_ids();
-	const edb::tid_t current_thread = edb::v1::debugger_core->active_thread();
-
-	Q_FOREACH(edb::tid_t thread, threads) {
-	
-		const ThreadInfo info = edb::v1::debugger_core->get_thread_info(thread);
-	
-		if(thread == current_thread) {
-			threads_model_->addThread(info, true);
-		} else {
-			threads_model_->addThread(info, false);
-		}
-	}
+	threads_model_->sync(edb::v1::debugger_core->thread_ids(), edb::v1::debugger_core->active_thread());
 }
 
 }
@@ -19,9 +19,15 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #ifndef DIALOG_PROCESS_PROPERTIES_20120817_H_
 #define DIALOG_PROCESS_PROPERTIES_20120817_H_
 
+#include "HandlesModel.h"
 #include "ThreadsModel.h"
+#include <QByteArray>
 #include <QDialog>
+#include <QMutex>
+#include <QSet>
 #include <QSortFilterProxyModel>
+#include <QThreadPool>
+#include <QVector>
 
 namespace ProcessProperties {
 
@@ -42,13 +48,25 @@ public Q_SLOTS:
 	void on_btnStrings_clicked();
 	void on_btnRefreshThreads_clicked();
 	void on_txtSearchEnvironment_textChanged(const QString &text);
-	
+	void on_tabWidget_currentChanged(int index);
+
+private Q_SLOTS:
+	void environment_loaded(const QByteArray &environment, int request);
+	void flush_handles();
+
+public:
+	// called from the pool's threads, false means a newer listing has been
+	// asked for and this one should stop
+	bool add_handles(const QVector<HandlesModel::Item> &handles, int request);
+
 private:
+	void loadPage(QWidget *page);
 	void updateGeneralPage();
 	void updateMemoryPage();
 	void updateModulePage();
 	void updateHandles();
 	void updateThreads();
+	void updateEnvironment();
 	void updateEnvironmentPage(const QString &filter);
 	
 private:
@@ -58,6 +76,21 @@ private:
 	Ui::DialogProcessProperties *const ui;
 	ThreadsModel          *threads_model_;
 	QSortFilterProxyModel *threads_filter_;	
+	HandlesModel          *handles_model_;
+	QSortFilterProxyModel *handles_filter_;
+
+	// pages are filled in the first time they are looked at after the
+	// dialog is shown
+	QSet<QWidget *>        loaded_pages_;
+
+	// the environment and handles are read on the pool, newer requests make
+	// what older ones come back with be ignored
+	QThreadPool                 pool_;
+	QMutex                      lock_;
+	int                         environment_request_;
+	int                         handles_request_;
+	QVector<HandlesModel::Item> pending_handles_;
+	QByteArray                  environment_;
 };
 
 }
@@ -19,23 +19,79 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "DialogStrings.h"
 #include "edb.h"
 #include "MemoryRegions.h"
-#include "Util.h"
+#include "ResultsModel.h"
+#include "StringScanner.h"
 #include "Configuration.h"
 
 #include <QHeaderView>
 #include <QMessageBox>
+#include <QProgressBar>
 #include <QSortFilterProxyModel>
+#include <QVector>
 
 #include "ui_DialogStrings.h"
 
 namespace ProcessProperties {
 
+namespace {
+
+// only the address and kind of each string is kept, the string itself is read
+// again when its row is shown
+class StringFormatter : public ResultsModel::Formatter {
+public:
+	virtual QString format(const ResultsModel::Result &result) const {
+		QString str;
+		int string_length = 0;
+
+		if(result.type == StringScanner::ENCODING_UTF16) {
+			edb::v1::get_utf16_string_at_address(result.address, str, 1, 256, string_length);
+			return QString("%1: [UTF16] %2").arg(edb::v1::format_pointer(result.address)).arg(str);
+		} else {
+			edb::v1::get_ascii_string_at_address(result.address, str, 1, 256, string_length);
+			return QString("%1: [ASCII] %2").arg(edb::v1::format_pointer(result.address)).arg(str);
+		}
+	}
+};
+
+// hands the strings to the view as each window's worth is found
+class FindStrings : public StringScanner {
+public:
+	FindStrings(int min_length, bool utf16, ResultsModel *model, QProgressBar *progress) : StringScanner(min_length, utf16), model_(model), progress_(progress) {
+	}
+
+public:
+	virtual void progress(int percent) {
+		progress_->setValue(percent);
+	}
+
+protected:
+	virtual void found(const QVector<String> &strings) {
+		QVector<ResultsModel::Result> results;
+		results.reserve(strings.size());
+
+		Q_FOREACH(const String &string, strings) {
+			const ResultsModel::Result r = { string.address, static_cast<quint32>(string.encoding), string.length };
+			results.push_back(r);
+		}
+
+		model_->addResults(results);
+	}
+
+private:
+	ResultsModel *const model_;
+	QProgressBar *const progress_;
+};
+
+}
+
 //------------------------------------------------------------------------------
 // Name: DialogStrings
 // Desc:
 //------------------------------------------------------------------------------
-DialogStrings::DialogStrings(QWidget *parent) : QDialog(parent), ui(new Ui::DialogStrings) {
+DialogStrings::DialogStrings(QWidget *parent) : QDialog(parent), ui(new Ui::DialogStrings), results_model_(new ResultsModel(this)) {
 	ui->setupUi(this);
+	results_model_->setFormatter(new StringFormatter);
+	ui->listView->setModel(results_model_);
 	ui->tableView->verticalHeader()->hide();
 #if QT_VERSION >= 0x050000
 	ui->tableView->horizontalHeader()->setSectionResizeMode(QHeaderView::ResizeToContents);
@@ -56,15 +112,11 @@ DialogStrings::~DialogStrings() {
 }
 
 //------------------------------------------------------------------------------
-// Name: on_listWidget_itemDoubleClicked
+// Name: on_listView_doubleClicked
 // Desc: follows the found item in the data view
 //------------------------------------------------------------------------------
-void DialogStrings::on_listWidget_itemDoubleClicked(QListWidgetItem *item) {
-	bool ok;
-	const edb::address_t addr = item->data(Qt::UserRole).toULongLong(&ok);
-	if(ok) {
-		edb::v1::dump_data(addr, false);
-	}
+void DialogStrings::on_listView_doubleClicked(const QModelIndex &index) {
+	edb::v1::dump_data(results_model_->result(index).address, false);
 }
 
 //------------------------------------------------------------------------------
@@ -77,7 +129,7 @@ void DialogStrings::showEvent(QShowEvent *) {
 	ui->tableView->setModel(filter_model_);
 
 	ui->progressBar->setValue(0);
-	ui->listWidget->clear();
+	results_model_->clear();
 }
 
 //------------------------------------------------------------------------------
@@ -86,13 +138,9 @@ void DialogStrings::showEvent(QShowEvent *) {
 //------------------------------------------------------------------------------
 void DialogStrings::do_find() {
 
-	const int min_string_length = edb::v1::config().min_string_length;
-
 	const QItemSelectionModel *const selection_model = ui->tableView->selectionModel();
 	const QModelIndexList sel = selection_model->selectedRows();
 
-	QString str;
-
 	if(sel.size() == 0) {
 		QMessageBox::information(
 			this,
@@ -100,48 +148,19 @@ void DialogStrings::do_find() {
 			tr("You must select a region which is to be scanned for strings."));
 	}
 
+	QList<IRegion::pointer> regions;
 	Q_FOREACH(const QModelIndex &selected_item, sel) {
-
 		const QModelIndex index = filter_model_->mapToSource(selected_item);
-
 		if(const IRegion::pointer region = *reinterpret_cast<const IRegion::pointer *>(index.internalPointer())) {
-
-			edb::address_t start_address     = region->start();
-			const edb::address_t end_address = region->end();
-			const edb::address_t orig_start  = start_address;
-
-			// do the search for this region!
-			while(start_address < end_address) {
-
-				int string_length = 0;
-				bool ok = edb::v1::get_ascii_string_at_address(start_address, str, min_string_length, 256, string_length);
-				if(ok) {
-					QListWidgetItem *const item = new QListWidgetItem(QString("%1: [ASCII] %2").arg(edb::v1::format_pointer(start_address)).arg(str));
-					item->setData(Qt::UserRole, start_address);
-					ui->listWidget->addItem(item);
-				} else {
-				
-					if(ui->search_unicode->isChecked()) {
-						string_length = 0;
-						ok = edb::v1::get_utf16_string_at_address(start_address, str, min_string_length, 256, string_length);
-						if(ok) {
-							QListWidgetItem *const item = new QListWidgetItem(QString("%1: [UTF16] %2").arg(edb::v1::format_pointer(start_address)).arg(str));
-							item->setData(Qt::UserRole, start_address);
-							ui->listWidget->addItem(item);
-						}
-					}
-				}
-
-				ui->progressBar->setValue(util::percentage((start_address - orig_start), region->size()));
-
-				if(ok) {
-					start_address += string_length;
-				} else {
-					++start_address;
-				}
-			}
+			regions.push_back(region);
 		}
 	}
+
+	FindStrings scanner(edb::v1::config().min_string_length, ui->search_unicode->isChecked(), results_model_, ui->progressBar);
+	scanner.run(regions);
+
+	// strings which cross from one window into the next come after their neighbours
+	results_model_->sort(0);
 }
 
 //------------------------------------------------------------------------------
@@ -150,7 +169,7 @@ void DialogStrings::do_find() {
 //------------------------------------------------------------------------------
 void DialogStrings::on_btnFind_clicked() {
 	ui->btnFind->setEnabled(false);
-	ui->listWidget->clear();
+	results_model_->clear();
 	ui->progressBar->setValue(0);
 	do_find();
 	ui->progressBar->setValue(100);
@@ -22,8 +22,9 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <QDialog>
 #include "Types.h"
 
+class QModelIndex;
 class QSortFilterProxyModel;
-class QListWidgetItem;
+class ResultsModel;
 
 namespace ProcessProperties {
 
@@ -38,7 +39,7 @@ public:
 
 public Q_SLOTS:
 	void on_btnFind_clicked();
-	void on_listWidget_itemDoubleClicked(QListWidgetItem *);
+	void on_listView_doubleClicked(const QModelIndex &index);
 
 private:
 	virtual void showEvent(QShowEvent *event);
@@ -49,6 +50,7 @@ private:
 private:
 	 Ui::DialogStrings *const ui;
 	 QSortFilterProxyModel *  filter_model_;
+	 ResultsModel *const      results_model_;
 };
 
 }
@@ -0,0 +1,109 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "HandlesModel.h"
+
+namespace ProcessProperties {
+
+HandlesModel::HandlesModel(QObject *parent) : QAbstractItemModel(parent) {
+}
+
+HandlesModel::~HandlesModel() {
+}
+
+QModelIndex HandlesModel::index(int row, int column, const QModelIndex &parent) const {
+	Q_UNUSED(parent);
+
+	if(row >= rowCount(parent) || column >= columnCount(parent)) {
+		return QModelIndex();
+	}
+
+	if(row >= 0) {
+		return createIndex(row, column, const_cast<Item *>(&items_[row]));
+	} else {
+		return createIndex(row, column);
+	}
+}
+
+QModelIndex HandlesModel::parent(const QModelIndex &index) const {
+	Q_UNUSED(index);
+	return QModelIndex();
+}
+
+QVariant HandlesModel::data(const QModelIndex &index, int role) const {
+
+	if(index.isValid() && role == Qt::DisplayRole) {
+
+		const Item &item = items_[index.row()];
+
+		switch(index.column()) {
+		case 0:
+			return item.type;
+		case 1:
+			return item.fd;
+		case 2:
+			return item.name;
+		}
+	}
+
+	return QVariant();
+}
+
+QVariant HandlesModel::headerData(int section, Qt::Orientation orientation, int role) const {
+	if(role == Qt::DisplayRole && orientation == Qt::Horizontal) {
+		switch(section) {
+		case 0:
+			return tr("Type");
+		case 1:
+			return tr("Handle");
+		case 2:
+			return tr("Name");
+		}
+	}
+
+	return QVariant();
+}
+
+int HandlesModel::columnCount(const QModelIndex &parent) const {
+	Q_UNUSED(parent);
+	return 3;
+}
+
+int HandlesModel::rowCount(const QModelIndex &parent) const {
+	Q_UNUSED(parent);
+	return items_.size();
+}
+
+void HandlesModel::addHandles(const QVector<Item> &handles) {
+	if(handles.isEmpty()) {
+		return;
+	}
+
+	// one insertion per batch, not per handle
+	beginInsertRows(QModelIndex(), rowCount(), rowCount() + handles.size() - 1);
+	items_ += handles;
+	endInsertRows();
+}
+
+void HandlesModel::clear() {
+	beginResetModel();
+	items_.clear();
+	endResetModel();
+}
+
+}
@@ -29,7 +29,6 @@ namespace ProcessProperties {
 // Desc:
 //------------------------------------------------------------------------------
 ProcessProperties::ProcessProperties() : menu_(0), dialog_(0) {
-	dialog_ = new DialogProcessProperties(edb::v1::debugger_ui);
 }
 
 //------------------------------------------------------------------------------
@@ -49,6 +48,10 @@ QMenu *ProcessProperties::menu(QWidget *parent) {
 	Q_ASSERT(parent);
 
 	if(!menu_) {
+		// made with the menu rather than the plugin, which a batch run of edb
+		// loads without any widgets
+		dialog_ = new DialogProcessProperties(edb::v1::debugger_ui);
+
 		menu_ = new QMenu(tr("Process Properties"), parent);
 		menu_->addAction(tr("&Process Properties"), this, SLOT(show_menu()), QKeySequence(tr("Ctrl+P")));
 		menu_->addAction(tr("Process &Strings"), dialog_, SLOT(on_btnStrings_clicked()), QKeySequence(tr("Ctrl+S")));
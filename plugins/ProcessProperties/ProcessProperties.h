@@ -29,7 +29,7 @@ class ProcessProperties : public QObject, public IPlugin {
 	Q_OBJECT
 	Q_INTERFACES(IPlugin)
 #if QT_VERSION >= 0x050000
-	Q_PLUGIN_METADATA(IID "edb.IPlugin/1.0")
+	Q_PLUGIN_METADATA(IID "edb.IPlugin/1.0" FILE "ProcessProperties.json")
 #endif
 	Q_CLASSINFO("author", "Evan Teran")
 	Q_CLASSINFO("url", "http://www.codef00.com")
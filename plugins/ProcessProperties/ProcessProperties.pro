@@ -2,8 +2,9 @@
 include(../plugins.pri)
 
 # Input
-HEADERS += ProcessProperties.h DialogProcessProperties.h DialogStrings.h
+HEADERS += ProcessProperties.h DialogProcessProperties.h DialogStrings.h HandlesModel.h
 FORMS += DialogProcessProperties.ui DialogStrings.ui
-SOURCES += ProcessProperties.cpp DialogProcessProperties.cpp DialogStrings.cpp
+SOURCES += ProcessProperties.cpp DialogProcessProperties.cpp DialogStrings.cpp HandlesModel.cpp
+OTHER_FILES += ProcessProperties.json
 
 QT += network
@@ -0,0 +1,95 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "DialogProfile.h"
+
+#include <QHeaderView>
+#include <QTreeWidgetItem>
+
+#include "ui_DialogProfile.h"
+
+namespace Profiler {
+
+namespace {
+
+enum {
+	COLUMN_FUNCTION,
+	COLUMN_SELF,
+	COLUMN_SELF_PERCENT,
+	COLUMN_TOTAL,
+	COLUMN_TOTAL_PERCENT
+};
+
+//------------------------------------------------------------------------------
+// Name: percent
+// Desc:
+//------------------------------------------------------------------------------
+QString percent(quint64 count, quint64 samples) {
+	return QString::number(100.0 * count / samples, 'f', 2);
+}
+
+}
+
+//------------------------------------------------------------------------------
+// Name: DialogProfile
+// Desc:
+//------------------------------------------------------------------------------
+DialogProfile::DialogProfile(QWidget *parent) : QDialog(parent), ui(new Ui::DialogProfile) {
+	ui->setupUi(this);
+#if QT_VERSION >= 0x050000
+	ui->treeWidget->header()->setSectionResizeMode(COLUMN_FUNCTION, QHeaderView::Stretch);
+#else
+	ui->treeWidget->header()->setResizeMode(COLUMN_FUNCTION, QHeaderView::Stretch);
+#endif
+	ui->treeWidget->header()->setStretchLastSection(false);
+}
+
+//------------------------------------------------------------------------------
+// Name: ~DialogProfile
+// Desc:
+//------------------------------------------------------------------------------
+DialogProfile::~DialogProfile() {
+	delete ui;
+}
+
+//------------------------------------------------------------------------------
+// Name: set_profile
+// Desc: replaces what is shown, keeping the order the user picked
+//------------------------------------------------------------------------------
+void DialogProfile::set_profile(const QHash<QString, quint64> &self, const QHash<QString, quint64> &total, quint64 samples, quint64 lost) {
+
+	ui->treeWidget->setSortingEnabled(false);
+	ui->treeWidget->clear();
+
+	for(QHash<QString, quint64>::const_iterator it = total.begin(); it != total.end(); ++it) {
+		const quint64 self_count = self.value(it.key());
+
+		QTreeWidgetItem *const item = new QTreeWidgetItem(ui->treeWidget);
+		item->setText(COLUMN_FUNCTION, it.key());
+		item->setData(COLUMN_SELF, Qt::DisplayRole, self_count);
+		item->setText(COLUMN_SELF_PERCENT, percent(self_count, samples));
+		item->setData(COLUMN_TOTAL, Qt::DisplayRole, it.value());
+		item->setText(COLUMN_TOTAL_PERCENT, percent(it.value(), samples));
+	}
+
+	ui->treeWidget->setSortingEnabled(true);
+
+	ui->labelSummary->setText(tr("%1 samples, %2 lost").arg(samples).arg(lost));
+}
+
+}
@@ -0,0 +1,48 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef DIALOGPROFILE_20261014_H_
+#define DIALOGPROFILE_20261014_H_
+
+#include <QDialog>
+#include <QHash>
+#include <QString>
+
+namespace Profiler {
+
+namespace Ui { class DialogProfile; }
+
+// the functions the samples landed in, by how often they were running (self)
+// and how often they were anywhere on the stack (total)
+class DialogProfile : public QDialog {
+	Q_OBJECT
+
+public:
+	DialogProfile(QWidget *parent = 0);
+	virtual ~DialogProfile();
+
+public:
+	void set_profile(const QHash<QString, quint64> &self, const QHash<QString, quint64> &total, quint64 samples, quint64 lost);
+
+private:
+	Ui::DialogProfile *const ui;
+};
+
+}
+
+#endif
@@ -0,0 +1,250 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Profiler.h"
+#include "DialogProfile.h"
+#include "IAnalyzer.h"
+#include "IDebugger.h"
+#include "ISymbolManager.h"
+#include "Symbol.h"
+#include "edb.h"
+
+#include <QFile>
+#include <QFileDialog>
+#include <QInputDialog>
+#include <QMenu>
+#include <QMessageBox>
+#include <QSet>
+#include <QStringList>
+#include <QTextStream>
+#include <QTimer>
+
+namespace Profiler {
+
+namespace {
+
+// how often the core's sample buffers are drained, in milliseconds
+const int CollectInterval = 100;
+
+}
+
+//------------------------------------------------------------------------------
+// Name: Profiler
+// Desc:
+//------------------------------------------------------------------------------
+Profiler::Profiler() : menu_(0), timer_(new QTimer(this)), dialog_(0), samples_(0), lost_(0) {
+	connect(timer_, SIGNAL(timeout()), this, SLOT(collect()));
+}
+
+//------------------------------------------------------------------------------
+// Name: ~Profiler
+// Desc:
+//------------------------------------------------------------------------------
+Profiler::~Profiler() {
+	delete dialog_;
+}
+
+//------------------------------------------------------------------------------
+// Name: menu
+// Desc:
+//------------------------------------------------------------------------------
+QMenu *Profiler::menu(QWidget *parent) {
+
+	Q_ASSERT(parent);
+
+	if(!menu_) {
+		menu_ = new QMenu(tr("Profiler"), parent);
+		menu_->addAction(tr("&Start Profiling..."), this, SLOT(start_profile()));
+		menu_->addAction(tr("S&top Profiling"), this, SLOT(stop_profile()));
+		menu_->addSeparator();
+		menu_->addAction(tr("Show &Profile"), this, SLOT(show_profile()));
+		menu_->addAction(tr("&Export Folded Stacks..."), this, SLOT(export_folded()));
+	}
+
+	return menu_;
+}
+
+//------------------------------------------------------------------------------
+// Name: start_profile
+// Desc: asks for a rate and starts sampling, the last profile is thrown away
+//------------------------------------------------------------------------------
+void Profiler::start_profile() {
+
+	if(!edb::v1::debugger_core || !edb::v1::debugger_core->process()) {
+		QMessageBox::information(edb::v1::debugger_ui, tr("Profiler"), tr("There is no process to profile."));
+		return;
+	}
+
+	bool ok;
+	const int frequency = QInputDialog::getInt(edb::v1::debugger_ui, tr("Profiler"), tr("Samples per second:"), 200, 1, 10000, 1, &ok);
+	if(!ok) {
+		return;
+	}
+
+	stop_profile();
+
+	if(!edb::v1::debugger_core->start_profile(frequency)) {
+		QMessageBox::information(edb::v1::debugger_ui, tr("Profiler"), tr("The debugger core is unable to sample this process. On Linux, kernel.perf_event_paranoid may need lowering."));
+		return;
+	}
+
+	names_.clear();
+	stacks_.clear();
+	self_.clear();
+	total_.clear();
+	samples_ = 0;
+	lost_    = 0;
+
+	timer_->start(CollectInterval);
+}
+
+//------------------------------------------------------------------------------
+// Name: stop_profile
+// Desc: keeps what was sampled so far
+//------------------------------------------------------------------------------
+void Profiler::stop_profile() {
+
+	if(timer_->isActive()) {
+		timer_->stop();
+		collect();
+		edb::v1::debugger_core->stop_profile();
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: collect
+// Desc: folds the samples recorded since the last call into the profile
+//------------------------------------------------------------------------------
+void Profiler::collect() {
+
+	if(!edb::v1::debugger_core) {
+		return;
+	}
+
+	quint64 lost;
+	const QVector<ProfileSample> samples = edb::v1::debugger_core->profile_samples(&lost);
+	lost_ += lost;
+
+	Q_FOREACH(const ProfileSample &sample, samples) {
+
+		// a return address is just past the call, which may be the last
+		// instruction of the caller
+		QStringList stack;
+		for(int i = sample.depth - 1; i >= 0; --i) {
+			stack.push_back(function_name(sample.callers[i] - 1));
+		}
+
+		const QString function = function_name(sample.ip);
+		stack.push_back(function);
+
+		++stacks_[stack.join(";")];
+		++self_[function];
+
+		// recursion shouldn't count a function more than once per sample
+		Q_FOREACH(const QString &name, stack.toSet()) {
+			++total_[name];
+		}
+	}
+
+	samples_ += samples.size();
+
+	if(dialog_ && dialog_->isVisible()) {
+		dialog_->set_profile(self_, total_, samples_, lost_);
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: function_name
+// Desc: the function containing <address>, by symbol if there is one covering
+//       it, or else by where the analyzer says the function starts
+//------------------------------------------------------------------------------
+QString Profiler::function_name(edb::address_t address) {
+
+	QHash<edb::address_t, QString>::const_iterator it = names_.find(address);
+	if(it != names_.end()) {
+		return it.value();
+	}
+
+	bool have_start = false;
+	edb::address_t start = address;
+	if(IAnalyzer *const analyzer = edb::v1::analyzer()) {
+		start = analyzer->find_containing_function(address, &have_start);
+	}
+
+	QString name;
+	const Symbol::pointer symbol = edb::v1::symbol_manager().find_near_symbol(address);
+	if(symbol && (symbol->size != 0 ? address < symbol->address + symbol->size : (!have_start || symbol->address >= start))) {
+		name = symbol->name;
+	} else if(have_start) {
+		name = QString("sub_%1").arg(edb::v1::format_pointer(start));
+	} else {
+		name = edb::v1::format_pointer(address);
+	}
+
+	names_.insert(address, name);
+	return name;
+}
+
+//------------------------------------------------------------------------------
+// Name: show_profile
+// Desc:
+//------------------------------------------------------------------------------
+void Profiler::show_profile() {
+
+	if(!dialog_) {
+		dialog_ = new DialogProfile(edb::v1::debugger_ui);
+	}
+
+	dialog_->set_profile(self_, total_, samples_, lost_);
+	dialog_->show();
+}
+
+//------------------------------------------------------------------------------
+// Name: export_folded
+// Desc: one line per distinct stack, "outer;inner count", which is what
+//       flamegraph.pl and most other flame graph tools take
+//------------------------------------------------------------------------------
+void Profiler::export_folded() {
+
+	if(stacks_.isEmpty()) {
+		QMessageBox::information(edb::v1::debugger_ui, tr("Profiler"), tr("Nothing has been sampled yet."));
+		return;
+	}
+
+	const QString filename = QFileDialog::getSaveFileName(edb::v1::debugger_ui, tr("Export Folded Stacks"), QString(), tr("Folded Stacks (*.folded *.txt);;All Files (*)"));
+	if(filename.isEmpty()) {
+		return;
+	}
+
+	QFile file(filename);
+	if(!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+		QMessageBox::information(edb::v1::debugger_ui, tr("Profiler"), tr("Unable to open file: %1").arg(filename));
+		return;
+	}
+
+	QTextStream stream(&file);
+	for(QHash<QString, quint64>::const_iterator it = stacks_.begin(); it != stacks_.end(); ++it) {
+		stream << it.key() << ' ' << it.value() << '\n';
+	}
+}
+
+#if QT_VERSION < 0x050000
+Q_EXPORT_PLUGIN2(Profiler, Profiler)
+#endif
+
+}
@@ -0,0 +1,81 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef PROFILER_20261014_H_
+#define PROFILER_20261014_H_
+
+#include "IPlugin.h"
+#include "Types.h"
+
+#include <QHash>
+#include <QString>
+
+class QMenu;
+class QTimer;
+
+namespace Profiler {
+
+class DialogProfile;
+
+// a sampling profiler. The debugger core samples every thread while the
+// process runs, and the samples are drained a few times a second and folded
+// into per function counts and whole stacks, which can be exported in the
+// format flamegraph.pl reads
+class Profiler : public QObject, public IPlugin {
+	Q_OBJECT
+	Q_INTERFACES(IPlugin)
+#if QT_VERSION >= 0x050000
+	Q_PLUGIN_METADATA(IID "edb.IPlugin/1.0")
+#endif
+	Q_CLASSINFO("author", "Evan Teran")
+	Q_CLASSINFO("url", "http://www.codef00.com")
+
+public:
+	Profiler();
+	virtual ~Profiler();
+
+public:
+	virtual QMenu *menu(QWidget *parent = 0);
+
+public Q_SLOTS:
+	void start_profile();
+	void stop_profile();
+	void show_profile();
+	void export_folded();
+
+private Q_SLOTS:
+	void collect();
+
+private:
+	QString function_name(edb::address_t address);
+
+private:
+	QMenu                           *menu_;
+	QTimer                          *timer_;
+	DialogProfile                   *dialog_;
+	QHash<edb::address_t, QString>   names_;
+	QHash<QString, quint64>          stacks_; // outermost function first, separated by ';'
+	QHash<QString, quint64>          self_;
+	QHash<QString, quint64>          total_;
+	quint64                          samples_;
+	quint64                          lost_;
+};
+
+}
+
+#endif
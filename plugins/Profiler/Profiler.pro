@@ -0,0 +1,7 @@
+
+include(../plugins.pri)
+
+# Input
+HEADERS += DialogProfile.h Profiler.h
+FORMS   += DialogProfile.ui
+SOURCES += DialogProfile.cpp Profiler.cpp
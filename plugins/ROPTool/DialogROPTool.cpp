@@ -17,54 +17,35 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
 #include "DialogROPTool.h"
-#include "ByteShiftArray.h"
+#include "Gadget.h"
+#include "GadgetCache.h"
+#include "GadgetScan.h"
+#include "Configuration.h"
 #include "edb.h"
 #include "IDebugger.h"
 #include "MemoryRegions.h"
-#include "Util.h"
-#include <QDebug>
+#include "RegionScanner.h"
+#include <QHash>
 #include <QHeaderView>
 #include <QMessageBox>
 #include <QModelIndex>
 #include <QSortFilterProxyModel>
 #include <QStandardItemModel>
 
+#include <algorithm>
+
 #include "ui_DialogROPTool.h"
 
 namespace ROPTool {
 
 namespace {
 
-bool is_nop(const edb::Instruction &inst) {
-	if(inst) {
-		if(edisassm::is_nop(inst)) {
-			return true;
-		}
-
-		// TODO: does this effect flags?
-		if(inst.type() == edb::Instruction::OP_MOV && inst.operand_count() == 2) {
-			if(inst.operands()[0].general_type() == edb::Operand::TYPE_REGISTER && inst.operands()[1].general_type() == edb::Operand::TYPE_REGISTER) {
-				if(inst.operands()[0].reg() == inst.operands()[1].reg()) {
-					return true;
-				}
-			}
-
-		}
-
-		// TODO: does this effect flags?
-		if(inst.type() == edb::Instruction::OP_XCHG && inst.operand_count() == 2) {
-			if(inst.operands()[0].general_type() == edb::Operand::TYPE_REGISTER && inst.operands()[1].general_type() == edb::Operand::TYPE_REGISTER) {
-				if(inst.operands()[0].reg() == inst.operands()[1].reg()) {
-					return true;
-				}
-			}
-
-		}
-
-		// TODO: support LEA reg, [reg]
-
-	}
-	return false;
+//------------------------------------------------------------------------------
+// Name: gadget_less
+// Desc:
+//------------------------------------------------------------------------------
+bool gadget_less(const Gadget &lhs, const Gadget &rhs) {
+	return lhs.address < rhs.address;
 }
 
 }
@@ -170,133 +151,26 @@ void DialogROPTool::on_chkShowOther_stateChanged(int state) {
 	result_filter_->set_mask_bit(0x10, state);
 }
 
-//------------------------------------------------------------------------------
-// Name: set_gadget_role
-// Desc:
-//------------------------------------------------------------------------------
-void DialogROPTool::set_gadget_role(QStandardItem *item, const edb::Instruction &inst1) {
-
-	switch(inst1.type()) {
-	case edb::Instruction::OP_ADD:
-	case edb::Instruction::OP_ADC:
-	case edb::Instruction::OP_SUB:
-	case edb::Instruction::OP_SBB:
-	case edb::Instruction::OP_IMUL:
-	case edb::Instruction::OP_MUL:
-	case edb::Instruction::OP_IDIV:
-	case edb::Instruction::OP_DIV:
-	case edb::Instruction::OP_INC:
-	case edb::Instruction::OP_DEC:
-	case edb::Instruction::OP_NEG:
-	case edb::Instruction::OP_CMP:
-	case edb::Instruction::OP_DAA:
-	case edb::Instruction::OP_DAS:
-	case edb::Instruction::OP_AAA:
-	case edb::Instruction::OP_AAS:
-	case edb::Instruction::OP_AAM:
-	case edb::Instruction::OP_AAD:
-		// ALU ops
-		item->setData(0x01, Qt::UserRole + 1);
-		break;
-	case edb::Instruction::OP_PUSH:
-	case edb::Instruction::OP_PUSHA:
-	case edb::Instruction::OP_POP:
-	case edb::Instruction::OP_POPA:
-		// stack ops
-		item->setData(0x02, Qt::UserRole + 1);
-		break;
-	case edb::Instruction::OP_AND:
-	case edb::Instruction::OP_OR:
-	case edb::Instruction::OP_XOR:
-	case edb::Instruction::OP_NOT:
-	case edb::Instruction::OP_SAR:
-	case edb::Instruction::OP_SAL:
-	case edb::Instruction::OP_SHR:
-	case edb::Instruction::OP_SHL:
-	case edb::Instruction::OP_SHRD:
-	case edb::Instruction::OP_SHLD:
-	case edb::Instruction::OP_ROR:
-	case edb::Instruction::OP_ROL:
-	case edb::Instruction::OP_RCR:
-	case edb::Instruction::OP_RCL:
-	case edb::Instruction::OP_BT:
-	case edb::Instruction::OP_BTS:
-	case edb::Instruction::OP_BTR:
-	case edb::Instruction::OP_BTC:
-	case edb::Instruction::OP_BSF:
-	case edb::Instruction::OP_BSR:
-		// logic ops
-		item->setData(0x04, Qt::UserRole + 1);
-		break;
-	case edb::Instruction::OP_MOV:
-	case edb::Instruction::OP_CMOVCC:
-	case edb::Instruction::OP_XCHG:
-	case edb::Instruction::OP_BSWAP:
-	case edb::Instruction::OP_XADD:
-	case edb::Instruction::OP_CMPXCHG:
-	case edb::Instruction::OP_CWD:
-	case edb::Instruction::OP_CDQ:
-	case edb::Instruction::OP_CQO:
-	case edb::Instruction::OP_CDQE:
-	case edb::Instruction::OP_CBW:
-	case edb::Instruction::OP_CWDE:
-	case edb::Instruction::OP_MOVSX:
-	case edb::Instruction::OP_MOVZX:
-	case edb::Instruction::OP_MOVSXD:
-	case edb::Instruction::OP_MOVBE:
-	case edb::Instruction::OP_MOVS:
-	case edb::Instruction::OP_CMPS:
-	case edb::Instruction::OP_CMPSW:
-	case edb::Instruction::OP_SCAS:
-	case edb::Instruction::OP_LODS:
-	case edb::Instruction::OP_STOS:
-	case edb::Instruction::OP_CMPXCHG8B:
-	case edb::Instruction::OP_CMPXCHG16B:
-		// data ops
-		item->setData(0x08, Qt::UserRole + 1);
-		break;
-	default:
-		// other ops
-		item->setData(0x10, Qt::UserRole + 1);
-		break;
-
-	}
-}
-
 //------------------------------------------------------------------------------
 // Name: add_gadget
 // Desc:
 //------------------------------------------------------------------------------
-void DialogROPTool::add_gadget(QList<edb::Instruction> instructions) {
-
-	if(!instructions.isEmpty()) {
-		const edb::Instruction inst1 = instructions.takeFirst();
+void DialogROPTool::add_gadget(const Gadget &gadget) {
 
-		QString instruction_string = QString("%1").arg(QString::fromStdString(to_string(inst1)));
-		Q_FOREACH(const edb::Instruction &instruction, instructions) {
-			instruction_string.append(QString("; %1").arg(QString::fromStdString(to_string(instruction))));
-		}
+	QStandardItem *const item = new QStandardItem(QString("%1: %2").arg(edb::v1::format_pointer(gadget.address), gadget.text));
 
-		if(!ui->checkUnique->isChecked() || !unique_results_.contains(instruction_string)) {
-			unique_results_.insert(instruction_string);
+	item->setData(static_cast<qulonglong>(gadget.address), Qt::UserRole);
+	item->setData(gadget.role, Qt::UserRole + 1);
+	item->setData(gadget.ending, Qt::UserRole + 2);
+	item->setData(gadget.count, Qt::UserRole + 3);
 
-			// found a gadget
-			QStandardItem *const item = new QStandardItem(
-				QString("%1: %2").arg(edb::v1::format_pointer(inst1.rva()), instruction_string));
-
-			item->setData(static_cast<qulonglong>(inst1.rva()), Qt::UserRole);
-			
-			// TODO: make this look for 1st non-NOP
-			set_gadget_role(item, inst1);
-
-			result_model_->insertRow(result_model_->rowCount(), item);
-		}
-	}
+	result_model_->insertRow(result_model_->rowCount(), item);
 }
 
 //------------------------------------------------------------------------------
 // Name: do_find
-// Desc:
+// Desc: regions of a module which we've searched before are loaded from the
+//       gadget cache, the rest are searched and then cached
 //------------------------------------------------------------------------------
 void DialogROPTool::do_find() {
 
@@ -312,111 +186,68 @@ void DialogROPTool::do_find() {
 
 		unique_results_.clear();
 
-		if(IProcess *process = edb::v1::debugger_core->process()) {
-			Q_FOREACH(const QModelIndex &selected_item, sel) {
-
-				const QModelIndex index = filter_model_->mapToSource(selected_item);
-				if(const IRegion::pointer region = *reinterpret_cast<const IRegion::pointer *>(index.internalPointer())) {
-
-					edb::address_t start_address     = region->start();
-					const edb::address_t end_address = region->end();
-					const edb::address_t orig_start  = start_address;
-
-					ByteShiftArray bsa(32);
-
-					while(start_address < end_address) {
-
-						// read in the next byte
-						quint8 byte;
-						if(process->read_bytes(start_address, &byte, 1)) {
-							bsa << byte;
-
-							const quint8       *p = bsa.data();
-							const quint8 *const l = p + bsa.size();
-							edb::address_t    rva = start_address - bsa.size() + 1;
-
-							QList<edb::Instruction> instruction_list;
-
-							// eat up any NOPs in front...
-							Q_FOREVER {
-								edb::Instruction inst(p, l, rva, std::nothrow);
-								if(!is_nop(inst)) {
-									break;
-								}
-
-								instruction_list << inst;
-								p += inst.size();
-								rva += inst.size();
-							}
-
-
-							edb::Instruction inst1(p, l, rva, std::nothrow);
-							if(inst1) {
-								instruction_list << inst1;
-
-								if(inst1.type() == edb::Instruction::OP_INT && inst1.operands()[0].general_type() == edb::Operand::TYPE_IMMEDIATE && (inst1.operands()[0].immediate() & 0xff) == 0x80) {
-									add_gadget(instruction_list);
-								} else if(inst1.type() == edb::Instruction::OP_SYSENTER) {
-									add_gadget(instruction_list);
-								} else if(inst1.type() == edb::Instruction::OP_SYSCALL) {
-									add_gadget(instruction_list);
-								} else if(is_ret(inst1)) {
-									ui->progressBar->setValue(util::percentage(start_address - orig_start, region->size()));
-									++start_address;
-									continue;
-								} else {
-
-									p += inst1.size();
-									rva += inst1.size();
-
-									// eat up any NOPs in between...
-									Q_FOREVER {
-										edb::Instruction inst(p, l, rva, std::nothrow);
-										if(!is_nop(inst)) {
-											break;
-										}
-
-										instruction_list << inst;
-										p += inst.size();
-										rva += inst.size();
-									}
-
-									edb::Instruction inst2(p, l, rva, std::nothrow);
-									if(is_ret(inst2)) {
-										instruction_list << inst2;
-										add_gadget(instruction_list);
-									} else if(inst2 && inst2.type() == edb::Instruction::OP_POP) {
-										instruction_list << inst2;
-										p += inst2.size();
-										rva += inst2.size();
-
-										edb::Instruction inst3(p, l, rva, std::nothrow);
-										if(inst3 && inst3.type() == edb::Instruction::OP_JMP) {
-
-											instruction_list << inst3;
-
-											if(inst2.operand_count() == 1 && inst2.operands()[0].general_type() == edb::Operand::TYPE_REGISTER) {
-												if(inst3.operand_count() == 1 && inst3.operands()[0].general_type() == edb::Operand::TYPE_REGISTER) {
-													if(inst2.operands()[0].reg() == inst3.operands()[0].reg()) {
-														add_gadget(instruction_list);
-													}
-												}
-											}
-										}
-									}
-								}
-
-								// TODO(eteran): catch things like "add rsp, 8; jmp [rsp - 8]" and similar, it's rare,
-								// but could happen
-							}
-						}
-
-						ui->progressBar->setValue(util::percentage(start_address - orig_start, region->size()));
-						++start_address;
-					}
+		const int  depth     = ui->spnDepth->value();
+		const bool code_only = edb::v1::config().scan_code_sections_only;
+
+		QHash<QString, QByteArray> md5s;
+		QList<GadgetCache>         uncached;
+		QList<IRegion::pointer>    regions;
+		QVector<Gadget>            gadgets;
+
+		Q_FOREACH(const QModelIndex &selected_item, sel) {
+			const QModelIndex index = filter_model_->mapToSource(selected_item);
+			if(const IRegion::pointer region = *reinterpret_cast<const IRegion::pointer *>(index.internalPointer())) {
+
+				const QString path = region->name();
+				if(!md5s.contains(path)) {
+					md5s.insert(path, path.startsWith('/') ? edb::v1::get_file_md5(path) : QByteArray());
+				}
+
+				const GadgetCache cache(region, md5s[path], depth, code_only);
+				if(!cache.load(&gadgets)) {
+					regions += edb::v1::code_regions(region);
+					uncached.push_back(cache);
 				}
 			}
 		}
+
+		GadgetScan scan(depth, ui->progressBar);
+		RegionScanner().run(regions, &scan);
+
+		Q_FOREACH(const GadgetCache &cache, uncached) {
+			cache.save(scan.gadgets);
+		}
+
+		gadgets += scan.gadgets;
+		std::stable_sort(gadgets.begin(), gadgets.end(), gadget_less);
+
+		// the same bytes are the same gadget, wherever they are
+		const bool unique = ui->checkUnique->isChecked();
+
+		Q_FOREACH(const Gadget &gadget, gadgets) {
+			if(!unique || !unique_results_.contains(gadget.bytes)) {
+				unique_results_.insert(gadget.bytes);
+				add_gadget(gadget);
+			}
+		}
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: on_txtQuery_textChanged
+// Desc: a query which doesn't parse leaves the last good one in place and
+//       says what is wrong with it in the tool tip
+//------------------------------------------------------------------------------
+void DialogROPTool::on_txtQuery_textChanged(const QString &text) {
+
+	GadgetQuery query;
+	QString     error;
+
+	if(query.parse(text, &error)) {
+		result_filter_->set_query(query);
+		ui->txtQuery->setToolTip(tr("Terms which must all match, such as: role:stack ends:ret \"pop rdi\" -xor len<=3"));
+	} else {
+		ui->txtQuery->setToolTip(error);
 	}
 }
 
@@ -19,23 +19,22 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #ifndef DIALOG_ROPTOOL_20100817_H_
 #define DIALOG_ROPTOOL_20100817_H_
 
+#include "GadgetQuery.h"
 #include "Types.h"
-#include "Instruction.h"
 
 #include <QDialog>
+#include <QByteArray>
 #include <QSet>
-#include <QList>
 #include <QSortFilterProxyModel>
 
-class QListWidgetItem;
 class QModelIndex;
 class QSortFilterProxyModel;
-class QStandardItem;
 class QStandardItemModel;
 
 namespace ROPTool {
 
 class ResultFilterProxy;
+struct Gadget;
 
 namespace Ui { class DialogROPTool; }
 
@@ -58,17 +57,24 @@ public:
 		endResetModel();
 	}
 
+	void set_query(const GadgetQuery &query) {
+		beginResetModel();
+		query_ = query;
+		endResetModel();
+	}
+
 protected:
 	bool filterAcceptsRow(int sourceRow, const QModelIndex &sourceParent) const {
 		QModelIndex index = sourceModel()->index(sourceRow, 0, sourceParent);
 		if(index.data(Qt::UserRole + 1).toUInt() & mask_) {
-			return true;
+			return query_.empty() || query_.matches(index.data(Qt::DisplayRole).toString(), index.data(Qt::UserRole + 1).toUInt(), index.data(Qt::UserRole + 2).toUInt(), index.data(Qt::UserRole + 3).toUInt());
 		}
 		return false;
 	}
 
 private:
-	quint32 mask_;
+	quint32     mask_;
+	GadgetQuery query_;
 };
 
 class DialogROPTool : public QDialog {
@@ -86,11 +92,11 @@ public Q_SLOTS:
 	void on_chkShowLogic_stateChanged(int state);
 	void on_chkShowData_stateChanged(int state);
 	void on_chkShowOther_stateChanged(int state);
+	void on_txtQuery_textChanged(const QString &text);
 
 private:
 	void do_find();
-	void add_gadget(QList<edb::Instruction> instructions);
-	void set_gadget_role(QStandardItem *item, const edb::Instruction &inst1);
+	void add_gadget(const Gadget &gadget);
 
 private:
 	virtual void showEvent(QShowEvent *event);
@@ -100,7 +106,7 @@ private:
 	QSortFilterProxyModel *  filter_model_;
 	QStandardItemModel *     result_model_;
 	ResultFilterProxy *      result_filter_;
-	QSet<QString>            unique_results_;
+	QSet<QByteArray>         unique_results_;
 };
 
 }
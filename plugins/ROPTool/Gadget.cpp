@@ -0,0 +1,53 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "Gadget.h"
+#include "Instruction.h"
+#include "InstructionTextCache.h"
+#include "edb.h"
+
+namespace ROPTool {
+
+//------------------------------------------------------------------------------
+// Name: gadget_text
+// Desc: the instructions of a gadget as "inst; inst; ret"
+//------------------------------------------------------------------------------
+QString gadget_text(const QByteArray &bytes, edb::address_t address) {
+
+	const quint8 *p          = reinterpret_cast<const quint8 *>(bytes.constData());
+	const quint8 *const last = p + bytes.size();
+
+	QString text;
+	while(p < last) {
+		const edb::Instruction inst(p, last, address, std::nothrow);
+		if(!inst) {
+			break;
+		}
+
+		if(!text.isEmpty()) {
+			text.append("; ");
+		}
+		text.append(edb::v1::instruction_text_cache().format(inst));
+
+		p       += inst.size();
+		address += inst.size();
+	}
+
+	return text;
+}
+
+}
@@ -0,0 +1,56 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef GADGET_20261014_H_
+#define GADGET_20261014_H_
+
+#include "Types.h"
+#include <QByteArray>
+#include <QString>
+
+namespace ROPTool {
+
+struct Gadget {
+	// the same bits as the "Gadgets to Display" check boxes
+	enum Role {
+		ROLE_ALU   = 0x01,
+		ROLE_STACK = 0x02,
+		ROLE_LOGIC = 0x04,
+		ROLE_DATA  = 0x08,
+		ROLE_OTHER = 0x10
+	};
+
+	// and how it hands control back
+	enum Ending {
+		ENDS_RET     = 0x01,
+		ENDS_SYSCALL = 0x02,
+		ENDS_JMP     = 0x04
+	};
+
+	edb::address_t address;
+	QByteArray     bytes;
+	QString        text;
+	quint32        role;
+	quint32        ending;
+	quint32        count;  // of instructions, the last one included
+};
+
+QString gadget_text(const QByteArray &bytes, edb::address_t address);
+
+}
+
+#endif
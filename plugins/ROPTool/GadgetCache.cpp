@@ -0,0 +1,197 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "GadgetCache.h"
+#include "edb.h"
+
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+
+namespace ROPTool {
+
+namespace {
+
+const quint32 CACHE_MAGIC   = 0x47424445; // "EDBG"
+const quint32 CACHE_VERSION = 2;
+
+}
+
+//------------------------------------------------------------------------------
+// Name: GadgetCache
+// Desc: only regions of a file which can't be written to get a cache, nothing
+//       else can be trusted to still be what the file says it is
+//------------------------------------------------------------------------------
+GadgetCache::GadgetCache(const IRegion::pointer &region, const QByteArray &md5, int depth, bool code_only) : region_(region), md5_(md5), depth_(depth), code_only_(code_only) {
+
+	const QString path = region_->name();
+	if(!md5_.isEmpty() && !region_->writable() && path.startsWith(QLatin1Char('/'))) {
+		filename_ = QString(QLatin1String("%1/%2-%3-%4%5.gadgets")).arg(edb::v1::cache_directory(QLatin1String("gadgets")), QFileInfo(path).fileName(), QString::fromLatin1(md5_.toHex())).arg(static_cast<quint64>(region_->base()), 0, 16).arg(code_only_ ? QString() : QLatin1String("-raw"));
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: write_header
+// Desc:
+//------------------------------------------------------------------------------
+void GadgetCache::write_header(QDataStream &stream) const {
+	stream << CACHE_MAGIC << CACHE_VERSION;
+	stream << region_->name() << md5_ << static_cast<quint64>(region_->base()) << static_cast<quint64>(region_->size()) << static_cast<qint32>(depth_) << code_only_;
+}
+
+//------------------------------------------------------------------------------
+// Name: read_header
+// Desc: returns true if the cache was made from the same part of the same
+//       file, searched to the same depth in the same way
+//------------------------------------------------------------------------------
+bool GadgetCache::read_header(QDataStream &stream) const {
+
+	quint32    magic;
+	quint32    version;
+	QString    path;
+	QByteArray md5;
+	quint64    base;
+	quint64    size;
+	qint32     depth;
+	bool       code_only;
+
+	stream >> magic >> version;
+	if(stream.status() != QDataStream::Ok || magic != CACHE_MAGIC || version != CACHE_VERSION) {
+		return false;
+	}
+
+	stream >> path >> md5 >> base >> size >> depth >> code_only;
+
+	return stream.status() == QDataStream::Ok &&
+		path == region_->name() &&
+		md5 == md5_ &&
+		base == static_cast<quint64>(region_->base()) &&
+		size == static_cast<quint64>(region_->size()) &&
+		depth == depth_ &&
+		code_only == code_only_;
+}
+
+//------------------------------------------------------------------------------
+// Name: load
+// Desc: fills in <gadgets> if there is a matching cache
+//------------------------------------------------------------------------------
+bool GadgetCache::load(QVector<Gadget> *gadgets) const {
+
+	Q_ASSERT(gadgets);
+
+	if(filename_.isEmpty()) {
+		return false;
+	}
+
+	QFile file(filename_);
+	if(!file.open(QIODevice::ReadOnly)) {
+		return false;
+	}
+
+	QDataStream stream(&file);
+	stream.setByteOrder(QDataStream::LittleEndian);
+	stream.setVersion(QDataStream::Qt_4_6);
+
+	if(!read_header(stream)) {
+		return false;
+	}
+
+	const edb::address_t base = region_->start();
+	const quint64        size = region_->size();
+
+	quint32 count;
+	stream >> count;
+
+	QVector<Gadget> found;
+	found.reserve(count);
+
+	for(quint32 i = 0; i < count; ++i) {
+		quint64 offset;
+		Gadget  gadget;
+		stream >> offset >> gadget.bytes >> gadget.role >> gadget.ending >> gadget.count;
+
+		if(stream.status() != QDataStream::Ok || offset >= size || gadget.bytes.isEmpty()) {
+			return false;
+		}
+
+		gadget.address = base + offset;
+		gadget.text    = gadget_text(gadget.bytes, gadget.address);
+		found.push_back(gadget);
+	}
+
+	*gadgets += found;
+	return true;
+}
+
+//------------------------------------------------------------------------------
+// Name: save
+// Desc: writes to a temporary file first, so a reader never sees half of one.
+//       Only the gadgets inside of our region are kept
+//------------------------------------------------------------------------------
+bool GadgetCache::save(const QVector<Gadget> &gadgets) const {
+
+	if(filename_.isEmpty()) {
+		return false;
+	}
+
+	if(!QDir().mkpath(QFileInfo(filename_).absolutePath())) {
+		return false;
+	}
+
+	const QString temp_filename = edb::v1::temp_filename(filename_);
+
+	QFile file(temp_filename);
+	if(!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+		return false;
+	}
+
+	QVector<const Gadget *> kept;
+	for(int i = 0; i < gadgets.size(); ++i) {
+		if(region_->contains(gadgets[i].address)) {
+			kept.push_back(&gadgets[i]);
+		}
+	}
+
+	QDataStream stream(&file);
+	stream.setByteOrder(QDataStream::LittleEndian);
+	stream.setVersion(QDataStream::Qt_4_6);
+
+	write_header(stream);
+
+	stream << static_cast<quint32>(kept.size());
+	Q_FOREACH(const Gadget *gadget, kept) {
+		stream << static_cast<quint64>(gadget->address - region_->start()) << gadget->bytes << gadget->role << gadget->ending << gadget->count;
+	}
+
+	file.close();
+
+	if(stream.status() != QDataStream::Ok || file.error() != QFile::NoError) {
+		QFile::remove(temp_filename);
+		return false;
+	}
+
+	QFile::remove(filename_);
+	if(!QFile::rename(temp_filename, filename_)) {
+		QFile::remove(temp_filename);
+		return false;
+	}
+
+	return true;
+}
+
+}
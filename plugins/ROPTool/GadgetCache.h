@@ -0,0 +1,60 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef GADGET_CACHE_20261014_H_
+#define GADGET_CACHE_20261014_H_
+
+#include "Gadget.h"
+#include "IRegion.h"
+#include <QByteArray>
+#include <QString>
+#include <QVector>
+
+class QDataStream;
+
+namespace ROPTool {
+
+// keeps the gadgets found in a module's region on disk, keyed by the MD5 of
+// the module's file, so that a library such as libc is only ever searched
+// once. Gadgets are stored as offsets from the start of the region along with
+// their roles and their text is decoded again on load, so the results hold
+// wherever the module ends up being loaded. Searches of just the code sections
+// and of the whole region are cached apart
+class GadgetCache {
+public:
+	GadgetCache(const IRegion::pointer &region, const QByteArray &md5, int depth, bool code_only);
+
+public:
+	bool load(QVector<Gadget> *gadgets) const;
+	bool save(const QVector<Gadget> &gadgets) const;
+	QString filename() const { return filename_; }
+
+private:
+	bool read_header(QDataStream &stream) const;
+	void write_header(QDataStream &stream) const;
+
+private:
+	IRegion::pointer region_;
+	QByteArray       md5_;
+	int              depth_;
+	bool             code_only_;
+	QString          filename_;
+};
+
+}
+
+#endif
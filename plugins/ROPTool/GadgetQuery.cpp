@@ -0,0 +1,246 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "GadgetQuery.h"
+#include "Gadget.h"
+#include <QCoreApplication>
+#include <QRegExp>
+#include <QStringList>
+
+namespace ROPTool {
+
+namespace {
+
+//------------------------------------------------------------------------------
+// Name: tr
+// Desc:
+//------------------------------------------------------------------------------
+QString tr(const char *text) {
+	return QCoreApplication::translate("ROPTool::GadgetQuery", text);
+}
+
+//------------------------------------------------------------------------------
+// Name: role_mask
+// Desc:
+//------------------------------------------------------------------------------
+quint32 role_mask(const QString &name) {
+	if(name == "alu") {
+		return Gadget::ROLE_ALU;
+	}
+	if(name == "stack") {
+		return Gadget::ROLE_STACK;
+	}
+	if(name == "logic") {
+		return Gadget::ROLE_LOGIC;
+	}
+	if(name == "data") {
+		return Gadget::ROLE_DATA;
+	}
+	if(name == "other") {
+		return Gadget::ROLE_OTHER;
+	}
+	return 0;
+}
+
+//------------------------------------------------------------------------------
+// Name: ending_mask
+// Desc:
+//------------------------------------------------------------------------------
+quint32 ending_mask(const QString &name) {
+	if(name == "ret") {
+		return Gadget::ENDS_RET;
+	}
+	if(name == "syscall") {
+		return Gadget::ENDS_SYSCALL;
+	}
+	if(name == "jmp") {
+		return Gadget::ENDS_JMP;
+	}
+	return 0;
+}
+
+}
+
+//------------------------------------------------------------------------------
+// Name: split
+// Desc: breaks a query up at spaces, except for those in quotes
+//------------------------------------------------------------------------------
+QStringList GadgetQuery::split(const QString &query, QString *error) {
+
+	QStringList tokens;
+	QString     token;
+	bool        quoted = false;
+
+	Q_FOREACH(const QChar ch, query) {
+		if(ch == QLatin1Char('"')) {
+			quoted = !quoted;
+			token.append(ch);
+		} else if(ch.isSpace() && !quoted) {
+			if(!token.isEmpty()) {
+				tokens.push_back(token);
+				token.clear();
+			}
+		} else {
+			token.append(ch);
+		}
+	}
+
+	if(quoted) {
+		*error = tr("Missing closing quote");
+		return QStringList();
+	}
+
+	if(!token.isEmpty()) {
+		tokens.push_back(token);
+	}
+
+	return tokens;
+}
+
+//------------------------------------------------------------------------------
+// Name: parse_term
+// Desc:
+//------------------------------------------------------------------------------
+bool GadgetQuery::parse_term(const QString &token, Term *term, QString *error) {
+
+	QString s = token;
+
+	term->negated = false;
+	term->mask    = 0;
+	term->length  = 0;
+	term->compare = Term::EQUAL;
+
+	if(s.startsWith(QLatin1Char('-')) && s.size() > 1) {
+		term->negated = true;
+		s.remove(0, 1);
+	}
+
+	const QString lower = s.toLower();
+	QRegExp length_regex("len(<=|>=|<|>|=)(\\d+)");
+
+	if(lower.startsWith("role:") || lower.startsWith("ends:")) {
+		const bool is_role = lower.startsWith("role:");
+		term->type = is_role ? Term::TERM_ROLE : Term::TERM_ENDS;
+
+		Q_FOREACH(const QString &name, lower.mid(5).split(QLatin1Char(','))) {
+			const quint32 mask = is_role ? role_mask(name) : ending_mask(name);
+			if(mask == 0) {
+				*error = tr("Unknown value \"%1\" in \"%2\"").arg(name, token);
+				return false;
+			}
+			term->mask |= mask;
+		}
+	} else if(length_regex.exactMatch(lower)) {
+		const QString op = length_regex.cap(1);
+
+		term->type   = Term::TERM_LENGTH;
+		term->length = length_regex.cap(2).toUInt();
+
+		if(op == "<") {
+			term->compare = Term::LESS;
+		} else if(op == "<=") {
+			term->compare = Term::LESS_EQUAL;
+		} else if(op == ">=") {
+			term->compare = Term::GREATER_EQUAL;
+		} else if(op == ">") {
+			term->compare = Term::GREATER;
+		} else {
+			term->compare = Term::EQUAL;
+		}
+	} else {
+		term->type = Term::TERM_TEXT;
+		term->text = s;
+		term->text.remove(QLatin1Char('"'));
+
+		if(term->text.isEmpty()) {
+			*error = tr("Empty term \"%1\"").arg(token);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+//------------------------------------------------------------------------------
+// Name: parse
+// Desc: on failure <error> says why and the old query is kept
+//------------------------------------------------------------------------------
+bool GadgetQuery::parse(const QString &query, QString *error) {
+
+	Q_ASSERT(error);
+
+	error->clear();
+	const QStringList tokens = split(query, error);
+	if(!error->isEmpty()) {
+		return false;
+	}
+
+	QVector<Term> terms;
+	Q_FOREACH(const QString &token, tokens) {
+		Term term;
+		if(!parse_term(token, &term, error)) {
+			return false;
+		}
+		terms.push_back(term);
+	}
+
+	terms_ = terms;
+	return true;
+}
+
+//------------------------------------------------------------------------------
+// Name: matches
+// Desc:
+//------------------------------------------------------------------------------
+bool GadgetQuery::matches(const Term &term, const QString &text, quint32 role, quint32 ending, quint32 count) {
+
+	switch(term.type) {
+	case Term::TERM_TEXT:
+		return text.contains(term.text, Qt::CaseInsensitive);
+	case Term::TERM_ROLE:
+		return (role & term.mask) != 0;
+	case Term::TERM_ENDS:
+		return (ending & term.mask) != 0;
+	case Term::TERM_LENGTH:
+		switch(term.compare) {
+		case Term::LESS:          return count < term.length;
+		case Term::LESS_EQUAL:    return count <= term.length;
+		case Term::GREATER_EQUAL: return count >= term.length;
+		case Term::GREATER:       return count > term.length;
+		default:                  return count == term.length;
+		}
+	}
+
+	return false;
+}
+
+//------------------------------------------------------------------------------
+// Name: matches
+// Desc: an empty query matches everything
+//------------------------------------------------------------------------------
+bool GadgetQuery::matches(const QString &text, quint32 role, quint32 ending, quint32 count) const {
+
+	Q_FOREACH(const Term &term, terms_) {
+		if(matches(term, text, role, ending, count) == term.negated) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+}
@@ -0,0 +1,81 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef GADGET_QUERY_20261014_H_
+#define GADGET_QUERY_20261014_H_
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+namespace ROPTool {
+
+// picks gadgets by what they do. A query is a list of terms, separated by
+// spaces, which must all match. A term starting with a '-' must not match:
+//
+//     pop              the gadget's text contains "pop"
+//     "pop rdi"        the gadget's text contains "pop rdi"
+//     role:stack       its role is one of alu, stack, logic, data or other,
+//                      "role:alu,logic" matches either
+//     ends:ret         it ends with a ret, syscall or jmp
+//     len<=2           it is that many instructions long, the last one
+//                      included. Takes <, <=, =, >= and >
+//
+// for example: "role:stack -ends:syscall pop len<3"
+class GadgetQuery {
+public:
+	bool parse(const QString &query, QString *error);
+	bool matches(const QString &text, quint32 role, quint32 ending, quint32 count) const;
+	bool empty() const { return terms_.isEmpty(); }
+
+private:
+	struct Term {
+		enum Type {
+			TERM_TEXT,
+			TERM_ROLE,
+			TERM_ENDS,
+			TERM_LENGTH
+		};
+
+		enum Compare {
+			LESS,
+			LESS_EQUAL,
+			EQUAL,
+			GREATER_EQUAL,
+			GREATER
+		};
+
+		Type    type;
+		bool    negated;
+		QString text;
+		quint32 mask;
+		Compare compare;
+		quint32 length;
+	};
+
+private:
+	static QStringList split(const QString &query, QString *error);
+	static bool parse_term(const QString &token, Term *term, QString *error);
+	static bool matches(const Term &term, const QString &text, quint32 role, quint32 ending, quint32 count);
+
+private:
+	QVector<Term> terms_;
+};
+
+}
+
+#endif
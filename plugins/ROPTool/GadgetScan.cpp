@@ -0,0 +1,389 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "GadgetScan.h"
+#include "Instruction.h"
+#include <QProgressBar>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace ROPTool {
+
+namespace {
+
+bool is_nop(const edb::Instruction &inst) {
+	if(inst) {
+		if(edisassm::is_nop(inst)) {
+			return true;
+		}
+
+		// TODO: does this effect flags?
+		if(inst.type() == edb::Instruction::OP_MOV && inst.operand_count() == 2) {
+			if(inst.operands()[0].general_type() == edb::Operand::TYPE_REGISTER && inst.operands()[1].general_type() == edb::Operand::TYPE_REGISTER) {
+				if(inst.operands()[0].reg() == inst.operands()[1].reg()) {
+					return true;
+				}
+			}
+
+		}
+
+		// TODO: does this effect flags?
+		if(inst.type() == edb::Instruction::OP_XCHG && inst.operand_count() == 2) {
+			if(inst.operands()[0].general_type() == edb::Operand::TYPE_REGISTER && inst.operands()[1].general_type() == edb::Operand::TYPE_REGISTER) {
+				if(inst.operands()[0].reg() == inst.operands()[1].reg()) {
+					return true;
+				}
+			}
+
+		}
+
+		// TODO: support LEA reg, [reg]
+
+	}
+	return false;
+}
+
+//------------------------------------------------------------------------------
+// Name: gadget_role
+// Desc: which of the "Gadgets to Display" groups a gadget starting with <inst>
+//       is in
+//------------------------------------------------------------------------------
+quint32 gadget_role(const edb::Instruction &inst) {
+
+	switch(inst.type()) {
+	case edb::Instruction::OP_ADD:
+	case edb::Instruction::OP_ADC:
+	case edb::Instruction::OP_SUB:
+	case edb::Instruction::OP_SBB:
+	case edb::Instruction::OP_IMUL:
+	case edb::Instruction::OP_MUL:
+	case edb::Instruction::OP_IDIV:
+	case edb::Instruction::OP_DIV:
+	case edb::Instruction::OP_INC:
+	case edb::Instruction::OP_DEC:
+	case edb::Instruction::OP_NEG:
+	case edb::Instruction::OP_CMP:
+	case edb::Instruction::OP_DAA:
+	case edb::Instruction::OP_DAS:
+	case edb::Instruction::OP_AAA:
+	case edb::Instruction::OP_AAS:
+	case edb::Instruction::OP_AAM:
+	case edb::Instruction::OP_AAD:
+		// ALU ops
+		return Gadget::ROLE_ALU;
+	case edb::Instruction::OP_PUSH:
+	case edb::Instruction::OP_PUSHA:
+	case edb::Instruction::OP_POP:
+	case edb::Instruction::OP_POPA:
+		// stack ops
+		return Gadget::ROLE_STACK;
+	case edb::Instruction::OP_AND:
+	case edb::Instruction::OP_OR:
+	case edb::Instruction::OP_XOR:
+	case edb::Instruction::OP_NOT:
+	case edb::Instruction::OP_SAR:
+	case edb::Instruction::OP_SAL:
+	case edb::Instruction::OP_SHR:
+	case edb::Instruction::OP_SHL:
+	case edb::Instruction::OP_SHRD:
+	case edb::Instruction::OP_SHLD:
+	case edb::Instruction::OP_ROR:
+	case edb::Instruction::OP_ROL:
+	case edb::Instruction::OP_RCR:
+	case edb::Instruction::OP_RCL:
+	case edb::Instruction::OP_BT:
+	case edb::Instruction::OP_BTS:
+	case edb::Instruction::OP_BTR:
+	case edb::Instruction::OP_BTC:
+	case edb::Instruction::OP_BSF:
+	case edb::Instruction::OP_BSR:
+		// logic ops
+		return Gadget::ROLE_LOGIC;
+	case edb::Instruction::OP_MOV:
+	case edb::Instruction::OP_CMOVCC:
+	case edb::Instruction::OP_XCHG:
+	case edb::Instruction::OP_BSWAP:
+	case edb::Instruction::OP_XADD:
+	case edb::Instruction::OP_CMPXCHG:
+	case edb::Instruction::OP_CWD:
+	case edb::Instruction::OP_CDQ:
+	case edb::Instruction::OP_CQO:
+	case edb::Instruction::OP_CDQE:
+	case edb::Instruction::OP_CBW:
+	case edb::Instruction::OP_CWDE:
+	case edb::Instruction::OP_MOVSX:
+	case edb::Instruction::OP_MOVZX:
+	case edb::Instruction::OP_MOVSXD:
+	case edb::Instruction::OP_MOVBE:
+	case edb::Instruction::OP_MOVS:
+	case edb::Instruction::OP_CMPS:
+	case edb::Instruction::OP_CMPSW:
+	case edb::Instruction::OP_SCAS:
+	case edb::Instruction::OP_LODS:
+	case edb::Instruction::OP_STOS:
+	case edb::Instruction::OP_CMPXCHG8B:
+	case edb::Instruction::OP_CMPXCHG16B:
+		// data ops
+		return Gadget::ROLE_DATA;
+	default:
+		// other ops
+		return Gadget::ROLE_OTHER;
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: is_syscall
+// Desc: int 0x80, sysenter or syscall, these make a gadget all on their own
+//------------------------------------------------------------------------------
+bool is_syscall(const edb::Instruction &inst) {
+	switch(inst.type()) {
+	case edb::Instruction::OP_INT:
+		return inst.operands()[0].general_type() == edb::Operand::TYPE_IMMEDIATE && (inst.operands()[0].immediate() & 0xff) == 0x80;
+	case edb::Instruction::OP_SYSENTER:
+	case edb::Instruction::OP_SYSCALL:
+		return true;
+	default:
+		return false;
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: ending
+// Desc: how a gadget ending in <inst> hands control back, 0 if <inst> can't
+//       end one
+//------------------------------------------------------------------------------
+quint32 ending(const edb::Instruction &inst) {
+	if(is_ret(inst)) {
+		return Gadget::ENDS_RET;
+	}
+
+	if(is_syscall(inst)) {
+		return Gadget::ENDS_SYSCALL;
+	}
+
+	if(inst.type() == edb::Instruction::OP_JMP && inst.operand_count() == 1 && inst.operands()[0].general_type() == edb::Operand::TYPE_REGISTER) {
+		return Gadget::ENDS_JMP;
+	}
+
+	return 0;
+}
+
+//------------------------------------------------------------------------------
+// Name: terminator_size
+// Desc: if <p> looks like the start of a ret, ret imm16, retf, retf imm16,
+//       syscall, sysenter, int 0x80 or jmp reg returns its size, otherwise 0.
+//       Only a guess, the decoder has the final say
+//------------------------------------------------------------------------------
+std::size_t terminator_size(const quint8 *p, const quint8 *last) {
+
+	const std::size_t n = last - p;
+
+	switch(p[0]) {
+	case 0xc3:
+	case 0xcb:
+		return 1;
+	case 0xc2:
+	case 0xca:
+		return n >= 3 ? 3 : 0;
+	case 0x0f:
+		return (n >= 2 && (p[1] == 0x05 || p[1] == 0x34)) ? 2 : 0;
+	case 0xcd:
+		return (n >= 2 && p[1] == 0x80) ? 2 : 0;
+	case 0xff:
+		// FF /4 with a register operand
+		return (n >= 2 && (p[1] & 0xf8) == 0xe0) ? 2 : 0;
+	default:
+		return 0;
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: next_candidate
+// Desc: finds the next byte in [p, last) that a terminator can start with,
+//       with SSE2 this looks at 16 bytes at a time
+//------------------------------------------------------------------------------
+const quint8 *next_candidate(const quint8 *p, const quint8 *last) {
+
+#ifdef __SSE2__
+	// C2, C3, CA and CB only differ in bits 0 and 3
+	const __m128i ret_mask  = _mm_set1_epi8(static_cast<char>(0xf6));
+	const __m128i ret       = _mm_set1_epi8(static_cast<char>(0xc2));
+	const __m128i escape    = _mm_set1_epi8(static_cast<char>(0x0f));
+	const __m128i interrupt = _mm_set1_epi8(static_cast<char>(0xcd));
+	const __m128i group5    = _mm_set1_epi8(static_cast<char>(0xff));
+
+	while(last - p >= 16) {
+		const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+
+		__m128i hits = _mm_cmpeq_epi8(_mm_and_si128(v, ret_mask), ret);
+		hits = _mm_or_si128(hits, _mm_cmpeq_epi8(v, escape));
+		hits = _mm_or_si128(hits, _mm_cmpeq_epi8(v, interrupt));
+		hits = _mm_or_si128(hits, _mm_cmpeq_epi8(v, group5));
+
+		if(const unsigned int mask = _mm_movemask_epi8(hits)) {
+			return p + __builtin_ctz(mask);
+		}
+
+		p += 16;
+	}
+#endif
+
+	for(; p != last; ++p) {
+		switch(*p) {
+		case 0xc2:
+		case 0xc3:
+		case 0xca:
+		case 0xcb:
+		case 0x0f:
+		case 0xcd:
+		case 0xff:
+			return p;
+		default:
+			break;
+		}
+	}
+
+	return last;
+}
+
+}
+
+//------------------------------------------------------------------------------
+// Name: GadgetScan
+// Desc:
+//------------------------------------------------------------------------------
+GadgetScan::GadgetScan(int depth, QProgressBar *progress) : depth_(depth), reach_(depth * edb::Instruction::MAX_SIZE), progress_(progress) {
+}
+
+//------------------------------------------------------------------------------
+// Name: lookahead
+// Desc: the furthest a terminator can end from the start of its gadget
+//------------------------------------------------------------------------------
+std::size_t GadgetScan::lookahead() const {
+	return reach_ + 3;
+}
+
+//------------------------------------------------------------------------------
+// Name: merge
+// Desc:
+//------------------------------------------------------------------------------
+void GadgetScan::merge(Result *result) {
+	gadgets += static_cast<List<Gadget> *>(result)->items;
+}
+
+//------------------------------------------------------------------------------
+// Name: progress
+// Desc:
+//------------------------------------------------------------------------------
+void GadgetScan::progress(int percent) {
+	if(progress_) {
+		progress_->setValue(percent);
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: decode
+// Desc: true if [first, last) is up to depth instructions and NOPs ending in a
+//       terminator, a ret or jmp needs at least one instruction before it
+//------------------------------------------------------------------------------
+bool GadgetScan::decode(const quint8 *first, const quint8 *last, edb::address_t address, Gadget *gadget) const {
+
+	const quint8 *p = first;
+	quint32 role    = 0;
+
+	for(int count = 0; count <= depth_ && p < last; ++count) {
+
+		const edb::Instruction inst(p, last, address + (p - first), std::nothrow);
+		if(!inst) {
+			return false;
+		}
+
+		p += inst.size();
+
+		if(const quint32 how = ending(inst)) {
+
+			if(p != last || (role == 0 && how != Gadget::ENDS_SYSCALL)) {
+				return false;
+			}
+
+			gadget->address = address;
+			gadget->bytes   = QByteArray(reinterpret_cast<const char *>(first), last - first);
+			gadget->text    = gadget_text(gadget->bytes, address);
+			gadget->role    = role ? role : gadget_role(inst);
+			gadget->ending  = how;
+			gadget->count   = count + 1;
+			return true;
+		}
+
+		if(is_nop(inst)) {
+			continue;
+		}
+
+		// anything else which changes where execution goes ends the search
+		if(is_jump(inst) || is_call(inst) || inst.type() == edb::Instruction::OP_INT) {
+			return false;
+		}
+
+		// the gadget's role is that of its first instruction which isn't a NOP
+		if(role == 0) {
+			role = gadget_role(inst);
+		}
+	}
+
+	return false;
+}
+
+//------------------------------------------------------------------------------
+// Name: scan
+// Desc: runs on a pool thread
+//------------------------------------------------------------------------------
+RegionScanner::Task::Result *GadgetScan::scan(const RegionScanner::Chunk &chunk) const {
+
+	List<Gadget> *const result = new List<Gadget>;
+
+	const quint8 *const first      = chunk.data.constData();
+	const quint8 *const window_end = first + chunk.size;
+	const quint8 *const last       = first + chunk.data.size();
+
+	// a terminator this far past the window can still end a gadget which
+	// starts in it
+	const quint8 *const search_end = first + qMin<std::size_t>(chunk.data.size(), chunk.size + reach_);
+
+	for(const quint8 *t = next_candidate(first, search_end); t != search_end; t = next_candidate(t + 1, search_end)) {
+
+		const std::size_t size = terminator_size(t, last);
+		if(size == 0) {
+			continue;
+		}
+
+		const quint8 *const end = t + size;
+
+		for(const quint8 *s = (static_cast<std::size_t>(t - first) > reach_) ? t - reach_ : first; s <= t && s < window_end; ++s) {
+			Gadget gadget;
+			if(decode(s, end, chunk.address + (s - first), &gadget)) {
+				result->items.push_back(gadget);
+			}
+		}
+	}
+
+	return result;
+}
+
+}
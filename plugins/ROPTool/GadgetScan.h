@@ -0,0 +1,59 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef GADGETSCAN_20261014_H_
+#define GADGETSCAN_20261014_H_
+
+#include "Gadget.h"
+#include "RegionScanner.h"
+#include <QVector>
+
+class QProgressBar;
+
+namespace ROPTool {
+
+// finds the terminators in each window and decodes backwards from them, that
+// is, tries every start up to depth instructions' worth of bytes in front of
+// one and keeps those which decode to a run of instructions ending exactly on
+// it. Gadgets belong to the window they start in
+class GadgetScan : public RegionScanner::Task {
+public:
+	// <progress> may be null, for searches which nobody is watching
+	GadgetScan(int depth, QProgressBar *progress);
+
+public:
+	virtual std::size_t lookahead() const;
+	virtual Result *scan(const RegionScanner::Chunk &chunk) const;
+	virtual void merge(Result *result);
+	virtual void progress(int percent);
+
+public:
+	QVector<Gadget> gadgets;
+
+private:
+	bool decode(const quint8 *first, const quint8 *last, edb::address_t address, Gadget *gadget) const;
+
+private:
+	const int           depth_;
+	const std::size_t   reach_;
+	QProgressBar *const progress_;
+};
+
+}
+
+#endif
@@ -19,6 +19,8 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "ROPTool.h"
 #include "edb.h"
 #include "DialogROPTool.h"
+#include "GadgetScan.h"
+#include "RegionScanner.h"
 #include <QMenu>
 
 namespace ROPTool {
@@ -68,6 +70,34 @@ void ROPTool::show_menu() {
 }
 
 
+//------------------------------------------------------------------------------
+// Name: run_benchmarks
+// Desc: the gadget search over all of <regions> at the dialog's default depth
+//       and its deepest, the gadget cache isn't used
+//------------------------------------------------------------------------------
+QList<BenchmarkResult> ROPTool::run_benchmarks(const QList<IRegion::pointer> &regions) {
+
+	static const int depths[] = { 3, 8 };
+
+	const quint64 bytes = BenchmarkRun::bytes(regions);
+
+	BenchmarkRun run("DialogROPTool::do_find", "gadgets");
+
+	for(std::size_t i = 0; i < sizeof(depths) / sizeof(depths[0]); ++i) {
+
+		run.start();
+
+		GadgetScan scan(depths[i], 0);
+		RegionScanner().run(regions, &scan);
+
+		QVariantMap parameters;
+		parameters["depth"] = depths[i];
+		run.finish(parameters, bytes, scan.gadgets.size());
+	}
+
+	return run.results();
+}
+
 #if QT_VERSION < 0x050000
 Q_EXPORT_PLUGIN2(ROPTool, ROPTool)
 #endif
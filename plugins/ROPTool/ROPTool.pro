@@ -2,7 +2,8 @@
 include(../plugins.pri)
 
 # Input
-HEADERS += ROPTool.h DialogROPTool.h
+HEADERS += ROPTool.h DialogROPTool.h Gadget.h GadgetCache.h GadgetQuery.h GadgetScan.h
 FORMS += DialogROPTool.ui
-SOURCES += ROPTool.cpp DialogROPTool.cpp
+SOURCES += ROPTool.cpp DialogROPTool.cpp Gadget.cpp GadgetCache.cpp GadgetQuery.cpp GadgetScan.cpp
+OTHER_FILES += ROPTool.json
 
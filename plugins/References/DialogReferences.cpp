@@ -17,9 +17,12 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
 #include "DialogReferences.h"
+#include "IAnalyzer.h"
 #include "IDebugger.h"
 #include "MemoryRegions.h"
-#include "Util.h"
+#include "ReferenceScan.h"
+#include "RegionScanner.h"
+#include "ResultsModel.h"
 #include "edb.h"
 
 #include <QMessageBox>
@@ -29,17 +32,13 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 namespace References {
 
-enum Role {
-	TypeRole    = Qt::UserRole + 0,
-	AddressRole = Qt::UserRole + 1
-};
-
 //------------------------------------------------------------------------------
 // Name: DialogReferences
 // Desc: constructor
 //------------------------------------------------------------------------------
-DialogReferences::DialogReferences(QWidget *parent) : QDialog(parent), ui(new Ui::DialogReferences) {
+DialogReferences::DialogReferences(QWidget *parent) : QDialog(parent), ui(new Ui::DialogReferences), model_(new ResultsModel(this)) {
 	ui->setupUi(this);
+	ui->listView->setModel(model_);
 	connect(this, SIGNAL(updateProgress(int)), ui->progressBar, SLOT(setValue(int)));
 }
 
@@ -56,7 +55,7 @@ DialogReferences::~DialogReferences() {
 // Desc:
 //------------------------------------------------------------------------------
 void DialogReferences::showEvent(QShowEvent *) {
-	ui->listWidget->clear();
+	model_->clear();
 	ui->progressBar->setValue(0);
 }
 
@@ -66,99 +65,44 @@ void DialogReferences::showEvent(QShowEvent *) {
 //------------------------------------------------------------------------------
 void DialogReferences::do_find() {
 	bool ok;
-	const edb::address_t address   = edb::v1::string_to_address(ui->txtAddress->text(), &ok);
-	const edb::address_t page_size = edb::v1::debugger_core->page_size();
+	const edb::address_t address = edb::v1::string_to_address(ui->txtAddress->text(), &ok);
 
 	if(ok) {
 		edb::v1::memory_regions().sync();
 		const QList<IRegion::pointer> regions = edb::v1::memory_regions().regions();
 
-		int i = 0;
+		IAnalyzer *const analyzer = edb::v1::analyzer();
+
+		// an analyzed region already knows what in it refers to what, only
+		// the others have to be searched
+		QList<IRegion::pointer>       unanalyzed;
+		QVector<ResultsModel::Result> known;
+
 		Q_FOREACH(const IRegion::pointer &region, regions) {
-			// a short circut for speading things up
-			if(region->accessible() || !ui->chkSkipNoAccess->isChecked()) {
-
-				const size_t page_count     = region->size() / page_size;
-				const QVector<quint8> pages = edb::v1::read_pages(region->start(), page_count);
-
-				if(!pages.isEmpty()) {
-					const quint8 *p = &pages[0];
-					const quint8 *const pages_end = &pages[0] + region->size();
-
-					while(p != pages_end) {
-
-						if(static_cast<std::size_t>(pages_end - p) < sizeof(edb::address_t)) {
-							break;
-						}
-
-						const edb::address_t addr = p - &pages[0] + region->start();
-
-						edb::address_t test_address;
-						memcpy(&test_address, p, sizeof(edb::address_t));
-
-						if(test_address == address) {
-							QListWidgetItem *const item = new QListWidgetItem(edb::v1::format_pointer(addr));
-							item->setData(TypeRole, 'D');
-							item->setData(AddressRole, addr);
-							ui->listWidget->addItem(item);
-						}
-
-						edb::Instruction inst(p, pages_end, addr, std::nothrow);
-
-						if(inst) {
-							switch(inst.type()) {
-							case edb::Instruction::OP_JMP:
-							case edb::Instruction::OP_CALL:
-							case edb::Instruction::OP_JCC:
-								if(inst.operands()[0].general_type() == edb::Operand::TYPE_REL) {
-									if(inst.operands()[0].relative_target() == address) {
-										QListWidgetItem *const item = new QListWidgetItem(edb::v1::format_pointer(addr));
-										item->setData(TypeRole, 'C');
-										item->setData(AddressRole, addr);
-										ui->listWidget->addItem(item);
-									}
-								}
-								break;
-							case edb::Instruction::OP_MOV:
-								// instructions of the form: mov [ADDR], 0xNNNNNNNN
-								Q_ASSERT(inst.operand_count() == 2);
-
-								if(inst.operands()[0].general_type() == edb::Operand::TYPE_EXPRESSION) {
-									if(inst.operands()[1].general_type() == edb::Operand::TYPE_IMMEDIATE && static_cast<edb::address_t>(inst.operands()[1].immediate()) == address) {
-										QListWidgetItem *const item = new QListWidgetItem(edb::v1::format_pointer(addr));
-										item->setData(TypeRole, 'C');
-										item->setData(AddressRole, addr);
-										ui->listWidget->addItem(item);
-									}
-								}
-
-								break;
-							case edb::Instruction::OP_PUSH:
-								// instructions of the form: push 0xNNNNNNNN
-								Q_ASSERT(inst.operand_count() == 1);
-
-								if(inst.operands()[0].general_type() == edb::Operand::TYPE_IMMEDIATE && static_cast<edb::address_t>(inst.operands()[0].immediate()) == address) {
-									QListWidgetItem *const item = new QListWidgetItem(edb::v1::format_pointer(addr));
-									item->setData(TypeRole, 'C');
-									item->setData(AddressRole, addr);
-									ui->listWidget->addItem(item);
-								}
-								break;
-							default:
-								break;
-							}
-						}
-
-						emit updateProgress(util::percentage(i, regions.size(), p - &pages[0], region->size()));
-						++p;
+
+			IAnalyzer::ReferenceList references;
+
+			if(analyzer && analyzer->references(region, address, &references)) {
+				Q_FOREACH(const IAnalyzer::Reference &ref, references) {
+					const bool pointer = ref.type == IAnalyzer::Reference::REF_POINTER;
+					if(pointer ? ui->chkData->isChecked() : ui->chkCode->isChecked()) {
+						known.push_back(make_reference(ref.source, pointer ? 'D' : 'C'));
 					}
 				}
 
-			} else {
-				emit updateProgress(util::percentage(i, regions.size()));
+			// a short circut for speading things up
+			} else if(region->accessible() || !ui->chkSkipNoAccess->isChecked()) {
+				unanalyzed.push_back(region);
 			}
-			++i;
 		}
+
+		model_->addResults(known);
+
+		ReferenceScan scan(model_, ui->progressBar, address, ui->chkData->isChecked(), ui->chkCode->isChecked());
+		RegionScanner().run(unanalyzed, &scan);
+
+		// the analyzed regions' references came first, put them all in order
+		model_->sort(0);
 	}
 }
 
@@ -169,19 +113,20 @@ void DialogReferences::do_find() {
 void DialogReferences::on_btnFind_clicked() {
 	ui->btnFind->setEnabled(false);
 	ui->progressBar->setValue(0);
-	ui->listWidget->clear();
+	model_->clear();
 	do_find();
 	ui->progressBar->setValue(100);
 	ui->btnFind->setEnabled(true);
 }
 
 //------------------------------------------------------------------------------
-// Name: on_listWidget_itemDoubleClicked
+// Name: on_listView_doubleClicked
 // Desc: follows the found item in the data view
 //------------------------------------------------------------------------------
-void DialogReferences::on_listWidget_itemDoubleClicked(QListWidgetItem *item) {
-	const edb::address_t addr = item->data(AddressRole).toULongLong();
-	if(item->data(TypeRole).toChar() == 'D') {
+void DialogReferences::on_listView_doubleClicked(const QModelIndex &index) {
+	const ResultsModel::Result &r = model_->result(index);
+	const edb::address_t addr     = r.address;
+	if(r.type == 'D') {
 		edb::v1::dump_data(addr, false);
 	} else {
 		edb::v1::jump_to_address(addr);
@@ -23,7 +23,8 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "Types.h"
 #include "IRegion.h"
 
-class QListWidgetItem;
+class QModelIndex;
+class ResultsModel;
 
 namespace References {
 
@@ -38,7 +39,7 @@ public:
 
 public Q_SLOTS:
 	void on_btnFind_clicked();
-	void on_listWidget_itemDoubleClicked(QListWidgetItem *item);
+	void on_listView_doubleClicked(const QModelIndex &index);
 
 Q_SIGNALS:
 	void updateProgress(int);
@@ -51,6 +52,7 @@ private:
 
 private:
 	 Ui::DialogReferences *const ui;
+	 ResultsModel         *const model_;
 };
 
 }
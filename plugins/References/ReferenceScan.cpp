@@ -0,0 +1,330 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "ReferenceScan.h"
+#include "Instruction.h"
+#include <QProgressBar>
+
+#include <algorithm>
+#include <cstring>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace References {
+
+namespace {
+
+//------------------------------------------------------------------------------
+// Name: is_prefix
+// Desc:
+//------------------------------------------------------------------------------
+bool is_prefix(quint8 byte) {
+	switch(byte) {
+	case 0x26:
+	case 0x2e:
+	case 0x36:
+	case 0x3e:
+	case 0x64:
+	case 0x65:
+	case 0x66:
+	case 0x67:
+	case 0xf0:
+	case 0xf2:
+	case 0xf3:
+		return true;
+	default:
+		return false;
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: read_rel32
+// Desc:
+//------------------------------------------------------------------------------
+qint32 read_rel32(const quint8 *p) {
+	qint32 rel;
+	memcpy(&rel, p, sizeof(rel));
+	return rel;
+}
+
+//------------------------------------------------------------------------------
+// Name: next_branch
+// Desc: finds the next byte in [p, last) which can start a relative call or
+//       jump: E8, E9 and 0F (for 0F 8x), and if <short_branches> is set also
+//       EB, 7x and E0 to E3. With SSE2 this looks at 16 bytes at a time
+//------------------------------------------------------------------------------
+const quint8 *next_branch(const quint8 *p, const quint8 *last, bool short_branches) {
+
+#ifdef __SSE2__
+	const __m128i mask_fe = _mm_set1_epi8(static_cast<char>(0xfe));
+	const __m128i mask_f0 = _mm_set1_epi8(static_cast<char>(0xf0));
+	const __m128i mask_fc = _mm_set1_epi8(static_cast<char>(0xfc));
+	const __m128i call    = _mm_set1_epi8(static_cast<char>(0xe8));
+	const __m128i escape  = _mm_set1_epi8(static_cast<char>(0x0f));
+	const __m128i jmp8    = _mm_set1_epi8(static_cast<char>(0xeb));
+	const __m128i jcc8    = _mm_set1_epi8(static_cast<char>(0x70));
+	const __m128i loop    = _mm_set1_epi8(static_cast<char>(0xe0));
+
+	while(last - p >= 16) {
+		const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+
+		__m128i hits = _mm_or_si128(_mm_cmpeq_epi8(_mm_and_si128(v, mask_fe), call), _mm_cmpeq_epi8(v, escape));
+		if(short_branches) {
+			hits = _mm_or_si128(hits, _mm_cmpeq_epi8(v, jmp8));
+			hits = _mm_or_si128(hits, _mm_cmpeq_epi8(_mm_and_si128(v, mask_f0), jcc8));
+			hits = _mm_or_si128(hits, _mm_cmpeq_epi8(_mm_and_si128(v, mask_fc), loop));
+		}
+
+		if(const unsigned int mask = _mm_movemask_epi8(hits)) {
+			return p + __builtin_ctz(mask);
+		}
+
+		p += 16;
+	}
+#endif
+
+	for(; p != last; ++p) {
+		const quint8 b = *p;
+		if((b & 0xfe) == 0xe8 || b == 0x0f) {
+			return p;
+		}
+
+		if(short_branches && (b == 0xeb || (b & 0xf0) == 0x70 || (b & 0xfc) == 0xe0)) {
+			return p;
+		}
+	}
+
+	return last;
+}
+
+}
+
+//------------------------------------------------------------------------------
+// Name: make_reference
+// Desc:
+//------------------------------------------------------------------------------
+ResultsModel::Result make_reference(edb::address_t address, char type) {
+	const ResultsModel::Result r = { address, static_cast<quint32>(type), 0 };
+	return r;
+}
+
+//------------------------------------------------------------------------------
+// Name: ReferenceScan
+// Desc:
+//------------------------------------------------------------------------------
+ReferenceScan::ReferenceScan(ResultsModel *model, QProgressBar *progress, edb::address_t address, bool data, bool code)
+	: model_(model), progress_(progress), address_(address), data_(data), code_(code),
+	  pointer_searcher_(QByteArray(reinterpret_cast<const char *>(&address_), sizeof(address_))),
+	  immediate_searcher_(QByteArray(reinterpret_cast<const char *>(&address_), sizeof(qint32))),
+	  has_immediate_(static_cast<edb::address_t>(static_cast<qint32>(address_)) == address_),
+	  matches_(0) {
+}
+
+//------------------------------------------------------------------------------
+// Name: lookahead
+// Desc: keep enough bytes past the end of each window to decode an
+//       instruction which starts in the last few bytes of it
+//------------------------------------------------------------------------------
+std::size_t ReferenceScan::lookahead() const {
+	return edb::Instruction::MAX_SIZE;
+}
+
+//------------------------------------------------------------------------------
+// Name: merge
+// Desc:
+//------------------------------------------------------------------------------
+void ReferenceScan::merge(Result *result) {
+	const QVector<ResultsModel::Result> &items = static_cast<List<ResultsModel::Result> *>(result)->items;
+	matches_ += items.size();
+	if(model_) {
+		model_->addResults(items);
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: progress
+// Desc:
+//------------------------------------------------------------------------------
+void ReferenceScan::progress(int percent) {
+	if(progress_) {
+		progress_->setValue(percent);
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: is_code_reference
+// Desc: true if the instruction at <p> branches to, pushes or stores the
+//       address
+//------------------------------------------------------------------------------
+bool ReferenceScan::is_code_reference(const quint8 *p, const quint8 *last, edb::address_t address) const {
+
+	const edb::Instruction inst(p, last, address, std::nothrow);
+	if(!inst) {
+		return false;
+	}
+
+	switch(inst.type()) {
+	case edb::Instruction::OP_JMP:
+	case edb::Instruction::OP_CALL:
+	case edb::Instruction::OP_JCC:
+		if(inst.operands()[0].general_type() == edb::Operand::TYPE_REL) {
+			return inst.operands()[0].relative_target() == address_;
+		}
+		break;
+	case edb::Instruction::OP_MOV:
+		// instructions of the form: mov [ADDR], 0xNNNNNNNN
+		Q_ASSERT(inst.operand_count() == 2);
+
+		if(inst.operands()[0].general_type() == edb::Operand::TYPE_EXPRESSION) {
+			return inst.operands()[1].general_type() == edb::Operand::TYPE_IMMEDIATE && static_cast<edb::address_t>(inst.operands()[1].immediate()) == address_;
+		}
+		break;
+	case edb::Instruction::OP_PUSH:
+		// instructions of the form: push 0xNNNNNNNN
+		Q_ASSERT(inst.operand_count() == 1);
+
+		return inst.operands()[0].general_type() == edb::Operand::TYPE_IMMEDIATE && static_cast<edb::address_t>(inst.operands()[0].immediate()) == address_;
+	default:
+		break;
+	}
+
+	return false;
+}
+
+//------------------------------------------------------------------------------
+// Name: find_pointers
+// Desc: the address as data, at any alignment
+//------------------------------------------------------------------------------
+void ReferenceScan::find_pointers(const RegionScanner::Chunk &chunk, QVector<ResultsModel::Result> *results) const {
+
+	const quint8 *const first = chunk.data.constData();
+	const quint8 *const last  = first + qMin<std::size_t>(chunk.data.size(), chunk.size + sizeof(edb::address_t) - 1);
+
+	const quint8 *p = first;
+	while((p = pointer_searcher_.find(p, last, chunk.address + (p - first))) != last) {
+		results->push_back(make_reference(chunk.address + (p - first), 'D'));
+		++p;
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: find_branches
+// Desc: relative calls and jumps to the address. Their targets are worked out
+//       from the bytes, so only ones which really go there are decoded. Short
+//       branches are only looked for when the address is in reach of them
+//------------------------------------------------------------------------------
+void ReferenceScan::find_branches(const RegionScanner::Chunk &chunk, QVector<edb::address_t> *found) const {
+
+	const quint8 *const first      = chunk.data.constData();
+	const quint8 *const window_end = first + chunk.size;
+	const quint8 *const last       = first + chunk.data.size();
+
+	const bool short_branches = address_ + 0x100 >= chunk.address && address_ < chunk.address + chunk.size + 0x100;
+
+	for(const quint8 *p = next_branch(first, window_end, short_branches); p != window_end; p = next_branch(p + 1, window_end, short_branches)) {
+
+		const edb::address_t address = chunk.address + (p - first);
+		const std::size_t    n       = last - p;
+
+		edb::address_t target;
+		if((p[0] & 0xfe) == 0xe8 && n >= 5) {
+			target = address + 5 + read_rel32(p + 1);
+		} else if(p[0] == 0x0f && n >= 6 && (p[1] & 0xf0) == 0x80) {
+			target = address + 6 + read_rel32(p + 2);
+		} else if(p[0] != 0x0f && p[0] != 0xe8 && p[0] != 0xe9 && n >= 2) {
+			target = address + 2 + static_cast<qint8>(p[1]);
+		} else {
+			continue;
+		}
+
+		if(target != address_ || !is_code_reference(p, last, address)) {
+			continue;
+		}
+
+		found->push_back(address);
+
+		// the same branch with prefixes in front of it is just as much of one
+		for(const quint8 *q = p; q != first && p - q < 4 && is_prefix(q[-1]); --q) {
+			if(is_code_reference(q - 1, last, address - (p - q) - 1)) {
+				found->push_back(address - (p - q) - 1);
+			}
+		}
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: find_immediates
+// Desc: the address as the immediate of a push or mov. Wherever its low 32
+//       bits turn up, the instructions which may end with that immediate are
+//       decoded
+//------------------------------------------------------------------------------
+void ReferenceScan::find_immediates(const RegionScanner::Chunk &chunk, QVector<edb::address_t> *found) const {
+
+	if(!has_immediate_) {
+		return;
+	}
+
+	const quint8 *const first      = chunk.data.constData();
+	const quint8 *const window_end = first + chunk.size;
+	const quint8 *const last       = first + chunk.data.size();
+
+	const quint8 *q = first;
+	while((q = immediate_searcher_.find(q, last, chunk.address + (q - first))) != last) {
+
+		for(std::size_t k = 1; k <= edb::Instruction::MAX_SIZE - sizeof(qint32) && k <= static_cast<std::size_t>(q - first); ++k) {
+			const quint8 *const p = q - k;
+			if(p < window_end && is_code_reference(p, last, chunk.address + (p - first))) {
+				found->push_back(chunk.address + (p - first));
+			}
+		}
+
+		++q;
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: scan
+// Desc: runs on a pool thread
+//------------------------------------------------------------------------------
+RegionScanner::Task::Result *ReferenceScan::scan(const RegionScanner::Chunk &chunk) const {
+
+	List<ResultsModel::Result> *const result = new List<ResultsModel::Result>;
+
+	if(data_) {
+		find_pointers(chunk, &result->items);
+	}
+
+	if(code_) {
+		QVector<edb::address_t> found;
+		find_branches(chunk, &found);
+		find_immediates(chunk, &found);
+
+		std::sort(found.begin(), found.end());
+		found.erase(std::unique(found.begin(), found.end()), found.end());
+
+		Q_FOREACH(edb::address_t address, found) {
+			result->items.push_back(make_reference(address, 'C'));
+		}
+	}
+
+	return result;
+}
+
+}
@@ -0,0 +1,74 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef REFERENCESCAN_20261014_H_
+#define REFERENCESCAN_20261014_H_
+
+#include "ByteSearcher.h"
+#include "RegionScanner.h"
+#include "ResultsModel.h"
+#include "Types.h"
+#include <QVector>
+
+class QProgressBar;
+
+namespace References {
+
+// <type> is 'C' for code and 'D' for data
+ResultsModel::Result make_reference(edb::address_t address, char type);
+
+// looks for data which is the address, and for instructions which use it as
+// an immediate or branch target. Nothing is decoded blindly, the pointer and
+// the immediate are searched for directly and branch targets are worked out
+// from the bytes, only the instructions those turn up are decoded to be sure.
+// What is found goes into <model> and <progress> is kept up to date, either
+// may be null when nobody is looking
+class ReferenceScan : public RegionScanner::Task {
+public:
+	ReferenceScan(ResultsModel *model, QProgressBar *progress, edb::address_t address, bool data, bool code);
+
+public:
+	virtual std::size_t lookahead() const;
+	virtual Result *scan(const RegionScanner::Chunk &chunk) const;
+	virtual void merge(Result *result);
+	virtual void progress(int percent);
+
+public:
+	quint64 matches() const { return matches_; }
+
+private:
+	bool is_code_reference(const quint8 *p, const quint8 *last, edb::address_t address) const;
+	void find_pointers(const RegionScanner::Chunk &chunk, QVector<ResultsModel::Result> *results) const;
+	void find_branches(const RegionScanner::Chunk &chunk, QVector<edb::address_t> *found) const;
+	void find_immediates(const RegionScanner::Chunk &chunk, QVector<edb::address_t> *found) const;
+
+private:
+	ResultsModel *const  model_;
+	QProgressBar *const  progress_;
+	const edb::address_t address_;
+	const bool           data_;
+	const bool           code_;
+	const ByteSearcher   pointer_searcher_;
+	const ByteSearcher   immediate_searcher_;
+	const bool           has_immediate_;  // the address fits in a sign extended imm32
+	quint64              matches_;
+};
+
+}
+
+#endif
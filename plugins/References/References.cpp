@@ -18,6 +18,8 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "References.h"
 #include "DialogReferences.h"
+#include "ReferenceScan.h"
+#include "RegionScanner.h"
 #include "edb.h"
 #include <QMenu>
 
@@ -67,6 +69,50 @@ void References::show_menu() {
 	dialog_->show();
 }
 
+//------------------------------------------------------------------------------
+// Name: run_benchmarks
+// Desc: searches all of <regions> for what refers to the start of the first
+//       one, for data and code references apart and together. Unlike the
+//       dialog this doesn't take what the analyzer knows, everything is
+//       searched
+//------------------------------------------------------------------------------
+QList<BenchmarkResult> References::run_benchmarks(const QList<IRegion::pointer> &regions) {
+
+	static const struct {
+		bool data;
+		bool code;
+	} kinds[] = {
+		{ true,  false },
+		{ false, true  },
+		{ true,  true  }
+	};
+
+	BenchmarkRun run("DialogReferences::do_find", "references");
+
+	if(regions.isEmpty()) {
+		return run.results();
+	}
+
+	const edb::address_t address = regions.first()->start();
+	const quint64        bytes   = BenchmarkRun::bytes(regions);
+
+	for(std::size_t i = 0; i < sizeof(kinds) / sizeof(kinds[0]); ++i) {
+
+		run.start();
+
+		ReferenceScan scan(0, 0, address, kinds[i].data, kinds[i].code);
+		RegionScanner().run(regions, &scan);
+
+		QVariantMap parameters;
+		parameters["address"] = edb::v1::format_pointer(address);
+		parameters["data"]    = kinds[i].data;
+		parameters["code"]    = kinds[i].code;
+		run.finish(parameters, bytes, scan.matches());
+	}
+
+	return run.results();
+}
+
 #if QT_VERSION < 0x050000
 Q_EXPORT_PLUGIN2(References, References)
 #endif
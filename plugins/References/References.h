@@ -30,7 +30,7 @@ class References : public QObject, public IPlugin {
 	Q_OBJECT
 	Q_INTERFACES(IPlugin)
 #if QT_VERSION >= 0x050000
-	Q_PLUGIN_METADATA(IID "edb.IPlugin/1.0")
+	Q_PLUGIN_METADATA(IID "edb.IPlugin/1.0" FILE "References.json")
 #endif
 	Q_CLASSINFO("author", "Evan Teran")
 	Q_CLASSINFO("url", "http://www.codef00.com")
@@ -41,6 +41,7 @@ public:
 
 public:
 	virtual QMenu *menu(QWidget *parent = 0);
+	virtual QList<BenchmarkResult> run_benchmarks(const QList<IRegion::pointer> &regions);
 
 public Q_SLOTS:
 	void show_menu();
@@ -2,6 +2,7 @@
 include(../plugins.pri)
 
 # Input
-HEADERS += References.h DialogReferences.h
+HEADERS += References.h DialogReferences.h ReferenceScan.h
 FORMS += DialogReferences.ui
-SOURCES += References.cpp DialogReferences.cpp
+SOURCES += References.cpp DialogReferences.cpp ReferenceScan.cpp
+OTHER_FILES += References.json
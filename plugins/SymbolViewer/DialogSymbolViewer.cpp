@@ -20,34 +20,63 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "Configuration.h"
 #include "IDebugger.h"
 #include "ISymbolManager.h"
+#include "SymbolListModel.h"
 #include "Util.h"
 #include "edb.h"
 
-#include <QStringListModel>
-#include <QSortFilterProxyModel>
 #include <QMenu>
 
 #include "ui_DialogSymbolViewer.h"
 
 namespace SymbolViewer {
+namespace {
+
+//------------------------------------------------------------------------------
+// Name: module_part
+// Desc: the "module" of a "module::name" search, or a null string
+//------------------------------------------------------------------------------
+QString module_part(const QString &text) {
+	const int n = text.indexOf("::");
+	return (n != -1) ? text.left(n) : QString();
+}
+
+//------------------------------------------------------------------------------
+// Name: narrows
+// Desc: returns true if everything <text> matches was also matched by <last>
+//------------------------------------------------------------------------------
+bool narrows(const QString &text, const QString &last, ISymbolManager::SearchMode mode) {
+
+	if(module_part(text) != module_part(last)) {
+		return false;
+	}
+
+	switch(mode) {
+	case ISymbolManager::SEARCH_PREFIX:
+	case ISymbolManager::SEARCH_FUZZY:
+		return text.startsWith(last);
+	case ISymbolManager::SEARCH_SUBSTRING:
+		return text.contains(last);
+	default:
+		return false;
+	}
+}
+
+}
 
 //------------------------------------------------------------------------------
 // Name: DialogSymbolViewer
 // Desc:
 //------------------------------------------------------------------------------
-DialogSymbolViewer::DialogSymbolViewer(QWidget *parent) : QDialog(parent), ui(new Ui::DialogSymbolViewer) {
+DialogSymbolViewer::DialogSymbolViewer(QWidget *parent) : QDialog(parent), ui(new Ui::DialogSymbolViewer), last_mode_(ISymbolManager::SEARCH_SUBSTRING), last_generation_(0) {
 	ui->setupUi(this);
 
 	ui->listView->setContextMenuPolicy(Qt::CustomContextMenu);
 
-	model_        = new QStringListModel(this);
-	filter_model_ = new QSortFilterProxyModel(this);
-
-	filter_model_->setFilterKeyColumn(0);
-	filter_model_->setSourceModel(model_);
-	ui->listView->setModel(filter_model_);
+	// every row is the same, so the view doesn't have to measure millions
+	ui->listView->setUniformItemSizes(true);
 
-	connect(ui->txtSearch, SIGNAL(textChanged(const QString &)), filter_model_, SLOT(setFilterFixedString(const QString &)));
+	model_ = new SymbolListModel(this);
+	ui->listView->setModel(model_);
 }
 
 //------------------------------------------------------------------------------
@@ -152,19 +181,59 @@ void DialogSymbolViewer::mnuFollowInCPU() {
 }
 
 //------------------------------------------------------------------------------
-// Name: do_find
+// Name: search_mode
 // Desc:
 //------------------------------------------------------------------------------
-void DialogSymbolViewer::do_find() {
-	QStringList results;
-	QString temp;
-
-	const QList<Symbol::pointer> symbols = edb::v1::symbol_manager().symbols();
-	Q_FOREACH(const Symbol::pointer &sym, symbols) {
-		results << QString("%1: %2").arg(edb::v1::format_pointer(sym->address)).arg(sym->name);
+ISymbolManager::SearchMode DialogSymbolViewer::search_mode() const {
+	switch(ui->cmbMode->currentIndex()) {
+	case 1:  return ISymbolManager::SEARCH_PREFIX;
+	case 2:  return ISymbolManager::SEARCH_FUZZY;
+	default: return ISymbolManager::SEARCH_SUBSTRING;
 	}
+}
 
-	model_->setStringList(results);
+//------------------------------------------------------------------------------
+// Name: do_find
+// Desc: when <refine> is set and the new filter only narrows the last one,
+//       just the last results are searched again
+//------------------------------------------------------------------------------
+void DialogSymbolViewer::do_find(bool refine) {
+
+	ISymbolManager &symbols = edb::v1::symbol_manager();
+
+	const QString text                    = ui->txtSearch->text();
+	const ISymbolManager::SearchMode mode = search_mode();
+
+	refine = refine &&
+		mode == last_mode_ &&
+		symbols.generation() == last_generation_ &&
+		narrows(text, last_text_, mode);
+
+	const QVector<quint64> results = symbols.search(text, mode, refine ? &model_->symbols() : 0);
+
+	last_text_       = text;
+	last_mode_       = mode;
+	last_generation_ = symbols.generation();
+
+	model_->set_symbols(results);
+}
+
+//------------------------------------------------------------------------------
+// Name: on_txtSearch_textChanged
+// Desc:
+//------------------------------------------------------------------------------
+void DialogSymbolViewer::on_txtSearch_textChanged(const QString &text) {
+	Q_UNUSED(text);
+	do_find(true);
+}
+
+//------------------------------------------------------------------------------
+// Name: on_cmbMode_currentIndexChanged
+// Desc:
+//------------------------------------------------------------------------------
+void DialogSymbolViewer::on_cmbMode_currentIndexChanged(int index) {
+	Q_UNUSED(index);
+	do_find(false);
 }
 
 //------------------------------------------------------------------------------
@@ -173,7 +242,7 @@ void DialogSymbolViewer::do_find() {
 //------------------------------------------------------------------------------
 void DialogSymbolViewer::on_btnRefresh_clicked() {
 	ui->btnRefresh->setEnabled(false);
-	do_find();
+	do_find(false);
 	ui->btnRefresh->setEnabled(true);
 }
 
@@ -20,17 +20,18 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #define DIALOGSYMBOLVIEWER_20080812_H_
 
 #include <QDialog>
+#include "ISymbolManager.h"
 #include "Types.h"
 
 class QModelIndex;
 class QPoint;
-class QSortFilterProxyModel;
-class QStringListModel;
 
 namespace SymbolViewer {
 
 namespace Ui { class DialogSymbolViewer; }
 
+class SymbolListModel;
+
 class DialogSymbolViewer : public QDialog {
 	Q_OBJECT
 
@@ -42,6 +43,8 @@ public Q_SLOTS:
 	void on_listView_doubleClicked(const QModelIndex &index);
 	void on_listView_customContextMenuRequested(const QPoint &pos);
 	void on_btnRefresh_clicked();
+	void on_txtSearch_textChanged(const QString &text);
+	void on_cmbMode_currentIndexChanged(int index);
 
 private Q_SLOTS:
 	void mnuFollowInDump();
@@ -53,12 +56,15 @@ private:
 	virtual void showEvent(QShowEvent *event);
 
 private:
-	void do_find();
+	void do_find(bool refine);
+	ISymbolManager::SearchMode search_mode() const;
 
 private:
 	 Ui::DialogSymbolViewer *const ui;
-	 QStringListModel *            model_;
-	 QSortFilterProxyModel *       filter_model_;
+	 SymbolListModel *             model_;
+	 QString                       last_text_;
+	 ISymbolManager::SearchMode    last_mode_;
+	 quint64                       last_generation_;
 };
 
 }
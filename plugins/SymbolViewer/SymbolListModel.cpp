@@ -0,0 +1,75 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "SymbolListModel.h"
+#include "ISymbolManager.h"
+#include "edb.h"
+
+namespace SymbolViewer {
+
+//------------------------------------------------------------------------------
+// Name: SymbolListModel
+// Desc:
+//------------------------------------------------------------------------------
+SymbolListModel::SymbolListModel(QObject *parent) : QAbstractListModel(parent) {
+}
+
+//------------------------------------------------------------------------------
+// Name: ~SymbolListModel
+// Desc:
+//------------------------------------------------------------------------------
+SymbolListModel::~SymbolListModel() {
+}
+
+//------------------------------------------------------------------------------
+// Name: set_symbols
+// Desc:
+//------------------------------------------------------------------------------
+void SymbolListModel::set_symbols(const QVector<quint64> &symbols) {
+	beginResetModel();
+	symbols_ = symbols;
+	endResetModel();
+}
+
+//------------------------------------------------------------------------------
+// Name: rowCount
+// Desc:
+//------------------------------------------------------------------------------
+int SymbolListModel::rowCount(const QModelIndex &parent) const {
+	Q_UNUSED(parent);
+	return symbols_.size();
+}
+
+//------------------------------------------------------------------------------
+// Name: data
+// Desc:
+//------------------------------------------------------------------------------
+QVariant SymbolListModel::data(const QModelIndex &index, int role) const {
+
+	if(!index.isValid() || index.row() >= symbols_.size() || role != Qt::DisplayRole) {
+		return QVariant();
+	}
+
+	if(const Symbol::pointer sym = edb::v1::symbol_manager().from_handle(symbols_[index.row()])) {
+		return QString("%1: %2").arg(edb::v1::format_pointer(sym->address)).arg(sym->name);
+	}
+
+	return QVariant();
+}
+
+}
@@ -0,0 +1,51 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SYMBOLLISTMODEL_20261014_H_
+#define SYMBOLLISTMODEL_20261014_H_
+
+#include "Types.h"
+#include <QAbstractListModel>
+#include <QVector>
+
+namespace SymbolViewer {
+
+// the results of a symbol search. Only handles are kept, the text of a row is
+// made when it is shown, so listing millions of symbols is cheap
+class SymbolListModel : public QAbstractListModel {
+	Q_OBJECT
+
+public:
+	SymbolListModel(QObject *parent = 0);
+	virtual ~SymbolListModel();
+
+public:
+	virtual QVariant data(const QModelIndex &index, int role) const;
+	virtual int rowCount(const QModelIndex &parent = QModelIndex()) const;
+
+public:
+	void set_symbols(const QVector<quint64> &symbols);
+	const QVector<quint64> &symbols() const { return symbols_; }
+
+private:
+	QVector<quint64> symbols_;
+};
+
+}
+
+#endif
@@ -2,7 +2,8 @@
 include(../plugins.pri)
 
 # Input
-HEADERS += DialogSymbolViewer.h  SymbolViewer.h
+HEADERS += DialogSymbolViewer.h  SymbolListModel.h  SymbolViewer.h
 FORMS += DialogSymbolViewer.ui
-SOURCES += DialogSymbolViewer.cpp  SymbolViewer.cpp
+SOURCES += DialogSymbolViewer.cpp  SymbolListModel.cpp  SymbolViewer.cpp
+OTHER_FILES += SymbolViewer.json
 
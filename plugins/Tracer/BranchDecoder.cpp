@@ -0,0 +1,125 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "BranchDecoder.h"
+#include "Instruction.h"
+#include "InstructionCache.h"
+#include "edb.h"
+
+#include <QHash>
+
+namespace Tracer {
+
+namespace {
+
+// a run of straight line code longer than this means that we've lost track
+// of where we are (most likely a signal or something else the branch trace
+// didn't see), so we pick up again at the next branch
+const int MaxBlockLength = 0x10000;
+
+class InstructionSizes {
+public:
+	//--------------------------------------------------------------------------
+	// Name: size
+	// Desc: returns the size of the instruction at <address>, or 0 if there
+	//       isn't a valid one. Loops run the same code over and over, so each
+	//       address is only ever decoded once
+	//--------------------------------------------------------------------------
+	int size(edb::address_t address) {
+		const QHash<edb::address_t, int>::const_iterator it = sizes_.find(address);
+		if(it != sizes_.end()) {
+			return it.value();
+		}
+
+		int ret = 0;
+		const InstructionCache::pointer inst = edb::v1::instruction_cache().find(address);
+		if(inst && *inst) {
+			ret = inst->size();
+		}
+
+		sizes_.insert(address, ret);
+		return ret;
+	}
+
+private:
+	QHash<edb::address_t, int> sizes_;
+};
+
+//------------------------------------------------------------------------------
+// Name: walk
+// Desc: appends the straight line code from <from> up to <to> (and including
+//       it when <inclusive> is true) to <instructions>. Returns false if <to>
+//       couldn't be reached
+//------------------------------------------------------------------------------
+bool walk(InstructionSizes *sizes, edb::address_t from, edb::address_t to, bool inclusive, QVector<edb::address_t> *instructions) {
+
+	const int mark = instructions->size();
+
+	edb::address_t address = from;
+	for(int i = 0; i < MaxBlockLength; ++i) {
+		if(address == to) {
+			if(inclusive) {
+				instructions->push_back(address);
+			}
+			return true;
+		}
+
+		instructions->push_back(address);
+
+		const int n = sizes->size(address);
+		if(n == 0) {
+			break;
+		}
+
+		address += n;
+	}
+
+	// don't keep a partial block, it would probably be nonsense
+	instructions->resize(mark);
+	return false;
+}
+
+}
+
+//------------------------------------------------------------------------------
+// Name: decode_branch_trace
+// Desc: turns a list of taken branches into the list of instructions which
+//       were executed, starting at <start> and ending just before <end>
+//       (which is where the thread is now)
+//------------------------------------------------------------------------------
+QVector<edb::address_t> decode_branch_trace(edb::address_t start, const QVector<BranchRecord> &records, edb::address_t end) {
+
+	InstructionSizes sizes;
+	QVector<edb::address_t> instructions;
+
+	edb::address_t address = start;
+	Q_FOREACH(const BranchRecord &record, records) {
+		// every instruction between where we landed and the next branch ran,
+		// followed by the branch itself
+		if(!walk(&sizes, address, record.from, true, &instructions)) {
+			instructions.push_back(record.from);
+		}
+
+		address = record.to;
+	}
+
+	walk(&sizes, address, end, false, &instructions);
+	return instructions;
+}
+
+}
@@ -0,0 +1,57 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "DialogSyscalls.h"
+#include "SyscallModel.h"
+
+#include "ui_DialogSyscalls.h"
+
+namespace Tracer {
+
+//------------------------------------------------------------------------------
+// Name: DialogSyscalls
+// Desc: constructor
+//------------------------------------------------------------------------------
+DialogSyscalls::DialogSyscalls(QWidget *parent) : QDialog(parent), ui(new Ui::DialogSyscalls), model_(new SyscallModel(this)) {
+	ui->setupUi(this);
+	ui->listView->setModel(model_);
+}
+
+//------------------------------------------------------------------------------
+// Name: ~DialogSyscalls
+// Desc:
+//------------------------------------------------------------------------------
+DialogSyscalls::~DialogSyscalls() {
+	delete ui;
+}
+
+//------------------------------------------------------------------------------
+// Name: set_syscalls
+// Desc:
+//------------------------------------------------------------------------------
+void DialogSyscalls::set_syscalls(const QVector<SyscallRecord> &syscalls, quint64 lost) {
+	model_->set_syscalls(syscalls);
+
+	if(lost != 0) {
+		ui->lblSummary->setText(tr("%1 syscalls (the first %2 were overwritten)").arg(syscalls.size()).arg(lost));
+	} else {
+		ui->lblSummary->setText(tr("%1 syscalls").arg(syscalls.size()));
+	}
+}
+
+}
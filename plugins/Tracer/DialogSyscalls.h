@@ -0,0 +1,50 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef DIALOGSYSCALLS_20261014_H_
+#define DIALOGSYSCALLS_20261014_H_
+
+#include "SyscallRecord.h"
+#include <QDialog>
+#include <QVector>
+
+namespace Tracer {
+
+namespace Ui { class DialogSyscalls; }
+
+class SyscallModel;
+
+// shows the syscalls recorded by a syscall trace
+class DialogSyscalls : public QDialog {
+	Q_OBJECT
+
+public:
+	DialogSyscalls(QWidget *parent = 0);
+	virtual ~DialogSyscalls();
+
+public:
+	void set_syscalls(const QVector<SyscallRecord> &syscalls, quint64 lost);
+
+private:
+	Ui::DialogSyscalls *const ui;
+	SyscallModel             *model_;
+};
+
+}
+
+#endif
@@ -0,0 +1,157 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "DialogTrace.h"
+#include "TraceLog.h"
+#include "TraceModel.h"
+#include "edb.h"
+
+#include "ui_DialogTrace.h"
+
+namespace Tracer {
+
+//------------------------------------------------------------------------------
+// Name: DialogTrace
+// Desc: constructor
+//------------------------------------------------------------------------------
+DialogTrace::DialogTrace(QWidget *parent) : QDialog(parent), ui(new Ui::DialogTrace), model_(new TraceModel(this)) {
+	ui->setupUi(this);
+	ui->listView->setModel(model_);
+	connect(ui->listView->selectionModel(), SIGNAL(currentChanged(const QModelIndex &, const QModelIndex &)), this, SLOT(current_changed(const QModelIndex &, const QModelIndex &)));
+}
+
+//------------------------------------------------------------------------------
+// Name: ~DialogTrace
+// Desc:
+//------------------------------------------------------------------------------
+DialogTrace::~DialogTrace() {
+	delete ui;
+}
+
+//------------------------------------------------------------------------------
+// Name: set_trace
+// Desc:
+//------------------------------------------------------------------------------
+void DialogTrace::set_trace(const QVector<edb::address_t> &instructions, quint64 lost) {
+	model_->set_instructions(instructions);
+
+	if(lost != 0) {
+		ui->lblSummary->setText(tr("%1 instructions (%2 branches were lost, the trace has gaps)").arg(instructions.size()).arg(lost));
+	} else {
+		ui->lblSummary->setText(tr("%1 instructions").arg(instructions.size()));
+	}
+
+	ui->lblStep->clear();
+}
+
+//------------------------------------------------------------------------------
+// Name: set_log
+// Desc: shows a recording, <register_names> are the names of the registers
+//       stored with each step
+//------------------------------------------------------------------------------
+void DialogTrace::set_log(const TraceLog *log, const QStringList &register_names) {
+	model_->set_log(log);
+	register_names_ = register_names;
+
+	if(log->first_step() != 0) {
+		ui->lblSummary->setText(tr("%1 instructions (the first %2 were overwritten)").arg(log->step_count() - log->first_step()).arg(log->first_step()));
+	} else {
+		ui->lblSummary->setText(tr("%1 instructions").arg(log->step_count()));
+	}
+
+	ui->lblStep->clear();
+}
+
+//------------------------------------------------------------------------------
+// Name: show_step
+// Desc: for a recording, lists the registers the instruction at <row>
+//       changed and the memory it wrote
+//------------------------------------------------------------------------------
+void DialogTrace::show_step(int row) {
+
+	const TraceLog *const log = model_->log();
+	if(!log) {
+		return;
+	}
+
+	TraceLog::Step step;
+	TraceLog::Step next;
+	if(!log->read(model_->step(row), &step)) {
+		ui->lblStep->clear();
+		return;
+	}
+
+	QStringList changes;
+
+	// registers are stored as they were before the instruction ran, so what it
+	// changed is the difference from the next step
+	if(log->read(model_->step(row) + 1, &next)) {
+		for(int i = 0; i < step.registers.size() && i < register_names_.size(); ++i) {
+			if(next.registers[i] != step.registers[i]) {
+				changes << tr("%1 = %2").arg(register_names_[i], edb::v1::format_pointer(next.registers[i]));
+			}
+		}
+	}
+
+	Q_FOREACH(const TraceLog::MemoryWrite &write, step.writes) {
+		changes << tr("[%1] = %2").arg(edb::v1::format_pointer(write.address), QString::fromLatin1(write.bytes.toHex()));
+	}
+
+	ui->lblStep->setText(changes.join(QLatin1String("\n")));
+}
+
+//------------------------------------------------------------------------------
+// Name: select_row
+// Desc:
+//------------------------------------------------------------------------------
+void DialogTrace::select_row(int row) {
+	if(row >= 0 && row < model_->rowCount()) {
+		ui->listView->setCurrentIndex(model_->index(row));
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: on_btnPrevious_clicked
+// Desc:
+//------------------------------------------------------------------------------
+void DialogTrace::on_btnPrevious_clicked() {
+	select_row(ui->listView->currentIndex().row() - 1);
+}
+
+//------------------------------------------------------------------------------
+// Name: on_btnNext_clicked
+// Desc:
+//------------------------------------------------------------------------------
+void DialogTrace::on_btnNext_clicked() {
+	select_row(ui->listView->currentIndex().row() + 1);
+}
+
+//------------------------------------------------------------------------------
+// Name: current_changed
+// Desc: shows the selected instruction in the CPU view
+//------------------------------------------------------------------------------
+void DialogTrace::current_changed(const QModelIndex &current, const QModelIndex &previous) {
+	Q_UNUSED(previous);
+
+	if(current.isValid()) {
+		edb::v1::jump_to_address(model_->address(current.row()));
+		show_step(current.row());
+	}
+}
+
+}
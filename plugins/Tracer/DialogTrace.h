@@ -0,0 +1,66 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef DIALOGTRACE_20261014_H_
+#define DIALOGTRACE_20261014_H_
+
+#include "Types.h"
+#include <QDialog>
+#include <QStringList>
+#include <QVector>
+
+class QModelIndex;
+
+namespace Tracer {
+
+namespace Ui { class DialogTrace; }
+
+class TraceLog;
+class TraceModel;
+
+// shows a recorded trace, selecting an instruction shows it in the CPU view
+// so the trace can be replayed a step at a time
+class DialogTrace : public QDialog {
+	Q_OBJECT
+
+public:
+	DialogTrace(QWidget *parent = 0);
+	virtual ~DialogTrace();
+
+public:
+	void set_trace(const QVector<edb::address_t> &instructions, quint64 lost);
+	void set_log(const TraceLog *log, const QStringList &register_names);
+
+public Q_SLOTS:
+	void on_btnPrevious_clicked();
+	void on_btnNext_clicked();
+	void current_changed(const QModelIndex &current, const QModelIndex &previous);
+
+private:
+	void select_row(int row);
+	void show_step(int row);
+
+private:
+	Ui::DialogTrace *const ui;
+	TraceModel            *model_;
+	QStringList            register_names_;
+};
+
+}
+
+#endif
@@ -0,0 +1,75 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "SyscallModel.h"
+#include "ArchProcessor.h"
+#include "edb.h"
+
+namespace Tracer {
+
+//------------------------------------------------------------------------------
+// Name: SyscallModel
+// Desc: constructor
+//------------------------------------------------------------------------------
+SyscallModel::SyscallModel(QObject *parent) : QAbstractListModel(parent) {
+}
+
+//------------------------------------------------------------------------------
+// Name: ~SyscallModel
+// Desc: destructor
+//------------------------------------------------------------------------------
+SyscallModel::~SyscallModel() {
+}
+
+//------------------------------------------------------------------------------
+// Name: data
+// Desc:
+//------------------------------------------------------------------------------
+QVariant SyscallModel::data(const QModelIndex &index, int role) const {
+
+	if(!index.isValid() || index.row() >= syscalls_.size()) {
+		return QVariant();
+	}
+
+	if(role == Qt::DisplayRole) {
+		return edb::v1::arch_processor().format_syscall(syscalls_[index.row()]);
+	}
+
+	return QVariant();
+}
+
+//------------------------------------------------------------------------------
+// Name: rowCount
+// Desc:
+//------------------------------------------------------------------------------
+int SyscallModel::rowCount(const QModelIndex &parent) const {
+	Q_UNUSED(parent);
+	return syscalls_.size();
+}
+
+//------------------------------------------------------------------------------
+// Name: set_syscalls
+// Desc:
+//------------------------------------------------------------------------------
+void SyscallModel::set_syscalls(const QVector<SyscallRecord> &syscalls) {
+	beginResetModel();
+	syscalls_ = syscalls;
+	endResetModel();
+}
+
+}
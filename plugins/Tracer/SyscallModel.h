@@ -0,0 +1,50 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SYSCALLMODEL_20261014_H_
+#define SYSCALLMODEL_20261014_H_
+
+#include "SyscallRecord.h"
+#include <QAbstractListModel>
+#include <QVector>
+
+namespace Tracer {
+
+// the syscalls of a syscall trace, in the order they were made. Rows are only
+// decoded when they are shown
+class SyscallModel : public QAbstractListModel {
+	Q_OBJECT
+
+public:
+	SyscallModel(QObject *parent = 0);
+	virtual ~SyscallModel();
+
+public:
+	virtual QVariant data(const QModelIndex &index, int role) const;
+	virtual int rowCount(const QModelIndex &parent = QModelIndex()) const;
+
+public:
+	void set_syscalls(const QVector<SyscallRecord> &syscalls);
+
+private:
+	QVector<SyscallRecord> syscalls_;
+};
+
+}
+
+#endif
@@ -0,0 +1,368 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "TraceLog.h"
+
+#include <cstring>
+
+namespace Tracer {
+
+namespace {
+
+enum RecordType {
+	RECORD_KEYFRAME = 0,
+	RECORD_STEP     = 1
+};
+
+// or'ed into the record type of a step which wrote memory it didn't record
+const quint8 RecordIrreversible = 0x80;
+
+//------------------------------------------------------------------------------
+// Name: zigzag
+// Desc: maps small negative deltas to small unsigned numbers so that they
+//       varint encode to a byte or two as well
+//------------------------------------------------------------------------------
+quint64 zigzag(quint64 delta) {
+	return (delta << 1) ^ static_cast<quint64>(static_cast<qint64>(delta) >> 63);
+}
+
+//------------------------------------------------------------------------------
+// Name: unzigzag
+// Desc:
+//------------------------------------------------------------------------------
+quint64 unzigzag(quint64 value) {
+	return (value >> 1) ^ (~(value & 1) + 1);
+}
+
+//------------------------------------------------------------------------------
+// Name: put_varint
+// Desc: appends <value> 7 bits at a time, low bits first
+//------------------------------------------------------------------------------
+void put_varint(QByteArray &record, quint64 value) {
+	while(value >= 0x80) {
+		record.append(static_cast<char>((value & 0x7f) | 0x80));
+		value >>= 7;
+	}
+	record.append(static_cast<char>(value));
+}
+
+//------------------------------------------------------------------------------
+// Name: put_writes
+// Desc: the addresses are stored relative to the end of the previous write,
+//       writes tend to be next to each other (pushes, string instructions).
+//       The bytes written are followed by as many bytes which they replaced
+//------------------------------------------------------------------------------
+void put_writes(QByteArray &record, const QVector<TraceLog::MemoryWrite> &writes, edb::address_t *last_write) {
+	put_varint(record, writes.size());
+	Q_FOREACH(const TraceLog::MemoryWrite &write, writes) {
+		put_varint(record, zigzag(static_cast<quint64>(write.address) - static_cast<quint64>(*last_write)));
+		put_varint(record, write.bytes.size());
+		record.append(write.bytes);
+		record.append(write.previous);
+		*last_write = write.address + write.bytes.size();
+	}
+}
+
+}
+
+const quint64 TraceLog::DefaultCapacity;
+const quint64 TraceLog::KeyframeInterval;
+const int     TraceLog::MaxRegisters;
+
+//------------------------------------------------------------------------------
+// Name: TraceLog
+// Desc: constructor
+//------------------------------------------------------------------------------
+TraceLog::TraceLog() : data_(0), capacity_(0), position_(0), count_(0), register_count_(0), last_write_(0), cursor_valid_(false) {
+}
+
+//------------------------------------------------------------------------------
+// Name: ~TraceLog
+// Desc: destructor
+//------------------------------------------------------------------------------
+TraceLog::~TraceLog() {
+	close();
+}
+
+//------------------------------------------------------------------------------
+// Name: open
+// Desc: creates an empty log of <capacity> bytes, each step records
+//       <register_count> registers besides the instruction pointer
+//------------------------------------------------------------------------------
+bool TraceLog::open(int register_count, quint64 capacity) {
+
+	close();
+
+	if(register_count > MaxRegisters) {
+		return false;
+	}
+
+	if(!file_.open() || !file_.resize(capacity)) {
+		file_.close();
+		return false;
+	}
+
+	data_ = file_.map(0, capacity);
+	if(!data_) {
+		file_.close();
+		return false;
+	}
+
+	capacity_       = capacity;
+	register_count_ = register_count;
+	return true;
+}
+
+//------------------------------------------------------------------------------
+// Name: close
+// Desc: throws the log away
+//------------------------------------------------------------------------------
+void TraceLog::close() {
+	if(data_) {
+		file_.unmap(data_);
+		file_.close();
+	}
+
+	data_         = 0;
+	capacity_     = 0;
+	position_     = 0;
+	count_        = 0;
+	last_write_   = 0;
+	cursor_valid_ = false;
+	index_.clear();
+}
+
+//------------------------------------------------------------------------------
+// Name: first_step
+// Desc: the oldest step which hasn't been overwritten yet
+//------------------------------------------------------------------------------
+quint64 TraceLog::first_step() const {
+	return index_.isEmpty() ? count_ : index_.front().number;
+}
+
+//------------------------------------------------------------------------------
+// Name: append
+// Desc: records the execution of the instruction at <ip>, <registers> are the
+//       values from before it ran and <writes> what it wrote to memory.
+//       <irreversible> says that it wrote more than <writes>
+//------------------------------------------------------------------------------
+void TraceLog::append(edb::address_t ip, const QVector<edb::reg_t> &registers, const QVector<MemoryWrite> &writes, bool irreversible) {
+
+	Q_ASSERT(data_);
+	Q_ASSERT(registers.size() == register_count_);
+
+	QByteArray record;
+
+	const bool keyframe = (count_ % KeyframeInterval) == 0;
+	const edb::address_t previous_write = last_write_;
+	const quint8 flags = irreversible ? RecordIrreversible : 0;
+
+	if(keyframe) {
+		record.append(static_cast<char>(RECORD_KEYFRAME | flags));
+		put_varint(record, count_);
+		put_varint(record, ip);
+		Q_FOREACH(edb::reg_t value, registers) {
+			put_varint(record, value);
+		}
+		last_write_ = 0;
+	} else {
+		record.append(static_cast<char>(RECORD_STEP | flags));
+		put_varint(record, zigzag(static_cast<quint64>(ip) - static_cast<quint64>(last_.ip)));
+
+		quint64 mask = 0;
+		for(int i = 0; i < register_count_; ++i) {
+			if(registers[i] != last_.registers[i]) {
+				mask |= Q_UINT64_C(1) << i;
+			}
+		}
+
+		put_varint(record, mask);
+		for(int i = 0; i < register_count_; ++i) {
+			if(mask & (Q_UINT64_C(1) << i)) {
+				put_varint(record, zigzag(static_cast<quint64>(registers[i]) - static_cast<quint64>(last_.registers[i])));
+			}
+		}
+	}
+
+	const int header_size = record.size();
+	put_writes(record, writes, &last_write_);
+
+	// a single record must never be able to wrap over its own keyframe, if an
+	// instruction wrote that much, we keep the registers and drop the memory,
+	// which makes it irreversible
+	if(static_cast<quint64>(record.size()) > capacity_ / 2) {
+		record.truncate(header_size);
+		record[0] = static_cast<char>(record[0] | RecordIrreversible);
+		last_write_ = keyframe ? 0 : previous_write;
+		put_writes(record, QVector<MemoryWrite>(), &last_write_);
+	}
+
+	if(keyframe) {
+		const Keyframe entry = { count_, position_ };
+		index_.push_back(entry);
+	}
+
+	put(record);
+
+	last_.number    = count_++;
+	last_.ip        = ip;
+	last_.registers = registers;
+}
+
+//------------------------------------------------------------------------------
+// Name: put
+// Desc: copies <record> to the ring, forgetting the keyframes it overwrites
+//------------------------------------------------------------------------------
+void TraceLog::put(const QByteArray &record) {
+
+	const quint64 end = position_ + record.size();
+
+	if(end > capacity_) {
+		const quint64 oldest = end - capacity_;
+		while(!index_.isEmpty() && index_.front().offset < oldest) {
+			index_.removeFirst();
+		}
+
+		if(cursor_valid_ && (index_.isEmpty() || cursor_.step.number < index_.front().number)) {
+			cursor_valid_ = false;
+		}
+	}
+
+	const quint64 start = position_ % capacity_;
+	const quint64 first = qMin<quint64>(record.size(), capacity_ - start);
+
+	std::memcpy(data_ + start, record.constData(), first);
+	std::memcpy(data_, record.constData() + first, record.size() - first);
+
+	position_ = end;
+}
+
+//------------------------------------------------------------------------------
+// Name: byte_at
+// Desc:
+//------------------------------------------------------------------------------
+quint8 TraceLog::byte_at(quint64 offset) const {
+	return data_[offset % capacity_];
+}
+
+//------------------------------------------------------------------------------
+// Name: read_varint
+// Desc:
+//------------------------------------------------------------------------------
+quint64 TraceLog::read_varint(quint64 *offset) const {
+	quint64 value = 0;
+	int shift     = 0;
+	quint8 byte;
+	do {
+		byte = byte_at((*offset)++);
+		value |= static_cast<quint64>(byte & 0x7f) << shift;
+		shift += 7;
+	} while((byte & 0x80) && shift < 64);
+	return value;
+}
+
+//------------------------------------------------------------------------------
+// Name: decode
+// Desc: reads the record at <offset> on top of <step>, which must hold the
+//       step before it unless the record is a keyframe
+//------------------------------------------------------------------------------
+void TraceLog::decode(quint64 *offset, Step *step, edb::address_t *last_write) const {
+
+	step->registers.resize(register_count_);
+
+	const quint8 type = byte_at((*offset)++);
+	step->irreversible = (type & RecordIrreversible) != 0;
+
+	if((type & ~RecordIrreversible) == RECORD_KEYFRAME) {
+		step->number = read_varint(offset);
+		step->ip     = read_varint(offset);
+		for(int i = 0; i < register_count_; ++i) {
+			step->registers[i] = read_varint(offset);
+		}
+		*last_write = 0;
+	} else {
+		step->number += 1;
+		step->ip     += unzigzag(read_varint(offset));
+
+		const quint64 mask = read_varint(offset);
+		for(int i = 0; i < register_count_; ++i) {
+			if(mask & (Q_UINT64_C(1) << i)) {
+				step->registers[i] += unzigzag(read_varint(offset));
+			}
+		}
+	}
+
+	const int count = read_varint(offset);
+	step->writes.resize(count);
+	for(int i = 0; i < count; ++i) {
+		MemoryWrite &write = step->writes[i];
+		write.address = *last_write + unzigzag(read_varint(offset));
+		write.bytes.resize(read_varint(offset));
+		write.previous.resize(write.bytes.size());
+		for(int j = 0; j < write.bytes.size(); ++j) {
+			write.bytes[j] = byte_at((*offset)++);
+		}
+		for(int j = 0; j < write.previous.size(); ++j) {
+			write.previous[j] = byte_at((*offset)++);
+		}
+		*last_write = write.address + write.bytes.size();
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: read
+// Desc: fills in <step> with step <number>, this is a binary search for the
+//       keyframe at or before it and then decoding forward from there
+//------------------------------------------------------------------------------
+bool TraceLog::read(quint64 number, Step *step) const {
+
+	Q_ASSERT(step);
+
+	if(!data_ || number >= count_ || number < first_step()) {
+		return false;
+	}
+
+	const bool forward = cursor_valid_ && cursor_.step.number <= number && number - cursor_.step.number < KeyframeInterval;
+
+	if(!forward) {
+		// the last keyframe numbered <= number, the first one always is
+		int lo = 0;
+		int hi = index_.size();
+		while(hi - lo > 1) {
+			const int mid = lo + (hi - lo) / 2;
+			if(index_[mid].number <= number) {
+				lo = mid;
+			} else {
+				hi = mid;
+			}
+		}
+
+		cursor_.offset = index_[lo].offset;
+		decode(&cursor_.offset, &cursor_.step, &cursor_.last_write);
+		cursor_valid_ = true;
+	}
+
+	while(cursor_.step.number < number) {
+		decode(&cursor_.offset, &cursor_.step, &cursor_.last_write);
+	}
+
+	*step = cursor_.step;
+	return true;
+}
+
+}
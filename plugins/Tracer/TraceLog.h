@@ -0,0 +1,124 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef TRACELOG_20261014_H_
+#define TRACELOG_20261014_H_
+
+#include "Types.h"
+#include <QByteArray>
+#include <QList>
+#include <QTemporaryFile>
+#include <QVector>
+
+namespace Tracer {
+
+// a recording of every instruction executed, kept in a fixed size memory
+// mapped file which is used as a ring, so the oldest steps are overwritten
+// once it is full and RAM use doesn't grow with the length of the trace.
+//
+// each step is stored as the difference from the one before it: the change in
+// the instruction pointer, a mask of the registers which changed along with
+// the change in each of them and the bytes of any memory written, along with
+// what they overwrote so that a step can be undone, unless it is marked as
+// irreversible because it wrote more than that. Every
+// KeyframeInterval steps the full set of registers is stored instead, and the
+// offset of these is kept in an index, so reading a step is a binary search
+// for its keyframe followed by decoding at most KeyframeInterval records
+class TraceLog {
+public:
+	static const quint64 DefaultCapacity  = 256 * 1024 * 1024;
+	static const quint64 KeyframeInterval = 4096;
+	static const int     MaxRegisters     = 64;
+
+public:
+	struct MemoryWrite {
+		edb::address_t address;
+		QByteArray     bytes;
+		QByteArray     previous;
+	};
+
+	struct Step {
+		quint64              number;
+		edb::address_t       ip;
+		QVector<edb::reg_t>  registers;
+		QVector<MemoryWrite> writes;
+		bool                 irreversible;
+	};
+
+public:
+	TraceLog();
+	~TraceLog();
+
+private:
+	Q_DISABLE_COPY(TraceLog)
+
+public:
+	bool open(int register_count, quint64 capacity = DefaultCapacity);
+	void close();
+	bool is_open() const { return data_ != 0; }
+
+public:
+	void append(edb::address_t ip, const QVector<edb::reg_t> &registers, const QVector<MemoryWrite> &writes, bool irreversible = false);
+	bool read(quint64 number, Step *step) const;
+
+public:
+	// the steps which can still be read are [first_step(), step_count())
+	quint64 first_step() const;
+	quint64 step_count() const    { return count_; }
+	int register_count() const    { return register_count_; }
+
+	// how much of the mapping has been written to, which is what it costs
+	quint64 memory_used() const   { return qMin(position_, capacity_); }
+
+private:
+	struct Keyframe {
+		quint64 number;
+		quint64 offset;
+	};
+
+	// where decoding stopped last time, so that reading the following step,
+	// which is what a list view scrolling through the trace does, is cheap
+	struct Cursor {
+		quint64        offset;
+		edb::address_t last_write;
+		Step           step;
+	};
+
+private:
+	void put(const QByteArray &record);
+	quint8 byte_at(quint64 offset) const;
+	quint64 read_varint(quint64 *offset) const;
+	void decode(quint64 *offset, Step *step, edb::address_t *last_write) const;
+
+private:
+	QTemporaryFile  file_;
+	uchar          *data_;
+	quint64         capacity_;
+	quint64         position_;
+	quint64         count_;
+	int             register_count_;
+	QList<Keyframe> index_;
+	Step            last_;
+	edb::address_t  last_write_;
+	mutable Cursor  cursor_;
+	mutable bool    cursor_valid_;
+};
+
+}
+
+#endif
@@ -0,0 +1,118 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "TraceModel.h"
+#include "TraceLog.h"
+#include "edb.h"
+
+#include <climits>
+
+namespace Tracer {
+
+//------------------------------------------------------------------------------
+// Name: TraceModel
+// Desc: constructor
+//------------------------------------------------------------------------------
+TraceModel::TraceModel(QObject *parent) : QAbstractListModel(parent), log_(0), first_step_(0), rows_(0) {
+}
+
+//------------------------------------------------------------------------------
+// Name: ~TraceModel
+// Desc: destructor
+//------------------------------------------------------------------------------
+TraceModel::~TraceModel() {
+}
+
+//------------------------------------------------------------------------------
+// Name: data
+// Desc:
+//------------------------------------------------------------------------------
+QVariant TraceModel::data(const QModelIndex &index, int role) const {
+
+	if(!index.isValid() || index.row() >= rows_) {
+		return QVariant();
+	}
+
+	if(role == Qt::DisplayRole) {
+		const edb::address_t address = this->address(index.row());
+		return tr("%1: %2  %3").arg(step(index.row())).arg(edb::v1::format_pointer(address), edb::v1::disassemble_address(address));
+	}
+
+	return QVariant();
+}
+
+//------------------------------------------------------------------------------
+// Name: rowCount
+// Desc:
+//------------------------------------------------------------------------------
+int TraceModel::rowCount(const QModelIndex &parent) const {
+	Q_UNUSED(parent);
+	return rows_;
+}
+
+//------------------------------------------------------------------------------
+// Name: set_instructions
+// Desc:
+//------------------------------------------------------------------------------
+void TraceModel::set_instructions(const QVector<edb::address_t> &instructions) {
+	beginResetModel();
+	instructions_ = instructions;
+	log_          = 0;
+	first_step_   = 0;
+	rows_         = instructions.size();
+	endResetModel();
+}
+
+//------------------------------------------------------------------------------
+// Name: set_log
+// Desc: shows the steps of <log> which haven't been overwritten, <log> must
+//       not be appended to while it is shown
+//------------------------------------------------------------------------------
+void TraceModel::set_log(const TraceLog *log) {
+	beginResetModel();
+	instructions_.clear();
+	log_        = log;
+	first_step_ = log->first_step();
+	rows_       = static_cast<int>(qMin<quint64>(log->step_count() - first_step_, INT_MAX));
+	endResetModel();
+}
+
+//------------------------------------------------------------------------------
+// Name: step
+// Desc: the step number of <row>
+//------------------------------------------------------------------------------
+quint64 TraceModel::step(int row) const {
+	return first_step_ + row;
+}
+
+//------------------------------------------------------------------------------
+// Name: address
+// Desc: the address of the instruction executed at <row>
+//------------------------------------------------------------------------------
+edb::address_t TraceModel::address(int row) const {
+	if(log_) {
+		TraceLog::Step entry;
+		if(log_->read(step(row), &entry)) {
+			return entry.ip;
+		}
+		return 0;
+	}
+	return instructions_[row];
+}
+
+}
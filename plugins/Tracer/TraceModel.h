@@ -0,0 +1,61 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef TRACEMODEL_20261014_H_
+#define TRACEMODEL_20261014_H_
+
+#include "Types.h"
+#include <QAbstractListModel>
+#include <QVector>
+
+namespace Tracer {
+
+class TraceLog;
+
+// the instructions of a trace, in the order they were executed. Rows are
+// only disassembled when they are shown, so a trace can be very long. The
+// instructions either come from a list of addresses (a decoded branch trace)
+// or are read from a recording as they are needed
+class TraceModel : public QAbstractListModel {
+	Q_OBJECT
+
+public:
+	TraceModel(QObject *parent = 0);
+	virtual ~TraceModel();
+
+public:
+	virtual QVariant data(const QModelIndex &index, int role) const;
+	virtual int rowCount(const QModelIndex &parent = QModelIndex()) const;
+
+public:
+	void set_instructions(const QVector<edb::address_t> &instructions);
+	void set_log(const TraceLog *log);
+	edb::address_t address(int row) const;
+	quint64 step(int row) const;
+	const TraceLog *log() const { return log_; }
+
+private:
+	QVector<edb::address_t>  instructions_;
+	const TraceLog          *log_;
+	quint64                  first_step_;
+	int                      rows_;
+};
+
+}
+
+#endif
@@ -0,0 +1,402 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "TraceRecorder.h"
+#include "ArchProcessor.h"
+#include "Emulator.h"
+#include "IDebugEvent.h"
+#include "IDebugger.h"
+#include "IProcess.h"
+#include "LengthDecoder.h"
+#include "State.h"
+#include "edb.h"
+
+namespace Tracer {
+
+namespace {
+
+// the registers stored with every step, the instruction pointer is stored
+// separately since it changes every time
+const char *const register_names[] = {
+#if defined(EDB_X86)
+	"eax", "ebx", "ecx", "edx", "ebp", "esp", "esi", "edi", "eflags"
+#elif defined(EDB_X86_64)
+	"rax", "rbx", "rcx", "rdx", "rbp", "rsp", "rsi", "rdi",
+	"r8",  "r9",  "r10", "r11", "r12", "r13", "r14", "r15",
+	"rflags"
+#endif
+};
+
+// pushes, calls and enter write just below the stack pointer without having
+// a memory operand, pusha writes 8 registers
+const int stack_window = 8 * sizeof(edb::reg_t);
+
+// the most instructions emulated between two which are really stepped, so
+// that a long emulated loop still lets the UI see a stop request
+const int emulation_limit = 4096;
+
+//------------------------------------------------------------------------------
+// Name: operand_size
+// Desc: how many bytes a memory operand could write, when the disassembler
+//       doesn't say (FPU, SSE and AVX operands) we assume the largest
+//------------------------------------------------------------------------------
+int operand_size(const edb::Operand &operand) {
+	switch(operand.complete_type()) {
+	case edb::Operand::TYPE_EXPRESSION8:  return 1;
+	case edb::Operand::TYPE_EXPRESSION16: return 2;
+	case edb::Operand::TYPE_EXPRESSION32: return 4;
+	case edb::Operand::TYPE_EXPRESSION64: return 8;
+	default:
+		return 64;
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: saves_state
+// Desc: true for the instructions which store the FPU or extended state, up
+//       to several KB which no operand size tells us about: fnsave, fxsave,
+//       xsave, xsavec, xsaveopt and xsaves
+//------------------------------------------------------------------------------
+bool saves_state(const quint8 *p, const quint8 *last) {
+
+	while(p != last && edb::length::detail::is_prefix(*p)) {
+		++p;
+	}
+
+#if defined(EDB_X86_64)
+	if(p != last && (*p & 0xf0) == 0x40) {
+		++p;
+	}
+#endif
+
+	if(last - p < 2) {
+		return false;
+	}
+
+	if(p[0] == 0xdd) {
+		return (p[1] >> 6) != 3 && ((p[1] >> 3) & 7) == 6;
+	}
+
+	if(p[0] != 0x0f || last - p < 3 || (p[2] >> 6) == 3) {
+		return false;
+	}
+
+	const int reg = (p[2] >> 3) & 7;
+	return (p[1] == 0xae && (reg == 0 || reg == 4 || reg == 6)) || (p[1] == 0xc7 && (reg == 4 || reg == 5));
+}
+
+//------------------------------------------------------------------------------
+// Name: irreversible
+// Desc: true if <inst> writes memory which snapshot() can't find: the kernel's
+//       writes during a system call, string instructions repeated by a count
+//       and the state saving instructions
+//------------------------------------------------------------------------------
+bool irreversible(const edb::Instruction &inst, const quint8 *bytes, int size) {
+
+	switch(inst.type()) {
+	case edb::Instruction::OP_SYSCALL:
+	case edb::Instruction::OP_SYSENTER:
+	case edb::Instruction::OP_INT:
+		return true;
+	case edb::Instruction::OP_CMPS:
+	case edb::Instruction::OP_CMPSW:
+	case edb::Instruction::OP_SCAS:
+	case edb::Instruction::OP_LODS:
+		return false;
+	default:
+		break;
+	}
+
+	if(inst.prefix() & (edb::Instruction::PREFIX_REP | edb::Instruction::PREFIX_REPNE)) {
+		return true;
+	}
+
+	return saves_state(bytes, bytes + size);
+}
+
+}
+
+//------------------------------------------------------------------------------
+// Name: TraceRecorder
+// Desc:
+//------------------------------------------------------------------------------
+TraceRecorder::TraceRecorder(TraceLog *log) : log_(log), previous_handler_(0), ip_(0), irreversible_(false), recording_(false), stop_requested_(false) {
+
+	Q_ASSERT(log);
+
+	for(std::size_t i = 0; i < sizeof(register_names) / sizeof(register_names[0]); ++i) {
+		names_.push_back(QLatin1String(register_names[i]));
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: ~TraceRecorder
+// Desc:
+//------------------------------------------------------------------------------
+TraceRecorder::~TraceRecorder() {
+	finish();
+}
+
+//------------------------------------------------------------------------------
+// Name: start
+// Desc: starts a new recording from where the active thread is stopped
+//------------------------------------------------------------------------------
+bool TraceRecorder::start() {
+
+	if(recording_ || !edb::v1::debugger_core->process()) {
+		return false;
+	}
+
+	if(!log_->open(names_.size())) {
+		return false;
+	}
+
+	State state;
+	edb::v1::debugger_core->get_state(&state);
+
+	// the fast path reads registers straight out of the state, anything the
+	// platform can't index is looked up by name with value()
+	indexes_.clear();
+	Q_FOREACH(const QString &name, names_) {
+		indexes_.push_back(state.register_index(name));
+	}
+
+	// like Step, we step over a breakpoint we are sitting on
+	if(IBreakpoint::pointer bp = edb::v1::debugger_core->find_breakpoint(state.instruction_pointer())) {
+		if(bp->enabled()) {
+			bp->disable();
+			reenable_ = bp;
+		}
+	}
+
+	snapshot(state);
+
+	stop_requested_   = false;
+	recording_        = true;
+	previous_handler_ = edb::v1::set_debug_event_handler(this);
+
+	edb::v1::debugger_core->step(edb::DEBUG_CONTINUE);
+	return true;
+}
+
+//------------------------------------------------------------------------------
+// Name: finish
+// Desc: makes the previous handler the event handler again, the log is kept
+//       so it can be looked at and replayed
+//------------------------------------------------------------------------------
+void TraceRecorder::finish() {
+
+	if(reenable_) {
+		reenable_->enable();
+		reenable_ = IBreakpoint::pointer();
+	}
+
+	if(recording_) {
+		edb::v1::set_debug_event_handler(previous_handler_);
+		recording_ = false;
+
+		// the last step is where the thread stopped, it hasn't run yet, but
+		// replaying needs the registers it stopped with
+		if(edb::v1::debugger_core->process()) {
+			State state;
+			edb::v1::debugger_core->get_state(&state);
+			log_->append(state.instruction_pointer(), registers(state), QVector<TraceLog::MemoryWrite>());
+		}
+	}
+
+	snapshots_.clear();
+}
+
+//------------------------------------------------------------------------------
+// Name: pass_back_to_debugger
+// Desc: ends the recording and lets the debugger deal with <event>
+//------------------------------------------------------------------------------
+edb::EVENT_STATUS TraceRecorder::pass_back_to_debugger(const IDebugEvent::const_pointer &event) {
+	IDebugEventHandler *const handler = previous_handler_;
+	finish();
+	return handler->handle_event(event);
+}
+
+//------------------------------------------------------------------------------
+// Name: registers
+// Desc:
+//------------------------------------------------------------------------------
+QVector<edb::reg_t> TraceRecorder::registers(const State &state) const {
+
+	QVector<edb::reg_t> values(names_.size());
+	for(int i = 0; i < names_.size(); ++i) {
+		if(indexes_[i] != -1) {
+			values[i] = state.register_value(indexes_[i]);
+		} else {
+			values[i] = state[names_[i]].value<edb::reg_t>();
+		}
+	}
+	return values;
+}
+
+//------------------------------------------------------------------------------
+// Name: snapshot
+// Desc: saves the registers and every byte the instruction about to be
+//       stepped could write, or notes that it can't be undone when those
+//       can't be known beforehand
+//------------------------------------------------------------------------------
+void TraceRecorder::snapshot(const State &state) {
+
+	ip_           = state.instruction_pointer();
+	registers_    = registers(state);
+	irreversible_ = false;
+	snapshots_.clear();
+
+	IProcess *const process = edb::v1::debugger_core->process();
+
+	QVector<Snapshot> ranges;
+
+	const Snapshot stack = { state.stack_pointer() - stack_window, QByteArray(stack_window, 0) };
+	ranges.push_back(stack);
+
+	quint8 buffer[edb::Instruction::MAX_SIZE];
+	if(const int size = edb::v1::get_instruction_bytes(ip_, buffer)) {
+		edb::Instruction inst(buffer, buffer + size, ip_, std::nothrow);
+		if(inst) {
+			irreversible_ = irreversible(inst, buffer, size);
+			for(std::size_t i = 0; i < inst.operand_count(); ++i) {
+				const edb::Operand &operand = inst.operands()[i];
+				if(operand.general_type() == edb::Operand::TYPE_EXPRESSION || operand.general_type() == edb::Operand::TYPE_ABSOLUTE) {
+					const Snapshot range = { edb::v1::arch_processor().effective_address(operand, state), QByteArray(operand_size(operand), 0) };
+					ranges.push_back(range);
+				}
+			}
+		}
+	}
+
+	// memory which can't be read can't be written either, unless the
+	// instruction faults, which ends the recording anyway
+	Q_FOREACH(Snapshot range, ranges) {
+		if(process->read_bytes(range.address, range.bytes.data(), range.bytes.size())) {
+			snapshots_.push_back(range);
+		}
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: record
+// Desc: appends the instruction which was just stepped, memory writes are the
+//       runs of bytes which differ from the snapshot
+//------------------------------------------------------------------------------
+void TraceRecorder::record() {
+
+	IProcess *const process = edb::v1::debugger_core->process();
+
+	QVector<TraceLog::MemoryWrite> writes;
+
+	Q_FOREACH(const Snapshot &before, snapshots_) {
+		QByteArray after(before.bytes.size(), 0);
+		if(!process->read_bytes(before.address, after.data(), after.size())) {
+			continue;
+		}
+
+		int i = 0;
+		while(i < after.size()) {
+			if(after[i] == before.bytes[i]) {
+				++i;
+				continue;
+			}
+
+			int j = i;
+			while(j < after.size() && after[j] != before.bytes[j]) {
+				++j;
+			}
+
+			const TraceLog::MemoryWrite write = { before.address + i, after.mid(i, j - i), before.bytes.mid(i, j - i) };
+			writes.push_back(write);
+			i = j;
+		}
+	}
+
+	log_->append(ip_, registers_, writes, irreversible_);
+}
+
+//------------------------------------------------------------------------------
+// Name: handle_event
+// Desc:
+//------------------------------------------------------------------------------
+edb::EVENT_STATUS TraceRecorder::handle_event(const IDebugEvent::const_pointer &event) {
+
+	if(!event->stopped() || !event->is_trap() || event->trap_reason() != IDebugEvent::TRAP_STEPPING) {
+		return pass_back_to_debugger(event);
+	}
+
+	if(reenable_) {
+		reenable_->enable();
+		reenable_ = IBreakpoint::pointer();
+	}
+
+	State state;
+	edb::v1::debugger_core->get_state(&state);
+
+	record();
+
+	if(stop_requested_) {
+		finish();
+		return edb::DEBUG_STOP;
+	}
+
+	// whatever can be emulated is, each instruction recorded just as if it
+	// had been stepped, saving a trip through the kernel for every one of them
+	Emulator emulator(state);
+	for(int i = 0; i < emulation_limit; ++i) {
+		const edb::address_t      ip     = emulator.instruction_pointer();
+		const QVector<edb::reg_t> before = registers(state);
+
+		if(!emulator.step()) {
+			break;
+		}
+
+		QVector<TraceLog::MemoryWrite> writes;
+		Q_FOREACH(const Emulator::Write &w, emulator.writes()) {
+			const TraceLog::MemoryWrite write = { w.address, w.bytes, w.previous };
+			writes.push_back(write);
+		}
+
+		log_->append(ip, before, writes);
+		emulator.store(&state);
+	}
+
+	if(emulator.count() != 0) {
+		edb::v1::debugger_core->set_state(state);
+	}
+
+	// a user's breakpoint ends the recording just like it would end Run,
+	// internal ones (step out, coverage, ...) are stepped over
+	if(IBreakpoint::pointer bp = edb::v1::debugger_core->find_breakpoint(state.instruction_pointer())) {
+		if(bp->enabled()) {
+			if(!bp->internal()) {
+				finish();
+				return edb::DEBUG_STOP;
+			}
+
+			bp->disable();
+			reenable_ = bp;
+		}
+	}
+
+	snapshot(state);
+	return edb::DEBUG_CONTINUE_STEP;
+}
+
+}
@@ -0,0 +1,86 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef TRACERECORDER_20261014_H_
+#define TRACERECORDER_20261014_H_
+
+#include "IBreakpoint.h"
+#include "IDebugEventHandler.h"
+#include "TraceLog.h"
+#include "Types.h"
+#include <QStringList>
+#include <QVector>
+
+class State;
+
+namespace Tracer {
+
+// single steps the active thread, appending every instruction to a TraceLog.
+// Recording ends when a user breakpoint is reached, when stop() is called or
+// at any event which isn't one of our steps (signals, exits), which is then
+// handled by the debugger as usual.
+//
+// memory writes are found by saving the bytes an instruction could write,
+// its memory operands and the top of the stack, before stepping it and
+// comparing them afterwards. Memory written by the kernel during a system
+// call, by a repeated string instruction or by fxsave, xsave and the like
+// isn't seen, those steps are recorded as irreversible instead
+class TraceRecorder : public IDebugEventHandler {
+public:
+	TraceRecorder(TraceLog *log);
+	virtual ~TraceRecorder();
+
+public:
+	bool start();
+	void stop()                               { stop_requested_ = true; }
+	bool is_recording() const                 { return recording_; }
+	const QStringList &register_names() const { return names_; }
+
+public:
+	virtual edb::EVENT_STATUS handle_event(const IDebugEvent::const_pointer &event);
+
+private:
+	struct Snapshot {
+		edb::address_t address;
+		QByteArray     bytes;
+	};
+
+private:
+	QVector<edb::reg_t> registers(const State &state) const;
+	edb::EVENT_STATUS pass_back_to_debugger(const IDebugEvent::const_pointer &event);
+	void finish();
+	void record();
+	void snapshot(const State &state);
+
+private:
+	TraceLog              *log_;
+	IDebugEventHandler    *previous_handler_;
+	IBreakpoint::pointer   reenable_;
+	QStringList            names_;
+	QVector<int>           indexes_;
+	QVector<Snapshot>      snapshots_;
+	QVector<edb::reg_t>    registers_;
+	edb::address_t         ip_;
+	bool                   irreversible_;
+	bool                   recording_;
+	bool                   stop_requested_;
+};
+
+}
+
+#endif
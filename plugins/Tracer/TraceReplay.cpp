@@ -0,0 +1,241 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "TraceReplay.h"
+#include "IBreakpoint.h"
+#include "IDebugger.h"
+#include "IProcess.h"
+#include "State.h"
+#include "edb.h"
+
+namespace Tracer {
+
+//------------------------------------------------------------------------------
+// Name: TraceReplay
+// Desc:
+//------------------------------------------------------------------------------
+TraceReplay::TraceReplay(const TraceLog *log) : log_(log), block_start_(0), position_(0), valid_(false) {
+	Q_ASSERT(log);
+}
+
+//------------------------------------------------------------------------------
+// Name: reset
+// Desc: to be called when a recording has finished, the process is then at
+//       its last step
+//------------------------------------------------------------------------------
+void TraceReplay::reset(const QStringList &register_names) {
+	names_    = register_names;
+	valid_    = log_->step_count() != 0;
+	position_ = valid_ ? log_->step_count() - 1 : 0;
+	block_.clear();
+}
+
+//------------------------------------------------------------------------------
+// Name: step
+// Desc: steps are decoded a keyframe interval at a time, walking backwards
+//       through the log would otherwise decode from the keyframe every time
+//------------------------------------------------------------------------------
+const TraceLog::Step &TraceReplay::step(quint64 number) {
+
+	if(block_.isEmpty() || number < block_start_ || number - block_start_ >= static_cast<quint64>(block_.size())) {
+		block_start_ = number - number % TraceLog::KeyframeInterval;
+
+		const quint64 end = qMin(block_start_ + TraceLog::KeyframeInterval, log_->step_count());
+		block_.resize(end - block_start_);
+		for(int i = 0; i < block_.size(); ++i) {
+			log_->read(block_start_ + i, &block_[i]);
+		}
+	}
+
+	return block_[number - block_start_];
+}
+
+//------------------------------------------------------------------------------
+// Name: memory_used
+// Desc:
+//------------------------------------------------------------------------------
+quint64 TraceReplay::memory_used() const {
+	quint64 bytes = block_.capacity() * sizeof(TraceLog::Step);
+	Q_FOREACH(const TraceLog::Step &step, block_) {
+		bytes += step.registers.size() * sizeof(edb::reg_t);
+		Q_FOREACH(const TraceLog::MemoryWrite &write, step.writes) {
+			bytes += sizeof(write) + write.bytes.size() + write.previous.size();
+		}
+	}
+	return bytes;
+}
+
+//------------------------------------------------------------------------------
+// Name: at_irreversible
+// Desc:
+//------------------------------------------------------------------------------
+bool TraceReplay::at_irreversible() {
+	return can_step_back() && step(position_ - 1).irreversible;
+}
+
+//------------------------------------------------------------------------------
+// Name: irreversible_address
+// Desc: where the instruction at_irreversible() refers to is
+//------------------------------------------------------------------------------
+edb::address_t TraceReplay::irreversible_address() {
+	return can_step_back() ? step(position_ - 1).ip : 0;
+}
+
+//------------------------------------------------------------------------------
+// Name: in_sync
+// Desc: true if the process is still where the replay left it
+//------------------------------------------------------------------------------
+bool TraceReplay::in_sync(const State &state) {
+
+	const TraceLog::Step &current = step(position_);
+
+	if(current.ip != state.instruction_pointer()) {
+		return false;
+	}
+
+	for(int i = 0; i < names_.size() && i < current.registers.size(); ++i) {
+		if(state[names_[i]].value<edb::reg_t>() != current.registers[i]) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+//------------------------------------------------------------------------------
+// Name: restore
+// Desc: writes the memory of <step> back to how it was before the instruction
+//       ran if <previous> is true, otherwise to how the instruction left it
+//------------------------------------------------------------------------------
+void TraceReplay::restore(const TraceLog::Step &step, bool previous) {
+
+	IProcess *const process = edb::v1::debugger_core->process();
+
+	if(previous) {
+		for(int i = step.writes.size() - 1; i >= 0; --i) {
+			const TraceLog::MemoryWrite &write = step.writes[i];
+			process->write_bytes(write.address, write.previous.constData(), write.previous.size());
+		}
+	} else {
+		Q_FOREACH(const TraceLog::MemoryWrite &write, step.writes) {
+			process->write_bytes(write.address, write.bytes.constData(), write.bytes.size());
+		}
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: finish
+// Desc: gives the thread the registers of step <position> and shows it
+//------------------------------------------------------------------------------
+void TraceReplay::finish(State *state, quint64 position) {
+
+	const TraceLog::Step &target = step(position);
+
+	for(int i = 0; i < names_.size() && i < target.registers.size(); ++i) {
+		state->set_register(names_[i], target.registers[i]);
+	}
+
+	state->set_instruction_pointer(target.ip);
+	edb::v1::debugger_core->set_state(*state);
+
+	position_ = position;
+	edb::v1::update_ui();
+}
+
+//------------------------------------------------------------------------------
+// Name: step_back
+// Desc: undoes the last instruction
+//------------------------------------------------------------------------------
+bool TraceReplay::step_back() {
+
+	if(!can_step_back() || at_irreversible()) {
+		return false;
+	}
+
+	State state;
+	edb::v1::debugger_core->get_state(&state);
+
+	if(!in_sync(state)) {
+		valid_ = false;
+		return false;
+	}
+
+	restore(step(position_ - 1), true);
+	finish(&state, position_ - 1);
+	return true;
+}
+
+//------------------------------------------------------------------------------
+// Name: step_forward
+// Desc: redoes the next instruction from the recording
+//------------------------------------------------------------------------------
+bool TraceReplay::step_forward() {
+
+	if(!can_step_forward()) {
+		return false;
+	}
+
+	State state;
+	edb::v1::debugger_core->get_state(&state);
+
+	if(!in_sync(state)) {
+		valid_ = false;
+		return false;
+	}
+
+	restore(step(position_), false);
+	finish(&state, position_ + 1);
+	return true;
+}
+
+//------------------------------------------------------------------------------
+// Name: reverse_continue
+// Desc: undoes instructions until one at a user breakpoint has been undone,
+//       the next one can't be undone or the start of the recording is reached
+//------------------------------------------------------------------------------
+bool TraceReplay::reverse_continue() {
+
+	if(!can_step_back() || at_irreversible()) {
+		return false;
+	}
+
+	State state;
+	edb::v1::debugger_core->get_state(&state);
+
+	if(!in_sync(state)) {
+		valid_ = false;
+		return false;
+	}
+
+	quint64 position = position_;
+	while(position > log_->first_step() && !step(position - 1).irreversible) {
+		const TraceLog::Step &previous = step(--position);
+		restore(previous, true);
+
+		if(IBreakpoint::pointer bp = edb::v1::debugger_core->find_breakpoint(previous.ip)) {
+			if(bp->enabled() && !bp->internal()) {
+				break;
+			}
+		}
+	}
+
+	finish(&state, position);
+	return true;
+}
+
+}
@@ -0,0 +1,85 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef TRACEREPLAY_20261014_H_
+#define TRACEREPLAY_20261014_H_
+
+#include "TraceLog.h"
+#include "Types.h"
+#include <QStringList>
+#include <QVector>
+
+class State;
+
+namespace Tracer {
+
+// moves a stopped process backwards and forwards through a recording. Going
+// back a step writes back the bytes the instruction overwrote and restores
+// the registers it started with, going forward does the opposite, so moving
+// N steps costs O(N) and nothing is re-executed.
+//
+// only what the recorder saw can be undone: the general purpose registers,
+// the flags and memory written by instructions. Steps marked irreversible
+// (system calls, repeated string instructions, ...) can't be gone back past.
+// Once the process is run for real the recording no longer describes it,
+// that is noticed because its registers no longer match and replaying is
+// refused
+class TraceReplay {
+public:
+	explicit TraceReplay(const TraceLog *log);
+
+public:
+	void reset(const QStringList &register_names);
+	bool step_back();
+	bool step_forward();
+	bool reverse_continue();
+
+public:
+	bool can_step_back() const    { return valid_ && position_ > log_->first_step(); }
+	bool can_step_forward() const { return valid_ && position_ + 1 < log_->step_count(); }
+	quint64 position() const      { return position_; }
+
+public:
+	// true if the step before the current one can't be undone
+	bool at_irreversible();
+	edb::address_t irreversible_address();
+
+public:
+	// the decoded steps around the current one, they are decoded again when
+	// needed after being dropped
+	quint64 memory_used() const;
+	void drop_decoded() { block_.clear(); }
+
+private:
+	const TraceLog::Step &step(quint64 number);
+	bool in_sync(const State &state);
+	void restore(const TraceLog::Step &step, bool previous);
+	void finish(State *state, quint64 position);
+
+private:
+	const TraceLog         *log_;
+	QStringList             names_;
+	QVector<TraceLog::Step> block_;
+	quint64                 block_start_;
+	quint64                 position_;
+	bool                    valid_;
+};
+
+}
+
+#endif
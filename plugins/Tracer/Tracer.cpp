@@ -0,0 +1,360 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Tracer.h"
+#include "ArchProcessor.h"
+#include "BranchDecoder.h"
+#include "DialogSyscalls.h"
+#include "DialogTrace.h"
+#include "IDebugger.h"
+#include "State.h"
+#include "edb.h"
+
+#include <QInputDialog>
+#include <QLineEdit>
+#include <QMenu>
+#include <QMessageBox>
+#include <QRegExp>
+
+namespace Tracer {
+
+namespace {
+
+// how many syscalls a trace keeps, at 80 bytes each this is about 5MB
+const int SyscallTraceCapacity = 1 << 16;
+
+}
+
+//------------------------------------------------------------------------------
+// Name: Tracer
+// Desc:
+//------------------------------------------------------------------------------
+Tracer::Tracer() : menu_(0), start_action_(0), stop_action_(0), syscall_start_action_(0), syscall_stop_action_(0), record_action_(0), stop_record_action_(0), show_record_action_(0), step_back_action_(0), step_forward_action_(0), reverse_continue_action_(0), dialog_(0), syscall_dialog_(0), trace_start_(0), recorder_(&log_), replay_(&log_), replay_stale_(false) {
+	edb::memory::add_consumer("tracer: recording", this);
+}
+
+//------------------------------------------------------------------------------
+// Name: ~Tracer
+// Desc:
+//------------------------------------------------------------------------------
+Tracer::~Tracer() {
+	edb::memory::remove_consumer(this);
+	delete dialog_;
+	delete syscall_dialog_;
+}
+
+//------------------------------------------------------------------------------
+// Name: memory_used
+// Desc: the recording's ring and the steps the replay has decoded
+//------------------------------------------------------------------------------
+quint64 Tracer::memory_used() const {
+	return log_.memory_used() + replay_.memory_used();
+}
+
+//------------------------------------------------------------------------------
+// Name: trim
+// Desc: the recording itself can't be made again, only what the replay has
+//       decoded from it can be let go of
+//------------------------------------------------------------------------------
+void Tracer::trim(quint64 bytes) {
+	if(replay_.memory_used() != 0 && memory_used() > bytes) {
+		replay_.drop_decoded();
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: menu
+// Desc:
+//------------------------------------------------------------------------------
+QMenu *Tracer::menu(QWidget *parent) {
+
+	Q_ASSERT(parent);
+
+	if(!menu_) {
+		menu_ = new QMenu(tr("Tracer"), parent);
+		start_action_ = menu_->addAction(tr("&Start Branch Trace"), this, SLOT(start_branch_trace()));
+		stop_action_  = menu_->addAction(tr("S&top Branch Trace"), this, SLOT(stop_branch_trace()));
+		stop_action_->setEnabled(false);
+		menu_->addSeparator();
+		syscall_start_action_ = menu_->addAction(tr("Start S&yscall Trace"), this, SLOT(start_syscall_trace()));
+		syscall_stop_action_  = menu_->addAction(tr("Stop Syscall Tr&ace"), this, SLOT(stop_syscall_trace()));
+		syscall_stop_action_->setEnabled(false);
+		menu_->addSeparator();
+		record_action_      = menu_->addAction(tr("Start &Recording"), this, SLOT(start_recording()));
+		stop_record_action_ = menu_->addAction(tr("Stop R&ecording"), this, SLOT(stop_recording()));
+		show_record_action_ = menu_->addAction(tr("S&how Recording"), this, SLOT(show_recording()));
+		menu_->addSeparator();
+		step_back_action_        = menu_->addAction(tr("Step &Back"), this, SLOT(step_back()));
+		step_forward_action_     = menu_->addAction(tr("Step &Forward"), this, SLOT(step_forward()));
+		reverse_continue_action_ = menu_->addAction(tr("Re&verse Continue"), this, SLOT(reverse_continue()));
+		connect(menu_, SIGNAL(aboutToShow()), this, SLOT(update_menu()));
+		update_menu();
+	}
+
+	return menu_;
+}
+
+//------------------------------------------------------------------------------
+// Name: start_branch_trace
+// Desc: has the CPU record every branch the active thread takes from here on,
+//       the program can then be run at full speed instead of single stepped
+//------------------------------------------------------------------------------
+void Tracer::start_branch_trace() {
+
+	if(!edb::v1::debugger_core->process()) {
+		return;
+	}
+
+	State state;
+	edb::v1::debugger_core->get_state(&state);
+
+	if(!edb::v1::debugger_core->start_branch_trace()) {
+		QMessageBox::information(edb::v1::debugger_ui, tr("Branch Trace"), tr("Branch tracing is not available, it needs hardware support from the CPU and permission to use perf events."));
+		return;
+	}
+
+	trace_start_ = state.instruction_pointer();
+	start_action_->setEnabled(false);
+	stop_action_->setEnabled(true);
+}
+
+//------------------------------------------------------------------------------
+// Name: stop_branch_trace
+// Desc: stops the trace and shows the instructions which were executed
+//------------------------------------------------------------------------------
+void Tracer::stop_branch_trace() {
+
+	start_action_->setEnabled(true);
+	stop_action_->setEnabled(false);
+
+	if(!edb::v1::debugger_core->process()) {
+		return;
+	}
+
+	quint64 lost;
+	const QVector<BranchRecord> records = edb::v1::debugger_core->branch_trace(&lost);
+	edb::v1::debugger_core->stop_branch_trace();
+
+	State state;
+	edb::v1::debugger_core->get_state(&state);
+
+	if(!dialog_) {
+		dialog_ = new DialogTrace(edb::v1::debugger_ui);
+	}
+
+	dialog_->set_trace(decode_branch_trace(trace_start_, records, state.instruction_pointer()), lost);
+	dialog_->show();
+}
+
+//------------------------------------------------------------------------------
+// Name: start_syscall_trace
+// Desc: records the syscalls the process makes while it runs normally, like
+//       strace would. Asks which syscalls to record, none means all of them
+//------------------------------------------------------------------------------
+void Tracer::start_syscall_trace() {
+
+	if(!edb::v1::debugger_core->process()) {
+		return;
+	}
+
+	bool ok;
+	const QString text = QInputDialog::getText(edb::v1::debugger_ui, tr("Syscall Trace"), tr("Syscalls to trace, separated by spaces or commas (leave empty for all of them):"), QLineEdit::Normal, QString(), &ok);
+	if(!ok) {
+		return;
+	}
+
+	QList<edb::reg_t> numbers;
+	Q_FOREACH(const QString &name, text.split(QRegExp("[\\s,]+"), QString::SkipEmptyParts)) {
+		edb::reg_t number;
+		if(!edb::v1::arch_processor().syscall_number(name, &number)) {
+			QMessageBox::information(edb::v1::debugger_ui, tr("Syscall Trace"), tr("There is no syscall called \"%1\".").arg(name));
+			return;
+		}
+		numbers.push_back(number);
+	}
+
+	if(!edb::v1::debugger_core->start_syscall_trace(numbers, SyscallTraceCapacity)) {
+		QMessageBox::information(edb::v1::debugger_ui, tr("Syscall Trace"), tr("Syscall tracing is not available for this process."));
+		return;
+	}
+
+	syscall_start_action_->setEnabled(false);
+	syscall_stop_action_->setEnabled(true);
+}
+
+//------------------------------------------------------------------------------
+// Name: stop_syscall_trace
+// Desc: stops the trace and shows the syscalls which were recorded
+//------------------------------------------------------------------------------
+void Tracer::stop_syscall_trace() {
+
+	syscall_start_action_->setEnabled(true);
+	syscall_stop_action_->setEnabled(false);
+
+	if(!edb::v1::debugger_core->process()) {
+		return;
+	}
+
+	quint64 lost;
+	const QVector<SyscallRecord> records = edb::v1::debugger_core->syscall_trace(&lost);
+	edb::v1::debugger_core->stop_syscall_trace();
+
+	if(!syscall_dialog_) {
+		syscall_dialog_ = new DialogSyscalls(edb::v1::debugger_ui);
+	}
+
+	syscall_dialog_->set_syscalls(records, lost);
+	syscall_dialog_->show();
+}
+
+//------------------------------------------------------------------------------
+// Name: update_menu
+// Desc: the recorder stops by itself (breakpoints, signals), so its actions
+//       are brought up to date whenever the menu is shown
+//------------------------------------------------------------------------------
+void Tracer::update_menu() {
+	sync_replay();
+	record_action_->setEnabled(!recorder_.is_recording());
+	stop_record_action_->setEnabled(recorder_.is_recording());
+	show_record_action_->setEnabled(!recorder_.is_recording() && log_.is_open() && log_.step_count() != 0);
+	step_back_action_->setEnabled(replay_.can_step_back());
+	step_forward_action_->setEnabled(replay_.can_step_forward());
+	reverse_continue_action_->setEnabled(replay_.can_step_back());
+}
+
+//------------------------------------------------------------------------------
+// Name: sync_replay
+// Desc: once a recording has finished, replaying starts from its last step
+//------------------------------------------------------------------------------
+void Tracer::sync_replay() {
+	if(replay_stale_ && !recorder_.is_recording()) {
+		replay_.reset(recorder_.register_names());
+		replay_stale_ = false;
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: replay_failed
+// Desc:
+//------------------------------------------------------------------------------
+void Tracer::replay_failed() {
+	QMessageBox::information(edb::v1::debugger_ui, tr("Replay"), tr("The process has been run since it was recorded, the recording no longer describes it and can't be replayed."));
+}
+
+//------------------------------------------------------------------------------
+// Name: replay_irreversible
+// Desc:
+//------------------------------------------------------------------------------
+void Tracer::replay_irreversible() {
+	QMessageBox::information(edb::v1::debugger_ui, tr("Replay"), tr("The instruction at %1 wrote memory the recording couldn't see (a system call, a repeated string instruction or a state save), so it can't be undone.").arg(edb::v1::format_pointer(replay_.irreversible_address())));
+}
+
+//------------------------------------------------------------------------------
+// Name: step_back
+// Desc:
+//------------------------------------------------------------------------------
+void Tracer::step_back() {
+	sync_replay();
+	if(replay_.at_irreversible()) {
+		replay_irreversible();
+	} else if(replay_.can_step_back() && !replay_.step_back()) {
+		replay_failed();
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: step_forward
+// Desc:
+//------------------------------------------------------------------------------
+void Tracer::step_forward() {
+	sync_replay();
+	if(replay_.can_step_forward() && !replay_.step_forward()) {
+		replay_failed();
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: reverse_continue
+// Desc:
+//------------------------------------------------------------------------------
+void Tracer::reverse_continue() {
+	sync_replay();
+	if(replay_.at_irreversible()) {
+		replay_irreversible();
+	} else if(replay_.can_step_back()) {
+		if(!replay_.reverse_continue()) {
+			replay_failed();
+		} else if(replay_.at_irreversible()) {
+			replay_irreversible();
+		}
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: start_recording
+// Desc: single steps from here on, recording each instruction, until a
+//       breakpoint is reached or the recording is stopped
+//------------------------------------------------------------------------------
+void Tracer::start_recording() {
+
+	if(!edb::v1::debugger_core->process()) {
+		return;
+	}
+
+	// the dialog may be showing the previous recording
+	if(dialog_) {
+		dialog_->hide();
+	}
+
+	if(!recorder_.start()) {
+		QMessageBox::information(edb::v1::debugger_ui, tr("Recording"), tr("Could not create the recording file."));
+		return;
+	}
+
+	// nothing to replay until it stops
+	replay_.reset(recorder_.register_names());
+	replay_stale_ = true;
+}
+
+//------------------------------------------------------------------------------
+// Name: stop_recording
+// Desc: the recording stops after the next step
+//------------------------------------------------------------------------------
+void Tracer::stop_recording() {
+	recorder_.stop();
+}
+
+//------------------------------------------------------------------------------
+// Name: show_recording
+// Desc:
+//------------------------------------------------------------------------------
+void Tracer::show_recording() {
+
+	if(!dialog_) {
+		dialog_ = new DialogTrace(edb::v1::debugger_ui);
+	}
+
+	dialog_->set_log(&log_, recorder_.register_names());
+	dialog_->show();
+}
+
+#if QT_VERSION < 0x050000
+Q_EXPORT_PLUGIN2(Tracer, Tracer)
+#endif
+
+}
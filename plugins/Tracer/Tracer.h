@@ -0,0 +1,98 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef TRACER_20261014_H_
+#define TRACER_20261014_H_
+
+#include "IPlugin.h"
+#include "MemoryBudget.h"
+#include "TraceLog.h"
+#include "TraceRecorder.h"
+#include "TraceReplay.h"
+#include "Types.h"
+
+class QAction;
+class QMenu;
+
+namespace Tracer {
+
+class DialogSyscalls;
+class DialogTrace;
+
+class Tracer : public QObject, public IPlugin, public edb::memory::Consumer {
+	Q_OBJECT
+	Q_INTERFACES(IPlugin)
+#if QT_VERSION >= 0x050000
+	Q_PLUGIN_METADATA(IID "edb.IPlugin/1.0")
+#endif
+	Q_CLASSINFO("author", "Evan Teran")
+	Q_CLASSINFO("url", "http://www.codef00.com")
+
+public:
+	Tracer();
+	virtual ~Tracer();
+
+public:
+	virtual QMenu *menu(QWidget *parent = 0);
+
+public:
+	virtual quint64 memory_used() const;
+	virtual void trim(quint64 bytes);
+
+public Q_SLOTS:
+	void start_branch_trace();
+	void stop_branch_trace();
+	void start_syscall_trace();
+	void stop_syscall_trace();
+	void start_recording();
+	void stop_recording();
+	void show_recording();
+	void step_back();
+	void step_forward();
+	void reverse_continue();
+	void update_menu();
+
+private:
+	void replay_failed();
+	void replay_irreversible();
+	void sync_replay();
+
+private:
+	QMenu          *menu_;
+	QAction        *start_action_;
+	QAction        *stop_action_;
+	QAction        *syscall_start_action_;
+	QAction        *syscall_stop_action_;
+	QAction        *record_action_;
+	QAction        *stop_record_action_;
+	QAction        *show_record_action_;
+	QAction        *step_back_action_;
+	QAction        *step_forward_action_;
+	QAction        *reverse_continue_action_;
+	DialogTrace    *dialog_;
+	DialogSyscalls *syscall_dialog_;
+	edb::address_t  trace_start_;
+	TraceLog        log_;
+	TraceRecorder   recorder_;
+	TraceReplay     replay_;
+	bool            replay_stale_;
+};
+
+}
+
+#endif
@@ -0,0 +1,7 @@
+
+include(../plugins.pri)
+
+# Input
+HEADERS += Tracer.h DialogTrace.h DialogSyscalls.h TraceModel.h SyscallModel.h BranchDecoder.h TraceLog.h TraceRecorder.h TraceReplay.h
+FORMS += DialogTrace.ui DialogSyscalls.ui
+SOURCES += Tracer.cpp DialogTrace.cpp DialogSyscalls.cpp TraceModel.cpp SyscallModel.cpp BranchDecoder.cpp TraceLog.cpp TraceRecorder.cpp TraceReplay.cpp
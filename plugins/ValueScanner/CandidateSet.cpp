@@ -0,0 +1,132 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "CandidateSet.h"
+#include <cstring>
+
+namespace ValueScanner {
+
+//------------------------------------------------------------------------------
+// Name: first
+// Desc: the lowest bit set, or -1 if there are none
+//------------------------------------------------------------------------------
+int CandidateSet::Block::first() const {
+	return next(-1);
+}
+
+//------------------------------------------------------------------------------
+// Name: last
+// Desc: the highest bit set, or -1 if there are none
+//------------------------------------------------------------------------------
+int CandidateSet::Block::last() const {
+
+	for(int word = BlockWords - 1; word >= 0; --word) {
+		if(const quint64 w = bits[word]) {
+			return word * 64 + 63 - __builtin_clzll(w);
+		}
+	}
+
+	return -1;
+}
+
+//------------------------------------------------------------------------------
+// Name: next
+// Desc: the lowest bit set above <bit>, or -1 if there are none
+//------------------------------------------------------------------------------
+int CandidateSet::Block::next(int bit) const {
+
+	++bit;
+
+	for(int word = bit / 64; word < BlockWords; ++word) {
+		quint64 w = bits[word];
+		if(word == bit / 64) {
+			w &= ~Q_UINT64_C(0) << (bit % 64);
+		}
+
+		if(w) {
+			return word * 64 + __builtin_ctzll(w);
+		}
+	}
+
+	return -1;
+}
+
+//------------------------------------------------------------------------------
+// Name: count
+// Desc: how many bits are set
+//------------------------------------------------------------------------------
+int CandidateSet::Block::count() const {
+
+	int n = 0;
+	for(int word = 0; word < BlockWords; ++word) {
+		n += __builtin_popcountll(bits[word]);
+	}
+
+	return n;
+}
+
+//------------------------------------------------------------------------------
+// Name: CandidateSet
+// Desc: candidates are at <start> + n * <step> and hold <value_size> bytes
+//------------------------------------------------------------------------------
+CandidateSet::CandidateSet(edb::address_t start, std::size_t step, std::size_t value_size) : start_(start), step_(step), value_size_(value_size), count_(0) {
+	Q_ASSERT(step != 0);
+}
+
+//------------------------------------------------------------------------------
+// Name: add
+// Desc: adds the candidate at <address>, holding <value>. Addresses have to
+//       be added in increasing order
+//------------------------------------------------------------------------------
+void CandidateSet::add(edb::address_t address, const quint8 *value) {
+
+	Q_ASSERT(address >= start_ && (address - start_) % step_ == 0);
+
+	const edb::address_t position = (address - start_) / step_;
+	const edb::address_t block    = start_ + (position / BlockBits) * BlockBits * step_;
+	const int            bit      = position % BlockBits;
+
+	if(blocks_.isEmpty() || blocks_.last().address != block) {
+		Q_ASSERT(blocks_.isEmpty() || blocks_.last().address < block);
+
+		Block b;
+		b.address = block;
+		std::memset(b.bits, 0, sizeof(b.bits));
+		blocks_.push_back(b);
+	}
+
+	Block &b = blocks_.last();
+	Q_ASSERT(!(b.bits[bit / 64] & (Q_UINT64_C(1) << (bit % 64))));
+
+	b.bits[bit / 64] |= Q_UINT64_C(1) << (bit % 64);
+	b.values.append(reinterpret_cast<const char *>(value), value_size_);
+	++count_;
+}
+
+//------------------------------------------------------------------------------
+// Name: memory_used
+// Desc:
+//------------------------------------------------------------------------------
+quint64 CandidateSet::memory_used() const {
+	quint64 bytes = blocks_.capacity() * sizeof(Block);
+	Q_FOREACH(const Block &block, blocks_) {
+		bytes += block.values.capacity();
+	}
+	return bytes;
+}
+
+}
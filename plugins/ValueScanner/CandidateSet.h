@@ -0,0 +1,86 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef CANDIDATESET_20261014_H_
+#define CANDIDATESET_20261014_H_
+
+#include "Types.h"
+#include <QByteArray>
+#include <QVector>
+#include <cstddef>
+
+namespace ValueScanner {
+
+// the addresses in one region which are still candidates, and the value each
+// held when it was last read. A candidate is a position, every <step> bytes
+// from the start, and positions are grouped into blocks. Only blocks with a
+// candidate in them are stored, each as a bitmap with the values of its
+// candidates packed after each other, so a large region with a few matches
+// left costs a few blocks.
+//
+// Typical usage:
+//
+//     CandidateSet set(region->start(), step, size);
+//     set.add(address, value); // in increasing address order
+//
+//     Q_FOREACH(const CandidateSet::Block &block, set.blocks()) {
+//         for(int bit = block.first(); bit != -1; bit = block.next(bit)) {
+//             // block.address + bit * step holds a candidate
+//         }
+//     }
+class CandidateSet {
+public:
+	static const int BlockBits  = 512;
+	static const int BlockWords = BlockBits / 64;
+
+	struct Block {
+		int first() const;
+		int last() const;
+		int next(int bit) const;
+		int count() const;
+
+		edb::address_t address;           // of the block's first position
+		quint64        bits[BlockWords];
+		QByteArray     values;            // value_size bytes per set bit, lowest first
+	};
+
+public:
+	CandidateSet(edb::address_t start, std::size_t step, std::size_t value_size);
+
+public:
+	void add(edb::address_t address, const quint8 *value);
+
+public:
+	const QVector<Block> &blocks() const { return blocks_; }
+	edb::address_t start() const         { return start_; }
+	std::size_t step() const             { return step_; }
+	std::size_t value_size() const       { return value_size_; }
+	std::size_t count() const            { return count_; }
+	bool empty() const                   { return count_ == 0; }
+	quint64 memory_used() const;
+
+private:
+	edb::address_t start_;
+	std::size_t    step_;
+	std::size_t    value_size_;
+	std::size_t    count_;
+	QVector<Block> blocks_;
+};
+
+}
+
+#endif
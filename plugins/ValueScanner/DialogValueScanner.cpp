@@ -0,0 +1,536 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "DialogValueScanner.h"
+#include "ByteSearcher.h"
+#include "edb.h"
+#include "IDebugger.h"
+#include "IProcess.h"
+#include "MemoryRegions.h"
+#include "RegionScanner.h"
+#include "ResultsModel.h"
+#include <QMessageBox>
+#include <QProgressBar>
+#include <QVector>
+#include <cstring>
+
+#include "ui_DialogValueScanner.h"
+
+namespace ValueScanner {
+
+namespace {
+
+// in the order of cmbType
+enum Type {
+	TYPE_INT8,
+	TYPE_INT16,
+	TYPE_INT32,
+	TYPE_INT64,
+	TYPE_FLOAT,
+	TYPE_DOUBLE
+};
+
+// in the order of cmbCompare
+enum Compare {
+	COMPARE_EQUAL,
+	COMPARE_CHANGED,
+	COMPARE_UNCHANGED,
+	COMPARE_INCREASED,
+	COMPARE_DECREASED
+};
+
+// a first scan can leave millions of candidates, only this many are listed
+const std::size_t max_shown = 10000;
+
+// how many blocks of candidates are read in one batch
+const int batch_blocks = 1024;
+
+//------------------------------------------------------------------------------
+// Name: value_size
+// Desc:
+//------------------------------------------------------------------------------
+std::size_t value_size(int type) {
+	switch(type) {
+	case TYPE_INT8:   return sizeof(qint8);
+	case TYPE_INT16:  return sizeof(qint16);
+	case TYPE_INT32:  return sizeof(qint32);
+	case TYPE_INT64:  return sizeof(qint64);
+	case TYPE_FLOAT:  return sizeof(float);
+	case TYPE_DOUBLE: return sizeof(double);
+	default:
+		return 0;
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: parse_value
+// Desc: the bytes of <text> as a value of <type>. Integers may be given in
+//       hex with a 0x prefix, and either signed or unsigned as long as they
+//       fit
+//------------------------------------------------------------------------------
+bool parse_value(int type, const QString &text, QByteArray *value) {
+
+	const QString s = text.trimmed();
+	bool ok = false;
+
+	if(type == TYPE_FLOAT) {
+		const float f = s.toFloat(&ok);
+		if(ok) {
+			*value = QByteArray(reinterpret_cast<const char *>(&f), sizeof(f));
+		}
+	} else if(type == TYPE_DOUBLE) {
+		const double d = s.toDouble(&ok);
+		if(ok) {
+			*value = QByteArray(reinterpret_cast<const char *>(&d), sizeof(d));
+		}
+	} else {
+		const std::size_t size = value_size(type);
+		const int         bits = size * 8;
+
+		quint64 n;
+		if(s.startsWith('-')) {
+			const qint64 v = s.toLongLong(&ok, 0);
+			if(ok && bits < 64 && v < -(Q_INT64_C(1) << (bits - 1))) {
+				ok = false;
+			}
+			n = v;
+		} else {
+			n = s.toULongLong(&ok, 0);
+			if(ok && bits < 64 && (n >> bits) != 0) {
+				ok = false;
+			}
+		}
+
+		// the low bytes come first
+		if(ok) {
+			*value = QByteArray(reinterpret_cast<const char *>(&n), size);
+		}
+	}
+
+	return ok;
+}
+
+//------------------------------------------------------------------------------
+// Name: format_value
+// Desc:
+//------------------------------------------------------------------------------
+template <class T>
+QString format_value(const quint8 *p) {
+	T value;
+	std::memcpy(&value, p, sizeof(value));
+	return QString::number(value);
+}
+
+//------------------------------------------------------------------------------
+// Name: format_value
+// Desc: integers are shown signed
+//------------------------------------------------------------------------------
+QString format_value(int type, const quint8 *p) {
+	switch(type) {
+	case TYPE_INT8:   return QString::number(static_cast<qint8>(p[0]));
+	case TYPE_INT16:  return format_value<qint16>(p);
+	case TYPE_INT32:  return format_value<qint32>(p);
+	case TYPE_INT64:  return format_value<qint64>(p);
+	case TYPE_FLOAT:  return format_value<float>(p);
+	case TYPE_DOUBLE: return format_value<double>(p);
+	default:
+		return QString();
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: compare_values
+// Desc: the comparisons which depend on the type
+//------------------------------------------------------------------------------
+template <class T>
+bool compare_values(int compare, const quint8 *old_value, const quint8 *new_value) {
+
+	T a;
+	T b;
+	std::memcpy(&a, old_value, sizeof(a));
+	std::memcpy(&b, new_value, sizeof(b));
+
+	switch(compare) {
+	case COMPARE_INCREASED:
+		return b > a;
+	case COMPARE_DECREASED:
+		return b < a;
+	default:
+		return false;
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: matches
+// Desc: true if a candidate which held <old_value> and now holds <new_value>
+//       stays one. Equality is of the bytes, as in the first scan, so a float
+//       is only equal to exactly the same float
+//------------------------------------------------------------------------------
+bool matches(int type, int compare, const quint8 *old_value, const quint8 *new_value, const QByteArray &value) {
+
+	const std::size_t size = value_size(type);
+
+	switch(compare) {
+	case COMPARE_EQUAL:
+		return std::memcmp(new_value, value.constData(), size) == 0;
+	case COMPARE_CHANGED:
+		return std::memcmp(new_value, old_value, size) != 0;
+	case COMPARE_UNCHANGED:
+		return std::memcmp(new_value, old_value, size) == 0;
+	default:
+		break;
+	}
+
+	switch(type) {
+	case TYPE_INT8:   return compare_values<qint8>(compare, old_value, new_value);
+	case TYPE_INT16:  return compare_values<qint16>(compare, old_value, new_value);
+	case TYPE_INT32:  return compare_values<qint32>(compare, old_value, new_value);
+	case TYPE_INT64:  return compare_values<qint64>(compare, old_value, new_value);
+	case TYPE_FLOAT:  return compare_values<float>(compare, old_value, new_value);
+	case TYPE_DOUBLE: return compare_values<double>(compare, old_value, new_value);
+	default:
+		return false;
+	}
+}
+
+// shows each candidate with the value it holds now
+class ValueFormatter : public ResultsModel::Formatter {
+public:
+	virtual QString format(const ResultsModel::Result &result) const {
+
+		quint8 buffer[sizeof(quint64)];
+		if(IProcess *process = edb::v1::debugger_core->process()) {
+			if(process->read_bytes(result.address, buffer, result.size)) {
+				return QString("%1: %2").arg(edb::v1::format_pointer(result.address), format_value(result.type, buffer));
+			}
+		}
+
+		return QString("%1: ??").arg(edb::v1::format_pointer(result.address));
+	}
+};
+
+// finds every position holding the value by searching for its bytes, the
+// regions are searched in parallel and each one's hits are added to its own
+// candidate set
+class FirstScan : public RegionScanner::Task {
+public:
+	FirstScan(const QByteArray &value, std::size_t step, QList<CandidateSet> *candidates, QProgressBar *progress)
+		: searcher_(value, step), value_(value), step_(step), candidates_(candidates), progress_(progress) {
+	}
+
+public:
+	class Hits : public List<edb::address_t> {
+	public:
+		edb::address_t region; // where the region the hits are in starts
+	};
+
+public:
+	virtual std::size_t lookahead() const {
+		return value_.size() - 1;
+	}
+
+	virtual Result *scan(const RegionScanner::Chunk &chunk) const {
+
+		Hits *const result = new Hits;
+		result->region = chunk.region->start();
+
+		const quint8 *const first = chunk.data.constData();
+		const quint8 *const last  = first + qMin<std::size_t>(chunk.data.size(), chunk.size + value_.size() - 1);
+
+		const quint8 *p = first;
+		while((p = searcher_.find(p, last, chunk.address + (p - first))) != last) {
+			result->items.push_back(chunk.address + (p - first));
+			++p;
+		}
+
+		return result;
+	}
+
+	virtual void merge(Result *result) {
+
+		const Hits *const hits = static_cast<Hits *>(result);
+		if(hits->items.isEmpty()) {
+			return;
+		}
+
+		// chunks come in address order, so a region's hits are all together
+		if(candidates_->isEmpty() || candidates_->last().start() != hits->region) {
+			candidates_->push_back(CandidateSet(hits->region, step_, value_.size()));
+		}
+
+		CandidateSet &set = candidates_->last();
+		const quint8 *const value = reinterpret_cast<const quint8 *>(value_.constData());
+
+		Q_FOREACH(edb::address_t address, hits->items) {
+			set.add(address, value);
+		}
+	}
+
+	virtual void progress(int percent) {
+		progress_->setValue(percent);
+	}
+
+private:
+	const ByteSearcher         searcher_;
+	const QByteArray           value_;
+	const std::size_t          step_;
+	QList<CandidateSet> *const candidates_;
+	QProgressBar        *const progress_;
+};
+
+}
+
+//------------------------------------------------------------------------------
+// Name: DialogValueScanner
+// Desc:
+//------------------------------------------------------------------------------
+DialogValueScanner::DialogValueScanner(QWidget *parent) : QDialog(parent), ui(new Ui::DialogValueScanner), model_(new ResultsModel(this)), type_(TYPE_INT32) {
+	ui->setupUi(this);
+	ui->progressBar->setValue(0);
+	model_->setFormatter(new ValueFormatter);
+	ui->listView->setModel(model_);
+	show_candidates();
+
+	edb::memory::add_consumer("value scanner: candidates", this);
+}
+
+//------------------------------------------------------------------------------
+// Name: ~DialogValueScanner
+// Desc:
+//------------------------------------------------------------------------------
+DialogValueScanner::~DialogValueScanner() {
+	edb::memory::remove_consumer(this);
+	delete ui;
+}
+
+//------------------------------------------------------------------------------
+// Name: memory_used
+// Desc:
+//------------------------------------------------------------------------------
+quint64 DialogValueScanner::memory_used() const {
+	quint64 bytes = 0;
+	Q_FOREACH(const CandidateSet &set, candidates_) {
+		bytes += set.memory_used();
+	}
+	return bytes;
+}
+
+//------------------------------------------------------------------------------
+// Name: trim
+// Desc: the candidates are what the scans so far have narrowed things down
+//       to, they can't be made again, so they are only counted
+//------------------------------------------------------------------------------
+void DialogValueScanner::trim(quint64 bytes) {
+	Q_UNUSED(bytes);
+}
+
+//------------------------------------------------------------------------------
+// Name: first_scan
+// Desc: starts over with every position holding the value
+//------------------------------------------------------------------------------
+void DialogValueScanner::first_scan() {
+
+	const int type = ui->cmbType->currentIndex();
+
+	QByteArray value;
+	if(!parse_value(type, ui->txtValue->text(), &value)) {
+		QMessageBox::information(this, tr("Invalid Value"), tr("The value to scan for is not a valid %1.").arg(ui->cmbType->currentText()));
+		return;
+	}
+
+	edb::v1::memory_regions().sync();
+
+	QList<IRegion::pointer> regions;
+	Q_FOREACH(const IRegion::pointer &region, edb::v1::memory_regions().regions()) {
+		if(region->readable() && (!ui->chkWritable->isChecked() || region->writable())) {
+			regions.push_back(region);
+		}
+	}
+
+	candidates_.clear();
+	type_ = type;
+
+	FirstScan scan(value, ui->chkAligned->isChecked() ? value.size() : 1, &candidates_, ui->progressBar);
+	RegionScanner().run(regions, &scan);
+}
+
+//------------------------------------------------------------------------------
+// Name: next_scan
+// Desc: keeps the candidates which pass the comparison. Only they are read,
+//       each block of them as one request from its first candidate to the end
+//       of its last, batch_blocks requests at a time
+//------------------------------------------------------------------------------
+void DialogValueScanner::next_scan() {
+
+	const int compare = ui->cmbCompare->currentIndex();
+
+	QByteArray value;
+	if(compare == COMPARE_EQUAL && !parse_value(type_, ui->txtValue->text(), &value)) {
+		QMessageBox::information(this, tr("Invalid Value"), tr("The value to compare with is not a valid %1.").arg(ui->cmbType->itemText(type_)));
+		return;
+	}
+
+	IProcess *const process = edb::v1::debugger_core->process();
+	if(!process) {
+		return;
+	}
+
+	int total_blocks = 0;
+	Q_FOREACH(const CandidateSet &set, candidates_) {
+		total_blocks += set.blocks().size();
+	}
+
+	QList<CandidateSet> narrowed;
+	QVector<IProcess::ReadRequest> requests;
+	QVector<std::size_t>           offsets;
+	QVector<quint8>                buffer;
+	int                            blocks_done = 0;
+
+	Q_FOREACH(const CandidateSet &set, candidates_) {
+
+		CandidateSet next(set.start(), set.step(), set.value_size());
+
+		const QVector<CandidateSet::Block> &blocks = set.blocks();
+		const std::size_t step = set.step();
+		const std::size_t size = set.value_size();
+
+		for(int first = 0; first < blocks.size(); first += batch_blocks) {
+			const int last = qMin(first + batch_blocks, blocks.size());
+
+			// where each block's span goes in the buffer
+			offsets.clear();
+			std::size_t buffer_size = 0;
+			for(int i = first; i < last; ++i) {
+				offsets.push_back(buffer_size);
+				buffer_size += (blocks[i].last() - blocks[i].first()) * step + size;
+			}
+
+			buffer.resize(buffer_size);
+
+			requests.clear();
+			for(int i = first; i < last; ++i) {
+				const CandidateSet::Block &block = blocks[i];
+				const std::size_t length = (block.last() - block.first()) * step + size;
+				requests.push_back(IProcess::ReadRequest(block.address + block.first() * step, &buffer[offsets[i - first]], length));
+			}
+
+			const QVector<bool> results = process->read_batch(requests);
+
+			for(int i = first; i < last; ++i) {
+
+				// a block which can't be read any more has been unmapped
+				if(!results[i - first]) {
+					continue;
+				}
+
+				const CandidateSet::Block &block = blocks[i];
+				const quint8 *const span      = &buffer[offsets[i - first]];
+				const quint8 *      old_value = reinterpret_cast<const quint8 *>(block.values.constData());
+				const int           first_bit = block.first();
+
+				for(int bit = first_bit; bit != -1; bit = block.next(bit)) {
+					const quint8 *const new_value = span + (bit - first_bit) * step;
+					if(matches(type_, compare, old_value, new_value, value)) {
+						next.add(block.address + bit * step, new_value);
+					}
+					old_value += size;
+				}
+			}
+
+			blocks_done += last - first;
+			ui->progressBar->setValue(blocks_done * 100 / total_blocks);
+		}
+
+		if(!next.empty()) {
+			narrowed.push_back(next);
+		}
+	}
+
+	candidates_ = narrowed;
+}
+
+//------------------------------------------------------------------------------
+// Name: show_candidates
+// Desc: lists the first few candidates and how many there are in all
+//------------------------------------------------------------------------------
+void DialogValueScanner::show_candidates() {
+
+	model_->clear();
+
+	QVector<ResultsModel::Result> results;
+	std::size_t total = 0;
+
+	Q_FOREACH(const CandidateSet &set, candidates_) {
+		total += set.count();
+
+		Q_FOREACH(const CandidateSet::Block &block, set.blocks()) {
+			for(int bit = block.first(); bit != -1 && static_cast<std::size_t>(results.size()) < max_shown; bit = block.next(bit)) {
+				const ResultsModel::Result r = { block.address + bit * set.step(), static_cast<quint32>(type_), static_cast<quint32>(set.value_size()) };
+				results.push_back(r);
+			}
+		}
+	}
+
+	model_->addResults(results);
+
+	if(total > max_shown) {
+		ui->lblCount->setText(tr("%1 candidates, the first %2 are shown").arg(total).arg(max_shown));
+	} else {
+		ui->lblCount->setText(tr("%1 candidates").arg(total));
+	}
+
+	// the first scan always looks for the value itself
+	ui->cmbCompare->setEnabled(total != 0);
+	ui->btnNextScan->setEnabled(total != 0);
+}
+
+//------------------------------------------------------------------------------
+// Name: on_btnFirstScan_clicked
+// Desc:
+//------------------------------------------------------------------------------
+void DialogValueScanner::on_btnFirstScan_clicked() {
+	ui->btnFirstScan->setEnabled(false);
+	ui->progressBar->setValue(0);
+	first_scan();
+	show_candidates();
+	ui->progressBar->setValue(100);
+	ui->btnFirstScan->setEnabled(true);
+}
+
+//------------------------------------------------------------------------------
+// Name: on_btnNextScan_clicked
+// Desc:
+//------------------------------------------------------------------------------
+void DialogValueScanner::on_btnNextScan_clicked() {
+	ui->btnFirstScan->setEnabled(false);
+	ui->btnNextScan->setEnabled(false);
+	ui->progressBar->setValue(0);
+	next_scan();
+	show_candidates();
+	ui->progressBar->setValue(100);
+	ui->btnFirstScan->setEnabled(true);
+}
+
+//------------------------------------------------------------------------------
+// Name: on_listView_doubleClicked
+// Desc: follows the candidate in the data view
+//------------------------------------------------------------------------------
+void DialogValueScanner::on_listView_doubleClicked(const QModelIndex &index) {
+	edb::v1::dump_data(model_->result(index).address, false);
+}
+
+}
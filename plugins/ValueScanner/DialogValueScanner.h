@@ -0,0 +1,64 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef DIALOGVALUESCANNER_20261014_H_
+#define DIALOGVALUESCANNER_20261014_H_
+
+#include "CandidateSet.h"
+#include "MemoryBudget.h"
+#include <QDialog>
+#include <QList>
+
+class QModelIndex;
+class ResultsModel;
+
+namespace ValueScanner {
+
+namespace Ui { class DialogValueScanner; }
+
+class DialogValueScanner : public QDialog, public edb::memory::Consumer {
+	Q_OBJECT
+
+public:
+	DialogValueScanner(QWidget *parent = 0);
+	virtual ~DialogValueScanner();
+
+public:
+	virtual quint64 memory_used() const;
+	virtual void trim(quint64 bytes);
+
+public Q_SLOTS:
+	void on_btnFirstScan_clicked();
+	void on_btnNextScan_clicked();
+	void on_listView_doubleClicked(const QModelIndex &index);
+
+private:
+	void first_scan();
+	void next_scan();
+	void show_candidates();
+
+private:
+	Ui::DialogValueScanner *const ui;
+	ResultsModel           *const model_;
+	QList<CandidateSet>           candidates_;
+	int                           type_;       // of the values in candidates_
+};
+
+}
+
+#endif
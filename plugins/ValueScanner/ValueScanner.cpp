@@ -0,0 +1,69 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "ValueScanner.h"
+#include "edb.h"
+#include "DialogValueScanner.h"
+#include <QMenu>
+
+namespace ValueScanner {
+
+//------------------------------------------------------------------------------
+// Name: ValueScanner
+// Desc:
+//------------------------------------------------------------------------------
+ValueScanner::ValueScanner() : menu_(0) {
+}
+
+//------------------------------------------------------------------------------
+// Name: ~ValueScanner
+// Desc:
+//------------------------------------------------------------------------------
+ValueScanner::~ValueScanner() {
+}
+
+//------------------------------------------------------------------------------
+// Name: menu
+// Desc:
+//------------------------------------------------------------------------------
+QMenu *ValueScanner::menu(QWidget *parent) {
+
+	Q_ASSERT(parent);
+
+	if(!menu_) {
+		menu_ = new QMenu(tr("ValueScanner"), parent);
+		menu_->addAction(tr("&Value Scan"), this, SLOT(show_menu()));
+	}
+
+	return menu_;
+}
+
+//------------------------------------------------------------------------------
+// Name: show_menu
+// Desc:
+//------------------------------------------------------------------------------
+void ValueScanner::show_menu() {
+	static QDialog *const dialog = new DialogValueScanner(edb::v1::debugger_ui);
+	dialog->show();
+}
+
+#if QT_VERSION < 0x050000
+Q_EXPORT_PLUGIN2(ValueScanner, ValueScanner)
+#endif
+
+}
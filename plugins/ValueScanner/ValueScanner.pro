@@ -0,0 +1,7 @@
+include(../plugins.pri)
+
+# Input
+HEADERS += ValueScanner.h DialogValueScanner.h CandidateSet.h
+FORMS += DialogValueScanner.ui
+SOURCES += ValueScanner.cpp DialogValueScanner.cpp CandidateSet.cpp
+OTHER_FILES += ValueScanner.json
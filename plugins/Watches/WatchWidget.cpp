@@ -0,0 +1,383 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "WatchWidget.h"
+#include "IDebugger.h"
+#include "IProcess.h"
+#include "State.h"
+#include "edb.h"
+#include <QBrush>
+#include <QInputDialog>
+#include <QMenu>
+#include <QMessageBox>
+#include <QTableWidgetItem>
+#include <algorithm>
+
+#include "ui_WatchWidget.h"
+
+namespace Watches {
+
+namespace {
+
+// nested dereferences each need another round of reads, an expression nested
+// deeper than this is most likely not worth waiting for
+const int max_rounds = 16;
+
+// reads memory out of what was fetched for this stop. Anything which wasn't
+// fetched yet is noted down for the next batch, the evaluation fails until then
+struct batched_reader {
+	batched_reader(const WatchWidget::Memory *memory, QVector<edb::address_t> *reads, QVector<edb::address_t> *missing) : memory_(memory), reads_(reads), missing_(missing) {
+	}
+
+	edb::address_t operator()(edb::address_t address, bool *ok, ExpressionError *err) const {
+
+		const WatchWidget::Memory::const_iterator it = memory_->find(address);
+		if(it == memory_->end()) {
+			missing_->push_back(address);
+			*ok  = false;
+			*err = ExpressionError(ExpressionError::CANNOT_READ_MEMORY);
+			return 0;
+		}
+
+		reads_->push_back(address);
+
+		*ok = it->ok;
+		if(!it->ok) {
+			*err = ExpressionError(ExpressionError::CANNOT_READ_MEMORY);
+		}
+		return it->value;
+	}
+
+	const WatchWidget::Memory *memory_;
+	QVector<edb::address_t>   *reads_;
+	QVector<edb::address_t>   *missing_;
+};
+
+}
+
+//------------------------------------------------------------------------------
+// Name: WatchWidget
+// Desc:
+//------------------------------------------------------------------------------
+WatchWidget::WatchWidget(QWidget *parent, Qt::WindowFlags f) : QWidget(parent, f), ui(new Ui::WatchWidget) {
+	ui->setupUi(this);
+}
+
+//------------------------------------------------------------------------------
+// Name: ~WatchWidget
+// Desc:
+//------------------------------------------------------------------------------
+WatchWidget::~WatchWidget() {
+	delete ui;
+}
+
+//------------------------------------------------------------------------------
+// Name: on_btnAdd_clicked
+// Desc:
+//------------------------------------------------------------------------------
+void WatchWidget::on_btnAdd_clicked() {
+
+	bool ok;
+	const QString text = QInputDialog::getText(ui->tableWidget, tr("Add Watch"), tr("Expression:"), QLineEdit::Normal, QString(), &ok);
+	if(ok && !text.isEmpty()) {
+		add_expression(text);
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: on_btnDel_clicked
+// Desc:
+//------------------------------------------------------------------------------
+void WatchWidget::on_btnDel_clicked() {
+	const int row = ui->tableWidget->currentRow();
+	if(row >= 0 && row < watches_.size()) {
+		ui->tableWidget->removeRow(row);
+		watches_.remove(row);
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: on_btnClear_clicked
+// Desc:
+//------------------------------------------------------------------------------
+void WatchWidget::on_btnClear_clicked() {
+	ui->tableWidget->clearContents();
+	ui->tableWidget->setRowCount(0);
+	watches_.clear();
+}
+
+//------------------------------------------------------------------------------
+// Name: on_tableWidget_cellDoubleClicked
+// Desc:
+//------------------------------------------------------------------------------
+void WatchWidget::on_tableWidget_cellDoubleClicked(int row, int col) {
+	Q_UNUSED(col);
+	edit_expression(row);
+}
+
+//------------------------------------------------------------------------------
+// Name: on_tableWidget_customContextMenuRequested
+// Desc:
+//------------------------------------------------------------------------------
+void WatchWidget::on_tableWidget_customContextMenuRequested(const QPoint &pos) {
+
+	QMenu menu;
+	QAction *const actionAdd   = menu.addAction(tr("&Add Watch"));
+	QAction *const actionEdit  = menu.addAction(tr("&Edit Watch"));
+	QAction *const actionDel   = menu.addAction(tr("&Delete Watch"));
+	QAction *const actionClear = menu.addAction(tr("&Clear"));
+	QAction *const chosen = menu.exec(ui->tableWidget->mapToGlobal(pos));
+
+	if(chosen == actionAdd) {
+		on_btnAdd_clicked();
+	} else if(chosen == actionEdit) {
+		edit_expression(ui->tableWidget->currentRow());
+	} else if(chosen == actionDel) {
+		on_btnDel_clicked();
+	} else if(chosen == actionClear) {
+		on_btnClear_clicked();
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: add_expression
+// Desc:
+//------------------------------------------------------------------------------
+void WatchWidget::add_expression(const QString &text) {
+
+	const int row = ui->tableWidget->rowCount();
+	ui->tableWidget->setRowCount(row + 1);
+	ui->tableWidget->setItem(row, 0, new QTableWidgetItem(text));
+	ui->tableWidget->setItem(row, 1, new QTableWidgetItem);
+
+	watches_.push_back(Watch());
+	watches_.back().evaluated = false;
+	watches_.back().changed   = false;
+
+	refresh();
+}
+
+//------------------------------------------------------------------------------
+// Name: edit_expression
+// Desc:
+//------------------------------------------------------------------------------
+bool WatchWidget::edit_expression(int row) {
+
+	QTableWidgetItem *const item = ui->tableWidget->item(row, 0);
+	if(!item || row >= watches_.size()) {
+		return false;
+	}
+
+	bool ok;
+	const QString text = QInputDialog::getText(ui->tableWidget, tr("Edit Watch"), tr("Expression:"), QLineEdit::Normal, item->text(), &ok);
+	if(!ok || text.isEmpty()) {
+		return false;
+	}
+
+	item->setText(text);
+	watches_[row].evaluated = false;
+	refresh();
+	return true;
+}
+
+//------------------------------------------------------------------------------
+// Name: inputs_unchanged
+// Desc: true if <watch> would read the same registers and memory as it did at
+//       the last stop, in which case its value can't have changed either
+//------------------------------------------------------------------------------
+bool WatchWidget::inputs_unchanged(const Watch &watch, const State &state, const Memory &memory) const {
+
+	const CompiledExpression &expression = watch.expression;
+
+	if(!watch.evaluated || !expression.valid() || expression.has_named_variables() || expression.stale()) {
+		return false;
+	}
+
+	const QVector<int> &registers = expression.registers();
+	for(int i = 0; i < registers.size(); ++i) {
+		if(registers[i] != -1 && state.register_value(registers[i]) != watch.registers[i]) {
+			return false;
+		}
+	}
+
+	for(int i = 0; i < watch.reads.size(); ++i) {
+		const Memory::const_iterator it = memory.find(watch.reads[i]);
+		if(it == memory.end() || it->ok != watch.words[i].ok || it->value != watch.words[i].value) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+//------------------------------------------------------------------------------
+// Name: read_words
+// Desc: fetches a word from each of <addresses> which isn't in <memory> yet
+//       with a single batched read
+//------------------------------------------------------------------------------
+void WatchWidget::read_words(const QVector<edb::address_t> &wanted, Memory *memory) const {
+
+	IProcess *const process = edb::v1::debugger_core->process();
+
+	QVector<edb::address_t> addresses;
+	Q_FOREACH(edb::address_t address, wanted) {
+		if(!memory->contains(address)) {
+			addresses.push_back(address);
+		}
+	}
+
+	std::sort(addresses.begin(), addresses.end());
+	addresses.erase(std::unique(addresses.begin(), addresses.end()), addresses.end());
+
+	if(addresses.isEmpty()) {
+		return;
+	}
+
+	QVector<edb::address_t> values(addresses.size());
+	QVector<IProcess::ReadRequest> requests;
+	requests.reserve(addresses.size());
+	for(int i = 0; i < addresses.size(); ++i) {
+		requests.push_back(IProcess::ReadRequest(addresses[i], &values[i], sizeof(edb::address_t)));
+	}
+
+	const QVector<bool> results = process->read_batch(requests);
+
+	for(int i = 0; i < addresses.size(); ++i) {
+		Word word;
+		word.value = values[i];
+		word.ok    = results[i];
+		memory->insert(addresses[i], word);
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: show_value
+// Desc: a value which changed since the last stop is shown in red, like the
+//       registers are
+//------------------------------------------------------------------------------
+void WatchWidget::show_value(int row) {
+	if(QTableWidgetItem *const item = ui->tableWidget->item(row, 1)) {
+		item->setText(watches_[row].value);
+		item->setForeground(watches_[row].changed ? QBrush(Qt::red) : QBrush());
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: refresh
+// Desc: evaluates every watch for the current stop. The memory the watches
+//       read last time is fetched up front in one batched read, each further
+//       level of dereferences costs one more. Only rows whose value or
+//       highlight changes are touched
+//------------------------------------------------------------------------------
+void WatchWidget::refresh() {
+
+	if(!edb::v1::debugger_core || !edb::v1::debugger_core->process()) {
+		return;
+	}
+
+	State state;
+	if(const StopSnapshot::pointer snapshot = edb::v1::stop_snapshot()) {
+		state = snapshot->state;
+	} else {
+		edb::v1::debugger_core->get_state(&state);
+	}
+
+	// the addresses are usually the same as last time, so in most cases this
+	// is the only read there is
+	QVector<edb::address_t> addresses;
+	for(int row = 0; row < watches_.size(); ++row) {
+		const Watch &watch = watches_[row];
+		if(watch.evaluated) {
+			addresses += watch.reads;
+		}
+	}
+
+	Memory memory;
+	read_words(addresses, &memory);
+
+	QVector<int> pending;
+	for(int row = 0; row < watches_.size(); ++row) {
+		Watch &watch = watches_[row];
+
+		// a watch which was entered or changed since is compiled again
+		if(!watch.evaluated || watch.expression.stale()) {
+			if(QTableWidgetItem *const item = ui->tableWidget->item(row, 0)) {
+				watch.expression.compile(item->text(), state);
+			}
+		}
+
+		if(inputs_unchanged(watch, state, memory)) {
+			if(watch.changed) {
+				watch.changed = false;
+				show_value(row);
+			}
+		} else {
+			pending.push_back(row);
+		}
+	}
+
+	for(int round = 0; round < max_rounds && !pending.isEmpty(); ++round) {
+
+		QVector<edb::address_t> missing;
+		QVector<int>            still_pending;
+
+		Q_FOREACH(int row, pending) {
+			Watch &watch = watches_[row];
+
+			QVector<edb::address_t> reads;
+			QVector<edb::address_t> watch_missing;
+
+			edb::address_t  result;
+			ExpressionError error;
+			const bool ok = watch.expression.evaluate(state, batched_reader(&memory, &reads, &watch_missing), &result, &error);
+
+			if(!watch_missing.isEmpty() && round + 1 < max_rounds) {
+				missing += watch_missing;
+				still_pending.push_back(row);
+				continue;
+			}
+
+			watch.reads = reads;
+			watch.words.clear();
+			Q_FOREACH(edb::address_t address, reads) {
+				watch.words.push_back(memory.value(address));
+			}
+
+			watch.registers.clear();
+			Q_FOREACH(int index, watch.expression.registers()) {
+				watch.registers.push_back(index != -1 ? state.register_value(index) : 0);
+			}
+
+			const QString value = ok ? edb::v1::format_pointer(result) : QString::fromLatin1(error.what());
+			const bool changed  = watch.evaluated && value != watch.value;
+
+			if(changed != watch.changed || value != watch.value || !watch.evaluated) {
+				watch.value   = value;
+				watch.changed = changed;
+				show_value(row);
+			}
+
+			watch.evaluated = true;
+		}
+
+		read_words(missing, &memory);
+		qSwap(pending, still_pending);
+	}
+}
+
+}
@@ -0,0 +1,83 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef WATCHWIDGET_20261014_H_
+#define WATCHWIDGET_20261014_H_
+
+#include "CompiledExpression.h"
+#include "Types.h"
+#include <QHash>
+#include <QVector>
+#include <QWidget>
+
+class State;
+
+namespace Watches {
+
+namespace Ui { class WatchWidget; }
+
+class WatchWidget : public QWidget {
+	Q_OBJECT
+
+public:
+	WatchWidget(QWidget *parent = 0, Qt::WindowFlags f = 0);
+	virtual ~WatchWidget();
+
+public Q_SLOTS:
+	void on_btnAdd_clicked();
+	void on_btnDel_clicked();
+	void on_btnClear_clicked();
+	void on_tableWidget_cellDoubleClicked(int row, int col);
+	void on_tableWidget_customContextMenuRequested(const QPoint &pos);
+	void refresh();
+
+public:
+	// a word of memory as it was at this stop
+	struct Word {
+		edb::address_t value;
+		bool           ok;
+	};
+
+	typedef QHash<edb::address_t, Word> Memory;
+
+private:
+	struct Watch {
+		CompiledExpression      expression;
+		QVector<edb::reg_t>     registers; // the registers it read at the last stop
+		QVector<edb::address_t> reads;     // and the memory, in the order it was read
+		QVector<Word>           words;
+		bool                    evaluated;
+		bool                    changed;
+		QString                 value;
+	};
+
+private:
+	void add_expression(const QString &text);
+	bool edit_expression(int row);
+	bool inputs_unchanged(const Watch &watch, const State &state, const Memory &memory) const;
+	void read_words(const QVector<edb::address_t> &wanted, Memory *memory) const;
+	void show_value(int row);
+
+private:
+	Ui::WatchWidget *ui;
+	QVector<Watch>   watches_;
+};
+
+}
+
+#endif
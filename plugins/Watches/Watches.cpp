@@ -0,0 +1,75 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Watches.h"
+#include "WatchWidget.h"
+#include "Diagnostics.h"
+#include "edb.h"
+#include <QDockWidget>
+#include <QMainWindow>
+#include <QMenu>
+
+namespace Watches {
+
+//------------------------------------------------------------------------------
+// Name: Watches
+// Desc:
+//------------------------------------------------------------------------------
+Watches::Watches() : QObject(0), menu_(0), watch_widget_(0) {
+}
+
+//------------------------------------------------------------------------------
+// Name: menu
+// Desc:
+//------------------------------------------------------------------------------
+QMenu *Watches::menu(QWidget *parent) {
+
+	Q_ASSERT(parent);
+
+	if(!menu_) {
+
+		// if we are dealing with a main window (and we are...)
+		// add the dock object
+		if(QMainWindow *const main_window = qobject_cast<QMainWindow *>(edb::v1::debugger_ui)) {
+			watch_widget_ = new WatchWidget;
+
+			// make the dock widget and _name_ it, it is important to name it so
+			// that it's state is saved in the GUI info
+			QDockWidget *const dock_widget = new QDockWidget(tr("Watches"), main_window);
+			dock_widget->setObjectName(QString::fromUtf8("Watches"));
+			dock_widget->setWidget(watch_widget_);
+
+			// add it to the dock
+			main_window->addDockWidget(Qt::RightDockWidgetArea, dock_widget);
+
+			// make the menu and add the show/hide toggle for the widget
+			menu_ = new QMenu(tr("Watches"), parent);
+			menu_->addAction(dock_widget->toggleViewAction());
+
+			edb::diagnostics::connect_gui_updated(watch_widget_, SLOT(refresh()));
+		}
+	}
+
+	return menu_;
+}
+
+#if QT_VERSION < 0x050000
+Q_EXPORT_PLUGIN2(Watches, Watches)
+#endif
+
+}
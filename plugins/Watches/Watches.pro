@@ -0,0 +1,8 @@
+
+include(../plugins.pri)
+
+# Input
+HEADERS += Watches.h WatchWidget.h
+FORMS += WatchWidget.ui
+SOURCES += Watches.cpp WatchWidget.cpp
+
@@ -3,6 +3,7 @@ LEVEL = ../..
 include(../qmake/clean-objects.pri)
 include(../qmake/c++11.pri)
 include(../qmake/qt5-gui.pri)
+include(../qmake/tracing.pri)
 
 TEMPLATE = lib
 CONFIG   += plugin
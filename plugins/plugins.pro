@@ -4,20 +4,30 @@ TEMPLATE = subdirs
 SUBDIRS += \
 	Analyzer \
 	Assembler \
+	Benchmark \
 	BinaryInfo \
 	BinarySearcher \
 	Bookmarks \
 	BreakpointManager \
 	CheckVersion \
+	Counters \
+	Coverage \
 	DebuggerCore \
+	DiagnosticsPanel \
 	DumpState \
 	FunctionFinder \
 	HardwareBreakpoints \
 	OpcodeSearcher \
+	Patches \
+	PointerScanner \
 	ProcessProperties \
+	Profiler \
 	ROPTool \
 	References \
 	SymbolViewer \
+	Tracer \
+	ValueScanner \
+	Watches \
     Backtrace
 
 unix {
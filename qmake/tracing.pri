@@ -0,0 +1,5 @@
+# qmake CONFIG+=tracing builds edb and its plugins with EDB_TRACE_SCOPE spans
+# recorded, to be exported from the Diagnostics dialog for chrome://tracing
+tracing {
+	DEFINES += EDB_TRACING
+}
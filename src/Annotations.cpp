@@ -0,0 +1,149 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Annotations.h"
+
+#include <algorithm>
+
+namespace {
+
+struct EntryOrder {
+	bool operator()(const Annotations::Entry &lhs, edb::address_t rhs) const {
+		return lhs.address < rhs;
+	}
+};
+
+}
+
+//------------------------------------------------------------------------------
+// Name: Annotations
+// Desc:
+//------------------------------------------------------------------------------
+Annotations::Annotations() : QObject(0) {
+}
+
+//------------------------------------------------------------------------------
+// Name: lower_bound
+// Desc: the first entry of <kind> at or after <address>
+//------------------------------------------------------------------------------
+Annotations::const_iterator Annotations::lower_bound(Kind kind, edb::address_t address) const {
+	const QVector<Entry> &entries = entries_[kind];
+	return std::lower_bound(entries.begin(), entries.end(), address, EntryOrder());
+}
+
+//------------------------------------------------------------------------------
+// Name: range
+// Desc:
+//------------------------------------------------------------------------------
+void Annotations::range(Kind kind, edb::address_t first, edb::address_t last, const_iterator *begin, const_iterator *end) const {
+
+	Q_ASSERT(begin);
+	Q_ASSERT(end);
+
+	const QVector<Entry> &entries = entries_[kind];
+	*begin = std::lower_bound(entries.begin(), entries.end(), first, EntryOrder());
+	*end   = (last > first) ? std::lower_bound(*begin, entries.end(), last, EntryOrder()) : *begin;
+}
+
+//------------------------------------------------------------------------------
+// Name: contains
+// Desc:
+//------------------------------------------------------------------------------
+bool Annotations::contains(Kind kind, edb::address_t address) const {
+	const const_iterator it = lower_bound(kind, address);
+	return it != entries_[kind].end() && it->address == address;
+}
+
+//------------------------------------------------------------------------------
+// Name: find
+// Desc: the text of the entry of <kind> at <address>, empty if there isn't one
+//------------------------------------------------------------------------------
+QString Annotations::find(Kind kind, edb::address_t address) const {
+	const const_iterator it = lower_bound(kind, address);
+	if(it != entries_[kind].end() && it->address == address) {
+		return it->text;
+	}
+
+	return QString();
+}
+
+//------------------------------------------------------------------------------
+// Name: set
+// Desc: entries are mostly added in the order they are found, so the common
+//       case is an append. Otherwise everything after it moves up by one,
+//       which is a single memmove of the tail and still cheap next to what a
+//       hash costs to look in on every line that is drawn
+//------------------------------------------------------------------------------
+void Annotations::set(Kind kind, edb::address_t address, const QString &text) {
+
+	QVector<Entry> &entries = entries_[kind];
+	QVector<Entry>::iterator it = std::lower_bound(entries.begin(), entries.end(), address, EntryOrder());
+
+	if(it != entries.end() && it->address == address) {
+		if(it->text == text) {
+			return;
+		}
+		it->text = text;
+	} else {
+		Entry entry;
+		entry.address = address;
+		entry.text    = text;
+		entries.insert(it, entry);
+	}
+
+	Q_EMIT changed(kind, address);
+}
+
+//------------------------------------------------------------------------------
+// Name: remove
+// Desc: returns true if there was something at <address> to remove
+//------------------------------------------------------------------------------
+bool Annotations::remove(Kind kind, edb::address_t address) {
+
+	QVector<Entry> &entries = entries_[kind];
+	QVector<Entry>::iterator it = std::lower_bound(entries.begin(), entries.end(), address, EntryOrder());
+
+	if(it == entries.end() || it->address != address) {
+		return false;
+	}
+
+	entries.erase(it);
+	Q_EMIT changed(kind, address);
+	return true;
+}
+
+//------------------------------------------------------------------------------
+// Name: clear
+// Desc:
+//------------------------------------------------------------------------------
+void Annotations::clear(Kind kind) {
+	if(!entries_[kind].isEmpty()) {
+		entries_[kind].clear();
+		Q_EMIT cleared(kind);
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: clear
+// Desc:
+//------------------------------------------------------------------------------
+void Annotations::clear() {
+	for(int kind = 0; kind < KIND_COUNT; ++kind) {
+		clear(static_cast<Kind>(kind));
+	}
+}
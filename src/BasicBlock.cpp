@@ -17,19 +17,36 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
 #include "BasicBlock.h"
+#include "Instruction.h"
+#include "edb.h"
+
+#include <algorithm>
+#include <cstddef>
 
 //------------------------------------------------------------------------------
 // Name: BasicBlock
 //------------------------------------------------------------------------------
-BasicBlock::BasicBlock() {
-
+BasicBlock::BasicBlock() : memory_base_(0), address_(0), byte_size_(0), instruction_count_(0), last_offset_(0), successor_count_(0) {
+	successors_[0] = 0;
+	successors_[1] = 0;
 }
 
 //------------------------------------------------------------------------------
 // Name: BasicBlock
+// Desc: <memory> is a snapshot starting at <memory_base> which holds the block,
+//       it is shared rather than copied
 //------------------------------------------------------------------------------
-BasicBlock::BasicBlock(const BasicBlock &other) : instructions_(other.instructions_) {
+BasicBlock::BasicBlock(const QVector<quint8> &memory, edb::address_t memory_base) : memory_(memory), memory_base_(memory_base), address_(0), byte_size_(0), instruction_count_(0), last_offset_(0), successor_count_(0) {
+	successors_[0] = 0;
+	successors_[1] = 0;
+}
 
+//------------------------------------------------------------------------------
+// Name: BasicBlock
+//------------------------------------------------------------------------------
+BasicBlock::BasicBlock(const BasicBlock &other) : memory_(other.memory_), memory_base_(other.memory_base_), address_(other.address_), byte_size_(other.byte_size_), instruction_count_(other.instruction_count_), last_offset_(other.last_offset_), successor_count_(other.successor_count_) {
+	successors_[0] = other.successors_[0];
+	successors_[1] = other.successors_[1];
 }
 
 //------------------------------------------------------------------------------
@@ -51,141 +68,161 @@ BasicBlock::~BasicBlock() {
 // Name: swap
 //------------------------------------------------------------------------------
 void BasicBlock::swap(BasicBlock &other) {
-	qSwap(instructions_, other.instructions_);
+	qSwap(memory_, other.memory_);
+	qSwap(memory_base_, other.memory_base_);
+	qSwap(address_, other.address_);
+	qSwap(byte_size_, other.byte_size_);
+	qSwap(instruction_count_, other.instruction_count_);
+	qSwap(last_offset_, other.last_offset_);
+	qSwap(successor_count_, other.successor_count_);
+	qSwap(successors_[0], other.successors_[0]);
+	qSwap(successors_[1], other.successors_[1]);
 }
 
 //------------------------------------------------------------------------------
-// Name: push_back
+// Name: rebase
+// Desc: moves the block along with the region [start, end) it is in, which is
+//       now loaded at <new_start>. Successors outside of the region stay put,
+//       they are wherever the other region is
 //------------------------------------------------------------------------------
-void BasicBlock::push_back(const instruction_pointer &inst) {
-	instructions_.push_back(inst);
-}
+void BasicBlock::rebase(edb::address_t start, edb::address_t end, edb::address_t new_start) {
 
-//------------------------------------------------------------------------------
-// Name: begin
-//------------------------------------------------------------------------------
-BasicBlock::const_iterator BasicBlock::begin() const {
-	return instructions_.begin();
-}
+	memory_base_ = memory_base_ - start + new_start;
+	address_     = address_ - start + new_start;
 
-//------------------------------------------------------------------------------
-// Name: end
-//------------------------------------------------------------------------------
-BasicBlock::const_iterator BasicBlock::end() const {
-	return instructions_.end();
+	for(quint32 i = 0; i < successor_count_; ++i) {
+		if(successors_[i] >= start && successors_[i] < end) {
+			successors_[i] = successors_[i] - start + new_start;
+		}
+	}
 }
 
 //------------------------------------------------------------------------------
-// Name: begin
+// Name: push_back
+// Desc: instructions are expected one after the other, only their sizes are
+//       kept
 //------------------------------------------------------------------------------
-BasicBlock::iterator BasicBlock::begin() {
-	return instructions_.begin();
-}
+void BasicBlock::push_back(const edb::Instruction &inst) {
 
-//------------------------------------------------------------------------------
-// Name: end
-//------------------------------------------------------------------------------
-BasicBlock::iterator BasicBlock::end() {
-	return instructions_.end();
-}
+	if(instruction_count_ == 0) {
+		address_ = inst.rva();
+	}
 
-//------------------------------------------------------------------------------
-// Name: rbegin
-//------------------------------------------------------------------------------
-BasicBlock::const_reverse_iterator BasicBlock::rbegin() const {
-	return const_reverse_iterator(instructions_.end());
+	Q_ASSERT(inst.rva() == address_ + byte_size_);
+
+	last_offset_ = byte_size_;
+	byte_size_ += inst.size();
+	++instruction_count_;
 }
 
 //------------------------------------------------------------------------------
-// Name: rend
+// Name: add_successor
+// Desc: a block ends in at most a two way branch
 //------------------------------------------------------------------------------
-BasicBlock::const_reverse_iterator BasicBlock::rend() const {
-	return const_reverse_iterator(instructions_.begin());
+void BasicBlock::add_successor(edb::address_t address) {
+	Q_ASSERT(successor_count_ < 2);
+	if(successor_count_ < 2) {
+		successors_[successor_count_++] = address;
+	}
 }
 
 //------------------------------------------------------------------------------
-// Name: rbegin
+// Name: decode
+// Desc:
 //------------------------------------------------------------------------------
-BasicBlock::reverse_iterator BasicBlock::rbegin() {
-	return reverse_iterator(instructions_.end());
+instruction_pointer BasicBlock::decode(edb::address_t address) const {
+
+	if(!memory_.isEmpty()) {
+		const edb::address_t offset = address - memory_base_;
+		if(offset < static_cast<edb::address_t>(memory_.size())) {
+			const quint8 *const p    = memory_.constData() + offset;
+			const quint8 *const last = memory_.constData() + memory_.size();
+			return instruction_pointer(new edb::Instruction(p, p + std::min<std::ptrdiff_t>(edb::Instruction::MAX_SIZE, last - p), address, std::nothrow));
+		}
+	} else {
+		quint8 buffer[edb::Instruction::MAX_SIZE];
+		if(const int buf_size = edb::v1::get_instruction_bytes(address, buffer)) {
+			return instruction_pointer(new edb::Instruction(buffer, buffer + buf_size, address, std::nothrow));
+		}
+	}
+
+	return instruction_pointer();
 }
 
 //------------------------------------------------------------------------------
-// Name: rend
+// Name: instructions
+// Desc: decodes the whole block
 //------------------------------------------------------------------------------
-BasicBlock::reverse_iterator BasicBlock::rend() {
-	return reverse_iterator(instructions_.begin());
+QVector<instruction_pointer> BasicBlock::instructions() const {
+
+	QVector<instruction_pointer> results;
+	results.reserve(instruction_count_);
+
+	edb::address_t address = address_;
+	for(quint32 i = 0; i < instruction_count_; ++i) {
+		const instruction_pointer inst = decode(address);
+		if(!inst || !*inst) {
+			break;
+		}
+
+		results.push_back(inst);
+		address += inst->size();
+	}
+
+	return results;
 }
 
 //------------------------------------------------------------------------------
 // Name: size
+// Desc: the number of instructions in the block
 //------------------------------------------------------------------------------
 BasicBlock::size_type BasicBlock::size() const {
-	return instructions_.size();
+	return instruction_count_;
 }
 
 //------------------------------------------------------------------------------
 // Name: empty
 //------------------------------------------------------------------------------
 bool BasicBlock::empty() const {
-	return instructions_.isEmpty();
+	return instruction_count_ == 0;
 }
 
 //------------------------------------------------------------------------------
-// Name: operator[]
+// Name: successor_count
 //------------------------------------------------------------------------------
-BasicBlock::reference BasicBlock::operator[](size_type pos) {
-	return instructions_[pos];
+BasicBlock::size_type BasicBlock::successor_count() const {
+	return successor_count_;
 }
 
 //------------------------------------------------------------------------------
-// Name: operator[]
+// Name: successor
 //------------------------------------------------------------------------------
-BasicBlock::const_reference BasicBlock::operator[](size_type pos) const {
-	return instructions_[pos];
-}
-
-//------------------------------------------------------------------------------
-// Name: front
-//------------------------------------------------------------------------------
-BasicBlock::reference BasicBlock::front() {
-	Q_ASSERT(!empty());
-	return *begin();
+edb::address_t BasicBlock::successor(size_type n) const {
+	Q_ASSERT(n < successor_count_);
+	return successors_[n];
 }
 
 //------------------------------------------------------------------------------
 // Name: front
 //------------------------------------------------------------------------------
-BasicBlock::const_reference BasicBlock::front() const {
+instruction_pointer BasicBlock::front() const {
 	Q_ASSERT(!empty());
-	return *begin();
+	return decode(address_);
 }
 
 //------------------------------------------------------------------------------
 // Name: back
 //------------------------------------------------------------------------------
-BasicBlock::reference BasicBlock::back() {
+instruction_pointer BasicBlock::back() const {
 	Q_ASSERT(!empty());
-	return *rbegin();
-}
-
-//------------------------------------------------------------------------------
-// Name: back
-//------------------------------------------------------------------------------
-BasicBlock::const_reference BasicBlock::back() const {
-	Q_ASSERT(!empty());
-	return *rbegin();
+	return decode(last_instruction());
 }
 
 //------------------------------------------------------------------------------
 // Name: byte_size
 //------------------------------------------------------------------------------
 BasicBlock::size_type BasicBlock::byte_size() const {
-	size_type n = 0;
-	Q_FOREACH(const instruction_pointer &inst, instructions_) {
-		n += inst->size();
-	}
-	return n;
+	return byte_size_;
 }
 
 //------------------------------------------------------------------------------
@@ -193,7 +230,7 @@ BasicBlock::size_type BasicBlock::byte_size() const {
 //------------------------------------------------------------------------------
 edb::address_t BasicBlock::first_address() const {
 	Q_ASSERT(!empty());
-	return front()->rva();
+	return address_;
 }
 
 //------------------------------------------------------------------------------
@@ -201,5 +238,14 @@ edb::address_t BasicBlock::first_address() const {
 //------------------------------------------------------------------------------
 edb::address_t BasicBlock::last_address() const {
 	Q_ASSERT(!empty());
-	return back()->rva() + back()->size();
+	return address_ + byte_size_;
+}
+
+//------------------------------------------------------------------------------
+// Name: last_instruction
+// Desc: the address of the block's final instruction
+//------------------------------------------------------------------------------
+edb::address_t BasicBlock::last_instruction() const {
+	Q_ASSERT(!empty());
+	return address_ + last_offset_;
 }
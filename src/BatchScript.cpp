@@ -0,0 +1,656 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "BatchScript.h"
+#include "ByteSearcher.h"
+#include "Configuration.h"
+#include "Expression.h"
+#include "IAnalyzer.h"
+#include "IBreakpoint.h"
+#include "IDebugger.h"
+#include "IProcess.h"
+#include "ISymbolManager.h"
+#include "MemoryRegions.h"
+#include "Module.h"
+#include "RegionScanner.h"
+#include "State.h"
+#include "edb.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJSEngine>
+#include <QJSValue>
+
+#include <cstdlib>
+#include <iostream>
+
+namespace {
+
+// how long each wait on the core is, the number doesn't matter much as
+// nothing else is going on
+const int WaitInterval = 100;
+
+// the addresses a pattern is found at
+class PatternSearch : public RegionScanner::Task {
+public:
+	explicit PatternSearch(const ByteSearcher &searcher) : searcher_(searcher) {
+	}
+
+public:
+	virtual std::size_t lookahead() const {
+		return searcher_.size() - 1;
+	}
+
+	virtual Result *scan(const RegionScanner::Chunk &chunk) const {
+
+		List<edb::address_t> *const result = new List<edb::address_t>;
+
+		const quint8 *const first = chunk.data.constData();
+		const quint8 *const last  = first + qMin<std::size_t>(chunk.data.size(), chunk.size + searcher_.size() - 1);
+
+		const quint8 *p = first;
+		while((p = searcher_.find(p, last, chunk.address + (p - first))) != last) {
+			result->items.push_back(chunk.address + (p - first));
+			++p;
+		}
+
+		return result;
+	}
+
+	virtual void merge(Result *result) {
+		Q_FOREACH(edb::address_t address, static_cast<List<edb::address_t> *>(result)->items) {
+			matches.push_back(static_cast<double>(address));
+		}
+	}
+
+public:
+	QVariantList matches;
+
+private:
+	const ByteSearcher &searcher_;
+};
+
+//------------------------------------------------------------------------------
+// Name: evaluate_expression
+// Desc: like edb::v1::eval_expression, but says what was wrong rather than
+//       showing it
+//------------------------------------------------------------------------------
+bool evaluate_expression(const QString &expression, edb::address_t *value, QString *error) {
+
+	Expression<edb::address_t> expr(expression, edb::v1::get_variable, edb::v1::get_value);
+	ExpressionError err;
+
+	bool ok;
+	*value = expr.evaluate_expression(&ok, &err);
+	if(!ok) {
+		*error = QString::fromLatin1(err.what());
+	}
+
+	return ok;
+}
+
+//------------------------------------------------------------------------------
+// Name: wait_event
+// Desc:
+//------------------------------------------------------------------------------
+IDebugEvent::const_pointer wait_event() {
+	Q_FOREVER {
+		if(IDebugEvent::const_pointer event = edb::v1::debugger_core->wait_debug_event(WaitInterval)) {
+			return event;
+		}
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: not_running
+// Desc:
+//------------------------------------------------------------------------------
+QVariantMap not_running() {
+	QVariantMap result;
+	result["reason"] = "detached";
+	return result;
+}
+
+}
+
+//------------------------------------------------------------------------------
+// Name: BatchScript
+// Desc: <arguments> are what follows the script on the command line
+//------------------------------------------------------------------------------
+BatchScript::BatchScript(const QStringList &arguments, QObject *parent) : QObject(parent), arguments_(arguments), launched_(false), signalled_(false) {
+}
+
+//------------------------------------------------------------------------------
+// Name: ~BatchScript
+// Desc:
+//------------------------------------------------------------------------------
+BatchScript::~BatchScript() {
+	finish();
+}
+
+//------------------------------------------------------------------------------
+// Name: run
+// Desc: runs the script in <filename>, returning what edb should exit with
+//------------------------------------------------------------------------------
+int BatchScript::run(const QString &filename) {
+
+	QFile file(filename);
+	if(!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+		std::cerr << "Unable to open the script " << qPrintable(filename) << std::endl;
+		return -1;
+	}
+
+	QJSEngine engine;
+	engine.globalObject().setProperty("edb", engine.newQObject(this));
+
+	const QJSValue result = engine.evaluate(QString::fromUtf8(file.readAll()), filename);
+	finish();
+
+	if(result.isError()) {
+		std::cerr << qPrintable(filename) << ":" << result.property("lineNumber").toInt() << ": " << qPrintable(result.toString()) << std::endl;
+		return 1;
+	}
+
+	return 0;
+}
+
+//------------------------------------------------------------------------------
+// Name: finish
+// Desc: a process we started doesn't outlive the script, one we attached to
+//       is let go
+//------------------------------------------------------------------------------
+void BatchScript::finish() {
+	if(edb::v1::debugger_core && edb::v1::debugger_core->process()) {
+		if(launched_) {
+			edb::v1::debugger_core->kill();
+		} else {
+			edb::v1::debugger_core->detach();
+		}
+	}
+
+	launched_ = false;
+}
+
+//------------------------------------------------------------------------------
+// Name: arguments
+// Desc:
+//------------------------------------------------------------------------------
+QStringList BatchScript::arguments() const {
+	return arguments_;
+}
+
+//------------------------------------------------------------------------------
+// Name: print
+// Desc:
+//------------------------------------------------------------------------------
+void BatchScript::print(const QString &text) {
+	std::cout << qPrintable(text) << std::endl;
+}
+
+//------------------------------------------------------------------------------
+// Name: exit
+// Desc: ends the script, and edb, right away
+//------------------------------------------------------------------------------
+void BatchScript::exit(int code) {
+	finish();
+	std::exit(code);
+}
+
+//------------------------------------------------------------------------------
+// Name: open
+// Desc: starts <program> stopped at its first instruction
+//------------------------------------------------------------------------------
+bool BatchScript::open(const QString &program, const QStringList &args) {
+
+	finish();
+
+	QList<QByteArray> program_args;
+	Q_FOREACH(const QString &arg, args) {
+		program_args.push_back(arg.toLocal8Bit());
+	}
+
+	if(!QFile(program).exists() || !edb::v1::debugger_core->open(program, QDir::currentPath(), program_args)) {
+		std::cerr << "Failed to open and attach to " << qPrintable(program) << std::endl;
+		return false;
+	}
+
+	launched_  = true;
+	signalled_ = false;
+	symbols_loaded_.clear();
+	load_symbols();
+	return true;
+}
+
+//------------------------------------------------------------------------------
+// Name: attach
+// Desc:
+//------------------------------------------------------------------------------
+bool BatchScript::attach(int pid) {
+
+	finish();
+
+	if(!edb::v1::debugger_core->attach(pid)) {
+		std::cerr << "Failed to attach to " << pid << std::endl;
+		return false;
+	}
+
+	signalled_ = false;
+	symbols_loaded_.clear();
+	load_symbols();
+	return true;
+}
+
+//------------------------------------------------------------------------------
+// Name: detach
+// Desc:
+//------------------------------------------------------------------------------
+void BatchScript::detach() {
+	if(edb::v1::debugger_core->process()) {
+		edb::v1::debugger_core->detach();
+	}
+
+	launched_ = false;
+}
+
+//------------------------------------------------------------------------------
+// Name: kill
+// Desc:
+//------------------------------------------------------------------------------
+void BatchScript::kill() {
+	if(edb::v1::debugger_core->process()) {
+		edb::v1::debugger_core->kill();
+	}
+
+	launched_ = false;
+}
+
+//------------------------------------------------------------------------------
+// Name: load_symbols
+// Desc: loads the symbols of every module which has been loaded since the
+//       last call, returns how many there were. A just started process only
+//       has the program itself, the libraries come once the linker has run
+//------------------------------------------------------------------------------
+int BatchScript::load_symbols() {
+
+	if(!edb::v1::debugger_core->process()) {
+		return 0;
+	}
+
+	int count = 0;
+	Q_FOREACH(const Module &module, edb::v1::debugger_core->loaded_modules()) {
+		if(QFileInfo(module.name).isAbsolute() && !symbols_loaded_.contains(module.name)) {
+			edb::v1::symbol_manager().load_symbol_file(module.name, module.base_address);
+			symbols_loaded_.insert(module.name);
+			++count;
+		}
+	}
+
+	return count;
+}
+
+//------------------------------------------------------------------------------
+// Name: to_address
+// Desc: numbers are taken as they are, strings are evaluated
+//------------------------------------------------------------------------------
+bool BatchScript::to_address(const QVariant &value, edb::address_t *address) {
+
+	if(value.type() == QVariant::String) {
+		QString error;
+		if(!evaluate_expression(value.toString(), address, &error)) {
+			std::cerr << qPrintable(value.toString()) << ": " << qPrintable(error) << std::endl;
+			return false;
+		}
+		return true;
+	}
+
+	bool ok;
+	*address = static_cast<edb::address_t>(value.toULongLong(&ok));
+	if(!ok) {
+		std::cerr << qPrintable(value.toString()) << " is not an address" << std::endl;
+	}
+
+	return ok;
+}
+
+//------------------------------------------------------------------------------
+// Name: breakpoint
+// Desc: if <condition> is given the process only stops when it is true
+//------------------------------------------------------------------------------
+bool BatchScript::breakpoint(const QVariant &address, const QString &condition) {
+
+	edb::address_t value;
+	if(!edb::v1::debugger_core->process() || !to_address(address, &value)) {
+		return false;
+	}
+
+	if(IBreakpoint::pointer bp = edb::v1::debugger_core->add_breakpoint(value)) {
+		bp->condition = condition;
+		return true;
+	}
+
+	return false;
+}
+
+//------------------------------------------------------------------------------
+// Name: remove_breakpoint
+// Desc:
+//------------------------------------------------------------------------------
+void BatchScript::remove_breakpoint(const QVariant &address) {
+
+	edb::address_t value;
+	if(edb::v1::debugger_core->process() && to_address(address, &value)) {
+		edb::v1::debugger_core->remove_breakpoint(value);
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: resume
+// Desc: runs until something stops the process. <pass_signal> hands the
+//       signal it last stopped for over to it
+//------------------------------------------------------------------------------
+QVariantMap BatchScript::resume(bool pass_signal) {
+	return run_until_stop(false, pass_signal);
+}
+
+//------------------------------------------------------------------------------
+// Name: step
+// Desc:
+//------------------------------------------------------------------------------
+QVariantMap BatchScript::step(bool pass_signal) {
+	return run_until_stop(true, pass_signal);
+}
+
+//------------------------------------------------------------------------------
+// Name: run_until_stop
+// Desc: the same as the debugger does, a breakpoint which we are on is stepped
+//       over with it disabled before carrying on
+//------------------------------------------------------------------------------
+QVariantMap BatchScript::run_until_stop(bool stepping, bool pass_signal) {
+
+	if(!edb::v1::debugger_core->process()) {
+		return not_running();
+	}
+
+	edb::EVENT_STATUS status = (pass_signal && signalled_) ? edb::DEBUG_EXCEPTION_NOT_HANDLED : edb::DEBUG_CONTINUE;
+
+	Q_FOREVER {
+		IDebugEvent::const_pointer event;
+
+		State state;
+		edb::v1::debugger_core->get_state(&state);
+
+		IBreakpoint::pointer bp = edb::v1::debugger_core->find_breakpoint(state.instruction_pointer());
+		if(bp && bp->enabled()) {
+			bp->disable();
+			edb::v1::debugger_core->step(status);
+			event = wait_event();
+			bp->enable();
+
+			status = edb::DEBUG_CONTINUE;
+
+			// stepped past it, unless something else came up on the way
+			if(!stepping && event->stopped() && event->is_trap()) {
+				event.clear();
+			}
+		}
+
+		if(!event) {
+			if(stepping) {
+				edb::v1::debugger_core->step(status);
+			} else {
+				edb::v1::debugger_core->resume(status);
+			}
+			event = wait_event();
+		}
+
+		QVariantMap result;
+		if(stopped_for(event, stepping, &result, &status)) {
+			return result;
+		}
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: stopped_for
+// Desc: true if <event> is one the script is told about, in <result>. If not
+//       the process is resumed with <status>
+//------------------------------------------------------------------------------
+bool BatchScript::stopped_for(const IDebugEvent::const_pointer &event, bool stepping, QVariantMap *result, edb::EVENT_STATUS *status) {
+
+	signalled_ = false;
+	*status    = edb::DEBUG_CONTINUE;
+
+	if(event->exited() || event->terminated()) {
+		(*result)["reason"] = event->exited() ? "exited" : "terminated";
+		(*result)["code"]   = event->code();
+		edb::v1::debugger_core->detach();
+		launched_ = false;
+		return true;
+	}
+
+	State state;
+	edb::v1::debugger_core->get_state(&state);
+
+	(*result)["thread"]  = static_cast<double>(event->thread());
+	(*result)["address"] = static_cast<double>(state.instruction_pointer());
+
+	if(event->is_trap()) {
+
+		// one of our int3s, the same as Debugger::handle_trap
+		const edb::address_t previous_ip = state.instruction_pointer() - 1;
+		IBreakpoint::pointer bp = edb::v1::debugger_core->find_breakpoint(previous_ip);
+		if(bp && bp->enabled()) {
+			bp->hit();
+			state.set_instruction_pointer(previous_ip);
+			edb::v1::debugger_core->set_state(state);
+
+			if(!bp->condition.isEmpty()) {
+				bool condition;
+				ExpressionError err;
+				if(!edb::v1::breakpoint_condition_true(bp, state, &condition, &err)) {
+					edb::address_t value;
+					QString error;
+					if(evaluate_expression(bp->condition, &value, &error)) {
+						condition = value != 0;
+					} else {
+						std::cerr << qPrintable(bp->condition) << ": " << qPrintable(error) << std::endl;
+						condition = true;
+					}
+				}
+
+				if(!condition) {
+					return false;
+				}
+			}
+
+			if(bp->one_time()) {
+				edb::v1::debugger_core->remove_breakpoint(bp->address());
+			}
+
+			(*result)["reason"]  = "breakpoint";
+			(*result)["address"] = static_cast<double>(previous_ip);
+			return true;
+		}
+
+		(*result)["reason"] = stepping ? "step" : "trap";
+		return true;
+	}
+
+	if(event->is_stop()) {
+		(*result)["reason"] = "paused";
+		return true;
+	}
+
+	// signals the user asked to be passed to the program are, without stopping
+	switch(edb::v1::config().signal_policies.value(event->code(), Configuration::SignalStop)) {
+	case Configuration::SignalPass:
+	case Configuration::SignalLog:
+		*status = edb::DEBUG_EXCEPTION_NOT_HANDLED;
+		return false;
+	default:
+		signalled_ = true;
+		(*result)["reason"] = "signal";
+		(*result)["code"]   = event->code();
+		return true;
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: evaluate
+// Desc: undefined if <expression> couldn't be evaluated
+//------------------------------------------------------------------------------
+QVariant BatchScript::evaluate(const QString &expression) {
+
+	edb::address_t value;
+	QString error;
+	if(!evaluate_expression(expression, &value, &error)) {
+		std::cerr << qPrintable(expression) << ": " << qPrintable(error) << std::endl;
+		return QVariant();
+	}
+
+	return static_cast<double>(value);
+}
+
+//------------------------------------------------------------------------------
+// Name: get_register
+// Desc: of the active thread, undefined if there is no such register
+//------------------------------------------------------------------------------
+QVariant BatchScript::get_register(const QString &name) {
+
+	if(!edb::v1::debugger_core->process()) {
+		return QVariant();
+	}
+
+	State state;
+	edb::v1::debugger_core->get_state(&state);
+
+	if(const Register reg = state.value(name)) {
+		return static_cast<double>(reg.value<edb::reg_t>());
+	}
+
+	return QVariant();
+}
+
+//------------------------------------------------------------------------------
+// Name: set_register
+// Desc: of the active thread
+//------------------------------------------------------------------------------
+bool BatchScript::set_register(const QString &name, const QVariant &value) {
+
+	edb::address_t address;
+	if(!edb::v1::debugger_core->process() || !to_address(value, &address)) {
+		return false;
+	}
+
+	State state;
+	edb::v1::debugger_core->get_state(&state);
+	if(!state.value(name)) {
+		return false;
+	}
+
+	state.set_register(name, address);
+	edb::v1::debugger_core->set_state(state);
+	return true;
+}
+
+//------------------------------------------------------------------------------
+// Name: read_memory
+// Desc: <size> bytes as hex, empty if they couldn't all be read
+//------------------------------------------------------------------------------
+QString BatchScript::read_memory(const QVariant &address, int size) {
+
+	edb::address_t value;
+	if(size <= 0 || !edb::v1::debugger_core->process() || !to_address(address, &value)) {
+		return QString();
+	}
+
+	QByteArray bytes(size, 0);
+	if(!edb::v1::debugger_core->process()->read_bytes(value, bytes.data(), bytes.size())) {
+		return QString();
+	}
+
+	return QString::fromLatin1(bytes.toHex());
+}
+
+//------------------------------------------------------------------------------
+// Name: write_memory
+// Desc: <hex> may have spaces between the bytes
+//------------------------------------------------------------------------------
+bool BatchScript::write_memory(const QVariant &address, const QString &hex) {
+
+	edb::address_t value;
+	if(!edb::v1::debugger_core->process() || !to_address(address, &value)) {
+		return false;
+	}
+
+	const QByteArray bytes = QByteArray::fromHex(hex.toLatin1());
+	return !bytes.isEmpty() && edb::v1::debugger_core->process()->write_bytes(value, bytes.constData(), bytes.size());
+}
+
+//------------------------------------------------------------------------------
+// Name: analyze
+// Desc: analyzes the region containing <address>, returning how many
+//       functions were found in it or -1 if there is no analyzer
+//------------------------------------------------------------------------------
+int BatchScript::analyze(const QVariant &address) {
+
+	IAnalyzer *const analyzer = edb::v1::analyzer();
+
+	edb::address_t value;
+	if(!analyzer || !edb::v1::debugger_core->process() || !to_address(address, &value)) {
+		return -1;
+	}
+
+	edb::v1::memory_regions().sync();
+	const IRegion::pointer region = edb::v1::memory_regions().find_region(value);
+	if(!region) {
+		return -1;
+	}
+
+	analyzer->analyze(region);
+	return analyzer->functions(region).size();
+}
+
+//------------------------------------------------------------------------------
+// Name: search
+// Desc: every readable address which <pattern> is found at, it is written
+//       the way the binary search takes it, "48 8b ?? ?? e8"
+//------------------------------------------------------------------------------
+QVariantList BatchScript::search(const QString &pattern) {
+
+	QByteArray bytes;
+	QByteArray mask;
+	if(!edb::v1::debugger_core->process() || !ByteSearcher::parse(pattern, &bytes, &mask) || bytes.isEmpty()) {
+		return QVariantList();
+	}
+
+	edb::v1::memory_regions().sync();
+
+	QList<IRegion::pointer> regions;
+	Q_FOREACH(const IRegion::pointer &region, edb::v1::memory_regions().regions()) {
+		if(region->readable()) {
+			regions.push_back(region);
+		}
+	}
+
+	const ByteSearcher searcher(bytes, mask);
+	PatternSearch task(searcher);
+	RegionScanner().run(regions, &task);
+	return task.matches;
+}
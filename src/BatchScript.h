@@ -0,0 +1,97 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef BATCHSCRIPT_20261014_H_
+#define BATCHSCRIPT_20261014_H_
+
+#include "IDebugEvent.h"
+#include "Types.h"
+
+#include <QObject>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+#include <QVariant>
+#include <QVariantList>
+#include <QVariantMap>
+
+// runs a script against the debugger core with no UI at all, for "edb --batch
+// script.js". The script sees this object as "edb", and everything it does
+// goes straight to the core, waiting on it rather than on an event loop.
+// Addresses may be given as numbers, or as strings which are evaluated the
+// same way as expressions typed into edb. Each function which resumes the
+// process returns once it stops again, with what stopped it:
+//
+//     { reason: "breakpoint", address: 4198400, thread: 1234 }
+//
+// reason is one of "breakpoint", "step", "trap", "paused", "signal" (with
+// code, the signal number), "exited" or "terminated" (with code), or
+// "detached" if there was no process to resume
+class BatchScript : public QObject {
+	Q_OBJECT
+
+public:
+	explicit BatchScript(const QStringList &arguments, QObject *parent = 0);
+	virtual ~BatchScript();
+
+public:
+	int run(const QString &filename);
+
+public:
+	Q_INVOKABLE QStringList arguments() const;
+	Q_INVOKABLE void print(const QString &text);
+	Q_INVOKABLE void exit(int code);
+
+public:
+	Q_INVOKABLE bool open(const QString &program, const QStringList &args = QStringList());
+	Q_INVOKABLE bool attach(int pid);
+	Q_INVOKABLE void detach();
+	Q_INVOKABLE void kill();
+	Q_INVOKABLE int load_symbols();
+
+public:
+	Q_INVOKABLE bool breakpoint(const QVariant &address, const QString &condition = QString());
+	Q_INVOKABLE void remove_breakpoint(const QVariant &address);
+	Q_INVOKABLE QVariantMap resume(bool pass_signal = false);
+	Q_INVOKABLE QVariantMap step(bool pass_signal = false);
+
+public:
+	Q_INVOKABLE QVariant evaluate(const QString &expression);
+	Q_INVOKABLE QVariant get_register(const QString &name);
+	Q_INVOKABLE bool set_register(const QString &name, const QVariant &value);
+	Q_INVOKABLE QString read_memory(const QVariant &address, int size);
+	Q_INVOKABLE bool write_memory(const QVariant &address, const QString &hex);
+
+public:
+	Q_INVOKABLE int analyze(const QVariant &address);
+	Q_INVOKABLE QVariantList search(const QString &pattern);
+
+private:
+	bool to_address(const QVariant &value, edb::address_t *address);
+	bool stopped_for(const IDebugEvent::const_pointer &event, bool stepping, QVariantMap *result, edb::EVENT_STATUS *status);
+	QVariantMap run_until_stop(bool stepping, bool pass_signal);
+	void finish();
+
+private:
+	QStringList   arguments_;
+	QSet<QString> symbols_loaded_;
+	bool          launched_;   // we started the process, so it is killed at the end
+	bool          signalled_;  // the last stop was for a signal, which may be passed on
+};
+
+#endif
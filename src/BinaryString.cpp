@@ -17,6 +17,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
 #include "BinaryString.h"
+#include "ByteSearcher.h"
 #include "HexStringValidator.h"
 #include <QStringList>
 
@@ -36,9 +37,17 @@ void BinaryString::setMaxLength(int n) {
 // Name: BinaryString
 // Desc: constructor
 //------------------------------------------------------------------------------
-BinaryString::BinaryString(QWidget *parent) : QWidget(parent), ui(new Ui::BinaryStringWidget) {
+BinaryString::BinaryString(QWidget *parent) : QWidget(parent), ui(new Ui::BinaryStringWidget), hex_validator_(new HexStringValidator(this)) {
 	ui->setupUi(this);
-	ui->txtHex->setValidator(new HexStringValidator(this));
+	ui->txtHex->setValidator(hex_validator_);
+}
+
+//------------------------------------------------------------------------------
+// Name: setAllowWildcards
+// Desc: lets the hex field have '?' for digits which can be anything, see mask
+//------------------------------------------------------------------------------
+void BinaryString::setAllowWildcards(bool allow) {
+	hex_validator_->setAllowWildcards(allow);
 }
 
 //------------------------------------------------------------------------------
@@ -151,12 +160,20 @@ void BinaryString::on_txtHex_textEdited(const QString &text) {
 QByteArray BinaryString::value() const {
 
 	QByteArray ret;
-	const QStringList list1 = ui->txtHex->text().split(" ", QString::SkipEmptyParts);
+	QByteArray mask;
+	ByteSearcher::parse(ui->txtHex->text(), &ret, &mask);
+	return ret;
+}
 
-	Q_FOREACH(const QString &i, list1) {
-		ret += static_cast<quint8>(i.toUInt(0, 16));
-	}
+//------------------------------------------------------------------------------
+// Name: mask
+// Desc: which bits of value() were given, wildcard digits are 0 in both
+//------------------------------------------------------------------------------
+QByteArray BinaryString::mask() const {
 
+	QByteArray value;
+	QByteArray ret;
+	ByteSearcher::parse(ui->txtHex->text(), &value, &ret);
 	return ret;
 }
 
@@ -0,0 +1,305 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "ByteSearcher.h"
+#include <QStringList>
+#include <cstring>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+// patterns at least this long are searched for with Boyer-Moore-Horspool, by
+// then its skips beat testing every position however quickly that is done
+const int horspool_threshold = 16;
+
+//------------------------------------------------------------------------------
+// Name: parse_nibble
+// Desc: a hex digit, or a '?' which matches anything
+//------------------------------------------------------------------------------
+bool parse_nibble(QChar ch, quint8 *value, quint8 *mask) {
+
+	const int c = ch.toLatin1();
+	if(c >= '0' && c <= '9') {
+		*value = c - '0';
+	} else if(c >= 'a' && c <= 'f') {
+		*value = c - 'a' + 10;
+	} else if(c >= 'A' && c <= 'F') {
+		*value = c - 'A' + 10;
+	} else if(c == '?') {
+		*value = 0;
+		*mask  = 0;
+		return true;
+	} else {
+		return false;
+	}
+
+	*mask = 0x0f;
+	return true;
+}
+
+}
+
+//------------------------------------------------------------------------------
+// Name: ByteSearcher
+// Desc: an <alignment> of 0 or 1 means any address will do
+//------------------------------------------------------------------------------
+ByteSearcher::ByteSearcher(const QByteArray &pattern, edb::address_t alignment) : pattern_(pattern), alignment_(alignment ? alignment : 1) {
+	init();
+}
+
+//------------------------------------------------------------------------------
+// Name: ByteSearcher
+// Desc: <mask> is the same size as <pattern>, bits which are clear in it match
+//       anything
+//------------------------------------------------------------------------------
+ByteSearcher::ByteSearcher(const QByteArray &pattern, const QByteArray &mask, edb::address_t alignment) : pattern_(pattern), mask_(mask), alignment_(alignment ? alignment : 1) {
+
+	Q_ASSERT(mask_.isEmpty() || mask_.size() == pattern_.size());
+
+	// keep the pattern's clear bits clear so that matching is a plain compare,
+	// and don't bother with a mask which doesn't hide anything
+	bool masked = false;
+	for(int i = 0; i < mask_.size(); ++i) {
+		pattern_[i] = pattern_[i] & mask_[i];
+		if(static_cast<quint8>(mask_[i]) != 0xff) {
+			masked = true;
+		}
+	}
+
+	if(!masked) {
+		mask_.clear();
+	}
+
+	init();
+}
+
+//------------------------------------------------------------------------------
+// Name: init
+// Desc: picks the bytes to filter positions with, the first and last bytes
+//       with any bits to match. Horspool needs every bit to match
+//------------------------------------------------------------------------------
+void ByteSearcher::init() {
+
+	const int n = pattern_.size();
+
+	head_ = -1;
+	tail_ = -1;
+	for(int i = 0; i < n; ++i) {
+		if(mask_.isEmpty() || mask_[i] != 0) {
+			if(head_ == -1) {
+				head_ = i;
+			}
+			tail_ = i;
+		}
+	}
+
+	if(n >= horspool_threshold && mask_.isEmpty() && alignment_ == 1) {
+		const quint8 *const p = reinterpret_cast<const quint8 *>(pattern_.constData());
+		shift_.fill(n, 256);
+		for(int i = 0; i < n - 1; ++i) {
+			shift_[p[i]] = n - 1 - i;
+		}
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: parse
+// Desc: reads a pattern such as "48 8b ?? ?? e8", the bytes are pairs of hex
+//       digits and either digit may be a '?'. Returns false if <text> isn't
+//       such a pattern
+//------------------------------------------------------------------------------
+bool ByteSearcher::parse(const QString &text, QByteArray *pattern, QByteArray *mask) {
+
+	Q_ASSERT(pattern);
+	Q_ASSERT(mask);
+
+	pattern->clear();
+	mask->clear();
+
+	const QStringList bytes = text.split(" ", QString::SkipEmptyParts);
+	Q_FOREACH(const QString &byte, bytes) {
+
+		if(byte.size() > 2) {
+			return false;
+		}
+
+		// a lone digit is the low nibble, as toUInt would read it
+		quint8 hi_value = 0;
+		quint8 hi_mask  = 0x0f;
+		quint8 lo_value;
+		quint8 lo_mask;
+
+		if(byte.size() == 2 && !parse_nibble(byte[0], &hi_value, &hi_mask)) {
+			return false;
+		}
+
+		if(!parse_nibble(byte[byte.size() - 1], &lo_value, &lo_mask)) {
+			return false;
+		}
+
+		*pattern += static_cast<char>((hi_value << 4) | lo_value);
+		*mask    += static_cast<char>((hi_mask << 4) | lo_mask);
+	}
+
+	return true;
+}
+
+//------------------------------------------------------------------------------
+// Name: matches
+// Desc: does the pattern match at <p>
+//------------------------------------------------------------------------------
+bool ByteSearcher::matches(const quint8 *p) const {
+
+	if(mask_.isEmpty()) {
+		return std::memcmp(p, pattern_.constData(), pattern_.size()) == 0;
+	}
+
+	const quint8 *const value = reinterpret_cast<const quint8 *>(pattern_.constData());
+	const quint8 *const mask  = reinterpret_cast<const quint8 *>(mask_.constData());
+	for(int i = 0; i < pattern_.size(); ++i) {
+		if((p[i] & mask[i]) != value[i]) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+//------------------------------------------------------------------------------
+// Name: find
+// Desc: returns the first match which lies entirely inside of [first, last) or
+//       <last> if there isn't one, <address> is the address of <first>
+//------------------------------------------------------------------------------
+const quint8 *ByteSearcher::find(const quint8 *first, const quint8 *last, edb::address_t address) const {
+
+	const std::size_t n = pattern_.size();
+	if(n == 0 || first >= last || static_cast<std::size_t>(last - first) < n) {
+		return last;
+	}
+
+	if(alignment_ != 1 || head_ == -1) {
+		return find_aligned(first, last, address);
+	} else if(!shift_.isEmpty()) {
+		return find_horspool(first, last);
+	} else {
+		return find_short(first, last);
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: find_aligned
+// Desc: only tries the positions whose address is a multiple of the alignment
+//------------------------------------------------------------------------------
+const quint8 *ByteSearcher::find_aligned(const quint8 *first, const quint8 *last, edb::address_t address) const {
+
+	const std::size_t n               = pattern_.size();
+	const edb::address_t misalignment = address % alignment_;
+
+	std::size_t i           = misalignment ? alignment_ - misalignment : 0;
+	const std::size_t limit = (last - first) - n;
+
+	for(; i <= limit; i += alignment_) {
+		if(matches(first + i)) {
+			return first + i;
+		}
+	}
+
+	return last;
+}
+
+//------------------------------------------------------------------------------
+// Name: find_horspool
+// Desc:
+//------------------------------------------------------------------------------
+const quint8 *ByteSearcher::find_horspool(const quint8 *first, const quint8 *last) const {
+
+	const quint8 *const p   = reinterpret_cast<const quint8 *>(pattern_.constData());
+	const std::size_t n     = pattern_.size();
+	const quint8 tail       = p[n - 1];
+	const std::size_t limit = (last - first) - n;
+
+	std::size_t i = 0;
+	while(i <= limit) {
+		const quint8 c = first[i + n - 1];
+		if(c == tail && std::memcmp(first + i, p, n - 1) == 0) {
+			return first + i;
+		}
+		i += shift_[c];
+	}
+
+	return last;
+}
+
+//------------------------------------------------------------------------------
+// Name: find_short
+// Desc: positions are only compared in full when both the head and tail
+//       bytes match, with SSE2 that test is done for 16 positions at once
+//------------------------------------------------------------------------------
+const quint8 *ByteSearcher::find_short(const quint8 *first, const quint8 *last) const {
+
+	const quint8 *const p   = reinterpret_cast<const quint8 *>(pattern_.constData());
+	const std::size_t limit = (last - first) - pattern_.size();
+	const quint8 head_mask  = mask_.isEmpty() ? 0xff : mask_[head_];
+	const quint8 tail_mask  = mask_.isEmpty() ? 0xff : mask_[tail_];
+
+	std::size_t i = 0;
+
+#ifdef __SSE2__
+	const __m128i head       = _mm_set1_epi8(static_cast<char>(p[head_]));
+	const __m128i tail       = _mm_set1_epi8(static_cast<char>(p[tail_]));
+	const __m128i head_bits  = _mm_set1_epi8(static_cast<char>(head_mask));
+	const __m128i tail_bits  = _mm_set1_epi8(static_cast<char>(tail_mask));
+
+	// the last block's tail bytes must still be inside of the buffer
+	for(; i + 16 <= limit + 1; i += 16) {
+		const __m128i a = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(first + i + head_)), head_bits);
+		const __m128i b = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(first + i + tail_)), tail_bits);
+
+		unsigned int mask = _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(a, head), _mm_cmpeq_epi8(b, tail)));
+		while(mask) {
+			const unsigned int bit = __builtin_ctz(mask);
+			if(matches(first + i + bit)) {
+				return first + i + bit;
+			}
+			mask &= mask - 1;
+		}
+	}
+#endif
+
+	for(; i <= limit; ++i) {
+
+		// when the head byte has to match exactly, memchr can do the looking
+		if(head_mask == 0xff) {
+			const quint8 *const q = static_cast<const quint8 *>(std::memchr(first + i + head_, p[head_], limit - i + 1));
+			if(!q) {
+				break;
+			}
+			i = q - first - head_;
+		} else if((first[i + head_] & head_mask) != p[head_]) {
+			continue;
+		}
+
+		if((first[i + tail_] & tail_mask) == p[tail_] && matches(first + i)) {
+			return first + i;
+		}
+	}
+
+	return last;
+}
@@ -18,27 +18,195 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "CallStack.h"
 #include "edb.h"
+#include "IAnalyzer.h"
 #include "IDebugger.h"
 #include "IState.h"
+#include "InstructionCache.h"
 #include "State.h"
 #include "MemoryRegions.h"
 #include "Expression.h"
+#include "Unwinder.h"
+
+#include <QHash>
+#include <QVector>
 
 //TODO: This may be specific to x86... Maybe abstract this in the future.
 CallStack::CallStack()
 {
-	get_call_stack();
+	get_call_stack(edb::v1::debugger_core->active_thread());
+}
+
+CallStack::CallStack(edb::tid_t tid)
+{
+	get_call_stack(tid);
 }
 
 CallStack::~CallStack() {
 
 }
 
+namespace {
+
+// more than this and the stack is either corrupt or runaway recursion
+const int max_frames = 4096;
+
+// the last call stack worked out for each thread. They stay good until the
+// process's memory may have changed or the registers a stack was worked out
+// from have
+struct CachedStack {
+	edb::address_t                ip;
+	edb::address_t                sp;
+	edb::address_t                fp;
+	QList<CallStack::stack_frame> frames;
+};
+
+quint64                        cached_generation = 0;
+QHash<edb::tid_t, CachedStack> cached_stacks;
+
+//------------------------------------------------------------------------------
+// Name: frame_pointer_step
+// Desc: for code without unwind info, follows the saved frame pointer as long
+//       as it stays on the stack
+//------------------------------------------------------------------------------
+bool frame_pointer_step(IProcess *process, const IRegion::pointer &stack, Unwinder::Registers *registers) {
+
+	const edb::address_t fp = registers->value[Unwinder::REGISTER_FP];
+	if(!registers->valid[Unwinder::REGISTER_FP] || fp % sizeof(edb::address_t) != 0 || !stack->contains(fp) || !stack->contains(fp + 2 * sizeof(edb::address_t) - 1)) {
+		return false;
+	}
+
+	edb::address_t frame[2];
+	if(!process->read_bytes(fp, frame, sizeof(frame))) {
+		return false;
+	}
+
+	registers->value[Unwinder::REGISTER_FP] = frame[0];
+	registers->value[Unwinder::REGISTER_IP] = frame[1];
+	registers->value[Unwinder::REGISTER_SP] = fp + sizeof(frame);
+	registers->valid[Unwinder::REGISTER_IP] = true;
+	registers->valid[Unwinder::REGISTER_SP] = true;
+	return true;
+}
+
+}
+
 //------------------------------------------------------------------------------
 // Name: get_call_stack
-// Desc: Gets the state of the call stack at the time the object is created.
+// Desc: Gets the state of thread <tid>'s call stack at the time the object is
+//       created.
+//------------------------------------------------------------------------------
+void CallStack::get_call_stack(edb::tid_t tid) {
+
+	State state;
+	if(!edb::v1::debugger_core->get_thread_state(tid, &state)) {
+		return;
+	}
+
+	IProcess *const process = edb::v1::debugger_core->process();
+	if(!process) {
+		return;
+	}
+
+	// the backtrace is asked for every time the GUI updates, usually without
+	// the process having run in between
+	const quint64 generation = process->memory_generation();
+	if(generation != cached_generation) {
+		cached_stacks.clear();
+		cached_generation = generation;
+	}
+
+	const QHash<edb::tid_t, CachedStack>::const_iterator it = cached_stacks.find(tid);
+	if(generation != 0 && it != cached_stacks.end() && it->ip == state.instruction_pointer() && it->sp == state.stack_pointer() && it->fp == state.frame_pointer()) {
+		stack_frames_ = it->frames;
+		return;
+	}
+
+	build_call_stack(process, state);
+
+	if(generation != 0) {
+		const CachedStack cached = {
+			state.instruction_pointer(), state.stack_pointer(), state.frame_pointer(), stack_frames_
+		};
+		cached_stacks.insert(tid, cached);
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: build_call_stack
+// Desc: the memory regions are kept in sync by the debugger whenever the
+//       process stops, so they are just used as they are
+//------------------------------------------------------------------------------
+void CallStack::build_call_stack(IProcess *process, const State &state) {
+
+	const IRegion::pointer stack = edb::v1::memory_regions().find_region(state.stack_pointer());
+	if(!stack) {
+		return;
+	}
+
+	//Walk the frames with the unwind tables, a frame is a lookup and a few
+	//reads. Code without any falls back to the frame pointer chain.
+	Unwinder::Registers registers = Unwinder::registers(state);
+	QVector<edb::address_t> returns;
+
+	while(returns.size() < max_frames) {
+		const edb::address_t sp = registers.value[Unwinder::REGISTER_SP];
+
+		if(!Unwinder::instance().step(&registers, !returns.isEmpty()) && !frame_pointer_step(process, stack, &registers)) {
+			break;
+		}
+
+		//The stack only grows down, so anything else means we are lost.
+		if(registers.value[Unwinder::REGISTER_SP] <= sp || !stack->contains(registers.value[Unwinder::REGISTER_SP] - 1)) {
+			break;
+		}
+
+		returns.push_back(registers.value[Unwinder::REGISTER_IP]);
+	}
+
+	if(returns.isEmpty()) {
+		scan_call_stack(state);
+		return;
+	}
+
+	//Find the call before each return address, all in one batched read.
+	const quint8 CALL_MIN_SIZE = 2, CALL_MAX_SIZE = 7;
+	const int buffer_size = edb::Instruction::MAX_SIZE;
+
+	QVector<quint8> buffers(returns.size() * buffer_size);
+	QVector<IProcess::ReadRequest> requests;
+	requests.reserve(returns.size());
+	for (int i = 0; i < returns.size(); ++i) {
+		requests.push_back(IProcess::ReadRequest(returns[i] - CALL_MAX_SIZE, &buffers[i * buffer_size], buffer_size));
+	}
+
+	const QVector<bool> results = process->read_batch(requests);
+
+	for (int n = 0; n < returns.size(); ++n) {
+		stack_frame frame;
+		frame.ret    = returns[n];
+		frame.caller = returns[n];
+
+		if (results[n]) {
+			const quint8 *const buffer = &buffers[n * buffer_size];
+			for(int i = (CALL_MAX_SIZE - CALL_MIN_SIZE); i >= 0; --i) {
+				const InstructionCache::pointer inst = edb::v1::instruction_cache().decode(returns[n] - CALL_MAX_SIZE + i, buffer + i, buffer + buffer_size);
+				if(is_call(*inst) && static_cast<int>(inst->size()) == CALL_MAX_SIZE - i) {
+					frame.caller = returns[n] - CALL_MAX_SIZE + i;
+					break;
+				}
+			}
+		}
+
+		stack_frames_.append(frame);
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: scan_call_stack
+// Desc: Guesses at the call stack when it can't be unwound, by looking for
+//			values above the frame pointer which follow a call.
 //------------------------------------------------------------------------------
-void CallStack::get_call_stack() {
+void CallStack::scan_call_stack(const State &state) {
 	/*
 	 * Is rbp a pointer somewhere in the stack?
 	 * Is the value below rbp a ret addr?
@@ -46,8 +214,6 @@ void CallStack::get_call_stack() {
 	 */
 
 	//Get the frame & stack pointers.
-	State state;
-	edb::v1::debugger_core->get_state(&state);
 	edb::address_t rbp = state.frame_pointer();
 	edb::address_t rsp = state.stack_pointer();
 
@@ -62,38 +228,76 @@ void CallStack::get_call_stack() {
 	//If not, then it's being used as a GPR, and we don't have enough info.
 	//This assumes the stack pointer is always pointing somewhere in the stack.
 	IRegion::pointer region_rsp, region_rbp;
-	edb::v1::memory_regions().sync();
 	region_rsp = edb::v1::memory_regions().find_region(rsp);
 	region_rbp = edb::v1::memory_regions().find_region(rbp);
 	if (!region_rsp || !region_rbp || (region_rbp != region_rsp) ) {
 		return;
 	}
 
+	IProcess *const process = edb::v1::debugger_core->process();
+	if(!process) {
+		return;
+	}
+
+	//Grab every possible return address between rbp and the end of the stack in one read.
+	const int slot_count = (region_rbp->end() - rbp) / sizeof(edb::address_t);
+	QVector<edb::address_t> stack_values(slot_count);
+	if(slot_count == 0 || !process->read_bytes(rbp, stack_values.data(), slot_count * sizeof(edb::address_t))) {
+		return;
+	}
+
+	//Only values in executable regions can be return addresses, the region
+	//index sorts out most of the stack without reading anything. Where the
+	//analyzer has decoded the code in front of a value, it knows for sure.
+	IAnalyzer *const analyzer = edb::v1::analyzer();
+	QVector<edb::address_t> candidates;
+	for (int slot = 0; slot < slot_count; ++slot) {
+		const IRegion::pointer region = edb::v1::memory_regions().find_region(stack_values[slot]);
+		if (!region || !region->executable()) {
+			continue;
+		}
+
+		bool follows_call;
+		if (analyzer && analyzer->follows_call(stack_values[slot], &follows_call) && !follows_call) {
+			continue;
+		}
+
+		candidates.push_back(stack_values[slot]);
+	}
+
 	//But if we're good, then scan from rbp downward and look for return addresses.
 	//Code is largely from CommentServer.cpp.  Makes assumption of size of call.
+	//The bytes before each candidate are fetched with a single batched read.
 	const quint8 CALL_MIN_SIZE = 2, CALL_MAX_SIZE = 7;
-	quint8 buffer[edb::Instruction::MAX_SIZE];
-	for (edb::address_t addr = rbp; region_rbp->contains(addr); addr += sizeof(edb::address_t)) {
-
-		//Get the stack value so that we can see if it's a pointer
-		bool ok;
-		ExpressionError err;
-		edb::address_t possible_ret = edb::v1::get_value(addr, &ok, &err);
-
-		if(IProcess *process = edb::v1::debugger_core->process()) {
-			if(process->read_bytes(possible_ret - CALL_MAX_SIZE, buffer, sizeof(buffer))) {	//0xfffff... if not a ptr.
-				for(int i = (CALL_MAX_SIZE - CALL_MIN_SIZE); i >= 0; --i) {
-					edb::Instruction inst(buffer + i, buffer + sizeof(buffer), 0, std::nothrow);
-
-					//If it's a call, then make a frame
-					if(is_call(inst)) {
-						stack_frame frame;
-						frame.ret = possible_ret;
-						frame.caller = possible_ret - CALL_MAX_SIZE + i;
-						stack_frames_.append(frame);
-						break;
-					}
-				}
+	const int buffer_size = edb::Instruction::MAX_SIZE;
+
+	QVector<quint8> buffers(candidates.size() * buffer_size);
+	QVector<IProcess::ReadRequest> requests;
+	requests.reserve(candidates.size());
+	for (int n = 0; n < candidates.size(); ++n) {
+		requests.push_back(IProcess::ReadRequest(candidates[n] - CALL_MAX_SIZE, &buffers[n * buffer_size], buffer_size));
+	}
+
+	const QVector<bool> results = process->read_batch(requests);
+
+	for (int n = 0; n < candidates.size(); ++n) {
+
+		if (!results[n]) {	//not a ptr.
+			continue;
+		}
+
+		const edb::address_t possible_ret = candidates[n];
+		const quint8 *const buffer = &buffers[n * buffer_size];
+		for(int i = (CALL_MAX_SIZE - CALL_MIN_SIZE); i >= 0; --i) {
+			const InstructionCache::pointer inst = edb::v1::instruction_cache().decode(possible_ret - CALL_MAX_SIZE + i, buffer + i, buffer + buffer_size);
+
+			//If it's a call, then make a frame
+			if(is_call(*inst)) {
+				stack_frame frame;
+				frame.ret = possible_ret;
+				frame.caller = possible_ret - CALL_MAX_SIZE + i;
+				stack_frames_.append(frame);
+				break;
 			}
 		}
 	}
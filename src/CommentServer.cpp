@@ -18,17 +18,21 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "CommentServer.h"
 #include "Configuration.h"
+#include "IAnalyzer.h"
 #include "IDebugger.h"
 #include "Instruction.h"
+#include "InstructionCache.h"
 #include "edb.h"
 
 #include <QString>
+#include <QStringList>
+#include <QVector>
 
 //------------------------------------------------------------------------------
 // Name: CommentServer
 // Desc:
 //------------------------------------------------------------------------------
-CommentServer::CommentServer(QObject *parent) : QObject(parent) {
+CommentServer::CommentServer(QObject *parent) : QObject(parent), generation_(0), overlay_address_(0), resolve_values_(true) {
 
 }
 
@@ -45,6 +49,7 @@ CommentServer::~CommentServer() {
 //------------------------------------------------------------------------------
 void CommentServer::set_comment(QHexView::address_t address, const QString &comment) {
 	custom_comments_[address] = comment;
+	cache_.clear();
 }
 
 //------------------------------------------------------------------------------
@@ -53,6 +58,71 @@ void CommentServer::set_comment(QHexView::address_t address, const QString &comm
 //------------------------------------------------------------------------------
 void CommentServer::clear() {
 	custom_comments_.clear();
+	cache_.clear();
+	changes_.clear();
+}
+
+//------------------------------------------------------------------------------
+// Name: set_changes
+// Desc: the bytes which changed at the last stop, slots overlapping them are
+//       marked as changed
+//------------------------------------------------------------------------------
+void CommentServer::set_changes(const QVector<RegionDiff::Change> &changes) {
+	changes_ = changes;
+}
+
+//------------------------------------------------------------------------------
+// Name: set_resolve_values
+// Desc:
+//------------------------------------------------------------------------------
+void CommentServer::set_resolve_values(bool value) {
+	resolve_values_ = value;
+}
+
+//------------------------------------------------------------------------------
+// Name: set_overlay
+// Desc:
+//------------------------------------------------------------------------------
+void CommentServer::set_overlay(edb::address_t address, const TypeLayout::type_pointer &type) {
+	overlay_address_ = address;
+	overlay_type_    = type;
+}
+
+//------------------------------------------------------------------------------
+// Name: clear_overlay
+// Desc:
+//------------------------------------------------------------------------------
+void CommentServer::clear_overlay() {
+	overlay_type_.clear();
+}
+
+//------------------------------------------------------------------------------
+// Name: has_overlay
+// Desc:
+//------------------------------------------------------------------------------
+bool CommentServer::has_overlay() const {
+	return !overlay_type_.isNull();
+}
+
+//------------------------------------------------------------------------------
+// Name: overlay_field
+// Desc:
+//------------------------------------------------------------------------------
+bool CommentServer::overlay_field(edb::address_t address, TypeLayout::Location *location, edb::address_t *field_address) const {
+
+	Q_ASSERT(location);
+	Q_ASSERT(field_address);
+
+	if(!overlay_type_ || address < overlay_address_) {
+		return false;
+	}
+
+	if(!TypeLayout::locate(overlay_type_, address - overlay_address_, location)) {
+		return false;
+	}
+
+	*field_address = overlay_address_ + location->offset;
+	return true;
 }
 
 // a call can be anywhere from 2 to 7 bytes long depends on if there is a Mod/RM byte
@@ -62,12 +132,135 @@ void CommentServer::clear() {
 #define CALL_MAX_SIZE 7
 #define CALL_MIN_SIZE 2
 
+// how many bytes we prefetch when checking if a value points to a string,
+// enough for 256 UTF-16 characters
+#define STRING_PROBE_SIZE 512
+
+// how many slots are worked out in one go when one isn't known yet, the view
+// asks for them a row at a time from the top, so this covers a screenful
+#define PREFETCH_SLOTS 64
+
+//------------------------------------------------------------------------------
+// Name: sync
+// Desc: throws away the comments worked out before the process's memory last
+//       changed, if the process can't tell when that is, nothing is kept
+//------------------------------------------------------------------------------
+void CommentServer::sync() const {
+
+	IProcess *const process  = edb::v1::debugger_core ? edb::v1::debugger_core->process() : 0;
+	const quint64 generation = process ? process->memory_generation() : 0;
+
+	if(generation != generation_ || generation == 0) {
+		cache_.clear();
+		generation_ = generation;
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: prefetch
+// Desc: works out the comments for <count> slots from <address> onwards with
+//       one batched read for the values and another for what they point to
+//------------------------------------------------------------------------------
+void CommentServer::prefetch(IProcess *process, QHexView::address_t address, int count) const {
+
+	const std::size_t slot_size = edb::v1::pointer_size();
+
+	QVector<edb::address_t> values(count);
+	QVector<IProcess::ReadRequest> value_requests;
+	value_requests.reserve(count);
+
+	for(int i = 0; i < count; ++i) {
+		value_requests.push_back(IProcess::ReadRequest(address + i * slot_size, &values[i], sizeof(edb::address_t)));
+	}
+
+	const QVector<bool> value_results = process->read_batch(value_requests);
+
+	// the slots which are already known or unreadable have nothing to fetch
+	QVector<int> slots;
+	slots.reserve(count);
+	for(int i = 0; i < count; ++i) {
+		if(value_results[i] && !cache_.contains(address + i * slot_size)) {
+			slots.push_back(i);
+		}
+	}
+
+	// grab everything we might want to know about what each value points to
+	const int call_size = edb::Instruction::MAX_SIZE;
+	QVector<quint8> call_bytes(slots.size() * call_size);
+	QVector<quint8> string_bytes(slots.size() * STRING_PROBE_SIZE);
+
+	QVector<IProcess::ReadRequest> requests;
+	requests.reserve(slots.size() * 2);
+	for(int n = 0; n < slots.size(); ++n) {
+		const edb::address_t value = values[slots[n]];
+		requests.push_back(IProcess::ReadRequest(value - CALL_MAX_SIZE, &call_bytes[n * call_size], call_size));
+		requests.push_back(IProcess::ReadRequest(value, &string_bytes[n * STRING_PROBE_SIZE], STRING_PROBE_SIZE));
+	}
+
+	const QVector<bool> results = process->read_batch(requests);
+
+	for(int n = 0; n < slots.size(); ++n) {
+		const edb::address_t value = values[slots[n]];
+		cache_.insert(address + slots[n] * slot_size, resolve(value, &call_bytes[n * call_size], results[n * 2], &string_bytes[n * STRING_PROBE_SIZE]));
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: resolve
+// Desc: the comment for a slot holding <value>
+//------------------------------------------------------------------------------
+QString CommentServer::resolve(edb::address_t value, const quint8 *call_bytes, bool call_ok, const quint8 *string_bytes) const {
+
+	QHash<quint64, QString>::const_iterator it = custom_comments_.find(value);
+	if(it != custom_comments_.end()) {
+		return it.value();
+	}
+
+	QString ret;
+	bool ok = false;
+
+	// once the code in front of the value has been analyzed there is no need
+	// to decode it again
+	bool follows_call;
+	IAnalyzer *const analyzer = edb::v1::analyzer();
+	if(analyzer && analyzer->follows_call(value, &follows_call)) {
+		if(follows_call) {
+			return return_comment(value);
+		}
+	} else if(call_ok) {
+		ret = resolve_function_call(value, call_bytes, edb::Instruction::MAX_SIZE, &ok);
+	}
+
+	// unreadable bytes come back as 0xff, which end a string
+	// anyway, so a partial read is still useful here
+	if(!ok) {
+		ret = resolve_string(string_bytes, STRING_PROBE_SIZE, &ok);
+	}
+
+	return ret;
+}
+
+//------------------------------------------------------------------------------
+// Name: return_comment
+// Desc: the comment for a return address
+//------------------------------------------------------------------------------
+QString CommentServer::return_comment(edb::address_t address) const {
+
+	const QString symname = edb::v1::find_function_symbol(address);
+	if(!symname.isEmpty()) {
+		return tr("return to %1 <%2>").arg(edb::v1::format_pointer(address)).arg(symname);
+	}
+
+	return tr("return to %1").arg(edb::v1::format_pointer(address));
+}
+
 //------------------------------------------------------------------------------
 // Name: resolve_function_call
-// Desc:
+// Desc: <buffer> holds the bytes just before <address>, starting at
+//       address - CALL_MAX_SIZE
 //------------------------------------------------------------------------------
-QString CommentServer::resolve_function_call(QHexView::address_t address, bool *ok) const {
-	
+QString CommentServer::resolve_function_call(QHexView::address_t address, const quint8 *buffer, size_t size, bool *ok) const {
+
 	Q_ASSERT(ok);
 	QString ret;
 
@@ -75,24 +268,14 @@ QString CommentServer::resolve_function_call(QHexView::address_t address, bool *
 
 	// ok, we now want to locate the instruction before this one
 	// so we need to look back a few bytes
-	quint8 buffer[edb::Instruction::MAX_SIZE];
 
 	// TODO(eteran): portability warning, makes assumptions on the size of a call
-	if(IProcess *process = edb::v1::debugger_core->process()) {
-		if(process->read_bytes(address - CALL_MAX_SIZE, buffer, sizeof(buffer))) {
-			for(int i = (CALL_MAX_SIZE - CALL_MIN_SIZE); i >= 0; --i) {
-				edb::Instruction inst(buffer + i, buffer + sizeof(buffer), 0, std::nothrow);
-				if(is_call(inst)) {
-					const QString symname = edb::v1::find_function_symbol(address);
-					if(!symname.isEmpty()) {
-						ret = tr("return to %1 <%2>").arg(edb::v1::format_pointer(address)).arg(symname);
-					} else {
-						ret = tr("return to %1").arg(edb::v1::format_pointer(address));
-					}
-					*ok = true;
-					break;
-				}
-			}
+	for(int i = (CALL_MAX_SIZE - CALL_MIN_SIZE); i >= 0; --i) {
+		const InstructionCache::pointer inst = edb::v1::instruction_cache().decode(address - CALL_MAX_SIZE + i, buffer + i, buffer + size);
+		if(is_call(*inst)) {
+			ret = return_comment(address);
+			*ok = true;
+			break;
 		}
 	}
 
@@ -101,9 +284,9 @@ QString CommentServer::resolve_function_call(QHexView::address_t address, bool *
 
 //------------------------------------------------------------------------------
 // Name: resolve_string
-// Desc:
+// Desc: <buffer> holds the bytes found at <address>
 //------------------------------------------------------------------------------
-QString CommentServer::resolve_string(QHexView::address_t address, bool *ok) const {
+QString CommentServer::resolve_string(const quint8 *buffer, size_t size, bool *ok) const {
 
 	Q_ASSERT(ok);
 
@@ -113,9 +296,9 @@ QString CommentServer::resolve_string(QHexView::address_t address, bool *ok) con
 
 	int stringLen;
 	QString temp;
-	if((*ok = edb::v1::get_ascii_string_at_address(address, temp, min_string_length, 256, stringLen))) {
+	if((*ok = edb::v1::get_ascii_string_from_buffer(buffer, size, temp, min_string_length, 256, stringLen))) {
 		ret = tr("ASCII \"%1\"").arg(temp);
-	} else if((*ok = edb::v1::get_utf16_string_at_address(address, temp, min_string_length, 256, stringLen))) {
+	} else if((*ok = edb::v1::get_utf16_string_from_buffer(buffer, size, temp, min_string_length, 256, stringLen))) {
 		ret = tr("UTF16 \"%1\"").arg(temp);
 	}
 
@@ -128,28 +311,93 @@ QString CommentServer::resolve_string(QHexView::address_t address, bool *ok) con
 //------------------------------------------------------------------------------
 QString CommentServer::comment(QHexView::address_t address, int size) const {
 
-	QString ret;
-	
-	if(IProcess *process = edb::v1::debugger_core->process()) {
-		// if the view is currently looking at words which are a pointer in size
-		// then see if it points to anything...
-		if(size == edb::v1::pointer_size()) {
-			edb::address_t value;
-			if(process->read_bytes(address, &value, sizeof(value))) {
-
-				QHash<quint64, QString>::const_iterator it = custom_comments_.find(value);
-				if(it != custom_comments_.end()) {
-					ret = it.value();
-				} else {
-					bool ok;
-					ret = resolve_function_call(value, &ok);
-					if(!ok) {
-						ret = resolve_string(value, &ok);
-					}
-				}
+	IProcess *const process = edb::v1::debugger_core->process();
+	if(!process) {
+		return QString();
+	}
+
+	QString text;
+	if(overlay_type_ && address + size > overlay_address_ && address < overlay_address_ + overlay_type_->size) {
+		text = overlay_comment(process, address, size);
+
+	// if the view is currently looking at words which are a pointer in size
+	// then see if it points to anything...
+	} else if(resolve_values_ && size == edb::v1::pointer_size()) {
+		text = cached_comment(process, address);
+	} else {
+		return QString();
+	}
+
+	// whether the slot changed isn't kept with its comment, the changes are
+	// set on every stop while the comments last until the memory changes
+	if(RegionDiff::overlaps(changes_, address, size)) {
+		return text.isEmpty() ? tr("<changed>") : tr("<changed> %1").arg(text);
+	}
+
+	return text;
+}
+
+//------------------------------------------------------------------------------
+// Name: overlay_comment
+// Desc: the members of the overlay which start in the row at <address>, one
+//       which started in an earlier row belongs to that one. Each is read
+//       on its own, which the core's page cache makes cheap
+//------------------------------------------------------------------------------
+QString CommentServer::overlay_comment(IProcess *process, edb::address_t address, int size) const {
+
+	const edb::address_t end = address + size;
+
+	QStringList fields;
+	edb::address_t at = qMax<edb::address_t>(address, overlay_address_);
+
+	while(at < end) {
+		TypeLayout::Location location;
+		if(!TypeLayout::locate(overlay_type_, at - overlay_address_, &location)) {
+			// padding, or past the end
+			++at;
+			continue;
+		}
+
+		const edb::address_t field_address = overlay_address_ + location.offset;
+		const QString        name          = location.path.isEmpty() ? location.type->name : location.path;
+
+		if(field_address >= address) {
+			QVector<quint8> bytes(static_cast<int>(qMin<quint64>(location.type->size, STRING_PROBE_SIZE)));
+			if(!bytes.isEmpty() && process->read_bytes(field_address, bytes.data(), bytes.size())) {
+				fields.push_back(QString("%1 = %2").arg(name, TypeLayout::format_value(location.type, bytes.data(), bytes.size())));
+			} else {
+				fields.push_back(QString("%1 = ?").arg(name));
 			}
 		}
+
+		at = field_address + qMax<quint64>(location.type->size, 1);
 	}
 
-	return ret;
+	return fields.join(", ");
+}
+
+//------------------------------------------------------------------------------
+// Name: cached_comment
+// Desc:
+//------------------------------------------------------------------------------
+QString CommentServer::cached_comment(IProcess *process, QHexView::address_t address) const {
+
+	// the view repaints often while the process is stopped, neither a slot's
+	// value nor what it points to can change without the memory generation
+	// changing too, so the slot's address is all a comment needs to be found by
+	sync();
+
+	if(generation_ == 0) {
+		// nothing may be kept if the process can't say when its memory changes
+		prefetch(process, address, 1);
+		return cache_.take(address);
+	}
+
+	QHash<QHexView::address_t, QString>::const_iterator it = cache_.find(address);
+	if(it == cache_.end()) {
+		prefetch(process, address, PREFETCH_SLOTS);
+		it = cache_.find(address);
+	}
+
+	return (it != cache_.end()) ? it.value() : QString();
 }
@@ -20,8 +20,14 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #define COMMENTSERVER_20070427_H_
 
 #include "QHexView"
+#include "RegionDiff.h"
+#include "TypeLayout.h"
 #include <QHash>
 #include <QObject>
+#include <QVector>
+#include "Types.h"
+
+class IProcess;
 
 class CommentServer : public QObject, public QHexView::CommentServerInterface {
 	Q_OBJECT
@@ -35,12 +41,42 @@ public:
 	virtual QString comment(QHexView::address_t address, int size) const;
 	virtual void clear();
 
+public:
+	void set_changes(const QVector<RegionDiff::Change> &changes);
+
+	// the comments of slots holding pointers (return addresses, strings) are
+	// only worked out if this is on, which it is to begin with
+	void set_resolve_values(bool value);
+
+public:
+	// a value of <type> at <address>, the members of which are shown as the
+	// comments of the rows they start in. Only the rows which are shown are
+	// ever decoded
+	void set_overlay(edb::address_t address, const TypeLayout::type_pointer &type);
+	void clear_overlay();
+	bool has_overlay() const;
+
+	// the member of the overlay at <address>, <field_address> is where it starts
+	bool overlay_field(edb::address_t address, TypeLayout::Location *location, edb::address_t *field_address) const;
+
 private:
-	QString resolve_function_call(QHexView::address_t address, bool *ok) const;
-	QString resolve_string(QHexView::address_t address, bool *ok) const;
+	QString cached_comment(IProcess *process, QHexView::address_t address) const;
+	void sync() const;
+	void prefetch(IProcess *process, QHexView::address_t address, int count) const;
+	QString resolve(edb::address_t value, const quint8 *call_bytes, bool call_ok, const quint8 *string_bytes) const;
+	QString return_comment(edb::address_t address) const;
+	QString resolve_function_call(QHexView::address_t address, const quint8 *buffer, size_t size, bool *ok) const;
+	QString resolve_string(const quint8 *buffer, size_t size, bool *ok) const;
+	QString overlay_comment(IProcess *process, edb::address_t address, int size) const;
 
 private:
-	QHash<quint64, QString> custom_comments_;
+	QHash<quint64, QString>                     custom_comments_;
+	mutable QHash<QHexView::address_t, QString> cache_;
+	mutable quint64                             generation_;
+	QVector<RegionDiff::Change>                 changes_;
+	TypeLayout::type_pointer                    overlay_type_;
+	edb::address_t                              overlay_address_;
+	bool                                        resolve_values_;
 };
 
 #endif
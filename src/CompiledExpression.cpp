@@ -0,0 +1,192 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "CompiledExpression.h"
+#include "ISymbolManager.h"
+#include "State.h"
+#include "edb.h"
+
+namespace {
+
+//------------------------------------------------------------------------------
+// Name: find_symbol
+// Desc: the address of the symbol <name>, either fully, like
+//       "libc.so.6::malloc", or just "malloc" if it is in any module
+//------------------------------------------------------------------------------
+bool find_symbol(const QString &name, edb::address_t *address) {
+
+	if(const Symbol::pointer sym = edb::v1::symbol_manager().find(name)) {
+		*address = sym->address;
+		return true;
+	}
+
+	const QVector<quint64> matches = edb::v1::symbol_manager().search(name, ISymbolManager::SEARCH_EXACT);
+	if(!matches.isEmpty()) {
+		if(const Symbol::pointer sym = edb::v1::symbol_manager().from_handle(matches.front())) {
+			*address = sym->address;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+//------------------------------------------------------------------------------
+// Name: segment_base_name
+// Desc: fs and gs evaluate to the base of their segment, not the selector
+//------------------------------------------------------------------------------
+QString segment_base_name(const QString &name) {
+	if(name == "fs") {
+		return "fs_base";
+	} else if(name == "gs") {
+		return "gs_base";
+	}
+
+	return name;
+}
+
+struct slot_reader {
+	slot_reader(const State &state, const CompiledExpression::Program &program, const QVector<int> &registers) : state_(state), program_(program), registers_(registers) {
+	}
+
+	edb::address_t operator()(int slot, bool *ok, ExpressionError *err) const {
+
+		const int index = registers_[slot];
+		if(index != -1) {
+			*ok = true;
+			return state_.register_value(index);
+		}
+
+		// neither a register nor a symbol when it was compiled, a symbol may
+		// have turned up since
+		const QString &name = program_.variables[slot];
+
+		const Register reg = state_.value(segment_base_name(name));
+		if(reg) {
+			*ok = true;
+			return reg.value<edb::reg_t>();
+		}
+
+		edb::address_t address;
+		if(find_symbol(name, &address)) {
+			*ok = true;
+			return address;
+		}
+
+		*ok  = false;
+		*err = ExpressionError(ExpressionError::UNKNOWN_VARIABLE);
+		return 0;
+	}
+
+	const State                         &state_;
+	const CompiledExpression::Program   &program_;
+	const QVector<int>                  &registers_;
+};
+
+}
+
+//------------------------------------------------------------------------------
+// Name: CompiledExpression
+// Desc:
+//------------------------------------------------------------------------------
+CompiledExpression::CompiledExpression() : symbols_generation_(0), named_variables_(false), valid_(false) {
+}
+
+//------------------------------------------------------------------------------
+// Name: compile
+// Desc: parses <source>, <state> is only used to learn the register indexes
+//       so any state of the process will do
+//------------------------------------------------------------------------------
+bool CompiledExpression::compile(const QString &source, const State &state) {
+
+	Expression<edb::address_t> expr(source, edb::v1::get_variable, edb::v1::get_value);
+
+	source_             = source;
+	symbols_generation_ = edb::v1::symbol_manager().generation();
+	named_variables_    = false;
+	registers_.clear();
+
+	valid_ = expr.compile(&program_, &error_);
+	if(!valid_) {
+		return false;
+	}
+
+	QVector<edb::address_t> symbols(program_.variables.size());
+	QVector<bool>           is_symbol(program_.variables.size(), false);
+
+	for(int slot = 0; slot < program_.variables.size(); ++slot) {
+		const QString &name = program_.variables[slot];
+		const int index     = state.register_index(segment_base_name(name));
+
+		registers_.push_back(index);
+		if(index == -1) {
+			is_symbol[slot] = find_symbol(name, &symbols[slot]);
+			if(!is_symbol[slot]) {
+				named_variables_ = true;
+			}
+		}
+	}
+
+	// the symbols become constants, so evaluating them costs nothing
+	for(int i = 0; i < program_.code.size(); ++i) {
+		Program::Instruction &insn = program_.code[i];
+		if(insn.type == Program::Instruction::VARIABLE && is_symbol[insn.op]) {
+			insn.type  = Program::Instruction::CONSTANT;
+			insn.value = symbols[insn.op];
+		}
+	}
+
+	return true;
+}
+
+//------------------------------------------------------------------------------
+// Name: stale
+// Desc:
+//------------------------------------------------------------------------------
+bool CompiledExpression::stale() const {
+	return symbols_generation_ != edb::v1::symbol_manager().generation();
+}
+
+//------------------------------------------------------------------------------
+// Name: evaluate
+// Desc: evaluates the expression with the registers in <state>, reading memory
+//       straight from the process
+//------------------------------------------------------------------------------
+bool CompiledExpression::evaluate(const State &state, edb::address_t *result, ExpressionError *error) const {
+	return evaluate(state, edb::v1::get_value, result, error);
+}
+
+//------------------------------------------------------------------------------
+// Name: evaluate
+// Desc: evaluates the expression with the registers in <state>, reading memory
+//       with <mr>
+//------------------------------------------------------------------------------
+bool CompiledExpression::evaluate(const State &state, memory_reader_t mr, edb::address_t *result, ExpressionError *error) const {
+
+	Q_ASSERT(result);
+	Q_ASSERT(error);
+
+	if(!valid_) {
+		*error = error_;
+		return false;
+	}
+
+	bool ok;
+	*result = Expression<edb::address_t>::execute(program_, slot_reader(state, program_, registers_), mr, &ok, error);
+	return ok;
+}
@@ -22,6 +22,10 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <QDir>
 #include <QFont>
 
+#ifdef Q_OS_UNIX
+#include <csignal>
+#endif
+
 #define STRINGIFY(x) #x
 #define TOSTRING(x) STRINGIFY(x)
 
@@ -89,18 +93,38 @@ void Configuration::read_settings() {
 	min_string_length  = settings.value("debugger.string_min", 4).value<uint>();
 	tty_enabled        = settings.value("debugger.terminal.enabled", true).value<bool>();
 	tty_command        = settings.value("debugger.terminal.command", "/usr/bin/xterm").value<QString>();
+	page_cache_size    = settings.value("debugger.page_cache.size", 256).value<int>();
+	memory_budget      = settings.value("debugger.memory_budget.size", 0).value<int>();
+	track_memory_map   = settings.value("debugger.track_memory_map.enabled", false).value<bool>();
+	non_stop           = settings.value("debugger.non_stop.enabled", false).value<bool>();
+	follow_fork        = settings.value("debugger.follow_fork.enabled", false).value<bool>();
+
+	// there's rarely anything to see in these, so they've always been passed
+	QVariantMap default_signal_policies;
+#ifdef Q_OS_UNIX
+	default_signal_policies.insert(QString::number(SIGCHLD), SignalPass);
+	default_signal_policies.insert(QString::number(SIGPROF), SignalPass);
+#endif
+
+	signal_policies.clear();
+	const QVariantMap policies = settings.value("debugger.signal_policies", default_signal_policies).toMap();
+	for(QVariantMap::const_iterator it = policies.begin(); it != policies.end(); ++it) {
+		signal_policies.insert(it.key().toInt(), static_cast<SignalPolicy>(it.value().toInt()));
+	}
 	settings.endGroup();
 
 	settings.beginGroup("Disassembly");
-	syntax                = static_cast<Syntax>(settings.value("disassembly.syntax", Intel).value<uint>());
-	zeros_are_filling     = settings.value("disassembly.zeros_are_filling.enabled", true).value<bool>();
-	uppercase_disassembly = settings.value("disassembly.uppercase.enabled", false).value<bool>();
+	syntax                  = static_cast<Syntax>(settings.value("disassembly.syntax", Intel).value<uint>());
+	zeros_are_filling       = settings.value("disassembly.zeros_are_filling.enabled", true).value<bool>();
+	uppercase_disassembly   = settings.value("disassembly.uppercase.enabled", false).value<bool>();
+	scan_code_sections_only = settings.value("disassembly.scan_code_sections_only.enabled", true).value<bool>();
 	settings.endGroup();
 
 	settings.beginGroup("Directories");
-	symbol_path  = settings.value("directory.symbol.path", QString()).value<QString>();
-	plugin_path  = settings.value("directory.plugin.path", default_plugin_path).value<QString>();
-	session_path = settings.value("directory.session.path", QString()).value<QString>();
+	symbol_path     = settings.value("directory.symbol.path", QString()).value<QString>();
+	plugin_path     = settings.value("directory.plugin.path", default_plugin_path).value<QString>();
+	session_path    = settings.value("directory.session.path", QString()).value<QString>();
+	structures_file = settings.value("directory.structures.file", QString()).value<QString>();
 	settings.endGroup();
 
 	// normalize values
@@ -108,6 +132,14 @@ void Configuration::read_settings() {
 		data_word_width = 1;
 	}
 
+	if(page_cache_size < 0) {
+		page_cache_size = 0;
+	}
+
+	if(memory_budget < 0) {
+		memory_budget = 0;
+	}
+
 	if(data_row_width != 1 && data_row_width != 2 && data_row_width != 4 && data_row_width != 8 && data_row_width != 16) {
 		data_row_width = 16;
 	}
@@ -146,17 +178,30 @@ void Configuration::write_settings() {
 	settings.setValue("debugger.find_main.enabled", find_main);
 	settings.setValue("debugger.terminal.enabled", tty_enabled);
 	settings.setValue("debugger.terminal.command", tty_command);
+	settings.setValue("debugger.page_cache.size", page_cache_size);
+	settings.setValue("debugger.memory_budget.size", memory_budget);
+	settings.setValue("debugger.track_memory_map.enabled", track_memory_map);
+	settings.setValue("debugger.non_stop.enabled", non_stop);
+	settings.setValue("debugger.follow_fork.enabled", follow_fork);
+
+	QVariantMap policies;
+	for(QMap<int, SignalPolicy>::const_iterator it = signal_policies.begin(); it != signal_policies.end(); ++it) {
+		policies.insert(QString::number(it.key()), it.value());
+	}
+	settings.setValue("debugger.signal_policies", policies);
 	settings.endGroup();
 
 	settings.beginGroup("Disassembly");
 	settings.setValue("disassembly.syntax", syntax);
 	settings.setValue("disassembly.zeros_are_filling.enabled", zeros_are_filling);
 	settings.setValue("disassembly.uppercase.enabled", uppercase_disassembly);
+	settings.setValue("disassembly.scan_code_sections_only.enabled", scan_code_sections_only);
 	settings.endGroup();
 
 	settings.beginGroup("Directories");
 	settings.setValue("directory.symbol.path", symbol_path);
 	settings.setValue("directory.plugin.path", plugin_path);
 	settings.setValue("directory.session.path", session_path);
+	settings.setValue("directory.structures.file", structures_file);
 	settings.endGroup();
 }
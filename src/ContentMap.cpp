@@ -0,0 +1,208 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "ContentMap.h"
+#include "StringScanner.h"
+#include <cmath>
+#include <cstring>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+// how much entropy (in bits per byte) a page needs before it is taken to be
+// compressed or encrypted, x86 code and text stay well below this
+const float random_entropy = 7.2f;
+
+// x86 code is rarely any less varied than this
+const float code_entropy = 4.5f;
+
+// the share of a page, in percent, which has to be printable for it to be
+// text, or be one of the bytes x86 code is full of for it to be code. Those
+// bytes make up about 6% of random data, and several times that of code
+const std::size_t text_percent = 85;
+const std::size_t code_percent = 18;
+
+// opcodes, prefixes and ModRM bytes which turn up far more than their share in
+// both 32 and 64 bit code
+const quint8 code_bytes[] = {
+	0x0f, 0x24, 0x44, 0x45, 0x48, 0x4c, 0x74, 0x75,
+	0x83, 0x85, 0x89, 0x8b, 0x8d, 0xc3, 0xe8, 0xff
+};
+
+//------------------------------------------------------------------------------
+// Name: all_zero
+// Desc: true if none of the <size> bytes at <p> are set
+//------------------------------------------------------------------------------
+bool all_zero(const quint8 *p, std::size_t size) {
+
+	std::size_t i = 0;
+
+#ifdef __SSE2__
+	__m128i bits = _mm_setzero_si128();
+	for(; i + 16 <= size; i += 16) {
+		bits = _mm_or_si128(bits, _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + i)));
+	}
+
+	if(_mm_movemask_epi8(_mm_cmpeq_epi8(bits, _mm_setzero_si128())) != 0xffff) {
+		return false;
+	}
+#endif
+
+	for(; i < size; ++i) {
+		if(p[i]) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+//------------------------------------------------------------------------------
+// Name: histogram
+// Desc: counts each byte value of the <size> bytes at <p> into <counts>. Four
+//       histograms are kept and added up at the end, as a run of the same
+//       byte would otherwise have every count wait for the last one to be
+//       stored
+//------------------------------------------------------------------------------
+void histogram(const quint8 *p, std::size_t size, quint32 *counts) {
+
+	quint32 partial[4][256];
+	std::memset(partial, 0, sizeof(partial));
+
+	std::size_t i = 0;
+	for(; i + 4 <= size; i += 4) {
+		++partial[0][p[i + 0]];
+		++partial[1][p[i + 1]];
+		++partial[2][p[i + 2]];
+		++partial[3][p[i + 3]];
+	}
+
+	for(; i < size; ++i) {
+		++partial[0][p[i]];
+	}
+
+	for(int n = 0; n < 256; ++n) {
+		counts[n] = partial[0][n] + partial[1][n] + partial[2][n] + partial[3][n];
+	}
+}
+
+}
+
+//------------------------------------------------------------------------------
+// Name: ContentMap
+// Desc: <page_size> is how much each Page covers
+//------------------------------------------------------------------------------
+ContentMap::ContentMap(edb::address_t page_size) : page_size_(page_size ? page_size : 0x1000) {
+}
+
+//------------------------------------------------------------------------------
+// Name: classify
+// Desc: the entropy and content of the <size> bytes at <p>, which are at
+//       <address>
+//------------------------------------------------------------------------------
+ContentMap::Page ContentMap::classify(edb::address_t address, const quint8 *p, std::size_t size) {
+
+	Page page;
+	page.address = address;
+	page.entropy = 0.0f;
+	page.content = CONTENT_ZERO;
+
+	if(size == 0 || all_zero(p, size)) {
+		return page;
+	}
+
+	quint32 counts[256];
+	histogram(p, size, counts);
+
+	double      entropy   = 0.0;
+	std::size_t printable = 0;
+	for(int n = 0; n < 256; ++n) {
+		if(counts[n]) {
+			const double probability = static_cast<double>(counts[n]) / size;
+			entropy -= probability * std::log(probability);
+
+			if(StringScanner::is_ascii_char(n)) {
+				printable += counts[n];
+			}
+		}
+	}
+
+	std::size_t code = 0;
+	for(std::size_t n = 0; n < sizeof(code_bytes); ++n) {
+		code += counts[code_bytes[n]];
+	}
+
+	page.entropy = static_cast<float>(entropy / std::log(2.0));
+
+	if(printable * 100 >= size * text_percent) {
+		page.content = CONTENT_TEXT;
+	} else if(page.entropy >= random_entropy) {
+		page.content = CONTENT_RANDOM;
+	} else if(page.entropy >= code_entropy && code * 100 >= size * code_percent) {
+		page.content = CONTENT_CODE;
+	} else {
+		page.content = CONTENT_DATA;
+	}
+
+	return page;
+}
+
+//------------------------------------------------------------------------------
+// Name: run
+// Desc: maps every readable one of <regions>, replacing what pages() had
+//------------------------------------------------------------------------------
+void ContentMap::run(const QList<IRegion::pointer> &regions) {
+
+	pages_.clear();
+
+	QList<IRegion::pointer> readable;
+	Q_FOREACH(const IRegion::pointer &region, regions) {
+		if(region->readable()) {
+			readable.push_back(region);
+		}
+	}
+
+	RegionScanner().run(readable, this);
+}
+
+//------------------------------------------------------------------------------
+// Name: scan
+// Desc: runs on a pool thread, windows are made of whole pages
+//------------------------------------------------------------------------------
+RegionScanner::Task::Result *ContentMap::scan(const RegionScanner::Chunk &chunk) const {
+
+	List<Page> *const result = new List<Page>;
+
+	const quint8 *const data = chunk.data.constData();
+	for(std::size_t offset = 0; offset < chunk.size; offset += page_size_) {
+		const std::size_t size = qMin<std::size_t>(page_size_, chunk.size - offset);
+		result->items.push_back(classify(chunk.address + offset, data + offset, size));
+	}
+
+	return result;
+}
+
+//------------------------------------------------------------------------------
+// Name: merge
+// Desc:
+//------------------------------------------------------------------------------
+void ContentMap::merge(Result *result) {
+	pages_ += static_cast<List<Page> *>(result)->items;
+}
@@ -0,0 +1,676 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "CoreFile.h"
+#include "IDebugger.h"
+#include "IProcess.h"
+#include "IRegion.h"
+#include "MemoryDump.h"
+#include "State.h"
+#include "ThreadInfo.h"
+#include "edb.h"
+
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QPair>
+#include <QStringList>
+#include <cstddef>
+#include <cstring>
+
+#if defined(Q_OS_LINUX)
+#include <elf.h>
+#include <sys/procfs.h>
+#include <sys/user.h>
+#endif
+
+#if defined(Q_OS_LINUX)
+namespace {
+
+#if defined(EDB_X86_64)
+typedef Elf64_Ehdr elf_header;
+typedef Elf64_Phdr program_header;
+typedef Elf64_Nhdr note_header;
+const unsigned char CoreClass   = ELFCLASS64;
+const int           CoreMachine = EM_X86_64;
+#elif defined(EDB_X86)
+typedef Elf32_Ehdr elf_header;
+typedef Elf32_Phdr program_header;
+typedef Elf32_Nhdr note_header;
+const unsigned char CoreClass   = ELFCLASS32;
+const int           CoreMachine = EM_386;
+#endif
+
+// NT_FILE is made of words of the size of a pointer in the process
+typedef edb::address_t file_word;
+
+// our own note, the names of all of the regions in program header order
+const char    EdbNoteName[]  = "EDB";
+const quint32 NT_EDB_REGIONS = 1;
+
+// PT_LOAD flags, the permissions of a region
+const quint32 SegmentRead    = PF_R;
+const quint32 SegmentWrite   = PF_W;
+const quint32 SegmentExecute = PF_X;
+
+//------------------------------------------------------------------------------
+// Name: align_up
+// Desc: rounds <value> up to a multiple of <alignment>
+//------------------------------------------------------------------------------
+template <class T>
+T align_up(T value, T alignment) {
+	return (value + alignment - 1) / alignment * alignment;
+}
+
+//------------------------------------------------------------------------------
+// Name: append_note
+// Desc: adds a note to <notes>, the name and the description are both padded
+//       to 4 bytes, as they are in cores of either class
+//------------------------------------------------------------------------------
+void append_note(QByteArray *notes, const char *name, quint32 type, const void *desc, std::size_t size) {
+
+	note_header header;
+	header.n_namesz = std::strlen(name) + 1;
+	header.n_descsz = size;
+	header.n_type   = type;
+
+	notes->append(reinterpret_cast<const char *>(&header), sizeof(header));
+	notes->append(name, header.n_namesz);
+	notes->append(QByteArray(align_up<int>(header.n_namesz, 4) - header.n_namesz, '\0'));
+	notes->append(static_cast<const char *>(desc), size);
+	notes->append(QByteArray(align_up<int>(size, 4) - size, '\0'));
+}
+
+//------------------------------------------------------------------------------
+// Name: register_value
+// Desc: the value of the register called <name>, or 0 if there isn't one
+//------------------------------------------------------------------------------
+edb::reg_t register_value(const State &state, const char *name) {
+	const Register reg = state[name];
+	return reg.valid() ? reg.value<edb::reg_t>() : 0;
+}
+
+//------------------------------------------------------------------------------
+// Name: fill_registers
+// Desc: puts <state> into <regs> the way the kernel would have
+//------------------------------------------------------------------------------
+void fill_registers(const State &state, user_regs_struct *regs) {
+
+	std::memset(regs, 0, sizeof(*regs));
+
+#if defined(EDB_X86_64)
+	regs->r15      = register_value(state, "r15");
+	regs->r14      = register_value(state, "r14");
+	regs->r13      = register_value(state, "r13");
+	regs->r12      = register_value(state, "r12");
+	regs->rbp      = register_value(state, "rbp");
+	regs->rbx      = register_value(state, "rbx");
+	regs->r11      = register_value(state, "r11");
+	regs->r10      = register_value(state, "r10");
+	regs->r9       = register_value(state, "r9");
+	regs->r8       = register_value(state, "r8");
+	regs->rax      = register_value(state, "rax");
+	regs->rcx      = register_value(state, "rcx");
+	regs->rdx      = register_value(state, "rdx");
+	regs->rsi      = register_value(state, "rsi");
+	regs->rdi      = register_value(state, "rdi");
+	regs->orig_rax = static_cast<edb::reg_t>(-1);
+	regs->rip      = state.instruction_pointer();
+	regs->cs       = register_value(state, "cs");
+	regs->eflags   = state.flags();
+	regs->rsp      = register_value(state, "rsp");
+	regs->ss       = register_value(state, "ss");
+	regs->fs_base  = register_value(state, "fs_base");
+	regs->gs_base  = register_value(state, "gs_base");
+	regs->ds       = register_value(state, "ds");
+	regs->es       = register_value(state, "es");
+	regs->fs       = register_value(state, "fs");
+	regs->gs       = register_value(state, "gs");
+#elif defined(EDB_X86)
+	regs->ebx      = register_value(state, "ebx");
+	regs->ecx      = register_value(state, "ecx");
+	regs->edx      = register_value(state, "edx");
+	regs->esi      = register_value(state, "esi");
+	regs->edi      = register_value(state, "edi");
+	regs->ebp      = register_value(state, "ebp");
+	regs->eax      = register_value(state, "eax");
+	regs->xds      = register_value(state, "ds");
+	regs->xes      = register_value(state, "es");
+	regs->xfs      = register_value(state, "fs");
+	regs->xgs      = register_value(state, "gs");
+	regs->orig_eax = static_cast<edb::reg_t>(-1);
+	regs->eip      = state.instruction_pointer();
+	regs->xcs      = register_value(state, "cs");
+	regs->eflags   = state.flags();
+	regs->esp      = register_value(state, "esp");
+	regs->xss      = register_value(state, "ss");
+#endif
+}
+
+//------------------------------------------------------------------------------
+// Name: fill_state
+// Desc: the other way around, puts <regs> into <state>
+//------------------------------------------------------------------------------
+void fill_state(const user_regs_struct &regs, State *state) {
+
+#if defined(EDB_X86_64)
+	state->set_register("r15", regs.r15);
+	state->set_register("r14", regs.r14);
+	state->set_register("r13", regs.r13);
+	state->set_register("r12", regs.r12);
+	state->set_register("rbp", regs.rbp);
+	state->set_register("rbx", regs.rbx);
+	state->set_register("r11", regs.r11);
+	state->set_register("r10", regs.r10);
+	state->set_register("r9",  regs.r9);
+	state->set_register("r8",  regs.r8);
+	state->set_register("rax", regs.rax);
+	state->set_register("rcx", regs.rcx);
+	state->set_register("rdx", regs.rdx);
+	state->set_register("rsi", regs.rsi);
+	state->set_register("rdi", regs.rdi);
+	state->set_register("cs",  regs.cs);
+	state->set_register("rsp", regs.rsp);
+	state->set_register("ss",  regs.ss);
+	state->set_register("ds",  regs.ds);
+	state->set_register("es",  regs.es);
+	state->set_register("fs",  regs.fs);
+	state->set_register("gs",  regs.gs);
+	state->set_instruction_pointer(regs.rip);
+	state->set_flags(regs.eflags);
+#elif defined(EDB_X86)
+	state->set_register("ebx", regs.ebx);
+	state->set_register("ecx", regs.ecx);
+	state->set_register("edx", regs.edx);
+	state->set_register("esi", regs.esi);
+	state->set_register("edi", regs.edi);
+	state->set_register("ebp", regs.ebp);
+	state->set_register("eax", regs.eax);
+	state->set_register("ds",  regs.xds);
+	state->set_register("es",  regs.xes);
+	state->set_register("fs",  regs.xfs);
+	state->set_register("gs",  regs.xgs);
+	state->set_register("cs",  regs.xcs);
+	state->set_register("esp", regs.esp);
+	state->set_register("ss",  regs.xss);
+	state->set_instruction_pointer(regs.eip);
+	state->set_flags(regs.eflags);
+#endif
+}
+
+//------------------------------------------------------------------------------
+// Name: thread_note
+// Desc: NT_PRSTATUS for one thread
+//------------------------------------------------------------------------------
+void thread_note(QByteArray *notes, edb::pid_t pid, edb::tid_t tid, const user_regs_struct &regs) {
+
+	elf_prstatus status;
+	std::memset(&status, 0, sizeof(status));
+	status.pr_pid  = tid;
+	status.pr_pgrp = pid;
+	status.pr_sid  = pid;
+	std::memcpy(&status.pr_reg, &regs, qMin(sizeof(status.pr_reg), sizeof(regs)));
+
+	append_note(notes, "CORE", NT_PRSTATUS, &status, sizeof(status));
+}
+
+//------------------------------------------------------------------------------
+// Name: process_note
+// Desc: NT_PRPSINFO, the name and command line of the process
+//------------------------------------------------------------------------------
+void process_note(QByteArray *notes, IProcess *process) {
+
+	elf_prpsinfo info;
+	std::memset(&info, 0, sizeof(info));
+	info.pr_sname = 't';
+	info.pr_pid   = process->pid();
+
+	const QByteArray name = QFile::encodeName(QFileInfo(process->executable()).fileName());
+	std::strncpy(info.pr_fname, name.constData(), sizeof(info.pr_fname) - 1);
+
+	QByteArray args;
+	Q_FOREACH(const QByteArray &arg, process->arguments()) {
+		if(!args.isEmpty()) {
+			args += ' ';
+		}
+		args += arg;
+	}
+	std::strncpy(info.pr_psargs, args.constData(), sizeof(info.pr_psargs) - 1);
+
+	append_note(notes, "CORE", NT_PRPSINFO, &info, sizeof(info));
+}
+
+//------------------------------------------------------------------------------
+// Name: file_note
+// Desc: NT_FILE, which files the regions map and from where in them
+//------------------------------------------------------------------------------
+void file_note(QByteArray *notes, const QList<IRegion::pointer> &regions, edb::address_t page_size) {
+
+	QVector<file_word> words;
+	QByteArray         names;
+
+	words.push_back(0);
+	words.push_back(page_size);
+
+	Q_FOREACH(const IRegion::pointer &region, regions) {
+		if(region->name().startsWith('/')) {
+			words.push_back(region->start());
+			words.push_back(region->end());
+			words.push_back(region->base() / page_size);
+			names += QFile::encodeName(region->name());
+			names += '\0';
+			++words[0];
+		}
+	}
+
+	if(words[0] != 0) {
+		QByteArray desc(reinterpret_cast<const char *>(words.constData()), words.size() * sizeof(file_word));
+		desc += names;
+		append_note(notes, "CORE", NT_FILE, desc.constData(), desc.size());
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: region_names_note
+// Desc: our note, the name of every region whether it maps a file or not
+//------------------------------------------------------------------------------
+void region_names_note(QByteArray *notes, const QList<IRegion::pointer> &regions) {
+
+	QByteArray names;
+	Q_FOREACH(const IRegion::pointer &region, regions) {
+		names += region->name().toUtf8();
+		names += '\0';
+	}
+
+	append_note(notes, EdbNoteName, NT_EDB_REGIONS, names.constData(), names.size());
+}
+
+//------------------------------------------------------------------------------
+// Name: c_string
+// Desc: the NUL terminated string in <p>, which is at most <size> bytes long
+//------------------------------------------------------------------------------
+QByteArray c_string(const char *p, std::size_t size) {
+	return QByteArray(p, qstrnlen(p, size));
+}
+
+}
+#endif
+
+//------------------------------------------------------------------------------
+// Name: CoreFile
+// Desc:
+//------------------------------------------------------------------------------
+CoreFile::CoreFile() : pid_(0) {
+}
+
+//------------------------------------------------------------------------------
+// Name: save
+// Desc: writes a core file of the debuggee to <filename>, on failure <error>
+//       says why. The active thread is saved with all of its registers, the
+//       others only with their instruction pointers, since those are all the
+//       debugger core will tell us about them
+//------------------------------------------------------------------------------
+bool CoreFile::save(const QString &filename, QString *error) {
+
+	Q_ASSERT(error);
+
+#if defined(Q_OS_LINUX)
+	IProcess *const process = edb::v1::debugger_core ? edb::v1::debugger_core->process() : 0;
+	if(!process) {
+		*error = tr("There is no process to save.");
+		return false;
+	}
+
+	const edb::address_t page_size = edb::v1::debugger_core->page_size();
+
+	QList<IRegion::pointer> regions;
+	Q_FOREACH(const IRegion::pointer &region, process->regions()) {
+		if(region->size() != 0) {
+			regions.push_back(region);
+		}
+	}
+
+	if(regions.size() + 1 >= PN_XNUM) {
+		*error = tr("The process has too many memory regions for a core file.");
+		return false;
+	}
+
+	// the active thread goes first, that is the one debuggers will show
+	const edb::tid_t active = edb::v1::debugger_core->active_thread();
+
+	State state;
+	edb::v1::debugger_core->get_state(&state);
+
+	QByteArray notes;
+
+	user_regs_struct regs;
+	fill_registers(state, &regs);
+	thread_note(&notes, process->pid(), active != static_cast<edb::tid_t>(-1) ? active : process->pid(), regs);
+
+	Q_FOREACH(edb::tid_t tid, edb::v1::debugger_core->thread_ids()) {
+		if(tid != active) {
+			std::memset(&regs, 0, sizeof(regs));
+#if defined(EDB_X86_64)
+			regs.rip = edb::v1::debugger_core->get_thread_info(tid).ip;
+#elif defined(EDB_X86)
+			regs.eip = edb::v1::debugger_core->get_thread_info(tid).ip;
+#endif
+			thread_note(&notes, process->pid(), tid, regs);
+		}
+	}
+
+	process_note(&notes, process);
+	file_note(&notes, regions, page_size);
+	region_names_note(&notes, regions);
+
+	// the headers, then the notes, then the contents of the regions each
+	// starting on a page of their own
+	const std::size_t headers_size = sizeof(elf_header) + (regions.size() + 1) * sizeof(program_header);
+
+	elf_header header;
+	std::memset(&header, 0, sizeof(header));
+	std::memcpy(header.e_ident, ELFMAG, SELFMAG);
+	header.e_ident[EI_CLASS]   = CoreClass;
+	header.e_ident[EI_DATA]    = ELFDATA2LSB;
+	header.e_ident[EI_VERSION] = EV_CURRENT;
+	header.e_ident[EI_OSABI]   = ELFOSABI_NONE;
+	header.e_type              = ET_CORE;
+	header.e_machine           = CoreMachine;
+	header.e_version           = EV_CURRENT;
+	header.e_phoff             = sizeof(elf_header);
+	header.e_ehsize            = sizeof(elf_header);
+	header.e_phentsize         = sizeof(program_header);
+	header.e_phnum             = regions.size() + 1;
+
+	QByteArray headers(reinterpret_cast<const char *>(&header), sizeof(header));
+
+	program_header note;
+	std::memset(&note, 0, sizeof(note));
+	note.p_type   = PT_NOTE;
+	note.p_offset = headers_size;
+	note.p_filesz = notes.size();
+	note.p_align  = 4;
+	headers.append(reinterpret_cast<const char *>(&note), sizeof(note));
+
+	edb::address_t offset = align_up<edb::address_t>(headers_size + notes.size(), page_size);
+	const edb::address_t data_offset = offset;
+
+	Q_FOREACH(const IRegion::pointer &region, regions) {
+		program_header load;
+		std::memset(&load, 0, sizeof(load));
+		load.p_type   = PT_LOAD;
+		load.p_offset = offset;
+		load.p_vaddr  = region->start();
+		load.p_filesz = region->readable() ? region->size() : 0;
+		load.p_memsz  = region->size();
+		load.p_align  = page_size;
+		load.p_flags  = (region->readable() ? SegmentRead : 0) | (region->writable() ? SegmentWrite : 0) | (region->executable() ? SegmentExecute : 0);
+		headers.append(reinterpret_cast<const char *>(&load), sizeof(load));
+
+		offset += load.p_filesz;
+	}
+
+	headers += notes;
+	headers.append(QByteArray(data_offset - headers.size(), '\0'));
+
+	QFile file(filename);
+	if(!file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Unbuffered)) {
+		*error = tr("Could not open %1 for writing: %2").arg(filename, file.errorString());
+		return false;
+	}
+
+	if(file.write(headers) != headers.size()) {
+		*error = tr("Could not write to %1: %2").arg(filename, file.errorString());
+		return false;
+	}
+
+	Q_FOREACH(const IRegion::pointer &region, regions) {
+		if(region->readable() && !MemoryDump::write_region(&file, region)) {
+			*error = tr("Could not write the region at %1 to %2: %3").arg(edb::v1::format_pointer(region->start()), filename, file.errorString());
+			return false;
+		}
+	}
+
+	return true;
+#else
+	Q_UNUSED(filename);
+	*error = tr("Core files are not supported on this platform.");
+	return false;
+#endif
+}
+
+//------------------------------------------------------------------------------
+// Name: get_state
+// Desc: sets <state> to the registers <thread> had when the core was saved
+//------------------------------------------------------------------------------
+void CoreFile::get_state(const Thread &thread, State *state) {
+	Q_ASSERT(state);
+
+	state->clear();
+	load_registers(thread.registers, thread.registers_size, state);
+}
+
+//------------------------------------------------------------------------------
+// Name: save_registers
+// Desc: returns the registers of <state> the way they are kept in a core
+//------------------------------------------------------------------------------
+QByteArray CoreFile::save_registers(const State &state) {
+#if defined(Q_OS_LINUX)
+	user_regs_struct regs;
+	fill_registers(state, &regs);
+	return QByteArray(reinterpret_cast<const char *>(&regs), sizeof(regs));
+#else
+	Q_UNUSED(state);
+	return QByteArray();
+#endif
+}
+
+//------------------------------------------------------------------------------
+// Name: load_registers
+// Desc: sets the general purpose registers of <state> to the <size> bytes at
+//       <data>, as they are kept in a core. Anything missing is zero, the rest
+//       of <state> is left alone
+//------------------------------------------------------------------------------
+void CoreFile::load_registers(const uchar *data, std::size_t size, State *state) {
+
+	Q_ASSERT(state);
+
+#if defined(Q_OS_LINUX)
+	user_regs_struct regs;
+	std::memset(&regs, 0, sizeof(regs));
+	if(data) {
+		std::memcpy(&regs, data, qMin(sizeof(regs), size));
+	}
+	fill_state(regs, state);
+#else
+	Q_UNUSED(data);
+	Q_UNUSED(size);
+#endif
+}
+
+//------------------------------------------------------------------------------
+// Name: open
+// Desc: maps <filename> and reads what is in it, on failure <error> says why
+//------------------------------------------------------------------------------
+bool CoreFile::open(const QString &filename, QString *error) {
+
+	Q_ASSERT(error);
+
+	*this = CoreFile();
+
+#if defined(Q_OS_LINUX)
+	const MappedFile file = MappedFile::open(filename);
+	if(!file.is_open()) {
+		*error = tr("Could not open %1.").arg(filename);
+		return false;
+	}
+
+	const uchar *const data = file.data();
+	const quint64      size = file.size();
+
+	if(size < sizeof(elf_header)) {
+		*error = tr("%1 is not a core file.").arg(filename);
+		return false;
+	}
+
+	const elf_header *const header = reinterpret_cast<const elf_header *>(data);
+	if(std::memcmp(header->e_ident, ELFMAG, SELFMAG) != 0 || header->e_type != ET_CORE) {
+		*error = tr("%1 is not a core file.").arg(filename);
+		return false;
+	}
+
+	if(header->e_ident[EI_CLASS] != CoreClass || header->e_machine != CoreMachine) {
+		*error = tr("%1 is a core file of a different architecture.").arg(filename);
+		return false;
+	}
+
+	if(header->e_phentsize != sizeof(program_header) || header->e_phoff > size || (size - header->e_phoff) / sizeof(program_header) < header->e_phnum) {
+		*error = tr("%1 is damaged, its program headers are missing.").arg(filename);
+		return false;
+	}
+
+	const program_header *const headers = reinterpret_cast<const program_header *>(data + header->e_phoff);
+
+	QStringList region_names;
+	QHash<edb::address_t, QPair<QString, edb::address_t> > files;
+	QByteArray process_name;
+
+	// the notes first, they name the segments
+	for(int i = 0; i < header->e_phnum; ++i) {
+		const program_header &note = headers[i];
+		if(note.p_type != PT_NOTE || note.p_offset > size || note.p_filesz > size - note.p_offset) {
+			continue;
+		}
+
+		const uchar *p         = data + note.p_offset;
+		const uchar *const end = p + note.p_filesz;
+
+		while(end - p >= static_cast<std::ptrdiff_t>(sizeof(note_header))) {
+			const note_header *const n = reinterpret_cast<const note_header *>(p);
+			const std::size_t name_size = align_up<std::size_t>(n->n_namesz, 4);
+			const std::size_t desc_size = align_up<std::size_t>(n->n_descsz, 4);
+
+			if(static_cast<std::size_t>(end - p) - sizeof(note_header) < name_size + desc_size) {
+				break;
+			}
+
+			const QByteArray name  = c_string(reinterpret_cast<const char *>(p + sizeof(note_header)), n->n_namesz);
+			const uchar *const desc = p + sizeof(note_header) + name_size;
+			const std::size_t length = n->n_descsz;
+
+			if(name == "CORE" && n->n_type == NT_PRSTATUS && length >= sizeof(elf_prstatus)) {
+				const elf_prstatus *const status = reinterpret_cast<const elf_prstatus *>(desc);
+				Thread thread;
+				thread.tid            = status->pr_pid;
+				thread.signal         = status->pr_cursig;
+				thread.registers      = desc + offsetof(elf_prstatus, pr_reg);
+				thread.registers_size = sizeof(status->pr_reg);
+				threads_.push_back(thread);
+			} else if(name == "CORE" && n->n_type == NT_PRPSINFO && length >= sizeof(elf_prpsinfo)) {
+				const elf_prpsinfo *const info = reinterpret_cast<const elf_prpsinfo *>(desc);
+				pid_         = info->pr_pid;
+				process_name = c_string(info->pr_fname, sizeof(info->pr_fname));
+				Q_FOREACH(const QByteArray &arg, c_string(info->pr_psargs, sizeof(info->pr_psargs)).split(' ')) {
+					if(!arg.isEmpty()) {
+						arguments_.push_back(arg);
+					}
+				}
+			} else if(name == "CORE" && n->n_type == NT_FILE && length >= 2 * sizeof(file_word)) {
+				const file_word *const words = reinterpret_cast<const file_word *>(desc);
+				const file_word count        = words[0];
+				const file_word page_size    = words[1];
+				if(count <= (length / sizeof(file_word) - 2) / 3) {
+					const char *s         = reinterpret_cast<const char *>(words + 2 + count * 3);
+					const char *const last = reinterpret_cast<const char *>(desc + length);
+					for(file_word k = 0; k < count && s < last; ++k) {
+						const QByteArray file_name = c_string(s, last - s);
+						files.insert(words[2 + k * 3], qMakePair(QFile::decodeName(file_name), words[2 + k * 3 + 2] * page_size));
+						s += file_name.size() + 1;
+					}
+				}
+			} else if(name == EdbNoteName && n->n_type == NT_EDB_REGIONS) {
+				Q_FOREACH(const QByteArray &region_name, QByteArray(reinterpret_cast<const char *>(desc), length).split('\0')) {
+					region_names.push_back(QString::fromUtf8(region_name));
+				}
+			}
+
+			p += sizeof(note_header) + name_size + desc_size;
+		}
+	}
+
+	// then the segments, a segment which was only partly saved becomes two
+	int load_index = 0;
+	for(int i = 0; i < header->e_phnum; ++i) {
+		const program_header &load = headers[i];
+		if(load.p_type != PT_LOAD || load.p_memsz == 0) {
+			continue;
+		}
+
+		Segment segment;
+		segment.start   = load.p_vaddr;
+		segment.end     = load.p_vaddr + load.p_memsz;
+		segment.base    = 0;
+		segment.data    = 0;
+		segment.read    = (load.p_flags & SegmentRead) != 0;
+		segment.write   = (load.p_flags & SegmentWrite) != 0;
+		segment.execute = (load.p_flags & SegmentExecute) != 0;
+
+		QHash<edb::address_t, QPair<QString, edb::address_t> >::const_iterator it = files.constFind(segment.start);
+		if(it != files.constEnd()) {
+			segment.name = it->first;
+			segment.base = it->second;
+		}
+
+		if(load_index < region_names.size() && !region_names[load_index].isEmpty()) {
+			segment.name = region_names[load_index];
+		}
+		++load_index;
+
+		const edb::address_t saved = (load.p_offset <= size) ? qMin<quint64>(load.p_filesz, size - load.p_offset) : 0;
+		if(saved != 0) {
+			Segment rest    = segment;
+			segment.end     = segment.start + qMin<edb::address_t>(saved, load.p_memsz);
+			segment.data    = data + load.p_offset;
+			rest.start      = segment.end;
+			rest.base      += segment.end - segment.start;
+			segments_.push_back(segment);
+			if(rest.start != rest.end) {
+				segments_.push_back(rest);
+			}
+		} else {
+			segments_.push_back(segment);
+		}
+	}
+
+	// pr_fname is only the first 15 characters of the name, the full path is
+	// whichever file mapping has that name
+	executable_ = QFile::decodeName(process_name);
+	Q_FOREACH(const Segment &segment, segments_) {
+		if(segment.name.startsWith('/') && !process_name.isEmpty() && QFileInfo(segment.name).fileName().startsWith(executable_)) {
+			executable_ = segment.name;
+			break;
+		}
+	}
+
+	file_ = file;
+	return true;
+#else
+	*error = tr("Core files are not supported on this platform.");
+	return false;
+#endif
+}
@@ -0,0 +1,314 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "CoreFileDebugger.h"
+#include "ProcessSnapshot.h"
+#include "State.h"
+
+#include <QSet>
+
+//------------------------------------------------------------------------------
+// Name: CoreFileDebugger
+// Desc: <live_core> is the debugger core which was loaded as a plugin
+//------------------------------------------------------------------------------
+CoreFileDebugger::CoreFileDebugger(IDebugger *live_core) : live_core_(live_core), active_thread_(0) {
+	Q_ASSERT(live_core_);
+}
+
+//------------------------------------------------------------------------------
+// Name: ~CoreFileDebugger
+// Desc:
+//------------------------------------------------------------------------------
+CoreFileDebugger::~CoreFileDebugger() {
+}
+
+//------------------------------------------------------------------------------
+// Name: open_core
+// Desc: opens the core file <filename>, on failure <error> says why. The first
+//       thread in the core, the one which crashed, becomes the active one
+//------------------------------------------------------------------------------
+bool CoreFileDebugger::open_core(const QString &filename, QString *error) {
+
+	Q_ASSERT(error);
+
+	CoreFile core;
+	if(!core.open(filename, error)) {
+		return false;
+	}
+
+	// the snapshot shares the mapping of the core we just opened
+	ProcessSnapshot *const snapshot = ProcessSnapshot::open_core(filename, error);
+	if(!snapshot) {
+		return false;
+	}
+
+	core_ = core;
+	process_.reset(snapshot);
+	active_thread_ = core_.threads().isEmpty() ? core_.pid() : core_.threads().first().tid;
+	return true;
+}
+
+//------------------------------------------------------------------------------
+// Name: find_thread
+// Desc: returns the thread <tid> of the core, or NULL
+//------------------------------------------------------------------------------
+const CoreFile::Thread *CoreFileDebugger::find_thread(edb::tid_t tid) const {
+	Q_FOREACH(const CoreFile::Thread &thread, core_.threads()) {
+		if(thread.tid == tid) {
+			return &thread;
+		}
+	}
+	return 0;
+}
+
+//------------------------------------------------------------------------------
+// Name: loaded_modules
+// Desc: with nothing running the linker can't be asked, every file which is
+//       mapped is a module based at its lowest region
+//------------------------------------------------------------------------------
+QList<Module> CoreFileDebugger::loaded_modules() const {
+
+	QList<Module> ret;
+	QSet<QString> found_modules;
+
+	if(process_) {
+		Q_FOREACH(const IRegion::pointer &region, process_->regions()) {
+			if(region->name().startsWith("/") && !found_modules.contains(region->name())) {
+				Module module;
+				module.name         = region->name();
+				module.base_address = region->start();
+				found_modules.insert(region->name());
+				ret.push_back(module);
+			}
+		}
+	}
+
+	return ret;
+}
+
+//------------------------------------------------------------------------------
+// Name: attach
+// Desc:
+//------------------------------------------------------------------------------
+bool CoreFileDebugger::attach(edb::pid_t pid) {
+	Q_UNUSED(pid);
+	return false;
+}
+
+//------------------------------------------------------------------------------
+// Name: open
+// Desc:
+//------------------------------------------------------------------------------
+bool CoreFileDebugger::open(const QString &path, const QString &cwd, const QList<QByteArray> &args) {
+	Q_UNUSED(path);
+	Q_UNUSED(cwd);
+	Q_UNUSED(args);
+	return false;
+}
+
+//------------------------------------------------------------------------------
+// Name: open
+// Desc:
+//------------------------------------------------------------------------------
+bool CoreFileDebugger::open(const QString &path, const QString &cwd, const QList<QByteArray> &args, const QString &tty) {
+	Q_UNUSED(tty);
+	return open(path, cwd, args);
+}
+
+//------------------------------------------------------------------------------
+// Name: wait_debug_event
+// Desc: nothing ever happens in a core file
+//------------------------------------------------------------------------------
+IDebugEvent::const_pointer CoreFileDebugger::wait_debug_event(int msecs) {
+	Q_UNUSED(msecs);
+	return IDebugEvent::const_pointer();
+}
+
+//------------------------------------------------------------------------------
+// Name: detach
+// Desc: closes the core file
+//------------------------------------------------------------------------------
+void CoreFileDebugger::detach() {
+	process_.reset();
+	core_          = CoreFile();
+	active_thread_ = 0;
+}
+
+//------------------------------------------------------------------------------
+// Name: kill
+// Desc: closes the core file
+//------------------------------------------------------------------------------
+void CoreFileDebugger::kill() {
+	detach();
+}
+
+//------------------------------------------------------------------------------
+// Name: get_state
+// Desc: the registers of the active thread as they were saved
+//------------------------------------------------------------------------------
+void CoreFileDebugger::get_state(State *state) {
+
+	Q_ASSERT(state);
+
+	if(const CoreFile::Thread *const thread = find_thread(active_thread_)) {
+		CoreFile::get_state(*thread, state);
+	} else {
+		state->clear();
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: pause
+// Desc:
+//------------------------------------------------------------------------------
+void CoreFileDebugger::pause() {
+}
+
+//------------------------------------------------------------------------------
+// Name: resume
+// Desc:
+//------------------------------------------------------------------------------
+void CoreFileDebugger::resume(edb::EVENT_STATUS status) {
+	Q_UNUSED(status);
+}
+
+//------------------------------------------------------------------------------
+// Name: set_state
+// Desc: core files are read-only
+//------------------------------------------------------------------------------
+void CoreFileDebugger::set_state(const State &state) {
+	Q_UNUSED(state);
+}
+
+//------------------------------------------------------------------------------
+// Name: step
+// Desc:
+//------------------------------------------------------------------------------
+void CoreFileDebugger::step(edb::EVENT_STATUS status) {
+	Q_UNUSED(status);
+}
+
+//------------------------------------------------------------------------------
+// Name: thread_ids
+// Desc:
+//------------------------------------------------------------------------------
+QList<edb::tid_t> CoreFileDebugger::thread_ids() const {
+	QList<edb::tid_t> ret;
+	Q_FOREACH(const CoreFile::Thread &thread, core_.threads()) {
+		ret.push_back(thread.tid);
+	}
+	return ret;
+}
+
+//------------------------------------------------------------------------------
+// Name: active_thread
+// Desc:
+//------------------------------------------------------------------------------
+edb::tid_t CoreFileDebugger::active_thread() const {
+	return active_thread_;
+}
+
+//------------------------------------------------------------------------------
+// Name: set_active_thread
+// Desc: every thread of a core file is as good as any other
+//------------------------------------------------------------------------------
+void CoreFileDebugger::set_active_thread(edb::tid_t tid) {
+	if(find_thread(tid)) {
+		active_thread_ = tid;
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: get_thread_info
+// Desc:
+//------------------------------------------------------------------------------
+ThreadInfo CoreFileDebugger::get_thread_info(edb::tid_t tid) {
+
+	ThreadInfo info;
+	info.tid      = tid;
+	info.ip       = 0;
+	info.priority = 0;
+	info.running  = false;
+
+	if(const CoreFile::Thread *const thread = find_thread(tid)) {
+		State state;
+		CoreFile::get_state(*thread, &state);
+		info.ip    = state.instruction_pointer();
+		info.state = thread->signal ? exceptions().value(thread->signal, tr("Signal %1").arg(thread->signal)) : tr("Stopped");
+	}
+
+	return info;
+}
+
+//------------------------------------------------------------------------------
+// Name: backup_breakpoints
+// Desc:
+//------------------------------------------------------------------------------
+IDebugger::BreakpointList CoreFileDebugger::backup_breakpoints() const {
+	return BreakpointList();
+}
+
+//------------------------------------------------------------------------------
+// Name: add_breakpoint
+// Desc: nothing runs, so there is nowhere to break
+//------------------------------------------------------------------------------
+IBreakpoint::pointer CoreFileDebugger::add_breakpoint(edb::address_t address) {
+	Q_UNUSED(address);
+	return IBreakpoint::pointer();
+}
+
+//------------------------------------------------------------------------------
+// Name: add_breakpoints
+// Desc:
+//------------------------------------------------------------------------------
+QList<IBreakpoint::pointer> CoreFileDebugger::add_breakpoints(const QList<edb::address_t> &addresses) {
+	Q_UNUSED(addresses);
+	return QList<IBreakpoint::pointer>();
+}
+
+//------------------------------------------------------------------------------
+// Name: find_breakpoint
+// Desc:
+//------------------------------------------------------------------------------
+IBreakpoint::pointer CoreFileDebugger::find_breakpoint(edb::address_t address) {
+	Q_UNUSED(address);
+	return IBreakpoint::pointer();
+}
+
+//------------------------------------------------------------------------------
+// Name: clear_breakpoints
+// Desc:
+//------------------------------------------------------------------------------
+void CoreFileDebugger::clear_breakpoints() {
+}
+
+//------------------------------------------------------------------------------
+// Name: remove_breakpoint
+// Desc:
+//------------------------------------------------------------------------------
+void CoreFileDebugger::remove_breakpoint(edb::address_t address) {
+	Q_UNUSED(address);
+}
+
+//------------------------------------------------------------------------------
+// Name: process
+// Desc: NULL once the core is closed
+//------------------------------------------------------------------------------
+IProcess *CoreFileDebugger::process() const {
+	return process_.data();
+}
@@ -0,0 +1,108 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef COREFILEDEBUGGER_20261014_H_
+#define COREFILEDEBUGGER_20261014_H_
+
+#include "CoreFile.h"
+#include "IDebugger.h"
+#include <QCoreApplication>
+#include <QScopedPointer>
+
+class ProcessSnapshot;
+
+// a debugger core for post-mortem debugging, everything it knows comes out
+// of a core file. Memory is read straight out of the mapped core, nothing
+// ever runs and nothing can be changed. What depends on the machine rather
+// than the process (register names, states, exceptions, ...) is asked of the
+// live core
+class CoreFileDebugger : public IDebugger {
+	Q_DECLARE_TR_FUNCTIONS(CoreFileDebugger)
+	Q_DISABLE_COPY(CoreFileDebugger)
+public:
+	explicit CoreFileDebugger(IDebugger *live_core);
+	virtual ~CoreFileDebugger();
+
+public:
+	bool open_core(const QString &filename, QString *error);
+	IDebugger *live_core() const { return live_core_; }
+
+public:
+	virtual edb::address_t      page_size() const                            { return live_core_->page_size(); }
+	virtual int                 pointer_size() const                         { return live_core_->pointer_size(); }
+	virtual quint64             cpu_type() const                             { return live_core_->cpu_type(); }
+	virtual bool                has_extension(quint64 ext) const             { return live_core_->has_extension(ext); }
+	virtual QMap<long, QString> exceptions() const                           { return live_core_->exceptions(); }
+	virtual QString             stack_pointer() const                        { return live_core_->stack_pointer(); }
+	virtual QString             frame_pointer() const                        { return live_core_->frame_pointer(); }
+	virtual QString             instruction_pointer() const                  { return live_core_->instruction_pointer(); }
+	virtual QString             flag_register() const                        { return live_core_->flag_register(); }
+	virtual QString             format_pointer(edb::address_t address) const { return live_core_->format_pointer(address); }
+	virtual edb::pid_t          parent_pid(edb::pid_t pid) const             { return live_core_->parent_pid(pid); }
+	virtual IState *            create_state() const                         { return live_core_->create_state(); }
+
+	virtual QMap<edb::pid_t, ProcessInfo> enumerate_processes() const        { return live_core_->enumerate_processes(); }
+
+public:
+	virtual QList<Module> loaded_modules() const;
+
+public:
+	// there is nothing to run
+	virtual bool attach(edb::pid_t pid);
+	virtual bool open(const QString &path, const QString &cwd, const QList<QByteArray> &args);
+	virtual bool open(const QString &path, const QString &cwd, const QList<QByteArray> &args, const QString &tty);
+	virtual IDebugEvent::const_pointer wait_debug_event(int msecs);
+	virtual void detach();
+	virtual void get_state(State *state);
+	virtual void kill();
+	virtual void pause();
+	virtual void resume(edb::EVENT_STATUS status);
+	virtual void set_state(const State &state);
+	virtual void step(edb::EVENT_STATUS status);
+
+public:
+	virtual QList<edb::tid_t> thread_ids() const;
+	virtual edb::tid_t        active_thread() const;
+	virtual void              set_active_thread(edb::tid_t tid);
+	virtual ThreadInfo        get_thread_info(edb::tid_t tid);
+
+public:
+	virtual bool memory_map_changed() { return false; }
+
+public:
+	virtual BreakpointList              backup_breakpoints() const;
+	virtual IBreakpoint::pointer        add_breakpoint(edb::address_t address);
+	virtual QList<IBreakpoint::pointer> add_breakpoints(const QList<edb::address_t> &addresses);
+	virtual IBreakpoint::pointer        find_breakpoint(edb::address_t address);
+	virtual void                        clear_breakpoints();
+	virtual void                        remove_breakpoint(edb::address_t address);
+
+public:
+	virtual IProcess *process() const;
+
+private:
+	const CoreFile::Thread *find_thread(edb::tid_t tid) const;
+
+private:
+	IDebugger *const                live_core_;
+	CoreFile                        core_;
+	QScopedPointer<ProcessSnapshot> process_;
+	edb::tid_t                      active_thread_;
+};
+
+#endif
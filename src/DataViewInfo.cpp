@@ -23,7 +23,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 // Name: DataViewInfo
 // Desc:
 //------------------------------------------------------------------------------
-DataViewInfo::DataViewInfo(const IRegion::pointer &r) : region(r), stream(new RegionBuffer(r)) {
+DataViewInfo::DataViewInfo(const IRegion::pointer &r) : region(r), stream(new RegionBuffer(r)), shown_(false) {
 }
 
 //------------------------------------------------------------------------------
@@ -44,7 +44,30 @@ void DataViewInfo::update() {
 	Q_ASSERT(view);
 
 	stream->set_region(region);
+	stream->update_changes();
 	view->setAddressOffset(region->start());
 	view->setData(stream);
+	shown_ = true;
+}
+
+//------------------------------------------------------------------------------
+// Name: invalidate
+// Desc: the view no longer shows the region, the next update has to happen
+//------------------------------------------------------------------------------
+void DataViewInfo::invalidate() {
+	shown_ = false;
+}
+
+//------------------------------------------------------------------------------
+// Name: needs_update
+// Desc: the view reads its data as it paints, so setting it again is only
+//       needed when a page it has shown has changed since the last stop
+//------------------------------------------------------------------------------
+bool DataViewInfo::needs_update() {
+
+	Q_ASSERT(stream);
+
+	const bool changed = stream->update_changes();
+	return !shown_ || changed;
 }
 
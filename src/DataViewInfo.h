@@ -24,6 +24,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "IRegion.h"
 #include <QSharedPointer>
 
+class CommentServer;
 class QHexView;
 
 class DataViewInfo {
@@ -41,8 +42,16 @@ public:
 	RegionBuffer *const      stream;
 	QSharedPointer<QHexView> view;
 
+	// only made once a structure is overlaid on the view
+	QSharedPointer<CommentServer> comment_server;
+
 public:
 	void update();
+	void invalidate();
+	bool needs_update();
+
+private:
+	bool shown_; // false until update(), and again after invalidate()
 };
 
 #endif
@@ -17,16 +17,22 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
 #include "Debugger.h"
+#include "Annotations.h"
 #include "ArchProcessor.h"
 #include "CommentServer.h"
+#include "CompiledExpression.h"
 #include "Configuration.h"
+#include "CoreFile.h"
+#include "CoreFileDebugger.h"
 #include "DebuggerInternal.h"
+#include "Diagnostics.h"
 #include "DialogArguments.h"
 #include "DialogAttach.h"
 #include "DialogMemoryRegions.h"
 #include "DialogOptions.h"
 #include "DialogPlugins.h"
 #include "DialogThreads.h"
+#include "Emulator.h"
 #include "Expression.h"
 #include "IAnalyzer.h"
 #include "IBinary.h"
@@ -34,15 +40,25 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "IDebugger.h"
 #include "IPlugin.h"
 #include "Instruction.h"
+#include "InstructionCache.h"
+#include "PatchJournal.h"
+#include "LazyPlugin.h"
+#include "MemoryBudget.h"
+#include "MemoryDump.h"
 #include "MemoryRegions.h"
 #include "QHexView"
 #include "RecentFileManager.h"
+#include "RemoteDebugger.h"
+#include "RemoteProtocol.h"
 #include "State.h"
 #include "SymbolManager.h"
+#include "Trace.h"
+#include "Unwinder.h"
 #include "edb.h"
 #include "version.h"
 
 #include <QCloseEvent>
+#include <QDataStream>
 #include <QDir>
 #include <QDragEnterEvent>
 #include <QDropEvent>
@@ -54,7 +70,9 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <QMimeData>
 #include <QSettings>
 #include <QShortcut>
+#include <QSocketNotifier>
 #include <QStringListModel>
+#include <QTime>
 #include <QTimer>
 #include <QToolButton>
 #include <QUrl>
@@ -64,6 +82,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <boost/bind.hpp>
 #include <memory>
+#include <climits>
 #include <cstring>
 
 #if defined(Q_OS_UNIX) && !defined(Q_OS_MAC)
@@ -90,17 +109,158 @@ const char stack_type_name[] = "QWORD";
 
 const quint64 initial_bp_tag  = Q_UINT64_C(0x494e4954494e5433); // "INITINT3" in hex
 const quint64 stepover_bp_tag = Q_UINT64_C(0x535445504f564552); // "STEPOVER" in hex
+const quint64 link_map_bp_tag = Q_UINT64_C(0x4c494e4b4d415021); // "LINKMAP!" in hex
+const quint64 jit_bp_tag      = Q_UINT64_C(0x4a49545245474953); // "JITREGIS" in hex
+
+// stops which come quicker than this after the last refresh (holding down a
+// step key, auto stepping) share one deferred refresh instead of each redoing
+// every view, this keeps the display at no more than 25 frames per second
+const int gui_update_interval = 40;
+
+// events which are resumed from right away (conditions, tracing breakpoints,
+// signals passed on) are handled back to back for up to this long before
+// anything else in the event loop gets a turn
+const int event_batch_interval = 15;
 
 //--------------------------------------------------------------------------
 // Name: is_instruction_ret
 //--------------------------------------------------------------------------
 bool is_instruction_ret(edb::address_t address) {
 
-	quint8 buffer[edb::Instruction::MAX_SIZE];
-	if(const int size = edb::v1::get_instruction_bytes(address, buffer)) {
-		edb::Instruction inst(buffer, buffer + size, address, std::nothrow);
-		return is_ret(inst);
+	const InstructionCache::pointer inst = edb::v1::instruction_cache().find(address);
+	return inst && is_ret(*inst);
+}
+
+//--------------------------------------------------------------------------
+// Name: follows_call
+// Desc: returns true if the instruction just before <address> is a call,
+//       which is what we expect of a return address
+//--------------------------------------------------------------------------
+bool follows_call(edb::address_t address) {
+
+	const int CALL_MIN_SIZE = 2;
+	const int CALL_MAX_SIZE = 7;
+
+	IProcess *const process = edb::v1::debugger_core->process();
+	if(!process) {
+		return false;
+	}
+
+	quint8 buffer[CALL_MAX_SIZE];
+	if(!process->read_bytes(address - CALL_MAX_SIZE, buffer, sizeof(buffer))) {
+		return false;
+	}
+
+	for(int i = CALL_MAX_SIZE - CALL_MIN_SIZE; i >= 0; --i) {
+		const InstructionCache::pointer inst = edb::v1::instruction_cache().decode(address - CALL_MAX_SIZE + i, buffer + i, buffer + sizeof(buffer));
+		if(is_call(*inst) && static_cast<int>(inst->size()) == CALL_MAX_SIZE - i) {
+			return true;
+		}
+	}
+	return false;
+}
+
+//--------------------------------------------------------------------------
+// Name: frame_confirmed
+// Desc: returns true if the analyzer knows the function <ip> is in, that
+//       function sets up a frame pointer, and <ip> is past where it does so.
+//       Only then does the frame pointer say where the return address is
+//--------------------------------------------------------------------------
+bool frame_confirmed(IProcess *process, edb::address_t ip) {
+
+	IAnalyzer *const analyzer = edb::v1::analyzer();
+	if(!analyzer) {
+		return false;
+	}
+
+	bool ok;
+	const edb::address_t entry = analyzer->find_containing_function(ip, &ok);
+	if(!ok) {
+		return false;
+	}
+
+	quint8 prologue[9];
+	if(!process->read_bytes(entry, prologue, sizeof(prologue))) {
+		return false;
+	}
+
+	const quint8 *p = prologue;
+
+	// endbr32 / endbr64
+	if(p[0] == 0xf3 && p[1] == 0x0f && p[2] == 0x1e && (p[3] == 0xfa || p[3] == 0xfb)) {
+		p += 4;
+	}
+
+	// push bp
+	if(*p++ != 0x55) {
+		return false;
+	}
+
+#if defined(EDB_X86_64)
+	if(*p++ != 0x48) {
+		return false;
+	}
+#endif
+
+	// mov bp, sp
+	if(!((p[0] == 0x89 && p[1] == 0xe5) || (p[0] == 0x8b && p[1] == 0xec))) {
+		return false;
+	}
+	p += 2;
+
+	return ip >= entry + (p - prologue);
+}
+
+//--------------------------------------------------------------------------
+// Name: find_return_slot
+// Desc: finds where on the stack the return address of the current function
+//       lives. Returns true and sets <slot> and <return_address> on success
+//--------------------------------------------------------------------------
+bool find_return_slot(const State &state, edb::address_t *slot, edb::address_t *return_address) {
+
+	IProcess *const process = edb::v1::debugger_core->process();
+	if(!process) {
+		return false;
+	}
+
+	const edb::address_t ip = state.instruction_pointer();
+	const edb::address_t sp = state.stack_pointer();
+	const edb::address_t fp = state.frame_pointer();
+
+	QList<edb::address_t> candidates;
+
+	// the unwind info says exactly where the caller's frame starts, the
+	// return address is just below it
+	Unwinder::Registers registers = Unwinder::registers(state);
+	if(Unwinder::instance().step(&registers, false) && registers.valid[Unwinder::REGISTER_SP]) {
+		candidates.push_back(registers.value[Unwinder::REGISTER_SP] - sizeof(edb::address_t));
 	}
+
+	// on the first instruction of a function, or on its ret, the return
+	// address is right on top of the stack
+	if(is_instruction_ret(ip)) {
+		candidates.push_back(sp);
+	} else if(IAnalyzer *const analyzer = edb::v1::analyzer()) {
+		if(analyzer->category(ip) == IAnalyzer::ADDRESS_FUNC_START) {
+			candidates.push_back(sp);
+		}
+	}
+
+	// otherwise, the frame pointer can only be trusted once the function is
+	// known to have set it up. Anything else is left to Run Until Return
+	if(fp >= sp && frame_confirmed(process, ip)) {
+		candidates.push_back(fp + sizeof(edb::address_t));
+	}
+
+	Q_FOREACH(edb::address_t candidate, candidates) {
+		edb::address_t value;
+		if(process->read_bytes(candidate, &value, sizeof(value)) && follows_call(value)) {
+			*slot           = candidate;
+			*return_address = value;
+			return true;
+		}
+	}
+
 	return false;
 }
 
@@ -200,9 +360,18 @@ public:
 			}
 
 			//If not a ret, then step so we can find the next block terminator.
+			//Jumps are simple enough to emulate, which saves the trap.
 			else {
-				qDebug() << "Not ret. Single-stepping";
-				return edb::DEBUG_CONTINUE_STEP;
+				Emulator emulator(state);
+				if (!emulator.step()) {
+					qDebug() << "Not ret. Single-stepping";
+					return edb::DEBUG_CONTINUE_STEP;
+				}
+
+				qDebug() << "Not ret. Emulated it";
+				emulator.store(&state);
+				edb::v1::debugger_core->set_state(state);
+				address = emulator.instruction_pointer();
 			}
 		}
 
@@ -268,6 +437,93 @@ private:
 	edb::address_t		ret_address_;
 };
 
+class StepOut : public IDebugEventHandler {
+public:
+	//--------------------------------------------------------------------------
+	// Name: StepOut
+	// Desc: runs until the return address stored at <slot> is returned to,
+	//       a hit from a deeper (recursive) call has a stack pointer which is
+	//       still at or below <slot> and is stepped over
+	//--------------------------------------------------------------------------
+	StepOut(const IBreakpoint::pointer &bp, edb::address_t slot) : previous_handler_(0), bp_(bp), slot_(slot), stepping_(false) {
+		previous_handler_ = edb::v1::set_debug_event_handler(this);
+	}
+
+	//--------------------------------------------------------------------------
+	// Name: pass_back_to_debugger
+	// Desc: lets the previous handler deal with an event which isn't ours, if
+	//       that stops the process, we are done and delete this
+	// Note: the first event may well be the step off of a breakpoint that
+	//       Run does for us, which the debugger needs to see to re-enable it
+	//--------------------------------------------------------------------------
+	edb::EVENT_STATUS pass_back_to_debugger(const IDebugEvent::const_pointer &event) {
+		const edb::EVENT_STATUS status = previous_handler_->handle_event(event);
+		if(status == edb::DEBUG_STOP) {
+			finish();
+		}
+		return status;
+	}
+
+	//--------------------------------------------------------------------------
+	// Name: handle_event
+	//--------------------------------------------------------------------------
+	virtual edb::EVENT_STATUS handle_event(const IDebugEvent::const_pointer &event) {
+
+		if(!event->stopped() || !event->is_trap()) {
+			return pass_back_to_debugger(event);
+		}
+
+		// we just stepped past a recursive hit, put the breakpoint back
+		if(stepping_) {
+			stepping_ = false;
+			bp_->enable();
+			return edb::DEBUG_CONTINUE;
+		}
+
+		State state;
+		edb::v1::debugger_core->get_state(&state);
+
+		const edb::address_t address = state.instruction_pointer() - 1;
+		if(address != bp_->address() || !bp_->enabled()) {
+			// something else, like a user breakpoint
+			return pass_back_to_debugger(event);
+		}
+
+		bp_->hit();
+		state.set_instruction_pointer(address);
+		edb::v1::debugger_core->set_state(state);
+
+		if(state.stack_pointer() <= slot_) {
+			bp_->disable();
+			stepping_ = true;
+			return edb::DEBUG_CONTINUE_STEP;
+		}
+
+		finish();
+		return edb::DEBUG_STOP;
+	}
+
+private:
+	//--------------------------------------------------------------------------
+	// Name: finish
+	// Desc: removes our breakpoint, makes the previous handler the event
+	//       handler again and deletes this
+	//--------------------------------------------------------------------------
+	void finish() {
+		if(edb::v1::debugger_core->find_breakpoint(bp_->address()) == bp_) {
+			edb::v1::debugger_core->remove_breakpoint(bp_->address());
+		}
+		edb::v1::set_debug_event_handler(previous_handler_);
+		delete this;
+	}
+
+private:
+	IDebugEventHandler   *previous_handler_;
+	IBreakpoint::pointer  bp_;
+	edb::address_t        slot_;
+	bool                  stepping_;
+};
+
 //------------------------------------------------------------------------------
 // Name: Debugger
 // Desc:
@@ -280,9 +536,16 @@ Debugger::Debugger(QWidget *parent) : QMainWindow(parent),
 		stack_view_info_(IRegion::pointer()),
 		arguments_dialog_(new DialogArguments),
 		timer_(new QTimer(this)),
+		gui_update_timer_(new QTimer(this)),
+		event_notifier_(0),
 		recent_file_manager_(new RecentFileManager(this)),
 		stack_comment_server_(new CommentServer),
-		stack_view_locked_(false)
+		stack_view_locked_(false),
+		restarting_(false),
+		regions_stale_(false),
+		snapshot_count_(0),
+		resume_mode_(MODE_RUN),
+		step_until_count_(1000)
 #ifdef Q_OS_UNIX
 		,debug_pointer_(0)
 #endif
@@ -292,6 +555,13 @@ Debugger::Debugger(QWidget *parent) : QMainWindow(parent),
 	// connect the timer to the debug event
 	connect(timer_, SIGNAL(timeout()), this, SLOT(next_debug_event()));
 
+	// stops close together are drawn once when this fires
+	gui_update_timer_->setSingleShot(true);
+	connect(gui_update_timer_, SIGNAL(timeout()), this, SLOT(deferred_update_gui()));
+
+	// what the user annotates goes into the session as it is made
+	connect(&edb::v1::annotations(), SIGNAL(changed(Annotations::Kind, edb::address_t)), this, SLOT(annotation_changed(Annotations::Kind, edb::address_t)));
+
 	// create a context menu for the tab bar as well
 	connect(ui.tabWidget, SIGNAL(customContextMenuRequested(int, const QPoint &)), this, SLOT(tab_context_menu(int, const QPoint &)));
 
@@ -311,6 +581,10 @@ Debugger::Debugger(QWidget *parent) : QMainWindow(parent),
 	ui.action_Recent_Files->setMenu(recent_file_manager_->create_menu());
 	connect(recent_file_manager_, SIGNAL(file_selected(const QString &)), SLOT(open_file(const QString &)));
 
+	// the processes menu lists whatever the core follows at the time
+	connect(ui.menu_Processes, SIGNAL(aboutToShow()), SLOT(populate_process_menu()));
+	connect(ui.menu_Processes, SIGNAL(triggered(QAction *)), SLOT(process_selected(QAction *)));
+
 	// make us the default event handler
 	edb::v1::set_debug_event_handler(this);
 
@@ -332,6 +606,10 @@ Debugger::~Debugger() {
 
 	detach_from_process((edb::v1::config().close_behavior == Configuration::Terminate) ? KILL_ON_DETACH : NO_KILL_ON_DETACH);
 
+	if(remote_debugger_) {
+		edb::v1::debugger_core = remote_debugger_->live_core();
+	}
+
 	// kill our xterm and wait for it to die
 	tty_proc_->kill();
 	tty_proc_->waitForFinished(3000);
@@ -343,9 +621,12 @@ Debugger::~Debugger() {
 //------------------------------------------------------------------------------
 void Debugger::update_menu_state(GUI_STATE state) {
 
+	QString status;
+
 	switch(state) {
 	case PAUSED:
 		ui.actionRun_Until_Return->setEnabled(true);
+		ui.actionStep_Into_Until->setEnabled(true);
 		ui.action_Restart->setEnabled(true);
 		ui.action_Run->setEnabled(true);
 		ui.action_Pause->setEnabled(false);
@@ -357,11 +638,14 @@ void Debugger::update_menu_state(GUI_STATE state) {
 		ui.action_Run_Pass_Signal_To_Application->setEnabled(true);
 		ui.action_Detach->setEnabled(true);
 		ui.action_Kill->setEnabled(true);
+		ui.action_Save_Core_File->setEnabled(true);
+		ui.menu_Processes->setEnabled(true);
 		add_tab_->setEnabled(true);
-		edb::v1::set_status(tr("paused"));
+		status = tr("paused");
 		break;
 	case RUNNING:
 		ui.actionRun_Until_Return->setEnabled(false);
+		ui.actionStep_Into_Until->setEnabled(false);
 		ui.action_Restart->setEnabled(false);
 		ui.action_Run->setEnabled(false);
 		ui.action_Pause->setEnabled(true);
@@ -373,11 +657,14 @@ void Debugger::update_menu_state(GUI_STATE state) {
 		ui.action_Run_Pass_Signal_To_Application->setEnabled(false);
 		ui.action_Detach->setEnabled(true);
 		ui.action_Kill->setEnabled(true);
+		ui.action_Save_Core_File->setEnabled(false);
+		ui.menu_Processes->setEnabled(false);
 		add_tab_->setEnabled(true);
-		edb::v1::set_status(tr("running"));
+		status = tr("running");
 		break;
 	case TERMINATED:
 		ui.actionRun_Until_Return->setEnabled(false);
+		ui.actionStep_Into_Until->setEnabled(false);
 		ui.action_Restart->setEnabled(false);
 		ui.action_Run->setEnabled(false);
 		ui.action_Pause->setEnabled(false);
@@ -389,11 +676,38 @@ void Debugger::update_menu_state(GUI_STATE state) {
 		ui.action_Run_Pass_Signal_To_Application->setEnabled(false);
 		ui.action_Detach->setEnabled(false);
 		ui.action_Kill->setEnabled(false);
+		ui.action_Save_Core_File->setEnabled(false);
+		ui.menu_Processes->setEnabled(false);
 		add_tab_->setEnabled(false);
-		edb::v1::set_status(tr("terminated"));
+		status = tr("terminated");
 		break;
 	}
 
+	// a core file can be looked at, but nothing in it can run
+	if(core_file_debugger_ && state == PAUSED) {
+		ui.actionRun_Until_Return->setEnabled(false);
+		ui.actionStep_Into_Until->setEnabled(false);
+		ui.action_Restart->setEnabled(false);
+		ui.action_Run->setEnabled(false);
+		ui.action_Step_Into->setEnabled(false);
+		ui.action_Step_Over->setEnabled(false);
+		ui.actionStep_Out->setEnabled(false);
+		ui.action_Step_Into_Pass_Signal_To_Application->setEnabled(false);
+		ui.action_Step_Over_Pass_Signal_To_Application->setEnabled(false);
+		ui.action_Run_Pass_Signal_To_Application->setEnabled(false);
+		ui.action_Detach->setEnabled(false);
+		status = tr("core file");
+	}
+
+	if(remote_debugger_) {
+		status = tr("%1 on %2").arg(status, remote_debugger_->peer_name());
+	}
+
+	ui.action_Connect_Remote->setEnabled(remote_debugger_.isNull());
+	ui.action_Disconnect_Remote->setEnabled(!remote_debugger_.isNull());
+
+	edb::v1::set_status(status);
+
 	gui_state_ = state;
 }
 
@@ -605,6 +919,7 @@ void Debugger::finish_plugin_setup() {
 	Q_FOREACH(QObject *plugin, edb::v1::plugin_list()) {
 		if(IPlugin *const p = qobject_cast<IPlugin *>(plugin)) {
 			p->init();
+			edb::internal::startup_mark(QString("initialized %1").arg(plugin->metaObject()->className()));
 		}
 	}
 
@@ -623,6 +938,23 @@ void Debugger::finish_plugin_setup() {
 			}
 		}
 	}
+
+	// the plugins which haven't been loaded yet only have their menus
+	Q_FOREACH(LazyPlugin *plugin, edb::internal::lazy_plugins()) {
+		if(QMenu *const menu = plugin->menu(this)) {
+			ui.menu_Plugins->addMenu(menu);
+		}
+	}
+
+	edb::internal::startup_mark("set up plugin menus");
+}
+
+//------------------------------------------------------------------------------
+// Name: startup_finished
+// Desc: the first pass through the event loop, the window has been painted
+//------------------------------------------------------------------------------
+void Debugger::startup_finished() {
+	edb::internal::startup_mark("first pass through the event loop");
 }
 
 //------------------------------------------------------------------------------
@@ -1086,14 +1418,12 @@ void Debugger::step_over(F1 run_func, F2 step_func) {
 	edb::v1::debugger_core->get_state(&state);
 
 	const edb::address_t ip = state.instruction_pointer();
-	quint8 buffer[edb::Instruction::MAX_SIZE];
-	if(const int sz = edb::v1::get_instruction_bytes(ip, buffer)) {
-		edb::Instruction inst(buffer, buffer + sz, 0, std::nothrow);
-		if(inst && edb::v1::arch_processor().can_step_over(inst)) {
+	if(const InstructionCache::pointer inst = edb::v1::instruction_cache().find(ip)) {
+		if(*inst && edb::v1::arch_processor().can_step_over(*inst)) {
 
 			// add a temporary breakpoint at the instruction just
 			// after the call
-			if(IBreakpoint::pointer bp = edb::v1::debugger_core->add_breakpoint(ip + inst.size())) {
+			if(IBreakpoint::pointer bp = edb::v1::debugger_core->add_breakpoint(ip + inst->size())) {
 				bp->set_internal(true);
 				bp->set_one_time(true);
 				bp->tag = stepover_bp_tag;
@@ -1538,6 +1868,10 @@ void Debugger::mnuStackContextMenu(const QPoint &pos) {
 	menu->addSeparator();
 	menu->addAction(tr("&Push %1").arg(stack_type_name), this, SLOT(mnuStackPush()));
 	menu->addAction(tr("P&op %1").arg(stack_type_name), this, SLOT(mnuStackPop()));
+	menu->addSeparator();
+	menu->addAction(tr("Overlay St&ructure..."), this, SLOT(mnuStackOverlayStructure()));
+	menu->addAction(tr("Follow Structure &Pointer"), this, SLOT(mnuStackFollowStructurePointer()))->setEnabled(stack_comment_server_->has_overlay());
+	menu->addAction(tr("Remove Structure O&verlay"), this, SLOT(mnuStackRemoveStructureOverlay()))->setEnabled(stack_comment_server_->has_overlay());
 
 	// lockable stack feature
 	menu->addSeparator();
@@ -1571,7 +1905,17 @@ void Debugger::mnuDumpContextMenu(const QPoint &pos) {
 	menu->addSeparator();
 	menu->addAction(tr("&Edit Bytes"), this, SLOT(mnuDumpModify()));
 	menu->addSeparator();
+	menu->addAction(tr("Memory Breakpoint On &Access"), this, SLOT(mnuDumpBreakOnAccess()));
+	menu->addAction(tr("Memory Breakpoint On &Write"), this, SLOT(mnuDumpBreakOnWrite()));
+	menu->addAction(tr("&Remove Memory Breakpoints"), this, SLOT(mnuDumpRemoveMemoryBreakpoints()))->setEnabled(!memory_breakpoints_.ranges().isEmpty());
+	menu->addSeparator();
 	menu->addAction(tr("&Save To File"), this, SLOT(mnuDumpSaveToFile()));
+	menu->addSeparator();
+
+	const CommentServer *const server = comment_server(s, false);
+	menu->addAction(tr("Overlay St&ructure..."), this, SLOT(mnuDumpOverlayStructure()));
+	menu->addAction(tr("Follow Structure &Pointer"), this, SLOT(mnuDumpFollowStructurePointer()))->setEnabled(server && server->has_overlay());
+	menu->addAction(tr("Remove Structure O&verlay"), this, SLOT(mnuDumpRemoveStructureOverlay()))->setEnabled(server && server->has_overlay());
 
 	add_plugin_context_menu(menu, &IPlugin::data_context_menu);
 
@@ -1580,24 +1924,172 @@ void Debugger::mnuDumpContextMenu(const QPoint &pos) {
 }
 
 //------------------------------------------------------------------------------
-// Name: mnuDumpSaveToFile
+// Name: comment_server
+// Desc: the stack view always has one, data views get theirs once a
+//       structure is first overlaid on them
+//------------------------------------------------------------------------------
+CommentServer *Debugger::comment_server(QHexView *view, bool create) {
+
+	if(view == stack_view_.data()) {
+		return stack_comment_server_.data();
+	}
+
+	Q_FOREACH(const DataViewInfo::pointer &info, data_regions_) {
+		if(info->view.data() == view) {
+			if(!info->comment_server && create) {
+				// the data views only ever showed the overlay's comments
+				info->comment_server = QSharedPointer<CommentServer>(new CommentServer);
+				info->comment_server->set_resolve_values(false);
+				view->setCommentServer(info->comment_server);
+			}
+			return info->comment_server.data();
+		}
+	}
+
+	return 0;
+}
+
+//------------------------------------------------------------------------------
+// Name: overlay_structure
+// Desc: lays one of the structures of the structures file (or an array of
+//       them) over <view>, from the selection or the top of the view
+//------------------------------------------------------------------------------
+void Debugger::overlay_structure(QHexView *view) {
+
+	if(!view) {
+		return;
+	}
+
+	const TypeLayout &structures = edb::v1::structures();
+	const QStringList names      = structures.names();
+	if(names.isEmpty()) {
+		QMessageBox::information(this, tr("No Structures"), tr("No structures are defined, choose a file of C declarations of them in the Directories tab of the options."));
+		return;
+	}
+
+	const edb::address_t address = view->hasSelectedText() ? view->selectedBytesAddress() : view->firstVisibleAddress();
+
+	bool ok;
+	const QString name = QInputDialog::getItem(this, tr("Overlay Structure"), tr("Type at %1, followed by [count] for an array of them:").arg(edb::v1::format_pointer(address)), names, 0, true, &ok);
+	if(!ok || name.isEmpty()) {
+		return;
+	}
+
+	const TypeLayout::type_pointer type = structures.find(name);
+	if(!type || !type->complete || type->size == 0) {
+		QMessageBox::information(this, tr("Unknown Type"), tr("\"%1\" isn't a type which can be overlaid.").arg(name));
+		return;
+	}
+
+	comment_server(view, true)->set_overlay(address, type);
+	view->setShowComments(true);
+	view->viewport()->update();
+}
+
+//------------------------------------------------------------------------------
+// Name: follow_structure_pointer
+// Desc: shows what the selected pointer of the overlay points to in the data
+//       view, overlaid with the structure it points to if it is one
+//------------------------------------------------------------------------------
+void Debugger::follow_structure_pointer(QHexView *view) {
+
+	const CommentServer *const server = view ? comment_server(view, false) : 0;
+	IProcess *const process           = edb::v1::debugger_core->process();
+	if(!server || !process) {
+		return;
+	}
+
+	const edb::address_t address = view->hasSelectedText() ? view->selectedBytesAddress() : view->firstVisibleAddress();
+
+	TypeLayout::Location location;
+	edb::address_t field_address;
+	if(!server->overlay_field(address, &location, &field_address) || location.type->kind != TypeLayout::Type::POINTER) {
+		QMessageBox::information(this, tr("Not A Pointer"), tr("Please select a pointer of the structure overlay to use this function."));
+		return;
+	}
+
+	edb::address_t target = 0;
+	if(!process->read_bytes(field_address, &target, edb::v1::pointer_size())) {
+		return;
+	}
+
+	if(!edb::v1::dump_data(target)) {
+		QMessageBox::information(this,
+			tr("No Memory Found"),
+			tr("There appears to be no memory at that location (<strong>0x%1</strong>)").arg(edb::v1::format_pointer(target)));
+		return;
+	}
+
+	const TypeLayout::type_pointer element = location.type->element;
+	if(element->complete && (element->kind == TypeLayout::Type::STRUCT || element->kind == TypeLayout::Type::UNION)) {
+		if(QHexView *const data_view = qobject_cast<QHexView *>(ui.tabWidget->currentWidget())) {
+			comment_server(data_view, true)->set_overlay(target, element);
+			data_view->setShowComments(true);
+			data_view->viewport()->update();
+		}
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: remove_structure_overlay
 // Desc:
 //------------------------------------------------------------------------------
-void Debugger::mnuDumpSaveToFile() {
+void Debugger::remove_structure_overlay(QHexView *view) {
+	if(CommentServer *const server = view ? comment_server(view, false) : 0) {
+		server->clear_overlay();
+		view->viewport()->update();
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: add_memory_breakpoint
+// Desc: watches the bytes selected in the current data view
+//------------------------------------------------------------------------------
+void Debugger::add_memory_breakpoint(MemoryBreakpoints::Type type) {
 	QHexView *const s = qobject_cast<QHexView *>(ui.tabWidget->currentWidget());
 
 	Q_ASSERT(s);
 
+	const edb::address_t address = s->selectedBytesAddress();
+	const unsigned int size      = s->selectedBytesSize();
+
+	if(size != 0 && !memory_breakpoints_.add(address, size, type)) {
+		QMessageBox::information(this, tr("Memory Breakpoint"), tr("The memory at %1 could not be protected.").arg(edb::v1::format_pointer(address)));
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: mnuDumpRemoveMemoryBreakpoints
+// Desc:
+//------------------------------------------------------------------------------
+void Debugger::mnuDumpRemoveMemoryBreakpoints() {
+	memory_breakpoints_.remove_all();
+}
+
+//------------------------------------------------------------------------------
+// Name: mnuDumpSaveToFile
+// Desc:
+//------------------------------------------------------------------------------
+void Debugger::mnuDumpSaveToFile() {
+
+	const IRegion::pointer region = current_data_view_info()->region;
+	if(!region) {
+		return;
+	}
+
 	const QString filename = QFileDialog::getSaveFileName(
 		this,
 		tr("Save File"),
 		last_open_directory_);
 
 	if(!filename.isEmpty()) {
-		QFile file(filename);
-		file.open(QIODevice::WriteOnly);
-		if(file.isOpen()) {
-			file.write(s->allBytes());
+		QString error;
+		QApplication::setOverrideCursor(Qt::WaitCursor);
+		const bool saved = MemoryDump::save_region(region, filename, &error);
+		QApplication::restoreOverrideCursor();
+
+		if(!saved) {
+			QMessageBox::warning(this, tr("Error Saving File"), error);
 		}
 	}
 }
@@ -1611,11 +2103,11 @@ void Debugger::cpu_fill(quint8 byte) {
 	const unsigned int size      = ui.cpuView->selectedSize();
 
 	if(size != 0) {
-		if(IProcess *process = edb::v1::debugger_core->process()) {
+		if(edb::v1::debugger_core->process()) {
 			if(edb::v1::overwrite_check(address, size)) {
-				QByteArray bytes(size, byte);
+				const QByteArray bytes(size, byte);
 	
-				process->write_bytes(address, bytes.data(), size);
+				edb::v1::patch_journal().write((byte == 0x00) ? tr("Fill With Zeros") : tr("Fill With NOPs"), address, bytes);
 	
 				// do a refresh, not full update
 				refresh_gui();
@@ -1637,18 +2129,18 @@ void Debugger::mnuCPUEditComment() {
 				QString("Edit Comment"),
 				QString("Comment:"),
 				QLineEdit::Normal,
-				ui.cpuView->get_comment(address),
+				edb::v1::annotations().find(Annotations::COMMENT, address),
 				&got_text);
 
 	//If we got a comment, add it.
 	if (got_text && !comment.isEmpty()) {
-		ui.cpuView->add_comment(address, comment);
+		edb::v1::annotations().set(Annotations::COMMENT, address, comment);
 	}
 
 	//If the user backspaced the comment, remove the comment since
-	//there's no need for a null string to take space in the hash.
+	//there's no need for a null string to take space in the store.
 	else if (got_text && comment.isEmpty()) {
-		ui.cpuView->remove_comment(address);
+		edb::v1::annotations().remove(Annotations::COMMENT, address);
 	}
 
 	//The only other real case is that we didn't got_text.  No change.
@@ -1665,7 +2157,7 @@ void Debugger::mnuCPUEditComment() {
 //------------------------------------------------------------------------------
 void Debugger::mnuCPURemoveComment() {
 	const edb::address_t address = ui.cpuView->selectedAddress();
-	ui.cpuView->remove_comment(address);
+	edb::v1::annotations().remove(Annotations::COMMENT, address);
 	refresh_gui();
 }
 
@@ -1850,7 +2342,8 @@ edb::EVENT_STATUS Debugger::handle_trap() {
 	IBreakpoint::pointer bp = edb::v1::find_breakpoint(previous_ip);
 	if(bp && bp->enabled()) {
 
-		// TODO: check if the breakpoint was corrupted
+		// one the process wrote over has been put back by the core by now, see
+		// report_overwritten_breakpoints
 		bp->hit();
 
 		// back up eip the size of a breakpoint, since we executed a breakpoint
@@ -1858,15 +2351,59 @@ edb::EVENT_STATUS Debugger::handle_trap() {
 		state.set_instruction_pointer(previous_ip);
 		edb::v1::debugger_core->set_state(state);
 
+#if defined(Q_OS_UNIX) && !defined(Q_OS_MAC)
+		// the linker changed the list of loaded objects, if the user has a
+		// breakpoint here too it is still treated as theirs
+		if(module_tracker_.attached() && previous_ip == module_tracker_.breakpoint_address()) {
+			QList<Module> added;
+			QList<Module> removed;
+			if(module_tracker_.update(&added, &removed)) {
+				modules_changed(added, removed);
+			}
+
+			if(bp->tag == link_map_bp_tag) {
+				return edb::DEBUG_CONTINUE;
+			}
+		}
+
+		// a JIT registered or unregistered an object
+		if(jit_symbols_.attached() && previous_ip == jit_symbols_.breakpoint_address()) {
+			QList<Symbol::pointer> added;
+			jit_symbols_.update(&added);
+			edb::v1::symbol_manager().add_symbols(added);
+
+			if(bp->tag == jit_bp_tag) {
+				return edb::DEBUG_CONTINUE;
+			}
+		}
+#endif
+
 		const QString condition = bp->condition;
 
-		// handle conditional breakpoints
+		// handle conditional breakpoints, if the compiled condition can't be
+		// evaluated, fall back on the regular expression evaluator which will
+		// report the problem to the user
 		if(!condition.isEmpty()) {
-			if(!breakpoint_condition_true(condition)) {
+			state.set_instruction_pointer(previous_ip);
+
+			bool result;
+			ExpressionError err;
+			if(!edb::v1::breakpoint_condition_true(bp, state, &result, &err)) {
+				result = breakpoint_condition_true(condition);
+			}
+
+			if(!result) {
 				return edb::DEBUG_CONTINUE;
 			}
 		}
 
+		// logpoints which the core left to us, they never stop either
+		if(!bp->log_format.isEmpty()) {
+			state.set_instruction_pointer(previous_ip);
+			edb::v1::log_breakpoint_hit(bp, state);
+			return edb::DEBUG_CONTINUE;
+		}
+
 		// if it's a one time breakpoint then we should remove it upon
 		// triggering, this is mainly used for situations like step over
 
@@ -1879,25 +2416,123 @@ edb::EVENT_STATUS Debugger::handle_trap() {
 }
 
 //------------------------------------------------------------------------------
-// Name: handle_event_stopped
-// Desc:
+// Name: report_overwritten_breakpoints
+// Desc: lets the user know about breakpoints which the process wrote over,
+//       they are back in place, but the code under them has changed
 //------------------------------------------------------------------------------
-edb::EVENT_STATUS Debugger::handle_event_stopped(const IDebugEvent::const_pointer &event) {
-
-	// ok we just came in from a stop, we need to test some things,
-	// generally, we will want to check if it was a step, if it was, was it
-	// because we just hit a break point or because we wanted to run, but had
-	// to step first in case were were on a breakpoint already...
+void Debugger::report_overwritten_breakpoints() {
 
+	const QList<edb::address_t> overwritten = edb::v1::debugger_core->overwritten_breakpoints();
+	if(overwritten.isEmpty()) {
+		return;
+	}
 
-	if(event->is_kill()) {
-		QMessageBox::information(
-			this,
-			tr("Application Killed"),
-			tr("The debugged application was killed."));
-
-		on_action_Detach_triggered();
-		return edb::DEBUG_STOP;
+	QStringList addresses;
+	Q_FOREACH(edb::address_t address, overwritten) {
+		addresses << edb::v1::format_pointer(address);
+	}
+
+	ui.statusbar->showMessage(tr("The process wrote over the breakpoints at %1, they have been put back.").arg(addresses.join(", ")), 10000);
+}
+
+//------------------------------------------------------------------------------
+// Name: modules_changed
+// Desc: only the modules which came or went have their symbols and pending
+//       breakpoints touched
+//------------------------------------------------------------------------------
+void Debugger::modules_changed(const QList<Module> &added, const QList<Module> &removed) {
+
+	Q_FOREACH(const Module &module, removed) {
+		pending_breakpoints_.module_unloaded(module);
+		edb::v1::symbol_manager().unload_symbol_file(module.name);
+		session_modules_.remove(module.name);
+	}
+
+	regions_stale_ = true;
+
+	// the linker also lists things like the vdso, which aren't files
+	Q_FOREACH(const Module &module, added) {
+		if(QFileInfo(module.name).isAbsolute()) {
+			edb::v1::symbol_manager().load_symbol_file(module.name, module.base_address);
+			pending_breakpoints_.module_loaded(module);
+			apply_session(module.name);
+		}
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: update_jit_symbols
+// Desc: picks up what the JITs of the process compiled since the last stop,
+//       and starts following the GDB JIT interface once a module has it
+//------------------------------------------------------------------------------
+void Debugger::update_jit_symbols() {
+
+#if defined(Q_OS_UNIX) && !defined(Q_OS_MAC)
+	QList<Symbol::pointer> added;
+	jit_symbols_.poll_perf_map(&added);
+
+	if(!jit_symbols_.attached()) {
+		QStringList modules;
+		if(IProcess *const process = edb::v1::debugger_core->process()) {
+			modules.push_back(QFileInfo(process->executable()).fileName());
+		}
+
+		Q_FOREACH(const Module &module, loaded_modules()) {
+			modules.push_back(QFileInfo(module.name).fileName());
+		}
+
+		if(jit_symbols_.attach(modules, &added)) {
+			if(IBreakpoint::pointer bp = edb::v1::debugger_core->add_breakpoint(jit_symbols_.breakpoint_address())) {
+				bp->set_internal(true);
+				bp->tag = jit_bp_tag;
+			}
+		}
+	}
+
+	// one sort of the symbol table for all of them
+	edb::v1::symbol_manager().add_symbols(added);
+#endif
+}
+
+//------------------------------------------------------------------------------
+// Name: loaded_modules
+// Desc: the modules the linker has loaded, when we can't follow it the core
+//       works them out itself
+//------------------------------------------------------------------------------
+QList<Module> Debugger::loaded_modules() const {
+	if(module_tracker_.attached()) {
+		return module_tracker_.modules();
+	}
+
+	if(edb::v1::debugger_core) {
+		return edb::v1::debugger_core->loaded_modules();
+	}
+
+	return QList<Module>();
+}
+
+//------------------------------------------------------------------------------
+// Name: handle_event_stopped
+// Desc:
+//------------------------------------------------------------------------------
+edb::EVENT_STATUS Debugger::handle_event_stopped(const IDebugEvent::const_pointer &event) {
+
+	// ok we just came in from a stop, we need to test some things,
+	// generally, we will want to check if it was a step, if it was, was it
+	// because we just hit a break point or because we wanted to run, but had
+	// to step first in case were were on a breakpoint already...
+
+
+	report_overwritten_breakpoints();
+
+	if(event->is_kill()) {
+		QMessageBox::information(
+			this,
+			tr("Application Killed"),
+			tr("The debugged application was killed."));
+
+		on_action_Detach_triggered();
+		return edb::DEBUG_STOP;
 	}
 
 	if(event->is_error()) {
@@ -1915,12 +2550,12 @@ edb::EVENT_STATUS Debugger::handle_event_stopped(const IDebugEvent::const_pointe
 		return edb::DEBUG_STOP;
 	}
 
-	switch(event->code()) {
-#ifdef Q_OS_UNIX
-	case SIGCHLD:
-	case SIGPROF:
+	// cores which apply the signal policy themselves never get us here for
+	// signals which are passed, the rest leave it to us
+	switch(edb::v1::config().signal_policies.value(event->code(), Configuration::SignalStop)) {
+	case Configuration::SignalPass:
+	case Configuration::SignalLog:
 		return edb::DEBUG_EXCEPTION_NOT_HANDLED;
-#endif
 	default:
 		QMessageBox::information(this, tr("Debug Event"),
 			tr(
@@ -1973,7 +2608,36 @@ edb::EVENT_STATUS Debugger::handle_event(const IDebugEvent::const_pointer &event
 	// either a syncronous event (STOPPED)
 	// or an asyncronous event (SIGNALED)
 	case IDebugEvent::EVENT_STOPPED:
-		status = handle_event_stopped(event);
+		// a fault on a page guarded by a memory breakpoint, the instruction is
+		// stepped with the page accessible. Breakpoints waiting to be
+		// re-enabled wait for that step too
+		if(memory_breakpoints_.handle_fault(event)) {
+			return edb::DEBUG_CONTINUE_STEP;
+		}
+
+		do {
+			bool hit;
+			edb::address_t address;
+			if(memory_breakpoints_.handle_step(event, &hit, &address)) {
+				if(hit) {
+					if(reenable_breakpoint_step_) {
+						reenable_breakpoint_step_->enable();
+						reenable_breakpoint_step_.clear();
+					} else if(reenable_breakpoint_run_) {
+						reenable_breakpoint_run_->enable();
+						reenable_breakpoint_run_.clear();
+					}
+					edb::v1::set_status(tr("Memory breakpoint hit accessing %1").arg(edb::v1::format_pointer(address)));
+					return edb::DEBUG_STOP;
+				}
+
+				// nothing we watch, carry on with what the user asked for
+				status = (resume_mode_ == MODE_STEP) ? edb::DEBUG_STOP : edb::DEBUG_CONTINUE;
+				break;
+			}
+
+			status = handle_event_stopped(event);
+		} while(0);
 		break;
 
 	case IDebugEvent::EVENT_TERMINATED:
@@ -2010,6 +2674,7 @@ edb::EVENT_STATUS Debugger::handle_event(const IDebugEvent::const_pointer &event
 // Desc:
 //------------------------------------------------------------------------------
 edb::EVENT_STATUS Debugger::debug_event_handler(const IDebugEvent::const_pointer &event) {
+	EDB_TRACE_SCOPE("Debugger::debug_event_handler");
 	IDebugEventHandler *const handler = edb::v1::debug_event_handler();
 	Q_ASSERT(handler);
 	return handler->handle_event(event);
@@ -2059,6 +2724,7 @@ void Debugger::clear_data(const DataViewInfo::pointer &v) {
 
 	Q_ASSERT(view);
 
+	v->invalidate();
 	view->clear();
 	view->scrollTo(0);
 
@@ -2082,10 +2748,24 @@ void Debugger::do_jump_to_address(edb::address_t address, const IRegion::pointer
 // Name: update_disassembly
 // Desc:
 //------------------------------------------------------------------------------
-void Debugger::update_disassembly(edb::address_t address, const IRegion::pointer &r) {
+void Debugger::update_disassembly(const State &state, const IRegion::pointer &r) {
+	const edb::address_t address = state.instruction_pointer();
 	ui.cpuView->setCurrentAddress(address);
 	do_jump_to_address(address, r, true);
-	list_model_->setStringList(edb::v1::arch_processor().update_instruction_info(address));
+	list_model_->setStringList(instruction_info(state));
+}
+
+//------------------------------------------------------------------------------
+// Name: instruction_info
+// Desc: what there is to say about the instruction at the instruction pointer,
+//       it was decoded for the CPU view already so the cache has it
+//------------------------------------------------------------------------------
+QStringList Debugger::instruction_info(const State &state) const {
+	if(const InstructionCache::pointer inst = edb::v1::instruction_cache().find(state.instruction_pointer())) {
+		return edb::v1::arch_processor().update_instruction_info(*inst, state);
+	}
+
+	return QStringList();
 }
 
 //------------------------------------------------------------------------------
@@ -2108,7 +2788,7 @@ IRegion::pointer Debugger::update_cpu_view(const State &state) {
 	const edb::address_t address = state.instruction_pointer();
 
 	if(IRegion::pointer region = edb::v1::memory_regions().find_region(address)) {
-		update_disassembly(address, region);
+		update_disassembly(state, region);
 		return region;
 	} else {
 		ui.cpuView->clear();
@@ -2129,7 +2809,9 @@ void Debugger::update_data_views() {
 
 		// make sure the regions are still valid..
 		if(info->region && edb::v1::memory_regions().find_region(info->region->start())) {
-			update_data(info);
+			if(info->needs_update()) {
+				update_data(info);
+			}
 		} else {
 			clear_data(info);
 		}
@@ -2152,7 +2834,7 @@ void Debugger::refresh_gui() {
 	if(edb::v1::debugger_core) {
 		State state;
 		edb::v1::debugger_core->get_state(&state);
-		list_model_->setStringList(edb::v1::arch_processor().update_instruction_info(state.instruction_pointer()));
+		list_model_->setStringList(instruction_info(state));
 	}
 }
 
@@ -2162,22 +2844,80 @@ void Debugger::refresh_gui() {
 //------------------------------------------------------------------------------
 void Debugger::update_gui() {
 
+	EDB_TRACE_SCOPE("Debugger::update_gui");
+
+	static edb::diagnostics::Counter *const update_timer = edb::diagnostics::timer("Debugger::update_gui");
+	edb::diagnostics::ScopedTimer timer(update_timer);
+
+	gui_update_timer_->stop();
+	last_gui_update_.start();
+
+	snapshot_.clear();
+
 	if(edb::v1::debugger_core) {
-		State state;
-		edb::v1::debugger_core->get_state(&state);
+		IProcess *const process = edb::v1::debugger_core->process();
+
+		// everything below is shown from this, and so is whatever the
+		// plugins show when they hear that we're done
+		QSharedPointer<StopSnapshot> snapshot(new StopSnapshot);
+		edb::v1::debugger_core->get_state(&snapshot->state);
+		snapshot->active_thread = edb::v1::debugger_core->active_thread();
+		snapshot->threads       = edb::v1::debugger_core->thread_ids();
+		snapshot->generation    = process ? process->memory_generation() : 0;
+		snapshot->number        = ++snapshot_count_;
+
+		const State &state = snapshot->state;
 
 		update_data_views();
 		update_stack_view(state);
 
 		if(const IRegion::pointer region = update_cpu_view(state)) {
+			snapshot->code_region = region;
 			edb::v1::arch_processor().update_register_view(region->name(), state);
 		}
+
+		if(process) {
+			snapshot_ = snapshot;
+		}
 	}
 
 	//Signal all connected slots that the GUI has been updated.
 	//Useful for plugins with windows that should updated after
 	//hitting breakpoints, Step Over, etc.
 	emit gui_updated();
+
+	// everyone has seen this stop, so whatever the caches hold beyond the
+	// budget is the least likely to be needed again
+	edb::memory::enforce();
+}
+
+//------------------------------------------------------------------------------
+// Name: schedule_update_gui
+// Desc: updates the displays after a stop, right away if they haven't been
+//       for a while. Otherwise the update waits for the rest of the interval,
+//       if another step happens by then only the stop after it gets drawn
+//------------------------------------------------------------------------------
+void Debugger::schedule_update_gui() {
+
+	const int elapsed = last_gui_update_.isNull() ? gui_update_interval : last_gui_update_.elapsed();
+
+	// elapsed() goes negative if the clock passes midnight
+	if(elapsed >= gui_update_interval || elapsed < 0 || gui_state_ != PAUSED) {
+		update_gui();
+	} else if(!gui_update_timer_->isActive()) {
+		gui_update_timer_->start(gui_update_interval - elapsed);
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: deferred_update_gui
+// Desc: the refresh put off by schedule_update_gui, skipped if the process has
+//       been resumed since, as its next stop will schedule another one
+//------------------------------------------------------------------------------
+void Debugger::deferred_update_gui() {
+	if(gui_state_ == PAUSED) {
+		update_gui();
+	}
 }
 
 //------------------------------------------------------------------------------
@@ -2213,21 +2953,30 @@ void Debugger::resume_execution(EXCEPTION_RESUME pass_exception, DEBUG_MODE mode
 	// as normal
 	const edb::EVENT_STATUS status = resume_status(pass_exception == PASS_EXCEPTION);
 
-	// if we are on a breakpoint, disable it
-	State state;
-	edb::v1::debugger_core->get_state(&state);
+	if(!forced) {
+		resume_mode_ = mode;
+	}
+
+	// if we are on a breakpoint, disable it, unless we can run past it
+	// without taking it out
 	IBreakpoint::pointer bp;
+	bool displaced = false;
 	if(!forced) {
+		State state;
+		edb::v1::debugger_core->get_state(&state);
 		bp = edb::v1::debugger_core->find_breakpoint(state.instruction_pointer());
 		if(bp) {
-			bp->disable();
+			displaced = (mode == MODE_RUN) && displaced_steps_.resume(bp->address(), status);
+			if(!displaced) {
+				bp->disable();
+			}
 		}
 	}
 
 	if(mode == MODE_STEP) {
 		reenable_breakpoint_step_ = bp;
 		edb::v1::debugger_core->step(status);
-	} else if(mode == MODE_RUN) {
+	} else if(mode == MODE_RUN && !displaced) {
 		reenable_breakpoint_run_ = bp;
 		if(bp) {
 			edb::v1::debugger_core->step(status);
@@ -2236,8 +2985,14 @@ void Debugger::resume_execution(EXCEPTION_RESUME pass_exception, DEBUG_MODE mode
 		}
 	}
 
-	// set the state to 'running'
-	update_menu_state(RUNNING);
+	// what the views show is no longer what is there
+	snapshot_.clear();
+
+	// set the state to 'running', when an event is being resumed from we
+	// already are
+	if(gui_state_ != RUNNING) {
+		update_menu_state(RUNNING);
+	}
 }
 
 //------------------------------------------------------------------------------
@@ -2272,6 +3027,54 @@ void Debugger::on_action_Step_Into_triggered() {
 	resume_execution(IGNORE_EXCEPTION, MODE_STEP);
 }
 
+//------------------------------------------------------------------------------
+// Name: populate_process_menu
+// Desc: one entry per traced process, the one being debugged is checked
+//------------------------------------------------------------------------------
+void Debugger::populate_process_menu() {
+
+	ui.menu_Processes->clear();
+
+	const QList<edb::pid_t> processes = edb::v1::debugger_core->traced_processes();
+	if(processes.isEmpty()) {
+		ui.menu_Processes->addAction(QString::number(edb::v1::debugger_core->pid()))->setEnabled(false);
+		return;
+	}
+
+	Q_FOREACH(edb::pid_t pid, processes) {
+		QAction *const action = ui.menu_Processes->addAction(QString::number(pid));
+		action->setData(static_cast<qlonglong>(pid));
+		action->setCheckable(true);
+		action->setChecked(pid == edb::v1::debugger_core->pid());
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: process_selected
+// Desc: switches to debugging another one of the traced processes
+//------------------------------------------------------------------------------
+void Debugger::process_selected(QAction *action) {
+
+	const edb::pid_t pid = static_cast<edb::pid_t>(action->data().toLongLong());
+	if(!action->data().isValid() || pid == edb::v1::debugger_core->pid()) {
+		return;
+	}
+
+	if(!edb::v1::debugger_core->select_process(pid)) {
+		QMessageBox::information(this,
+			tr("Could Not Select Process"),
+			tr("Failed to switch to process %1, it may have exited.").arg(pid));
+		return;
+	}
+
+	// everything we show belongs to the old process
+	edb::v1::memory_regions().sync();
+	regions_stale_ = false;
+
+	update_menu_state(PAUSED);
+	update_gui();
+}
+
 //------------------------------------------------------------------------------
 // Name: on_action_Detach_triggered
 // Desc:
@@ -2310,9 +3113,34 @@ void Debugger::on_action_Step_Over_triggered() {
 
 //------------------------------------------------------------------------------
 // Name: on_actionStep_Out_triggered
-// Desc: Step out is the same as run until return, in our context.
+// Desc: runs until the current function returns to its caller. If we can find
+//       the return address this is a single breakpoint and one resume,
+//       otherwise we fall back on run until return
 //------------------------------------------------------------------------------
 void Debugger::on_actionStep_Out_triggered() {
+
+	State state;
+	edb::v1::debugger_core->get_state(&state);
+
+	edb::address_t slot;
+	edb::address_t return_address;
+	if(find_return_slot(state, &slot, &return_address)) {
+
+		// a breakpoint of the user's will stop us anyway
+		if(edb::v1::debugger_core->find_breakpoint(return_address)) {
+			on_action_Run_triggered();
+			return;
+		}
+
+		if(IBreakpoint::pointer bp = edb::v1::debugger_core->add_breakpoint(return_address)) {
+			bp->set_internal(true);
+			bp->set_one_time(true);
+			new StepOut(bp, slot);
+			on_action_Run_triggered();
+			return;
+		}
+	}
+
 	on_actionRun_Until_Return_triggered();
 }
 
@@ -2331,6 +3159,62 @@ void Debugger::on_actionRun_Until_Return_triggered() {
 				boost::bind(&Debugger::on_action_Step_Into_triggered, this));
 }
 
+//------------------------------------------------------------------------------
+// Name: on_actionStep_Into_Until_triggered
+// Desc: steps up to a number of instructions, or until a condition is true,
+//       without stopping to show each of them
+//------------------------------------------------------------------------------
+void Debugger::on_actionStep_Into_Until_triggered() {
+
+	Q_ASSERT(edb::v1::debugger_core);
+
+	bool ok;
+	const int count = QInputDialog::getInt(this, tr("Step Into Until"), tr("Most instructions to step:"), step_until_count_, 1, INT_MAX, 1, &ok);
+	if(!ok) {
+		return;
+	}
+
+	const QString source = QInputDialog::getText(this, tr("Step Into Until"), tr("Stop once this expression is true (optional):"), QLineEdit::Normal, step_until_condition_, &ok);
+	if(!ok) {
+		return;
+	}
+
+	step_until_count_     = count;
+	step_until_condition_ = source;
+
+	State state;
+	edb::v1::debugger_core->get_state(&state);
+
+	CompiledExpression condition;
+	if(!source.isEmpty() && !condition.compile(source, state)) {
+		QMessageBox::information(this, tr("Error In Expression!"), condition.error().what());
+		return;
+	}
+
+	// what was there to re-enable is stepped past by the core itself
+	reenable_breakpoint_step_.clear();
+	reenable_breakpoint_run_.clear();
+
+	QVector<edb::address_t> trace;
+	IDebugEvent::const_pointer event;
+	if(!edb::v1::debugger_core->step_many(count, source.isEmpty() ? 0 : &condition, &trace, &event)) {
+		QMessageBox::information(this, tr("Step Into Until"), tr("The debugger core can't step by itself, use Step Into instead."));
+		return;
+	}
+
+	resume_mode_ = MODE_STEP;
+	snapshot_.clear();
+	update_menu_state(RUNNING);
+
+	edb::v1::set_status(tr("Stepped %1 instructions").arg(trace.size()));
+
+	// nothing to report means the core kept it going, we'll hear about it
+	// from the event loop as usual
+	if(event) {
+		dispatch_debug_event(event);
+	}
+}
+
 //------------------------------------------------------------------------------
 // Name: on_action_Pause_triggered
 // Desc:
@@ -2347,10 +3231,22 @@ void Debugger::on_action_Pause_triggered() {
 void Debugger::cleanup_debugger() {
 
 	timer_->stop();
+	if(event_notifier_) {
+		event_notifier_->setEnabled(false);
+	}
 
-	ui.cpuView->clear_comments();
+	snapshot_.clear();
+	edb::v1::patch_journal().clear();
+	edb::v1::annotations().clear();
 	edb::v1::memory_regions().clear();
-	edb::v1::symbol_manager().clear();
+	if(restarting_) {
+		edb::v1::symbol_manager().clear_for_restart();
+	} else {
+		edb::v1::symbol_manager().clear();
+	}
+	module_tracker_.reset();
+	jit_symbols_.reset();
+	pending_breakpoints_.reset();
 	edb::v1::arch_processor().reset();
 
 	// clear up the data view
@@ -2381,8 +3277,11 @@ QString Debugger::session_filename() const {
 	}
 
 	if(!program_executable_.isEmpty()) {
+		// the same program rebuilt is a different program, it gets a session
+		// of its own
 		const QFileInfo info(program_executable_);
-		return QString(QLatin1String("%1/%2.edb")).arg(session_path, info.fileName());
+		const QByteArray md5 = edb::v1::get_file_md5(program_executable_);
+		return QString(QLatin1String("%1/%2-%3.session")).arg(session_path, info.fileName(), QString::fromLatin1(md5.toHex()));
 	}
 
 	return QString();
@@ -2394,10 +3293,7 @@ QString Debugger::session_filename() const {
 //------------------------------------------------------------------------------
 void Debugger::detach_from_process(DETACH_ACTION kill) {
 
-	const QString filename = session_filename();
-	if(!filename.isEmpty()) {
-		save_session(filename);
-	}
+	save_session();
 
 	program_executable_.clear();
 
@@ -2409,6 +3305,13 @@ void Debugger::detach_from_process(DETACH_ACTION kill) {
 	last_event_.clear();
 
 	cleanup_debugger();
+
+	// a core file is done with, the live core takes over again
+	if(core_file_debugger_) {
+		edb::v1::debugger_core = core_file_debugger_->live_core();
+		core_file_debugger_.reset();
+	}
+
 	update_menu_state(TERMINATED);
 }
 
@@ -2419,7 +3322,19 @@ void Debugger::detach_from_process(DETACH_ACTION kill) {
 void Debugger::set_initial_debugger_state() {
 
 	update_menu_state(PAUSED);
-	timer_->start(0);
+
+	// if the core can tell us when something happens, wait for that rather
+	// than polling for events
+	const int fd = edb::v1::debugger_core->event_fd();
+	if(fd != -1) {
+		if(!event_notifier_) {
+			event_notifier_ = new QSocketNotifier(fd, QSocketNotifier::Read, this);
+			connect(event_notifier_, SIGNAL(activated(int)), this, SLOT(next_debug_event()));
+		}
+		event_notifier_->setEnabled(true);
+	} else {
+		timer_->start(0);
+	}
 
 	edb::v1::symbol_manager().set_symbol_path(edb::v1::config().symbol_path);
 	edb::v1::memory_regions().sync();
@@ -2429,15 +3344,23 @@ void Debugger::set_initial_debugger_state() {
 	data_regions_.first()->region = edb::v1::primary_data_region();
 
 	if(IAnalyzer *const analyzer = edb::v1::analyzer()) {
-		analyzer->invalidate_analysis();
+		if(restarting_) {
+			analyzer->invalidate_for_restart();
+		} else {
+			analyzer->invalidate_analysis();
+		}
 	}
 
 	reenable_breakpoint_run_.clear();
 	reenable_breakpoint_step_.clear();
+	memory_breakpoints_.reset();
+	displaced_steps_.reset();
 
 #ifdef Q_OS_UNIX
 	debug_pointer_ = 0;
 #endif
+	module_tracker_.reset();
+	jit_symbols_.reset();
 
 	IProcess *process = edb::v1::debugger_core->process();
 
@@ -2450,6 +3373,8 @@ void Debugger::set_initial_debugger_state() {
 		program_executable_ = executable;
 	}
 
+	session_modules_.clear();
+
 	const QString filename = session_filename();
 	if(!filename.isEmpty()) {
 		load_session(filename);
@@ -2517,7 +3442,10 @@ void Debugger::set_initial_breakpoint(const QString &s) {
 
 //------------------------------------------------------------------------------
 // Name: on_action_Restart_triggered
-// Desc:
+// Desc: the same program is started again, so the symbols and analysis of its
+//       modules are kept for the new process rather than being rebuilt. Each
+//       is only taken back if its file is unchanged, moved to wherever the
+//       module is loaded this time. The annotations come back with the session
 //------------------------------------------------------------------------------
 void Debugger::on_action_Restart_triggered() {
 
@@ -2533,8 +3461,10 @@ void Debugger::on_action_Restart_triggered() {
 	}
 
 	if(!s.isEmpty()) {
+		restarting_ = true;
 		detach_from_process(KILL_ON_DETACH);
 		common_open(s, args);
+		restarting_ = false;
 	}
 }
 
@@ -2545,7 +3475,8 @@ void Debugger::on_action_Restart_triggered() {
 bool Debugger::common_open(const QString &s, const QList<QByteArray> &args) {
 
 	bool ret = false;
-	if(!QFile(s).exists()) {
+	// a remote target is on the stub's machine, the stub will say if it isn't there
+	if(!remote_debugger_ && !QFile(s).exists()) {
 		QMessageBox::information(
 			this,
 			tr("Could Not Open"),
@@ -2652,6 +3583,142 @@ void Debugger::attach(edb::pid_t pid) {
 	update_gui();
 }
 
+//------------------------------------------------------------------------------
+// Name: open_core
+// Desc: examines the process saved in the core file <filename>. The core file
+//       stands in for the debugger core until it is closed with Kill
+//------------------------------------------------------------------------------
+void Debugger::open_core(const QString &filename) {
+
+	disconnect_remote();
+	detach_from_process(NO_KILL_ON_DETACH);
+
+	QScopedPointer<CoreFileDebugger> core(new CoreFileDebugger(edb::v1::debugger_core));
+
+	QString error;
+	if(!core->open_core(filename, &error)) {
+		QMessageBox::warning(this, tr("Error Opening Core File"), error);
+		return;
+	}
+
+	core_file_debugger_.reset(core.take());
+	edb::v1::debugger_core = core_file_debugger_.data();
+
+	working_directory_ = QFileInfo(filename).absolutePath();
+
+	set_initial_debugger_state();
+
+	// nothing will ever happen in a core file, there is no point in waiting
+	timer_->stop();
+	if(event_notifier_) {
+		event_notifier_->setEnabled(false);
+	}
+
+	update_gui();
+}
+
+//------------------------------------------------------------------------------
+// Name: on_action_Open_Core_File_triggered
+// Desc:
+//------------------------------------------------------------------------------
+void Debugger::on_action_Open_Core_File_triggered() {
+
+	const QString filename = QFileDialog::getOpenFileName(
+		this,
+		tr("Choose a core file to examine"),
+		last_open_directory_,
+		tr("Core Files (core*);;All Files (*)"));
+
+	if(!filename.isEmpty()) {
+		last_open_directory_ = QFileInfo(filename).absolutePath();
+		open_core(filename);
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: connect_remote
+// Desc: debugs through the edb --stub at <host>:<port>, which stands in for
+//       the debugger core until it is disconnected from
+//------------------------------------------------------------------------------
+void Debugger::connect_remote(const QString &host, quint16 port) {
+
+	disconnect_remote();
+	detach_from_process(NO_KILL_ON_DETACH);
+
+	QScopedPointer<RemoteDebugger> core(new RemoteDebugger(edb::v1::debugger_core));
+
+	QApplication::setOverrideCursor(Qt::WaitCursor);
+	QString error;
+	const bool connected = core->connect_to_stub(host, port, &error);
+	QApplication::restoreOverrideCursor();
+
+	if(!connected) {
+		QMessageBox::warning(this, tr("Error Connecting to Stub"), error);
+		return;
+	}
+
+	remote_debugger_.reset(core.take());
+	edb::v1::debugger_core = remote_debugger_.data();
+
+	update_menu_state(TERMINATED);
+}
+
+//------------------------------------------------------------------------------
+// Name: disconnect_remote
+// Desc: lets go of the remote process, and the live core takes over again
+//------------------------------------------------------------------------------
+void Debugger::disconnect_remote() {
+
+	if(remote_debugger_) {
+		detach_from_process(NO_KILL_ON_DETACH);
+		edb::v1::debugger_core = remote_debugger_->live_core();
+		remote_debugger_.reset();
+		update_menu_state(TERMINATED);
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: on_action_Connect_Remote_triggered
+// Desc:
+//------------------------------------------------------------------------------
+void Debugger::on_action_Connect_Remote_triggered() {
+
+	bool ok;
+	const QString address = QInputDialog::getText(
+		this,
+		tr("Connect to Remote Stub"),
+		tr("Address of an edb running with --stub (host:port), reach it through an SSH tunnel:"),
+		QLineEdit::Normal,
+		QString("localhost:%1").arg(Remote::DefaultPort),
+		&ok);
+
+	if(!ok || address.isEmpty()) {
+		return;
+	}
+
+	const int colon = address.lastIndexOf(':');
+	quint16 port = Remote::DefaultPort;
+	QString host = address;
+	if(colon != -1) {
+		port = address.mid(colon + 1).toUShort(&ok);
+		host = address.left(colon);
+		if(!ok) {
+			QMessageBox::warning(this, tr("Error Connecting to Stub"), tr("%1 is not a valid port.").arg(address.mid(colon + 1)));
+			return;
+		}
+	}
+
+	connect_remote(host, port);
+}
+
+//------------------------------------------------------------------------------
+// Name: on_action_Disconnect_Remote_triggered
+// Desc:
+//------------------------------------------------------------------------------
+void Debugger::on_action_Disconnect_Remote_triggered() {
+	disconnect_remote();
+}
+
 //------------------------------------------------------------------------------
 // Name: on_action_Open_triggered
 // Desc:
@@ -2661,6 +3728,24 @@ void Debugger::on_action_Open_triggered() {
 	// TODO: we need a core concept of debugger capabilities which
 	// may restrict some actions
 
+	// the files of a remote machine can't be browsed from here
+	if(remote_debugger_) {
+		bool ok;
+		const QString filename = QInputDialog::getText(
+			this,
+			tr("Open on %1").arg(remote_debugger_->peer_name()),
+			tr("Path of the program on the remote machine:"),
+			QLineEdit::Normal,
+			QString(),
+			&ok);
+
+		if(ok && !filename.isEmpty()) {
+			detach_from_process(NO_KILL_ON_DETACH);
+			execute(filename, arguments_dialog_->arguments());
+		}
+		return;
+	}
+
 	const QString filename = QFileDialog::getOpenFileName(
 		this,
 		tr("Choose a file"),
@@ -2693,10 +3778,39 @@ void Debugger::on_action_Attach_triggered() {
 	delete dlg;
 }
 
+//------------------------------------------------------------------------------
+// Name: on_action_Save_Core_File_triggered
+// Desc: saves all of the memory and the registers of the process as an ELF
+//       core file
+//------------------------------------------------------------------------------
 //------------------------------------------------------------------------------
 // Name: on_action_Memory_Regions_triggered
 // Desc: displays the memory regions dialog, and optionally dumps some data
 //------------------------------------------------------------------------------
+void Debugger::on_action_Save_Core_File_triggered() {
+
+	const QString filename = QFileDialog::getSaveFileName(
+		this,
+		tr("Save Core File"),
+		last_open_directory_,
+		tr("Core Files (core*);;All Files (*)"));
+
+	if(!filename.isEmpty()) {
+		QString error;
+		QApplication::setOverrideCursor(Qt::WaitCursor);
+		const bool saved = CoreFile::save(filename, &error);
+		QApplication::restoreOverrideCursor();
+
+		if(!saved) {
+			QMessageBox::warning(this, tr("Error Saving Core File"), error);
+		}
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: on_action_Memory_Regions_triggered
+// Desc:
+//------------------------------------------------------------------------------
 void Debugger::on_action_Memory_Regions_triggered() {
 
 	// TODO: we need a core concept of debugger capabilities which
@@ -2855,6 +3969,7 @@ bool Debugger::dump_stack(edb::address_t address, bool scroll_to) {
 
 	if(stack_view_info_.region) {
 		stack_view_info_.update();
+		stack_comment_server_->set_changes(stack_view_info_.stream->changes());
 		
 		State state;
 		edb::v1::debugger_core->get_state(&state);
@@ -2901,83 +4016,377 @@ void Debugger::tab_context_menu(int index, const QPoint &pos) {
 
 //------------------------------------------------------------------------------
 // Name: next_debug_event
-// Desc:
+// Desc: handles whatever events the core has for us. When the core has an
+//       event_fd we are only called once it is readable, so there is no
+//       reason to sit and wait on the UI thread. Events which the process is
+//       resumed from are followed by any others which are already waiting,
+//       rather than each one going back through the event loop
 //------------------------------------------------------------------------------
 void Debugger::next_debug_event() {
 
-
-	// TODO(eteran): come up with a nice system to inject a debug event
-	//               into the system, for example on windows, we want
-	//               to deliver real "memory map updated" events, but
-	//               on linux, (at least for now), I would want to send
-	//               a fake one before every event so it is always up to
-	//               date.
+	EDB_TRACE_SCOPE("Debugger::next_debug_event");
 
 	Q_ASSERT(edb::v1::debugger_core);
 
-	if(IDebugEvent::const_pointer e = edb::v1::debugger_core->wait_debug_event(10)) {
+	const bool notified = event_notifier_ && event_notifier_->isEnabled();
+
+	QTime batch;
+	batch.start();
+
+	while(IDebugEvent::const_pointer e = edb::v1::debugger_core->wait_debug_event(notified ? 0 : 10)) {
+		if(!dispatch_debug_event(e) || !notified || batch.elapsed() >= event_batch_interval) {
+			break;
+		}
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: dispatch_debug_event
+// Desc: handles a single event, returns true if the process was resumed from
+//       it and is running again
+//------------------------------------------------------------------------------
+bool Debugger::dispatch_debug_event(const IDebugEvent::const_pointer &e) {
 
-		last_event_ = e;
+	static edb::diagnostics::Counter *const events = edb::diagnostics::counter("debug events");
+	edb::diagnostics::add(events);
+
+	last_event_ = e;
+
+	// only re-read the map when the core thinks it might be different, on
+	// linux this means that single steps which didn't make a syscall
+	// (and continues, when syscall tracking is enabled) are free. Even
+	// then, it isn't re-read until we actually stop, events which are
+	// resumed right away (conditions, tracing breakpoints, etc.) never
+	// touch the regions or the views
+	if(edb::v1::debugger_core->memory_map_changed()) {
+		regions_stale_ = true;
+	}
 
-		// TODO(eteran): figure out a way to do this less often, if they map an obscene
-		// number of regions, this really slows things down
-		edb::v1::memory_regions().sync();
+	// cores which see modules come and go say so themselves
+	QList<Module> loaded;
+	QList<Module> unloaded;
+	if(edb::v1::debugger_core->module_changes(&loaded, &unloaded) && (!loaded.isEmpty() || !unloaded.isEmpty())) {
+		modules_changed(loaded, unloaded);
+	}
 
-		// TODO(eteran): make the system use this information, this is huge! it will
-		// allow us to have restorable breakpoints...even in libraries!
 #if defined(Q_OS_UNIX) && !defined(Q_OS_MAC)
-		if(IProcess *process = edb::v1::debugger_core->process()) {
-			if(!debug_pointer_ && binary_info_) {
-				if((debug_pointer_ = binary_info_->debug_pointer()) != 0) {
-					r_debug dynamic_info;
-					const bool ok = process->read_bytes(debug_pointer_, &dynamic_info, sizeof(dynamic_info));
-					if(ok) {
-					#if 0
-						qDebug("READ DYNAMIC INFO! %p", dynamic_info.r_brk);
-					#endif
-					}
+	// the linker only fills in the debug pointer once it is running, after
+	// that a breakpoint on r_brk tells us about every dlopen/dlclose
+	if(!module_tracker_.attached() && binary_info_) {
+		if((debug_pointer_ = binary_info_->debug_pointer()) != 0) {
+			QList<Module> added;
+			if(module_tracker_.attach(debug_pointer_, &added)) {
+				if(IBreakpoint::pointer bp = edb::v1::debugger_core->add_breakpoint(module_tracker_.breakpoint_address())) {
+					bp->set_internal(true);
+					bp->tag = link_map_bp_tag;
 				}
-	
+				modules_changed(added, QList<Module>());
 			}
 		}
-	#if 0
-		qDebug("DEBUG POINTER: %p", debug_pointer_);
-	#endif
+	}
 #endif
 
-		const edb::EVENT_STATUS status = debug_event_handler(e);
-		switch(status) {
-		case edb::DEBUG_STOP:
-			update_gui();
-			update_menu_state(edb::v1::debugger_core->process() ? PAUSED : TERMINATED);
-			break;
-		case edb::DEBUG_CONTINUE:
-			resume_execution(IGNORE_EXCEPTION, MODE_RUN, true);
-			break;
-		case edb::DEBUG_CONTINUE_STEP:
-			resume_execution(IGNORE_EXCEPTION, MODE_STEP, true);
-			break;
-		case edb::DEBUG_EXCEPTION_NOT_HANDLED:
-			resume_execution(PASS_EXCEPTION, MODE_RUN, true);
-			break;
+	const edb::EVENT_STATUS status = debug_event_handler(e);
+	switch(status) {
+	case edb::DEBUG_STOP:
+		displaced_steps_.leave();
+		if(regions_stale_) {
+			edb::v1::memory_regions().sync();
+			regions_stale_ = false;
+		}
+		update_jit_symbols();
+		update_menu_state(edb::v1::debugger_core->process() ? PAUSED : TERMINATED);
+		schedule_update_gui();
+		return false;
+	case edb::DEBUG_CONTINUE:
+		resume_execution(IGNORE_EXCEPTION, MODE_RUN, true);
+		break;
+	case edb::DEBUG_CONTINUE_STEP:
+		resume_execution(IGNORE_EXCEPTION, MODE_STEP, true);
+		break;
+	case edb::DEBUG_EXCEPTION_NOT_HANDLED:
+		resume_execution(PASS_EXCEPTION, MODE_RUN, true);
+		break;
+	}
+
+	return edb::v1::debugger_core->process() != 0;
+}
+
+//------------------------------------------------------------------------------
+// Name: module_base
+// Desc: where <module> starts, its lowest mapping. Saving and restoring both
+//       go by this, so offsets are the same from one run to the next
+//------------------------------------------------------------------------------
+edb::address_t Debugger::module_base(const QString &module) const {
+
+	edb::address_t base = 0;
+	bool found          = false;
+
+	Q_FOREACH(const IRegion::pointer &region, edb::v1::memory_regions().regions()) {
+		if(region->name() == module && (!found || region->start() < base)) {
+			base  = region->start();
+			found = true;
+		}
+	}
+
+	return base;
+}
+
+//------------------------------------------------------------------------------
+// Name: session_location
+// Desc: which module <address> is in and how far into it, addresses outside
+//       of any file are kept as they are with no module
+//------------------------------------------------------------------------------
+bool Debugger::session_location(edb::address_t address, QString *module, edb::address_t *offset) const {
+
+	Q_ASSERT(module);
+	Q_ASSERT(offset);
+
+	const IRegion::pointer region = edb::v1::memory_regions().find_region(address);
+	if(!region) {
+		return false;
+	}
+
+	if(region->name().startsWith("/")) {
+		*module = region->name();
+		*offset = address - module_base(*module);
+	} else {
+		*module = QString();
+		*offset = address;
+	}
+
+	return true;
+}
+
+//------------------------------------------------------------------------------
+// Name: annotation_changed
+// Desc: the user changed a label, comment or bookmark, the session keeps it
+//       and it is written out right away
+//------------------------------------------------------------------------------
+void Debugger::annotation_changed(Annotations::Kind kind, edb::address_t address) {
+
+	if(!session_.is_open()) {
+		return;
+	}
+
+	QString module;
+	edb::address_t offset;
+	if(!session_location(address, &module, &offset)) {
+		return;
+	}
+
+	Session::Kind session_kind;
+	switch(kind) {
+	case Annotations::LABEL:    session_kind = Session::LABEL;    break;
+	case Annotations::COMMENT:  session_kind = Session::COMMENT;  break;
+	case Annotations::BOOKMARK: session_kind = Session::BOOKMARK; break;
+	default:
+		return;
+	}
+
+	const Annotations &annotations = edb::v1::annotations();
+	if(annotations.contains(kind, address)) {
+		session_.set(session_kind, module, offset, annotations.find(kind, address));
+	} else {
+		session_.remove(session_kind, module, offset);
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: apply_session
+// Desc: puts back what the session has for <module> once it is mapped, so
+//       only the modules which actually get loaded cost anything
+//------------------------------------------------------------------------------
+void Debugger::apply_session(const QString &module) {
+
+	if(!session_.is_open() || session_modules_.contains(module)) {
+		return;
+	}
+
+	const Session::Entries comments    = session_.entries(Session::COMMENT, module);
+	const Session::Entries labels      = session_.entries(Session::LABEL, module);
+	const Session::Entries bookmarks   = session_.entries(Session::BOOKMARK, module);
+	const Session::Entries breakpoints = session_.entries(Session::BREAKPOINT, module);
+
+	if(comments.isEmpty() && labels.isEmpty() && bookmarks.isEmpty() && breakpoints.isEmpty()) {
+		session_modules_.insert(module);
+		return;
+	}
+
+	edb::address_t base = 0;
+	if(!module.isEmpty()) {
+		if(regions_stale_) {
+			edb::v1::memory_regions().sync();
+			regions_stale_ = false;
+		}
+
+		base = module_base(module);
+		if(base == 0) {
+			// not mapped yet after all, try again next time
+			return;
+		}
+	}
+
+	session_modules_.insert(module);
+
+	// these go back in through the store as if they were being made, which
+	// the session already has and so doesn't write again
+	Annotations &annotations = edb::v1::annotations();
+
+	for(Session::Entries::const_iterator it = comments.begin(); it != comments.end(); ++it) {
+		annotations.set(Annotations::COMMENT, base + it.key(), it.value());
+	}
+
+	for(Session::Entries::const_iterator it = bookmarks.begin(); it != bookmarks.end(); ++it) {
+		annotations.set(Annotations::BOOKMARK, base + it.key(), it.value());
+	}
+
+	for(Session::Entries::const_iterator it = labels.begin(); it != labels.end(); ++it) {
+		edb::v1::symbol_manager().set_label(base + it.key(), it.value());
+	}
+
+	for(Session::Entries::const_iterator it = breakpoints.begin(); it != breakpoints.end(); ++it) {
+		const edb::address_t address = base + it.key();
+		if(!edb::v1::debugger_core->find_breakpoint(address)) {
+			if(IBreakpoint::pointer bp = edb::v1::debugger_core->add_breakpoint(address)) {
+				bp->condition = it.value();
+			}
 		}
 	}
 }
 
 //------------------------------------------------------------------------------
 // Name: save_session
-// Desc:
+// Desc: annotations were written as they were made, what is left is
+//       the breakpoints of the modules which were loaded, the pending
+//       breakpoints and the plugins' state. The file is then written out
+//       whole so that it loads as fast as it can next time
 //------------------------------------------------------------------------------
-void Debugger::save_session(const QString &session_file) {
-	Q_UNUSED(session_file);
+void Debugger::save_session() {
+
+	if(!session_.is_open()) {
+		return;
+	}
+
+	if(edb::v1::debugger_core && edb::v1::debugger_core->process()) {
+
+		// the breakpoints pending_breakpoints_ set are saved as what they were
+		// asked for, not where they ended up
+		QSet<edb::address_t> pending;
+		Q_FOREACH(const PendingBreakpoints::Breakpoint &breakpoint, pending_breakpoints_.breakpoints()) {
+			if(breakpoint.address) {
+				pending.insert(breakpoint.address);
+			}
+		}
+
+		// every module which was loaded has its breakpoints replaced, the
+		// ones which weren't keep what they had
+		QHash<QString, Session::Entries> breakpoints;
+		Q_FOREACH(const QString &module, session_modules_) {
+			breakpoints[module];
+		}
+
+		Q_FOREACH(const IBreakpoint::pointer &bp, edb::v1::debugger_core->backup_breakpoints()) {
+			if(bp->internal() || bp->one_time() || pending.contains(bp->address())) {
+				continue;
+			}
+
+			QString module;
+			edb::address_t offset;
+			if(session_location(bp->address(), &module, &offset)) {
+				breakpoints[module].insert(offset, bp->condition);
+			}
+		}
+
+		for(QHash<QString, Session::Entries>::const_iterator it = breakpoints.begin(); it != breakpoints.end(); ++it) {
+			session_.set_entries(Session::BREAKPOINT, it.key(), it.value());
+		}
+	}
+
+	QByteArray state;
+	QDataStream out(&state, QIODevice::WriteOnly);
+	out.setVersion(QDataStream::Qt_4_6);
+	Q_FOREACH(const PendingBreakpoints::Breakpoint &breakpoint, pending_breakpoints_.breakpoints()) {
+		out << breakpoint.text << breakpoint.condition;
+	}
+	session_.set_state("PendingBreakpoints", state);
+
+	Q_FOREACH(QObject *plugin, edb::v1::plugin_list()) {
+		if(IPlugin *const p = qobject_cast<IPlugin *>(plugin)) {
+			session_.set_state(QString("plugin/%1").arg(plugin->metaObject()->className()), p->save_state());
+		}
+	}
+
+	session_.save();
+	session_.close();
+	session_modules_.clear();
 }
 
 //------------------------------------------------------------------------------
 // Name: load_session
-// Desc:
+// Desc: only reads the file, what is in it is put back a module at a time as
+//       each one is mapped
 //------------------------------------------------------------------------------
 void Debugger::load_session(const QString &session_file) {
-	Q_UNUSED(session_file);
+
+	pending_breakpoints_.clear();
+
+	const bool existed = QFile::exists(session_file);
+	if(!session_.open(session_file, edb::v1::get_file_md5(program_executable_))) {
+		return;
+	}
+
+	if(!existed) {
+		// sessions used to be kept by file name only, in a settings file
+		const QFileInfo info(program_executable_);
+		load_legacy_session(QString(QLatin1String("%1/%2.edb")).arg(QFileInfo(session_file).absolutePath(), info.fileName()));
+	} else {
+		QDataStream in(session_.state("PendingBreakpoints"));
+		in.setVersion(QDataStream::Qt_4_6);
+		while(!in.atEnd()) {
+			QString text;
+			QString condition;
+			in >> text >> condition;
+			if(in.status() != QDataStream::Ok) {
+				break;
+			}
+			pending_breakpoints_.add(text, condition);
+		}
+	}
+
+	Q_FOREACH(QObject *plugin, edb::v1::plugin_list()) {
+		if(IPlugin *const p = qobject_cast<IPlugin *>(plugin)) {
+			const QByteArray state = session_.state(QString("plugin/%1").arg(plugin->metaObject()->className()));
+			if(!state.isEmpty()) {
+				p->restore_state(state);
+			}
+		}
+	}
+
+	// what isn't in any module, and the program itself, which is already
+	// mapped. Libraries follow as the linker loads them
+	apply_session(QString());
+	apply_session(program_executable_);
+}
+
+//------------------------------------------------------------------------------
+// Name: load_legacy_session
+// Desc: the pending breakpoints of an old style session, if there is one
+//------------------------------------------------------------------------------
+void Debugger::load_legacy_session(const QString &session_file) {
+
+	if(!QFile::exists(session_file)) {
+		return;
+	}
+
+	QSettings settings(session_file, QSettings::IniFormat);
+
+	const int count = settings.beginReadArray("PendingBreakpoints");
+	for(int i = 0; i < count; ++i) {
+		settings.setArrayIndex(i);
+		pending_breakpoints_.add(settings.value("location").toString(), settings.value("condition").toString());
+	}
+	settings.endArray();
 }
 
 //------------------------------------------------------------------------------
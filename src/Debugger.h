@@ -19,19 +19,32 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #ifndef DEBUGGERMAIN_20090811_H_
 #define DEBUGGERMAIN_20090811_H_
 
+#include "Annotations.h"
 #include "DataViewInfo.h"
 #include "Debugger.h"
+#include "DisplacedSteps.h"
 #include "IDebugEventHandler.h"
+#include "JitSymbols.h"
+#include "MemoryBreakpoints.h"
+#include "Module.h"
+#include "ModuleTracker.h"
+#include "PendingBreakpoints.h"
 #include "QHexView"
+#include "Session.h"
+#include "StopSnapshot.h"
 #include "edb.h"
 
+class CommentServer;
+class CoreFileDebugger;
 class DialogArguments;
 class IBinary;
 class IBreakpoint;
 class IDebugEvent;
 class IPlugin;
 class RecentFileManager;
+class RemoteDebugger;
 
+class QSocketNotifier;
 class QStringListModel;
 class QTimer;
 class QToolButton;
@@ -42,8 +55,10 @@ class QDropEvent;
 
 #include <QMainWindow>
 #include <QProcess>
+#include <QTime>
 #include <QVector>
 #include <QScopedPointer>
+#include <QSet>
 
 #include <cstring>
 
@@ -90,9 +105,16 @@ public:
 	bool dump_stack(edb::address_t address, bool scroll_to);
 	bool jump_to_address(edb::address_t address);
 	int current_tab() const;
+	QList<Module> loaded_modules() const;
+	PendingBreakpoints &pending_breakpoints() { return pending_breakpoints_; }
+	StopSnapshot::pointer snapshot() const { return snapshot_; }
+	const MemoryBreakpoints &memory_breakpoints() const { return memory_breakpoints_; }
 	void attach(edb::pid_t pid);
 	void clear_data(const DataViewInfo::pointer &v);
+	void connect_remote(const QString &host, quint16 port);
+	void disconnect_remote();
 	void execute(const QString &s, const QList<QByteArray> &args);
+	void open_core(const QString &filename);
 	void refresh_gui();
 	void update_data(const DataViewInfo::pointer &v);
 	void update_gui();
@@ -107,16 +129,21 @@ public Q_SLOTS:
 	void on_actionApplication_Arguments_triggered();
 	void on_actionApplication_Working_Directory_triggered();
 	void on_actionRun_Until_Return_triggered();
+	void on_actionStep_Into_Until_triggered();
 	void on_action_About_triggered();
 	void on_action_Attach_triggered();
 	void on_action_Configure_Debugger_triggered();
+	void on_action_Connect_Remote_triggered();
 	void on_action_Detach_triggered();
+	void on_action_Disconnect_Remote_triggered();
 	void on_action_Kill_triggered();
 	void on_action_Memory_Regions_triggered();
+	void on_action_Open_Core_File_triggered();
 	void on_action_Open_triggered();
 	void on_action_Pause_triggered();
 	void on_action_Plugins_triggered();
 	void on_action_Restart_triggered();
+	void on_action_Save_Core_File_triggered();
 	void on_action_Run_Pass_Signal_To_Application_triggered();
 	void on_action_Run_triggered();
 	void on_action_Step_Into_Pass_Signal_To_Application_triggered();
@@ -178,6 +205,12 @@ private Q_SLOTS:
 	void mnuDumpGotoAddress();
 	void mnuDumpModify();
 	void mnuDumpSaveToFile();
+	void mnuDumpBreakOnAccess()  { add_memory_breakpoint(MemoryBreakpoints::ACCESS); }
+	void mnuDumpBreakOnWrite()   { add_memory_breakpoint(MemoryBreakpoints::WRITE); }
+	void mnuDumpRemoveMemoryBreakpoints();
+	void mnuDumpOverlayStructure()        { overlay_structure(qobject_cast<QHexView *>(ui.tabWidget->currentWidget())); }
+	void mnuDumpFollowStructurePointer()  { follow_structure_pointer(qobject_cast<QHexView *>(ui.tabWidget->currentWidget())); }
+	void mnuDumpRemoveStructureOverlay()  { remove_structure_overlay(qobject_cast<QHexView *>(ui.tabWidget->currentWidget())); }
 
 private Q_SLOTS:
 	// the manually connected Stack slots
@@ -192,11 +225,19 @@ private Q_SLOTS:
 	void mnuStackPop();
 	void mnuStackPush();
 	void mnuStackToggleLock(bool locked);
+	void mnuStackOverlayStructure()       { overlay_structure(stack_view_.data()); }
+	void mnuStackFollowStructurePointer() { follow_structure_pointer(stack_view_.data()); }
+	void mnuStackRemoveStructureOverlay() { remove_structure_overlay(stack_view_.data()); }
 
 private Q_SLOTS:
+	void annotation_changed(Annotations::Kind kind, edb::address_t address);
+	void deferred_update_gui();
 	void goto_triggered();
 	void next_debug_event();
 	void open_file(const QString &s);
+	void populate_process_menu();
+	void process_selected(QAction *action);
+	void startup_finished();
 	void tab_context_menu(int index, const QPoint &pos);
 	void tty_proc_finished(int exit_code, QProcess::ExitStatus exit_status);
 
@@ -211,18 +252,24 @@ public:
 
 private:
 	IRegion::pointer update_cpu_view(const State &state);
+	QStringList instruction_info(const State &state) const;
 	QString create_tty();
 	QString session_filename() const;
 	bool breakpoint_condition_true(const QString &condition);
 	bool common_open(const QString &s, const QList<QByteArray> &args);
 	edb::EVENT_STATUS debug_event_handler(const IDebugEvent::const_pointer &event);
+	bool dispatch_debug_event(const IDebugEvent::const_pointer &event);
 	edb::EVENT_STATUS handle_event_exited(const IDebugEvent::const_pointer &event);
 	edb::EVENT_STATUS handle_event_stopped(const IDebugEvent::const_pointer &event);
 	edb::EVENT_STATUS handle_event_terminated(const IDebugEvent::const_pointer &event);
 	edb::EVENT_STATUS handle_trap();
+	void modules_changed(const QList<Module> &added, const QList<Module> &removed);
+	void update_jit_symbols();
+	void report_overwritten_breakpoints();
 	edb::EVENT_STATUS resume_status(bool pass_exception);
 	edb::address_t get_goto_expression(bool *ok);
 	edb::reg_t get_follow_register(bool *ok) const;
+	void add_memory_breakpoint(MemoryBreakpoints::Type type);
 	void apply_default_fonts();
 	void apply_default_show_separator();
 	void cleanup_debugger();
@@ -234,9 +281,14 @@ private:
 	void finish_plugin_setup();
 	void follow_register_in_dump(bool tabbed);
 	void load_session(const QString &session_file);
+	void load_legacy_session(const QString &session_file);
+	void apply_session(const QString &module);
+	bool session_location(edb::address_t address, QString *module, edb::address_t *offset) const;
+	edb::address_t module_base(const QString &module) const;
 	void resume_execution(EXCEPTION_RESUME pass_exception, DEBUG_MODE mode);
 	void resume_execution(EXCEPTION_RESUME pass_exception, DEBUG_MODE mode, bool forced);
-	void save_session(const QString &session_file);
+	void save_session();
+	void schedule_update_gui();
 	void set_debugger_caption(const QString &appname);
 	void set_initial_breakpoint(const QString &s);
 	void set_initial_debugger_state();
@@ -245,7 +297,7 @@ private:
 	void setup_ui();
 	void test_native_binary();
 	void update_data_views();
-	void update_disassembly(edb::address_t address, const IRegion::pointer &r);
+	void update_disassembly(const State &state, const IRegion::pointer &r);
 	void update_menu_state(GUI_STATE state);
 	void update_stack_view(const State &state);
 	void update_tab_caption(const QSharedPointer<QHexView> &view, edb::address_t start, edb::address_t end);
@@ -272,6 +324,12 @@ private:
 
 	template <class T>
 	void modify_bytes(const T &hexview);
+
+private:
+	CommentServer *comment_server(QHexView *view, bool create);
+	void overlay_structure(QHexView *view);
+	void follow_structure_pointer(QHexView *view);
+	void remove_structure_overlay(QHexView *view);
 	
 	template <class F1, class F2>
 	void step_over(F1 run_func, F2 step_func);
@@ -291,9 +349,14 @@ private:
 	QStringListModel *                               list_model_;
 	DialogArguments *                                arguments_dialog_;
 	QTimer *                                         timer_;
+	QTimer *                                         gui_update_timer_;
+	QTime                                            last_gui_update_;
+	QSocketNotifier *                                event_notifier_;
 	RecentFileManager *                              recent_file_manager_;
 
-	QSharedPointer<QHexView::CommentServerInterface> stack_comment_server_;
+	QSharedPointer<CommentServer>                    stack_comment_server_;
+	Session                                          session_;
+	QSet<QString>                                    session_modules_;
 	IBreakpoint::pointer                             reenable_breakpoint_run_;
 	IBreakpoint::pointer                             reenable_breakpoint_step_;
 	QScopedPointer<IBinary>                          binary_info_;
@@ -302,7 +365,21 @@ private:
 	QString                                          working_directory_;
 	QString                                          program_executable_;
 	bool                                             stack_view_locked_;
+	bool                                             restarting_;    // the caches of the old process are kept for the new one
 	IDebugEvent::const_pointer                       last_event_;
+	StopSnapshot::pointer                            snapshot_;      // what the views show, null while running
+	quint64                                          snapshot_count_;
+	bool                                             regions_stale_; // the memory map changed since the last sync
+	MemoryBreakpoints                                memory_breakpoints_;
+	DisplacedSteps                                   displaced_steps_;
+	DEBUG_MODE                                       resume_mode_;   // what the user last asked for, run or step
+	int                                              step_until_count_;
+	QString                                          step_until_condition_;
+	ModuleTracker                                    module_tracker_;
+	JitSymbols                                       jit_symbols_;
+	PendingBreakpoints                               pending_breakpoints_;
+	QScopedPointer<CoreFileDebugger>                 core_file_debugger_; // installed as the core while a core file is open
+	QScopedPointer<RemoteDebugger>                   remote_debugger_;    // installed as the core while connected to a stub
 #ifdef Q_OS_UNIX
 	edb::address_t                                   debug_pointer_;
 #endif
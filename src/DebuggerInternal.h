@@ -19,15 +19,24 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #ifndef DEBUGGER_INTERNAL_20100301_H_
 #define DEBUGGER_INTERNAL_20100301_H_
 
+class LazyPlugin;
 class QString;
 class QObject;
 
+template <class T> class QList;
+
 // these are global utility functions which are not part of the exported API
 
 namespace edb {
 namespace internal {
 	bool register_plugin(const QString &filename, QObject *plugin);
-	void load_function_db();
+	bool register_lazy_plugin(LazyPlugin *plugin);
+	const QList<LazyPlugin *> &lazy_plugins();
+
+	// set EDB_PROFILE_STARTUP to have each step of startup timed
+	void start_startup_profile();
+	bool profiling_startup();
+	void startup_mark(const QString &what);
 }
 }
 
@@ -0,0 +1,197 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Diagnostics.h"
+#include "TimedSlot.h"
+#include "edb.h"
+#include "version.h"
+
+#include <QHash>
+#include <QStringList>
+
+#include <algorithm>
+
+#if defined(Q_OS_WIN)
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+namespace {
+
+QHash<QString, edb::diagnostics::Counter *> g_Counters;
+
+//------------------------------------------------------------------------------
+// Name: find_or_create
+// Desc:
+//------------------------------------------------------------------------------
+edb::diagnostics::Counter *find_or_create(const QString &name, bool timing) {
+
+	edb::diagnostics::Counter *&counter = g_Counters[name];
+	if(!counter) {
+		counter = new edb::diagnostics::Counter;
+		counter->name   = name;
+		counter->timing = timing;
+		counter->count  = 0;
+		counter->total  = 0;
+		counter->max    = 0;
+	}
+
+	return counter;
+}
+
+//------------------------------------------------------------------------------
+// Name: counter_less
+// Desc:
+//------------------------------------------------------------------------------
+bool counter_less(const edb::diagnostics::Counter *lhs, const edb::diagnostics::Counter *rhs) {
+	return lhs->name < rhs->name;
+}
+
+}
+
+//------------------------------------------------------------------------------
+// Name: TimedSlot
+// Desc: <member> is as given to SLOT()
+//------------------------------------------------------------------------------
+TimedSlot::TimedSlot(const QString &signal, QObject *receiver, const char *member) : QObject(receiver),
+	counter_(edb::diagnostics::timer(QString("%1: %2::%3").arg(signal, receiver->metaObject()->className(), QString::fromLatin1(member + 1)))) {
+
+	setObjectName(QString::fromLatin1(member));
+	connect(this, SIGNAL(triggered()), receiver, member);
+}
+
+//------------------------------------------------------------------------------
+// Name: trigger
+// Desc:
+//------------------------------------------------------------------------------
+void TimedSlot::trigger() {
+	edb::diagnostics::ScopedTimer timer(counter_);
+	Q_EMIT triggered();
+}
+
+namespace edb {
+namespace diagnostics {
+
+//------------------------------------------------------------------------------
+// Name: counter
+// Desc: the counter called <name>, created the first time it is asked for
+//------------------------------------------------------------------------------
+Counter *counter(const QString &name) {
+	return find_or_create(name, false);
+}
+
+//------------------------------------------------------------------------------
+// Name: timer
+// Desc: like counter, for amounts which are nanoseconds
+//------------------------------------------------------------------------------
+Counter *timer(const QString &name) {
+	return find_or_create(name, true);
+}
+
+//------------------------------------------------------------------------------
+// Name: counters
+// Desc: all of them, by name
+//------------------------------------------------------------------------------
+QList<const Counter *> counters() {
+
+	QList<const Counter *> ret;
+	Q_FOREACH(const Counter *counter, g_Counters) {
+		ret.push_back(counter);
+	}
+
+	std::sort(ret.begin(), ret.end(), counter_less);
+	return ret;
+}
+
+//------------------------------------------------------------------------------
+// Name: reset
+// Desc: zeroes every counter, they stay where they are
+//------------------------------------------------------------------------------
+void reset() {
+	Q_FOREACH(Counter *counter, g_Counters) {
+		counter->count = 0;
+		counter->total = 0;
+		counter->max   = 0;
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: to_json
+// Desc: every counter which has counted something
+//------------------------------------------------------------------------------
+QByteArray to_json() {
+
+	QStringList entries;
+	Q_FOREACH(const Counter *counter, counters()) {
+		if(counter->count != 0) {
+			entries.push_back(QString("\t\t{ \"name\": %1, \"timing\": %2, \"count\": %3, \"total\": %4, \"max\": %5 }")
+				.arg(edb::v1::json_string(counter->name))
+				.arg(counter->timing ? "true" : "false")
+				.arg(counter->count)
+				.arg(counter->total)
+				.arg(counter->max));
+		}
+	}
+
+	return QString("{\n\t\"edb_version\": %1,\n\t\"counters\": [\n%2\n\t]\n}\n").arg(edb::v1::json_string(edb::version), entries.join(",\n")).toUtf8();
+}
+
+//------------------------------------------------------------------------------
+// Name: nsecs
+// Desc: a monotonic clock, in nanoseconds from some point in the past
+//------------------------------------------------------------------------------
+quint64 nsecs() {
+#if defined(Q_OS_WIN)
+	static LARGE_INTEGER frequency;
+	if(frequency.QuadPart == 0) {
+		QueryPerformanceFrequency(&frequency);
+	}
+
+	LARGE_INTEGER now;
+	QueryPerformanceCounter(&now);
+	return static_cast<quint64>(now.QuadPart / frequency.QuadPart) * 1000000000 + static_cast<quint64>(now.QuadPart % frequency.QuadPart) * 1000000000 / frequency.QuadPart;
+#else
+	timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return static_cast<quint64>(now.tv_sec) * 1000000000 + now.tv_nsec;
+#endif
+}
+
+//------------------------------------------------------------------------------
+// Name: connect_gui_updated
+// Desc:
+//------------------------------------------------------------------------------
+void connect_gui_updated(QObject *receiver, const char *member) {
+	TimedSlot *const slot = new TimedSlot("gui_updated", receiver, member);
+	QObject::connect(edb::v1::debugger_ui, SIGNAL(gui_updated()), slot, SLOT(trigger()));
+}
+
+//------------------------------------------------------------------------------
+// Name: disconnect_gui_updated
+// Desc: the slot may be the one running, so it is only deleted later
+//------------------------------------------------------------------------------
+void disconnect_gui_updated(QObject *receiver, const char *member) {
+	Q_FOREACH(TimedSlot *slot, receiver->findChildren<TimedSlot *>(QString::fromLatin1(member))) {
+		QObject::disconnect(edb::v1::debugger_ui, 0, slot, 0);
+		slot->deleteLater();
+	}
+}
+
+}
+}
@@ -24,6 +24,8 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <QMap>
 #include <QHeaderView>
+#include <QMutexLocker>
+#include <QRunnable>
 #include <QSortFilterProxyModel>
 
 #include "ui_DialogAttach.h"
@@ -40,13 +42,48 @@ int getuid() {
 #include <unistd.h>
 #endif
 
+namespace {
+
+// runs stream_processes on the dialog's pool and posts each batch back to the
+// UI thread as it comes in
+class ListProcesses : public QRunnable, public IDebugger::ProcessSink {
+public:
+	ListProcesses(DialogAttach *dialog, int request) : dialog_(dialog), request_(request) {
+	}
+
+public:
+	virtual void run() {
+		if(edb::v1::debugger_core) {
+			edb::v1::debugger_core->stream_processes(this);
+		}
+	}
+
+	virtual bool found(const QList<ProcessInfo> &processes) {
+		if(!dialog_->is_current(request_)) {
+			return false;
+		}
+
+		QMetaObject::invokeMethod(dialog_, "add_processes", Qt::QueuedConnection, Q_ARG(QList<ProcessInfo>, processes), Q_ARG(int, request_));
+		return true;
+	}
+
+private:
+	DialogAttach *const dialog_;
+	const int           request_;
+};
+
+}
+
 //------------------------------------------------------------------------------
 // Name: DialogAttach
 // Desc: constructor
 //------------------------------------------------------------------------------
-DialogAttach::DialogAttach(QWidget *parent) : QDialog(parent), ui(new Ui::DialogAttach) {
+DialogAttach::DialogAttach(QWidget *parent) : QDialog(parent), ui(new Ui::DialogAttach), request_(0) {
 	ui->setupUi(this);
 
+	qRegisterMetaType<QList<ProcessInfo> >("QList<ProcessInfo>");
+	list_pool_.setMaxThreadCount(1);
+
 	process_model_ = new ProcessModel(this);
 	process_filter_ = new QSortFilterProxyModel(this);
 
@@ -64,29 +101,73 @@ DialogAttach::DialogAttach(QWidget *parent) : QDialog(parent), ui(new Ui::Dialog
 // Desc:
 //------------------------------------------------------------------------------
 DialogAttach::~DialogAttach() {
+
+	// stop a listing which is still going, the batches it already posted are
+	// dropped along with the dialog
+	{
+		QMutexLocker locker(&request_lock_);
+		++request_;
+	}
+	list_pool_.waitForDone();
+
 	delete ui;
 }
 
 //------------------------------------------------------------------------------
 // Name: update_list
-// Desc:
+// Desc: starts listing the processes, they show up as they are found
 //------------------------------------------------------------------------------
 void DialogAttach::update_list() {
 
 	process_model_->clear();
 
 	if(edb::v1::debugger_core) {
-		QMap<edb::pid_t, ProcessInfo> procs = edb::v1::debugger_core->enumerate_processes();
+		int request;
+		{
+			QMutexLocker locker(&request_lock_);
+			request = ++request_;
+		}
 
-		const edb::uid_t user_id = getuid();
-		const bool filterUID = ui->filter_uid->isChecked();
+		list_pool_.start(new ListProcesses(this, request));
+	}
+}
 
-		Q_FOREACH(const ProcessInfo &process_info, procs) {
-			if(!filterUID || process_info.uid == user_id) {
-				process_model_->addProcess(process_info);
-			}
+//------------------------------------------------------------------------------
+// Name: is_current
+// Desc: true if <request> is the latest listing asked for, called from the
+//       listing's thread
+//------------------------------------------------------------------------------
+bool DialogAttach::is_current(int request) const {
+	QMutexLocker locker(&request_lock_);
+	return request == request_;
+}
+
+//------------------------------------------------------------------------------
+// Name: add_processes
+// Desc: a batch from a listing, ones from a listing which has been replaced
+//       since are ignored
+//------------------------------------------------------------------------------
+void DialogAttach::add_processes(const QList<ProcessInfo> &processes, int request) {
+
+	if(!is_current(request)) {
+		return;
+	}
+
+	if(!ui->filter_uid->isChecked()) {
+		process_model_->addProcesses(processes);
+		return;
+	}
+
+	const edb::uid_t user_id = getuid();
+
+	QList<ProcessInfo> mine;
+	Q_FOREACH(const ProcessInfo &process_info, processes) {
+		if(process_info.uid == user_id) {
+			mine.push_back(process_info);
 		}
 	}
+
+	process_model_->addProcesses(mine);
 }
 
 //------------------------------------------------------------------------------
@@ -19,8 +19,12 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #ifndef DIALOG_ATTACH_20091218_H_
 #define DIALOG_ATTACH_20091218_H_
 
+#include "ProcessInfo.h"
 #include "Types.h"
 #include <QDialog>
+#include <QList>
+#include <QMutex>
+#include <QThreadPool>
 
 class ProcessModel;
 class QSortFilterProxyModel;
@@ -43,13 +47,23 @@ private:
 public Q_SLOTS:
 	void on_filter_uid_clicked(bool checked);
 
+private Q_SLOTS:
+	void add_processes(const QList<ProcessInfo> &processes, int request);
+
 public:
 	edb::pid_t selected_pid(bool *ok) const;
+	bool is_current(int request) const;
 
 private:
 	Ui::DialogAttach *const ui;
 	ProcessModel          *process_model_;
 	QSortFilterProxyModel *process_filter_;
+
+	// the processes are listed on a thread of their own, one listing at a
+	// time, and a listing stops once a newer one has been asked for
+	QThreadPool            list_pool_;
+	mutable QMutex         request_lock_;
+	int                    request_;
 };
 
 #endif
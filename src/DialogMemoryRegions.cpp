@@ -17,10 +17,12 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
 #include "DialogMemoryRegions.h"
+#include "ContentMap.h"
 #include "IDebugger.h"
 #include "edb.h"
 #include "MemoryRegions.h"
 
+#include <QApplication>
 #include <QHeaderView>
 #include <QString>
 #include <QMenu>
@@ -38,13 +40,9 @@ DialogMemoryRegions::DialogMemoryRegions(QWidget *parent) : QDialog(parent), ui(
 	ui->setupUi(this);
 
 	ui->regions_table->verticalHeader()->hide();
-#if QT_VERSION >= 0x050000
-	ui->regions_table->horizontalHeader()->setSectionResizeMode(QHeaderView::ResizeToContents);
-#else
-	ui->regions_table->horizontalHeader()->setResizeMode(QHeaderView::ResizeToContents);
-#endif
 	filter_model_ = new QSortFilterProxyModel(this);
 	connect(ui->filter, SIGNAL(textChanged(const QString &)), filter_model_, SLOT(setFilterFixedString(const QString &)));
+	connect(&edb::v1::memory_regions(), SIGNAL(dataChanged(const QModelIndex &, const QModelIndex &)), this, SLOT(update_total_usage()));
 }
 
 //------------------------------------------------------------------------------
@@ -64,6 +62,30 @@ void DialogMemoryRegions::showEvent(QShowEvent *) {
 	filter_model_->setFilterKeyColumn(3);
 	filter_model_->setSourceModel(&edb::v1::memory_regions());
 	ui->regions_table->setModel(filter_model_);
+
+	// sized once rather than kept fitted to the contents, which would look at
+	// every row each time any of them changed
+	ui->regions_table->resizeColumnsToContents();
+
+	update_total_usage();
+}
+
+//------------------------------------------------------------------------------
+// Name: update_total_usage
+// Desc: how much of the whole process is in RAM
+//------------------------------------------------------------------------------
+void DialogMemoryRegions::update_total_usage() {
+
+	if(!isVisible()) {
+		return;
+	}
+
+	MemoryUsage usage;
+	if(edb::v1::debugger_core && edb::v1::debugger_core->total_memory_usage(&usage)) {
+		ui->usage_label->setText(tr("Total RSS: %1 KiB, PSS: %2 KiB").arg(usage.resident / 1024).arg(usage.proportional / 1024));
+	} else {
+		ui->usage_label->clear();
+	}
 }
 
 //------------------------------------------------------------------------------
@@ -223,3 +245,31 @@ void DialogMemoryRegions::on_regions_table_doubleClicked(const QModelIndex &inde
 	}
 }
 
+
+//------------------------------------------------------------------------------
+// Name: on_map_button_clicked
+// Desc: maps the entropy and content of every readable page
+//------------------------------------------------------------------------------
+void DialogMemoryRegions::on_map_button_clicked() {
+
+	if(!edb::v1::debugger_core || !edb::v1::debugger_core->process()) {
+		ui->content_map->clear();
+		return;
+	}
+
+	QApplication::setOverrideCursor(Qt::WaitCursor);
+
+	ContentMap map(edb::v1::debugger_core->page_size());
+	map.run(edb::v1::memory_regions().regions());
+	ui->content_map->setPages(map.pages());
+
+	QApplication::restoreOverrideCursor();
+}
+
+//------------------------------------------------------------------------------
+// Name: on_content_map_pageClicked
+// Desc:
+//------------------------------------------------------------------------------
+void DialogMemoryRegions::on_content_map_pageClicked(edb::address_t address) {
+	edb::v1::dump_data(address, true);
+}
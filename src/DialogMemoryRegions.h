@@ -39,6 +39,9 @@ private:
 private Q_SLOTS:
 	void on_regions_table_customContextMenuRequested(const QPoint &pos);
 	void on_regions_table_doubleClicked(const QModelIndex &index);
+	void on_map_button_clicked();
+	void on_content_map_pageClicked(edb::address_t address);
+	void update_total_usage();
 	void set_access_none();
 	void set_access_r();
 	void set_access_w();
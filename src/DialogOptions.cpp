@@ -149,6 +149,18 @@ void DialogOptions::on_btnPluginDir_clicked() {
 	}
 }
 
+//------------------------------------------------------------------------------
+// Name: on_btnStructuresFile_clicked
+// Desc:
+//------------------------------------------------------------------------------
+void DialogOptions::on_btnStructuresFile_clicked() {
+	const QString s = QFileDialog::getOpenFileName(this, tr("Choose Your Structure Definitions"), ui->txtStructuresFile->text(), tr("C Headers (*.h);;All Files (*)"));
+
+	if(!s.isEmpty()) {
+		ui->txtStructuresFile->setText(s);
+	}
+}
+
 //------------------------------------------------------------------------------
 // Name: showEvent
 // Desc:
@@ -173,11 +185,13 @@ void DialogOptions::showEvent(QShowEvent *event) {
 
 	ui->chkZerosAreFilling->setChecked(config.zeros_are_filling);
 	ui->chkUppercase->setChecked(config.uppercase_disassembly);
+	ui->chkCodeSectionsOnly->setChecked(config.scan_code_sections_only);
 
 	ui->chkFindMain->setChecked(config.find_main);
 	ui->chkWarnDataBreakpoint->setChecked(config.warn_on_no_exec_bp);
 
 	ui->spnMinString->setValue(config.min_string_length);
+	ui->spnMemoryBudget->setValue(config.memory_budget);
 
 	ui->stackFont->setCurrentFont(config.stack_font);
 	ui->dataFont->setCurrentFont(config.data_font);
@@ -187,6 +201,7 @@ void DialogOptions::showEvent(QShowEvent *event) {
 	ui->txtSymbolDir->setText(config.symbol_path);
 	ui->txtPluginDir->setText(config.plugin_path);
 	ui->txtSessionDir->setText(config.session_path);
+	ui->txtStructuresFile->setText(config.structures_file);
 
 	ui->chkDataShowAddress->setChecked(config.data_show_address);
 	ui->chkDataShowHex->setChecked(config.data_show_hex);
@@ -227,9 +242,12 @@ void DialogOptions::closeEvent(QCloseEvent *event) {
 	config.zeros_are_filling     = ui->chkZerosAreFilling->isChecked();
 	config.uppercase_disassembly = ui->chkUppercase->isChecked();
 
+	config.scan_code_sections_only = ui->chkCodeSectionsOnly->isChecked();
+
 	config.symbol_path           = ui->txtSymbolDir->text();
 	config.plugin_path           = ui->txtPluginDir->text();
 	config.session_path          = ui->txtSessionDir->text();
+	config.structures_file       = ui->txtStructuresFile->text();
 
 	if(ui->rdoBPMain->isChecked()) {
 		config.initial_breakpoint = Configuration::MainSymbol;
@@ -243,6 +261,7 @@ void DialogOptions::closeEvent(QCloseEvent *event) {
 	config.show_address_separator = ui->chkAddressSemicolon->isChecked();
 
 	config.min_string_length      = ui->spnMinString->value();
+	config.memory_budget          = ui->spnMemoryBudget->value();
 
 	config.data_show_address  = ui->chkDataShowAddress->isChecked();
 	config.data_show_hex      = ui->chkDataShowHex->isChecked();
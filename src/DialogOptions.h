@@ -36,6 +36,7 @@ public Q_SLOTS:
 	void on_btnPluginDir_clicked();
 	void on_btnTTY_clicked();
 	void on_btnSessionDir_clicked();
+	void on_btnStructuresFile_clicked();
 	void closeEvent(QCloseEvent *event);
 	void accept();
 
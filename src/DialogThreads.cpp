@@ -17,6 +17,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
 #include "DialogThreads.h"
+#include "Diagnostics.h"
 #include "IDebugger.h"
 #include "ThreadsModel.h"
 #include "edb.h"
@@ -40,6 +41,8 @@ DialogThreads::DialogThreads(QWidget *parent, Qt::WindowFlags f) : QDialog(paren
 	threads_filter_->setFilterCaseSensitivity(Qt::CaseInsensitive);
 	
 	ui->thread_table->setModel(threads_filter_);
+
+	edb::diagnostics::connect_gui_updated(this, SLOT(update_threads()));
 }
 
 //------------------------------------------------------------------------------
@@ -55,24 +58,22 @@ DialogThreads::~DialogThreads() {
 // Desc:
 //------------------------------------------------------------------------------
 void DialogThreads::showEvent(QShowEvent *) {
+	update_threads();
+	ui->thread_table->horizontalHeader()->resizeSections(QHeaderView::Stretch);
+}
 
-	threads_model_->clear();
-
-	QList<edb::tid_t> threads       = edb::v1::debugger_core->thread_ids();
-	const edb::tid_t current_thread = edb::v1::debugger_core->active_thread();
-
-	Q_FOREACH(edb::tid_t thread, threads) {
-	
-		const ThreadInfo info = edb::v1::debugger_core->get_thread_info(thread);
-	
-		if(thread == current_thread) {
-			threads_model_->addThread(info, true);
+//------------------------------------------------------------------------------
+// Name: update_threads
+// Desc: called whenever the process stops while the list is showing
+//------------------------------------------------------------------------------
+void DialogThreads::update_threads() {
+	if(isVisible()) {
+		if(const StopSnapshot::pointer snapshot = edb::v1::stop_snapshot()) {
+			threads_model_->sync(snapshot->threads, snapshot->active_thread);
 		} else {
-			threads_model_->addThread(info, false);
+			threads_model_->sync(edb::v1::debugger_core->thread_ids(), edb::v1::debugger_core->active_thread());
 		}
 	}
-	
-	ui->thread_table->horizontalHeader()->resizeSections(QHeaderView::Stretch);
 }
 
 //------------------------------------------------------------------------------
@@ -39,6 +39,9 @@ public:
 public:
 	void showEvent(QShowEvent *);
 
+private Q_SLOTS:
+	void update_threads();
+
 private:
 	Ui::DialogThreads *const ui;
 	ThreadsModel          *threads_model_;
@@ -0,0 +1,471 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "DisplacedSteps.h"
+#include "IDebugger.h"
+#include "IProcess.h"
+#include "IRegion.h"
+#include "InstructionLength.h"
+#include "MemoryRegions.h"
+#include "State.h"
+#include "edb.h"
+
+#include <QPair>
+#include <cstring>
+
+namespace {
+
+// every copy gets a slot of this size, which is more than the longest one
+// (a conditional branch with all of its prefixes and both of its jumps) needs
+const edb::address_t SlotSize = 64;
+
+// how far a RIP relative disp32 reaches, less a page to be safe
+const qint64 NearDistance = 0x7fff0000;
+
+//------------------------------------------------------------------------------
+// Name: append_value
+// Desc:
+//------------------------------------------------------------------------------
+template <class T>
+void append_value(QByteArray *code, T value) {
+	code->append(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+//------------------------------------------------------------------------------
+// Name: read_value
+// Desc:
+//------------------------------------------------------------------------------
+template <class T>
+T read_value(const char *p) {
+	T value;
+	std::memcpy(&value, p, sizeof(value));
+	return value;
+}
+
+//------------------------------------------------------------------------------
+// Name: append_jump
+// Desc: a jump to <target> at the end of <code>, which is going to <base>
+//------------------------------------------------------------------------------
+void append_jump(QByteArray *code, edb::address_t base, edb::address_t target) {
+#if defined(EDB_X86)
+	const edb::address_t next = base + code->size() + 5;
+	code->append('\xe9');                         // jmp rel32
+	append_value(code, static_cast<quint32>(target - next));
+#elif defined(EDB_X86_64)
+	Q_UNUSED(base);
+	static const char jump[] = { '\xff', '\x25', 0, 0, 0, 0 }; // jmp qword [rip+0]
+	code->append(jump, sizeof(jump));
+	append_value(code, static_cast<quint64>(target));
+#endif
+}
+
+//------------------------------------------------------------------------------
+// Name: jump_size
+// Desc: how many bytes append_jump adds
+//------------------------------------------------------------------------------
+int jump_size() {
+#if defined(EDB_X86)
+	return 5;
+#elif defined(EDB_X86_64)
+	return 14;
+#endif
+}
+
+//------------------------------------------------------------------------------
+// Name: has_prefix
+// Desc: true if <prefix> is among the first <n> bytes of an instruction which
+//       are its prefixes
+//------------------------------------------------------------------------------
+bool has_prefix(const QByteArray &bytes, std::size_t n, char prefix) {
+	return std::memchr(bytes.constData(), prefix, n) != 0;
+}
+
+//------------------------------------------------------------------------------
+// Name: traps
+// Desc: true for the instructions which enter the kernel or trap, which could
+//       be copied but would then be seen by the kernel and edb (as the address
+//       to return or restart at) somewhere they don't belong
+//------------------------------------------------------------------------------
+bool traps(const quint8 *opcode) {
+	switch(opcode[0]) {
+	case 0xcc: // int3
+	case 0xcd: // int
+	case 0xce: // into
+	case 0xf1: // int1
+		return true;
+	case 0x0f:
+		switch(opcode[1]) {
+		case 0x05: // syscall
+		case 0x07: // sysret
+		case 0x34: // sysenter
+		case 0x35: // sysexit
+			return true;
+		default:
+			return false;
+		}
+	default:
+		return false;
+	}
+}
+
+}
+
+//------------------------------------------------------------------------------
+// Name: DisplacedSteps
+// Desc:
+//------------------------------------------------------------------------------
+DisplacedSteps::DisplacedSteps() : pid_(0) {
+}
+
+//------------------------------------------------------------------------------
+// Name: reset
+// Desc: forgets every copy, the scratch pages are left to the process
+//------------------------------------------------------------------------------
+void DisplacedSteps::reset() {
+	stubs_.clear();
+	exits_.clear();
+	pages_.clear();
+	pid_ = 0;
+}
+
+//------------------------------------------------------------------------------
+// Name: allocation_hint
+// Desc: the start of the free space nearest to <address> which a page fits
+//       in. It is always right after something which is mapped, so that it
+//       never takes the room a stack would grow down into
+//------------------------------------------------------------------------------
+edb::address_t DisplacedSteps::allocation_hint(edb::address_t address) const {
+
+	const edb::address_t page_size = edb::v1::debugger_core->page_size();
+	const QList<IRegion::pointer> &regions = edb::v1::memory_regions().regions();
+
+	edb::address_t best          = 0;
+	edb::address_t best_distance = ~edb::address_t(0);
+
+	for(int i = 0; i < regions.size(); ++i) {
+		const edb::address_t start = regions[i]->end();
+		const edb::address_t end   = (i + 1 < regions.size()) ? regions[i + 1]->start() : start + page_size;
+
+		if(end < start + page_size) {
+			continue;
+		}
+
+		const edb::address_t distance = (start > address) ? start - address : address - start;
+		if(distance < best_distance) {
+			best          = start;
+			best_distance = distance;
+		}
+	}
+
+	return best;
+}
+
+//------------------------------------------------------------------------------
+// Name: allocate_slot
+// Desc: room for a copy of the instruction at <address>, within reach of a
+//       disp32 from it if <near> is set. Returns 0 if there isn't any
+//------------------------------------------------------------------------------
+edb::address_t DisplacedSteps::allocate_slot(edb::address_t address, bool near) {
+
+	const edb::address_t page_size = edb::v1::debugger_core->page_size();
+
+	for(QList<Page>::iterator it = pages_.begin(); it != pages_.end(); ++it) {
+		if(it->used + SlotSize > page_size) {
+			continue;
+		}
+
+		if(near && qAbs(static_cast<qint64>(it->address - address)) >= NearDistance) {
+			continue;
+		}
+
+		const edb::address_t slot = it->address + it->used;
+		it->used += SlotSize;
+		return slot;
+	}
+
+	const edb::address_t page = edb::v1::debugger_core->allocate_memory(allocation_hint(address), page_size);
+	if(page == 0) {
+		return 0;
+	}
+
+	// even if it didn't end up near enough, the next copy may not care
+	Page info;
+	info.address = page;
+	info.used    = 0;
+	pages_.push_back(info);
+
+	if(near && qAbs(static_cast<qint64>(page - address)) >= NearDistance) {
+		return 0;
+	}
+
+	pages_.back().used = SlotSize;
+	return page;
+}
+
+//------------------------------------------------------------------------------
+// Name: build
+// Desc: makes the copy of <original>, the instruction at <address>. Returns
+//       false if it can't be displaced
+//------------------------------------------------------------------------------
+bool DisplacedSteps::build(edb::address_t address, const QByteArray &original, Stub *stub) {
+
+	Q_ASSERT(stub);
+
+	const quint8 *const bytes = reinterpret_cast<const quint8 *>(original.constData());
+
+	edb::length::Flow   flow;
+	edb::length::Layout layout;
+	const std::size_t size = edb::instruction_length(bytes, original.size(), &flow, &layout);
+	if(size == 0 || size != static_cast<std::size_t>(original.size())) {
+		return false;
+	}
+
+	const quint8 *const opcode = bytes + layout.opcode;
+	const std::size_t   length = size - layout.opcode;
+	const edb::address_t next  = address + size;
+
+	// operand size prefixes make branches wrap their target at 16 bits
+	const bool operand16 = has_prefix(original, layout.opcode, '\x66');
+
+	// where the copy goes once it has been worked out what it needs
+	edb::address_t base = 0;
+	QByteArray &code = stub->code;
+	code.clear();
+
+	QList<QPair<edb::address_t, edb::address_t> > exits;
+
+	switch(flow) {
+	case edb::length::FLOW_JUMP:
+		if((opcode[0] == 0xeb && length == 2) || (opcode[0] == 0xe9 && length == 5 && !operand16)) {
+			const edb::address_t target = next + ((length == 2) ? static_cast<qint8>(opcode[1]) : read_value<qint32>(reinterpret_cast<const char *>(opcode + 1)));
+			if(!(base = allocate_slot(address, false))) {
+				return false;
+			}
+			append_jump(&code, base, target);
+			break;
+		}
+		// indirect and far jumps go somewhere absolute, they are moved as they are
+		// fall through
+	case edb::length::FLOW_NONE:
+	case edb::length::FLOW_RETURN:
+		if(traps(opcode)) {
+			return false;
+		}
+
+		if(!(base = allocate_slot(address, layout.rip_relative != 0))) {
+			return false;
+		}
+
+		code.append(original);
+		if(layout.rip_relative) {
+			const qint64 displacement = read_value<qint32>(original.constData() + layout.rip_relative) + static_cast<qint64>(address - base);
+			if(displacement != static_cast<qint32>(displacement)) {
+				return false;
+			}
+			const qint32 patched = static_cast<qint32>(displacement);
+			std::memcpy(code.data() + layout.rip_relative, &patched, sizeof(patched));
+		}
+
+		exits.push_back(qMakePair(base + code.size(), next));
+		append_jump(&code, base, next);
+		break;
+
+	case edb::length::FLOW_CALL:
+		// only a relative call can have its return address pushed for it, an
+		// indirect one may well be through the stack pointer
+		if(opcode[0] != 0xe8 || length != 5 || operand16) {
+			return false;
+		} else {
+			const edb::address_t target = next + read_value<qint32>(reinterpret_cast<const char *>(opcode + 1));
+			if(!(base = allocate_slot(address, false))) {
+				return false;
+			}
+#if defined(EDB_X86)
+			code.append('\x68');                     // push imm32
+			append_value(&code, static_cast<quint32>(next));
+#elif defined(EDB_X86_64)
+			static const char push[] = { '\xff', '\x35', 14, 0, 0, 0 }; // push qword [rip+14], past the jump
+			code.append(push, sizeof(push));
+#endif
+			exits.push_back(qMakePair(base + code.size(), target));
+			append_jump(&code, base, target);
+#if defined(EDB_X86_64)
+			append_value(&code, static_cast<quint64>(next));
+#endif
+		}
+		break;
+
+	case edb::length::FLOW_CONDITIONAL:
+		if(operand16) {
+			return false;
+		} else {
+			quint8 condition;
+			edb::address_t target;
+			if((opcode[0] & 0xf0) == 0x70 && length == 2) {
+				condition = opcode[0];
+				target    = next + static_cast<qint8>(opcode[1]);
+			} else if(opcode[0] == 0x0f && (opcode[1] & 0xf0) == 0x80 && length == 6) {
+				condition = 0x70 | (opcode[1] & 0x0f);
+				target    = next + read_value<qint32>(reinterpret_cast<const char *>(opcode + 2));
+			} else if(opcode[0] >= 0xe0 && opcode[0] <= 0xe3 && length == 2) {
+				// the address size says which of cx, ecx or rcx is counted, so
+				// the prefixes stay
+				code.append(original.constData(), layout.opcode);
+				condition = opcode[0];
+				target    = next + static_cast<qint8>(opcode[1]);
+			} else {
+				return false;
+			}
+
+			if(!(base = allocate_slot(address, false))) {
+				return false;
+			}
+
+			// j<cc> taken ; jmp next ; taken: jmp target
+			code.append(static_cast<char>(condition));
+			code.append(static_cast<char>(jump_size()));
+			exits.push_back(qMakePair(base + code.size(), next));
+			append_jump(&code, base, next);
+			exits.push_back(qMakePair(base + code.size(), target));
+			append_jump(&code, base, target);
+		}
+		break;
+	}
+
+	Q_ASSERT(static_cast<edb::address_t>(code.size()) <= SlotSize);
+
+	IProcess *const process = edb::v1::debugger_core->process();
+	if(!process->write_bytes(base, code.constData(), code.size())) {
+		return false;
+	}
+
+	stub->address = base;
+
+	exits_.insert(base, address);
+	for(int i = 0; i < exits.size(); ++i) {
+		exits_.insert(exits[i].first, exits[i].second);
+	}
+
+	return true;
+}
+
+//------------------------------------------------------------------------------
+// Name: in_place
+// Desc: true if the copy is still there, it isn't after an exec. A scratch page
+//       which can't be read any more is dropped
+//------------------------------------------------------------------------------
+bool DisplacedSteps::in_place(const Stub &stub) {
+
+	IProcess *const process = edb::v1::debugger_core->process();
+
+	char buffer[SlotSize];
+	if(!process->read_bytes(stub.address, buffer, stub.code.size())) {
+		const edb::address_t page_size = edb::v1::debugger_core->page_size();
+		for(int i = 0; i < pages_.size(); ++i) {
+			if(stub.address - pages_[i].address < page_size) {
+				pages_.removeAt(i);
+				break;
+			}
+		}
+		return false;
+	}
+
+	return std::memcmp(buffer, stub.code.constData(), stub.code.size()) == 0;
+}
+
+//------------------------------------------------------------------------------
+// Name: resume
+// Desc: continues the active thread, which is stopped at the breakpoint at
+//       <address>, through a copy of the instruction there. Returns false
+//       without doing anything if that can't be done
+//------------------------------------------------------------------------------
+bool DisplacedSteps::resume(edb::address_t address, edb::EVENT_STATUS status) {
+
+	IDebugger *const core   = edb::v1::debugger_core;
+	IProcess *const process = core ? core->process() : 0;
+	if(!process) {
+		return false;
+	}
+
+	if(process->pid() != pid_) {
+		reset();
+		pid_ = process->pid();
+	}
+
+	// what is read has the breakpoints masked out, so it is the instruction
+	// which the breakpoint replaced
+	quint8 buffer[edb::length::MaxSize];
+	int size = sizeof(buffer);
+	if(!edb::v1::get_instruction_bytes(address, buffer, &size) || size == 0) {
+		return false;
+	}
+
+	const std::size_t length = edb::instruction_length(buffer, size);
+	if(length == 0) {
+		return false;
+	}
+
+	const QByteArray original(reinterpret_cast<const char *>(buffer), length);
+
+	QHash<edb::address_t, Stub>::iterator it = stubs_.find(address);
+	if(it == stubs_.end() || it->original != original || (it->address != 0 && !in_place(*it))) {
+		Stub stub;
+		stub.address  = 0;
+		stub.original = original;
+		if(!build(address, original, &stub)) {
+			stub.address = 0;
+		}
+		it = stubs_.insert(address, stub);
+	}
+
+	if(it->address == 0) {
+		return false;
+	}
+
+	State state;
+	core->get_state(&state);
+	if(state.instruction_pointer() != address) {
+		return false;
+	}
+
+	state.set_instruction_pointer(it->address);
+	core->set_state(state);
+	core->resume(status);
+	return true;
+}
+
+//------------------------------------------------------------------------------
+// Name: leave
+// Desc: if the active thread stopped in a copy at a place which stands for an
+//       address in the real code, it is moved there
+//------------------------------------------------------------------------------
+void DisplacedSteps::leave() {
+
+	if(exits_.isEmpty() || !edb::v1::debugger_core->process()) {
+		return;
+	}
+
+	State state;
+	edb::v1::debugger_core->get_state(&state);
+
+	const QHash<edb::address_t, edb::address_t>::const_iterator it = exits_.find(state.instruction_pointer());
+	if(it != exits_.end()) {
+		state.set_instruction_pointer(it.value());
+		edb::v1::debugger_core->set_state(state);
+	}
+}
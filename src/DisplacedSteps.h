@@ -0,0 +1,80 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef DISPLACEDSTEPS_20261014_H_
+#define DISPLACEDSTEPS_20261014_H_
+
+#include "Types.h"
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <cstddef>
+
+// resumes from a software breakpoint without taking it out. The instruction
+// under the breakpoint is copied into a scratch page in the process, with
+// anything which is relative to where it is patched, and followed by a jump to
+// wherever the original would have gone next. The thread is pointed at the
+// copy and continued in one go, so the breakpoint stays in place the whole
+// time and no other thread can run through it unseen.
+//
+// Instructions which can't be moved like that (indirect calls, system calls
+// and interrupts, RIP relative operands which wouldn't reach from any scratch
+// page, anything the length decoder isn't sure of) aren't displaced, resume
+// returns false and the breakpoint has to be stepped over the usual way.
+//
+// A thread which stops while it is in a copy is moved back to the address it
+// stands for before the stop is shown, other threads are left where they are
+// and carry on through the copy when they run again
+class DisplacedSteps {
+public:
+	DisplacedSteps();
+
+private:
+	Q_DISABLE_COPY(DisplacedSteps)
+
+public:
+	bool resume(edb::address_t address, edb::EVENT_STATUS status);
+	void leave();
+	void reset();
+
+private:
+	struct Stub {
+		edb::address_t address;   // where the copy is, 0 if there can't be one
+		QByteArray     original;  // the instruction which was copied
+		QByteArray     code;      // what was written at <address>
+	};
+
+	struct Page {
+		edb::address_t address;
+		edb::address_t used;
+	};
+
+private:
+	bool build(edb::address_t address, const QByteArray &original, Stub *stub);
+	bool in_place(const Stub &stub);
+	edb::address_t allocate_slot(edb::address_t address, bool near);
+	edb::address_t allocation_hint(edb::address_t address) const;
+
+private:
+	QHash<edb::address_t, Stub>           stubs_;
+	QHash<edb::address_t, edb::address_t> exits_;  // places in the copies, and the addresses they stand for
+	QList<Page>                           pages_;
+	edb::pid_t                            pid_;
+};
+
+#endif
@@ -0,0 +1,862 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Emulator.h"
+#include "IDebugger.h"
+#include "IProcess.h"
+#include "MemoryRegions.h"
+#include "State.h"
+#include "edb.h"
+
+#include <cstring>
+
+namespace {
+
+#if defined(EDB_X86_64)
+const char *const register_names[16] = {
+	"rax", "rcx", "rdx", "rbx", "rsp", "rbp", "rsi", "rdi",
+	"r8",  "r9",  "r10", "r11", "r12", "r13", "r14", "r15"
+};
+
+const int RSP = 4;
+
+const quint32 RipDirty   = 1u << 16;
+const quint32 FlagsDirty = 1u << 17;
+
+enum {
+	CF = 0x0001,
+	PF = 0x0004,
+	AF = 0x0010,
+	ZF = 0x0040,
+	SF = 0x0080,
+	TF = 0x0100,
+	OF = 0x0800,
+	ArithmeticFlags = CF | PF | AF | ZF | SF | OF
+};
+
+// the ALU operations the emulator knows, numbered like the reg field of
+// opcodes 80 to 83 and bits 3 to 5 of opcodes 00 to 3F
+enum Operation {
+	OP_ADD = 0,
+	OP_OR  = 1,
+	OP_ADC = 2,
+	OP_SBB = 3,
+	OP_AND = 4,
+	OP_SUB = 5,
+	OP_XOR = 6,
+	OP_CMP = 7
+};
+
+// a decoded ModRM operand, <address> is only meaningful if <memory>
+struct Operand {
+	bool           memory;
+	bool           rip_relative;
+	int            reg;     // the reg field, with REX.R
+	int            rm;      // the register if !memory, with REX.B
+	edb::address_t address;
+};
+
+//------------------------------------------------------------------------------
+// Name: mask
+// Desc:
+//------------------------------------------------------------------------------
+quint64 mask(int size) {
+	return (size == 8) ? ~Q_UINT64_C(0) : ((Q_UINT64_C(1) << (size * 8)) - 1);
+}
+
+//------------------------------------------------------------------------------
+// Name: sign_bit
+// Desc:
+//------------------------------------------------------------------------------
+quint64 sign_bit(int size) {
+	return Q_UINT64_C(1) << (size * 8 - 1);
+}
+
+//------------------------------------------------------------------------------
+// Name: result_flags
+// Desc: PF, ZF and SF of <result>, the rest are up to the operation
+//------------------------------------------------------------------------------
+edb::reg_t result_flags(quint64 result, int size) {
+
+	edb::reg_t flags = 0;
+
+	quint8 low = static_cast<quint8>(result);
+	low ^= low >> 4;
+	low ^= low >> 2;
+	low ^= low >> 1;
+	if(!(low & 1)) {
+		flags |= PF;
+	}
+
+	if((result & mask(size)) == 0) {
+		flags |= ZF;
+	}
+
+	if(result & sign_bit(size)) {
+		flags |= SF;
+	}
+
+	return flags;
+}
+
+//------------------------------------------------------------------------------
+// Name: alu
+// Desc: <a> <op> <b> on <size> byte operands, setting the arithmetic flags in
+//       <flags>. Returns false for the operations that aren't emulated
+//------------------------------------------------------------------------------
+bool alu(int op, quint64 a, quint64 b, int size, quint64 *result, edb::reg_t *flags) {
+
+	const quint64 m = mask(size);
+	a &= m;
+	b &= m;
+
+	quint64 r;
+	edb::reg_t f = 0;
+
+	switch(op) {
+	case OP_ADD:
+		r = (a + b) & m;
+		if(r < a) {
+			f |= CF;
+		}
+		if((a ^ r) & (b ^ r) & sign_bit(size)) {
+			f |= OF;
+		}
+		f |= (a ^ b ^ r) & AF;
+		break;
+	case OP_SUB:
+	case OP_CMP:
+		r = (a - b) & m;
+		if(a < b) {
+			f |= CF;
+		}
+		if((a ^ b) & (a ^ r) & sign_bit(size)) {
+			f |= OF;
+		}
+		f |= (a ^ b ^ r) & AF;
+		break;
+	case OP_OR:  r = a | b; break;
+	case OP_AND: r = a & b; break;
+	case OP_XOR: r = a ^ b; break;
+	default:
+		return false;
+	}
+
+	*result = r;
+	*flags  = (*flags & ~static_cast<edb::reg_t>(ArithmeticFlags)) | f | result_flags(r, size);
+	return true;
+}
+
+//------------------------------------------------------------------------------
+// Name: condition
+// Desc: whether condition code <cc> (the low nibble of a jcc) holds
+//------------------------------------------------------------------------------
+bool condition(int cc, edb::reg_t flags) {
+
+	const bool cf = flags & CF;
+	const bool pf = flags & PF;
+	const bool zf = flags & ZF;
+	const bool sf = flags & SF;
+	const bool of = flags & OF;
+
+	bool value;
+	switch(cc >> 1) {
+	case 0:  value = of;               break;
+	case 1:  value = cf;               break;
+	case 2:  value = zf;               break;
+	case 3:  value = cf || zf;         break;
+	case 4:  value = sf;               break;
+	case 5:  value = pf;               break;
+	case 6:  value = sf != of;         break;
+	default: value = zf || sf != of;   break;
+	}
+
+	return (cc & 1) ? !value : value;
+}
+
+//------------------------------------------------------------------------------
+// Name: take
+// Desc: reads an <n> byte little endian value at <p> and moves past it,
+//       returns false if it doesn't fit before <last>
+//------------------------------------------------------------------------------
+bool take(const quint8 **p, const quint8 *last, int n, quint64 *value) {
+	if(last - *p < n) {
+		return false;
+	}
+
+	quint64 v = 0;
+	std::memcpy(&v, *p, n);
+	*p += n;
+	*value = v;
+	return true;
+}
+
+//------------------------------------------------------------------------------
+// Name: sign_extend
+// Desc:
+//------------------------------------------------------------------------------
+quint64 sign_extend(quint64 value, int size) {
+	if(size < 8 && (value & sign_bit(size))) {
+		value |= ~mask(size);
+	}
+	return value;
+}
+
+//------------------------------------------------------------------------------
+// Name: decode_modrm
+// Desc: the ModRM byte at <p> and whatever follows it. A RIP relative
+//       address is relative to the start of the instruction until the caller
+//       knows where it ends
+//------------------------------------------------------------------------------
+bool decode_modrm(const quint8 **p, const quint8 *last, quint8 rex, const edb::reg_t *gpr, Operand *operand) {
+
+	if(*p == last) {
+		return false;
+	}
+
+	const quint8 modrm = *(*p)++;
+	const int mod      = modrm >> 6;
+	const int rm       = modrm & 7;
+
+	operand->reg          = ((modrm >> 3) & 7) | ((rex & 4) << 1);
+	operand->rm           = rm | ((rex & 1) << 3);
+	operand->memory       = mod != 3;
+	operand->rip_relative = false;
+	operand->address      = 0;
+
+	if(mod == 3) {
+		return true;
+	}
+
+	quint64 disp = 0;
+	edb::address_t address = 0;
+
+	if(rm == 4) {
+		if(*p == last) {
+			return false;
+		}
+
+		const quint8 sib = *(*p)++;
+		const int scale  = sib >> 6;
+		const int index  = ((sib >> 3) & 7) | ((rex & 2) << 2);
+		const int base   = sib & 7;
+
+		if(index != 4) {
+			address += gpr[index] << scale;
+		}
+
+		if(base == 5 && mod == 0) {
+			if(!take(p, last, 4, &disp)) {
+				return false;
+			}
+			address += sign_extend(disp, 4);
+		} else {
+			address += gpr[base | ((rex & 1) << 3)];
+		}
+	} else if(rm == 5 && mod == 0) {
+		if(!take(p, last, 4, &disp)) {
+			return false;
+		}
+		operand->rip_relative = true;
+		address = sign_extend(disp, 4);
+	} else {
+		address = gpr[operand->rm];
+	}
+
+	if(mod == 1) {
+		if(!take(p, last, 1, &disp)) {
+			return false;
+		}
+		address += sign_extend(disp, 1);
+	} else if(mod == 2) {
+		if(!take(p, last, 4, &disp)) {
+			return false;
+		}
+		address += sign_extend(disp, 4);
+	}
+
+	operand->address = address;
+	return true;
+}
+
+//------------------------------------------------------------------------------
+// Name: accessible
+// Desc: true if the CPU could read (or, if <write>, write) <size> bytes at
+//       <address> without faulting. Going through the process would succeed
+//       regardless of the page protections, so anything which would fault,
+//       guard pages and the pages memory breakpoints protect included, is
+//       left for the CPU to really step
+//------------------------------------------------------------------------------
+bool accessible(edb::address_t address, int size, bool write) {
+
+	const edb::address_t last = address + size - 1;
+	if(last < address) {
+		return false;
+	}
+
+	const MemoryRegions &regions = edb::v1::memory_regions();
+	for(edb::address_t a = address; ; ) {
+		const IRegion::pointer region = regions.find_region(a);
+		if(!region || !region->readable() || (write && !region->writable())) {
+			return false;
+		}
+
+		if(last < region->end()) {
+			break;
+		}
+
+		a = region->end();
+	}
+
+	return !edb::v1::memory_breakpoint_page(address, size, write);
+}
+
+//------------------------------------------------------------------------------
+// Name: read_memory
+// Desc:
+//------------------------------------------------------------------------------
+bool read_memory(edb::address_t address, int size, quint64 *value) {
+	if(!accessible(address, size, false)) {
+		return false;
+	}
+
+	IProcess *const process = edb::v1::debugger_core->process();
+	quint64 v = 0;
+	if(!process || !process->read_bytes(address, &v, size)) {
+		return false;
+	}
+	*value = v;
+	return true;
+}
+#endif
+
+}
+
+//------------------------------------------------------------------------------
+// Name: Emulator
+// Desc:
+//------------------------------------------------------------------------------
+Emulator::Emulator(const State &state) : dirty_(0), count_(0), usable_(false) {
+
+	std::memset(&machine_, 0, sizeof(machine_));
+	machine_.rip   = state.instruction_pointer();
+	machine_.flags = state.flags();
+
+#if defined(EDB_X86_64)
+	for(int i = 0; i < 16; ++i) {
+		machine_.gpr[i] = state[QLatin1String(register_names[i])].value<edb::reg_t>();
+	}
+
+	// a hardware breakpoint or the trap flag would notice that nothing
+	// really ran, and the decoder only knows 64-bit code
+	const bool debug_registers = (state.debug_register(7) & 0xff) != 0;
+	const bool long_mode       = state[QLatin1String("cs")].value<edb::reg_t>() == 0x33;
+
+	usable_ = long_mode && !debug_registers && !(machine_.flags & TF);
+#endif
+}
+
+//------------------------------------------------------------------------------
+// Name: store
+// Desc: writes the registers which were changed into <state>
+//------------------------------------------------------------------------------
+void Emulator::store(State *state) const {
+
+	Q_ASSERT(state);
+
+#if defined(EDB_X86_64)
+	for(int i = 0; i < 16; ++i) {
+		if(dirty_ & (1u << i)) {
+			state->set_register(QLatin1String(register_names[i]), machine_.gpr[i]);
+		}
+	}
+
+	if(dirty_ & FlagsDirty) {
+		state->set_flags(machine_.flags);
+	}
+
+	if(dirty_ & RipDirty) {
+		state->set_instruction_pointer(machine_.rip);
+	}
+#else
+	Q_UNUSED(state);
+#endif
+}
+
+//------------------------------------------------------------------------------
+// Name: step
+// Desc: emulates the instruction at the instruction pointer, returns false if
+//       it isn't one the emulator knows, in which case nothing has changed
+//------------------------------------------------------------------------------
+bool Emulator::step() {
+
+	writes_.clear();
+
+#if defined(EDB_X86_64)
+	if(!usable_ || !edb::v1::debugger_core || edb::v1::debugger_core->find_breakpoint(machine_.rip)) {
+		return false;
+	}
+
+	// code on a page a memory breakpoint protects has to fault for real
+	const IRegion::pointer code_region = edb::v1::memory_regions().find_region(machine_.rip);
+	if(!code_region || !code_region->executable() || edb::v1::memory_breakpoint_page(machine_.rip, 1, false)) {
+		return false;
+	}
+
+	quint8 code[15];
+	int available = sizeof(code);
+	if(!edb::v1::get_instruction_bytes(machine_.rip, code, &available) || available == 0) {
+		return false;
+	}
+
+	const quint8 *p          = code;
+	const quint8 *const last = code + available;
+
+	Machine m = machine_;
+	quint32 changed = RipDirty;
+
+	// the one write an instruction may make, done only once all else is known
+	// to have worked
+	bool           store_pending = false;
+	edb::address_t store_address = 0;
+	quint64        store_value   = 0;
+	int            store_size    = 0;
+
+	// endbr64 and endbr32, which are nops to anything without CET
+	if(available >= 4 && code[0] == 0xf3 && code[1] == 0x0f && code[2] == 0x1e && (code[3] == 0xfa || code[3] == 0xfb)) {
+		m.rip += 4;
+		goto commit;
+	}
+
+	{
+		quint8 rex = 0;
+		if(p != last && (*p & 0xf0) == 0x40) {
+			rex = *p++;
+		}
+
+		if(p == last) {
+			return false;
+		}
+
+		const int size   = (rex & 8) ? 8 : 4;
+		const quint8 op  = *p++;
+		Operand operand;
+		quint64 imm      = 0;
+
+		// finishes the decode of an instruction whose ModRM operand comes
+		// <trailing> bytes before its end
+		#define EDB_EMU_MODRM(trailing)                                          \
+			do {                                                                 \
+				if(!decode_modrm(&p, last, rex, m.gpr, &operand)) {              \
+					return false;                                                \
+				}                                                                \
+				if(operand.rip_relative) {                                       \
+					operand.address += m.rip + (p - code) + (trailing);          \
+				}                                                                \
+			} while(0)
+
+		quint64 a;
+		quint64 b;
+		quint64 r;
+
+		if(op < 0x40 && ((op & 7) == 1 || (op & 7) == 3 || (op & 7) == 5)) {
+			// ALU r/m,r ; r,r/m ; rax,imm32
+			const int alu_op = op >> 3;
+			if((op & 7) == 5) {
+				if(!take(&p, last, 4, &imm)) {
+					return false;
+				}
+				a = m.gpr[0];
+				b = sign_extend(imm, 4);
+				if(!alu(alu_op, a, b, size, &r, &m.flags)) {
+					return false;
+				}
+				if(alu_op != OP_CMP) {
+					m.gpr[0] = r;
+					changed |= 1u;
+				}
+			} else {
+				EDB_EMU_MODRM(0);
+				quint64 rm_value;
+				if(operand.memory) {
+					if(!read_memory(operand.address, size, &rm_value)) {
+						return false;
+					}
+				} else {
+					rm_value = m.gpr[operand.rm];
+				}
+
+				const bool to_rm = (op & 7) == 1;
+				a = to_rm ? rm_value : m.gpr[operand.reg];
+				b = to_rm ? m.gpr[operand.reg] : rm_value;
+				if(!alu(alu_op, a, b, size, &r, &m.flags)) {
+					return false;
+				}
+
+				if(alu_op != OP_CMP) {
+					if(to_rm && operand.memory) {
+						store_pending = true;
+						store_address = operand.address;
+						store_value   = r;
+						store_size    = size;
+					} else {
+						const int dest = to_rm ? operand.rm : operand.reg;
+						m.gpr[dest] = r;
+						changed |= 1u << dest;
+					}
+				}
+			}
+			changed |= FlagsDirty;
+		} else {
+			switch(op) {
+			case 0x50: case 0x51: case 0x52: case 0x53:
+			case 0x54: case 0x55: case 0x56: case 0x57:
+				// push r64
+				store_pending = true;
+				store_value   = m.gpr[(op & 7) | ((rex & 1) << 3)];
+				store_size    = 8;
+				m.gpr[RSP]   -= 8;
+				store_address = m.gpr[RSP];
+				changed |= 1u << RSP;
+				break;
+
+			case 0x58: case 0x59: case 0x5a: case 0x5b:
+			case 0x5c: case 0x5d: case 0x5e: case 0x5f:
+				// pop r64, of rsp too, which ends up with what was popped
+				if(!read_memory(m.gpr[RSP], 8, &r)) {
+					return false;
+				}
+				m.gpr[RSP] += 8;
+				m.gpr[(op & 7) | ((rex & 1) << 3)] = r;
+				changed |= (1u << RSP) | (1u << ((op & 7) | ((rex & 1) << 3)));
+				break;
+
+			case 0x68:
+			case 0x6a:
+				// push imm32 / imm8
+				if(!take(&p, last, (op == 0x68) ? 4 : 1, &imm)) {
+					return false;
+				}
+				store_pending = true;
+				store_value   = sign_extend(imm, (op == 0x68) ? 4 : 1);
+				store_size    = 8;
+				m.gpr[RSP]   -= 8;
+				store_address = m.gpr[RSP];
+				changed |= 1u << RSP;
+				break;
+
+			case 0x70: case 0x71: case 0x72: case 0x73:
+			case 0x74: case 0x75: case 0x76: case 0x77:
+			case 0x78: case 0x79: case 0x7a: case 0x7b:
+			case 0x7c: case 0x7d: case 0x7e: case 0x7f:
+				// jcc rel8
+				if(!take(&p, last, 1, &imm)) {
+					return false;
+				}
+				if(condition(op & 0x0f, m.flags)) {
+					m.rip += sign_extend(imm, 1);
+				}
+				break;
+
+			case 0x81:
+			case 0x83:
+				// ALU r/m, imm32 / imm8
+				EDB_EMU_MODRM((op == 0x81) ? 4 : 1);
+				if(!take(&p, last, (op == 0x81) ? 4 : 1, &imm)) {
+					return false;
+				}
+				if(operand.memory) {
+					if(!read_memory(operand.address, size, &a)) {
+						return false;
+					}
+				} else {
+					a = m.gpr[operand.rm];
+				}
+				if(!alu(operand.reg & 7, a, sign_extend(imm, (op == 0x81) ? 4 : 1), size, &r, &m.flags)) {
+					return false;
+				}
+				if((operand.reg & 7) != OP_CMP) {
+					if(operand.memory) {
+						store_pending = true;
+						store_address = operand.address;
+						store_value   = r;
+						store_size    = size;
+					} else {
+						m.gpr[operand.rm] = r;
+						changed |= 1u << operand.rm;
+					}
+				}
+				changed |= FlagsDirty;
+				break;
+
+			case 0x85:
+				// test r/m, r
+				EDB_EMU_MODRM(0);
+				if(operand.memory) {
+					if(!read_memory(operand.address, size, &a)) {
+						return false;
+					}
+				} else {
+					a = m.gpr[operand.rm];
+				}
+				alu(OP_AND, a, m.gpr[operand.reg], size, &r, &m.flags);
+				changed |= FlagsDirty;
+				break;
+
+			case 0xa9:
+				// test rax, imm32
+				if(!take(&p, last, 4, &imm)) {
+					return false;
+				}
+				alu(OP_AND, m.gpr[0], sign_extend(imm, 4), size, &r, &m.flags);
+				changed |= FlagsDirty;
+				break;
+
+			case 0x89:
+				// mov r/m, r
+				EDB_EMU_MODRM(0);
+				if(operand.memory) {
+					store_pending = true;
+					store_address = operand.address;
+					store_value   = m.gpr[operand.reg];
+					store_size    = size;
+				} else {
+					m.gpr[operand.rm] = m.gpr[operand.reg] & mask(size);
+					changed |= 1u << operand.rm;
+				}
+				break;
+
+			case 0x8b:
+				// mov r, r/m
+				EDB_EMU_MODRM(0);
+				if(operand.memory) {
+					if(!read_memory(operand.address, size, &r)) {
+						return false;
+					}
+				} else {
+					r = m.gpr[operand.rm] & mask(size);
+				}
+				m.gpr[operand.reg] = r;
+				changed |= 1u << operand.reg;
+				break;
+
+			case 0x8d:
+				// lea r, m
+				EDB_EMU_MODRM(0);
+				if(!operand.memory) {
+					return false;
+				}
+				m.gpr[operand.reg] = operand.address & mask(size);
+				changed |= 1u << operand.reg;
+				break;
+
+			case 0x90:
+				// nop, with REX.B it is xchg r8, rax
+				if(rex & 1) {
+					return false;
+				}
+				break;
+
+			case 0xb8: case 0xb9: case 0xba: case 0xbb:
+			case 0xbc: case 0xbd: case 0xbe: case 0xbf:
+				// mov r, imm32 / imm64
+				if(!take(&p, last, size, &imm)) {
+					return false;
+				}
+				m.gpr[(op & 7) | ((rex & 1) << 3)] = imm;
+				changed |= 1u << ((op & 7) | ((rex & 1) << 3));
+				break;
+
+			case 0xc3:
+				// ret
+				if(!read_memory(m.gpr[RSP], 8, &r)) {
+					return false;
+				}
+				m.gpr[RSP] += 8;
+				changed |= 1u << RSP;
+				m.rip = r - (p - code); // made up for below
+				break;
+
+			case 0xc7:
+				// mov r/m, imm32
+				EDB_EMU_MODRM(4);
+				if((operand.reg & 7) != 0) {
+					return false;
+				}
+				if(!take(&p, last, 4, &imm)) {
+					return false;
+				}
+				imm = sign_extend(imm, 4) & mask(size);
+				if(operand.memory) {
+					store_pending = true;
+					store_address = operand.address;
+					store_value   = imm;
+					store_size    = size;
+				} else {
+					m.gpr[operand.rm] = imm;
+					changed |= 1u << operand.rm;
+				}
+				break;
+
+			case 0xe8:
+				// call rel32
+				if(!take(&p, last, 4, &imm)) {
+					return false;
+				}
+				store_pending = true;
+				store_value   = m.rip + (p - code);
+				store_size    = 8;
+				m.gpr[RSP]   -= 8;
+				store_address = m.gpr[RSP];
+				changed |= 1u << RSP;
+				m.rip += sign_extend(imm, 4);
+				break;
+
+			case 0xe9:
+			case 0xeb:
+				// jmp rel32 / rel8
+				if(!take(&p, last, (op == 0xe9) ? 4 : 1, &imm)) {
+					return false;
+				}
+				m.rip += sign_extend(imm, (op == 0xe9) ? 4 : 1);
+				break;
+
+			case 0xff:
+				EDB_EMU_MODRM(0);
+				switch(operand.reg & 7) {
+				case 0:
+				case 1:
+					// inc and dec leave CF alone
+					if(operand.memory) {
+						if(!read_memory(operand.address, size, &a)) {
+							return false;
+						}
+					} else {
+						a = m.gpr[operand.rm];
+					}
+					{
+						const edb::reg_t carry = m.flags & CF;
+						alu(((operand.reg & 7) == 0) ? OP_ADD : OP_SUB, a, 1, size, &r, &m.flags);
+						m.flags = (m.flags & ~static_cast<edb::reg_t>(CF)) | carry;
+					}
+					if(operand.memory) {
+						store_pending = true;
+						store_address = operand.address;
+						store_value   = r;
+						store_size    = size;
+					} else {
+						m.gpr[operand.rm] = r;
+						changed |= 1u << operand.rm;
+					}
+					changed |= FlagsDirty;
+					break;
+				case 2:
+				case 4:
+				case 6:
+					// call, jmp and push of r/m64
+					if(operand.memory) {
+						if(!read_memory(operand.address, 8, &r)) {
+							return false;
+						}
+					} else {
+						r = m.gpr[operand.rm];
+					}
+
+					if((operand.reg & 7) != 4) {
+						store_pending = true;
+						store_value   = ((operand.reg & 7) == 2) ? m.rip + (p - code) : r;
+						store_size    = 8;
+						m.gpr[RSP]   -= 8;
+						store_address = m.gpr[RSP];
+						changed |= 1u << RSP;
+					}
+
+					if((operand.reg & 7) != 6) {
+						m.rip = r - (p - code); // made up for below
+					}
+					break;
+				default:
+					return false;
+				}
+				break;
+
+			case 0x0f:
+				if(p == last) {
+					return false;
+				}
+
+				if((*p & 0xf0) == 0x80) {
+					// jcc rel32
+					const int cc = *p++ & 0x0f;
+					if(!take(&p, last, 4, &imm)) {
+						return false;
+					}
+					if(condition(cc, m.flags)) {
+						m.rip += sign_extend(imm, 4);
+					}
+				} else if(*p == 0x1f) {
+					// nop r/m, nothing is accessed
+					++p;
+					EDB_EMU_MODRM(0);
+				} else {
+					return false;
+				}
+				break;
+
+			default:
+				return false;
+			}
+		}
+
+		#undef EDB_EMU_MODRM
+
+		m.rip += p - code;
+	}
+
+commit:
+	if(store_pending) {
+		if(!accessible(store_address, store_size, true)) {
+			return false;
+		}
+
+		IProcess *const process = edb::v1::debugger_core->process();
+
+		Write write;
+		write.address  = store_address;
+		write.bytes    = QByteArray(reinterpret_cast<const char *>(&store_value), store_size);
+		write.previous = QByteArray(store_size, 0);
+
+		if(!process || !process->read_bytes(store_address, write.previous.data(), store_size)) {
+			return false;
+		}
+
+		if(!process->write_bytes(store_address, write.bytes.constData(), store_size)) {
+			return false;
+		}
+
+		writes_.push_back(write);
+	}
+
+	machine_ = m;
+	dirty_  |= changed;
+	++count_;
+	return true;
+#else
+	return false;
+#endif
+}
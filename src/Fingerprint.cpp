@@ -0,0 +1,146 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Fingerprint.h"
+#include <cstring>
+
+namespace edb {
+namespace internal {
+
+namespace {
+
+const quint64 Prime1 = Q_UINT64_C(0x9e3779b185ebca87);
+const quint64 Prime2 = Q_UINT64_C(0xc2b2ae3d27d4eb4f);
+const quint64 Prime3 = Q_UINT64_C(0x165667b19e3779f9);
+const quint64 Prime4 = Q_UINT64_C(0x85ebca77c2b2ae63);
+const quint64 Prime5 = Q_UINT64_C(0x27d4eb2f165667c5);
+
+//------------------------------------------------------------------------------
+// Name: rotl
+// Desc:
+//------------------------------------------------------------------------------
+inline quint64 rotl(quint64 x, int r) {
+	return (x << r) | (x >> (64 - r));
+}
+
+//------------------------------------------------------------------------------
+// Name: read64
+// Desc: an unaligned little endian read, which is all x86 has
+//------------------------------------------------------------------------------
+inline quint64 read64(const quint8 *p) {
+	quint64 v;
+	std::memcpy(&v, p, sizeof(v));
+	return v;
+}
+
+//------------------------------------------------------------------------------
+// Name: read32
+// Desc:
+//------------------------------------------------------------------------------
+inline quint32 read32(const quint8 *p) {
+	quint32 v;
+	std::memcpy(&v, p, sizeof(v));
+	return v;
+}
+
+//------------------------------------------------------------------------------
+// Name: lane_round
+// Desc:
+//------------------------------------------------------------------------------
+inline quint64 lane_round(quint64 acc, quint64 input) {
+	acc += input * Prime2;
+	acc  = rotl(acc, 31);
+	return acc * Prime1;
+}
+
+//------------------------------------------------------------------------------
+// Name: merge_round
+// Desc:
+//------------------------------------------------------------------------------
+inline quint64 merge_round(quint64 acc, quint64 value) {
+	acc ^= lane_round(0, value);
+	return acc * Prime1 + Prime4;
+}
+
+}
+
+//------------------------------------------------------------------------------
+// Name: xxh64
+// Desc: the four lanes are independent, so the bulk of the input goes at
+//       about the speed memory can be read
+//------------------------------------------------------------------------------
+quint64 xxh64(const void *data, std::size_t len, quint64 seed) {
+
+	const quint8 *p         = reinterpret_cast<const quint8 *>(data);
+	const quint8 *const end = p + len;
+
+	quint64 h;
+
+	if(len >= 32) {
+		const quint8 *const limit = end - 32;
+
+		quint64 v1 = seed + Prime1 + Prime2;
+		quint64 v2 = seed + Prime2;
+		quint64 v3 = seed;
+		quint64 v4 = seed - Prime1;
+
+		do {
+			v1 = lane_round(v1, read64(p));
+			v2 = lane_round(v2, read64(p + 8));
+			v3 = lane_round(v3, read64(p + 16));
+			v4 = lane_round(v4, read64(p + 24));
+			p += 32;
+		} while(p <= limit);
+
+		h = rotl(v1, 1) + rotl(v2, 7) + rotl(v3, 12) + rotl(v4, 18);
+		h = merge_round(h, v1);
+		h = merge_round(h, v2);
+		h = merge_round(h, v3);
+		h = merge_round(h, v4);
+	} else {
+		h = seed + Prime5;
+	}
+
+	h += static_cast<quint64>(len);
+
+	for(; end - p >= 8; p += 8) {
+		h ^= lane_round(0, read64(p));
+		h  = rotl(h, 27) * Prime1 + Prime4;
+	}
+
+	if(end - p >= 4) {
+		h ^= static_cast<quint64>(read32(p)) * Prime1;
+		h  = rotl(h, 23) * Prime2 + Prime3;
+		p += 4;
+	}
+
+	for(; p != end; ++p) {
+		h ^= *p * Prime5;
+		h  = rotl(h, 11) * Prime1;
+	}
+
+	h ^= h >> 33;
+	h *= Prime2;
+	h ^= h >> 29;
+	h *= Prime3;
+	h ^= h >> 32;
+	return h;
+}
+
+}
+}
@@ -56,6 +56,24 @@ void Function::swap(Function &other) {
 	qSwap(blocks_, other.blocks_);
 }
 
+//------------------------------------------------------------------------------
+// Name: rebase
+// Desc: moves the function and its blocks along with the region [start, end)
+//       they are in, which is now loaded at <new_start>
+//------------------------------------------------------------------------------
+void Function::rebase(edb::address_t start, edb::address_t end, edb::address_t new_start) {
+
+	QMap<edb::address_t, BasicBlock> blocks;
+	for(QMap<edb::address_t, BasicBlock>::const_iterator it = blocks_.begin(); it != blocks_.end(); ++it) {
+		BasicBlock block = it.value();
+		block.rebase(start, end, new_start);
+		blocks.insert(it.key() - start + new_start, block);
+	}
+
+	address_ = address_ - start + new_start;
+	qSwap(blocks_, blocks);
+}
+
 //------------------------------------------------------------------------------
 // Name: insert
 //------------------------------------------------------------------------------
@@ -81,7 +99,7 @@ edb::address_t Function::end_address() const {
 // Name: last_instruction
 //------------------------------------------------------------------------------
 edb::address_t Function::last_instruction() const {
-	return back().back()->rva();
+	return back().last_instruction();
 }
 
 //------------------------------------------------------------------------------
@@ -24,12 +24,13 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 // Name: HexStringValidator
 // Desc: constructor
 //------------------------------------------------------------------------------
-HexStringValidator::HexStringValidator(QObject * parent) : QValidator(parent) {
+HexStringValidator::HexStringValidator(QObject * parent) : QValidator(parent), allow_wildcards_(false) {
 }
 
 //------------------------------------------------------------------------------
 // Name: fixup
-// Desc:
+// Desc: keeps only the hex digits (and '?' when wildcards are allowed), two
+//       to a byte
 //------------------------------------------------------------------------------
 void HexStringValidator::fixup(QString &input) const {
 	QString temp;
@@ -37,7 +38,7 @@ void HexStringValidator::fixup(QString &input) const {
 
 	Q_FOREACH(QChar ch, input) {
 		const int c = ch.toLatin1();
-		if(c < 0x80 && std::isxdigit(c)) {
+		if(c < 0x80 && (std::isxdigit(c) || (allow_wildcards_ && c == '?'))) {
 
 			if(index != 0 && (index & 1) == 0) {
 				temp += ' ';
@@ -25,9 +25,15 @@ class HexStringValidator : public QValidator {
 public:
 	HexStringValidator(QObject * parent);
 
+public:
+	void setAllowWildcards(bool allow) { allow_wildcards_ = allow; }
+
 public:
 	virtual void fixup(QString &input) const;
 	virtual State validate(QString &input, int &pos) const;
+
+private:
+	bool allow_wildcards_;
 };
 
 #endif
@@ -0,0 +1,190 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "InstructionCache.h"
+#include "IDebugger.h"
+#include "IProcess.h"
+#include "edb.h"
+
+#include <QMutexLocker>
+
+//------------------------------------------------------------------------------
+// Name: InstructionCache
+// Desc:
+//------------------------------------------------------------------------------
+InstructionCache::InstructionCache(int max_entries) : generation_(0), max_entries_(max_entries) {
+	edb::memory::add_consumer("instruction cache", this);
+}
+
+//------------------------------------------------------------------------------
+// Name: ~InstructionCache
+// Desc:
+//------------------------------------------------------------------------------
+InstructionCache::~InstructionCache() {
+	edb::memory::remove_consumer(this);
+}
+
+//------------------------------------------------------------------------------
+// Name: sync
+// Desc: throws away what was decoded before the process's memory last changed,
+//       returns false if the process can't tell when that is, in which case
+//       nothing may be kept at all
+// Note: lock_ must be held
+//------------------------------------------------------------------------------
+bool InstructionCache::sync() {
+
+	IProcess *const process  = edb::v1::debugger_core ? edb::v1::debugger_core->process() : 0;
+	const quint64 generation = process ? process->memory_generation() : 0;
+
+	if(generation != generation_ || generation == 0) {
+		entries_.clear();
+		generation_ = generation;
+	}
+
+	return generation != 0;
+}
+
+//------------------------------------------------------------------------------
+// Name: lookup
+// Desc: the entry for <address>, if it can stand for a decode of <available>
+//       bytes. A valid instruction can for as long as it fits, truncating the
+//       bytes of an invalid one never makes it valid
+// Note: lock_ must be held
+//------------------------------------------------------------------------------
+InstructionCache::pointer InstructionCache::lookup(edb::address_t address, std::size_t available) const {
+
+	const QHash<edb::address_t, pointer>::const_iterator it = entries_.find(address);
+	if(it != entries_.end()) {
+		const pointer &inst = it.value();
+		if(!*inst || inst->size() <= available) {
+			return inst;
+		}
+	}
+
+	return pointer();
+}
+
+//------------------------------------------------------------------------------
+// Name: insert
+// Desc: keeps <inst>, which was decoded from <available> bytes, unless it was
+//       invalid for lack of bytes rather than because of them
+// Note: lock_ must be held
+//------------------------------------------------------------------------------
+void InstructionCache::insert(edb::address_t address, const pointer &inst, std::size_t available) {
+
+	if(*inst || available >= static_cast<std::size_t>(edb::Instruction::MAX_SIZE)) {
+
+		// the working set of a stop is small, anything far beyond it is most
+		// likely a scan which won't come back this way
+		if(entries_.size() >= max_entries_) {
+			entries_.clear();
+		}
+
+		entries_.insert(address, inst);
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: find
+// Desc: the instruction at <address> decoded from at most <max_size> bytes of
+//       the process's memory, the result is NULL if nothing could be read
+//------------------------------------------------------------------------------
+InstructionCache::pointer InstructionCache::find(edb::address_t address, int max_size) {
+
+	const int size_limit = qBound(0, max_size, static_cast<int>(edb::Instruction::MAX_SIZE));
+
+	QMutexLocker locker(&lock_);
+
+	const bool cacheable = sync();
+	if(cacheable) {
+		if(const pointer inst = lookup(address, size_limit)) {
+			return inst;
+		}
+	}
+
+	quint8 buffer[edb::Instruction::MAX_SIZE];
+	int size = size_limit;
+	if(!edb::v1::get_instruction_bytes(address, buffer, &size) || size == 0) {
+		return pointer();
+	}
+
+	const pointer inst(new edb::Instruction(buffer, buffer + size, address, std::nothrow));
+	if(cacheable) {
+		insert(address, inst, size);
+	}
+
+	return inst;
+}
+
+//------------------------------------------------------------------------------
+// Name: decode
+// Desc: like find, but for when the bytes at <address> have already been read
+//       into [first, last). They must be the process's current memory
+//------------------------------------------------------------------------------
+InstructionCache::pointer InstructionCache::decode(edb::address_t address, const quint8 *first, const quint8 *last) {
+
+	Q_ASSERT(first <= last);
+
+	const std::size_t available = qMin<std::size_t>(last - first, edb::Instruction::MAX_SIZE);
+
+	QMutexLocker locker(&lock_);
+
+	const bool cacheable = sync();
+	if(cacheable) {
+		if(const pointer inst = lookup(address, available)) {
+			return inst;
+		}
+	}
+
+	const pointer inst(new edb::Instruction(first, first + available, address, std::nothrow));
+	if(cacheable) {
+		insert(address, inst, available);
+	}
+
+	return inst;
+}
+
+//------------------------------------------------------------------------------
+// Name: clear
+// Desc:
+//------------------------------------------------------------------------------
+void InstructionCache::clear() {
+	QMutexLocker locker(&lock_);
+	entries_.clear();
+	generation_ = 0;
+}
+
+//------------------------------------------------------------------------------
+// Name: memory_used
+// Desc: the instructions plus their shared pointers and hash nodes, roughly
+//------------------------------------------------------------------------------
+quint64 InstructionCache::memory_used() const {
+	QMutexLocker locker(&lock_);
+	return static_cast<quint64>(entries_.size()) * (sizeof(edb::Instruction) + sizeof(pointer) + 4 * sizeof(void *));
+}
+
+//------------------------------------------------------------------------------
+// Name: trim
+// Desc: nothing here is kept in order of use, and everything is cheap to
+//       decode again, so being asked for less than it holds empties it
+//------------------------------------------------------------------------------
+void InstructionCache::trim(quint64 bytes) {
+	if(memory_used() > bytes) {
+		clear();
+	}
+}
@@ -0,0 +1,163 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "InstructionTextCache.h"
+#include "Fingerprint.h"
+#include "Util.h"
+
+#include <QMutexLocker>
+#include <cstring>
+
+namespace {
+
+struct intel_lower {
+	typedef edisassm::lower_case   case_type;
+	typedef edisassm::syntax_intel syntax_type;
+};
+
+struct intel_upper {
+	typedef edisassm::upper_case   case_type;
+	typedef edisassm::syntax_intel syntax_type;
+};
+
+//------------------------------------------------------------------------------
+// Name: is_relative
+// Desc: true if the text of <inst> depends on where it is, which is the case
+//       for branches with a relative target
+//------------------------------------------------------------------------------
+bool is_relative(const edb::Instruction &inst) {
+	for(std::size_t i = 0; i < inst.operand_count(); ++i) {
+		if(inst.operands()[i].general_type() == edb::Operand::TYPE_REL) {
+			return true;
+		}
+	}
+	return false;
+}
+
+}
+
+//------------------------------------------------------------------------------
+// Name: operator==
+// Desc:
+//------------------------------------------------------------------------------
+bool operator==(const InstructionTextCache::Key &lhs, const InstructionTextCache::Key &rhs) {
+	return lhs.address == rhs.address && lhs.size == rhs.size && lhs.upper == rhs.upper && std::memcmp(lhs.bytes, rhs.bytes, lhs.size) == 0;
+}
+
+//------------------------------------------------------------------------------
+// Name: qHash
+// Desc:
+//------------------------------------------------------------------------------
+uint qHash(const InstructionTextCache::Key &key) {
+	const quint64 seed = static_cast<quint64>(key.address) ^ (static_cast<quint64>(key.upper) << 63);
+	return static_cast<uint>(edb::internal::xxh64(key.bytes, key.size, seed));
+}
+
+//------------------------------------------------------------------------------
+// Name: InstructionTextCache
+// Desc:
+//------------------------------------------------------------------------------
+InstructionTextCache::InstructionTextCache(int max_entries) : text_bytes_(0), max_entries_(max_entries) {
+	edb::memory::add_consumer("instruction text cache", this);
+}
+
+//------------------------------------------------------------------------------
+// Name: ~InstructionTextCache
+// Desc:
+//------------------------------------------------------------------------------
+InstructionTextCache::~InstructionTextCache() {
+	edb::memory::remove_consumer(this);
+}
+
+//------------------------------------------------------------------------------
+// Name: format
+// Desc: sets <text> to <inst> in Intel syntax, upper case if <upper> is set.
+//       <inst> must be valid
+//------------------------------------------------------------------------------
+void InstructionTextCache::format(const edb::Instruction &inst, bool upper, QString *text) {
+
+	Q_ASSERT(inst);
+	Q_ASSERT(text);
+
+	Key key;
+	key.address = is_relative(inst) ? inst.rva() : 0;
+	key.size    = static_cast<quint8>(qMin<std::size_t>(inst.size(), sizeof(key.bytes)));
+	key.upper   = upper;
+	std::memcpy(key.bytes, inst.bytes(), key.size);
+
+	QMutexLocker locker(&lock_);
+
+	const QHash<Key, QString>::const_iterator it = entries_.find(key);
+	if(it != entries_.end()) {
+		*text = it.value();
+		return;
+	}
+
+	const std::string s = upper ? edisassm::to_string(inst, intel_upper()) : edisassm::to_string(inst, intel_lower());
+	util::assign_latin1(text, s.data(), static_cast<int>(s.size()));
+
+	// anything far beyond what is on screen is most likely a scan which won't
+	// come back this way
+	if(entries_.size() >= max_entries_) {
+		entries_.clear();
+		text_bytes_ = 0;
+	}
+
+	entries_.insert(key, *text);
+	text_bytes_ += text->size() * sizeof(QChar);
+}
+
+//------------------------------------------------------------------------------
+// Name: format
+// Desc:
+//------------------------------------------------------------------------------
+QString InstructionTextCache::format(const edb::Instruction &inst, bool upper) {
+	QString text;
+	format(inst, upper, &text);
+	return text;
+}
+
+//------------------------------------------------------------------------------
+// Name: clear
+// Desc:
+//------------------------------------------------------------------------------
+void InstructionTextCache::clear() {
+	QMutexLocker locker(&lock_);
+	entries_.clear();
+	text_bytes_ = 0;
+}
+
+//------------------------------------------------------------------------------
+// Name: memory_used
+// Desc: the keys and the text, plus the hash nodes and string headers, roughly
+//------------------------------------------------------------------------------
+quint64 InstructionTextCache::memory_used() const {
+	QMutexLocker locker(&lock_);
+	return static_cast<quint64>(entries_.size()) * (sizeof(Key) + sizeof(QString) + 6 * sizeof(void *)) + text_bytes_;
+}
+
+//------------------------------------------------------------------------------
+// Name: trim
+// Desc: nothing here is kept in order of use, so being asked for less than it
+//       holds empties it
+//------------------------------------------------------------------------------
+void InstructionTextCache::trim(quint64 bytes) {
+	if(memory_used() > bytes) {
+		clear();
+	}
+}
@@ -0,0 +1,396 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "JitSymbols.h"
+#include "IDebugger.h"
+#include "IProcess.h"
+#include "ISymbolManager.h"
+#include "edb.h"
+
+#include <QByteArray>
+#include <QFile>
+#include <QFileInfo>
+#include <QString>
+#include <cstring>
+
+#if defined(Q_OS_UNIX) && !defined(Q_OS_MAC)
+#include <elf.h>
+#endif
+
+namespace {
+
+// the prefix of every JIT symbol, as if they were all one module's
+const char jit_prefix[] = "jit";
+
+// what the JIT last did, from the GDB JIT interface
+enum {
+	JIT_NOACTION,
+	JIT_REGISTER_FN,
+	JIT_UNREGISTER_FN
+};
+
+// a JIT object is a small ELF file, anything bigger than this is taken to be
+// a corrupt entry
+const quint64 max_symfile_size = Q_UINT64_C(64) << 20;
+
+//------------------------------------------------------------------------------
+// Name: make_symbol
+// Desc:
+//------------------------------------------------------------------------------
+Symbol::pointer make_symbol(const QString &file, const QString &name, edb::address_t address, quint64 size) {
+	Symbol::pointer symbol(new Symbol);
+	symbol->file           = file;
+	symbol->name_no_prefix = name;
+	symbol->name           = QString("%1::%2").arg(jit_prefix, name);
+	symbol->address        = address;
+	symbol->size           = static_cast<quint32>(qMin<quint64>(size, 0xffffffff));
+	symbol->type           = 'T';
+	return symbol;
+}
+
+//------------------------------------------------------------------------------
+// Name: parse_perf_map_line
+// Desc: "START SIZE name", in hex, the name may have spaces in it
+//------------------------------------------------------------------------------
+Symbol::pointer parse_perf_map_line(const QString &file, const QByteArray &line) {
+
+	const int first = line.indexOf(' ');
+	if(first == -1) {
+		return Symbol::pointer();
+	}
+
+	const int second = line.indexOf(' ', first + 1);
+	if(second == -1) {
+		return Symbol::pointer();
+	}
+
+	bool address_ok;
+	bool size_ok;
+	const edb::address_t address = line.left(first).toULongLong(&address_ok, 16);
+	const quint64 size           = line.mid(first + 1, second - first - 1).toULongLong(&size_ok, 16);
+	const QByteArray name        = line.mid(second + 1).trimmed();
+
+	if(!address_ok || !size_ok || address == 0 || name.isEmpty()) {
+		return Symbol::pointer();
+	}
+
+	return make_symbol(file, QString::fromUtf8(name), address, size);
+}
+
+#if defined(Q_OS_UNIX) && !defined(Q_OS_MAC)
+//------------------------------------------------------------------------------
+// Name: read_elf_symbols
+// Desc: the functions in the symbol tables of an in-memory ELF object. JITs
+//       give them at the address the code is at, there is nothing to relocate
+//------------------------------------------------------------------------------
+template <class Ehdr, class Shdr, class Sym>
+void read_elf_symbols(const QByteArray &image, const QString &file, QList<Symbol::pointer> *added) {
+
+	const quint64 size = image.size();
+	const char *const data = image.constData();
+
+	if(size < sizeof(Ehdr)) {
+		return;
+	}
+
+	Ehdr header;
+	std::memcpy(&header, data, sizeof(header));
+
+	if(header.e_shentsize != sizeof(Shdr) || header.e_shoff == 0 || header.e_shoff + static_cast<quint64>(header.e_shnum) * sizeof(Shdr) > size) {
+		return;
+	}
+
+	for(int i = 0; i < header.e_shnum; ++i) {
+		Shdr section;
+		std::memcpy(&section, data + header.e_shoff + i * sizeof(Shdr), sizeof(section));
+
+		if(section.sh_type != SHT_SYMTAB || section.sh_entsize != sizeof(Sym) || section.sh_link >= header.e_shnum) {
+			continue;
+		}
+
+		Shdr strings;
+		std::memcpy(&strings, data + header.e_shoff + section.sh_link * sizeof(Shdr), sizeof(strings));
+
+		if(section.sh_offset + section.sh_size > size || strings.sh_offset + strings.sh_size > size) {
+			continue;
+		}
+
+		const char *const names = data + strings.sh_offset;
+
+		for(quint64 offset = 0; offset + sizeof(Sym) <= section.sh_size; offset += sizeof(Sym)) {
+			Sym sym;
+			std::memcpy(&sym, data + section.sh_offset + offset, sizeof(sym));
+
+			if((sym.st_info & 0xf) != STT_FUNC || sym.st_value == 0 || sym.st_name >= strings.sh_size) {
+				continue;
+			}
+
+			const char *const name = names + sym.st_name;
+			const void *const end  = std::memchr(name, '\0', strings.sh_size - sym.st_name);
+			if(!end || end == name) {
+				continue;
+			}
+
+			added->push_back(make_symbol(file, QString::fromUtf8(name, static_cast<const char *>(end) - name), sym.st_value, sym.st_size));
+		}
+	}
+}
+#endif
+
+}
+
+//------------------------------------------------------------------------------
+// Name: JitSymbols
+// Desc:
+//------------------------------------------------------------------------------
+JitSymbols::JitSymbols() : pid_(0), perf_map_offset_(0), descriptor_(0), breakpoint_address_(0), symbol_generation_(0) {
+}
+
+//------------------------------------------------------------------------------
+// Name: reset
+// Desc: forgets the process, the perf map is read from the start again
+//------------------------------------------------------------------------------
+void JitSymbols::reset() {
+	pid_                = 0;
+	perf_map_offset_    = 0;
+	descriptor_         = 0;
+	breakpoint_address_ = 0;
+	symbol_generation_  = 0;
+	entries_.clear();
+}
+
+//------------------------------------------------------------------------------
+// Name: poll_perf_map
+// Desc: reads the whole lines added to the perf map since the last poll. One
+//       which is still being written is left for the next poll
+//------------------------------------------------------------------------------
+void JitSymbols::poll_perf_map(QList<Symbol::pointer> *added) {
+
+	Q_ASSERT(added);
+
+	IProcess *const process = edb::v1::debugger_core ? edb::v1::debugger_core->process() : 0;
+	if(!process) {
+		return;
+	}
+
+	if(process->pid() != pid_) {
+		pid_             = process->pid();
+		perf_map_offset_ = 0;
+	}
+
+	const QString filename = QString("/tmp/perf-%1.map").arg(pid_);
+
+	QFile file(filename);
+	if(!file.open(QIODevice::ReadOnly)) {
+		return;
+	}
+
+	// a map which got shorter was started over
+	if(file.size() < perf_map_offset_) {
+		perf_map_offset_ = 0;
+	}
+
+	if(file.size() == perf_map_offset_ || !file.seek(perf_map_offset_)) {
+		return;
+	}
+
+	const QByteArray data = file.readAll();
+	const int end = data.lastIndexOf('\n');
+	if(end == -1) {
+		return;
+	}
+
+	int first = 0;
+	while(first <= end) {
+		const int last = data.indexOf('\n', first);
+		if(const Symbol::pointer symbol = parse_perf_map_line(filename, data.mid(first, last - first))) {
+			added->push_back(symbol);
+		}
+		first = last + 1;
+	}
+
+	perf_map_offset_ += end + 1;
+}
+
+//------------------------------------------------------------------------------
+// Name: read_pointer
+// Desc: a pointer of the process's size
+//------------------------------------------------------------------------------
+bool JitSymbols::read_pointer(edb::address_t address, edb::address_t *value) const {
+
+	IProcess *const process = edb::v1::debugger_core ? edb::v1::debugger_core->process() : 0;
+	if(!process) {
+		return false;
+	}
+
+	quint64 pointer = 0;
+	const std::size_t size = qMin<std::size_t>(edb::v1::debugger_core->pointer_size(), sizeof(pointer));
+	if(!process->read_bytes(address, &pointer, size)) {
+		return false;
+	}
+
+	*value = static_cast<edb::address_t>(pointer);
+	return true;
+}
+
+//------------------------------------------------------------------------------
+// Name: attach
+// Desc: looks for the GDB JIT interface in <modules> (by their prefixes). The
+//       objects the JIT registered already are reported as <added>. Modules
+//       are only looked in again once the symbol manager may know more, if
+//       it is found breakpoint_address() is where the JIT says the list
+//       changed
+//------------------------------------------------------------------------------
+bool JitSymbols::attach(const QStringList &modules, QList<Symbol::pointer> *added) {
+
+	Q_ASSERT(added);
+
+#if defined(Q_OS_UNIX) && !defined(Q_OS_MAC)
+	ISymbolManager &symbols = edb::v1::symbol_manager();
+
+	const quint64 generation = symbols.generation();
+	if(attached() || generation == symbol_generation_) {
+		return false;
+	}
+
+	symbol_generation_ = generation;
+
+	Q_FOREACH(const QString &module, modules) {
+		const Symbol::pointer function   = symbols.find(QString("%1::__jit_debug_register_code").arg(module));
+		const Symbol::pointer descriptor = symbols.find(QString("%1::__jit_debug_descriptor").arg(module));
+		if(!function || !descriptor) {
+			continue;
+		}
+
+		descriptor_         = descriptor->address;
+		breakpoint_address_ = function->address;
+
+		// jit_descriptor { uint32_t version; uint32_t action_flag; jit_code_entry *relevant_entry; jit_code_entry *first_entry; }
+		const edb::address_t pointer_size = edb::v1::debugger_core->pointer_size();
+
+		edb::address_t entry = 0;
+		if(!read_pointer(descriptor_ + 8 + pointer_size, &entry)) {
+			return true;
+		}
+
+		// a corrupt list could loop forever
+		QSet<edb::address_t> seen;
+		while(entry && !seen.contains(entry)) {
+			seen.insert(entry);
+			read_entry(entry, added);
+			if(!read_pointer(entry, &entry)) {
+				break;
+			}
+		}
+
+		return true;
+	}
+#else
+	Q_UNUSED(modules);
+	Q_UNUSED(added);
+#endif
+
+	return false;
+}
+
+//------------------------------------------------------------------------------
+// Name: update
+// Desc: called each time the breakpoint is hit, the descriptor says which
+//       object was registered or unregistered. The symbols of an unregistered
+//       one stay until the symbols are cleared, the table can't drop some
+//------------------------------------------------------------------------------
+void JitSymbols::update(QList<Symbol::pointer> *added) {
+
+	Q_ASSERT(added);
+
+	IProcess *const process = edb::v1::debugger_core ? edb::v1::debugger_core->process() : 0;
+	if(!attached() || !process) {
+		return;
+	}
+
+	quint32 action;
+	edb::address_t entry;
+	if(!process->read_bytes(descriptor_ + 4, &action, sizeof(action)) || !read_pointer(descriptor_ + 8, &entry) || !entry) {
+		return;
+	}
+
+	switch(action) {
+	case JIT_REGISTER_FN:
+		read_entry(entry, added);
+		break;
+	case JIT_UNREGISTER_FN:
+		entries_.remove(entry);
+		break;
+	default:
+		break;
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: read_entry
+// Desc: reads the object of one jit_code_entry, unless it was read before
+//------------------------------------------------------------------------------
+void JitSymbols::read_entry(edb::address_t entry, QList<Symbol::pointer> *added) {
+
+#if defined(Q_OS_UNIX) && !defined(Q_OS_MAC)
+	IProcess *const process = edb::v1::debugger_core ? edb::v1::debugger_core->process() : 0;
+	if(!process || entries_.contains(entry)) {
+		return;
+	}
+
+	// jit_code_entry { jit_code_entry *next; jit_code_entry *prev; const char *symfile_addr; uint64_t symfile_size; }
+	const edb::address_t pointer_size = edb::v1::debugger_core->pointer_size();
+
+	edb::address_t symfile = 0;
+	quint64 size           = 0;
+	if(!read_pointer(entry + 2 * pointer_size, &symfile) || !process->read_bytes(entry + 3 * pointer_size, &size, sizeof(size))) {
+		return;
+	}
+
+	if(!symfile || size < EI_NIDENT || size > max_symfile_size) {
+		return;
+	}
+
+	QByteArray image(static_cast<int>(size), '\0');
+	if(!process->read_bytes(symfile, image.data(), image.size())) {
+		return;
+	}
+
+	if(std::memcmp(image.constData(), ELFMAG, SELFMAG) != 0) {
+		return;
+	}
+
+	entries_.insert(entry);
+
+	const QString file = QString("%1@%2").arg(jit_prefix, edb::v1::format_pointer(symfile));
+
+	switch(image[EI_CLASS]) {
+	case ELFCLASS32:
+		read_elf_symbols<Elf32_Ehdr, Elf32_Shdr, Elf32_Sym>(image, file, added);
+		break;
+	case ELFCLASS64:
+		read_elf_symbols<Elf64_Ehdr, Elf64_Shdr, Elf64_Sym>(image, file, added);
+		break;
+	default:
+		break;
+	}
+#else
+	Q_UNUSED(entry);
+	Q_UNUSED(added);
+#endif
+}
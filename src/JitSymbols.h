@@ -0,0 +1,70 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef JITSYMBOLS_20261014_H_
+#define JITSYMBOLS_20261014_H_
+
+#include "Symbol.h"
+#include "Types.h"
+#include <QList>
+#include <QSet>
+#include <QStringList>
+
+// names for the code of JIT compilers, which is otherwise just anonymous
+// executable memory. Two sources are followed:
+//
+// the perf map: JITs which support perf (V8 with --perf-basic-prof, the JVM
+// with perf-map-agent) append a "START SIZE name" line to /tmp/perf-<pid>.map
+// for every function they compile. Each poll only reads the lines added since
+// the last one.
+//
+// the GDB JIT interface: the JIT adds an in-memory ELF object to the list at
+// __jit_debug_descriptor and then calls __jit_debug_register_code. With a
+// breakpoint there the symbol table of each object is read as it is
+// registered.
+//
+// Either way the symbols are handed back in batches for
+// ISymbolManager::add_symbols, under the module prefix "jit"
+class JitSymbols {
+public:
+	JitSymbols();
+
+public:
+	void reset();
+	void poll_perf_map(QList<Symbol::pointer> *added);
+	bool attach(const QStringList &modules, QList<Symbol::pointer> *added);
+	void update(QList<Symbol::pointer> *added);
+
+public:
+	bool attached() const                     { return descriptor_ != 0; }
+	edb::address_t breakpoint_address() const { return breakpoint_address_; }
+
+private:
+	bool read_pointer(edb::address_t address, edb::address_t *value) const;
+	void read_entry(edb::address_t entry, QList<Symbol::pointer> *added);
+
+private:
+	edb::pid_t           pid_;
+	qint64               perf_map_offset_;
+	edb::address_t       descriptor_;
+	edb::address_t       breakpoint_address_;
+	quint64              symbol_generation_;
+	QSet<edb::address_t> entries_;
+};
+
+#endif
@@ -0,0 +1,125 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "LazyPlugin.h"
+#include "DebuggerInternal.h"
+#include "IPlugin.h"
+
+#include <QAction>
+#include <QMenu>
+#include <QPluginLoader>
+#include <QtDebug>
+
+//------------------------------------------------------------------------------
+// Name: LazyPlugin
+// Desc:
+//------------------------------------------------------------------------------
+LazyPlugin::LazyPlugin(const QString &filename, const QString &title, const QList<Action> &actions) : filename_(filename), title_(title), actions_(actions), plugin_(0) {
+}
+
+//------------------------------------------------------------------------------
+// Name: ~LazyPlugin
+// Desc:
+//------------------------------------------------------------------------------
+LazyPlugin::~LazyPlugin() {
+}
+
+//------------------------------------------------------------------------------
+// Name: menu
+// Desc: the stand in menu, built from the metadata alone
+//------------------------------------------------------------------------------
+QMenu *LazyPlugin::menu(QWidget *parent) {
+
+	Q_ASSERT(parent);
+
+	if(!menu_ && !plugin_) {
+		menu_ = new QMenu(title_, parent);
+		for(int i = 0; i < actions_.size(); ++i) {
+			QAction *const action = menu_->addAction(actions_[i].text, this, SLOT(action_triggered()), actions_[i].shortcut);
+			action->setData(i);
+		}
+	}
+
+	return menu_;
+}
+
+//------------------------------------------------------------------------------
+// Name: load
+// Desc: loads and initializes the plugin, if it hasn't been already
+//------------------------------------------------------------------------------
+QObject *LazyPlugin::load() {
+
+	if(!plugin_) {
+		QPluginLoader loader(filename_);
+		loader.setLoadHints(QLibrary::ExportExternalSymbolsHint);
+
+		QObject *const plugin = loader.instance();
+		if(IPlugin *const p = qobject_cast<IPlugin *>(plugin)) {
+			if(edb::internal::register_plugin(filename_, plugin)) {
+				p->init();
+				plugin_ = plugin;
+			}
+		} else {
+			qDebug() << "[load_plugins]" << qPrintable(loader.errorString());
+		}
+	}
+
+	return plugin_;
+}
+
+//------------------------------------------------------------------------------
+// Name: action_triggered
+// Desc: loads the plugin, swaps its menu in for ours and then runs whichever
+//       of its actions matches the one which was picked. Separators don't
+//       count, the metadata lists the other entries in order
+//------------------------------------------------------------------------------
+void LazyPlugin::action_triggered() {
+
+	QAction *const picked = qobject_cast<QAction *>(sender());
+	if(!picked || !menu_) {
+		return;
+	}
+
+	const int index = picked->data().toInt();
+
+	IPlugin *const p = qobject_cast<IPlugin *>(load());
+	if(!p) {
+		return;
+	}
+
+	QMenu *const placeholder = menu_;
+	QMenu *const real_menu   = p->menu(placeholder->parentWidget());
+	if(!real_menu) {
+		return;
+	}
+
+	Q_FOREACH(QWidget *widget, placeholder->menuAction()->associatedWidgets()) {
+		widget->insertAction(placeholder->menuAction(), real_menu->menuAction());
+		widget->removeAction(placeholder->menuAction());
+	}
+
+	placeholder->deleteLater();
+
+	int n = 0;
+	Q_FOREACH(QAction *action, real_menu->actions()) {
+		if(!action->isSeparator() && n++ == index) {
+			action->trigger();
+			break;
+		}
+	}
+}
@@ -0,0 +1,64 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef LAZYPLUGIN_20261014_H_
+#define LAZYPLUGIN_20261014_H_
+
+#include <QKeySequence>
+#include <QList>
+#include <QObject>
+#include <QPointer>
+#include <QString>
+
+class QAction;
+class QMenu;
+class QWidget;
+
+// a plugin whose metadata says what its menu looks like. edb puts up that
+// menu without loading the plugin, and only loads it the first time one of
+// the entries is used. The real menu then takes the place of this one
+class LazyPlugin : public QObject {
+	Q_OBJECT
+
+public:
+	struct Action {
+		QString      text;
+		QKeySequence shortcut;
+	};
+
+public:
+	LazyPlugin(const QString &filename, const QString &title, const QList<Action> &actions);
+	virtual ~LazyPlugin();
+
+public:
+	QString filename() const { return filename_; }
+	QMenu *menu(QWidget *parent);
+	QObject *load();
+
+private Q_SLOTS:
+	void action_triggered();
+
+private:
+	QString          filename_;
+	QString          title_;
+	QList<Action>    actions_;
+	QPointer<QMenu>  menu_;
+	QObject         *plugin_;
+};
+
+#endif
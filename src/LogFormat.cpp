@@ -0,0 +1,285 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "LogFormat.h"
+#include "IDebugger.h"
+#include "IProcess.h"
+#include "edb.h"
+
+namespace {
+
+#if defined(EDB_X86)
+typedef qint32 signed_value_t;
+#elif defined(EDB_X86_64)
+typedef qint64 signed_value_t;
+#endif
+
+// the most of a string which is shown
+const int max_string_length = 128;
+
+//------------------------------------------------------------------------------
+// Name: quoted_string
+// Desc: the bytes up to the first NUL, as a C string literal
+//------------------------------------------------------------------------------
+QString quoted_string(const char *bytes, int length) {
+
+	QString s;
+	s.reserve(length + 2);
+	s += '"';
+
+	for(int i = 0; i < length && bytes[i] != '\0'; ++i) {
+		const quint8 ch = bytes[i];
+		switch(ch) {
+		case '\n': s += "\\n";  break;
+		case '\r': s += "\\r";  break;
+		case '\t': s += "\\t";  break;
+		case '\\': s += "\\\\"; break;
+		case '"':  s += "\\\""; break;
+		default:
+			if(ch >= 0x20 && ch < 0x7f) {
+				s += QChar(ch);
+			} else {
+				s += QString("\\x%1").arg(ch, 2, 16, QChar('0'));
+			}
+			break;
+		}
+	}
+
+	s += '"';
+	return s;
+}
+
+}
+
+//------------------------------------------------------------------------------
+// Name: LogFormat
+// Desc:
+//------------------------------------------------------------------------------
+LogFormat::LogFormat() : valid_(false) {
+}
+
+//------------------------------------------------------------------------------
+// Name: compile
+// Desc: splits <source> into its text and expressions, <state> is only used
+//       to learn the register indexes so any state of the process will do
+//------------------------------------------------------------------------------
+bool LogFormat::compile(const QString &source, const State &state) {
+
+	source_ = source;
+	error_  = ExpressionError();
+	valid_  = false;
+	pieces_.clear();
+
+	QString text;
+	for(int i = 0; i < source.size(); ++i) {
+
+		if(source[i] != '%') {
+			text += source[i];
+			continue;
+		}
+
+		if(i + 1 < source.size() && source[i + 1] == '%') {
+			text += '%';
+			++i;
+			continue;
+		}
+
+		Piece piece;
+		piece.type = Piece::POINTER;
+
+		int open = i + 1;
+		if(open < source.size() && source[open] != '{') {
+			switch(source[open].toLatin1()) {
+			case 'x': piece.type = Piece::HEX;      break;
+			case 'd': piece.type = Piece::SIGNED;   break;
+			case 'u': piece.type = Piece::UNSIGNED; break;
+			case 's': piece.type = Piece::STRING;   break;
+			default:
+				error_ = ExpressionError(ExpressionError::SYNTAX);
+				return false;
+			}
+			++open;
+		}
+
+		if(open >= source.size() || source[open] != '{') {
+			error_ = ExpressionError(ExpressionError::SYNTAX);
+			return false;
+		}
+
+		const int close = source.indexOf('}', open + 1);
+		if(close == -1) {
+			error_ = ExpressionError(ExpressionError::UNBALANCED_BRACES);
+			return false;
+		}
+
+		if(!piece.expression.compile(source.mid(open + 1, close - open - 1), state)) {
+			error_ = piece.expression.error();
+			return false;
+		}
+
+		if(!text.isEmpty()) {
+			Piece text_piece;
+			text_piece.type = Piece::TEXT;
+			text_piece.text = text;
+			pieces_.push_back(text_piece);
+			text.clear();
+		}
+
+		pieces_.push_back(piece);
+		i = close;
+	}
+
+	if(!text.isEmpty()) {
+		Piece text_piece;
+		text_piece.type = Piece::TEXT;
+		text_piece.text = text;
+		pieces_.push_back(text_piece);
+	}
+
+	valid_ = true;
+	return true;
+}
+
+//------------------------------------------------------------------------------
+// Name: format
+// Desc: the expressions are evaluated first, then all of the strings they
+//       point at are read in one batch
+//------------------------------------------------------------------------------
+bool LogFormat::format(const State &state, QString *line) const {
+
+	Q_ASSERT(line);
+
+	if(!valid_) {
+		*line = QString("<%1>").arg(error_.what());
+		return false;
+	}
+
+	bool ok = true;
+
+	QVector<QString>               values(pieces_.size());
+	QVector<IProcess::ReadRequest> requests;
+	QVector<int>                   request_pieces;
+
+	for(int i = 0; i < pieces_.size(); ++i) {
+		const Piece &piece = pieces_[i];
+		if(piece.type == Piece::TEXT) {
+			continue;
+		}
+
+		edb::address_t  value;
+		ExpressionError err;
+		if(!piece.expression.evaluate(state, &value, &err)) {
+			values[i] = QString("<%1>").arg(err.what());
+			ok = false;
+			continue;
+		}
+
+		switch(piece.type) {
+		case Piece::POINTER:
+			values[i] = edb::v1::format_pointer(value);
+			break;
+		case Piece::HEX:
+			values[i] = QString::number(value, 16);
+			break;
+		case Piece::SIGNED:
+			values[i] = QString::number(static_cast<qlonglong>(static_cast<signed_value_t>(value)));
+			break;
+		case Piece::UNSIGNED:
+			values[i] = QString::number(static_cast<qulonglong>(value));
+			break;
+		case Piece::STRING:
+			requests.push_back(IProcess::ReadRequest(value, 0, max_string_length));
+			request_pieces.push_back(i);
+			break;
+		default:
+			break;
+		}
+	}
+
+	if(!requests.isEmpty()) {
+		IProcess *const process = edb::v1::debugger_core ? edb::v1::debugger_core->process() : 0;
+
+		QByteArray strings(requests.size() * max_string_length, '\0');
+		for(int i = 0; i < requests.size(); ++i) {
+			requests[i].buffer = strings.data() + i * max_string_length;
+		}
+
+		const QVector<bool> read = process ? process->read_batch(requests) : QVector<bool>(requests.size(), false);
+
+		for(int i = 0; i < requests.size(); ++i) {
+			const IProcess::ReadRequest &request = requests[i];
+
+			// a short string at the end of a mapping, only what is left of
+			// its page can be read
+			int length = max_string_length;
+			if(!read[i]) {
+				const edb::address_t page_size = edb::v1::debugger_core ? edb::v1::debugger_core->page_size() : 0;
+				const edb::address_t left      = page_size ? page_size - (request.address % page_size) : 0;
+
+				if(process && left != 0 && left < static_cast<edb::address_t>(max_string_length) && process->read_bytes(request.address, request.buffer, left)) {
+					length = static_cast<int>(left);
+				} else {
+					values[request_pieces[i]] = QString("<%1>").arg(ExpressionError(ExpressionError::CANNOT_READ_MEMORY).what());
+					ok = false;
+					continue;
+				}
+			}
+
+			values[request_pieces[i]] = quoted_string(static_cast<const char *>(request.buffer), length);
+		}
+	}
+
+	line->clear();
+	for(int i = 0; i < pieces_.size(); ++i) {
+		if(pieces_[i].type == Piece::TEXT) {
+			*line += pieces_[i].text;
+		} else {
+			*line += values[i];
+		}
+	}
+
+	return ok;
+}
+
+//------------------------------------------------------------------------------
+// Name: stale
+// Desc:
+//------------------------------------------------------------------------------
+bool LogFormat::stale() const {
+	Q_FOREACH(const Piece &piece, pieces_) {
+		if(piece.type != Piece::TEXT && piece.expression.stale()) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+//------------------------------------------------------------------------------
+// Name: has_named_variables
+// Desc:
+//------------------------------------------------------------------------------
+bool LogFormat::has_named_variables() const {
+	Q_FOREACH(const Piece &piece, pieces_) {
+		if(piece.type != Piece::TEXT && piece.expression.has_named_variables()) {
+			return true;
+		}
+	}
+
+	return false;
+}
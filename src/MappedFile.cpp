@@ -0,0 +1,163 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "MappedFile.h"
+
+#include <QDateTime>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QWeakPointer>
+
+#if defined(Q_OS_UNIX)
+#include <sys/types.h>
+#include <sys/stat.h>
+#endif
+
+struct MappedFile::Mapping {
+	QFile        file;
+	const uchar *data;
+	qint64       size;
+};
+
+namespace {
+
+QMutex g_MappingLock;
+
+//------------------------------------------------------------------------------
+// Name: file_key
+// Desc: two names for one file share a key, and rewriting a file changes it.
+//       Empty if the file can't be looked at
+//------------------------------------------------------------------------------
+QString file_key(const QString &filename) {
+#if defined(Q_OS_UNIX)
+	struct stat info;
+	if(::stat(QFile::encodeName(filename).constData(), &info) != 0 || !S_ISREG(info.st_mode)) {
+		return QString();
+	}
+
+	return QString("%1:%2:%3:%4")
+		.arg(static_cast<quint64>(info.st_dev))
+		.arg(static_cast<quint64>(info.st_ino))
+		.arg(static_cast<qint64>(info.st_mtime))
+		.arg(static_cast<qint64>(info.st_size));
+#else
+	const QFileInfo info(filename);
+	if(!info.isFile()) {
+		return QString();
+	}
+
+	return QString("%1:%2:%3")
+		.arg(info.canonicalFilePath())
+		.arg(info.lastModified().toTime_t())
+		.arg(info.size());
+#endif
+}
+
+}
+
+//------------------------------------------------------------------------------
+// Name: MappedFile
+// Desc:
+//------------------------------------------------------------------------------
+MappedFile::MappedFile() {
+}
+
+//------------------------------------------------------------------------------
+// Name: open
+// Desc: maps <filename>, or shares the mapping someone else already has. The
+//       result isn't open if the file can't be mapped
+//------------------------------------------------------------------------------
+MappedFile MappedFile::open(const QString &filename) {
+
+	MappedFile result;
+
+	const QString key = file_key(filename);
+	if(key.isEmpty()) {
+		return result;
+	}
+
+	typedef QHash<QString, QWeakPointer<Mapping> > MappingTable;
+
+	// symbols are generated on several threads at once
+	static MappingTable mappings;
+	QMutexLocker locker(&g_MappingLock);
+
+	MappingTable::iterator it = mappings.find(key);
+	if(it != mappings.end()) {
+		result.mapping_ = it->toStrongRef();
+		if(result.mapping_) {
+			return result;
+		}
+		mappings.erase(it);
+	}
+
+	QSharedPointer<Mapping> mapping(new Mapping);
+	mapping->file.setFileName(filename);
+	mapping->data = 0;
+	mapping->size = 0;
+
+	if(!mapping->file.open(QIODevice::ReadOnly)) {
+		return result;
+	}
+
+	mapping->size = mapping->file.size();
+	if(mapping->size <= 0 || !(mapping->data = mapping->file.map(0, mapping->size))) {
+		return result;
+	}
+
+	// drop whatever has expired while we are here, so files which keep
+	// changing don't leave a trail of entries behind
+	for(MappingTable::iterator entry = mappings.begin(); entry != mappings.end();) {
+		if(entry->isNull()) {
+			entry = mappings.erase(entry);
+		} else {
+			++entry;
+		}
+	}
+
+	mappings.insert(key, mapping);
+	result.mapping_ = mapping;
+	return result;
+}
+
+//------------------------------------------------------------------------------
+// Name: data
+// Desc:
+//------------------------------------------------------------------------------
+const uchar *MappedFile::data() const {
+	return mapping_ ? mapping_->data : 0;
+}
+
+//------------------------------------------------------------------------------
+// Name: size
+// Desc:
+//------------------------------------------------------------------------------
+qint64 MappedFile::size() const {
+	return mapping_ ? mapping_->size : 0;
+}
+
+//------------------------------------------------------------------------------
+// Name: filename
+// Desc:
+//------------------------------------------------------------------------------
+QString MappedFile::filename() const {
+	return mapping_ ? mapping_->file.fileName() : QString();
+}
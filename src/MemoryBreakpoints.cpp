@@ -0,0 +1,276 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "MemoryBreakpoints.h"
+#include "IDebugger.h"
+#include "IRegion.h"
+#include "MemoryRegions.h"
+#include "edb.h"
+
+//------------------------------------------------------------------------------
+// Name: MemoryBreakpoints
+// Desc:
+//------------------------------------------------------------------------------
+MemoryBreakpoints::MemoryBreakpoints() : hit_(false), hit_address_(0) {
+}
+
+//------------------------------------------------------------------------------
+// Name: page_size
+// Desc:
+//------------------------------------------------------------------------------
+edb::address_t MemoryBreakpoints::page_size() const {
+	return edb::v1::debugger_core->page_size();
+}
+
+//------------------------------------------------------------------------------
+// Name: protect
+// Desc: makes <page> fault on whatever we are watching it for
+//------------------------------------------------------------------------------
+bool MemoryBreakpoints::protect(edb::address_t page, const Page &info) const {
+	if(info.protect_reads) {
+		return edb::v1::debugger_core->set_page_permissions(page, page_size(), false, false, false);
+	}
+	return edb::v1::debugger_core->set_page_permissions(page, page_size(), info.read, false, info.execute);
+}
+
+//------------------------------------------------------------------------------
+// Name: unprotect
+// Desc: gives <page> back the permissions it had before we protected it
+//------------------------------------------------------------------------------
+bool MemoryBreakpoints::unprotect(edb::address_t page, const Page &info) const {
+	return edb::v1::debugger_core->set_page_permissions(page, page_size(), info.read, info.write, info.execute);
+}
+
+//------------------------------------------------------------------------------
+// Name: update_pages
+// Desc: protects the pages the ranges cover and releases the ones they no
+//       longer do, a page is read protected if any range on it is ACCESS
+// Note: the original permissions are kept from the first time a page is
+//       protected, the memory map shows our permissions after that
+//------------------------------------------------------------------------------
+bool MemoryBreakpoints::update_pages() {
+
+	const edb::address_t size = page_size();
+
+	QHash<edb::address_t, bool> wanted;
+	Q_FOREACH(const Range &range, ranges_) {
+		for(edb::address_t page = range.start & ~(size - 1); page < range.end; page += size) {
+			wanted[page] = wanted.value(page) || range.type == ACCESS;
+			if(page + size < page) {
+				break;
+			}
+		}
+	}
+
+	bool ok = true;
+
+	QHash<edb::address_t, Page>::iterator it = pages_.begin();
+	while(it != pages_.end()) {
+		if(!wanted.contains(it.key())) {
+			unprotect(it.key(), it.value());
+			it = pages_.erase(it);
+		} else {
+			++it;
+		}
+	}
+
+	for(QHash<edb::address_t, bool>::const_iterator want = wanted.begin(); want != wanted.end(); ++want) {
+		const edb::address_t page = want.key();
+
+		it = pages_.find(page);
+		if(it != pages_.end()) {
+			if(it->protect_reads != want.value()) {
+				it->protect_reads = want.value();
+				ok = protect(page, *it) && ok;
+			}
+			continue;
+		}
+
+		const IRegion::pointer region = edb::v1::memory_regions().find_region(page);
+		if(!region) {
+			ok = false;
+			continue;
+		}
+
+		const Page info = { region->readable(), region->writable(), region->executable(), want.value() };
+
+		// writes to a read-only page fault all by themselves
+		if(!info.protect_reads && !info.write) {
+			continue;
+		}
+
+		if(protect(page, info)) {
+			pages_.insert(page, info);
+		} else {
+			ok = false;
+		}
+	}
+
+	return ok;
+}
+
+//------------------------------------------------------------------------------
+// Name: protects
+// Desc: true if reading (or, if <write>, writing) any of the <size> bytes at
+//       <address> would fault on one of the pages we protected, whether or
+//       not it would be a hit
+//------------------------------------------------------------------------------
+bool MemoryBreakpoints::protects(edb::address_t address, edb::address_t size, bool write) const {
+
+	if(pages_.isEmpty() || size == 0) {
+		return false;
+	}
+
+	const edb::address_t page_bytes = page_size();
+	const edb::address_t last       = (address + size - 1) & ~(page_bytes - 1);
+
+	for(edb::address_t page = address & ~(page_bytes - 1); ; page += page_bytes) {
+		const QHash<edb::address_t, Page>::const_iterator it = pages_.find(page);
+		if(it != pages_.end() && (write || it->protect_reads)) {
+			return true;
+		}
+
+		if(page >= last) {
+			break;
+		}
+	}
+
+	return false;
+}
+
+//------------------------------------------------------------------------------
+// Name: add
+// Desc: watches <size> bytes at <address>, returns false if the pages they
+//       are on couldn't be protected
+//------------------------------------------------------------------------------
+bool MemoryBreakpoints::add(edb::address_t address, edb::address_t size, Type type) {
+
+	if(size == 0 || !edb::v1::debugger_core->process()) {
+		return false;
+	}
+
+	const Range range = { address, address + size, type };
+	ranges_.push_back(range);
+
+	if(!update_pages()) {
+		ranges_.removeLast();
+		update_pages();
+		return false;
+	}
+
+	return true;
+}
+
+//------------------------------------------------------------------------------
+// Name: remove_all
+// Desc: removes every range and gives the pages their permissions back
+//------------------------------------------------------------------------------
+void MemoryBreakpoints::remove_all() {
+	ranges_.clear();
+	update_pages();
+}
+
+//------------------------------------------------------------------------------
+// Name: reset
+// Desc: forgets everything without touching the process, for when it is gone
+//------------------------------------------------------------------------------
+void MemoryBreakpoints::reset() {
+	ranges_.clear();
+	pages_.clear();
+	stepping_.clear();
+	hit_         = false;
+	hit_address_ = 0;
+}
+
+//------------------------------------------------------------------------------
+// Name: is_hit
+// Desc: a fault doesn't say whether it was a read or a write, on a page which
+//       is read protected a read of a WRITE range counts as a hit too
+//------------------------------------------------------------------------------
+bool MemoryBreakpoints::is_hit(edb::address_t address) const {
+	Q_FOREACH(const Range &range, ranges_) {
+		if(address >= range.start && address < range.end) {
+			return true;
+		}
+	}
+	return false;
+}
+
+//------------------------------------------------------------------------------
+// Name: handle_fault
+// Desc: if <event> is a fault on one of our pages, the page is made accessible
+//       and true is returned, the faulting instruction should then be stepped
+//------------------------------------------------------------------------------
+bool MemoryBreakpoints::handle_fault(const IDebugEvent::const_pointer &event) {
+
+	edb::address_t address;
+	if(pages_.isEmpty() || !event->access_violation(&address)) {
+		return false;
+	}
+
+	const edb::address_t page = address & ~(page_size() - 1);
+
+	QHash<edb::address_t, Page>::const_iterator it = pages_.constFind(page);
+	if(it == pages_.constEnd() || stepping_.contains(page)) {
+		return false;
+	}
+
+	if(!hit_ && is_hit(address)) {
+		hit_         = true;
+		hit_address_ = address;
+	}
+
+	// an instruction may touch more than one of our pages, each of them
+	// faults in turn until they are all accessible
+	unprotect(page, *it);
+	stepping_.insert(page);
+	return true;
+}
+
+//------------------------------------------------------------------------------
+// Name: handle_step
+// Desc: once the faulting instruction has been stepped, its pages are
+//       protected again. Returns true if <event> is the end of that step,
+//       <hit> says if it touched a watched range and <address> where
+//------------------------------------------------------------------------------
+bool MemoryBreakpoints::handle_step(const IDebugEvent::const_pointer &event, bool *hit, edb::address_t *address) {
+
+	Q_ASSERT(hit);
+	Q_ASSERT(address);
+
+	if(stepping_.isEmpty()) {
+		return false;
+	}
+
+	Q_FOREACH(edb::address_t page, stepping_) {
+		QHash<edb::address_t, Page>::const_iterator it = pages_.constFind(page);
+		if(it != pages_.constEnd()) {
+			protect(page, *it);
+		}
+	}
+
+	stepping_.clear();
+
+	const bool stepped = event->stopped() && event->is_trap() && event->trap_reason() == IDebugEvent::TRAP_STEPPING;
+
+	*hit         = stepped && hit_;
+	*address     = hit_address_;
+	hit_         = false;
+	hit_address_ = 0;
+	return stepped;
+}
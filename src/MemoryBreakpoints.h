@@ -0,0 +1,90 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef MEMORYBREAKPOINTS_20261014_H_
+#define MEMORYBREAKPOINTS_20261014_H_
+
+#include "IDebugEvent.h"
+#include "Types.h"
+#include <QHash>
+#include <QList>
+#include <QSet>
+
+// breakpoints on ranges of memory of any size. The pages holding a range are
+// made inaccessible (or read-only, if only writes are watched) so that
+// touching them faults. A fault is stepped past with the page accessible
+// again, and it is only a hit if the address which faulted is inside one of
+// the ranges, everything else on those pages runs on without stopping.
+//
+// Threads which run while a page is accessible (non-stop mode) can touch
+// it unseen, and system calls given a watched buffer fail with EFAULT rather
+// than faulting
+class MemoryBreakpoints {
+public:
+	enum Type {
+		ACCESS,
+		WRITE
+	};
+
+	struct Range {
+		edb::address_t start;
+		edb::address_t end;
+		Type           type;
+	};
+
+public:
+	MemoryBreakpoints();
+
+private:
+	Q_DISABLE_COPY(MemoryBreakpoints)
+
+public:
+	bool add(edb::address_t address, edb::address_t size, Type type);
+	void remove_all();
+	void reset();
+	const QList<Range> &ranges() const { return ranges_; }
+	bool protects(edb::address_t address, edb::address_t size, bool write) const;
+
+public:
+	bool handle_fault(const IDebugEvent::const_pointer &event);
+	bool handle_step(const IDebugEvent::const_pointer &event, bool *hit, edb::address_t *address);
+
+private:
+	struct Page {
+		bool read;
+		bool write;
+		bool execute;
+		bool protect_reads;
+	};
+
+private:
+	edb::address_t page_size() const;
+	bool protect(edb::address_t page, const Page &info) const;
+	bool unprotect(edb::address_t page, const Page &info) const;
+	bool is_hit(edb::address_t address) const;
+	bool update_pages();
+
+private:
+	QList<Range>                 ranges_;
+	QHash<edb::address_t, Page>  pages_;
+	QSet<edb::address_t>         stepping_;
+	bool                         hit_;
+	edb::address_t               hit_address_;
+};
+
+#endif
@@ -0,0 +1,181 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "MemoryBudget.h"
+#include "Configuration.h"
+#include "Diagnostics.h"
+#include "edb.h"
+
+#include <QFile>
+#include <QList>
+#include <QPair>
+
+#include <algorithm>
+
+#if defined(Q_OS_LINUX)
+#include <unistd.h>
+#endif
+
+namespace {
+
+typedef QPair<QString, edb::memory::Consumer *> Entry;
+
+//------------------------------------------------------------------------------
+// Name: consumers
+// Desc: never destroyed, static caches may remove themselves after main
+//------------------------------------------------------------------------------
+QList<Entry> &consumers() {
+	static QList<Entry> *const list = new QList<Entry>;
+	return *list;
+}
+
+// a consumer and what it said it holds, for sorting the biggest first
+struct Sized {
+	edb::memory::Consumer *consumer;
+	quint64                bytes;
+};
+
+//------------------------------------------------------------------------------
+// Name: bigger
+// Desc:
+//------------------------------------------------------------------------------
+bool bigger(const Sized &lhs, const Sized &rhs) {
+	return lhs.bytes > rhs.bytes;
+}
+
+//------------------------------------------------------------------------------
+// Name: usage_bigger
+// Desc:
+//------------------------------------------------------------------------------
+bool usage_bigger(const edb::memory::Usage &lhs, const edb::memory::Usage &rhs) {
+	return lhs.bytes > rhs.bytes;
+}
+
+}
+
+namespace edb {
+namespace memory {
+
+//------------------------------------------------------------------------------
+// Name: add_consumer
+// Desc: <consumer> must be removed before it is destroyed
+//------------------------------------------------------------------------------
+void add_consumer(const QString &name, Consumer *consumer) {
+	consumers().push_back(qMakePair(name, consumer));
+}
+
+//------------------------------------------------------------------------------
+// Name: remove_consumer
+// Desc:
+//------------------------------------------------------------------------------
+void remove_consumer(Consumer *consumer) {
+	QList<Entry> &list = consumers();
+	for(QList<Entry>::iterator it = list.begin(); it != list.end(); ) {
+		if(it->second == consumer) {
+			it = list.erase(it);
+		} else {
+			++it;
+		}
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: budget
+// Desc:
+//------------------------------------------------------------------------------
+quint64 budget() {
+	return static_cast<quint64>(edb::v1::config().memory_budget) << 20;
+}
+
+//------------------------------------------------------------------------------
+// Name: enforce
+// Desc: trims the biggest consumers first, each by as much as the whole is
+//       over, so that a small cache isn't emptied for a big one's sake
+//------------------------------------------------------------------------------
+void enforce() {
+
+	const quint64 limit = budget();
+	if(limit == 0) {
+		return;
+	}
+
+	static diagnostics::Counter *const trims = diagnostics::counter("memory budget: bytes trimmed");
+
+	QList<Sized> sizes;
+	quint64 total = 0;
+	Q_FOREACH(const Entry &entry, consumers()) {
+		const Sized sized = { entry.second, entry.second->memory_used() };
+		sizes.push_back(sized);
+		total += sized.bytes;
+	}
+
+	if(total <= limit) {
+		return;
+	}
+
+	std::sort(sizes.begin(), sizes.end(), bigger);
+
+	Q_FOREACH(const Sized &sized, sizes) {
+		if(total <= limit) {
+			break;
+		}
+
+		const quint64 excess = total - limit;
+		sized.consumer->trim(sized.bytes > excess ? sized.bytes - excess : 0);
+
+		const quint64 now = qMin(sized.consumer->memory_used(), sized.bytes);
+		diagnostics::add(trims, sized.bytes - now);
+		total -= sized.bytes - now;
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: usage
+// Desc: what each consumer holds, the biggest first
+//------------------------------------------------------------------------------
+QList<Usage> usage() {
+	QList<Usage> ret;
+	Q_FOREACH(const Entry &entry, consumers()) {
+		const Usage u = { entry.first, entry.second->memory_used() };
+		ret.push_back(u);
+	}
+
+	std::sort(ret.begin(), ret.end(), usage_bigger);
+	return ret;
+}
+
+//------------------------------------------------------------------------------
+// Name: resident_size
+// Desc:
+//------------------------------------------------------------------------------
+quint64 resident_size() {
+#if defined(Q_OS_LINUX)
+	QFile file("/proc/self/statm");
+	if(file.open(QIODevice::ReadOnly)) {
+		// the size of the whole mapping, then how much of it is resident, in pages
+		const QList<QByteArray> fields = file.readAll().split(' ');
+		if(fields.size() > 1) {
+			return fields[1].toULongLong() * sysconf(_SC_PAGESIZE);
+		}
+	}
+#endif
+	return 0;
+}
+
+}
+}
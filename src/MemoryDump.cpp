@@ -0,0 +1,134 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "MemoryDump.h"
+#include "IDebugger.h"
+#include "RegionReader.h"
+#include "edb.h"
+
+#include <QByteArray>
+
+namespace {
+
+//------------------------------------------------------------------------------
+// Name: write_all
+// Desc: unbuffered writes may be short, keeps going until all of it is out
+//------------------------------------------------------------------------------
+bool write_all(QFile *file, const void *data, qint64 size) {
+
+	const char *p = static_cast<const char *>(data);
+
+	while(size != 0) {
+		const qint64 n = file->write(p, size);
+		if(n <= 0) {
+			return false;
+		}
+
+		p    += n;
+		size -= n;
+	}
+
+	return true;
+}
+
+//------------------------------------------------------------------------------
+// Name: write_fill
+// Desc: writes <size> 0xff bytes, for the parts of a region which can't be read
+//------------------------------------------------------------------------------
+bool write_fill(QFile *file, qint64 size) {
+
+	if(size == 0) {
+		return true;
+	}
+
+	const qint64 window = MemoryDump::WindowPages * edb::v1::debugger_core->page_size();
+	const QByteArray fill(static_cast<int>(qMin(size, window)), static_cast<char>(0xff));
+
+	while(size != 0) {
+		const qint64 n = qMin<qint64>(size, fill.size());
+		if(!write_all(file, fill.constData(), n)) {
+			return false;
+		}
+		size -= n;
+	}
+
+	return true;
+}
+
+}
+
+//------------------------------------------------------------------------------
+// Name: write_region
+// Desc: appends all of <region> to <file>, exactly region->size() bytes of it
+//       if this returns true. <file> should be opened as QIODevice::Unbuffered
+//       or each window is copied once more on its way out
+//------------------------------------------------------------------------------
+bool MemoryDump::write_region(QFile *file, const IRegion::pointer &region) {
+
+	Q_ASSERT(file);
+	Q_ASSERT(region);
+
+	if(!edb::v1::debugger_core) {
+		return false;
+	}
+
+	edb::address_t written = region->start();
+
+	RegionReader reader(region, 0, WindowPages);
+	while(reader.next()) {
+		if(!write_fill(file, reader.address() - written)) {
+			return false;
+		}
+
+		if(!write_all(file, reader.data(), reader.size())) {
+			return false;
+		}
+
+		written = reader.address() + reader.size();
+	}
+
+	return write_fill(file, region->end() - written);
+}
+
+//------------------------------------------------------------------------------
+// Name: save_region
+// Desc: writes the contents of <region> to <filename>, on failure <error> says
+//       why
+//------------------------------------------------------------------------------
+bool MemoryDump::save_region(const IRegion::pointer &region, const QString &filename, QString *error) {
+
+	Q_ASSERT(error);
+
+	if(!region) {
+		*error = tr("There is no memory region to save.");
+		return false;
+	}
+
+	QFile file(filename);
+	if(!file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Unbuffered)) {
+		*error = tr("Could not open %1 for writing: %2").arg(filename, file.errorString());
+		return false;
+	}
+
+	if(!write_region(&file, region)) {
+		*error = tr("Could not write the region to %1: %2").arg(filename, file.errorString());
+		return false;
+	}
+
+	return true;
+}
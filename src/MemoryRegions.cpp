@@ -16,18 +16,48 @@ You should have received a copy of the GNU General Public License
 along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+#include "Diagnostics.h"
 #include "IDebugger.h"
 #include "ISymbolManager.h"
 #include "MemoryRegions.h"
+#include "Trace.h"
 #include "edb.h"
 
 #include <QDebug>
+#include <QTimer>
+
+#include <algorithm>
+#include <climits>
+
+namespace {
+
+//------------------------------------------------------------------------------
+// Name: region_before
+// Desc: orders regions by start address
+//------------------------------------------------------------------------------
+bool region_before(const IRegion::pointer &a, const IRegion::pointer &b) {
+	return a->start() < b->start();
+}
+
+//------------------------------------------------------------------------------
+// Name: address_before
+// Desc: ordering predicate for std::upper_bound over the region index
+//------------------------------------------------------------------------------
+template <class Range>
+bool address_before(edb::address_t address, const Range &range) {
+	return address < range.start;
+}
+
+}
 
 //------------------------------------------------------------------------------
 // Name: MemoryRegions
 // Desc: constructor
 //------------------------------------------------------------------------------
-MemoryRegions::MemoryRegions() : QAbstractItemModel(0) {
+MemoryRegions::MemoryRegions() : QAbstractItemModel(0), last_hit_(-1), usage_timer_(new QTimer(this)), usage_generation_(0) {
+	usage_timer_->setSingleShot(true);
+	usage_timer_->setInterval(0);
+	connect(usage_timer_, SIGNAL(timeout()), this, SLOT(fetch_usage()));
 }
 
 //------------------------------------------------------------------------------
@@ -42,40 +72,229 @@ MemoryRegions::~MemoryRegions() {
 // Desc:
 //------------------------------------------------------------------------------
 void MemoryRegions::clear() {
+	beginResetModel();
 	regions_.clear();
+	rebuild_index();
+	usage_.clear();
+	usage_wanted_.clear();
+	endResetModel();
+}
+
+//------------------------------------------------------------------------------
+// Name: rebuild_index
+// Desc: refreshes the flat copy of the region bounds used by find_region
+//------------------------------------------------------------------------------
+void MemoryRegions::rebuild_index() {
+	index_.resize(regions_.size());
+	for(int i = 0; i < regions_.size(); ++i) {
+		index_[i].start = regions_[i]->start();
+		index_[i].end   = regions_[i]->end();
+	}
+	last_hit_ = -1;
+}
+
+//------------------------------------------------------------------------------
+// Name: row_of
+// Desc: the row of the region starting at <start>, or -1
+//------------------------------------------------------------------------------
+int MemoryRegions::row_of(edb::address_t start) const {
+
+	QVector<Range>::const_iterator it = std::upper_bound(index_.begin(), index_.end(), start, address_before<Range>);
+	if(it != index_.begin()) {
+		--it;
+		if(it->start == start) {
+			return it - index_.begin();
+		}
+	}
+
+	return -1;
+}
+
+//------------------------------------------------------------------------------
+// Name: load_symbols
+// Desc: if the region has a name, is mapped starting at the beginning of the
+//       file, and is executable, sounds like a module mapping!
+//------------------------------------------------------------------------------
+void MemoryRegions::load_symbols(const IRegion::pointer &region) {
+	if(!region->name().isEmpty()) {
+		if(region->base() == 0) {
+			if(region->executable()) {
+				edb::v1::symbol_manager().load_symbol_file(region->name(), region->start());
+			}
+		}
+	}
 }
 
 //------------------------------------------------------------------------------
 // Name: sync
-// Desc: reads a memory map file line by line
+// Desc: brings the region list up to date with the process. Only the regions
+//       which actually changed are removed/inserted, so views keep their
+//       selection and symbols are only loaded for newly mapped modules. A
+//       mapping which just changed its permissions or size is updated where
+//       it is
 //------------------------------------------------------------------------------
 void MemoryRegions::sync() {
 
-	beginResetModel();
+	EDB_TRACE_SCOPE("MemoryRegions::sync");
+
+	static edb::diagnostics::Counter *const sync_timer = edb::diagnostics::timer("MemoryRegions::sync");
+	edb::diagnostics::ScopedTimer timer(sync_timer);
 
 	QList<IRegion::pointer> regions;
-	
+
 	if(edb::v1::debugger_core) {
 		if(IProcess *process = edb::v1::debugger_core->process()) {
 			regions = process->regions();
-			Q_FOREACH(const IRegion::pointer &region, regions) {
-				// if the region has a name, is mapped starting
-				// at the beginning of the file, and is executable, sounds
-				// like a module mapping!
-				if(!region->name().isEmpty()) {
-					if(region->base() == 0) {
-						if(region->executable()) {
-							edb::v1::symbol_manager().load_symbol_file(region->name(), region->start());
-						}
-					}
-				}
+		}
+	}
+
+	// the merge below relies on both lists being in address order
+	std::sort(regions.begin(), regions.end(), region_before);
+
+	// RSS and PSS may have changed whether or not the regions did
+	++usage_generation_;
+
+	bool changed = false;
+
+	int row = 0;
+	int i   = 0;
+	while(row < regions_.size() || i < regions.size()) {
+
+		if(row < regions_.size() && i < regions.size()) {
+			const IRegion::pointer &old_region = regions_[row];
+			const IRegion::pointer &new_region = regions[i];
+			if(old_region == new_region || old_region->compare(new_region) == 0) {
+				++row;
+				++i;
+				continue;
+			}
+
+			if(old_region->start() == new_region->start() && old_region->name() == new_region->name()) {
+				regions_[row] = new_region;
+				Q_EMIT dataChanged(index(row, 0), index(row, columnCount() - 1));
+				changed = true;
+				++row;
+				++i;
+				continue;
 			}
 		}
+
+		// since the lists are sorted and regions don't overlap, an old region
+		// which starts at or before the next new one can't be in the new list
+		if(i == regions.size() || (row < regions_.size() && regions_[row]->start() <= regions[i]->start())) {
+			int last = row;
+			while(last + 1 < regions_.size() && (i == regions.size() || regions_[last + 1]->start() < regions[i]->start())) {
+				++last;
+			}
+
+			beginRemoveRows(QModelIndex(), row, last);
+			regions_.erase(regions_.begin() + row, regions_.begin() + last + 1);
+			endRemoveRows();
+			changed = true;
+			continue;
+		}
+
+		// new regions which come one after another go in together, which is
+		// all of them when there were none before
+		int last = i;
+		while(last + 1 < regions.size() && (row == regions_.size() || regions[last + 1]->start() < regions_[row]->start())) {
+			++last;
+		}
+
+		beginInsertRows(QModelIndex(), row, row + (last - i));
+		for(int j = i; j <= last; ++j) {
+			regions_.insert(row + (j - i), regions[j]);
+		}
+		endInsertRows();
+
+		for(int j = i; j <= last; ++j) {
+			load_symbols(regions[j]);
+		}
+
+		changed = true;
+
+		row += last - i + 1;
+		i    = last + 1;
 	}
 
+	if(changed) {
+		rebuild_index();
 
-	qSwap(regions_, regions);
-	endResetModel();
+		QHash<edb::address_t, Usage>::iterator it = usage_.begin();
+		while(it != usage_.end()) {
+			if(row_of(it.key()) == -1) {
+				it = usage_.erase(it);
+			} else {
+				++it;
+			}
+		}
+	}
+
+	// only the rows being looked at will ask for theirs again
+	if(!usage_.isEmpty() && !regions_.isEmpty()) {
+		Q_EMIT dataChanged(index(0, 4), index(regions_.size() - 1, 5));
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: usage
+// Desc: the RSS or PSS of <region> in KiB, depending on <column>. Anything
+//       not found since the last sync is asked for, all together, once the
+//       view has asked for everything it is showing
+//------------------------------------------------------------------------------
+QVariant MemoryRegions::usage(const IRegion::pointer &region, int column) const {
+
+	const QHash<edb::address_t, Usage>::const_iterator it = usage_.find(region->start());
+	if(it == usage_.end() || it->generation != usage_generation_) {
+		usage_wanted_.insert(region->start());
+		usage_timer_->start();
+	}
+
+	if(it == usage_.end() || !it->known) {
+		return QVariant();
+	}
+
+	const quint64 bytes = (column == 4) ? it->usage.resident : it->usage.proportional;
+	return static_cast<qulonglong>(bytes / 1024);
+}
+
+//------------------------------------------------------------------------------
+// Name: fetch_usage
+// Desc: finds the usage of every region asked about since the last time
+//------------------------------------------------------------------------------
+void MemoryRegions::fetch_usage() {
+
+	if(usage_wanted_.isEmpty() || !edb::v1::debugger_core) {
+		return;
+	}
+
+	const QList<edb::address_t> starts = usage_wanted_.toList();
+	usage_wanted_.clear();
+
+	const QHash<edb::address_t, MemoryUsage> found = edb::v1::debugger_core->memory_usage(starts);
+
+	int first = INT_MAX;
+	int last  = -1;
+	Q_FOREACH(edb::address_t start, starts) {
+		const int row = row_of(start);
+		if(row == -1) {
+			continue;
+		}
+
+		Usage &entry     = usage_[start];
+		entry.generation = usage_generation_;
+		entry.known      = found.contains(start);
+		if(entry.known) {
+			entry.usage = found.value(start);
+		}
+
+		first = qMin(first, row);
+		last  = qMax(last, row);
+	}
+
+	if(last != -1) {
+		Q_EMIT dataChanged(index(first, 4), index(last, 5));
+	}
 }
 
 //------------------------------------------------------------------------------
@@ -84,11 +303,24 @@ void MemoryRegions::sync() {
 //------------------------------------------------------------------------------
 IRegion::pointer MemoryRegions::find_region(edb::address_t address) const {
 
-	Q_FOREACH(const IRegion::pointer &i, regions_) {
-		if(i->contains(address)) {
-			return i;
+	// most lookups are for the same region as the last one
+	const int hit = last_hit_;
+	if(hit != -1 && hit < index_.size() && address >= index_[hit].start && address < index_[hit].end) {
+		return regions_[hit];
+	}
+
+	// find the first region which starts after address, the one before it
+	// is the only one which could contain it
+	QVector<Range>::const_iterator it = std::upper_bound(index_.begin(), index_.end(), address, address_before<Range>);
+	if(it != index_.begin()) {
+		--it;
+		if(address < it->end) {
+			const int n = it - index_.begin();
+			last_hit_ = n;
+			return regions_[n];
 		}
 	}
+
 	return IRegion::pointer();
 }
 
@@ -107,6 +339,8 @@ QVariant MemoryRegions::data(const QModelIndex &index, int role) const {
 		case 1: return edb::v1::format_pointer(region->end());
 		case 2: return QString("%1%2%3").arg(region->readable() ? 'r' : '-').arg(region->writable() ? 'w' : '-').arg(region->executable() ? 'x' : '-');
 		case 3: return region->name();
+		case 4:
+		case 5: return usage(region, index.column());
 		}
 	}
 
@@ -151,7 +385,7 @@ int MemoryRegions::rowCount(const QModelIndex &parent) const {
 //------------------------------------------------------------------------------
 int MemoryRegions::columnCount(const QModelIndex &parent) const {
 	Q_UNUSED(parent);
-	return 4;
+	return 6;
 }
 
 //------------------------------------------------------------------------------
@@ -165,6 +399,8 @@ QVariant MemoryRegions::headerData(int section, Qt::Orientation orientation, int
 		case 1: return tr("End Address");
 		case 2: return tr("Permissions");
 		case 3: return tr("Name");
+		case 4: return tr("RSS (KiB)");
+		case 5: return tr("PSS (KiB)");
 		}
 	}
 
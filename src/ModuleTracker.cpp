@@ -0,0 +1,234 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "ModuleTracker.h"
+#include "IDebugger.h"
+#include "IProcess.h"
+#include "edb.h"
+
+#include <QHash>
+#include <QSet>
+#include <QString>
+#include <climits>
+#include <cstring>
+
+#if defined(Q_OS_UNIX) && !defined(Q_OS_MAC)
+#include <link.h>
+#endif
+
+namespace {
+
+#if defined(Q_OS_UNIX) && !defined(Q_OS_MAC)
+//------------------------------------------------------------------------------
+// Name: read_string
+// Desc: reads a nul terminated string a piece at a time, so one that ends
+//       just before an unmapped page can still be read
+//------------------------------------------------------------------------------
+QString read_string(IProcess *process, edb::address_t address) {
+
+	QByteArray string;
+	char buffer[64];
+
+	while(string.size() < PATH_MAX && process->read_bytes(address, buffer, sizeof(buffer))) {
+		const void *const end = std::memchr(buffer, '\0', sizeof(buffer));
+		if(end) {
+			string.append(buffer, static_cast<const char *>(end) - buffer);
+			return QString::fromLocal8Bit(string);
+		}
+
+		string.append(buffer, sizeof(buffer));
+		address += sizeof(buffer);
+	}
+
+	// the last piece may have run into an unmapped page, try a byte at a time
+	char ch;
+	while(string.size() < PATH_MAX && process->read_bytes(address++, &ch, sizeof(ch)) && ch != '\0') {
+		string.append(ch);
+	}
+
+	return QString::fromLocal8Bit(string);
+}
+#endif
+
+}
+
+//------------------------------------------------------------------------------
+// Name: ModuleTracker
+// Desc:
+//------------------------------------------------------------------------------
+ModuleTracker::ModuleTracker() : debug_pointer_(0), breakpoint_address_(0) {
+}
+
+//------------------------------------------------------------------------------
+// Name: reset
+// Desc: forgets the process, it has to be attached to again
+//------------------------------------------------------------------------------
+void ModuleTracker::reset() {
+	debug_pointer_      = 0;
+	breakpoint_address_ = 0;
+	modules_.clear();
+}
+
+//------------------------------------------------------------------------------
+// Name: attach
+// Desc: starts following the link map whose r_debug is at <debug_pointer>.
+//       Everything already loaded is reported as <added>. Fails if the linker
+//       hasn't set it up yet, otherwise breakpoint_address() is where the
+//       linker says the list changed
+//------------------------------------------------------------------------------
+bool ModuleTracker::attach(edb::address_t debug_pointer, QList<Module> *added) {
+
+	Q_ASSERT(added);
+
+	added->clear();
+	reset();
+	debug_pointer_ = debug_pointer;
+
+	QList<Module> modules;
+	bool consistent;
+	if(!read_link_map(&modules, &consistent, &breakpoint_address_) || !breakpoint_address_) {
+		reset();
+		return false;
+	}
+
+	// if we stopped in the middle of a change, the next hit of the breakpoint
+	// will see the finished list
+	if(consistent) {
+		QList<Module> removed;
+		apply(modules, added, &removed);
+	}
+
+	return true;
+}
+
+//------------------------------------------------------------------------------
+// Name: update
+// Desc: called each time the breakpoint is hit. The linker hits it both
+//       before and after changing the list, only the latter is looked at.
+//       Returns true if any module came or went
+//------------------------------------------------------------------------------
+bool ModuleTracker::update(QList<Module> *added, QList<Module> *removed) {
+
+	Q_ASSERT(added);
+	Q_ASSERT(removed);
+
+	added->clear();
+	removed->clear();
+
+	if(!attached()) {
+		return false;
+	}
+
+	QList<Module> modules;
+	bool consistent;
+	edb::address_t breakpoint;
+	if(!read_link_map(&modules, &consistent, &breakpoint) || !consistent) {
+		return false;
+	}
+
+	apply(modules, added, removed);
+	return !added->isEmpty() || !removed->isEmpty();
+}
+
+//------------------------------------------------------------------------------
+// Name: apply
+// Desc: a module is the same one as long as it is loaded by the same name at
+//       the same address, anything else is one going and another coming
+//------------------------------------------------------------------------------
+void ModuleTracker::apply(const QList<Module> &modules, QList<Module> *added, QList<Module> *removed) {
+
+	QHash<edb::address_t, QString> previous;
+	Q_FOREACH(const Module &module, modules_) {
+		previous.insert(module.base_address, module.name);
+	}
+
+	QHash<edb::address_t, QString> current;
+	Q_FOREACH(const Module &module, modules) {
+		current.insert(module.base_address, module.name);
+
+		QHash<edb::address_t, QString>::const_iterator it = previous.find(module.base_address);
+		if(it == previous.end() || it.value() != module.name) {
+			added->push_back(module);
+		}
+	}
+
+	Q_FOREACH(const Module &module, modules_) {
+		QHash<edb::address_t, QString>::const_iterator it = current.find(module.base_address);
+		if(it == current.end() || it.value() != module.name) {
+			removed->push_back(module);
+		}
+	}
+
+	modules_ = modules;
+}
+
+//------------------------------------------------------------------------------
+// Name: read_link_map
+// Desc: the objects are listed in the order the linker loaded them, the main
+//       executable is left out unless it was relocated
+//------------------------------------------------------------------------------
+bool ModuleTracker::read_link_map(QList<Module> *modules, bool *consistent, edb::address_t *breakpoint) const {
+
+	Q_ASSERT(modules);
+	Q_ASSERT(consistent);
+	Q_ASSERT(breakpoint);
+
+#if defined(Q_OS_UNIX) && !defined(Q_OS_MAC)
+	IProcess *const process = edb::v1::debugger_core ? edb::v1::debugger_core->process() : 0;
+	if(!process) {
+		return false;
+	}
+
+	struct r_debug dynamic_info;
+	if(!process->read_bytes(debug_pointer_, &dynamic_info, sizeof(dynamic_info))) {
+		return false;
+	}
+
+	*consistent = dynamic_info.r_state == r_debug::RT_CONSISTENT;
+	*breakpoint = static_cast<edb::address_t>(dynamic_info.r_brk);
+
+	// a corrupt list could loop forever
+	QSet<edb::address_t> seen;
+
+	edb::address_t link_address = reinterpret_cast<edb::address_t>(dynamic_info.r_map);
+	while(link_address && !seen.contains(link_address)) {
+		seen.insert(link_address);
+
+		struct link_map map;
+		if(!process->read_bytes(link_address, &map, sizeof(map))) {
+			return false;
+		}
+
+		if(map.l_addr) {
+			Module module;
+			module.name         = read_string(process, reinterpret_cast<edb::address_t>(map.l_name));
+			module.base_address = map.l_addr;
+			modules->push_back(module);
+		}
+
+		link_address = reinterpret_cast<edb::address_t>(map.l_next);
+	}
+
+	return true;
+#else
+	Q_UNUSED(modules);
+	Q_UNUSED(consistent);
+	Q_UNUSED(breakpoint);
+	return false;
+#endif
+}
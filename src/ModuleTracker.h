@@ -0,0 +1,54 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef MODULETRACKER_20261014_H_
+#define MODULETRACKER_20261014_H_
+
+#include "Module.h"
+#include "Types.h"
+#include <QList>
+
+// follows the dynamic linker's list of loaded objects. The linker calls r_brk
+// around every dlopen/dlclose, so with a breakpoint there the list only has to
+// be walked when it actually changed, and each walk is compared against the
+// last one so only the objects which came or went are reported
+class ModuleTracker {
+public:
+	ModuleTracker();
+
+public:
+	void reset();
+	bool attach(edb::address_t debug_pointer, QList<Module> *added);
+	bool update(QList<Module> *added, QList<Module> *removed);
+
+public:
+	bool attached() const                     { return debug_pointer_ != 0; }
+	edb::address_t breakpoint_address() const { return breakpoint_address_; }
+	QList<Module> modules() const             { return modules_; }
+
+private:
+	bool read_link_map(QList<Module> *modules, bool *consistent, edb::address_t *breakpoint) const;
+	void apply(const QList<Module> &modules, QList<Module> *added, QList<Module> *removed);
+
+private:
+	edb::address_t debug_pointer_;
+	edb::address_t breakpoint_address_;
+	QList<Module>  modules_;
+};
+
+#endif
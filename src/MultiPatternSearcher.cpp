@@ -0,0 +1,143 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "MultiPatternSearcher.h"
+#include <QQueue>
+
+//------------------------------------------------------------------------------
+// Name: MultiPatternSearcher
+// Desc:
+//------------------------------------------------------------------------------
+MultiPatternSearcher::MultiPatternSearcher() : compiled_(false) {
+	add_state();
+}
+
+//------------------------------------------------------------------------------
+// Name: add_state
+// Desc: a new state with no transitions yet
+//------------------------------------------------------------------------------
+int MultiPatternSearcher::add_state() {
+
+	const int state = output_.size();
+
+	next_.insert(next_.end(), 256, -1);
+	output_.push_back(-1);
+	output_link_.push_back(-1);
+	return state;
+}
+
+//------------------------------------------------------------------------------
+// Name: add_pattern
+// Desc: returns the id matches of <pattern> will be reported with, or -1 if it
+//       is empty. Patterns must all be added before compile is called
+//------------------------------------------------------------------------------
+int MultiPatternSearcher::add_pattern(const QByteArray &pattern) {
+
+	Q_ASSERT(!compiled_);
+
+	if(pattern.isEmpty()) {
+		return -1;
+	}
+
+	int state = start_state();
+	for(int i = 0; i < pattern.size(); ++i) {
+		const int index = state * 256 + static_cast<quint8>(pattern[i]);
+		if(next_[index] == -1) {
+			const int created = add_state();
+			next_[index] = created;
+		}
+		state = next_[index];
+	}
+
+	const int id = patterns_.size();
+	patterns_.push_back(pattern);
+	same_.push_back(output_[state]);
+	output_[state] = id;
+	return id;
+}
+
+//------------------------------------------------------------------------------
+// Name: compile
+// Desc: fills in the failure transitions, breadth first so that each state's
+//       failure state is complete before it is needed
+//------------------------------------------------------------------------------
+void MultiPatternSearcher::compile() {
+
+	if(compiled_) {
+		return;
+	}
+
+	QVector<int> failure(output_.size(), 0);
+	QQueue<int>  queue;
+
+	for(int c = 0; c < 256; ++c) {
+		int &next = next_[c];
+		if(next == -1) {
+			next = start_state();
+		} else {
+			queue.enqueue(next);
+		}
+	}
+
+	while(!queue.isEmpty()) {
+		const int state = queue.dequeue();
+		const int fail  = failure[state];
+
+		output_link_[state] = (output_[fail] != -1) ? fail : output_link_[fail];
+
+		for(int c = 0; c < 256; ++c) {
+			const int index = state * 256 + c;
+			if(next_[index] == -1) {
+				next_[index] = next_[fail * 256 + c];
+			} else {
+				failure[next_[index]] = next_[fail * 256 + c];
+				queue.enqueue(next_[index]);
+			}
+		}
+	}
+
+	compiled_ = true;
+}
+
+//------------------------------------------------------------------------------
+// Name: scan
+// Desc: runs the bytes [first, last), which are at <address>, through the
+//       automaton starting in <state>. Every match which ends in them is
+//       appended to <matches>. Returns the state to carry on from
+//------------------------------------------------------------------------------
+int MultiPatternSearcher::scan(int state, const quint8 *first, const quint8 *last, edb::address_t address, QVector<Match> *matches) const {
+
+	Q_ASSERT(compiled_);
+	Q_ASSERT(matches);
+
+	const int *const next = next_.constData();
+
+	for(const quint8 *p = first; p != last; ++p) {
+		state = next[state * 256 + *p];
+
+		int found = (output_[state] != -1) ? state : output_link_[state];
+		while(found != -1) {
+			for(int id = output_[found]; id != -1; id = same_[id]) {
+				const Match match = { id, address + (p - first) + 1 - patterns_[id].size() };
+				matches->push_back(match);
+			}
+			found = output_link_[found];
+		}
+	}
+
+	return state;
+}
@@ -0,0 +1,438 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "PatchJournal.h"
+#include "IAnalyzer.h"
+#include "IDebugger.h"
+#include "IProcess.h"
+#include "IRegion.h"
+#include "MemoryRegions.h"
+#include "edb.h"
+
+#include <QFile>
+#include <QFileInfo>
+#include <QMap>
+#include <QPair>
+#include <QTextStream>
+
+#include <algorithm>
+
+namespace {
+
+// ranges closer together than this on the same page are written as one,
+// with the bytes in between written back as they are
+const edb::address_t MaxGap = 256;
+
+struct RangeOrder {
+	RangeOrder(const QVector<PatchJournal::Range> &ranges) : ranges_(ranges) {
+	}
+
+	bool operator()(int lhs, int rhs) const {
+		return ranges_[lhs].address < ranges_[rhs].address;
+	}
+
+	const QVector<PatchJournal::Range> &ranges_;
+};
+
+//------------------------------------------------------------------------------
+// Name: has_breakpoint
+// Desc: true if a breakpoint is somewhere in [first, last), the bytes edb
+//       reads back there aren't really in memory so they mustn't be written
+//------------------------------------------------------------------------------
+bool has_breakpoint(const IDebugger::BreakpointList &breakpoints, edb::address_t first, edb::address_t last) {
+	for(edb::address_t address = first; address != last; ++address) {
+		if(breakpoints.contains(address)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+//------------------------------------------------------------------------------
+// Name: invalidate
+// Desc: tells the analyzer that the bytes of <patch> are different now
+//------------------------------------------------------------------------------
+void invalidate(const PatchJournal::Patch &patch) {
+	if(IAnalyzer *const analyzer = edb::v1::analyzer()) {
+		analyzer->invalidate_range(patch.address, patch.bytes.size());
+	}
+}
+
+}
+
+//------------------------------------------------------------------------------
+// Name: PatchJournal
+// Desc:
+//------------------------------------------------------------------------------
+PatchJournal::PatchJournal() : applied_(0) {
+}
+
+//------------------------------------------------------------------------------
+// Name: write
+// Desc: writes <ranges> as one edit. They are sorted and the ones which
+//       overlap, touch or are near each other on a page are merged, so each
+//       run of them is read and written once. Where ranges overlap the later
+//       one wins
+//------------------------------------------------------------------------------
+bool PatchJournal::write(const QString &description, const QVector<Range> &ranges) {
+
+	IProcess *const process = edb::v1::debugger_core ? edb::v1::debugger_core->process() : 0;
+	if(!process) {
+		return false;
+	}
+
+	QVector<int> order;
+	order.reserve(ranges.size());
+	for(int i = 0; i < ranges.size(); ++i) {
+		if(!ranges[i].bytes.isEmpty()) {
+			order.push_back(i);
+		}
+	}
+
+	if(order.isEmpty()) {
+		return true;
+	}
+
+	std::stable_sort(order.begin(), order.end(), RangeOrder(ranges));
+
+	const edb::address_t page_size              = edb::v1::debugger_core->page_size();
+	const IDebugger::BreakpointList breakpoints = edb::v1::debugger_core->backup_breakpoints();
+
+	Entry entry;
+	entry.description = description;
+
+	bool ok = true;
+
+	int first = 0;
+	while(first < order.size()) {
+
+		// how far the run of ranges starting here goes
+		const edb::address_t start = ranges[order[first]].address;
+		edb::address_t end         = start + ranges[order[first]].bytes.size();
+
+		int last = first + 1;
+		while(last < order.size()) {
+			const Range &next = ranges[order[last]];
+			if(next.address > end) {
+				const bool same_page = (next.address / page_size) == ((end - 1) / page_size);
+				if(!same_page || next.address - end > MaxGap || has_breakpoint(breakpoints, end, next.address)) {
+					break;
+				}
+			}
+			end = qMax<edb::address_t>(end, next.address + next.bytes.size());
+			++last;
+		}
+
+		Patch patch;
+		patch.address = start;
+		patch.original.resize(end - start);
+		if(!process->read_bytes(start, patch.original.data(), patch.original.size())) {
+			ok = false;
+			first = last;
+			continue;
+		}
+
+		// the ranges go on in the order they were given
+		QVector<int> members;
+		for(int i = first; i != last; ++i) {
+			members.push_back(order[i]);
+		}
+		std::sort(members.begin(), members.end());
+
+		patch.bytes = patch.original;
+		Q_FOREACH(int index, members) {
+			const Range &range = ranges[index];
+			std::copy(range.bytes.begin(), range.bytes.end(), patch.bytes.begin() + (range.address - start));
+		}
+
+		if(patch.bytes != patch.original) {
+			if(process->write_bytes(patch.address, patch.bytes.constData(), patch.bytes.size())) {
+				invalidate(patch);
+				entry.patches.push_back(patch);
+			} else {
+				ok = false;
+			}
+		}
+
+		first = last;
+	}
+
+	if(!entry.patches.isEmpty()) {
+		// a new edit can't be followed by the ones which were undone
+		entries_.resize(applied_);
+		entries_.push_back(entry);
+		++applied_;
+		Q_EMIT changed();
+	}
+
+	return ok;
+}
+
+//------------------------------------------------------------------------------
+// Name: write
+// Desc:
+//------------------------------------------------------------------------------
+bool PatchJournal::write(const QString &description, edb::address_t address, const QByteArray &bytes) {
+	Range range;
+	range.address = address;
+	range.bytes   = bytes;
+	return write(description, QVector<Range>() << range);
+}
+
+//------------------------------------------------------------------------------
+// Name: rewrite
+// Desc: puts the bytes <patch> changed back to what they were before it, or to
+//       what it made them if <undo> is false. Bytes it left alone are written
+//       as they are now, it may have been a while since it was made
+//------------------------------------------------------------------------------
+bool PatchJournal::rewrite(const Patch &patch, bool undo) {
+
+	IProcess *const process = edb::v1::debugger_core ? edb::v1::debugger_core->process() : 0;
+	if(!process) {
+		return false;
+	}
+
+	QByteArray bytes(patch.bytes.size(), 0);
+	if(!process->read_bytes(patch.address, bytes.data(), bytes.size())) {
+		return false;
+	}
+
+	const QByteArray &wanted = undo ? patch.original : patch.bytes;
+	for(int i = 0; i < bytes.size(); ++i) {
+		if(patch.original[i] != patch.bytes[i]) {
+			bytes[i] = wanted[i];
+		}
+	}
+
+	if(!process->write_bytes(patch.address, bytes.constData(), bytes.size())) {
+		return false;
+	}
+
+	invalidate(patch);
+	return true;
+}
+
+//------------------------------------------------------------------------------
+// Name: undo
+// Desc:
+//------------------------------------------------------------------------------
+bool PatchJournal::undo() {
+
+	if(!can_undo()) {
+		return false;
+	}
+
+	const Entry &entry = entries_[applied_ - 1];
+
+	bool ok = true;
+	for(int i = entry.patches.size() - 1; i >= 0; --i) {
+		ok = rewrite(entry.patches[i], true) && ok;
+	}
+
+	--applied_;
+	Q_EMIT changed();
+	return ok;
+}
+
+//------------------------------------------------------------------------------
+// Name: redo
+// Desc:
+//------------------------------------------------------------------------------
+bool PatchJournal::redo() {
+
+	if(!can_redo()) {
+		return false;
+	}
+
+	const Entry &entry = entries_[applied_];
+
+	bool ok = true;
+	Q_FOREACH(const Patch &patch, entry.patches) {
+		ok = rewrite(patch, false) && ok;
+	}
+
+	++applied_;
+	Q_EMIT changed();
+	return ok;
+}
+
+//------------------------------------------------------------------------------
+// Name: clear
+// Desc: forgets every edit, for when the process goes away
+//------------------------------------------------------------------------------
+void PatchJournal::clear() {
+	if(!entries_.isEmpty()) {
+		entries_.clear();
+		applied_ = 0;
+		Q_EMIT changed();
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: undo_description
+// Desc:
+//------------------------------------------------------------------------------
+QString PatchJournal::undo_description() const {
+	return can_undo() ? entries_[applied_ - 1].description : QString();
+}
+
+//------------------------------------------------------------------------------
+// Name: redo_description
+// Desc:
+//------------------------------------------------------------------------------
+QString PatchJournal::redo_description() const {
+	return can_redo() ? entries_[applied_].description : QString();
+}
+
+//------------------------------------------------------------------------------
+// Name: changes
+// Desc:
+//------------------------------------------------------------------------------
+QVector<PatchJournal::Patch> PatchJournal::changes() const {
+
+	// the first original and the last value of every byte which was changed
+	QMap<edb::address_t, QPair<char, char> > bytes;
+	for(int i = 0; i < applied_; ++i) {
+		Q_FOREACH(const Patch &patch, entries_[i].patches) {
+			for(int j = 0; j < patch.bytes.size(); ++j) {
+				if(patch.original[j] == patch.bytes[j]) {
+					continue;
+				}
+
+				const edb::address_t address = patch.address + j;
+				QMap<edb::address_t, QPair<char, char> >::iterator it = bytes.find(address);
+				if(it == bytes.end()) {
+					bytes.insert(address, qMakePair(patch.original[j], patch.bytes[j]));
+				} else {
+					it->second = patch.bytes[j];
+				}
+			}
+		}
+	}
+
+	QVector<Patch> changes;
+	for(QMap<edb::address_t, QPair<char, char> >::const_iterator it = bytes.begin(); it != bytes.end(); ++it) {
+		if(it->first == it->second) {
+			continue;
+		}
+
+		if(changes.isEmpty() || changes.back().address + changes.back().bytes.size() != it.key()) {
+			Patch patch;
+			patch.address = it.key();
+			changes.push_back(patch);
+		}
+
+		changes.back().original += it->first;
+		changes.back().bytes    += it->second;
+	}
+
+	return changes;
+}
+
+//------------------------------------------------------------------------------
+// Name: diff
+// Desc: a line for each run of changed bytes:
+//       <address> <module>+<file offset>: <original> -> <new>
+//------------------------------------------------------------------------------
+QString PatchJournal::diff() const {
+
+	QString text;
+	QTextStream stream(&text);
+
+	Q_FOREACH(const Patch &patch, changes()) {
+		stream << edb::v1::format_pointer(patch.address);
+
+		const IRegion::pointer region = edb::v1::memory_regions().find_region(patch.address);
+		if(region && !region->name().isEmpty()) {
+			const edb::address_t offset = region->base() + (patch.address - region->start());
+			stream << ' ' << QFileInfo(region->name()).fileName() << "+0x" << QString::number(offset, 16);
+		}
+
+		stream << ": " << edb::v1::format_bytes(patch.original) << " -> " << edb::v1::format_bytes(patch.bytes) << '\n';
+	}
+
+	return text;
+}
+
+//------------------------------------------------------------------------------
+// Name: save_to_file
+// Desc:
+//------------------------------------------------------------------------------
+bool PatchJournal::save_to_file(const QString &module, const QString &filename, int *count, QString *error) const {
+
+	Q_ASSERT(count);
+	Q_ASSERT(error);
+
+	*count = 0;
+
+	if(QFileInfo(module).canonicalFilePath() != QFileInfo(filename).canonicalFilePath()) {
+		if(QFile::exists(filename) && !QFile::remove(filename)) {
+			*error = tr("%1 couldn't be replaced.").arg(filename);
+			return false;
+		}
+
+		if(!QFile::copy(module, filename)) {
+			*error = tr("%1 couldn't be copied to %2.").arg(module, filename);
+			return false;
+		}
+	}
+
+	QFile file(filename);
+	if(!file.open(QIODevice::ReadWrite)) {
+		*error = file.errorString();
+		return false;
+	}
+
+	const qint64 file_size = file.size();
+
+	Q_FOREACH(const Patch &patch, changes()) {
+
+		// a run may span more than one region, each part goes where its own
+		// region came from
+		int i = 0;
+		while(i < patch.bytes.size()) {
+			const edb::address_t address   = patch.address + i;
+			const IRegion::pointer region = edb::v1::memory_regions().find_region(address);
+			if(!region) {
+				++i;
+				continue;
+			}
+
+			const int n = qMin<edb::address_t>(patch.bytes.size() - i, region->end() - address);
+
+			if(region->name() == module) {
+				const qint64 offset = region->base() + (address - region->start());
+
+				// the end of the last page of a mapping may be past the end
+				// of the file
+				const qint64 in_file = qBound<qint64>(0, file_size - offset, n);
+				if(in_file != 0) {
+					if(!file.seek(offset) || file.write(patch.bytes.constData() + i, in_file) != in_file) {
+						*error = file.errorString();
+						return false;
+					}
+					*count += in_file;
+				}
+			}
+
+			i += n;
+		}
+	}
+
+	return true;
+}
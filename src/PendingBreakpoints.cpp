@@ -0,0 +1,264 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "PendingBreakpoints.h"
+#include "IDebugger.h"
+#include "ISymbolManager.h"
+#include "edb.h"
+
+#include <QFileInfo>
+#include <QtDebug>
+
+//------------------------------------------------------------------------------
+// Name: PendingBreakpoints
+// Desc:
+//------------------------------------------------------------------------------
+PendingBreakpoints::PendingBreakpoints() {
+}
+
+//------------------------------------------------------------------------------
+// Name: parse
+// Desc: splits "module!symbol+offset" up. The offset is in hex and either the
+//       symbol or the offset may be left out, "module!+offset" is relative to
+//       where the module is loaded
+//------------------------------------------------------------------------------
+bool PendingBreakpoints::parse(const QString &text, Breakpoint *breakpoint) {
+
+	Q_ASSERT(breakpoint);
+
+	const QString location = text.trimmed();
+
+	const int bang = location.indexOf('!');
+	if(bang <= 0) {
+		return false;
+	}
+
+	QString symbol = location.mid(bang + 1);
+	edb::address_t offset = 0;
+
+	// a '+' which isn't followed by a number is part of the name, as in
+	// "operator+"
+	bool has_offset = false;
+
+	const int plus = symbol.lastIndexOf('+');
+	if(plus != -1) {
+		const edb::address_t value = symbol.mid(plus + 1).trimmed().toULongLong(&has_offset, 16);
+		if(has_offset) {
+			offset = value;
+			symbol = symbol.left(plus).trimmed();
+		}
+	}
+
+	if(symbol.isEmpty() && !has_offset) {
+		return false;
+	}
+
+	breakpoint->text      = location;
+	breakpoint->module    = location.left(bang).trimmed();
+	breakpoint->symbol    = symbol;
+	breakpoint->offset    = offset;
+	breakpoint->address   = 0;
+	return true;
+}
+
+//------------------------------------------------------------------------------
+// Name: add
+// Desc: returns false if <text> isn't a location, it is waiting for its module
+//       until module_loaded is told about it
+//------------------------------------------------------------------------------
+bool PendingBreakpoints::add(const QString &text, const QString &condition) {
+
+	Breakpoint breakpoint;
+	if(!parse(text, &breakpoint)) {
+		return false;
+	}
+
+	Q_FOREACH(const Breakpoint &existing, breakpoints_) {
+		if(existing.text == breakpoint.text) {
+			return true;
+		}
+	}
+
+	breakpoint.condition = condition;
+
+	by_module_[breakpoint.module].push_back(breakpoints_.size());
+	breakpoints_.push_back(breakpoint);
+	return true;
+}
+
+//------------------------------------------------------------------------------
+// Name: remove
+// Desc: also removes the breakpoint it set, if any
+//------------------------------------------------------------------------------
+void PendingBreakpoints::remove(const QString &text) {
+	for(int i = 0; i < breakpoints_.size(); ++i) {
+		if(breakpoints_[i].text == text.trimmed()) {
+			if(breakpoints_[i].address && edb::v1::debugger_core) {
+				edb::v1::debugger_core->remove_breakpoint(breakpoints_[i].address);
+			}
+			breakpoints_.removeAt(i);
+			rebuild_index();
+			return;
+		}
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: breakpoint_removed
+// Desc: the user removed a breakpoint, if it was one of ours it isn't wanted
+//       next time either
+//------------------------------------------------------------------------------
+void PendingBreakpoints::breakpoint_removed(edb::address_t address) {
+	for(int i = 0; i < breakpoints_.size(); ++i) {
+		if(breakpoints_[i].address == address) {
+			breakpoints_.removeAt(i);
+			rebuild_index();
+			return;
+		}
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: clear
+// Desc:
+//------------------------------------------------------------------------------
+void PendingBreakpoints::clear() {
+	breakpoints_.clear();
+	by_module_.clear();
+}
+
+//------------------------------------------------------------------------------
+// Name: reset
+// Desc: the process is gone and its breakpoints with it, everything waits for
+//       its module again
+//------------------------------------------------------------------------------
+void PendingBreakpoints::reset() {
+	for(int i = 0; i < breakpoints_.size(); ++i) {
+		breakpoints_[i].address = 0;
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: rebuild_index
+// Desc:
+//------------------------------------------------------------------------------
+void PendingBreakpoints::rebuild_index() {
+	by_module_.clear();
+	for(int i = 0; i < breakpoints_.size(); ++i) {
+		by_module_[breakpoints_[i].module].push_back(i);
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: find_module
+// Desc: a module can be named by its file name, or without the version
+//       ("libfoo.so") or without the extension at all ("libfoo")
+//------------------------------------------------------------------------------
+QList<int> PendingBreakpoints::find_module(const QString &filename) const {
+
+	const QString name = QFileInfo(filename).fileName();
+
+	QList<int> result = by_module_.value(name);
+
+	const int n = name.indexOf(".so");
+	if(n > 0) {
+		if(name.size() != n + 3) {
+			result += by_module_.value(name.left(n + 3));
+		}
+		result += by_module_.value(name.left(n));
+	}
+
+	return result;
+}
+
+//------------------------------------------------------------------------------
+// Name: module_loaded
+// Desc: sets the breakpoints waiting for <module>. Their symbols are looked up
+//       by name in the module's symbol index, so this is only as slow as
+//       bringing its symbols up to date, which only happens when something
+//       is waiting for it
+//------------------------------------------------------------------------------
+void PendingBreakpoints::module_loaded(const Module &module) {
+
+	const QList<int> waiting = find_module(module.name);
+	if(waiting.isEmpty()) {
+		return;
+	}
+
+	bool symbols_ready = false;
+
+	Q_FOREACH(int index, waiting) {
+		Breakpoint &breakpoint = breakpoints_[index];
+		if(breakpoint.address) {
+			continue;
+		}
+
+		if(!breakpoint.symbol.isEmpty() && !symbols_ready) {
+			edb::v1::symbol_manager().wait_for_symbol_file(module.name);
+			symbols_ready = true;
+		}
+
+		set(&breakpoint, module);
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: module_unloaded
+// Desc:
+//------------------------------------------------------------------------------
+void PendingBreakpoints::module_unloaded(const Module &module) {
+	Q_FOREACH(int index, find_module(module.name)) {
+		Breakpoint &breakpoint = breakpoints_[index];
+		if(breakpoint.address) {
+			edb::v1::debugger_core->remove_breakpoint(breakpoint.address);
+			breakpoint.address = 0;
+		}
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: set
+// Desc:
+//------------------------------------------------------------------------------
+void PendingBreakpoints::set(Breakpoint *breakpoint, const Module &module) {
+
+	Q_ASSERT(breakpoint);
+
+	edb::address_t address = module.base_address + breakpoint->offset;
+
+	if(!breakpoint->symbol.isEmpty()) {
+		const QString name = QString("%1::%2").arg(QFileInfo(module.name).fileName(), breakpoint->symbol);
+		const Symbol::pointer symbol = edb::v1::symbol_manager().find(name);
+		if(!symbol) {
+			qDebug() << "Pending breakpoint" << breakpoint->text << "not found in" << module.name;
+			return;
+		}
+		address = symbol->address + breakpoint->offset;
+	}
+
+	// if there is already a breakpoint there, it stands in for this one
+	IBreakpoint::pointer bp = edb::v1::debugger_core->add_breakpoint(address);
+	if(bp) {
+		bp->condition = breakpoint->condition;
+	} else if(!edb::v1::debugger_core->find_breakpoint(address)) {
+		qDebug() << "Pending breakpoint" << breakpoint->text << "could not be set at" << edb::v1::format_pointer(address);
+		return;
+	}
+
+	breakpoint->address = address;
+}
@@ -0,0 +1,74 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef PENDINGBREAKPOINTS_20261014_H_
+#define PENDINGBREAKPOINTS_20261014_H_
+
+#include "Module.h"
+#include "Types.h"
+#include <QHash>
+#include <QList>
+#include <QString>
+
+// breakpoints given as module!symbol+offset rather than as an address. They
+// wait for their module to be loaded, are set each time it is, and go back
+// to waiting when it is unloaded, so they work in libraries which are only
+// opened later and carry over from one run to the next
+class PendingBreakpoints {
+public:
+	struct Breakpoint {
+		QString        text;
+		QString        module;
+		QString        symbol;
+		edb::address_t offset;
+		QString        condition;
+		edb::address_t address; // where it is set, 0 while it is waiting
+	};
+
+public:
+	PendingBreakpoints();
+
+private:
+	Q_DISABLE_COPY(PendingBreakpoints)
+
+public:
+	static bool parse(const QString &text, Breakpoint *breakpoint);
+
+public:
+	bool add(const QString &text, const QString &condition);
+	void remove(const QString &text);
+	void breakpoint_removed(edb::address_t address);
+	void clear();
+	void reset();
+	const QList<Breakpoint> &breakpoints() const { return breakpoints_; }
+
+public:
+	void module_loaded(const Module &module);
+	void module_unloaded(const Module &module);
+
+private:
+	QList<int> find_module(const QString &filename) const;
+	void rebuild_index();
+	void set(Breakpoint *breakpoint, const Module &module);
+
+private:
+	QList<Breakpoint>          breakpoints_;
+	QHash<QString, QList<int> > by_module_;
+};
+
+#endif
@@ -104,8 +104,26 @@ void ProcessModel::addProcess(const ProcessInfo &process) {
 	endInsertRows();
 }
 
+void ProcessModel::addProcesses(const QList<ProcessInfo> &processes) {
+	if(processes.isEmpty()) {
+		return;
+	}
+
+	// one insertion per batch, not per process
+	beginInsertRows(QModelIndex(), rowCount(), rowCount() + processes.size() - 1);
+
+	items_.reserve(items_.size() + processes.size());
+	Q_FOREACH(const ProcessInfo &process, processes) {
+		const Item item = {
+			process.pid, process.uid, process.user, process.name
+		};
+		items_.push_back(item);
+	}
+	endInsertRows();
+}
+
 void ProcessModel::clear() {
-	beginRemoveRows(QModelIndex(), 0, rowCount());
+	beginResetModel();
 	items_.clear();
-	endRemoveRows();
+	endResetModel();
 }
@@ -20,11 +20,12 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #define PROCESS_MODEL_H_
 
 #include <QAbstractItemModel>
+#include <QList>
 #include <QVector>
 #include <QString>
 #include "Types.h"
 
-class ProcessInfo;
+struct ProcessInfo;
 
 class ProcessModel : public QAbstractItemModel {
 	Q_OBJECT
@@ -51,6 +52,7 @@ public:
 
 public:
 	void addProcess(const ProcessInfo &process);
+	void addProcesses(const QList<ProcessInfo> &processes);
 	void clear();
 
 private:
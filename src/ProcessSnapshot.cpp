@@ -0,0 +1,300 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "ProcessSnapshot.h"
+#include "IDebugger.h"
+#include "RegionReader.h"
+#include "edb.h"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+// a region of a core file, it only describes what was there
+class SnapshotRegion : public IRegion {
+public:
+	explicit SnapshotRegion(const CoreFile::Segment &segment)
+		: start_(segment.start), end_(segment.end), base_(segment.base), name_(segment.name), read_(segment.read), write_(segment.write), execute_(segment.execute) {
+	}
+
+public:
+	virtual IRegion *clone() const { return new SnapshotRegion(*this); }
+
+public:
+	virtual bool accessible() const           { return read_ || write_ || execute_; }
+	virtual bool readable() const             { return read_; }
+	virtual bool writable() const             { return write_; }
+	virtual bool executable() const           { return execute_; }
+	virtual edb::address_t size() const       { return end_ - start_; }
+
+public:
+	virtual void set_permissions(bool read, bool write, bool execute) { read_ = read; write_ = write; execute_ = execute; }
+	virtual void set_start(edb::address_t address)                     { start_ = address; }
+	virtual void set_end(edb::address_t address)                       { end_ = address; }
+
+public:
+	virtual edb::address_t start() const      { return start_; }
+	virtual edb::address_t end() const        { return end_; }
+	virtual edb::address_t base() const       { return base_; }
+	virtual QString name() const              { return name_; }
+
+	// the same bits as PROT_READ, PROT_WRITE and PROT_EXEC
+	virtual permissions_t permissions() const { return (read_ ? 1 : 0) | (write_ ? 2 : 0) | (execute_ ? 4 : 0); }
+
+private:
+	edb::address_t start_;
+	edb::address_t end_;
+	edb::address_t base_;
+	QString        name_;
+	bool           read_;
+	bool           write_;
+	bool           execute_;
+};
+
+//------------------------------------------------------------------------------
+// Name: chunk_before
+// Desc: ordering predicate for std::upper_bound over chunks sorted by address
+//------------------------------------------------------------------------------
+template <class Chunk>
+bool chunk_before(edb::address_t address, const Chunk &chunk) {
+	return address < chunk.region->start();
+}
+
+}
+
+//------------------------------------------------------------------------------
+// Name: ProcessSnapshot
+// Desc: constructor, records the properties of <process>, add_region does the
+//       actual copying
+//------------------------------------------------------------------------------
+ProcessSnapshot::ProcessSnapshot(IProcess *process) : file_size_(0), page_size_(edb::v1::debugger_core ? edb::v1::debugger_core->page_size() : 0x1000), pid_(0), code_address_(0), data_address_(0) {
+	if(process) {
+		start_time_                = process->start_time();
+		arguments_                 = process->arguments();
+		current_working_directory_ = process->current_working_directory();
+		executable_                = process->executable();
+		pid_                       = process->pid();
+		code_address_              = process->code_address();
+		data_address_              = process->data_address();
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: ~ProcessSnapshot
+// Desc: destructor, the mappings go away along with the file
+//------------------------------------------------------------------------------
+ProcessSnapshot::~ProcessSnapshot() {
+}
+
+//------------------------------------------------------------------------------
+// Name: add_region
+// Desc: copies the current contents of <region> into the snapshot, returns
+//       false if nothing could be read or the file couldn't be written
+// Note: unreadable parts of the region end up as 0xff bytes
+//------------------------------------------------------------------------------
+bool ProcessSnapshot::add_region(const IRegion::pointer &region) {
+
+	if(!region || region->size() == 0 || find_chunk(region->start())) {
+		return false;
+	}
+
+	if(!file_.isOpen() && !file_.open()) {
+		return false;
+	}
+
+	const qint64 offset = file_size_;
+	const qint64 size   = region->size();
+
+	if(!file_.resize(offset + size)) {
+		return false;
+	}
+
+	// any holes left by unreadable windows should read as 0xff, like they do
+	// from read_bytes on a live process
+	uchar *const p = file_.map(offset, size);
+	if(!p) {
+		file_.resize(offset);
+		return false;
+	}
+
+	std::memset(p, 0xff, size);
+
+	bool read_something = false;
+
+	RegionReader reader(region);
+	while(reader.next()) {
+		std::memcpy(p + (reader.address() - region->start()), reader.data(), reader.size());
+		read_something = true;
+	}
+
+	if(!read_something) {
+		file_.unmap(p);
+		file_.resize(offset);
+		return false;
+	}
+
+	file_size_ = offset + size;
+
+	Chunk chunk;
+	chunk.region = IRegion::pointer(region->clone());
+	chunk.data   = p;
+
+	// keep them sorted so lookups can be a binary search
+	QVector<Chunk>::iterator it = std::upper_bound(chunks_.begin(), chunks_.end(), chunk.region->start(), chunk_before<Chunk>);
+	chunks_.insert(it, chunk);
+	return true;
+}
+
+//------------------------------------------------------------------------------
+// Name: open_core
+// Desc: makes a snapshot of the process saved in the core file <filename>, or
+//       returns NULL and says why in <error>. Only the parts of the core which
+//       hold memory contents become regions of the snapshot
+//------------------------------------------------------------------------------
+ProcessSnapshot *ProcessSnapshot::open_core(const QString &filename, QString *error) {
+
+	CoreFile core;
+	if(!core.open(filename, error)) {
+		return 0;
+	}
+
+	ProcessSnapshot *const snapshot = new ProcessSnapshot(0);
+	snapshot->core_       = core;
+	snapshot->pid_        = core.pid();
+	snapshot->executable_ = core.executable();
+	snapshot->arguments_  = core.arguments();
+
+	Q_FOREACH(const CoreFile::Segment &segment, core.segments()) {
+		if(segment.data) {
+			Chunk chunk;
+			chunk.region = IRegion::pointer(new SnapshotRegion(segment));
+			chunk.data   = segment.data;
+
+			QVector<Chunk>::iterator it = std::upper_bound(snapshot->chunks_.begin(), snapshot->chunks_.end(), chunk.region->start(), chunk_before<Chunk>);
+			snapshot->chunks_.insert(it, chunk);
+		}
+	}
+
+	return snapshot;
+}
+
+//------------------------------------------------------------------------------
+// Name: find_chunk
+// Desc: returns the chunk containing <address> or NULL
+//------------------------------------------------------------------------------
+const ProcessSnapshot::Chunk *ProcessSnapshot::find_chunk(edb::address_t address) const {
+
+	QVector<Chunk>::const_iterator it = std::upper_bound(chunks_.begin(), chunks_.end(), address, chunk_before<Chunk>);
+	if(it != chunks_.begin()) {
+		--it;
+		if(it->region->contains(address)) {
+			return &*it;
+		}
+	}
+
+	return 0;
+}
+
+//------------------------------------------------------------------------------
+// Name: data
+// Desc: returns a pointer to the captured bytes at <address>, <available> is
+//       set to the number of bytes which follow it in the same region
+//------------------------------------------------------------------------------
+const quint8 *ProcessSnapshot::data(edb::address_t address, size_t *available) const {
+
+	if(const Chunk *const chunk = find_chunk(address)) {
+		if(available) {
+			*available = chunk->region->end() - address;
+		}
+		return chunk->data + (address - chunk->region->start());
+	}
+
+	if(available) {
+		*available = 0;
+	}
+	return 0;
+}
+
+//------------------------------------------------------------------------------
+// Name: regions
+// Desc: returns the regions which were captured
+//------------------------------------------------------------------------------
+QList<IRegion::pointer> ProcessSnapshot::regions() const {
+	QList<IRegion::pointer> ret;
+	Q_FOREACH(const Chunk &chunk, chunks_) {
+		ret.push_back(chunk.region);
+	}
+	return ret;
+}
+
+//------------------------------------------------------------------------------
+// Name: write_bytes
+// Desc: snapshots are read-only
+//------------------------------------------------------------------------------
+bool ProcessSnapshot::write_bytes(edb::address_t address, const void *buf, size_t len) {
+	Q_UNUSED(address);
+	Q_UNUSED(buf);
+	Q_UNUSED(len);
+	return false;
+}
+
+//------------------------------------------------------------------------------
+// Name: read_bytes
+// Desc: reads <len> bytes into <buf> starting at <address>, the read may span
+//       adjacent regions
+// Note: if the read failed, the part of the buffer that could not be read will
+//       be filled with 0xff bytes
+//------------------------------------------------------------------------------
+bool ProcessSnapshot::read_bytes(edb::address_t address, void *buf, size_t len) {
+
+	Q_ASSERT(buf);
+
+	quint8 *ptr = reinterpret_cast<quint8 *>(buf);
+
+	while(len != 0) {
+		size_t available;
+		const quint8 *const p = data(address, &available);
+		if(!p) {
+			std::memset(ptr, 0xff, len);
+			return false;
+		}
+
+		const size_t n = qMin(available, len);
+		std::memcpy(ptr, p, n);
+
+		address += n;
+		ptr     += n;
+		len     -= n;
+	}
+
+	return true;
+}
+
+//------------------------------------------------------------------------------
+// Name: read_pages
+// Desc: reads <count> pages starting at <address>
+// Note: address should be page aligned.
+//------------------------------------------------------------------------------
+bool ProcessSnapshot::read_pages(edb::address_t address, void *buf, size_t count) {
+
+	if((address & (page_size_ - 1)) != 0) {
+		return false;
+	}
+
+	return read_bytes(address, buf, count * page_size_);
+}
@@ -0,0 +1,60 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef PROTOTYPE_TABLES_20261014_H_
+#define PROTOTYPE_TABLES_20261014_H_
+
+#include "Prototype.h"
+#include "Types.h"
+
+class QString;
+
+// the tables compile_prototypes.py builds from xml/functions.xml and
+// xml/syscalls.xml, nothing about them is worked out at runtime
+namespace edb {
+namespace internal {
+
+struct SyscallArgument {
+	const char *type;
+	const char *register_name;
+};
+
+struct Syscall {
+	const char            *name;            // 0 for numbers with no syscall
+	const SyscallArgument *arguments;
+	int                    argument_count;
+};
+
+// indexed through function_displacements, see find_function
+extern const Prototype function_table[];
+extern const int       function_displacements[];
+extern const int       function_count;
+
+// indexed by syscall number
+extern const Syscall syscalls_x86[];
+extern const int     syscalls_x86_count;
+extern const Syscall syscalls_x86_64[];
+extern const int     syscalls_x86_64_count;
+
+const Prototype *find_function(const QString &name);
+const Syscall *find_syscall(const Syscall *table, int count, edb::reg_t number);
+
+}
+}
+
+#endif
@@ -17,14 +17,20 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
 #include "RegionBuffer.h"
+#include "Fingerprint.h"
 #include "edb.h"
 #include "IDebugger.h"
+#include "IProcess.h"
+
+#include <QByteArray>
+#include <QVector>
+#include <algorithm>
 
 //------------------------------------------------------------------------------
 // Name: RegionBuffer
 // Desc:
 //------------------------------------------------------------------------------
-RegionBuffer::RegionBuffer(const IRegion::pointer &region) : QIODevice(), region_(region) {
+RegionBuffer::RegionBuffer(const IRegion::pointer &region) : QIODevice(), region_(region), changes_generation_(0), pages_changed_(false) {
 	setOpenMode(QIODevice::ReadOnly);
 }
 
@@ -32,19 +38,121 @@ RegionBuffer::RegionBuffer(const IRegion::pointer &region) : QIODevice(), region
 // Name: RegionBuffer
 // Desc:
 //------------------------------------------------------------------------------
-RegionBuffer::RegionBuffer(const IRegion::pointer &region, QObject *parent) : QIODevice(parent), region_(region) {
+RegionBuffer::RegionBuffer(const IRegion::pointer &region, QObject *parent) : QIODevice(parent), region_(region), changes_generation_(0), pages_changed_(false) {
 	setOpenMode(QIODevice::ReadOnly);
 }
 
 //------------------------------------------------------------------------------
 // Name: set_region
-// Desc:
+// Desc: the pages kept from the last stop stay if this is the same range of
+//       memory again, so that what changed since can still be told
 //------------------------------------------------------------------------------
 void RegionBuffer::set_region(const IRegion::pointer &region) {
+
+	if(!region || !region_ || region->start() != region_->start() || region->size() != region_->size()) {
+		pages_.clear();
+		changes_.clear();
+	}
+
 	region_ = region;
 	reset();
 }
 
+//------------------------------------------------------------------------------
+// Name: keep_pages
+// Desc: keeps a copy of each page of [start, end) which isn't kept already,
+//       the ones which are hold what the view has been showing since the
+//       last stop and are left as they were
+//------------------------------------------------------------------------------
+void RegionBuffer::keep_pages(edb::address_t start, edb::address_t end) {
+
+	IProcess *const process = edb::v1::debugger_core->process();
+	const edb::address_t page_size = edb::v1::debugger_core->page_size();
+
+	for(edb::address_t address = start - (start % page_size); address < end; address += page_size) {
+		if(!pages_.contains(address)) {
+			// the view just read from here, so this comes from the page cache
+			Page page;
+			page.data = QByteArray(page_size, 0);
+			process->read_bytes(address, page.data.data(), page_size);
+			page.hash = edb::internal::xxh64(page.data.constData(), page_size);
+			pages_.insert(address, page);
+		}
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: update_changes
+// Desc: reads every kept page again in one batch and works out which of their
+//       bytes changed since the last stop, so the cost depends on how much the
+//       view has shown rather than on the size of the region. Only pages
+//       whose hash differs are compared byte by byte. Returns true if any
+//       did, which is when a view showing them needs refreshing. Asking again
+//       before the process runs has no further effect
+//------------------------------------------------------------------------------
+bool RegionBuffer::update_changes() {
+
+	IProcess *const process = edb::v1::debugger_core ? edb::v1::debugger_core->process() : 0;
+	if(!process) {
+		return true;
+	}
+
+	const quint64 generation = process->memory_generation();
+	if(generation != 0 && generation == changes_generation_) {
+		return pages_changed_;
+	}
+
+	changes_generation_ = generation;
+	pages_changed_      = false;
+	changes_.clear();
+
+	const edb::address_t page_size = edb::v1::debugger_core->page_size();
+
+	QVector<edb::address_t> pages;
+	pages.reserve(pages_.size());
+	for(QHash<edb::address_t, Page>::const_iterator it = pages_.begin(); it != pages_.end(); ++it) {
+		pages.push_back(it.key());
+	}
+
+	std::sort(pages.begin(), pages.end());
+
+	QByteArray buffer(pages.size() * page_size, 0);
+	QVector<IProcess::ReadRequest> requests;
+	requests.reserve(pages.size());
+	for(int i = 0; i < pages.size(); ++i) {
+		requests.push_back(IProcess::ReadRequest(pages[i], buffer.data() + i * page_size, page_size));
+	}
+
+	process->read_batch(requests);
+
+	for(int i = 0; i < pages.size(); ++i) {
+		const char *const live = buffer.constData() + i * page_size;
+		const quint64 hash     = edb::internal::xxh64(live, page_size);
+
+		Page &page = pages_[pages[i]];
+		if(hash == page.hash) {
+			continue;
+		}
+
+		RegionDiff::diff(reinterpret_cast<const quint8 *>(live), reinterpret_cast<const quint8 *>(page.data.constData()), page_size, pages[i], &changes_);
+
+		page.data = QByteArray(live, page_size);
+		page.hash = hash;
+		pages_changed_ = true;
+	}
+
+	return pages_changed_;
+}
+
+//------------------------------------------------------------------------------
+// Name: changed
+// Desc: true if any of [address, address + size) changed at the last stop
+//------------------------------------------------------------------------------
+bool RegionBuffer::changed(edb::address_t address, edb::address_t size) const {
+
+	return RegionDiff::overlaps(changes_, address, size);
+}
+
 //------------------------------------------------------------------------------
 // Name: readData
 // Desc:
@@ -65,6 +173,7 @@ qint64 RegionBuffer::readData(char *data, qint64 maxSize) {
 			}
 	
 			if(process->read_bytes(start, data, maxSize)) {
+				keep_pages(start, start + maxSize);
 				return maxSize;
 			} else {
 				return -1;
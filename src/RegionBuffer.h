@@ -19,8 +19,12 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #ifndef REGION_BUFFER_20101111_H_
 #define REGION_BUFFER_20101111_H_
 
+#include <QByteArray>
+#include <QHash>
 #include <QIODevice>
+#include <QVector>
 #include "IRegion.h"
+#include "RegionDiff.h"
 
 class RegionBuffer : public QIODevice {
 	Q_OBJECT
@@ -31,6 +35,13 @@ public:
 public:
 	void set_region(const IRegion::pointer &region);
 
+public:
+	// what changed at the last stop in the pages the view has read, as of
+	// the last update_changes()
+	bool update_changes();
+	bool changed(edb::address_t address, edb::address_t size) const;
+	const QVector<RegionDiff::Change> &changes() const { return changes_; }
+
 public:
 	virtual qint64 readData(char * data, qint64 maxSize);
 	virtual qint64 writeData(const char*, qint64);
@@ -38,7 +49,22 @@ public:
 	virtual bool isSequential() const { return false; }
 
 private:
-	IRegion::pointer region_;
+	void keep_pages(edb::address_t start, edb::address_t end);
+
+private:
+	struct Page {
+		QByteArray data;
+		quint64    hash;
+	};
+
+	IRegion::pointer            region_;
+
+	// a copy of each page the view has read, as it was at the last stop or
+	// when first read since
+	QHash<edb::address_t, Page> pages_;
+	QVector<RegionDiff::Change> changes_;
+	quint64                     changes_generation_;
+	bool                        pages_changed_;
 };
 
 #endif
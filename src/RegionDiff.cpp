@@ -0,0 +1,224 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "RegionDiff.h"
+#include "Fingerprint.h"
+#include "IDebugger.h"
+#include "ProcessSnapshot.h"
+#include "RegionReader.h"
+#include "edb.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+//------------------------------------------------------------------------------
+// Name: hash_pages
+// Desc: hashes <count> pages starting at <p>
+//------------------------------------------------------------------------------
+QVector<quint64> hash_pages(const quint8 *p, std::size_t count, edb::address_t page_size) {
+	QVector<quint64> hashes(count);
+	for(std::size_t i = 0; i < count; ++i) {
+		hashes[i] = edb::internal::xxh64(p + i * page_size, page_size);
+	}
+	return hashes;
+}
+
+}
+
+//------------------------------------------------------------------------------
+// Name: RegionDiff
+// Desc: constructor
+//------------------------------------------------------------------------------
+RegionDiff::RegionDiff() : page_size_(0) {
+}
+
+//------------------------------------------------------------------------------
+// Name: ~RegionDiff
+// Desc: destructor
+//------------------------------------------------------------------------------
+RegionDiff::~RegionDiff() {
+}
+
+//------------------------------------------------------------------------------
+// Name: diff
+// Desc: with SSE2 the equal stretches are skipped 16 bytes at a time, only
+//       the blocks with a difference in them are looked at byte by byte
+//------------------------------------------------------------------------------
+void RegionDiff::diff(const quint8 *live, const quint8 *old, std::size_t size, edb::address_t address, QVector<Change> *changes) {
+
+	Q_ASSERT(changes);
+
+	std::size_t j = 0;
+	while(j < size) {
+
+#ifdef __SSE2__
+		while(size - j >= 16) {
+			const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(live + j));
+			const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(old + j));
+			if(_mm_movemask_epi8(_mm_cmpeq_epi8(a, b)) != 0xffff) {
+				break;
+			}
+			j += 16;
+		}
+
+		if(j == size) {
+			break;
+		}
+#endif
+
+		if(live[j] == old[j]) {
+			++j;
+			continue;
+		}
+
+		const std::size_t run_start = j;
+		while(j < size && live[j] != old[j]) {
+			++j;
+		}
+
+		const edb::address_t run_address = address + run_start;
+		const edb::address_t run_size    = j - run_start;
+
+		if(!changes->isEmpty() && changes->back().address + changes->back().size == run_address) {
+			changes->back().size += run_size;
+		} else {
+			const Change change = { run_address, run_size };
+			changes->push_back(change);
+		}
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: overlaps
+// Desc: the first change which ends past the address is the only one which
+//       can overlap it
+//------------------------------------------------------------------------------
+bool RegionDiff::overlaps(const QVector<Change> &changes, edb::address_t address, edb::address_t size) {
+
+	int lo = 0;
+	int hi = changes.size();
+	while(lo < hi) {
+		const int mid = (lo + hi) / 2;
+		if(changes[mid].address + changes[mid].size <= address) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+
+	return lo != changes.size() && changes[lo].address < address + size;
+}
+
+//------------------------------------------------------------------------------
+// Name: clear
+// Desc: throws away the baseline
+//------------------------------------------------------------------------------
+void RegionDiff::clear() {
+	snapshot_.reset();
+	baseline_.clear();
+}
+
+//------------------------------------------------------------------------------
+// Name: has_baseline
+// Desc:
+//------------------------------------------------------------------------------
+bool RegionDiff::has_baseline() const {
+	return !baseline_.isEmpty();
+}
+
+//------------------------------------------------------------------------------
+// Name: set_baseline
+// Desc: captures the current contents of <regions> to compare against later
+//------------------------------------------------------------------------------
+void RegionDiff::set_baseline(const QList<IRegion::pointer> &regions) {
+
+	clear();
+
+	if(!edb::v1::debugger_core) {
+		return;
+	}
+
+	IProcess *const process = edb::v1::debugger_core->process();
+	if(!process) {
+		return;
+	}
+
+	page_size_ = edb::v1::debugger_core->page_size();
+	snapshot_.reset(new ProcessSnapshot(process));
+
+	Q_FOREACH(const IRegion::pointer &region, regions) {
+		if(snapshot_->add_region(region)) {
+			Baseline baseline;
+			baseline.region = IRegion::pointer(region->clone());
+			baseline.hashes = hash_pages(snapshot_->data(region->start(), 0), region->size() / page_size_, page_size_);
+			baseline_.push_back(baseline);
+		}
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: compare
+// Desc: compares the live process against the baseline
+// Note: pages which can no longer be read are not reported
+//------------------------------------------------------------------------------
+QVector<RegionDiff::Change> RegionDiff::compare(QVector<edb::address_t> *changed_pages) const {
+
+	QVector<Change> changes;
+
+	if(changed_pages) {
+		changed_pages->clear();
+	}
+
+	RegionReader reader;
+
+	Q_FOREACH(const Baseline &baseline, baseline_) {
+
+		const edb::address_t region_start = baseline.region->start();
+
+		reader.reset(baseline.region);
+		while(reader.next()) {
+
+			const std::size_t page_count = reader.size() / page_size_;
+			const std::size_t first_page = (reader.address() - region_start) / page_size_;
+
+			for(std::size_t i = 0; i < page_count; ++i) {
+
+				// matching hashes are taken to mean the page is untouched
+				const quint8 *const live = reader.data() + i * page_size_;
+				if(edb::internal::xxh64(live, page_size_) == baseline.hashes[first_page + i]) {
+					continue;
+				}
+
+				const edb::address_t page_address = reader.address() + i * page_size_;
+				const quint8 *const old           = snapshot_->data(page_address, 0);
+
+				// now find out exactly what changed in this page
+				diff(live, old, page_size_, page_address, &changes);
+
+				if(changed_pages) {
+					changed_pages->push_back(page_address);
+				}
+			}
+		}
+	}
+
+	return changes;
+}
@@ -0,0 +1,114 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "RegionReader.h"
+#include "IDebugger.h"
+#include "IProcess.h"
+#include "edb.h"
+
+//------------------------------------------------------------------------------
+// Name: RegionReader
+// Desc: constructor
+//------------------------------------------------------------------------------
+RegionReader::RegionReader(std::size_t lookahead, std::size_t window_pages) : address_(0), next_address_(0), size_(0), available_(0), lookahead_(lookahead), window_pages_(qMax<std::size_t>(window_pages, 1)) {
+}
+
+//------------------------------------------------------------------------------
+// Name: RegionReader
+// Desc: constructor
+//------------------------------------------------------------------------------
+RegionReader::RegionReader(const IRegion::pointer &region, std::size_t lookahead, std::size_t window_pages) : address_(0), next_address_(0), size_(0), available_(0), lookahead_(lookahead), window_pages_(qMax<std::size_t>(window_pages, 1)) {
+	reset(region);
+}
+
+//------------------------------------------------------------------------------
+// Name: reset
+// Desc: starts over at the beginning of <region>, the buffer is kept so
+//       a single reader can be used for a whole list of regions
+//------------------------------------------------------------------------------
+void RegionReader::reset(const IRegion::pointer &region) {
+	region_       = region;
+	address_      = region ? region->start() : 0;
+	next_address_ = address_;
+	size_         = 0;
+	available_    = 0;
+}
+
+//------------------------------------------------------------------------------
+// Name: offset
+// Desc: returns how far into the region the current window starts, handy for
+//       progress bars
+//------------------------------------------------------------------------------
+edb::address_t RegionReader::offset() const {
+	return region_ ? address_ - region_->start() : 0;
+}
+
+//------------------------------------------------------------------------------
+// Name: next
+// Desc: reads the next window of the region, returns false once there is
+//       nothing left to read
+// Note: windows which can't be read are skipped, so address() isn't always
+//       size() bytes after the previous one
+//------------------------------------------------------------------------------
+bool RegionReader::next() {
+
+	if(!region_ || !edb::v1::debugger_core) {
+		return false;
+	}
+
+	IProcess *const process = edb::v1::debugger_core->process();
+	if(!process) {
+		return false;
+	}
+
+	const edb::address_t page_size    = edb::v1::debugger_core->page_size();
+	const std::size_t lookahead_pages = (lookahead_ + page_size - 1) / page_size;
+	const edb::address_t region_end   = region_->end();
+
+	while(next_address_ < region_end) {
+
+		const edb::address_t window_address = next_address_;
+		const std::size_t pages_left        = (region_end - window_address + page_size - 1) / page_size;
+		const std::size_t window_pages      = qMin(window_pages_, pages_left);
+		const std::size_t read_pages        = qMin(window_pages_ + lookahead_pages, pages_left);
+
+		next_address_ = window_address + window_pages * page_size;
+
+		if(buffer_.size() < static_cast<int>(read_pages * page_size)) {
+			buffer_.resize((window_pages_ + lookahead_pages) * page_size);
+		}
+
+		std::size_t pages_read = read_pages;
+		if(!process->read_pages(window_address, buffer_.data(), pages_read)) {
+			// the lookahead may be what failed, don't lose the window over it
+			pages_read = window_pages;
+			if(read_pages == window_pages || !process->read_pages(window_address, buffer_.data(), pages_read)) {
+				continue;
+			}
+		}
+
+		address_   = window_address;
+		size_      = qMin<edb::address_t>(window_pages * page_size, region_end - window_address);
+		available_ = qMin<edb::address_t>(qMin<edb::address_t>(pages_read * page_size, size_ + lookahead_), region_end - window_address);
+		return true;
+	}
+
+	size_      = 0;
+	available_ = 0;
+	return false;
+}
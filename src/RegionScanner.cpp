@@ -0,0 +1,143 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "RegionScanner.h"
+#include "RegionReader.h"
+#include <QMutex>
+#include <QQueue>
+#include <QRunnable>
+#include <QScopedPointer>
+#include <QThreadPool>
+#include <QWaitCondition>
+#include <cstring>
+
+//------------------------------------------------------------------------------
+// Name: Job
+// Desc: one chunk being scanned on the pool
+//------------------------------------------------------------------------------
+class RegionScanner::Job : public QRunnable {
+public:
+	Job(const Task *task, QMutex *lock, QWaitCondition *finished) : task_(task), lock_(lock), finished_(finished), done_(false) {
+		setAutoDelete(false);
+	}
+
+public:
+	virtual void run() {
+		Task::Result *const result = task_->scan(chunk);
+
+		QMutexLocker locker(lock_);
+		result_.reset(result);
+		done_ = true;
+		finished_->wakeAll();
+	}
+
+public:
+	// waits for the scan to be done and takes its result
+	Task::Result *wait() {
+		QMutexLocker locker(lock_);
+		while(!done_) {
+			finished_->wait(lock_);
+		}
+		return result_.take();
+	}
+
+public:
+	Chunk chunk;
+
+private:
+	const Task                   *task_;
+	QMutex                       *lock_;
+	QWaitCondition               *finished_;
+	QScopedPointer<Task::Result>  result_;
+	bool                          done_;
+};
+
+//------------------------------------------------------------------------------
+// Name: RegionScanner
+// Desc: uses the global thread pool unless given one
+//------------------------------------------------------------------------------
+RegionScanner::RegionScanner(QThreadPool *pool) : pool_(pool ? pool : QThreadPool::globalInstance()) {
+}
+
+//------------------------------------------------------------------------------
+// Name: run
+// Desc: scans <regions> with <task>, returning once every result has been
+//       merged
+//------------------------------------------------------------------------------
+void RegionScanner::run(const QList<IRegion::pointer> &regions, Task *task) {
+
+	Q_ASSERT(task);
+
+	// enough to keep every thread busy while the next window is read
+	const int max_in_flight = qMax(pool_->maxThreadCount(), 1) * 2;
+
+	edb::address_t total = 0;
+	Q_FOREACH(const IRegion::pointer &region, regions) {
+		total += region->size();
+	}
+
+	QMutex         lock;
+	QWaitCondition finished;
+	QQueue<Job *>  pending;
+	edb::address_t merged = 0;
+
+	RegionReader reader(task->lookahead());
+
+	Q_FOREACH(const IRegion::pointer &region, regions) {
+		reader.reset(region);
+		while(reader.next()) {
+
+			Job *const job = new Job(task, &lock, &finished);
+			job->chunk.region  = region;
+			job->chunk.address = reader.address();
+			job->chunk.size    = reader.size();
+			job->chunk.data.resize(reader.available());
+			std::memcpy(job->chunk.data.data(), reader.data(), reader.available());
+
+			pending.enqueue(job);
+			pool_->start(job);
+
+			while(pending.size() >= max_in_flight) {
+				merge_oldest(&pending, task, &merged, total);
+			}
+		}
+	}
+
+	while(!pending.isEmpty()) {
+		merge_oldest(&pending, task, &merged, total);
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: merge_oldest
+// Desc: waits for the oldest chunk in flight and merges its result, which
+//       keeps the results in address order
+//------------------------------------------------------------------------------
+void RegionScanner::merge_oldest(QQueue<Job *> *pending, Task *task, edb::address_t *merged, edb::address_t total) {
+
+	Job *const job = pending->dequeue();
+
+	const QScopedPointer<Task::Result> result(job->wait());
+	if(result) {
+		task->merge(result.data());
+	}
+
+	*merged += job->chunk.size;
+	delete job;
+
+	task->progress(total ? static_cast<int>(qMin(*merged, total) * 100.0 / total) : 100);
+}
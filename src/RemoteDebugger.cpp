@@ -0,0 +1,1244 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "RemoteDebugger.h"
+#include "CoreFile.h"
+#include "IProcess.h"
+#include "RemoteProtocol.h"
+#include "State.h"
+#include "edb.h"
+
+#include <QCache>
+#include <QDataStream>
+#include <QDateTime>
+#include <QVector>
+#include <QtDebug>
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+// how many pages the local cache holds, 16 MB of 4K pages
+const int CachePages = 4096;
+
+// the most pages read_bytes asks for in one go, well inside the cache
+const int ChunkPages = 1024;
+
+// pages after the last one asked for which come along with it, views tend to
+// scroll forward
+const int ReadAheadPages = 8;
+
+// the arguments of a request
+class Arguments {
+	Q_DISABLE_COPY(Arguments)
+public:
+	Arguments() : stream_(&data_, QIODevice::WriteOnly) {
+		stream_.setVersion(Remote::StreamVersion);
+	}
+
+public:
+	template <class T>
+	Arguments &operator<<(const T &value) {
+		stream_ << value;
+		return *this;
+	}
+
+	const QByteArray &data() const { return data_; }
+
+private:
+	QByteArray  data_;
+	QDataStream stream_;
+};
+
+// the answer to one
+class Reply : public QDataStream {
+public:
+	explicit Reply(const QByteArray &data) : QDataStream(data) {
+		setVersion(Remote::StreamVersion);
+	}
+};
+
+//------------------------------------------------------------------------------
+// Name: next_memory_generation
+// Desc: starts well clear of what the plugin cores hand out, so that a remote
+//       process never shares a generation with a local one
+//------------------------------------------------------------------------------
+quint64 next_memory_generation() {
+	static quint64 generation = Q_UINT64_C(1) << 62;
+	return ++generation;
+}
+
+// an event the stub saw
+class RemoteEvent : public IDebugEvent {
+public:
+	explicit RemoteEvent(QDataStream &in) : reason_(0), trap_reason_(0), flags_(0), pid_(0), tid_(0), code_(0), violation_(false), address_(0) {
+		in >> reason_ >> trap_reason_ >> flags_ >> pid_ >> tid_ >> code_ >> message_.caption >> message_.message >> violation_ >> address_;
+	}
+
+public:
+	virtual IDebugEvent *clone() const { return new RemoteEvent(*this); }
+
+public:
+	virtual Message error_description() const { return message_; }
+	virtual REASON reason() const             { return static_cast<REASON>(reason_); }
+	virtual TRAP_REASON trap_reason() const   { return static_cast<TRAP_REASON>(trap_reason_); }
+	virtual bool exited() const               { return flags_ & Remote::EVENT_EXITED; }
+	virtual bool is_error() const             { return flags_ & Remote::EVENT_ERROR; }
+	virtual bool is_kill() const              { return flags_ & Remote::EVENT_KILL; }
+	virtual bool is_stop() const              { return flags_ & Remote::EVENT_STOP; }
+	virtual bool is_trap() const              { return flags_ & Remote::EVENT_TRAP; }
+	virtual bool stopped() const              { return flags_ & Remote::EVENT_STOPPED; }
+	virtual bool terminated() const           { return flags_ & Remote::EVENT_TERMINATED; }
+	virtual edb::pid_t process() const        { return pid_; }
+	virtual edb::tid_t thread() const         { return tid_; }
+	virtual int code() const                  { return code_; }
+
+public:
+	virtual bool access_violation(edb::address_t *address) const {
+		if(violation_ && address) {
+			*address = address_;
+		}
+		return violation_;
+	}
+
+private:
+	qint32  reason_;
+	qint32  trap_reason_;
+	quint32 flags_;
+	qint64  pid_;
+	qint64  tid_;
+	qint32  code_;
+	Message message_;
+	bool    violation_;
+	quint64 address_;
+};
+
+}
+
+// a region of the remote process
+class RemoteRegion : public IRegion {
+public:
+	RemoteRegion(RemoteDebugger *debugger, QDataStream &in) : debugger_(debugger), start_(0), end_(0), base_(0), permissions_(0), read_(false), write_(false), execute_(false) {
+		in >> start_ >> end_ >> base_ >> name_ >> permissions_ >> read_ >> write_ >> execute_;
+	}
+
+public:
+	virtual IRegion *clone() const { return new RemoteRegion(*this); }
+
+public:
+	virtual bool accessible() const           { return read_ || write_ || execute_; }
+	virtual bool readable() const             { return read_; }
+	virtual bool writable() const             { return write_; }
+	virtual bool executable() const           { return execute_; }
+	virtual edb::address_t size() const       { return end_ - start_; }
+
+public:
+	virtual void set_permissions(bool read, bool write, bool execute) {
+		debugger_->call(Remote::CMD_REGION_PERMISSIONS, (Arguments() << start_ << end_ << read << write << execute).data());
+		read_    = read;
+		write_   = write;
+		execute_ = execute;
+	}
+
+	virtual void set_start(edb::address_t address) { start_ = address; }
+	virtual void set_end(edb::address_t address)   { end_ = address; }
+
+public:
+	virtual edb::address_t start() const      { return start_; }
+	virtual edb::address_t end() const        { return end_; }
+	virtual edb::address_t base() const       { return base_; }
+	virtual QString name() const              { return name_; }
+	virtual permissions_t permissions() const { return permissions_; }
+
+private:
+	RemoteDebugger *debugger_;
+	quint64         start_;
+	quint64         end_;
+	quint64         base_;
+	QString         name_;
+	quint32         permissions_;
+	bool            read_;
+	bool            write_;
+	bool            execute_;
+};
+
+// a breakpoint the stub's core has set, the flags which only matter to the
+// UI are kept here
+class RemoteBreakpoint : public IBreakpoint {
+public:
+	RemoteBreakpoint(RemoteDebugger *debugger, edb::address_t address, quint8 original_byte)
+		: remote_hits(0), debugger_(debugger), address_(address), hit_count_(0), original_byte_(original_byte), enabled_(true), one_time_(false), internal_(false) {
+	}
+
+public:
+	virtual edb::address_t address() const { return address_; }
+	virtual quint64 hit_count() const      { return hit_count_; }
+	virtual bool enabled() const           { return enabled_; }
+	virtual bool one_time() const          { return one_time_; }
+	virtual bool internal() const          { return internal_; }
+	virtual quint8 original_byte() const   { return original_byte_; }
+
+public:
+	virtual bool enable()                  { return set_enabled(true); }
+	virtual bool disable()                 { return set_enabled(false); }
+	virtual void hit()                     { ++hit_count_; }
+	virtual void set_one_time(bool value)  { one_time_ = value; }
+	virtual void set_internal(bool value)  { internal_ = value; }
+
+public:
+	// the stub counts the hits its core skips for their conditions, those
+	// are added to ours as they come in
+	void remote_hit_count(quint64 hits) {
+		if(hits > remote_hits) {
+			hit_count_ += hits - remote_hits;
+		}
+		remote_hits = hits;
+	}
+
+public:
+	quint64 remote_hits;
+	QString sent_condition;
+
+private:
+	bool set_enabled(bool enable) {
+		Reply reply(debugger_->call(Remote::CMD_ENABLE_BREAKPOINT, (Arguments() << static_cast<quint64>(address_) << enable).data()));
+		bool ok = false;
+		reply >> ok;
+		if(ok) {
+			enabled_ = enable;
+		}
+		return ok;
+	}
+
+private:
+	RemoteDebugger *debugger_;
+	edb::address_t  address_;
+	quint64         hit_count_;
+	quint8          original_byte_;
+	bool            enabled_;
+	bool            one_time_;
+	bool            internal_;
+};
+
+// the remote process, its memory is cached a page at a time until it runs
+class RemoteProcess : public IProcess {
+public:
+	RemoteProcess(RemoteDebugger *debugger, QDataStream &in)
+		: debugger_(debugger), pid_(0), code_address_(0), data_address_(0), pages_(CachePages), regions_valid_(false), regions_request_(0), generation_(next_memory_generation()) {
+		in >> pid_ >> executable_ >> arguments_ >> current_working_directory_ >> start_time_ >> code_address_ >> data_address_;
+	}
+
+	virtual ~RemoteProcess() {
+		debugger_->receive(regions_request_);
+	}
+
+public:
+	virtual QDateTime               start_time() const                { return start_time_; }
+	virtual QList<QByteArray>       arguments() const                 { return arguments_; }
+	virtual QString                 current_working_directory() const { return current_working_directory_; }
+	virtual QString                 executable() const                { return executable_; }
+	virtual edb::pid_t              pid() const                       { return pid_; }
+	virtual pointer                 parent() const                    { return pointer(); }
+	virtual edb::address_t          code_address() const              { return code_address_; }
+	virtual edb::address_t          data_address() const              { return data_address_; }
+	virtual QList<IRegion::pointer> regions() const;
+
+public:
+	virtual bool write_bytes(edb::address_t address, const void *buf, size_t len);
+	virtual bool read_bytes(edb::address_t address, void *buf, size_t len);
+	virtual bool read_pages(edb::address_t address, void *buf, size_t count);
+	virtual QVector<bool> read_batch(const QVector<ReadRequest> &requests);
+	virtual quint64 memory_generation() const { return generation_; }
+
+public:
+	void ran(bool map_changed);
+	void prefetch_regions();
+
+private:
+	void missing_pages(edb::address_t address, size_t len, QVector<edb::address_t> *pages) const;
+	void fetch(QVector<edb::address_t> pages);
+	bool copy(edb::address_t address, void *buf, size_t len) const;
+
+private:
+	RemoteDebugger *const                      debugger_;
+	qint64                                     pid_;
+	QString                                    executable_;
+	QList<QByteArray>                          arguments_;
+	QString                                    current_working_directory_;
+	QDateTime                                  start_time_;
+	quint64                                    code_address_;
+	quint64                                    data_address_;
+	QCache<edb::address_t, QByteArray>         pages_;  // an empty page couldn't be read
+	mutable QList<IRegion::pointer>            regions_;
+	mutable bool                               regions_valid_;
+	mutable quint32                            regions_request_;
+	quint64                                    generation_;
+};
+
+//------------------------------------------------------------------------------
+// Name: regions
+// Desc: the memory map as of this stop, it may already be on its way
+//------------------------------------------------------------------------------
+QList<IRegion::pointer> RemoteProcess::regions() const {
+
+	if(!regions_valid_) {
+		if(!regions_request_) {
+			regions_request_ = debugger_->send(Remote::CMD_REGIONS);
+		}
+
+		Reply reply(debugger_->receive(regions_request_));
+		regions_request_ = 0;
+
+		quint32 count = 0;
+		reply >> count;
+
+		regions_.clear();
+		for(quint32 i = 0; i < count && reply.status() == QDataStream::Ok; ++i) {
+			regions_.push_back(IRegion::pointer(new RemoteRegion(debugger_, reply)));
+		}
+
+		regions_valid_ = debugger_->is_connected();
+	}
+
+	return regions_;
+}
+
+//------------------------------------------------------------------------------
+// Name: ran
+// Desc: the process has had a chance to change its memory, and its map too if
+//       <map_changed>
+//------------------------------------------------------------------------------
+void RemoteProcess::ran(bool map_changed) {
+	pages_.clear();
+	generation_ = next_memory_generation();
+
+	if(map_changed) {
+		regions_valid_ = false;
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: prefetch_regions
+// Desc: asks for the memory map without waiting for it
+//------------------------------------------------------------------------------
+void RemoteProcess::prefetch_regions() {
+	if(!regions_valid_ && !regions_request_) {
+		regions_request_ = debugger_->send(Remote::CMD_REGIONS);
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: missing_pages
+// Desc: adds the pages of [address, address + len) which aren't cached yet to
+//       <pages>
+//------------------------------------------------------------------------------
+void RemoteProcess::missing_pages(edb::address_t address, size_t len, QVector<edb::address_t> *pages) const {
+
+	const edb::address_t page_size = debugger_->page_size();
+	const edb::address_t last      = (address + len - 1) & ~(page_size - 1);
+
+	for(edb::address_t page = address & ~(page_size - 1); ; page += page_size) {
+		if(!pages_.contains(page)) {
+			pages->push_back(page);
+		}
+
+		if(page == last) {
+			break;
+		}
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: fetch
+// Desc: brings <pages> into the cache with a single request, runs of
+//       adjacent pages are asked for together. A run which can't be read as a
+//       whole is asked for again a page at a time, so that one bad page
+//       doesn't take its neighbours with it
+//------------------------------------------------------------------------------
+void RemoteProcess::fetch(QVector<edb::address_t> pages) {
+
+	const edb::address_t page_size = debugger_->page_size();
+
+	std::sort(pages.begin(), pages.end());
+	pages.erase(std::unique(pages.begin(), pages.end()), pages.end());
+
+	if(!pages.isEmpty()) {
+		for(int i = 1; i <= ReadAheadPages && !pages_.contains(pages.last() + page_size); ++i) {
+			pages.push_back(pages.last() + page_size);
+		}
+	}
+
+	bool whole_runs = true;
+	while(!pages.isEmpty()) {
+
+		QVector<QPair<edb::address_t, quint32> > runs;
+		Q_FOREACH(edb::address_t page, pages) {
+			if(whole_runs && !runs.isEmpty() && runs.last().first + runs.last().second * page_size == page && runs.last().second < static_cast<quint32>(ChunkPages)) {
+				++runs.last().second;
+			} else {
+				runs.push_back(qMakePair(page, 1u));
+			}
+		}
+
+		Arguments args;
+		args << static_cast<quint32>(runs.size());
+		for(int i = 0; i < runs.size(); ++i) {
+			args << static_cast<quint64>(runs[i].first) << runs[i].second;
+		}
+
+		Reply reply(debugger_->call(Remote::CMD_READ_PAGES, args.data()));
+
+		QVector<edb::address_t> retry;
+		for(int i = 0; i < runs.size(); ++i) {
+			bool       ok = false;
+			QByteArray bytes;
+			reply >> ok >> bytes;
+
+			const edb::address_t start = runs[i].first;
+			const quint32        count = runs[i].second;
+
+			if(ok && static_cast<edb::address_t>(bytes.size()) == count * page_size) {
+				for(quint32 n = 0; n < count; ++n) {
+					pages_.insert(start + n * page_size, new QByteArray(bytes.mid(n * page_size, page_size)));
+				}
+			} else if(count == 1 || !debugger_->is_connected()) {
+				for(quint32 n = 0; n < count; ++n) {
+					pages_.insert(start + n * page_size, new QByteArray);
+				}
+			} else {
+				for(quint32 n = 0; n < count; ++n) {
+					retry.push_back(start + n * page_size);
+				}
+			}
+		}
+
+		pages      = retry;
+		whole_runs = false;
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: copy
+// Desc: copies what is cached of [address, address + len) into <buf>, anything
+//       not there is filled with 0xff and makes this return false
+//------------------------------------------------------------------------------
+bool RemoteProcess::copy(edb::address_t address, void *buf, size_t len) const {
+
+	const edb::address_t page_size = debugger_->page_size();
+
+	quint8 *ptr = reinterpret_cast<quint8 *>(buf);
+	bool ok = true;
+
+	while(len != 0) {
+		const edb::address_t page   = address & ~(page_size - 1);
+		const edb::address_t offset = address - page;
+		const size_t n = qMin<size_t>(page_size - offset, len);
+
+		const QByteArray *const bytes = pages_.object(page);
+		if(bytes && !bytes->isEmpty()) {
+			std::memcpy(ptr, bytes->constData() + offset, n);
+		} else {
+			std::memset(ptr, 0xff, n);
+			ok = false;
+		}
+
+		address += n;
+		ptr     += n;
+		len     -= n;
+	}
+
+	return ok;
+}
+
+//------------------------------------------------------------------------------
+// Name: read_bytes
+// Desc: reads <len> bytes at <address>, from the cache where possible
+//------------------------------------------------------------------------------
+bool RemoteProcess::read_bytes(edb::address_t address, void *buf, size_t len) {
+
+	Q_ASSERT(buf);
+
+	const size_t chunk = ChunkPages * debugger_->page_size();
+	quint8 *ptr = reinterpret_cast<quint8 *>(buf);
+	bool ok = true;
+
+	while(len != 0) {
+		const size_t n = qMin(len, chunk);
+
+		QVector<edb::address_t> pages;
+		missing_pages(address, n, &pages);
+		fetch(pages);
+
+		ok = copy(address, ptr, n) && ok;
+
+		address += n;
+		ptr     += n;
+		len     -= n;
+	}
+
+	return ok;
+}
+
+//------------------------------------------------------------------------------
+// Name: read_pages
+// Desc:
+//------------------------------------------------------------------------------
+bool RemoteProcess::read_pages(edb::address_t address, void *buf, size_t count) {
+
+	if((address & (debugger_->page_size() - 1)) != 0) {
+		return false;
+	}
+
+	return read_bytes(address, buf, count * debugger_->page_size());
+}
+
+//------------------------------------------------------------------------------
+// Name: read_batch
+// Desc: everything which isn't cached is asked for in one request
+//------------------------------------------------------------------------------
+QVector<bool> RemoteProcess::read_batch(const QVector<ReadRequest> &requests) {
+
+	QVector<edb::address_t> pages;
+	Q_FOREACH(const ReadRequest &request, requests) {
+		if(request.length != 0) {
+			missing_pages(request.address, request.length, &pages);
+		}
+	}
+
+	if(pages.size() > ChunkPages) {
+		return IProcess::read_batch(requests);
+	}
+
+	fetch(pages);
+
+	QVector<bool> results;
+	results.reserve(requests.size());
+	Q_FOREACH(const ReadRequest &request, requests) {
+		results.push_back(copy(request.address, request.buffer, request.length));
+	}
+	return results;
+}
+
+//------------------------------------------------------------------------------
+// Name: write_bytes
+// Desc: writes go straight through, the cached copies are updated to match
+//------------------------------------------------------------------------------
+bool RemoteProcess::write_bytes(edb::address_t address, const void *buf, size_t len) {
+
+	Reply reply(debugger_->call(Remote::CMD_WRITE_BYTES, (Arguments() << static_cast<quint64>(address) << QByteArray(static_cast<const char *>(buf), len)).data()));
+
+	bool ok = false;
+	reply >> ok;
+
+	const edb::address_t page_size = debugger_->page_size();
+	const quint8 *ptr = static_cast<const quint8 *>(buf);
+
+	while(len != 0) {
+		const edb::address_t page   = address & ~(page_size - 1);
+		const edb::address_t offset = address - page;
+		const size_t n = qMin<size_t>(page_size - offset, len);
+
+		if(QByteArray *const bytes = pages_.object(page)) {
+			if(ok && !bytes->isEmpty()) {
+				std::memcpy(bytes->data() + offset, ptr, n);
+			} else {
+				pages_.remove(page);
+			}
+		}
+
+		address += n;
+		ptr     += n;
+		len     -= n;
+	}
+
+	generation_ = next_memory_generation();
+	return ok;
+}
+
+//------------------------------------------------------------------------------
+// Name: RemoteDebugger
+// Desc: <live_core> is the debugger core which was loaded as a plugin
+//------------------------------------------------------------------------------
+RemoteDebugger::RemoteDebugger(IDebugger *live_core)
+	: live_core_(live_core), next_serial_(0), page_size_(0x1000), cpu_type_(0), memory_map_changed_(true), state_request_(0), state_valid_(false), threads_request_(0), threads_valid_(false), active_thread_(0) {
+	Q_ASSERT(live_core_);
+}
+
+//------------------------------------------------------------------------------
+// Name: ~RemoteDebugger
+// Desc:
+//------------------------------------------------------------------------------
+RemoteDebugger::~RemoteDebugger() {
+	process_.reset();
+	socket_.abort();
+}
+
+//------------------------------------------------------------------------------
+// Name: connect_to_stub
+// Desc: connects to the edb --stub at <host>:<port>, on failure <error> says
+//       why
+//------------------------------------------------------------------------------
+bool RemoteDebugger::connect_to_stub(const QString &host, quint16 port, QString *error) {
+
+	Q_ASSERT(error);
+
+	socket_.connectToHost(host, port);
+	if(!socket_.waitForConnected(Timeout)) {
+		*error = tr("Could not connect to %1:%2: %3").arg(host).arg(port).arg(socket_.errorString());
+		socket_.abort();
+		return false;
+	}
+
+	socket_.setSocketOption(QAbstractSocket::LowDelayOption, 1);
+
+	Reply reply(call(Remote::CMD_HELLO, (Arguments() << Remote::Magic << Remote::Version).data()));
+
+	quint32 magic        = 0;
+	quint32 version      = 0;
+	quint64 page_size    = 0;
+	qint32  pointer_size = 0;
+	quint64 cpu_type     = 0;
+	reply >> magic >> version >> page_size >> pointer_size >> cpu_type;
+
+	if(magic != Remote::Magic || version != Remote::Version || page_size == 0) {
+		*error = tr("%1:%2 is not an edb stub of this version.").arg(host).arg(port);
+		socket_.abort();
+		return false;
+	}
+
+	if(pointer_size != live_core_->pointer_size() || cpu_type != live_core_->cpu_type()) {
+		*error = tr("The stub at %1:%2 debugs a different architecture than this edb.").arg(host).arg(port);
+		socket_.abort();
+		return false;
+	}
+
+	page_size_ = page_size;
+	cpu_type_  = cpu_type;
+	return true;
+}
+
+//------------------------------------------------------------------------------
+// Name: is_connected
+// Desc:
+//------------------------------------------------------------------------------
+bool RemoteDebugger::is_connected() const {
+	return socket_.state() == QAbstractSocket::ConnectedState;
+}
+
+//------------------------------------------------------------------------------
+// Name: peer_name
+// Desc: host:port of the stub
+//------------------------------------------------------------------------------
+QString RemoteDebugger::peer_name() const {
+	return QString("%1:%2").arg(socket_.peerName()).arg(socket_.peerPort());
+}
+
+//------------------------------------------------------------------------------
+// Name: send
+// Desc: queues a request, returns its serial for receive or 0 if there is no
+//       connection. Requests go out with the next receive
+//------------------------------------------------------------------------------
+quint32 RemoteDebugger::send(quint16 command, const QByteArray &args) const {
+
+	if(!is_connected()) {
+		return 0;
+	}
+
+	if(++next_serial_ == 0) {
+		++next_serial_;
+	}
+
+	socket_.write(Remote::make_frame(next_serial_, command, args));
+	return next_serial_;
+}
+
+//------------------------------------------------------------------------------
+// Name: receive
+// Desc: waits for the answer to the request <serial>, the answers to other
+//       requests which come first are kept for later. An empty answer means
+//       the connection was lost, and it is then closed for good
+//------------------------------------------------------------------------------
+QByteArray RemoteDebugger::receive(quint32 serial) const {
+
+	if(serial == 0) {
+		return QByteArray();
+	}
+
+	socket_.flush();
+
+	while(!replies_.contains(serial)) {
+		quint32    reply_serial;
+		quint16    command;
+		QByteArray payload;
+		const Remote::FrameStatus status = Remote::take_frame(&buffer_, &reply_serial, &command, &payload);
+		if(status == Remote::FRAME_OK) {
+			replies_.insert(reply_serial, payload);
+			continue;
+		}
+
+		if(status == Remote::FRAME_INVALID) {
+			qDebug() << "[RemoteDebugger] the stub sent a frame which can't be one of ours, dropping the connection";
+			socket_.abort();
+			replies_.clear();
+			return QByteArray();
+		}
+
+		if(!is_connected() || !socket_.waitForReadyRead(Timeout)) {
+			qDebug() << "[RemoteDebugger] lost the connection to the stub:" << qPrintable(socket_.errorString());
+			socket_.abort();
+			replies_.clear();
+			buffer_.clear();
+			return QByteArray();
+		}
+
+		buffer_ += socket_.readAll();
+	}
+
+	return replies_.take(serial);
+}
+
+//------------------------------------------------------------------------------
+// Name: call
+// Desc: a request and its answer
+//------------------------------------------------------------------------------
+QByteArray RemoteDebugger::call(quint16 command, const QByteArray &args) const {
+	return receive(send(command, args));
+}
+
+//------------------------------------------------------------------------------
+// Name: has_extension
+// Desc: the answers don't change, they are only asked for once
+//------------------------------------------------------------------------------
+bool RemoteDebugger::has_extension(quint64 ext) const {
+
+	QHash<quint64, bool>::const_iterator it = extensions_.constFind(ext);
+	if(it != extensions_.constEnd()) {
+		return *it;
+	}
+
+	Reply reply(call(Remote::CMD_HAS_EXTENSION, (Arguments() << ext).data()));
+	bool result = false;
+	reply >> result;
+
+	extensions_.insert(ext, result);
+	return result;
+}
+
+//------------------------------------------------------------------------------
+// Name: parent_pid
+// Desc:
+//------------------------------------------------------------------------------
+edb::pid_t RemoteDebugger::parent_pid(edb::pid_t pid) const {
+	Reply reply(call(Remote::CMD_PARENT_PID, (Arguments() << static_cast<qint64>(pid)).data()));
+	qint64 parent = 0;
+	reply >> parent;
+	return parent;
+}
+
+//------------------------------------------------------------------------------
+// Name: enumerate_processes
+// Desc: the processes on the stub's machine
+//------------------------------------------------------------------------------
+QMap<edb::pid_t, ProcessInfo> RemoteDebugger::enumerate_processes() const {
+
+	Reply reply(call(Remote::CMD_ENUMERATE_PROCESSES));
+
+	quint32 count = 0;
+	reply >> count;
+
+	QMap<edb::pid_t, ProcessInfo> ret;
+	for(quint32 i = 0; i < count && reply.status() == QDataStream::Ok; ++i) {
+		qint64 pid = 0;
+		qint64 uid = 0;
+
+		ProcessInfo info;
+		reply >> pid >> uid >> info.user >> info.name;
+		info.pid = pid;
+		info.uid = uid;
+		ret.insert(info.pid, info);
+	}
+
+	return ret;
+}
+
+//------------------------------------------------------------------------------
+// Name: loaded_modules
+// Desc:
+//------------------------------------------------------------------------------
+QList<Module> RemoteDebugger::loaded_modules() const {
+
+	Reply reply(call(Remote::CMD_MODULES));
+
+	quint32 count = 0;
+	reply >> count;
+
+	QList<Module> ret;
+	for(quint32 i = 0; i < count && reply.status() == QDataStream::Ok; ++i) {
+		quint64 base = 0;
+
+		Module module;
+		reply >> module.name >> base;
+		module.base_address = base;
+		ret.push_back(module);
+	}
+
+	return ret;
+}
+
+//------------------------------------------------------------------------------
+// Name: attach
+// Desc:
+//------------------------------------------------------------------------------
+bool RemoteDebugger::attach(edb::pid_t pid) {
+
+	Reply reply(call(Remote::CMD_ATTACH, (Arguments() << static_cast<qint64>(pid)).data()));
+	bool ok = false;
+	reply >> ok;
+
+	if(ok) {
+		process_started();
+	}
+	return ok;
+}
+
+//------------------------------------------------------------------------------
+// Name: open
+// Desc: <path> and <cwd> are on the stub's machine
+//------------------------------------------------------------------------------
+bool RemoteDebugger::open(const QString &path, const QString &cwd, const QList<QByteArray> &args) {
+
+	Reply reply(call(Remote::CMD_OPEN, (Arguments() << path << cwd << args).data()));
+	bool ok = false;
+	reply >> ok;
+
+	if(ok) {
+		process_started();
+	}
+	return ok;
+}
+
+//------------------------------------------------------------------------------
+// Name: open
+// Desc: a local terminal is no use to a remote process, it gets the stub's
+//------------------------------------------------------------------------------
+bool RemoteDebugger::open(const QString &path, const QString &cwd, const QList<QByteArray> &args, const QString &tty) {
+	Q_UNUSED(tty);
+	return open(path, cwd, args);
+}
+
+//------------------------------------------------------------------------------
+// Name: wait_debug_event
+// Desc: the stub waits for at most <msecs> (and never very long) itself
+//------------------------------------------------------------------------------
+IDebugEvent::const_pointer RemoteDebugger::wait_debug_event(int msecs) {
+
+	if(!process_) {
+		return IDebugEvent::const_pointer();
+	}
+
+	Reply reply(call(Remote::CMD_WAIT_EVENT, (Arguments() << static_cast<qint32>(msecs)).data()));
+
+	bool have_event = false;
+	reply >> have_event;
+	if(!have_event) {
+		return IDebugEvent::const_pointer();
+	}
+
+	const IDebugEvent::const_pointer e(new RemoteEvent(reply));
+
+	bool map_changed = true;
+	reply >> map_changed;
+	memory_map_changed_ = map_changed;
+
+	quint32 count = 0;
+	reply >> count;
+	for(quint32 i = 0; i < count && reply.status() == QDataStream::Ok; ++i) {
+		quint64 address = 0;
+		quint64 hits    = 0;
+		reply >> address >> hits;
+		if(const IBreakpoint::pointer bp = breakpoints_.value(address)) {
+			static_cast<RemoteBreakpoint *>(bp.data())->remote_hit_count(hits);
+		}
+	}
+
+	process_stopped();
+	return e;
+}
+
+//------------------------------------------------------------------------------
+// Name: process_started
+// Desc: a process was opened or attached to, nothing from before applies
+//------------------------------------------------------------------------------
+void RemoteDebugger::process_started() {
+
+	process_ended();
+
+	Reply reply(call(Remote::CMD_PROCESS));
+	bool have_process = false;
+	reply >> have_process;
+
+	if(have_process) {
+		process_.reset(new RemoteProcess(this, reply));
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: process_ran
+// Desc: about to let the process run, everything cached is about to be stale
+//------------------------------------------------------------------------------
+void RemoteDebugger::process_ran() {
+
+	receive(state_request_);
+	receive(threads_request_);
+	state_request_   = 0;
+	threads_request_ = 0;
+	state_valid_     = false;
+	threads_valid_   = false;
+
+	if(process_) {
+		process_->ran(false);
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: process_stopped
+// Desc: the process just stopped, what the UI will want to know about the stop
+//       is asked for right away, all in one go, and waited for only once it
+//       is actually needed
+//------------------------------------------------------------------------------
+void RemoteDebugger::process_stopped() {
+
+	if(process_) {
+		process_->ran(memory_map_changed_);
+	}
+
+	state_valid_     = false;
+	threads_valid_   = false;
+	state_request_   = send(Remote::CMD_GET_STATE);
+	threads_request_ = send(Remote::CMD_THREADS);
+
+	if(process_) {
+		process_->prefetch_regions();
+	}
+
+	socket_.flush();
+}
+
+//------------------------------------------------------------------------------
+// Name: process_ended
+// Desc: there is no process anymore
+//------------------------------------------------------------------------------
+void RemoteDebugger::process_ended() {
+	process_ran();
+	process_.reset();
+	breakpoints_.clear();
+	memory_map_changed_ = true;
+}
+
+//------------------------------------------------------------------------------
+// Name: detach
+// Desc:
+//------------------------------------------------------------------------------
+void RemoteDebugger::detach() {
+	call(Remote::CMD_DETACH);
+	process_ended();
+}
+
+//------------------------------------------------------------------------------
+// Name: kill
+// Desc:
+//------------------------------------------------------------------------------
+void RemoteDebugger::kill() {
+	call(Remote::CMD_KILL);
+	process_ended();
+}
+
+//------------------------------------------------------------------------------
+// Name: pause
+// Desc:
+//------------------------------------------------------------------------------
+void RemoteDebugger::pause() {
+	call(Remote::CMD_PAUSE);
+}
+
+//------------------------------------------------------------------------------
+// Name: send_conditions
+// Desc: the stub's core tests the conditions of breakpoints itself, so any
+//       which have been changed here are handed over before it runs
+//------------------------------------------------------------------------------
+void RemoteDebugger::send_conditions() {
+
+	QList<quint32> requests;
+	Q_FOREACH(const IBreakpoint::pointer &bp, breakpoints_) {
+		RemoteBreakpoint *const remote = static_cast<RemoteBreakpoint *>(bp.data());
+		if(remote->condition != remote->sent_condition) {
+			requests.push_back(send(Remote::CMD_SET_CONDITION, (Arguments() << static_cast<quint64>(remote->address()) << remote->condition).data()));
+			remote->sent_condition = remote->condition;
+		}
+	}
+
+	Q_FOREACH(quint32 serial, requests) {
+		receive(serial);
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: resume
+// Desc:
+//------------------------------------------------------------------------------
+void RemoteDebugger::resume(edb::EVENT_STATUS status) {
+	send_conditions();
+	process_ran();
+	call(Remote::CMD_RESUME, (Arguments() << static_cast<qint32>(status)).data());
+}
+
+//------------------------------------------------------------------------------
+// Name: step
+// Desc:
+//------------------------------------------------------------------------------
+void RemoteDebugger::step(edb::EVENT_STATUS status) {
+	send_conditions();
+	process_ran();
+	call(Remote::CMD_STEP, (Arguments() << static_cast<qint32>(status)).data());
+}
+
+//------------------------------------------------------------------------------
+// Name: get_state
+// Desc: the registers of the active thread, asked for once per stop. Only the
+//       general purpose registers come over the wire
+//------------------------------------------------------------------------------
+void RemoteDebugger::get_state(State *state) {
+
+	Q_ASSERT(state);
+
+	if(!state_valid_) {
+		if(!state_request_) {
+			state_request_ = send(Remote::CMD_GET_STATE);
+		}
+
+		Reply reply(receive(state_request_));
+		state_request_ = 0;
+
+		registers_.clear();
+		reply >> registers_;
+		state_valid_ = is_connected();
+	}
+
+	state->clear();
+	CoreFile::load_registers(reinterpret_cast<const uchar *>(registers_.constData()), registers_.size(), state);
+}
+
+//------------------------------------------------------------------------------
+// Name: set_state
+// Desc:
+//------------------------------------------------------------------------------
+void RemoteDebugger::set_state(const State &state) {
+
+	receive(state_request_);
+	state_request_ = 0;
+
+	registers_ = CoreFile::save_registers(state);
+	call(Remote::CMD_SET_STATE, (Arguments() << registers_).data());
+	state_valid_ = true;
+}
+
+//------------------------------------------------------------------------------
+// Name: load_threads
+// Desc: the threads of this stop, asked for once
+//------------------------------------------------------------------------------
+void RemoteDebugger::load_threads() const {
+
+	if(threads_valid_) {
+		return;
+	}
+
+	if(!threads_request_) {
+		threads_request_ = send(Remote::CMD_THREADS);
+	}
+
+	Reply reply(receive(threads_request_));
+	threads_request_ = 0;
+
+	QList<qint64> ids;
+	qint64 active = 0;
+	reply >> ids >> active;
+
+	threads_.clear();
+	Q_FOREACH(qint64 tid, ids) {
+		threads_.push_back(tid);
+	}
+
+	active_thread_ = active;
+	threads_valid_ = is_connected();
+}
+
+//------------------------------------------------------------------------------
+// Name: thread_ids
+// Desc:
+//------------------------------------------------------------------------------
+QList<edb::tid_t> RemoteDebugger::thread_ids() const {
+	load_threads();
+	return threads_;
+}
+
+//------------------------------------------------------------------------------
+// Name: active_thread
+// Desc:
+//------------------------------------------------------------------------------
+edb::tid_t RemoteDebugger::active_thread() const {
+	load_threads();
+	return active_thread_;
+}
+
+//------------------------------------------------------------------------------
+// Name: set_active_thread
+// Desc: the state which was fetched belongs to the old active thread
+//------------------------------------------------------------------------------
+void RemoteDebugger::set_active_thread(edb::tid_t tid) {
+
+	receive(state_request_);
+	receive(threads_request_);
+	state_request_   = 0;
+	threads_request_ = 0;
+
+	call(Remote::CMD_SET_ACTIVE_THREAD, (Arguments() << static_cast<qint64>(tid)).data());
+
+	state_valid_   = false;
+	threads_valid_ = false;
+}
+
+//------------------------------------------------------------------------------
+// Name: get_thread_info
+// Desc:
+//------------------------------------------------------------------------------
+ThreadInfo RemoteDebugger::get_thread_info(edb::tid_t tid) {
+
+	Reply reply(call(Remote::CMD_THREAD_INFO, (Arguments() << static_cast<qint64>(tid)).data()));
+
+	qint64  thread_id = tid;
+	quint64 ip        = 0;
+	qint32  priority  = 0;
+
+	ThreadInfo info;
+	info.running = false;
+	reply >> info.name >> thread_id >> ip >> priority >> info.state >> info.running;
+
+	info.tid      = thread_id;
+	info.ip       = ip;
+	info.priority = priority;
+	return info;
+}
+
+//------------------------------------------------------------------------------
+// Name: set_page_permissions
+// Desc:
+//------------------------------------------------------------------------------
+bool RemoteDebugger::set_page_permissions(edb::address_t address, edb::address_t size, bool read, bool write, bool execute) {
+
+	Reply reply(call(Remote::CMD_SET_PERMISSIONS, (Arguments() << static_cast<quint64>(address) << static_cast<quint64>(size) << read << write << execute).data()));
+	bool ok = false;
+	reply >> ok;
+	return ok;
+}
+
+//------------------------------------------------------------------------------
+// Name: backup_breakpoints
+// Desc:
+//------------------------------------------------------------------------------
+IDebugger::BreakpointList RemoteDebugger::backup_breakpoints() const {
+	return breakpoints_;
+}
+
+//------------------------------------------------------------------------------
+// Name: add_breakpoint
+// Desc:
+//------------------------------------------------------------------------------
+IBreakpoint::pointer RemoteDebugger::add_breakpoint(edb::address_t address) {
+
+	const QList<IBreakpoint::pointer> added = add_breakpoints(QList<edb::address_t>() << address);
+	return added.isEmpty() ? IBreakpoint::pointer() : added.first();
+}
+
+//------------------------------------------------------------------------------
+// Name: add_breakpoints
+// Desc: all of them are asked for before any answer is waited for
+//------------------------------------------------------------------------------
+QList<IBreakpoint::pointer> RemoteDebugger::add_breakpoints(const QList<edb::address_t> &addresses) {
+
+	QList<IBreakpoint::pointer> ret;
+	QList<QPair<edb::address_t, quint32> > requests;
+
+	Q_FOREACH(edb::address_t address, addresses) {
+		if(const IBreakpoint::pointer bp = breakpoints_.value(address)) {
+			ret.push_back(bp);
+		} else {
+			requests.push_back(qMakePair(address, send(Remote::CMD_ADD_BREAKPOINT, (Arguments() << static_cast<quint64>(address)).data())));
+		}
+	}
+
+	for(int i = 0; i < requests.size(); ++i) {
+		Reply reply(receive(requests[i].second));
+
+		bool   ok            = false;
+		quint8 original_byte = 0;
+		reply >> ok >> original_byte;
+
+		if(ok) {
+			const IBreakpoint::pointer bp(new RemoteBreakpoint(this, requests[i].first, original_byte));
+			breakpoints_.insert(requests[i].first, bp);
+			ret.push_back(bp);
+		}
+	}
+
+	return ret;
+}
+
+//------------------------------------------------------------------------------
+// Name: find_breakpoint
+// Desc:
+//------------------------------------------------------------------------------
+IBreakpoint::pointer RemoteDebugger::find_breakpoint(edb::address_t address) {
+	return breakpoints_.value(address);
+}
+
+//------------------------------------------------------------------------------
+// Name: clear_breakpoints
+// Desc:
+//------------------------------------------------------------------------------
+void RemoteDebugger::clear_breakpoints() {
+	call(Remote::CMD_CLEAR_BREAKPOINTS);
+	breakpoints_.clear();
+}
+
+//------------------------------------------------------------------------------
+// Name: remove_breakpoint
+// Desc:
+//------------------------------------------------------------------------------
+void RemoteDebugger::remove_breakpoint(edb::address_t address) {
+	if(breakpoints_.remove(address)) {
+		call(Remote::CMD_REMOVE_BREAKPOINT, (Arguments() << static_cast<quint64>(address)).data());
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: process
+// Desc: NULL if the stub isn't debugging anything
+//------------------------------------------------------------------------------
+IProcess *RemoteDebugger::process() const {
+	return process_.data();
+}
@@ -0,0 +1,150 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef REMOTEDEBUGGER_20261014_H_
+#define REMOTEDEBUGGER_20261014_H_
+
+#include "IDebugger.h"
+#include <QByteArray>
+#include <QCoreApplication>
+#include <QHash>
+#include <QScopedPointer>
+#include <QTcpSocket>
+
+class RemoteProcess;
+
+// a debugger core which does all of its work through an edb --stub on
+// another machine, so that ptrace happens next to the target and only
+// the answers cross the network. Memory is kept in a local page cache until
+// the process runs again, the state, threads and regions of a stop are asked
+// for together as soon as the stop is seen, and reads of many pages go out as
+// one request. What depends on the machine rather than the process (register
+// names, states, exceptions, ...) is asked of the live core, so the stub has
+// to be of the same architecture as this edb
+class RemoteDebugger : public IDebugger {
+	Q_DECLARE_TR_FUNCTIONS(RemoteDebugger)
+	Q_DISABLE_COPY(RemoteDebugger)
+
+	friend class RemoteBreakpoint;
+	friend class RemoteProcess;
+	friend class RemoteRegion;
+
+public:
+	explicit RemoteDebugger(IDebugger *live_core);
+	virtual ~RemoteDebugger();
+
+public:
+	bool connect_to_stub(const QString &host, quint16 port, QString *error);
+	bool is_connected() const;
+	QString peer_name() const;
+	IDebugger *live_core() const { return live_core_; }
+
+public:
+	virtual edb::address_t      page_size() const                            { return page_size_; }
+	virtual int                 pointer_size() const                         { return live_core_->pointer_size(); }
+	virtual quint64             cpu_type() const                             { return cpu_type_; }
+	virtual bool                has_extension(quint64 ext) const;
+	virtual QMap<long, QString> exceptions() const                           { return live_core_->exceptions(); }
+	virtual QString             stack_pointer() const                        { return live_core_->stack_pointer(); }
+	virtual QString             frame_pointer() const                        { return live_core_->frame_pointer(); }
+	virtual QString             instruction_pointer() const                  { return live_core_->instruction_pointer(); }
+	virtual QString             flag_register() const                        { return live_core_->flag_register(); }
+	virtual QString             format_pointer(edb::address_t address) const { return live_core_->format_pointer(address); }
+	virtual edb::pid_t          parent_pid(edb::pid_t pid) const;
+	virtual IState *            create_state() const                         { return live_core_->create_state(); }
+
+	virtual QMap<edb::pid_t, ProcessInfo> enumerate_processes() const;
+
+public:
+	virtual QList<Module> loaded_modules() const;
+
+public:
+	virtual bool attach(edb::pid_t pid);
+	virtual bool open(const QString &path, const QString &cwd, const QList<QByteArray> &args);
+	virtual bool open(const QString &path, const QString &cwd, const QList<QByteArray> &args, const QString &tty);
+	virtual IDebugEvent::const_pointer wait_debug_event(int msecs);
+	virtual void detach();
+	virtual void get_state(State *state);
+	virtual void kill();
+	virtual void pause();
+	virtual void resume(edb::EVENT_STATUS status);
+	virtual void set_state(const State &state);
+	virtual void step(edb::EVENT_STATUS status);
+
+public:
+	virtual QList<edb::tid_t> thread_ids() const;
+	virtual edb::tid_t        active_thread() const;
+	virtual void              set_active_thread(edb::tid_t tid);
+	virtual ThreadInfo        get_thread_info(edb::tid_t tid);
+
+public:
+	virtual bool memory_map_changed() { return memory_map_changed_; }
+	virtual bool set_page_permissions(edb::address_t address, edb::address_t size, bool read, bool write, bool execute);
+
+public:
+	virtual BreakpointList              backup_breakpoints() const;
+	virtual IBreakpoint::pointer        add_breakpoint(edb::address_t address);
+	virtual QList<IBreakpoint::pointer> add_breakpoints(const QList<edb::address_t> &addresses);
+	virtual IBreakpoint::pointer        find_breakpoint(edb::address_t address);
+	virtual void                        clear_breakpoints();
+	virtual void                        remove_breakpoint(edb::address_t address);
+
+public:
+	virtual IProcess *process() const;
+
+private:
+	// the wire, send and receive let requests overlap, call doesn't
+	quint32 send(quint16 command, const QByteArray &args = QByteArray()) const;
+	QByteArray receive(quint32 serial) const;
+	QByteArray call(quint16 command, const QByteArray &args = QByteArray()) const;
+
+private:
+	void process_started();
+	void process_ran();
+	void process_stopped();
+	void process_ended();
+	void load_threads() const;
+	void send_conditions();
+
+private:
+	static const int Timeout = 30000;
+
+private:
+	IDebugger *const                   live_core_;
+	mutable QTcpSocket                 socket_;
+	mutable QByteArray                 buffer_;
+	mutable QHash<quint32, QByteArray> replies_;
+	mutable quint32                    next_serial_;
+	mutable QHash<quint64, bool>       extensions_;
+	edb::address_t                     page_size_;
+	quint64                            cpu_type_;
+	QScopedPointer<RemoteProcess>      process_;
+	BreakpointList                     breakpoints_;
+	bool                               memory_map_changed_;
+
+	// what is known about the current stop, 0 requests are ones not in flight
+	quint32                            state_request_;
+	bool                               state_valid_;
+	QByteArray                         registers_;
+	mutable quint32                    threads_request_;
+	mutable bool                       threads_valid_;
+	mutable QList<edb::tid_t>          threads_;
+	mutable edb::tid_t                 active_thread_;
+};
+
+#endif
@@ -0,0 +1,125 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "RemoteProtocol.h"
+
+#include <cstring>
+
+namespace Remote {
+
+namespace {
+
+// size, serial and command
+const int HeaderSize = sizeof(quint32) + sizeof(quint32) + sizeof(quint16);
+
+//------------------------------------------------------------------------------
+// Name: put
+// Desc: appends <value> to <buffer> in network byte order
+//------------------------------------------------------------------------------
+template <class T>
+void put(QByteArray *buffer, T value) {
+	for(int i = sizeof(T) - 1; i >= 0; --i) {
+		buffer->append(static_cast<char>((value >> (i * 8)) & 0xff));
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: get
+// Desc: reads a value in network byte order from <p>
+//------------------------------------------------------------------------------
+template <class T>
+T get(const char *p) {
+	T value = 0;
+	for(std::size_t i = 0; i < sizeof(T); ++i) {
+		value = static_cast<T>((value << 8) | static_cast<quint8>(p[i]));
+	}
+	return value;
+}
+
+}
+
+//------------------------------------------------------------------------------
+// Name: make_frame
+// Desc: wraps <payload> up as a frame, compressing it if that makes it smaller
+//------------------------------------------------------------------------------
+QByteArray make_frame(quint32 serial, quint16 command, const QByteArray &payload) {
+
+	QByteArray body = payload;
+	if(payload.size() >= CompressThreshold) {
+		const QByteArray compressed = qCompress(payload, 1);
+		if(compressed.size() < payload.size()) {
+			body     = compressed;
+			command |= FlagCompressed;
+		}
+	}
+
+	QByteArray frame;
+	frame.reserve(HeaderSize + body.size());
+	put<quint32>(&frame, HeaderSize - sizeof(quint32) + body.size());
+	put<quint32>(&frame, serial);
+	put<quint16>(&frame, command);
+	frame += body;
+	return frame;
+}
+
+//------------------------------------------------------------------------------
+// Name: take_frame
+// Desc: if <buffer> starts with a whole frame, removes it and returns
+//       FRAME_OK. The payload comes back uncompressed and the command without
+//       FlagCompressed. A frame which is too small or too big to be one of
+//       ours makes this return FRAME_INVALID, after which <buffer> is empty
+//------------------------------------------------------------------------------
+FrameStatus take_frame(QByteArray *buffer, quint32 *serial, quint16 *command, QByteArray *payload) {
+
+	if(buffer->size() < HeaderSize) {
+		return FRAME_INCOMPLETE;
+	}
+
+	const quint32 size = get<quint32>(buffer->constData());
+	if(size < HeaderSize - sizeof(quint32) || size > MaxFrameSize) {
+		buffer->clear();
+		return FRAME_INVALID;
+	}
+
+	if(static_cast<quint32>(buffer->size()) - sizeof(quint32) < size) {
+		return FRAME_INCOMPLETE;
+	}
+
+	*serial  = get<quint32>(buffer->constData() + 4);
+	*command = get<quint16>(buffer->constData() + 8);
+
+	const QByteArray body = buffer->mid(HeaderSize, size - (HeaderSize - sizeof(quint32)));
+	buffer->remove(0, sizeof(quint32) + size);
+
+	if(*command & FlagCompressed) {
+		// qUncompress allocates whatever the first 4 bytes say it will need
+		if(body.size() < 4 || get<quint32>(body.constData()) > MaxFrameSize) {
+			buffer->clear();
+			return FRAME_INVALID;
+		}
+
+		*command &= ~FlagCompressed;
+		*payload  = qUncompress(body);
+	} else {
+		*payload = body;
+	}
+
+	return FRAME_OK;
+}
+
+}
@@ -0,0 +1,112 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef REMOTEPROTOCOL_20261014_H_
+#define REMOTEPROTOCOL_20261014_H_
+
+#include <QByteArray>
+#include <QDataStream>
+
+// what edb --stub and the RemoteDebugger say to each other over TCP. Every
+// message is a frame:
+//
+//     quint32 size     bytes which follow the size
+//     quint32 serial   picked by the client, the reply has the same one
+//     quint16 command  a Command, with FlagCompressed set if the payload is
+//                      qCompress'ed
+//     ...     payload  QDataStream (StreamVersion) encoded arguments/results
+//
+// Requests are answered in order, but the client doesn't have to wait for an
+// answer before sending the next request, so several may be in flight at once.
+// Addresses always go over the wire as quint64. Registers are the kernel's
+// elf_gregset_t, as CoreFile::save_registers makes them. An event is (reason,
+// trap reason, EventFlags, pid, tid, code, caption, message, access
+// violation, address), breakpoint hits are (count, [address, hits]...)
+namespace Remote {
+
+const quint32 Magic         = 0x45444252; // "EDBR"
+const quint32 Version       = 1;
+const quint16 DefaultPort   = 4783;
+const int     StreamVersion = QDataStream::Qt_4_6;
+
+const quint16 FlagCompressed = 0x8000;
+
+// payloads smaller than this are never worth compressing
+const int CompressThreshold = 512;
+
+// the most a frame, or a compressed payload once uncompressed, may hold. The
+// biggest requests edb makes (page reads, ChunkPages at a time) are a few MB,
+// anything claiming to be more is taken for garbage, or an attempt to make the
+// other end allocate whatever it is told to
+const quint32 MaxFrameSize = 64 * 1024 * 1024;
+
+enum FrameStatus {
+	FRAME_INCOMPLETE, // keep reading
+	FRAME_OK,
+	FRAME_INVALID     // nothing sane can follow, the connection has to go
+};
+
+// the yes/no questions IDebugEvent answers
+enum EventFlags {
+	EVENT_EXITED     = 0x01,
+	EVENT_ERROR      = 0x02,
+	EVENT_KILL       = 0x04,
+	EVENT_STOP       = 0x08,
+	EVENT_TRAP       = 0x10,
+	EVENT_STOPPED    = 0x20,
+	EVENT_TERMINATED = 0x40
+};
+
+enum Command {
+	CMD_HELLO = 1,           // (magic, version) -> (magic, version, page size, pointer size, cpu type)
+	CMD_HAS_EXTENSION,       // (ext) -> (bool)
+	CMD_ENUMERATE_PROCESSES, // () -> (count, [pid, uid, user, name]...)
+	CMD_PARENT_PID,          // (pid) -> (pid)
+	CMD_ATTACH,              // (pid) -> (bool)
+	CMD_OPEN,                // (path, cwd, args) -> (bool)
+	CMD_DETACH,              // () -> ()
+	CMD_KILL,                // () -> ()
+	CMD_PAUSE,               // () -> ()
+	CMD_RESUME,              // (status) -> ()
+	CMD_STEP,                // (status) -> ()
+	CMD_WAIT_EVENT,          // (msecs) -> (bool, [event, memory map changed, breakpoint hits])
+	CMD_GET_STATE,           // () -> (registers)
+	CMD_SET_STATE,           // (registers) -> ()
+	CMD_THREADS,             // () -> (thread ids, active thread)
+	CMD_SET_ACTIVE_THREAD,   // (tid) -> ()
+	CMD_THREAD_INFO,         // (tid) -> (name, tid, ip, priority, state, running)
+	CMD_MODULES,             // () -> (count, [name, base]...)
+	CMD_PROCESS,             // () -> (bool, [pid, executable, arguments, cwd, start time, code address, data address])
+	CMD_REGIONS,             // () -> (count, [start, end, base, name, permissions, r, w, x]...)
+	CMD_READ_PAGES,          // (count, [address, pages]...) -> ([bool, bytes]...)
+	CMD_WRITE_BYTES,         // (address, bytes) -> (bool)
+	CMD_SET_PERMISSIONS,     // (address, size, r, w, x) -> (bool), IDebugger::set_page_permissions
+	CMD_REGION_PERMISSIONS,  // (start, end, r, w, x) -> (), IRegion::set_permissions
+	CMD_ADD_BREAKPOINT,      // (address) -> (bool, [original byte])
+	CMD_REMOVE_BREAKPOINT,   // (address) -> ()
+	CMD_CLEAR_BREAKPOINTS,   // () -> ()
+	CMD_ENABLE_BREAKPOINT,   // (address, bool) -> (bool)
+	CMD_SET_CONDITION        // (address, condition) -> ()
+};
+
+QByteArray make_frame(quint32 serial, quint16 command, const QByteArray &payload);
+FrameStatus take_frame(QByteArray *buffer, quint32 *serial, quint16 *command, QByteArray *payload);
+
+}
+
+#endif
@@ -0,0 +1,444 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "RemoteStub.h"
+#include "CoreFile.h"
+#include "IDebugger.h"
+#include "IProcess.h"
+#include "RemoteProtocol.h"
+#include "State.h"
+#include "edb.h"
+
+#include <QDataStream>
+#include <QDateTime>
+#include <QTcpSocket>
+#include <QtDebug>
+
+//------------------------------------------------------------------------------
+// Name: RemoteStub
+// Desc:
+//------------------------------------------------------------------------------
+RemoteStub::RemoteStub(QObject *parent) : QObject(parent), said_hello_(false) {
+	connect(&server_, SIGNAL(newConnection()), this, SLOT(new_connection()));
+}
+
+//------------------------------------------------------------------------------
+// Name: ~RemoteStub
+// Desc:
+//------------------------------------------------------------------------------
+RemoteStub::~RemoteStub() {
+}
+
+//------------------------------------------------------------------------------
+// Name: listen
+// Desc: starts taking connections on <address>:<port>, on failure <error> says
+//       why
+//------------------------------------------------------------------------------
+bool RemoteStub::listen(const QHostAddress &address, quint16 port, QString *error) {
+
+	Q_ASSERT(error);
+
+	if(!server_.listen(address, port)) {
+		*error = server_.errorString();
+		return false;
+	}
+
+	qDebug() << "[RemoteStub] listening on" << qPrintable(address.toString()) << port;
+	return true;
+}
+
+//------------------------------------------------------------------------------
+// Name: new_connection
+// Desc: there is only one debugger at a time, anyone else is turned away
+//------------------------------------------------------------------------------
+void RemoteStub::new_connection() {
+
+	while(QTcpSocket *const socket = server_.nextPendingConnection()) {
+		if(client_) {
+			socket->close();
+			socket->deleteLater();
+			continue;
+		}
+
+		qDebug() << "[RemoteStub] connection from" << qPrintable(socket->peerAddress().toString());
+
+		client_     = socket;
+		said_hello_ = false;
+		buffer_.clear();
+
+		socket->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+		connect(socket, SIGNAL(readyRead()), this, SLOT(read_requests()));
+		connect(socket, SIGNAL(disconnected()), this, SLOT(client_disconnected()));
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: client_disconnected
+// Desc: whatever was being debugged is let go, it shouldn't be left stopped
+//       with nobody to resume it
+//------------------------------------------------------------------------------
+void RemoteStub::client_disconnected() {
+
+	qDebug() << "[RemoteStub] disconnected";
+
+	if(edb::v1::debugger_core->process()) {
+		edb::v1::debugger_core->clear_breakpoints();
+		edb::v1::debugger_core->detach();
+	}
+
+	if(client_) {
+		client_->deleteLater();
+		client_ = 0;
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: read_requests
+// Desc: answers every whole request which has arrived, all of the answers go
+//       out together
+//------------------------------------------------------------------------------
+void RemoteStub::read_requests() {
+
+	if(!client_) {
+		return;
+	}
+
+	buffer_ += client_->readAll();
+
+	QByteArray replies;
+
+	quint32             serial;
+	quint16             command;
+	QByteArray          payload;
+	Remote::FrameStatus status;
+	while((status = Remote::take_frame(&buffer_, &serial, &command, &payload)) == Remote::FRAME_OK) {
+		QDataStream in(payload);
+		in.setVersion(Remote::StreamVersion);
+
+		// nothing but a hello until we know who we are talking to
+		if(!said_hello_ && command != Remote::CMD_HELLO) {
+			client_->abort();
+			return;
+		}
+
+		replies += Remote::make_frame(serial, command, handle(command, in));
+	}
+
+	if(status == Remote::FRAME_INVALID) {
+		client_->abort();
+		return;
+	}
+
+	client_->write(replies);
+}
+
+//------------------------------------------------------------------------------
+// Name: handle
+// Desc: carries out one request, returns the payload of the answer
+//------------------------------------------------------------------------------
+QByteArray RemoteStub::handle(quint16 command, QDataStream &in) {
+
+	IDebugger *const core = edb::v1::debugger_core;
+	IProcess *const process = core->process();
+
+	QByteArray result;
+	QDataStream out(&result, QIODevice::WriteOnly);
+	out.setVersion(Remote::StreamVersion);
+
+	switch(command) {
+	case Remote::CMD_HELLO:
+		{
+			quint32 magic;
+			quint32 version;
+			in >> magic >> version;
+			said_hello_ = (magic == Remote::Magic && version == Remote::Version);
+			out << Remote::Magic << Remote::Version << static_cast<quint64>(core->page_size()) << static_cast<qint32>(core->pointer_size()) << core->cpu_type();
+		}
+		break;
+	case Remote::CMD_HAS_EXTENSION:
+		{
+			quint64 ext;
+			in >> ext;
+			out << core->has_extension(ext);
+		}
+		break;
+	case Remote::CMD_ENUMERATE_PROCESSES:
+		{
+			const QMap<edb::pid_t, ProcessInfo> processes = core->enumerate_processes();
+			out << static_cast<quint32>(processes.size());
+			Q_FOREACH(const ProcessInfo &info, processes) {
+				out << static_cast<qint64>(info.pid) << static_cast<qint64>(info.uid) << info.user << info.name;
+			}
+		}
+		break;
+	case Remote::CMD_PARENT_PID:
+		{
+			qint64 pid;
+			in >> pid;
+			out << static_cast<qint64>(core->parent_pid(pid));
+		}
+		break;
+	case Remote::CMD_ATTACH:
+		{
+			qint64 pid;
+			in >> pid;
+			out << core->attach(pid);
+		}
+		break;
+	case Remote::CMD_OPEN:
+		{
+			QString           path;
+			QString           cwd;
+			QList<QByteArray> args;
+			in >> path >> cwd >> args;
+			out << core->open(path, cwd, args);
+		}
+		break;
+	case Remote::CMD_DETACH:
+		core->detach();
+		break;
+	case Remote::CMD_KILL:
+		core->kill();
+		break;
+	case Remote::CMD_PAUSE:
+		core->pause();
+		break;
+	case Remote::CMD_RESUME:
+		{
+			qint32 status;
+			in >> status;
+			core->resume(static_cast<edb::EVENT_STATUS>(status));
+		}
+		break;
+	case Remote::CMD_STEP:
+		{
+			qint32 status;
+			in >> status;
+			core->step(static_cast<edb::EVENT_STATUS>(status));
+		}
+		break;
+	case Remote::CMD_WAIT_EVENT:
+		{
+			qint32 msecs;
+			in >> msecs;
+
+			// don't sit on the requests behind this one for long
+			const IDebugEvent::const_pointer e = core->wait_debug_event(qBound(0, msecs, 100));
+			out << !e.isNull();
+			if(e) {
+				const IDebugEvent::Message message = e->error_description();
+				edb::address_t address = 0;
+				const bool violation = e->access_violation(&address);
+
+				quint32 flags = 0;
+				if(e->exited())     flags |= Remote::EVENT_EXITED;
+				if(e->is_error())   flags |= Remote::EVENT_ERROR;
+				if(e->is_kill())    flags |= Remote::EVENT_KILL;
+				if(e->is_stop())    flags |= Remote::EVENT_STOP;
+				if(e->is_trap())    flags |= Remote::EVENT_TRAP;
+				if(e->stopped())    flags |= Remote::EVENT_STOPPED;
+				if(e->terminated()) flags |= Remote::EVENT_TERMINATED;
+
+				out << static_cast<qint32>(e->reason()) << static_cast<qint32>(e->trap_reason()) << flags
+				    << static_cast<qint64>(e->process()) << static_cast<qint64>(e->thread()) << static_cast<qint32>(e->code())
+				    << message.caption << message.message << violation << static_cast<quint64>(address);
+
+				out << core->memory_map_changed();
+
+				// the core counts the hits it skips for their conditions
+				const IDebugger::BreakpointList breakpoints = core->backup_breakpoints();
+				out << static_cast<quint32>(breakpoints.size());
+				Q_FOREACH(const IBreakpoint::pointer &bp, breakpoints) {
+					out << static_cast<quint64>(bp->address()) << bp->hit_count();
+				}
+			}
+		}
+		break;
+	case Remote::CMD_GET_STATE:
+		{
+			State state;
+			core->get_state(&state);
+			out << CoreFile::save_registers(state);
+		}
+		break;
+	case Remote::CMD_SET_STATE:
+		{
+			QByteArray registers;
+			in >> registers;
+
+			// only the general purpose registers come over, the rest stay as
+			// they are
+			State state;
+			core->get_state(&state);
+			CoreFile::load_registers(reinterpret_cast<const uchar *>(registers.constData()), registers.size(), &state);
+			core->set_state(state);
+		}
+		break;
+	case Remote::CMD_THREADS:
+		{
+			QList<qint64> ids;
+			Q_FOREACH(edb::tid_t tid, core->thread_ids()) {
+				ids.push_back(tid);
+			}
+			out << ids << static_cast<qint64>(core->active_thread());
+		}
+		break;
+	case Remote::CMD_SET_ACTIVE_THREAD:
+		{
+			qint64 tid;
+			in >> tid;
+			core->set_active_thread(tid);
+		}
+		break;
+	case Remote::CMD_THREAD_INFO:
+		{
+			qint64 tid;
+			in >> tid;
+			const ThreadInfo info = core->get_thread_info(tid);
+			out << info.name << static_cast<qint64>(info.tid) << static_cast<quint64>(info.ip) << static_cast<qint32>(info.priority) << info.state << info.running;
+		}
+		break;
+	case Remote::CMD_MODULES:
+		{
+			const QList<Module> modules = core->loaded_modules();
+			out << static_cast<quint32>(modules.size());
+			Q_FOREACH(const Module &module, modules) {
+				out << module.name << static_cast<quint64>(module.base_address);
+			}
+		}
+		break;
+	case Remote::CMD_PROCESS:
+		out << (process != 0);
+		if(process) {
+			out << static_cast<qint64>(process->pid()) << process->executable() << process->arguments() << process->current_working_directory()
+			    << process->start_time() << static_cast<quint64>(process->code_address()) << static_cast<quint64>(process->data_address());
+		}
+		break;
+	case Remote::CMD_REGIONS:
+		{
+			const QList<IRegion::pointer> regions = process ? process->regions() : QList<IRegion::pointer>();
+			out << static_cast<quint32>(regions.size());
+			Q_FOREACH(const IRegion::pointer &region, regions) {
+				out << static_cast<quint64>(region->start()) << static_cast<quint64>(region->end()) << static_cast<quint64>(region->base())
+				    << region->name() << static_cast<quint32>(region->permissions()) << region->readable() << region->writable() << region->executable();
+			}
+		}
+		break;
+	case Remote::CMD_READ_PAGES:
+		{
+			const edb::address_t page_size = core->page_size();
+
+			quint32 count;
+			in >> count;
+			for(quint32 i = 0; i < count && in.status() == QDataStream::Ok; ++i) {
+				quint64 address;
+				quint32 pages;
+				in >> address >> pages;
+
+				// a page cache refill, not a way to make us allocate anything
+				// we like
+				QByteArray bytes(qMin<quint32>(pages, 1024) * page_size, '\0');
+				if(process && process->read_pages(address, bytes.data(), bytes.size() / page_size)) {
+					out << true << bytes;
+				} else {
+					out << false << QByteArray();
+				}
+			}
+		}
+		break;
+	case Remote::CMD_WRITE_BYTES:
+		{
+			quint64    address;
+			QByteArray bytes;
+			in >> address >> bytes;
+			out << (process && process->write_bytes(address, bytes.constData(), bytes.size()));
+		}
+		break;
+	case Remote::CMD_SET_PERMISSIONS:
+		{
+			quint64 address;
+			quint64 size;
+			bool    read;
+			bool    write;
+			bool    execute;
+			in >> address >> size >> read >> write >> execute;
+			out << core->set_page_permissions(address, size, read, write, execute);
+		}
+		break;
+	case Remote::CMD_REGION_PERMISSIONS:
+		{
+			quint64 start;
+			quint64 end;
+			bool    read;
+			bool    write;
+			bool    execute;
+			in >> start >> end >> read >> write >> execute;
+			if(process) {
+				Q_FOREACH(const IRegion::pointer &region, process->regions()) {
+					if(region->start() == start && region->end() == end) {
+						region->set_permissions(read, write, execute);
+						break;
+					}
+				}
+			}
+		}
+		break;
+	case Remote::CMD_ADD_BREAKPOINT:
+		{
+			quint64 address;
+			in >> address;
+			const IBreakpoint::pointer bp = core->add_breakpoint(address);
+			out << !bp.isNull() << static_cast<quint8>(bp ? bp->original_byte() : 0);
+		}
+		break;
+	case Remote::CMD_REMOVE_BREAKPOINT:
+		{
+			quint64 address;
+			in >> address;
+			core->remove_breakpoint(address);
+		}
+		break;
+	case Remote::CMD_CLEAR_BREAKPOINTS:
+		core->clear_breakpoints();
+		break;
+	case Remote::CMD_ENABLE_BREAKPOINT:
+		{
+			quint64 address;
+			bool    enable;
+			in >> address >> enable;
+			const IBreakpoint::pointer bp = core->find_breakpoint(address);
+			out << (bp && (enable ? bp->enable() : bp->disable()));
+		}
+		break;
+	case Remote::CMD_SET_CONDITION:
+		{
+			quint64 address;
+			QString condition;
+			in >> address >> condition;
+			if(const IBreakpoint::pointer bp = core->find_breakpoint(address)) {
+				bp->condition = condition;
+			}
+		}
+		break;
+	default:
+		qDebug() << "[RemoteStub] unknown request" << command;
+		break;
+	}
+
+	return result;
+}
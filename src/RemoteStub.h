@@ -0,0 +1,60 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef REMOTESTUB_20261014_H_
+#define REMOTESTUB_20261014_H_
+
+#include <QByteArray>
+#include <QHostAddress>
+#include <QObject>
+#include <QPointer>
+#include <QTcpServer>
+
+class QDataStream;
+class QTcpSocket;
+
+// the target side of remote debugging, what edb --stub runs instead of the
+// main window. It serves a RemoteDebugger on the other end of a TCP
+// connection with the debugger core plugin of this machine, one client at a
+// time. There is no authentication, so by default it only listens on the
+// loopback interface and is meant to be reached through an SSH tunnel
+class RemoteStub : public QObject {
+	Q_OBJECT
+public:
+	explicit RemoteStub(QObject *parent = 0);
+	virtual ~RemoteStub();
+
+public:
+	bool listen(const QHostAddress &address, quint16 port, QString *error);
+
+private Q_SLOTS:
+	void new_connection();
+	void read_requests();
+	void client_disconnected();
+
+private:
+	QByteArray handle(quint16 command, QDataStream &in);
+
+private:
+	QTcpServer           server_;
+	QPointer<QTcpSocket> client_;
+	QByteArray           buffer_;
+	bool                 said_hello_;
+};
+
+#endif
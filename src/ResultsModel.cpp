@@ -0,0 +1,211 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "ResultsModel.h"
+#include "edb.h"
+#include <algorithm>
+
+namespace {
+
+//------------------------------------------------------------------------------
+// Name: address_less
+// Desc:
+//------------------------------------------------------------------------------
+bool address_less(const ResultsModel::Result &lhs, const ResultsModel::Result &rhs) {
+	return lhs.address < rhs.address;
+}
+
+//------------------------------------------------------------------------------
+// Name: address_greater
+// Desc:
+//------------------------------------------------------------------------------
+bool address_greater(const ResultsModel::Result &lhs, const ResultsModel::Result &rhs) {
+	return lhs.address > rhs.address;
+}
+
+}
+
+//------------------------------------------------------------------------------
+// Name: ResultsModel
+// Desc: constructor
+//------------------------------------------------------------------------------
+ResultsModel::ResultsModel(QObject *parent) : QAbstractListModel(parent) {
+}
+
+//------------------------------------------------------------------------------
+// Name: ~ResultsModel
+// Desc:
+//------------------------------------------------------------------------------
+ResultsModel::~ResultsModel() {
+}
+
+//------------------------------------------------------------------------------
+// Name: data
+// Desc: without a formatter a result is shown as just its address
+//------------------------------------------------------------------------------
+QVariant ResultsModel::data(const QModelIndex &index, int role) const {
+
+	if(!index.isValid() || index.row() >= rowCount()) {
+		return QVariant();
+	}
+
+	const Result &r = result(index);
+
+	switch(role) {
+	case Qt::DisplayRole:
+		return formatter_ ? formatter_->format(r) : edb::v1::format_pointer(r.address);
+	case Qt::UserRole:
+		return static_cast<qulonglong>(r.address);
+	case TypeRole:
+		return r.type;
+	default:
+		return QVariant();
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: rowCount
+// Desc:
+//------------------------------------------------------------------------------
+int ResultsModel::rowCount(const QModelIndex &parent) const {
+
+	if(parent.isValid()) {
+		return 0;
+	}
+
+	return filter_ ? visible_.size() : results_.size();
+}
+
+//------------------------------------------------------------------------------
+// Name: result
+// Desc:
+//------------------------------------------------------------------------------
+const ResultsModel::Result &ResultsModel::result(const QModelIndex &index) const {
+	Q_ASSERT(index.isValid());
+	return filter_ ? results_[visible_[index.row()]] : results_[index.row()];
+}
+
+//------------------------------------------------------------------------------
+// Name: addResult
+// Desc:
+//------------------------------------------------------------------------------
+void ResultsModel::addResult(const Result &result) {
+	addResults(QVector<Result>(1, result));
+}
+
+//------------------------------------------------------------------------------
+// Name: addResults
+// Desc: adds a batch of results at once, the view only hears about it once
+//------------------------------------------------------------------------------
+void ResultsModel::addResults(const QVector<Result> &results) {
+
+	if(results.isEmpty()) {
+		return;
+	}
+
+	int added = results.size();
+	if(filter_) {
+		added = 0;
+		Q_FOREACH(const Result &r, results) {
+			if(filter_->accept(r)) {
+				++added;
+			}
+		}
+	}
+
+	if(added != 0) {
+		beginInsertRows(QModelIndex(), rowCount(), rowCount() + added - 1);
+	}
+
+	const int first = results_.size();
+	results_ += results;
+
+	if(filter_) {
+		for(int i = first; i < results_.size(); ++i) {
+			if(filter_->accept(results_[i])) {
+				visible_.push_back(i);
+			}
+		}
+	}
+
+	if(added != 0) {
+		endInsertRows();
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: clear
+// Desc:
+//------------------------------------------------------------------------------
+void ResultsModel::clear() {
+	beginResetModel();
+	results_.clear();
+	visible_.clear();
+	endResetModel();
+}
+
+//------------------------------------------------------------------------------
+// Name: sort
+// Desc: results are always in address order, <column> is ignored
+//------------------------------------------------------------------------------
+void ResultsModel::sort(int column, Qt::SortOrder order) {
+	Q_UNUSED(column);
+
+	beginResetModel();
+	std::stable_sort(results_.begin(), results_.end(), order == Qt::AscendingOrder ? address_less : address_greater);
+
+	if(filter_) {
+		visible_.clear();
+		for(int i = 0; i < results_.size(); ++i) {
+			if(filter_->accept(results_[i])) {
+				visible_.push_back(i);
+			}
+		}
+	}
+	endResetModel();
+}
+
+//------------------------------------------------------------------------------
+// Name: setFilter
+// Desc: only results which <filter> accepts are shown, 0 shows them all. The
+//       model owns the filter
+//------------------------------------------------------------------------------
+void ResultsModel::setFilter(Filter *filter) {
+
+	beginResetModel();
+	filter_.reset(filter);
+	visible_.clear();
+
+	if(filter_) {
+		for(int i = 0; i < results_.size(); ++i) {
+			if(filter_->accept(results_[i])) {
+				visible_.push_back(i);
+			}
+		}
+	}
+	endResetModel();
+}
+
+//------------------------------------------------------------------------------
+// Name: setFormatter
+// Desc: the model owns the formatter
+//------------------------------------------------------------------------------
+void ResultsModel::setFormatter(Formatter *formatter) {
+	beginResetModel();
+	formatter_.reset(formatter);
+	endResetModel();
+}
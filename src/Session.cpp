@@ -0,0 +1,387 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Session.h"
+
+#include <QDataStream>
+#include <QFile>
+
+namespace {
+
+const quint32 SESSION_MAGIC   = 0x45444253; // "EDBS"
+const quint32 SESSION_VERSION = 1;
+
+// the log is rewritten once it holds this many more records than there are
+// things in the session, changing the same comment back and forth shouldn't
+// make the file grow forever
+const int COMPACT_SLACK = 1024;
+
+//------------------------------------------------------------------------------
+// Name: set_stream_version
+// Desc: the format mustn't change with the version of Qt edb is built with
+//------------------------------------------------------------------------------
+void set_stream_version(QDataStream &stream) {
+	stream.setVersion(QDataStream::Qt_4_6);
+}
+
+}
+
+//------------------------------------------------------------------------------
+// Name: Session
+// Desc:
+//------------------------------------------------------------------------------
+Session::Session() : records_(0) {
+}
+
+//------------------------------------------------------------------------------
+// Name: ~Session
+// Desc:
+//------------------------------------------------------------------------------
+Session::~Session() {
+	close();
+}
+
+//------------------------------------------------------------------------------
+// Name: open
+// Desc: reads the session kept in <filename> for the program whose MD5 is
+//       <md5>, starting a new one if there isn't one. Nothing is applied to
+//       the process, the entries are asked for module by module as they load
+//------------------------------------------------------------------------------
+bool Session::open(const QString &filename, const QByteArray &md5) {
+
+	close();
+
+	filename_ = filename;
+	md5_      = md5;
+
+	bool clean = true;
+
+	QFile file(filename_);
+	if(file.open(QIODevice::ReadOnly)) {
+		QDataStream in(&file);
+		set_stream_version(in);
+		clean = replay(in);
+		file.close();
+	} else {
+		clean = false;
+	}
+
+	if(!clean) {
+		// missing, from something else, or cut short while being written,
+		// whatever could be read is written back out whole
+		save();
+	} else {
+		log_.reset(new QFile(filename_));
+		if(!log_->open(QIODevice::WriteOnly | QIODevice::Append)) {
+			log_.reset();
+		}
+	}
+
+	return is_open();
+}
+
+//------------------------------------------------------------------------------
+// Name: replay
+// Desc: returns false if the header doesn't match or the log ends part way
+//       through a record
+//------------------------------------------------------------------------------
+bool Session::replay(QDataStream &in) {
+
+	quint32    magic;
+	quint32    version;
+	QByteArray md5;
+	in >> magic >> version >> md5;
+
+	if(in.status() != QDataStream::Ok || magic != SESSION_MAGIC || version != SESSION_VERSION || md5 != md5_) {
+		return false;
+	}
+
+	while(!in.atEnd()) {
+
+		quint8         record;
+		quint8         kind = 0;
+		QString        name;
+		quint64        offset = 0;
+		QString        text;
+		QByteArray     state;
+
+		in >> record;
+		switch(record) {
+		case RECORD_SET:
+			in >> kind >> name >> offset >> text;
+			break;
+		case RECORD_REMOVE:
+			in >> kind >> name >> offset;
+			break;
+		case RECORD_STATE:
+			in >> name >> state;
+			break;
+		default:
+			return false;
+		}
+
+		if(in.status() != QDataStream::Ok || (record != RECORD_STATE && kind >= KIND_COUNT)) {
+			return false;
+		}
+
+		switch(record) {
+		case RECORD_SET:
+			entries_[kind][name].insert(offset, text);
+			break;
+		case RECORD_REMOVE:
+			entries_[kind][name].remove(offset);
+			break;
+		case RECORD_STATE:
+			states_.insert(name, state);
+			break;
+		}
+
+		++records_;
+	}
+
+	return true;
+}
+
+//------------------------------------------------------------------------------
+// Name: write_header
+// Desc:
+//------------------------------------------------------------------------------
+void Session::write_header(QDataStream &out) const {
+	out << SESSION_MAGIC << SESSION_VERSION << md5_;
+}
+
+//------------------------------------------------------------------------------
+// Name: save
+// Desc: writes the whole session out again, one record per entry, and goes
+//       on appending to that
+//------------------------------------------------------------------------------
+void Session::save() {
+
+	if(filename_.isEmpty()) {
+		return;
+	}
+
+	log_.reset();
+
+	const QString temp_filename = filename_ + ".tmp";
+
+	QFile file(temp_filename);
+	if(!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+		return;
+	}
+
+	QDataStream out(&file);
+	set_stream_version(out);
+	write_header(out);
+
+	records_ = 0;
+	for(int kind = 0; kind < KIND_COUNT; ++kind) {
+		for(QHash<QString, Entries>::const_iterator module = entries_[kind].begin(); module != entries_[kind].end(); ++module) {
+			for(Entries::const_iterator it = module.value().begin(); it != module.value().end(); ++it) {
+				out << static_cast<quint8>(RECORD_SET) << static_cast<quint8>(kind) << module.key() << static_cast<quint64>(it.key()) << it.value();
+				++records_;
+			}
+		}
+	}
+
+	for(QHash<QString, QByteArray>::const_iterator it = states_.begin(); it != states_.end(); ++it) {
+		out << static_cast<quint8>(RECORD_STATE) << it.key() << it.value();
+		++records_;
+	}
+
+	file.close();
+
+	// replace the old file only once the new one is complete
+	QFile::remove(filename_);
+	if(!QFile::rename(temp_filename, filename_)) {
+		return;
+	}
+
+	log_.reset(new QFile(filename_));
+	if(!log_->open(QIODevice::WriteOnly | QIODevice::Append)) {
+		log_.reset();
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: close
+// Desc: forgets the session, everything in it is already on disk
+//------------------------------------------------------------------------------
+void Session::close() {
+	log_.reset();
+	filename_.clear();
+	md5_.clear();
+	states_.clear();
+	records_ = 0;
+
+	for(int kind = 0; kind < KIND_COUNT; ++kind) {
+		entries_[kind].clear();
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: is_open
+// Desc:
+//------------------------------------------------------------------------------
+bool Session::is_open() const {
+	return !log_.isNull();
+}
+
+//------------------------------------------------------------------------------
+// Name: append
+// Desc: adds one record to the end of the log
+//------------------------------------------------------------------------------
+void Session::append(quint8 record, quint8 kind, const QString &name, edb::address_t offset, const QString &text, const QByteArray &state) {
+
+	if(!log_) {
+		return;
+	}
+
+	QDataStream out(log_.data());
+	set_stream_version(out);
+
+	out << record;
+	switch(record) {
+	case RECORD_SET:
+		out << kind << name << static_cast<quint64>(offset) << text;
+		break;
+	case RECORD_REMOVE:
+		out << kind << name << static_cast<quint64>(offset);
+		break;
+	case RECORD_STATE:
+		out << name << state;
+		break;
+	}
+
+	log_->flush();
+	++records_;
+
+	compact_if_needed();
+}
+
+//------------------------------------------------------------------------------
+// Name: live_count
+// Desc: how many records it takes to write the session out whole
+//------------------------------------------------------------------------------
+int Session::live_count() const {
+
+	int count = states_.size();
+	for(int kind = 0; kind < KIND_COUNT; ++kind) {
+		Q_FOREACH(const Entries &entries, entries_[kind]) {
+			count += entries.size();
+		}
+	}
+
+	return count;
+}
+
+//------------------------------------------------------------------------------
+// Name: compact_if_needed
+// Desc:
+//------------------------------------------------------------------------------
+void Session::compact_if_needed() {
+	if(records_ > 2 * live_count() + COMPACT_SLACK) {
+		save();
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: set
+// Desc:
+//------------------------------------------------------------------------------
+void Session::set(Kind kind, const QString &module, edb::address_t offset, const QString &text) {
+
+	Entries &entries = entries_[kind][module];
+
+	Entries::const_iterator it = entries.find(offset);
+	if(it != entries.end() && it.value() == text) {
+		return;
+	}
+
+	entries.insert(offset, text);
+	append(RECORD_SET, kind, module, offset, text, QByteArray());
+}
+
+//------------------------------------------------------------------------------
+// Name: remove
+// Desc:
+//------------------------------------------------------------------------------
+void Session::remove(Kind kind, const QString &module, edb::address_t offset) {
+
+	QHash<QString, Entries>::iterator it = entries_[kind].find(module);
+	if(it == entries_[kind].end() || it.value().remove(offset) == 0) {
+		return;
+	}
+
+	if(it.value().isEmpty()) {
+		entries_[kind].erase(it);
+	}
+
+	append(RECORD_REMOVE, kind, module, offset, QString(), QByteArray());
+}
+
+//------------------------------------------------------------------------------
+// Name: set_entries
+// Desc: replaces everything of <kind> that <module> has, only the differences
+//       are logged
+//------------------------------------------------------------------------------
+void Session::set_entries(Kind kind, const QString &module, const Entries &entries) {
+
+	const Entries old_entries = entries_[kind].value(module);
+
+	for(Entries::const_iterator it = old_entries.begin(); it != old_entries.end(); ++it) {
+		if(!entries.contains(it.key())) {
+			remove(kind, module, it.key());
+		}
+	}
+
+	for(Entries::const_iterator it = entries.begin(); it != entries.end(); ++it) {
+		set(kind, module, it.key(), it.value());
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: entries
+// Desc:
+//------------------------------------------------------------------------------
+Session::Entries Session::entries(Kind kind, const QString &module) const {
+	return entries_[kind].value(module);
+}
+
+//------------------------------------------------------------------------------
+// Name: set_state
+// Desc:
+//------------------------------------------------------------------------------
+void Session::set_state(const QString &name, const QByteArray &state) {
+
+	QHash<QString, QByteArray>::const_iterator it = states_.find(name);
+	if(it != states_.end() && it.value() == state) {
+		return;
+	}
+
+	states_.insert(name, state);
+	append(RECORD_STATE, 0, name, 0, QString(), state);
+}
+
+//------------------------------------------------------------------------------
+// Name: state
+// Desc:
+//------------------------------------------------------------------------------
+QByteArray Session::state(const QString &name) const {
+	return states_.value(name);
+}
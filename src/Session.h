@@ -0,0 +1,97 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SESSION_20261014_H_
+#define SESSION_20261014_H_
+
+#include "Types.h"
+#include <QByteArray>
+#include <QHash>
+#include <QScopedPointer>
+#include <QString>
+
+class QDataStream;
+class QFile;
+
+// what the user has added to a program, kept on disk from one run to the
+// next. Locations are stored as a module and an offset into it, so they
+// survive the module being loaded somewhere else. The file is a log, every
+// change is appended to it as it is made and reading it replays the log, so
+// nothing is lost if edb doesn't get to save on the way out. It is rewritten
+// in full on save, or once the log has grown well past what it describes
+class Session {
+public:
+	enum Kind {
+		COMMENT,
+		LABEL,
+		BREAKPOINT,
+		BOOKMARK,
+		KIND_COUNT
+	};
+
+	// what one module has, by offset
+	typedef QHash<edb::address_t, QString> Entries;
+
+public:
+	Session();
+	~Session();
+
+private:
+	Q_DISABLE_COPY(Session)
+
+public:
+	bool open(const QString &filename, const QByteArray &md5);
+	void save();
+	void close();
+	bool is_open() const;
+
+public:
+	void set(Kind kind, const QString &module, edb::address_t offset, const QString &text);
+	void remove(Kind kind, const QString &module, edb::address_t offset);
+	void set_entries(Kind kind, const QString &module, const Entries &entries);
+	Entries entries(Kind kind, const QString &module) const;
+
+public:
+	// anything else which wants to be kept, such as plugin state
+	void set_state(const QString &name, const QByteArray &state);
+	QByteArray state(const QString &name) const;
+
+private:
+	enum Record {
+		RECORD_SET,
+		RECORD_REMOVE,
+		RECORD_STATE
+	};
+
+private:
+	bool replay(QDataStream &in);
+	void write_header(QDataStream &out) const;
+	void append(quint8 record, quint8 kind, const QString &name, edb::address_t offset, const QString &text, const QByteArray &state);
+	void compact_if_needed();
+	int live_count() const;
+
+private:
+	QString                     filename_;
+	QByteArray                  md5_;
+	QScopedPointer<QFile>       log_;
+	QHash<QString, Entries>     entries_[KIND_COUNT];
+	QHash<QString, QByteArray>  states_;
+	int                         records_;
+};
+
+#endif
@@ -28,6 +28,9 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 // Desc: constructor
 //------------------------------------------------------------------------------
 State::State() : impl_(edb::v1::debugger_core ? edb::v1::debugger_core->create_state() : 0) {
+	if(impl_) {
+		impl_->ref_.ref();
+	}
 }
 
 //------------------------------------------------------------------------------
@@ -35,14 +38,61 @@ State::State() : impl_(edb::v1::debugger_core ? edb::v1::debugger_core->create_s
 // Desc:
 //------------------------------------------------------------------------------
 State::~State() {
-	delete impl_;
+	release(impl_);
+}
+
+//------------------------------------------------------------------------------
+// Name: State
+// Desc: shares <other>'s registers until one of the two is changed
+//------------------------------------------------------------------------------
+State::State(const State &other) : impl_(other.impl_) {
+	if(impl_) {
+		impl_->ref_.ref();
+	}
 }
 
+#ifdef Q_COMPILER_RVALUE_REFS
 //------------------------------------------------------------------------------
 // Name: State
 // Desc:
 //------------------------------------------------------------------------------
-State::State(const State &other) : impl_(other.impl_ ? other.impl_->clone() : 0) {
+State::State(State &&other) : impl_(other.impl_) {
+	other.impl_ = 0;
+}
+
+//------------------------------------------------------------------------------
+// Name: operator=
+// Desc:
+//------------------------------------------------------------------------------
+State &State::operator=(State &&other) {
+	swap(other);
+	return *this;
+}
+#endif
+
+//------------------------------------------------------------------------------
+// Name: release
+// Desc: lets go of <impl>, which goes away with its last State
+//------------------------------------------------------------------------------
+void State::release(IState *impl) {
+	if(impl && !impl->ref_.deref()) {
+		delete impl;
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: detach
+// Desc: the registers of this state and nobody else's, for changing them.
+//       They are copied first if another State shares them
+//------------------------------------------------------------------------------
+IState *State::detach() {
+	if(impl_ && impl_->ref_.fetchAndAddOrdered(0) != 1) {
+		IState *const copy = impl_->clone();
+		copy->ref_.ref();
+		release(impl_);
+		impl_ = copy;
+	}
+	return impl_;
 }
 
 //------------------------------------------------------------------------------
@@ -70,7 +120,7 @@ State &State::operator=(const State &other) {
 //------------------------------------------------------------------------------
 void State::clear() {
 	if(impl_) {
-		impl_->clear();
+		detach()->clear();
 	}
 }
 
@@ -129,6 +179,29 @@ Register State::value(const QString &reg) const {
 	return Register();
 }
 
+//------------------------------------------------------------------------------
+// Name: register_index
+// Desc: returns an index which can be passed to register_value to read <name>
+//       quickly, or -1 if it can only be read with value()
+//------------------------------------------------------------------------------
+int State::register_index(const QString &name) const {
+	if(impl_) {
+		return impl_->register_index(name);
+	}
+	return -1;
+}
+
+//------------------------------------------------------------------------------
+// Name: register_value
+// Desc:
+//------------------------------------------------------------------------------
+edb::reg_t State::register_value(int index) const {
+	if(impl_) {
+		return impl_->register_value(index);
+	}
+	return 0;
+}
+
 //------------------------------------------------------------------------------
 // Name: operator[]
 // Desc:
@@ -146,7 +219,7 @@ Register State::operator[](const QString &reg) const {
 //------------------------------------------------------------------------------
 void State::set_register(const QString &name, edb::reg_t value) {
 	if(impl_) {
-		impl_->set_register(name, value);
+		detach()->set_register(name, value);
 	}
 }
 
@@ -156,7 +229,7 @@ void State::set_register(const QString &name, edb::reg_t value) {
 //------------------------------------------------------------------------------
 void State::adjust_stack(int bytes) {
 	if(impl_) {
-		impl_->adjust_stack(bytes);
+		detach()->adjust_stack(bytes);
 	}
 }
 
@@ -166,7 +239,7 @@ void State::adjust_stack(int bytes) {
 //------------------------------------------------------------------------------
 void State::set_instruction_pointer(edb::address_t value) {
 	if(impl_) {
-		impl_->set_instruction_pointer(value);
+		detach()->set_instruction_pointer(value);
 	}
 }
 
@@ -198,7 +271,7 @@ QString State::flags_to_string(edb::reg_t flags) const {
 //------------------------------------------------------------------------------
 void State::set_flags(edb::reg_t flags) {
 	if(impl_) {
-		return impl_->set_flags(flags);
+		return detach()->set_flags(flags);
 	}
 }
 
@@ -219,7 +292,7 @@ edb::reg_t State::debug_register(int n) const {
 //------------------------------------------------------------------------------
 void State::set_debug_register(int n, edb::reg_t value) {
 	if(impl_) {
-		impl_->set_debug_register(n, value);
+		detach()->set_debug_register(n, value);
 	}
 }
 
@@ -256,6 +329,28 @@ QByteArray State::xmm_register(int n) const {
 	return QByteArray(16, 0);
 }
 
+//------------------------------------------------------------------------------
+// Name: ymm_register
+// Desc:
+//------------------------------------------------------------------------------
+QByteArray State::ymm_register(int n) const {
+	if(impl_) {
+		return impl_->ymm_register(n);
+	}
+	return QByteArray();
+}
+
+//------------------------------------------------------------------------------
+// Name: zmm_register
+// Desc:
+//------------------------------------------------------------------------------
+QByteArray State::zmm_register(int n) const {
+	if(impl_) {
+		return impl_->zmm_register(n);
+	}
+	return QByteArray();
+}
+
 //------------------------------------------------------------------------------
 // Name: gp_register
 // Desc:
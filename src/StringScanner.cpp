@@ -0,0 +1,354 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "StringScanner.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+//------------------------------------------------------------------------------
+// Name: is_utf16_char
+// Desc: an ASCII character encoded as UTF-16LE, as get_utf16_string_at_address
+//       has it
+//------------------------------------------------------------------------------
+bool is_utf16_char(const quint8 *p) {
+	return p[0] >= 0x20 && p[0] < 0x80 && p[1] == 0;
+}
+
+#ifdef __SSE2__
+//------------------------------------------------------------------------------
+// Name: ascii_mask
+// Desc: bit n is set if p[n] StringScanner::is_ascii_char. Bytes from 0x80 up are negative
+//       as far as the signed compares go, so none of them pass
+//------------------------------------------------------------------------------
+unsigned int ascii_mask(const quint8 *p) {
+	const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+
+	const __m128i printable = _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8(0x1f)), _mm_cmplt_epi8(v, _mm_set1_epi8(0x7f)));
+	const __m128i space     = _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8(0x08)), _mm_cmplt_epi8(v, _mm_set1_epi8(0x0e)));
+
+	return _mm_movemask_epi8(_mm_or_si128(printable, space));
+}
+
+//------------------------------------------------------------------------------
+// Name: utf16_mask
+// Desc: bit n is set if p + n is_utf16_char, reads 17 bytes
+//------------------------------------------------------------------------------
+unsigned int utf16_mask(const quint8 *p) {
+	const __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+	const __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + 1));
+
+	return _mm_movemask_epi8(_mm_and_si128(_mm_cmpgt_epi8(lo, _mm_set1_epi8(0x1f)), _mm_cmpeq_epi8(hi, _mm_setzero_si128())));
+}
+#endif
+
+//------------------------------------------------------------------------------
+// Name: next_ascii
+// Desc: finds the next byte in [p, last) which is (or isn't, if <printable> is
+//       false) an ASCII character, with SSE2 this looks at 16 bytes at a time
+//------------------------------------------------------------------------------
+const quint8 *next_ascii(const quint8 *p, const quint8 *last, bool printable) {
+
+#ifdef __SSE2__
+	while(last - p >= 16) {
+		unsigned int mask = ascii_mask(p);
+		if(!printable) {
+			mask = ~mask & 0xffff;
+		}
+
+		if(mask) {
+			return p + __builtin_ctz(mask);
+		}
+
+		p += 16;
+	}
+#endif
+
+	for(; p != last; ++p) {
+		if(StringScanner::is_ascii_char(*p) == printable) {
+			return p;
+		}
+	}
+
+	return last;
+}
+
+//------------------------------------------------------------------------------
+// Name: next_utf16
+// Desc: finds the next of the offsets i, i + 2, ... below <last> which is (or
+//       isn't) the start of a UTF-16 character, where only the first <end>
+//       bytes of <data> can be read. Returns an offset from <last> up if there
+//       isn't one
+//------------------------------------------------------------------------------
+std::size_t next_utf16(const quint8 *data, std::size_t i, std::size_t last, std::size_t end, bool printable) {
+
+#ifdef __SSE2__
+	while(i + 16 <= last && i + 17 <= end) {
+		unsigned int mask = utf16_mask(data + i);
+		if(!printable) {
+			mask = ~mask;
+		}
+
+		// only every other byte starts a character of this run
+		mask &= 0x5555;
+
+		if(mask) {
+			return i + __builtin_ctz(mask);
+		}
+
+		i += 16;
+	}
+#endif
+
+	for(; i < last; i += 2) {
+		const bool is_char = i + 2 <= end && is_utf16_char(data + i);
+		if(is_char == printable) {
+			return i;
+		}
+	}
+
+	return i;
+}
+
+//------------------------------------------------------------------------------
+// Name: run_end
+// Desc: where the character after the last one of <string> would start
+//------------------------------------------------------------------------------
+edb::address_t run_end(const StringScanner::String &string) {
+	return string.address + string.length * ((string.encoding == StringScanner::ENCODING_UTF16) ? 2 : 1);
+}
+
+}
+
+// the runs found in one window
+class StringScanner::Runs : public RegionScanner::Task::Result {
+public:
+	const IRegion *region;
+	edb::address_t address;
+	edb::address_t end;
+	QVector<Run>   items;
+};
+
+//------------------------------------------------------------------------------
+// Name: StringScanner
+// Desc: finds strings of at least <min_length> characters, UTF-16 ones too if
+//       <utf16> is set
+//------------------------------------------------------------------------------
+StringScanner::StringScanner(int min_length, bool utf16) : min_length_(qMax(min_length, 1)), utf16_(utf16), open_region_(0), open_end_(0) {
+}
+
+//------------------------------------------------------------------------------
+// Name: ascii_length
+// Desc: how many of the <size> bytes at <p> are ASCII characters before the
+//       first which isn't
+//------------------------------------------------------------------------------
+std::size_t StringScanner::ascii_length(const quint8 *p, std::size_t size) {
+	return next_ascii(p, p + size, false) - p;
+}
+
+//------------------------------------------------------------------------------
+// Name: utf16_length
+// Desc: how many UTF-16 characters the <size> bytes at <p> start with
+//------------------------------------------------------------------------------
+std::size_t StringScanner::utf16_length(const quint8 *p, std::size_t size) {
+	return next_utf16(p, 0, size & ~static_cast<std::size_t>(1), size, false) / 2;
+}
+
+//------------------------------------------------------------------------------
+// Name: run
+// Desc: scans <regions>, returning once every string has been passed to found
+//------------------------------------------------------------------------------
+void StringScanner::run(const QList<IRegion::pointer> &regions) {
+
+	open_.clear();
+	open_region_ = 0;
+	open_end_    = 0;
+
+	RegionScanner().run(regions, this);
+
+	// whatever reached the end of the last window
+	QVector<String> strings;
+	flush(&strings);
+	if(!strings.isEmpty()) {
+		found(strings);
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: lookahead
+// Desc: a UTF-16 character can start on the last byte of a window
+//------------------------------------------------------------------------------
+std::size_t StringScanner::lookahead() const {
+	return 1;
+}
+
+//------------------------------------------------------------------------------
+// Name: add_run
+// Desc: runs which are too short are only kept if they may join up with one in
+//       the next or previous window
+//------------------------------------------------------------------------------
+void StringScanner::add_run(QVector<Run> *runs, edb::address_t address, quint32 length, Encoding encoding, bool head, bool tail) const {
+
+	if(length >= min_length_ || head || tail) {
+		Run run;
+		run.string.address  = address;
+		run.string.length   = length;
+		run.string.encoding = encoding;
+		run.head            = head;
+		run.tail            = tail;
+		runs->push_back(run);
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: find_ascii
+// Desc:
+//------------------------------------------------------------------------------
+void StringScanner::find_ascii(const RegionScanner::Chunk &chunk, QVector<Run> *runs) const {
+
+	const quint8 *const first = chunk.data.constData();
+	const quint8 *const last  = first + chunk.size;
+
+	const quint8 *p = first;
+	while((p = next_ascii(p, last, true)) != last) {
+		const quint8 *const q = next_ascii(p, last, false);
+		add_run(runs, chunk.address + (p - first), q - p, ENCODING_ASCII, p == first, q == last);
+		p = q;
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: find_utf16
+// Desc: the runs made of characters starting at even offsets, or at odd ones
+//       if <parity> is 1
+//------------------------------------------------------------------------------
+void StringScanner::find_utf16(const RegionScanner::Chunk &chunk, std::size_t parity, QVector<Run> *runs) const {
+
+	const quint8 *const data = chunk.data.constData();
+	const std::size_t   last = chunk.size;
+	const std::size_t   end  = chunk.data.size();
+
+	std::size_t i = parity;
+	while((i = next_utf16(data, i, last, end, true)) < last) {
+		const std::size_t j = next_utf16(data, i, last, end, false);
+		add_run(runs, chunk.address + i, (j - i) / 2, ENCODING_UTF16, i == parity, j >= last);
+		i = j;
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: scan
+// Desc: runs on a pool thread
+//------------------------------------------------------------------------------
+RegionScanner::Task::Result *StringScanner::scan(const RegionScanner::Chunk &chunk) const {
+
+	Runs *const result = new Runs;
+	result->region  = chunk.region.data();
+	result->address = chunk.address;
+	result->end     = chunk.address + chunk.size;
+
+	find_ascii(chunk, &result->items);
+
+	if(utf16_) {
+		find_utf16(chunk, 0, &result->items);
+		find_utf16(chunk, 1, &result->items);
+	}
+
+	return result;
+}
+
+//------------------------------------------------------------------------------
+// Name: merge
+// Desc: joins the runs at the start of this window on to those left open at
+//       the end of the last one, if it comes right before this one
+//------------------------------------------------------------------------------
+void StringScanner::merge(Result *result) {
+
+	Runs *const runs = static_cast<Runs *>(result);
+
+	const bool continues = runs->region == open_region_ && runs->address == open_end_;
+
+	if(continues) {
+		for(int i = 0; i < runs->items.size(); ++i) {
+			Run &run = runs->items[i];
+			if(!run.head) {
+				continue;
+			}
+
+			for(int j = 0; j < open_.size(); ++j) {
+				String &open = open_[j].string;
+				if(open.length != 0 && open.encoding == run.string.encoding && run_end(open) == run.string.address) {
+					run.string.address  = open.address;
+					run.string.length  += open.length;
+					open.length         = 0;
+					break;
+				}
+			}
+		}
+	}
+
+	QVector<Run>    open;
+	QVector<String> strings;
+
+	// the open runs which weren't continued are done, and come first. One
+	// can only go on past a window too small to hold its next character
+	Q_FOREACH(const Run &run, open_) {
+		if(run.string.length == 0) {
+			continue;
+		}
+
+		if(continues && run_end(run.string) >= runs->end) {
+			open.push_back(run);
+		} else if(run.string.length >= min_length_) {
+			strings.push_back(run.string);
+		}
+	}
+
+	Q_FOREACH(const Run &run, runs->items) {
+		if(run.tail) {
+			open.push_back(run);
+		} else if(run.string.length >= min_length_) {
+			strings.push_back(run.string);
+		}
+	}
+
+	open_        = open;
+	open_region_ = runs->region;
+	open_end_    = runs->end;
+
+	if(!strings.isEmpty()) {
+		found(strings);
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: flush
+// Desc: ends the open runs, adding those which are long enough to <strings>
+//------------------------------------------------------------------------------
+void StringScanner::flush(QVector<String> *strings) {
+
+	Q_FOREACH(const Run &run, open_) {
+		if(run.string.length >= min_length_) {
+			strings->push_back(run.string);
+		}
+	}
+
+	open_.clear();
+}
@@ -0,0 +1,579 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "SymbolCache.h"
+#include "edb.h"
+
+#include <QDateTime>
+#include <QFileInfo>
+#include <QtDebug>
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__GNUG__)
+#include <cxxabi.h>
+#endif
+
+struct SymbolCache::Header {
+	char    magic[8];
+	quint32 version;
+	quint32 count;
+	quint32 hash_size;
+	quint32 string_size;
+	quint32 source;
+	quint32 reserved;
+	quint64 source_size;
+	qint64  source_time;
+	quint8  md5[16];
+};
+
+struct SymbolCache::Entry {
+	quint64 address;
+	quint64 size;
+	quint32 name;
+	quint32 demangled; // the same as name if there was nothing to demangle
+	quint8  type;
+	quint8  reserved[3];
+};
+
+const quint32 SymbolCache::Version;
+
+namespace {
+
+const char Magic[8] = { 'E', 'D', 'B', 'S', 'Y', 'M', 'S', '\0' };
+
+//------------------------------------------------------------------------------
+// Name: hash_name
+// Desc: FNV-1a, it is part of the file format so it must never change without
+//       also changing SymbolCache::Version
+//------------------------------------------------------------------------------
+quint32 hash_name(const char *name, int length) {
+	quint32 hash = 2166136261u;
+	for(int i = 0; i < length; ++i) {
+		hash ^= static_cast<quint8>(name[i]);
+		hash *= 16777619u;
+	}
+	return hash;
+}
+
+//------------------------------------------------------------------------------
+// Name: demangle
+// Desc: the demangled form of an Itanium ABI name, or an empty array if <name>
+//       isn't one (or we weren't built with a compiler which can demangle).
+//       A suffix such as "@plt" or a symbol version is kept as it is
+//------------------------------------------------------------------------------
+QByteArray demangle(const QByteArray &name) {
+#if defined(__GNUG__)
+	if(name.startsWith("_Z")) {
+		const int at = name.indexOf('@');
+		const QByteArray mangled = (at == -1) ? name : name.left(at);
+
+		int status = 0;
+		if(char *const demangled = abi::__cxa_demangle(mangled.constData(), 0, 0, &status)) {
+			const QByteArray result = QByteArray(demangled) + ((at == -1) ? QByteArray() : name.mid(at));
+			std::free(demangled);
+			return status == 0 ? result : QByteArray();
+		}
+	}
+#else
+	Q_UNUSED(name);
+#endif
+	return QByteArray();
+}
+
+//------------------------------------------------------------------------------
+// Name: record_less
+// Desc:
+//------------------------------------------------------------------------------
+bool record_less(const SymbolCache::Record &lhs, const SymbolCache::Record &rhs) {
+	return lhs.address < rhs.address || (lhs.address == rhs.address && lhs.name < rhs.name);
+}
+
+//------------------------------------------------------------------------------
+// Name: NameLess
+// Desc:
+//------------------------------------------------------------------------------
+struct NameLess {
+	explicit NameLess(const SymbolCache *cache) : cache_(cache) {
+	}
+
+	bool operator()(quint32 lhs, quint32 rhs) const {
+		return std::strcmp(cache_->demangled(lhs), cache_->demangled(rhs)) < 0;
+	}
+
+	const SymbolCache *cache_;
+};
+
+//------------------------------------------------------------------------------
+// Name: source_time
+// Desc:
+//------------------------------------------------------------------------------
+qint64 source_time(const QFileInfo &info) {
+	return info.lastModified().toTime_t();
+}
+
+}
+
+//------------------------------------------------------------------------------
+// Name: SymbolCache
+// Desc:
+//------------------------------------------------------------------------------
+SymbolCache::SymbolCache() : header_(0), entries_(0), hash_(0), strings_(0) {
+}
+
+//------------------------------------------------------------------------------
+// Name: ~SymbolCache
+// Desc:
+//------------------------------------------------------------------------------
+SymbolCache::~SymbolCache() {
+	close();
+}
+
+//------------------------------------------------------------------------------
+// Name: write
+// Desc: writes a symbol cache for the binary <source> to <filename>. The
+//       records do not need to be in any order, duplicates are dropped
+//------------------------------------------------------------------------------
+bool SymbolCache::write(const QString &filename, const QString &source, QVector<Record> records) {
+
+	const QFileInfo info(source);
+	if(!info.exists()) {
+		return false;
+	}
+
+	std::sort(records.begin(), records.end(), record_less);
+
+	QByteArray strings;
+	QVector<Entry> entries;
+	entries.reserve(records.size());
+
+	for(int i = 0; i < records.size(); ++i) {
+		const Record &record = records.at(i);
+		if(i != 0) {
+			const Record &previous = records.at(i - 1);
+			if(previous.address == record.address && previous.size == record.size && previous.type == record.type && previous.name == record.name) {
+				continue;
+			}
+		}
+
+		Entry entry;
+		std::memset(&entry, 0, sizeof(entry));
+		entry.address = record.address;
+		entry.size    = record.size;
+		entry.name      = strings.size();
+		entry.demangled = entry.name;
+		entry.type      = record.type;
+
+		strings.append(record.name);
+		strings.append('\0');
+
+		const QByteArray demangled = demangle(record.name);
+		if(!demangled.isEmpty() && demangled != record.name) {
+			entry.demangled = strings.size();
+			strings.append(demangled);
+			strings.append('\0');
+		}
+
+		entries.push_back(entry);
+	}
+
+	const QByteArray path = info.absoluteFilePath().toUtf8();
+	const quint32 source_offset = strings.size();
+	strings.append(path);
+	strings.append('\0');
+
+	quint32 names = 0;
+	for(int i = 0; i < entries.size(); ++i) {
+		names += (entries[i].demangled != entries[i].name) ? 2 : 1;
+	}
+
+	// open addressing with at most half of the slots used, a slot holds the
+	// entry index + 1 so that 0 can mean empty. A symbol is in there by both
+	// of its names, when two symbols share a name the one with the lowest
+	// address wins
+	quint32 hash_size = 1;
+	while(hash_size < names * 2) {
+		hash_size <<= 1;
+	}
+
+	QVector<quint32> hash(hash_size, 0);
+	for(int i = 0; i < entries.size(); ++i) {
+		insert_name(&hash, strings, entries, entries[i].name, i);
+		if(entries[i].demangled != entries[i].name) {
+			insert_name(&hash, strings, entries, entries[i].demangled, i);
+		}
+	}
+
+	Header header;
+	std::memset(&header, 0, sizeof(header));
+	std::memcpy(header.magic, Magic, sizeof(Magic));
+	header.version     = Version;
+	header.count       = entries.size();
+	header.hash_size   = hash_size;
+	header.string_size = strings.size();
+	header.source      = source_offset;
+	header.source_size = info.size();
+	header.source_time = source_time(info);
+
+	const QByteArray md5 = edb::v1::get_file_md5(source);
+	if(md5.size() == sizeof(header.md5)) {
+		std::memcpy(header.md5, md5.constData(), sizeof(header.md5));
+	}
+
+	// write to a temporary name first so that a reader never maps a cache
+	// which is only partially written
+	const QString temp_filename = edb::v1::temp_filename(filename);
+	QFile file(temp_filename);
+	if(!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+		return false;
+	}
+
+	bool ok = true;
+	ok = ok && file.write(reinterpret_cast<const char *>(&header), sizeof(header)) == sizeof(header);
+	ok = ok && file.write(reinterpret_cast<const char *>(entries.constData()), entries.size() * sizeof(Entry)) == static_cast<qint64>(entries.size() * sizeof(Entry));
+	ok = ok && file.write(reinterpret_cast<const char *>(hash.constData()), hash.size() * sizeof(quint32)) == static_cast<qint64>(hash.size() * sizeof(quint32));
+	ok = ok && file.write(strings) == strings.size();
+	file.close();
+
+	if(ok) {
+		QFile::remove(filename);
+		ok = QFile::rename(temp_filename, filename);
+	}
+
+	if(!ok) {
+		QFile::remove(temp_filename);
+	}
+
+	return ok;
+}
+
+//------------------------------------------------------------------------------
+// Name: insert_name
+// Desc: puts <index> in the slot for <name>, unless an earlier entry already
+//       has it
+//------------------------------------------------------------------------------
+void SymbolCache::insert_name(QVector<quint32> *hash, const QByteArray &strings, const QVector<Entry> &entries, quint32 offset, int index) {
+
+	const char *const name = strings.constData() + offset;
+	const int length       = std::strlen(name);
+	const quint32 mask     = hash->size() - 1;
+
+	quint32 slot = hash_name(name, length) & mask;
+	while((*hash)[slot] != 0) {
+		const Entry &other = entries[(*hash)[slot] - 1];
+		if(std::strcmp(strings.constData() + other.name, name) == 0 || std::strcmp(strings.constData() + other.demangled, name) == 0) {
+			return;
+		}
+		slot = (slot + 1) & mask;
+	}
+
+	(*hash)[slot] = index + 1;
+}
+
+//------------------------------------------------------------------------------
+// Name: open
+// Desc: maps a symbol cache, fails if it is not one or was written by a
+//       different version
+//------------------------------------------------------------------------------
+bool SymbolCache::open(const QString &filename) {
+
+	close();
+
+	file_.setFileName(filename);
+	if(!file_.open(QIODevice::ReadOnly)) {
+		return false;
+	}
+
+	const qint64 file_size = file_.size();
+	if(file_size >= static_cast<qint64>(sizeof(Header))) {
+		if(const uchar *const data = file_.map(0, file_size)) {
+
+			const Header *const header = reinterpret_cast<const Header *>(data);
+
+			const qint64 expected_size =
+				static_cast<qint64>(sizeof(Header)) +
+				static_cast<qint64>(header->count) * sizeof(Entry) +
+				static_cast<qint64>(header->hash_size) * sizeof(quint32) +
+				header->string_size;
+
+			if(std::memcmp(header->magic, Magic, sizeof(Magic)) == 0 &&
+			   header->version == Version &&
+			   expected_size == file_size &&
+			   header->hash_size != 0 && (header->hash_size & (header->hash_size - 1)) == 0 &&
+			   header->string_size != 0 && header->source < header->string_size &&
+			   data[file_size - 1] == '\0') {
+
+				header_  = header;
+				entries_ = reinterpret_cast<const Entry *>(data + sizeof(Header));
+				hash_    = reinterpret_cast<const quint32 *>(entries_ + header->count);
+				strings_ = reinterpret_cast<const char *>(hash_ + header->hash_size);
+				return true;
+			}
+
+			qDebug() << "ignoring symbol cache with an unknown format:" << filename;
+		}
+	}
+
+	close();
+	return false;
+}
+
+//------------------------------------------------------------------------------
+// Name: close
+// Desc:
+//------------------------------------------------------------------------------
+void SymbolCache::close() {
+	header_  = 0;
+	entries_ = 0;
+	hash_    = 0;
+	strings_ = 0;
+	by_name_.clear();
+	file_.close();
+}
+
+//------------------------------------------------------------------------------
+// Name: is_open
+// Desc:
+//------------------------------------------------------------------------------
+bool SymbolCache::is_open() const {
+	return header_ != 0;
+}
+
+//------------------------------------------------------------------------------
+// Name: matches
+// Desc: returns true if the cache was written for <source> as it is now. The
+//       size and modification time are compared rather than the md5, hashing a
+//       large binary on every load would cost more than the cache saves
+//------------------------------------------------------------------------------
+bool SymbolCache::matches(const QString &source) const {
+	if(!header_) {
+		return false;
+	}
+
+	const QFileInfo info(source);
+	return info.exists() && static_cast<quint64>(info.size()) == header_->source_size && source_time(info) == header_->source_time;
+}
+
+//------------------------------------------------------------------------------
+// Name: md5
+// Desc: the md5 of the binary this cache was written for
+//------------------------------------------------------------------------------
+QByteArray SymbolCache::md5() const {
+	if(!header_) {
+		return QByteArray();
+	}
+	return QByteArray(reinterpret_cast<const char *>(header_->md5), sizeof(header_->md5));
+}
+
+//------------------------------------------------------------------------------
+// Name: source
+// Desc: the absolute path of the binary this cache was written for
+//------------------------------------------------------------------------------
+QString SymbolCache::source() const {
+	if(!header_) {
+		return QString();
+	}
+	return QString::fromUtf8(strings_ + header_->source);
+}
+
+//------------------------------------------------------------------------------
+// Name: count
+// Desc:
+//------------------------------------------------------------------------------
+quint32 SymbolCache::count() const {
+	return header_ ? header_->count : 0;
+}
+
+//------------------------------------------------------------------------------
+// Name: address
+// Desc:
+//------------------------------------------------------------------------------
+quint64 SymbolCache::address(quint32 index) const {
+	Q_ASSERT(index < count());
+	return entries_[index].address;
+}
+
+//------------------------------------------------------------------------------
+// Name: size
+// Desc:
+//------------------------------------------------------------------------------
+quint64 SymbolCache::size(quint32 index) const {
+	Q_ASSERT(index < count());
+	return entries_[index].size;
+}
+
+//------------------------------------------------------------------------------
+// Name: type
+// Desc:
+//------------------------------------------------------------------------------
+char SymbolCache::type(quint32 index) const {
+	Q_ASSERT(index < count());
+	return entries_[index].type;
+}
+
+//------------------------------------------------------------------------------
+// Name: name
+// Desc: the name without any module prefix, points into the mapping
+//------------------------------------------------------------------------------
+const char *SymbolCache::name(quint32 index) const {
+	Q_ASSERT(index < count());
+	const quint32 offset = entries_[index].name;
+	return offset < header_->string_size ? strings_ + offset : "";
+}
+
+//------------------------------------------------------------------------------
+// Name: demangled
+// Desc: the name as the views should show it, the same as name unless it was
+//       a mangled C++ name
+//------------------------------------------------------------------------------
+const char *SymbolCache::demangled(quint32 index) const {
+	Q_ASSERT(index < count());
+	const quint32 offset = entries_[index].demangled;
+	return offset < header_->string_size ? strings_ + offset : "";
+}
+
+//------------------------------------------------------------------------------
+// Name: find
+// Desc: returns the index of the first symbol at exactly <address>, or -1
+//------------------------------------------------------------------------------
+qint64 SymbolCache::find(quint64 address) const {
+
+	quint32 first = 0;
+	quint32 last  = count();
+
+	while(first < last) {
+		const quint32 middle = first + (last - first) / 2;
+		if(entries_[middle].address < address) {
+			first = middle + 1;
+		} else {
+			last = middle;
+		}
+	}
+
+	if(first < count() && entries_[first].address == address) {
+		return first;
+	}
+
+	return -1;
+}
+
+//------------------------------------------------------------------------------
+// Name: find_near
+// Desc: returns the index of the symbol whose range contains <address>, or -1
+//------------------------------------------------------------------------------
+qint64 SymbolCache::find_near(quint64 address) const {
+
+	// find the first symbol after the address, the one before it is the only
+	// one which can contain it
+	quint32 first = 0;
+	quint32 last  = count();
+
+	while(first < last) {
+		const quint32 middle = first + (last - first) / 2;
+		if(entries_[middle].address <= address) {
+			first = middle + 1;
+		} else {
+			last = middle;
+		}
+	}
+
+	if(first != 0) {
+		const Entry &entry = entries_[first - 1];
+		if(address - entry.address < entry.size) {
+			return first - 1;
+		}
+	}
+
+	return -1;
+}
+
+//------------------------------------------------------------------------------
+// Name: find
+// Desc: returns the index of the symbol named <name> (without a module prefix),
+//       mangled or not, or -1
+//------------------------------------------------------------------------------
+qint64 SymbolCache::find(const QByteArray &symbol) const {
+
+	if(!header_) {
+		return -1;
+	}
+
+	const quint32 mask = header_->hash_size - 1;
+	quint32 slot = hash_name(symbol.constData(), symbol.size()) & mask;
+
+	for(quint32 probes = 0; probes < header_->hash_size; ++probes) {
+		const quint32 value = hash_[slot];
+		if(value == 0 || value > header_->count) {
+			break;
+		}
+
+		if(symbol == name(value - 1) || symbol == demangled(value - 1)) {
+			return value - 1;
+		}
+
+		slot = (slot + 1) & mask;
+	}
+
+	return -1;
+}
+
+//------------------------------------------------------------------------------
+// Name: find_prefix
+// Desc: returns the indexes of the symbols whose demangled name (without a
+//       module prefix) starts with <prefix>, in name order
+//------------------------------------------------------------------------------
+QVector<quint32> SymbolCache::find_prefix(const QByteArray &prefix) const {
+
+	QVector<quint32> results;
+
+	if(!header_) {
+		return results;
+	}
+
+	if(by_name_.size() != static_cast<int>(count())) {
+		by_name_.resize(count());
+		for(quint32 i = 0; i < count(); ++i) {
+			by_name_[i] = i;
+		}
+		std::sort(by_name_.begin(), by_name_.end(), NameLess(this));
+	}
+
+	// the first name not less than the prefix, everything that starts with
+	// it follows in one run
+	int first = 0;
+	int last  = by_name_.size();
+	while(first < last) {
+		const int middle = first + (last - first) / 2;
+		if(std::strcmp(demangled(by_name_[middle]), prefix.constData()) < 0) {
+			first = middle + 1;
+		} else {
+			last = middle;
+		}
+	}
+
+	for(int i = first; i < by_name_.size(); ++i) {
+		if(std::strncmp(demangled(by_name_[i]), prefix.constData(), prefix.size()) != 0) {
+			break;
+		}
+		results.push_back(by_name_[i]);
+	}
+
+	return results;
+}
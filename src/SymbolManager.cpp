@@ -19,22 +19,210 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "SymbolManager.h"
 #include "ISymbolGenerator.h"
 #include "MD5.h"
+#include "MemoryRegions.h"
+#include "SymbolCache.h"
 #include "edb.h"
 
+#include <QCoreApplication>
 #include <QFile>
 #include <QDir>
 #include <QtDebug>
 #include <QProcess>
 #include <QMessageBox>
+#include <QMetaObject>
+#include <QRunnable>
+#include <QThread>
+
+#if QT_VERSION >= 0x050100
+#include <QLockFile>
+#endif
+
+#include <cctype>
+#include <cstring>
 #include <istream>
 #include <fstream>
 #include <iostream>
 
+namespace {
+
+//------------------------------------------------------------------------------
+// Name: name_matches
+// Desc: fuzzy matches are case insensitive and only need the characters of
+//       <text> to appear in order
+//------------------------------------------------------------------------------
+bool name_matches(const char *name, const QByteArray &text, ISymbolManager::SearchMode mode) {
+	switch(mode) {
+	case ISymbolManager::SEARCH_EXACT:
+		return std::strcmp(name, text.constData()) == 0;
+	case ISymbolManager::SEARCH_PREFIX:
+		return std::strncmp(name, text.constData(), text.size()) == 0;
+	case ISymbolManager::SEARCH_SUBSTRING:
+		return std::strstr(name, text.constData()) != 0;
+	case ISymbolManager::SEARCH_FUZZY:
+		{
+			const char *p = text.constData();
+			for(; *name && *p; ++name) {
+				if(std::tolower(static_cast<unsigned char>(*name)) == std::tolower(static_cast<unsigned char>(*p))) {
+					++p;
+				}
+			}
+			return *p == '\0';
+		}
+	}
+	return false;
+}
+
+//------------------------------------------------------------------------------
+// Name: make_handle
+// Desc: source 0 is the symbol table, source n is module n - 1
+//------------------------------------------------------------------------------
+quint64 make_handle(quint32 source, quint32 index) {
+	return (static_cast<quint64>(source) << 32) | index;
+}
+
+//------------------------------------------------------------------------------
+// Name: cache_is_current
+// Desc:
+//------------------------------------------------------------------------------
+bool cache_is_current(const QString &symbol_file, const QString &library_filename) {
+	SymbolCache cache;
+	return cache.open(symbol_file) && cache.matches(library_filename);
+}
+
+//------------------------------------------------------------------------------
+// Name: update_symbol_cache
+// Desc: brings <symbol_file> up to date and returns the cache to load, or an
+//       empty string if there is none. Other edb processes debugging programs
+//       which share the library wait up to <timeout> ms for whichever of them
+//       got there first, and then find it current, rather than all
+//       generating it at once. One which can't wait that long generates a
+//       private cache of its own instead
+//------------------------------------------------------------------------------
+QString update_symbol_cache(ISymbolGenerator *generator, const QString &library_filename, const QString &symbol_file, int timeout) {
+
+	QString target = symbol_file;
+
+#if QT_VERSION >= 0x050100
+	// a big library can take a while, a lock older than this is from an edb
+	// which went away while it had it
+	QLockFile lock(symbol_file + ".lock");
+	lock.setStaleLockTime(10 * 60 * 1000);
+
+	if(!lock.tryLock(timeout)) {
+		if(cache_is_current(symbol_file, library_filename)) {
+			return symbol_file;
+		}
+
+		target = QString("%1.%2").arg(symbol_file).arg(QCoreApplication::applicationPid());
+	}
+#else
+	Q_UNUSED(timeout);
+#endif
+
+	if(cache_is_current(target, library_filename)) {
+		return target;
+	}
+
+	qDebug() << "Auto-Generating Symbol File: " << target;
+	if(!generator->generate_symbol_file(library_filename, target)) {
+		return QString();
+	}
+
+	return target;
+}
+
+// brings a module's symbol cache up to date on the generator pool and tells
+// the symbol manager once it is there
+class GenerateSymbols : public QRunnable {
+public:
+	GenerateSymbols(QObject *manager, ISymbolGenerator *generator, const QString &library_filename, const QString &symbol_file)
+		: manager_(manager), generator_(generator), library_filename_(library_filename), symbol_file_(symbol_file) {
+	}
+
+public:
+	virtual void run() {
+		// off the UI thread waiting for another edb is fine, for a while
+		const QString loaded = update_symbol_cache(generator_, library_filename_, symbol_file_, 30 * 1000);
+		QMetaObject::invokeMethod(manager_, "generation_finished", Qt::QueuedConnection, Q_ARG(QString, library_filename_), Q_ARG(QString, loaded));
+	}
+
+private:
+	QObject          *manager_;
+	ISymbolGenerator *generator_;
+	QString           library_filename_;
+	QString           symbol_file_;
+};
+
+}
+
 //------------------------------------------------------------------------------
 // Name: SymbolManager
 // Desc:
 //------------------------------------------------------------------------------
-SymbolManager::SymbolManager() : symbol_generator_(0), show_path_notice_(true) {	
+SymbolManager::SymbolManager() : generation_total_(0), generation_done_(0), generation_(0), symbol_generator_(0), show_path_notice_(true) {
+	// modules are independent, so as many are generated at once as there are
+	// cores to do it
+	generator_pool_.setMaxThreadCount(QThread::idealThreadCount());
+
+	// the labels themselves are annotations, only finding them by name is
+	// done here
+	connect(&edb::v1::annotations(), SIGNAL(cleared(Annotations::Kind)), this, SLOT(annotations_cleared(Annotations::Kind)));
+
+	edb::memory::add_consumer("symbols", this);
+}
+
+//------------------------------------------------------------------------------
+// Name: ~SymbolManager
+// Desc:
+//------------------------------------------------------------------------------
+SymbolManager::~SymbolManager() {
+	edb::memory::remove_consumer(this);
+}
+
+//------------------------------------------------------------------------------
+// Name: memory_used
+// Desc: the symbol table's arrays and name arena, and the name indexes of the
+//       mapped caches. The mappings themselves are backed by their files
+//------------------------------------------------------------------------------
+quint64 SymbolManager::memory_used() const {
+	quint64 bytes = table_.memory_used();
+	Q_FOREACH(const Module &module, modules_) {
+		bytes += module.cache->memory_used();
+	}
+	Q_FOREACH(const Module &module, retired_) {
+		bytes += module.cache->memory_used();
+	}
+	return bytes;
+}
+
+//------------------------------------------------------------------------------
+// Name: trim
+// Desc: the symbols themselves can't be made again, the name indexes of the
+//       caches are, by the next prefix search which needs one
+//------------------------------------------------------------------------------
+void SymbolManager::trim(quint64 bytes) {
+
+	quint64 used = memory_used();
+
+	for(QList<Module>::iterator it = modules_.begin(); it != modules_.end() && used > bytes; ++it) {
+		used -= qMin(used, it->cache->memory_used());
+		it->cache->drop_name_index();
+	}
+
+	for(QHash<QString, Module>::iterator it = retired_.begin(); it != retired_.end() && used > bytes; ++it) {
+		used -= qMin(used, it->cache->memory_used());
+		it->cache->drop_name_index();
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: annotations_cleared
+// Desc:
+//------------------------------------------------------------------------------
+void SymbolManager::annotations_cleared(Annotations::Kind kind) {
+	if(kind == Annotations::LABEL) {
+		labels_by_name_.clear();
+	}
 }
 
 //------------------------------------------------------------------------------
@@ -53,16 +241,39 @@ void SymbolManager::set_symbol_path(const QString &symbol_directory) {
 //------------------------------------------------------------------------------
 void SymbolManager::clear() {
 	symbol_files_.clear();
-	symbols_.clear();
-	symbols_by_address_.clear();
-	symbols_by_name_.clear();	
-	labels_.clear();
-	labels_by_name_.clear();
+	table_.clear();
+	modules_.clear();
+	modules_by_address_.clear();
+	modules_by_prefix_.clear();
+	pending_.clear();
+	pending_by_name_.clear();
+	retired_.clear();
+	++generation_;
+}
+
+//------------------------------------------------------------------------------
+// Name: clear_for_restart
+// Desc: like clear, but the caches of the loaded modules are kept mapped in
+//       <retired_> for load_symbol_cache to take back
+//------------------------------------------------------------------------------
+void SymbolManager::clear_for_restart() {
+
+	QHash<QString, Module> retired;
+	Q_FOREACH(const Module &module, modules_) {
+		if(module.cache->count() != 0) {
+			retired.insert(module.cache->source(), module);
+		}
+	}
+
+	clear();
+	qSwap(retired_, retired);
 }
 
 //------------------------------------------------------------------------------
 // Name: load_symbol_file
-// Desc:
+// Desc: notes that a module is mapped, its symbols are only loaded once
+//       something is looked up in it. In the meantime its symbol cache is
+//       brought up to date in the background
 //------------------------------------------------------------------------------
 void SymbolManager::load_symbol_file(const QString &filename, edb::address_t base) {
 
@@ -77,13 +288,338 @@ void SymbolManager::load_symbol_file(const QString &filename, edb::address_t bas
 	const QFileInfo info(filename);
 	const QString name = info.fileName();
 
-	if(!symbol_files_.contains(name)) {
-		const QString map_file = QString("%1/%2.map").arg(symbol_directory_, name);
+	if(!symbol_files_.contains(name) && !pending_by_name_.contains(name)) {
+		PendingModule module;
+		module.name        = name;
+		module.symbol_file = QString("%1/%2.sym").arg(symbol_directory_, name);
+		module.base        = base;
+		module.requested   = false;
+		module.generated   = false;
+
+		// a module the process had before it was restarted still has its
+		// cache mapped, if the file hasn't changed there is nothing to bring
+		// up to date
+		QHash<QString, Module>::const_iterator it = retired_.find(filename);
+		if(it != retired_.end() && it->cache->matches(filename)) {
+			module.symbol_file = it->file;
+			module.generated   = true;
+		}
+
+		pending_.insert(filename, module);
+		pending_by_name_.insert(name, filename);
+
+		if(symbol_generator_ && !module.generated) {
+			start_generation(filename, module.symbol_file);
+		}
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: unload_symbol_file
+// Desc: forgets the symbols of a module which is no longer mapped. Its slot in
+//       modules_ is kept with an empty cache so that the other modules keep
+//       their indexes, lookups and searches simply find nothing in it
+//------------------------------------------------------------------------------
+void SymbolManager::unload_symbol_file(const QString &filename) {
+
+	const QString name = QFileInfo(filename).fileName();
+
+	if(pending_.remove(filename)) {
+		pending_by_name_.remove(name);
+		++generation_;
+		return;
+	}
+
+	if(!symbol_files_.remove(name)) {
+		return;
+	}
+
+	QHash<QString, int>::iterator it = modules_by_prefix_.find(name);
+	if(it != modules_by_prefix_.end()) {
+		const int index = it.value();
+		modules_by_prefix_.erase(it);
 
-		if(process_symbol_file(map_file, base, filename)) {
-			symbol_files_.insert(name);
+		if(modules_by_address_.value(modules_[index].first, -1) == index) {
+			modules_by_address_.remove(modules_[index].first);
 		}
+
+		modules_[index].cache = QSharedPointer<SymbolCache>(new SymbolCache);
 	}
+
+	++generation_;
+}
+
+//------------------------------------------------------------------------------
+// Name: wait_for_symbol_file
+// Desc: loads the symbols of a module passed to load_symbol_file right away,
+//       for when something can't wait for them to be generated in the
+//       background. The queued generation_finished calls arrive later and
+//       find the module already loaded
+//------------------------------------------------------------------------------
+void SymbolManager::wait_for_symbol_file(const QString &filename) {
+
+	QHash<QString, PendingModule>::iterator it = pending_.find(filename);
+	if(it == pending_.end()) {
+		return;
+	}
+
+	if(generating_.contains(filename)) {
+		generator_pool_.waitForDone();
+	}
+
+	// this is on the UI thread, so it doesn't wait for another edb at all
+	if(symbol_generator_) {
+		const QString symbol_file = QString("%1/%2.sym").arg(symbol_directory_, it->name);
+		const QString loaded      = update_symbol_cache(symbol_generator_, filename, symbol_file, 0);
+		if(!loaded.isEmpty()) {
+			it->symbol_file = loaded;
+		}
+	}
+
+	finish_module(filename);
+}
+
+//------------------------------------------------------------------------------
+// Name: start_generation
+// Desc:
+//------------------------------------------------------------------------------
+void SymbolManager::start_generation(const QString &library_filename, const QString &symbol_file) {
+	if(!generating_.contains(library_filename)) {
+		generating_.insert(library_filename);
+		++generation_total_;
+		generator_pool_.start(new GenerateSymbols(this, symbol_generator_, library_filename, symbol_file));
+		report_progress();
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: report_progress
+// Desc:
+//------------------------------------------------------------------------------
+void SymbolManager::report_progress() {
+
+	if(edb::v1::debugger_ui) {
+		if(generating_.isEmpty()) {
+			edb::v1::set_status(tr("Symbols ready for %n module(s)", "", generation_done_));
+		} else {
+			edb::v1::set_status(tr("Generating symbols: %1 of %2 modules").arg(generation_done_).arg(generation_total_));
+		}
+	}
+
+	// a batch is over once nothing is left in flight
+	if(generating_.isEmpty()) {
+		generation_total_ = 0;
+		generation_done_  = 0;
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: request_module_at
+// Desc: loads the symbols of the module mapped at <address> if they aren't yet
+//------------------------------------------------------------------------------
+void SymbolManager::request_module_at(edb::address_t address) const {
+	if(!pending_.isEmpty()) {
+		if(const IRegion::pointer region = edb::v1::memory_regions().find_region(address)) {
+			if(pending_.contains(region->name())) {
+				// NOTE: loading on demand is not a visible change, so lookups are
+				// still const as far as callers are concerned
+				const_cast<SymbolManager *>(this)->load_module(region->name());
+			}
+		}
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: request_module
+// Desc: loads the symbols of the module named by the prefix of <name> if they
+//       aren't yet
+//------------------------------------------------------------------------------
+void SymbolManager::request_module(const QString &name) const {
+	if(!pending_.isEmpty()) {
+		const int n = name.indexOf("::");
+		if(n != -1) {
+			QHash<QString, QString>::const_iterator it = pending_by_name_.find(name.left(n));
+			if(it != pending_by_name_.end()) {
+				const_cast<SymbolManager *>(this)->load_module(it.value());
+			}
+		}
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: load_module
+// Desc: maps a pending module's symbol cache. If it has to be generated first
+//       that happens on the generator pool, and until it is done lookups in
+//       the module simply find nothing
+//------------------------------------------------------------------------------
+void SymbolManager::load_module(const QString &library_filename) {
+
+	QHash<QString, PendingModule>::iterator it = pending_.find(library_filename);
+	if(it == pending_.end()) {
+		return;
+	}
+
+	if(generating_.contains(library_filename)) {
+		it->requested = true;
+		return;
+	}
+
+	// the generator may have shown up after the module was mapped
+	const QString symbol_file = QString("%1/%2.sym").arg(symbol_directory_, it->name);
+	if(symbol_generator_ && !it->generated && !cache_is_current(symbol_file, library_filename)) {
+		it->requested = true;
+		start_generation(library_filename, symbol_file);
+		return;
+	}
+
+	finish_module(library_filename);
+}
+
+//------------------------------------------------------------------------------
+// Name: generation_finished
+// Desc:
+//------------------------------------------------------------------------------
+void SymbolManager::generation_finished(const QString &library_filename, const QString &symbol_file) {
+
+	generating_.remove(library_filename);
+	++generation_done_;
+	report_progress();
+
+	if(symbol_file.isEmpty()) {
+		qDebug() << "Failed to generate symbols for" << library_filename;
+	}
+
+	// the symbols may have been cleared while we were busy, and if nothing has
+	// been looked up in the module there is no hurry to load it
+	QHash<QString, PendingModule>::iterator it = pending_.find(library_filename);
+	if(it != pending_.end()) {
+		if(!symbol_file.isEmpty()) {
+			it->symbol_file = symbol_file;
+		}
+
+		it->generated = true;
+		if(it->requested) {
+			finish_module(library_filename);
+			if(edb::v1::debugger_ui) {
+				edb::v1::update_ui();
+			}
+		}
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: finish_module
+// Desc: loads whatever symbols there are for a pending module, hand written
+//       text symbol files are still used when there is no cache
+//------------------------------------------------------------------------------
+void SymbolManager::finish_module(const QString &library_filename) {
+
+	const PendingModule module = pending_.take(library_filename);
+	pending_by_name_.remove(module.name);
+
+	const QString symbol_file = QString("%1/%2.sym").arg(symbol_directory_, module.name);
+	const QString map_file    = QString("%1/%2.map").arg(symbol_directory_, module.name);
+
+	if(!load_symbol_cache(module.symbol_file, module.base, library_filename)) {
+		process_symbol_file(map_file, module.base, library_filename);
+	}
+
+	// a private cache made while another edb held the shared one's lock stays
+	// mapped, nobody is going to open it again
+	if(module.symbol_file != symbol_file) {
+		QFile::remove(module.symbol_file);
+	}
+
+	symbol_files_.insert(module.name);
+	++generation_;
+}
+
+//------------------------------------------------------------------------------
+// Name: load_symbol_cache
+// Desc: maps the symbol cache for a module
+//------------------------------------------------------------------------------
+bool SymbolManager::load_symbol_cache(const QString &f, edb::address_t base, const QString &library_filename) {
+
+	QSharedPointer<SymbolCache> cache;
+
+	const Module retired = retired_.take(library_filename);
+	if(retired.cache && retired.file == f && retired.cache->matches(library_filename)) {
+		cache = retired.cache;
+	} else {
+		cache = QSharedPointer<SymbolCache>(new SymbolCache);
+
+		if(!cache->open(f)) {
+			return false;
+		}
+
+		if(!cache->matches(library_filename)) {
+			qDebug() << "Your symbol file for" << library_filename << "appears to not match the actual file, perhaps you should rebuild your symbols?";
+		}
+
+		qDebug() << "loading symbols:" << f;
+	}
+
+	Module module;
+	module.cache  = cache;
+	module.file   = f;
+	module.prefix = QFileInfo(cache->source()).fileName();
+	module.base   = 0;
+	module.first  = 0;
+	module.last   = 0;
+
+	if(const quint32 count = cache->count()) {
+
+		// the symbols of a shared library are relative to where it is loaded
+		if(cache->address(count - 1) < base) {
+			module.base = base;
+		}
+
+		module.first = module.base + cache->address(0);
+		module.last  = module.base + cache->address(count - 1) + cache->size(count - 1);
+	}
+
+	modules_by_address_.insert(module.first, modules_.size());
+	modules_by_prefix_.insert(module.prefix, modules_.size());
+	modules_.append(module);
+	return true;
+}
+
+//------------------------------------------------------------------------------
+// Name: module_at
+// Desc: returns the module whose symbols may cover <address>, or NULL
+//------------------------------------------------------------------------------
+const SymbolManager::Module *SymbolManager::module_at(edb::address_t address) const {
+
+	QMap<edb::address_t, int>::const_iterator it = modules_by_address_.upperBound(address);
+	if(it == modules_by_address_.constBegin()) {
+		return 0;
+	}
+
+	--it;
+
+	const Module &module = modules_[it.value()];
+	if(module.cache->count() != 0 && address <= module.last) {
+		return &module;
+	}
+
+	return 0;
+}
+
+//------------------------------------------------------------------------------
+// Name: make_symbol
+// Desc: symbols in a cache are only turned into Symbol objects when asked for.
+//       They go by their demangled names, which find knows them by as well
+//------------------------------------------------------------------------------
+Symbol::pointer SymbolManager::make_symbol(const Module &module, quint32 index) const {
+	Symbol::pointer sym(new Symbol);
+
+	sym->file           = module.file;
+	sym->name_no_prefix = QString::fromUtf8(module.cache->demangled(index));
+	sym->name           = QString("%1::%2").arg(module.prefix, sym->name_no_prefix);
+	sym->address        = module.base + module.cache->address(index);
+	sym->size           = module.cache->size(index);
+	sym->type           = module.cache->type(index);
+	return sym;
 }
 
 //------------------------------------------------------------------------------
@@ -91,10 +627,26 @@ void SymbolManager::load_symbol_file(const QString &filename, edb::address_t bas
 // Desc:
 //------------------------------------------------------------------------------
 const Symbol::pointer SymbolManager::find(const QString &name) const {
-	QHash<QString, Symbol::pointer>::const_iterator it = symbols_by_name_.find(name);
-	if(it != symbols_by_name_.end()) {
-		return it.value();
+
+	request_module(name);
+
+	const int symbol = table_.find(name);
+	if(symbol != -1) {
+		return table_.symbol(symbol);
 	}
+
+	const int n = name.indexOf("::");
+	if(n != -1) {
+		QHash<QString, int>::const_iterator module = modules_by_prefix_.find(name.left(n));
+		if(module != modules_by_prefix_.end()) {
+			const Module &m = modules_[module.value()];
+			const qint64 index = m.cache->find(name.mid(n + 2).toUtf8());
+			if(index != -1) {
+				return make_symbol(m, index);
+			}
+		}
+	}
+
 	return Symbol::pointer();
 }
 
@@ -103,8 +655,22 @@ const Symbol::pointer SymbolManager::find(const QString &name) const {
 // Desc:
 //------------------------------------------------------------------------------
 const Symbol::pointer SymbolManager::find(edb::address_t address) const {
-	QMap<edb::address_t, Symbol::pointer>::const_iterator it = symbols_by_address_.find(address);
-	return (it != symbols_by_address_.end()) ? it.value() : Symbol::pointer();
+
+	request_module_at(address);
+
+	const int symbol = table_.find(address);
+	if(symbol != -1) {
+		return table_.symbol(symbol);
+	}
+
+	if(const Module *const module = module_at(address)) {
+		const qint64 index = module->cache->find(static_cast<quint64>(address - module->base));
+		if(index != -1) {
+			return make_symbol(*module, index);
+		}
+	}
+
+	return Symbol::pointer();
 }
 
 //------------------------------------------------------------------------------
@@ -113,43 +679,84 @@ const Symbol::pointer SymbolManager::find(edb::address_t address) const {
 //------------------------------------------------------------------------------
 const Symbol::pointer SymbolManager::find_near_symbol(edb::address_t address) const {
 
-	QMap<edb::address_t, Symbol::pointer>::const_iterator it = symbols_by_address_.lowerBound(address);
-	if(it != symbols_by_address_.end()) {
+	request_module_at(address);
 
-		// not an exact match, we should backup one
-		if(address != it.value()->address) {
-			// not safe to backup!, return early
-			if(it == symbols_by_address_.begin()) {
-				return Symbol::pointer();
-			}
-			--it;
-		}
+	const int symbol = table_.find_near(address);
+	if(symbol != -1) {
+		return table_.symbol(symbol);
+	}
 
-		if(const Symbol::pointer sym = it.value()) {
-			if(address >= sym->address && address < sym->address + sym->size) {
-				return sym;
-			}
+	if(const Module *const module = module_at(address)) {
+		const qint64 index = module->cache->find_near(static_cast<quint64>(address - module->base));
+		if(index != -1) {
+			return make_symbol(*module, index);
 		}
 	}
 
 	return Symbol::pointer();
 }
 
+//------------------------------------------------------------------------------
+// Name: find_source_line
+// Desc: the generator reads the module's debug info, it works in addresses as
+//       the module was linked
+//------------------------------------------------------------------------------
+bool SymbolManager::find_source_line(edb::address_t address, QString *file, int *line, edb::address_t *start) const {
+
+	Q_ASSERT(file);
+	Q_ASSERT(line);
+	Q_ASSERT(start);
+
+	if(!symbol_generator_) {
+		return false;
+	}
+
+	request_module_at(address);
+
+	if(const Module *const module = module_at(address)) {
+		edb::address_t line_start;
+		if(symbol_generator_->source_line(module->cache->source(), address - module->base, file, line, &line_start)) {
+			*start = line_start + module->base;
+			return true;
+		}
+	}
+
+	return false;
+}
+
 //------------------------------------------------------------------------------
 // Name: add_symbol
 // Desc:
 //------------------------------------------------------------------------------
 void SymbolManager::add_symbol(const Symbol::pointer &symbol) {
 	Q_ASSERT(symbol);
-	symbols_.append(symbol);
-	symbols_by_address_[symbol->address] = symbol;
-	symbols_by_name_[symbol->name]       = symbol;
+	table_.add(*symbol);
+	table_.sort();
+	++generation_;
+}
+
+//------------------------------------------------------------------------------
+// Name: add_symbols
+// Desc: like add_symbol, but the table is only sorted once for all of them
+//------------------------------------------------------------------------------
+void SymbolManager::add_symbols(const QList<Symbol::pointer> &symbols) {
+
+	if(symbols.isEmpty()) {
+		return;
+	}
+
+	Q_FOREACH(const Symbol::pointer &symbol, symbols) {
+		Q_ASSERT(symbol);
+		table_.add(*symbol);
+	}
+
+	table_.sort();
+	++generation_;
 }
 
 //------------------------------------------------------------------------------
 // Name: process_symbol_file
-// Desc:
-// Note: returning false means 'try again', true means, 'we loaded what we could'
+// Desc: loads a text symbol file, returns false if there wasn't one
 //------------------------------------------------------------------------------
 bool SymbolManager::process_symbol_file(const QString &f, edb::address_t base, const QString &library_filename) {
 
@@ -182,34 +789,31 @@ bool SymbolManager::process_symbol_file(const QString &f, edb::address_t base, c
 				char sym_type;
 
 				while(file >> std::hex >> sym_start >> std::hex >> sym_end >> sym_type >> sym_name) {
-					Symbol::pointer sym(new Symbol);
+					Symbol sym;
 
-					sym->file           = f;
-					sym->name_no_prefix = QString::fromStdString(sym_name);
-					sym->name           = QString("%1::%2").arg(prefix, sym->name_no_prefix);
-					sym->address        = sym_start;
-					sym->size           = sym_end;
-					sym->type           = sym_type;
+					sym.file           = f;
+					sym.name_no_prefix = QString::fromStdString(sym_name);
+					sym.name           = QString("%1::%2").arg(prefix, sym.name_no_prefix);
+					sym.address        = sym_start;
+					sym.size           = sym_end;
+					sym.type           = sym_type;
 
 					// fixup the base address based on where it is loaded
-					if(sym->address < base) {
-						sym->address += base;
+					if(sym.address < base) {
+						sym.address += base;
 					}
 
-					add_symbol(sym);
+					table_.add(sym);
 				}
+
+				// sorted once for the whole file rather than per symbol
+				table_.sort();
 				return true;
 			}
 		}
-	} else if(symbol_generator_) {
-		qDebug() << "Auto-Generating Symbol File: " << f;
-		if(symbol_generator_->generate_symbol_file(library_filename, f)) {
-			return false;
-		}
 	}
 
-	// TODO: should we return false and try again later?
-	return true;
+	return false;
 }
 
 //------------------------------------------------------------------------------
@@ -217,7 +821,24 @@ bool SymbolManager::process_symbol_file(const QString &f, edb::address_t base, c
 // Desc:
 //------------------------------------------------------------------------------
 const QList<Symbol::pointer> SymbolManager::symbols() const {
-	return symbols_;
+
+	// NOTE: this loads every module and turns every cached symbol into a
+	// Symbol, it is meant for things which really do want all of them. Modules
+	// whose symbols are still being generated are missing
+	load_all_modules();
+
+	QList<Symbol::pointer> symbols;
+	for(int i = 0; i < table_.size(); ++i) {
+		symbols.append(table_.symbol(i));
+	}
+
+	Q_FOREACH(const Module &module, modules_) {
+		const quint32 count = module.cache->count();
+		for(quint32 i = 0; i < count; ++i) {
+			symbols.append(make_symbol(module, i));
+		}
+	}
+	return symbols;
 }
 
 //------------------------------------------------------------------------------
@@ -235,9 +856,12 @@ void SymbolManager::set_symbol_generator(ISymbolGenerator *generator) {
 //       wants to call this address). And only apply to code
 //------------------------------------------------------------------------------
 void SymbolManager::set_label(edb::address_t address, const QString &label) {
+
+	Annotations &annotations = edb::v1::annotations();
+
 	if(label.isEmpty()) {
-		labels_by_name_.remove(labels_[address]);
-		labels_.remove(address);
+		labels_by_name_.remove(annotations.find(Annotations::LABEL, address));
+		annotations.remove(Annotations::LABEL, address);
 	} else {
 	
 		if(labels_by_name_.contains(label) && labels_by_name_[label] != address) {
@@ -249,8 +873,10 @@ void SymbolManager::set_label(edb::address_t address, const QString &label) {
 			return;
 		}
 	
-		labels_[address] = label;
+		// the name it had before is free again
+		labels_by_name_.remove(annotations.find(Annotations::LABEL, address));
 		labels_by_name_[label] = address;
+		annotations.set(Annotations::LABEL, address, label);
 	}
 }
 
@@ -259,9 +885,9 @@ void SymbolManager::set_label(edb::address_t address, const QString &label) {
 // Desc:
 //------------------------------------------------------------------------------
 QString SymbolManager::find_address_name(edb::address_t address) {
-	QHash<edb::address_t, QString>::const_iterator it = labels_.find(address);
-	if(it != labels_.end()) {
-		return it.value();
+	const QString label = edb::v1::annotations().find(Annotations::LABEL, address);
+	if(!label.isEmpty()) {
+		return label;
 	}
 	
 	if(const Symbol::pointer sym = find(address)) {
@@ -276,6 +902,162 @@ QString SymbolManager::find_address_name(edb::address_t address) {
 // Name: labels
 // Desc:
 //------------------------------------------------------------------------------
-QHash<edb::address_t, QString> SymbolManager::labels() const {
-	return labels_;
+const QVector<Annotations::Entry> &SymbolManager::labels() const {
+	return edb::v1::annotations().entries(Annotations::LABEL);
+}
+
+//------------------------------------------------------------------------------
+// Name: load_all_modules
+// Desc: loads every module that hasn't been yet, modules whose symbols are
+//       still being generated show up later
+//------------------------------------------------------------------------------
+void SymbolManager::load_all_modules() const {
+	Q_FOREACH(const QString &library_filename, pending_.keys()) {
+		const_cast<SymbolManager *>(this)->load_module(library_filename);
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: generation
+// Desc: changes whenever symbols are added or removed
+//------------------------------------------------------------------------------
+quint64 SymbolManager::generation() const {
+	return generation_;
+}
+
+//------------------------------------------------------------------------------
+// Name: handle_name
+// Desc: the unprefixed name and the module prefix of a search result, or NULL
+//       if the handle isn't valid
+//------------------------------------------------------------------------------
+const char *SymbolManager::handle_name(quint64 handle, QString *prefix) const {
+
+	Q_ASSERT(prefix);
+
+	const quint32 source = handle >> 32;
+	const quint32 index  = handle & 0xffffffff;
+
+	if(source == 0) {
+		if(index < static_cast<quint32>(table_.size())) {
+			*prefix = table_.prefix(index);
+			return table_.name(index);
+		}
+	} else if(source <= static_cast<quint32>(modules_.size())) {
+		const Module &module = modules_[source - 1];
+		if(index < module.cache->count()) {
+			*prefix = module.prefix;
+			return module.cache->demangled(index);
+		}
+	}
+
+	return 0;
+}
+
+//------------------------------------------------------------------------------
+// Name: from_handle
+// Desc:
+//------------------------------------------------------------------------------
+Symbol::pointer SymbolManager::from_handle(quint64 handle) const {
+
+	const quint32 source = handle >> 32;
+	const quint32 index  = handle & 0xffffffff;
+
+	if(source == 0) {
+		if(index < static_cast<quint32>(table_.size())) {
+			return table_.symbol(index);
+		}
+	} else if(source <= static_cast<quint32>(modules_.size())) {
+		const Module &module = modules_[source - 1];
+		if(index < module.cache->count()) {
+			return make_symbol(module, index);
+		}
+	}
+
+	return Symbol::pointer();
+}
+
+//------------------------------------------------------------------------------
+// Name: search
+// Desc: exact and prefix searches use the name indexes, substring and fuzzy
+//       searches scan the names, which are contiguous in each module. Every
+//       keystroke extends the last text, so passing the last results as
+//       <within> means only those are looked at again
+//------------------------------------------------------------------------------
+QVector<quint64> SymbolManager::search(const QString &text, SearchMode mode, const QVector<quint64> *within) const {
+
+	QString    module_name;
+	QByteArray name = text.toUtf8();
+
+	const int n = text.indexOf("::");
+	if(n != -1) {
+		module_name = text.left(n);
+		name        = text.mid(n + 2).toUtf8();
+	}
+
+	QVector<quint64> results;
+
+	if(within) {
+		QString prefix;
+		Q_FOREACH(quint64 handle, *within) {
+			if(const char *const symbol = handle_name(handle, &prefix)) {
+				if((module_name.isEmpty() || prefix == module_name) && name_matches(symbol, name, mode)) {
+					results.push_back(handle);
+				}
+			}
+		}
+		return results;
+	}
+
+	load_all_modules();
+
+	// the symbol table holds symbols of any module
+	if(mode == SEARCH_EXACT || mode == SEARCH_PREFIX) {
+		Q_FOREACH(quint32 index, table_.find_prefix(name)) {
+			if((module_name.isEmpty() || table_.prefix(index) == module_name) && name_matches(table_.name(index), name, mode)) {
+				results.push_back(make_handle(0, index));
+			}
+		}
+	} else {
+		for(int i = 0; i < table_.size(); ++i) {
+			if((module_name.isEmpty() || table_.prefix(i) == module_name) && name_matches(table_.name(i), name, mode)) {
+				results.push_back(make_handle(0, i));
+			}
+		}
+	}
+
+	for(int m = 0; m < modules_.size(); ++m) {
+		const Module &module = modules_[m];
+		if(!module_name.isEmpty() && module.prefix != module_name) {
+			continue;
+		}
+
+		switch(mode) {
+		case SEARCH_EXACT:
+			{
+				const qint64 index = module.cache->find(name);
+				if(index != -1) {
+					results.push_back(make_handle(m + 1, index));
+				}
+			}
+			break;
+		case SEARCH_PREFIX:
+			Q_FOREACH(quint32 index, module.cache->find_prefix(name)) {
+				results.push_back(make_handle(m + 1, index));
+			}
+			break;
+		case SEARCH_SUBSTRING:
+		case SEARCH_FUZZY:
+			{
+				const quint32 count = module.cache->count();
+				for(quint32 i = 0; i < count; ++i) {
+					if(name_matches(module.cache->demangled(i), name, mode)) {
+						results.push_back(make_handle(m + 1, i));
+					}
+				}
+			}
+			break;
+		}
+	}
+
+	return results;
 }
@@ -19,15 +19,27 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #ifndef SYMBOLMANAGER_20060814_H_
 #define SYMBOLMANAGER_20060814_H_
 
+#include "Annotations.h"
 #include "ISymbolManager.h"
+#include "MemoryBudget.h"
+#include "SymbolTable.h"
 #include <QHash>
+#include <QList>
 #include <QMap>
+#include <QObject>
 #include <QSet>
+#include <QSharedPointer>
 #include <QString>
+#include <QThreadPool>
+
+class SymbolCache;
+
+class SymbolManager : public QObject, public ISymbolManager, public edb::memory::Consumer {
+	Q_OBJECT
 
-class SymbolManager : public ISymbolManager {
 public:
 	SymbolManager();
+	virtual ~SymbolManager();
 
 public:
 	virtual const QList<Symbol::pointer> symbols() const;
@@ -35,27 +47,90 @@ public:
 	virtual const Symbol::pointer find(edb::address_t address) const;
 	virtual const Symbol::pointer find_near_symbol(edb::address_t address) const;
 	virtual void add_symbol(const Symbol::pointer &symbol);
+	virtual void add_symbols(const QList<Symbol::pointer> &symbols);
 	virtual void clear();
 	virtual void load_symbol_file(const QString &filename, edb::address_t base);
+	virtual void unload_symbol_file(const QString &filename);
+	virtual void wait_for_symbol_file(const QString &filename);
 	virtual void set_symbol_generator(ISymbolGenerator *generator);
 	virtual void set_symbol_path(const QString &symbol_directory);
 	virtual void set_label(edb::address_t address, const QString &label);
 	virtual QString find_address_name(edb::address_t address);
-	virtual QHash<edb::address_t, QString> labels() const;
+	virtual const QVector<Annotations::Entry> &labels() const;
+
+public:
+	virtual void clear_for_restart();
+
+public:
+	virtual QVector<quint64> search(const QString &text, SearchMode mode, const QVector<quint64> *within) const;
+	virtual Symbol::pointer from_handle(quint64 handle) const;
+	virtual quint64 generation() const;
+
+public:
+	virtual bool find_source_line(edb::address_t address, QString *file, int *line, edb::address_t *start) const;
+
+public:
+	virtual quint64 memory_used() const;
+	virtual void trim(quint64 bytes);
 
 private:
+	// the symbols of one loaded module, served from its mapped cache
+	struct Module {
+		QSharedPointer<SymbolCache> cache;
+		QString                     file;
+		QString                     prefix;
+		edb::address_t              base;
+		edb::address_t              first;
+		edb::address_t              last;
+	};
+
+	// a module which has been mapped but whose symbols haven't been asked for
+	struct PendingModule {
+		QString        name;
+		QString        symbol_file;
+		edb::address_t base;
+		bool           requested;
+		bool           generated;
+	};
+
+private Q_SLOTS:
+	void generation_finished(const QString &library_filename, const QString &symbol_file);
+	void annotations_cleared(Annotations::Kind kind);
+
+private:
+	void request_module_at(edb::address_t address) const;
+	void request_module(const QString &name) const;
+	void load_module(const QString &library_filename);
+	void start_generation(const QString &library_filename, const QString &symbol_file);
+	void report_progress();
+	void finish_module(const QString &library_filename);
+	bool load_symbol_cache(const QString &f, edb::address_t base, const QString &library_filename);
 	bool process_symbol_file(const QString &f, edb::address_t base, const QString &library_filename);
+	const Module *module_at(edb::address_t address) const;
+	Symbol::pointer make_symbol(const Module &module, quint32 index) const;
+	void load_all_modules() const;
+	const char *handle_name(quint64 handle, QString *prefix) const;
 
 private:
+	QHash<QString, PendingModule>         pending_;
+	QHash<QString, QString>               pending_by_name_;
+	QSet<QString>                         generating_;
+	QThreadPool                           generator_pool_;
+	int                                   generation_total_;
+	int                                   generation_done_;
+	QList<Module>                         modules_;
+	QMap<edb::address_t, int>             modules_by_address_;
+	QHash<QString, int>                   modules_by_prefix_;
 	QString                               symbol_directory_;
 	QSet<QString>                         symbol_files_;
-	QList<Symbol::pointer>                symbols_;
-	QMap<edb::address_t, Symbol::pointer> symbols_by_address_;
-	QHash<QString, Symbol::pointer>       symbols_by_name_;
+	SymbolTable                           table_;
+	quint64                               generation_;
 	ISymbolGenerator                     *symbol_generator_;
 	bool                                  show_path_notice_;
-	QHash<edb::address_t, QString>        labels_;
 	QHash<QString, edb::address_t>        labels_by_name_;
+
+	// the modules clear_for_restart put aside, by the binary they are for
+	QHash<QString, Module>                retired_;
 	
 };
 
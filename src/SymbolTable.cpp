@@ -0,0 +1,401 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "SymbolTable.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+struct AddressLess {
+	explicit AddressLess(const QVector<edb::address_t> &addresses) : addresses_(addresses) {
+	}
+
+	bool operator()(quint32 lhs, quint32 rhs) const {
+		return addresses_[lhs] < addresses_[rhs];
+	}
+
+	const QVector<edb::address_t> &addresses_;
+};
+
+// equal names are kept in address order, which is also the order they were
+// added in when they share an address
+struct NameLess {
+	NameLess(const QVector<quint16> &prefixes, const QVector<quint32> &names, const char *arena) : prefixes_(prefixes), names_(names), arena_(arena) {
+	}
+
+	bool operator()(quint32 lhs, quint32 rhs) const {
+		if(prefixes_[lhs] != prefixes_[rhs]) {
+			return prefixes_[lhs] < prefixes_[rhs];
+		}
+		const int cmp = std::strcmp(arena_ + names_[lhs], arena_ + names_[rhs]);
+		if(cmp != 0) {
+			return cmp < 0;
+		}
+		return lhs < rhs;
+	}
+
+	const QVector<quint16> &prefixes_;
+	const QVector<quint32> &names_;
+	const char             *arena_;
+};
+
+//------------------------------------------------------------------------------
+// Name: permute
+// Desc: reorders <values> so that the i'th element is the old order[i]'th
+//------------------------------------------------------------------------------
+template <class T>
+void permute(QVector<T> *values, const QVector<quint32> &order) {
+	QVector<T> result;
+	result.reserve(order.size());
+	Q_FOREACH(quint32 index, order) {
+		result.push_back((*values)[index]);
+	}
+	qSwap(*values, result);
+}
+
+//------------------------------------------------------------------------------
+// Name: identity
+// Desc:
+//------------------------------------------------------------------------------
+QVector<quint32> identity(int n) {
+	QVector<quint32> order(n);
+	for(int i = 0; i < n; ++i) {
+		order[i] = i;
+	}
+	return order;
+}
+
+}
+
+//------------------------------------------------------------------------------
+// Name: SymbolTable
+// Desc:
+//------------------------------------------------------------------------------
+SymbolTable::SymbolTable() : sorted_size_(0) {
+	clear();
+}
+
+//------------------------------------------------------------------------------
+// Name: memory_used
+// Desc:
+//------------------------------------------------------------------------------
+quint64 SymbolTable::memory_used() const {
+	return addresses_.capacity() * sizeof(edb::address_t)
+		+ (sizes_.capacity() + names_.capacity() + by_name_.capacity()) * sizeof(quint32)
+		+ (prefixes_.capacity() + files_.capacity()) * sizeof(quint16)
+		+ types_.capacity()
+		+ arena_.capacity();
+}
+
+//------------------------------------------------------------------------------
+// Name: clear
+// Desc:
+//------------------------------------------------------------------------------
+void SymbolTable::clear() {
+	addresses_.clear();
+	sizes_.clear();
+	names_.clear();
+	prefixes_.clear();
+	files_.clear();
+	types_.clear();
+	by_name_.clear();
+	arena_.clear();
+	prefix_strings_.clear();
+	prefix_index_.clear();
+	file_strings_.clear();
+	file_index_.clear();
+	sorted_size_ = 0;
+
+	// index 0 is always "no prefix"/"no file"
+	intern(&prefix_strings_, &prefix_index_, QString());
+	intern(&file_strings_, &file_index_, QString());
+}
+
+//------------------------------------------------------------------------------
+// Name: intern
+// Desc:
+//------------------------------------------------------------------------------
+quint16 SymbolTable::intern(QStringList *strings, QHash<QString, quint16> *index, const QString &s) {
+
+	QHash<QString, quint16>::const_iterator it = index->constFind(s);
+	if(it != index->constEnd()) {
+		return it.value();
+	}
+
+	// there won't be anywhere near this many modules, but don't wrap if there are
+	if(strings->size() > 0xffff) {
+		return 0;
+	}
+
+	const quint16 n = strings->size();
+	strings->append(s);
+	index->insert(s, n);
+	return n;
+}
+
+//------------------------------------------------------------------------------
+// Name: add
+// Desc: the table must be sorted again before it is searched
+//------------------------------------------------------------------------------
+void SymbolTable::add(const Symbol &symbol) {
+
+	// the full name is only kept as a prefix and the name without it, when
+	// it isn't made that way the whole name is kept unprefixed
+	const QString suffix = "::" + symbol.name_no_prefix;
+	QString prefix;
+	QString name = symbol.name;
+	if(!symbol.name_no_prefix.isEmpty() && symbol.name.endsWith(suffix)) {
+		prefix = symbol.name.left(symbol.name.size() - suffix.size());
+		name   = symbol.name_no_prefix;
+	}
+
+	addresses_.push_back(symbol.address);
+	sizes_.push_back(symbol.size);
+	names_.push_back(arena_.size());
+	prefixes_.push_back(intern(&prefix_strings_, &prefix_index_, prefix));
+	files_.push_back(intern(&file_strings_, &file_index_, symbol.file));
+	types_.push_back(symbol.type);
+
+	arena_.append(name.toUtf8());
+	arena_.append('\0');
+}
+
+//------------------------------------------------------------------------------
+// Name: sort
+// Desc: puts the table in address order and updates the name index. Only the
+//       symbols added since the last sort are sorted, they are then merged
+//       with the rest, so adding a batch to a big table costs about as much
+//       as copying it once. The merges are stable so when symbols share an
+//       address the one added last wins, just like inserting them into a map
+//       would
+//------------------------------------------------------------------------------
+void SymbolTable::sort() {
+
+	const int n = addresses_.size();
+	if(sorted_size_ == n) {
+		return;
+	}
+
+	const AddressLess address_less(addresses_);
+
+	QVector<quint32> order = identity(n);
+	std::stable_sort(order.begin() + sorted_size_, order.end(), address_less);
+	std::inplace_merge(order.begin(), order.begin() + sorted_size_, order.end(), address_less);
+
+	// where each entry ends up
+	QVector<quint32> position(n);
+	for(int i = 0; i < n; ++i) {
+		position[order[i]] = i;
+	}
+
+	permute(&addresses_, order);
+	permute(&sizes_, order);
+	permute(&names_, order);
+	permute(&prefixes_, order);
+	permute(&files_, order);
+	permute(&types_, order);
+
+	// the old entries keep their order relative to each other, so their part
+	// of the name index only has to follow them to where they are now
+	QVector<quint32> by_name;
+	by_name.reserve(n);
+	Q_FOREACH(quint32 index, by_name_) {
+		by_name.push_back(position[index]);
+	}
+
+	for(int i = sorted_size_; i < n; ++i) {
+		by_name.push_back(position[i]);
+	}
+
+	const NameLess name_less(prefixes_, names_, arena_.constData());
+	std::sort(by_name.begin() + sorted_size_, by_name.end(), name_less);
+	std::inplace_merge(by_name.begin(), by_name.begin() + sorted_size_, by_name.end(), name_less);
+
+	qSwap(by_name_, by_name);
+	sorted_size_ = n;
+}
+
+//------------------------------------------------------------------------------
+// Name: symbol
+// Desc: builds a Symbol for one entry, the prefixed name is only made here
+//------------------------------------------------------------------------------
+Symbol::pointer SymbolTable::symbol(int index) const {
+
+	Q_ASSERT(index >= 0 && index < size());
+
+	Symbol::pointer sym(new Symbol);
+
+	const QString &prefix = prefix_strings_[prefixes_[index]];
+
+	sym->file           = file_strings_[files_[index]];
+	sym->name_no_prefix = QString::fromUtf8(arena_.constData() + names_[index]);
+	sym->name           = prefix.isEmpty() ? sym->name_no_prefix : QString("%1::%2").arg(prefix, sym->name_no_prefix);
+	sym->address        = addresses_[index];
+	sym->size           = sizes_[index];
+	sym->type           = types_[index];
+	return sym;
+}
+
+//------------------------------------------------------------------------------
+// Name: upper_bound
+// Desc: the number of symbols at or below <address>. The loop has no branch
+//       besides its own, the compiler turns the select into a cmov
+//------------------------------------------------------------------------------
+int SymbolTable::upper_bound(edb::address_t address) const {
+
+	Q_ASSERT(sorted_size_ == addresses_.size());
+
+	int n = addresses_.size();
+	if(n == 0) {
+		return 0;
+	}
+
+	const edb::address_t *const first = addresses_.constData();
+	const edb::address_t *base        = first;
+
+	while(n > 1) {
+		const int half = n / 2;
+		base = (base[half] <= address) ? base + half : base;
+		n -= half;
+	}
+
+	return (base - first) + (*base <= address);
+}
+
+//------------------------------------------------------------------------------
+// Name: find
+// Desc: returns the index of the symbol at exactly <address>, or -1
+//------------------------------------------------------------------------------
+int SymbolTable::find(edb::address_t address) const {
+	const int n = upper_bound(address);
+	if(n != 0 && addresses_[n - 1] == address) {
+		return n - 1;
+	}
+	return -1;
+}
+
+//------------------------------------------------------------------------------
+// Name: find_near
+// Desc: returns the index of the symbol whose range contains <address>, or -1
+//------------------------------------------------------------------------------
+int SymbolTable::find_near(edb::address_t address) const {
+	const int n = upper_bound(address);
+	if(n != 0 && address - addresses_[n - 1] < sizes_[n - 1]) {
+		return n - 1;
+	}
+	return -1;
+}
+
+//------------------------------------------------------------------------------
+// Name: find
+// Desc: returns the index of the symbol with the (prefixed) <name>, or -1
+//------------------------------------------------------------------------------
+int SymbolTable::find(const QString &name) const {
+
+	Q_ASSERT(sorted_size_ == addresses_.size());
+
+	quint16 prefix   = 0;
+	QByteArray value = name.toUtf8();
+
+	const int n = name.indexOf("::");
+	if(n != -1) {
+		QHash<QString, quint16>::const_iterator it = prefix_index_.constFind(name.left(n));
+		if(it != prefix_index_.constEnd()) {
+			prefix = it.value();
+			value  = name.mid(n + 2).toUtf8();
+		}
+	}
+
+	// find the last entry not greater than (prefix, value)
+	int first = 0;
+	int last  = by_name_.size();
+	while(first < last) {
+		const int middle     = first + (last - first) / 2;
+		const quint32 index  = by_name_[middle];
+		const bool not_after = prefixes_[index] < prefix || (prefixes_[index] == prefix && std::strcmp(arena_.constData() + names_[index], value.constData()) <= 0);
+		if(not_after) {
+			first = middle + 1;
+		} else {
+			last = middle;
+		}
+	}
+
+	if(first != 0) {
+		const quint32 index = by_name_[first - 1];
+		if(prefixes_[index] == prefix && std::strcmp(arena_.constData() + names_[index], value.constData()) == 0) {
+			return index;
+		}
+	}
+
+	return -1;
+}
+
+//------------------------------------------------------------------------------
+// Name: find_prefix
+// Desc: returns the indexes of the symbols whose name (without a module
+//       prefix) starts with <prefix>, in (module, name) order
+//------------------------------------------------------------------------------
+QVector<quint32> SymbolTable::find_prefix(const QByteArray &prefix) const {
+
+	Q_ASSERT(sorted_size_ == addresses_.size());
+
+	QVector<quint32> results;
+
+	// by_name_ is ordered by prefix first, so each module is its own run
+	int run = 0;
+	while(run < by_name_.size()) {
+		const quint16 module = prefixes_[by_name_[run]];
+
+		// the end of this module's run
+		int end = run;
+		int last = by_name_.size();
+		while(end < last) {
+			const int middle = end + (last - end) / 2;
+			if(prefixes_[by_name_[middle]] <= module) {
+				end = middle + 1;
+			} else {
+				last = middle;
+			}
+		}
+
+		// the first name in it not less than the prefix
+		int first = run;
+		last      = end;
+		while(first < last) {
+			const int middle = first + (last - first) / 2;
+			if(std::strcmp(name(by_name_[middle]), prefix.constData()) < 0) {
+				first = middle + 1;
+			} else {
+				last = middle;
+			}
+		}
+
+		for(int i = first; i < end; ++i) {
+			if(std::strncmp(name(by_name_[i]), prefix.constData(), prefix.size()) != 0) {
+				break;
+			}
+			results.push_back(by_name_[i]);
+		}
+
+		run = end;
+	}
+
+	return results;
+}
@@ -0,0 +1,87 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SYMBOL_TABLE_20261014_H_
+#define SYMBOL_TABLE_20261014_H_
+
+#include "Symbol.h"
+#include "Types.h"
+#include <QByteArray>
+#include <QHash>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+// the symbols which don't come from a mapped symbol cache, kept as parallel
+// arrays sorted by address. Names live in one shared arena and the module
+// prefix and file of each symbol are interned, so a symbol costs a couple of
+// dozen bytes plus its name instead of a heap object holding three strings
+class SymbolTable {
+public:
+	SymbolTable();
+
+public:
+	void add(const Symbol &symbol);
+	void sort();
+	void clear();
+
+public:
+	int size() const { return addresses_.size(); }
+	bool empty() const { return addresses_.isEmpty(); }
+	Symbol::pointer symbol(int index) const;
+
+public:
+	int find(edb::address_t address) const;
+	int find_near(edb::address_t address) const;
+	int find(const QString &name) const;
+	QVector<quint32> find_prefix(const QByteArray &prefix) const;
+
+public:
+	const char *name(int index) const { return arena_.constData() + names_[index]; }
+	const QString &prefix(int index) const { return prefix_strings_[prefixes_[index]]; }
+
+public:
+	// roughly, the interned strings aren't counted
+	quint64 memory_used() const;
+
+private:
+	static quint16 intern(QStringList *strings, QHash<QString, quint16> *index, const QString &s);
+	int upper_bound(edb::address_t address) const;
+
+private:
+	QVector<edb::address_t> addresses_;
+	QVector<quint32>        sizes_;
+	QVector<quint32>        names_;
+	QVector<quint16>        prefixes_;
+	QVector<quint16>        files_;
+	QVector<char>           types_;
+
+	// indexes of the symbols sorted by (prefix, name)
+	QVector<quint32>        by_name_;
+
+	QByteArray              arena_;
+	QStringList             prefix_strings_;
+	QHash<QString, quint16> prefix_index_;
+	QStringList             file_strings_;
+	QHash<QString, quint16> file_index_;
+
+	// how many of the entries, from the first, were there at the last sort
+	int                     sorted_size_;
+};
+
+#endif
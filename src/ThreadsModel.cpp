@@ -17,7 +17,9 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
 #include "ThreadsModel.h"
+#include "IDebugger.h"
 #include "edb.h"
+#include <QSet>
 #include <QtAlgorithms>
 
 ThreadsModel::ThreadsModel(QObject *parent) : QAbstractItemModel(parent) {
@@ -52,33 +54,41 @@ QVariant ThreadsModel::data(const QModelIndex &index, int role) const {
 		const Item &item = items_[index.row()];
 
 		if(role == Qt::DisplayRole) {
-			switch(index.column()) {
-			case 0:
+			// the ID is all that sorting by the first column needs, so only the
+			// other columns fetch the details
+			if(index.column() == 0) {
 				if(item.current) {
-					return tr("*%1").arg(item.info.tid);
+					return tr("*%1").arg(item.tid);
 				} else {
-					return item.info.tid;
+					return item.tid;
 				}
+			}
+
+			const ThreadInfo &info = this->info(item);
+
+			switch(index.column()) {
 			case 1:
-				return item.info.priority;
+				return info.priority;
 			case 2:
 				{
 					const QString default_region_name;
-					const QString symname = edb::v1::find_function_symbol(item.info.ip, default_region_name);
+					const QString symname = edb::v1::find_function_symbol(info.ip, default_region_name);
 
 					if(!symname.isEmpty()) {
-						return QString("%1 <%2>").arg(edb::v1::format_pointer(item.info.ip)).arg(symname);
+						return QString("%1 <%2>").arg(edb::v1::format_pointer(info.ip)).arg(symname);
 					} else {
-						return QString("%1").arg(edb::v1::format_pointer(item.info.ip));
+						return QString("%1").arg(edb::v1::format_pointer(info.ip));
 					}				
 				}
 			case 3:
-				return item.info.state;
+				return info.state;
 			case 4:
-				return item.info.name;								
+				return info.running ? tr("Running") : tr("Stopped");
+			case 5:
+				return info.name;
 			}
 		} else if(role == Qt::UserRole) {
-			return item.info.tid;
+			return item.tid;
 		}
 	}
 
@@ -98,7 +108,9 @@ QVariant ThreadsModel::headerData(int section, Qt::Orientation orientation, int
 		case 3:
 			return tr("State");			
 		case 4:
-			return tr("Name");			
+			return tr("Run State");
+		case 5:
+			return tr("Name");
 		}
 	}
 
@@ -107,7 +119,7 @@ QVariant ThreadsModel::headerData(int section, Qt::Orientation orientation, int
 
 int ThreadsModel::columnCount(const QModelIndex &parent) const {
 	Q_UNUSED(parent);
-	return 5;
+	return 6;
 }
 
 int ThreadsModel::rowCount(const QModelIndex &parent) const {
@@ -119,14 +131,80 @@ void ThreadsModel::addThread(const ThreadInfo &info, bool current) {
 	beginInsertRows(QModelIndex(), rowCount(), rowCount());
 
 	const Item item = {
-		info, current
+		info.tid, current, true, info
 	};
 	items_.push_back(item);
 	endInsertRows();
 }
 
 void ThreadsModel::clear() {
-	beginRemoveRows(QModelIndex(), 0, rowCount());
+	beginResetModel();
 	items_.clear();
-	endRemoveRows();
+	endResetModel();
+}
+
+// brings the model up to date with <threads>, the rows of threads which have
+// exited are removed and new ones are added at the end. Whatever was fetched
+// for the rest is thrown away since they may have run since
+void ThreadsModel::sync(const QList<edb::tid_t> &threads, edb::tid_t current) {
+
+	const QSet<edb::tid_t> alive = threads.toSet();
+
+	// the exited ones are removed a run of rows at a time
+	for(int row = items_.size() - 1; row >= 0; ) {
+		if(alive.contains(items_[row].tid)) {
+			--row;
+			continue;
+		}
+
+		int first = row;
+		while(first > 0 && !alive.contains(items_[first - 1].tid)) {
+			--first;
+		}
+
+		beginRemoveRows(QModelIndex(), first, row);
+		items_.remove(first, row - first + 1);
+		endRemoveRows();
+
+		row = first - 1;
+	}
+
+	QSet<edb::tid_t> known;
+	for(int row = 0; row < items_.size(); ++row) {
+		Item &item = items_[row];
+		item.current = (item.tid == current);
+		item.loaded  = false;
+		known.insert(item.tid);
+	}
+
+	if(!items_.isEmpty()) {
+		Q_EMIT dataChanged(index(0, 0), index(items_.size() - 1, columnCount() - 1));
+	}
+
+	QVector<Item> added;
+	Q_FOREACH(edb::tid_t tid, threads) {
+		if(!known.contains(tid)) {
+			const Item item = {
+				tid, tid == current, false, ThreadInfo()
+			};
+			added.push_back(item);
+		}
+	}
+
+	if(!added.isEmpty()) {
+		beginInsertRows(QModelIndex(), items_.size(), items_.size() + added.size() - 1);
+		items_ += added;
+		endInsertRows();
+	}
+}
+
+// the details of <item>'s thread, fetched the first time they're needed
+const ThreadInfo &ThreadsModel::info(const Item &item) const {
+	if(!item.loaded) {
+		if(edb::v1::debugger_core) {
+			item.info = edb::v1::debugger_core->get_thread_info(item.tid);
+		}
+		item.loaded = true;
+	}
+	return item.info;
 }
@@ -0,0 +1,43 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef TIMEDSLOT_20261014_H_
+#define TIMEDSLOT_20261014_H_
+
+#include "Diagnostics.h"
+#include <QObject>
+
+// stands between a signal and one slot of a receiver, timing every call of
+// the slot. Belongs to the receiver, so it goes when the receiver does
+class TimedSlot : public QObject {
+	Q_OBJECT
+
+public:
+	TimedSlot(const QString &signal, QObject *receiver, const char *member);
+
+public Q_SLOTS:
+	void trigger();
+
+Q_SIGNALS:
+	void triggered();
+
+private:
+	edb::diagnostics::Counter *const counter_;
+};
+
+#endif
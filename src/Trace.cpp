@@ -0,0 +1,214 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Trace.h"
+#include "Diagnostics.h"
+#include "edb.h"
+
+#include <QAtomicInt>
+#include <QCoreApplication>
+#include <QList>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QString>
+#include <QStringList>
+#include <QThread>
+#include <QThreadStorage>
+
+namespace {
+
+// how many of the latest spans each thread keeps
+const int BufferSize = 65536;
+
+struct Event {
+	const char *name;
+	quint64     start;
+	quint64     duration;
+};
+
+// written only by the thread it belongs to, <published> is how many spans
+// it has recorded so far and is what the reader goes by
+struct Buffer {
+	int        tid;
+	QString    thread_name;
+	int        next;
+	QAtomicInt published;
+	Event      events[BufferSize];
+};
+
+// QThreadStorage deletes what it holds when the thread exits, but the spans
+// are wanted after that, so it only holds a pointer to the buffer
+struct BufferHandle {
+	Buffer *buffer;
+};
+
+QMutex                         g_BuffersLock;
+QList<Buffer *>                g_Buffers;
+QThreadStorage<BufferHandle *> g_ThreadBuffer;
+
+//------------------------------------------------------------------------------
+// Name: published
+// Desc: reads an atomic counter the same way on Qt4 and Qt5
+//------------------------------------------------------------------------------
+int published(Buffer *buffer) {
+	return buffer->published.fetchAndAddOrdered(0);
+}
+
+//------------------------------------------------------------------------------
+// Name: thread_buffer
+// Desc: the calling thread's buffer, made the first time it records a span
+//------------------------------------------------------------------------------
+Buffer *thread_buffer() {
+
+	if(!g_ThreadBuffer.hasLocalData()) {
+		Buffer *const buffer = new Buffer;
+		buffer->next = 0;
+
+		QThread *const thread = QThread::currentThread();
+		if(QCoreApplication::instance() && thread == QCoreApplication::instance()->thread()) {
+			buffer->thread_name = "UI";
+		} else {
+			buffer->thread_name = thread->objectName();
+		}
+
+		QMutexLocker locker(&g_BuffersLock);
+		buffer->tid = g_Buffers.size() + 1;
+		if(buffer->thread_name.isEmpty()) {
+			buffer->thread_name = QString("thread %1").arg(buffer->tid);
+		}
+		g_Buffers.push_back(buffer);
+
+		BufferHandle *const handle = new BufferHandle;
+		handle->buffer = buffer;
+		g_ThreadBuffer.setLocalData(handle);
+	}
+
+	return g_ThreadBuffer.localData()->buffer;
+}
+
+//------------------------------------------------------------------------------
+// Name: microseconds
+// Desc: the Trace Event format's unit
+//------------------------------------------------------------------------------
+QString microseconds(quint64 nsecs) {
+	return QString("%1.%2").arg(nsecs / 1000).arg(nsecs % 1000, 3, 10, QChar('0'));
+}
+
+}
+
+namespace edb {
+namespace trace {
+
+//------------------------------------------------------------------------------
+// Name: record
+// Desc: <start> and <end> are from edb::diagnostics::nsecs
+//------------------------------------------------------------------------------
+void record(const char *name, quint64 start, quint64 end) {
+
+	Buffer *const buffer = thread_buffer();
+
+	Event &event = buffer->events[buffer->next % BufferSize];
+	event.name     = name;
+	event.start    = start;
+	event.duration = end - start;
+
+	buffer->published.fetchAndStoreRelease(++buffer->next);
+}
+
+//------------------------------------------------------------------------------
+// Name: enabled
+// Desc: true if edb was built with the spans in it
+//------------------------------------------------------------------------------
+bool enabled() {
+#ifdef EDB_TRACING
+	return true;
+#else
+	return false;
+#endif
+}
+
+//------------------------------------------------------------------------------
+// Name: clear
+// Desc: forgets every span recorded so far. Only the calling thread's buffer
+//       is safe to clear while others are recording, so this is meant for when
+//       the UI thread is the only one tracing
+//------------------------------------------------------------------------------
+void clear() {
+	QMutexLocker locker(&g_BuffersLock);
+	Q_FOREACH(Buffer *buffer, g_Buffers) {
+		buffer->next = 0;
+		buffer->published.fetchAndStoreRelease(0);
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: to_chrome_json
+// Desc: every thread's spans as "complete" (ph X) events, with each thread
+//       named by a metadata event. A thread which is still recording may
+//       overwrite the oldest of its spans while they are being read
+//------------------------------------------------------------------------------
+QByteArray to_chrome_json() {
+
+	const qint64 pid = QCoreApplication::applicationPid();
+
+	QStringList events;
+
+	QMutexLocker locker(&g_BuffersLock);
+	Q_FOREACH(Buffer *buffer, g_Buffers) {
+
+		events.push_back(QString("\t\t{ \"name\": \"thread_name\", \"ph\": \"M\", \"pid\": %1, \"tid\": %2, \"args\": { \"name\": %3 } }")
+			.arg(pid)
+			.arg(buffer->tid)
+			.arg(edb::v1::json_string(buffer->thread_name)));
+
+		const int last  = published(buffer);
+		const int first = qMax(0, last - BufferSize);
+
+		for(int i = first; i < last; ++i) {
+			const Event &event = buffer->events[i % BufferSize];
+			events.push_back(QString("\t\t{ \"name\": %1, \"cat\": \"edb\", \"ph\": \"X\", \"ts\": %2, \"dur\": %3, \"pid\": %4, \"tid\": %5 }")
+				.arg(edb::v1::json_string(QString::fromLatin1(event.name)))
+				.arg(microseconds(event.start))
+				.arg(microseconds(event.duration))
+				.arg(pid)
+				.arg(buffer->tid));
+		}
+	}
+
+	return QString("{\n\t\"displayTimeUnit\": \"ms\",\n\t\"traceEvents\": [\n%1\n\t]\n}\n").arg(events.join(",\n")).toUtf8();
+}
+
+#ifdef EDB_TRACING
+//------------------------------------------------------------------------------
+// Name: Span
+// Desc:
+//------------------------------------------------------------------------------
+Span::Span(const char *name) : name_(name), start_(edb::diagnostics::nsecs()) {
+}
+
+//------------------------------------------------------------------------------
+// Name: ~Span
+// Desc:
+//------------------------------------------------------------------------------
+Span::~Span() {
+	record(name_, start_, edb::diagnostics::nsecs());
+}
+#endif
+
+}
+}
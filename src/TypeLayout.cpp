@@ -0,0 +1,906 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "TypeLayout.h"
+#include "edb.h"
+
+#include <QChar>
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+typedef TypeLayout::Type         Type;
+typedef TypeLayout::type_pointer type_pointer;
+
+struct Token {
+	QString text;
+	int     line;
+};
+
+// the widest string shown
+const quint64 max_string_length = 256;
+
+//------------------------------------------------------------------------------
+// Name: align_up
+// Desc:
+//------------------------------------------------------------------------------
+quint64 align_up(quint64 value, quint64 alignment) {
+	return alignment > 1 ? (value + alignment - 1) / alignment * alignment : value;
+}
+
+//------------------------------------------------------------------------------
+// Name: make_type
+// Desc:
+//------------------------------------------------------------------------------
+type_pointer make_type(Type::Kind kind, const QString &name, quint64 size) {
+	const type_pointer type(new Type);
+	type->kind      = kind;
+	type->name      = name;
+	type->size      = size;
+	type->alignment = size ? size : 1;
+	return type;
+}
+
+//------------------------------------------------------------------------------
+// Name: long_size
+// Desc: long is as wide as a pointer, except on windows
+//------------------------------------------------------------------------------
+quint64 long_size() {
+#if defined(Q_OS_WIN)
+	return 4;
+#else
+	return edb::v1::pointer_size();
+#endif
+}
+
+//------------------------------------------------------------------------------
+// Name: builtin_type
+// Desc: the fixed width types of stdint.h and friends
+//------------------------------------------------------------------------------
+type_pointer builtin_type(const QString &name) {
+
+	static const struct {
+		const char *name;
+		Type::Kind  kind;
+		int         size;   // 0 for the size of a pointer
+	} builtins[] = {
+		{ "int8_t",    Type::SIGNED,   1 },
+		{ "int16_t",   Type::SIGNED,   2 },
+		{ "int32_t",   Type::SIGNED,   4 },
+		{ "int64_t",   Type::SIGNED,   8 },
+		{ "uint8_t",   Type::UNSIGNED, 1 },
+		{ "uint16_t",  Type::UNSIGNED, 2 },
+		{ "uint32_t",  Type::UNSIGNED, 4 },
+		{ "uint64_t",  Type::UNSIGNED, 8 },
+		{ "bool",      Type::UNSIGNED, 1 },
+		{ "_Bool",     Type::UNSIGNED, 1 },
+		{ "float",     Type::FLOAT,    4 },
+		{ "double",    Type::FLOAT,    8 },
+		{ "size_t",    Type::UNSIGNED, 0 },
+		{ "ssize_t",   Type::SIGNED,   0 },
+		{ "intptr_t",  Type::SIGNED,   0 },
+		{ "uintptr_t", Type::UNSIGNED, 0 },
+		{ "ptrdiff_t", Type::SIGNED,   0 },
+		{ "off_t",     Type::SIGNED,   8 },
+		{ "pid_t",     Type::SIGNED,   4 },
+		{ "uid_t",     Type::UNSIGNED, 4 },
+		{ "gid_t",     Type::UNSIGNED, 4 },
+	};
+
+	for(size_t i = 0; i < sizeof(builtins) / sizeof(builtins[0]); ++i) {
+		if(name == builtins[i].name) {
+			const quint64 size = builtins[i].size ? builtins[i].size : edb::v1::pointer_size();
+			return make_type(builtins[i].kind, name, size);
+		}
+	}
+
+	if(name == "void") {
+		type_pointer type = make_type(Type::UNSIGNED, name, 0);
+		type->complete = false;
+		return type;
+	}
+
+	return type_pointer();
+}
+
+//------------------------------------------------------------------------------
+// Name: integer_type
+// Desc: the type named by a run of the keywords of the integer types, like
+//       "unsigned long int"
+//------------------------------------------------------------------------------
+type_pointer integer_type(const QStringList &words) {
+
+	const bool is_unsigned = words.contains("unsigned");
+	const int  longs       = words.count("long");
+
+	if(words.contains("char")) {
+		if(is_unsigned) {
+			return make_type(Type::UNSIGNED, "unsigned char", 1);
+		} else if(words.contains("signed")) {
+			return make_type(Type::SIGNED, "signed char", 1);
+		}
+		return make_type(Type::CHAR, "char", 1);
+	}
+
+	if(words.contains("double")) {
+		return make_type(Type::FLOAT, longs ? "long double" : "double", longs ? 16 : 8);
+	}
+
+	quint64 size;
+	QString name;
+	if(words.contains("short")) {
+		size = 2;
+		name = "short";
+	} else if(longs >= 2) {
+		size = 8;
+		name = "long long";
+	} else if(longs == 1) {
+		size = long_size();
+		name = "long";
+	} else {
+		size = 4;
+		name = "int";
+	}
+
+	return make_type(is_unsigned ? Type::UNSIGNED : Type::SIGNED, is_unsigned ? "unsigned " + name : name, size);
+}
+
+//------------------------------------------------------------------------------
+// Name: is_integer_word
+// Desc:
+//------------------------------------------------------------------------------
+bool is_integer_word(const QString &word) {
+	static const char *const words[] = { "signed", "unsigned", "short", "long", "int", "char", "double" };
+
+	for(size_t i = 0; i < sizeof(words) / sizeof(words[0]); ++i) {
+		if(word == words[i]) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+//------------------------------------------------------------------------------
+// Name: is_integer_name
+// Desc: true for names like "unsigned long"
+//------------------------------------------------------------------------------
+bool is_integer_name(const QString &name) {
+	const QStringList words = name.split(' ', QString::SkipEmptyParts);
+	if(words.isEmpty()) {
+		return false;
+	}
+
+	Q_FOREACH(const QString &word, words) {
+		if(!is_integer_word(word)) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+//------------------------------------------------------------------------------
+// Name: tokenize
+// Desc: comments and preprocessor lines are left out
+//------------------------------------------------------------------------------
+QVector<Token> tokenize(const QString &source) {
+
+	QVector<Token> tokens;
+	int line = 1;
+	int i    = 0;
+
+	while(i < source.size()) {
+		const QChar ch = source[i];
+
+		if(ch == '\n') {
+			++line;
+			++i;
+		} else if(ch.isSpace()) {
+			++i;
+		} else if(ch == '#' || source.midRef(i, 2) == QLatin1String("//")) {
+			while(i < source.size() && source[i] != '\n') {
+				++i;
+			}
+		} else if(source.midRef(i, 2) == QLatin1String("/*")) {
+			const int end = source.indexOf("*/", i + 2);
+			const int stop = (end == -1) ? source.size() : end + 2;
+			line += source.mid(i, stop - i).count('\n');
+			i = stop;
+		} else if(ch.isLetterOrNumber() || ch == '_') {
+			const int start = i;
+			while(i < source.size() && (source[i].isLetterOrNumber() || source[i] == '_')) {
+				++i;
+			}
+			Token token = { source.mid(start, i - start), line };
+			tokens.push_back(token);
+		} else {
+			Token token = { QString(ch), line };
+			tokens.push_back(token);
+			++i;
+		}
+	}
+
+	return tokens;
+}
+
+// a recursive descent parser of just enough of C to define structures, with
+// each top level declaration which it can't make sense of skipped
+class Parser {
+public:
+	Parser(const QVector<Token> &tokens, QHash<QString, type_pointer> *types, QStringList *errors) : tokens_(tokens), types_(types), errors_(errors), pos_(0), failed_(false) {
+	}
+
+public:
+	bool parse() {
+		bool ok = true;
+		while(!at_end()) {
+			failed_ = false;
+			parse_statement();
+			if(failed_) {
+				ok = false;
+				skip_statement();
+			}
+		}
+		return ok;
+	}
+
+private:
+	bool at_end() const {
+		return pos_ >= tokens_.size();
+	}
+
+	QString peek(int ahead = 0) const {
+		return (pos_ + ahead < tokens_.size()) ? tokens_[pos_ + ahead].text : QString();
+	}
+
+	bool accept(const char *text) {
+		if(!at_end() && tokens_[pos_].text == text) {
+			++pos_;
+			return true;
+		}
+		return false;
+	}
+
+	bool expect(const char *text) {
+		if(accept(text)) {
+			return true;
+		}
+		fail(QString("expected '%1'").arg(text));
+		return false;
+	}
+
+	void fail(const QString &message) {
+		if(!failed_) {
+			const int line = at_end() ? (tokens_.isEmpty() ? 1 : tokens_.back().line) : tokens_[pos_].line;
+			errors_->push_back(QString("line %1: %2").arg(line).arg(message));
+			failed_ = true;
+		}
+	}
+
+	// up to and including the next ';' which isn't inside braces
+	void skip_statement() {
+		int depth = 0;
+		while(!at_end()) {
+			const QString &text = tokens_[pos_++].text;
+			if(text == "{") {
+				++depth;
+			} else if(text == "}") {
+				--depth;
+			} else if(text == ";" && depth <= 0) {
+				return;
+			}
+		}
+	}
+
+	static bool is_identifier(const QString &text) {
+		return !text.isEmpty() && (text[0].isLetter() || text[0] == '_');
+	}
+
+	void skip_qualifiers() {
+		while(accept("const") || accept("volatile") || accept("static") || accept("extern") || accept("register")) {
+		}
+	}
+
+private:
+	void parse_statement() {
+
+		if(accept(";")) {
+			return;
+		}
+
+		const bool is_typedef = accept("typedef");
+
+		const type_pointer base = parse_base_type();
+		if(failed_) {
+			return;
+		}
+
+		if(accept(";")) {
+			return;
+		}
+
+		do {
+			QString      name;
+			type_pointer type;
+			if(!parse_declarator(base, &name, &type)) {
+				return;
+			}
+
+			// variables are of no interest, only the types
+			if(is_typedef) {
+				types_->insert(name, type);
+			}
+		} while(accept(","));
+
+		expect(";");
+	}
+
+	type_pointer parse_base_type() {
+
+		skip_qualifiers();
+
+		if(accept("struct")) {
+			return parse_record(Type::STRUCT, "struct");
+		} else if(accept("union")) {
+			return parse_record(Type::UNION, "union");
+		} else if(accept("enum")) {
+			return parse_enum();
+		}
+
+		QStringList words;
+		while(is_integer_word(peek())) {
+			words.push_back(peek());
+			++pos_;
+			skip_qualifiers();
+		}
+
+		type_pointer type;
+		if(!words.isEmpty()) {
+			type = integer_type(words);
+		} else {
+			const QString name = peek();
+			if(!is_identifier(name)) {
+				fail(QString("expected a type, not '%1'").arg(name));
+				return type_pointer();
+			}
+
+			type = types_->value(name);
+			if(!type) {
+				type = builtin_type(name);
+			}
+
+			if(!type) {
+				fail(QString("unknown type '%1'").arg(name));
+				return type_pointer();
+			}
+
+			++pos_;
+		}
+
+		skip_qualifiers();
+		return type;
+	}
+
+	type_pointer parse_enum() {
+
+		if(is_identifier(peek())) {
+			++pos_;
+		}
+
+		// the values don't matter, only that it is an int
+		if(accept("{")) {
+			while(!at_end() && !accept("}")) {
+				++pos_;
+			}
+		}
+
+		skip_qualifiers();
+		return make_type(Type::SIGNED, "int", 4);
+	}
+
+	type_pointer parse_record(Type::Kind kind, const QString &keyword) {
+
+		QString name;
+		if(is_identifier(peek())) {
+			name = keyword + ' ' + peek();
+			++pos_;
+		}
+
+		if(peek() != "{") {
+			if(name.isEmpty()) {
+				fail(QString("expected a name or '{' after '%1'").arg(keyword));
+				return type_pointer();
+			}
+
+			// a declaration of one which is defined later, or not at all,
+			// which is enough to point at it
+			type_pointer type = types_->value(name);
+			if(!type) {
+				type = make_type(kind, name, 0);
+				type->complete = false;
+				types_->insert(name, type);
+			}
+
+			skip_qualifiers();
+			return type;
+		}
+
+		++pos_;
+
+		// a definition fills in the declaration, so that what already points
+		// at it sees the members
+		type_pointer type = name.isEmpty() ? type_pointer() : types_->value(name);
+		if(!type || type->complete) {
+			type = make_type(kind, name.isEmpty() ? keyword + " <anonymous>" : name, 0);
+		}
+
+		// it is known by its name from here on, so that its members can
+		// point at it, but it can't contain itself
+		type->complete = false;
+		if(!name.isEmpty()) {
+			types_->insert(name, type);
+		}
+
+		QVector<TypeLayout::Field> fields;
+		while(!accept("}")) {
+			if(at_end()) {
+				fail("expected '}'");
+				return type_pointer();
+			}
+
+			const type_pointer base = parse_base_type();
+			if(failed_) {
+				return type_pointer();
+			}
+
+			// the members of an anonymous struct or union belong to this one
+			if(accept(";")) {
+				if(base->kind == Type::STRUCT || base->kind == Type::UNION) {
+					TypeLayout::Field field;
+					field.offset = 0;
+					field.type   = base;
+					fields.push_back(field);
+				}
+				continue;
+			}
+
+			do {
+				TypeLayout::Field field;
+				field.offset = 0;
+				if(!parse_declarator(base, &field.name, &field.type)) {
+					return type_pointer();
+				}
+
+				if(!field.type->complete) {
+					fail(QString("'%1' has the incomplete type '%2'").arg(field.name, field.type->name));
+					return type_pointer();
+				}
+
+				fields.push_back(field);
+			} while(accept(","));
+
+			if(!expect(";")) {
+				return type_pointer();
+			}
+		}
+
+		quint64 offset    = 0;
+		quint64 size      = 0;
+		quint64 alignment = 1;
+		for(int i = 0; i < fields.size(); ++i) {
+			const type_pointer &field_type = fields[i].type;
+			alignment = qMax(alignment, field_type->alignment);
+
+			if(kind == Type::UNION) {
+				size = qMax(size, field_type->size);
+			} else {
+				offset           = align_up(offset, field_type->alignment);
+				fields[i].offset = offset;
+				offset          += field_type->size;
+				size             = offset;
+			}
+		}
+
+		type->fields    = fields;
+		type->alignment = alignment;
+		type->size      = align_up(size, alignment);
+		type->complete  = true;
+
+		skip_qualifiers();
+		return type;
+	}
+
+	bool parse_declarator(const type_pointer &base, QString *name, type_pointer *type) {
+
+		type_pointer t = base;
+		while(accept("*")) {
+			t = TypeLayout::pointer_to(t);
+			skip_qualifiers();
+		}
+
+		// a pointer to a function, which is only shown as a pointer
+		if(accept("(")) {
+			if(!expect("*")) {
+				return false;
+			}
+
+			*name = peek();
+			if(!is_identifier(*name)) {
+				fail("expected the name of a function pointer");
+				return false;
+			}
+			++pos_;
+
+			if(!expect(")") || !expect("(")) {
+				return false;
+			}
+
+			for(int depth = 1; depth > 0; ++pos_) {
+				if(at_end()) {
+					fail("expected ')'");
+					return false;
+				}
+
+				if(peek() == "(") {
+					++depth;
+				} else if(peek() == ")") {
+					--depth;
+				}
+			}
+
+			*type = TypeLayout::pointer_to(builtin_type("void"));
+			return true;
+		}
+
+		*name = peek();
+		if(!is_identifier(*name)) {
+			fail(QString("expected a name, not '%1'").arg(*name));
+			return false;
+		}
+		++pos_;
+
+		QVector<quint64> dimensions;
+		while(accept("[")) {
+			bool ok;
+			const QString text = peek();
+			const quint64 count = text.toULongLong(&ok, 0);
+			if(!ok) {
+				fail(QString("expected the size of an array, not '%1'").arg(text));
+				return false;
+			}
+			++pos_;
+
+			if(!expect("]")) {
+				return false;
+			}
+
+			dimensions.push_back(count);
+		}
+
+		if(peek() == ":") {
+			fail("bit-fields aren't supported");
+			return false;
+		}
+
+		// int a[2][3] is two arrays of three ints
+		for(int i = dimensions.size() - 1; i >= 0; --i) {
+			t = TypeLayout::array_of(t, dimensions[i]);
+		}
+
+		*type = t;
+		return true;
+	}
+
+private:
+	const QVector<Token>         &tokens_;
+	QHash<QString, type_pointer> *types_;
+	QStringList                  *errors_;
+	int                           pos_;
+	bool                          failed_;
+};
+
+//------------------------------------------------------------------------------
+// Name: read_integer
+// Desc:
+//------------------------------------------------------------------------------
+template <class T>
+T read_integer(const void *bytes) {
+	T value;
+	std::memcpy(&value, bytes, sizeof(value));
+	return value;
+}
+
+//------------------------------------------------------------------------------
+// Name: field_less
+// Desc:
+//------------------------------------------------------------------------------
+bool field_less(quint64 offset, const TypeLayout::Field &field) {
+	return offset < field.offset;
+}
+
+}
+
+//------------------------------------------------------------------------------
+// Name: parse
+// Desc:
+//------------------------------------------------------------------------------
+bool TypeLayout::parse(const QString &source, QStringList *errors) {
+
+	Q_ASSERT(errors);
+
+	const QVector<Token> tokens = tokenize(source);
+	Parser parser(tokens, &types_, errors);
+	return parser.parse();
+}
+
+//------------------------------------------------------------------------------
+// Name: clear
+// Desc:
+//------------------------------------------------------------------------------
+void TypeLayout::clear() {
+	types_.clear();
+}
+
+//------------------------------------------------------------------------------
+// Name: find
+// Desc: the name may be followed by any number of '*' and one "[count]"
+//------------------------------------------------------------------------------
+TypeLayout::type_pointer TypeLayout::find(const QString &name) const {
+
+	QString base = name.trimmed();
+
+	quint64 count = 0;
+	if(base.endsWith(']')) {
+		const int open = base.lastIndexOf('[');
+		if(open == -1) {
+			return type_pointer();
+		}
+
+		bool ok;
+		count = base.mid(open + 1, base.size() - open - 2).trimmed().toULongLong(&ok, 0);
+		if(!ok || count == 0) {
+			return type_pointer();
+		}
+		base = base.left(open).trimmed();
+	}
+
+	int pointers = 0;
+	while(base.endsWith('*')) {
+		++pointers;
+		base = base.left(base.size() - 1).trimmed();
+	}
+
+	type_pointer type = types_.value(base);
+	if(!type) {
+		type = types_.value("struct " + base);
+	}
+	if(!type) {
+		type = types_.value("union " + base);
+	}
+	if(!type) {
+		type = builtin_type(base);
+	}
+	if(!type && is_integer_name(base)) {
+		type = integer_type(base.split(' ', QString::SkipEmptyParts));
+	}
+	if(!type) {
+		return type_pointer();
+	}
+
+	for(int i = 0; i < pointers; ++i) {
+		type = pointer_to(type);
+	}
+
+	if(count) {
+		if(!type->complete) {
+			return type_pointer();
+		}
+		type = array_of(type, count);
+	}
+
+	return type;
+}
+
+//------------------------------------------------------------------------------
+// Name: names
+// Desc:
+//------------------------------------------------------------------------------
+QStringList TypeLayout::names() const {
+	QStringList names;
+	for(QHash<QString, type_pointer>::const_iterator it = types_.begin(); it != types_.end(); ++it) {
+		if(it.value()->complete) {
+			names.push_back(it.key());
+		}
+	}
+
+	names.sort();
+	return names;
+}
+
+//------------------------------------------------------------------------------
+// Name: pointer_to
+// Desc:
+//------------------------------------------------------------------------------
+TypeLayout::type_pointer TypeLayout::pointer_to(const type_pointer &type) {
+	const type_pointer pointer = make_type(Type::POINTER, type->name + " *", edb::v1::pointer_size());
+	pointer->element = type;
+	return pointer;
+}
+
+//------------------------------------------------------------------------------
+// Name: array_of
+// Desc:
+//------------------------------------------------------------------------------
+TypeLayout::type_pointer TypeLayout::array_of(const type_pointer &type, quint64 count) {
+	const type_pointer array = make_type(Type::ARRAY, QString("%1[%2]").arg(type->name).arg(count), type->size * count);
+	array->element   = type;
+	array->count     = count;
+	array->alignment = type->alignment;
+	return array;
+}
+
+//------------------------------------------------------------------------------
+// Name: is_leaf
+// Desc:
+//------------------------------------------------------------------------------
+bool TypeLayout::is_leaf(const type_pointer &type) {
+	switch(type->kind) {
+	case Type::STRUCT:
+	case Type::UNION:
+		return false;
+	case Type::ARRAY:
+		return type->element->kind == Type::CHAR;
+	default:
+		return true;
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: locate
+// Desc: an array is stepped into by dividing, a struct by a binary search of
+//       its fields, so nothing is ever enumerated. The first member of a
+//       union is the one which is found
+//------------------------------------------------------------------------------
+bool TypeLayout::locate(const type_pointer &type, quint64 offset, Location *location) {
+
+	Q_ASSERT(location);
+
+	location->path.clear();
+	location->type   = type;
+	location->offset = 0;
+
+	if(offset >= type->size) {
+		return false;
+	}
+
+	while(!is_leaf(location->type)) {
+		const type_pointer current = location->type;
+
+		if(current->kind == Type::ARRAY) {
+			const quint64 element_size = current->element->size;
+			if(element_size == 0) {
+				return false;
+			}
+
+			const quint64 index = offset / element_size;
+			location->path   += QString("[%1]").arg(index);
+			location->offset += index * element_size;
+			location->type    = current->element;
+			offset           -= index * element_size;
+			continue;
+		}
+
+		const QVector<Field> &fields = current->fields;
+		const Field *field = 0;
+		if(current->kind == Type::UNION) {
+			if(!fields.isEmpty()) {
+				field = &fields.front();
+			}
+		} else {
+			const Field *const it = std::upper_bound(fields.constBegin(), fields.constEnd(), offset, field_less);
+			if(it != fields.constBegin()) {
+				field = it - 1;
+			}
+		}
+
+		if(!field || offset - field->offset >= field->type->size) {
+			return false;
+		}
+
+		if(!field->name.isEmpty()) {
+			location->path += location->path.isEmpty() ? field->name : '.' + field->name;
+		}
+
+		location->offset += field->offset;
+		location->type    = field->type;
+		offset           -= field->offset;
+	}
+
+	return true;
+}
+
+//------------------------------------------------------------------------------
+// Name: format_value
+// Desc:
+//------------------------------------------------------------------------------
+QString TypeLayout::format_value(const type_pointer &type, const void *bytes, quint64 size) {
+
+	if(size < type->size && type->kind != Type::ARRAY) {
+		return QString();
+	}
+
+	switch(type->kind) {
+	case Type::SIGNED:
+		switch(type->size) {
+		case 1: return QString::number(read_integer<qint8>(bytes));
+		case 2: return QString::number(read_integer<qint16>(bytes));
+		case 4: return QString::number(read_integer<qint32>(bytes));
+		case 8: return QString::number(read_integer<qint64>(bytes));
+		}
+		break;
+	case Type::UNSIGNED:
+		switch(type->size) {
+		case 1: return QString::number(read_integer<quint8>(bytes));
+		case 2: return QString::number(read_integer<quint16>(bytes));
+		case 4: return QString::number(read_integer<quint32>(bytes));
+		case 8: return QString::number(read_integer<quint64>(bytes));
+		}
+		break;
+	case Type::CHAR:
+		{
+			const quint8 ch = read_integer<quint8>(bytes);
+			if(ch >= 0x20 && ch < 0x7f) {
+				return QString("%1 '%2'").arg(ch).arg(QChar(ch));
+			}
+			return QString::number(ch);
+		}
+	case Type::FLOAT:
+		switch(type->size) {
+		case 4: return QString::number(read_integer<float>(bytes));
+		case 8: return QString::number(read_integer<double>(bytes));
+		}
+		break;
+	case Type::POINTER:
+		if(type->size == 4) {
+			return edb::v1::format_pointer(read_integer<quint32>(bytes));
+		} else if(type->size == 8) {
+			return edb::v1::format_pointer(static_cast<edb::address_t>(read_integer<quint64>(bytes)));
+		}
+		break;
+	case Type::ARRAY:
+		if(type->element->kind == Type::CHAR) {
+			const char *const chars = static_cast<const char *>(bytes);
+			const quint64 length    = qMin(qMin(size, type->size), max_string_length);
+
+			QString s;
+			for(quint64 i = 0; i < length && chars[i] != '\0'; ++i) {
+				const quint8 ch = chars[i];
+				s += (ch >= 0x20 && ch < 0x7f) ? QString(QChar(ch)) : QString("\\x%1").arg(ch, 2, 16, QChar('0'));
+			}
+			return QString("\"%1\"").arg(s);
+		}
+		break;
+	default:
+		break;
+	}
+
+	return QString();
+}
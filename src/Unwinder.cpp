@@ -0,0 +1,964 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Unwinder.h"
+#include "IBinary.h"
+#include "IDebugger.h"
+#include "IProcess.h"
+#include "MemoryRegions.h"
+#include "State.h"
+#include "edb.h"
+
+#include <QScopedPointer>
+
+#include <cstring>
+
+namespace {
+
+enum {
+	DW_EH_PE_absptr  = 0x00,
+	DW_EH_PE_uleb128 = 0x01,
+	DW_EH_PE_udata2  = 0x02,
+	DW_EH_PE_udata4  = 0x03,
+	DW_EH_PE_udata8  = 0x04,
+	DW_EH_PE_sleb128 = 0x09,
+	DW_EH_PE_sdata2  = 0x0a,
+	DW_EH_PE_sdata4  = 0x0b,
+	DW_EH_PE_sdata8  = 0x0c,
+	DW_EH_PE_pcrel   = 0x10,
+	DW_EH_PE_datarel = 0x30,
+	DW_EH_PE_indirect = 0x80,
+	DW_EH_PE_omit    = 0xff
+};
+
+enum {
+	DW_CFA_advance_loc        = 0x40,
+	DW_CFA_offset             = 0x80,
+	DW_CFA_restore            = 0xc0,
+	DW_CFA_nop                = 0x00,
+	DW_CFA_set_loc            = 0x01,
+	DW_CFA_advance_loc1       = 0x02,
+	DW_CFA_advance_loc2       = 0x03,
+	DW_CFA_advance_loc4       = 0x04,
+	DW_CFA_offset_extended    = 0x05,
+	DW_CFA_restore_extended   = 0x06,
+	DW_CFA_undefined          = 0x07,
+	DW_CFA_same_value         = 0x08,
+	DW_CFA_register           = 0x09,
+	DW_CFA_remember_state     = 0x0a,
+	DW_CFA_restore_state      = 0x0b,
+	DW_CFA_def_cfa            = 0x0c,
+	DW_CFA_def_cfa_register   = 0x0d,
+	DW_CFA_def_cfa_offset     = 0x0e,
+	DW_CFA_def_cfa_expression = 0x0f,
+	DW_CFA_expression         = 0x10,
+	DW_CFA_offset_extended_sf = 0x11,
+	DW_CFA_def_cfa_sf         = 0x12,
+	DW_CFA_def_cfa_offset_sf  = 0x13,
+	DW_CFA_val_offset         = 0x14,
+	DW_CFA_val_offset_sf      = 0x15,
+	DW_CFA_val_expression     = 0x16,
+	DW_CFA_GNU_args_size      = 0x2e,
+	DW_CFA_GNU_negative_offset_extended = 0x2f
+};
+
+enum {
+	DW_OP_addr        = 0x03,
+	DW_OP_deref       = 0x06,
+	DW_OP_const1u     = 0x08,
+	DW_OP_const1s     = 0x09,
+	DW_OP_const2u     = 0x0a,
+	DW_OP_const2s     = 0x0b,
+	DW_OP_const4u     = 0x0c,
+	DW_OP_const4s     = 0x0d,
+	DW_OP_const8u     = 0x0e,
+	DW_OP_const8s     = 0x0f,
+	DW_OP_constu      = 0x10,
+	DW_OP_consts      = 0x11,
+	DW_OP_dup         = 0x12,
+	DW_OP_drop        = 0x13,
+	DW_OP_over        = 0x14,
+	DW_OP_swap        = 0x16,
+	DW_OP_and         = 0x1a,
+	DW_OP_minus       = 0x1c,
+	DW_OP_or          = 0x21,
+	DW_OP_plus        = 0x22,
+	DW_OP_plus_uconst = 0x23,
+	DW_OP_shl         = 0x24,
+	DW_OP_shr         = 0x25,
+	DW_OP_xor         = 0x27,
+	DW_OP_eq          = 0x29,
+	DW_OP_ge          = 0x2a,
+	DW_OP_gt          = 0x2b,
+	DW_OP_le          = 0x2c,
+	DW_OP_lt          = 0x2d,
+	DW_OP_ne          = 0x2e,
+	DW_OP_lit0        = 0x30,
+	DW_OP_lit31       = 0x4f,
+	DW_OP_reg0        = 0x50,
+	DW_OP_reg31       = 0x6f,
+	DW_OP_breg0       = 0x70,
+	DW_OP_breg31      = 0x8f,
+	DW_OP_nop         = 0x96
+};
+
+// no sane FDE or CIE is anywhere near this big
+const quint64 max_entry_size = 0x10000;
+
+//------------------------------------------------------------------------------
+// Name: to_signed
+// Desc:
+//------------------------------------------------------------------------------
+qint64 to_signed(edb::address_t value) {
+	return (sizeof(edb::address_t) == 4) ? static_cast<qint32>(value) : static_cast<qint64>(value);
+}
+
+//------------------------------------------------------------------------------
+// Name: read_pointer
+// Desc:
+//------------------------------------------------------------------------------
+bool read_pointer(edb::address_t address, edb::address_t *value) {
+	if(IProcess *process = edb::v1::debugger_core->process()) {
+		return process->read_bytes(address, value, sizeof(edb::address_t));
+	}
+	return false;
+}
+
+//------------------------------------------------------------------------------
+// Name: read_entry
+// Desc: reads a CIE or FDE, <body> is what follows its length and <address>
+//       where that is in the target
+//------------------------------------------------------------------------------
+bool read_entry(edb::address_t entry, QByteArray *body, edb::address_t *address) {
+
+	IProcess *const process = edb::v1::debugger_core->process();
+	if(!process) {
+		return false;
+	}
+
+	quint32 length;
+	if(!process->read_bytes(entry, &length, sizeof(length)) || length == 0xffffffff || length == 0 || length > max_entry_size) {
+		return false;
+	}
+
+	body->resize(length);
+	*address = entry + sizeof(length);
+	return process->read_bytes(*address, body->data(), length);
+}
+
+// reads the encodings .eh_frame uses out of a copy of the target's memory,
+// remembering where in the target each byte came from
+class Reader {
+public:
+	Reader(const QByteArray &data, edb::address_t address) : data_(data), address_(address), offset_(0), ok_(true) {
+	}
+
+public:
+	bool ok() const                { return ok_; }
+	bool at_end() const            { return offset_ >= data_.size(); }
+	edb::address_t address() const { return address_ + offset_; }
+
+	quint64 uint(int n) {
+		if(!ok_ || n > data_.size() - offset_) {
+			ok_ = false;
+			return 0;
+		}
+
+		quint64 value = 0;
+		for(int i = 0; i < n; ++i) {
+			value |= static_cast<quint64>(static_cast<quint8>(data_[offset_ + i])) << (i * 8);
+		}
+		offset_ += n;
+		return value;
+	}
+
+	qint64 sint(int n) {
+		const quint64 value = uint(n);
+		const int shift     = 64 - n * 8;
+		return shift ? static_cast<qint64>(value << shift) >> shift : static_cast<qint64>(value);
+	}
+
+	quint8 u8() { return uint(1); }
+
+	quint64 uleb() {
+		quint64 value = 0;
+		int shift     = 0;
+		while(ok_) {
+			const quint8 byte = u8();
+			if(shift < 64) {
+				value |= static_cast<quint64>(byte & 0x7f) << shift;
+			}
+			shift += 7;
+			if(!(byte & 0x80)) {
+				break;
+			}
+		}
+		return value;
+	}
+
+	qint64 sleb() {
+		quint64 value = 0;
+		int shift     = 0;
+		quint8 byte   = 0;
+		while(ok_) {
+			byte = u8();
+			if(shift < 64) {
+				value |= static_cast<quint64>(byte & 0x7f) << shift;
+			}
+			shift += 7;
+			if(!(byte & 0x80)) {
+				break;
+			}
+		}
+		if(shift < 64 && (byte & 0x40)) {
+			value |= ~static_cast<quint64>(0) << shift;
+		}
+		return static_cast<qint64>(value);
+	}
+
+	QByteArray cstr() {
+		const int nul = data_.indexOf('\0', offset_);
+		if(!ok_ || nul == -1) {
+			ok_ = false;
+			return QByteArray();
+		}
+		const QByteArray s = data_.mid(offset_, nul - offset_);
+		offset_ = nul + 1;
+		return s;
+	}
+
+	QByteArray block(quint64 size) {
+		if(!ok_ || size > static_cast<quint64>(data_.size() - offset_)) {
+			ok_ = false;
+			return QByteArray();
+		}
+		const QByteArray b = data_.mid(offset_, size);
+		offset_ += size;
+		return b;
+	}
+
+	QByteArray rest() {
+		return block(data_.size() - offset_);
+	}
+
+	void skip(quint64 size) {
+		block(size);
+	}
+
+	// decodes a DW_EH_PE_* encoded pointer
+	edb::address_t pointer(quint8 encoding, edb::address_t data_base) {
+
+		if(encoding == DW_EH_PE_omit) {
+			return 0;
+		}
+
+		const edb::address_t field = address();
+
+		quint64 value = 0;
+		switch(encoding & 0x0f) {
+		case DW_EH_PE_absptr:  value = uint(sizeof(edb::address_t)); break;
+		case DW_EH_PE_uleb128: value = uleb(); break;
+		case DW_EH_PE_udata2:  value = uint(2); break;
+		case DW_EH_PE_udata4:  value = uint(4); break;
+		case DW_EH_PE_udata8:  value = uint(8); break;
+		case DW_EH_PE_sleb128: value = sleb(); break;
+		case DW_EH_PE_sdata2:  value = sint(2); break;
+		case DW_EH_PE_sdata4:  value = sint(4); break;
+		case DW_EH_PE_sdata8:  value = sint(8); break;
+		default:
+			ok_ = false;
+			return 0;
+		}
+
+		switch(encoding & 0x70) {
+		case 0:                                  break;
+		case DW_EH_PE_pcrel:   value += field;     break;
+		case DW_EH_PE_datarel: value += data_base; break;
+		default:
+			ok_ = false;
+			return 0;
+		}
+
+		edb::address_t result = static_cast<edb::address_t>(value);
+		if(encoding & DW_EH_PE_indirect) {
+			ok_ = ok_ && read_pointer(result, &result);
+		}
+		return result;
+	}
+
+private:
+	QByteArray     data_;
+	edb::address_t address_;
+	int            offset_;
+	bool           ok_;
+};
+
+}
+
+//------------------------------------------------------------------------------
+// Name: Registers
+// Desc:
+//------------------------------------------------------------------------------
+Unwinder::Registers::Registers() {
+	for(int i = 0; i < REGISTER_COUNT; ++i) {
+		value[i] = 0;
+		valid[i] = false;
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: Unwinder
+// Desc:
+//------------------------------------------------------------------------------
+Unwinder::Unwinder() : pid_(0) {
+}
+
+//------------------------------------------------------------------------------
+// Name: instance
+// Desc:
+//------------------------------------------------------------------------------
+Unwinder &Unwinder::instance() {
+	static Unwinder unwinder;
+	return unwinder;
+}
+
+//------------------------------------------------------------------------------
+// Name: registers
+// Desc: the registers of a thread, in DWARF order
+//------------------------------------------------------------------------------
+Unwinder::Registers Unwinder::registers(const State &state) {
+
+#if defined(EDB_X86_64)
+	static const char *const names[REGISTER_COUNT] = {
+		"rax", "rdx", "rcx", "rbx", "rsi", "rdi", "rbp", "rsp",
+		"r8",  "r9",  "r10", "r11", "r12", "r13", "r14", "r15",
+		"rip"
+	};
+#else
+	static const char *const names[REGISTER_COUNT] = {
+		"eax", "ecx", "edx", "ebx", "esp", "ebp", "esi", "edi",
+		"eip"
+	};
+#endif
+
+	Registers registers;
+	for(int i = 0; i < REGISTER_COUNT; ++i) {
+		if(const Register reg = state[names[i]]) {
+			registers.value[i] = reg.value<edb::reg_t>();
+			registers.valid[i] = true;
+		}
+	}
+	return registers;
+}
+
+//------------------------------------------------------------------------------
+// Name: check_process
+// Desc: everything cached belongs to one process
+//------------------------------------------------------------------------------
+void Unwinder::check_process() {
+	IProcess *const process = edb::v1::debugger_core->process();
+	const edb::pid_t pid    = process ? process->pid() : 0;
+	if(pid != pid_) {
+		modules_.clear();
+		cies_.clear();
+		pid_ = pid;
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: module_at
+// Desc: the module covering <address>, whose unwind table is loaded the first
+//       time any of its code is seen. Code outside of any file has none
+//------------------------------------------------------------------------------
+const Unwinder::Module *Unwinder::module_at(edb::address_t address) {
+
+	for(int i = 0; i < modules_.size(); ++i) {
+		if(address >= modules_[i].start && address < modules_[i].end) {
+			return &modules_[i];
+		}
+	}
+
+	const IRegion::pointer region = edb::v1::memory_regions().find_region(address);
+	if(!region || region->name().isEmpty()) {
+		return 0;
+	}
+
+	Module module;
+	module.start = region->start();
+	module.end   = region->end();
+
+	Q_FOREACH(const IRegion::pointer &r, edb::v1::memory_regions().regions()) {
+		if(region->name() == r->name()) {
+			module.start = qMin(module.start, r->start());
+			module.end   = qMax(module.end, r->end());
+		}
+	}
+
+	load_module(&module, region->name());
+	modules_.push_back(module);
+	return &modules_.last();
+}
+
+//------------------------------------------------------------------------------
+// Name: load_module
+// Desc: reads the binary search table of the module's .eh_frame_hdr
+//------------------------------------------------------------------------------
+void Unwinder::load_module(Module *module, const QString &name) {
+
+	IProcess *const process = edb::v1::debugger_core->process();
+	if(!process) {
+		return;
+	}
+
+	// the headers are in the module's first mapping
+	IRegion::pointer first;
+	Q_FOREACH(const IRegion::pointer &r, edb::v1::memory_regions().regions()) {
+		if(r->name() == name && r->start() == module->start) {
+			first = r;
+			break;
+		}
+	}
+
+	if(!first) {
+		return;
+	}
+
+	QScopedPointer<IBinary> binary(edb::v1::get_binary_info(first));
+	if(!binary) {
+		return;
+	}
+
+	const edb::address_t header = binary->eh_frame_header();
+	if(!header) {
+		return;
+	}
+
+	QByteArray data(4 + 8 + 8, '\0');
+	if(!process->read_bytes(header, data.data(), data.size())) {
+		return;
+	}
+
+	Reader reader(data, header);
+	const quint8 version        = reader.u8();
+	const quint8 frame_encoding = reader.u8();
+	const quint8 count_encoding = reader.u8();
+	const quint8 table_encoding = reader.u8();
+
+	reader.pointer(frame_encoding, header);
+	const edb::address_t count = reader.pointer(count_encoding, header);
+
+	// every linker writes the table as pairs of 4 byte offsets from the header
+	if(!reader.ok() || version != 1 || table_encoding != (DW_EH_PE_datarel | DW_EH_PE_sdata4) || count == 0 || count > 0x100000) {
+		return;
+	}
+
+	QVector<qint32> table(static_cast<int>(count * 2));
+	if(!process->read_bytes(reader.address(), table.data(), table.size() * sizeof(qint32))) {
+		return;
+	}
+
+	module->table.resize(count);
+	for(edb::address_t i = 0; i < count; ++i) {
+		module->table[i].location = header + table[i * 2];
+		module->table[i].fde      = header + table[i * 2 + 1];
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: cie_at
+// Desc: a parsed CIE, FDEs mostly share a handful of them
+//------------------------------------------------------------------------------
+const Unwinder::Cie *Unwinder::cie_at(edb::address_t address) {
+
+	QHash<edb::address_t, Cie>::const_iterator it = cies_.constFind(address);
+	if(it != cies_.constEnd()) {
+		return &it.value();
+	}
+
+	QByteArray body;
+	edb::address_t body_address;
+	if(!read_entry(address, &body, &body_address)) {
+		return 0;
+	}
+
+	Reader reader(body, body_address);
+
+	Cie cie;
+	cie.fde_encoding = DW_EH_PE_absptr;
+	cie.augmented    = false;
+
+	const quint32 id            = reader.uint(4);
+	const quint8 version        = reader.u8();
+	const QByteArray augmentation = reader.cstr();
+	if(id != 0 || !reader.ok()) {
+		return 0;
+	}
+
+	if(augmentation.contains("eh")) {
+		reader.skip(sizeof(edb::address_t));
+	}
+
+	cie.code_alignment  = reader.uleb();
+	cie.data_alignment  = reader.sleb();
+	cie.return_register = (version == 1) ? reader.u8() : reader.uleb();
+
+	if(augmentation.startsWith('z')) {
+		cie.augmented = true;
+
+		const quint64 length = reader.uleb();
+		Reader data(reader.block(length), reader.address() - length);
+
+		for(int i = 1; i < augmentation.size(); ++i) {
+			switch(augmentation[i]) {
+			case 'L':
+				data.u8();
+				break;
+			case 'P':
+				data.pointer(data.u8(), 0);
+				break;
+			case 'R':
+				cie.fde_encoding = data.u8();
+				break;
+			default:
+				break;
+			}
+		}
+	}
+
+	cie.instructions_address = reader.address();
+	cie.instructions         = reader.rest();
+
+	if(!reader.ok() || cie.return_register >= REGISTER_COUNT) {
+		return 0;
+	}
+
+	return &cies_.insert(address, cie).value();
+}
+
+//------------------------------------------------------------------------------
+// Name: execute
+// Desc: runs call frame instructions, starting with <row>, until they move
+//       past <pc>
+//------------------------------------------------------------------------------
+bool Unwinder::execute(const QByteArray &instructions, edb::address_t instructions_address, const Cie &cie, edb::address_t location, edb::address_t pc, const Row &initial, Row *row) const {
+
+	Reader reader(instructions, instructions_address);
+	QVector<Row> remembered;
+
+	while(reader.ok() && !reader.at_end()) {
+
+		const quint8 opcode = reader.u8();
+
+		quint64 reg    = REGISTER_COUNT;
+		Rule rule;
+
+		switch(opcode & 0xc0) {
+		case DW_CFA_advance_loc:
+			location += (opcode & 0x3f) * cie.code_alignment;
+			if(location > pc) {
+				return true;
+			}
+			continue;
+		case DW_CFA_offset:
+			reg         = opcode & 0x3f;
+			rule.type   = Rule::OFFSET;
+			rule.offset = reader.uleb() * cie.data_alignment;
+			break;
+		case DW_CFA_restore:
+			reg  = opcode & 0x3f;
+			rule = initial.rules[qMin<quint64>(reg, REGISTER_COUNT - 1)];
+			break;
+		default:
+			switch(opcode) {
+			case DW_CFA_nop:
+				continue;
+			case DW_CFA_set_loc:
+				location = reader.pointer(cie.fde_encoding, 0);
+				if(location > pc) {
+					return true;
+				}
+				continue;
+			case DW_CFA_advance_loc1:
+			case DW_CFA_advance_loc2:
+			case DW_CFA_advance_loc4:
+				location += reader.uint(1 << (opcode - DW_CFA_advance_loc1)) * cie.code_alignment;
+				if(location > pc) {
+					return true;
+				}
+				continue;
+			case DW_CFA_offset_extended:
+				reg         = reader.uleb();
+				rule.type   = Rule::OFFSET;
+				rule.offset = reader.uleb() * cie.data_alignment;
+				break;
+			case DW_CFA_offset_extended_sf:
+				reg         = reader.uleb();
+				rule.type   = Rule::OFFSET;
+				rule.offset = reader.sleb() * cie.data_alignment;
+				break;
+			case DW_CFA_GNU_negative_offset_extended:
+				reg         = reader.uleb();
+				rule.type   = Rule::OFFSET;
+				rule.offset = -static_cast<qint64>(reader.uleb() * cie.data_alignment);
+				break;
+			case DW_CFA_val_offset:
+				reg         = reader.uleb();
+				rule.type   = Rule::VAL_OFFSET;
+				rule.offset = reader.uleb() * cie.data_alignment;
+				break;
+			case DW_CFA_val_offset_sf:
+				reg         = reader.uleb();
+				rule.type   = Rule::VAL_OFFSET;
+				rule.offset = reader.sleb() * cie.data_alignment;
+				break;
+			case DW_CFA_restore_extended:
+				reg  = reader.uleb();
+				rule = initial.rules[qMin<quint64>(reg, REGISTER_COUNT - 1)];
+				break;
+			case DW_CFA_undefined:
+				reg       = reader.uleb();
+				rule.type = Rule::UNDEFINED;
+				break;
+			case DW_CFA_same_value:
+				reg       = reader.uleb();
+				rule.type = Rule::SAME;
+				break;
+			case DW_CFA_register:
+				reg         = reader.uleb();
+				rule.type   = Rule::REGISTER;
+				rule.offset = reader.uleb();
+				break;
+			case DW_CFA_expression:
+				reg             = reader.uleb();
+				rule.type       = Rule::EXPRESSION;
+				rule.expression = reader.block(reader.uleb());
+				break;
+			case DW_CFA_val_expression:
+				reg             = reader.uleb();
+				rule.type       = Rule::VAL_EXPRESSION;
+				rule.expression = reader.block(reader.uleb());
+				break;
+			case DW_CFA_remember_state:
+				remembered.push_back(*row);
+				continue;
+			case DW_CFA_restore_state:
+				if(remembered.isEmpty()) {
+					return false;
+				}
+				*row = remembered.last();
+				remembered.pop_back();
+				continue;
+			case DW_CFA_def_cfa:
+				row->cfa_register = reader.uleb();
+				row->cfa_offset   = reader.uleb();
+				row->cfa_expression.clear();
+				continue;
+			case DW_CFA_def_cfa_sf:
+				row->cfa_register = reader.uleb();
+				row->cfa_offset   = reader.sleb() * cie.data_alignment;
+				row->cfa_expression.clear();
+				continue;
+			case DW_CFA_def_cfa_register:
+				row->cfa_register = reader.uleb();
+				row->cfa_expression.clear();
+				continue;
+			case DW_CFA_def_cfa_offset:
+				row->cfa_offset = reader.uleb();
+				continue;
+			case DW_CFA_def_cfa_offset_sf:
+				row->cfa_offset = reader.sleb() * cie.data_alignment;
+				continue;
+			case DW_CFA_def_cfa_expression:
+				row->cfa_expression = reader.block(reader.uleb());
+				continue;
+			case DW_CFA_GNU_args_size:
+				reader.uleb();
+				continue;
+			default:
+				return false;
+			}
+			break;
+		}
+
+		// rules for registers we don't track (the SSE ones, say) are dropped
+		if(reg < REGISTER_COUNT) {
+			row->rules[reg] = rule;
+		}
+	}
+
+	return reader.ok();
+}
+
+//------------------------------------------------------------------------------
+// Name: evaluate
+// Desc: runs the subset of DWARF expressions that unwind info actually uses,
+//       like the ones describing PLT entries
+//------------------------------------------------------------------------------
+bool Unwinder::evaluate(const QByteArray &expression, const Registers &registers, const edb::address_t *initial, edb::address_t *result) const {
+
+	Reader reader(expression, 0);
+	QVector<edb::address_t> stack;
+
+	if(initial) {
+		stack.push_back(*initial);
+	}
+
+	while(reader.ok() && !reader.at_end()) {
+
+		const quint8 opcode = reader.u8();
+
+		if(opcode >= DW_OP_lit0 && opcode <= DW_OP_lit31) {
+			stack.push_back(opcode - DW_OP_lit0);
+			continue;
+		}
+
+		if((opcode >= DW_OP_reg0 && opcode <= DW_OP_reg31) || (opcode >= DW_OP_breg0 && opcode <= DW_OP_breg31)) {
+			const bool base = opcode >= DW_OP_breg0;
+			const int reg   = opcode - (base ? DW_OP_breg0 : DW_OP_reg0);
+			if(reg >= REGISTER_COUNT || !registers.valid[reg]) {
+				return false;
+			}
+			stack.push_back(registers.value[reg] + (base ? reader.sleb() : 0));
+			continue;
+		}
+
+		switch(opcode) {
+		case DW_OP_addr:    stack.push_back(reader.uint(sizeof(edb::address_t))); continue;
+		case DW_OP_const1u: stack.push_back(reader.uint(1)); continue;
+		case DW_OP_const1s: stack.push_back(reader.sint(1)); continue;
+		case DW_OP_const2u: stack.push_back(reader.uint(2)); continue;
+		case DW_OP_const2s: stack.push_back(reader.sint(2)); continue;
+		case DW_OP_const4u: stack.push_back(reader.uint(4)); continue;
+		case DW_OP_const4s: stack.push_back(reader.sint(4)); continue;
+		case DW_OP_const8u: stack.push_back(reader.uint(8)); continue;
+		case DW_OP_const8s: stack.push_back(reader.sint(8)); continue;
+		case DW_OP_constu:  stack.push_back(reader.uleb()); continue;
+		case DW_OP_consts:  stack.push_back(reader.sleb()); continue;
+		case DW_OP_nop:     continue;
+		default:
+			break;
+		}
+
+		// everything else works on what's already on the stack
+		if(stack.isEmpty()) {
+			return false;
+		}
+
+		edb::address_t &top = stack.last();
+
+		switch(opcode) {
+		case DW_OP_deref:
+			if(!read_pointer(top, &top)) {
+				return false;
+			}
+			continue;
+		case DW_OP_dup:
+			stack.push_back(top);
+			continue;
+		case DW_OP_drop:
+			stack.pop_back();
+			continue;
+		case DW_OP_plus_uconst:
+			top += reader.uleb();
+			continue;
+		default:
+			break;
+		}
+
+		if(stack.size() < 2) {
+			return false;
+		}
+
+		const edb::address_t b = stack.last();
+		const edb::address_t a = stack[stack.size() - 2];
+
+		switch(opcode) {
+		case DW_OP_over:
+			stack.push_back(a);
+			continue;
+		case DW_OP_swap:
+			stack[stack.size() - 2] = b;
+			stack.last()            = a;
+			continue;
+		default:
+			break;
+		}
+
+		edb::address_t value;
+		switch(opcode) {
+		case DW_OP_and:   value = a & b; break;
+		case DW_OP_minus: value = a - b; break;
+		case DW_OP_or:    value = a | b; break;
+		case DW_OP_plus:  value = a + b; break;
+		case DW_OP_shl:   value = a << b; break;
+		case DW_OP_shr:   value = a >> b; break;
+		case DW_OP_xor:   value = a ^ b; break;
+		case DW_OP_eq:    value = a == b; break;
+		case DW_OP_ne:    value = a != b; break;
+		case DW_OP_ge:    value = to_signed(a) >= to_signed(b); break;
+		case DW_OP_gt:    value = to_signed(a) > to_signed(b); break;
+		case DW_OP_le:    value = to_signed(a) <= to_signed(b); break;
+		case DW_OP_lt:    value = to_signed(a) < to_signed(b); break;
+		default:
+			return false;
+		}
+
+		stack.pop_back();
+		stack.last() = value;
+	}
+
+	if(!reader.ok() || stack.isEmpty()) {
+		return false;
+	}
+
+	*result = stack.last();
+	return true;
+}
+
+//------------------------------------------------------------------------------
+// Name: step
+// Desc:
+//------------------------------------------------------------------------------
+bool Unwinder::step(Registers *registers, bool caller_frame) {
+
+	Q_ASSERT(registers);
+
+	check_process();
+
+	if(!registers->valid[REGISTER_IP]) {
+		return false;
+	}
+
+	// a return address is just past the call, which may be the last
+	// instruction of the function
+	const edb::address_t pc = registers->value[REGISTER_IP] - (caller_frame ? 1 : 0);
+
+	const Module *const module = module_at(pc);
+	if(!module || module->table.isEmpty()) {
+		return false;
+	}
+
+	// the last FDE which starts at or before pc
+	int first = 0;
+	int last  = module->table.size();
+	while(first < last) {
+		const int middle = first + (last - first) / 2;
+		if(module->table[middle].location <= pc) {
+			first = middle + 1;
+		} else {
+			last = middle;
+		}
+	}
+
+	if(first == 0) {
+		return false;
+	}
+
+	QByteArray body;
+	edb::address_t body_address;
+	if(!read_entry(module->table[first - 1].fde, &body, &body_address)) {
+		return false;
+	}
+
+	Reader reader(body, body_address);
+
+	const edb::address_t cie_pointer = reader.uint(4);
+	const Cie *const cie = cie_at(body_address - cie_pointer);
+	if(!cie) {
+		return false;
+	}
+
+	const edb::address_t start = reader.pointer(cie->fde_encoding, 0);
+	const edb::address_t range = reader.pointer(cie->fde_encoding & 0x0f, 0);
+	if(cie->augmented) {
+		reader.skip(reader.uleb());
+	}
+
+	const edb::address_t instructions_address = reader.address();
+	const QByteArray instructions             = reader.rest();
+
+	if(!reader.ok() || pc < start || pc - start >= range) {
+		return false;
+	}
+
+	Row initial;
+	if(!execute(cie->instructions, cie->instructions_address, *cie, 0, ~static_cast<edb::address_t>(0), initial, &initial)) {
+		return false;
+	}
+
+	Row row = initial;
+	if(!execute(instructions, instructions_address, *cie, start, pc, initial, &row)) {
+		return false;
+	}
+
+	edb::address_t cfa;
+	if(!row.cfa_expression.isEmpty()) {
+		if(!evaluate(row.cfa_expression, *registers, 0, &cfa)) {
+			return false;
+		}
+	} else {
+		if(row.cfa_register < 0 || row.cfa_register >= REGISTER_COUNT || !registers->valid[row.cfa_register]) {
+			return false;
+		}
+		cfa = registers->value[row.cfa_register] + row.cfa_offset;
+	}
+
+	Registers caller = *registers;
+	for(int i = 0; i < REGISTER_COUNT; ++i) {
+		const Rule &rule = row.rules[i];
+		edb::address_t address;
+
+		switch(rule.type) {
+		case Rule::SAME:
+			break;
+		case Rule::UNDEFINED:
+			caller.valid[i] = false;
+			break;
+		case Rule::OFFSET:
+			caller.valid[i] = read_pointer(cfa + rule.offset, &caller.value[i]);
+			break;
+		case Rule::VAL_OFFSET:
+			caller.value[i] = cfa + rule.offset;
+			caller.valid[i] = true;
+			break;
+		case Rule::REGISTER:
+			caller.valid[i] = rule.offset >= 0 && rule.offset < REGISTER_COUNT && registers->valid[rule.offset];
+			caller.value[i] = caller.valid[i] ? registers->value[rule.offset] : 0;
+			break;
+		case Rule::EXPRESSION:
+			caller.valid[i] = evaluate(rule.expression, *registers, &cfa, &address) && read_pointer(address, &caller.value[i]);
+			break;
+		case Rule::VAL_EXPRESSION:
+			caller.valid[i] = evaluate(rule.expression, *registers, &cfa, &caller.value[i]);
+			break;
+		}
+	}
+
+	// the outermost frame marks its return address as undefined
+	if(!caller.valid[cie->return_register] || caller.value[cie->return_register] == 0) {
+		return false;
+	}
+
+	caller.value[REGISTER_IP] = caller.value[cie->return_register];
+	caller.valid[REGISTER_IP] = true;
+	caller.value[REGISTER_SP] = cfa;
+	caller.valid[REGISTER_SP] = true;
+
+	*registers = caller;
+	return true;
+}
@@ -0,0 +1,139 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef UNWINDER_20261014_H_
+#define UNWINDER_20261014_H_
+
+#include "Types.h"
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QString>
+#include <QVector>
+
+class State;
+
+// walks the stack one frame at a time using the CFA rules in .eh_frame. The
+// unwind info is read straight out of the target's memory through each
+// module's .eh_frame_hdr, whose lookup table (and the CIEs) are kept for as
+// long as the process lives, so a frame costs a lookup and a few reads
+class Unwinder {
+public:
+	// registers are numbered the way DWARF numbers them
+#if defined(EDB_X86_64)
+	enum {
+		REGISTER_FP    = 6,
+		REGISTER_SP    = 7,
+		REGISTER_IP    = 16,
+		REGISTER_COUNT = 17
+	};
+#else
+	enum {
+		REGISTER_SP    = 4,
+		REGISTER_FP    = 5,
+		REGISTER_IP    = 8,
+		REGISTER_COUNT = 9
+	};
+#endif
+
+	struct Registers {
+		Registers();
+
+		edb::address_t value[REGISTER_COUNT];
+		bool           valid[REGISTER_COUNT];
+	};
+
+public:
+	Unwinder();
+
+public:
+	// the unwind tables outlive any one backtrace, so everything shares these
+	static Unwinder &instance();
+	static Registers registers(const State &state);
+
+public:
+	// turns <registers> into those of the calling frame. <caller_frame> says
+	// that the instruction pointer is a return address rather than where the
+	// thread stopped. Fails when there is no unwind info for the code or the
+	// outermost frame has been reached
+	bool step(Registers *registers, bool caller_frame);
+
+private:
+	struct TableEntry {
+		edb::address_t location;
+		edb::address_t fde;
+	};
+
+	struct Module {
+		edb::address_t      start;
+		edb::address_t      end;
+		QVector<TableEntry> table;
+	};
+
+	struct Cie {
+		quint64        code_alignment;
+		qint64         data_alignment;
+		int            return_register;
+		quint8         fde_encoding;
+		bool           augmented;
+		QByteArray     instructions;
+		edb::address_t instructions_address;
+	};
+
+	struct Rule {
+		enum Type {
+			SAME,
+			UNDEFINED,
+			OFFSET,
+			VAL_OFFSET,
+			REGISTER,
+			EXPRESSION,
+			VAL_EXPRESSION
+		};
+
+		Rule() : type(SAME), offset(0) {}
+
+		Type       type;
+		qint64     offset;
+		QByteArray expression;
+	};
+
+	struct Row {
+		Row() : cfa_register(REGISTER_SP), cfa_offset(0) {}
+
+		Rule       rules[REGISTER_COUNT];
+		int        cfa_register;
+		qint64     cfa_offset;
+		QByteArray cfa_expression;
+	};
+
+private:
+	void check_process();
+	const Module *module_at(edb::address_t address);
+	void load_module(Module *module, const QString &name);
+	const Cie *cie_at(edb::address_t address);
+	bool execute(const QByteArray &instructions, edb::address_t instructions_address, const Cie &cie, edb::address_t location, edb::address_t pc, const Row &initial, Row *row) const;
+	bool evaluate(const QByteArray &expression, const Registers &registers, const edb::address_t *initial, edb::address_t *result) const;
+
+private:
+	QList<Module>             modules_;
+	QHash<edb::address_t, Cie> cies_;
+	edb::pid_t                pid_;
+};
+
+#endif
@@ -20,7 +20,9 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "Configuration.h"
 #include "IDebugger.h"
 #include "Instruction.h"
+#include "InstructionCache.h"
 #include "Prototype.h"
+#include "PrototypeTables.h"
 #include "RegisterListWidget.h"
 #include "State.h"
 #include "Util.h"
@@ -29,14 +31,12 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <QApplication>
 #include <QDebug>
-#include <QDomDocument>
-#include <QFile>
 #include <QVector>
-#include <QXmlQuery>
 
 #include <boost/math/special_functions/fpclassify.hpp>
 #include <climits>
 #include <cmath>
+#include <cstring>
 
 #ifdef Q_OS_LINUX
 #include <asm/unistd.h>
@@ -277,14 +277,12 @@ void resolve_function_parameters(const State &state, const QString &symname, int
 		if(const edb::Prototype *const info = edb::v1::get_function_info(func_name)) {
 
 			QStringList arguments;
-			int i = 0;
-			Q_FOREACH(edb::Argument argument, info->arguments) {
+			for(int i = 0; i < info->argument_count; ++i) {
 
 				edb::reg_t arg;
 				process->read_bytes(state.stack_pointer() + i * sizeof(edb::reg_t) + offset, &arg, sizeof(arg));
 
-				arguments << format_argument(argument.type, arg);
-				++i;
+				arguments << format_argument(QString::fromLatin1(info->arguments[i].type), arg);
 			}
 
 			ret << QString("%1(%2)").arg(func_name, arguments.join(", "));
@@ -394,18 +392,72 @@ void analyze_jump(const State &state, const edb::Instruction &inst, QStringList
 	}
 }
 
+// the memory the analyses of an instruction look at, which is all fetched
+// with one batched read up front
+struct InstructionMemory {
+	edb::address_t return_address;
+	bool           return_ok;
+	edb::address_t operands[edb::Instruction::MAX_OPERANDS];
+	bool           operands_ok[edb::Instruction::MAX_OPERANDS];
+	quint8         nearby[255 + edb::Instruction::MAX_SIZE];    // the bytes from 128 before the instruction on
+	bool           nearby_ok;
+};
+
+//------------------------------------------------------------------------------
+// Name: read_instruction_memory
+// Desc: reads the top of the stack, the memory operands of <inst> and the
+//       bytes around it in one go
+//------------------------------------------------------------------------------
+void read_instruction_memory(IProcess *process, const State &state, const edb::Instruction &inst, InstructionMemory *memory) {
+
+	Q_ASSERT(process);
+	Q_ASSERT(memory);
+
+	QVector<IProcess::ReadRequest> requests;
+	int operand_requests[edb::Instruction::MAX_OPERANDS];
+
+	memory->return_address = 0;
+	memory->return_ok      = false;
+	requests.push_back(IProcess::ReadRequest(state.stack_pointer(), &memory->return_address, sizeof(memory->return_address)));
+
+	memory->nearby_ok = false;
+	requests.push_back(IProcess::ReadRequest(inst.rva() - 128, memory->nearby, sizeof(memory->nearby)));
+
+	for(int j = 0; j < edb::Instruction::MAX_OPERANDS; ++j) {
+		const edb::Operand &operand = inst.operands()[j];
+
+		memory->operands[j]    = 0;
+		memory->operands_ok[j] = false;
+		operand_requests[j]    = -1;
+
+		if(operand.valid() && operand.general_type() == edb::Operand::TYPE_EXPRESSION) {
+			operand_requests[j] = requests.size();
+			requests.push_back(IProcess::ReadRequest(get_effective_address(operand, state), &memory->operands[j], sizeof(memory->operands[j])));
+		}
+	}
+
+	const QVector<bool> results = process->read_batch(requests);
+
+	memory->return_ok = results[0];
+	memory->nearby_ok = results[1];
+	for(int j = 0; j < edb::Instruction::MAX_OPERANDS; ++j) {
+		if(operand_requests[j] != -1) {
+			memory->operands_ok[j] = results[operand_requests[j]];
+		}
+	}
+}
+
 //------------------------------------------------------------------------------
 // Name: analyze_return
 // Desc:
 //------------------------------------------------------------------------------
-void analyze_return(const State &state, const edb::Instruction &inst, QStringList &ret) {
-
+void analyze_return(const State &state, const edb::Instruction &inst, const InstructionMemory &memory, QStringList &ret) {
+	Q_UNUSED(state);
 	Q_UNUSED(inst);
 
-	if(IProcess *process = edb::v1::debugger_core->process()) {
-		edb::address_t return_address;
-		process->read_bytes(state.stack_pointer(), &return_address, sizeof(return_address));
-	
+	if(memory.return_ok) {
+		const edb::address_t return_address = memory.return_address;
+
 		const QString symname = edb::v1::find_function_symbol(return_address);
 		if(!symname.isEmpty()) {
 			ret << ArchProcessor::tr("return to %1 <%2>").arg(edb::v1::format_pointer(return_address)).arg(symname);
@@ -419,25 +471,48 @@ void analyze_return(const State &state, const edb::Instruction &inst, QStringLis
 // Name: analyze_call
 // Desc:
 //------------------------------------------------------------------------------
-void analyze_call(const State &state, const edb::Instruction &inst, QStringList &ret) {
+void analyze_call(const State &state, const edb::Instruction &inst, const InstructionMemory &memory, QStringList &ret) {
 
-	if(IProcess *process = edb::v1::debugger_core->process()) {
-		const edb::Operand &operand = inst.operands()[0];
+	const edb::Operand &operand = inst.operands()[0];
 
-		if(operand.valid()) {
+	if(operand.valid()) {
 
-			const edb::address_t effective_address = get_effective_address(operand, state);
-			const QString temp_operand             = QString::fromStdString(to_string(operand));
-			QString temp;
+		const edb::address_t effective_address = get_effective_address(operand, state);
+		const QString temp_operand             = QString::fromStdString(to_string(operand));
+		QString temp;
 
-			switch(operand.general_type()) {
-			case edb::Operand::TYPE_REL:
-			case edb::Operand::TYPE_REGISTER:
-				do {
+		switch(operand.general_type()) {
+		case edb::Operand::TYPE_REL:
+		case edb::Operand::TYPE_REGISTER:
+			do {
+				int offset;
+				const QString symname = edb::v1::find_function_symbol(effective_address, QString(), &offset);
+				if(!symname.isEmpty()) {
+					ret << QString("%1 = %2 <%3>").arg(temp_operand, edb::v1::format_pointer(effective_address), symname);
+
+					if(offset == 0) {
+						if(is_call(inst)) {
+							resolve_function_parameters(state, symname, 0, ret);
+						} else {
+							resolve_function_parameters(state, symname, 4, ret);
+						}
+					}
+
+				} else {
+					ret << QString("%1 = %2").arg(temp_operand, edb::v1::format_pointer(effective_address));
+				}
+			} while(0);
+			break;
+
+		case edb::Operand::TYPE_EXPRESSION:
+		default:
+			do {
+				if(memory.operands_ok[0]) {
+					const edb::address_t target = memory.operands[0];
 					int offset;
-					const QString symname = edb::v1::find_function_symbol(effective_address, QString(), &offset);
+					const QString symname = edb::v1::find_function_symbol(target, QString(), &offset);
 					if(!symname.isEmpty()) {
-						ret << QString("%1 = %2 <%3>").arg(temp_operand, edb::v1::format_pointer(effective_address), symname);
+						ret << QString("%1 = [%2] = %3 <%4>").arg(temp_operand, edb::v1::format_pointer(effective_address), edb::v1::format_pointer(target), symname);
 
 						if(offset == 0) {
 							if(is_call(inst)) {
@@ -448,40 +523,14 @@ void analyze_call(const State &state, const edb::Instruction &inst, QStringList
 						}
 
 					} else {
-						ret << QString("%1 = %2").arg(temp_operand, edb::v1::format_pointer(effective_address));
+						ret << QString("%1 = [%2] = %3").arg(temp_operand, edb::v1::format_pointer(effective_address), edb::v1::format_pointer(target));
 					}
-				} while(0);
-				break;
-
-			case edb::Operand::TYPE_EXPRESSION:
-			default:
-				do {
-					edb::address_t target;
-
-					if(process->read_bytes(effective_address, &target, sizeof(target))) {
-						int offset;
-						const QString symname = edb::v1::find_function_symbol(target, QString(), &offset);
-						if(!symname.isEmpty()) {
-							ret << QString("%1 = [%2] = %3 <%4>").arg(temp_operand, edb::v1::format_pointer(effective_address), edb::v1::format_pointer(target), symname);
-
-							if(offset == 0) {
-								if(is_call(inst)) {
-									resolve_function_parameters(state, symname, 0, ret);
-								} else {
-									resolve_function_parameters(state, symname, 4, ret);
-								}
-							}
-
-						} else {
-							ret << QString("%1 = [%2] = %3").arg(temp_operand, edb::v1::format_pointer(effective_address), edb::v1::format_pointer(target));
-						}
-					} else {
-						// could not read from the address
-						ret << QString("%1 = [%2] = ?").arg(temp_operand, edb::v1::format_pointer(effective_address));
-					}
-				} while(0);
-				break;
-			}
+				} else {
+					// could not read from the address
+					ret << QString("%1 = [%2] = ?").arg(temp_operand, edb::v1::format_pointer(effective_address));
+				}
+			} while(0);
+			break;
 		}
 	}
 }
@@ -490,53 +539,49 @@ void analyze_call(const State &state, const edb::Instruction &inst, QStringList
 // Name: analyze_operands
 // Desc:
 //------------------------------------------------------------------------------
-void analyze_operands(const State &state, const edb::Instruction &inst, QStringList &ret) {
+void analyze_operands(const State &state, const edb::Instruction &inst, const InstructionMemory &memory, QStringList &ret) {
 
-	Q_UNUSED(inst);
+	for(int j = 0; j < edb::Instruction::MAX_OPERANDS; ++j) {
 
-	if(IProcess *process = edb::v1::debugger_core->process()) {
-		for(int j = 0; j < edb::Instruction::MAX_OPERANDS; ++j) {
-
-			const edb::Operand &operand = inst.operands()[j];
-
-			if(operand.valid()) {
-
-				const QString temp_operand = QString::fromStdString(to_string(operand));
-
-				switch(operand.general_type()) {
-				case edb::Operand::TYPE_REL:
-				case edb::Operand::TYPE_REGISTER:
-					do {
-						const edb::address_t effective_address = get_effective_address(operand, state);
-						ret << QString("%1 = %2").arg(temp_operand).arg(edb::v1::format_pointer(effective_address));
-					} while(0);
-					break;
-				case edb::Operand::TYPE_EXPRESSION:
-					do {
-						const edb::address_t effective_address = get_effective_address(operand, state);
-						edb::address_t target;
-
-						if(process->read_bytes(effective_address, &target, sizeof(target))) {
-							switch(operand.complete_type()) {
-							case edb::Operand::TYPE_EXPRESSION8:
-								ret << QString("%1 = [%2] = 0x%3").arg(temp_operand).arg(edb::v1::format_pointer(effective_address)).arg(target & 0xff, 2, 16, QChar('0'));
-								break;
-							case edb::Operand::TYPE_EXPRESSION16:
-								ret << QString("%1 = [%2] = 0x%3").arg(temp_operand).arg(edb::v1::format_pointer(effective_address)).arg(target & 0xffff, 4, 16, QChar('0'));
-								break;
-							case edb::Operand::TYPE_EXPRESSION32:
-							default:
-								ret << QString("%1 = [%2] = 0x%3").arg(temp_operand).arg(edb::v1::format_pointer(effective_address)).arg(target & 0xffffffff, 8, 16, QChar('0'));
-								break;
-							}
-						} else {
-							ret << QString("%1 = [%2] = ?").arg(temp_operand).arg(edb::v1::format_pointer(effective_address));
+		const edb::Operand &operand = inst.operands()[j];
+
+		if(operand.valid()) {
+
+			const QString temp_operand = QString::fromStdString(to_string(operand));
+
+			switch(operand.general_type()) {
+			case edb::Operand::TYPE_REL:
+			case edb::Operand::TYPE_REGISTER:
+				do {
+					const edb::address_t effective_address = get_effective_address(operand, state);
+					ret << QString("%1 = %2").arg(temp_operand).arg(edb::v1::format_pointer(effective_address));
+				} while(0);
+				break;
+			case edb::Operand::TYPE_EXPRESSION:
+				do {
+					const edb::address_t effective_address = get_effective_address(operand, state);
+					const edb::address_t target            = memory.operands[j];
+
+					if(memory.operands_ok[j]) {
+						switch(operand.complete_type()) {
+						case edb::Operand::TYPE_EXPRESSION8:
+							ret << QString("%1 = [%2] = 0x%3").arg(temp_operand).arg(edb::v1::format_pointer(effective_address)).arg(target & 0xff, 2, 16, QChar('0'));
+							break;
+						case edb::Operand::TYPE_EXPRESSION16:
+							ret << QString("%1 = [%2] = 0x%3").arg(temp_operand).arg(edb::v1::format_pointer(effective_address)).arg(target & 0xffff, 4, 16, QChar('0'));
+							break;
+						case edb::Operand::TYPE_EXPRESSION32:
+						default:
+							ret << QString("%1 = [%2] = 0x%3").arg(temp_operand).arg(edb::v1::format_pointer(effective_address)).arg(target & 0xffffffff, 8, 16, QChar('0'));
+							break;
 						}
-					} while(0);
-					break;
-				default:
-					break;
-				}
+					} else {
+						ret << QString("%1 = [%2] = ?").arg(temp_operand).arg(edb::v1::format_pointer(effective_address));
+					}
+				} while(0);
+				break;
+			default:
+				break;
 			}
 		}
 	}
@@ -546,16 +591,21 @@ void analyze_operands(const State &state, const edb::Instruction &inst, QStringL
 // Name: analyze_jump_targets
 // Desc:
 //------------------------------------------------------------------------------
-void analyze_jump_targets(const edb::Instruction &inst, QStringList &ret) {
+void analyze_jump_targets(const edb::Instruction &inst, const InstructionMemory &memory, QStringList &ret) {
 	const edb::address_t address       = inst.rva();
 	const edb::address_t start_address = address - 128;
 	const edb::address_t end_address   = address + 127;
 
-	quint8 buffer[edb::Instruction::MAX_SIZE];
+	// the whole range is read at once and every candidate decoded out of it
+	const quint8 *const buffer = memory.nearby;
+	if(!memory.nearby_ok) {
+		return;
+	}
 
 	for(edb::address_t addr = start_address; addr < end_address; ++addr) {
-		if(const int sz = edb::v1::get_instruction_bytes(addr, buffer)) {
-			edb::Instruction inst(buffer, buffer + sz, addr, std::nothrow);
+		const quint8 *const p = buffer + (addr - start_address);
+		if(const InstructionCache::pointer decoded = edb::v1::instruction_cache().decode(addr, p, buffer + sizeof(memory.nearby))) {
+			const edb::Instruction &inst = *decoded;
 			if(is_jump(inst)) {
 				const edb::Operand &operand = inst.operands()[0];
 
@@ -581,51 +631,54 @@ void analyze_syscall(const State &state, const edb::Instruction &inst, QStringLi
 	Q_UNUSED(state);
 
 #ifdef Q_OS_LINUX
-	QString syscall_entry;
-	QDomDocument syscall_xml;
-	QFile file(":/debugger/xml/syscalls.xml");
-	if(file.open(QIODevice::ReadOnly | QIODevice::Text)) {
-
-		QXmlQuery query;
-		QString res;
-		query.setFocus(&file);
-		query.setQuery(QString("syscalls[@version='1.0']/linux[@arch='x86']/syscall[index=%1]").arg(state.gp_register(Eax).value<edb::reg_t>()));
-		if (query.isValid()) {
-			query.evaluateTo(&syscall_entry);
-		}
-		file.close();
-	}
-
-	if(!syscall_entry.isEmpty()) {
-		syscall_xml.setContent("" + syscall_entry + "");
-		QDomElement root = syscall_xml.documentElement();
+	const edb::reg_t number = state.gp_register(Eax).value<edb::reg_t>();
+	if(const edb::internal::Syscall *const syscall = edb::internal::find_syscall(edb::internal::syscalls_x86, edb::internal::syscalls_x86_count, number)) {
 
 		QStringList arguments;
 
-		for (QDomElement argument = root.firstChildElement("argument"); !argument.isNull(); argument = argument.nextSiblingElement("argument")) {
-			const QString argument_type     = argument.attribute("type");
-			const QString argument_register = argument.attribute("register");
-			arguments << format_argument(argument_type, state[argument_register].value<edb::reg_t>());
+		for(int i = 0; i < syscall->argument_count; ++i) {
+			const edb::internal::SyscallArgument &argument = syscall->arguments[i];
+			arguments << format_argument(QString::fromLatin1(argument.type), state[QString::fromLatin1(argument.register_name)].value<edb::reg_t>());
 		}
 
-		ret << ArchProcessor::tr("SYSCALL: %1(%2)").arg(root.attribute("name"), arguments.join(","));
+		ret << ArchProcessor::tr("SYSCALL: %1(%2)").arg(QString::fromLatin1(syscall->name), arguments.join(","));
 	}
 #endif
 }
 
+//------------------------------------------------------------------------------
+// Name: syscall_argument_index
+// Desc: which argument of a syscall <register_name> holds, -1 if none
+//------------------------------------------------------------------------------
+int syscall_argument_index(const char *register_name) {
+	static const char *const registers[] = { "ebx", "ecx", "edx", "esi", "edi", "ebp" };
+
+	for(std::size_t i = 0; i < sizeof(registers) / sizeof(registers[0]); ++i) {
+		if(std::strcmp(register_name, registers[i]) == 0) {
+			return static_cast<int>(i);
+		}
+	}
+
+	return -1;
+}
+
 }
 
 //------------------------------------------------------------------------------
 // Name: ArchProcessor
 // Desc:
 //------------------------------------------------------------------------------
-ArchProcessor::ArchProcessor() : split_flags_(0) {
+ArchProcessor::ArchProcessor() : split_flags_(0), register_view_valid_(false) {
 	if(edb::v1::debugger_core) {
 		has_mmx_ = edb::v1::debugger_core->has_extension(edb::string_hash<'M', 'M', 'X'>::value);
 		has_xmm_ = edb::v1::debugger_core->has_extension(edb::string_hash<'X', 'M', 'M'>::value);
+		has_ymm_ = edb::v1::debugger_core->has_extension(edb::string_hash<'A', 'V', 'X'>::value);
+		has_zmm_ = edb::v1::debugger_core->has_extension(edb::string_hash<'A', 'V', 'X', '5', '1', '2'>::value);
 	} else {
 		has_mmx_ = false;
 		has_xmm_ = false;
+		has_ymm_ = false;
+		has_zmm_ = false;
 	}
 }
 
@@ -716,6 +769,32 @@ void ArchProcessor::setup_register_view(RegisterListWidget *category_list) {
 			}
 		}
 
+		if(has_ymm_) {
+			if(QTreeWidgetItem *const ymm = category_list->addCategory(tr("YMM"))) {
+				register_view_items_[0x31] = create_register_item(ymm, "ymm0");
+				register_view_items_[0x32] = create_register_item(ymm, "ymm1");
+				register_view_items_[0x33] = create_register_item(ymm, "ymm2");
+				register_view_items_[0x34] = create_register_item(ymm, "ymm3");
+				register_view_items_[0x35] = create_register_item(ymm, "ymm4");
+				register_view_items_[0x36] = create_register_item(ymm, "ymm5");
+				register_view_items_[0x37] = create_register_item(ymm, "ymm6");
+				register_view_items_[0x38] = create_register_item(ymm, "ymm7");
+			}
+		}
+
+		if(has_zmm_) {
+			if(QTreeWidgetItem *const zmm = category_list->addCategory(tr("ZMM"))) {
+				register_view_items_[0x39] = create_register_item(zmm, "zmm0");
+				register_view_items_[0x3a] = create_register_item(zmm, "zmm1");
+				register_view_items_[0x3b] = create_register_item(zmm, "zmm2");
+				register_view_items_[0x3c] = create_register_item(zmm, "zmm3");
+				register_view_items_[0x3d] = create_register_item(zmm, "zmm4");
+				register_view_items_[0x3e] = create_register_item(zmm, "zmm5");
+				register_view_items_[0x3f] = create_register_item(zmm, "zmm6");
+				register_view_items_[0x40] = create_register_item(zmm, "zmm7");
+			}
+		}
+
 		update_register_view(QString(), State());
 	}
 }
@@ -726,6 +805,10 @@ void ArchProcessor::setup_register_view(RegisterListWidget *category_list) {
 //------------------------------------------------------------------------------
 Register ArchProcessor::value_from_item(const QTreeWidgetItem &item) {
 	const QString &name = item.data(0, Qt::UserRole).toString();
+	if(const StopSnapshot::pointer snapshot = edb::v1::stop_snapshot()) {
+		return snapshot->state[name];
+	}
+
 	State state;
 	edb::v1::debugger_core->get_state(&state);
 	return state[name];
@@ -760,6 +843,7 @@ void ArchProcessor::reset() {
 
 	if(edb::v1::debugger_core) {
 		last_state_.clear();
+		register_view_valid_ = false;
 		update_register_view(QString(), State());
 	}
 }
@@ -780,39 +864,70 @@ void ArchProcessor::update_register_view(const QString &default_region_name, con
 	update_register(register_view_items_[6], "ESI", state.gp_register(Esi));
 	update_register(register_view_items_[7], "EDI", state.gp_register(Edi));
 
-	const QString symname = edb::v1::find_function_symbol(state.instruction_pointer(), default_region_name);
+	// the general purpose registers are always redone since the strings they
+	// point to may have changed, everything else is only formatted again when
+	// its value differs from the last stop
+	const bool ip_changed    = state.instruction_pointer() != last_state_.instruction_pointer();
+	const bool flags_changed = state.flags() != last_state_.flags();
 
-	if(!symname.isEmpty()) {
-		register_view_items_[8]->setText(0, QString("EIP: %1 <%2>").arg(edb::v1::format_pointer(state.instruction_pointer())).arg(symname));
-	} else {
-		register_view_items_[8]->setText(0, QString("EIP: %1").arg(edb::v1::format_pointer(state.instruction_pointer())));
+	if(ip_changed || !register_view_valid_) {
+		const QString symname = edb::v1::find_function_symbol(state.instruction_pointer(), default_region_name);
+
+		if(!symname.isEmpty()) {
+			register_view_items_[8]->setText(0, QString("EIP: %1 <%2>").arg(edb::v1::format_pointer(state.instruction_pointer())).arg(symname));
+		} else {
+			register_view_items_[8]->setText(0, QString("EIP: %1").arg(edb::v1::format_pointer(state.instruction_pointer())));
+		}
+	}
+
+	if(flags_changed || !register_view_valid_) {
+		register_view_items_[9]->setText(0, QString("EFLAGS: %1").arg(edb::v1::format_pointer(state.flags())));
 	}
-	register_view_items_[9]->setText(0, QString("EFLAGS: %1").arg(edb::v1::format_pointer(state.flags())));
 
-	register_view_items_[10]->setText(0, QString("CS: %1")     .arg(state["cs"].value<edb::reg_t>() & 0xffff, 4, 16, QChar('0')));
-	register_view_items_[11]->setText(0, QString("DS: %1")     .arg(state["ds"].value<edb::reg_t>() & 0xffff, 4, 16, QChar('0')));
-	register_view_items_[12]->setText(0, QString("ES: %1")     .arg(state["es"].value<edb::reg_t>() & 0xffff, 4, 16, QChar('0')));
-	register_view_items_[13]->setText(0, QString("FS: %1 (%2)").arg(state["fs"].value<edb::reg_t>() & 0xffff, 4, 16, QChar('0')).arg(edb::v1::format_pointer(state["fs_base"].value<edb::reg_t>())));
-	register_view_items_[14]->setText(0, QString("GS: %1 (%2)").arg(state["gs"].value<edb::reg_t>() & 0xffff, 4, 16, QChar('0')).arg(edb::v1::format_pointer(state["gs_base"].value<edb::reg_t>())));
-	register_view_items_[15]->setText(0, QString("SS: %1")     .arg(state["ss"].value<edb::reg_t>() & 0xffff, 4, 16, QChar('0')));
+	if(state["cs"].value<edb::reg_t>() != last_state_["cs"].value<edb::reg_t>() || !register_view_valid_) {
+		register_view_items_[10]->setText(0, QString("CS: %1")     .arg(state["cs"].value<edb::reg_t>() & 0xffff, 4, 16, QChar('0')));
+	}
+	if(state["ds"].value<edb::reg_t>() != last_state_["ds"].value<edb::reg_t>() || !register_view_valid_) {
+		register_view_items_[11]->setText(0, QString("DS: %1")     .arg(state["ds"].value<edb::reg_t>() & 0xffff, 4, 16, QChar('0')));
+	}
+	if(state["es"].value<edb::reg_t>() != last_state_["es"].value<edb::reg_t>() || !register_view_valid_) {
+		register_view_items_[12]->setText(0, QString("ES: %1")     .arg(state["es"].value<edb::reg_t>() & 0xffff, 4, 16, QChar('0')));
+	}
+	if(state["fs"].value<edb::reg_t>() != last_state_["fs"].value<edb::reg_t>() || state["fs_base"].value<edb::reg_t>() != last_state_["fs_base"].value<edb::reg_t>() || !register_view_valid_) {
+		register_view_items_[13]->setText(0, QString("FS: %1 (%2)").arg(state["fs"].value<edb::reg_t>() & 0xffff, 4, 16, QChar('0')).arg(edb::v1::format_pointer(state["fs_base"].value<edb::reg_t>())));
+	}
+	if(state["gs"].value<edb::reg_t>() != last_state_["gs"].value<edb::reg_t>() || state["gs_base"].value<edb::reg_t>() != last_state_["gs_base"].value<edb::reg_t>() || !register_view_valid_) {
+		register_view_items_[14]->setText(0, QString("GS: %1 (%2)").arg(state["gs"].value<edb::reg_t>() & 0xffff, 4, 16, QChar('0')).arg(edb::v1::format_pointer(state["gs_base"].value<edb::reg_t>())));
+	}
+	if(state["ss"].value<edb::reg_t>() != last_state_["ss"].value<edb::reg_t>() || !register_view_valid_) {
+		register_view_items_[15]->setText(0, QString("SS: %1")     .arg(state["ss"].value<edb::reg_t>() & 0xffff, 4, 16, QChar('0')));
+	}
 
 	for(int i = 0; i < 8; ++i) {
 		const long double current = state.fpu_register(i);
 		const long double prev    = last_state_.fpu_register(i);
-		register_view_items_[16 + i]->setText(0, QString("ST%1: %2").arg(i).arg(current, 0, 'g', 16));
-		register_view_items_[16 + i]->setForeground(0, QBrush((current != prev && !(boost::math::isnan(prev) && boost::math::isnan(current))) ? Qt::red : palette.text()));
+		const bool changed        = current != prev && !(boost::math::isnan(prev) && boost::math::isnan(current));
+		if(changed || !register_view_valid_) {
+			register_view_items_[16 + i]->setText(0, QString("ST%1: %2").arg(i).arg(current, 0, 'g', 16));
+		}
+		register_view_items_[16 + i]->setForeground(0, QBrush(changed ? Qt::red : palette.text()));
 	}
 
 	for(int i = 0; i < 8; ++i) {
-		register_view_items_[24 + i]->setText(0, QString("DR%1: %2").arg(i).arg(state.debug_register(i), 0, 16));
-		register_view_items_[24 + i]->setForeground(0, QBrush((state.debug_register(i) != last_state_.debug_register(i)) ? Qt::red : palette.text()));
+		const bool changed = state.debug_register(i) != last_state_.debug_register(i);
+		if(changed || !register_view_valid_) {
+			register_view_items_[24 + i]->setText(0, QString("DR%1: %2").arg(i).arg(state.debug_register(i), 0, 16));
+		}
+		register_view_items_[24 + i]->setForeground(0, QBrush(changed ? Qt::red : palette.text()));
 	}
 
 	if(has_mmx_) {
 		for(int i = 0; i < 8; ++i) {
 			const quint64 current = state.mmx_register(i);
 			const quint64 prev    = last_state_.mmx_register(i);
-			register_view_items_[32 + i]->setText(0, QString("MM%1: %2").arg(i).arg(current, sizeof(quint64)*2, 16, QChar('0')));
+			if(current != prev || !register_view_valid_) {
+				register_view_items_[32 + i]->setText(0, QString("MM%1: %2").arg(i).arg(current, sizeof(quint64)*2, 16, QChar('0')));
+			}
 			register_view_items_[32 + i]->setForeground(0, QBrush((current != prev) ? Qt::red : palette.text()));
 		}
 	}
@@ -822,18 +937,45 @@ void ArchProcessor::update_register_view(const QString &default_region_name, con
 			const QByteArray current = state.xmm_register(i);
 			const QByteArray prev    = last_state_.xmm_register(i);
 			Q_ASSERT(current.size() == 16 || current.size() == 0);
-			register_view_items_[40 + i]->setText(0, QString("XMM%1: %2").arg(i).arg(current.toHex().constData()));
+			if(current != prev || !register_view_valid_) {
+				register_view_items_[40 + i]->setText(0, QString("XMM%1: %2").arg(i).arg(current.toHex().constData()));
+			}
 			register_view_items_[40 + i]->setForeground(0, QBrush((current != prev) ? Qt::red : palette.text()));
 		}
 
 		const quint32 current = state["mxcsr"].value<edb::reg_t>();
 		const quint32 prev    = last_state_["mxcsr"].value<edb::reg_t>();
-		register_view_items_[0x30]->setText(0, QString("MXCSR: %1").arg(current, 0, 16));
+		if(current != prev || !register_view_valid_) {
+			register_view_items_[0x30]->setText(0, QString("MXCSR: %1").arg(current, 0, 16));
+		}
 		register_view_items_[0x30]->setForeground(0, QBrush((current != prev) ? Qt::red : palette.text()));
 	}
 
-	const bool flags_changed = state.flags() != last_state_.flags();
-	if(flags_changed) {
+	if(has_ymm_) {
+		for(int i = 0; i < 8; ++i) {
+			const QByteArray current = state.ymm_register(i);
+			const QByteArray prev    = last_state_.ymm_register(i);
+			Q_ASSERT(current.size() == 32 || current.size() == 0);
+			if(current != prev || !register_view_valid_) {
+				register_view_items_[0x31 + i]->setText(0, QString("YMM%1: %2").arg(i).arg(current.toHex().constData()));
+			}
+			register_view_items_[0x31 + i]->setForeground(0, QBrush((current != prev) ? Qt::red : palette.text()));
+		}
+	}
+
+	if(has_zmm_) {
+		for(int i = 0; i < 8; ++i) {
+			const QByteArray current = state.zmm_register(i);
+			const QByteArray prev    = last_state_.zmm_register(i);
+			Q_ASSERT(current.size() == 64 || current.size() == 0);
+			if(current != prev || !register_view_valid_) {
+				register_view_items_[0x39 + i]->setText(0, QString("ZMM%1: %2").arg(i).arg(current.toHex().constData()));
+			}
+			register_view_items_[0x39 + i]->setForeground(0, QBrush((current != prev) ? Qt::red : palette.text()));
+		}
+	}
+
+	if(flags_changed || !register_view_valid_) {
 		split_flags_->setText(0, state.flags_to_string());
 	}
 
@@ -846,67 +988,63 @@ void ArchProcessor::update_register_view(const QString &default_region_name, con
 	register_view_items_[0x05]->setForeground(0, (state.gp_register(Esp) != last_state_.gp_register(Esp)) ? Qt::red : palette.text());
 	register_view_items_[0x06]->setForeground(0, (state.gp_register(Esi) != last_state_.gp_register(Esi)) ? Qt::red : palette.text());
 	register_view_items_[0x07]->setForeground(0, (state.gp_register(Edi) != last_state_.gp_register(Edi)) ? Qt::red : palette.text());
-	register_view_items_[0x08]->setForeground(0, (state.instruction_pointer() != last_state_.instruction_pointer()) ? Qt::red : palette.text());
+	register_view_items_[0x08]->setForeground(0, ip_changed ? Qt::red : palette.text());
 	register_view_items_[0x09]->setForeground(0, flags_changed ? Qt::red : palette.text());
 
-	last_state_ = state;
+	last_state_          = state;
+	register_view_valid_ = true;
 }
 
 //------------------------------------------------------------------------------
 // Name: update_instruction_info
 // Desc:
 //------------------------------------------------------------------------------
-QStringList ArchProcessor::update_instruction_info(edb::address_t address) {
+QStringList ArchProcessor::update_instruction_info(const edb::Instruction &inst, const State &state) {
 
 	QStringList ret;
 
 	Q_ASSERT(edb::v1::debugger_core);
 
-	if(IProcess *process = edb::v1::debugger_core->process()) {
-		quint8 buffer[edb::Instruction::MAX_SIZE];
-
-		if(process->read_bytes(address, buffer, sizeof(buffer))) {
-			edb::Instruction inst(buffer, buffer + sizeof(buffer), address, std::nothrow);
-			if(inst) {
-
-				State state;
-				edb::v1::debugger_core->get_state(&state);
-
-				// figure out the instruction type and display some information about it
-				switch(inst.type()) {
-				case edb::Instruction::OP_CMOVCC:
-					analyze_cmov(state, inst, ret);
-					break;
-				case edb::Instruction::OP_RET:
-					analyze_return(state, inst, ret);
-					break;
-				case edb::Instruction::OP_JCC:
-					analyze_jump(state, inst, ret);
-					// FALL THROUGH!
-				case edb::Instruction::OP_JMP:
-				case edb::Instruction::OP_CALL:
-					analyze_call(state, inst, ret);
-					break;
-				#ifdef Q_OS_LINUX
-				case edb::Instruction::OP_INT:
-					if(inst.operands()[0].complete_type() == edb::Operand::TYPE_IMMEDIATE8 && (inst.operands()[0].immediate() & 0xff) == 0x80) {
-						analyze_syscall(state, inst, ret);
-					} else {
-						analyze_operands(state, inst, ret);
-					}
-					break;
-				#endif
-				case edb::Instruction::OP_SYSCALL:
+	if(IProcess *const process = edb::v1::debugger_core->process()) {
+		if(inst) {
+
+			InstructionMemory memory;
+			read_instruction_memory(process, state, inst, &memory);
+
+			// figure out the instruction type and display some information about it
+			switch(inst.type()) {
+			case edb::Instruction::OP_CMOVCC:
+				analyze_cmov(state, inst, ret);
+				break;
+			case edb::Instruction::OP_RET:
+				analyze_return(state, inst, memory, ret);
+				break;
+			case edb::Instruction::OP_JCC:
+				analyze_jump(state, inst, ret);
+				// FALL THROUGH!
+			case edb::Instruction::OP_JMP:
+			case edb::Instruction::OP_CALL:
+				analyze_call(state, inst, memory, ret);
+				break;
+			#ifdef Q_OS_LINUX
+			case edb::Instruction::OP_INT:
+				if(inst.operands()[0].complete_type() == edb::Operand::TYPE_IMMEDIATE8 && (inst.operands()[0].immediate() & 0xff) == 0x80) {
 					analyze_syscall(state, inst, ret);
-					break;
-				default:
-					analyze_operands(state, inst, ret);
-					break;
+				} else {
+					analyze_operands(state, inst, memory, ret);
 				}
+				break;
+			#endif
+			case edb::Instruction::OP_SYSCALL:
+				analyze_syscall(state, inst, ret);
+				break;
+			default:
+				analyze_operands(state, inst, memory, ret);
+				break;
+			}
 
-				analyze_jump_targets(inst, ret);
+			analyze_jump_targets(inst, memory, ret);
 
-			}
 		}
 
 		// eliminate duplicates
@@ -992,3 +1130,62 @@ bool ArchProcessor::is_filling(const edb::Instruction &inst) const {
 
 	return ret;
 }
+
+//------------------------------------------------------------------------------
+// Name: effective_address
+// Desc: the address an operand refers to given the registers in <state>
+//------------------------------------------------------------------------------
+edb::address_t ArchProcessor::effective_address(const edb::Operand &op, const State &state) const {
+	return get_effective_address(op, state);
+}
+
+//------------------------------------------------------------------------------
+// Name: format_syscall
+// Desc: a recorded syscall the way strace would show it
+//------------------------------------------------------------------------------
+QString ArchProcessor::format_syscall(const SyscallRecord &record) const {
+
+	QString call = tr("syscall_%1()").arg(record.number);
+
+#ifdef Q_OS_LINUX
+	if(const edb::internal::Syscall *const syscall = edb::internal::find_syscall(edb::internal::syscalls_x86, edb::internal::syscalls_x86_count, record.number)) {
+
+		QStringList arguments;
+
+		for(int i = 0; i < syscall->argument_count; ++i) {
+			const edb::internal::SyscallArgument &argument = syscall->arguments[i];
+			const int n = syscall_argument_index(argument.register_name);
+			arguments << format_argument(QString::fromLatin1(argument.type), (n != -1) ? record.arguments[n] : 0);
+		}
+
+		call = QString("%1(%2)").arg(QString::fromLatin1(syscall->name), arguments.join(","));
+	}
+#endif
+
+	if(!record.returned) {
+		return tr("[%1] %2 = ?").arg(record.tid).arg(call);
+	}
+
+	return tr("[%1] %2 = %3").arg(record.tid).arg(call).arg(static_cast<long>(record.result));
+}
+
+//------------------------------------------------------------------------------
+// Name: syscall_number
+// Desc: looks a syscall up by name, returns false if there is no such syscall
+//------------------------------------------------------------------------------
+bool ArchProcessor::syscall_number(const QString &name, edb::reg_t *number) const {
+
+	Q_ASSERT(number);
+	Q_UNUSED(name);
+
+#ifdef Q_OS_LINUX
+	for(int i = 0; i < edb::internal::syscalls_x86_count; ++i) {
+		if(edb::internal::syscalls_x86[i].name && name == QLatin1String(edb::internal::syscalls_x86[i].name)) {
+			*number = i;
+			return true;
+		}
+	}
+#endif
+
+	return false;
+}
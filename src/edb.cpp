@@ -17,6 +17,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
 #include "edb.h"
+#include "Annotations.h"
 #include "ArchProcessor.h"
 #include "BinaryString.h"
 #include "Configuration.h"
@@ -24,29 +25,52 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "DialogInputBinaryString.h"
 #include "DialogInputValue.h"
 #include "DialogOptions.h"
+#include "Diagnostics.h"
 #include "Debugger.h"
 #include "Expression.h"
+#include "Fingerprint.h"
+#include "IAnalyzer.h"
 #include "Prototype.h"
 #include "IDebugger.h"
 #include "IPlugin.h"
+#include "InstructionCache.h"
+#include "PatchJournal.h"
+#include "InstructionTextCache.h"
 #include "MD5.h"
+#include "MappedFile.h"
 #include "MemoryRegions.h"
 #include "QHexView"
 #include "State.h"
+#include "StringScanner.h"
+#include "LazyPlugin.h"
+#include "LogFormat.h"
+#include "PrototypeTables.h"
 #include "SymbolManager.h"
+#include "Util.h"
 #include "version.h"
 
 #include <QAction>
 #include <QAtomicPointer>
 #include <QByteArray>
-#include <QDomDocument>
+#include <QCoreApplication>
+#include <QDateTime>
 #include <QFile>
 #include <QFileInfo>
 #include <QInputDialog>
 #include <QMessageBox>
+#include <QMutex>
+#include <QMutexLocker>
 #include <QScopedPointer>
+#include <QSettings>
+#include <QTime>
+#include <QVarLengthArray>
 
 #include <cctype>
+#include <cstring>
+
+#ifdef Q_OS_UNIX
+#include <sys/stat.h>
+#endif
 
 IDebugger *edb::v1::debugger_core = 0;
 QWidget       *edb::v1::debugger_ui   = 0;
@@ -59,13 +83,113 @@ namespace {
 	QAtomicPointer<IAnalyzer>          g_Analyzer          = 0;
 	QHash<QString, QObject *>          g_GeneralPlugins;
 	BinaryInfoList                     g_BinaryInfoList;
+	QList<LazyPlugin *>                g_LazyPlugins;
 
-	QHash<QString, edb::Prototype>     g_FunctionDB;
+	bool                               g_ProfileStartup = false;
+	QTime                              g_StartupTime;
+	int                                g_StartupLast    = 0;
 
 	Debugger *ui() {
 		return qobject_cast<Debugger *>(edb::v1::debugger_ui);
 	}
 
+	// what get_file_md5 has worked out so far, a file is only hashed again if
+	// it looks like it might be a different file
+	struct FileDigest {
+		quint64    inode;
+		qint64     size;
+		QDateTime  modified;
+		QByteArray md5;
+	};
+
+	// what logpoints have logged which hasn't been taken yet, the oldest lines
+	// go once there are too many
+	const int MaxBreakpointLogLines = 10000;
+
+	QStringList g_BreakpointLog;
+	quint64     g_BreakpointLogLost = 0;
+	QMutex      g_BreakpointLogLock;
+
+	// what structures() read from the structures file, and when the file had
+	// last been changed
+	TypeLayout g_Structures;
+	QString    g_StructuresFile;
+	QDateTime  g_StructuresModified;
+
+	QHash<QString, FileDigest> g_FileDigests;
+	QMutex                     g_FileDigestsLock;
+
+	// what find_function_symbol has said about each address it was asked
+	// about since the symbols last changed
+	struct FunctionSymbol {
+		QString name;    // "symbol+offset"
+		int     offset;
+		bool    found;
+	};
+
+	const int MaxFunctionSymbols = 16384;
+
+	QHash<edb::address_t, FunctionSymbol> g_FunctionSymbols;
+	quint64                               g_FunctionSymbolsGeneration = 0;
+	QMutex                                g_FunctionSymbolsLock;
+
+	// the inode of <info>, or 0 where there is no such thing
+	quint64 file_inode(const QFileInfo &info) {
+#ifdef Q_OS_UNIX
+		struct stat st;
+		if(::stat(QFile::encodeName(info.absoluteFilePath()).constData(), &st) == 0) {
+			return static_cast<quint64>(st.st_ino) ^ (static_cast<quint64>(st.st_dev) << 32);
+		}
+#else
+		Q_UNUSED(info);
+#endif
+		return 0;
+	}
+
+	// strings up to this many characters are read into a buffer on the stack
+	const int string_buffer_size = 256;
+
+	// reads up to <count> characters of <char_size> bytes at <address>, in one
+	// read unless they cross a page, in which case a page at a time so that a
+	// string which runs up to unreadable memory is still read as far as it
+	// goes. Returns how many characters at the start of the buffer <length>
+	// says are part of the string
+	std::size_t read_string(IProcess *process, edb::address_t address, quint8 *buffer, std::size_t count, std::size_t char_size, std::size_t (*length)(const quint8 *, std::size_t)) {
+
+		const edb::address_t page_size = edb::v1::debugger_core->page_size();
+
+		std::size_t n = 0;
+		while(n < count) {
+			const edb::address_t piece_address = address + n * char_size;
+
+			// a character which straddles two pages is read on its own
+			std::size_t piece = page_size ? static_cast<std::size_t>(page_size - piece_address % page_size) / char_size : count;
+			piece = qMin(qMax<std::size_t>(piece, 1), count - n);
+
+			quint8 *const p = buffer + n * char_size;
+			if(!process->read_bytes(piece_address, p, piece * char_size)) {
+				break;
+			}
+
+			const std::size_t found = length(p, piece * char_size);
+			n += found;
+
+			if(found != piece) {
+				break;
+			}
+		}
+
+		return n;
+	}
+
+	void escape_string(QString &s) {
+		s.replace("\r", "\\r");
+		s.replace("\n", "\\n");
+		s.replace("\t", "\\t");
+		s.replace("\v", "\\v");
+		s.replace("\"", "\\\"");
+	}
+
 	bool function_symbol_base(edb::address_t address, QString *value, int *offset) {
 
 		Q_ASSERT(value);
@@ -81,6 +205,45 @@ namespace {
 		}
 		return ret;
 	}
+
+	FunctionSymbol function_symbol(edb::address_t address) {
+
+		QMutexLocker locker(&g_FunctionSymbolsLock);
+
+		const quint64 generation = edb::v1::symbol_manager().generation();
+		if(generation != g_FunctionSymbolsGeneration || g_FunctionSymbols.size() >= MaxFunctionSymbols) {
+			g_FunctionSymbols.clear();
+			g_FunctionSymbolsGeneration = generation;
+		}
+
+		const QHash<edb::address_t, FunctionSymbol>::const_iterator it = g_FunctionSymbols.find(address);
+		if(it != g_FunctionSymbols.end()) {
+			return it.value();
+		}
+
+		FunctionSymbol symbol;
+		symbol.found = function_symbol_base(address, &symbol.name, &symbol.offset);
+		if(symbol.found) {
+			const unsigned int offset = static_cast<unsigned int>(symbol.offset);
+
+			int digits = 1;
+			for(unsigned int v = offset >> 4; v != 0; v >>= 4) {
+				++digits;
+			}
+
+			char buffer[8];
+			const char *const end = util::format_hex(offset, digits, buffer);
+
+			symbol.name.reserve(symbol.name.size() + 1 + digits);
+			symbol.name.append(QLatin1Char('+'));
+			for(const char *p = buffer; p != end; ++p) {
+				symbol.name.append(QLatin1Char(*p));
+			}
+		}
+
+		g_FunctionSymbols.insert(address, symbol);
+		return symbol;
+	}
 }
 
 namespace edb {
@@ -100,37 +263,129 @@ bool register_plugin(const QString &filename, QObject *plugin) {
 }
 
 //------------------------------------------------------------------------------
-// Name:
-// Desc:
+// Name: register_lazy_plugin
+// Desc: takes ownership of the plugin, it's kept until edb exits
 //------------------------------------------------------------------------------
-void load_function_db() {
-	QFile file(":/debugger/xml/functions.xml");
-	QDomDocument doc;
+bool register_lazy_plugin(LazyPlugin *plugin) {
 
-	if(file.open(QIODevice::ReadOnly)) {
-		if(doc.setContent(&file)) {
-			QDomElement root = doc.firstChildElement("functions");
-			QDomElement function = root.firstChildElement("function");
-			for (; !function.isNull(); function = function.nextSiblingElement("function")) {
+	Q_ASSERT(plugin);
 
+	if(g_GeneralPlugins.contains(plugin->filename())) {
+		delete plugin;
+		return false;
+	}
 
-				Prototype func;
-				func.name = function.attribute("name");
-				func.type = function.attribute("type");
+	Q_FOREACH(LazyPlugin *p, g_LazyPlugins) {
+		if(p->filename() == plugin->filename()) {
+			delete plugin;
+			return false;
+		}
+	}
 
-				QDomElement argument = function.firstChildElement("argument");
-				for (; !argument.isNull(); argument = argument.nextSiblingElement("argument")) {
+	g_LazyPlugins.push_back(plugin);
+	return true;
+}
 
-					Argument arg;
-					arg.name = argument.attribute("name");
-					arg.type = argument.attribute("type");
-					func.arguments.push_back(arg);
-				}
+//------------------------------------------------------------------------------
+// Name: lazy_plugins
+// Desc:
+//------------------------------------------------------------------------------
+const QList<LazyPlugin *> &lazy_plugins() {
+	return g_LazyPlugins;
+}
 
-				g_FunctionDB[func.name] = func;
-			}
+//------------------------------------------------------------------------------
+// Name: start_startup_profile
+// Desc: called first thing in main, the marks are relative to it
+//------------------------------------------------------------------------------
+void start_startup_profile() {
+	g_ProfileStartup = !qgetenv("EDB_PROFILE_STARTUP").isEmpty();
+	g_StartupTime.start();
+	g_StartupLast = 0;
+}
+
+//------------------------------------------------------------------------------
+// Name: profiling_startup
+// Desc:
+//------------------------------------------------------------------------------
+bool profiling_startup() {
+	return g_ProfileStartup;
+}
+
+//------------------------------------------------------------------------------
+// Name: startup_mark
+// Desc: reports how long it has been since startup, and since the last mark
+//------------------------------------------------------------------------------
+void startup_mark(const QString &what) {
+	if(g_ProfileStartup) {
+		const int now = g_StartupTime.elapsed();
+		qDebug("[startup] %5d ms (+%4d ms) %s", now, now - g_StartupLast, qPrintable(what));
+		g_StartupLast = now;
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: function_hash
+// Desc: FNV-1a of the name, the same as fnv1a in compile_prototypes.py.
+//       Returns false if the name can't be in the table at all
+//------------------------------------------------------------------------------
+bool function_hash(const QString &name, quint32 seed, quint32 *hash) {
+
+	quint32 h = 0x811c9dc5 ^ seed;
+	const QChar *const first = name.constData();
+	const QChar *const last  = first + name.size();
+	for(const QChar *it = first; it != last; ++it) {
+		const ushort ch = it->unicode();
+		if(ch > 0x7f) {
+			return false;
 		}
+		h ^= ch;
+		h *= 0x01000193;
+	}
+
+	*hash = h;
+	return true;
+}
+
+//------------------------------------------------------------------------------
+// Name: find_function
+// Desc: the table is a perfect hash, so this is two hashes and one compare
+//------------------------------------------------------------------------------
+const Prototype *find_function(const QString &name) {
+
+	quint32 hash;
+	if(function_count == 0 || !function_hash(name, 0, &hash)) {
+		return 0;
+	}
+
+	const int displacement = function_displacements[hash % function_count];
+
+	int slot;
+	if(displacement < 0) {
+		slot = -displacement - 1;
+	} else {
+		function_hash(name, displacement, &hash);
+		slot = hash % function_count;
+	}
+
+	const Prototype *const function = &function_table[slot];
+	if(name != QLatin1String(function->name)) {
+		return 0;
+	}
+
+	return function;
+}
+
+//------------------------------------------------------------------------------
+// Name: find_syscall
+// Desc:
+//------------------------------------------------------------------------------
+const Syscall *find_syscall(const Syscall *table, int count, edb::reg_t number) {
+	if(number < static_cast<edb::reg_t>(count) && table[number].name) {
+		return &table[number];
 	}
+
+	return 0;
 }
 
 }
@@ -153,6 +408,23 @@ IRegion::pointer current_cpu_view_region() {
 	return ui()->ui.cpuView->region();
 }
 
+//------------------------------------------------------------------------------
+// Name: stop_snapshot
+// Desc:
+//------------------------------------------------------------------------------
+StopSnapshot::pointer stop_snapshot() {
+	return ui()->snapshot();
+}
+
+//------------------------------------------------------------------------------
+// Name: memory_breakpoint_page
+// Desc:
+//------------------------------------------------------------------------------
+bool memory_breakpoint_page(address_t address, address_t size, bool write) {
+	Debugger *const debugger = ui();
+	return debugger && debugger->memory_breakpoints().protects(address, size, write);
+}
+
 //------------------------------------------------------------------------------
 // Name: repaint_cpu_view
 // Desc:
@@ -163,6 +435,17 @@ void repaint_cpu_view() {
 	gui->ui.cpuView->repaint();
 }
 
+//------------------------------------------------------------------------------
+// Name: update_ui
+// Desc: brings every view up to date with the state of the process, for when
+//       a plugin changes it behind the debugger's back
+//------------------------------------------------------------------------------
+void update_ui() {
+	Debugger *const gui = ui();
+	Q_ASSERT(gui);
+	gui->update_gui();
+}
+
 //------------------------------------------------------------------------------
 // Name: symbol_manager
 // Desc:
@@ -190,6 +473,42 @@ ArchProcessor &arch_processor() {
 	return g_ArchProcessor;
 }
 
+//------------------------------------------------------------------------------
+// Name: patch_journal
+// Desc:
+//------------------------------------------------------------------------------
+PatchJournal &patch_journal() {
+	static PatchJournal g_PatchJournal;
+	return g_PatchJournal;
+}
+
+//------------------------------------------------------------------------------
+// Name: annotations
+// Desc:
+//------------------------------------------------------------------------------
+Annotations &annotations() {
+	static Annotations g_Annotations;
+	return g_Annotations;
+}
+
+//------------------------------------------------------------------------------
+// Name: instruction_cache
+// Desc:
+//------------------------------------------------------------------------------
+InstructionCache &instruction_cache() {
+	static InstructionCache g_InstructionCache;
+	return g_InstructionCache;
+}
+
+//------------------------------------------------------------------------------
+// Name: instruction_text_cache
+// Desc:
+//------------------------------------------------------------------------------
+InstructionTextCache &instruction_text_cache() {
+	static InstructionTextCache g_InstructionTextCache;
+	return g_InstructionTextCache;
+}
+
 //------------------------------------------------------------------------------
 // Name: set_analyzer
 // Desc:
@@ -323,6 +642,30 @@ QString get_breakpoint_condition(address_t address) {
 	return ret;
 }
 
+//------------------------------------------------------------------------------
+// Name: set_breakpoint_log_format
+// Desc: an empty format makes it a regular breakpoint again
+//------------------------------------------------------------------------------
+void set_breakpoint_log_format(address_t address, const QString &format) {
+	IBreakpoint::pointer bp = find_breakpoint(address);
+	if(bp) {
+		bp->log_format = format;
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: get_breakpoint_log_format
+// Desc:
+//------------------------------------------------------------------------------
+QString get_breakpoint_log_format(address_t address) {
+	QString ret;
+	IBreakpoint::pointer bp = find_breakpoint(address);
+	if(bp) {
+		ret = bp->log_format;
+	}
+
+	return ret;
+}
 
 //------------------------------------------------------------------------------
 // Name: create_breakpoint
@@ -420,9 +763,62 @@ void toggle_breakpoint(address_t address) {
 //------------------------------------------------------------------------------
 void remove_breakpoint(address_t address) {
 	debugger_core->remove_breakpoint(address);
+	if(Debugger *const debugger = ui()) {
+		debugger->pending_breakpoints().breakpoint_removed(address);
+	}
 	repaint_cpu_view();
 }
 
+//------------------------------------------------------------------------------
+// Name: create_pending_breakpoint
+// Desc: returns false if <location> isn't of the form module!symbol+offset. If
+//       the module is already loaded the breakpoint is set right away
+//------------------------------------------------------------------------------
+bool create_pending_breakpoint(const QString &location) {
+
+	Debugger *const debugger = ui();
+	if(!debugger || !debugger->pending_breakpoints().add(location, QString())) {
+		return false;
+	}
+
+	if(debugger_core && debugger_core->process()) {
+		Q_FOREACH(const Module &module, loaded_modules()) {
+			debugger->pending_breakpoints().module_loaded(module);
+		}
+		repaint_cpu_view();
+	}
+
+	return true;
+}
+
+//------------------------------------------------------------------------------
+// Name: remove_pending_breakpoint
+// Desc:
+//------------------------------------------------------------------------------
+void remove_pending_breakpoint(const QString &location) {
+	if(Debugger *const debugger = ui()) {
+		debugger->pending_breakpoints().remove(location);
+		repaint_cpu_view();
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: pending_breakpoints
+// Desc: the locations of the pending breakpoints which aren't set, the ones
+//       which are show up as ordinary breakpoints
+//------------------------------------------------------------------------------
+QStringList pending_breakpoints() {
+	QStringList locations;
+	if(Debugger *const debugger = ui()) {
+		Q_FOREACH(const PendingBreakpoints::Breakpoint &breakpoint, debugger->pending_breakpoints().breakpoints()) {
+			if(!breakpoint.address) {
+				locations.push_back(breakpoint.text);
+			}
+		}
+	}
+	return locations;
+}
+
 //------------------------------------------------------------------------------
 // Name: eval_expression
 // Desc:
@@ -557,30 +953,16 @@ bool get_ascii_string_at_address(address_t address, QString &s, int min_length,
 			s.clear();
 
 			if(min_length <= max_length) {
-				while(max_length--) {
-					char ch;
-					if(!process->read_bytes(address++, &ch, sizeof(ch))) {
-						break;
-					}
-
-					const int ascii_char = static_cast<unsigned char>(ch);
-					if(ascii_char < 0x80 && (std::isprint(ascii_char) || std::isspace(ascii_char))) {
-						s += ch;
-					} else {
-						break;
-					}
-				}
+				QVarLengthArray<quint8, string_buffer_size> buffer(max_length);
+				const std::size_t n = read_string(process, address, buffer.data(), max_length, 1, StringScanner::ascii_length);
+				s = QString::fromLatin1(reinterpret_cast<const char *>(buffer.data()), n);
 			}
 
 			is_string = s.length() >= min_length;
 
 			if(is_string) {
 				found_length = s.length();
-				s.replace("\r", "\\r");
-				s.replace("\n", "\\n");
-				s.replace("\t", "\\t");
-				s.replace("\v", "\\v");
-				s.replace("\"", "\\\"");
+				escape_string(s);
 			}
 		}
 	}
@@ -604,59 +986,105 @@ bool get_utf16_string_at_address(address_t address, QString &s, int min_length,
 			s.clear();
 
 			if(min_length <= max_length) {
-				while(max_length--) {
+				QVarLengthArray<quint8, string_buffer_size * sizeof(quint16)> buffer(max_length * sizeof(quint16));
+				const std::size_t n = read_string(process, address, buffer.data(), max_length, sizeof(quint16), StringScanner::utf16_length);
 
-					quint16 val;
-					if(!process->read_bytes(address, &val, sizeof(val))) {
-						break;
-					}
-
-					address += sizeof(val);
-
-					QChar ch(val);
-
-					// for now, we only acknowledge ASCII chars encoded as unicode
-					const int ascii_char = ch.toLatin1();
-					if(ascii_char >= 0x20 && ascii_char < 0x80) {
-						s += ch;
-					} else {
-						break;
-					}
+				// for now, we only acknowledge ASCII chars encoded as unicode,
+				// so the low bytes are all there is to them
+				for(std::size_t i = 0; i < n; ++i) {
+					buffer[i] = buffer[i * sizeof(quint16)];
 				}
+
+				s = QString::fromLatin1(reinterpret_cast<const char *>(buffer.data()), n);
 			}
 
 			is_string = s.length() >= min_length;
 
 			if(is_string) {
 				found_length = s.length();
-				s.replace("\r", "\\r");
-				s.replace("\n", "\\n");
-				s.replace("\t", "\\t");
-				s.replace("\v", "\\v");
-				s.replace("\"", "\\\"");
+				escape_string(s);
 			}
 		}
 	}
 	return is_string;
 }
 
+//------------------------------------------------------------------------------
+// Name: get_ascii_string_from_buffer
+// Desc: like get_ascii_string_at_address, but examines <size> bytes which were
+//       already read from the process. This lets callers fetch string candidates
+//       along with other data in a single batched read
+//------------------------------------------------------------------------------
+bool get_ascii_string_from_buffer(const void *buffer, size_t size, QString &s, int min_length, int max_length, int &found_length) {
+
+	Q_ASSERT(buffer);
+
+	const quint8 *const p = reinterpret_cast<const quint8 *>(buffer);
+	s.clear();
+
+	if(min_length <= max_length) {
+		const size_t n = StringScanner::ascii_length(p, qMin(size, static_cast<size_t>(max_length)));
+		s = QString::fromLatin1(reinterpret_cast<const char *>(p), n);
+	}
+
+	const bool is_string = s.length() >= min_length;
+
+	if(is_string) {
+		found_length = s.length();
+		escape_string(s);
+	}
+
+	return is_string;
+}
+
+//------------------------------------------------------------------------------
+// Name: get_utf16_string_from_buffer
+// Desc: like get_utf16_string_at_address, but examines <size> bytes which were
+//       already read from the process
+//------------------------------------------------------------------------------
+bool get_utf16_string_from_buffer(const void *buffer, size_t size, QString &s, int min_length, int max_length, int &found_length) {
+
+	Q_ASSERT(buffer);
+
+	const quint8 *const p = reinterpret_cast<const quint8 *>(buffer);
+	s.clear();
+
+	if(min_length <= max_length) {
+		const size_t n = StringScanner::utf16_length(p, qMin(size, static_cast<size_t>(max_length) * sizeof(quint16)));
+
+		s.resize(n);
+		for(size_t i = 0; i < n; ++i) {
+			s[static_cast<int>(i)] = QLatin1Char(p[i * sizeof(quint16)]);
+		}
+	}
+
+	const bool is_string = s.length() >= min_length;
+
+	if(is_string) {
+		found_length = s.length();
+		escape_string(s);
+	}
+
+	return is_string;
+}
+
 //------------------------------------------------------------------------------
 // Name: find_function_symbol
-// Desc:
+// Desc: "symbol+offset" for <address>, the answers are kept until the symbols
+//       change so it is cheap to ask again
 //------------------------------------------------------------------------------
 QString find_function_symbol(address_t address, const QString &default_value, int *offset) {
 
-	QString symname(default_value);
-	int off;
+	const FunctionSymbol symbol = function_symbol(address);
+	if(!symbol.found) {
+		return default_value;
+	}
 
-	if(function_symbol_base(address, &symname, &off)) {
-		symname = QString("%1+%2").arg(symname).arg(off, 0, 16);
-		if(offset) {
-			*offset = off;
-		}
+	if(offset) {
+		*offset = symbol.offset;
 	}
 
-	return symname;
+	return symbol.name;
 }
 
 //------------------------------------------------------------------------------
@@ -690,6 +1118,22 @@ address_t get_variable(const QString &s, bool *ok, ExpressionError *err) {
 	const Register reg = state.value(s);
 	*ok = reg;
 	if(!*ok) {
+
+		// not a register, maybe it names a symbol. Either fully, like
+		// "libc.so.6::malloc", or just "malloc" if it is in any module
+		if(const Symbol::pointer sym = symbol_manager().find(s)) {
+			*ok = true;
+			return sym->address;
+		}
+
+		const QVector<quint64> matches = symbol_manager().search(s, ISymbolManager::SEARCH_EXACT);
+		if(!matches.isEmpty()) {
+			if(const Symbol::pointer sym = symbol_manager().from_handle(matches.front())) {
+				*ok = true;
+				return sym->address;
+			}
+		}
+
 		*err = ExpressionError(ExpressionError::UNKNOWN_VARIABLE);
 	}
 
@@ -702,6 +1146,111 @@ address_t get_variable(const QString &s, bool *ok, ExpressionError *err) {
 	return reg.value<reg_t>();
 }
 
+//------------------------------------------------------------------------------
+// Name: breakpoint_condition_true
+// Desc: evaluates the condition of <bp> using the registers in <state>, the
+//       condition is only parsed again when it has changed
+//------------------------------------------------------------------------------
+bool breakpoint_condition_true(const IBreakpoint::pointer &bp, const State &state, bool *result, ExpressionError *err) {
+
+	Q_ASSERT(bp);
+	Q_ASSERT(result);
+	Q_ASSERT(err);
+
+	CompiledExpression &condition = bp->compiled_condition;
+
+	if(condition.source() != bp->condition || condition.stale()) {
+		condition.compile(bp->condition, state);
+	}
+
+	address_t value;
+	if(!condition.evaluate(state, &value, err)) {
+		return false;
+	}
+
+	*result = value != 0;
+	return true;
+}
+
+//------------------------------------------------------------------------------
+// Name: structures
+// Desc: mistakes in the file are only logged, the definitions which could be
+//       understood are still used
+//------------------------------------------------------------------------------
+const TypeLayout &structures() {
+
+	const QString   path = config().structures_file;
+	const QFileInfo info(path);
+	const QDateTime modified = info.exists() ? info.lastModified() : QDateTime();
+
+	if(path != g_StructuresFile || modified != g_StructuresModified) {
+		g_StructuresFile     = path;
+		g_StructuresModified = modified;
+		g_Structures.clear();
+
+		QFile file(path);
+		if(!path.isEmpty() && file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+			QStringList errors;
+			if(!g_Structures.parse(QString::fromUtf8(file.readAll()), &errors)) {
+				Q_FOREACH(const QString &error, errors) {
+					qDebug("[structures] %s: %s", qPrintable(path), qPrintable(error));
+				}
+			}
+		}
+	}
+
+	return g_Structures;
+}
+
+//------------------------------------------------------------------------------
+// Name: log_breakpoint_hit
+// Desc: the message is only parsed again when it has changed, expressions in
+//       it which can't be evaluated are logged as their error
+//------------------------------------------------------------------------------
+void log_breakpoint_hit(const IBreakpoint::pointer &bp, const State &state) {
+
+	Q_ASSERT(bp);
+
+	static edb::diagnostics::Counter *const hits = edb::diagnostics::counter("logpoint hits");
+	edb::diagnostics::add(hits);
+
+	LogFormat &format = bp->compiled_log_format;
+
+	if(format.source() != bp->log_format || format.stale()) {
+		format.compile(bp->log_format, state);
+	}
+
+	QString message;
+	format.format(state, &message);
+
+	const QString line = QString("%1  %2").arg(format_pointer(bp->address()), message);
+
+	QMutexLocker locker(&g_BreakpointLogLock);
+	g_BreakpointLog.push_back(line);
+	if(g_BreakpointLog.size() > MaxBreakpointLogLines) {
+		g_BreakpointLog.removeFirst();
+		++g_BreakpointLogLost;
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: take_breakpoint_log
+// Desc:
+//------------------------------------------------------------------------------
+QStringList take_breakpoint_log(quint64 *lost) {
+
+	QMutexLocker locker(&g_BreakpointLogLock);
+
+	if(lost) {
+		*lost = g_BreakpointLogLost;
+	}
+
+	const QStringList lines = g_BreakpointLog;
+	g_BreakpointLog.clear();
+	g_BreakpointLogLost = 0;
+	return lines;
+}
+
 //------------------------------------------------------------------------------
 // Name: get_value
 // Desc:
@@ -769,6 +1318,61 @@ IBinary *get_binary_info(const IRegion::pointer &region) {
 	return 0;
 }
 
+//------------------------------------------------------------------------------
+// Name: code_regions
+// Desc: the binary's headers are in the first mapping of its file, which is
+//       the closest one at or below <region> mapped from the file's start
+//------------------------------------------------------------------------------
+QList<IRegion::pointer> code_regions(const IRegion::pointer &region) {
+
+	QList<IRegion::pointer> regions;
+
+	IRegion::pointer first;
+	if(config().scan_code_sections_only && region->name().startsWith('/')) {
+		Q_FOREACH(const IRegion::pointer &r, memory_regions().regions()) {
+			if(r->name() == region->name() && r->base() == 0 && r->start() <= region->start()) {
+				if(!first || r->start() > first->start()) {
+					first = r;
+				}
+			}
+		}
+	}
+
+	QList<IBinary::Section> sections;
+	if(first) {
+		QScopedPointer<IBinary> binary(get_binary_info(first));
+		if(binary) {
+			sections = binary->sections();
+		}
+	}
+
+	if(sections.isEmpty()) {
+		regions.push_back(region);
+		return regions;
+	}
+
+	Q_FOREACH(const IBinary::Section &section, sections) {
+		const address_t start = qMax(section.start, region->start());
+		const address_t end   = qMin(section.end, region->end());
+		if(section.executable && start < end) {
+
+			// code sections which follow on from each other are scanned as
+			// one, so nothing is cut off where they meet
+			if(!regions.isEmpty() && regions.last()->end() == start) {
+				regions.last()->set_end(end);
+				continue;
+			}
+
+			IRegion::pointer part(region->clone());
+			part->set_start(start);
+			part->set_end(end);
+			regions.push_back(part);
+		}
+	}
+
+	return regions;
+}
+
 //------------------------------------------------------------------------------
 // Name: locate_main_function
 // Desc:
@@ -819,6 +1423,18 @@ IPlugin *find_plugin_by_name(const QString &name) {
 	return 0;
 }
 
+//------------------------------------------------------------------------------
+// Name: load_lazy_plugins
+// Desc: loads the plugins which are still waiting for their menu to be used,
+//       so that plugin_list has all of them. Their menus swap themselves in
+//       the first time they are used, as usual
+//------------------------------------------------------------------------------
+void load_lazy_plugins() {
+	Q_FOREACH(LazyPlugin *plugin, internal::lazy_plugins()) {
+		plugin->load();
+	}
+}
+
 //------------------------------------------------------------------------------
 // Name: reload_symbols
 // Desc:
@@ -833,12 +1449,7 @@ void reload_symbols() {
 //------------------------------------------------------------------------------
 const Prototype *get_function_info(const QString &function) {
 
-	QHash<QString, Prototype>::const_iterator it = g_FunctionDB.find(function);
-	if(it != g_FunctionDB.end()) {
-		return &(it.value());
-	}
-
-	return 0;
+	return internal::find_function(function);
 }
 
 //------------------------------------------------------------------------------
@@ -972,14 +1583,15 @@ bool overwrite_check(address_t address, unsigned int size) {
 //------------------------------------------------------------------------------
 void modify_bytes(address_t address, unsigned int size, QByteArray &bytes, quint8 fill) {
 
-	if(IProcess *process = edb::v1::debugger_core->process()) {
+	if(edb::v1::debugger_core->process()) {
 		if(size != 0) {
 			// fill bytes
 			while(bytes.size() < static_cast<int>(size)) {
 				bytes.push_back(fill);
 			}
 	
-			process->write_bytes(address, bytes.data(), size);
+			// the journal tells the analyzer what changed
+			patch_journal().write(QT_TRANSLATE_NOOP("edb", "Modify Bytes"), address, bytes.left(size));
 	
 			// do a refresh, not full update
 			Debugger *const gui = ui();
@@ -1008,22 +1620,111 @@ QByteArray get_md5(const void *p, size_t n) {
 	return QByteArray(reinterpret_cast<const char *>(md5.digest()), 16);
 }
 
+//------------------------------------------------------------------------------
+// Name: get_fingerprint
+// Desc: a cheap way to tell whether a block of memory has changed, it is much
+//       quicker than MD5 but stands for nothing outside of this run of edb's
+//       own caches. Anything written where other tools read it should stay
+//       an MD5
+//------------------------------------------------------------------------------
+QByteArray get_fingerprint(const void *p, size_t n) {
+	const quint64 h = edb::internal::xxh64(p, n, 0);
+	return QByteArray(reinterpret_cast<const char *>(&h), sizeof(h));
+}
+
 //------------------------------------------------------------------------------
 // Name: get_file_md5
 // Desc: returns a byte array representing the MD5 of a file
+// Note: files are only hashed the first time they are seen, after that only
+//       when their inode, size or modification time changes. Every attach
+//       checks the symbols of every module, this saves hashing them again
 //------------------------------------------------------------------------------
 QByteArray get_file_md5(const QString &s) {
 
-	QFile file(s);
-	file.open(QIODevice::ReadOnly);
-	if(file.isOpen()) {
+	const QFileInfo info(s);
+	const QString   path     = info.absoluteFilePath();
+	const quint64   inode    = file_inode(info);
+	const qint64    size     = info.size();
+	const QDateTime modified = info.lastModified();
+
+	{
+		QMutexLocker locker(&g_FileDigestsLock);
+		QHash<QString, FileDigest>::const_iterator it = g_FileDigests.constFind(path);
+		if(it != g_FileDigests.constEnd() && it->inode == inode && it->size == size && it->modified == modified) {
+			return it->md5;
+		}
+	}
+
+	QByteArray md5;
+
+	// hash the file through the shared mapping when we can, symbol generation
+	// does this for every module and copying large binaries into memory to do
+	// it is slow
+	const MappedFile mapping = MappedFile::open(s);
+	if(mapping.is_open()) {
+		md5 = get_md5(mapping.data(), mapping.size());
+	} else {
+		QFile file(s);
+		file.open(QIODevice::ReadOnly);
+		if(!file.isOpen()) {
+			return QByteArray();
+		}
+
 		const QByteArray file_bytes = file.readAll();
-		return get_md5(file_bytes.data(), file_bytes.size());
+		md5 = get_md5(file_bytes.data(), file_bytes.size());
 	}
 
-	return QByteArray();
+	const FileDigest digest = { inode, size, modified, md5 };
+
+	QMutexLocker locker(&g_FileDigestsLock);
+	g_FileDigests.insert(path, digest);
+	return md5;
 }
 
+//------------------------------------------------------------------------------
+// Name: temp_filename
+// Desc: several edb processes debugging cooperating programs share the caches
+//       of the libraries those have in common, so the temporary name a cache
+//       is written under has to be this process's own
+//------------------------------------------------------------------------------
+QString temp_filename(const QString &filename) {
+	return QString("%1.%2.tmp").arg(filename).arg(QCoreApplication::applicationPid());
+}
+
+//------------------------------------------------------------------------------
+// Name: cache_directory
+// Desc: the analysis, gadget and opcode caches and the signature libraries
+//       all live here, so that every plugin agrees on where that is
+//------------------------------------------------------------------------------
+QString cache_directory(const QString &name) {
+	const QSettings settings;
+	return QFileInfo(settings.fileName()).absolutePath() + QLatin1Char('/') + name;
+}
+
+//------------------------------------------------------------------------------
+// Name: json_string
+// Desc: every control character is written as \uXXXX, JSON allows none of
+//       them in a string as they are
+//------------------------------------------------------------------------------
+QString json_string(const QString &s) {
+
+	QString ret("\"");
+	ret.reserve(s.size() + 2);
+
+	Q_FOREACH(QChar ch, s) {
+		if(ch == '"' || ch == '\\') {
+			ret += '\\';
+			ret += ch;
+		} else if(ch.unicode() < 0x20) {
+			ret += QString("\\u%1").arg(ch.unicode(), 4, 16, QChar('0'));
+		} else {
+			ret += ch;
+		}
+	}
+
+	ret += '"';
+	return ret;
+}
 
 //------------------------------------------------------------------------------
 // Name: symlink_target
@@ -1180,10 +1881,27 @@ QString format_bytes(quint8 byte) {
 // Desc:
 //------------------------------------------------------------------------------
 QString format_pointer(address_t p) {
-	if(debugger_core) {
-		return debugger_core->format_pointer(p);
+	QString text;
+	format_pointer(p, &text);
+	return text;
+}
+
+//------------------------------------------------------------------------------
+// Name: format_pointer
+// Desc: like the other one, but writes into <text> so that a caller formatting
+//       many addresses can reuse the same string
+//------------------------------------------------------------------------------
+void format_pointer(address_t p, QString *text) {
+
+	Q_ASSERT(text);
+
+	if(!debugger_core) {
+		text->clear();
+		return;
 	}
-	return QString();
+
+	char buffer[sizeof(address_t) * 2];
+	util::assign_latin1(text, buffer, static_cast<int>(util::format_hex(p, sizeof(buffer), buffer) - buffer));
 }
 
 //------------------------------------------------------------------------------
@@ -1263,17 +1981,31 @@ QVector<quint8> read_pages(address_t address, size_t page_count) {
 	return QVector<quint8>();
 }
 
+//------------------------------------------------------------------------------
+// Name: loaded_modules
+// Desc: the shared objects loaded into the process, kept up to date as they
+//       are loaded and unloaded rather than worked out on every call
+//------------------------------------------------------------------------------
+QList<Module> loaded_modules() {
+	if(Debugger *const debugger = ui()) {
+		return debugger->loaded_modules();
+	}
+
+	if(debugger_core) {
+		return debugger_core->loaded_modules();
+	}
+
+	return QList<Module>();
+}
+
 //------------------------------------------------------------------------------
 // Name: disassemble_address
 // Desc: will return a QString where isNull is true on failure
 //------------------------------------------------------------------------------
 QString disassemble_address(address_t address) {
-	quint8 buffer[edb::Instruction::MAX_SIZE];
-	if(const int size = edb::v1::get_instruction_bytes(address, buffer)) {
-		edb::Instruction inst(buffer, buffer + size, address, std::nothrow);
-		if(inst) {
-			return QString::fromStdString(to_string(inst));
-		}
+	const InstructionCache::pointer inst = instruction_cache().find(address);
+	if(inst && *inst) {
+		return instruction_text_cache().format(*inst);
 	}
 	
 	return QString();
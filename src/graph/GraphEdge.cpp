@@ -55,7 +55,10 @@ void GraphEdge::paint(QPainter *painter, const QStyleOptionGraphicsItem *option,
 	painter->save();
 	QGraphicsPathItem::paint(painter, option, widget);
 	painter->restore();
-	picture_.play(painter);
+
+	if(GraphWidget::show_details(painter)) {
+		picture_.play(painter);
+	}
 }
 
 //------------------------------------------------------------------------------
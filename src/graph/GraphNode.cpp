@@ -41,7 +41,10 @@ void GraphNode::paint(QPainter *painter, const QStyleOptionGraphicsItem *option,
 	painter->save();
 	QGraphicsPathItem::paint(painter, option, widget);
 	painter->restore();
-	picture_.play(painter);
+
+	if(GraphWidget::show_details(painter)) {
+		picture_.play(painter);
+	}
 }
 
 //------------------------------------------------------------------------------
@@ -26,28 +26,86 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <QObject>
 #include <QDebug>
 #include <QKeyEvent>
+#include <QPainter>
+#include <QStyleOptionGraphicsItem>
+#include <QThread>
 #include <QWheelEvent>
 #include <QGraphicsSceneMouseEvent>
 
+#if QT_VERSION >= 0x050400
+#include <QOpenGLWidget>
+#include <QSurfaceFormat>
+#endif
+
 #include "GraphWidget.h"
 #include "GraphNode.h"
 #include "GraphEdge.h"
 
+namespace {
+
+// the zoom below which only the shapes of the graph are drawn
+const qreal DETAIL_THRESHOLD = 0.5;
+
+// graphs with at least this many items are drawn with OpenGL. For smaller ones
+// setting up a context costs more than it saves
+const int OPENGL_THRESHOLD = 2000;
+
+}
+
+// lays a graph out with graphviz away from the GUI thread, big graphs can take
+// seconds. Only one layout is ever done at a time, graphviz isn't thread safe
+class GraphWidget::LayoutThread : public QThread {
+public:
+	LayoutThread(const QByteArray &dot, const QString &layout, QObject *parent) : QThread(parent), dot_(dot), layout_(layout.toUtf8()), gvc(0), graph(0), laid_out(false) {
+	}
+
+	virtual ~LayoutThread() {
+		wait();
+		if(graph) {
+			if(laid_out) {
+				gvFreeLayout(gvc, graph);
+			}
+			agclose(graph);
+		}
+
+		if(gvc) {
+			gvFreeContext(gvc);
+		}
+	}
+
+public:
+	virtual void run() {
+		if((gvc = gvContext())) {
+			if((graph = agmemread(const_cast<char *>(dot_.constData())))) {
+				laid_out = gvLayout(gvc, graph, const_cast<char *>(layout_.constData())) == 0;
+			}
+		}
+	}
+
+private:
+	QByteArray dot_;
+	QByteArray layout_;
+
+public:
+	GVC_t     *gvc;
+	graph_t   *graph;
+	bool       laid_out;
+};
+
 //------------------------------------------------------------------------------
 // Name: GraphWidget
-// Desc:
+// Desc: an empty view, for a graph given to layout_graph later
 //------------------------------------------------------------------------------
-GraphWidget::GraphWidget(const QString& filename, const QString& layout, QWidget* parent) : QGraphicsView(parent) {
-
-	setRenderHint(QPainter::Antialiasing);
-	setRenderHint(QPainter::TextAntialiasing);
-	setTransformationAnchor(AnchorUnderMouse);
-	setResizeAnchor(AnchorUnderMouse);
-
-	scene_ = new QGraphicsScene(this);
-	scene_->setItemIndexMethod(QGraphicsScene::BspTreeIndex);
-	setScene(scene_);
+GraphWidget::GraphWidget(QWidget* parent) : QGraphicsView(parent), layout_thread_(0), opengl_(false) {
+	init_view();
+}
 
+//------------------------------------------------------------------------------
+// Name: GraphWidget
+// Desc:
+//------------------------------------------------------------------------------
+GraphWidget::GraphWidget(const QString& filename, const QString& layout, QWidget* parent) : QGraphicsView(parent), layout_thread_(0), opengl_(false) {
+	init_view();
 	render_graph(filename, layout);
 }
 
@@ -55,18 +113,72 @@ GraphWidget::GraphWidget(const QString& filename, const QString& layout, QWidget
 // Name: GraphWidget
 // Desc:
 //------------------------------------------------------------------------------
-GraphWidget::GraphWidget(GVC_t *gvc, graph_t *graph, const QString& layout, QWidget* parent) : QGraphicsView(parent) {
+GraphWidget::GraphWidget(GVC_t *gvc, graph_t *graph, const QString& layout, QWidget* parent) : QGraphicsView(parent), layout_thread_(0), opengl_(false) {
+	init_view();
+	render_graph(gvc, graph, layout);
+}
+
+//------------------------------------------------------------------------------
+// Name: init_view
+// Desc:
+//------------------------------------------------------------------------------
+void GraphWidget::init_view() {
 
 	setRenderHint(QPainter::Antialiasing);
 	setRenderHint(QPainter::TextAntialiasing);
 	setTransformationAnchor(AnchorUnderMouse);
 	setResizeAnchor(AnchorUnderMouse);
 
+	// the nodes and edges put the painter back the way they found it
+	setOptimizationFlag(DontSavePainterState);
+
 	scene_ = new QGraphicsScene(this);
 	scene_->setItemIndexMethod(QGraphicsScene::BspTreeIndex);
 	setScene(scene_);
+}
 
-	render_graph(gvc, graph, layout);
+//------------------------------------------------------------------------------
+// Name: set_opengl
+// Desc: switches the view between drawing through OpenGL and in software. The
+//       items are the same either way, and the scene's index still means only
+//       those in view are drawn. Setting EDB_GRAPH_SOFTWARE keeps it in
+//       software, for drivers which don't get along with Qt
+//------------------------------------------------------------------------------
+void GraphWidget::set_opengl(bool enable) {
+
+#if QT_VERSION >= 0x050400
+	if(enable && !qgetenv("EDB_GRAPH_SOFTWARE").isEmpty()) {
+		enable = false;
+	}
+
+	if(enable == opengl_) {
+		return;
+	}
+
+	if(enable) {
+		QOpenGLWidget *const viewport = new QOpenGLWidget;
+
+		// multisampling stands in for the painter's antialiasing
+		QSurfaceFormat format = viewport->format();
+		format.setSamples(4);
+		viewport->setFormat(format);
+
+		setViewport(viewport);
+
+		// a GL viewport is always redrawn as a whole, so there is no point in
+		// working out what changed or in leaving room for antialiasing
+		setViewportUpdateMode(FullViewportUpdate);
+		setOptimizationFlag(DontAdjustForAntialiasing, true);
+	} else {
+		setViewport(new QWidget);
+		setViewportUpdateMode(MinimalViewportUpdate);
+		setOptimizationFlag(DontAdjustForAntialiasing, false);
+	}
+
+	opengl_ = enable;
+#else
+	Q_UNUSED(enable);
+#endif
 }
 
 //------------------------------------------------------------------------------
@@ -74,6 +186,55 @@ GraphWidget::GraphWidget(GVC_t *gvc, graph_t *graph, const QString& layout, QWid
 // Desc:
 //------------------------------------------------------------------------------
 GraphWidget::~GraphWidget() {
+	delete layout_thread_;
+}
+
+//------------------------------------------------------------------------------
+// Name: show_details
+// Desc:
+//------------------------------------------------------------------------------
+bool GraphWidget::show_details(const QPainter *painter) {
+	return QStyleOptionGraphicsItem::levelOfDetailFromTransform(painter->worldTransform()) >= DETAIL_THRESHOLD;
+}
+
+//------------------------------------------------------------------------------
+// Name: layout_graph
+// Desc: lays out the graph described by <dot> in the background and shows it
+//       once that is done, the GUI carries on in the meantime
+//------------------------------------------------------------------------------
+void GraphWidget::layout_graph(const QByteArray& dot, const QString& layout) {
+
+	// a layout already running can't be stopped, only waited out
+	delete layout_thread_;
+
+	clear_graph();
+	scene_->addText(tr("Laying out the graph..."));
+
+	layout_thread_ = new LayoutThread(dot, layout, this);
+	connect(layout_thread_, SIGNAL(finished()), this, SLOT(layout_finished()));
+	layout_thread_->start();
+}
+
+//------------------------------------------------------------------------------
+// Name: layout_finished
+// Desc:
+//------------------------------------------------------------------------------
+void GraphWidget::layout_finished() {
+
+	// this might be left over from a layout which was replaced by another
+	if(!layout_thread_ || !layout_thread_->isFinished()) {
+		return;
+	}
+
+	if(layout_thread_->laid_out) {
+		render_layout(layout_thread_->graph);
+	} else {
+		clear_graph();
+		qCritical("gvLayout() failed");
+	}
+
+	delete layout_thread_;
+	layout_thread_ = 0;
 }
 
 //------------------------------------------------------------------------------
@@ -117,6 +278,10 @@ void GraphWidget::scale_view(qreal scaleFactor) {
 	scaleFactor = qBound(0.1 / f, scaleFactor, 8.0 / f);
 
 	scale(scaleFactor, scaleFactor);
+
+	// antialiasing thousands of tiny shapes is most of the cost of drawing a
+	// zoomed out graph and makes no visible difference
+	setRenderHint(QPainter::Antialiasing, f * scaleFactor >= DETAIL_THRESHOLD);
 }
 
 //------------------------------------------------------------------------------
@@ -125,7 +290,7 @@ void GraphWidget::scale_view(qreal scaleFactor) {
 //------------------------------------------------------------------------------
 void GraphWidget::contextMenuEvent(QContextMenuEvent* event) {
 
-	if(GraphNode *const node = qgraphicsitem_cast<GraphNode*>(itemAt(event->pos()))) {
+	if(GraphNode *const node = node_at(event->pos())) {
 		emit nodeContextMenuEvent(event, node->name);
 	} else {
 		emit backgroundContextMenuEvent(event);
@@ -138,11 +303,33 @@ void GraphWidget::contextMenuEvent(QContextMenuEvent* event) {
 //------------------------------------------------------------------------------
 void GraphWidget::mouseDoubleClickEvent(QMouseEvent* event) {
 
-	if(GraphNode *const node = qgraphicsitem_cast<GraphNode*>(itemAt(event->pos()))) {
+	if(GraphNode *const node = node_at(event->pos())) {
 		emit nodeDoubleClickEvent(event, node->name);
 	}
 }
 
+//------------------------------------------------------------------------------
+// Name: node_at
+// Desc: the node under <pos> in the view. The scene's index narrows things
+//       down by bounding rect, which is cheap, and only the nodes among those
+//       have their shape looked at. itemAt would work out the shape of every
+//       edge there too, and in a big graph there are a lot of them
+//------------------------------------------------------------------------------
+GraphNode *GraphWidget::node_at(const QPoint &pos) const {
+
+	const QPointF point = mapToScene(pos);
+
+	Q_FOREACH(QGraphicsItem *item, scene_->items(point, Qt::IntersectsItemBoundingRect, Qt::DescendingOrder)) {
+		if(GraphNode *const node = qgraphicsitem_cast<GraphNode*>(item)) {
+			if(node->contains(node->mapFromScene(point))) {
+				return node;
+			}
+		}
+	}
+
+	return 0;
+}
+
 //------------------------------------------------------------------------------
 // Name: gToQ
 // Desc:
@@ -334,30 +521,41 @@ void GraphWidget::render_node(graph_t *graph, node_t *node) {
 void GraphWidget::render_graph(GVC_t *gvc, graph_t *graph, const QString& layout) {
 
 	if(gvLayout(gvc, graph, const_cast<char *>(qPrintable(layout))) == 0) {
-		clear_graph();
-		if(GD_charset(graph)) {
-			qWarning("unsupported charset");
-		}
+		render_layout(graph);
+	} else {
+		qCritical("gvLayout() failed");
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: render_layout
+// Desc: fills the scene from a graph which has been laid out
+//------------------------------------------------------------------------------
+void GraphWidget::render_layout(graph_t *graph) {
 
-		// don't use gToQ here since it adjusts the values
-		graph_rect_ = QRectF(
-			GD_bb(graph).LL.x,
-			GD_bb(graph).LL.y,
-			GD_bb(graph).UR.x,
-			GD_bb(graph).UR.y);
+	clear_graph();
+	if(GD_charset(graph)) {
+		qWarning("unsupported charset");
+	}
 
-		scene_->setSceneRect(graph_rect_.adjusted(-5, -5, +5, +5));
-		scene_->setBackgroundBrush(aggetToQColor(graph, "bgcolor", Qt::white));
+	// don't use gToQ here since it adjusts the values
+	graph_rect_ = QRectF(
+		GD_bb(graph).LL.x,
+		GD_bb(graph).LL.y,
+		GD_bb(graph).UR.x,
+		GD_bb(graph).UR.y);
 
-		render_sub_graph(graph);
+	scene_->setSceneRect(graph_rect_.adjusted(-5, -5, +5, +5));
+	scene_->setBackgroundBrush(aggetToQColor(graph, "bgcolor", Qt::white));
 
-		// the list of nodes includes sub-graphs
-		for(node_t *n = agfstnode(graph); n; n = agnxtnode(graph, n)) {
-			render_node(graph, n);
-		}
-	} else {
-		qCritical("gvLayout() failed");
+	render_sub_graph(graph);
+
+	// the list of nodes includes sub-graphs
+	for(node_t *n = agfstnode(graph); n; n = agnxtnode(graph, n)) {
+		render_node(graph, n);
 	}
+
+	set_opengl(scene_->items().size() >= OPENGL_THRESHOLD);
 }
 
 //------------------------------------------------------------------------------
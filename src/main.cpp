@@ -22,6 +22,9 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "IDebugger.h"
 #include "IPlugin.h"
 #include "edb.h"
+#include "LazyPlugin.h"
+#include "RemoteProtocol.h"
+#include "RemoteStub.h"
 #include "version.h"
 
 #include <QApplication>
@@ -30,19 +33,64 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <QLibraryInfo>
 #include <QMessageBox>
 #include <QPluginLoader>
+#include <QTimer>
 #include <QTranslator>
 #include <QtDebug>
 
+#if QT_VERSION >= 0x050000
+#include "BatchScript.h"
+#include <QJsonArray>
+#include <QJsonObject>
+#endif
+
+#include <cstring>
 #include <ctime>
 #include <iostream>
 
 namespace {
 
+#if QT_VERSION >= 0x050000
+//------------------------------------------------------------------------------
+// Name: lazy_plugin
+// Desc: plugins may describe their menu in their metadata, like this:
+//
+//       { "lazy" : true, "menu" : "ROPTool",
+//         "actions" : [ { "text" : "&ROP Tool", "shortcut" : "Ctrl+Alt+R" } ] }
+//
+//       those aren't loaded until one of the entries is used. Reading the
+//       metadata doesn't load the library, Qt finds it in the file
+//------------------------------------------------------------------------------
+LazyPlugin *lazy_plugin(const QString &full_path, const QPluginLoader &loader) {
+
+	const QJsonObject metadata = loader.metaData().value("MetaData").toObject();
+	if(!metadata.value("lazy").toBool()) {
+		return 0;
+	}
+
+	QList<LazyPlugin::Action> actions;
+	Q_FOREACH(const QJsonValue &value, metadata.value("actions").toArray()) {
+		const QJsonObject object = value.toObject();
+
+		LazyPlugin::Action action;
+		action.text     = object.value("text").toString();
+		action.shortcut = QKeySequence(object.value("shortcut").toString());
+		actions.push_back(action);
+	}
+
+	if(actions.isEmpty()) {
+		return 0;
+	}
+
+	return new LazyPlugin(full_path, metadata.value("menu").toString(), actions);
+}
+#endif
+
 //------------------------------------------------------------------------------
 // Name: load_plugins
-// Desc: attempts to load all plugins in a given directory
+// Desc: attempts to load all plugins in a given directory, if <core_only> is
+//       set the debugger core is all that is wanted
 //------------------------------------------------------------------------------
-void load_plugins(const QString &directory) {
+void load_plugins(const QString &directory, bool core_only = false) {
 
 	QDir plugins_dir(qApp->applicationDirPath());
 
@@ -55,6 +103,14 @@ void load_plugins(const QString &directory) {
 			QPluginLoader loader(full_path);
 			loader.setLoadHints(QLibrary::ExportExternalSymbolsHint);
 
+#if QT_VERSION >= 0x050000
+			if(LazyPlugin *const lazy = lazy_plugin(full_path, loader)) {
+				edb::internal::register_lazy_plugin(lazy);
+				edb::internal::startup_mark(QString("deferred %1").arg(file_name));
+				continue;
+			}
+#endif
+
 			if(QObject *const plugin = loader.instance()) {
 
 				// TODO: handle the case where we find more than one core plugin...
@@ -62,10 +118,12 @@ void load_plugins(const QString &directory) {
 					if(!edb::v1::debugger_core) {
 						edb::v1::debugger_core = core_plugin;
 					}
-				} else if(qobject_cast<IPlugin *>(plugin)) {
+				} else if(!core_only && qobject_cast<IPlugin *>(plugin)) {
 					if(edb::internal::register_plugin(full_path, plugin)) {
 					}
 				}
+
+				edb::internal::startup_mark(QString("loaded %1").arg(file_name));
 			} else {
 				qDebug() << "[load_plugins]" << qPrintable(loader.errorString());
 			}
@@ -77,18 +135,22 @@ void load_plugins(const QString &directory) {
 // Name: start_debugger
 // Desc: starts the main debugger code
 //------------------------------------------------------------------------------
-int start_debugger(edb::pid_t attach_pid, const QString &program, const QList<QByteArray> &programArgs) {
+int start_debugger(edb::pid_t attach_pid, const QString &program, const QList<QByteArray> &programArgs, const QString &core_file) {
 
 	qDebug() << "Starting edb version:" << edb::version;
 	qDebug("Please Report Bugs & Requests At: https://github.com/eteran/edb-debugger/issues");
 
-	edb::internal::load_function_db();
-
 	// create the main window object
 	Debugger debugger;
+	edb::internal::startup_mark("created the main window");
 
 	// ok things are initialized to a reasonable degree, let's show the main window
 	debugger.show();
+	edb::internal::startup_mark("showed the main window");
+
+	if(edb::internal::profiling_startup()) {
+		QTimer::singleShot(0, &debugger, SLOT(startup_finished()));
+	}
 
 	if(!edb::v1::debugger_core) {
 		QMessageBox::warning(
@@ -114,12 +176,81 @@ int start_debugger(edb::pid_t attach_pid, const QString &program, const QList<QB
 			debugger.attach(attach_pid);
 		} else if(!program.isEmpty()) {
 			debugger.execute(program, programArgs);
+		} else if(!core_file.isEmpty()) {
+			debugger.open_core(core_file);
 		}
 
 		return qApp->exec();
 	}
 }
 
+//------------------------------------------------------------------------------
+// Name: start_stub
+// Desc: serves the debugger core to a remote edb instead of showing a window,
+//       <listen> is [address:]port and the address defaults to the loopback
+//       interface
+//------------------------------------------------------------------------------
+int start_stub(const QString &listen) {
+
+	if(!edb::v1::debugger_core) {
+		std::cerr << "Failed to load the debugger core plugin, please check the plugin path." << std::endl;
+		return -1;
+	}
+
+	QHostAddress address(QHostAddress::LocalHost);
+	quint16      port = Remote::DefaultPort;
+
+	if(!listen.isEmpty()) {
+		const int colon = listen.lastIndexOf(':');
+		if(colon != -1 && !address.setAddress(listen.left(colon))) {
+			std::cerr << qPrintable(listen.left(colon)) << " is not a valid address" << std::endl;
+			return -1;
+		}
+
+		bool ok;
+		port = listen.mid(colon + 1).toUShort(&ok);
+		if(!ok) {
+			std::cerr << qPrintable(listen.mid(colon + 1)) << " is not a valid port" << std::endl;
+			return -1;
+		}
+	}
+
+	RemoteStub stub;
+
+	QString error;
+	if(!stub.listen(address, port, &error)) {
+		std::cerr << "Could not listen on " << qPrintable(address.toString()) << ":" << port << ": " << qPrintable(error) << std::endl;
+		return -1;
+	}
+
+	return qApp->exec();
+}
+
+#if QT_VERSION >= 0x050000
+//------------------------------------------------------------------------------
+// Name: start_batch
+// Desc: runs <script> with no window, see BatchScript. Plugins are loaded
+//       for their engines (the analyzer, binary formats) but never given a
+//       menu, so none of their widgets are made
+//------------------------------------------------------------------------------
+int start_batch(const QString &script, const QStringList &arguments) {
+
+	if(!edb::v1::debugger_core) {
+		std::cerr << "Failed to load the debugger core plugin, please check the plugin path." << std::endl;
+		return -1;
+	}
+
+	Q_FOREACH(QObject *plugin, edb::v1::plugin_list()) {
+		if(IPlugin *const p = qobject_cast<IPlugin *>(plugin)) {
+			p->init();
+		}
+	}
+
+	BatchScript batch(arguments);
+	return batch.run(script);
+}
+#endif
+
 //------------------------------------------------------------------------------
 // Name: load_translations
 // Desc:
@@ -146,6 +277,13 @@ void usage() {
 	std::cerr << std::endl;
 	std::cerr << " --attach <pid>            : attach to running process" << std::endl;
 	std::cerr << " --run <program> (args...) : execute specified <program> with <args>" << std::endl;
+	std::cerr << " --core <file>             : examine the process saved in the core <file>" << std::endl;
+	std::cerr << " --stub [address:]port     : serve a remote edb instead of showing a window," << std::endl;
+	std::cerr << "                             on 127.0.0.1 unless an address is given" << std::endl;
+#if QT_VERSION >= 0x050000
+	std::cerr << " --batch <script> (args...): run the JavaScript <script> without a window," << std::endl;
+	std::cerr << "                             it is given <args> as edb.arguments()" << std::endl;
+#endif
 	std::cerr << " --version                 : output version information and exit" << std::endl;
 	std::cerr << " --dump-version            : display terse version string and exit" << std::endl;
 	std::cerr << " --help                    : display this help and exit" << std::endl;
@@ -175,7 +313,34 @@ int main(int argc, char *argv[]) {
 
 	QT_REQUIRE_VERSION(argc, argv, "4.6.0");
 
+	edb::internal::start_startup_profile();
+
+	// the stub may well run where there is no display
+	if(argc >= 2 && std::strcmp(argv[1], "--stub") == 0) {
+		QCoreApplication app(argc, argv);
+		QCoreApplication::setOrganizationName("codef00.com");
+		QCoreApplication::setOrganizationDomain("codef00.com");
+		QCoreApplication::setApplicationName("edb");
+
+		load_plugins(edb::v1::config().plugin_path, true);
+		return start_stub(argc >= 3 ? QString::fromLocal8Bit(argv[2]) : QString());
+	}
+
+#if QT_VERSION >= 0x050000
+	// as is a batch run, which is meant for CI and other scripted use
+	if(argc >= 3 && std::strcmp(argv[1], "--batch") == 0) {
+		QCoreApplication app(argc, argv);
+		QCoreApplication::setOrganizationName("codef00.com");
+		QCoreApplication::setOrganizationDomain("codef00.com");
+		QCoreApplication::setApplicationName("edb");
+
+		load_plugins(edb::v1::config().plugin_path);
+		return start_batch(QString::fromLocal8Bit(argv[2]), app.arguments().mid(3));
+	}
+#endif
+
 	QApplication app(argc, argv);
+	edb::internal::startup_mark("created the application");
 	QApplication::setWindowIcon(QIcon(":/debugger/images/edb48-logo.png"));
 
 	qsrand(std::time(0));
@@ -186,14 +351,17 @@ int main(int argc, char *argv[]) {
 	QApplication::setApplicationName("edb");
 
 	load_translations();
+	edb::internal::startup_mark("loaded translations");
 
 	// look for some plugins..
 	load_plugins(edb::v1::config().plugin_path);
+	edb::internal::startup_mark("loaded plugins");
 
 	QStringList args = app.arguments();
 	edb::pid_t        attach_pid = 0;
 	QList<QByteArray> run_args;
 	QString           run_app;
+	QString           core_file;
 
 	// call the init function for each plugin, this is done after
 	// ALL plugins are loaded in case there are inter-plugin dependencies
@@ -223,6 +391,8 @@ int main(int argc, char *argv[]) {
 			for(int i = 3; i < args.size(); ++i) {
 				run_args.push_back(argv[i]);
 			}
+		} else if(args.size() == 3 && args[1] == "--core") {
+			core_file = args[2];
 		} else if(args.size() == 2 && args[1] == "--version") {
 			std::cout << "edb version: " << edb::version << std::endl;
 			return 0;
@@ -234,5 +404,5 @@ int main(int argc, char *argv[]) {
 		}
 	}
 
-	return start_debugger(attach_pid, run_app, run_args);
+	return start_debugger(attach_pid, run_app, run_args, core_file);
 }
@@ -3,6 +3,16 @@ LEVEL = ..
 include(../qmake/clean-objects.pri)
 include(../qmake/c++11.pri)
 include(../qmake/qt5-gui.pri)
+include(../qmake/tracing.pri)
+
+QT          += network
+
+# batch mode scripts are run by QJSEngine, which Qt4 doesn't have
+greaterThan(QT_MAJOR_VERSION, 4) {
+	QT      += qml
+	HEADERS += BatchScript.h
+	SOURCES += BatchScript.cpp
+}
 
 TEMPLATE    = app
 TARGET      = edb
@@ -13,23 +23,33 @@ RESOURCES   = debugger.qrc
 DESTDIR     = ../
 target.path = /bin/
 INSTALLS    += target
-QT          += xml xmlpatterns
 
 TRANSLATIONS += \
 	lang/edb_en.ts
 
 HEADERS += \
 	API.h \
+	Annotations.h \
 	ArchProcessor.h \
 	ArchTypes.h \
 	BasicBlock.h \
+	BenchmarkResult.h \
 	BinaryString.h \
+	BranchRecord.h \
+	ByteSearcher.h \
 	ByteShiftArray.h \
 	CommentServer.h \
+	CompiledExpression.h \
 	Configuration.h \
+	ContentMap.h \
+	ContentMapWidget.h \
+	CoreFile.h \
+	CoreFileDebugger.h \
 	DataViewInfo.h \
+	DebugRegisters.h \
 	Debugger.h \
 	DebuggerInternal.h \
+	Diagnostics.h \
 	DialogArguments.h \
 	DialogAttach.h \
 	DialogInputBinaryString.h \
@@ -38,7 +58,10 @@ HEADERS += \
 	DialogOptions.h \
 	DialogPlugins.h \
 	DialogThreads.h \
+	DisplacedSteps.h \
+	Emulator.h \
 	Expression.h \
+	Fingerprint.h \
 	FixedFontSelector.h \
 	HexStringValidator.h \
 	IAnalyzer.h \
@@ -54,31 +77,68 @@ HEADERS += \
 	IState.h \
 	ISymbolManager.h \
 	Instruction.h \
+	InstructionCache.h \
+	InstructionTextCache.h \
+	InstructionLength.h \
+	JitSymbols.h \
+	LazyPlugin.h \
+	LengthDecoder.h \
 	LineEdit.h \
+	LogFormat.h \
 	MD5.h \
+	MappedFile.h \
+	MemoryBreakpoints.h \
+	MemoryBudget.h \
+	MemoryDump.h \
 	MemoryRegions.h \
+	MemoryUsage.h \
 	Module.h \
+	ModuleTracker.h \
+	MultiPatternSearcher.h \
 	OSTypes.h \
+	PatchJournal.h \
+	PendingBreakpoints.h \
+	PerformanceCounters.h \
 	PluginModel.h \
 	ProcessInfo.h \
 	ProcessModel.h \
+	ProcessSnapshot.h \
+	ProfileSample.h \
 	Prototype.h \
+	PrototypeTables.h \
 	QDisassemblyView.h \
 	QLongValidator.h \
 	QULongValidator.h \
 	RecentFileManager.h \
 	RegionBuffer.h \
+	RegionDiff.h \
+	RegionReader.h \
+	RegionScanner.h \
 	Register.h \
 	RegisterListWidget.h \
 	RegisterViewDelegate.h \
+	RemoteDebugger.h \
+	RemoteProtocol.h \
+	RemoteStub.h \
+	ResultsModel.h \
+	Session.h \
 	ShiftBuffer.h \
 	State.h \
+	StopSnapshot.h \
+	StringScanner.h \
+	SymbolCache.h \
 	Symbol.h \
 	SymbolManager.h \
+	SymbolTable.h \
 	SyntaxHighlighter.h \
+	SyscallRecord.h \
 	TabWidget.h \
 	ThreadsModel.h \
+	TimedSlot.h \
+	Trace.h \
+	TypeLayout.h \
 	Types.h \
+	Unwinder.h \
 	Util.h \
 	edb.h \
 	string_hash.h \
@@ -86,6 +146,22 @@ HEADERS += \
     CallStack.h
 
 
+# functions.xml and syscalls.xml are compiled into tables, rather than being
+# parsed every time edb starts
+isEmpty(PYTHON) : PYTHON = python3
+
+prototype_db.input         = PROTOTYPE_XML
+prototype_db.output        = PrototypeTables.cpp
+prototype_db.commands      = $$PYTHON $$PWD/xml/compile_prototypes.py -o ${QMAKE_FILE_OUT} ${QMAKE_FILE_IN}
+prototype_db.depends       = $$PWD/xml/compile_prototypes.py
+prototype_db.variable_out  = SOURCES
+prototype_db.CONFIG       += combine
+QMAKE_EXTRA_COMPILERS     += prototype_db
+
+PROTOTYPE_XML = \
+	xml/functions.xml \
+	xml/syscalls.xml
+
 FORMS += \
 	BinaryString.ui \
 	Debugger.ui \
@@ -100,14 +176,22 @@ FORMS += \
 	FixedFontSelector.ui
 
 SOURCES += \
+	Annotations.cpp \
 	ArchProcessor.cpp \
 	BasicBlock.cpp \
 	BinaryString.cpp \
+	ByteSearcher.cpp \
 	ByteShiftArray.cpp \
 	CommentServer.cpp \
+	CompiledExpression.cpp \
 	Configuration.cpp \
+	ContentMap.cpp \
+	ContentMapWidget.cpp \
+	CoreFile.cpp \
+	CoreFileDebugger.cpp \
 	DataViewInfo.cpp \
 	Debugger.cpp \
+	Diagnostics.cpp \
 	DialogArguments.cpp \
 	DialogAttach.cpp \
 	DialogInputBinaryString.cpp \
@@ -116,28 +200,59 @@ SOURCES += \
 	DialogOptions.cpp \
 	DialogPlugins.cpp \
 	DialogThreads.cpp \
+	DisplacedSteps.cpp \
+	Emulator.cpp \
+	Fingerprint.cpp \
 	FixedFontSelector.cpp \
 	Function.cpp \
 	HexStringValidator.cpp \
 	Instruction.cpp \
+	InstructionCache.cpp \
+	InstructionTextCache.cpp \
+	JitSymbols.cpp \
+	LazyPlugin.cpp \
 	LineEdit.cpp \
+	LogFormat.cpp \
 	MD5.cpp \
+	MappedFile.cpp \
+	MemoryBreakpoints.cpp \
+	MemoryBudget.cpp \
+	MemoryDump.cpp \
 	MemoryRegions.cpp \
+	ModuleTracker.cpp \
+	MultiPatternSearcher.cpp \
+	PatchJournal.cpp \
+	PendingBreakpoints.cpp \
 	PluginModel.cpp \
 	ProcessModel.cpp \
+	ProcessSnapshot.cpp \
 	QDisassemblyView.cpp \
 	QLongValidator.cpp \
 	QULongValidator.cpp \
 	RecentFileManager.cpp \
 	RegionBuffer.cpp \
+	RegionDiff.cpp \
+	RegionReader.cpp \
+	RegionScanner.cpp \
 	Register.cpp \
 	RegisterListWidget.cpp \
 	RegisterViewDelegate.cpp \
+	RemoteDebugger.cpp \
+	RemoteProtocol.cpp \
+	RemoteStub.cpp \
+	ResultsModel.cpp \
+	Session.cpp \
 	State.cpp \
+	StringScanner.cpp \
+	SymbolCache.cpp \
 	SymbolManager.cpp \
+	SymbolTable.cpp \
 	SyntaxHighlighter.cpp \
 	TabWidget.cpp \
 	ThreadsModel.cpp \
+	Trace.cpp \
+	TypeLayout.cpp \
+	Unwinder.cpp \
 	edb.cpp \
 	main.cpp \
     CallStack.cpp
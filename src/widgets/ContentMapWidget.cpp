@@ -0,0 +1,261 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "ContentMapWidget.h"
+#include "edb.h"
+#include <QHelpEvent>
+#include <QMouseEvent>
+#include <QPainter>
+#include <QToolTip>
+#include <cmath>
+
+namespace {
+
+// cells are never drawn bigger than this, however few pages there are
+const int max_cell_size = 8;
+
+//------------------------------------------------------------------------------
+// Name: rank
+// Desc: how much a page with <content> is worth drawing over its neighbours
+//------------------------------------------------------------------------------
+int rank(ContentMap::Content content) {
+	switch(content) {
+	case ContentMap::CONTENT_RANDOM: return 4;
+	case ContentMap::CONTENT_CODE:   return 3;
+	case ContentMap::CONTENT_TEXT:   return 2;
+	case ContentMap::CONTENT_DATA:   return 1;
+	case ContentMap::CONTENT_ZERO:
+	default:
+		return 0;
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: content_name
+// Desc:
+//------------------------------------------------------------------------------
+QString content_name(ContentMap::Content content) {
+	switch(content) {
+	case ContentMap::CONTENT_ZERO:   return ContentMapWidget::tr("Zeros");
+	case ContentMap::CONTENT_TEXT:   return ContentMapWidget::tr("Text");
+	case ContentMap::CONTENT_CODE:   return ContentMapWidget::tr("Code");
+	case ContentMap::CONTENT_RANDOM: return ContentMapWidget::tr("High Entropy");
+	case ContentMap::CONTENT_DATA:
+	default:
+		return ContentMapWidget::tr("Data");
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: page_color
+// Desc: the hue says what the page holds, the brighter it is the more entropy
+//       it has
+//------------------------------------------------------------------------------
+QRgb page_color(const ContentMap::Page &page) {
+
+	int hue;
+	int saturation = 255;
+	switch(page.content) {
+	case ContentMap::CONTENT_ZERO:   return qRgb(0, 0, 0);
+	case ContentMap::CONTENT_TEXT:   hue = 120; break;
+	case ContentMap::CONTENT_CODE:   hue = 210; break;
+	case ContentMap::CONTENT_RANDOM: hue = 0;   break;
+	case ContentMap::CONTENT_DATA:
+	default:
+		hue        = 45;
+		saturation = 64;
+		break;
+	}
+
+	const int value = 96 + static_cast<int>(page.entropy / 8.0f * 159.0f);
+	return QColor::fromHsv(hue, saturation, qBound(0, value, 255)).rgb();
+}
+
+}
+
+//------------------------------------------------------------------------------
+// Name: ContentMapWidget
+// Desc:
+//------------------------------------------------------------------------------
+ContentMapWidget::ContentMapWidget(QWidget *parent) : QWidget(parent), cell_size_(1), columns_(1), pages_per_cell_(1) {
+	setMouseTracking(true);
+}
+
+//------------------------------------------------------------------------------
+// Name: sizeHint
+// Desc: a narrow strip beside whatever it goes with
+//------------------------------------------------------------------------------
+QSize ContentMapWidget::sizeHint() const {
+	return QSize(96, 256);
+}
+
+//------------------------------------------------------------------------------
+// Name: setPages
+// Desc:
+//------------------------------------------------------------------------------
+void ContentMapWidget::setPages(const QVector<ContentMap::Page> &pages) {
+	pages_ = pages;
+	layout_cells();
+	update();
+}
+
+//------------------------------------------------------------------------------
+// Name: clear
+// Desc:
+//------------------------------------------------------------------------------
+void ContentMapWidget::clear() {
+	setPages(QVector<ContentMap::Page>());
+}
+
+//------------------------------------------------------------------------------
+// Name: representative
+// Desc: the index of the page <cell> is drawn as, or -1 if it has none
+//------------------------------------------------------------------------------
+int ContentMapWidget::representative(int cell) const {
+
+	const int first = cell * pages_per_cell_;
+	const int last  = qMin(first + pages_per_cell_, pages_.size());
+
+	int best = -1;
+	for(int i = first; i < last; ++i) {
+		if(best == -1 || rank(pages_[i].content) > rank(pages_[best].content) || (pages_[i].content == pages_[best].content && pages_[i].entropy > pages_[best].entropy)) {
+			best = i;
+		}
+	}
+
+	return best;
+}
+
+//------------------------------------------------------------------------------
+// Name: layout_cells
+// Desc: picks the biggest cells which still fit every page in, several pages
+//       to a cell if even single pixels won't do, and draws them into image_
+//------------------------------------------------------------------------------
+void ContentMapWidget::layout_cells() {
+
+	const int w = qMax(width(), 1);
+	const int h = qMax(height(), 1);
+
+	cell_size_      = 1;
+	columns_        = w;
+	pages_per_cell_ = 1;
+
+	if(pages_.isEmpty()) {
+		image_ = QImage();
+		return;
+	}
+
+	const double area = static_cast<double>(w) * h / pages_.size();
+	cell_size_        = qBound(1, static_cast<int>(std::sqrt(area)), max_cell_size);
+	columns_          = qMax(w / cell_size_, 1);
+
+	const int rows  = qMax(h / cell_size_, 1);
+	const int cells = columns_ * rows;
+	pages_per_cell_ = (pages_.size() + cells - 1) / cells;
+
+	image_ = QImage(columns_, rows, QImage::Format_RGB32);
+	image_.fill(palette().color(QPalette::Window).rgb());
+
+	for(int cell = 0; cell < cells; ++cell) {
+		const int page = representative(cell);
+		if(page == -1) {
+			break;
+		}
+
+		image_.setPixel(cell % columns_, cell / columns_, page_color(pages_[page]));
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: page_at
+// Desc: the index of the page drawn at <pos>, or -1
+//------------------------------------------------------------------------------
+int ContentMapWidget::page_at(const QPoint &pos) const {
+
+	if(image_.isNull() || pos.x() < 0 || pos.y() < 0) {
+		return -1;
+	}
+
+	const int column = pos.x() / cell_size_;
+	const int row    = pos.y() / cell_size_;
+	if(column >= image_.width() || row >= image_.height()) {
+		return -1;
+	}
+
+	return representative(row * columns_ + column);
+}
+
+//------------------------------------------------------------------------------
+// Name: paintEvent
+// Desc:
+//------------------------------------------------------------------------------
+void ContentMapWidget::paintEvent(QPaintEvent *event) {
+	Q_UNUSED(event);
+
+	QPainter painter(this);
+	if(!image_.isNull()) {
+		painter.drawImage(QRect(0, 0, image_.width() * cell_size_, image_.height() * cell_size_), image_);
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: resizeEvent
+// Desc:
+//------------------------------------------------------------------------------
+void ContentMapWidget::resizeEvent(QResizeEvent *event) {
+	QWidget::resizeEvent(event);
+	layout_cells();
+}
+
+//------------------------------------------------------------------------------
+// Name: mousePressEvent
+// Desc:
+//------------------------------------------------------------------------------
+void ContentMapWidget::mousePressEvent(QMouseEvent *event) {
+	if(event->button() == Qt::LeftButton) {
+		const int page = page_at(event->pos());
+		if(page != -1) {
+			Q_EMIT pageClicked(pages_[page].address);
+		}
+	}
+
+	QWidget::mousePressEvent(event);
+}
+
+//------------------------------------------------------------------------------
+// Name: event
+// Desc: the tooltip says what the page under the mouse holds
+//------------------------------------------------------------------------------
+bool ContentMapWidget::event(QEvent *event) {
+
+	if(event->type() == QEvent::ToolTip) {
+		const QHelpEvent *const help_event = static_cast<QHelpEvent *>(event);
+
+		const int page = page_at(help_event->pos());
+		if(page != -1) {
+			const ContentMap::Page &p = pages_[page];
+			QToolTip::showText(help_event->globalPos(), tr("%1: %2, %3 bits/byte").arg(edb::v1::format_pointer(p.address), content_name(p.content)).arg(p.entropy, 0, 'f', 2));
+		} else {
+			QToolTip::hideText();
+			event->ignore();
+		}
+
+		return true;
+	}
+
+	return QWidget::event(event);
+}
@@ -0,0 +1,65 @@
+/*
+Copyright (C) 2006 - 2015 Evan Teran
+                          evan.teran@gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef CONTENTMAPWIDGET_20261014_H_
+#define CONTENTMAPWIDGET_20261014_H_
+
+#include "ContentMap.h"
+#include <QImage>
+#include <QVector>
+#include <QWidget>
+
+// draws a ContentMap as a grid of cells, one page after another with the gaps
+// between regions left out. When there are more pages than cells, each cell
+// shows the most interesting of its pages, so lone code or key pages don't
+// vanish among zeros
+class ContentMapWidget : public QWidget {
+	Q_OBJECT
+
+public:
+	ContentMapWidget(QWidget *parent = 0);
+
+public:
+	virtual QSize sizeHint() const;
+
+public:
+	void setPages(const QVector<ContentMap::Page> &pages);
+	void clear();
+
+Q_SIGNALS:
+	void pageClicked(edb::address_t address);
+
+protected:
+	virtual bool event(QEvent *event);
+	virtual void mousePressEvent(QMouseEvent *event);
+	virtual void paintEvent(QPaintEvent *event);
+	virtual void resizeEvent(QResizeEvent *event);
+
+private:
+	int page_at(const QPoint &pos) const;
+	int representative(int cell) const;
+	void layout_cells();
+
+private:
+	QVector<ContentMap::Page> pages_;
+	QImage                    image_;
+	int                       cell_size_;
+	int                       columns_;
+	int                       pages_per_cell_;
+};
+
+#endif
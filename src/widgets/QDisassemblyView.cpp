@@ -17,6 +17,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
 #include "QDisassemblyView.h"
+#include "Annotations.h"
 #include "Configuration.h"
 #include "edb.h"
 #include "IAnalyzer.h"
@@ -24,13 +25,18 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "IDebugger.h"
 #include "ISymbolManager.h"
 #include "Instruction.h"
+#include "InstructionCache.h"
+#include "InstructionLength.h"
+#include "InstructionTextCache.h"
 #include "SyntaxHighlighter.h"
+#include "Trace.h"
 #include "Util.h"
 
 #include <QAbstractItemDelegate>
 #include <QAbstractTextDocumentLayout>
 #include <QApplication>
 #include <QDebug>
+#include <QFileInfo>
 #include <QMouseEvent>
 #include <QPainter>
 #include <QPixmap>
@@ -38,6 +44,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <QTextDocument>
 #include <QTextLayout>
 #include <QToolTip>
+#include <QVector>
 #include <QtGlobal>
 #include <climits>
 
@@ -49,6 +56,17 @@ const QColor default_dis_color = Qt::blue;
 const QColor invalid_dis_color = Qt::blue;
 const QColor data_dis_color    = Qt::blue;
 
+// how far back of a line with no known predecessor the line index starts
+// walking when there is no function to start from, x86 decoding has almost
+// always fallen into step with the real instructions well within this
+const edb::address_t line_index_backtrack = 256;
+
+// the line index is simply thrown away once it holds this many lines
+const int line_index_max_lines = 65536;
+
+// how many highlighted instructions are kept around ready to be drawn
+const int opcode_cache_size = 1024;
+
 //------------------------------------------------------------------------------
 // Name:
 // Desc:
@@ -62,49 +80,27 @@ void draw_rich_text(QPainter *painter, int x, int y, const QTextDocument &text)
 	painter->restore();
 }
 
-struct show_separator_tag {};
-
-template <class T, size_t N>
-struct address_format {};
-
-template <class T>
-struct address_format<T, 4> {
-	static QString format_address(T address, const show_separator_tag&) {
-		static char buffer[10];
-		qsnprintf(buffer, sizeof(buffer), "%04x:%04x", (address >> 16) & 0xffff, address & 0xffff);
-		return QString::fromLatin1(buffer, sizeof(buffer) - 1);
-	}
+//------------------------------------------------------------------------------
+// Name: format_address
+// Desc: writes <address> into <text> as hex digits, with a ':' between the
+//       two halves if <show_separator> is set, reusing the buffer <text>
+//       already has
+//------------------------------------------------------------------------------
+void format_address(edb::address_t address, bool show_separator, QString *text) {
 
-	static QString format_address(T address) {
-		static char buffer[9];
-		qsnprintf(buffer, sizeof(buffer), "%04x%04x", (address >> 16) & 0xffff, address & 0xffff);
-		return QString::fromLatin1(buffer, sizeof(buffer) - 1);
-	}
-};
-
-template <class T>
-struct address_format<T, 8> {
-	static QString format_address(T address, const show_separator_tag&) {
-		static char buffer[18];
-		qsnprintf(buffer, sizeof(buffer), "%08x:%08x", (address >> 32) & 0xffffffff, address & 0xffffffff);
-		return QString::fromLatin1(buffer, sizeof(buffer) - 1);
-	}
+	const int digits = sizeof(edb::address_t) * 2;
 
-	static QString format_address(T address) {
-		static char buffer[17];
-		qsnprintf(buffer, sizeof(buffer), "%08x%08x", (address >> 32) & 0xffffffff, address & 0xffffffff);
-		return QString::fromLatin1(buffer, sizeof(buffer) - 1);
+	char buffer[digits + 1];
+	char *p = buffer;
+	if(show_separator) {
+		p = util::format_hex(address >> (digits * 2), digits / 2, p);
+		*p++ = ':';
+		p = util::format_hex(address, digits / 2, p);
+	} else {
+		p = util::format_hex(address, digits, p);
 	}
-};
 
-//------------------------------------------------------------------------------
-// Name:
-// Desc:
-//------------------------------------------------------------------------------
-template <class T>
-QString format_address(T address, bool show_separator) {
-	if(show_separator) return address_format<T, sizeof(T)>::format_address(address, show_separator_tag());
-	else               return address_format<T, sizeof(T)>::format_address(address);
+	util::assign_latin1(text, buffer, static_cast<int>(p - buffer));
 }
 
 //------------------------------------------------------------------------------
@@ -116,10 +112,14 @@ bool near_line(int x, int linex) {
 }
 
 //------------------------------------------------------------------------------
-// Name:
-// Desc:
+// Name: instruction_size
+// Desc: only what the length decoder can't say goes to the full decoder
 //------------------------------------------------------------------------------
 int instruction_size(const quint8 *buffer, std::size_t size) {
+	if(const std::size_t length = edb::instruction_length(buffer, size)) {
+		return length;
+	}
+
 	edb::Instruction inst(buffer, buffer + size, 0, std::nothrow);
 	return inst.size();
 }
@@ -139,12 +139,16 @@ size_t length_disasm_back(const quint8 *buf, size_t size) {
 
 	while(offs < edb::Instruction::MAX_SIZE) {
 
-		const edb::Instruction inst(tmp + offs, tmp + sizeof(tmp), 0, std::nothrow);
-		if(!inst) {
-			return 0;
+		size_t cmdsize = edb::instruction_length(tmp + offs, sizeof(tmp) - offs);
+		if(cmdsize == 0) {
+			const edb::Instruction inst(tmp + offs, tmp + sizeof(tmp), 0, std::nothrow);
+			if(!inst) {
+				return 0;
+			}
+
+			cmdsize = inst.size();
 		}
 
-		const size_t cmdsize = inst.size();
 		offs += cmdsize;
 
 		if(offs == edb::Instruction::MAX_SIZE) {
@@ -192,7 +196,11 @@ QDisassemblyView::QDisassemblyView(QWidget * parent) : QAbstractScrollArea(paren
 		moving_line1_(false),
 		moving_line2_(false),
 		moving_line3_(false),
-		comments_(new QHash<edb::address_t, QString>) {
+		scroll_offset_(0),
+		scroll_shift_(0),
+		line_index_generation_(0) {
+
+	opcode_cache_.setMaxCost(opcode_cache_size);
 
 
 	setShowAddressSeparator(true);
@@ -202,6 +210,7 @@ QDisassemblyView::QDisassemblyView(QWidget * parent) : QAbstractScrollArea(paren
 	setVerticalScrollBarPolicy(Qt::ScrollBarAlwaysOn);
 
 	connect(verticalScrollBar(), SIGNAL(actionTriggered(int)), this, SLOT(scrollbar_action_triggered(int)));
+	connect(verticalScrollBar(), SIGNAL(valueChanged(int)), this, SLOT(scrollbar_value_changed(int)));
 }
 
 //------------------------------------------------------------------------------
@@ -216,9 +225,9 @@ QDisassemblyView::~QDisassemblyView() {
 //------------------------------------------------------------------------------
 void QDisassemblyView::keyPressEvent(QKeyEvent *event) {
 	if (event->matches(QKeySequence::MoveToStartOfDocument)) {
-		verticalScrollBar()->setValue(0);
+		set_scroll_offset(0);
 	} else if (event->matches(QKeySequence::MoveToEndOfDocument)) {
-		verticalScrollBar()->setValue(verticalScrollBar()->maximum());
+		set_scroll_offset(index_lines_before(address_offset_ + max_scroll_offset()) - address_offset_);
 	} else if (event->matches(QKeySequence::MoveToNextLine)) {
 		scrollbar_action_triggered(QAbstractSlider::SliderSingleStepAdd);
 	} else if (event->matches(QKeySequence::MoveToPreviousLine)) {
@@ -231,69 +240,127 @@ void QDisassemblyView::keyPressEvent(QKeyEvent *event) {
 }
 
 //------------------------------------------------------------------------------
-// Name: previous_instructions
-// Desc: attempts to find the address of the instruction <count> instructions
-//       before <current_address>
-// Note: <current_address> is a 0 based value relative to the begining of the
-//       current region, not an absolute address within the program
+// Name: sync_line_index
+// Desc: forgets the line index if the process's memory has changed since it
+//       was built
 //------------------------------------------------------------------------------
-edb::address_t QDisassemblyView::previous_instructions(edb::address_t current_address, int count) {
+void QDisassemblyView::sync_line_index() {
+
+	IProcess *const process  = edb::v1::debugger_core ? edb::v1::debugger_core->process() : 0;
+	const quint64 generation = process ? process->memory_generation() : 0;
+
+	if(generation != line_index_generation_ || generation == 0) {
+		line_index_.clear();
+		line_index_generation_ = generation;
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: record_line
+// Desc: notes that the line at <address> is followed by the one at <next>
+//------------------------------------------------------------------------------
+void QDisassemblyView::record_line(edb::address_t address, edb::address_t next) {
+
+	if(line_index_.size() >= line_index_max_lines) {
+		line_index_.clear();
+	}
+
+	line_index_.insert(next, address);
+}
+
+//------------------------------------------------------------------------------
+// Name: index_lines_before
+// Desc: walks forward to <address> from the start of the function it is in,
+//       or from a little way back if there isn't one, noting where each line
+//       starts on the way. Scrolling up through all of those lines then
+//       costs nothing more. Lines break up the same way paintEvent does it.
+//       Returns the start of the line <address> is in, which is <address>
+//       itself if the walk can't be done
+//------------------------------------------------------------------------------
+edb::address_t QDisassemblyView::index_lines_before(edb::address_t address) {
+
+	if(!region_ || address <= region_->start() || address >= region_->end()) {
+		return address;
+	}
+
+	edb::address_t start = region_->start();
+	if(address - start > line_index_backtrack) {
+		start = address - line_index_backtrack;
+	}
 
 	IAnalyzer *const analyzer = edb::v1::analyzer();
+	if(analyzer && analyzer->category(address) != IAnalyzer::ADDRESS_FUNC_START) {
+		bool ok;
+		const edb::address_t function = analyzer->find_containing_function(address, &ok);
+		if(ok && function < address && function >= region_->start()) {
+			start = function;
+		}
+	}
 
-	for(int i = 0; i < count; ++i) {
+	IProcess *const process = edb::v1::debugger_core ? edb::v1::debugger_core->process() : 0;
+	if(!process) {
+		return address;
+	}
 
-		// If we have an analyzer, and the current address is within a function
-		// then first we find the begining of that function.
-		// Then, we attempt to disassemble from there until we run into
-		// the address we were on (stopping one instruction early).
-		// this allows us to identify with good accuracy where the
-		// previous instruction was making upward scrolling more functional.
-		//
-		// If all else fails, fall back on the old heuristic which works "ok"
-		if(analyzer) {
-			edb::address_t address = address_offset_ + current_address;
+	// one read for the whole walk, allowing for the last line to run past
+	// <address> but not past the region end
+	QVector<quint8> buffer(qMin<edb::address_t>(region_->end() - start, address - start + edb::Instruction::MAX_SIZE));
+	if(!process->read_bytes(start, buffer.data(), buffer.size())) {
+		return address;
+	}
 
-			const IAnalyzer::AddressCategory cat = analyzer->category(address);
+	const quint8 *const last = buffer.constData() + buffer.size();
 
-			// find the containing function
-			bool ok;
-			address = analyzer->find_containing_function(address, &ok);
+	edb::address_t line    = address;
+	edb::address_t current = start;
+	while(current < address) {
+		const quint8 *const p = buffer.constData() + (current - start);
 
-			if(ok && cat != IAnalyzer::ADDRESS_FUNC_START) {
+		int size;
+		if(analyzer && analyzer->category(current + 1) == IAnalyzer::ADDRESS_FUNC_START) {
+			size = 1;
+		} else {
+			size = edb::v1::instruction_cache().decode(current, p, last)->size();
+		}
 
-				// disassemble from function start until the NEXT address is where we started
-				while(true) {
-					quint8 buf[edb::Instruction::MAX_SIZE];
+		if(size == 0) {
+			break;
+		}
 
-					int buf_size = sizeof(buf);
-					if(region_) {
-						buf_size = qMin<edb::address_t>((address - region_->base()), sizeof(buf));
-					}
+		record_line(current, current + size);
+		line     = current;
+		current += size;
+	}
 
-					if(edb::v1::get_instruction_bytes(address, buf, &buf_size)) {
-						const edb::Instruction inst(buf, buf + buf_size, address, std::nothrow);
-						if(!inst) {
-							break;
-						}
+	return (current == address) ? address : line;
+}
 
-						// if the NEXT address would be our target, then
-						// we are at the previous instruction!
-						if(address + inst.size() >= current_address + address_offset_) {
-							break;
-						}
+//------------------------------------------------------------------------------
+// Name: previous_instructions
+// Desc: goes <count> lines up from <current_address>, using the line index
+//       where it can and filling it in where it can't
+//------------------------------------------------------------------------------
+edb::address_t QDisassemblyView::previous_instructions(edb::address_t current_address, int count) {
 
-						address += inst.size();
-					}
-				}
+	sync_line_index();
 
-				current_address = (address - address_offset_);
-				continue;
-			}
+	for(int i = 0; i < count; ++i) {
+
+		const edb::address_t address = address_offset_ + current_address;
+
+		QHash<edb::address_t, edb::address_t>::const_iterator it = line_index_.find(address);
+		if(it == line_index_.end()) {
+			index_lines_before(address);
+			it = line_index_.find(address);
 		}
 
+		if(it != line_index_.end()) {
+			current_address = it.value() - address_offset_;
+			continue;
+		}
 
-		// fall back on the old heuristic
+		// fall back on the old heuristic, the walk never lined up with
+		// <address>, so it may well be in the middle of an instruction
 		quint8 buf[edb::Instruction::MAX_SIZE];
 
 		int buf_size = sizeof(buf);
@@ -324,28 +391,23 @@ edb::address_t QDisassemblyView::previous_instructions(edb::address_t current_ad
 //------------------------------------------------------------------------------
 edb::address_t QDisassemblyView::following_instructions(edb::address_t current_address, int count) {
 
-	for(int i = 0; i < count; ++i) {
+	sync_line_index();
 
-		quint8 buf[edb::Instruction::MAX_SIZE + 1];
+	for(int i = 0; i < count; ++i) {
 
 		// do the longest read we can while still not passing the region end
-		int buf_size = sizeof(buf);
+		int buf_size = edb::Instruction::MAX_SIZE;
 		if(region_) {
-			buf_size = qMin<edb::address_t>((region_->end() - current_address), sizeof(buf));
+			buf_size = qMin<edb::address_t>((region_->end() - current_address), buf_size);
 		}
 
-		// read in the bytes...
-		if(!edb::v1::get_instruction_bytes(address_offset_ + current_address, buf, &buf_size)) {
+		const InstructionCache::pointer inst = edb::v1::instruction_cache().find(address_offset_ + current_address, buf_size);
+		if(inst && *inst) {
+			record_line(address_offset_ + current_address, address_offset_ + current_address + inst->size());
+			current_address += inst->size();
+		} else {
 			current_address += 1;
 			break;
-		} else {
-			const edb::Instruction inst(buf, buf + buf_size, current_address, std::nothrow);
-			if(inst) {
-				current_address += inst.size();
-			} else {
-				current_address += 1;
-				break;
-			}
 		}
 	}
 
@@ -368,15 +430,66 @@ void QDisassemblyView::wheelEvent(QWheelEvent *e) {
 
 	if(e->delta() > 0) {
 		// scroll up
-		edb::address_t address = verticalScrollBar()->value();
-		address = previous_instructions(address, scroll_count);
-		verticalScrollBar()->setValue(address);
+		set_scroll_offset(previous_instructions(scroll_offset_, scroll_count));
 	} else {
 		// scroll down
-		edb::address_t address = verticalScrollBar()->value();
-		address = following_instructions(address, scroll_count);
-		verticalScrollBar()->setValue(address);
+		set_scroll_offset(following_instructions(scroll_offset_, scroll_count));
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: max_scroll_offset
+// Desc: the furthest into the region the first line shown can be
+//------------------------------------------------------------------------------
+edb::address_t QDisassemblyView::max_scroll_offset() const {
+	if(region_) {
+		const edb::address_t total_lines    = region_->size();
+		const edb::address_t viewable_lines = viewport()->height() / line_height();
+		return (total_lines > viewable_lines) ? total_lines - 1 : 0;
+	}
+
+	return 0;
+}
+
+//------------------------------------------------------------------------------
+// Name: set_scroll_offset
+// Desc: makes the line <offset> bytes past address_offset_ the first one
+//       shown, and moves the scrollbar to match
+//------------------------------------------------------------------------------
+void QDisassemblyView::set_scroll_offset(edb::address_t offset) {
+
+	// previous_instructions wraps around if it runs into the region start,
+	// anything that far out can only have come from there
+	const edb::address_t region_size = region_ ? region_->size() : 0;
+	const edb::address_t max_offset  = max_scroll_offset();
+	if(offset > region_size + edb::Instruction::MAX_SIZE) {
+		offset = 0;
+	} else if(offset > max_offset) {
+		offset = max_offset;
 	}
+
+	scroll_offset_ = offset;
+
+	// the scrollbar may not move at all when it is scaled, so the repaint
+	// can't be left to it
+	verticalScrollBar()->setSliderPosition(static_cast<int>(offset >> scroll_shift_));
+	viewport()->update();
+}
+
+//------------------------------------------------------------------------------
+// Name: scrollbar_value_changed
+// Desc: a value which doesn't agree with scroll_offset_ came from the user
+//       dragging the slider (or Qt clamping it), so it is turned back into an
+//       offset and moved back to the start of the line it lands in
+//------------------------------------------------------------------------------
+void QDisassemblyView::scrollbar_value_changed(int value) {
+
+	if(static_cast<int>(scroll_offset_ >> scroll_shift_) == value) {
+		return;
+	}
+
+	const edb::address_t offset = static_cast<edb::address_t>(value) << scroll_shift_;
+	scroll_offset_ = index_lines_before(address_offset_ + offset) - address_offset_;
 }
 
 //------------------------------------------------------------------------------
@@ -391,32 +504,16 @@ void QDisassemblyView::scrollbar_action_triggered(int action) {
 
 	switch(action) {
 	case QAbstractSlider::SliderSingleStepSub:
-		{
-			edb::address_t address = verticalScrollBar()->value();
-			address = previous_instructions(address, 1);
-			verticalScrollBar()->setSliderPosition(address);
-		}
+		set_scroll_offset(previous_instructions(scroll_offset_, 1));
 		break;
 	case QAbstractSlider::SliderPageStepSub:
-		{
-			edb::address_t address = verticalScrollBar()->value();
-			address = previous_instructions(address, verticalScrollBar()->pageStep());
-			verticalScrollBar()->setSliderPosition(address);
-		}
+		set_scroll_offset(previous_instructions(scroll_offset_, verticalScrollBar()->pageStep()));
 		break;
 	case QAbstractSlider::SliderSingleStepAdd:
-		{
-			edb::address_t address = verticalScrollBar()->value();
-			address = following_instructions(address, 1);
-			verticalScrollBar()->setSliderPosition(address);
-		}
+		set_scroll_offset(following_instructions(scroll_offset_, 1));
 		break;
 	case QAbstractSlider::SliderPageStepAdd:
-		{
-			edb::address_t address = verticalScrollBar()->value();
-			address = following_instructions(address, verticalScrollBar()->pageStep());
-			verticalScrollBar()->setSliderPosition(address);
-		}
+		set_scroll_offset(following_instructions(scroll_offset_, verticalScrollBar()->pageStep()));
 		break;
 
 	case QAbstractSlider::SliderToMinimum:
@@ -441,7 +538,9 @@ void QDisassemblyView::setShowAddressSeparator(bool value) {
 // Desc:
 //------------------------------------------------------------------------------
 QString QDisassemblyView::formatAddress(edb::address_t address) const {
-	return format_address(address, show_address_separator_);
+	QString text;
+	format_address(address, show_address_separator_, &text);
+	return text;
 }
 
 //------------------------------------------------------------------------------
@@ -484,6 +583,7 @@ void QDisassemblyView::setRegion(const IRegion::pointer &r) {
 	// reset region, so we don't bother check that condition
 	if((r && r->compare(region_) != 0) || (!r)) {
 		region_ = r;
+		line_index_.clear();
 		updateScrollbars();
 		emit regionChanged();
 	}
@@ -511,18 +611,40 @@ void QDisassemblyView::setAddressOffset(edb::address_t address) {
 // Desc:
 //------------------------------------------------------------------------------
 void QDisassemblyView::scrollTo(edb::address_t address) {
-	verticalScrollBar()->setValue(address - address_offset_);
+	set_scroll_offset((address > address_offset_) ? address - address_offset_ : 0);
 }
 
-struct intel_lower {
-	typedef edisassm::lower_case   case_type;
-	typedef edisassm::syntax_intel syntax_type;
-};
+//------------------------------------------------------------------------------
+// Name: highlighted_opcode
+// Desc: returns <opcode> syntax highlighted and laid out in the view's font.
+//       Most lines look the same from one repaint to the next, so the result
+//       is kept and only new text goes through the highlighter
+//------------------------------------------------------------------------------
+const QPixmap *QDisassemblyView::highlighted_opcode(const QString &opcode) const {
 
-struct intel_upper {
-	typedef edisassm::upper_case   case_type;
-	typedef edisassm::syntax_intel syntax_type;
-};
+	if(const QPixmap *const pixmap = opcode_cache_.object(opcode)) {
+		return pixmap;
+	}
+
+	QTextDocument doc;
+	doc.setDefaultFont(font());
+	doc.setDocumentMargin(0);
+	doc.setPlainText(opcode);
+	highlighter_->setDocument(&doc);
+
+	QPixmap *const pixmap = new QPixmap(doc.size().toSize() + QSize(1, 1));
+	pixmap->fill(Qt::transparent);
+
+	QPainter painter(pixmap);
+	painter.setPen(default_dis_color);
+	draw_rich_text(&painter, 0, 0, doc);
+	painter.end();
+
+	highlighter_->setDocument(0);
+
+	opcode_cache_.insert(opcode, pixmap);
+	return pixmap;
+}
 
 //------------------------------------------------------------------------------
 // Name: draw_instruction
@@ -535,11 +657,8 @@ int QDisassemblyView::draw_instruction(QPainter &painter, const edb::Instruction
 	const int ret         = inst.size();
 	
 	if(inst) {
-		QString opcode = QString::fromStdString(
-			upper ?
-				edisassm::to_string(inst, intel_upper()) :
-				edisassm::to_string(inst, intel_lower())
-		);
+		QString opcode;
+		edb::v1::instruction_text_cache().format(inst, upper, &opcode);
 
 		//return metrics.elidedText(byte_buffer, Qt::ElideRight, maxStringPx);
 
@@ -583,12 +702,9 @@ int QDisassemblyView::draw_instruction(QPainter &painter, const edb::Instruction
 			opcode = painter.fontMetrics().elidedText(opcode, Qt::ElideRight, (l3 - l2) - font_width_ * 2);
 
 			painter.setPen(default_dis_color);
-			QTextDocument doc;
-			doc.setDefaultFont(font());
-			doc.setDocumentMargin(0);
-			doc.setPlainText(opcode);
-			highlighter_->setDocument(&doc);
-			draw_rich_text(&painter, x, y, doc);
+			if(const QPixmap *const pixmap = highlighted_opcode(opcode)) {
+				painter.drawPixmap(x, y, *pixmap);
+			}
 		}
 
 	} else {
@@ -715,12 +831,14 @@ void QDisassemblyView::draw_function_markers(QPainter &painter, edb::address_t a
 //------------------------------------------------------------------------------
 void QDisassemblyView::paintEvent(QPaintEvent *) {
 
+	EDB_TRACE_SCOPE("QDisassemblyView::paintEvent");
+
 	QPainter painter(viewport());
 
 	const bool uppercase  = edb::v1::config().uppercase_disassembly;
 	const int line_height = qMax(this->line_height(), breakpoint_icon_.height());
 	int viewable_lines    = viewport()->height() / line_height;
-	int current_line      = verticalScrollBar()->value();
+	edb::address_t current_line = scroll_offset_;
 	int row_index         = 0;
 	int y                 = 0;
 	const int l1          = line1();
@@ -734,7 +852,7 @@ void QDisassemblyView::paintEvent(QPaintEvent *) {
 
 	// TODO: reimplement me
 	// const Configuration::Syntax syntax = edb::v1::config().syntax;
-	const int region_size = region_->size();
+	const edb::address_t region_size = region_->size();
 
 	if(region_size == 0) {
 		return;
@@ -755,40 +873,65 @@ void QDisassemblyView::paintEvent(QPaintEvent *) {
 	IAnalyzer *const analyzer = edb::v1::analyzer();
 
 	edb::address_t last_address = 0;
-	
-	// TODO: read larger chunks of data at a time
-	//       my gut tells me that 2 pages is probably enough
-	//       perhaps a page-cache in general using QCache
-	//       first. I am thinking that it should be safe to
-	//       store cache objects which represent 2 page blocks
-	//       keyed by the page contining the address we care about
-	//       so address: 0x1000 would have pages for [0x1000-0x3000)
-	//       and address 0x2000 would have pages for [0x2000-0x4000)
-	//       there is overlap, but i think it avoids page bounary issues
+
+	// everything which can be seen is read in one go, which is at most every
+	// line being as long as an instruction can be. The window never passes
+	// the region end
+	const edb::address_t window_address = address_offset_ + current_line;
+	std::size_t window_size = 0;
+	if(current_line < region_size) {
+		window_size = qMin<edb::address_t>(region_->end() - window_address, (viewable_lines + 1) * edb::Instruction::MAX_SIZE + 1);
+	}
+
+	sync_line_index();
+
+	QVector<quint8> window(window_size);
+	IProcess *const process = edb::v1::debugger_core ? edb::v1::debugger_core->process() : 0;
+	const bool window_read  = process && window_size != 0 && process->read_bytes(window_address, window.data(), window_size);
+
+	// the comments of everything which can be seen, the lines go up in
+	// address so they are walked through in step with them
+	Annotations::const_iterator comment_it;
+	Annotations::const_iterator comments_end;
+	edb::v1::annotations().range(Annotations::COMMENT, window_address, window_address + window_size, &comment_it, &comments_end);
+
+	// reused from one line to the next
+	QString address_buffer;
 
 	while(viewable_lines >= 0 && current_line < region_size) {
 		const edb::address_t address = address_offset_ + current_line;
 
-		quint8 buf[edb::Instruction::MAX_SIZE + 1];
+		quint8 line_buf[edb::Instruction::MAX_SIZE + 1];
+		const quint8 *buf = line_buf;
+		int buf_size;
 
-		// do the longest read we can while still not passing the region end
-		int buf_size = qMin<edb::address_t>((region_->end() - address), sizeof(buf));
-
-		// read in the bytes...
-		if(!edb::v1::get_instruction_bytes(address, buf, &buf_size)) {
-			// if the read failed, let's pretend that we were able to read a
-			// single 0xff byte so that we have _something_ to display.
-			buf_size = 1;
-			*buf = 0xff;
+		if(window_read && address - window_address < window_size) {
+			buf      = window.constData() + (address - window_address);
+			buf_size = window_size - (address - window_address);
+		} else {
+			// do the longest read we can while still not passing the region end
+			buf_size = qMin<edb::address_t>((region_->end() - address), sizeof(line_buf));
+
+			// read in the bytes...
+			if(!edb::v1::get_instruction_bytes(address, line_buf, &buf_size)) {
+				// if the read failed, let's pretend that we were able to read a
+				// single 0xff byte so that we have _something_ to display.
+				buf_size = 1;
+				*line_buf = 0xff;
+			}
 		}
 
 		// disassemble the instruction, if it happens that the next byte is the start of a known function
 		// then we should treat this like a one byte instruction
-		edb::Instruction inst(buf, buf + buf_size, address, std::nothrow);
+		InstructionCache::pointer decoded;
 		if(analyzer && (analyzer->category(address + 1) == IAnalyzer::ADDRESS_FUNC_START)) {
-			edb::Instruction(buf, buf + 1, address, std::nothrow).swap(inst);
+			decoded = InstructionCache::pointer(new edb::Instruction(buf, buf + 1, address, std::nothrow));
+		} else {
+			decoded = edb::v1::instruction_cache().decode(address, buf, buf + buf_size);
 		}
 
+		const edb::Instruction &inst = *decoded;
+
 		const int inst_size = inst.size();
 
 		if(inst_size == 0) {
@@ -828,7 +971,7 @@ void QDisassemblyView::paintEvent(QPaintEvent *) {
 
 		// format the different components
 		const QString byte_buffer    = format_instruction_bytes(inst, bytes_width, painter.fontMetrics());
-		const QString address_buffer = formatAddress(address);
+		format_address(address, show_address_separator_, &address_buffer);
 
 		// draw the address
 		painter.setPen(address_pen);
@@ -896,11 +1039,30 @@ void QDisassemblyView::paintEvent(QPaintEvent *) {
 
 		// draw the disassembly
 		current_line += draw_instruction(painter, inst, uppercase, y, line_height, l2, l3);
+		record_line(address, address_offset_ + current_line);
 		show_addresses_.insert(address);
 		last_address = address;
 
 		//Draw any comments
-		QString comment = comments_->value(address, QString(""));
+		QString comment;
+		while(comment_it != comments_end && comment_it->address < address) {
+			++comment_it;
+		}
+
+		if(comment_it != comments_end && comment_it->address == address) {
+			comment = comment_it->text;
+		}
+
+		// otherwise, say which source line starts here when there is debug info
+		if(comment.isEmpty()) {
+			QString source_file;
+			int source_line;
+			edb::address_t line_start;
+			if(edb::v1::symbol_manager().find_source_line(address, &source_file, &source_line, &line_start) && line_start == address) {
+				comment = QString("%1:%2").arg(QFileInfo(source_file).fileName()).arg(source_line);
+			}
+		}
+
 		if (!comment.isEmpty()) {
 			painter.drawText(
 						l3 + font_width_ + (font_width_ / 2),
@@ -938,6 +1100,8 @@ void QDisassemblyView::setFont(const QFont &f) {
 	font_width_  = metrics.width('X');
 	font_height_ = metrics.height();
 
+	opcode_cache_.clear();
+
 	updateScrollbars();
 }
 
@@ -962,15 +1126,16 @@ int QDisassemblyView::line_height() const {
 // Desc:
 //------------------------------------------------------------------------------
 void QDisassemblyView::updateScrollbars() {
-	if(region_) {
-		const unsigned int total_lines    = region_->size();
-		const unsigned int viewable_lines = viewport()->height() / line_height();
-		const unsigned int scroll_max     = (total_lines > viewable_lines) ? total_lines - 1 : 0;
 
-		verticalScrollBar()->setMaximum(scroll_max);
-	} else {
-		verticalScrollBar()->setMaximum(0);
+	// the smallest power of two scale which fits the region in an int
+	const edb::address_t scroll_max = max_scroll_offset();
+	scroll_shift_ = 0;
+	while((scroll_max >> scroll_shift_) > static_cast<edb::address_t>(INT_MAX)) {
+		++scroll_shift_;
 	}
+
+	verticalScrollBar()->setMaximum(static_cast<int>(scroll_max >> scroll_shift_));
+	set_scroll_offset(qMin(scroll_offset_, scroll_max));
 }
 
 //------------------------------------------------------------------------------
@@ -1098,7 +1263,7 @@ edb::address_t QDisassemblyView::address_from_coord(int x, int y) const {
 	Q_UNUSED(x);
 
 	const int line = y / line_height();
-	edb::address_t address = verticalScrollBar()->value();
+	edb::address_t address = scroll_offset_;
 
 	// add up all the instructions sizes up to the line we want
 	for(int i = 0; i < line; ++i) {
@@ -1150,15 +1315,12 @@ bool QDisassemblyView::event(QEvent *event) {
 
 				const edb::address_t address = addressFromPoint(helpEvent->pos());
 
-				quint8 buf[edb::Instruction::MAX_SIZE];
-
 				// do the longest read we can while still not passing the region end
-				int buf_size = qMin<edb::address_t>((region_->end() - address), sizeof(buf));
-				if(edb::v1::get_instruction_bytes(address, buf, &buf_size)) {
-					const edb::Instruction inst(buf, buf + buf_size, address, std::nothrow);
+				const int buf_size = qMin<edb::address_t>((region_->end() - address), edb::Instruction::MAX_SIZE);
+				if(const InstructionCache::pointer inst = edb::v1::instruction_cache().find(address, buf_size)) {
 
-					if((line1() + (static_cast<int>(inst.size()) * 3) * font_width_) > line2()) {
-						const QString byte_buffer = format_instruction_bytes(inst);
+					if((line1() + (static_cast<int>(inst->size()) * 3) * font_width_) > line2()) {
+						const QString byte_buffer = format_instruction_bytes(*inst);
 						QToolTip::showText(helpEvent->globalPos(), byte_buffer);
 						show = true;
 					}
@@ -1297,35 +1459,3 @@ int QDisassemblyView::selectedSize() const {
 IRegion::pointer QDisassemblyView::region() const {
 	return region_;
 }
-
-//------------------------------------------------------------------------------
-// Name: add_comment
-// Desc: Adds a comment to the comment hash.
-//------------------------------------------------------------------------------
-void QDisassemblyView::add_comment(edb::address_t address, QString comment) {
-	comments_->insert(address, comment);
-}
-
-//------------------------------------------------------------------------------
-// Name: remove_comment
-// Desc: Removes a comment from the comment hash and returns the number of comments removed.
-//------------------------------------------------------------------------------
-int QDisassemblyView::remove_comment(edb::address_t address) {
-	return comments_->remove(address);
-}
-
-//------------------------------------------------------------------------------
-// Name: get_comment
-// Desc: Returns a comment assigned for an address or a blank string if there is none.
-//------------------------------------------------------------------------------
-QString QDisassemblyView::get_comment(edb::address_t address) {
-	return comments_->value(address, QString(""));
-}
-
-//------------------------------------------------------------------------------
-// Name: clear_comments
-// Desc: Clears all comments in the comment hash.
-//------------------------------------------------------------------------------
-void QDisassemblyView::clear_comments() {
-	comments_->clear();
-}
@@ -24,6 +24,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <QAbstractScrollArea>
 #include <QAbstractSlider>
 #include <QCache>
+#include <QHash>
 #include <QPixmap>
 #include <QSet>
 
@@ -55,10 +56,6 @@ public:
 	edb::address_t addressFromPoint(const QPoint &pos) const;
 	edb::address_t selectedAddress() const;
 	int selectedSize() const;
-	void add_comment(edb::address_t address, QString comment);
-	int remove_comment(edb::address_t address);
-	QString get_comment(edb::address_t address);
-	void clear_comments();
 
 signals:
 	void signal_updated();
@@ -76,6 +73,7 @@ public Q_SLOTS:
 
 private Q_SLOTS:
 	void scrollbar_action_triggered(int action);
+	void scrollbar_value_changed(int value);
 
 signals:
 	void breakPointToggled(edb::address_t address);
@@ -87,6 +85,8 @@ private:
 	edb::address_t address_from_coord(int x, int y) const;
 	edb::address_t previous_instructions(edb::address_t current_address, int count);
 	edb::address_t following_instructions(edb::address_t current_address, int count);
+	edb::address_t index_lines_before(edb::address_t address);
+	edb::address_t max_scroll_offset() const;
 	int address_length() const;
 	int auto_line1() const;
 	int draw_instruction(QPainter &painter, const edb::Instruction &inst, bool upper, int y, int line_height, int l2, int l3) const;
@@ -96,6 +96,10 @@ private:
 	int line2() const;
 	int line3() const;
 	int line_height() const;
+	const QPixmap *highlighted_opcode(const QString &opcode) const;
+	void record_line(edb::address_t address, edb::address_t next);
+	void set_scroll_offset(edb::address_t offset);
+	void sync_line_index();
 	void draw_function_markers(QPainter &painter, edb::address_t address, int l2, int y, int inst_size, IAnalyzer *analyzer);
 	void updateScrollbars();
 	void updateSelectedAddress(QMouseEvent *event);
@@ -120,7 +124,22 @@ private:
 	bool                              moving_line2_;
 	bool                              moving_line3_;
 	bool                              show_address_separator_;
-	QHash<edb::address_t, QString>    *comments_;
+
+	// the offset of the first line shown from address_offset_. The scrollbar
+	// only has an int, so for regions too big for that it shows this shifted
+	// right by scroll_shift_ and is never read back while it still agrees
+	edb::address_t                    scroll_offset_;
+	int                               scroll_shift_;
+
+	// the start of the line before each line seen so far, so that scrolling
+	// up needn't work it out again. Only good while the process's memory
+	// generation stays the same
+	QHash<edb::address_t, edb::address_t> line_index_;
+	quint64                               line_index_generation_;
+
+	// highlighted instruction text keyed by the text itself, only good for
+	// the current font
+	mutable QCache<QString, QPixmap>      opcode_cache_;
 };
 
 #endif
@@ -19,12 +19,76 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "SyntaxHighlighter.h"
 #include <QSettings>
 
+namespace {
+
+//------------------------------------------------------------------------------
+// Name: is_word
+// Desc: true for the characters a word is made of, as \b sees them
+//------------------------------------------------------------------------------
+bool is_word(QChar ch) {
+	return ch.isLetterOrNumber() || ch == QLatin1Char('_');
+}
+
+//------------------------------------------------------------------------------
+// Name: is_number
+// Desc: true if <word> is a constant in octal, decimal or (0x) hex
+//------------------------------------------------------------------------------
+bool is_number(const QString &word) {
+
+	const int n = word.size();
+	if(n == 0 || word[0] < QLatin1Char('0') || word[0] > QLatin1Char('9')) {
+		return false;
+	}
+
+	if(word[0] == QLatin1Char('0')) {
+		if(n > 2 && (word[1] == QLatin1Char('x') || word[1] == QLatin1Char('X'))) {
+			for(int i = 2; i < n; ++i) {
+				const char ch = word[i].toLatin1();
+				if(!((ch >= '0' && ch <= '9') || (ch >= 'a' && ch <= 'f') || (ch >= 'A' && ch <= 'F'))) {
+					return false;
+				}
+			}
+			return true;
+		}
+
+		for(int i = 1; i < n; ++i) {
+			if(word[i] < QLatin1Char('0') || word[i] > QLatin1Char('7')) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	for(int i = 1; i < n; ++i) {
+		if(!word[i].isDigit()) {
+			return false;
+		}
+	}
+	return true;
+}
+
+//------------------------------------------------------------------------------
+// Name: theme_format
+// Desc: the format the theme gives <name>, or the default one
+//------------------------------------------------------------------------------
+QTextCharFormat theme_format(const QSettings &settings, const QString &name, const char *foreground, const char *background, int weight) {
+	QTextCharFormat format;
+	format.setForeground(QColor(settings.value(QString("theme.%1.foreground").arg(name), foreground).value<QString>()));
+	format.setBackground(QColor(settings.value(QString("theme.%1.background").arg(name), background).value<QString>()));
+	format.setFontWeight(settings.value(QString("theme.%1.weight").arg(name), weight).value<int>());
+	format.setFontItalic(settings.value(QString("theme.%1.italic").arg(name), false).value<bool>());
+	format.setFontUnderline(settings.value(QString("theme.%1.underline").arg(name), false).value<bool>());
+	return format;
+}
+
+}
+
 //------------------------------------------------------------------------------
 // Name: SyntaxHighlighter
 // Desc:
 //------------------------------------------------------------------------------
 SyntaxHighlighter::SyntaxHighlighter(QObject *parent) : QSyntaxHighlighter(parent) {
-	create_rules();
+	create_formats();
 }
 
 //------------------------------------------------------------------------------
@@ -32,7 +96,7 @@ SyntaxHighlighter::SyntaxHighlighter(QObject *parent) : QSyntaxHighlighter(paren
 // Desc:
 //------------------------------------------------------------------------------
 SyntaxHighlighter::SyntaxHighlighter(QTextDocument *parent) : QSyntaxHighlighter(parent) {
-	create_rules();
+	create_formats();
 }
 
 #if QT_VERSION < 0x050000
@@ -41,221 +105,179 @@ SyntaxHighlighter::SyntaxHighlighter(QTextDocument *parent) : QSyntaxHighlighter
 // Desc:
 //------------------------------------------------------------------------------
 SyntaxHighlighter::SyntaxHighlighter(QTextEdit *parent) : QSyntaxHighlighter(parent) {
-	create_rules();
+	create_formats();
 }
 #endif
 
 //------------------------------------------------------------------------------
-// Name: HighlightingRule::HighlightingRule
-// Desc:
+// Name: add_words
+// Desc: <words> ends with a null
 //------------------------------------------------------------------------------
-SyntaxHighlighter::HighlightingRule::HighlightingRule() {
-
-}
-
-//------------------------------------------------------------------------------
-// Name: HighlightingRule::HighlightingRule
-// Desc:
-//------------------------------------------------------------------------------
-SyntaxHighlighter::HighlightingRule::HighlightingRule(const QString &regex, const QBrush &foreground, const QBrush &background, int weight, bool italic, bool underline) : pattern(regex) {
-	pattern.setCaseSensitivity(Qt::CaseInsensitive);
-
-	format.setForeground(foreground);
-	format.setBackground(background);
-	format.setFontWeight(weight);
-	format.setFontItalic(italic);
-	format.setFontUnderline(underline);
+void SyntaxHighlighter::add_words(const char *const *words, Token token) {
+	for(; *words; ++words) {
+		words_.insert(QLatin1String(*words), token);
+	}
 }
 
 //------------------------------------------------------------------------------
-// Name: create_rules
+// Name: create_formats
 // Desc:
 //------------------------------------------------------------------------------
-void SyntaxHighlighter::create_rules() {
+void SyntaxHighlighter::create_formats() {
 
-	// TODO: make these rules be implemented in a portable way
+	// TODO: make these words be implemented in a portable way
 	// right now things are very much hard coded
-	
+
 	// TODO: support segments
 
 	QSettings settings;
 	settings.beginGroup("Theme");
 
-	// comma
-	rules_.append(HighlightingRule(
-		"(,)",
-		QColor(settings.value("theme.brackets.foreground", "blue").value<QString>()),
-		QColor(settings.value("theme.brackets.background", "transparent").value<QString>()),
-		settings.value("theme.brackets.weight", QFont::Normal).value<int>(),
-		settings.value("theme.brackets.italic", false).value<bool>(),
-		settings.value("theme.brackets.underline", false).value<bool>()
-		));
-
-	// expression brackets
-	rules_.append(HighlightingRule(
-		"([\\[\\]])",
-		QColor(settings.value("theme.brackets.foreground", "blue").value<QString>()),
-		QColor(settings.value("theme.brackets.background", "transparent").value<QString>()),
-		settings.value("theme.brackets.weight", QFont::Normal).value<int>(),
-		settings.value("theme.brackets.italic", false).value<bool>(),
-		settings.value("theme.brackets.underline", false).value<bool>()
-		));
-
-	// math operators
-	rules_.append(HighlightingRule(
-		"\\b([\\+\\-\\*])\\b",
-		QColor(settings.value("theme.operator.foreground", "blue").value<QString>()),
-		QColor(settings.value("theme.operator.background", "transparent").value<QString>()),
-		settings.value("theme.operator.weight", QFont::Normal).value<int>(),
-		settings.value("theme.operator.italic", false).value<bool>(),
-		settings.value("theme.operator.underline", false).value<bool>()
-		));
+	formats_[TOKEN_BRACKETS]   = theme_format(settings, "brackets",   "blue",      "transparent", QFont::Normal);
+	formats_[TOKEN_OPERATOR]   = theme_format(settings, "operator",   "blue",      "transparent", QFont::Normal);
+	formats_[TOKEN_REGISTER]   = theme_format(settings, "register",   "red",       "transparent", QFont::Bold);
+	formats_[TOKEN_CONSTANT]   = theme_format(settings, "constant",   "black",     "transparent", QFont::Normal);
+	formats_[TOKEN_PTR]        = theme_format(settings, "ptr",        "darkGreen", "transparent", QFont::Normal);
+	formats_[TOKEN_PREFIX]     = theme_format(settings, "prefix",     "black",     "transparent", QFont::Bold);
+	formats_[TOKEN_FLOW_CTRL]  = theme_format(settings, "flow_ctrl",  "blue",      "yellow",      QFont::Normal);
+	formats_[TOKEN_FUNCTION]   = theme_format(settings, "function",   "blue",      "yellow",      QFont::Normal);
+	formats_[TOKEN_STACK]      = theme_format(settings, "stack",      "blue",      "transparent", QFont::Normal);
+	formats_[TOKEN_COMPARISON] = theme_format(settings, "comparison", "blue",      "transparent", QFont::Normal);
+	formats_[TOKEN_DATA_XFER]  = theme_format(settings, "data_xfer",  "blue",      "transparent", QFont::Normal);
+	formats_[TOKEN_ARITHMETIC] = theme_format(settings, "arithmetic", "blue",      "transparent", QFont::Normal);
+	formats_[TOKEN_LOGIC]      = theme_format(settings, "logic",      "blue",      "transparent", QFont::Normal);
+	formats_[TOKEN_SHIFT]      = theme_format(settings, "shift",      "blue",      "transparent", QFont::Normal);
+	formats_[TOKEN_SYSTEM]     = theme_format(settings, "system",     "blue",      "transparent", QFont::Bold);
 
 	// registers
 	// TODO: support ST(N)
-	rules_.append(HighlightingRule(
-		"\\b(((e|r)?(ax|bx|cx|dx|bp|sp|si|di|ip))|([abcd](l|h))|(sp|bp|si|di)l|([cdefgs]s)|(x?mm[0-7])|r(8|9|(1[0-5]))[dwb]?)\\b",
-		QColor(settings.value("theme.register.foreground", "red").value<QString>()),
-		QColor(settings.value("theme.register.background", "transparent").value<QString>()),
-		settings.value("theme.register.weight", QFont::Bold).value<int>(),
-		settings.value("theme.register.italic", false).value<bool>(),
-		settings.value("theme.register.underline", false).value<bool>()
-		));
-
-	// constants
-	rules_.append(HighlightingRule(
-		"\\b((0[0-7]*)|(0(x|X)[0-9a-fA-F]+)|([1-9][0-9]*))\\b",
-		QColor(settings.value("theme.constant.foreground", "black").value<QString>()),
-		QColor(settings.value("theme.constant.background", "transparent").value<QString>()),
-		settings.value("theme.constant.weight", QFont::Normal).value<int>(),
-		settings.value("theme.constant.italic", false).value<bool>(),
-		settings.value("theme.constant.underline", false).value<bool>()
-		));
-
-	// pointer modifiers
-	rules_.append(HighlightingRule(
-		"\\b(t?byte|(xmm|[qdf]?)word) ptr\\b",
-		QColor(settings.value("theme.ptr.foreground", "darkGreen").value<QString>()),
-		QColor(settings.value("theme.ptr.background", "transparent").value<QString>()),
-		settings.value("theme.ptr.weight", QFont::Normal).value<int>(),
-		settings.value("theme.ptr.italic", false).value<bool>(),
-		settings.value("theme.ptr.underline", false).value<bool>()
-		));
-
-	// prefix
-	rules_.append(HighlightingRule(
-		"\\b(lock|rep(ne)?)\\b",
-		QColor(settings.value("theme.prefix.foreground", "black").value<QString>()),
-		QColor(settings.value("theme.prefix.background", "transparent").value<QString>()),
-		settings.value("theme.prefix.weight", QFont::Bold).value<int>(),
-		settings.value("theme.prefix.italic", false).value<bool>(),
-		settings.value("theme.prefix.underline", false).value<bool>()
-		));
-
-
-	// flow control
-	rules_.append(HighlightingRule(
-		"\\b(jmp|jn?[blopsz]|jn?[bl]e|jcez|loopn?[ez])\\b",
-		QColor(settings.value("theme.flow_ctrl.foreground", "blue").value<QString>()),
-		QColor(settings.value("theme.flow_ctrl.background", "yellow").value<QString>()),
-		settings.value("theme.flow_ctrl.weight", QFont::Normal).value<int>(),
-		settings.value("theme.flow_ctrl.italic", false).value<bool>(),
-		settings.value("theme.flow_ctrl.underline", false).value<bool>()
-		));
-
-	// function call
-	rules_.append(HighlightingRule(
-		"\\b(call|retn?)\\b",
-		QColor(settings.value("theme.function.foreground", "blue").value<QString>()),
-		QColor(settings.value("theme.function.background", "yellow").value<QString>()),
-		settings.value("theme.function.weight", QFont::Normal).value<int>(),
-		settings.value("theme.function.italic", false).value<bool>(),
-		settings.value("theme.function.underline", false).value<bool>()
-		));
-
-	// stack operations
-	rules_.append(HighlightingRule(
-		"\\b(pushf?|popf?|enter|leave)\\b",
-		QColor(settings.value("theme.stack.foreground", "blue").value<QString>()),
-		QColor(settings.value("theme.stack.background", "transparent").value<QString>()),
-		settings.value("theme.stack.weight", QFont::Normal).value<int>(),
-		settings.value("theme.stack.italic", false).value<bool>(),
-		settings.value("theme.stack.underline", false).value<bool>()
-		));
-
-	// comparison
-	rules_.append(HighlightingRule(
-		"\\b(cmp|test)\\b",
-		QColor(settings.value("theme.comparison.foreground", "blue").value<QString>()),
-		QColor(settings.value("theme.comparison.background", "transparent").value<QString>()),
-		settings.value("theme.comparison.weight", QFont::Normal).value<int>(),
-		settings.value("theme.comparison.italic", false).value<bool>(),
-		settings.value("theme.comparison.underline", false).value<bool>()
-		));
-
-
-	// data transfer
-	rules_.append(HighlightingRule(
-		"\\b(c?movs[bw]|lea|xchg|mov([zs]x?)?)\\b",
-		QColor(settings.value("theme.data_xfer.foreground", "blue").value<QString>()),
-		QColor(settings.value("theme.data_xfer.background", "transparent").value<QString>()),
-		settings.value("theme.data_xfer.weight", QFont::Normal).value<int>(),
-		settings.value("theme.data_xfer.italic", false).value<bool>(),
-		settings.value("theme.data_xfer.underline", false).value<bool>()
-		));
-
-	// arithmetic
-	rules_.append(HighlightingRule(
-		"\\b(add|sub|i?mul|i?div|neg|adc|sbb|inc|dec)\\b",
-		QColor(settings.value("theme.arithmetic.foreground", "blue").value<QString>()),
-		QColor(settings.value("theme.arithmetic.background", "transparent").value<QString>()),
-		settings.value("theme.arithmetic.weight", QFont::Normal).value<int>(),
-		settings.value("theme.arithmetic.italic", false).value<bool>(),
-		settings.value("theme.arithmetic.underline", false).value<bool>()
-		));
-
-	// logic
-	rules_.append(HighlightingRule(
-		"\\b(and|x?or|not)\\b",
-		QColor(settings.value("theme.logic.foreground", "blue").value<QString>()),
-		QColor(settings.value("theme.logic.background", "transparent").value<QString>()),
-		settings.value("theme.logic.weight", QFont::Normal).value<int>(),
-		settings.value("theme.logic.italic", false).value<bool>(),
-		settings.value("theme.logic.underline", false).value<bool>()
-		));
-
-	// shift
-	rules_.append(HighlightingRule(
-		"\\b(sh|sa|sc|ro)[rl]\\b",
-		QColor(settings.value("theme.shift.foreground", "blue").value<QString>()),
-		QColor(settings.value("theme.shift.background", "transparent").value<QString>()),
-		settings.value("theme.shift.weight", QFont::Normal).value<int>(),
-		settings.value("theme.shift.italic", false).value<bool>(),
-		settings.value("theme.shift.underline", false).value<bool>()
-		));
-
-	// system
-	rules_.append(HighlightingRule(
-		"\\b(sti|cli|hlt|in|out|sysenter|sysexit|syscall|sysret|int)\\b",
-		QColor(settings.value("theme.system.foreground", "blue").value<QString>()),
-		QColor(settings.value("theme.system.background", "transparent").value<QString>()),
-		settings.value("theme.system.weight", QFont::Bold).value<int>(),
-		settings.value("theme.system.italic", false).value<bool>(),
-		settings.value("theme.system.underline", false).value<bool>()
-		));
+	static const char *const general[] = { "ax", "bx", "cx", "dx", "bp", "sp", "si", "di", "ip" };
+	for(std::size_t i = 0; i < sizeof(general) / sizeof(general[0]); ++i) {
+		words_.insert(QLatin1String(general[i]), TOKEN_REGISTER);
+		words_.insert(QString("e%1").arg(general[i]), TOKEN_REGISTER);
+		words_.insert(QString("r%1").arg(general[i]), TOKEN_REGISTER);
+	}
+
+	for(int i = 0; i < 8; ++i) {
+		words_.insert(QString("mm%1").arg(i), TOKEN_REGISTER);
+		words_.insert(QString("xmm%1").arg(i), TOKEN_REGISTER);
+		words_.insert(QString("r%1").arg(i + 8), TOKEN_REGISTER);
+		words_.insert(QString("r%1d").arg(i + 8), TOKEN_REGISTER);
+		words_.insert(QString("r%1w").arg(i + 8), TOKEN_REGISTER);
+		words_.insert(QString("r%1b").arg(i + 8), TOKEN_REGISTER);
+	}
+
+	static const char *const registers[] = {
+		"al", "ah", "bl", "bh", "cl", "ch", "dl", "dh",
+		"spl", "bpl", "sil", "dil",
+		"cs", "ds", "es", "fs", "gs", "ss",
+		0
+	};
+
+	// pointer modifiers, which are only highlighted when followed by "ptr"
+	static const char *const ptr[] = { "byte", "tbyte", "word", "dword", "qword", "fword", "xmmword", 0 };
+
+	static const char *const prefix[]     = { "lock", "rep", "repne", 0 };
+	static const char *const function[]   = { "call", "ret", "retn", 0 };
+	static const char *const stack[]      = { "push", "pushf", "pop", "popf", "enter", "leave", 0 };
+	static const char *const comparison[] = { "cmp", "test", 0 };
+	static const char *const logic[]      = { "and", "or", "xor", "not", 0 };
+	static const char *const shift[]      = { "shl", "shr", "sal", "sar", "scl", "scr", "rol", "ror", 0 };
+
+	static const char *const flow_ctrl[] = {
+		"jmp",
+		"jb", "jnb", "jl", "jnl", "jo", "jno", "jp", "jnp", "js", "jns", "jz", "jnz",
+		"jbe", "jnbe", "jle", "jnle",
+		"jcez",
+		"loope", "loopne", "loopz", "loopnz",
+		0
+	};
+
+	static const char *const data_xfer[] = {
+		"movsb", "movsw", "cmovsb", "cmovsw",
+		"lea", "xchg",
+		"mov", "movs", "movsx", "movz", "movzx",
+		0
+	};
+
+	static const char *const arithmetic[] = {
+		"add", "sub", "mul", "imul", "div", "idiv", "neg", "adc", "sbb", "inc", "dec",
+		0
+	};
+
+	static const char *const system[] = {
+		"sti", "cli", "hlt", "in", "out", "sysenter", "sysexit", "syscall", "sysret", "int",
+		0
+	};
+
+	add_words(registers,  TOKEN_REGISTER);
+	add_words(ptr,        TOKEN_PTR);
+	add_words(prefix,     TOKEN_PREFIX);
+	add_words(flow_ctrl,  TOKEN_FLOW_CTRL);
+	add_words(function,   TOKEN_FUNCTION);
+	add_words(stack,      TOKEN_STACK);
+	add_words(comparison, TOKEN_COMPARISON);
+	add_words(data_xfer,  TOKEN_DATA_XFER);
+	add_words(arithmetic, TOKEN_ARITHMETIC);
+	add_words(logic,      TOKEN_LOGIC);
+	add_words(shift,      TOKEN_SHIFT);
+	add_words(system,     TOKEN_SYSTEM);
 }
 
 //------------------------------------------------------------------------------
 // Name: highlightBlock
-// Desc:
+// Desc: one pass over <text>, a token at a time
 //------------------------------------------------------------------------------
 void SyntaxHighlighter::highlightBlock(const QString &text) {
-	Q_FOREACH(const HighlightingRule &rule, rules_) {
-		int index = rule.pattern.indexIn(text);
-		while(index >= 0) {
-			const int length = rule.pattern.matchedLength();
-			setFormat(index, length, rule.format);
-			index = rule.pattern.indexIn(text, index + length);
+
+	const int n = text.size();
+
+	int i = 0;
+	while(i < n) {
+
+		if(!is_word(text[i])) {
+			switch(text[i].toLatin1()) {
+			case ',':
+			case '[':
+			case ']':
+				setFormat(i, 1, formats_[TOKEN_BRACKETS]);
+				break;
+			case '+':
+			case '-':
+			case '*':
+				// only between two words, like "rax+0x10"
+				if(i > 0 && i + 1 < n && is_word(text[i - 1]) && is_word(text[i + 1])) {
+					setFormat(i, 1, formats_[TOKEN_OPERATOR]);
+				}
+				break;
+			default:
+				break;
+			}
+			++i;
+			continue;
 		}
+
+		int end = i + 1;
+		while(end < n && is_word(text[end])) {
+			++end;
+		}
+
+		const QString word = text.mid(i, end - i).toLower();
+
+		if(is_number(word)) {
+			setFormat(i, end - i, formats_[TOKEN_CONSTANT]);
+		} else {
+			const QHash<QString, int>::const_iterator it = words_.find(word);
+			if(it != words_.end()) {
+				if(it.value() != TOKEN_PTR) {
+					setFormat(i, end - i, formats_[it.value()]);
+				} else if(text.mid(end, 4).compare(QLatin1String(" ptr"), Qt::CaseInsensitive) == 0 && (end + 4 == n || !is_word(text[end + 4]))) {
+					end += 4;
+					setFormat(i, end - i, formats_[TOKEN_PTR]);
+				}
+			}
+		}
+
+		i = end;
 	}
 }
@@ -19,8 +19,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #ifndef SYNTAX_HIGHLIGHTER_H
 #define SYNTAX_HIGHLIGHTER_H
 
-#include <QList>
-#include <QRegExp>
+#include <QHash>
 #include <QSyntaxHighlighter>
 #include <QTextCharFormat>
 
@@ -30,6 +29,10 @@ class QTextDocument;
 class QTextEdit;
 #endif
 
+// highlights instructions as the formatter writes them. Each line is split
+// into words, numbers and punctuation in a single pass and every token is
+// given the theme's format for its kind, mnemonics and registers are told
+// apart by looking the word up
 class SyntaxHighlighter : public QSyntaxHighlighter {
 	Q_OBJECT
 
@@ -41,21 +44,35 @@ public:
 #endif
 
 private:
-	void create_rules();
+	enum Token {
+		TOKEN_BRACKETS,
+		TOKEN_OPERATOR,
+		TOKEN_REGISTER,
+		TOKEN_CONSTANT,
+		TOKEN_PTR,
+		TOKEN_PREFIX,
+		TOKEN_FLOW_CTRL,
+		TOKEN_FUNCTION,
+		TOKEN_STACK,
+		TOKEN_COMPARISON,
+		TOKEN_DATA_XFER,
+		TOKEN_ARITHMETIC,
+		TOKEN_LOGIC,
+		TOKEN_SHIFT,
+		TOKEN_SYSTEM,
+		TOKEN_COUNT
+	};
+
+private:
+	void create_formats();
+	void add_words(const char *const *words, Token token);
 
 protected:
 	void highlightBlock(const QString &text);
 
 private:
-	struct HighlightingRule {
-		HighlightingRule();
-		HighlightingRule(const QString &regex, const QBrush &foreground, const QBrush &background, int weight, bool italic, bool underline);
-
-		QRegExp         pattern;
-		QTextCharFormat format;
-	};
-
-	QList<HighlightingRule> rules_;
+	QTextCharFormat     formats_[TOKEN_COUNT];
+	QHash<QString, int> words_;   // lower case, to the Token they are
 };
 
 #endif
@@ -0,0 +1,198 @@
+#!/usr/bin/env python3
+#
+# Copyright (C) 2006 - 2015 Evan Teran
+#                           evan.teran@gmail.com
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 2 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#
+# compiles functions.xml and syscalls.xml into the static tables declared in
+# PrototypeTables.h, so that edb doesn't parse any XML at runtime. Functions
+# are found through a perfect hash (hash and displace), syscalls are indexed
+# by number.
+#
+# usage: compile_prototypes.py -o PrototypeTables.cpp functions.xml syscalls.xml
+
+import sys
+import xml.etree.ElementTree as ET
+
+FNV_OFFSET = 0x811c9dc5
+FNV_PRIME  = 0x01000193
+
+# the arch attributes of syscalls.xml and the tables they become
+SYSCALL_TABLES = {
+	'x86':    'syscalls_x86',
+	'x86-64': 'syscalls_x86_64',
+}
+
+
+def fnv1a(name, seed):
+	# must match function_hash in edb.cpp
+	h = FNV_OFFSET ^ seed
+	for ch in name.encode('ascii'):
+		h ^= ch
+		h = (h * FNV_PRIME) & 0xffffffff
+	return h
+
+
+def perfect_hash(names):
+	n = len(names)
+	buckets = [[] for _ in range(n)]
+	for i, name in enumerate(names):
+		buckets[fnv1a(name, 0) % n].append(i)
+
+	displacements = [0] * n
+	slots = [None] * n
+
+	# the fullest buckets go first, while there is the most room
+	order = sorted(range(n), key=lambda b: -len(buckets[b]))
+	for b in order:
+		keys = buckets[b]
+		if len(keys) <= 1:
+			break
+
+		seed = 1
+		while True:
+			wanted = [fnv1a(names[k], seed) % n for k in keys]
+			if len(set(wanted)) == len(wanted) and all(slots[s] is None for s in wanted):
+				break
+			seed += 1
+
+		for k, s in zip(keys, wanted):
+			slots[s] = k
+		displacements[b] = seed
+
+	# buckets with a single key go straight to a free slot
+	free = [s for s in range(n) if slots[s] is None]
+	for b in order:
+		keys = buckets[b]
+		if len(keys) != 1:
+			continue
+		s = free.pop()
+		slots[s] = keys[0]
+		displacements[b] = -s - 1
+
+	return displacements, slots
+
+
+def c_string(s):
+	return '"' + s.replace('\\', '\\\\').replace('"', '\\"') + '"'
+
+
+def compile_functions(root, out):
+	functions = []
+	seen = set()
+	for function in root.iter('function'):
+		name = function.get('name')
+		# the last definition wins, as it did when these went into a QHash
+		if name in seen:
+			functions = [f for f in functions if f[0] != name]
+		seen.add(name)
+		arguments = [(a.get('name', ''), a.get('type', '')) for a in function.findall('argument')]
+		functions.append((name, function.get('type', ''), arguments))
+
+	names = [f[0] for f in functions]
+	displacements, slots = perfect_hash(names)
+
+	out.write('namespace {\n\n')
+	for i, (name, type_, arguments) in enumerate(functions):
+		if arguments:
+			out.write('const edb::Argument function_arguments_%d[] = {\n' % i)
+			for arg_name, arg_type in arguments:
+				out.write('\t{ %s, %s },\n' % (c_string(arg_name), c_string(arg_type)))
+			out.write('};\n\n')
+	out.write('}\n\n')
+
+	out.write('const edb::Prototype function_table[] = {\n')
+	for k in slots:
+		name, type_, arguments = functions[k]
+		args = ('function_arguments_%d' % k) if arguments else '0'
+		out.write('\t{ %s, %s, %s, %d },\n' % (c_string(name), c_string(type_), args, len(arguments)))
+	out.write('};\n\n')
+
+	out.write('const int function_displacements[] = {\n')
+	for i in range(0, len(displacements), 16):
+		out.write('\t' + ', '.join(str(d) for d in displacements[i:i + 16]) + ',\n')
+	out.write('};\n\n')
+
+	out.write('const int function_count = %d;\n\n' % len(functions))
+
+
+def compile_syscalls(root, out):
+	for linux in root.iter('linux'):
+		table = SYSCALL_TABLES.get(linux.get('arch'))
+		if table is None:
+			continue
+
+		syscalls = {}
+		for syscall in linux.findall('syscall'):
+			index = int(syscall.findtext('index'))
+			arguments = [(a.get('type', ''), a.get('register', '')) for a in syscall.findall('argument')]
+			syscalls[index] = (syscall.get('name'), arguments)
+
+		count = max(syscalls) + 1 if syscalls else 0
+
+		out.write('namespace {\n\n')
+		for index in sorted(syscalls):
+			name, arguments = syscalls[index]
+			if arguments:
+				out.write('const SyscallArgument %s_arguments_%d[] = {\n' % (table, index))
+				for arg_type, register in arguments:
+					out.write('\t{ %s, %s },\n' % (c_string(arg_type), c_string(register)))
+				out.write('};\n\n')
+		out.write('}\n\n')
+
+		out.write('const Syscall %s[] = {\n' % table)
+		for index in range(count):
+			if index in syscalls:
+				name, arguments = syscalls[index]
+				args = ('%s_arguments_%d' % (table, index)) if arguments else '0'
+				out.write('\t{ %s, %s, %d },\n' % (c_string(name), args, len(arguments)))
+			else:
+				out.write('\t{ 0, 0, 0 },\n')
+		out.write('};\n\n')
+		out.write('const int %s_count = %d;\n\n' % (table, count))
+
+
+def main(argv):
+	if len(argv) < 3 or argv[0] != '-o':
+		sys.stderr.write('usage: compile_prototypes.py -o <output> <xml>...\n')
+		return 1
+
+	output = argv[1]
+	functions = None
+	syscalls = None
+	for filename in argv[2:]:
+		root = ET.parse(filename).getroot()
+		if root.tag == 'functions':
+			functions = root
+		elif root.tag == 'syscalls':
+			syscalls = root
+
+	if functions is None or syscalls is None:
+		sys.stderr.write('compile_prototypes.py: both functions.xml and syscalls.xml are needed\n')
+		return 1
+
+	with open(output, 'w') as out:
+		out.write('// generated by compile_prototypes.py, do not edit\n\n')
+		out.write('#include "PrototypeTables.h"\n\n')
+		out.write('namespace edb {\nnamespace internal {\n\n')
+		compile_functions(functions, out)
+		compile_syscalls(syscalls, out)
+		out.write('}\n}\n')
+
+	return 0
+
+
+if __name__ == '__main__':
+	sys.exit(main(sys.argv[1:]))